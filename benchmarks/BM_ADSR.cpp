@@ -6,27 +6,27 @@
 
 #include "Config.h"
 #include "ADSREnvelope.h"
+#include "Curve.h"
+#include "MidiState.h"
+#include "Region.h"
 #include <benchmark/benchmark.h>
-#include <algorithm>
-#include <random>
-#include <numeric>
-
-constexpr int fixedAmount{12};
-constexpr float sampleRate{100.0f};
-constexpr int envelopeSize{2 << 16};
-constexpr float attack = static_cast<float>(static_cast<int>(envelopeSize / 4) - fixedAmount) / sampleRate;
-constexpr float decay = attack;
-constexpr float release = attack;
-constexpr float releaseTime = envelopeSize - static_cast<int>(envelopeSize / 4);
+#include <vector>
+
+constexpr float sampleRate { 48000.0f };
+constexpr int envelopeSize { 1 << 16 };
+// the attack, decay, sustain and release take about a quarter each
+constexpr float segmentTime = (envelopeSize / 4) / sampleRate;
+constexpr int releaseDelay = envelopeSize - envelopeSize / 4;
 
 class EnvelopeFixture : public benchmark::Fixture
 {
 public:
-    void SetUp(const ::benchmark::State &state)
+    void SetUp(const ::benchmark::State& state)
     {
-        region.amplitudeEG.attack = attack;
-        region.amplitudeEG.release = release;
-        region.amplitudeEG.decay = decay;
+        region.amplitudeEG.attack = segmentTime;
+        region.amplitudeEG.decay = segmentTime;
+        region.amplitudeEG.sustain = 50.0f;
+        region.amplitudeEG.release = segmentTime;
         output.resize(state.range(0));
     }
 
@@ -35,23 +35,26 @@ public:
     }
 
     sfz::MidiState midiState;
-    sfz::Region region{0};
-    sfz::ADSREnvelope envelope;
+    sfz::CurveSet curveSet { sfz::CurveSet::createPredefined() };
+    sfz::Region region { 0 };
+    sfz::ADSREnvelope envelope { midiState, curveSet };
     std::vector<float> output;
 };
 
 BENCHMARK_DEFINE_F(EnvelopeFixture, Block)(benchmark::State& state)
 {
+    const int blockSize = static_cast<int>(state.range(0));
     for (auto _ : state) {
-        envelope.reset(region.amplitudeEG, region, midiState, 0, 0, sampleRate);
-        envelope.startRelease(releaseTime);
-        for (int offset = 0; offset < envelopeSize; offset += static_cast<int>(state.range(0)))
+        envelope.reset(region.amplitudeEG, region, 0, 0.0f, sampleRate);
+        envelope.startRelease(releaseDelay);
+        for (int offset = 0; offset < envelopeSize; offset += blockSize) {
             envelope.getBlock(absl::MakeSpan(output));
-        benchmark::DoNotOptimize(output);
+            benchmark::DoNotOptimize(output.data());
+        }
     }
 
-    state.counters["Blocks"] = benchmark::Counter(envelopeSize / static_cast<double>(state.range(0)), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["Blocks"] = benchmark::Counter(envelopeSize / static_cast<double>(blockSize), benchmark::Counter::kIsIterationInvariantRate);
 }
 
-BENCHMARK_REGISTER_F(EnvelopeFixture, Block)->RangeMultiplier(2)->Range((2 << 6), (2 << 11));
+BENCHMARK_REGISTER_F(EnvelopeFixture, Block)->RangeMultiplier(4)->Range(16, 1024);
 BENCHMARK_MAIN();
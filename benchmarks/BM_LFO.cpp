@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Resources.h"
+#include "LFO.h"
+#include "LFODescription.h"
+#include "Region.h"
+#include <benchmark/benchmark.h>
+#include <absl/strings/str_cat.h>
+#include <memory>
+#include <vector>
+
+constexpr double sampleRate { 48000.0 };
+
+class LFOFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        // the wave of the first sub, and the number of subs
+        const int wave = static_cast<int>(state.range(0));
+        const int numSubs = static_cast<int>(state.range(1));
+        std::string sfz = absl::StrCat("<region> sample=*sine lfo1_freq=5 lfo1_wave=", wave);
+        for (int i = 2; i <= numSubs; ++i)
+            absl::StrAppend(&sfz, " lfo1_wave", i, "=", wave, " lfo1_ratio", i, "=", i);
+        synth.loadSfzString("lfo.sfz", sfz);
+
+        lfo.reset(new sfz::LFO(synth.getResources()));
+        lfo->setSampleRate(sampleRate);
+        lfo->configure(&synth.getRegionView(0)->lfos[0]);
+        lfo->start(0);
+        output.resize(blockSize);
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        lfo.reset();
+    }
+
+    static constexpr size_t blockSize { 256 };
+    sfz::Synth synth;
+    std::unique_ptr<sfz::LFO> lfo;
+    std::vector<float> output;
+};
+
+BENCHMARK_DEFINE_F(LFOFixture, Process)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        lfo->process(absl::MakeSpan(output));
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.counters["Frames"] = benchmark::Counter(blockSize, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Triangle, Sine, Square, Saw and Sample&Hold, with 1 and 4 subs
+BENCHMARK_REGISTER_F(LFOFixture, Process)->ArgsProduct({ { 0, 1, 3, 7, 12 }, { 1, 4 } });
+BENCHMARK_MAIN();
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "SIMDHelpers.h"
+#include "SfzHelpers.h"
+#include "utility/Macros.h"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+class CentsArray : public benchmark::Fixture {
+public:
+  void SetUp(const ::benchmark::State& state) {
+    std::random_device rd { };
+    std::mt19937 gen { rd() };
+    std::uniform_real_distribution<float> dist { -2400, 2400 };
+    input = std::vector<float>(state.range(0));
+    output = std::vector<float>(state.range(0));
+    std::generate(input.begin(), input.end(), [&]() { return dist(gen); });
+  }
+
+  void TearDown(const ::benchmark::State& state) {
+      UNUSED(state);
+  }
+
+  std::vector<float> input;
+  std::vector<float> output;
+};
+
+BENCHMARK_DEFINE_F(CentsArray, Pow)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < input.size(); ++i)
+            output[i] = sfz::centsFactor(input[i]);
+        benchmark::DoNotOptimize(output);
+    }
+}
+
+BENCHMARK_DEFINE_F(CentsArray, Scalar)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::centsFactor, false);
+        sfz::centsFactor<float>(input, absl::MakeSpan(output));
+        benchmark::DoNotOptimize(output);
+    }
+}
+
+BENCHMARK_DEFINE_F(CentsArray, SIMD)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::centsFactor, true);
+        sfz::centsFactor<float>(input, absl::MakeSpan(output));
+        benchmark::DoNotOptimize(output);
+    }
+}
+
+BENCHMARK_REGISTER_F(CentsArray, Pow)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
+BENCHMARK_REGISTER_F(CentsArray, Scalar)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
+BENCHMARK_REGISTER_F(CentsArray, SIMD)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
+BENCHMARK_MAIN();
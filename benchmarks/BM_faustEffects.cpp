@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  Processing of the faust effects by blocks, out of place.
+
+  The sources are the ones of the build: compare the scalar code against the
+  vector code by running this in a build with the option SFIZZ_FAUST_VECTORIZE
+  and in one without it, both with SFIZZ_RECOMPILE_FAUST.
+*/
+
+#include "ScopedFTZ.h"
+#include "Config.h"
+#include "effects/gen/compressor.hxx"
+#include "effects/gen/disto_stage.hxx"
+#include "effects/gen/fverb.hxx"
+#include "effects/gen/gate.hxx"
+#include "effects/gen/limiter.hxx"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr int maxChannels { 2 };
+constexpr int numFrames { 65536 };
+
+template <class Dsp>
+static void FaustEffect(benchmark::State& state)
+{
+    const int blockSize = static_cast<int>(state.range(0));
+
+    std::vector<float> inputs[maxChannels];
+    std::vector<float> outputs[maxChannels];
+    float* inputPtrs[maxChannels];
+    float* outputPtrs[maxChannels];
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    for (int c = 0; c < maxChannels; ++c) {
+        inputs[c].resize(numFrames);
+        outputs[c].resize(numFrames);
+        std::generate(inputs[c].begin(), inputs[c].end(), [&]() { return dist(prng); });
+    }
+
+    // Some of the effects are too big for the stack
+    std::unique_ptr<Dsp> dsp { new Dsp };
+    dsp->init(static_cast<int>(sfz::config::defaultSampleRate));
+
+    ScopedFTZ ftz;
+    for (auto _ : state) {
+        for (int frame = 0; frame + blockSize <= numFrames; frame += blockSize) {
+            for (int c = 0; c < maxChannels; ++c) {
+                inputPtrs[c] = inputs[c].data() + frame;
+                outputPtrs[c] = outputs[c].data() + frame;
+            }
+            dsp->compute(blockSize, inputPtrs, outputPtrs);
+        }
+        benchmark::DoNotOptimize(outputs[0].data());
+    }
+    state.SetItemsProcessed(state.iterations() * numFrames);
+}
+
+BENCHMARK_TEMPLATE(FaustEffect, faustCompressor)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(FaustEffect, faustGate)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(FaustEffect, faustLimiter)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(FaustEffect, faustDisto)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(FaustEffect, faustFverb)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_MAIN();
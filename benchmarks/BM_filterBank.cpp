@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "FilterBank.h"
+#include "SfzFilter.h"
+#include "SIMDHelpers.h"
+#include "ScopedFTZ.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr int blockSize { 1024 };
+constexpr float sampleRate { 48000.0f };
+
+// The filters of many voices, which play the same region
+class FilterBankFixture : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state) {
+        numVoices = static_cast<unsigned>(state.range(0));
+        inputs.resize(numVoices);
+        outputs.resize(numVoices);
+        cutoffs.resize(numVoices);
+        resonances.resize(numVoices);
+        for (unsigned v = 0; v < numVoices; ++v) {
+            inputs[v] = std::vector<float>(blockSize);
+            outputs[v] = std::vector<float>(blockSize);
+            cutoffs[v] = std::vector<float>(blockSize);
+            resonances[v] = std::vector<float>(blockSize);
+            sfz::linearRamp<float>(absl::MakeSpan(cutoffs[v]), 500.0f + 100.0f * v, 1.0f);
+            sfz::linearRamp<float>(absl::MakeSpan(resonances[v]), 0.0f, 0.001f);
+            std::generate(inputs[v].begin(), inputs[v].end(), [&]() { return dist(gen); });
+        }
+    }
+
+    void TearDown(const ::benchmark::State& /* state */) {
+
+    }
+    std::random_device rd { };
+    std::mt19937 gen { rd() };
+    std::normal_distribution<float> dist { 0, 0.5 };
+    unsigned numVoices { 0 };
+    std::vector<std::vector<float>> inputs;
+    std::vector<std::vector<float>> outputs;
+    std::vector<std::vector<float>> cutoffs;
+    std::vector<std::vector<float>> resonances;
+};
+
+BENCHMARK_DEFINE_F(FilterBankFixture, PerVoice_Faust)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    std::vector<std::unique_ptr<sfz::Filter>> filters;
+    for (unsigned v = 0; v < numVoices; ++v) {
+        filters.emplace_back(new sfz::Filter);
+        filters.back()->init(sampleRate);
+        filters.back()->setType(sfz::FilterType::kFilterLpf2p);
+    }
+    const std::vector<float> pksh(blockSize);
+    for (auto _ : state)
+    {
+        for (unsigned v = 0; v < numVoices; ++v) {
+            const float* input = inputs[v].data();
+            float* output = outputs[v].data();
+            filters[v]->processModulated(&input, &output, cutoffs[v].data(), resonances[v].data(), pksh.data(), blockSize);
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(FilterBankFixture, Bank)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    sfz::FilterBank banks[2];
+    for (sfz::FilterBank& bank : banks) {
+        bank.init(sampleRate);
+        bank.setType(sfz::FilterType::kFilterLpf2p);
+    }
+    for (auto _ : state)
+    {
+        for (unsigned v = 0; v < numVoices; v += sfz::FilterBank::maxLanes) {
+            const unsigned numLanes = std::min<unsigned>(numVoices - v, sfz::FilterBank::maxLanes);
+            const float* in[sfz::FilterBank::maxLanes];
+            float* out[sfz::FilterBank::maxLanes];
+            const float* cutoff[sfz::FilterBank::maxLanes];
+            const float* q[sfz::FilterBank::maxLanes];
+            for (unsigned l = 0; l < numLanes; ++l) {
+                in[l] = inputs[v + l].data();
+                out[l] = outputs[v + l].data();
+                cutoff[l] = cutoffs[v + l].data();
+                q[l] = resonances[v + l].data();
+            }
+            banks[v / sfz::FilterBank::maxLanes].processModulated(in, out, cutoff, q, numLanes, blockSize);
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(FilterBankFixture, PerVoiceConstant_Faust)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    std::vector<std::unique_ptr<sfz::Filter>> filters;
+    for (unsigned v = 0; v < numVoices; ++v) {
+        filters.emplace_back(new sfz::Filter);
+        filters.back()->init(sampleRate);
+        filters.back()->setType(sfz::FilterType::kFilterLpf2p);
+    }
+    for (auto _ : state)
+    {
+        for (unsigned v = 0; v < numVoices; ++v) {
+            const float* input = inputs[v].data();
+            float* output = outputs[v].data();
+            filters[v]->process(&input, &output, cutoffs[v][0], resonances[v][0], 0.0f, blockSize);
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(FilterBankFixture, BankConstant)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    sfz::FilterBank banks[2];
+    for (sfz::FilterBank& bank : banks) {
+        bank.init(sampleRate);
+        bank.setType(sfz::FilterType::kFilterLpf2p);
+    }
+    for (auto _ : state)
+    {
+        for (unsigned v = 0; v < numVoices; v += sfz::FilterBank::maxLanes) {
+            const unsigned numLanes = std::min<unsigned>(numVoices - v, sfz::FilterBank::maxLanes);
+            const float* in[sfz::FilterBank::maxLanes];
+            float* out[sfz::FilterBank::maxLanes];
+            float cutoff[sfz::FilterBank::maxLanes];
+            float q[sfz::FilterBank::maxLanes];
+            for (unsigned l = 0; l < numLanes; ++l) {
+                in[l] = inputs[v + l].data();
+                out[l] = outputs[v + l].data();
+                cutoff[l] = cutoffs[v + l][0];
+                q[l] = resonances[v + l][0];
+            }
+            banks[v / sfz::FilterBank::maxLanes].process(in, out, cutoff, q, numLanes, blockSize);
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(FilterBankFixture, PerVoice_Faust)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_REGISTER_F(FilterBankFixture, Bank)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_REGISTER_F(FilterBankFixture, PerVoiceConstant_Faust)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_REGISTER_F(FilterBankFixture, BankConstant)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_MAIN();
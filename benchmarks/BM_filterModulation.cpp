@@ -115,6 +115,31 @@ BENCHMARK_DEFINE_F(FilterFixture, TwoPole_Faust)(benchmark::State& state) {
     }
 }
 
+BENCHMARK_DEFINE_F(FilterFixture, TwoPole_Tabulated)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    sfz::Filter filter;
+    filter.init(sampleRate);
+    filter.setType(sfz::FilterType::kFilterLpf2p);
+    filter.setTabulated(true);
+    for (auto _ : state)
+    {
+        const auto step = static_cast<size_t>(state.range(0));
+        auto cutoffPtr = cutoff.data();
+        auto qIterator = q.begin();
+        auto inputPtr = input.data();
+        auto outputPtr = output.data();
+        const auto sentinel = cutoff.data() + blockSize;
+        while (cutoffPtr < sentinel)
+        {
+            filter.process(&inputPtr, &outputPtr, *cutoffPtr, *qIterator, 0.0, step);
+            qIterator += step;
+            cutoffPtr += step;
+            inputPtr += step;
+            outputPtr += step;
+        }
+    }
+}
+
 BENCHMARK_DEFINE_F(FilterFixture, TwoPoleShelf_Faust)(benchmark::State& state) {
     ScopedFTZ ftz;
     sfz::Filter filter;
@@ -144,6 +169,7 @@ BENCHMARK_DEFINE_F(FilterFixture, TwoPoleShelf_Faust)(benchmark::State& state) {
 BENCHMARK_REGISTER_F(FilterFixture, OnePole_VA)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_REGISTER_F(FilterFixture, OnePole_Faust)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_REGISTER_F(FilterFixture, TwoPole_Faust)->RangeMultiplier(2)->Range(1, 1 << 8);
+BENCHMARK_REGISTER_F(FilterFixture, TwoPole_Tabulated)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_REGISTER_F(FilterFixture, TwoPoleShelf_Faust)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_MAIN();
 
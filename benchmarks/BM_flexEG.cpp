@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Resources.h"
+#include "FlexEnvelope.h"
+#include "FlexEGDescription.h"
+#include "Region.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+constexpr double sampleRate { 48000.0 };
+constexpr int envelopeSize { 1 << 16 };
+constexpr int releaseDelay = envelopeSize - envelopeSize / 4;
+
+// The scenarios of the FlexEG tests, with the stages taking about a quarter
+// of the envelope each
+static const char* envelopeText(int scenario)
+{
+    switch (scenario) {
+    default:
+    case 0: // linear stages
+        return R"(
+            <region> sample=*sine
+            eg1_time1=.34 eg1_level1=.25
+            eg1_time2=.34 eg1_level2=1
+            eg1_time3=.34 eg1_level3=.5 eg1_sustain=3
+            eg1_time4=.34 eg1_level4=0
+        )";
+    case 1: // shaped stages
+        return R"(
+            <region> sample=*sine
+            eg1_time1=.34 eg1_level1=.25 eg1_shape1=2
+            eg1_time2=.34 eg1_level2=1 eg1_shape2=0.5
+            eg1_time3=.34 eg1_level3=.5 eg1_shape3=4 eg1_sustain=3
+            eg1_time4=.34 eg1_level4=0 eg1_shape4=-2
+        )";
+    case 2: // many short stages
+        return R"(
+            <region> sample=*sine
+            eg1_time1=.01 eg1_level1=1 eg1_time2=.01 eg1_level2=0
+            eg1_time3=.01 eg1_level3=1 eg1_time4=.01 eg1_level4=0
+            eg1_time5=.01 eg1_level5=1 eg1_time6=.01 eg1_level6=0
+            eg1_time7=.01 eg1_level7=1 eg1_time8=.01 eg1_level8=.5
+            eg1_sustain=8 eg1_time9=.34 eg1_level9=0
+        )";
+    case 3: // dynamic, with a time modulated by a controller
+        return R"(
+            <region> sample=*sine
+            eg1_dynamic=1 eg1_time1=.34 eg1_time1_oncc1=.2 eg1_level1=1
+            eg1_time2=.34 eg1_level2=.5 eg1_sustain=2
+            eg1_time3=.34 eg1_level3=0
+        )";
+    }
+}
+
+class FlexEGFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        synth.setSampleRate(static_cast<float>(sampleRate));
+        synth.loadSfzString("flex_eg.sfz", envelopeText(static_cast<int>(state.range(0))));
+        envelope.reset(new sfz::FlexEnvelope(synth.getResources()));
+        envelope->setSampleRate(sampleRate);
+        envelope->configure(&synth.getRegionView(0)->flexEGs[0]);
+        output.resize(state.range(1));
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        envelope.reset();
+    }
+
+    sfz::Synth synth;
+    std::unique_ptr<sfz::FlexEnvelope> envelope;
+    std::vector<float> output;
+};
+
+BENCHMARK_DEFINE_F(FlexEGFixture, Block)(benchmark::State& state)
+{
+    const int blockSize = static_cast<int>(state.range(1));
+    for (auto _ : state) {
+        envelope->start(0);
+        envelope->release(releaseDelay);
+        for (int offset = 0; offset < envelopeSize; offset += blockSize) {
+            envelope->process(absl::MakeSpan(output));
+            benchmark::DoNotOptimize(output.data());
+        }
+    }
+
+    state.counters["Frames"] = benchmark::Counter(envelopeSize, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Linear, shaped, short and modulated stages, by block sizes
+BENCHMARK_REGISTER_F(FlexEGFixture, Block)->ArgsProduct({ { 0, 1, 2, 3 }, { 16, 64, 256, 1024 } });
+BENCHMARK_MAIN();
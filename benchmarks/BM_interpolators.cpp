@@ -60,6 +60,27 @@ static void doInterpolation(absl::Span<const float> input, absl::Span<float> out
     }
 }
 
+template <sfz::InterpolatorModel M>
+static void doBlockInterpolation(absl::Span<const float> input, absl::Span<float> output, std::vector<int>& indices, std::vector<float>& coeffs)
+{
+    const float kOutToIn = static_cast<float>(input.size()) / output.size();
+
+    indices.resize(output.size());
+    coeffs.resize(output.size());
+    for (size_t iOut = 0; iOut < output.size(); ++iOut) {
+        float posIn = iOut * kOutToIn;
+        indices[iOut] = static_cast<int>(posIn);
+        coeffs[iOut] = posIn - indices[iOut];
+    }
+
+    const float* sources[1] { input.data() };
+    float* outputs[1] { output.data() };
+    if (!sfz::interpolateSincBlock(M, sources, outputs, 1, indices.data(), coeffs.data(), nullptr, output.size())) {
+        for (size_t iOut = 0; iOut < output.size(); ++iOut)
+            output[iOut] = sfz::interpolate<M>(&input[indices[iOut]], coeffs[iOut]);
+    }
+}
+
 #define ADD_INTERPOLATOR_BENCHMARK(Type)                                \
     BENCHMARK_DEFINE_F(Interpolators, Type)(benchmark::State& state)    \
     {                                                                   \
@@ -84,3 +105,26 @@ ADD_INTERPOLATOR_BENCHMARK(Sinc36)
 ADD_INTERPOLATOR_BENCHMARK(Sinc48)
 ADD_INTERPOLATOR_BENCHMARK(Sinc60)
 ADD_INTERPOLATOR_BENCHMARK(Sinc72)
+
+#define ADD_BLOCK_INTERPOLATOR_BENCHMARK(Type)                                      \
+    BENCHMARK_DEFINE_F(Interpolators, Type##Block)(benchmark::State& state)         \
+    {                                                                               \
+        ScopedFTZ ftz;                                                              \
+        std::vector<int> indices;                                                   \
+        std::vector<float> coeffs;                                                  \
+        for (auto _ : state) {                                                      \
+            absl::Span<float> span = absl::MakeSpan(output);                        \
+            doBlockInterpolation<sfz::kInterpolator##Type>(input, span, indices, coeffs); \
+        }                                                                           \
+    }                                                                               \
+    BENCHMARK_REGISTER_F(Interpolators, Type##Block)                                \
+        ->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc8)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc12)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc16)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc24)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc36)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc48)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc60)
+ADD_BLOCK_INTERPOLATOR_BENCHMARK(Sinc72)
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  Processing of the lightweight effects by blocks, in place, as the effect
+  buses run them.
+*/
+
+#include "ScopedFTZ.h"
+#include "Config.h"
+#include "Opcode.h"
+#include "effects/Apan.h"
+#include "effects/Gain.h"
+#include "effects/Gate.h"
+#include "effects/Lofi.h"
+#include "effects/Rectify.h"
+#include "effects/Width.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+constexpr int numChannels { 2 };
+constexpr int numFrames { 65536 };
+
+using Members = std::vector<std::pair<const char*, const char*>>;
+
+static void LightEffect(benchmark::State& state, sfz::Effect::MakeInstance* make, const Members& members)
+{
+    const int blockSize = static_cast<int>(state.range(0));
+
+    std::vector<sfz::Opcode> opcodes;
+    for (const auto& member : members)
+        opcodes.emplace_back(member.first, member.second);
+    std::unique_ptr<sfz::Effect> effect = make(opcodes);
+    effect->setSampleRate(sfz::config::defaultSampleRate);
+    effect->setSamplesPerBlock(blockSize);
+    effect->clear();
+
+    std::vector<float> signal[numChannels];
+    float* signalPtrs[numChannels];
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    for (int c = 0; c < numChannels; ++c) {
+        signal[c].resize(numFrames);
+        std::generate(signal[c].begin(), signal[c].end(), [&]() { return dist(prng); });
+    }
+
+    ScopedFTZ ftz;
+    for (auto _ : state) {
+        for (int frame = 0; frame + blockSize <= numFrames; frame += blockSize) {
+            for (int c = 0; c < numChannels; ++c)
+                signalPtrs[c] = signal[c].data() + frame;
+            effect->process(signalPtrs, signalPtrs, blockSize);
+        }
+        benchmark::DoNotOptimize(signal[0].data());
+    }
+    state.SetItemsProcessed(state.iterations() * numFrames);
+}
+
+BENCHMARK_CAPTURE(LightEffect, gain, &sfz::fx::Gain::makeInstance, Members { { "gain", "-6" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, width, &sfz::fx::Width::makeInstance, Members { { "width", "50" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, apan, &sfz::fx::Apan::makeInstance, Members { { "apan_freq", "2" }, { "apan_depth", "50" }, { "apan_wet", "50" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, rectify, &sfz::fx::Rectify::makeInstance, Members { { "rectify", "50" }, { "rectify_mode", "full" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, bitred, &sfz::fx::Lofi::makeInstance, Members { { "bitred", "90" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, decim, &sfz::fx::Lofi::makeInstance, Members { { "decim", "50" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, gate, &sfz::fx::Gate::makeInstance, Members { { "gate_threshold", "-20" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_CAPTURE(LightEffect, gateLinked, &sfz::fx::Gate::makeInstance, Members { { "gate_threshold", "-20" }, { "gate_stlink", "on" } })->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_MAIN();
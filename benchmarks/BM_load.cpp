@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "parser/Parser.h"
+#include "parser/ParserListener.h"
+#include <benchmark/benchmark.h>
+#include <ghc/fs_std.hpp>
+#include <fstream>
+#include <string>
+
+// Load synthetic instruments, made of groups of regions spread over a chain of
+// included files, with definitions and CC conditions. The regions play the
+// silence generator, so that the loads do not depend on the sample files.
+
+constexpr int numGroups { 64 };
+constexpr int includeDepth { 8 };
+constexpr int numDefines { 32 };
+
+// names of the same length, so that none is a prefix of another
+static std::string volumeDefine(int index)
+{
+    return std::string("$VOLUME") + char('A' + index / 26) + char('A' + index % 26);
+}
+
+static std::string regionText(int index)
+{
+    const int key = index % 128;
+    const int layer = (index / 128) % 4;
+    const int cc = 20 + index % 8;
+    std::string text = "<region> sample=*silence key=" + std::to_string(key);
+    text += " lovel=" + std::to_string(1 + 32 * layer) + " hivel=" + std::to_string(32 * (layer + 1) - (layer == 3 ? 1 : 0));
+    text += " locc" + std::to_string(cc) + "=" + std::to_string(index % 64)
+        + " hicc" + std::to_string(cc) + "=127";
+    text += " volume=" + volumeDefine(index % numDefines);
+    text += " ampeg_attack=0.002 ampeg_release=$RELEASE amp_veltrack=80";
+    text += " cutoff=$CUTOFF cutoff_oncc74=2400 fil_type=lpf_2p resonance=2";
+    text += " lfo1_freq=5 lfo1_pitch=15 lfo1_pitch_oncc1=50";
+    text += " amplitude_oncc11=100 pan_oncc10=100\n";
+    return text;
+}
+
+/**
+ * @brief Write the included files of a synthetic instrument, and get the text
+ * of its main file, which includes the first of them.
+ *
+ * The groups of regions are split evenly between the main file and the
+ * included files, which include each other down to the depth.
+ */
+static std::string writeInstrument(const fs::path& directory, int numRegions)
+{
+    fs::create_directories(directory);
+    const int numFiles = includeDepth + 1;
+
+    std::string mainText;
+    for (int i = 0; i < numDefines; ++i)
+        mainText += "#define " + volumeDefine(i) + " " + std::to_string(-(i % 12)) + "\n";
+    mainText += "#define $RELEASE 0.8\n#define $CUTOFF 4000\n";
+    mainText += "<control> set_cc1=0 set_cc74=64\n<global> ampeg_sustain=80\n";
+
+    int region = 0;
+    for (int file = 0; file < numFiles; ++file) {
+        std::string text;
+        const int firstGroup = file * numGroups / numFiles;
+        const int lastGroup = (file + 1) * numGroups / numFiles;
+        for (int group = firstGroup; group < lastGroup; ++group) {
+            text += "<group> group=" + std::to_string(1 + group) + " off_by=" + std::to_string(1 + (group + 1) % numGroups) + "\n";
+            const int groupEnd = (group + 1) * numRegions / numGroups;
+            for (; region < groupEnd; ++region)
+                text += regionText(region);
+        }
+        if (file + 1 < numFiles)
+            text += "#include \"include_" + std::to_string(file + 1) + ".sfz\"\n";
+
+        if (file == 0)
+            mainText += text;
+        else {
+            std::ofstream stream { (directory / ("include_" + std::to_string(file) + ".sfz")).string() };
+            stream << text;
+        }
+    }
+    return mainText;
+}
+
+static fs::path instrumentDirectory()
+{
+    return fs::temp_directory_path() / "sfizz_bm_load";
+}
+
+static void Parse(benchmark::State& state)
+{
+    const fs::path directory = instrumentDirectory();
+    const std::string text = writeInstrument(directory, static_cast<int>(state.range(0)));
+
+    struct CountingListener : sfz::ParserListener {
+        void onParseFullBlock(const std::string&, const std::vector<sfz::Opcode>& opcodes) override
+        {
+            numOpcodes += opcodes.size();
+        }
+        size_t numOpcodes { 0 };
+    } listener;
+
+    sfz::Parser parser;
+    parser.setListener(&listener);
+    for (auto _ : state) {
+        parser.parseString(directory / "instrument.sfz", text);
+        benchmark::DoNotOptimize(listener.numOpcodes);
+    }
+    state.counters["Regions"] = static_cast<double>(state.range(0));
+    state.counters["Regions/s"] = benchmark::Counter(
+        static_cast<double>(state.range(0)), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/**
+ * @brief Load the instrument, and time a stage of the load. The synth keeps
+ * the regions of a reloaded file, so the loads alternate between two paths.
+ */
+template <class F>
+static void timeLoadStage(benchmark::State& state, F&& stageDuration)
+{
+    const fs::path directory = instrumentDirectory();
+    const std::string text = writeInstrument(directory, static_cast<int>(state.range(0)));
+
+    sfz::Synth synth;
+    int load = 0;
+    for (auto _ : state) {
+        const fs::path path = directory / (load++ % 2 ? "instrument_a.sfz" : "instrument_b.sfz");
+        synth.loadSfzString(path, text);
+        state.SetIterationTime(stageDuration(synth.getLoadBreakdown()));
+    }
+    state.counters["Regions"] = static_cast<double>(synth.getNumRegions());
+}
+
+static void Load(benchmark::State& state)
+{
+    timeLoadStage(state, [](const sfz::Synth::LoadBreakdown& load) {
+        return load.parse + load.regions + load.finalize;
+    });
+}
+
+static void BuildRegions(benchmark::State& state)
+{
+    timeLoadStage(state, [](const sfz::Synth::LoadBreakdown& load) { return load.regions; });
+}
+
+static void Finalize(benchmark::State& state)
+{
+    timeLoadStage(state, [](const sfz::Synth::LoadBreakdown& load) { return load.finalize; });
+}
+
+static void ActivationLists(benchmark::State& state)
+{
+    timeLoadStage(state, [](const sfz::Synth::LoadBreakdown& load) { return load.activation; });
+}
+
+static void ModMatrix(benchmark::State& state)
+{
+    timeLoadStage(state, [](const sfz::Synth::LoadBreakdown& load) { return load.modMatrix; });
+}
+
+BENCHMARK(Parse)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMillisecond);
+BENCHMARK(Load)->RangeMultiplier(4)->Range(256, 16384)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BuildRegions)->RangeMultiplier(4)->Range(256, 16384)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(Finalize)->RangeMultiplier(4)->Range(256, 16384)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(ActivationLists)->RangeMultiplier(4)->Range(256, 16384)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(ModMatrix)->RangeMultiplier(4)->Range(256, 16384)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_MAIN();
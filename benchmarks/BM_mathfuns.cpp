@@ -24,6 +24,8 @@ public:
         result = std::vector<float>(state.range(0));
         intResult = std::vector<int>(state.range(0));
         std::generate(source.begin(), source.end(), [&]() { return dist(gen); });
+        decibels = std::vector<float>(state.range(0));
+        std::transform(source.begin(), source.end(), decibels.begin(), [](float x) { return -60.0f * x; });
     }
 
     void TearDown(const ::benchmark::State& /* state */)
@@ -33,6 +35,7 @@ public:
     std::vector<float> source;
     std::vector<float> result;
     std::vector<int> intResult;
+    std::vector<float> decibels;
 };
 
 BENCHMARK_DEFINE_F(MyFixture, Dummy)
@@ -68,8 +71,30 @@ BENCHMARK_DEFINE_F(MyFixture, ScalarFastFloorLog2)
     }
 }
 
+BENCHMARK_DEFINE_F(MyFixture, ScalarDb2mag)
+(benchmark::State& state)
+{
+    for (auto _ : state) {
+        for (size_t i = 0, n = decibels.size(); i < n; ++i)
+            result[i] = db2mag(decibels[i]);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK_DEFINE_F(MyFixture, SIMDDb2mag)
+(benchmark::State& state)
+{
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::db2mag, true);
+    for (auto _ : state) {
+        sfz::db2mag<float>(decibels, absl::MakeSpan(result));
+        benchmark::DoNotOptimize(result);
+    }
+}
+
 BENCHMARK_REGISTER_F(MyFixture, Dummy)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
 BENCHMARK_REGISTER_F(MyFixture, ScalarLibmFloorLog2)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
 BENCHMARK_REGISTER_F(MyFixture, ScalarFastFloorLog2)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
+BENCHMARK_REGISTER_F(MyFixture, ScalarDb2mag)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
+BENCHMARK_REGISTER_F(MyFixture, SIMDDb2mag)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
 
 BENCHMARK_MAIN();
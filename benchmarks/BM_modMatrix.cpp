@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Resources.h"
+#include "Region.h"
+#include "Voice.h"
+#include "AudioBuffer.h"
+#include "modulations/ModMatrix.h"
+#include <benchmark/benchmark.h>
+#include <absl/strings/str_cat.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Run the cycles of the modulation matrix over the voices of a region, whose
+// connections come in turn from the CCs, the LFOs, the flex EGs and the
+// aftertouch. The CCs and the channel aftertouch are global sources, and the
+// others are per voice.
+
+constexpr int blockSize { 256 };
+
+static const char* const targetNames[] {
+    "pitch", "volume", "amplitude", "pan", "cutoff", "resonance", "width",
+};
+
+constexpr int numTargetNames { sizeof(targetNames) / sizeof(targetNames[0]) };
+
+static std::string regionText(int numConnections)
+{
+    std::string text = "<region> sample=*sine fil_type=lpf_2p cutoff=2000";
+    for (int i = 0; i < numConnections; ++i) {
+        const int n = 1 + i / 4;
+        const char* target = targetNames[(n - 1) % numTargetNames];
+        switch (i % 4) {
+        case 0:
+            absl::StrAppend(&text, " ", target, "_oncc", 19 + n, "=10");
+            break;
+        case 1:
+            absl::StrAppend(&text, " lfo", n, "_freq=", n, " lfo", n, "_", target, "=10");
+            break;
+        case 2:
+            absl::StrAppend(&text, " eg", n, "_time1=0.1 eg", n, "_level1=1 eg", n, "_sustain=1 eg", n, "_", target, "=10");
+            break;
+        case 3:
+            absl::StrAppend(&text, " lfo", n, (n % 2 ? "_freqchanaft" : "_freqpolyaft"), "=1");
+            break;
+        }
+    }
+    return text;
+}
+
+class ModMatrixFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const int numVoices = static_cast<int>(state.range(0));
+        const int numConnections = static_cast<int>(state.range(1));
+
+        synth.reset(new sfz::Synth);
+        synth->setSamplesPerBlock(blockSize);
+        synth->setNumVoices(numVoices);
+        synth->loadSfzString("modMatrix.sfz", regionText(numConnections));
+        for (int i = 0; i < numVoices; ++i)
+            synth->noteOn(0, i % 128, 1 + (i * 37) % 127);
+        sfz::AudioBuffer<float> buffer { 2, blockSize };
+        synth->renderBlock(buffer);
+
+        sfz::ModMatrix& mm = synth->getResources().getModMatrix();
+        const sfz::Region* region = synth->getRegionView(0);
+        regionId = region->getId();
+        numRegionConnections = static_cast<int>(region->connections.size());
+        targets.clear();
+        for (const sfz::Region::Connection& connection : region->connections) {
+            const sfz::ModMatrix::TargetId target = mm.findTarget(connection.target);
+            if (target && std::find(targets.begin(), targets.end(), target) == targets.end())
+                targets.push_back(target);
+        }
+
+        voices.clear();
+        for (int i = 0; i < synth->getNumVoices(); ++i) {
+            const sfz::Voice* voice = synth->getVoiceView(i);
+            if (!voice->isFree())
+                voices.push_back({ voice->getId(), voice->getTriggerEvent().value });
+        }
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        synth.reset();
+    }
+
+    void setCounters(benchmark::State& state) const
+    {
+        const double numModulations = static_cast<double>(voices.size() * targets.size());
+        state.counters["Voices"] = static_cast<double>(voices.size());
+        state.counters["Connections"] = numRegionConnections;
+        state.counters["Targets"] = static_cast<double>(targets.size());
+        state.counters["Modulations/s"] = benchmark::Counter(
+            numModulations, benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    struct ActiveVoice {
+        NumericId<sfz::Voice> id;
+        float triggerValue;
+    };
+
+    std::unique_ptr<sfz::Synth> synth;
+    NumericId<sfz::Region> regionId;
+    int numRegionConnections { 0 };
+    std::vector<sfz::ModMatrix::TargetId> targets;
+    std::vector<ActiveVoice> voices;
+};
+
+// The cycle of the audio thread: the global sources, then each voice reads
+// the modulations of its targets
+BENCHMARK_DEFINE_F(ModMatrixFixture, Cycle)(benchmark::State& state)
+{
+    sfz::ModMatrix& mm = synth->getResources().getModMatrix();
+    for (auto _ : state) {
+        mm.beginCycle(blockSize);
+        for (const ActiveVoice& voice : voices) {
+            mm.beginVoice(voice.id, regionId, voice.triggerValue);
+            for (sfz::ModMatrix::TargetId target : targets) {
+                bool constant;
+                benchmark::DoNotOptimize(mm.getModulation(target, constant));
+            }
+            mm.endVoice();
+        }
+        mm.endCycle();
+    }
+    setCounters(state);
+}
+
+// The same cycle, with the voices skipping their targets, so that the global
+// sources and the dummy runs of the voice-scoped ones remain
+BENCHMARK_DEFINE_F(ModMatrixFixture, CycleWithoutTargets)(benchmark::State& state)
+{
+    sfz::ModMatrix& mm = synth->getResources().getModMatrix();
+    for (auto _ : state) {
+        mm.beginCycle(blockSize);
+        for (const ActiveVoice& voice : voices) {
+            mm.beginVoice(voice.id, regionId, voice.triggerValue);
+            mm.endVoice();
+        }
+        mm.endCycle();
+        benchmark::ClobberMemory();
+    }
+    setCounters(state);
+}
+
+static void ModMatrixArguments(benchmark::internal::Benchmark* b)
+{
+    for (int numVoices : { 1, 4, 16, 64, 256 })
+        for (int numConnections : { 4, 16, 64 })
+            b->Args({ numVoices, numConnections });
+}
+
+BENCHMARK_REGISTER_F(ModMatrixFixture, Cycle)
+    ->ArgNames({ "voices", "connections" })
+    ->Apply(ModMatrixArguments)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_REGISTER_F(ModMatrixFixture, CycleWithoutTargets)
+    ->ArgNames({ "voices", "connections" })
+    ->Apply(ModMatrixArguments)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Region.h"
+#include "Opcode.h"
+#include "Messaging.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the opcodes of a typical region of a sampled instrument
+static const std::vector<std::pair<std::string, std::string>> opcodeTexts {
+    { "sample", "Samples/Piano/C4_mf_close.wav" },
+    { "lokey", "58" }, { "hikey", "62" }, { "pitch_keycenter", "60" },
+    { "lovel", "64" }, { "hivel", "95" },
+    { "volume", "-3.5" }, { "pan", "12" }, { "tune", "-4" },
+    { "ampeg_attack", "0.002" }, { "ampeg_decay", "1.5" }, { "ampeg_sustain", "60" },
+    { "ampeg_release", "0.8" }, { "amp_veltrack", "85" },
+    { "fil_type", "lpf_2p" }, { "cutoff", "4000" }, { "resonance", "2" },
+    { "fil_veltrack", "2400" }, { "cutoff_oncc74", "2400" }, { "fil1_gain_oncc71", "6" },
+    { "eq1_freq", "200" }, { "eq1_gain_oncc75", "-6" },
+    { "lfo1_freq", "5" }, { "lfo1_pitch", "15" }, { "lfo1_pitch_oncc1", "50" },
+    { "amplitude_oncc11", "100" }, { "amplitude_curvecc11", "4" },
+    { "offset_random", "200" }, { "group", "3" }, { "off_by", "4" },
+};
+
+static void Construct(benchmark::State& state)
+{
+    for (auto _ : state) {
+        for (const auto& text : opcodeTexts) {
+            sfz::Opcode opcode { text.first, text.second };
+            benchmark::DoNotOptimize(opcode.lettersOnlyHash);
+        }
+    }
+    state.counters["Opcodes"] = benchmark::Counter(static_cast<double>(opcodeTexts.size()), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void ParseRegion(benchmark::State& state)
+{
+    std::vector<sfz::Opcode> opcodes;
+    for (const auto& text : opcodeTexts)
+        opcodes.emplace_back(text.first, text.second);
+
+    for (auto _ : state) {
+        sfz::Region region { 0 };
+        for (const sfz::Opcode& opcode : opcodes)
+            region.parseOpcode(opcode);
+        benchmark::DoNotOptimize(region.volume);
+    }
+    state.counters["Opcodes"] = benchmark::Counter(static_cast<double>(opcodes.size()), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void Messages(benchmark::State& state)
+{
+    sfz::Synth synth;
+    synth.loadSfzString("opcodes.sfz", R"(
+        <region> sample=*sine lfo1_freq=5 lfo1_pitch=15 cutoff=4000 eq1_freq=200
+    )");
+
+    sfz::Client client(nullptr);
+    client.setReceiveCallback(+[](void*, int, const char*, const char*, const sfizz_arg_t* args) {
+        benchmark::DoNotOptimize(args);
+    });
+
+    const char* paths[] {
+        "/region0/volume", "/region0/pan", "/region0/pitch_keycenter", "/region0/sample",
+        "/region0/ampeg_attack", "/region0/filter0/cutoff", "/region0/eq0/frequency",
+        "/region0/lfo0/wave", "/num_regions", "/num_active_voices",
+    };
+
+    for (auto _ : state) {
+        for (const char* path : paths)
+            synth.dispatchMessage(client, 0, path, "", nullptr);
+    }
+    state.counters["Messages"] = benchmark::Counter(static_cast<double>(sizeof(paths) / sizeof(paths[0])), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(Construct);
+BENCHMARK(ParseRegion);
+BENCHMARK(Messages);
+BENCHMARK_MAIN();
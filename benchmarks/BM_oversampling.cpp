@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  Oversampling of the interleaved stereo chunks of the files, as done at
+  load time: channel by channel, or in the vector lanes of the stereo stages.
+*/
+
+#include "OversamplerHelpers.h"
+#include "StereoUpsampler.h"
+#include "Config.h"
+#include "SIMDHelpers.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+constexpr size_t numFrames { sfz::config::fileChunkSize };
+
+static std::vector<float> makeInput()
+{
+    std::vector<float> input(2 * numFrames);
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    std::generate(input.begin(), input.end(), [&]() { return dist(prng); });
+    return input;
+}
+
+static void PerChannel(benchmark::State& state)
+{
+    const int factor = static_cast<int>(state.range(0));
+    const std::vector<float> input = makeInput();
+    std::vector<float> output(2 * factor * numFrames);
+    std::vector<float> left(numFrames);
+    std::vector<float> right(numFrames);
+    std::vector<float> upLeft(factor * numFrames);
+    std::vector<float> upRight(factor * numFrames);
+    std::vector<float> temp(std::max(128, sfz::Upsampler::recommendedBuffer(16, static_cast<int>(numFrames))));
+    sfz::Upsampler upsamplers[2];
+
+    for (auto _ : state) {
+        sfz::readInterleaved(input.data(), left.data(), right.data(), static_cast<unsigned>(input.size()));
+        upsamplers[0].process(factor, left.data(), upLeft.data(), static_cast<int>(numFrames), temp.data(), static_cast<int>(temp.size()));
+        upsamplers[1].process(factor, right.data(), upRight.data(), static_cast<int>(numFrames), temp.data(), static_cast<int>(temp.size()));
+        sfz::writeInterleaved(upLeft.data(), upRight.data(), output.data(), static_cast<unsigned>(output.size()));
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numFrames);
+}
+
+static void Stereo(benchmark::State& state)
+{
+    const int factor = static_cast<int>(state.range(0));
+    const std::vector<float> input = makeInput();
+    std::vector<float> output(2 * factor * numFrames);
+    std::vector<float> temp(std::max<size_t>(1, sfz::StereoUpsampler::recommendedBuffer(factor, numFrames)));
+    sfz::StereoUpsampler upsampler;
+
+    for (auto _ : state) {
+        upsampler.process(factor, input.data(), output.data(), numFrames, temp.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numFrames);
+}
+
+BENCHMARK(PerChannel)->RangeMultiplier(2)->Range(2, 8);
+BENCHMARK(Stereo)->RangeMultiplier(2)->Range(2, 8);
+BENCHMARK_MAIN();
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  The pan law from a table against the polynomial, and the stereo stage of the
+  voice as separate passes against the single pass.
+*/
+
+#include "Panning.h"
+#include "MathHelpers.h"
+#include "ScopedFTZ.h"
+#include <benchmark/benchmark.h>
+#include <absl/algorithm/container.h>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// The table which the pan law used to read, odd for equal volume at center
+constexpr int panSize = 4095;
+
+static const auto panData = []()
+{
+    std::array<float, panSize + 1> pan;
+    int i = 0;
+    for (; i < panSize; ++i)
+        pan[i] = std::cos(i * (piTwo<double>() / (panSize - 1)));
+    for (; i < static_cast<int>(pan.size()); ++i)
+        pan[i] = pan[panSize - 1];
+    return pan;
+}();
+
+static void panTable(const float* panEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
+{
+    for (unsigned i = 0; i < size; ++i) {
+        const float p = clamp((panEnvelope[i] + 1.0f) * 0.5f, 0.0f, 1.0f);
+        leftBuffer[i] *= panData[lroundPositive(p * (panSize - 1))];
+        rightBuffer[i] *= panData[lroundPositive((1 - p) * (panSize - 1))];
+    }
+}
+
+class PanFixture : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        std::random_device rd {};
+        std::mt19937 gen { rd() };
+        std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+        const auto size = static_cast<size_t>(state.range(0));
+        pan.resize(size);
+        width.resize(size);
+        position.resize(size);
+        left.resize(size);
+        right.resize(size);
+        absl::c_generate(pan, [&]() { return dist(gen); });
+        absl::c_generate(width, [&]() { return dist(gen); });
+        absl::c_generate(position, [&]() { return dist(gen); });
+        absl::c_generate(left, [&]() { return dist(gen); });
+        absl::c_generate(right, [&]() { return dist(gen); });
+    }
+
+    void TearDown(const ::benchmark::State& /* state */) {}
+
+    std::vector<float> pan;
+    std::vector<float> width;
+    std::vector<float> position;
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+BENCHMARK_DEFINE_F(PanFixture, PanTable)(benchmark::State& state)
+{
+    ScopedFTZ ftz;
+    for (auto _ : state) {
+        panTable(pan.data(), left.data(), right.data(), state.range(0));
+        benchmark::DoNotOptimize(left.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(PanFixture, PanPolynomial)(benchmark::State& state)
+{
+    ScopedFTZ ftz;
+    for (auto _ : state) {
+        sfz::pan(pan.data(), left.data(), right.data(), state.range(0));
+        benchmark::DoNotOptimize(left.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(PanFixture, StereoStageSeparate)(benchmark::State& state)
+{
+    ScopedFTZ ftz;
+    for (auto _ : state) {
+        sfz::pan(pan.data(), left.data(), right.data(), state.range(0));
+        sfz::width(width.data(), left.data(), right.data(), state.range(0));
+        sfz::pan(position.data(), left.data(), right.data(), state.range(0));
+        benchmark::DoNotOptimize(left.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(PanFixture, StereoStageSinglePass)(benchmark::State& state)
+{
+    ScopedFTZ ftz;
+    for (auto _ : state) {
+        sfz::panWidthPosition(pan.data(), width.data(), position.data(), left.data(), right.data(), state.range(0));
+        benchmark::DoNotOptimize(left.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(PanFixture, PanTable)->RangeMultiplier(4)->Range((1 << 4), (1 << 12));
+BENCHMARK_REGISTER_F(PanFixture, PanPolynomial)->RangeMultiplier(4)->Range((1 << 4), (1 << 12));
+BENCHMARK_REGISTER_F(PanFixture, StereoStageSeparate)->RangeMultiplier(4)->Range((1 << 4), (1 << 12));
+BENCHMARK_REGISTER_F(PanFixture, StereoStageSinglePass)->RangeMultiplier(4)->Range((1 << 4), (1 << 12));
+BENCHMARK_MAIN();
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  The positions of the interpolation from a modulated pitch, as separate
+  passes over the buffers against the fused kernel.
+*/
+
+#include "SIMDHelpers.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+class Positions : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        sfz::initializeSIMDDispatchers();
+        const auto size = static_cast<size_t>(state.range(0));
+        pitch.resize(size);
+        jumps.resize(size);
+        coeffs.resize(size);
+        indices.resize(size);
+        for (size_t i = 0; i < size; ++i)
+            pitch[i] = 100.0f * std::sin(0.01f * static_cast<float>(i));
+    }
+
+    void TearDown(const ::benchmark::State& /* state */) {}
+
+    std::vector<float> pitch;
+    std::vector<float> jumps;
+    std::vector<float> coeffs;
+    std::vector<int> indices;
+};
+
+BENCHMARK_DEFINE_F(Positions, Separate)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        sfz::centsFactor<float>(pitch, absl::MakeSpan(jumps));
+        sfz::applyGain1(1.1f, absl::MakeSpan(jumps));
+        jumps.front() = 0.25f;
+        sfz::cumsum<float>(jumps, absl::MakeSpan(jumps));
+        sfz::sfzInterpolationCast<float>(jumps, absl::MakeSpan(indices), absl::MakeSpan(coeffs));
+        sfz::add1<int>(1000, absl::MakeSpan(indices));
+        benchmark::DoNotOptimize(indices.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(Positions, Fused)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        sfz::interpolationPositions<float>(pitch, 1.1f, fixedPosition(1000.25), absl::MakeSpan(indices), absl::MakeSpan(coeffs));
+        benchmark::DoNotOptimize(indices.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(Positions, Separate)->RangeMultiplier(4)->Range(1 << 4, 1 << 10);
+BENCHMARK_REGISTER_F(Positions, Fused)->RangeMultiplier(4)->Range(1 << 4, 1 << 10);
+BENCHMARK_MAIN();
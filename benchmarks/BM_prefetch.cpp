@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  Voices reading blocks from many distinct files, larger together than the
+  caches, with and without prefetching the blocks of all voices first.
+*/
+
+#include "utility/MemoryHelpers.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+constexpr int numFiles { 256 };
+constexpr int fileFrames { 1 << 18 };
+constexpr int blockSize { 256 };
+constexpr float ratio { 1.3f };
+
+class Prefetch : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const auto numVoices = static_cast<size_t>(state.range(0));
+        files.resize(numFiles);
+        std::minstd_rand prng;
+        std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+        for (auto& file : files) {
+            file.resize(fileFrames);
+            std::generate(file.begin(), file.end(), [&]() { return dist(prng); });
+        }
+        std::uniform_int_distribution<int> fileDist { 0, numFiles - 1 };
+        std::uniform_int_distribution<int> positionDist { 0, fileFrames / 2 };
+        voices.resize(numVoices);
+        for (auto& voice : voices) {
+            voice.file = fileDist(prng);
+            voice.position = positionDist(prng);
+        }
+        output.resize(blockSize);
+    }
+
+    void TearDown(const ::benchmark::State& /* state */) {}
+
+    struct Voice {
+        int file;
+        int position;
+    };
+
+    void render(const Voice& voice) noexcept
+    {
+        const float* source = files[voice.file].data() + voice.position;
+        for (int i = 0; i < blockSize; ++i) {
+            const float position = ratio * i;
+            const int index = static_cast<int>(position);
+            const float coeff = position - index;
+            output[i] += source[index] + coeff * (source[index + 1] - source[index]);
+        }
+    }
+
+    void advance(Voice& voice) noexcept
+    {
+        voice.position += static_cast<int>(ratio * blockSize);
+        if (voice.position + 2 * blockSize > fileFrames)
+            voice.position = 0;
+    }
+
+    std::vector<std::vector<float>> files;
+    std::vector<Voice> voices;
+    std::vector<float> output;
+};
+
+BENCHMARK_DEFINE_F(Prefetch, Straight)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        for (auto& voice : voices) {
+            render(voice);
+            advance(voice);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(Prefetch, Prefetched)(benchmark::State& state)
+{
+    const size_t span = static_cast<size_t>(std::ceil(ratio * blockSize)) + 1;
+    for (auto _ : state) {
+        for (const auto& voice : voices)
+            sfz::prefetchRange(files[voice.file].data() + voice.position, span * sizeof(float));
+        for (auto& voice : voices) {
+            render(voice);
+            advance(voice);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(Prefetch, Straight)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK_REGISTER_F(Prefetch, Prefetched)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK_MAIN();
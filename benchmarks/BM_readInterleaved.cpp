@@ -95,10 +95,62 @@ static void SSE_Unaligned_2(benchmark::State& state) {
   }
 }
 
+static void Scalar_Int16(benchmark::State& state) {
+  sfz::Buffer<int16_t> input (state.range(0) * 2);
+  sfz::Buffer<float> outputLeft (state.range(0));
+  sfz::Buffer<float> outputRight (state.range(0));
+  std::iota(input.begin(), input.end(), int16_t(1));
+
+  for (auto _ : state) {
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt16, false);
+    sfz::readInterleavedInt16(input, absl::MakeSpan(outputLeft), absl::MakeSpan(outputRight));
+  }
+}
+
+static void SIMD_Int16(benchmark::State& state) {
+  sfz::Buffer<int16_t> input (state.range(0) * 2);
+  sfz::Buffer<float> outputLeft (state.range(0));
+  sfz::Buffer<float> outputRight (state.range(0));
+  std::iota(input.begin(), input.end(), int16_t(1));
+
+  for (auto _ : state) {
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt16, true);
+    sfz::readInterleavedInt16(input, absl::MakeSpan(outputLeft), absl::MakeSpan(outputRight));
+  }
+}
+
+static void Scalar_Int24(benchmark::State& state) {
+  sfz::Buffer<uint8_t> input (state.range(0) * 6);
+  sfz::Buffer<float> outputLeft (state.range(0));
+  sfz::Buffer<float> outputRight (state.range(0));
+  std::iota(input.begin(), input.end(), uint8_t(1));
+
+  for (auto _ : state) {
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt24, false);
+    sfz::readInterleavedInt24(input, absl::MakeSpan(outputLeft), absl::MakeSpan(outputRight));
+  }
+}
+
+static void SIMD_Int24(benchmark::State& state) {
+  sfz::Buffer<uint8_t> input (state.range(0) * 6);
+  sfz::Buffer<float> outputLeft (state.range(0));
+  sfz::Buffer<float> outputRight (state.range(0));
+  std::iota(input.begin(), input.end(), uint8_t(1));
+
+  for (auto _ : state) {
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt24, true);
+    sfz::readInterleavedInt24(input, absl::MakeSpan(outputLeft), absl::MakeSpan(outputRight));
+  }
+}
+
 BENCHMARK(Scalar)->Range((8<<10), (8<<20));
 BENCHMARK(SSE)->Range((8<<10), (8<<20));
 BENCHMARK(Scalar_Unaligned)->Range((8<<10), (8<<20));
 BENCHMARK(SSE_Unaligned)->Range((8<<10), (8<<20));
 BENCHMARK(Scalar_Unaligned_2)->Range((8<<10), (8<<20));
 BENCHMARK(SSE_Unaligned_2)->Range((8<<10), (8<<20));
+BENCHMARK(Scalar_Int16)->Range((8<<10), (8<<20));
+BENCHMARK(SIMD_Int16)->Range((8<<10), (8<<20));
+BENCHMARK(Scalar_Int24)->Range((8<<10), (8<<20));
+BENCHMARK(SIMD_Int24)->Range((8<<10), (8<<20));
 BENCHMARK_MAIN();
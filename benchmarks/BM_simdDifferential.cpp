@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "SIMDHelpers.h"
+#include "AudioBuffer.h"
+#include <benchmark/benchmark.h>
+#include <ghc/fs_std.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Render the instruments with the kernels of each backend, against the scalar
+// kernels. The counters are the deviations of the output from the scalar one,
+// and the ratios of the durations of the stages to the scalar ones, so the
+// regressions of accuracy and of speed show together.
+
+enum Instrument {
+    kOscillator,
+    kFiltered,
+    kLooped,
+    kUnison,
+    kEffects,
+};
+
+static const char* instrumentText(int instrument)
+{
+    switch (instrument) {
+    case kOscillator:
+        return "<region> sample=*sine";
+    case kFiltered:
+        return R"(
+            <region> sample=*saw fil_type=lpf_2p cutoff=1200 resonance=6
+                lfo1_freq=5 lfo1_cutoff=1200 eq1_freq=800 eq1_gain=6
+        )";
+    case kLooped:
+        return R"(
+            <region> sample=looped_flute.wav loop_mode=loop_continuous pan=-30 width=50
+        )";
+    case kUnison:
+        return "<region> sample=*tri oscillator_multi=5 oscillator_detune=20";
+    case kEffects:
+        return R"(
+            <region> sample=looped_flute.wav loop_mode=loop_continuous effect1=50
+            <effect> bus=fx1 type=lofi
+        )";
+    }
+    return "";
+}
+
+static const sfz::Synth::CallbackStage timedStages[] = {
+    sfz::Synth::CallbackData,
+    sfz::Synth::CallbackAmplitude,
+    sfz::Synth::CallbackFilters,
+    sfz::Synth::CallbackPanning,
+    sfz::Synth::CallbackEffects,
+};
+
+static const char* stageName(sfz::Synth::CallbackStage stage)
+{
+    switch (stage) {
+    case sfz::Synth::CallbackData: return "Data";
+    case sfz::Synth::CallbackAmplitude: return "Amplitude";
+    case sfz::Synth::CallbackFilters: return "Filters";
+    case sfz::Synth::CallbackPanning: return "Panning";
+    case sfz::Synth::CallbackEffects: return "Effects";
+    default: return "Stage";
+    }
+}
+
+constexpr int blockSize { 256 };
+constexpr int numReferenceBlocks { 64 };
+
+static void selectBackend(sfz::SIMDBackend backend)
+{
+    for (int i = 0; i < static_cast<int>(sfz::SIMDOps::_sentinel); ++i) {
+        const auto op = static_cast<sfz::SIMDOps>(i);
+        sfz::setSIMDOpStatus<float>(op, false);
+        if (backend != sfz::SIMDBackend::scalar)
+            sfz::setSIMDOpBackend<float>(op, backend);
+    }
+}
+
+static bool backendAvailable(sfz::SIMDBackend backend)
+{
+    bool available = false;
+    for (int i = 0; i < static_cast<int>(sfz::SIMDOps::_sentinel); ++i) {
+        const auto op = static_cast<sfz::SIMDOps>(i);
+        const auto previous = sfz::getSIMDOpBackend<float>(op);
+        if (sfz::setSIMDOpBackend<float>(op, backend)) {
+            available = true;
+            sfz::setSIMDOpBackend<float>(op, previous);
+        }
+    }
+    return available;
+}
+
+struct Render {
+    std::vector<float> output;
+    std::array<double, sizeof(timedStages) / sizeof(timedStages[0])> stageMeans {};
+};
+
+static std::unique_ptr<sfz::Synth> makeSynth(int instrument)
+{
+    std::unique_ptr<sfz::Synth> synth { new sfz::Synth };
+    synth->setSamplesPerBlock(blockSize);
+    synth->setVoiceTimingPeriod(1);
+    const fs::path directory { SFIZZ_BENCHMARK_FILES };
+    synth->loadSfzString(directory / "simd_differential.sfz", instrumentText(instrument));
+    for (int key : { 48, 55, 60, 64, 71 })
+        synth->noteOn(0, key, 100);
+    return synth;
+}
+
+static void readStageMeans(const sfz::Synth& synth, Render& render)
+{
+    for (size_t i = 0; i < render.stageMeans.size(); ++i)
+        render.stageMeans[i] = synth.getCallbackStats(timedStages[i]).mean;
+}
+
+// The output and the durations of the stages with the scalar kernels, which
+// the runs of the backends compare against
+static const Render& scalarRender(int instrument)
+{
+    static std::array<std::unique_ptr<Render>, kEffects + 1> renders;
+    std::unique_ptr<Render>& render = renders[instrument];
+    if (render)
+        return *render;
+
+    render.reset(new Render);
+    selectBackend(sfz::SIMDBackend::scalar);
+    auto synth = makeSynth(instrument);
+    sfz::AudioBuffer<float> buffer { 2, blockSize };
+    for (int block = 0; block < numReferenceBlocks; ++block) {
+        synth->renderBlock(buffer);
+        for (int i = 0; i < blockSize; ++i) {
+            render->output.push_back(buffer.getSample(0, i));
+            render->output.push_back(buffer.getSample(1, i));
+        }
+    }
+    readStageMeans(*synth, *render);
+    return *render;
+}
+
+static void SIMDDifferential(benchmark::State& state)
+{
+    const int instrument = static_cast<int>(state.range(0));
+    const auto backend = static_cast<sfz::SIMDBackend>(state.range(1));
+    state.SetLabel(sfz::simdBackendName(backend));
+    if (!backendAvailable(backend)) {
+        state.SkipWithError("The backend is not available");
+        return;
+    }
+
+    const Render& reference = scalarRender(instrument);
+
+    // The deviations, over the same blocks as the reference
+    selectBackend(backend);
+    auto synth = makeSynth(instrument);
+    sfz::AudioBuffer<float> buffer { 2, blockSize };
+    double maxDeviation = 0.0;
+    double sumSquares = 0.0;
+    size_t index = 0;
+    for (int block = 0; block < numReferenceBlocks; ++block) {
+        synth->renderBlock(buffer);
+        for (int i = 0; i < blockSize; ++i) {
+            for (int c = 0; c < 2; ++c) {
+                const double deviation = std::abs(buffer.getSample(c, i) - reference.output[index++]);
+                maxDeviation = std::max(maxDeviation, deviation);
+                sumSquares += deviation * deviation;
+            }
+        }
+    }
+
+    synth->resetCallbackStats();
+    for (auto _ : state) {
+        synth->renderBlock(buffer);
+        benchmark::ClobberMemory();
+    }
+
+    Render render;
+    readStageMeans(*synth, render);
+    state.counters["MaxDeviation"] = maxDeviation;
+    state.counters["RMSDeviation"] = std::sqrt(sumSquares / reference.output.size());
+    for (size_t i = 0; i < render.stageMeans.size(); ++i) {
+        if (reference.stageMeans[i] > 0.0)
+            state.counters[std::string(stageName(timedStages[i])) + "Ratio"] = render.stageMeans[i] / reference.stageMeans[i];
+    }
+
+    sfz::resetSIMDOpStatus<float>();
+}
+
+static void DifferentialArguments(benchmark::internal::Benchmark* b)
+{
+    for (int instrument : { kOscillator, kFiltered, kLooped, kUnison, kEffects })
+        for (auto backend : { sfz::SIMDBackend::scalar, sfz::SIMDBackend::sse, sfz::SIMDBackend::avx, sfz::SIMDBackend::neon })
+            b->Args({ instrument, static_cast<int>(backend) });
+}
+
+BENCHMARK(SIMDDifferential)->Apply(DifferentialArguments);
+BENCHMARK_MAIN();
@@ -52,6 +52,55 @@ BENCHMARK_DEFINE_F(SmootherFixture, Linear) (benchmark::State& state)
     }
 }
 
+// Several targets, with the inputs of the fixture shifted for each
+constexpr unsigned numTargets = 8;
+
+BENCHMARK_DEFINE_F(SmootherFixture, OnePoleMulti) (benchmark::State& state)
+{
+    std::vector<sfz::OnePoleSmoother> smoothers(numTargets);
+    std::vector<std::vector<float>> outputs(numTargets, output);
+    for (auto& smoother : smoothers)
+        smoother.setSmoothing(10, sfz::config::defaultSampleRate);
+    for (auto _ : state) {
+        for (unsigned k = 0; k < numTargets; ++k)
+            smoothers[k].process(input, absl::MakeSpan(outputs[k]));
+    }
+}
+
+BENCHMARK_DEFINE_F(SmootherFixture, OnePoleBank) (benchmark::State& state)
+{
+    std::vector<sfz::OnePoleSmoother> smoothers(numTargets);
+    std::vector<std::vector<float>> outputs(numTargets, output);
+    sfz::OnePoleSmoother* pointers[numTargets];
+    const float* inputs[numTargets];
+    float* outputPointers[numTargets];
+    for (unsigned k = 0; k < numTargets; ++k) {
+        smoothers[k].setSmoothing(10, sfz::config::defaultSampleRate);
+        pointers[k] = &smoothers[k];
+        inputs[k] = input.data();
+        outputPointers[k] = outputs[k].data();
+    }
+    const unsigned numFrames = static_cast<unsigned>(input.size());
+    for (auto _ : state) {
+        sfz::OnePoleSmootherBank::process(pointers, inputs, outputPointers, nullptr, numTargets, numFrames);
+    }
+}
+
+BENCHMARK_DEFINE_F(SmootherFixture, LinearMulti) (benchmark::State& state)
+{
+    std::vector<sfz::LinearSmoother> smoothers(numTargets);
+    std::vector<std::vector<float>> outputs(numTargets, output);
+    for (auto& smoother : smoothers)
+        smoother.setSmoothing(10, sfz::config::defaultSampleRate);
+    for (auto _ : state) {
+        for (unsigned k = 0; k < numTargets; ++k)
+            smoothers[k].process(input, absl::MakeSpan(outputs[k]));
+    }
+}
+
 BENCHMARK_REGISTER_F(SmootherFixture, OnePole)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
 BENCHMARK_REGISTER_F(SmootherFixture, Linear)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
+BENCHMARK_REGISTER_F(SmootherFixture, OnePoleMulti)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
+BENCHMARK_REGISTER_F(SmootherFixture, OnePoleBank)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
+BENCHMARK_REGISTER_F(SmootherFixture, LinearMulti)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
 BENCHMARK_MAIN();
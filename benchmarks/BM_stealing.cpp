@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Voice.h"
+#include "VoiceStealing.h"
+#include "AudioBuffer.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+constexpr int blockSize { 256 };
+
+class StealingFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const int numVoices = static_cast<int>(state.range(0));
+        synth.setSamplesPerBlock(blockSize);
+        synth.setNumVoices(numVoices);
+        synth.loadSfzString("stealing.sfz", R"(
+            <region> sample=*sine ampeg_attack=0.01 ampeg_decay=0.5 ampeg_sustain=20
+        )");
+
+        // Start the voices at different times, so that they differ in age and power
+        sfz::AudioBuffer<float> buffer { 2, blockSize };
+        for (int i = 0; i < numVoices; ++i) {
+            synth.noteOn(0, i % 128, 1 + (i * 37) % 127);
+            synth.renderBlock(buffer);
+        }
+
+        voices.clear();
+        for (int i = 0; i < numVoices; ++i)
+            voices.push_back(const_cast<sfz::Voice*>(synth.getVoiceView(i)));
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+    }
+
+    sfz::Synth synth;
+    std::vector<sfz::Voice*> voices;
+};
+
+BENCHMARK_DEFINE_F(StealingFixture, EnvelopeAndAge)(benchmark::State& state)
+{
+    sfz::EnvelopeAndAgeStealer stealer;
+    const unsigned polyphony = static_cast<unsigned>(voices.size());
+    for (auto _ : state) {
+        sfz::Voice* stolen = stealer.checkPolyphony(absl::MakeSpan(voices), polyphony);
+        benchmark::DoNotOptimize(stolen);
+    }
+}
+
+BENCHMARK_DEFINE_F(StealingFixture, Oldest)(benchmark::State& state)
+{
+    sfz::OldestStealer stealer;
+    const unsigned polyphony = static_cast<unsigned>(voices.size());
+    for (auto _ : state) {
+        sfz::Voice* stolen = stealer.checkPolyphony(absl::MakeSpan(voices), polyphony);
+        benchmark::DoNotOptimize(stolen);
+    }
+}
+
+BENCHMARK_REGISTER_F(StealingFixture, EnvelopeAndAge)->RangeMultiplier(2)->Range(16, 256);
+BENCHMARK_REGISTER_F(StealingFixture, Oldest)->RangeMultiplier(2)->Range(16, 256);
+BENCHMARK_MAIN();
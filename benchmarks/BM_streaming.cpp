@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Resources.h"
+#include "FilePool.h"
+#include "AudioReader.h"
+#include "AudioBuffer.h"
+#include <benchmark/benchmark.h>
+#include <ghc/fs_std.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stream bursts of voices from a simulated storage, which serves one access
+// at a time with a latency and a throughput, and measure how the streaming
+// keeps up in real time.
+
+using Clock = std::chrono::steady_clock;
+
+struct StorageProfile {
+    const char* name;
+    double latency; // seconds per access
+    double throughput; // bytes per second
+};
+
+static const StorageProfile storageProfiles[] {
+    { "NVMe", 100e-6, 2000e6 },
+    { "HDD", 8e-3, 150e6 },
+    { "NFS", 2e-3, 60e6 },
+};
+
+constexpr int blockSize { 256 };
+constexpr float sampleRate { 44100.0f };
+constexpr double burstDuration { 1.0 }; // seconds of audio per burst
+constexpr uint32_t preloadSize { 8192 };
+constexpr uint32_t streamingWindow { 65536 };
+
+class SimulatedStorage {
+public:
+    explicit SimulatedStorage(const StorageProfile& profile)
+        : profile_(profile)
+    {
+    }
+
+    /**
+     * @brief Wait for an access of some bytes, queued after the pending ones
+     */
+    void access(size_t numBytes)
+    {
+        const auto cost = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(profile_.latency + numBytes / profile_.throughput));
+        Clock::time_point end;
+        {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            busyUntil_ = std::max(busyUntil_, Clock::now()) + cost;
+            end = busyUntil_;
+        }
+        std::this_thread::sleep_until(end);
+    }
+
+    /**
+     * @brief Record the time at which a stream got its first frames
+     */
+    void addFirstRead(Clock::time_point time)
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        firstReads_.push_back(time);
+    }
+
+    std::vector<Clock::time_point> takeFirstReads()
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        std::vector<Clock::time_point> reads;
+        std::swap(reads, firstReads_);
+        return reads;
+    }
+
+private:
+    const StorageProfile& profile_;
+    std::mutex mutex_;
+    Clock::time_point busyUntil_ {};
+    std::vector<Clock::time_point> firstReads_;
+};
+
+class SlowReader : public sfz::AudioReader {
+public:
+    SlowReader(sfz::AudioReaderPtr reader, SimulatedStorage& storage)
+        : reader_(std::move(reader)), storage_(storage)
+    {
+    }
+
+    sfz::AudioReaderType type() const override { return reader_->type(); }
+    int format() const override { return reader_->format(); }
+    int64_t frames() const override { return reader_->frames(); }
+    unsigned channels() const override { return reader_->channels(); }
+    unsigned sampleRate() const override { return reader_->sampleRate(); }
+
+    size_t readNextBlock(float* buffer, size_t frames) override
+    {
+        storage_.access(numBytes(frames));
+        const size_t numRead = reader_->readNextBlock(buffer, frames);
+        recordFirstRead();
+        return numRead;
+    }
+
+    size_t readNextFrames(float* const outputs[], size_t frames) override
+    {
+        storage_.access(numBytes(frames));
+        const size_t numRead = reader_->readNextFrames(outputs, frames);
+        recordFirstRead();
+        return numRead;
+    }
+
+private:
+    // bytes of 16-bit frames
+    size_t numBytes(size_t frames) const { return frames * reader_->channels() * 2; }
+
+    void recordFirstRead()
+    {
+        if (!hasRead_) {
+            hasRead_ = true;
+            storage_.addFirstRead(Clock::now());
+        }
+    }
+
+    sfz::AudioReaderPtr reader_;
+    SimulatedStorage& storage_;
+    bool hasRead_ { false };
+};
+
+static void Streaming(benchmark::State& state)
+{
+    const StorageProfile& profile = storageProfiles[state.range(0)];
+    const int numVoices = static_cast<int>(state.range(1));
+    state.SetLabel(profile.name);
+
+    const auto blockDuration = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(blockSize / static_cast<double>(sampleRate)));
+    const int numBlocks = static_cast<int>(burstDuration * sampleRate / blockSize);
+    const fs::path directory { SFIZZ_BENCHMARK_FILES };
+
+    double firstFrameTime = 0.0;
+    double maxFirstFrameTime = 0.0;
+    double numStreams = 0.0;
+    double numUnderruns = 0.0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        SimulatedStorage storage { profile };
+        sfz::Synth synth;
+        synth.setSampleRate(sampleRate);
+        synth.setSamplesPerBlock(blockSize);
+        synth.setNumVoices(numVoices);
+        synth.setPreloadSize(preloadSize);
+        synth.setStreamingWindow(streamingWindow);
+        synth.getResources().getFilePool().setStreamReaderFactory(
+            [&storage](const fs::path& path, bool reverse, std::error_code* ec) -> sfz::AudioReaderPtr {
+                storage.access(0); // the opening of the file
+                sfz::AudioReaderPtr reader = sfz::createAudioReader(path, reverse, ec);
+                if (!reader)
+                    return {};
+                return sfz::AudioReaderPtr { new SlowReader(std::move(reader), storage) };
+            });
+        synth.loadSfzString(directory / "streaming.sfz", R"(
+            <region> lokey=0 hikey=63 pitch_keycenter=48 sample=looped_flute.wav loop_mode=no_loop
+            <region> lokey=64 hikey=127 pitch_keycenter=72 sample=stereo_sample.wav loop_mode=no_loop
+        )");
+        sfz::AudioBuffer<float> buffer { 2, blockSize };
+        state.ResumeTiming();
+
+        // Trigger the burst, and render in real time
+        const Clock::time_point trigger = Clock::now();
+        for (int i = 0; i < numVoices; ++i)
+            synth.noteOn(0, 36 + (i * 5) % 60, 100);
+        for (int block = 0; block < numBlocks; ++block) {
+            synth.renderBlock(buffer);
+            std::this_thread::sleep_until(trigger + (block + 1) * blockDuration);
+        }
+
+        state.PauseTiming();
+        const std::vector<Clock::time_point> firstReads = storage.takeFirstReads();
+        double sum = 0.0;
+        for (Clock::time_point read : firstReads) {
+            const double time = std::chrono::duration<double>(read - trigger).count();
+            sum += time;
+            maxFirstFrameTime = std::max(maxFirstFrameTime, time);
+        }
+        if (!firstReads.empty())
+            firstFrameTime += sum / firstReads.size();
+        numStreams += static_cast<double>(firstReads.size());
+        numUnderruns += static_cast<double>(synth.getUnderrunStats().numUnderruns);
+        synth.getResources().getFilePool().setStreamReaderFactory({});
+        state.ResumeTiming();
+    }
+
+    // The time to the first frames is from the burst to the first read of
+    // the streams, and the streams are those which got frames during the
+    // burst. A voice stops on its first underrun, so the sustained streams
+    // are the voices which played the whole burst.
+    const double numBursts = static_cast<double>(state.iterations());
+    state.counters["FirstFrameMs"] = 1e3 * firstFrameTime / numBursts;
+    state.counters["MaxFirstFrameMs"] = 1e3 * maxFirstFrameTime;
+    state.counters["Streams"] = numStreams / numBursts;
+    state.counters["Underruns"] = numUnderruns / numBursts;
+    state.counters["SustainedStreams"] = std::max(numVoices - numUnderruns / numBursts, 0.0);
+}
+
+static void StreamingArguments(benchmark::internal::Benchmark* b)
+{
+    const int numProfiles = static_cast<int>(sizeof(storageProfiles) / sizeof(storageProfiles[0]));
+    for (int profile = 0; profile < numProfiles; ++profile)
+        for (int numVoices : { 8, 32, 64, 128, 256 })
+            b->Args({ profile, numVoices });
+}
+
+BENCHMARK(Streaming)
+    ->ArgNames({ "storage", "voices" })
+    ->Apply(StreamingArguments)
+    ->Iterations(3)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_MAIN();
@@ -11,6 +11,9 @@
 #include "effects/impl/ResonantArray.h"
 #include "effects/impl/ResonantArraySSE.h"
 #include "effects/impl/ResonantArrayAVX.h"
+#include "effects/impl/ResonantArrayAVX512.h"
+#include "effects/impl/ResonantArrayNEON.h"
+#include "cpuid/cpuinfo.hpp"
 #include <benchmark/benchmark.h>
 #include <random>
 #include <vector>
@@ -93,11 +96,43 @@ BENCHMARK_DEFINE_F(StringResonator, StringResonator_AVX)(benchmark::State& state
         resonator.process(input.data(), output.data(), numFrames);
     }
 }
+
+BENCHMARK_DEFINE_F(StringResonator, StringResonator_AVX512)(benchmark::State& state) {
+    if (!cpuid::cpuinfo().has_avx512_f()) {
+        state.SkipWithError("AVX-512 is not supported");
+        return;
+    }
+    ScopedFTZ ftz;
+    sfz::fx::ResonantArrayAVX512 resonator;
+    resonator.setup(sampleRate, numStrings, pitches.data(), bandwidths.data(), feedbacks.data(), gains.data());
+    resonator.setSamplesPerBlock(numFrames);
+    for (auto _ : state)
+    {
+        resonator.process(input.data(), output.data(), numFrames);
+    }
+}
+#endif
+
+#if SFIZZ_HAVE_NEON
+BENCHMARK_DEFINE_F(StringResonator, StringResonator_NEON)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    sfz::fx::ResonantArrayNEON resonator;
+    resonator.setup(sampleRate, numStrings, pitches.data(), bandwidths.data(), feedbacks.data(), gains.data());
+    resonator.setSamplesPerBlock(numFrames);
+    for (auto _ : state)
+    {
+        resonator.process(input.data(), output.data(), numFrames);
+    }
+}
 #endif
 
 BENCHMARK_REGISTER_F(StringResonator, StringResonator_Scalar)->RangeMultiplier(4)->Range(1, 128);
 #if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
 BENCHMARK_REGISTER_F(StringResonator, StringResonator_SSE)->RangeMultiplier(4)->Range(1, 128);
 BENCHMARK_REGISTER_F(StringResonator, StringResonator_AVX)->RangeMultiplier(4)->Range(1, 128);
+BENCHMARK_REGISTER_F(StringResonator, StringResonator_AVX512)->RangeMultiplier(4)->Range(1, 128);
+#endif
+#if SFIZZ_HAVE_NEON
+BENCHMARK_REGISTER_F(StringResonator, StringResonator_NEON)->RangeMultiplier(4)->Range(1, 128);
 #endif
 BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "Resources.h"
+#include "FilePool.h"
+#include "AudioBuffer.h"
+#include <benchmark/benchmark.h>
+#include <ghc/fs_std.hpp>
+#include <memory>
+#include <string>
+
+// Render the whole synth, with instruments sweeping the main paths of the
+// processing. The instruments use the samples of the test files.
+
+enum Instrument {
+    kSampled, // looping samples, preloaded
+    kStreamed, // looping samples, preloaded in part and streamed
+    kWavetables, // wavetable and unison oscillators
+    kModulated, // LFOs, envelopes and CCs on filters, EQs, pitch and amplitude
+    kEffectBuses, // samples sent to effect buses
+};
+
+static std::string instrumentText(int instrument)
+{
+    std::string text;
+    switch (instrument) {
+    case kSampled:
+    case kStreamed:
+        // a region per key, with a sample shared by 4 keys
+        for (int key = 0; key < 128; ++key) {
+            text += "<region> key=" + std::to_string(key)
+                + " pitch_keycenter=" + std::to_string(key - key % 4)
+                + (key % 8 < 4 ? " sample=looped_flute.wav" : " sample=stereo_sample.wav")
+                + " loop_mode=loop_continuous ampeg_release=0.5\n";
+        }
+        break;
+    case kWavetables:
+        text = R"(
+            <region> hikey=63 sample=wavetables/surge.wav oscillator=on oscillator_multi=3 oscillator_detune=20
+            <region> lokey=64 sample=*saw oscillator_multi=5 oscillator_detune=15
+        )";
+        break;
+    case kModulated:
+        text = R"(
+            <region> sample=*saw
+                fil_type=lpf_2p cutoff=800 resonance=6 fil_veltrack=1200 cutoff_oncc74=2400
+                fil2_type=hpf_1p cutoff2=100
+                eq1_freq=500 eq1_gain=6 eq1_gain_oncc1=-6
+                lfo1_freq=3 lfo1_cutoff=1200
+                lfo2_freq=0.5 lfo2_pitch=20
+                lfo3_freq=7 lfo3_volume=2
+                eg1_time1=0.1 eg1_level1=1 eg1_time2=1 eg1_level2=0.3 eg1_sustain=2 eg1_cutoff=2400
+                amplitude_oncc7=100 pan_oncc10=100 pitch_oncc1=50
+        )";
+        break;
+    case kEffectBuses:
+        text = R"(
+            <region> sample=looped_flute.wav loop_mode=loop_continuous effect1=50 effect2=30
+            <effect> bus=fx1 type=fverb
+            <effect> bus=fx2 type=lofi
+        )";
+        break;
+    }
+    return text;
+}
+
+class SynthFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const int instrument = static_cast<int>(state.range(0));
+        numVoices = static_cast<int>(state.range(1));
+        blockSize = static_cast<int>(state.range(2));
+        sampleRate = static_cast<float>(state.range(3));
+        const int quality = static_cast<int>(state.range(4));
+
+        synth.reset(new sfz::Synth);
+        synth->setSampleRate(sampleRate);
+        synth->setSamplesPerBlock(blockSize);
+        synth->setNumVoices(numVoices);
+        synth->setSampleQuality(sfz::Synth::ProcessLive, quality);
+        synth->setOscillatorQuality(sfz::Synth::ProcessLive, quality);
+        if (instrument == kStreamed)
+            synth->setPreloadSize(1024);
+        const fs::path directory { SFIZZ_BENCHMARK_FILES };
+        synth->loadSfzString(directory / "synth.sfz", instrumentText(instrument));
+
+        buffer.reset(new sfz::AudioBuffer<float> { 2, static_cast<unsigned>(blockSize) });
+        for (int i = 0; i < numVoices; ++i)
+            synth->noteOn(0, 24 + (i * 7) % 96, 1 + (i * 37) % 127);
+
+        // Start the voices and finish the loading of the streamed samples
+        synth->renderBlock(*buffer);
+        synth->getResources().getFilePool().waitForBackgroundLoading();
+        synth->renderBlock(*buffer);
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        synth.reset();
+        buffer.reset();
+    }
+
+    std::unique_ptr<sfz::Synth> synth;
+    std::unique_ptr<sfz::AudioBuffer<float>> buffer;
+    int numVoices { 0 };
+    int blockSize { 0 };
+    float sampleRate { 0 };
+};
+
+BENCHMARK_DEFINE_F(SynthFixture, RenderBlock)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        synth->renderBlock(*buffer);
+        benchmark::ClobberMemory();
+    }
+
+    // The seconds of audio rendered per second of processing, times the
+    // voices, is the number of voices which one core renders at real time
+    const double blockDuration = blockSize / static_cast<double>(sampleRate);
+    const int activeVoices = synth->getNumActiveVoices();
+    state.counters["Voices"] = activeVoices;
+    state.counters["VoicesPerCore"] = benchmark::Counter(
+        activeVoices * blockDuration, benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["RealTime"] = benchmark::Counter(
+        blockDuration, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void SynthArguments(benchmark::internal::Benchmark* b)
+{
+    for (int instrument : { kSampled, kStreamed, kWavetables, kModulated, kEffectBuses })
+        for (int numVoices : { 8, 32, 64, 128, 256 })
+            for (int blockSize : { 64, 256, 1024 })
+                for (int sampleRate : { 44100, 96000 })
+                    for (int quality : { 1, 3 })
+                        b->Args({ instrument, numVoices, blockSize, sampleRate, quality });
+}
+
+BENCHMARK_REGISTER_F(SynthFixture, RenderBlock)
+    ->ArgNames({ "instrument", "voices", "block", "rate", "quality" })
+    ->Apply(SynthArguments)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_MAIN();
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  Start of a voice on a region, as done when a note-on is dispatched: the
+  filters, the EQs and the modulation targets of the region are set up, with
+  the unison of an oscillator.
+*/
+
+#include "Synth.h"
+#include "Layer.h"
+#include "Voice.h"
+#include "TriggerEvent.h"
+#include <benchmark/benchmark.h>
+
+constexpr int blockSize { 256 };
+
+class VoiceStartFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const ::benchmark::State& /* state */)
+    {
+        synth.setSamplesPerBlock(blockSize);
+        synth.setNumVoices(1);
+        synth.loadSfzString("voiceStart.sfz", R"(
+            <region> sample=*saw oscillator_multi=5 oscillator_detune=20
+                fil_type=lpf_2p cutoff=2000 cutoff_oncc20=1200 fil_veltrack=2400
+                fil2_type=hpf_1p cutoff2=100 resonance2_oncc21=6
+                eq1_freq=200 eq1_gain=3 eq2_freq=2000 eq2_gain_oncc22=6 eq3_freq=8000
+                amplitude_oncc23=100 pan_oncc24=50 pitch_oncc25=100
+                lfo1_freq=5 lfo1_volume=3 eg1_time1=0.1 eg1_level1=1 eg1_sustain=1 eg1_pitch=100
+        )");
+        layer = const_cast<sfz::Layer*>(synth.getLayerView(0));
+        voice = const_cast<sfz::Voice*>(synth.getVoiceView(0));
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+    }
+
+    sfz::Synth synth;
+    sfz::Layer* layer { nullptr };
+    sfz::Voice* voice { nullptr };
+};
+
+BENCHMARK_DEFINE_F(VoiceStartFixture, NoteOn)(benchmark::State& state)
+{
+    const sfz::TriggerEvent event { sfz::TriggerEventType::NoteOn, 60, 0.8f };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(voice->startVoice(layer, 0, event));
+        voice->reset();
+    }
+}
+
+BENCHMARK_REGISTER_F(VoiceStartFixture, NoteOn);
+BENCHMARK_MAIN();
@@ -24,13 +24,17 @@
 
 #include "sfizz.hpp"
 #include "sfizz/import/sfizz_import.h"
+#include "sfizz/import/ForeignInstrument.h"
 #include "MidiHelpers.h"
+#include "sfizz/RTSemaphore.h"
 #include <absl/flags/parse.h>
 #include <absl/flags/flag.h>
 #include <absl/types/span.h>
 #include <SpinMutex.h>
+#include <atomic_queue/atomic_queue.h>
 #include <atomic>
 #include <cstddef>
+#include <cstring>
 #include <ios>
 #include <iostream>
 #include <jack/jack.h>
@@ -38,46 +42,355 @@
 #include <jack/types.h>
 #include <ostream>
 #include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <sstream>
 #include <string_view>
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <algorithm>
+#include <memory>
 #include <vector>
 #if SFIZZ_JACK_USE_ALSA
 #include <regex>
 #include "alsa/asoundlib.h"
 #endif
 
-sfz::Sfizz synth;
+// One synth, or one per MIDI channel in multi-timbral mode
+static std::vector<std::unique_ptr<sfz::Sfizz>> synths;
+static bool multiTimbral { false };
+constexpr int numMidiChannels { 16 };
 
 static jack_port_t* midiInputPort;
-static jack_port_t* outputPort1;
-static jack_port_t* outputPort2;
+// A stereo pair of ports per synth, and their buffers in the current block
+static std::vector<jack_port_t*> outputPorts;
+static std::vector<float*> outputBuffers;
 static jack_client_t* client;
 #if SFIZZ_JACK_USE_ALSA
 static int alsaMidiInputPort;
 static snd_seq_t *alsa_client;
 #endif
-static SpinMutex processMutex;
+// Held while importing a foreign instrument, which has no asynchronous load,
+// and while changing the settings which reload or allocate; the process
+// callback outputs silence meanwhile
+static SpinMutex importMutex;
+
+/**
+ * @brief A MIDI event or a change of volume, sent by the other threads to the
+ * process callback, which applies them at the start of its next block.
+ */
+struct Command {
+    enum Type : uint8_t {
+        None,
+        SetVolume,
+        NoteOn,
+        NoteOff,
+        PolyAftertouch,
+        ControlChange,
+        ChannelAftertouch,
+        PitchWheel,
+    };
+    Type type { None };
+    uint8_t channel { 0 };
+    bool timed { false }; // whether the frame time is set
+    int number { 0 };
+    int value { 0 };
+    float floatValue { 0.0f };
+    jack_nframes_t frameTime { 0 }; // the JACK frame time of the reception of a MIDI event
+};
+
+// The producers are the command line and the ALSA input
+static atomic_queue::AtomicQueue2<Command, 1024> commandQueue;
+// The timed commands received during the current block, for the next one
+constexpr size_t maxDeferredCommands { 1024 };
+static std::vector<Command> deferredCommands;
+
+static void sendCommand(Command::Type type, int number = 0, int value = 0, float floatValue = 0.0f, int channel = 0)
+{
+    Command command;
+    command.type = type;
+    command.channel = static_cast<uint8_t>(channel);
+    command.number = number;
+    command.value = value;
+    command.floatValue = floatValue;
+    commandQueue.push(command);
+}
+
+#if SFIZZ_JACK_USE_ALSA
+/**
+ * @brief Send a MIDI event with the frame time of its reception, which the
+ * process callback converts into a delay in its block.
+ */
+static void sendTimedCommand(Command::Type type, int number, int value, int channel)
+{
+    Command command;
+    command.type = type;
+    command.channel = static_cast<uint8_t>(channel);
+    command.timed = true;
+    command.number = number;
+    command.value = value;
+    command.frameTime = jack_frame_time(client);
+    commandQueue.push(command);
+}
+#endif
+
+/**
+ * @brief Return the synth which plays a MIDI channel.
+ */
+static sfz::Sfizz* synthForChannel(int channel)
+{
+    if (!multiTimbral)
+        return synths.front().get();
+
+    return synths[static_cast<size_t>(channel) % synths.size()].get();
+}
+
+/**
+ * @brief A setting of the synths which reloads the preloads or allocates,
+ * which is changed out of the process callback.
+ */
+enum class Setting {
+    SamplesPerBlock,
+    SampleRate,
+    NumVoices,
+    PreloadSize,
+    Oversampling,
+};
+
+/**
+ * @brief Change a setting of all the channels, from a control thread. The
+ * process callback outputs silence until the change is done.
+ */
+static void changeSetting(Setting setting, int value)
+{
+    std::lock_guard<SpinMutex> lock { importMutex };
+    for (auto& synth : synths) {
+        switch (setting) {
+        case Setting::SamplesPerBlock:
+            synth->setSamplesPerBlock(value);
+            break;
+        case Setting::SampleRate:
+            synth->setSampleRate(static_cast<float>(value));
+            break;
+        case Setting::NumVoices:
+            synth->setNumVoices(value);
+            break;
+        case Setting::PreloadSize:
+            synth->setPreloadSize(static_cast<uint32_t>(value));
+            break;
+        case Setting::Oversampling:
+            synth->setOversamplingFactor(value);
+            break;
+        }
+    }
+}
+
+static void applyCommand(const Command& command, int delay)
+{
+    sfz::Sfizz* synth = synthForChannel(command.channel);
+    switch (command.type) {
+    case Command::None:
+        break;
+    case Command::SetVolume:
+        // The volume applies to all the channels
+        for (auto& channelSynth : synths)
+            channelSynth->setVolume(command.floatValue);
+        break;
+    case Command::NoteOn:
+        synth->noteOn(delay, command.number, command.value);
+        break;
+    case Command::NoteOff:
+        synth->noteOff(delay, command.number, command.value);
+        break;
+    case Command::PolyAftertouch:
+        synth->polyAftertouch(delay, command.number, command.value);
+        break;
+    case Command::ControlChange:
+        synth->cc(delay, command.number, command.value);
+        break;
+    case Command::ChannelAftertouch:
+        synth->channelAftertouch(delay, command.value);
+        break;
+    case Command::PitchWheel:
+        synth->pitchWheel(delay, command.value);
+        break;
+    }
+}
+
+/**
+ * @brief Apply a command in the block, unless it is timed after the block.
+ *
+ * The timed commands play one block after their reception, which keeps
+ * their spacing whatever the size of the blocks; the ones received after
+ * the start of the block wait for the next.
+ *
+ * @return false if the command is for a later block
+ */
+static bool applyCommandInBlock(const Command& command, jack_nframes_t cycleStart, jack_nframes_t numFrames)
+{
+    int delay = 0;
+    if (command.timed) {
+        // The difference of the frame times, which wrap around
+        const auto frameDelay = static_cast<int32_t>(command.frameTime + numFrames - cycleStart);
+        if (frameDelay >= static_cast<int32_t>(numFrames))
+            return false;
+        delay = std::max<int32_t>(frameDelay, 0);
+    }
+
+    applyCommand(command, delay);
+    return true;
+}
+
+static void applyCommands(jack_nframes_t numFrames)
+{
+    const jack_nframes_t cycleStart = jack_last_frame_time(client);
+
+    // The commands deferred from the last block are the earliest
+    const auto deferredEnd = std::remove_if(deferredCommands.begin(), deferredCommands.end(),
+        [&](const Command& command) { return applyCommandInBlock(command, cycleStart, numFrames); });
+    deferredCommands.erase(deferredEnd, deferredCommands.end());
+
+    Command command;
+    while (commandQueue.try_pop(command)) {
+        if (applyCommandInBlock(command, cycleStart, numFrames))
+            continue;
+        if (deferredCommands.size() < maxDeferredCommands)
+            deferredCommands.push_back(command);
+        else
+            applyCommand(command, static_cast<int>(numFrames) - 1);
+    }
+}
+
+/**
+ * @brief Worker threads which render the synths of the channels along with
+ * the process callback. The synths are claimed one at a time from a shared
+ * counter, so that the callback renders its share as well, and only waits
+ * for the last ones to finish.
+ *
+ * The workers are real-time threads of the JACK client, which the callback
+ * wakes and waits for with semaphores, without locking.
+ */
+class ParallelRenderer {
+public:
+    ~ParallelRenderer() { stop(); }
+
+    /**
+     * @brief Start the workers, at the priority of the process callback.
+     * Call it once the JACK client is open.
+     */
+    void start(jack_client_t* jackClient, unsigned numWorkers)
+    {
+        stop();
+        quit_.store(false, std::memory_order_relaxed);
+        const int realtime = jack_is_realtime(jackClient);
+        const int priority = realtime ? jack_client_real_time_priority(jackClient) : 0;
+        workers_.reserve(numWorkers);
+        for (unsigned i = 0; i < numWorkers; ++i) {
+            workers_.emplace_back(new Worker);
+            Worker& worker = *workers_.back();
+            worker.renderer = this;
+            if (jack_client_create_thread(jackClient, &worker.thread, priority, realtime, &ParallelRenderer::workerProc, &worker) != 0) {
+                std::cerr << "Could not create a render thread" << '\n';
+                workers_.pop_back();
+                break;
+            }
+        }
+    }
+
+    void stop()
+    {
+        quit_.store(true, std::memory_order_relaxed);
+        for (auto& worker : workers_)
+            worker->semStart.post();
+        for (auto& worker : workers_)
+            pthread_join(worker->thread, nullptr);
+        workers_.clear();
+    }
+
+    unsigned getNumWorkers() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief Render all the synths into the output buffers of the block.
+     */
+    void render(jack_nframes_t numFrames)
+    {
+        numFrames_ = numFrames;
+        nextSynth_.store(0, std::memory_order_relaxed);
+
+        const size_t numWorkers = workers_.size();
+        for (size_t i = 0; i < numWorkers; ++i)
+            workers_[i]->semStart.post();
+
+        renderPending();
+
+        for (size_t i = 0; i < numWorkers; ++i)
+            semDone_.wait();
+    }
+
+private:
+    struct Worker {
+        ParallelRenderer* renderer { nullptr };
+        jack_native_thread_t thread {};
+        RTSemaphore semStart;
+    };
+
+    void renderPending()
+    {
+        const unsigned numSynths = static_cast<unsigned>(synths.size());
+        unsigned index;
+        while ((index = nextSynth_.fetch_add(1, std::memory_order_relaxed)) < numSynths) {
+            float* stereoOutput[] = { outputBuffers[2 * index], outputBuffers[2 * index + 1] };
+            synths[index]->renderBlock(stereoOutput, numFrames_);
+        }
+    }
+
+    static void* workerProc(void* arg)
+    {
+        Worker& worker = *static_cast<Worker*>(arg);
+        ParallelRenderer& renderer = *worker.renderer;
+        while (true) {
+            worker.semStart.wait();
+            if (renderer.quit_.load(std::memory_order_relaxed))
+                break;
+            renderer.renderPending();
+            renderer.semDone_.post();
+        }
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    RTSemaphore semDone_;
+    std::atomic<bool> quit_ { false };
+    std::atomic<unsigned> nextSynth_ { 0 };
+    jack_nframes_t numFrames_ { 0 };
+};
+
+static ParallelRenderer renderer;
 
 int process(jack_nframes_t numFrames, void* arg)
 {
-    auto* synth = reinterpret_cast<sfz::Sfizz*>(arg);
+    (void)arg;
 
     auto* buffer = jack_port_get_buffer(midiInputPort, numFrames);
     assert(buffer);
 
-    auto* leftOutput = reinterpret_cast<float*>(jack_port_get_buffer(outputPort1, numFrames));
-    auto* rightOutput = reinterpret_cast<float*>(jack_port_get_buffer(outputPort2, numFrames));
+    for (size_t i = 0, n = outputPorts.size(); i < n; ++i)
+        outputBuffers[i] = reinterpret_cast<float*>(jack_port_get_buffer(outputPorts[i], numFrames));
 
-    std::unique_lock<SpinMutex> lock { processMutex, std::try_to_lock };
+    std::unique_lock<SpinMutex> lock { importMutex, std::try_to_lock };
     if (!lock.owns_lock()) {
-        std::fill_n(leftOutput, numFrames, 0.0f);
-        std::fill_n(rightOutput, numFrames, 0.0f);
+        for (float* output : outputBuffers)
+            std::fill_n(output, numFrames, 0.0f);
         return 0;
     }
 
+    applyCommands(numFrames);
+
     auto numMidiEvents = jack_midi_get_event_count(buffer);
     jack_midi_event_t event;
 
@@ -89,6 +402,8 @@ int process(jack_nframes_t numFrames, void* arg)
         if (event.size == 0)
             continue;
 
+        sfz::Sfizz* synth = synthForChannel(midi::channel(event.buffer[0]));
+
         switch (midi::status(event.buffer[0])) {
         case midi::noteOff: noteoff:
             synth->noteOff(event.time, event.buffer[1], event.buffer[2]);
@@ -119,62 +434,48 @@ int process(jack_nframes_t numFrames, void* arg)
         }
     }
 
-    float* stereoOutput[] = { leftOutput, rightOutput };
-    synth->renderBlock(stereoOutput, numFrames);
+    renderer.render(numFrames);
 
     return 0;
 }
 
 #if SFIZZ_JACK_USE_ALSA
-int process_alsa(snd_seq_event_t *event, sfz::Sfizz *synth)
+// The ALSA events go to the process callback with their time of reception,
+// and play one block later, at the same offset
+int process_alsa(snd_seq_event_t *event)
 {
-    const int numFrames = 1;        // XXX
-
-    auto* leftOutput = reinterpret_cast<float*>(jack_port_get_buffer(outputPort1, numFrames));
-    auto* rightOutput = reinterpret_cast<float*>(jack_port_get_buffer(outputPort2, numFrames));
-
-    std::unique_lock<SpinMutex> lock { processMutex, std::try_to_lock };
-    if (!lock.owns_lock()) {
-        std::fill_n(leftOutput, numFrames, 0.0f);
-        std::fill_n(rightOutput, numFrames, 0.0f);
+    if (!event)
         return 0;
-    }
 
-    // Midi dispatching
-    if (event) {
-        switch (event->type) {
-        case SND_SEQ_EVENT_NOTEOFF: noteoff:
-            synth->noteOff(event->time.tick, event->data.note.note, event->data.note.velocity);
-            break;
-        case SND_SEQ_EVENT_NOTEON:
-            if (event->data.note.velocity == 0)
-                goto noteoff;
-            synth->noteOn(event->time.tick, event->data.note.note, event->data.note.velocity);
-            break;
-        case SND_SEQ_EVENT_KEYPRESS:
-            synth->polyAftertouch(event->time.tick, event->data.note.note, event->data.note.velocity);
-            break;
-        case SND_SEQ_EVENT_CONTROLLER:
-            synth->cc(event->time.tick, event->data.control.param, event->data.control.value);
-            break;
-        case SND_SEQ_EVENT_PGMCHANGE:
-            // Not implemented
-            break;
-        case SND_SEQ_EVENT_CHANPRESS:
-            synth->channelAftertouch(event->time.tick, event->data.control.value);
-            break;
-        case SND_SEQ_EVENT_PITCHBEND:
-            synth->pitchWheel(event->time.tick, event->data.control.value);
-            break;
-        case SND_SEQ_EVENT_SYSEX:       // ?
-            // Not implemented
-            break;
-        }
+    switch (event->type) {
+    case SND_SEQ_EVENT_NOTEOFF: noteoff:
+        sendTimedCommand(Command::NoteOff, event->data.note.note, event->data.note.velocity, event->data.note.channel);
+        break;
+    case SND_SEQ_EVENT_NOTEON:
+        if (event->data.note.velocity == 0)
+            goto noteoff;
+        sendTimedCommand(Command::NoteOn, event->data.note.note, event->data.note.velocity, event->data.note.channel);
+        break;
+    case SND_SEQ_EVENT_KEYPRESS:
+        sendTimedCommand(Command::PolyAftertouch, event->data.note.note, event->data.note.velocity, event->data.note.channel);
+        break;
+    case SND_SEQ_EVENT_CONTROLLER:
+        sendTimedCommand(Command::ControlChange, event->data.control.param, event->data.control.value, event->data.control.channel);
+        break;
+    case SND_SEQ_EVENT_PGMCHANGE:
+        // Not implemented
+        break;
+    case SND_SEQ_EVENT_CHANPRESS:
+        sendTimedCommand(Command::ChannelAftertouch, 0, event->data.control.value, event->data.control.channel);
+        break;
+    case SND_SEQ_EVENT_PITCHBEND:
+        sendTimedCommand(Command::PitchWheel, 0, event->data.control.value, event->data.control.channel);
+        break;
+    case SND_SEQ_EVENT_SYSEX:       // ?
+        // Not implemented
+        break;
     }
 
-    float* stereoOutput[] = { leftOutput, rightOutput };
-    synth->renderBlock(stereoOutput, numFrames);
-
     return 0;
 }
 #endif
@@ -184,10 +485,8 @@ int sampleBlockChanged(jack_nframes_t nframes, void* arg)
     if (arg == nullptr)
         return 0;
 
-    auto* synth = reinterpret_cast<sfz::Sfizz*>(arg);
     // DBG("Sample per block changed to " << nframes);
-    std::lock_guard<SpinMutex> lock { processMutex };
-    synth->setSamplesPerBlock(nframes);
+    changeSetting(Setting::SamplesPerBlock, static_cast<int>(nframes));
     return 0;
 }
 
@@ -196,10 +495,8 @@ int sampleRateChanged(jack_nframes_t nframes, void* arg)
     if (arg == nullptr)
         return 0;
 
-    auto* synth = reinterpret_cast<sfz::Sfizz*>(arg);
     // DBG("Sample rate changed to " << nframes);
-    std::lock_guard<SpinMutex> lock { processMutex };
-    synth->setSampleRate(nframes);
+    changeSetting(Setting::SampleRate, static_cast<int>(nframes));
     return 0;
 }
 
@@ -215,15 +512,40 @@ static void done(int sig)
     // exit(0);
 }
 
-bool loadInstrument(const char* fpath)
+/**
+ * @brief Load an instrument while the synth keeps playing. The SFZ files load
+ * on a background thread, and replace the current instrument at the start
+ * of a block; the foreign instruments are imported with the process
+ * callback held.
+ *
+ * @param channel  The MIDI channel of the instrument, from 0, in
+ *                 multi-timbral mode.
+ */
+bool loadInstrument(const char* fpath, int channel = 0)
 {
+    if (channel < 0 || static_cast<size_t>(channel) >= synths.size()) {
+        std::cout << "Invalid channel: " << channel + 1 << '\n';
+        return false;
+    }
+
+    sfz::Sfizz& synth = *synths[channel];
     const char* importFormat = nullptr;
-    if (!sfizz_load_or_import_file(synth.handle(), fpath, &importFormat)) {
+    bool success;
+    if (sfz::InstrumentFormatRegistry::getInstance().getMatchingFormat(fpath)) {
+        std::lock_guard<SpinMutex> lock { importMutex };
+        success = sfizz_load_or_import_file(synth.handle(), fpath, &importFormat);
+    } else {
+        sfz::Sfizz::LoadPtr load = synth.loadSfzFileAsync(fpath);
+        success = load && sfz::Sfizz::waitLoad(*load);
+    }
+    if (!success) {
         std::cout << "Could not load the instrument file: " << fpath << '\n';
         return false;
     }
 
     std::cout << "Instrument loaded: " << fpath << '\n';
+    if (multiTimbral)
+        std::cout << "Channel: " << channel + 1 << '\n';
     std::cout << "===========================" << '\n';
     std::cout << "Total:" << '\n';
     std::cout << "\tMasters: " << synth.getNumMasters() << '\n';
@@ -284,10 +606,10 @@ std::vector<std::string> stringTokenize(const std::string& str)
 
 #if SFIZZ_JACK_USE_ALSA
 void cliShowSynthGain() {
-    std::cout << synth.getVolume();
+    std::cout << synths.front()->getVolume();
 }
 void cliSetSynthGain( std::string &val ) {
-    synth.setVolume(std::stof(val));
+    sendCommand(Command::SetVolume, 0, 0, std::stof(val));
 }
 typedef struct {
     const char *name;
@@ -316,37 +638,33 @@ void cliThreadProc()
 
         if (kw == "load_instrument") {
             try {
-                std::lock_guard<SpinMutex> lock { processMutex };
-                loadInstrument(tokens[0].c_str());
+                const int channel = (tokens.size() > 1) ? std::stoi(tokens[1]) - 1 : 0;
+                loadInstrument(tokens.at(0).c_str(), channel);
             } catch (...) {
                 std::cout << "ERROR: Can't load instrument!\n";
             }
         } else if (kw == "set_oversampling") {
             try {
-                std::lock_guard<SpinMutex> lock { processMutex };
-                synth.setOversamplingFactor(stoi(args));
+                changeSetting(Setting::Oversampling, stoi(args));
             } catch (...) {
                 std::cout << "ERROR: Can't set oversampling!\n";
             }
         } else if (kw == "set_preload_size") {
             try {
-                std::lock_guard<SpinMutex> lock { processMutex };
-                synth.setPreloadSize(stoi(args));
+                changeSetting(Setting::PreloadSize, stoi(args));
             } catch (...) {
                 std::cout << "ERROR: Can't set preload size!\n";
             }
         } else if (kw == "set_voices") {
             try {
-                std::lock_guard<SpinMutex> lock { processMutex };
-                synth.setNumVoices(stoi(args));
+                changeSetting(Setting::NumVoices, stoi(args));
             } catch (...) {
                 std::cout << "ERROR: Can't set num of voices!\n";
             }
 #if SFIZZ_JACK_USE_ALSA
         } else if (kw == "gain") {
             try {
-                std::lock_guard<SpinMutex> lock { processMutex };
-                synth.setVolume(stof(args));
+                sendCommand(Command::SetVolume, 0, 0, stof(args));
             } catch (...) {
                 std::cout << "ERROR: Can't set gain!\n";
             }
@@ -357,7 +675,7 @@ void cliThreadProc()
                 std::cout << '\n';
             }
         } else if (kw == "help") {
-            std::cout << "load_instrument file\n";
+            std::cout << "load_instrument file [channel]\n";
             std::cout << "set_oversampling num\n";
             std::cout << "set_reload_size num\n";
             std::cout << "set_voices num\n";
@@ -384,12 +702,116 @@ void alsaThreadProc()
             } else if (err < 0) {
                 std::cout << "DEBUG: snd_seq_event_input returned error " << err << "'" << snd_strerror(err) << "'\n";
             } else {
-                process_alsa(event, &synth);
+                process_alsa(event);
             }
         }
     }
 }
 
+/**
+ * @brief Format the streaming metrics of the synths in the OpenMetrics text
+ * format, with a label per synth.
+ */
+static std::string formatMetrics()
+{
+    std::ostringstream metrics;
+    auto family = [&](const char* name, const char* type, const char* help, auto value) {
+        metrics << "# TYPE " << name << ' ' << type << '\n';
+        metrics << "# HELP " << name << ' ' << help << '\n';
+        const char* suffix = std::strcmp(type, "counter") == 0 ? "_total" : "";
+        for (size_t i = 0; i < synths.size(); ++i)
+            metrics << name << suffix << "{synth=\"" << i << "\"} " << value(*synths[i]) << '\n';
+    };
+    using Stats = sfz::Sfizz::StreamingStats;
+    auto streaming = [](auto member) {
+        return [member](const sfz::Sfizz& synth) { return synth.getStreamingStats().*member; };
+    };
+
+    family("sfizz_streamed_bytes", "counter", "Bytes of the decoded frames streamed", streaming(&Stats::streamedBytes));
+    family("sfizz_streams", "counter", "Streams which read their first slice", streaming(&Stats::numStreams));
+    family("sfizz_first_slice_latency_seconds", "counter", "Total time from the stream requests to their first slices",
+        streaming(&Stats::totalFirstSliceLatency));
+    family("sfizz_first_slice_latency_max_seconds", "gauge", "Longest time from a stream request to its first slice",
+        streaming(&Stats::maxFirstSliceLatency));
+    family("sfizz_collected_bytes", "counter", "Bytes of streamed data freed by the garbage collection",
+        streaming(&Stats::collectedBytes));
+    family("sfizz_queued_requests", "gauge", "Stream requests waiting for the dispatching", streaming(&Stats::numQueuedRequests));
+    family("sfizz_queued_streams", "gauge", "Streams waiting for a slice", streaming(&Stats::numQueuedStreams));
+    family("sfizz_loading_jobs", "gauge", "Slices running", streaming(&Stats::numLoadingJobs));
+    family("sfizz_underruns", "counter", "Voices which ran out of streamed frames",
+        [](const sfz::Sfizz& synth) { return synth.getUnderrunStats().numUnderruns; });
+    family("sfizz_missing_frames", "counter", "Frames left silent by the underruns",
+        [](const sfz::Sfizz& synth) { return synth.getUnderrunStats().numMissingFrames; });
+
+    // The synths share the workers of the process
+    const Stats stats = synths.front()->getStreamingStats();
+    metrics << "# TYPE sfizz_workers gauge\n# HELP sfizz_workers Background worker threads\n"
+            << "sfizz_workers " << stats.numWorkers << '\n';
+    metrics << "# TYPE sfizz_workers_busy_seconds counter\n# HELP sfizz_workers_busy_seconds Time the workers ran tasks, summed over the workers\n"
+            << "sfizz_workers_busy_seconds_total " << stats.workersBusyTime << '\n';
+    metrics << "# TYPE sfizz_workers_elapsed_seconds counter\n# HELP sfizz_workers_elapsed_seconds Time since the start of the workers\n"
+            << "sfizz_workers_elapsed_seconds_total " << stats.workersElapsedTime << '\n';
+    metrics << "# EOF\n";
+    return metrics.str();
+}
+
+/**
+ * @brief Serve the metrics over HTTP to the scrapers, whatever the request,
+ * until the client closes.
+ */
+void metricsThreadProc(std::string host, int port)
+{
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "Invalid metrics address " << host << '\n';
+        return;
+    }
+
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Could not open the metrics socket" << '\n';
+        return;
+    }
+    const int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 4) < 0) {
+        std::cerr << "Could not serve the metrics on " << host << ':' << port << '\n';
+        close(listener);
+        return;
+    }
+
+    while (!shouldClose) {
+        // Wake up regularly to see the closing
+        pollfd listening { listener, POLLIN, 0 };
+        if (poll(&listening, 1, 500) <= 0)
+            continue;
+        const int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0)
+            continue;
+
+        char request[1024];
+        pollfd reading { connection, POLLIN, 0 };
+        if (poll(&reading, 1, 1000) > 0 && recv(connection, request, sizeof(request), 0) > 0) {
+            const std::string body = formatMetrics();
+            const std::string response = "HTTP/1.0 200 OK\r\n"
+                "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body;
+            for (size_t sent = 0; sent < response.size();) {
+                const ssize_t result = send(connection, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (result <= 0)
+                    break;
+                sent += static_cast<size_t>(result);
+            }
+        }
+        close(connection);
+    }
+    close(listener);
+}
+
 #if SFIZZ_JACK_USE_ALSA
 ABSL_FLAG(std::string, client_name, "sfizz", "Jack/ALSA client name");
 ABSL_FLAG(std::string, port, "", "Connect to this MIDI input");
@@ -401,6 +823,12 @@ ABSL_FLAG(uint32_t, preload_size, 8192, "Preloaded size");
 ABSL_FLAG(uint32_t, num_voices, 32, "Num of voices");
 ABSL_FLAG(bool, jack_autoconnect, false, "Autoconnect audio output");
 ABSL_FLAG(bool, state, false, "Output the synth state in the jack loop");
+ABSL_FLAG(bool, multi_timbral, false, "One synth per MIDI channel, loading the files in channel order");
+ABSL_FLAG(int32_t, render_threads, -1, "Threads rendering the channels with the JACK thread in multi-timbral mode (-1 for one per core)");
+ABSL_FLAG(std::string, cache_dir, "", "Directory of the decoded sample cache");
+ABSL_FLAG(int32_t, metrics_port, 0, "Serve the streaming metrics in the OpenMetrics format on this TCP port (0 to disable); "
+                                    "anyone reaching the port reads the state of the streaming and the workers, without authentication");
+ABSL_FLAG(std::string, metrics_address, "127.0.0.1", "IPv4 address the metrics are served on (0.0.0.0 for all the interfaces)");
 
 int main(int argc, char** argv)
 {
@@ -416,6 +844,11 @@ int main(int argc, char** argv)
     const uint32_t num_voices = absl::GetFlag(FLAGS_num_voices);
     const bool jack_autoconnect = absl::GetFlag(FLAGS_jack_autoconnect);
     const bool verboseState = absl::GetFlag(FLAGS_state);
+    const int32_t renderThreads = absl::GetFlag(FLAGS_render_threads);
+    const std::string cacheDir = absl::GetFlag(FLAGS_cache_dir);
+    const int32_t metricsPort = absl::GetFlag(FLAGS_metrics_port);
+    const std::string metricsAddress = absl::GetFlag(FLAGS_metrics_address);
+    multiTimbral = absl::GetFlag(FLAGS_multi_timbral);
 
     std::cout << "Flags" << '\n';
     std::cout << "- Client name: " << clientName << '\n';
@@ -427,6 +860,9 @@ int main(int argc, char** argv)
     std::cout << "- Num of voices: " << num_voices << '\n';
     std::cout << "- Audio Autoconnect: " << jack_autoconnect << '\n';
     std::cout << "- Verbose State: " << verboseState << '\n';
+    std::cout << "- Multi-timbral: " << multiTimbral << '\n';
+    std::cout << "- Metrics port: " << metricsPort << '\n';
+    std::cout << "- Metrics address: " << metricsAddress << '\n';
 
     const auto factor = [&]() {
         if (oversampling == "x1") return 1;
@@ -441,9 +877,20 @@ int main(int argc, char** argv)
         std::cout << " " << file << ',';
     std::cout << '\n';
 
-    synth.setOversamplingFactor(factor);
-    synth.setPreloadSize(preload_size);
-    synth.setNumVoices(num_voices);
+    // The synths share the preloaded samples and the loading threads of the
+    // process, so that the same instrument on several channels is read once
+    const int numSynths = multiTimbral ? numMidiChannels : 1;
+    for (int i = 0; i < numSynths; ++i) {
+        synths.emplace_back(new sfz::Sfizz);
+        sfz::Sfizz& synth = *synths.back();
+        synth.setOversamplingFactor(factor);
+        synth.setPreloadSize(preload_size);
+        synth.setNumVoices(num_voices);
+        if (!cacheDir.empty())
+            synth.setSampleCacheDirectory(cacheDir);
+    }
+    outputBuffers.resize(2 * synths.size());
+    deferredCommands.reserve(maxDeferredCommands);
 
     jack_status_t status;
     client = jack_client_open(clientName.c_str(), JackNullOption, &status);
@@ -479,12 +926,21 @@ int main(int argc, char** argv)
     std::cout << "Connected to ALSA as client " << snd_seq_client_id(alsa_client) << '\n';
 #endif
 
-    synth.setSamplesPerBlock(jack_get_buffer_size(client));
-    synth.setSampleRate(jack_get_sample_rate(client));
+    for (auto& synth : synths) {
+        synth->setSamplesPerBlock(jack_get_buffer_size(client));
+        synth->setSampleRate(jack_get_sample_rate(client));
+    }
+
+    if (multiTimbral) {
+        const unsigned numCores = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned numWorkers = (renderThreads < 0) ? numCores - 1 : static_cast<unsigned>(renderThreads);
+        renderer.start(client, std::min<unsigned>(numWorkers, numSynths - 1));
+        std::cout << "- Render threads: " << renderer.getNumWorkers() << '\n';
+    }
 
-    jack_set_sample_rate_callback(client, sampleRateChanged, &synth);
-    jack_set_buffer_size_callback(client, sampleBlockChanged, &synth);
-    jack_set_process_callback(client, process, &synth);
+    jack_set_sample_rate_callback(client, sampleRateChanged, &synths);
+    jack_set_buffer_size_callback(client, sampleBlockChanged, &synths);
+    jack_set_process_callback(client, process, &synths);
 
     midiInputPort = jack_port_register(client, "input", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
     if (midiInputPort == nullptr) {
@@ -500,11 +956,17 @@ int main(int argc, char** argv)
     }
 #endif
 
-    outputPort1 = jack_port_register(client, "output_1", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    outputPort2 = jack_port_register(client, "output_2", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    if (outputPort1 == nullptr || outputPort2 == nullptr) {
-        std::cerr << "Could not open output ports" << '\n';
-        return 1;
+    for (size_t i = 0; i < synths.size(); ++i) {
+        const std::string prefix = multiTimbral ? "ch" + std::to_string(i + 1) + "_" : "";
+        for (int side = 1; side <= 2; ++side) {
+            const std::string outputName = prefix + "output_" + std::to_string(side);
+            jack_port_t* port = jack_port_register(client, outputName.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            if (port == nullptr) {
+                std::cerr << "Could not open output ports" << '\n';
+                return 1;
+            }
+            outputPorts.push_back(port);
+        }
     }
 
     if (jack_activate(client) != 0) {
@@ -519,12 +981,11 @@ int main(int argc, char** argv)
             return 1;
         }
 
-        if (jack_connect(client, jack_port_name(outputPort1), systemPorts[0])) {
-            std::cerr << "Cannot connect to physical output ports (0)" << '\n';
-        }
-
-        if (jack_connect(client, jack_port_name(outputPort2), systemPorts[1])) {
-            std::cerr << "Cannot connect to physical output ports (1)" << '\n';
+        // Every channel goes to the first pair of physical outputs
+        for (size_t i = 0; i < outputPorts.size(); ++i) {
+            if (jack_connect(client, jack_port_name(outputPorts[i]), systemPorts[i % 2])) {
+                std::cerr << "Cannot connect to physical output ports (" << i % 2 << ")" << '\n';
+            }
         }
         jack_free(systemPorts);
     }
@@ -553,11 +1014,16 @@ int main(int argc, char** argv)
     }
 #endif
 
-    if (!filesToParse.empty() && filesToParse[0]) {
-        loadInstrument(filesToParse[0]);
+    const size_t numFilesToLoad = std::min(filesToParse.size(), synths.size());
+    for (size_t i = 0; i < numFilesToLoad; ++i) {
+        if (filesToParse[i])
+            loadInstrument(filesToParse[i], static_cast<int>(i));
     }
 
     std::thread cli_thread(cliThreadProc);
+    std::thread metrics_thread;
+    if (metricsPort > 0)
+        metrics_thread = std::thread(metricsThreadProc, metricsAddress, metricsPort);
 #if SFIZZ_JACK_USE_ALSA
     std::thread alsa_thread(alsaThreadProc);
 #endif
@@ -569,10 +1035,13 @@ int main(int argc, char** argv)
 
     while (!shouldClose) {
         if (verboseState) {
-            std::cout << "Active voices: " << synth.getNumActiveVoices() << '\n';
+            int numActiveVoices = 0;
+            for (auto& synth : synths)
+                numActiveVoices += synth->getNumActiveVoices();
+            std::cout << "Active voices: " << numActiveVoices << '\n';
 #ifndef NDEBUG
-            std::cout << "Allocated buffers: " << synth.getAllocatedBuffers() << '\n';
-            std::cout << "Total size: " << synth.getAllocatedBytes() << '\n';
+            std::cout << "Allocated buffers: " << synths.front()->getAllocatedBuffers() << '\n';
+            std::cout << "Total size: " << synths.front()->getAllocatedBytes() << '\n';
 #endif
         }
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -580,7 +1049,10 @@ int main(int argc, char** argv)
 
     std::cout << "Closing..." << '\n';
     jack_client_close(client);
+    renderer.stop();
     cli_thread.join();
+    if (metrics_thread.joinable())
+        metrics_thread.join();
 #if SFIZZ_JACK_USE_ALSA
     // Don't bother to join(). The thread uses a blocking call and there's no way to synthesize a dummy event to unblock it.
     //alsa_thread.join();
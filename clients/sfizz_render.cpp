@@ -4,19 +4,133 @@
 #include "sfizz/SfzHelpers.h"
 #include "sfizz/SIMDHelpers.h"
 #include "sfizz/utility/U8Strings.h"
+#include "sfizz/FilePool.h"
 #include "MidiHelpers.h"
 #include <st_audiofile_libs.h>
 #include <cxxopts.hpp>
 #include <fmidi/fmidi.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #define LOG_ERROR(ostream) std::cerr  << ostream << '\n'
 #define LOG_INFO(ostream) if (verbose) { std::cout << ostream << '\n'; }
 #define ERROR_IF(check, ostream) if ((check)) { LOG_ERROR(ostream); std::exit(-1); }
 
+enum class SampleFormat { Int16, Int24, Float32 };
+
+struct RenderSettings {
+    unsigned blockSize { 1024 };
+    int sampleRate { 48000 };
+    int quality { 2 };
+    int polyphony { 64 };
+    bool useEOT { false };
+    bool multiOutput { false }; // a file per stereo output
+    SampleFormat format { SampleFormat::Int16 };
+    fs::path cacheDirectory {};
+};
+
+/**
+ * @brief Timings of a rendering, for the benchmark report
+ */
+struct RenderReport {
+    uint64_t numFrames { 0 };
+    uint64_t numBlocks { 0 };
+    double duration { 0 }; // seconds, from the start to the end of the writing
+    sfz::Synth::CallbackBreakdown breakdown {}; // the totals of the blocks
+
+    void add(const RenderReport& other)
+    {
+        numFrames += other.numFrames;
+        numBlocks += other.numBlocks;
+        duration += other.duration;
+        breakdown.dispatch += other.breakdown.dispatch;
+        breakdown.renderMethod += other.breakdown.renderMethod;
+        breakdown.data += other.breakdown.data;
+        breakdown.amplitude += other.breakdown.amplitude;
+        breakdown.filters += other.breakdown.filters;
+        breakdown.panning += other.breakdown.panning;
+        breakdown.effects += other.breakdown.effects;
+        breakdown.culledVoices += other.breakdown.culledVoices;
+    }
+};
+
+/**
+ * @brief A queue of bounded size between two stages of the rendering. The
+ * producer waits while it is full, and the consumer while it is empty, until
+ * the producer closes it.
+ */
+template <class T>
+class StageQueue {
+public:
+    explicit StageQueue(size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock { mutex_ };
+        notFull_.wait(lock, [this]() { return items_.size() < capacity_; });
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+    }
+
+    /**
+     * @brief Take the next item, or return false once the queue is closed
+     * and empty.
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock { mutex_ };
+        notEmpty_.wait(lock, [this]() { return !items_.empty() || closed_; });
+        if (items_.empty())
+            return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_;
+    bool closed_ { false };
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+constexpr size_t stageQueueSize { 16 }; // blocks between two stages
+constexpr uint64_t writeChunkFrames { 65536 }; // frames per write to the file
+
+struct MidiEvent {
+    unsigned delay;
+    uint8_t data[3];
+};
+
 struct CallbackData {
-    sfz::Synth& synth;
+    std::vector<MidiEvent>& events;
     unsigned delay;
     bool finished;
 };
@@ -28,62 +142,567 @@ void midiCallback(const fmidi_event_t * event, void * cbdata)
     if (event->type != fmidi_event_type::fmidi_event_message)
         return;
 
-    switch (midi::status(event->data[0])) {
+    MidiEvent midiEvent { data->delay, { 0, 0, 0 } };
+    std::copy_n(event->data, std::min<uint32_t>(event->datalen, 3), midiEvent.data);
+    data->events.push_back(midiEvent);
+}
+
+void finishedCallback(void * cbdata)
+{
+    auto data = reinterpret_cast<CallbackData*>(cbdata);
+    data->finished = true;
+}
+
+void sendMidiEvent(sfz::Synth& synth, const MidiEvent& event)
+{
+    const unsigned delay = event.delay;
+    switch (midi::status(event.data[0])) {
         case midi::noteOff:
-            data->synth.noteOff(data->delay, event->data[1], event->data[2]);
+            synth.noteOff(delay, event.data[1], event.data[2]);
             break;
         case midi::noteOn:
-            if (event->data[2] == 0)
-                data->synth.noteOff(data->delay, event->data[1], event->data[2]);
+            if (event.data[2] == 0)
+                synth.noteOff(delay, event.data[1], event.data[2]);
             else
-                data->synth.noteOn(data->delay, event->data[1], event->data[2]);
+                synth.noteOn(delay, event.data[1], event.data[2]);
             break;
         case midi::polyphonicPressure:
             break;
         case midi::controlChange:
-            data->synth.cc(data->delay, event->data[1], event->data[2]);
+            synth.cc(delay, event.data[1], event.data[2]);
             break;
         case midi::programChange:
             break;
         case midi::channelPressure:
             break;
         case midi::pitchBend:
-            data->synth.pitchWheel(data->delay, midi::buildAndCenterPitch(event->data[1], event->data[2]));
+            synth.pitchWheel(delay, midi::buildAndCenterPitch(event.data[1], event.data[2]));
             break;
         case midi::systemMessage:
             break;
         }
 }
 
-void finishedCallback(void * cbdata)
+void setupSynth(sfz::Synth& synth, const RenderSettings& settings)
 {
-    auto data = reinterpret_cast<CallbackData*>(cbdata);
-    data->finished = true;
+    synth.setSamplesPerBlock(settings.blockSize);
+    synth.setSampleRate(settings.sampleRate);
+    synth.setSampleQuality(sfz::Synth::ProcessMode::ProcessFreewheeling, settings.quality);
+    synth.setNumVoices(settings.polyphony);
+    if (!settings.cacheDirectory.empty())
+        synth.setSampleCacheDirectory(settings.cacheDirectory);
+    synth.enableFreeWheeling();
+}
+
+void writeLogLine(std::ofstream& callbackLogFile, const sfz::Synth& synth, unsigned blockSize)
+{
+    auto breakdown = synth.getCallbackBreakdown();
+    auto numVoices = synth.getNumActiveVoices();
+    callbackLogFile << breakdown.dispatch << ','
+                    << breakdown.renderMethod << ','
+                    << breakdown.data << ','
+                    << breakdown.amplitude << ','
+                    << breakdown.filters << ','
+                    << breakdown.panning << ','
+                    << breakdown.effects << ','
+                    << numVoices << ','
+                    << blockSize << ','
+                    << breakdown.culledVoices << '\n';
+}
+
+/**
+ * @brief Get the file of a stereo output, in the multi-output mode
+ */
+fs::path outputStemPath(const fs::path& outputPath, int output)
+{
+    fs::path path = outputPath;
+    path.replace_filename(outputPath.stem().string() + "_out" + std::to_string(output) + outputPath.extension().string());
+    return path;
+}
+
+unsigned bytesPerSample(SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::Float32:
+        return 4;
+    case SampleFormat::Int24:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+/**
+ * @brief Convert interleaved floats into samples of the output format
+ */
+void convertSamples(const float* input, uint8_t* output, size_t numSamples, SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::Int16:
+        drwav_f32_to_s16(reinterpret_cast<drwav_int16*>(output), input, numSamples);
+        break;
+    case SampleFormat::Int24:
+        for (size_t i = 0; i < numSamples; ++i) {
+            const float clamped = clamp(input[i], -1.0f, 1.0f);
+            const auto value = static_cast<int32_t>(std::lround(clamped * 8388607.0f));
+            output[3 * i] = static_cast<uint8_t>(value);
+            output[3 * i + 1] = static_cast<uint8_t>(value >> 8);
+            output[3 * i + 2] = static_cast<uint8_t>(value >> 16);
+        }
+        break;
+    case SampleFormat::Float32:
+        std::memcpy(output, input, numSamples * sizeof(float));
+        break;
+    }
+}
+
+/**
+ * @brief Render a MIDI file through a loaded synth into a WAV file, or into a
+ * WAV file per stereo output in the multi-output mode
+ *
+ * The rendering runs as a pipeline of stages, joined by bounded queues of
+ * blocks: the scheduling of the MIDI events into the blocks, the synth,
+ * the conversion into interleaved frames of the output format, and the
+ * buffered writing of the files. The synth stays on the calling thread.
+ *
+ * @param synth the synth, with the SFZ file loaded
+ * @param settings the settings of the rendering
+ * @param midiPath the MIDI file
+ * @param outputPath the WAV file to write, which names the files of the
+ *                   outputs in the multi-output mode
+ * @param callbackLogFile the log of the callbacks, or null
+ * @param report the timings of the rendering, or null
+ * @param error the reason of the failure
+ * @return the number of frames written, or -1 on failure
+ */
+int64_t renderMidiFile(sfz::Synth& synth, const RenderSettings& settings, const fs::path& midiPath,
+    const fs::path& outputPath, std::ofstream* callbackLogFile, RenderReport* report, std::string& error)
+{
+    const unsigned blockSize = settings.blockSize;
+    const auto start = std::chrono::steady_clock::now();
+
+    fmidi_smf_u midiFile { fmidi_smf_file_read(u8EncodedString(midiPath).c_str()) };
+    if (!midiFile) {
+        error = "Can't read " + midiPath.string();
+        return -1;
+    }
+
+    const auto* midiInfo = fmidi_smf_get_info(midiFile.get());
+    if (!midiInfo) {
+        error = "Can't get info on the midi file " + midiPath.string();
+        return -1;
+    }
+
+    // Without the multi-output mode, the outputs wrap around a stereo buffer
+    const unsigned numFiles = settings.multiOutput ? static_cast<unsigned>(synth.getNumOutputs()) : 1;
+    const unsigned numChannels = 2 * numFiles;
+    const unsigned sampleBytes = bytesPerSample(settings.format);
+
+    drwav_data_format outputFormat {};
+    outputFormat.container = drwav_container_riff;
+    outputFormat.format = settings.format == SampleFormat::Float32 ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    outputFormat.channels = 2;
+    outputFormat.sampleRate = settings.sampleRate;
+    outputFormat.bitsPerSample = 8 * sampleBytes;
+
+    std::vector<drwav> outputFiles(numFiles);
+    for (unsigned i = 0; i < numFiles; ++i) {
+        const fs::path path = settings.multiOutput ? outputStemPath(outputPath, i) : outputPath;
+#if !defined(_WIN32)
+        drwav_bool32 outputFileOk = drwav_init_file_write(&outputFiles[i], path.c_str(), &outputFormat, nullptr);
+#else
+        drwav_bool32 outputFileOk = drwav_init_file_write_w(&outputFiles[i], path.c_str(), &outputFormat, nullptr);
+#endif
+        if (!outputFileOk) {
+            for (unsigned j = 0; j < i; ++j)
+                drwav_uninit(&outputFiles[j]);
+            error = "Error opening the wav file " + path.string() + " for writing";
+            return -1;
+        }
+    }
+
+    // The events of a block, the last one ending the MIDI file
+    struct EventBlock {
+        std::vector<MidiEvent> events;
+        bool last { false };
+    };
+    using FileBlocks = std::vector<std::vector<uint8_t>>; // interleaved, per file
+    StageQueue<EventBlock> eventQueue { stageQueueSize };
+    StageQueue<std::vector<float>> audioQueue { stageQueueSize }; // planar blocks
+    StageQueue<FileBlocks> pcmQueue { stageQueueSize };
+
+    std::thread scheduler([&]() {
+        const double increment { 1.0 / static_cast<double>(settings.sampleRate) };
+        fmidi_player_u midiPlayer { fmidi_player_new(midiFile.get()) };
+        EventBlock block;
+        CallbackData callbackData { block.events, 0, false };
+        fmidi_player_event_callback(midiPlayer.get(), &midiCallback, &callbackData);
+        fmidi_player_finish_callback(midiPlayer.get(), &finishedCallback, &callbackData);
+
+        fmidi_player_start(midiPlayer.get());
+        while (!callbackData.finished) {
+            for (callbackData.delay = 0; callbackData.delay < blockSize && !callbackData.finished; callbackData.delay++)
+                fmidi_player_tick(midiPlayer.get(), increment);
+            block.last = callbackData.finished;
+            eventQueue.push(std::move(block));
+            block.events.clear();
+        }
+        eventQueue.close();
+    });
+
+    std::thread converter([&]() {
+        std::vector<float> planar;
+        std::vector<float> interleaved(2 * blockSize);
+        while (audioQueue.pop(planar)) {
+            FileBlocks blocks(numFiles);
+            for (unsigned i = 0; i < numFiles; ++i) {
+                const float* left = planar.data() + 2 * i * blockSize;
+                sfz::writeInterleaved(absl::MakeConstSpan(left, blockSize),
+                    absl::MakeConstSpan(left + blockSize, blockSize), absl::MakeSpan(interleaved));
+                blocks[i].resize(2 * blockSize * sampleBytes);
+                convertSamples(interleaved.data(), blocks[i].data(), 2 * blockSize, settings.format);
+            }
+            pcmQueue.push(std::move(blocks));
+        }
+        pcmQueue.close();
+    });
+
+    uint64_t numFramesWritten { 0 };
+    std::thread writer([&]() {
+        const size_t frameBytes = 2 * sampleBytes;
+        FileBlocks blocks;
+        FileBlocks chunks(numFiles);
+        for (auto& chunk : chunks)
+            chunk.reserve(writeChunkFrames * frameBytes);
+        auto flush = [&]() {
+            for (unsigned i = 0; i < numFiles; ++i) {
+                const uint64_t numFrames = drwav_write_pcm_frames(&outputFiles[i], chunks[i].size() / frameBytes, chunks[i].data());
+                if (i == 0)
+                    numFramesWritten += numFrames;
+                chunks[i].clear();
+            }
+        };
+        while (pcmQueue.pop(blocks)) {
+            for (unsigned i = 0; i < numFiles; ++i)
+                chunks[i].insert(chunks[i].end(), blocks[i].begin(), blocks[i].end());
+            if (chunks[0].size() >= writeChunkFrames * frameBytes)
+                flush();
+        }
+        flush();
+    });
+
+    sfz::AudioBuffer<float> audioBuffer { numChannels, blockSize };
+    RenderReport renderReport;
+    auto renderBlock = [&]() {
+        synth.renderBlock(audioBuffer);
+        std::vector<float> planar(numChannels * blockSize);
+        for (unsigned c = 0; c < numChannels; ++c)
+            std::copy_n(audioBuffer.getConstSpan(c).data(), blockSize, planar.data() + c * blockSize);
+        audioQueue.push(std::move(planar));
+
+        if (callbackLogFile)
+            writeLogLine(*callbackLogFile, synth, blockSize);
+        if (report) {
+            RenderReport blockReport;
+            blockReport.numBlocks = 1;
+            blockReport.breakdown = synth.getCallbackBreakdown();
+            renderReport.add(blockReport);
+        }
+    };
+
+    EventBlock block;
+    while (eventQueue.pop(block)) {
+        for (const MidiEvent& event : block.events)
+            sendMidiEvent(synth, event);
+        renderBlock();
+    }
+
+    if (!settings.useEOT) {
+        auto averagePower = [&]() {
+            float sum = 0.0f;
+            for (unsigned c = 0; c < numChannels; ++c)
+                sum += sfz::meanSquared<float>(audioBuffer.getConstSpan(c));
+            return sum / numChannels;
+        };
+        while (averagePower() > 1e-12f)
+            renderBlock();
+    }
+
+    audioQueue.close();
+    scheduler.join();
+    converter.join();
+    writer.join();
+    for (drwav& outputFile : outputFiles)
+        drwav_uninit(&outputFile);
+
+    if (report) {
+        renderReport.numFrames = numFramesWritten;
+        renderReport.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        *report = renderReport;
+    }
+    return static_cast<int64_t>(numFramesWritten);
+}
+
+void printReport(const RenderReport& report, int sampleRate, unsigned numJobs)
+{
+    const double audioDuration = static_cast<double>(report.numFrames) / sampleRate;
+    const auto& breakdown = report.breakdown;
+    std::cout << "Rendered " << audioDuration << " s of audio in " << report.duration << " s";
+    if (numJobs > 1)
+        std::cout << " on " << numJobs << " threads";
+    std::cout << '\n';
+    std::cout << "Realtime factor: " << (report.duration > 0 ? audioDuration / report.duration : 0) << '\n';
+    std::cout << "Blocks: " << report.numBlocks << '\n';
+    std::cout << "Callback breakdown totals (s):" << '\n'
+              << "  Dispatch:      " << breakdown.dispatch << '\n'
+              << "  Render method: " << breakdown.renderMethod << '\n'
+              << "  Data:          " << breakdown.data << '\n'
+              << "  Amplitude:     " << breakdown.amplitude << '\n'
+              << "  Filters:       " << breakdown.filters << '\n'
+              << "  Panning:       " << breakdown.panning << '\n'
+              << "  Effects:       " << breakdown.effects << '\n'
+              << "  Culled voices: " << breakdown.culledVoices << '\n';
+}
+
+bool isMidiFile(const fs::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".mid" || extension == ".midi" || extension == ".smf";
+}
+
+/**
+ * @brief Render MIDI files in parallel, each through its own synth
+ *
+ * The SFZ file is loaded once ahead of the workers, which keeps the preloaded
+ * samples in the cache that the file pools of the process share. The synths
+ * of the workers then find their preloaded data in this cache instead of
+ * reading it again, and only parse the SFZ file.
+ *
+ * @return the number of files which failed to render
+ */
+int renderBatch(const RenderSettings& settings, const fs::path& sfzPath, const std::vector<fs::path>& midiPaths,
+    const fs::path& outputDirectory, unsigned numJobs, bool verbose, bool benchmark)
+{
+    sfz::Synth primer;
+    setupSynth(primer, settings);
+    ERROR_IF(!primer.loadSfzFile(sfzPath), "There was an error loading the SFZ file.");
+    LOG_INFO(primer.getNumRegions() << " regions in the SFZ.");
+    if (settings.multiOutput)
+        LOG_INFO("Writing a file for each of the " << primer.getNumOutputs() << " outputs.");
+
+    std::atomic<size_t> nextFile { 0 };
+    std::atomic<int> numFailures { 0 };
+    std::mutex outputMutex;
+    sfz::FilePool::SharedPreloadStats sharedStats;
+    RenderReport totalReport;
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        sfz::Synth synth;
+        setupSynth(synth, settings);
+        const bool loaded = synth.loadSfzFile(sfzPath);
+        {
+            // the sharing is the largest while all the synths are loaded
+            std::lock_guard<std::mutex> lock { outputMutex };
+            const auto stats = sfz::FilePool::getSharedPreloadStats();
+            if (stats.bytesSaved > sharedStats.bytesSaved)
+                sharedStats = stats;
+        }
+        for (size_t index; (index = nextFile.fetch_add(1)) < midiPaths.size();) {
+            const fs::path& midiPath = midiPaths[index];
+            const fs::path outputPath = outputDirectory / midiPath.filename().replace_extension(".wav");
+            std::string error = "There was an error loading the SFZ file.";
+            RenderReport report;
+            const int64_t numFrames = loaded ? renderMidiFile(synth, settings, midiPath, outputPath, nullptr, &report, error) : -1;
+            if (loaded) {
+                // Start the next file from silence, with the default controllers
+                synth.allSoundOff();
+                synth.cc(0, 121, 0);
+            }
+
+            std::lock_guard<std::mutex> lock { outputMutex };
+            if (numFrames < 0) {
+                ++numFailures;
+                LOG_ERROR(midiPath.string() << ": " << error);
+            } else {
+                LOG_INFO("Wrote " << numFrames << " frames of sound data in " << outputPath.string());
+                totalReport.add(report);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(numJobs);
+    for (unsigned i = 0; i < numJobs; ++i)
+        workers.emplace_back(worker);
+    for (std::thread& thread : workers)
+        thread.join();
+
+    LOG_INFO("Rendered " << midiPaths.size() - static_cast<size_t>(numFailures.load()) << " of " << midiPaths.size()
+        << " MIDI files on " << numJobs << " threads, sharing " << sharedStats.numSharedFiles
+        << " preloaded files (" << sharedStats.bytesSaved << " bytes saved).");
+    if (benchmark) {
+        // the factor of the whole batch, from its wall-clock time
+        totalReport.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printReport(totalReport, settings.sampleRate, numJobs);
+    }
+    return numFailures.load();
+}
+
+/**
+ * @brief A job of the server mode: a MIDI file to render through an SFZ file
+ */
+struct ServerJob {
+    fs::path sfzPath;
+    fs::path midiPath;
+    fs::path outputPath;
+};
+
+constexpr size_t serverQueueSize { 64 }; // jobs waiting for a worker
+constexpr size_t maxServerInstruments { 8 }; // loaded instruments per worker
+
+/**
+ * @brief Read the job of a line of the form `<sfz>\t<midi>\t<wav>`, with the
+ * paths relative to the current directory.
+ */
+bool parseServerJob(const std::string& line, ServerJob& job)
+{
+    const size_t first = line.find('\t');
+    const size_t second = (first != line.npos) ? line.find('\t', first + 1) : line.npos;
+    if (second == line.npos || line.find('\t', second + 1) != line.npos)
+        return false;
+
+    job.sfzPath = fs::current_path() / line.substr(0, first);
+    job.midiPath = fs::current_path() / line.substr(first + 1, second - first - 1);
+    job.outputPath = fs::current_path() / line.substr(second + 1);
+    return true;
+}
+
+/**
+ * @brief Render the jobs read from the standard input, one per line, until
+ * its end or an empty line
+ *
+ * Each worker keeps the synths of the last instruments it rendered loaded,
+ * and reuses them for the next jobs on the same SFZ file, unless the file
+ * changed; the preloaded samples are shared between the synths of all the
+ * workers by the file pools. The jobs then only pay for their rendering.
+ *
+ * The result of each job is a line on the standard output, in the order
+ * of their completion: `ok\t<wav>\t<frames>` or `error\t<wav>\t<reason>`,
+ * with the line of the job in place of the WAV file if it is malformed.
+ *
+ * @return the number of jobs which failed
+ */
+int serveJobs(const RenderSettings& settings, unsigned numJobs)
+{
+    StageQueue<ServerJob> jobQueue { serverQueueSize };
+    std::atomic<int> numFailures { 0 };
+    std::mutex outputMutex;
+
+    auto respond = [&](const std::string& name, int64_t numFrames, const std::string& error) {
+        std::lock_guard<std::mutex> lock { outputMutex };
+        if (numFrames < 0) {
+            ++numFailures;
+            std::cout << "error\t" << name << '\t' << error << std::endl;
+        } else {
+            std::cout << "ok\t" << name << '\t' << numFrames << std::endl;
+        }
+    };
+
+    auto worker = [&]() {
+        struct Instrument {
+            fs::path sfzPath;
+            std::unique_ptr<sfz::Synth> synth;
+        };
+        std::list<Instrument> instruments; // the most recently used first
+
+        auto findSynth = [&](const fs::path& sfzPath) -> sfz::Synth* {
+            auto it = std::find_if(instruments.begin(), instruments.end(),
+                [&](const Instrument& instrument) { return instrument.sfzPath == sfzPath; });
+            if (it != instruments.end() && !it->synth->shouldReloadFile()) {
+                instruments.splice(instruments.begin(), instruments, it);
+                return instruments.front().synth.get();
+            }
+            if (it != instruments.end())
+                instruments.erase(it);
+
+            std::unique_ptr<sfz::Synth> synth { new sfz::Synth };
+            setupSynth(*synth, settings);
+            if (!synth->loadSfzFile(sfzPath))
+                return nullptr;
+            if (instruments.size() == maxServerInstruments)
+                instruments.pop_back();
+            instruments.push_front({ sfzPath, std::move(synth) });
+            return instruments.front().synth.get();
+        };
+
+        ServerJob job;
+        while (jobQueue.pop(job)) {
+            std::string error = "There was an error loading the SFZ file.";
+            sfz::Synth* synth = findSynth(job.sfzPath);
+            const int64_t numFrames = synth ? renderMidiFile(*synth, settings, job.midiPath, job.outputPath, nullptr, nullptr, error) : -1;
+            if (synth) {
+                // Start the next job from silence, with the default controllers
+                synth->allSoundOff();
+                synth->cc(0, 121, 0);
+            }
+            respond(job.outputPath.string(), numFrames, error);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(numJobs);
+    for (unsigned i = 0; i < numJobs; ++i)
+        workers.emplace_back(worker);
+
+    std::string line;
+    while (std::getline(std::cin, line) && !line.empty()) {
+        if (line.back() == '\r')
+            line.pop_back();
+        ServerJob job;
+        if (!parseServerJob(line, job))
+            respond(line, -1, "The job should be of the form <sfz><tab><midi><tab><wav>");
+        else
+            jobQueue.push(std::move(job));
+    }
+
+    jobQueue.close();
+    for (std::thread& thread : workers)
+        thread.join();
+    return numFailures.load();
 }
 
 int main(int argc, char** argv)
 {
     cxxopts::Options options("sfizz-render", "Render a midi file through an SFZ file using the sfizz library.");
 
-    unsigned blockSize { 1024 };
-    int sampleRate { 48000 };
+    RenderSettings settings;
     bool verbose { false };
     bool help { false };
-    bool useEOT { false };
-    int quality { 2 };
-    int polyphony { 64 };
+    bool benchmark { false };
+    bool serve { false };
+    unsigned numJobs { std::max(1u, std::thread::hardware_concurrency()) };
 
     options.add_options()
         ("sfz", "SFZ file", cxxopts::value<std::string>())
-        ("midi", "Input midi file", cxxopts::value<std::string>())
+        ("midi", "Input midi file, or in batch mode a midi file or a directory of them, which can repeat", cxxopts::value<std::vector<std::string>>())
         ("wav", "Output wav file", cxxopts::value<std::string>())
-        ("b,blocksize", "Block size for the sfizz callbacks", cxxopts::value(blockSize))
-        ("s,samplerate", "Output sample rate", cxxopts::value(sampleRate))
-        ("q,quality", "Resampling quality", cxxopts::value(quality))
-        ("p,polyphony", "Polyphony max", cxxopts::value(polyphony))
+        ("serve", "Render in server mode the jobs of the standard input, a line <sfz><tab><midi><tab><wav> each", cxxopts::value(serve))
+        ("output-dir", "Render in batch mode, writing a wav file per midi file in this directory", cxxopts::value<std::string>())
+        ("j,jobs", "Number of parallel renderings in batch or server mode", cxxopts::value(numJobs))
+        ("cache-dir", "Directory of the cache of decoded samples and parsed SFZ files", cxxopts::value<std::string>())
+        ("b,blocksize", "Block size for the sfizz callbacks", cxxopts::value(settings.blockSize))
+        ("s,samplerate", "Output sample rate", cxxopts::value(settings.sampleRate))
+        ("q,quality", "Resampling quality", cxxopts::value(settings.quality))
+        ("p,polyphony", "Polyphony max", cxxopts::value(settings.polyphony))
         ("v,verbose", "Verbose output", cxxopts::value(verbose))
         ("log", "Produce logs", cxxopts::value<std::string>())
-        ("use-eot", "End the rendering at the last End of Track Midi message", cxxopts::value(useEOT))
+        ("use-eot", "End the rendering at the last End of Track Midi message", cxxopts::value(settings.useEOT))
+        ("multi-output", "Write each stereo output of the instrument into its own file, with the suffix _out<N>", cxxopts::value(settings.multiOutput))
+        ("format", "Sample format of the output files: s16, s24 or f32", cxxopts::value<std::string>()->default_value("s16"))
+        ("benchmark", "Report the realtime factor and the totals of the callback breakdown", cxxopts::value(benchmark))
         ("h,help", "Show help", cxxopts::value(help))
     ;
     auto params = [&]() {
@@ -99,16 +718,92 @@ int main(int argc, char** argv)
         std::exit(0);
     }
 
+    const std::string format = params["format"].as<std::string>();
+    if (format == "s24")
+        settings.format = SampleFormat::Int24;
+    else if (format == "f32")
+        settings.format = SampleFormat::Float32;
+    else
+        ERROR_IF(format != "s16", "Unknown sample format " << format << ", please specify s16, s24 or f32 using --format");
+
+    if (params.count("cache-dir"))
+        settings.cacheDirectory = fs::current_path() / params["cache-dir"].as<std::string>();
+
+    if (serve) {
+        ERROR_IF(params.count("sfz") > 0 || params.count("midi") > 0 || params.count("wav") > 0 || params.count("output-dir") > 0,
+            "The jobs of the server mode name their SFZ, MIDI and WAV files");
+        ERROR_IF(params.count("log") > 0 || benchmark, "Logs and benchmarks are not produced in server mode");
+        ERROR_IF(numJobs == 0, "Please specify at least one job using --jobs");
+
+        const int numFailures = serveJobs(settings, numJobs);
+        return numFailures > 0 ? -1 : 0;
+    }
+
+    const bool batch = params.count("output-dir") > 0;
     ERROR_IF(params.count("sfz") != 1, "Please specify a single SFZ file using --sfz");
-    ERROR_IF(params.count("wav") != 1, "Please specify a single WAV file using --wav");
-    ERROR_IF(params.count("midi") != 1, "Please specify a single MIDI file using --midi");
+    ERROR_IF(params.count("midi") == 0, "Please specify a MIDI file using --midi");
 
     fs::path sfzPath  = fs::current_path() / params["sfz"].as<std::string>();
-    fs::path outputPath  = fs::current_path() / params["wav"].as<std::string>();
-    fs::path midiPath  = fs::current_path() / params["midi"].as<std::string>();
-
     ERROR_IF(!fs::exists(sfzPath) || !fs::is_regular_file(sfzPath),
                     "SFZ file " << sfzPath.string() << " does not exist or is not a regular file");
+
+    const auto& midiArguments = params["midi"].as<std::vector<std::string>>();
+
+    if (batch) {
+        ERROR_IF(params.count("wav") > 0, "Please specify either a WAV file using --wav or an output directory using --output-dir");
+        ERROR_IF(params.count("log") > 0, "Logs are not produced in batch mode");
+        ERROR_IF(numJobs == 0, "Please specify at least one job using --jobs");
+
+        std::vector<fs::path> midiPaths;
+        for (const std::string& argument : midiArguments) {
+            const fs::path path = fs::current_path() / argument;
+            if (fs::is_directory(path)) {
+                std::vector<fs::path> directoryFiles;
+                for (const fs::directory_entry& entry : fs::directory_iterator(path)) {
+                    if (entry.is_regular_file() && isMidiFile(entry.path()))
+                        directoryFiles.push_back(entry.path());
+                }
+                std::sort(directoryFiles.begin(), directoryFiles.end());
+                midiPaths.insert(midiPaths.end(), directoryFiles.begin(), directoryFiles.end());
+            } else {
+                ERROR_IF(!fs::is_regular_file(path),
+                    "MIDI file " << path.string() << " does not exist or is not a regular file");
+                midiPaths.push_back(path);
+            }
+        }
+        ERROR_IF(midiPaths.empty(), "No MIDI file to render");
+
+        std::vector<fs::path> outputNames;
+        for (const fs::path& midiPath : midiPaths)
+            outputNames.push_back(midiPath.filename().replace_extension(".wav"));
+        std::sort(outputNames.begin(), outputNames.end());
+        const auto duplicate = std::adjacent_find(outputNames.begin(), outputNames.end());
+        ERROR_IF(duplicate != outputNames.end(), "Several MIDI files would render into " << duplicate->string());
+
+        const fs::path outputDirectory = fs::current_path() / params["output-dir"].as<std::string>();
+        std::error_code ec;
+        fs::create_directories(outputDirectory, ec);
+        ERROR_IF(!fs::is_directory(outputDirectory), "Can't create the output directory " << outputDirectory.string());
+
+        numJobs = std::min(numJobs, static_cast<unsigned>(midiPaths.size()));
+        LOG_INFO("SFZ file:    " << sfzPath.string());
+        LOG_INFO("MIDI files:  " << midiPaths.size());
+        LOG_INFO("Output directory: " << outputDirectory.string());
+        LOG_INFO("Jobs: " << numJobs);
+        LOG_INFO("Block size: " << settings.blockSize);
+        LOG_INFO("Sample rate: " << settings.sampleRate);
+        LOG_INFO("Polyphony Max: " << settings.polyphony);
+
+        const int numFailures = renderBatch(settings, sfzPath, midiPaths, outputDirectory, numJobs, verbose, benchmark);
+        return numFailures > 0 ? -1 : 0;
+    }
+
+    ERROR_IF(params.count("wav") != 1, "Please specify a single WAV file using --wav");
+    ERROR_IF(midiArguments.size() != 1, "Please specify a single MIDI file using --midi");
+
+    fs::path outputPath  = fs::current_path() / params["wav"].as<std::string>();
+    fs::path midiPath  = fs::current_path() / midiArguments.front();
+
     ERROR_IF(!fs::exists(midiPath) || !fs::is_regular_file(midiPath),
             "MIDI file " << midiPath.string() << " does not exist or is not a regular file");
 
@@ -119,16 +814,12 @@ int main(int argc, char** argv)
     LOG_INFO("SFZ file:    " << sfzPath.string());
     LOG_INFO("MIDI file:   " << midiPath.string());
     LOG_INFO("Output file: " << outputPath.string());
-    LOG_INFO("Block size: " << blockSize);
-    LOG_INFO("Sample rate: " << sampleRate);
-    LOG_INFO("Polyphony Max: " << polyphony);
+    LOG_INFO("Block size: " << settings.blockSize);
+    LOG_INFO("Sample rate: " << settings.sampleRate);
+    LOG_INFO("Polyphony Max: " << settings.polyphony);
 
     sfz::Synth synth;
-    synth.setSamplesPerBlock(blockSize);
-    synth.setSampleRate(sampleRate);
-    synth.setSampleQuality(sfz::Synth::ProcessMode::ProcessFreewheeling, quality);
-    synth.setNumVoices(polyphony);
-    synth.enableFreeWheeling();
+    setupSynth(synth, settings);
 
     bool logging = params.count("log") > 0;
     std::string logFilename {};
@@ -139,97 +830,30 @@ int main(int argc, char** argv)
         callbackLogFile.open(logPath.string());
 
         if (callbackLogFile.is_open()) {
-            callbackLogFile << "Dispatch,RenderMethod,Data,Amplitude,Filters,Panning,Effects,NumVoices,NumSamples" << '\n';
+            callbackLogFile << "Dispatch,RenderMethod,Data,Amplitude,Filters,Panning,Effects,NumVoices,NumSamples,CulledVoices" << '\n';
         } else {
             logging = false;
             LOG_INFO("Error opening log file " << logPath.string() << "; logging will be disabled");
         }
     }
 
-    auto writeLogLine = [&] {
-        if (!logging)
-            return;
-
-        auto breakdown = synth.getCallbackBreakdown();
-        auto numVoices = synth.getNumActiveVoices();
-        callbackLogFile << breakdown.dispatch << ','
-                        << breakdown.renderMethod << ','
-                        << breakdown.data << ','
-                        << breakdown.amplitude << ','
-                        << breakdown.filters << ','
-                        << breakdown.panning << ','
-                        << breakdown.effects << ','
-                        << numVoices << ','
-                        << blockSize << '\n';
-    };
-
     ERROR_IF(!synth.loadSfzFile(sfzPath), "There was an error loading the SFZ file.");
     LOG_INFO(synth.getNumRegions() << " regions in the SFZ.");
+    if (settings.multiOutput)
+        LOG_INFO("Writing a file for each of the " << synth.getNumOutputs() << " outputs.");
 
-    fmidi_smf_u midiFile { fmidi_smf_file_read(u8EncodedString(midiPath).c_str()) };
-    ERROR_IF(!midiFile, "Can't read " << midiPath);
-
-    const auto* midiInfo = fmidi_smf_get_info(midiFile.get());
-    ERROR_IF(!midiInfo, "Can't get info on the midi file");
-
-    LOG_INFO( midiInfo->track_count << " tracks in the SMF.");
-
-    if (useEOT) {
+    if (settings.useEOT) {
         LOG_INFO("-- Cutting the rendering at the last MIDI End of Track message");
     }
 
-    drwav outputFile;
-    drwav_data_format outputFormat {};
-    outputFormat.container = drwav_container_riff;
-    outputFormat.format = DR_WAVE_FORMAT_PCM;
-    outputFormat.channels = 2;
-    outputFormat.sampleRate = sampleRate;
-    outputFormat.bitsPerSample = 16;
-
-#if !defined(_WIN32)
-    drwav_bool32 outputFileOk = drwav_init_file_write(&outputFile, outputPath.c_str(), &outputFormat, nullptr);
-#else
-    drwav_bool32 outputFileOk = drwav_init_file_write_w(&outputFile, outputPath.c_str(), &outputFormat, nullptr);
-#endif
-    ERROR_IF(!outputFileOk, "Error opening the wav file for writing");
-
-    auto sampleRateDouble = static_cast<double>(sampleRate);
-    const double increment { 1.0 / sampleRateDouble };
-    uint64_t numFramesWritten { 0 };
-    sfz::AudioBuffer<float> audioBuffer { 2, blockSize };
-    sfz::Buffer<float> interleavedBuffer { 2 * blockSize };
-    sfz::Buffer<int16_t> interleavedPcm { 2 * blockSize };
-
-    fmidi_player_u midiPlayer { fmidi_player_new(midiFile.get()) };
-    CallbackData callbackData { synth, 0, false };
-    fmidi_player_event_callback(midiPlayer.get(), &midiCallback, &callbackData);
-    fmidi_player_finish_callback(midiPlayer.get(), &finishedCallback, &callbackData);
-
-    fmidi_player_start(midiPlayer.get());
-    while (!callbackData.finished) {
-        for (callbackData.delay = 0; callbackData.delay < blockSize && !callbackData.finished; callbackData.delay++)
-            fmidi_player_tick(midiPlayer.get(), increment);
-        synth.renderBlock(audioBuffer);
-        sfz::writeInterleaved(audioBuffer.getConstSpan(0), audioBuffer.getConstSpan(1), absl::MakeSpan(interleavedBuffer));
-        drwav_f32_to_s16(interleavedPcm.data(), interleavedBuffer.data(), 2 * blockSize);
-        numFramesWritten += drwav_write_pcm_frames(&outputFile, blockSize, interleavedPcm.data());
-        writeLogLine();
-    }
-
-    if (!useEOT) {
-        auto averagePower = sfz::meanSquared<float>(interleavedBuffer);
-        while (averagePower > 1e-12f) {
-            synth.renderBlock(audioBuffer);
-            sfz::writeInterleaved(audioBuffer.getConstSpan(0), audioBuffer.getConstSpan(1), absl::MakeSpan(interleavedBuffer));
-            drwav_f32_to_s16(interleavedPcm.data(), interleavedBuffer.data(), 2 * blockSize);
-            numFramesWritten += drwav_write_pcm_frames(&outputFile, blockSize, interleavedPcm.data());
-            writeLogLine();
-            averagePower = sfz::meanSquared<float>(interleavedBuffer);
-        }
-    }
-
-    drwav_uninit(&outputFile);
+    std::string error;
+    RenderReport report;
+    const int64_t numFramesWritten = renderMidiFile(synth, settings, midiPath, outputPath,
+        logging ? &callbackLogFile : nullptr, benchmark ? &report : nullptr, error);
+    ERROR_IF(numFramesWritten < 0, error);
     LOG_INFO("Wrote " << numFramesWritten << " frames of sound data in" << outputPath.string());
+    if (benchmark)
+        printReport(report, settings.sampleRate, 1);
 
     return 0;
 }
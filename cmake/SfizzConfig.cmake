@@ -170,6 +170,8 @@ Statically link sndfile:       ${SFIZZ_SNDFILE_STATIC}
 Use clang libc++:              ${USE_LIBCPP}
 Release asserts:               ${SFIZZ_RELEASE_ASSERTS}
 Use ASAN:                      ${SFIZZ_ASAN}
+Timing traces:                 ${SFIZZ_TRACING}
+Real-time checks:              ${SFIZZ_RT_CHECKS}
 
 Use system abseil-cpp:         ${SFIZZ_USE_SYSTEM_ABSEIL}
 Use system catch:              ${SFIZZ_USE_SYSTEM_CATCH}
@@ -253,11 +253,6 @@ target_include_directories(sfizz_cpuid
     PUBLIC "src/external/cpuid/src"
     PRIVATE "src/external/cpuid/platform/src")
 
-# The threadpool library
-add_library(sfizz_threadpool INTERFACE)
-add_library(sfizz::threadpool ALIAS sfizz_threadpool)
-target_include_directories(sfizz_threadpool INTERFACE "external/threadpool")
-
 # The atomic_queue library
 add_library(sfizz_atomic_queue INTERFACE)
 add_library(sfizz::atomic_queue ALIAS sfizz_atomic_queue)
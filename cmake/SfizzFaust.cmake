@@ -1,6 +1,8 @@
 include(CMakeParseArguments)
 
 option(SFIZZ_RECOMPILE_FAUST "Recompile faust sources" OFF)
+option(SFIZZ_FAUST_VECTORIZE "Recompile the block-processing faust effects with the vector backend" OFF)
+set(SFIZZ_FAUST_VECTOR_SIZE "32" CACHE STRING "Vector size of the faust vector backend")
 
 if(SFIZZ_RECOMPILE_FAUST)
     find_program(RDMD "rdmd")
@@ -11,7 +13,7 @@ endif()
 
 function(add_faust_command INPUT OUTPUT)
     set(_options ONE_SAMPLE DOUBLE IN_PLACE VECTORIZE MATH_APPROXIMATION)
-    set(_one_args PROCESS_NAME CLASS_NAME SUPERCLASS_NAME)
+    set(_one_args PROCESS_NAME CLASS_NAME SUPERCLASS_NAME VECTOR_SIZE)
     set(_multi_args IMPORT_DIRS)
     cmake_parse_arguments(_FAUST "${_options}" "${_one_args}" "${_multi_args}" ${ARGN})
     if(NOT SFIZZ_RECOMPILE_FAUST)
@@ -47,6 +49,9 @@ function(add_faust_command INPUT OUTPUT)
     endif()
     if(_FAUST_VECTORIZE)
         list(APPEND _cmd "--vec")
+        if(_FAUST_VECTOR_SIZE)
+            list(APPEND _cmd "--vs" "${_FAUST_VECTOR_SIZE}")
+        endif()
     endif()
     if(_FAUST_MATH_APPROXIMATION)
         list(APPEND _cmd "--mapp")
@@ -47,6 +47,7 @@ SFIZZ_CXX_FLAGS = $(SFIZZ_C_FLAGS)
 
 SFIZZ_SOURCES = \
 	src/sfizz/ADSREnvelope.cpp \
+	src/sfizz/AsyncFileIO.cpp \
 	src/sfizz/AudioReader.cpp \
 	src/sfizz/BeatClock.cpp \
 	src/sfizz/Curve.cpp \
@@ -64,17 +65,23 @@ SFIZZ_SOURCES = \
 	src/sfizz/modulations/sources/FlexEnvelope.cpp \
 	src/sfizz/modulations/sources/LFO.cpp \
 	src/sfizz/effects/Compressor.cpp \
+	src/sfizz/effects/Convolution.cpp \
 	src/sfizz/effects/Disto.cpp \
 	src/sfizz/effects/Eq.cpp \
 	src/sfizz/effects/Filter.cpp \
 	src/sfizz/effects/Fverb.cpp \
 	src/sfizz/effects/Gain.cpp \
 	src/sfizz/effects/Gate.cpp \
+	src/sfizz/effects/impl/PartitionedConvolver.cpp \
 	src/sfizz/effects/impl/ResonantArrayAVX.cpp \
+	src/sfizz/effects/impl/ResonantArrayAVX512.cpp \
 	src/sfizz/effects/impl/ResonantArray.cpp \
+	src/sfizz/effects/impl/ResonantArrayNEON.cpp \
 	src/sfizz/effects/impl/ResonantArraySSE.cpp \
 	src/sfizz/effects/impl/ResonantStringAVX.cpp \
+	src/sfizz/effects/impl/ResonantStringAVX512.cpp \
 	src/sfizz/effects/impl/ResonantString.cpp \
+	src/sfizz/effects/impl/ResonantStringNEON.cpp \
 	src/sfizz/effects/impl/ResonantStringSSE.cpp \
 	src/sfizz/effects/Limiter.cpp \
 	src/sfizz/effects/Lofi.cpp \
@@ -83,46 +90,66 @@ SFIZZ_SOURCES = \
 	src/sfizz/effects/Strings.cpp \
 	src/sfizz/effects/Width.cpp \
 	src/sfizz/EQPool.cpp \
+	src/sfizz/EqCascade.cpp \
 	src/sfizz/FileId.cpp \
 	src/sfizz/FileMetadata.cpp \
 	src/sfizz/FilePool.cpp \
+	src/sfizz/FilterBank.cpp \
 	src/sfizz/FilterPool.cpp \
+	src/sfizz/FilterTables.cpp \
 	src/sfizz/FlexEGDescription.cpp \
 	src/sfizz/FlexEnvelope.cpp \
 	src/sfizz/Interpolators.cpp \
+	src/sfizz/LatencyHistogram.cpp \
 	src/sfizz/Layer.cpp \
 	src/sfizz/LFO.cpp \
 	src/sfizz/LFODescription.cpp \
+	src/sfizz/MappedAudioFile.cpp \
 	src/sfizz/Messaging.cpp \
 	src/sfizz/Metronome.cpp \
 	src/sfizz/MidiState.cpp \
 	src/sfizz/OpcodeCleanup.cpp \
 	src/sfizz/Opcode.cpp \
+	src/sfizz/OutputUpsampler.cpp \
 	src/sfizz/Oversampler.cpp \
 	src/sfizz/Panning.cpp \
 	src/sfizz/parser/Parser.cpp \
 	src/sfizz/parser/ParserPrivate.cpp \
 	src/sfizz/PolyphonyGroup.cpp \
 	src/sfizz/PowerFollower.cpp \
+	src/sfizz/QualityGovernor.cpp \
+	src/sfizz/RealtimeGuard.cpp \
 	src/sfizz/Region.cpp \
 	src/sfizz/RegionSet.cpp \
 	src/sfizz/RegionStateful.cpp \
+	src/sfizz/RenderThreadPool.cpp \
 	src/sfizz/Resources.cpp \
 	src/sfizz/RTSemaphore.cpp \
+	src/sfizz/SampleMemory.cpp \
+	src/sfizz/SampleEnvelope.cpp \
+	src/sfizz/UsageProfile.cpp \
 	src/sfizz/ScopedFTZ.cpp \
+	src/sfizz/TaskScheduler.cpp \
 	src/sfizz/sfizz.cpp \
 	src/sfizz/sfizz_wrapper.cpp \
 	src/sfizz/SfzFilter.cpp \
 	src/sfizz/SIMDHelpers.cpp \
 	src/sfizz/simd/HelpersSSE.cpp \
 	src/sfizz/simd/HelpersAVX.cpp \
+	src/sfizz/simd/InterpolatorsAVX2.cpp \
 	src/sfizz/Smoothers.cpp \
+	src/sfizz/StreamBuffer.cpp \
+	src/sfizz/Subscriptions.cpp \
 	src/sfizz/Synth.cpp \
 	src/sfizz/SynthMessaging.cpp \
+	src/sfizz/Tracer.cpp \
+	src/sfizz/SynthState.cpp \
 	src/sfizz/Tuning.cpp \
 	src/sfizz/utility/spin_mutex/SpinMutex.cpp \
 	src/sfizz/Voice.cpp \
+	src/sfizz/VoiceBudget.cpp \
 	src/sfizz/VoiceManager.cpp \
+	src/sfizz/VoicePools.cpp \
 	src/sfizz/VoiceStealing.cpp \
 	src/sfizz/Wavetables.cpp \
 	src/sfizz/WindowedSinc.cpp
@@ -231,10 +258,6 @@ endif
 
 SFIZZ_CXX_FLAGS += -I$(SFIZZ_DIR)/src/external/hiir
 
-# threadpool dependency
-
-SFIZZ_CXX_FLAGS += -I$(SFIZZ_DIR)/external/threadpool
-
 # atomic_queue dependency
 
 SFIZZ_CXX_FLAGS += -I$(SFIZZ_DIR)/external/atomic_queue/include
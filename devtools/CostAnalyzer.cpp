@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+  This program loads a SFZ file, and reports the cost of its regions, groups
+  and keyswitches: the preloaded memory, the voices which a note may start,
+  the processing of each voice, and an estimate of the processor time of a
+  voice.
+
+  The estimate adds the costs of the parts of a voice, which the program
+  measures first by rendering voices of a generator with and without each
+  part. It is meant to compare instruments and articulations on a machine;
+  the voices of samples also read the sample data, which the generator voices
+  of the calibration do not.
+ */
+
+#include "sfizz/Synth.h"
+#include "sfizz/Region.h"
+#include "sfizz/Effects.h"
+#include "sfizz/FilePool.h"
+#include "sfizz/AudioBuffer.h"
+#include <cxxopts.hpp>
+#include <absl/memory/memory.h>
+#include <absl/strings/str_cat.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The costs of the parts of a voice, in seconds of processing per
+ * second of audio.
+ */
+struct VoiceCosts {
+    double voice { 0.0 };
+    double filter { 0.0 };
+    double equalizer { 0.0 };
+    double lfo { 0.0 };
+    double envelope { 0.0 };
+    double oscillator { 0.0 };
+};
+
+struct Settings {
+    float sampleRate { 48000.0f };
+    int samplesPerBlock { 1024 };
+    int numBlocks { 200 };
+};
+
+constexpr int calibrationVoices { 32 };
+
+/**
+ * @brief Measure the processing time of a voice of a region, per second of
+ * audio, with a number of voices of it playing.
+ */
+double measureVoice(const Settings& settings, absl::string_view opcodes)
+{
+    sfz::Synth synth;
+    synth.setSampleRate(settings.sampleRate);
+    synth.setSamplesPerBlock(settings.samplesPerBlock);
+    synth.loadSfzString("calibration.sfz", absl::StrCat("<region> sample=*saw ", opcodes));
+
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(settings.samplesPerBlock) };
+    for (int i = 0; i < calibrationVoices; ++i)
+        synth.noteOn(0, 36 + i, 100);
+    for (int i = 0; i < 4; ++i)
+        synth.renderBlock(buffer);
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < settings.numBlocks; ++i)
+        synth.renderBlock(buffer);
+    const std::chrono::duration<double> duration = Clock::now() - start;
+
+    const double audioSeconds = settings.numBlocks * settings.samplesPerBlock / settings.sampleRate;
+    const int numVoices = std::max(1, synth.getNumActiveVoices());
+    return duration.count() / (audioSeconds * numVoices);
+}
+
+VoiceCosts calibrate(const Settings& settings)
+{
+    VoiceCosts costs;
+    costs.voice = measureVoice(settings, "");
+    auto extra = [&](absl::string_view opcodes, int count) {
+        return std::max(0.0, (measureVoice(settings, opcodes) - costs.voice) / count);
+    };
+    costs.filter = extra("fil_type=lpf_2p cutoff=1000 fil2_type=hpf_2p cutoff2=100", 2);
+    costs.equalizer = extra("eq1_gain=6 eq1_freq=500 eq2_gain=-6 eq2_freq=2000", 2);
+    costs.lfo = extra("lfo1_freq=5 lfo1_pitch=10 lfo2_freq=3 lfo2_volume=1", 2);
+    costs.envelope = extra("eg1_time1=1 eg1_level1=1 eg1_pitch=100 eg2_time1=1 eg2_level1=1 eg2_volume=1", 2);
+    costs.oscillator = extra("oscillator_multi=9 oscillator_detune=10", 8);
+    return costs;
+}
+
+/**
+ * @brief The cost of a region, and of the voices which it plays.
+ */
+struct RegionCost {
+    const sfz::Region* region { nullptr };
+    const sfz::FileData* data { nullptr };
+    size_t preloadBytes { 0 };
+    int voicesPerNote { 0 };
+    int numFilters { 0 };
+    int numEqualizers { 0 };
+    int numLFOs { 0 };
+    int numEnvelopes { 0 };
+    int unisonSize { 1 };
+    bool sendsToEffects { false };
+    double cpuPerVoice { 0.0 };
+};
+
+size_t getPreloadBytes(const sfz::FileData& data)
+{
+    const size_t bytesPerSample = data.compactPreloadedData ? sizeof(int16_t) : sizeof(float);
+    return data.getNumHeldFrames() * static_cast<size_t>(data.information.numChannels) * bytesPerSample;
+}
+
+int getUnisonSize(const sfz::Region& region)
+{
+    if (!region.isOscillator())
+        return 1;
+    // 3-9: unison mode, 1: normal/RM, 2: PM/FM
+    if (region.oscillatorMode > 0)
+        return 2;
+    return region.oscillatorMulti >= 3 ? region.oscillatorMulti : 1;
+}
+
+/**
+ * @brief Can two regions play on the same note? Only their keys, velocities
+ * and last keyswitches are compared, so it is the worst case.
+ */
+bool canPlayTogether(const sfz::Region& a, const sfz::Region& b, uint8_t key)
+{
+    if (!b.triggerOnNote || !b.keyRange.containsWithEnd(key))
+        return false;
+    if (a.velocityRange.getStart() > b.velocityRange.getEnd()
+        || b.velocityRange.getStart() > a.velocityRange.getEnd())
+        return false;
+    if (a.lastKeyswitch && b.lastKeyswitch && *a.lastKeyswitch != *b.lastKeyswitch)
+        return false;
+    return true;
+}
+
+int getVoicesPerNote(const sfz::Region& region, const std::vector<const sfz::Region*>& regions)
+{
+    if (!region.triggerOnNote)
+        return 1;
+
+    int worst = 0;
+    for (int key = region.keyRange.getStart(); key <= region.keyRange.getEnd(); ++key) {
+        int count = 0;
+        for (const sfz::Region* other : regions)
+            count += canPlayTogether(region, *other, static_cast<uint8_t>(key));
+        worst = std::max(worst, count);
+    }
+    return worst;
+}
+
+std::string getKeyswitchName(const sfz::Region& region)
+{
+    if (region.keyswitchLabel)
+        return *region.keyswitchLabel;
+    if (region.lastKeyswitch)
+        return absl::StrCat("sw_last=", *region.lastKeyswitch);
+    if (region.lastKeyswitchRange)
+        return absl::StrCat("sw_last=", region.lastKeyswitchRange->getStart(), "-", region.lastKeyswitchRange->getEnd());
+    return "(none)";
+}
+
+/**
+ * @brief The totals of a group or a keyswitch.
+ */
+struct SetCost {
+    int numRegions { 0 };
+    std::set<const sfz::FileData*> files;
+    size_t preloadBytes { 0 };
+    int voicesPerNote { 0 };
+    double cpuPerVoice { 0.0 };
+
+    void add(const RegionCost& cost)
+    {
+        ++numRegions;
+        if (cost.data && files.insert(cost.data).second)
+            preloadBytes += cost.preloadBytes;
+        voicesPerNote = std::max(voicesPerNote, cost.voicesPerNote);
+        cpuPerVoice = std::max(cpuPerVoice, cost.cpuPerVoice);
+    }
+};
+
+const char* getEffectsClass(double load, bool hasEffects)
+{
+    if (!hasEffects)
+        return "none";
+    if (load < 0.005)
+        return "light";
+    if (load < 0.05)
+        return "moderate";
+    return "heavy";
+}
+
+std::string formatBytes(size_t bytes)
+{
+    char text[64];
+    if (bytes < 1024)
+        std::snprintf(text, sizeof(text), "%zu B", bytes);
+    else if (bytes < 1024 * 1024)
+        std::snprintf(text, sizeof(text), "%.1f kB", bytes / 1024.0);
+    else
+        std::snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+    return text;
+}
+
+std::string formatLoad(double load)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f%%", 100.0 * load);
+    return text;
+}
+
+void printSets(const char* title, const std::map<std::string, SetCost>& sets)
+{
+    std::printf("\n%s\n", title);
+    std::printf("%-24s %8s %12s %12s %12s %14s\n",
+        "name", "regions", "preload", "voices/note", "cpu/voice", "cpu/note");
+    for (const auto& item : sets) {
+        const SetCost& set = item.second;
+        std::printf("%-24s %8d %12s %12d %12s %14s\n",
+            item.first.c_str(), set.numRegions, formatBytes(set.preloadBytes).c_str(),
+            set.voicesPerNote, formatLoad(set.cpuPerVoice).c_str(),
+            formatLoad(set.voicesPerNote * set.cpuPerVoice).c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    cxxopts::Options options("sfizz_cost_analyzer", "Report the processing and memory costs of a SFZ file");
+
+    options.positional_help("<sfz-file>");
+
+    options.add_options()
+        ("i,input", "Input SFZ file", cxxopts::value<std::string>())
+        ("s,samplerate", "Sample rate", cxxopts::value<float>()->default_value("48000"))
+        ("b,blocksize", "Block size", cxxopts::value<int>()->default_value("1024"))
+        ("n,blocks", "Blocks rendered by each measurement", cxxopts::value<int>()->default_value("200"))
+        ("h,help", "Print usage");
+
+    options.parse_positional({"input"});
+
+    std::unique_ptr<cxxopts::ParseResult> resultPtr;
+    try {
+        resultPtr = absl::make_unique<cxxopts::ParseResult>(options.parse(argc, argv));
+    } catch (cxxopts::exceptions::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        return 1;
+    }
+    cxxopts::ParseResult& result = *resultPtr;
+
+    if (result.count("help")) {
+        std::cerr << options.help() << "\n";
+        return 0;
+    }
+
+    if (!result.count("input")) {
+        std::cerr << "Please indicate the SFZ file path.\n";
+        return 1;
+    }
+
+    Settings settings;
+    settings.sampleRate = result["samplerate"].as<float>();
+    settings.samplesPerBlock = result["blocksize"].as<int>();
+    settings.numBlocks = result["blocks"].as<int>();
+    if (settings.sampleRate <= 0.0f || settings.samplesPerBlock <= 0 || settings.numBlocks <= 0) {
+        std::cerr << "The sample rate, block size and blocks should be positive.\n";
+        return 1;
+    }
+
+    sfz::Synth synth;
+    synth.setSampleRate(settings.sampleRate);
+    synth.setSamplesPerBlock(settings.samplesPerBlock);
+    const fs::path sfzFilePath { result["input"].as<std::string>() };
+    if (!synth.loadSfzFile(sfzFilePath)) {
+        std::cerr << "Could not load the SFZ file.\n";
+        return 1;
+    }
+    synth.getResources().getFilePool().waitForBackgroundLoading();
+
+    // The effects process the same with or without voices
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(settings.samplesPerBlock) };
+    for (int i = 0; i < settings.numBlocks; ++i)
+        synth.renderBlock(buffer);
+    const double blockSeconds = settings.samplesPerBlock / settings.sampleRate;
+    const double effectsLoad = synth.getCallbackStats(sfz::Synth::CallbackEffects).mean / blockSeconds;
+
+    std::vector<const sfz::Region*> regions;
+    size_t numBuses = 0;
+    for (int i = 0, n = synth.getNumRegions(); i < n; ++i) {
+        regions.push_back(synth.getRegionView(i));
+        numBuses = std::max(numBuses, regions.back()->gainToEffect.size());
+    }
+
+    // The buses of the main output, which may be missing if no effect is
+    // sent to them
+    std::vector<bool> busHasEffects(numBuses);
+    for (size_t i = 0; i < numBuses; ++i) {
+        const sfz::EffectBus* bus = synth.getEffectBusView(static_cast<int>(i));
+        busHasEffects[i] = bus && bus->numEffects() > 0;
+    }
+
+    const VoiceCosts costs = calibrate(settings);
+
+    std::vector<RegionCost> regionCosts;
+    regionCosts.reserve(regions.size());
+    for (const sfz::Region* region : regions) {
+        RegionCost cost;
+        cost.region = region;
+        if (!region->isOscillator() || region->hasWavetableSample) {
+            cost.data = region->sampleSlot.data;
+            if (cost.data)
+                cost.preloadBytes = getPreloadBytes(*cost.data);
+        }
+        cost.voicesPerNote = getVoicesPerNote(*region, regions);
+        cost.numFilters = static_cast<int>(region->filters.size());
+        cost.numEqualizers = static_cast<int>(region->equalizers.size());
+        cost.numLFOs = static_cast<int>(region->lfos.size());
+        cost.numEnvelopes = 1 + static_cast<int>(region->flexEGs.size())
+            + (region->pitchEG ? 1 : 0) + (region->filterEG ? 1 : 0);
+        cost.unisonSize = getUnisonSize(*region);
+        for (size_t i = 0; i < region->gainToEffect.size(); ++i)
+            cost.sendsToEffects |= region->gainToEffect[i] > 0 && busHasEffects[i];
+        cost.cpuPerVoice = costs.voice
+            + cost.numFilters * costs.filter
+            + cost.numEqualizers * costs.equalizer
+            + cost.numLFOs * costs.lfo
+            + (cost.numEnvelopes - 1) * costs.envelope
+            + (cost.unisonSize - 1) * costs.oscillator;
+        regionCosts.push_back(cost);
+    }
+
+    std::printf("Calibration at %g Hz, in processor time per second of audio:\n", settings.sampleRate);
+    std::printf("  voice %s, filter %s, equalizer %s, LFO %s, envelope %s, oscillator %s\n",
+        formatLoad(costs.voice).c_str(), formatLoad(costs.filter).c_str(),
+        formatLoad(costs.equalizer).c_str(), formatLoad(costs.lfo).c_str(),
+        formatLoad(costs.envelope).c_str(), formatLoad(costs.oscillator).c_str());
+    std::printf("Effects: %s (%s)\n",
+        getEffectsClass(effectsLoad, std::count(busHasEffects.begin(), busHasEffects.end(), true) > 0),
+        formatLoad(effectsLoad).c_str());
+
+    std::printf("\nRegions\n");
+    std::printf("%-6s %-32s %12s %12s %4s %4s %4s %4s %7s %9s %12s\n",
+        "index", "sample", "preload", "voices/note", "fil", "eq", "lfo", "eg", "unison", "effects", "cpu/voice");
+    SetCost total;
+    std::map<std::string, SetCost> groups;
+    std::map<std::string, SetCost> keyswitches;
+    for (size_t i = 0; i < regionCosts.size(); ++i) {
+        const RegionCost& cost = regionCosts[i];
+        std::printf("%-6zu %-32s %12s %12d %4d %4d %4d %4d %7d %9s %12s\n",
+            i, cost.region->sampleId->filename().c_str(), formatBytes(cost.preloadBytes).c_str(),
+            cost.voicesPerNote, cost.numFilters, cost.numEqualizers, cost.numLFOs,
+            cost.numEnvelopes, cost.unisonSize,
+            getEffectsClass(effectsLoad, cost.sendsToEffects), formatLoad(cost.cpuPerVoice).c_str());
+        total.add(cost);
+        groups[absl::StrCat("group=", cost.region->group)].add(cost);
+        keyswitches[getKeyswitchName(*cost.region)].add(cost);
+    }
+
+    printSets("Groups", groups);
+    printSets("Keyswitches", keyswitches);
+
+    std::printf("\nTotal: %d regions, %s preloaded in %zu files\n",
+        total.numRegions, formatBytes(total.preloadBytes).c_str(), total.files.size());
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+#!/usr/bin/python3
+
+"""Run a curated subset of the benchmarks, and compare it with the baselines
+stored per machine class, reporting the statistically significant changes.
+
+The baselines are JSON files kept in `benchmarks/baselines`, one per machine
+class. Store one with the `store` command on a quiet machine, then check the
+builds against it with the `compare` command, which fails on regressions.
+"""
+
+import argparse
+import json
+import math
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+
+# The curated subset: the area, the executable and the benchmark filter
+suite = [
+    ("simd", "bm_add", "AddArray/(Scalar|SIMD)/(256|4096)$"),
+    ("simd", "bm_multiplyAdd", "MultiplyAdd/(Scalar|SIMD)/(256|4096)$"),
+    ("simd", "bm_gain", "GainArray/(Scalar|SIMD)/(256|4096)$"),
+    ("simd", "bm_cumsum", "CumArray/Sum_(Scalar|SIMD)/(256|4096)$"),
+    ("interpolation", "bm_interpolators", "Interpolators/.*/(256|4096)$"),
+    ("filters", "bm_filterModulation", "FilterFixture/.*/(16|256)$"),
+    ("filters", "bm_filterBank", "FilterBankFixture/.*/16$"),
+    ("render", "bm_synth", "RenderBlock/instrument:[0-4]/voices:64/block:256/rate:44100/quality:1$"),
+    ("render", "bm_modMatrix", "Cycle/voices:64/connections:16$"),
+]
+
+time_unit_ns = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def machine_class():
+    """Name the machine class from the system, the architecture and the CPU
+
+    Returns:
+        string -- a name usable as a file name
+    """
+    cpu = platform.processor()
+    try:
+        with open("/proc/cpuinfo") as cpuinfo:
+            for line in cpuinfo:
+                if line.startswith("model name"):
+                    cpu = line.split(":", 1)[1]
+                    break
+    except OSError:
+        pass
+    name = f"{platform.system()}-{platform.machine()}-{cpu}"
+    return re.sub(r"[^A-Za-z0-9]+", "_", name).strip("_").lower()
+
+
+def run_suite(bin_dir, repetitions, areas):
+    """Run the benchmarks of the suite, and collect the time of each repetition
+
+    Arguments:
+        bin_dir {string} -- the directory of the benchmark executables
+        repetitions {int} -- the repetitions of each benchmark
+        areas {list of strings} -- the areas to run, or all if empty
+
+    Returns:
+        dict -- the samples in nanoseconds and the area, by benchmark name
+    """
+    results = {}
+    for area, executable, benchmark_filter in suite:
+        if areas and area not in areas:
+            continue
+        path = os.path.join(bin_dir, executable)
+        if not os.path.exists(path):
+            print(f"Skipping {executable}, which is not built")
+            continue
+        with tempfile.TemporaryDirectory() as directory:
+            output = os.path.join(directory, "output.json")
+            subprocess.run([path,
+                            f"--benchmark_filter={benchmark_filter}",
+                            f"--benchmark_repetitions={repetitions}",
+                            "--benchmark_enable_random_interleaving=true",
+                            f"--benchmark_out={output}",
+                            "--benchmark_out_format=json"],
+                           check=True, stdout=subprocess.DEVNULL)
+            with open(output) as stream:
+                data = json.load(stream)
+        for run in data["benchmarks"]:
+            if run.get("run_type", "iteration") != "iteration":
+                continue
+            name = f"{executable}/{run.get('run_name', run['name'])}"
+            entry = results.setdefault(name, {"area": area, "samples": []})
+            entry["samples"].append(run["real_time"] * time_unit_ns[run.get("time_unit", "ns")])
+    return results
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, by the normal approximation
+    with the correction for the ties
+
+    Arguments:
+        a {list of floats} -- the first samples
+        b {list of floats} -- the second samples
+
+    Returns:
+        float -- the probability that the samples come from the same distribution
+    """
+    n1, n2 = len(a), len(b)
+    values = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(values)
+    ties = 0.0
+    i = 0
+    while i < len(values):
+        j = i
+        while j + 1 < len(values) and values[j + 1][0] == values[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r1 = sum(rank for rank, (_, group) in zip(ranks, values) if group == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u1 - n1 * n2 / 2) - 0.5) / math.sqrt(variance)
+    return math.erfc(max(z, 0.0) / math.sqrt(2))
+
+
+def median(samples):
+    ordered = sorted(samples)
+    middle = len(ordered) // 2
+    return ordered[middle] if len(ordered) % 2 else (ordered[middle - 1] + ordered[middle]) / 2
+
+
+def baseline_path(args):
+    return os.path.join(args.baselines, f"{args.machine}.json")
+
+
+def store(args):
+    results = run_suite(args.bin_dir, args.repetitions, args.areas)
+    os.makedirs(args.baselines, exist_ok=True)
+    with open(baseline_path(args), "w") as stream:
+        json.dump({"machine": args.machine, "repetitions": args.repetitions, "benchmarks": results},
+                  stream, indent=1, sort_keys=True)
+    print(f"Stored {len(results)} benchmarks into {baseline_path(args)}")
+    return 0
+
+
+def compare(args):
+    try:
+        with open(baseline_path(args)) as stream:
+            baseline = json.load(stream)["benchmarks"]
+    except OSError:
+        print(f"No baseline for the machine class {args.machine}, store one with the store command")
+        return 1
+
+    results = run_suite(args.bin_dir, args.repetitions, args.areas)
+    regressions = []
+    improvements = []
+    for name, entry in sorted(results.items()):
+        if name not in baseline:
+            print(f"New benchmark {name}")
+            continue
+        before = baseline[name]["samples"]
+        after = entry["samples"]
+        ratio = median(after) / median(before)
+        if abs(ratio - 1) < args.threshold or mann_whitney_p(before, after) >= args.alpha:
+            continue
+        line = f"[{entry['area']}] {name}: {median(before):.1f} ns -> {median(after):.1f} ns ({100 * (ratio - 1):+.1f}%)"
+        (regressions if ratio > 1 else improvements).append(line)
+
+    for title, lines in (("Improvements", improvements), ("Regressions", regressions)):
+        if lines:
+            print(title)
+            print('- ', end='')
+            print('\n- '.join(lines))
+    if not regressions:
+        print(f"No significant regression over {len(results)} benchmarks")
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["store", "compare"])
+    parser.add_argument("--bin-dir", required=True, help="the directory of the benchmark executables")
+    parser.add_argument("--baselines", required=True, help="the directory of the baselines")
+    parser.add_argument("--machine", default=machine_class(), help="the machine class (default: %(default)s)")
+    parser.add_argument("--area", dest="areas", action="append", default=[],
+                        choices=sorted({area for area, _, _ in suite}), help="run only some areas")
+    parser.add_argument("--repetitions", type=int, default=10, help="repetitions of each benchmark")
+    parser.add_argument("--alpha", type=float, default=0.01, help="significance level of the test")
+    parser.add_argument("--threshold", type=float, default=0.05, help="smallest relative change reported")
+    args = parser.parse_args()
+    return store(args) if args.command == "store" else compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
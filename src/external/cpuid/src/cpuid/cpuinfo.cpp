@@ -178,6 +178,11 @@ bool cpuinfo::has_f16c() const
     return m_impl->m_has_f16c;
 }
 
+bool cpuinfo::has_fma3() const
+{
+    return m_impl->m_has_fma3;
+}
+
 bool cpuinfo::has_aes() const
 {
     return m_impl->m_has_aes;
@@ -118,6 +118,10 @@ public:
     /// standard IEEE single-precision floating-point formats
     bool has_f16c() const;
 
+    /// Return true if the CPU supports the fused multiply-add instructions
+    /// on 3 operands
+    bool has_fma3() const;
+
     /// Return true if the CPU supports Advanced Encryption Standard instruction
     /// set
     bool has_aes() const;
@@ -25,7 +25,7 @@ struct cpuinfo::impl
         m_has_avx512_vbmi2(false), m_has_avx512_vnni(false),
         m_has_avx512_bitalg(false), m_has_avx512_vpopcntdq(false),
         m_has_avx512_4vnniw(false), m_has_avx512_4fmaps(false),
-        m_has_avx512_vp2intersect(false), m_has_f16c(false), m_has_aes(false),
+        m_has_avx512_vp2intersect(false), m_has_f16c(false), m_has_fma3(false), m_has_aes(false),
         m_has_neon(false)
     {
     }
@@ -58,6 +58,7 @@ struct cpuinfo::impl
     bool m_has_avx512_4fmaps;
     bool m_has_avx512_vp2intersect;
     bool m_has_f16c;
+    bool m_has_fma3;
     bool m_has_aes;
     bool m_has_neon;
 };
@@ -29,6 +29,7 @@ void extract_x86_flags(cpuinfo::impl& info, uint32_t ecx, uint32_t edx)
     info.m_has_avx = (ecx & (1 << 28)) != 0;
     info.m_has_aes = (ecx & (1 << 25)) != 0;
     info.m_has_f16c = (ecx & (1 << 29)) != 0;
+    info.m_has_fma3 = (ecx & (1 << 12)) != 0;
 }
 
 void extract_x86_extended_flags(cpuinfo::impl& info, uint32_t ebx, uint32_t ecx,
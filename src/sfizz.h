@@ -32,6 +32,7 @@
 #include "sfizz_message.h"
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #if defined SFIZZ_EXPORT_SYMBOLS
   #if defined _WIN32
@@ -147,6 +148,199 @@ SFIZZ_EXPORTED_API bool sfizz_load_file(sfizz_synth_t* synth, const char* path);
  */
 SFIZZ_EXPORTED_API bool sfizz_load_string(sfizz_synth_t* synth, const char* path, const char* text);
 
+/**
+ * @brief An SFZ file loading on a background thread.
+ * @since 1.3.0
+ */
+typedef struct sfizz_load_t sfizz_load_t;
+
+/**
+ * @brief The progress of an asynchronous load.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    int num_regions;
+    size_t num_files_to_preload;
+    size_t num_preloaded_files;
+    size_t num_bytes_read;
+} sfizz_load_progress_t;
+
+/**
+ * @brief The function which receives the progress of an asynchronous load.
+ * @since 1.3.0
+ *
+ * @param data      The opaque data pointer passed with the callback.
+ * @param progress  The current progress.
+ */
+typedef void (sfizz_load_progress_callback_t)(void* data, const sfizz_load_progress_t* progress);
+
+/**
+ * @brief Loads an SFZ file on a background thread, and replaces the current
+ * instrument with it once complete.
+ *
+ * The new instrument starts with the settings and the controller values of
+ * the synth. The current instrument keeps playing, and the RT functions apply
+ * to it, until the start of the first render call after the load, where the
+ * new instrument takes its place and the sounding voices stop. The load is
+ * only done after this swap, or when canceled. No other function may be
+ * called on the synth until the load is done. The load must be freed with
+ * @ref sfizz_free_load before the synth.
+ * @since 1.3.0
+ *
+ * @param synth     The synth.
+ * @param path      A null-terminated string representing a path to an SFZ file.
+ * @param callback  The function which receives the progress, called from the
+ *                  loading thread, or NULL.
+ * @param data      The opaque data pointer passed to the callback.
+ *
+ * @return The load, which is never NULL.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API sfizz_load_t* sfizz_load_file_async(sfizz_synth_t* synth, const char* path, sfizz_load_progress_callback_t* callback, void* data);
+
+/**
+ * @brief Asks an asynchronous load to stop between two files. The synth
+ * keeps the current instrument, unless already replaced.
+ * @since 1.3.0
+ *
+ * @param load  The load.
+ */
+SFIZZ_EXPORTED_API void sfizz_cancel_load(sfizz_load_t* load);
+
+/**
+ * @brief Returns whether an asynchronous load is over, successfully or not.
+ * @since 1.3.0
+ *
+ * @param load  The load.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_load_done(sfizz_load_t* load);
+
+/**
+ * @brief Waits for the end of an asynchronous load.
+ * @since 1.3.0
+ *
+ * @param load  The load.
+ *
+ * @return @true when the instrument was loaded,
+ *         @false if the load failed or was canceled.
+ */
+SFIZZ_EXPORTED_API bool sfizz_wait_load(sfizz_load_t* load);
+
+/**
+ * @brief Gets the current progress of an asynchronous load.
+ * @since 1.3.0
+ *
+ * @param load      The load.
+ * @param progress  The progress to fill.
+ */
+SFIZZ_EXPORTED_API void sfizz_get_load_progress(sfizz_load_t* load, sfizz_load_progress_t* progress);
+
+/**
+ * @brief Waits for the end of an asynchronous load, and frees it.
+ * @since 1.3.0
+ *
+ * @param load  The load.
+ */
+SFIZZ_EXPORTED_API void sfizz_free_load(sfizz_load_t* load);
+
+/**
+ * @brief Loads an SFZ file as the resident instrument of a program.
+ *
+ * The instrument is fully prepared aside and kept in memory. A program change
+ * to this program switches to it at the start of the next render call, while
+ * the voices of the previous instrument play their release. A program change
+ * to a program without a resident instrument switches back to the default
+ * instrument, which the synth had before. The instruments share the preloaded
+ * sample data.
+ *
+ * The resident instrument starts with the settings of the synth, and then
+ * follows its sample rate, block size and processing rate. The other
+ * functions, the loads included, apply to the active instrument.
+ * @since 1.3.0
+ *
+ * @param synth    The synth.
+ * @param program  The program, from 0 to 127.
+ * @param path     A null-terminated string representing a path to an SFZ file.
+ *
+ * @return @true when the file was loaded, @false otherwise.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API bool sfizz_load_resident_program(sfizz_synth_t* synth, int program, const char* path);
+
+/**
+ * @brief Removes the resident instrument of a program. If it is active, the
+ * default instrument takes its place.
+ * @since 1.3.0
+ *
+ * @param synth    The synth.
+ * @param program  The program.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_remove_resident_program(sfizz_synth_t* synth, int program);
+
+/**
+ * @brief Returns whether a program has a resident instrument.
+ * @since 1.3.0
+ *
+ * @param synth    The synth.
+ * @param program  The program.
+ */
+SFIZZ_EXPORTED_API bool sfizz_has_resident_program(sfizz_synth_t* synth, int program);
+
+/**
+ * @brief Returns the program of the active instrument, or -1 for the default
+ * instrument.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_active_program(sfizz_synth_t* synth);
+
+/**
+ * @brief Saves the state of the session as a compact binary blob: the
+ * instrument file, or its text if it was loaded from a string, the
+ * controllers which differ from their defaults, the current keyswitch, the
+ * tuning, the qualities, the number of voices and the volume.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param size   The size of the state on return.
+ *
+ * @return A newly allocated state, which must be freed after use using sfizz_free_memory().
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void* sfizz_save_state(sfizz_synth_t* synth, size_t* size);
+
+/**
+ * @brief Restores a state of sfizz_save_state(), loading its instrument. With
+ * a cache directory, the load replays the parses of the unchanged files
+ * instead of parsing them again.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param data   The state.
+ * @param size   The size of the state.
+ *
+ * @return @true if the state was restored, @false if the data is not a state
+ *         or if the instrument failed to load.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API bool sfizz_load_state(sfizz_synth_t* synth, const void* data, size_t size);
+
 /**
  * @brief Sets the tuning from a Scala file loaded from the file system.
  * @since 0.4.0
@@ -331,6 +525,57 @@ SFIZZ_EXPORTED_API void sfizz_set_samples_per_block(sfizz_synth_t* synth, int sa
  */
 SFIZZ_EXPORTED_API void sfizz_set_sample_rate(sfizz_synth_t* synth, float sample_rate);
 
+/**
+ * @brief Set the highest sample rate at which the voices and the effects
+ * process.
+ *
+ * When the host runs above it, the engine processes at the host rate
+ * divided by 2, 4 or 8, and upsamples its outputs to the host rate.
+ * This saves most of the processing of the high rate sessions, for
+ * instruments which have no content above the audible range.
+ * The upsampling adds the latency of sfizz_get_latency().
+ * @since 1.3.0
+ *
+ * @param synth        The synth
+ * @param sample_rate  The highest processing rate, or 0 to process at the
+ *                     sample rate of the host.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_max_processing_rate(sfizz_synth_t* synth, float sample_rate);
+
+/**
+ * @brief Get the highest sample rate at which the voices and the effects
+ * process, or 0 if none.
+ * @since 1.3.0
+ *
+ * @param synth  The synth
+ */
+SFIZZ_EXPORTED_API float sfizz_get_max_processing_rate(sfizz_synth_t* synth);
+
+/**
+ * @brief Get the sample rate at which the voices and the effects process.
+ * @since 1.3.0
+ *
+ * @param synth  The synth
+ */
+SFIZZ_EXPORTED_API float sfizz_get_processing_rate(sfizz_synth_t* synth);
+
+/**
+ * @brief Get the latency of the outputs, in frames at the sample rate of the
+ * host.
+ *
+ * This is the delay which the upsampling from the processing rate adds.
+ * It is 0 when the engine processes at the sample rate of the host.
+ * The host should compensate it.
+ * @since 1.3.0
+ *
+ * @param synth  The synth
+ */
+SFIZZ_EXPORTED_API int sfizz_get_latency(sfizz_synth_t* synth);
+
 /**
  * @brief Send a note on event to the synth.
  * @since 0.2.0
@@ -611,6 +856,68 @@ SFIZZ_EXPORTED_API void sfizz_send_poly_aftertouch(sfizz_synth_t* synth, int del
  */
 SFIZZ_EXPORTED_API void sfizz_send_hd_poly_aftertouch(sfizz_synth_t* synth, int delay, int note_number, float aftertouch);
 
+/**
+ * @brief Send a per-note pitch wheel event, as MPE sends on the channel of
+ *        each note.
+ * @since 1.3.0
+ *
+ * The voices of the note add the bend to the one of the pitch wheel, within
+ * the bend range of their region, and the regions can also read it as the
+ * extended CC 138. This command should be delay-ordered with all other
+ * midi-type events (notes, CCs, aftertouch and pitch-wheel), otherwise the
+ * behavior of the synth is undefined.
+ *
+ * @param synth         The synth.
+ * @param delay         The delay at which the event occurs; this should be lower
+ *                      than the size of the block in the next call to sfizz_render_block().
+ * @param note_number   The note number, in domain 0 to 127.
+ * @param pitch         The normalized pitch, in domain -1 to 1.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_send_hd_per_note_pitch_wheel(sfizz_synth_t* synth, int delay, int note_number, float pitch);
+
+/**
+ * @brief Send a per-note timbre event, as MPE sends with CC 74 on the channel
+ *        of each note.
+ * @since 1.3.0
+ *
+ * The regions read the timbre of the note of their voices as the extended
+ * CC 139. This command should be delay-ordered with all other midi-type
+ * events (notes, CCs, aftertouch and pitch-wheel), otherwise the behavior of
+ * the synth is undefined.
+ *
+ * @param synth         The synth.
+ * @param delay         The delay at which the event occurs; this should be lower
+ *                      than the size of the block in the next call to sfizz_render_block().
+ * @param note_number   The note number, in domain 0 to 127.
+ * @param timbre        The normalized timbre, in domain 0 to 1.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_send_hd_per_note_timbre(sfizz_synth_t* synth, int delay, int note_number, float timbre);
+
+/**
+ * @brief Send a batch of midi-type events to the synth.
+ * @since 1.3.0
+ *
+ * This is equivalent to sending the events one by one with the high precision
+ * functions, but it takes the dispatch once for the whole batch, and it skips
+ * the CC values which are replaced at the same delay when nothing reacts to
+ * them. The events should be delay-ordered, and ordered with all other
+ * midi-type events, otherwise the behavior of the synth is undefined.
+ *
+ * @param synth   The synth.
+ * @param events  The events.
+ * @param count   The number of events.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_send_events(sfizz_synth_t* synth, const sfizz_event_t* events, size_t count);
+
 /**
  * @brief Send a tempo event.
  *
@@ -726,6 +1033,64 @@ SFIZZ_EXPORTED_API void sfizz_send_playback_state(sfizz_synth_t* synth, int dela
  */
 SFIZZ_EXPORTED_API void sfizz_render_block(sfizz_synth_t* synth, float** channels, int num_channels, int num_frames);
 
+/**
+ * @brief Render a block of audio, adding it to the content of the channels
+ * instead of replacing it.
+ *
+ * This behaves as sfizz_render_block(), so that a host can mix several synths
+ * into the same buffers without a copy.
+ *
+ * @since 1.3.0
+ *
+ * @param synth         The synth.
+ * @param channels      Pointers to the channels of the output.
+ * @param num_channels  Number of output channels; should be a multiple of 2.
+ * @param num_frames    Number of frames to fill. This should be less than
+ *                      or equal to the expected samples_per_block.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_render_block_adding(sfizz_synth_t* synth, float** channels, int num_channels, int num_frames);
+
+/**
+ * @brief Render a block of audio into an interleaved buffer.
+ *
+ * This behaves as sfizz_render_block(), except that the frames of the
+ * channels are interleaved in a single buffer of num_channels * num_frames
+ * samples. The outputs are written in place while they are mixed, without
+ * going through planar buffers.
+ *
+ * @since 1.3.0
+ *
+ * @param synth         The synth.
+ * @param buffer        The interleaved buffer of the output.
+ * @param num_channels  Number of output channels; should be a multiple of 2.
+ * @param num_frames    Number of frames to fill. This should be less than
+ *                      or equal to the expected samples_per_block.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_render_block_interleaved(sfizz_synth_t* synth, float* buffer, int num_channels, int num_frames);
+
+/**
+ * @brief Render a block of audio, adding it to the content of an interleaved
+ * buffer instead of replacing it.
+ *
+ * @since 1.3.0
+ *
+ * @param synth         The synth.
+ * @param buffer        The interleaved buffer of the output.
+ * @param num_channels  Number of output channels; should be a multiple of 2.
+ * @param num_frames    Number of frames to fill. This should be less than
+ *                      or equal to the expected samples_per_block.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_render_block_interleaved_adding(sfizz_synth_t* synth, float* buffer, int num_channels, int num_frames);
+
 /**
  * @brief Get the size of the preloaded data.
  *
@@ -755,9 +1120,53 @@ SFIZZ_EXPORTED_API unsigned int sfizz_get_preload_size(sfizz_synth_t* synth);
 SFIZZ_EXPORTED_API void sfizz_set_preload_size(sfizz_synth_t* synth, unsigned int preload_size);
 
 /**
- * @brief Get the internal oversampling rate.
+ * @brief Enable the adaptive preloading.
+ *
+ * The preloaded heads of the files then cover a high percentile of the
+ * measured times from the stream requests to their first slices, with a
+ * margin, at the rate of each file and at its highest playback speed, instead
+ * of the preload size. The heads are sized after the latest measures on the
+ * loads and on the calls to sfizz_update_adaptive_preloading(), and the
+ * preload size applies until enough latencies are measured. This is disabled
+ * by default.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param enable  Whether to enable the adaptive preloading.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_adaptive_preloading(sfizz_synth_t* synth, bool enable);
+
+/**
+ * @brief Return whether the adaptive preloading is enabled.
+ * @since 1.3.0
  *
- * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_adaptive_preloading_enabled(sfizz_synth_t* synth);
+
+/**
+ * @brief Resize the preloaded heads in the adaptive preloading, if the
+ *        measured streaming latency changed much since they were sized.
+ *
+ * This reloads the heads like sfizz_set_preload_size().
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @return @true if the heads resized.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API bool sfizz_update_adaptive_preloading(sfizz_synth_t* synth);
+
+/**
+ * @brief Get the internal oversampling rate.
  *
  * @since 0.2.0
  *
@@ -768,7 +1177,10 @@ SFIZZ_EXPORTED_API sfizz_oversampling_factor_t sfizz_get_oversampling_factor(sfi
 /**
  * @brief Set the internal oversampling rate.
  *
- * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
+ * The sample files are oversampled by this factor as they load, which lowers
+ * the aliasing of the transposed samples with the cheaper interpolators. They
+ * are oversampled in the background as they stream, and their data takes the
+ * factor times more memory. A change reloads the data of the files.
  * @since 0.2.0
  *
  * @param      synth         The synth.
@@ -850,6 +1262,40 @@ SFIZZ_EXPORTED_API int sfizz_get_oscillator_quality(sfizz_synth_t* synth, sfizz_
  */
 SFIZZ_EXPORTED_API void sfizz_set_oscillator_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode, int quality);
 
+/**
+ * @brief Get the effect quality.
+ *
+ * The effects which oversample run at most at 2^quality times the sample
+ * rate, below the oversampling which they are set to in the instrument.
+ * The engine uses distinct settings for live mode and freewheeling mode,
+ * which both can be accessed by the means of this function.
+ * @since 1.3.0
+ *
+ * @param      synth  The synth.
+ * @param[in]  mode   The processing mode.
+ *
+ * @return The effect quality for the given mode, in the range 0 to 3.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_effect_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode);
+
+/**
+ * @brief Set the effect quality.
+ *
+ * The effects which oversample run at most at 2^quality times the sample
+ * rate, below the oversampling which they are set to in the instrument.
+ * The engine uses distinct settings for live mode and freewheeling mode,
+ * which both can be accessed by the means of this function.
+ * @since 1.3.0
+ *
+ * @param      synth    The synth.
+ * @param[in]  mode     The processing mode.
+ * @param[in]  quality  The desired effect quality, in the range 0 to 3.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_effect_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode, int quality);
+
 /**
  * @brief Set whether pressing the sustain pedal cancels the release stage
  * @since 1.2.0
@@ -860,49 +1306,716 @@ SFIZZ_EXPORTED_API void sfizz_set_oscillator_quality(sfizz_synth_t* synth, sfizz
 SFIZZ_EXPORTED_API void sfizz_set_sustain_cancels_release(sfizz_synth_t* synth, bool value);
 
 /**
- * @brief Set the global instrument volume.
- * @since 0.2.0
+ * @brief Set the level under which released voices are ended early
+ * @since 1.3.0
  *
- * @param synth   The synth.
- * @param volume  The new volume.
+ * @param synth     The synth.
+ * @param threshold The threshold in dB, between -144 and 0.
+ *                  The value -144 disables the culling.
  *
  * @par Thread-safety constraints
  * - @b RT: the function must be invoked from the Real-time thread
  */
-SFIZZ_EXPORTED_API void sfizz_set_volume(sfizz_synth_t* synth, float volume);
+SFIZZ_EXPORTED_API void sfizz_set_voice_culling_threshold(sfizz_synth_t* synth, float threshold);
 
 /**
- * @brief Return the global instrument volume.
- * @since 0.2.0
+ * @brief Get the level under which released voices are ended early
+ * @since 1.3.0
  *
- * @param synth  The synth.
+ * @param synth     The synth.
+ *
+ * @return The threshold in dB.
  */
-SFIZZ_EXPORTED_API float sfizz_get_volume(sfizz_synth_t* synth);
+SFIZZ_EXPORTED_API float sfizz_get_voice_culling_threshold(sfizz_synth_t* synth);
 
 /**
- * @brief Set the number of voices used by the synth.
- *
- * @since 0.2.0
+ * @brief Enable or disable the quality governor. While the callbacks come
+ *        close to their deadline, new voices are rendered with a lower
+ *        sample and oscillator quality, which is raised back once the load
+ *        drops. The governor is inactive when freewheeling.
+ * @since 1.3.0
  *
- * @param synth       The synth.
- * @param num_voices  The number of voices.
+ * @param synth     The synth.
+ * @param enable    Whether to enable the governor.
  *
  * @par Thread-safety constraints
- * - @b CT: the function must be invoked from the Control thread
- * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ * - @b RT: the function must be invoked from the Real-time thread
  */
-SFIZZ_EXPORTED_API void sfizz_set_num_voices(sfizz_synth_t* synth, int num_voices);
+SFIZZ_EXPORTED_API void sfizz_enable_quality_governor(sfizz_synth_t* synth, bool enable);
 
 /**
- * @brief Return the number of voices.
- * @since 0.2.0
+ * @brief Return whether the quality governor is enabled.
+ * @since 1.3.0
  *
- * @param synth  The synth.
+ * @param synth     The synth.
  */
-SFIZZ_EXPORTED_API int sfizz_get_num_voices(sfizz_synth_t* synth);
+SFIZZ_EXPORTED_API bool sfizz_is_quality_governor_enabled(sfizz_synth_t* synth);
 
 /**
- * @brief Return the number of allocated buffers from the synth.
+ * @brief Enable or disable the adaptive sample quality. The voices then choose
+ *        the interpolation of each block from their playback ratios, from
+ *        hermite near unity to the longer sincs as they transpose upward, and
+ *        never above the sample quality set.
+ * @since 1.3.0
+ *
+ * @param synth     The synth.
+ * @param enable    Whether to adapt the sample quality.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_adaptive_sample_quality(sfizz_synth_t* synth, bool enable);
+
+/**
+ * @brief Return whether the adaptive sample quality is enabled.
+ * @since 1.3.0
+ *
+ * @param synth     The synth.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_adaptive_sample_quality_enabled(sfizz_synth_t* synth);
+
+/**
+ * @brief Return the number of quality steps the governor currently removes
+ *        from new voices.
+ * @since 1.3.0
+ *
+ * @param synth     The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_quality_reduction(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the directory of the decoded sample cache.
+ *
+ * Compressed sample files keep their decoded preloaded data in this
+ * directory, from which the following loads read it back instead of
+ * decoding the files again. The parses of the SFZ files are kept there
+ * too, and replayed by the loads of the files which did not change.
+ * A NULL or empty path disables the cache.
+ * @since 1.3.0
+ *
+ * @param synth      The synth.
+ * @param directory  The cache directory.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_sample_cache_directory(sfizz_synth_t* synth, const char* directory);
+
+/**
+ * @brief Read the information of all the audio files in a directory and
+ *        its subdirectories, so that loading them later skips scanning
+ *        their metadata.
+ *
+ * The information is kept for the process, and in the sample cache
+ * directory if one is set, for the following runs.
+ * @since 1.3.0
+ *
+ * @param synth      The synth.
+ * @param directory  The directory; a relative one is taken from the
+ *                   directory of the current instrument.
+ *
+ * @return The number of audio files read.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API int sfizz_probe_sample_directory(sfizz_synth_t* synth, const char* directory);
+
+/**
+ * @brief Set how many sample files are read concurrently while loading
+ *        an instrument.
+ * @since 1.3.0
+ *
+ * @param synth        The synth.
+ * @param parallelism  The number of files, where 1 reads them one after
+ *                     the other.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_loading_parallelism(sfizz_synth_t* synth, unsigned int parallelism);
+
+/**
+ * @brief Return how many sample files are read concurrently while loading
+ *        an instrument.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API unsigned int sfizz_get_loading_parallelism(sfizz_synth_t* synth);
+
+/**
+ * @brief The scheduling policy of the background threads.
+ * @since 1.3.0
+ */
+typedef enum {
+    /// Round-robin, or above normal priority on Windows
+    SFIZZ_THREAD_POLICY_DEFAULT,
+    /// The normal time-sharing scheduling
+    SFIZZ_THREAD_POLICY_NORMAL,
+    /// FIFO, or the "Pro Audio" MMCSS task on Windows
+    SFIZZ_THREAD_POLICY_REALTIME,
+} sfizz_thread_policy_t;
+
+/**
+ * @brief The settings of the background threads, which stream the samples
+ *        and collect the garbage for all the synths of the process.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    /// The number of threads, or 0 to leave two cores to the other threads
+    unsigned int num_threads;
+    /// The scheduling policy
+    sfizz_thread_policy_t policy;
+    /// The priority in the range of the policy, from 0 to 100
+    int priority;
+    /// The CPUs the threads may run on, a bit per CPU, or 0 for all of them
+    uint64_t affinity_mask;
+} sfizz_thread_settings_t;
+
+/**
+ * @brief Set the background threads of the process.
+ *
+ * The running threads take the new policy, priority and affinity as soon as
+ * they are idle. The threads start with the first synth of the process and
+ * stop with the last, and the number of threads applies when they start.
+ * The affinity is only supported on Linux and Windows.
+ * @since 1.3.0
+ *
+ * @param settings  The settings.
+ */
+SFIZZ_EXPORTED_API void sfizz_set_background_thread_settings(const sfizz_thread_settings_t* settings);
+
+/**
+ * @brief Get the settings of the background threads of the process.
+ * @since 1.3.0
+ *
+ * @param settings  The settings to fill.
+ */
+SFIZZ_EXPORTED_API void sfizz_get_background_thread_settings(sfizz_thread_settings_t* settings);
+
+/**
+ * @brief The pages of the memory of the sample data.
+ * @since 1.3.0
+ */
+typedef enum {
+    /// The pages of the system
+    SFIZZ_MEMORY_PAGES_NORMAL,
+    /// Mappings which the system may back with huge pages (Linux)
+    SFIZZ_MEMORY_PAGES_TRANSPARENT_HUGE,
+    /// Huge pages reserved by the system (Linux), or large pages (Windows),
+    /// or else the transparent huge pages
+    SFIZZ_MEMORY_PAGES_EXPLICIT_HUGE,
+} sfizz_memory_pages_t;
+
+/**
+ * @brief Set the pages of the sample data of the process.
+ *
+ * With huge pages, the small buffers share slabs of 2 MB, and the large ones
+ * are mapped on their own, which spares the TLB when the voices read across
+ * many samples. This applies to the sample data allocated from then on, by
+ * all the synths of the process. The pages which the system cannot provide
+ * fall back to the heap.
+ * @since 1.3.0
+ *
+ * @param pages  The pages.
+ */
+SFIZZ_EXPORTED_API void sfizz_set_sample_memory_pages(sfizz_memory_pages_t pages);
+
+/**
+ * @brief Get the pages of the sample data of the process.
+ * @since 1.3.0
+ */
+SFIZZ_EXPORTED_API sfizz_memory_pages_t sfizz_get_sample_memory_pages();
+
+/**
+ * @brief Set the window of the bounded streaming mode, in frames.
+ *
+ * Every voice then streams its sample on its own and holds about this many
+ * frames ahead of its play head in memory, as well as the loop segment,
+ * instead of the whole file. The memory then depends on the polyphony rather
+ * than on the length of the samples. A window of 0 disables the bounded
+ * mode, which is the default.
+ * @since 1.3.0
+ *
+ * @param synth       The synth.
+ * @param num_frames  The window.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_streaming_window(sfizz_synth_t* synth, uint32_t num_frames);
+
+/**
+ * @brief Return the window of the bounded streaming mode, in frames, or 0 if
+ *        disabled.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API uint32_t sfizz_get_streaming_window(sfizz_synth_t* synth);
+
+/**
+ * @brief Set a budget for the memory of the sample data, in bytes.
+ *
+ * Over the budget, the streamed data of the idle samples is freed, least
+ * recently played first, and then their preloaded data is shrunk to a
+ * minimum, except when all samples are loaded in ram. The budget applies
+ * right away, after loading, and regularly while rendering. A budget of 0
+ * disables this, which is the default.
+ * @since 1.3.0
+ *
+ * @param synth      The synth.
+ * @param num_bytes  The budget.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_memory_budget(sfizz_synth_t* synth, size_t num_bytes);
+
+/**
+ * @brief Return the memory budget, in bytes, or 0 if disabled.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API size_t sfizz_get_memory_budget(sfizz_synth_t* synth);
+
+/**
+ * @brief Enable or disable the immediate release of the streamed data.
+ *
+ * When enabled, the streamed data of a sample is freed in the background as
+ * soon as its last voice ends, instead of after some seconds of idleness, and
+ * the streams of the samples which nobody plays anymore stop. This keeps the
+ * memory of the large one-shot samples low, at the expense of streaming again
+ * the samples which replay soon. This is disabled by default.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param enable  Enable or disable the immediate release.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_immediate_release(sfizz_synth_t* synth, bool enable);
+
+/**
+ * @brief Return whether the streamed data is freed as soon as its last voice
+ * ends.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_immediate_release_enabled(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the NUMA node of the sample data.
+ *
+ * The sample data loaded from then on is placed on this node, which is best
+ * the node where the thread which renders this synth runs, as of
+ * sfizz_get_current_numa_node(); the host keeps this thread on the node. The
+ * preloaded data is shared only between the synths of the same node, which
+ * hold a replica each. A node of -1 leaves the data on the node of the
+ * loading threads, which is the default. Set this before loading an
+ * instrument, since the data loaded before does not move.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param node   The node, or -1.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_numa_node(sfizz_synth_t* synth, int node);
+
+/**
+ * @brief Return the NUMA node of the sample data, or -1 if none.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_numa_node(sfizz_synth_t* synth);
+
+/**
+ * @brief Return the NUMA node of the processor which runs the calling thread,
+ *        or -1 if unknown.
+ * @since 1.3.0
+ */
+SFIZZ_EXPORTED_API int sfizz_get_current_numa_node();
+
+/**
+ * @brief Enable or disable the prewarming of the release samples.
+ *
+ * A note-on then starts streaming the samples of the release regions of the
+ * note, after the samples which play right away, so that they are loaded by
+ * the time of the note-off. This does nothing in the bounded streaming mode.
+ * It is disabled by default.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param enable  Whether to enable the prewarming.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_release_prewarming(sfizz_synth_t* synth, bool enable);
+
+/**
+ * @brief Return whether the prewarming of the release samples is enabled.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_release_prewarming_enabled(sfizz_synth_t* synth);
+
+/**
+ * @brief Enable or disable the lazy preloading of the keyswitched
+ *        articulations.
+ *
+ * The samples of the regions under a `sw_last` keyswitch are then only
+ * preloaded if the keyswitch is the default one or an eager one. The others
+ * load in the background once their keyswitch is selected, and their regions
+ * play once their samples are loaded. The memory then follows the
+ * articulations which the session uses. This applies from the next load, and
+ * is disabled by default.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param enable  Whether to enable the lazy preloading.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_lazy_keyswitch_preloading(sfizz_synth_t* synth, bool enable);
+
+/**
+ * @brief Return whether the lazy preloading of the keyswitched articulations
+ *        is enabled.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_lazy_keyswitch_preloading_enabled(sfizz_synth_t* synth);
+
+/**
+ * @brief Set whether the articulation of a keyswitch is preloaded at load
+ *        time in the lazy keyswitch preloading. This applies from the next
+ *        load.
+ * @since 1.3.0
+ *
+ * @param synth        The synth.
+ * @param note_number  The keyswitch, between 0 and 127.
+ * @param eager        Whether to preload the articulation at load time.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_eager_keyswitch(sfizz_synth_t* synth, int note_number, bool eager);
+
+/**
+ * @brief Return whether the articulation of a keyswitch is preloaded at load
+ *        time in the lazy keyswitch preloading.
+ * @since 1.3.0
+ *
+ * @param synth        The synth.
+ * @param note_number  The keyswitch, between 0 and 127.
+ */
+SFIZZ_EXPORTED_API bool sfizz_is_eager_keyswitch(sfizz_synth_t* synth, int note_number);
+
+/**
+ * @brief Return the memory of the sample data, in bytes.
+ *
+ * This counts the preloaded and streamed data, but not the memory-mapped
+ * files. The data shared with other instances counts in each of them.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API size_t sfizz_get_memory_usage(sfizz_synth_t* synth);
+
+/**
+ * @brief The memory of the synth by category, in bytes.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    size_t preloaded_samples;
+    size_t streamed_samples;
+    size_t wavetables;
+    size_t voices;
+    size_t buffer_pool;
+    size_t effect_buses;
+    size_t regions;
+    size_t total;
+} sfizz_memory_breakdown_t;
+
+/**
+ * @brief Get the memory of the synth by category.
+ *
+ * The memory of the samples is exact, the other categories are estimates
+ * from the sizes of the objects and their main allocations. The voices
+ * include the filters, EQs, LFOs and flex EGs of their pools, and the effect
+ * buses do not include the state of the effects. The categories are also
+ * available through the messages @c /mem/preloaded_samples,
+ * @c /mem/streamed_samples, @c /mem/wavetables, @c /mem/voices,
+ * @c /mem/buffer_pool, @c /mem/effect_buses, @c /mem/regions and
+ * @c /mem/total.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param memory  The memory by category, written by the function.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_get_memory_breakdown(sfizz_synth_t* synth, sfizz_memory_breakdown_t* memory);
+
+/**
+ * @brief The counters of the streaming underruns.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    uint64_t num_underruns;
+    uint64_t num_missing_frames;
+    int last_region;
+} sfizz_underrun_stats_t;
+
+/**
+ * @brief Get the counters of the streaming underruns since the start or the
+ *        last reset.
+ *
+ * An underrun happens when a voice reaches the end of the loaded frames of a
+ * sample before its end, because the storage is too slow, and the voice
+ * stops. The missing frames are the frames of the blocks which were left
+ * silent, and the last region is the index of the region of the last
+ * underrun, or -1 if none. The counters are also available through the
+ * messages @c /underruns/count, @c /underruns/missing_frames and
+ * @c /underruns/last_region.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param stats  The counters, written by the function.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_get_underrun_stats(sfizz_synth_t* synth, sfizz_underrun_stats_t* stats);
+
+/**
+ * @brief Reset the counters of the streaming underruns.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API void sfizz_reset_underrun_stats(sfizz_synth_t* synth);
+
+/**
+ * @brief The counters and the gauges of the streaming of the samples.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    uint64_t streamed_bytes;
+    uint64_t num_streams;
+    double total_first_slice_latency;
+    double max_first_slice_latency;
+    uint64_t collected_bytes;
+    size_t num_queued_requests;
+    size_t num_queued_streams;
+    size_t num_loading_jobs;
+    double workers_busy_time;
+    double workers_elapsed_time;
+    unsigned num_workers;
+} sfizz_streaming_stats_t;
+
+/**
+ * @brief Get the counters and the gauges of the streaming.
+ *
+ * The counters run since the start: the bytes of the frames streamed, the
+ * streams which read their first slice and the total and the longest of
+ * their latencies, in seconds from the request of the voice to the first
+ * slice, and the bytes of streamed data freed by the garbage collection.
+ * The gauges are the requests waiting for the dispatching, the streams
+ * waiting for a slice and the slices running, as of the last dispatching.
+ * The busy time of the background workers, which the synths of the process
+ * share, is summed over the workers, and their elapsed time runs since their
+ * start.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param stats  The counters and the gauges, written by the function.
+ *
+ * @par Thread-safety constraints
+ * - The function is lock-free, and may be invoked from any thread
+ */
+SFIZZ_EXPORTED_API void sfizz_get_streaming_stats(sfizz_synth_t* synth, sfizz_streaming_stats_t* stats);
+
+/**
+ * @brief The use of the buffer pools.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    int num_buffers;
+    int num_stereo_buffers;
+    int num_index_buffers;
+    int max_buffers_used;
+    int max_stereo_buffers_used;
+    int max_index_buffers_used;
+    int num_buffer_failures;
+    int num_stereo_buffer_failures;
+    int num_index_buffer_failures;
+} sfizz_buffer_pool_stats_t;
+
+/**
+ * @brief Get the use of the buffer pools since the start or the last reset.
+ *
+ * The pools hold the temporary buffers of the processing, and are sized from
+ * the instrument. The high-water marks are the most buffers held at once, and
+ * the failures count the requests for a buffer which could not be served, in
+ * which case the processing which asked for it is skipped. The counters are
+ * also available through the messages under @c /buffer_pool/.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param stats  The counters, written by the function.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_get_buffer_pool_stats(sfizz_synth_t* synth, sfizz_buffer_pool_stats_t* stats);
+
+/**
+ * @brief Reset the high-water marks and the failures of the buffer pools.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API void sfizz_reset_buffer_pool_stats(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the global instrument volume.
+ * @since 0.2.0
+ *
+ * @param synth   The synth.
+ * @param volume  The new volume.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_volume(sfizz_synth_t* synth, float volume);
+
+/**
+ * @brief Return the global instrument volume.
+ * @since 0.2.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API float sfizz_get_volume(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the number of voices used by the synth.
+ * The voices which play are kept: a lower number lets the voices past the
+ * limit finish, and a higher one only constructs the missing voices.
+ *
+ * @since 0.2.0
+ *
+ * @param synth       The synth.
+ * @param num_voices  The number of voices.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_num_voices(sfizz_synth_t* synth, int num_voices);
+
+/**
+ * @brief Return the number of voices.
+ * @since 0.2.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_num_voices(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the limit of the voices playing in all the synths of the process
+ *        which share the voice budget, or 0 for no limit.
+ * @since 1.3.0
+ *
+ * @param num_voices  The number of voices.
+ */
+SFIZZ_EXPORTED_API void sfizz_set_shared_voice_limit(int num_voices);
+
+/**
+ * @brief Return the limit of the voices of the shared voice budget.
+ * @since 1.3.0
+ */
+SFIZZ_EXPORTED_API int sfizz_get_shared_voice_limit();
+
+/**
+ * @brief Share the voice budget of the process, or stop sharing it.
+ *
+ * When the voices playing in the synths which share the budget reach its
+ * limit, a voice start fast releases the voice of lowest priority across them:
+ * the older and the quieter voices of the synths with the smaller weights go
+ * first. The voices of the other synths are released at the start of their
+ * next block.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param shared  Whether the synth shares the budget.
+ * @param weight  The weight of the voices of the synth in the priorities.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_shared_voice_budget(sfizz_synth_t* synth, bool shared, float weight);
+
+/**
+ * @brief Set the number of threads which render the voices.
+ *
+ * This count includes the thread which calls the render functions. With more
+ * than one thread, the voices are rendered concurrently on a pool of real-time
+ * worker threads. The default is 1.
+ *
+ * @since 1.3.0
+ *
+ * @param synth        The synth.
+ * @param num_threads  The number of threads.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_num_render_threads(sfizz_synth_t* synth, int num_threads);
+
+/**
+ * @brief Return the number of threads which render the voices.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_num_render_threads(sfizz_synth_t* synth);
+
+/**
+ * @brief Return the number of allocated buffers from the synth.
  * @since 0.2.0
  *
  * @param synth  The synth.
@@ -1056,6 +2169,133 @@ typedef struct
  */
 SFIZZ_EXPORTED_API void sfizz_get_callback_breakdown(sfizz_synth_t* synth, sfizz_callback_breakdown_t* breakdown);
 
+/**
+ * @brief The timed stages of the callbacks.
+ * The total is the dispatch of the events since the previous block, and the
+ * whole render call.
+ * @since 1.3.0
+ */
+typedef enum {
+    SFIZZ_CALLBACK_TOTAL,
+    SFIZZ_CALLBACK_DISPATCH,
+    SFIZZ_CALLBACK_RENDER,
+    SFIZZ_CALLBACK_DATA,
+    SFIZZ_CALLBACK_AMPLITUDE,
+    SFIZZ_CALLBACK_FILTERS,
+    SFIZZ_CALLBACK_PANNING,
+    SFIZZ_CALLBACK_EFFECTS,
+} sfizz_callback_stage_t;
+
+/**
+ * @brief The statistics of the durations of a callback stage.
+ * @note Times are in seconds. The percentiles are the upper bounds of buckets
+ *       of logarithmic widths, 9% apart.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    uint64_t num_callbacks;
+    double min;
+    double max;
+    double mean;
+    double p50;
+    double p99;
+    double p999;
+} sfizz_callback_stats_t;
+
+/**
+ * @brief Get the statistics of the durations of a callback stage since the
+ *        start or the last reset.
+ *
+ * The statistics are also available through the messages
+ * @c /stats/<stage>/count, @c min, @c max, @c mean, @c p50, @c p99 and
+ * @c p999, where the stage is one of @c total, @c dispatch, @c render,
+ * @c data, @c amplitude, @c filters, @c panning and @c effects.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param stage  The callback stage.
+ * @param stats  The statistics, written by the function.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_get_callback_stats(sfizz_synth_t* synth, sfizz_callback_stage_t stage, sfizz_callback_stats_t* stats);
+
+/**
+ * @brief Reset the statistics of all the callback stages. The message
+ *        @c /stats/reset does the same.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_reset_callback_stats(sfizz_synth_t* synth);
+
+/**
+ * @brief The timed stages of the starts of the voices. The dispatch runs from
+ * the entry of the event to the start of the voice, and the render delay from
+ * the start of the voice to the rendering of the block of its first sample.
+ * @since 1.3.0
+ */
+typedef enum {
+    SFIZZ_VOICE_START_DISPATCH,
+    SFIZZ_VOICE_START_RENDER,
+} sfizz_voice_start_stage_t;
+
+/**
+ * @brief The statistics of the durations of a voice start stage, and of the
+ *        first blocks of the voices of samples.
+ * @note Times are in seconds, as for the callbacks. The first blocks read the
+ *       preloaded data, or else the stream or short of data.
+ * @since 1.3.0
+ */
+typedef struct
+{
+    uint64_t num_starts;
+    double min;
+    double max;
+    double mean;
+    double p50;
+    double p99;
+    double p999;
+    uint64_t num_preloaded;
+    uint64_t num_not_preloaded;
+} sfizz_voice_start_stats_t;
+
+/**
+ * @brief Get the statistics of a voice start stage since the start or the
+ *        last reset.
+ *
+ * The statistics are also available through the messages
+ * @c /stats/<stage>/count, @c min, @c max, @c mean, @c p50, @c p99 and
+ * @c p999, where the stage is @c voice_dispatch or @c voice_render, and
+ * @c /stats/voice_start/preloaded and @c not_preloaded.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param stage  The voice start stage.
+ * @param stats  The statistics, written by the function.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_get_voice_start_stats(sfizz_synth_t* synth, sfizz_voice_start_stage_t stage, sfizz_voice_start_stats_t* stats);
+
+/**
+ * @brief Reset the statistics of the voice starts. The message
+ *        @c /stats/voice_start/reset does the same.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_reset_voice_start_stats(sfizz_synth_t* synth);
+
 /**
  * @brief Shuts down the current processing, clear buffers and reset the voices.
  * @since 0.3.2
@@ -1230,16 +2470,57 @@ SFIZZ_EXPORTED_API void sfizz_set_receive_callback(sfizz_client_t* client, sfizz
  */
 SFIZZ_EXPORTED_API void sfizz_send_message(sfizz_synth_t* synth, sfizz_client_t* client, int delay, const char* path, const char* sig, const sfizz_arg_t* args);
 
+/**
+ * @brief Send a bundle of messages to the synth engine, and get all the
+ *        replies in a buffer.
+ * @since 1.3.0
+ *
+ * The requests and the replies are OSC messages laid one after the other,
+ * as written by @ref sfizz_prepare_message, and read back using
+ * @ref sfizz_extract_message. The bundle is processed in a single call,
+ * without allocating. If the replies do not fit, the buffer holds the first
+ * ones and the call can be made again with a larger buffer.
+ *
+ * @param synth             The synth.
+ * @param delay             The delay of the messages in the block, in samples.
+ * @param requests          The request messages.
+ * @param requests_size     The size of the request messages.
+ * @param replies           The buffer which receives the reply messages.
+ * @param replies_capacity  The capacity of the reply buffer.
+ * @return                  The size necessary to store all the replies,
+ *                          <= replies_capacity if none was dropped.
+ *                          It is 0 if the synth is loading.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API uint32_t sfizz_send_message_bundle(sfizz_synth_t* synth, int delay, const void* requests, uint32_t requests_size, void* replies, uint32_t replies_capacity);
+
 /**
  * @brief Set the function which receives broadcast messages from the synth engine.
  * @since 1.0.0
  *
+ * The function receives as well the values of the paths subscribed with
+ * the `/subscribe` message, from a thread which the synths share, at
+ * most at the rate asked for each path and only when they change. The
+ * paths are `/num_active_voices`, `/cc&/value`, `/voice&/level`,
+ * `/underruns/count` and `/underruns/missing_frames`, with a star in
+ * place of the number to subscribe to all the CCs or voices;
+ * `/unsubscribe` and `/unsubscribe_all` stop them. The thread sleeps
+ * while no path is subscribed.
+ *
+ * Once a path is subscribed, the function is called from this thread
+ * concurrently with the broadcasts of the other threads of the synth,
+ * such as the replies to the messages, so it must be reentrant. The
+ * calls from the subscription thread do not overlap each other, and
+ * stop before the function is unset or changed.
+ *
  * @param synth        The synth.
  * @param broadcast    The pointer to the receiving function.
  * @param data         The opaque data pointer which is passed to the receiver.
  *
  * @par Thread-safety constraints
- * - @b RT: the function must be invoked from the Real-time thread
+ * - @b CT: the function must be invoked from the Control thread
  */
 SFIZZ_EXPORTED_API void sfizz_set_broadcast_callback(sfizz_synth_t* synth, sfizz_receive_t* broadcast, void* data);
 
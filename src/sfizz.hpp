@@ -11,6 +11,7 @@
 
 #pragma once
 #include "sfizz_message.h"
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -35,6 +36,7 @@
 //! @endcond
 
 struct sfizz_synth_t;
+struct sfizz_load_t;
 
 namespace sfz
 {
@@ -141,6 +143,184 @@ public:
      */
     bool loadSfzString(const std::string& path, const std::string& text);
 
+    /**
+     * @brief The progress of an asynchronous load.
+     * @since 1.3.0
+     */
+    struct LoadProgress
+    {
+        int numRegions;
+        size_t numFilesToPreload;
+        size_t numPreloadedFiles;
+        size_t numBytesRead;
+    };
+
+private:
+    struct LoadDeleter {
+        void operator()(sfizz_load_t *load) const noexcept;
+    };
+
+public:
+//! @cond Doxygen_Suppress
+    using LoadPtr = std::unique_ptr<sfizz_load_t, LoadDeleter>;
+//! @endcond
+
+    /**
+     * @brief Load a new SFZ file on a background thread, and replace the
+     *        current instrument with it once complete.
+     *
+     * The new instrument starts with the settings and the controller values
+     * of the synth. The current instrument keeps playing, and the RT
+     * functions apply to it, until the start of the first render call after
+     * the load, where the new instrument takes its place and the sounding
+     * voices stop. The load is only over after this swap, or when canceled.
+     * No other function may be called until the load is done. The load must
+     * be destroyed before the synth; destroying it waits for the end of the
+     * load.
+     *
+     * @since 1.3.0
+     *
+     * @param path      The path to the file to load, as string.
+     * @param callback  The function which receives the progress, called
+     *                  from the loading thread.
+     *
+     * @return The load.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    LoadPtr loadSfzFileAsync(const std::string& path, std::function<void(const LoadProgress&)> callback = {});
+
+    /**
+     * @brief Ask an asynchronous load to stop between two files. The synth
+     *        keeps the current instrument, unless already replaced.
+     *
+     * @since 1.3.0
+     *
+     * @param load  The load.
+     */
+    static void cancelLoad(sfizz_load_t& load) noexcept;
+
+    /**
+     * @brief Return whether an asynchronous load is over, successfully or not.
+     *
+     * @since 1.3.0
+     *
+     * @param load  The load.
+     */
+    static bool isLoadDone(sfizz_load_t& load) noexcept;
+
+    /**
+     * @brief Wait for the end of an asynchronous load.
+     *
+     * @since 1.3.0
+     *
+     * @param load  The load.
+     *
+     * @return @true when the instrument was loaded,
+     *         @false if the load failed or was canceled.
+     */
+    static bool waitLoad(sfizz_load_t& load);
+
+    /**
+     * @brief Return the current progress of an asynchronous load.
+     *
+     * @since 1.3.0
+     *
+     * @param load  The load.
+     */
+    static LoadProgress getLoadProgress(sfizz_load_t& load) noexcept;
+
+    /**
+     * @brief Load an SFZ file as the resident instrument of a program.
+     *
+     * The instrument is fully prepared aside and kept in memory. A program
+     * change to this program switches to it at the start of the next render
+     * call, while the voices of the previous instrument play their release.
+     * A program change to a program without a resident instrument switches
+     * back to the default instrument, which the synth had before. The
+     * instruments share the preloaded sample data.
+     *
+     * The resident instrument starts with the settings of the synth, and
+     * then follows its sample rate, block size and processing rate. The
+     * other functions, the loads included, apply to the active instrument.
+     *
+     * @since 1.3.0
+     *
+     * @param program  The program, from 0 to 127.
+     * @param path     The path to the file to load, as string.
+     *
+     * @return @false if the file was not loaded, @true otherwise.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    bool loadResidentProgram(int program, const std::string& path);
+
+    /**
+     * @brief Remove the resident instrument of a program. If it is active,
+     * the default instrument takes its place.
+     *
+     * @since 1.3.0
+     *
+     * @param program  The program.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void removeResidentProgram(int program);
+
+    /**
+     * @brief Return whether a program has a resident instrument.
+     *
+     * @since 1.3.0
+     *
+     * @param program  The program.
+     */
+    bool hasResidentProgram(int program) const noexcept;
+
+    /**
+     * @brief Return the program of the active instrument, or -1 for the
+     * default instrument.
+     *
+     * @since 1.3.0
+     */
+    int getActiveProgram() const noexcept;
+
+    /**
+     * @brief Save the state of the session as a compact binary blob: the
+     * instrument file, or its text if it was loaded from a string, the
+     * controllers which differ from their defaults, the current keyswitch,
+     * the tuning, the qualities, the number of voices and the volume.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    std::vector<uint8_t> saveState() const;
+
+    /**
+     * @brief Restore a state of saveState(), loading its instrument. With a
+     * cache directory, the load replays the parses of the unchanged files
+     * instead of parsing them again.
+     *
+     * @since 1.3.0
+     *
+     * @param data  The state.
+     * @param size  The size of the state.
+     *
+     * @return @true if the state was restored, @false if the data is not a
+     *         state or if the instrument failed to load.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    bool loadState(const void* data, size_t size);
+
     /**
      * @brief Sets the tuning from a Scala file loaded from the file system.
      *
@@ -263,6 +443,26 @@ public:
      */
     size_t getNumPreloadedSamples() const noexcept;
 
+    /**
+     * @brief Get the RMS and peak envelope of a sample of the instrument,
+     * with one value of each per window of 512 frames of its data, as far
+     * as it is measured. The windows are measured from the preloaded data,
+     * and all of them once the sample is streamed whole.
+     * @since 1.3.0
+     *
+     * @param sample   The sample, as in the sample opcode.
+     * @param reverse  Whether the sample is the reversed one.
+     * @param rms      The RMS values, in the full scale.
+     * @param peak     The peak values, in the full scale.
+     *
+     * @return The number of windows of the whole sample, or 0 if the sample
+     *         is not loaded.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    size_t getSampleEnvelope(const std::string& sample, bool reverse, std::vector<float>& rms, std::vector<float>& peak) const;
+
     /**
      * @brief Set the maximum size of the blocks for the callback.
      *
@@ -284,90 +484,792 @@ public:
      *
      * If you do not call it it is initialized to `sfz::config::defaultSampleRate`.
      *
-     * @since 0.2.0
+     * @since 0.2.0
+     *
+     * @param sampleRate The sample rate.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setSampleRate(float sampleRate) noexcept;
+
+    /**
+     * @brief Set the highest sample rate at which the voices and the effects
+     * process.
+     *
+     * When the host runs above it, the engine processes at the host rate
+     * divided by 2, 4 or 8, and upsamples its outputs to the host rate.
+     * This saves most of the processing of the high rate sessions, for
+     * instruments which have no content above the audible range.
+     * The upsampling adds the latency of getLatency().
+     *
+     * @since 1.3.0
+     *
+     * @param sampleRate The highest processing rate, or 0 to process at the
+     *                   sample rate of the host.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setMaxProcessingRate(float sampleRate) noexcept;
+
+    /**
+     * @brief Get the highest sample rate at which the voices and the effects
+     * process.
+     *
+     * @since 1.3.0
+     *
+     * @return The highest processing rate, or 0 if none.
+     */
+    float getMaxProcessingRate() const noexcept;
+
+    /**
+     * @brief Get the sample rate at which the voices and the effects process.
+     *
+     * @since 1.3.0
+     */
+    float getProcessingRate() const noexcept;
+
+    /**
+     * @brief Get the latency of the outputs, in frames at the sample rate of
+     * the host.
+     *
+     * This is the delay which the upsampling from the processing rate adds.
+     * It is 0 when the engine processes at the sample rate of the host.
+     * The host should compensate it.
+     *
+     * @since 1.3.0
+     */
+    int getLatency() const noexcept;
+
+    /**
+     * @brief Get the default resampling quality.
+     *
+     * This is the quality setting which the engine uses when the instrument
+     * does not use the opcode `sample_quality`. The engine uses distinct
+     * default quality settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     * @since 0.4.0
+     *
+     * @param[in] mode  The processing mode.
+     *
+     * @return The sample quality for the given mode, in the range 0 to 10.
+     */
+    int getSampleQuality(ProcessMode mode);
+
+    /**
+     * @brief Set the default resampling quality.
+     *
+     * This is the quality setting which the engine uses when the instrument
+     * does not use the opcode `sample_quality`. The engine uses distinct
+     * default quality settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     *
+     * @since 0.4.0
+     *
+     * @param[in] mode    The processing mode.
+     * @param[in] quality The desired sample quality, in the range 0 to 10.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void setSampleQuality(ProcessMode mode, int quality);
+
+    /**
+     * @brief Get the default oscillator quality.
+     *
+     * This is the quality setting which the engine uses when the instrument
+     * does not use the opcode `oscillator_quality`. The engine uses distinct
+     * default quality settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     * @since 1.0.0
+     *
+     * @param[in] mode  The processing mode.
+     *
+     * @return The oscillator quality for the given mode, in the range 0 to 3.
+     */
+    int getOscillatorQuality(ProcessMode mode);
+
+    /**
+     * @brief Set the default oscillator quality.
+     *
+     * This is the quality setting which the engine uses when the instrument
+     * does not use the opcode `oscillator_quality`. The engine uses distinct
+     * default quality settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     *
+     * @since 1.0.0
+     *
+     * @param[in] mode    The processing mode.
+     * @param[in] quality The desired oscillator quality, in the range 0 to 3.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void setOscillatorQuality(ProcessMode mode, int quality);
+
+    /**
+     * @brief Get the effect quality.
+     *
+     * The effects which oversample run at most at 2^quality times the sample
+     * rate, below the oversampling which they are set to in the instrument.
+     * The engine uses distinct settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     * @since 1.3.0
+     *
+     * @param[in] mode  The processing mode.
+     *
+     * @return The effect quality for the given mode, in the range 0 to 3.
+     */
+    int getEffectQuality(ProcessMode mode);
+
+    /**
+     * @brief Set the effect quality.
+     *
+     * The effects which oversample run at most at 2^quality times the sample
+     * rate, below the oversampling which they are set to in the instrument.
+     * The engine uses distinct settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     *
+     * @since 1.3.0
+     *
+     * @param[in] mode    The processing mode.
+     * @param[in] quality The desired effect quality, in the range 0 to 3.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void setEffectQuality(ProcessMode mode, int quality);
+
+    /**
+     * @brief Set whether pressing the sustain pedal cancels the release stage
+     *
+     * @since 1.2.0
+     *
+     * @param value
+     */
+    void setSustainCancelsRelease(bool value);
+
+    /**
+     * @brief Set the level under which released voices are ended early
+     *
+     * @since 1.3.0
+     *
+     * @param threshold The threshold in dB, between -144 and 0.
+     *                  The value -144 disables the culling.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void setVoiceCullingThreshold(float threshold);
+
+    /**
+     * @brief Get the level under which released voices are ended early
+     *
+     * @since 1.3.0
+     *
+     * @return The threshold in dB.
+     */
+    float getVoiceCullingThreshold() const noexcept;
+
+    /**
+     * @brief Enable or disable the quality governor. While the callbacks come
+     *        close to their deadline, new voices are rendered with a lower
+     *        sample and oscillator quality, which is raised back once the load
+     *        drops. The governor is inactive when freewheeling.
+     *
+     * @since 1.3.0
+     *
+     * @param enable
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void enableQualityGovernor(bool enable) noexcept;
+
+    /**
+     * @brief Return whether the quality governor is enabled.
+     *
+     * @since 1.3.0
+     */
+    bool isQualityGovernorEnabled() const noexcept;
+
+    /**
+     * @brief Enable or disable the adaptive sample quality. The voices then
+     *        choose the interpolation of each block from their playback
+     *        ratios, from hermite near unity to the longer sincs as they
+     *        transpose upward, and never above the sample quality set.
+     *
+     * @since 1.3.0
+     *
+     * @param enable
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void enableAdaptiveSampleQuality(bool enable) noexcept;
+
+    /**
+     * @brief Return whether the adaptive sample quality is enabled.
+     *
+     * @since 1.3.0
+     */
+    bool isAdaptiveSampleQualityEnabled() const noexcept;
+
+    /**
+     * @brief Return the number of quality steps the governor currently
+     *        removes from new voices.
+     *
+     * @since 1.3.0
+     */
+    int getQualityReduction() const noexcept;
+
+    /**
+     * @brief Set the directory of the decoded sample cache.
+     *
+     * Compressed sample files keep their decoded preloaded data in this
+     * directory, from which the following loads read it back instead of
+     * decoding the files again. The parses of the SFZ files are kept there
+     * too, and replayed by the loads of the files which did not change.
+     * An empty path disables the cache.
+     *
+     * @since 1.3.0
+     *
+     * @param directory  The cache directory.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setSampleCacheDirectory(const std::string& directory);
+
+    /**
+     * @brief Return the directory of the decoded sample cache.
+     *
+     * @since 1.3.0
+     */
+    std::string getSampleCacheDirectory() const;
+
+    /**
+     * @brief Read the usage profile of the instrument from a file.
+     *
+     * The profile guides the preloads of the instrument loaded afterwards:
+     * the samples which played in it are preloaded first and as far as they
+     * played, and the others preload little. Then the profile records which
+     * samples play, how often and how far, for saveUsageProfile.
+     *
+     * @since 1.3.0
+     *
+     * @param path  The file of the profile, usually kept with the session.
+     *
+     * @return @true if the file is a profile, @false otherwise, in which
+     *         case the samples preload the same.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    bool loadUsageProfile(const std::string& path);
+
+    /**
+     * @brief Write the usage profile of the instrument into a file.
+     *
+     * @since 1.3.0
+     *
+     * @param path  The file of the profile.
+     *
+     * @return @true if the file was written, @false otherwise.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    bool saveUsageProfile(const std::string& path) const;
+
+    /**
+     * @brief Read the information of all the audio files in a directory
+     *        and its subdirectories, so that loading them later skips
+     *        scanning their metadata.
+     *
+     * The information is kept for the process, and in the sample cache
+     * directory if one is set, for the following runs.
+     *
+     * @since 1.3.0
+     *
+     * @param directory  The directory; a relative one is taken from the
+     *                   directory of the current instrument.
+     *
+     * @return The number of audio files read.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    int probeSampleDirectory(const std::string& directory);
+
+    /**
+     * @brief Set how many sample files are read concurrently while loading
+     *        an instrument.
+     *
+     * @since 1.3.0
+     *
+     * @param parallelism  The number of files, where 1 reads them one
+     *                     after the other.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setLoadingParallelism(unsigned parallelism) noexcept;
+
+    /**
+     * @brief Return how many sample files are read concurrently while
+     *        loading an instrument.
+     *
+     * @since 1.3.0
+     */
+    unsigned getLoadingParallelism() const noexcept;
+
+    /**
+     * @brief The settings of the background threads, which stream the
+     *        samples and collect the garbage for all the synths of the
+     *        process.
+     * @since 1.3.0
+     */
+    struct ThreadSettings
+    {
+        enum Policy {
+            //! Round-robin, or above normal priority on Windows
+            PolicyDefault,
+            //! The normal time-sharing scheduling
+            PolicyNormal,
+            //! FIFO, or the "Pro Audio" MMCSS task on Windows
+            PolicyRealTime,
+        };
+        //! The number of threads, or 0 to leave two cores to the other threads
+        unsigned numThreads;
+        //! The scheduling policy
+        Policy policy;
+        //! The priority in the range of the policy, from 0 to 100
+        int priority;
+        //! The CPUs the threads may run on, a bit per CPU, or 0 for all
+        uint64_t affinityMask;
+    };
+
+    /**
+     * @brief Set the background threads of the process.
+     *
+     * The running threads take the new policy, priority and affinity as
+     * soon as they are idle. The threads start with the first synth of the
+     * process and stop with the last, and the number of threads applies
+     * when they start. The affinity is only supported on Linux and Windows.
+     *
+     * @since 1.3.0
+     *
+     * @param settings  The settings.
+     */
+    static void setBackgroundThreadSettings(const ThreadSettings& settings);
+
+    /**
+     * @brief Return the settings of the background threads of the process.
+     *
+     * @since 1.3.0
+     */
+    static ThreadSettings getBackgroundThreadSettings();
+
+    /**
+     * @brief The pages of the memory of the sample data.
+     * @since 1.3.0
+     */
+    enum MemoryPages {
+        //! The pages of the system
+        MemoryPagesNormal,
+        //! Mappings which the system may back with huge pages (Linux)
+        MemoryPagesTransparentHuge,
+        //! Huge pages reserved by the system (Linux), or large pages
+        //! (Windows), or else the transparent huge pages
+        MemoryPagesExplicitHuge,
+    };
+
+    /**
+     * @brief Set the pages of the sample data of the process.
+     *
+     * With huge pages, the small buffers share slabs of 2 MB, and the large
+     * ones are mapped on their own, which spares the TLB when the voices read
+     * across many samples. This applies to the sample data allocated from
+     * then on, by all the synths of the process. The pages which the system
+     * cannot provide fall back to the heap.
+     *
+     * @since 1.3.0
+     *
+     * @param pages  The pages.
+     */
+    static void setSampleMemoryPages(MemoryPages pages);
+
+    /**
+     * @brief Get the pages of the sample data of the process.
+     *
+     * @since 1.3.0
+     */
+    static MemoryPages getSampleMemoryPages();
+
+    /**
+     * @brief Set the window of the bounded streaming mode, in frames.
+     *
+     * Every voice then streams its sample on its own and holds about this
+     * many frames ahead of its play head in memory, as well as the loop
+     * segment, instead of the whole file. The memory then depends on the
+     * polyphony rather than on the length of the samples. A window of 0
+     * disables the bounded mode, which is the default.
+     *
+     * @since 1.3.0
+     *
+     * @param numFrames  The window.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setStreamingWindow(uint32_t numFrames) noexcept;
+
+    /**
+     * @brief Return the window of the bounded streaming mode, in frames,
+     *        or 0 if disabled.
+     *
+     * @since 1.3.0
+     */
+    uint32_t getStreamingWindow() const noexcept;
+
+    /**
+     * @brief Set a budget for the memory of the sample data, in bytes.
+     *
+     * Over the budget, the streamed data of the idle samples is freed, least
+     * recently played first, and then their preloaded data is shrunk to a
+     * minimum, except when all samples are loaded in ram. The budget applies
+     * right away, after loading, and regularly while rendering. A budget of
+     * 0 disables this, which is the default.
+     *
+     * @since 1.3.0
+     *
+     * @param numBytes  The budget.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setMemoryBudget(size_t numBytes) noexcept;
+
+    /**
+     * @brief Return the memory budget, in bytes, or 0 if disabled.
+     *
+     * @since 1.3.0
+     */
+    size_t getMemoryBudget() const noexcept;
+
+    /**
+     * @brief Enable or disable the immediate release of the streamed data.
+     *
+     * When enabled, the streamed data of a sample is freed in the background
+     * as soon as its last voice ends, instead of after some seconds of
+     * idleness, and the streams of the samples which nobody plays anymore
+     * stop. This keeps the memory of the large one-shot samples low, at the
+     * expense of streaming again the samples which replay soon. This is
+     * disabled by default.
+     *
+     * @since 1.3.0
+     *
+     * @param enable  Enable or disable the immediate release.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void enableImmediateRelease(bool enable) noexcept;
+
+    /**
+     * @brief Return whether the streamed data is freed as soon as its last
+     * voice ends.
+     *
+     * @since 1.3.0
+     */
+    bool isImmediateReleaseEnabled() const noexcept;
+
+    /**
+     * @brief Set the NUMA node of the sample data.
+     *
+     * The sample data loaded from then on is placed on this node, which is
+     * best the node where the thread which renders this synth runs, as of
+     * getCurrentNumaNode(); the host keeps this thread on the node. The
+     * preloaded data is shared only between the synths of the same node,
+     * which hold a replica each. A node of -1 leaves the data on the node
+     * of the loading threads, which is the default. Set this before loading
+     * an instrument, since the data loaded before does not move.
+     *
+     * @since 1.3.0
+     *
+     * @param node  The node, or -1.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setNumaNode(int node) noexcept;
+
+    /**
+     * @brief Return the NUMA node of the sample data, or -1 if none.
+     *
+     * @since 1.3.0
+     */
+    int getNumaNode() const noexcept;
+
+    /**
+     * @brief Return the NUMA node of the processor which runs the calling
+     * thread, or -1 if unknown.
+     *
+     * @since 1.3.0
+     */
+    static int getCurrentNumaNode() noexcept;
+
+    /**
+     * @brief Enable or disable the prewarming of the release samples.
+     *
+     * A note-on then starts streaming the samples of the release regions of
+     * the note, after the samples which play right away, so that they are
+     * loaded by the time of the note-off. This does nothing in the bounded
+     * streaming mode. It is disabled by default.
+     *
+     * @since 1.3.0
+     *
+     * @param enable
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void enableReleasePrewarming(bool enable) noexcept;
+
+    /**
+     * @brief Return whether the prewarming of the release samples is enabled.
+     *
+     * @since 1.3.0
+     */
+    bool isReleasePrewarmingEnabled() const noexcept;
+
+    /**
+     * @brief Enable or disable the lazy preloading of the keyswitched
+     *        articulations.
+     *
+     * The samples of the regions under a `sw_last` keyswitch are then only
+     * preloaded if the keyswitch is the default one or an eager one. The
+     * others load in the background once their keyswitch is selected, and
+     * their regions play once their samples are loaded. The memory then
+     * follows the articulations which the session uses. This applies from
+     * the next load, and is disabled by default.
+     *
+     * @since 1.3.0
+     *
+     * @param enable
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void enableLazyKeyswitchPreloading(bool enable) noexcept;
+
+    /**
+     * @brief Return whether the lazy preloading of the keyswitched
+     *        articulations is enabled.
+     *
+     * @since 1.3.0
+     */
+    bool isLazyKeyswitchPreloadingEnabled() const noexcept;
+
+    /**
+     * @brief Set whether the articulation of a keyswitch is preloaded at
+     *        load time in the lazy keyswitch preloading. This applies from
+     *        the next load.
+     *
+     * @since 1.3.0
+     *
+     * @param noteNumber  The keyswitch, between 0 and 127.
+     * @param eager       Whether to preload the articulation at load time.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setEagerKeyswitch(int noteNumber, bool eager) noexcept;
+
+    /**
+     * @brief Return whether the articulation of a keyswitch is preloaded at
+     *        load time in the lazy keyswitch preloading.
+     *
+     * @since 1.3.0
+     *
+     * @param noteNumber  The keyswitch, between 0 and 127.
+     */
+    bool isEagerKeyswitch(int noteNumber) const noexcept;
+
+    /**
+     * @brief Return the memory of the sample data, in bytes.
+     *
+     * This counts the preloaded and streamed data, but not the memory-mapped
+     * files. The data shared with other instances counts in each of them.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    size_t getMemoryUsage() const noexcept;
+
+    /**
+     * @brief The memory of the synth by category, in bytes.
+     * @since 1.3.0
+     */
+    struct MemoryBreakdown
+    {
+        size_t preloadedSamples;
+        size_t streamedSamples;
+        size_t wavetables;
+        size_t voices;
+        size_t bufferPool;
+        size_t effectBuses;
+        size_t regions;
+        size_t total;
+    };
+
+    /**
+     * @brief Return the memory of the synth by category.
+     *
+     * The memory of the samples is exact, the other categories are estimates
+     * from the sizes of the objects and their main allocations. The voices
+     * include the filters, EQs, LFOs and flex EGs of their pools, and the
+     * effect buses do not include the state of the effects.
      *
-     * @param sampleRate The sample rate.
+     * @since 1.3.0
      *
      * @par Thread-safety constraints
      * - @b CT: the function must be invoked from the Control thread
      * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
      */
-    void setSampleRate(float sampleRate) noexcept;
+    MemoryBreakdown getMemoryBreakdown() const noexcept;
 
     /**
-     * @brief Get the default resampling quality.
+     * @brief The counters of the streaming underruns.
+     * @since 1.3.0
+     */
+    struct UnderrunStats
+    {
+        uint64_t numUnderruns;
+        uint64_t numMissingFrames;
+        int lastRegion;
+    };
+
+    /**
+     * @brief Return the counters of the streaming underruns since the start
+     *        or the last reset.
      *
-     * This is the quality setting which the engine uses when the instrument
-     * does not use the opcode `sample_quality`. The engine uses distinct
-     * default quality settings for live mode and freewheeling mode,
-     * which both can be accessed by the means of this function.
-     * @since 0.4.0
+     * An underrun happens when a voice reaches the end of the loaded frames
+     * of a sample before its end, because the storage is too slow, and the
+     * voice stops. The missing frames are the frames of the blocks which
+     * were left silent, and the last region is the index of the region of the
+     * last underrun, or -1 if none.
      *
-     * @param[in] mode  The processing mode.
+     * @since 1.3.0
      *
-     * @return The sample quality for the given mode, in the range 0 to 10.
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
      */
-    int getSampleQuality(ProcessMode mode);
+    UnderrunStats getUnderrunStats() const noexcept;
 
     /**
-     * @brief Set the default resampling quality.
+     * @brief Reset the counters of the streaming underruns.
      *
-     * This is the quality setting which the engine uses when the instrument
-     * does not use the opcode `sample_quality`. The engine uses distinct
-     * default quality settings for live mode and freewheeling mode,
-     * which both can be accessed by the means of this function.
+     * @since 1.3.0
+     */
+    void resetUnderrunStats() noexcept;
+
+    /**
+     * @brief The counters and the gauges of the streaming of the samples.
+     * @since 1.3.0
+     */
+    struct StreamingStats
+    {
+        uint64_t streamedBytes;
+        uint64_t numStreams;
+        double totalFirstSliceLatency;
+        double maxFirstSliceLatency;
+        uint64_t collectedBytes;
+        size_t numQueuedRequests;
+        size_t numQueuedStreams;
+        size_t numLoadingJobs;
+        double workersBusyTime;
+        double workersElapsedTime;
+        unsigned numWorkers;
+    };
+
+    /**
+     * @brief Return the counters and the gauges of the streaming.
      *
-     * @since 0.4.0
+     * The counters run since the start: the bytes of the frames streamed,
+     * the streams which read their first slice and the total and the longest
+     * of their latencies, in seconds from the request of the voice to the first
+     * slice, and the bytes of streamed data freed by the garbage collection.
+     * The gauges are the requests waiting for the dispatching, the streams
+     * waiting for a slice and the slices running, as of the last dispatching.
+     * The busy time of the background workers, which the synths of the process
+     * share, is summed over the workers, and their elapsed time runs since
+     * their start, so that their utilization is the busy time over the product
+     * of the elapsed time and the number of workers.
      *
-     * @param[in] mode    The processing mode.
-     * @param[in] quality The desired sample quality, in the range 0 to 10.
+     * @since 1.3.0
      *
      * @par Thread-safety constraints
-     * - @b RT: the function must be invoked from the Real-time thread
+     * - The function is lock-free, and may be invoked from any thread
      */
-    void setSampleQuality(ProcessMode mode, int quality);
+    StreamingStats getStreamingStats() const noexcept;
 
     /**
-     * @brief Get the default oscillator quality.
-     *
-     * This is the quality setting which the engine uses when the instrument
-     * does not use the opcode `oscillator_quality`. The engine uses distinct
-     * default quality settings for live mode and freewheeling mode,
-     * which both can be accessed by the means of this function.
-     * @since 1.0.0
-     *
-     * @param[in] mode  The processing mode.
-     *
-     * @return The oscillator quality for the given mode, in the range 0 to 3.
+     * @brief The use of the buffer pools.
+     * @since 1.3.0
      */
-    int getOscillatorQuality(ProcessMode mode);
+    struct BufferPoolStats
+    {
+        int numBuffers;
+        int numStereoBuffers;
+        int numIndexBuffers;
+        int maxBuffersUsed;
+        int maxStereoBuffersUsed;
+        int maxIndexBuffersUsed;
+        int numBufferFailures;
+        int numStereoBufferFailures;
+        int numIndexBufferFailures;
+    };
 
     /**
-     * @brief Set the default oscillator quality.
-     *
-     * This is the quality setting which the engine uses when the instrument
-     * does not use the opcode `oscillator_quality`. The engine uses distinct
-     * default quality settings for live mode and freewheeling mode,
-     * which both can be accessed by the means of this function.
+     * @brief Return the use of the buffer pools since the start or the last
+     *        reset.
      *
-     * @since 1.0.0
+     * The pools hold the temporary buffers of the processing, and are sized
+     * from the instrument. The high-water marks are the most buffers held at
+     * once, and the failures count the requests for a buffer which could not
+     * be served, in which case the processing which asked for it is skipped.
      *
-     * @param[in] mode    The processing mode.
-     * @param[in] quality The desired oscillator quality, in the range 0 to 3.
+     * @since 1.3.0
      *
      * @par Thread-safety constraints
-     * - @b RT: the function must be invoked from the Real-time thread
+     * - @b CT: the function must be invoked from the Control thread
      */
-    void setOscillatorQuality(ProcessMode mode, int quality);
+    BufferPoolStats getBufferPoolStats() const noexcept;
 
     /**
-     * @brief Set whether pressing the sustain pedal cancels the release stage
+     * @brief Reset the high-water marks and the failures of the buffer pools.
      *
-     * @since 1.2.0
-     *
-     * @param value
+     * @since 1.3.0
      */
-    void setSustainCancelsRelease(bool value);
+    void resetBufferPoolStats() noexcept;
 
     /**
      * @brief Return the current value for the volume, in dB.
@@ -666,6 +1568,66 @@ public:
      */
     void hdPolyAftertouch(int delay, int noteNumber, float aftertouch) noexcept;
 
+    /**
+     * @brief Send a per-note pitch wheel event to the synth, as MPE sends on
+     *        the channel of each note.
+     * @since 1.3.0
+     *
+     * The voices of the note add the bend to the one of the pitch wheel,
+     * within the bend range of their region, and the regions can also read it
+     * as the extended CC 138. This command should be delay-ordered with all
+     * other midi-type events (notes, CCs, aftertouch and pitch-wheel),
+     * otherwise the behavior of the synth is undefined.
+     *
+     * @param delay the delay at which the event occurs; this should be lower
+     *              than the size of the block in the next call to renderBlock().
+     * @param noteNumber the note number, in domain 0 to 127.
+     * @param pitch the normalized pitch, in domain -1 to 1.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void hdPerNotePitchWheel(int delay, int noteNumber, float pitch) noexcept;
+
+    /**
+     * @brief Send a per-note timbre event to the synth, as MPE sends with
+     *        CC 74 on the channel of each note.
+     * @since 1.3.0
+     *
+     * The regions read the timbre of the note of their voices as the extended
+     * CC 139. This command should be delay-ordered with all other midi-type
+     * events (notes, CCs, aftertouch and pitch-wheel), otherwise the behavior
+     * of the synth is undefined.
+     *
+     * @param delay the delay at which the event occurs; this should be lower
+     *              than the size of the block in the next call to renderBlock().
+     * @param noteNumber the note number, in domain 0 to 127.
+     * @param timbre the normalized timbre, in domain 0 to 1.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void hdPerNoteTimbre(int delay, int noteNumber, float timbre) noexcept;
+
+    /**
+     * @brief Send a batch of midi-type events to the synth.
+     * @since 1.3.0
+     *
+     * This is equivalent to sending the events one by one with the high
+     * precision functions, but it takes the dispatch once for the whole batch,
+     * and it skips the CC values which are replaced at the same delay when
+     * nothing reacts to them. The events should be delay-ordered, and ordered
+     * with all other midi-type events, otherwise the behavior of the synth is
+     * undefined.
+     *
+     * @param events the events.
+     * @param count the number of events.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void sendEvents(const sfizz_event_t* events, size_t count) noexcept;
+
     /**
      * @brief Send a tempo event to the synth.
      *
@@ -772,12 +1734,75 @@ public:
      */
     void renderBlock(float** buffers, size_t numFrames, int numOutputs = 1) noexcept;
 
+    /**
+     * @brief Render a block of audio data, adding it to the content of the
+     * buffers instead of replacing it.
+     *
+     * @since 1.3.0
+     *
+     * @param buffers the buffers to add the next block into.
+     * @param numFrames the number of stereo frames in the block.
+     * @param numOutputs the number of stereo outputs.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void renderBlockAdding(float** buffers, size_t numFrames, int numOutputs = 1) noexcept;
+
+    /**
+     * @brief Render a block of audio data in an interleaved buffer.
+     *
+     * The buffer must be float[numSamples * numOutputs * 2], with the
+     * channels of each frame next to each other.
+     *
+     * @since 1.3.0
+     *
+     * @param buffer the interleaved buffer to write the next block into.
+     * @param numFrames the number of stereo frames in the block.
+     * @param numOutputs the number of stereo outputs.
+     * @param adding whether to add the block to the content of the buffer.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void renderBlockInterleaved(float* buffer, size_t numFrames, int numOutputs = 1, bool adding = false) noexcept;
+
     /**
      * @brief Return the number of active voices.
      * @since 0.2.0
      */
     int getNumActiveVoices() const noexcept;
 
+    /**
+     * @brief The state of the instrument which the user interfaces query.
+     * @since 1.3.0
+     */
+    struct StateSnapshot
+    {
+        uint64_t version; // increments with each block, 0 before the first
+        uint32_t numActiveVoices;
+        int activeNotes;
+        int program;
+        float pitchBend;
+        float channelAftertouch;
+        float noteVelocities[128]; // of the pressed notes, 0 for the others
+        float ccValues[512];
+    };
+
+    /**
+     * @brief Return the state of the instrument as of the last block.
+     *
+     * The render publishes the state once per block, and this reads it
+     * without locking nor waiting for the render, so user interfaces can
+     * poll it at any rate without adding work to the audio callback.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - the function may be invoked from any thread, concurrently with the others
+     */
+    StateSnapshot getStateSnapshot() const noexcept;
+
     /**
      * @brief Return the total number of voices in the synth (the polyphony).
      * @since 0.2.0
@@ -786,6 +1811,8 @@ public:
 
     /**
      * @brief Change the number of voices (the polyphony).
+     * The voices which play are kept: a lower polyphony lets the voices past
+     * the limit finish, and a higher one only constructs the missing voices.
      *
      * @since 0.2.0
      *
@@ -798,16 +1825,78 @@ public:
     void setNumVoices(int numVoices) noexcept;
 
     /**
-     * @brief Set the oversampling factor to a new value.
+     * @brief Set the limit of the voices playing in all the synths of the
+     * process which share the voice budget, or 0 for no limit.
+     *
+     * @since 1.3.0
+     *
+     * @param numVoices  The number of voices.
+     */
+    static void setSharedVoiceLimit(int numVoices) noexcept;
+
+    /**
+     * @brief Return the limit of the voices of the shared voice budget.
+     * @since 1.3.0
+     */
+    static int getSharedVoiceLimit() noexcept;
+
+    /**
+     * @brief Share the voice budget of the process, or stop sharing it.
+     *
+     * When the voices playing in the synths which share the budget reach its
+     * limit, a voice start fast releases the voice of lowest priority across
+     * them: the older and the quieter voices of the synths with the smaller
+     * weights go first. The voices of the other synths are released at the
+     * start of their next block.
+     *
+     * @since 1.3.0
      *
-     * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
+     * @param shared  Whether the synth shares the budget.
+     * @param weight  The weight of the voices of the synth in the priorities.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setSharedVoiceBudget(bool shared, float weight = 1.0f) noexcept;
+
+    /**
+     * @brief Return the number of threads which render the voices.
+     * @since 1.3.0
+     */
+    int getNumRenderThreads() const noexcept;
+
+    /**
+     * @brief Change the number of threads which render the voices.
+     *
+     * This count includes the thread which calls the render functions. With
+     * more than one thread, the voices are rendered concurrently on a pool of
+     * real-time worker threads. The default is 1.
+     *
+     * @since 1.3.0
+     *
+     * @param numThreads The number of threads.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setNumRenderThreads(int numThreads) noexcept;
+
+    /**
+     * @brief Set the oversampling factor to a new value.
      *
+     * The sample files are oversampled by this factor as they load, which
+     * lowers the aliasing of the transposed samples with the cheaper
+     * interpolators. They are oversampled in the background as they stream,
+     * and their data takes the factor times more memory. A change reloads
+     * the data of the files.
      *
      * @since 0.2.0
      *
-     * @param factor The oversampling factor.
+     * @param factor The oversampling factor: 1, 2, 4 or 8.
      *
-     * @return @true if the factor did indeed change, @false otherwise.
+     * @return @true if the factor is valid, @false otherwise.
      *
      * @par Thread-safety constraints
      * - @b CT: the function must be invoked from the Control thread
@@ -818,9 +1907,6 @@ public:
     /**
      * @brief Return the current oversampling factor.
      * @since 0.2.0
-     *
-     * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
-     *
      */
     int getOversamplingFactor() const noexcept;
 
@@ -843,6 +1929,66 @@ public:
      */
     uint32_t getPreloadSize() const noexcept;
 
+    /**
+     * @brief Enable the adaptive preloading.
+     *
+     * The preloaded heads of the files then cover a high percentile of the
+     * measured times from the stream requests to their first slices, with a
+     * margin, at the rate of each file and at its highest playback speed,
+     * instead of the preload size. The heads are sized after the latest
+     * measures on the loads and on the calls to updateAdaptivePreloading(),
+     * and the preload size applies until enough latencies are measured. The
+     * heads then grow on slow storage and shrink on fast storage. This is
+     * disabled by default.
+     *
+     * @since 1.3.0
+     *
+     * @param enable
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void enableAdaptivePreloading(bool enable) noexcept;
+
+    /**
+     * @brief Return whether the adaptive preloading is enabled.
+     *
+     * @since 1.3.0
+     */
+    bool isAdaptivePreloadingEnabled() const noexcept;
+
+    /**
+     * @brief Resize the preloaded heads in the adaptive preloading, if the
+     *        measured streaming latency changed much since they were sized.
+     *
+     * This reloads the heads like setPreloadSize(), and can be called
+     * regularly while the synth is idle.
+     *
+     * @since 1.3.0
+     *
+     * @return @true if the heads resized.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    bool updateAdaptivePreloading() noexcept;
+
+    /**
+     * @brief Return a percentile of the measured times from the stream
+     *        requests to their first slices, in seconds, rounded up to the
+     *        next power of 2 of 100 µs, or 0 if too few were measured.
+     *
+     * @since 1.3.0
+     *
+     * @param percentile  The percentile, between 0 and 1.
+     *
+     * @par Thread-safety constraints
+     * - The function is lock-free, and may be invoked from any thread
+     */
+    double getStreamingLatency(double percentile) const noexcept;
+
     /**
      * @brief Return the number of allocated buffers.
      * @since 0.2.0
@@ -972,6 +2118,7 @@ public:
         double filters;
         double panning;
         double effects;
+        int culledVoices;
     };
 
     /**
@@ -986,6 +2133,112 @@ public:
      */
     CallbackBreakdown getCallbackBreakdown() noexcept;
 
+    /**
+     * @brief The timed stages of the callbacks. The total is the dispatch of
+     * the events since the previous block, and the whole render call.
+     * @since 1.3.0
+     */
+    enum CallbackStage {
+        CallbackTotal,
+        CallbackDispatch,
+        CallbackRender,
+        CallbackData,
+        CallbackAmplitude,
+        CallbackFilters,
+        CallbackPanning,
+        CallbackEffects,
+    };
+
+    /**
+     * @brief The statistics of the durations of a callback stage, in seconds.
+     * The percentiles are the upper bounds of buckets of logarithmic widths,
+     * 9% apart.
+     * @since 1.3.0
+     */
+    struct CallbackStats
+    {
+        uint64_t numCallbacks;
+        double min;
+        double max;
+        double mean;
+        double p50;
+        double p99;
+        double p999;
+    };
+
+    /**
+     * @brief Return the statistics of the durations of a callback stage
+     *        since the start or the last reset.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    CallbackStats getCallbackStats(CallbackStage stage) const noexcept;
+
+    /**
+     * @brief Reset the statistics of all the callback stages.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void resetCallbackStats() noexcept;
+
+    /**
+     * @brief The timed stages of the starts of the voices. The dispatch runs
+     * from the entry of the event to the start of the voice, and the render
+     * delay from the start of the voice to the rendering of the block of its
+     * first sample.
+     * @since 1.3.0
+     */
+    enum VoiceStartStage {
+        VoiceStartDispatch,
+        VoiceStartRender,
+    };
+
+    /**
+     * @brief The statistics of the durations of a voice start stage, in
+     * seconds, as for the callbacks, and the numbers of the first blocks of
+     * the voices of samples which read the preloaded data or not.
+     * @since 1.3.0
+     */
+    struct VoiceStartStats
+    {
+        uint64_t numStarts;
+        double min;
+        double max;
+        double mean;
+        double p50;
+        double p99;
+        double p999;
+        uint64_t numPreloaded;
+        uint64_t numNotPreloaded;
+    };
+
+    /**
+     * @brief Return the statistics of a voice start stage since the start or
+     *        the last reset.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    VoiceStartStats getVoiceStartStats(VoiceStartStage stage) const noexcept;
+
+    /**
+     * @brief Reset the statistics of the voice starts.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void resetVoiceStartStats() noexcept;
+
     /**
      * @brief Shuts down the current processing, clear buffers and reset the voices.
      *
@@ -1102,16 +2355,54 @@ public:
      */
     void sendMessage(Client& client, int delay, const char* path, const char* sig, const sfizz_arg_t* args);
 
+    /**
+     * @brief Send a bundle of messages to the synth engine, and get all the
+     *        replies in a buffer.
+     *
+     * @since 1.3.0
+     *
+     * The requests and the replies are OSC messages laid one after the other,
+     * as written by `sfizz_prepare_message`. If the replies do not fit, the
+     * buffer holds the first ones.
+     *
+     * @param delay            The delay of the messages in the block, in samples.
+     * @param requests         The request messages.
+     * @param requestsSize     The size of the request messages.
+     * @param replies          The buffer which receives the reply messages.
+     * @param repliesCapacity  The capacity of the reply buffer.
+     * @return                 The size necessary to store all the replies,
+     *                         <= repliesCapacity if none was dropped.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    uint32_t sendMessageBundle(int delay, const void* requests, uint32_t requestsSize, void* replies, uint32_t repliesCapacity);
+
     /**
      * @brief Set the function which receives broadcast messages from the synth engine.
      *
      * @since 1.0.0
      *
+     * The function receives as well the values of the paths subscribed with
+     * the `/subscribe` message, from a thread which the synths share, at
+     * most at the rate asked for each path and only when they change. The
+     * paths are `/num_active_voices`, `/cc&/value`, `/voice&/level`,
+     * `/underruns/count` and `/underruns/missing_frames`, with a star in
+     * place of the number to subscribe to all the CCs or voices;
+     * `/unsubscribe` and `/unsubscribe_all` stop them. The thread sleeps
+     * while no path is subscribed.
+     *
+     * Once a path is subscribed, the function is called from this thread
+     * concurrently with the broadcasts of the other threads of the synth,
+     * such as the replies to the messages, so it must be reentrant. The
+     * calls from the subscription thread do not overlap each other, and
+     * stop before the function is unset or changed.
+     *
      * @param broadcast    The pointer to the receiving function.
      * @param data         The opaque data pointer which is passed to the receiver.
      *
      * @par Thread-safety constraints
-     * - @b RT: the function must be invoked from the Real-time thread
+     * - @b CT: the function must be invoked from the Control thread
      */
     void setBroadcastCallback(sfizz_receive_t* broadcast, void* data);
 
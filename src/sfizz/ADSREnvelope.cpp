@@ -8,6 +8,8 @@
 #include "Config.h"
 #include "SIMDHelpers.h"
 #include "MathHelpers.h"
+#include <algorithm>
+#include <cmath>
 
 namespace sfz {
 
@@ -38,6 +40,39 @@ Float ADSREnvelope::secondsToExpRate(Float timeInSeconds) const noexcept
     return std::exp(Float(-9.0) / (timeInSeconds * sampleRate));
 };
 
+/**
+ * @brief Count the frames of a linear segment `value + k * step` for `k >= 1`
+ * which stay on the side of `value` with respect to `limit`, up to `size`.
+ */
+static size_t linearSegmentLength(Float value, Float step, Float limit, size_t size) noexcept
+{
+    // the frames `k < frames` do not reach the limit
+    const Float frames = (limit - value) / step;
+    if (!(frames > 0))
+        return 0;
+
+    const Float length = std::ceil(frames) - 1;
+    return (length < static_cast<Float>(size)) ? static_cast<size_t>(length) : size;
+}
+
+/**
+ * @brief Count the frames of a geometric segment `value * rate^k` for `k >= 1`
+ * which stay above `threshold`, up to `size`.
+ */
+static size_t geometricSegmentLength(Float value, Float rate, Float threshold, size_t size) noexcept
+{
+    if (value <= threshold || rate <= 0)
+        return 0;
+
+    if (rate >= 1 || threshold <= 0)
+        return size;
+
+    // the frames `k < frames` stay above the threshold
+    const Float frames = std::log(threshold / value) / std::log(rate);
+    const Float length = std::ceil(frames) - 1;
+    return (length < static_cast<Float>(size)) ? static_cast<size_t>(length) : size;
+}
+
 void ADSREnvelope::reset(const EGDescription& desc, const Region& region, int delay, float velocity, float sampleRate) noexcept
 {
     this->sampleRate = sampleRate;
@@ -116,34 +151,48 @@ void ADSREnvelope::getBlockInternal(absl::Span<Float> output) noexcept
             }
         }
 
-        Float previousValue;
-
         switch (currentState) {
         case State::Delay:
-            while (count < size && delay-- > 0) {
+            count = std::min<size_t>(size, std::max(delay, 0));
+            if (count > 0) {
                 currentValue = start;
-                output[count++] = currentValue;
+                fill(output.first(count), currentValue);
             }
+            // the countdown passes below zero when it ends within the block
+            delay -= static_cast<int>(count);
+            if (count < size)
+                --delay;
             if (delay <= 0)
                 currentState = State::Attack;
             break;
         case State::Attack:
-            while (count < size && (currentValue += attackStep) < 1)
-                output[count++] = currentValue;
-            if (currentValue >= 1) {
+            count = linearSegmentLength(currentValue, attackStep, 1, size);
+            if (count > 0) {
+                linearRamp(output.data(), currentValue + attackStep, attackStep, count);
+                currentValue = output[count - 1];
+            }
+            if (count < size) {
                 currentValue = 1;
                 currentState = State::Hold;
             }
             break;
         case State::Hold:
-            while (count < size && hold-- > 0)
-                output[count++] = currentValue;
+            count = std::min<size_t>(size, std::max(hold, 0));
+            fill(output.first(count), currentValue);
+            hold -= static_cast<int>(count);
+            if (count < size)
+                --hold;
             if (hold <= 0)
                 currentState = State::Decay;
             break;
         case State::Decay:
-            while (count < size && (currentValue *= decayRate) > sustain)
-                output[count++] = currentValue;
+            count = geometricSegmentLength(currentValue, decayRate, sustain, size);
+            if (count > 0) {
+                multiplicativeRamp(output.data(), currentValue * decayRate, decayRate, count);
+                currentValue = output[count - 1];
+            }
+            if (count < size)
+                currentValue *= decayRate;
             if (currentValue <= sustainThreshold) {
                 currentState = State::Sustain;
                 currentValue = std::max(sustain, currentValue);
@@ -155,27 +204,36 @@ void ADSREnvelope::getBlockInternal(absl::Span<Float> output) noexcept
                 shouldRelease = true;
                 break;
             }
-            while (count < size) {
-                if (currentValue > sustain)
-                    currentValue += transitionDelta;
-                output[count++] = currentValue;
+            count = size;
+            if (currentValue > sustain && transitionDelta < 0) {
+                // the transition ends on the first value at or below sustain
+                const size_t transition = std::min(size, linearSegmentLength(currentValue, transitionDelta, sustain, size) + 1);
+                linearRamp(output.data(), currentValue + transitionDelta, transitionDelta, transition);
+                currentValue = output[transition - 1];
+                fill(output.subspan(transition, size - transition), currentValue);
+            } else {
+                fill(output.first(size), currentValue);
             }
             break;
         case State::Release:
-            previousValue = currentValue;
-            while (count < size && (currentValue *= releaseRate) > config::egReleaseThreshold)
-                output[count++] = previousValue = currentValue;
-            if (currentValue <= config::egReleaseThreshold) {
+            count = geometricSegmentLength(currentValue, releaseRate, config::egReleaseThreshold, size);
+            if (count > 0) {
+                multiplicativeRamp(output.data(), currentValue * releaseRate, releaseRate, count);
+                currentValue = output[count - 1];
+            }
+            if (count < size) {
                 currentState = State::Fadeout;
-                currentValue = previousValue;
                 transitionDelta = -max(config::egReleaseThreshold, currentValue)
                     / (sampleRate * config::egTransitionTime);
             }
             break;
         case State::Fadeout:
-            while (count < size && (currentValue += transitionDelta) > 0)
-                output[count++] = currentValue;
-            if (currentValue <= 0) {
+            count = linearSegmentLength(currentValue, transitionDelta, 0, size);
+            if (count > 0) {
+                linearRamp(output.data(), currentValue + transitionDelta, transitionDelta, count);
+                currentValue = output[count - 1];
+            }
+            if (count < size) {
                 currentState = State::Done;
                 currentValue = 0;
             }
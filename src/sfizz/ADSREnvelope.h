@@ -76,6 +76,12 @@ public:
      * @return int
      */
     int getRemainingDelay() const noexcept { return delay; }
+    /**
+     * @brief Get the value of the envelope at the end of the last block
+     *
+     * @return Float
+     */
+    Float getCurrentValue() const noexcept { return currentValue; }
 
     /**
      * @brief Stop dynamic updates of the EG values.
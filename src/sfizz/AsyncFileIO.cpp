@@ -0,0 +1,457 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "AsyncFileIO.h"
+#include "utility/Debug.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define SFIZZ_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace sfz {
+
+struct AsyncFileIO::Operation {
+#if defined(_WIN32)
+    OVERLAPPED overlapped; // first, so that the completions give back the operation
+#elif defined(SFIZZ_HAVE_IO_URING)
+    struct iovec iov;
+#endif
+    void* userData;
+};
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr<AsyncFileIO::File> AsyncFileIO::File::open(const fs::path& path)
+{
+#if defined(_WIN32)
+    HANDLE handle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return {};
+    std::unique_ptr<File> file { new File };
+    file->handle_ = reinterpret_cast<intptr_t>(handle);
+    return file;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return {};
+    std::unique_ptr<File> file { new File };
+    file->handle_ = fd;
+    return file;
+#endif
+}
+
+AsyncFileIO::File::~File()
+{
+#if defined(_WIN32)
+    CloseHandle(reinterpret_cast<HANDLE>(handle_));
+#else
+    ::close(static_cast<int>(handle_));
+#endif
+}
+
+int64_t AsyncFileIO::File::read(uint64_t offset, void* buffer, size_t size) const noexcept
+{
+#if defined(_WIN32)
+    HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!event)
+        return -1;
+
+    // The low bit of the event keeps the read off the completion port
+    OVERLAPPED overlapped {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    overlapped.hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<uintptr_t>(event) | 1);
+
+    HANDLE handle = reinterpret_cast<HANDLE>(handle_);
+    DWORD numBytesRead = 0;
+    int64_t result = 0;
+    if (ReadFile(handle, buffer, static_cast<DWORD>(size), nullptr, &overlapped)
+        || GetLastError() == ERROR_IO_PENDING) {
+        WaitForSingleObject(event, INFINITE);
+        if (GetOverlappedResult(handle, &overlapped, &numBytesRead, FALSE))
+            result = static_cast<int64_t>(numBytesRead);
+        else if (GetLastError() != ERROR_HANDLE_EOF)
+            result = -1;
+    }
+    else if (GetLastError() != ERROR_HANDLE_EOF)
+        result = -1;
+
+    CloseHandle(event);
+    return result;
+#else
+    unsigned char* destination = static_cast<unsigned char*>(buffer);
+    size_t numBytesRead = 0;
+    while (numBytesRead < size) {
+        const ssize_t count = pread(static_cast<int>(handle_), destination + numBytesRead,
+            size - numBytesRead, static_cast<off_t>(offset + numBytesRead));
+        if (count == 0)
+            break;
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        numBytesRead += static_cast<size_t>(count);
+    }
+    return static_cast<int64_t>(numBytesRead);
+#endif
+}
+
+void AsyncFileIO::File::willNeed(uint64_t offset, uint64_t size) const noexcept
+{
+    if (size == 0)
+        return;
+
+#if defined(_WIN32)
+    // The prefetch works on mapped memory, so it goes through a view of the
+    // range, whose pages stay in the system cache once it is unmapped
+    struct PrefetchEntry {
+        void* address;
+        SIZE_T numBytes;
+    };
+    using PrefetchFunction = BOOL(WINAPI*)(HANDLE, ULONG_PTR, PrefetchEntry*, ULONG);
+    static const PrefetchFunction prefetch = reinterpret_cast<PrefetchFunction>(reinterpret_cast<void*>(
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory")));
+    if (!prefetch)
+        return;
+
+    HANDLE handle = reinterpret_cast<HANDLE>(handle_);
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || offset >= static_cast<uint64_t>(fileSize.QuadPart))
+        return;
+    size = std::min(size, static_cast<uint64_t>(fileSize.QuadPart) - offset);
+
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const uint64_t viewOffset = offset - offset % systemInfo.dwAllocationGranularity;
+    const SIZE_T viewSize = static_cast<SIZE_T>(size + (offset - viewOffset));
+
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ,
+        static_cast<DWORD>(viewOffset >> 32), static_cast<DWORD>(viewOffset), viewSize);
+    if (view) {
+        PrefetchEntry entry { view, viewSize };
+        prefetch(GetCurrentProcess(), 1, &entry, 0);
+        UnmapViewOfFile(view);
+    }
+    CloseHandle(mapping);
+#elif defined(__APPLE__)
+    struct radvisory advice;
+    advice.ra_offset = static_cast<off_t>(offset);
+    advice.ra_count = static_cast<int>(std::min(size, uint64_t(INT_MAX)));
+    fcntl(static_cast<int>(handle_), F_RDADVISE, &advice);
+#elif defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(static_cast<int>(handle_), static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#else
+    (void)offset;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+#if defined(_WIN32)
+struct AsyncFileIO::Impl {
+    HANDLE port { nullptr };
+
+    ~Impl()
+    {
+        if (port)
+            CloseHandle(port);
+    }
+
+    bool setup(unsigned) noexcept
+    {
+        port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        return port != nullptr;
+    }
+
+    bool submitRead(File& file, uint64_t offset, void* buffer, size_t size, Operation* op) noexcept
+    {
+        HANDLE handle = reinterpret_cast<HANDLE>(file.handle_);
+        if (!file.associated_) {
+            if (!CreateIoCompletionPort(handle, port, 0, 0))
+                return false;
+            file.associated_ = true;
+        }
+
+        // A read which completes at once still queues its completion
+        op->overlapped.Offset = static_cast<DWORD>(offset);
+        op->overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        return ReadFile(handle, buffer, static_cast<DWORD>(size), nullptr, &op->overlapped)
+            || GetLastError() == ERROR_IO_PENDING;
+    }
+
+    void wake() noexcept
+    {
+        PostQueuedCompletionStatus(port, 0, 0, nullptr);
+    }
+
+    bool waitCompletion(Operation*& op, int64_t& result) noexcept
+    {
+        for (;;) {
+            DWORD numBytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* overlapped = nullptr;
+            const BOOL ok = GetQueuedCompletionStatus(port, &numBytes, &key, &overlapped, INFINITE);
+            if (!overlapped) {
+                if (ok)
+                    return false; // the stop request
+                continue;
+            }
+
+            op = reinterpret_cast<Operation*>(overlapped);
+            if (ok)
+                result = static_cast<int64_t>(numBytes);
+            else if (GetLastError() == ERROR_HANDLE_EOF)
+                result = 0;
+            else
+                result = -static_cast<int64_t>(GetLastError());
+            return true;
+        }
+    }
+};
+#elif defined(SFIZZ_HAVE_IO_URING)
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) noexcept
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int ring, unsigned toSubmit, unsigned minComplete, unsigned flags) noexcept
+{
+    int result;
+    do
+        result = static_cast<int>(syscall(__NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0));
+    while (result < 0 && errno == EINTR);
+    return result;
+}
+
+} // namespace
+
+struct AsyncFileIO::Impl {
+    int ring { -1 };
+    void* sqRing { MAP_FAILED };
+    size_t sqRingSize { 0 };
+    void* cqRing { MAP_FAILED };
+    size_t cqRingSize { 0 };
+    io_uring_sqe* sqes { nullptr };
+    size_t sqesSize { 0 };
+
+    unsigned* sqHead { nullptr };
+    unsigned* sqTail { nullptr };
+    unsigned sqMask { 0 };
+    unsigned sqEntries { 0 };
+    unsigned* sqArray { nullptr };
+    unsigned* cqHead { nullptr };
+    unsigned* cqTail { nullptr };
+    unsigned cqMask { 0 };
+    io_uring_cqe* cqes { nullptr };
+
+    ~Impl()
+    {
+        if (sqes)
+            munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED)
+            munmap(sqRing, sqRingSize);
+        if (ring != -1)
+            ::close(ring);
+    }
+
+    bool setup(unsigned queueDepth) noexcept
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring = ioUringSetup(queueDepth, &params);
+        if (ring < 0) {
+            DBG("[sfizz] io_uring is not available: " << std::strerror(errno));
+            ring = -1;
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED)
+            return false;
+        cqRing = singleMapping ? sqRing :
+            mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+            return false;
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqesMapping = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+        if (sqesMapping == MAP_FAILED)
+            return false;
+        sqes = static_cast<io_uring_sqe*>(sqesMapping);
+
+        unsigned char* sq = static_cast<unsigned char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        unsigned char* cq = static_cast<unsigned char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool submit(uint8_t opcode, int fd, uint64_t offset, Operation* op) noexcept
+    {
+        const unsigned tail = *sqTail;
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+            return false;
+
+        const unsigned index = tail & sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.off = offset;
+        if (op) {
+            sqe.addr = reinterpret_cast<uintptr_t>(&op->iov);
+            sqe.len = 1;
+        }
+        sqe.user_data = reinterpret_cast<uintptr_t>(op);
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        // Once published, the entry belongs to the ring; if the kernel does
+        // not take it now, it takes it with the next submission
+        const unsigned numEntries = tail + 1 - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (ioUringEnter(ring, numEntries, 0, 0) < 0)
+            DBG("[sfizz] io_uring submission failed: " << std::strerror(errno));
+        return true;
+    }
+
+    bool submitRead(File& file, uint64_t offset, void* buffer, size_t size, Operation* op) noexcept
+    {
+        op->iov.iov_base = buffer;
+        op->iov.iov_len = size;
+        return submit(IORING_OP_READV, static_cast<int>(file.handle_), offset, op);
+    }
+
+    void wake() noexcept
+    {
+        submit(IORING_OP_NOP, -1, 0, nullptr);
+    }
+
+    bool waitCompletion(Operation*& op, int64_t& result) noexcept
+    {
+        for (;;) {
+            const unsigned head = *cqHead;
+            if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                ioUringEnter(ring, 0, 1, IORING_ENTER_GETEVENTS);
+                continue;
+            }
+
+            const io_uring_cqe& cqe = cqes[head & cqMask];
+            op = reinterpret_cast<Operation*>(static_cast<uintptr_t>(cqe.user_data));
+            result = cqe.res;
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+            return op != nullptr; // null is the stop request
+        }
+    }
+};
+#else
+struct AsyncFileIO::Impl {
+    bool setup(unsigned) noexcept { return false; }
+    bool submitRead(File&, uint64_t, void*, size_t, Operation*) noexcept { return false; }
+    void wake() noexcept {}
+    bool waitCompletion(Operation*&, int64_t&) noexcept { return false; }
+};
+#endif
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr<AsyncFileIO> AsyncFileIO::create(unsigned queueDepth, CompletionFunction completion)
+{
+    std::unique_ptr<Impl> impl { new Impl };
+    if (queueDepth == 0 || !impl->setup(queueDepth))
+        return {};
+
+    std::unique_ptr<AsyncFileIO> io { new AsyncFileIO };
+    io->impl_ = std::move(impl);
+    io->completion_ = std::move(completion);
+    io->queueDepth_ = queueDepth;
+    io->completionThread_ = std::thread(&AsyncFileIO::completionJob, io.get());
+    return io;
+}
+
+AsyncFileIO::~AsyncFileIO()
+{
+    ASSERT(numPendingReads_ == 0);
+    if (completionThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock { submitMutex_ };
+            impl_->wake();
+        }
+        completionThread_.join();
+    }
+}
+
+bool AsyncFileIO::read(File& file, uint64_t offset, void* buffer, size_t size, void* userData) noexcept
+{
+    std::lock_guard<std::mutex> lock { submitMutex_ };
+    if (numPendingReads_ >= queueDepth_)
+        return false;
+
+    std::unique_ptr<Operation> op { new (std::nothrow) Operation() };
+    if (!op)
+        return false;
+    op->userData = userData;
+
+    ++numPendingReads_;
+    if (!impl_->submitRead(file, offset, buffer, size, op.get())) {
+        --numPendingReads_;
+        return false;
+    }
+
+    op.release();
+    return true;
+}
+
+void AsyncFileIO::completionJob() noexcept
+{
+    Operation* op;
+    int64_t result;
+    while (impl_->waitCompletion(op, result)) {
+        --numPendingReads_;
+        completion_(op->userData, result);
+        delete op;
+    }
+}
+
+} // namespace sfz
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "utility/LeakDetector.h"
+#include "ghc/fs_std.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace sfz {
+
+/**
+ * @brief Reads of files which complete in the background, many at a time,
+ * with a single thread waiting for all of them. This uses io_uring on Linux
+ * and overlapped I/O on Windows; other systems have no backend.
+ */
+class AsyncFileIO {
+public:
+    /**
+     * @brief A file opened for reading at any offset
+     */
+    class File {
+    public:
+        /**
+         * @brief Open a file
+         *
+         * @param path the file to open
+         * @return the file, or null if it cannot be opened
+         */
+        static std::unique_ptr<File> open(const fs::path& path);
+
+        ~File();
+
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+
+        /**
+         * @brief Read from the file, blocking until the read is over
+         *
+         * @param offset the offset in bytes
+         * @param buffer the destination
+         * @param size the number of bytes to read
+         * @return the number of bytes read, or a negative value on error
+         */
+        int64_t read(uint64_t offset, void* buffer, size_t size) const noexcept;
+        /**
+         * @brief Tell the system that a range of the file is read soon, so
+         * that it starts reading it into its cache. This does not wait.
+         *
+         * @param offset the offset in bytes
+         * @param size the number of bytes
+         */
+        void willNeed(uint64_t offset, uint64_t size) const noexcept;
+
+    private:
+        friend class AsyncFileIO;
+        File() = default;
+        intptr_t handle_ { -1 };
+        bool associated_ { false };
+
+        LEAK_DETECTOR(File);
+    };
+
+    /**
+     * @brief Function called on the completion thread when a read is over,
+     * with the user data of the read, and the number of bytes read or a
+     * negative value on error
+     */
+    using CompletionFunction = std::function<void(void* userData, int64_t result)>;
+
+    /**
+     * @brief Start the backend
+     *
+     * @param queueDepth the maximal number of reads in flight
+     * @param completion the function receiving the completed reads
+     * @return the backend, or null if the system has none or it cannot start
+     */
+    static std::unique_ptr<AsyncFileIO> create(unsigned queueDepth, CompletionFunction completion);
+
+    /**
+     * @brief Stop the backend. The reads in flight must be over.
+     */
+    ~AsyncFileIO();
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    /**
+     * @brief Read from a file in the background. The file and the buffer must
+     * stay valid until the completion function is called.
+     *
+     * @param file the file
+     * @param offset the offset in bytes
+     * @param buffer the destination
+     * @param size the number of bytes to read
+     * @param userData the data passed to the completion function
+     * @return true if the read was queued, false if the queue is full or the
+     *         system refused it
+     */
+    bool read(File& file, uint64_t offset, void* buffer, size_t size, void* userData) noexcept;
+
+    /**
+     * @brief Get the number of reads in flight
+     */
+    unsigned getNumPendingReads() const noexcept { return numPendingReads_.load(); }
+
+private:
+    struct Impl;
+    struct Operation;
+
+    AsyncFileIO() = default;
+    void completionJob() noexcept;
+
+    std::unique_ptr<Impl> impl_;
+    CompletionFunction completion_;
+    unsigned queueDepth_ { 0 };
+    std::atomic<unsigned> numPendingReads_ { 0 };
+    std::mutex submitMutex_;
+    std::thread completionThread_;
+
+    LEAK_DETECTOR(AsyncFileIO);
+};
+
+} // namespace sfz
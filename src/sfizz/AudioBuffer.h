@@ -25,10 +25,12 @@ namespace sfz
  * @tparam Type the underlying type of the buffers
  * @tparam MaxChannels the maximum number of channels in the buffer
  * @tparam Alignment the alignment for the buffers
+ * @tparam Allocator the allocation of the buffers
  */
 template <class Type, size_t MaxChannels = config::maxChannels,
           unsigned int Alignment = config::defaultAlignment,
-          size_t PaddingLeft_ = 0, size_t PaddingRight_ = 0>
+          size_t PaddingLeft_ = 0, size_t PaddingRight_ = 0,
+          class Allocator = BufferAllocator>
 class AudioBuffer {
 public:
     using value_type = typename std::remove_cv<Type>::type;
@@ -218,6 +220,19 @@ public:
         return numChannels;
     }
 
+    /**
+     * @brief Get the memory allocated for the channels, in bytes
+     *
+     * @return size_t
+     */
+    size_t getMemoryUsage() const
+    {
+        size_t usage = 0;
+        for (size_t i = 0; i < numChannels; ++i)
+            usage += buffers[i]->allocationSize() * sizeof(Type);
+        return usage;
+    }
+
     /**
      * @brief Check if the buffers contains no elements
      *
@@ -295,7 +310,7 @@ public:
     }
 
 private:
-    using buffer_type = Buffer<Type, Alignment>;
+    using buffer_type = Buffer<Type, Alignment, Allocator>;
     using buffer_ptr = std::unique_ptr<buffer_type>;
     static_assert(MaxChannels > 0, "Need a positive number of channels");
     std::array<buffer_ptr, MaxChannels> buffers;
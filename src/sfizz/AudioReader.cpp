@@ -5,16 +5,70 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "AudioReader.h"
+#include "AsyncFileIO.h"
 #include "FileMetadata.h"
+#include "SIMDHelpers.h"
+#include "WindowedSinc.h"
 #include <absl/memory/memory.h>
 #include <st_audiofile.hpp>
 #if defined(SFIZZ_USE_SNDFILE)
 #include <sndfile.h>
 #endif
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace sfz {
 
+size_t AudioReader::readNextFrames(float* const outputs[], size_t frames)
+{
+    const unsigned numChannels = channels();
+    if (numChannels == 1)
+        return readNextBlock(outputs[0], frames);
+
+    interleaved_.resize(numChannels * frames);
+    const size_t numFramesRead = readNextBlock(interleaved_.data(), frames);
+    if (numChannels == 2)
+        readInterleaved(interleaved_.data(), outputs[0], outputs[1], static_cast<unsigned>(2 * numFramesRead));
+    else {
+        for (size_t i = 0; i < numFramesRead; ++i) {
+            for (unsigned c = 0; c < numChannels; ++c)
+                outputs[c][i] = interleaved_[i * numChannels + c];
+        }
+    }
+    return numFramesRead;
+}
+
+static bool extractWavetableInfo(MetadataReader* mdReader, WavetableInfo& wt)
+{
+    if (!mdReader)
+        return false;
+
+    if (!mdReader->isOpened())
+        mdReader->open();
+
+    if (mdReader->isOpened())
+        return mdReader->extractWavetableInfo(wt);
+
+    return false;
+}
+
+static bool extractInstrumentInfo(MetadataReader* mdReader, InstrumentInfo& instrument)
+{
+    if (!mdReader)
+        return false;
+
+    if (!mdReader->isOpened())
+        mdReader->open();
+
+    if (mdReader->isOpened())
+        return mdReader->extractInstrument(instrument);
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
 class BasicSndfileReader : public AudioReader {
 public:
     explicit BasicSndfileReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader)
@@ -54,16 +108,7 @@ unsigned BasicSndfileReader::sampleRate() const
 
 bool BasicSndfileReader::getWavetableInfo(WavetableInfo& wt)
 {
-    if (!mdReader_)
-        return false;
-
-    if (!mdReader_->isOpened())
-        mdReader_->open();
-
-    if (mdReader_->isOpened())
-        return mdReader_->extractWavetableInfo(wt);
-
-    return false;
+    return extractWavetableInfo(mdReader_.get(), wt);
 };
 
 bool BasicSndfileReader::getInstrumentInfo(InstrumentInfo& instrument)
@@ -74,14 +119,7 @@ bool BasicSndfileReader::getInstrumentInfo(InstrumentInfo& instrument)
     if (sf_command(sndfile, SFC_GET_INSTRUMENT, sfins, sizeof(SF_INSTRUMENT)) == SF_TRUE)
         return true;
 #else
-    if (!mdReader_)
-        return false;
-
-    if (!mdReader_->isOpened())
-        mdReader_->open();
-
-    if (mdReader_->isOpened())
-        return mdReader_->extractInstrument(instrument);
+    return extractInstrumentInfo(mdReader_.get(), instrument);
 #endif
     return false;
 }
@@ -203,7 +241,14 @@ size_t ReverseReader::readNextBlock(float* buffer, size_t frames)
 //------------------------------------------------------------------------------
 
 /**
- * @brief Audio file reader in reverse direction, for slow-seeking formats
+ * @brief Number of frames decoded after each seek of the slow-seeking reader
+ */
+constexpr uint64_t kReverseChunkFrames = 65536;
+
+/**
+ * @brief Audio file reader in reverse direction, for slow-seeking formats.
+ * It seeks once per chunk of frames and decodes the chunk forward, instead
+ * of seeking before each block.
  */
 class NoSeekReverseReader : public BasicSndfileReader {
 public:
@@ -212,16 +257,18 @@ public:
     size_t readNextBlock(float* buffer, size_t frames) override;
 
 private:
-    void readWholeFile();
+    bool readPreviousChunk();
 
 private:
-    std::unique_ptr<float[]> fileBuffer_;
-    uint64_t fileFramesLeft_ { 0 };
+    std::unique_ptr<float[]> chunkBuffer_;
+    uint64_t chunkFramesLeft_ { 0 };
+    uint64_t position_ { 0 };
 };
 
 NoSeekReverseReader::NoSeekReverseReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader)
     : BasicSndfileReader(std::move(handle), std::move(mdReader))
 {
+    position_ = handle_.get_frame_count();
 }
 
 AudioReaderType NoSeekReverseReader::type() const
@@ -231,34 +278,50 @@ AudioReaderType NoSeekReverseReader::type() const
 
 size_t NoSeekReverseReader::readNextBlock(float* buffer, size_t frames)
 {
-    float* fileBuffer = fileBuffer_.get();
-    if (!fileBuffer) {
-        readWholeFile();
-        fileBuffer = fileBuffer_.get();
-    }
-
     const unsigned channels = handle_.get_channels();
-    const uint64_t fileFramesLeft = fileFramesLeft_;
-    uint64_t readFrames = std::min<uint64_t>(frames, fileFramesLeft);
-    if (readFrames <= 0)
-        return 0;
-
-    std::copy(
-        &fileBuffer[channels * (fileFramesLeft - readFrames)],
-        &fileBuffer[channels * fileFramesLeft], buffer);
-    reverse_frames(buffer, readFrames, channels);
+    size_t framesDone = 0;
+
+    while (framesDone < frames) {
+        if (chunkFramesLeft_ == 0 && !readPreviousChunk())
+            break;
+
+        const uint64_t chunkFramesLeft = chunkFramesLeft_;
+        const uint64_t readFrames = std::min<uint64_t>(frames - framesDone, chunkFramesLeft);
+        const float* chunkBuffer = chunkBuffer_.get();
+        float* output = &buffer[channels * framesDone];
+        std::copy(
+            &chunkBuffer[channels * (chunkFramesLeft - readFrames)],
+            &chunkBuffer[channels * chunkFramesLeft], output);
+        reverse_frames(output, readFrames, channels);
+
+        chunkFramesLeft_ = chunkFramesLeft - readFrames;
+        framesDone += readFrames;
+    }
 
-    fileFramesLeft_ = fileFramesLeft - readFrames;
-    return readFrames;
+    return framesDone;
 }
 
-void NoSeekReverseReader::readWholeFile()
+bool NoSeekReverseReader::readPreviousChunk()
 {
-    const uint64_t frames = handle_.get_frame_count();
+    const uint64_t position = position_;
+    if (position == 0)
+        return false;
+
     const unsigned channels = handle_.get_channels();
-    float* fileBuffer = new float[channels * frames];
-    fileBuffer_.reset(fileBuffer);
-    fileFramesLeft_ = handle_.read_f32(fileBuffer, frames);
+    const uint64_t chunkFrames = std::min(kReverseChunkFrames, position);
+    if (!chunkBuffer_)
+        chunkBuffer_.reset(new float[channels * chunkFrames]);
+
+    const uint64_t chunkStart = position - chunkFrames;
+    if (!handle_.seek(chunkStart) ||
+        handle_.read_f32(chunkBuffer_.get(), chunkFrames) != chunkFrames) {
+        position_ = 0;
+        return false;
+    }
+
+    position_ = chunkStart;
+    chunkFramesLeft_ = chunkFrames;
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -304,6 +367,150 @@ const std::error_category& undetailed_category()
     return cat;
 }
 
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Points of the windowed-sinc kernel of the load-time resampler, at
+ * the lowest of the two rates
+ */
+constexpr size_t kResamplerPoints = 64;
+
+/**
+ * @brief Frames read from the source at once by the load-time resampler
+ */
+constexpr size_t kResamplerReadFrames = 4096;
+
+static const WindowedSinc& getResamplerKernel()
+{
+    // The lookup scales by an integer number of entries per point
+    static const WindowedSinc kernel { kResamplerPoints, kResamplerPoints * 1024 + 1, 10.0 };
+    return kernel;
+}
+
+/**
+ * @brief Audio file reader which resamples the frames of another reader at
+ * a different rate, with a windowed-sinc kernel whose cutoff is the lowest
+ * of the two Nyquist frequencies. It reads the source forward once.
+ */
+class ResamplingAudioReader : public AudioReader {
+public:
+    ResamplingAudioReader(AudioReaderPtr reader, double sampleRate);
+    AudioReaderType type() const override { return reader_->type(); }
+    int format() const override { return reader_->format(); }
+    int64_t frames() const override { return frames_; }
+    unsigned channels() const override { return reader_->channels(); }
+    unsigned sampleRate() const override { return static_cast<unsigned>(sampleRate_); }
+    size_t readNextBlock(float* buffer, size_t frames) override;
+    // The metadata positions are in the frames of the source, so there is none
+
+private:
+    void bufferSourceFrames(int64_t firstFrame, int64_t lastFrame);
+
+private:
+    AudioReaderPtr reader_;
+    double sampleRate_ {};
+    double step_ {};
+    double cutoff_ {};
+    int64_t halfWidth_ {};
+    int64_t frames_ {};
+    int64_t position_ { 0 };
+    bool sourceOver_ { false };
+    // The interleaved source frames from `bufferStart_`
+    std::vector<float> buffer_;
+    int64_t bufferStart_ { 0 };
+    std::vector<float> weights_;
+};
+
+ResamplingAudioReader::ResamplingAudioReader(AudioReaderPtr reader, double sampleRate)
+    : reader_(std::move(reader)), sampleRate_(sampleRate)
+{
+    const double sourceRate = reader_->sampleRate();
+    step_ = sourceRate / sampleRate;
+    cutoff_ = std::min(1.0, 1.0 / step_);
+    halfWidth_ = static_cast<int64_t>(std::ceil(kResamplerPoints / 2 / cutoff_));
+    frames_ = getResampledFrames(reader_->frames(), sourceRate, sampleRate);
+
+    // The frames before the start are silent
+    buffer_.assign(static_cast<size_t>(halfWidth_) * reader_->channels(), 0.0f);
+    bufferStart_ = -halfWidth_;
+    weights_.resize(static_cast<size_t>(2 * halfWidth_));
+}
+
+void ResamplingAudioReader::bufferSourceFrames(int64_t firstFrame, int64_t lastFrame)
+{
+    const unsigned channels = reader_->channels();
+
+    // Drop the frames which are no longer needed, by large amounts
+    const int64_t numDropped = firstFrame - bufferStart_;
+    if (numDropped >= static_cast<int64_t>(kResamplerReadFrames)) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<size_t>(numDropped * channels));
+        bufferStart_ = firstFrame;
+    }
+
+    int64_t bufferEnd = bufferStart_ + static_cast<int64_t>(buffer_.size() / channels);
+    while (bufferEnd <= lastFrame) {
+        const size_t oldSize = buffer_.size();
+        buffer_.resize(oldSize + kResamplerReadFrames * channels, 0.0f);
+        // The frames after the end are silent
+        if (!sourceOver_) {
+            const size_t numRead = reader_->readNextBlock(&buffer_[oldSize], kResamplerReadFrames);
+            sourceOver_ = numRead < kResamplerReadFrames;
+        }
+        bufferEnd += static_cast<int64_t>(kResamplerReadFrames);
+    }
+}
+
+size_t ResamplingAudioReader::readNextBlock(float* buffer, size_t frames)
+{
+    const unsigned channels = reader_->channels();
+    const WindowedSinc& kernel = getResamplerKernel();
+    const double kernelExtent = kResamplerPoints / 2.0;
+
+    frames = static_cast<size_t>(std::min<int64_t>(static_cast<int64_t>(frames), frames_ - position_));
+    for (size_t i = 0; i < frames; ++i) {
+        const double time = static_cast<double>(position_) * step_;
+        const int64_t center = static_cast<int64_t>(std::floor(time));
+        const int64_t firstFrame = center - halfWidth_ + 1;
+        bufferSourceFrames(firstFrame, center + halfWidth_);
+
+        // The weights are normalized, for a gain of exactly 1 at DC
+        double sumWeights = 0.0;
+        for (int64_t j = 0; j < 2 * halfWidth_; ++j) {
+            const double x = (static_cast<double>(firstFrame + j) - time) * cutoff_;
+            const float weight = (std::fabs(x) < kernelExtent) ?
+                kernel.getUnchecked(static_cast<float>(x)) : 0.0f;
+            weights_[static_cast<size_t>(j)] = weight;
+            sumWeights += weight;
+        }
+        const float normalization = (sumWeights != 0.0) ? static_cast<float>(1.0 / sumWeights) : 0.0f;
+
+        const float* input = &buffer_[static_cast<size_t>(firstFrame - bufferStart_) * channels];
+        float* output = &buffer[i * channels];
+        for (unsigned c = 0; c < channels; ++c) {
+            float sum = 0.0f;
+            for (int64_t j = 0; j < 2 * halfWidth_; ++j)
+                sum += weights_[static_cast<size_t>(j)] * input[static_cast<size_t>(j) * channels + c];
+            output[c] = normalization * sum;
+        }
+
+        ++position_;
+    }
+
+    return frames;
+}
+
+int64_t getResampledFrames(int64_t frames, double sourceRate, double sampleRate)
+{
+    return static_cast<int64_t>(std::ceil(static_cast<double>(frames) * sampleRate / sourceRate));
+}
+
+AudioReaderPtr createResamplingAudioReader(AudioReaderPtr reader, double sampleRate)
+{
+    if (!reader || reader->sampleRate() == 0 || static_cast<double>(reader->sampleRate()) == sampleRate)
+        return reader;
+    return AudioReaderPtr(new ResamplingAudioReader(std::move(reader), sampleRate));
+}
+
 //------------------------------------------------------------------------------
 static fs::path emptyPath_ {};
 
@@ -323,6 +530,302 @@ private:
 
 //------------------------------------------------------------------------------
 
+namespace {
+
+constexpr uint16_t kWavFormatPcm = 1;
+constexpr uint16_t kWavFormatFloat = 3;
+constexpr uint16_t kWavFormatExtensible = 0xfffe;
+
+uint16_t readLE16(const unsigned char* data) noexcept
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t readLE32(const unsigned char* data) noexcept
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+        | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+bool isLittleEndianHost() noexcept
+{
+    const uint32_t value = 1;
+    unsigned char first;
+    std::memcpy(&first, &value, 1);
+    return first == 1;
+}
+
+constexpr uint64_t kRawChunkFrames = 16384;
+
+template <class F>
+void decodeRawSamples(const unsigned char* data, unsigned stride, absl::Span<float> output, F&& decode) noexcept
+{
+    for (size_t i = 0, n = output.size(); i < n; ++i)
+        output[i] = decode(data + i * stride);
+}
+
+} // namespace
+
+bool getRawAudioLayout(const fs::path& path, RawAudioLayout& layout)
+{
+    if (!isLittleEndianHost())
+        return false;
+
+    fs::ifstream stream(path, std::ios::binary);
+    unsigned char header[12];
+    if (!stream.read(reinterpret_cast<char*>(header), 12))
+        return false;
+    if (std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0)
+        return false;
+
+    stream.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(stream.tellg());
+
+    bool formatOk = false;
+    uint64_t offset = 12;
+    while (offset + 8 <= fileSize) {
+        unsigned char chunk[8];
+        stream.seekg(static_cast<std::streamoff>(offset));
+        if (!stream.read(reinterpret_cast<char*>(chunk), 8))
+            return false;
+
+        const uint64_t chunkSize = readLE32(chunk + 4);
+        const uint64_t chunkData = offset + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[26];
+            const size_t fmtSize = chunkSize >= 26 ? 26 : 16;
+            if (chunkSize < 16 || !stream.read(reinterpret_cast<char*>(fmt), fmtSize))
+                return false;
+
+            uint16_t formatTag = readLE16(fmt);
+            if (formatTag == kWavFormatExtensible && fmtSize == 26)
+                formatTag = readLE16(fmt + 24); // first bytes of the subformat GUID
+            const uint16_t numChannels = readLE16(fmt + 2);
+            const uint16_t bitsPerSample = readLE16(fmt + 14);
+            const uint16_t blockAlign = readLE16(fmt + 12);
+
+            if (formatTag == kWavFormatPcm && bitsPerSample == 16)
+                layout.encoding = RawAudioLayout::Encoding::Int16;
+            else if (formatTag == kWavFormatPcm && bitsPerSample == 24)
+                layout.encoding = RawAudioLayout::Encoding::Int24;
+            else if (formatTag == kWavFormatPcm && bitsPerSample == 32)
+                layout.encoding = RawAudioLayout::Encoding::Int32;
+            else if (formatTag == kWavFormatFloat && bitsPerSample == 32)
+                layout.encoding = RawAudioLayout::Encoding::Float32;
+            else
+                return false;
+
+            layout.channels = numChannels;
+            layout.bytesPerSample = bitsPerSample / 8;
+            layout.sampleRate = readLE32(fmt + 4);
+            formatOk = (numChannels == 1 || numChannels == 2) && blockAlign == layout.bytesPerFrame();
+            if (!formatOk)
+                return false;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!formatOk)
+                return false;
+            layout.dataOffset = chunkData;
+            layout.frames = std::min(chunkSize, fileSize - chunkData) / layout.bytesPerFrame();
+            return true;
+        }
+
+        offset = chunkData + chunkSize + (chunkSize & 1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Decode the samples found every stride bytes
+ */
+static void decodeRawEncoding(const RawAudioLayout& layout, const unsigned char* samples, unsigned stride, absl::Span<float> output) noexcept
+{
+    switch (layout.encoding) {
+    case RawAudioLayout::Encoding::Int16:
+        decodeRawSamples(samples, stride, output, [](const unsigned char* p) {
+            return static_cast<int16_t>(readLE16(p)) * (1.0f / 32768.0f);
+        });
+        break;
+    case RawAudioLayout::Encoding::Int24:
+        decodeRawSamples(samples, stride, output, [](const unsigned char* p) {
+            const uint32_t bits = (static_cast<uint32_t>(p[0]) << 8)
+                | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 24);
+            return static_cast<float>(static_cast<int32_t>(bits)) * (1.0f / 2147483648.0f);
+        });
+        break;
+    case RawAudioLayout::Encoding::Int32:
+        decodeRawSamples(samples, stride, output, [](const unsigned char* p) {
+            return static_cast<float>(static_cast<int32_t>(readLE32(p))) * (1.0f / 2147483648.0f);
+        });
+        break;
+    case RawAudioLayout::Encoding::Float32:
+        decodeRawSamples(samples, stride, output, [](const unsigned char* p) {
+            float value;
+            std::memcpy(&value, p, sizeof(float));
+            return value;
+        });
+        break;
+    }
+}
+
+void decodeRawAudio(const RawAudioLayout& layout, const void* data, unsigned channel, absl::Span<float> output) noexcept
+{
+    const unsigned char* samples = static_cast<const unsigned char*>(data) + channel * layout.bytesPerSample;
+    decodeRawEncoding(layout, samples, layout.bytesPerFrame(), output);
+}
+
+void decodeRawAudio(const RawAudioLayout& layout, const void* data, size_t numFrames, float* output) noexcept
+{
+    const unsigned char* samples = static_cast<const unsigned char*>(data);
+    decodeRawEncoding(layout, samples, layout.bytesPerSample, absl::MakeSpan(output, numFrames * layout.channels));
+}
+
+void decodeRawAudio(const RawAudioLayout& layout, const void* data, size_t numFrames, float* const outputs[]) noexcept
+{
+    if (layout.channels == 2) {
+        const unsigned numSamples = static_cast<unsigned>(2 * numFrames);
+        switch (layout.encoding) {
+        case RawAudioLayout::Encoding::Int16:
+            readInterleavedInt16(static_cast<const int16_t*>(data), outputs[0], outputs[1], numSamples);
+            return;
+        case RawAudioLayout::Encoding::Int24:
+            readInterleavedInt24(static_cast<const uint8_t*>(data), outputs[0], outputs[1], numSamples);
+            return;
+        default:
+            break;
+        }
+    }
+
+    for (unsigned c = 0; c < layout.channels; ++c)
+        decodeRawAudio(layout, data, c, absl::MakeSpan(outputs[c], numFrames));
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Reader of uncompressed WAV files, which decodes the data of the file
+ * directly into the destination, in either direction
+ */
+class RawAudioReader : public AudioReader {
+public:
+    RawAudioReader(std::unique_ptr<AsyncFileIO::File> file, const RawAudioLayout& layout, std::unique_ptr<MetadataReader> mdReader, bool reverse);
+    AudioReaderType type() const override;
+    int format() const override { return st_audio_file_wav; }
+    int64_t frames() const override { return static_cast<int64_t>(layout_.frames); }
+    unsigned channels() const override { return layout_.channels; }
+    unsigned sampleRate() const override { return layout_.sampleRate; }
+    size_t readNextBlock(float* buffer, size_t frames) override;
+    size_t readNextFrames(float* const outputs[], size_t frames) override;
+    bool getInstrumentInfo(InstrumentInfo& instrument) override;
+    bool getWavetableInfo(WavetableInfo& wt) override;
+
+private:
+    /**
+     * @brief Read the data of the next frames, at most a chunk
+     *
+     * @param frames the maximal number of frames
+     * @return the number of frames read
+     */
+    size_t readChunk(size_t frames);
+
+    std::unique_ptr<AsyncFileIO::File> file_;
+    RawAudioLayout layout_;
+    std::unique_ptr<MetadataReader> mdReader_;
+    bool reverse_ { false };
+    uint64_t position_ { 0 }; // the frames read, or the frames left when reversed
+    std::vector<unsigned char> data_;
+};
+
+RawAudioReader::RawAudioReader(std::unique_ptr<AsyncFileIO::File> file, const RawAudioLayout& layout, std::unique_ptr<MetadataReader> mdReader, bool reverse)
+    : file_(std::move(file)), layout_(layout), mdReader_(std::move(mdReader)), reverse_(reverse)
+{
+    position_ = reverse ? layout.frames : 0;
+}
+
+AudioReaderType RawAudioReader::type() const
+{
+    return reverse_ ? AudioReaderType::Reverse : AudioReaderType::Forward;
+}
+
+size_t RawAudioReader::readChunk(size_t frames)
+{
+    const uint64_t framesLeft = reverse_ ? position_ : layout_.frames - position_;
+    const size_t numFrames = static_cast<size_t>(std::min<uint64_t>({ static_cast<uint64_t>(frames), kRawChunkFrames, framesLeft }));
+    if (numFrames == 0)
+        return 0;
+
+    const unsigned bytesPerFrame = layout_.bytesPerFrame();
+    const uint64_t firstFrame = reverse_ ? position_ - numFrames : position_;
+    data_.resize(numFrames * bytesPerFrame);
+    const int64_t numBytes = file_->read(layout_.dataOffset + firstFrame * bytesPerFrame, data_.data(), data_.size());
+    const size_t numFramesRead = numBytes > 0 ? static_cast<size_t>(numBytes) / bytesPerFrame : 0;
+
+    if (reverse_) {
+        // The frames go backwards from the position, they must all be there
+        if (numFramesRead < numFrames)
+            return 0;
+        position_ -= numFrames;
+    }
+    else
+        position_ += numFramesRead;
+
+    return numFramesRead;
+}
+
+size_t RawAudioReader::readNextBlock(float* buffer, size_t frames)
+{
+    const unsigned numChannels = layout_.channels;
+    size_t numFramesRead = 0;
+    while (numFramesRead < frames) {
+        const size_t numChunkFrames = readChunk(frames - numFramesRead);
+        if (numChunkFrames == 0)
+            break;
+
+        float* chunk = buffer + numFramesRead * numChannels;
+        decodeRawAudio(layout_, data_.data(), numChunkFrames, chunk);
+        if (reverse_)
+            reverse_frames(chunk, numChunkFrames, numChannels);
+        numFramesRead += numChunkFrames;
+    }
+    return numFramesRead;
+}
+
+size_t RawAudioReader::readNextFrames(float* const outputs[], size_t frames)
+{
+    const unsigned numChannels = layout_.channels;
+    size_t numFramesRead = 0;
+    while (numFramesRead < frames) {
+        const size_t numChunkFrames = readChunk(frames - numFramesRead);
+        if (numChunkFrames == 0)
+            break;
+
+        float* chunks[2];
+        for (unsigned c = 0; c < numChannels; ++c)
+            chunks[c] = outputs[c] + numFramesRead;
+        decodeRawAudio(layout_, data_.data(), numChunkFrames, chunks);
+        if (reverse_) {
+            for (unsigned c = 0; c < numChannels; ++c)
+                std::reverse(chunks[c], chunks[c] + numChunkFrames);
+        }
+        numFramesRead += numChunkFrames;
+    }
+    return numFramesRead;
+}
+
+bool RawAudioReader::getInstrumentInfo(InstrumentInfo& instrument)
+{
+    return extractInstrumentInfo(mdReader_.get(), instrument);
+}
+
+bool RawAudioReader::getWavetableInfo(WavetableInfo& wt)
+{
+    return extractWavetableInfo(mdReader_.get(), wt);
+}
+
+//------------------------------------------------------------------------------
+
 #if defined(SFIZZ_USE_SNDFILE)
 static bool formatHasFastSeeking(int format)
 {
@@ -389,6 +892,16 @@ static AudioReaderPtr createAudioReaderWithHandle(ST_AudioFile handle, std::uniq
 
 AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_code* ec)
 {
+    RawAudioLayout layout;
+    if (getRawAudioLayout(path, layout) && layout.frames > 0) {
+        if (auto file = AsyncFileIO::File::open(path)) {
+            if (ec)
+                ec->clear();
+            return AudioReaderPtr(new RawAudioReader(std::move(file), layout,
+                absl::make_unique<FileMetadataReader>(path), reverse));
+        }
+    }
+
     ST_AudioFile handle;
 #if defined(_WIN32)
     handle.open_file_w(path.wstring().c_str());
@@ -11,6 +11,7 @@
 #include <system_error>
 #include <memory>
 #include <cstdio>
+#include <vector>
 
 namespace sfz {
 struct InstrumentInfo;
@@ -24,7 +25,7 @@ enum class AudioReaderType {
     Forward,
     //! Reader in reverse direction
     Reverse,
-    //! Reader in reverse direction, operating on a whole file instead of seeking
+    //! Reader in reverse direction, seeking once per large chunk of frames
     NoSeekReverse,
 };
 
@@ -40,14 +41,27 @@ public:
     virtual unsigned channels() const = 0;
     virtual unsigned sampleRate() const = 0;
     virtual size_t readNextBlock(float* buffer, size_t frames) = 0;
+    /**
+     * @brief Read the next frames into separate channels. The default
+     * implementation reads interleaved frames and splits them.
+     *
+     * @param outputs the destination of each channel
+     * @param frames the number of frames to read
+     * @return the number of frames read
+     */
+    virtual size_t readNextFrames(float* const outputs[], size_t frames);
     virtual bool getInstrumentInfo(InstrumentInfo&) { return false; };
     virtual bool getWavetableInfo(WavetableInfo&) { return false; };
+
+private:
+    std::vector<float> interleaved_;
 };
 
 typedef std::unique_ptr<AudioReader> AudioReaderPtr;
 
 /**
- * @brief Create a file reader of detected type.
+ * @brief Create a file reader of detected type. The uncompressed WAV files
+ * get a reader which decodes their data directly into the destination.
  */
 AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_code* ec = nullptr);
 
@@ -56,4 +70,82 @@ AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_
  */
 AudioReaderPtr createAudioReaderFromMemory(const void* memory, size_t length, bool reverse, std::error_code* ec = nullptr);
 
+/**
+ * @brief Wrap a reader to resample its frames at another rate, with a
+ * high-quality windowed-sinc kernel. The wrapper reads forward only and has
+ * no metadata, since the positions of the metadata are in source frames.
+ *
+ * @param reader the reader of the source
+ * @param sampleRate the rate of the frames to read
+ * @return the wrapper, or the reader itself if it is already at this rate
+ */
+AudioReaderPtr createResamplingAudioReader(AudioReaderPtr reader, double sampleRate);
+
+/**
+ * @brief Get the number of frames of a file once resampled at another rate.
+ *
+ * @param frames the number of frames of the file
+ * @param sourceRate the rate of the file
+ * @param sampleRate the rate of the resampled frames
+ */
+int64_t getResampledFrames(int64_t frames, double sourceRate, double sampleRate);
+
+/**
+ * @brief Layout of the sample data of an uncompressed file, which can be read
+ * at any offset without a decoder.
+ */
+struct RawAudioLayout {
+    enum class Encoding { Int16, Int24, Int32, Float32 };
+    Encoding encoding { Encoding::Int16 };
+    unsigned channels { 0 };
+    unsigned bytesPerSample { 0 };
+    unsigned sampleRate { 0 };
+    uint64_t dataOffset { 0 };
+    uint64_t frames { 0 };
+
+    unsigned bytesPerFrame() const noexcept { return channels * bytesPerSample; }
+};
+
+/**
+ * @brief Locate the sample data of a PCM or float WAV file, of one or two
+ * channels. This fails for other files, or on big-endian hosts.
+ *
+ * @param path the file
+ * @param layout the layout, filled on success
+ * @return true if the file is uncompressed and has a supported layout
+ */
+bool getRawAudioLayout(const fs::path& path, RawAudioLayout& layout);
+
+/**
+ * @brief Decode a channel of uncompressed frames, in the same way as the
+ * readers do.
+ *
+ * @param layout the layout of the data
+ * @param data the interleaved frames, as in the file
+ * @param channel the channel to decode
+ * @param output the samples, as many as the frames to decode
+ */
+void decodeRawAudio(const RawAudioLayout& layout, const void* data, unsigned channel, absl::Span<float> output) noexcept;
+
+/**
+ * @brief Decode uncompressed frames into interleaved frames.
+ *
+ * @param layout the layout of the data
+ * @param data the interleaved frames, as in the file
+ * @param numFrames the number of frames to decode
+ * @param output the interleaved samples
+ */
+void decodeRawAudio(const RawAudioLayout& layout, const void* data, size_t numFrames, float* output) noexcept;
+
+/**
+ * @brief Decode uncompressed frames into separate channels. Stereo 16 and
+ * 24-bit frames convert and deinterleave in a single pass.
+ *
+ * @param layout the layout of the data
+ * @param data the interleaved frames, as in the file
+ * @param numFrames the number of frames to decode
+ * @param outputs the samples of each channel
+ */
+void decodeRawAudio(const RawAudioLayout& layout, const void* data, size_t numFrames, float* const outputs[]) noexcept;
+
 } // namespace sfz
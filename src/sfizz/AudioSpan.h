@@ -152,6 +152,7 @@ public:
             *thisSpan = newSpan->data();
             size = std::min(size, newSpan->size());
         }
+        numFrames = (spans.size() > 0) ? size : 0;
     }
 
     /**
@@ -165,8 +166,8 @@ public:
      * @tparam Alignment the alignment block size for the platform
      * @param audioBuffer the source AudioBuffer.
      */
-    template <class U, size_t N, unsigned int Alignment, size_t PaddingLeft, size_t PaddingRight, typename = typename std::enable_if<N <= MaxChannels>::type, typename = typename std::enable_if<std::is_const<U>::value, int>::type>
-    AudioSpan(AudioBuffer<U, N, Alignment, PaddingLeft, PaddingRight>& audioBuffer)
+    template <class U, size_t N, unsigned int Alignment, size_t PaddingLeft, size_t PaddingRight, class A, typename = typename std::enable_if<N <= MaxChannels>::type, typename = typename std::enable_if<std::is_const<U>::value, int>::type>
+    AudioSpan(AudioBuffer<U, N, Alignment, PaddingLeft, PaddingRight, A>& audioBuffer)
         : numFrames(audioBuffer.getNumFrames())
         , numChannels(audioBuffer.getNumChannels())
     {
@@ -186,8 +187,8 @@ public:
      * @tparam Alignment the alignment block size for the platform
      * @param audioBuffer the source AudioBuffer.
      */
-    template <class U, size_t N, unsigned int Alignment, size_t PaddingLeft, size_t PaddingRight, typename = std::enable_if<N <= MaxChannels>>
-    AudioSpan(AudioBuffer<U, N, Alignment, PaddingLeft, PaddingRight>& audioBuffer)
+    template <class U, size_t N, unsigned int Alignment, size_t PaddingLeft, size_t PaddingRight, class A, typename = std::enable_if<N <= MaxChannels>>
+    AudioSpan(AudioBuffer<U, N, Alignment, PaddingLeft, PaddingRight, A>& audioBuffer)
         : numFrames(audioBuffer.getNumFrames())
         , numChannels(audioBuffer.getNumChannels())
     {
@@ -373,7 +374,7 @@ public:
         ASSERT(other.getNumChannels() == numChannels);
         if (other.getNumChannels() == numChannels) {
             for (size_t i = 0; i < numChannels; ++i)
-                sfz::multiplyAdd(gain, other.getConstSpan(i), getSpan(i));
+                sfz::multiplyAdd1<Type>(gain, other.getConstSpan(i), getSpan(i));
         }
     }
 
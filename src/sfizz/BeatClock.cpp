@@ -9,6 +9,7 @@
 #include "Config.h"
 #include "utility/Debug.h"
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 
 namespace sfz {
@@ -79,6 +80,7 @@ void BeatClock::beginCycle(unsigned numFrames)
 {
     currentCycleFrames_ = numFrames;
     currentCycleFill_ = 0;
+    runningFill_ = 0;
     currentCycleStartPos_ = lastClientPos_;
 }
 
@@ -146,6 +148,7 @@ void BeatClock::setPlaying(unsigned delay, bool playing)
 absl::Span<const int> BeatClock::getRunningBeatNumber()
 {
     fillBufferUpTo(currentCycleFrames_);
+    fillSkippedFrames();
 
     return absl::MakeConstSpan(runningBeatNumber_.data(), currentCycleFrames_);
 }
@@ -153,6 +156,7 @@ absl::Span<const int> BeatClock::getRunningBeatNumber()
 absl::Span<const float> BeatClock::getRunningBeatPosition()
 {
     fillBufferUpTo(currentCycleFrames_);
+    fillSkippedFrames();
 
     return absl::MakeConstSpan(runningBeatPosition_.data(), currentCycleFrames_);
 }
@@ -165,12 +169,23 @@ double BeatClock::getLastBeatPosition() const
 absl::Span<const int> BeatClock::getRunningBeatsPerBar()
 {
     fillBufferUpTo(currentCycleFrames_);
+    fillSkippedFrames();
 
     return absl::MakeConstSpan(runningBeatsPerBar_.data(), currentCycleFrames_);
 }
 
 void BeatClock::fillBufferUpTo(unsigned delay)
 {
+    // already filled, do not touch the state; this makes the running
+    // buffers safe to read concurrently, once they are complete
+    if (currentCycleFill_ >= delay && !mustApplyHostPos_)
+        return;
+
+    if (numConsumers_ == 0) {
+        advanceUpTo(delay);
+        return;
+    }
+
     int *beatNumberData = runningBeatNumber_.data();
     float *beatNumberPosition = runningBeatPosition_.data();
     int *beatsPerBarData = runningBeatsPerBar_.data();
@@ -210,10 +225,63 @@ void BeatClock::fillBufferUpTo(unsigned delay)
 
 
     currentCycleFill_ = fillIdx;
+    runningFill_ = fillIdx;
     lastClientPos_ = clientPos;
     mustApplyHostPos_ = mustApplyHostPos;
 }
 
+void BeatClock::advanceUpTo(unsigned delay)
+{
+    const TimeSignature sig = timeSig_;
+    BBT clientPos = lastClientPos_;
+    bool mustApplyHostPos = mustApplyHostPos_;
+
+    if (!isPlaying_) {
+        clientPos = mustApplyHostPos ? lastHostPos_ : clientPos;
+        mustApplyHostPos = false;
+        currentCycleFill_ = std::max(currentCycleFill_, delay);
+    } else if (currentCycleFill_ < delay) {
+        // the frames of `fillBufferUpTo` at once, where the host position
+        // replaces the first one
+        unsigned numFrames = delay - currentCycleFill_;
+        if (mustApplyHostPos) {
+            clientPos = lastHostPos_;
+            mustApplyHostPos = false;
+            --numFrames;
+        }
+        clientPos = BBT::fromBeats(sig, clientPos.toBeats(sig) + numFrames * getBeatsPerFrame());
+        currentCycleFill_ = delay;
+    }
+
+    lastClientPos_ = clientPos;
+    mustApplyHostPos_ = mustApplyHostPos;
+}
+
+void BeatClock::fillSkippedFrames()
+{
+    if (runningFill_ >= currentCycleFill_)
+        return;
+
+    // The frames which the clock skipped without consumers, back from the
+    // current position at the current tempo. This is exact unless the tempo
+    // or the position changed in the cycle before the request.
+    int *beatNumberData = runningBeatNumber_.data();
+    float *beatNumberPosition = runningBeatPosition_.data();
+    int *beatsPerBarData = runningBeatsPerBar_.data();
+    const TimeSignature sig = timeSig_;
+    const double endBeats = lastClientPos_.toBeats(sig);
+    const double beatsPerFrame = isPlaying_ ? getBeatsPerFrame() : 0.0;
+
+    for (unsigned i = runningFill_; i < currentCycleFill_; ++i) {
+        const double beats = endBeats - (currentCycleFill_ - 1 - i) * beatsPerFrame;
+        beatNumberData[i] = dequantize<int>(quantize(beats));
+        beatNumberPosition[i] = static_cast<float>(beats);
+        beatsPerBarData[i] = sig.beatsPerBar;
+    }
+
+    runningFill_ = currentCycleFill_;
+}
+
 void BeatClock::calculatePhase(float beatPeriod, float* phaseOut)
 {
     const unsigned numFrames = currentCycleFrames_;
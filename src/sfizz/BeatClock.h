@@ -119,6 +119,20 @@ public:
      * Check whether the clock is currently ticking.
      */
     bool isPlaying() const noexcept { return isPlaying_; }
+    /**
+     * @brief Register a consumer of the running buffers, such as a tempo
+     * synced LFO. Without consumers, the clock only advances its position,
+     * and computes the buffers on demand when they are requested.
+     */
+    void registerConsumer() noexcept { ++numConsumers_; }
+    /**
+     * @brief Forget the registered consumers.
+     */
+    void clearConsumers() noexcept { numConsumers_ = 0; }
+    /**
+     * @brief Check whether consumers of the running buffers are registered.
+     */
+    bool hasConsumers() const noexcept { return numConsumers_ > 0; }
     /**
      * @brief Get the beat number for each frame of the current cycle.
      *
@@ -171,6 +185,8 @@ public:
 
 private:
     void fillBufferUpTo(unsigned delay);
+    void advanceUpTo(unsigned delay);
+    void fillSkippedFrames();
 
 private:
     double samplePeriod_ { 1.0 / config::defaultSampleRate };
@@ -185,6 +201,9 @@ private:
     // status of current cycle
     unsigned currentCycleFrames_ = 0;
     unsigned currentCycleFill_ = 0;
+    // frames of the running buffers written in the current cycle
+    unsigned runningFill_ = 0;
+    unsigned numConsumers_ = 0;
     BBT currentCycleStartPos_;
 
     // musical time information from host
@@ -97,6 +97,17 @@ private:
 
 
 
+/**
+ * @brief      The default allocation of the buffers, on the heap. An
+ *             allocator gives zeroed memory, and gets back the size it gave
+ *             with the memory to free.
+ */
+struct BufferAllocator
+{
+    static void* allocate(size_t bytes) noexcept { return std::calloc(bytes, 1); }
+    static void deallocate(void* pointer, size_t) noexcept { std::free(pointer); }
+};
+
 /**
  * @brief      A heap buffer structure that tries to align its beginning and
  *             adds a small offset at the end for alignment too.
@@ -110,8 +121,10 @@ private:
  * @tparam     Type       The buffer type
  * @tparam     Alignment  the required alignment in bytes (defaults to
  *                        config::defaultAlignment)
+ * @tparam     Allocator  the allocation of the memory (defaults to the heap)
  */
-template <class Type, unsigned int Alignment = config::defaultAlignment>
+template <class Type, unsigned int Alignment = config::defaultAlignment,
+          class Allocator = BufferAllocator>
 class Buffer {
 public:
     using value_type = typename std::remove_cv<Type>::type;
@@ -163,7 +176,7 @@ public:
         std::size_t oldSize = alignedSize;
 
         std::size_t tempSize = newSize + 2 * AlignmentMask; // To ensure that we have leeway at the beginning and at the end
-        Type* newData = reinterpret_cast<Type*>(std::calloc(tempSize, sizeof(value_type)));
+        Type* newData = reinterpret_cast<Type*>(Allocator::allocate(tempSize * sizeof(value_type)));
         if (newData == nullptr) {
             return false;
         }
@@ -173,10 +186,12 @@ public:
         else
             counter().newBuffer(tempSize * sizeof(value_type));
 
+        const std::size_t oldBytes = largerSize * sizeof(value_type);
         largerSize = tempSize;
         alignedSize = newSize;
         paddedData.release(); // realloc has invalidated the old pointer
         paddedData.reset(static_cast<pointer>(newData));
+        paddedData.get_deleter().bytes = tempSize * sizeof(value_type);
         normalData = static_cast<pointer>(align(Alignment, alignedSize, newData, tempSize));
         normalEnd = normalData + alignedSize;
         std::size_t endMisalignment = (alignedSize & TypeAlignmentMask);
@@ -186,7 +201,8 @@ public:
             _alignedEnd = normalEnd;
 
         std::memcpy(normalData, oldNormalData, std::min(newSize, oldSize) * sizeof(Type));
-        std::free(oldData);
+        if (oldData)
+            Allocator::deallocate(oldData, oldBytes);
 
         return true;
     }
@@ -232,7 +248,7 @@ public:
      *
      * @param other
      */
-    Buffer(const Buffer<Type, Alignment>& other)
+    Buffer(const Buffer& other)
     {
         resize(other.size());
         std::memcpy(this->data(), other.data(), other.size() * sizeof(value_type));
@@ -243,7 +259,7 @@ public:
      *
      * @param other
      */
-    Buffer(Buffer<Type, Alignment>&& other) noexcept
+    Buffer(Buffer&& other) noexcept
         : largerSize(other.largerSize),
           alignedSize(other.alignedSize),
           normalData(other.normalData),
@@ -254,7 +270,7 @@ public:
         other._clear();
     }
 
-    Buffer<Type, Alignment>& operator=(const Buffer<Type, Alignment>& other)
+    Buffer& operator=(const Buffer& other)
     {
         if (this != &other) {
             resize(other.size());
@@ -263,7 +279,7 @@ public:
         return *this;
     }
 
-    Buffer<Type, Alignment>& operator=(Buffer<Type, Alignment>&& other) noexcept
+    Buffer& operator=(Buffer&& other) noexcept
     {
         if (this != &other) {
             if (largerSize > 0)
@@ -313,7 +329,7 @@ private:
     static constexpr int TypeAlignment { Alignment / sizeof(value_type) };
     static constexpr int TypeAlignmentMask { TypeAlignment - 1 };
     static_assert(std::is_trivial<value_type>::value, "Type should be trivial");
-    static_assert(Alignment == 0 || Alignment == 4 || Alignment == 8 || Alignment == 16 || Alignment == 32, "Bad alignment value");
+    static_assert(Alignment == 0 || Alignment == 4 || Alignment == 8 || Alignment == 16 || Alignment == 32 || Alignment == 64, "Bad alignment value");
     static_assert(TypeAlignment * sizeof(value_type) == Alignment || !std::is_arithmetic<value_type>::value,
                   "The alignment does not appear to be divided by the size of the arithmetic Type");
     void* align(std::size_t alignment, std::size_t size, void *ptr, std::size_t &space)
@@ -327,7 +343,8 @@ private:
     }
 
     struct deleter {
-        void operator()(void *p) const noexcept { std::free(p); }
+        size_t bytes { 0 };
+        void operator()(void *p) const noexcept { Allocator::deallocate(p, bytes); }
     };
 
     size_type largerSize { 0 };
@@ -10,13 +10,12 @@
 #include "AudioBuffer.h"
 #include "AudioSpan.h"
 #include "utility/Debug.h"
-#include <array>
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <vector>
 #include "absl/algorithm/container.h"
-#ifndef NDEBUG
-#include "MathHelpers.h"
-#endif
 
 namespace sfz {
 
@@ -58,44 +57,72 @@ private:
     int* available { nullptr };
 };
 
+/**
+ * @brief The use of the pool since the last reset of the statistics.
+ * The high-water marks are the most buffers held at once, and the
+ * failures count the requests which could not be served.
+ */
+struct BufferPoolStats {
+    int maxBuffersUsed { 0 };
+    int maxStereoBuffersUsed { 0 };
+    int maxIndexBuffersUsed { 0 };
+    int numBufferFailures { 0 };
+    int numStereoBufferFailures { 0 };
+    int numIndexBufferFailures { 0 };
+};
+
 class BufferPool {
 public:
     BufferPool()
     {
-        for (auto& buffer : stereoBuffers) {
-            buffer.addChannels(2);
-        }
-        monoAvailable.resize(config::bufferPoolSize);
-        stereoAvailable.resize(config::stereoBufferPoolSize);
-        indexAvailable.resize(config::indexBufferPoolSize);
+        _setNumBuffers(config::bufferPoolSize, config::stereoBufferPoolSize, config::indexBufferPoolSize);
         _setBufferSize(config::defaultSamplesPerBlock);
     }
 
     void setBufferSize(unsigned bufferSize)
     {
-        ASSERT(absl::c_all_of(monoAvailable, [](int value) { return value == 1; }));
-        ASSERT(absl::c_all_of(indexAvailable, [](int value) { return value == 1; }));
-        ASSERT(absl::c_all_of(stereoAvailable, [](int value) { return value == 1; }));
+        ASSERT(allAvailable());
+        _setBufferSize(bufferSize);
+    }
+
+    /**
+     * @brief Set the number of buffers of each kind, which can be held at
+     * once. The pool never holds fewer than the sizes of the configuration.
+     * No buffer must be held while calling this; do not call it in the RT
+     * thread.
+     *
+     * @param numBuffers
+     * @param numStereoBuffers
+     * @param numIndexBuffers
+     */
+    void setNumBuffers(int numBuffers, int numStereoBuffers, int numIndexBuffers)
+    {
+        ASSERT(allAvailable());
+        _setNumBuffers(numBuffers, numStereoBuffers, numIndexBuffers);
         _setBufferSize(bufferSize);
     }
 
+    int getNumBuffers() const noexcept { return static_cast<int>(monoBuffers.size()); }
+    int getNumStereoBuffers() const noexcept { return static_cast<int>(stereoBuffers.size()); }
+    int getNumIndexBuffers() const noexcept { return static_cast<int>(indexBuffers.size()); }
+
     SpanHolder<absl::Span<float>> getBuffer(size_t numFrames)
     {
         const auto availableIt = absl::c_find(monoAvailable, 1);
         if (availableIt == monoAvailable.end()) {
             DBG("[sfizz] No free buffers available...");
+            numBufferFailures.fetch_add(1, std::memory_order_relaxed);
             return {};
         }
         const auto freeIndex = std::distance(monoAvailable.begin(), availableIt);
 
         if (monoBuffers[freeIndex].size() < numFrames) {
             DBG("[sfizz] Someone asked for a buffer of size " << numFrames << "; only " << monoBuffers[freeIndex].size() << " available...");
+            numBufferFailures.fetch_add(1, std::memory_order_relaxed);
             return {};
         }
 
-#ifndef NDEBUG
-        maxBuffersUsed = 1 + absl::c_count_if(monoAvailable, [](int value) { return value == 0; });
-#endif
+        updateHighWaterMark(maxBuffersUsed, monoAvailable);
         *availableIt -= 1;
         return { absl::MakeSpan(monoBuffers[freeIndex]).first(numFrames), &*availableIt };
     }
@@ -105,18 +132,18 @@ public:
         const auto availableIt = absl::c_find(indexAvailable, 1);
         if (availableIt == indexAvailable.end()) {
             DBG("[sfizz] No available index buffers in the pool");
+            numIndexBufferFailures.fetch_add(1, std::memory_order_relaxed);
             return {};
         }
         const auto freeIndex = std::distance(indexAvailable.begin(), availableIt);
 
         if (indexBuffers[freeIndex].size() < numFrames) {
             DBG("[sfizz] Someone asked for a index buffer of size " << numFrames << "; only " << indexBuffers[freeIndex].size() << " available...");
+            numIndexBufferFailures.fetch_add(1, std::memory_order_relaxed);
             return {};
         }
 
-#ifndef NDEBUG
-        maxIndexBuffersUsed = 1 + absl::c_count_if(indexAvailable, [](int value) { return value == 0; });
-#endif
+        updateHighWaterMark(maxIndexBuffersUsed, indexAvailable);
         *availableIt -= 1;
         return { absl::MakeSpan(indexBuffers[freeIndex]).first(numFrames), &*availableIt };
     }
@@ -126,34 +153,105 @@ public:
         const auto availableIt = absl::c_find(stereoAvailable, 1);
         if (availableIt == stereoAvailable.end()) {
             DBG("[sfizz] No available stereo buffers in the pool");
+            numStereoBufferFailures.fetch_add(1, std::memory_order_relaxed);
             return {};
         }
         const auto freeIndex = std::distance(stereoAvailable.begin(), availableIt);
 
         if (stereoBuffers[freeIndex].getNumFrames() < numFrames) {
             DBG("[sfizz] Someone asked for a stereo buffer of size " << numFrames << "; only " << stereoBuffers[freeIndex].getNumFrames() << " available...");
+            numStereoBufferFailures.fetch_add(1, std::memory_order_relaxed);
             return {};
         }
 
-#ifndef NDEBUG
-        maxStereoBuffersUsed = 1 + absl::c_count_if(stereoAvailable, [](int value) { return value == 0; });
-#endif
+        updateHighWaterMark(maxStereoBuffersUsed, stereoAvailable);
         *availableIt -= 1;
         return { sfz::AudioSpan<float>(stereoBuffers[freeIndex]).first(numFrames), &*availableIt };
     }
 
-#ifndef NDEBUG
-    ~BufferPool()
+    /**
+     * @brief Get the use of the pool since the last reset. It can be called
+     * from any thread.
+     *
+     * @return BufferPoolStats
+     */
+    BufferPoolStats getStats() const noexcept
     {
-        // DBG("Max buffers used: " << maxBuffersUsed);
-        // DBG("Max index buffers used: " << maxIndexBuffersUsed);
-        // DBG("Max stereo buffers used: " << maxStereoBuffersUsed);
+        BufferPoolStats stats;
+        stats.maxBuffersUsed = maxBuffersUsed.load(std::memory_order_relaxed);
+        stats.maxStereoBuffersUsed = maxStereoBuffersUsed.load(std::memory_order_relaxed);
+        stats.maxIndexBuffersUsed = maxIndexBuffersUsed.load(std::memory_order_relaxed);
+        stats.numBufferFailures = numBufferFailures.load(std::memory_order_relaxed);
+        stats.numStereoBufferFailures = numStereoBufferFailures.load(std::memory_order_relaxed);
+        stats.numIndexBufferFailures = numIndexBufferFailures.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**
+     * @brief Reset the high-water marks and the failures.
+     */
+    void resetStats() noexcept
+    {
+        maxBuffersUsed.store(0, std::memory_order_relaxed);
+        maxStereoBuffersUsed.store(0, std::memory_order_relaxed);
+        maxIndexBuffersUsed.store(0, std::memory_order_relaxed);
+        numBufferFailures.store(0, std::memory_order_relaxed);
+        numStereoBufferFailures.store(0, std::memory_order_relaxed);
+        numIndexBufferFailures.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the memory allocated for the buffers, in bytes
+     *
+     * @return size_t
+     */
+    size_t getMemoryUsage() const noexcept
+    {
+        size_t usage = 0;
+        for (const auto& buffer : monoBuffers)
+            usage += buffer.allocationSize() * sizeof(float);
+        for (const auto& buffer : indexBuffers)
+            usage += buffer.allocationSize() * sizeof(int);
+        for (const auto& buffer : stereoBuffers)
+            usage += buffer.getMemoryUsage();
+        return usage;
     }
-#endif
 
 private:
+    bool allAvailable() const noexcept
+    {
+        auto isFree = [](int value) { return value == 1; };
+        return absl::c_all_of(monoAvailable, isFree)
+            && absl::c_all_of(indexAvailable, isFree)
+            && absl::c_all_of(stereoAvailable, isFree);
+    }
+
+    // Only the thread which owns the pool writes the marks
+    static void updateHighWaterMark(std::atomic<int>& mark, const std::vector<int>& available) noexcept
+    {
+        const int used = 1 + static_cast<int>(absl::c_count(available, 0));
+        if (used > mark.load(std::memory_order_relaxed))
+            mark.store(used, std::memory_order_relaxed);
+    }
+
+    void _setNumBuffers(int numBuffers, int numStereoBuffers, int numIndexBuffers)
+    {
+        monoBuffers.resize(std::max(numBuffers, config::bufferPoolSize));
+        stereoBuffers.resize(std::max(numStereoBuffers, config::stereoBufferPoolSize));
+        indexBuffers.resize(std::max(numIndexBuffers, config::indexBufferPoolSize));
+        for (auto& buffer : stereoBuffers) {
+            if (buffer.getNumChannels() == 0)
+                buffer.addChannels(2);
+        }
+        monoAvailable.resize(monoBuffers.size());
+        stereoAvailable.resize(stereoBuffers.size());
+        indexAvailable.resize(indexBuffers.size());
+    }
+
     void _setBufferSize(unsigned bufferSize)
     {
+        this->bufferSize = bufferSize;
+
         for (auto& buffer : monoBuffers) {
             buffer.resize(bufferSize);
         }
@@ -171,16 +269,18 @@ private:
         absl::c_fill(indexAvailable, 1);
     }
 
-    std::array<sfz::Buffer<float>, config::bufferPoolSize> monoBuffers;
+    std::vector<sfz::Buffer<float>> monoBuffers;
     std::vector<int> monoAvailable;
-    std::array<sfz::Buffer<int>, config::bufferPoolSize> indexBuffers;
+    std::vector<sfz::Buffer<int>> indexBuffers;
     std::vector<int> indexAvailable;
-    std::array<sfz::AudioBuffer<float>, config::stereoBufferPoolSize> stereoBuffers;
+    std::vector<sfz::AudioBuffer<float>> stereoBuffers;
     std::vector<int> stereoAvailable;
-#ifndef NDEBUG
-    mutable int maxBuffersUsed { 0 };
-    mutable int maxIndexBuffersUsed { 0 };
-    mutable int maxStereoBuffersUsed { 0 };
-#endif
+    unsigned bufferSize { config::defaultSamplesPerBlock };
+    std::atomic<int> maxBuffersUsed { 0 };
+    std::atomic<int> maxStereoBuffersUsed { 0 };
+    std::atomic<int> maxIndexBuffersUsed { 0 };
+    std::atomic<int> numBufferFailures { 0 };
+    std::atomic<int> numStereoBufferFailures { 0 };
+    std::atomic<int> numIndexBufferFailures { 0 };
 };
 }
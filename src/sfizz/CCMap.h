@@ -117,6 +117,13 @@ public:
      */
     size_t size() const noexcept { return container.size(); }
 
+    /**
+     * @brief Memory allocated for the container, in bytes
+     *
+     * @return size_t
+     */
+    size_t getMemoryUsage() const noexcept { return container.capacity() * sizeof(CCData<ValueType>); }
+
     typename std::vector<CCData<ValueType>>::const_iterator begin() const { return container.cbegin(); }
     typename std::vector<CCData<ValueType>>::const_iterator end() const { return container.cend(); }
 
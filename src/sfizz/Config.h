@@ -27,13 +27,30 @@ namespace config {
     constexpr int stereoBufferPoolSize { 4 };
     constexpr int indexBufferPoolSize { 4 };
     constexpr int preloadSize { 8192 };
+    constexpr float minPreloadRatio { 0.25f }; // bounds of the preload size scaling by the playback speed
+    constexpr float maxPreloadRatio { 4.0f };
+    constexpr float hotPreloadRatio { 8.0f }; // bounds of the preload size of the files after their usage profile
+    constexpr float coldPreloadRatio { 0.25f };
     constexpr bool loadInRam { false };
+    constexpr bool memoryMapped { false };
+    constexpr bool encodedInRam { false }; // keep the streamed files encoded in memory, and decode them from there
+    constexpr bool compactSamples { false };
+    constexpr bool resampleSamples { false }; // resample the files at the engine rate as they load
+    constexpr bool deduplicateSamples { false }; // share the data of the files with identical contents
+    constexpr unsigned loadingParallelism { 4 };
+    constexpr unsigned includePrefetchThreads { 4 }; // threads reading the included sfz files ahead of the parse
+    constexpr uint32_t swapWaitPeriod { 10 }; // milliseconds between checks for a canceled swap
     constexpr int loggerQueueSize { 256 };
     constexpr int voiceLoggerQueueSize { 256 };
     constexpr bool loggingEnabled { false };
     constexpr size_t maxChannels { 32 };
     constexpr int numBackgroundThreads { 4 };
     constexpr unsigned fileClearingPeriod { 5 }; // in seconds
+    constexpr unsigned memoryBudgetPeriod { 250 }; // milliseconds between collections when over a memory budget
+    constexpr unsigned traceQueueSize { 8192 }; // events of the timing traces waiting to be written
+    constexpr unsigned traceDrainPeriod { 20 }; // milliseconds between the writes of the timing traces
+    constexpr int voiceTimingPeriod { 1 }; // blocks between the timings of the voice stages
+    constexpr uint32_t minPreloadSize { 4096 }; // frames kept preloaded past the offsets when over a memory budget
     constexpr int numVoices { 64 };
     constexpr unsigned maxVoices { 256 };
     constexpr unsigned smoothingSteps { 512 };
@@ -56,14 +73,30 @@ namespace config {
     constexpr float powerFollowerAttackTime { 5e-3f };
     constexpr float powerFollowerReleaseTime { 200e-3f };
     constexpr uint16_t numCCs { 512 };
+    constexpr int numPrograms { 128 };
     constexpr int maxCurves { 256 };
     constexpr int fileChunkSize { 1024 };
+    constexpr int streamSliceSize { 16 * fileChunkSize }; // frames streamed before yielding to more urgent files
+    constexpr bool asyncStreaming { true }; // read the uncompressed files with the asynchronous I/O of the system
+    constexpr int maxReadaheadFiles { 256 }; // the streamed files kept open, which the system is told to read ahead as their players start
+    constexpr uint32_t readaheadBytes { 256 * 1024 }; // the bytes after the preload read ahead
+    constexpr unsigned asyncQueueDepth { 64 }; // slices of uncompressed files read at once
+    constexpr uint32_t streamingWindow { 0 }; // frames kept ahead of the play head by the bounded streams, 0 to stream whole files
+    constexpr uint32_t minStreamingWindow { 2 * streamSliceSize };
+    constexpr int streamReleaseMargin { 4 * fileChunkSize }; // frames kept behind the play head by the bounded streams
+    constexpr double prewarmDelay { 1.0 }; // seconds after which the release samples streamed at note-on are due
     constexpr int processChunkSize { 16 };
     constexpr unsigned int defaultAlignment { 16 };
+    constexpr size_t sampleSlabSize { 2 << 20 }; // a huge page, shared by the small sample buffers
+    constexpr size_t minSampleBlockSize { 4096 }; // the smallest block of a slab
     constexpr int filtersInPool { maxVoices * 2 };
     constexpr int excessFileFrames { 64 };
+    constexpr int compactConversionFrames { 256 }; // frames converted at once from the compact storage when playing
+    constexpr size_t sampleEnvelopeResolution { 512 }; // frames of the data per window of the RMS and peak envelopes of the samples
     constexpr int maxLFOSubs { 8 };
     constexpr int maxLFOSteps { 128 };
+    constexpr int maxSharedLFOs { 16 }; // LFO outputs shared across the voices in a cycle
+    constexpr int modControlInterval { 16 }; // frames between the points of the control-rate modulation targets
     /**
      * @brief The threshold for age stealing.
      *        In percentage of the voice's max age.
@@ -74,7 +107,21 @@ namespace config {
      *        In percentage of the sum of all powers.
      */
     constexpr float stealingPowerCoeff { 0.5f };
+    /**
+     * @brief The synths which may share a voice budget.
+     */
+    constexpr int maxVoiceBudgetMembers { 64 };
+    /**
+     * @brief The real-time violations reported with a backtrace, in the
+     * builds with SFIZZ_RT_CHECKS.
+     */
+    constexpr int realtimeGuardReports { 16 };
     constexpr int filtersPerVoice { 2 };
+    /**
+     * @brief The last frames of a block which an open lowpass filter still
+     * processes while it passes the block through, to keep its state.
+     */
+    constexpr unsigned filterPassthroughFrames { 16 };
     constexpr int eqsPerVoice { 3 };
     constexpr int oscillatorsPerVoice { 9 };
     constexpr float uniformNoiseBounds { 1.0f };
@@ -84,6 +131,24 @@ namespace config {
        modulated filter. The lower, the more CPU resources are consumed.
     */
     constexpr int filterControlInterval { 16 };
+    /**
+       Frames of the tiles in which a voice applies its gain, pan and filters
+       over a large block, so that its buffer stays in the data cache between
+       the stages.
+    */
+    constexpr int voiceTileSize { 256 };
+    /**
+       Resolution of the tabulated coefficients of the filters, in steps of
+       cutoff per octave and of resonance per decibel. The tables interpolate
+       with cubic Hermite splines.
+    */
+    constexpr int filterTableStepsPerOctave { 32 };
+    constexpr int filterTableStepsPerDecibel { 2 };
+    /**
+       Number of designs of filter coefficients which the voices of a block
+       share, in each render lane. The cache is direct-mapped.
+    */
+    constexpr unsigned filterCoefficientCacheSize { 64 };
     /**
        Amplitude below which an exponential releasing envelope is considered as
        finished.
@@ -103,6 +168,17 @@ namespace config {
        Limit of how many "fxN" buses are accepted (in SFZv2, maximum is 4)
      */
     constexpr int maxEffectBuses { 256 };
+    /**
+       Highest oversampling factor of the effects, reached at the highest
+       effect quality
+     */
+    constexpr int maxEffectOversampling { 8 };
+    /**
+       Taps of the direct head of the convolution, which are the size of its
+       early partitions as well, and size of its late partitions
+     */
+    constexpr unsigned convolutionHeadSize { 128 };
+    constexpr unsigned convolutionTailPartitionSize { 2048 };
     // Wavetable constants; amplitude values are matched to reference
     static constexpr unsigned tableSize = 1024;
     static constexpr double tableRefSampleRate = 44100.0 * 1.1; // +10% aliasing permissivity
@@ -123,6 +199,26 @@ namespace config {
        Background file loading
      */
     static constexpr int backgroundLoaderPthreadPriority = 50; // expressed in %
+    /**
+       Multi-threaded voice rendering
+     */
+    static constexpr int renderThreadPthreadPriority = 90; // expressed in %
+    static constexpr int maxRenderThreads = 16;
+    static constexpr int minVoicesPerRenderThread = 4;
+    /**
+       @brief Number of consecutive blocks a released voice must stay under
+       the culling threshold before being ended
+     */
+    static constexpr int voiceCullingBlocks = 4;
+    /**
+       Quality governor: ratios of callback duration to block duration over
+       which the quality of new voices is lowered, and under which it is raised
+     */
+    static constexpr double qualityGovernorHighLoad = 0.75;
+    static constexpr double qualityGovernorLowLoad = 0.4;
+    static constexpr double qualityGovernorReleaseFactor = 0.05;
+    static constexpr int qualityGovernorHoldBlocks = 16;
+    static constexpr int qualityGovernorMaxSteps = 8;
     /**
        @brief Ratio to target under which smoothing is considered as completed
      */
@@ -164,6 +260,36 @@ namespace config {
      *
      */
     constexpr unsigned delayedReleaseVoices { 16 };
+    /**
+     * @brief Level under which the inputs and outputs of an effect bus are
+     * considered silent, to suspend its effects, and under which the strings
+     * of the resonator stop running
+     *
+     */
+    constexpr float effectSilenceThreshold { 1e-5f };
+    /**
+     * @brief Size of the argument buffer to decode the messages of a bundle,
+     * on the stack of the caller
+     *
+     */
+    constexpr unsigned maxBundleMessageArgsSize { 1024 };
+    /**
+     * @brief Highest rate of the broadcasts of a subscribed path, and rate
+     * at which the subscription thread checks for changes, in Hz
+     *
+     */
+    constexpr int maxSubscriptionRate { 100 };
+    /**
+     * @brief Adaptive preloading: the percentile of the measured streaming
+     * latencies which the preloaded heads cover, the margin over it, the
+     * latencies measured before adapting, and the change of the covered
+     * latency by which the heads resize
+     *
+     */
+    constexpr double adaptivePreloadPercentile { 0.99 };
+    constexpr double adaptivePreloadMargin { 2.0 };
+    constexpr uint32_t adaptivePreloadMinMeasures { 32 };
+    constexpr double adaptivePreloadHysteresis { 1.5 };
 } // namespace config
 
 } // namespace sfz
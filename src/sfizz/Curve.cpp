@@ -9,6 +9,7 @@
 #include "SIMDHelpers.h"
 #include "utility/Debug.h"
 #include <spline/spline.h>
+#include <simde/x86/sse2.h>
 #include <cmath>
 
 namespace sfz
@@ -149,6 +150,39 @@ Curve Curve::buildFromPoints(const float points[NumValues])
     return curve;
 }
 
+void Curve::evalSpan(absl::Span<const float> in, absl::Span<float> out) const noexcept
+{
+    CHECK_SPAN_SIZES(in, out);
+    const size_t size = minSpanSize(in, out);
+    const float* points = _points.data();
+    size_t i = 0;
+
+    // The indices and the fractions go by vectors, the lookups by elements.
+    // The last segment takes the end of the domain, so the second point
+    // stays within the table.
+    const simde__m128 scale = simde_mm_set1_ps(127.0f);
+    const simde__m128 zero = simde_mm_setzero_ps();
+    const simde__m128 last = simde_mm_set1_ps(127.0f);
+    const simde__m128 lastSegment = simde_mm_set1_ps(126.0f);
+    for (; i + 4 <= size; i += 4) {
+        simde__m128 x = simde_mm_mul_ps(simde_mm_loadu_ps(&in[i]), scale);
+        x = simde_mm_max_ps(simde_mm_min_ps(x, last), zero);
+        const simde__m128i index = simde_mm_cvttps_epi32(simde_mm_min_ps(x, lastSegment));
+        const simde__m128 mu = simde_mm_sub_ps(x, simde_mm_cvtepi32_ps(index));
+
+        alignas(16) int32_t indices[4];
+        simde_mm_store_si128(reinterpret_cast<simde__m128i*>(indices), index);
+        const simde__m128 y1 = simde_mm_setr_ps(
+            points[indices[0]], points[indices[1]], points[indices[2]], points[indices[3]]);
+        const simde__m128 y2 = simde_mm_setr_ps(
+            points[indices[0] + 1], points[indices[1] + 1], points[indices[2] + 1], points[indices[3] + 1]);
+        simde_mm_storeu_ps(&out[i], simde_mm_add_ps(y1, simde_mm_mul_ps(mu, simde_mm_sub_ps(y2, y1))));
+    }
+
+    for (; i < size; ++i)
+        out[i] = evalNormalized(in[i]);
+}
+
 const Curve& Curve::getDefault()
 {
     return defaultCurve;
@@ -50,6 +50,12 @@ public:
         return evalCC7(value * 127.0f);
     }
 
+    /**
+     * @brief Compute the curve for a span of real x in domain [0:1]
+     * `in` and `out` may refer to identical buffers, for in-place processing
+     */
+    void evalSpan(absl::Span<const float> in, absl::Span<float> out) const noexcept;
+
     /**
      * @brief Kind of curve interpolator
      */
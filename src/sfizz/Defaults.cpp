@@ -167,6 +167,8 @@ Int32Spec sampleQuality { 2, {0, 10}, 0 };
 Int32Spec oscillatorQuality { 1, {0, 3}, 0 };
 Int32Spec freewheelingSampleQuality { 10, {0, 10}, 0 };
 Int32Spec freewheelingOscillatorQuality { 3, {0, 3}, 0 };
+Int32Spec effectQuality { 3, {0, 3}, 0 };
+Int32Spec freewheelingEffectQuality { 3, {0, 3}, 0 };
 Int32Spec octaveOffset { 0, {-10, 10}, kPermissiveBounds };
 Int32Spec noteOffset { 0, {-127, 127}, kPermissiveBounds };
 
@@ -180,16 +182,23 @@ FloatSpec apanLevel { 0.0f, {0.0f, 100.0f}, kNormalizePercent };
 FloatSpec distoTone { 100.0f, {0.0f, 100.0f}, 0 };
 FloatSpec distoDepth { 0.0f, {0.0f, 100.0f}, 0 };
 UInt32Spec distoStages { 1, {1, maxDistoStages}, 0 };
+Int32Spec distoOversampling { 8, {1, config::maxEffectOversampling}, kEnforceBounds };
 FloatSpec compAttack { 0.005f, {0.0f, 10.0f}, 0 };
 FloatSpec compRelease { 0.05f, {0.0f, 10.0f}, 0 };
 BoolSpec compSTLink { false, {0, 1}, 0 };
 FloatSpec compThreshold { 0.0f, {-100.0f, 0.0f}, 0 };
 FloatSpec compRatio { 1.0f, {1.0f, 50.0f}, 0 };
 FloatSpec compGain { 0.0f, {-100.0f, 100.0f}, kDb2Mag };
+Int32Spec compOversampling { 2, {1, config::maxEffectOversampling}, kEnforceBounds };
+Int32Spec limiterOversampling { 2, {1, config::maxEffectOversampling}, kEnforceBounds };
 FloatSpec fverbSize { 0.0f, {0.0f, 100.0f}, 0 };
 FloatSpec fverbPredelay { 0.0f, {0.0f, 10.0f}, 0 };
 FloatSpec fverbTone { 100.0f, {0.0f, 100.0f}, 0 };
 FloatSpec fverbDamp { 0.0f, {0.0f, 100.0f}, 0 };
+Int32Spec fverbQuality { 2, {0, 2}, kEnforceBounds };
+FloatSpec convDry { 0.0f, {0.0f, 100.0f}, kNormalizePercent };
+FloatSpec convWet { 100.0f, {0.0f, 100.0f}, kNormalizePercent };
+FloatSpec convGain { 0.0f, {-100.0f, 100.0f}, kDb2Mag };
 BoolSpec gateSTLink { false, {0, 1}, 0 };
 FloatSpec gateAttack { 0.005f, {0.0f, 10.0f}, 0 };
 FloatSpec gateRelease { 0.05f, {0.0f, 10.0f}, 0 };
@@ -200,9 +209,21 @@ FloatSpec lofiDecim { 0.0f, {0.0f, 100.0f}, 0 };
 FloatSpec rectify { 0.0f, {0.0f, 100.0f}, 0 };
 UInt32Spec stringsNumber { maxStrings, {0, maxStrings}, 0 };
 BoolSpec sustainCancelsRelease { false, {0, 1}, kEnforceBounds };
+FloatSpec voiceCullingThreshold { -144.0f, {-144.0f, 0.0f}, kEnforceBounds };
+BoolSpec qualityGovernor { false, {0, 1}, kEnforceBounds };
+BoolSpec adaptiveSampleQuality { false, {0, 1}, kEnforceBounds };
+BoolSpec releasePrewarming { false, {0, 1}, kEnforceBounds };
+BoolSpec tabulatedFilters { false, {0, 1}, kEnforceBounds };
+BoolSpec controlRateModulations { false, {0, 1}, kEnforceBounds };
+UInt32Spec powerFollowerStride { 1, {1, 64}, kEnforceBounds };
 FloatSpec loTimer { 0.0f, {0.0f, float_max}, 0 };
 FloatSpec hiTimer { float_max, {0.0f, float_max}, 0 };
 BoolSpec ramBased { false, {0, 1}, kEnforceBounds };
+BoolSpec memoryMapped { false, {0, 1}, kEnforceBounds };
+BoolSpec encodedInRam { false, {0, 1}, kEnforceBounds };
+BoolSpec compactSamples { false, {0, 1}, kEnforceBounds };
+BoolSpec resampleSamples { false, {0, 1}, kEnforceBounds };
+BoolSpec deduplicateSamples { false, {0, 1}, kEnforceBounds };
 
 ESpec<Trigger> trigger { Trigger::attack, {Trigger::attack, Trigger::release_key}, 0};
 ESpec<CrossfadeCurve> crossfadeCurve { CrossfadeCurve::power, {CrossfadeCurve::gain, CrossfadeCurve::power}, 0};
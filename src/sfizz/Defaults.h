@@ -324,6 +324,8 @@ namespace Default
     extern const OpcodeSpec<int32_t> sampleQuality;
     extern const OpcodeSpec<int32_t> freewheelingSampleQuality;
     extern const OpcodeSpec<int32_t> freewheelingOscillatorQuality;
+    extern const OpcodeSpec<int32_t> effectQuality; // oversampling of the effects up to 2^quality
+    extern const OpcodeSpec<int32_t> freewheelingEffectQuality;
     extern const OpcodeSpec<int32_t> octaveOffset;
     extern const OpcodeSpec<int32_t> noteOffset;
     extern const OpcodeSpec<float> effect;
@@ -335,16 +337,23 @@ namespace Default
     extern const OpcodeSpec<float> distoTone;
     extern const OpcodeSpec<float> distoDepth;
     extern const OpcodeSpec<uint32_t> distoStages;
+    extern const OpcodeSpec<int32_t> distoOversampling;
     extern const OpcodeSpec<float> compAttack;
     extern const OpcodeSpec<float> compRelease;
     extern const OpcodeSpec<float> compThreshold;
     extern const OpcodeSpec<bool> compSTLink;
     extern const OpcodeSpec<float> compRatio;
     extern const OpcodeSpec<float> compGain;
+    extern const OpcodeSpec<int32_t> compOversampling;
+    extern const OpcodeSpec<int32_t> limiterOversampling;
     extern const OpcodeSpec<float> fverbSize;
     extern const OpcodeSpec<float> fverbPredelay;
     extern const OpcodeSpec<float> fverbTone;
     extern const OpcodeSpec<float> fverbDamp;
+    extern const OpcodeSpec<int32_t> fverbQuality; // 0: quarter rate, 1: half rate, 2: full rate
+    extern const OpcodeSpec<float> convDry;
+    extern const OpcodeSpec<float> convWet;
+    extern const OpcodeSpec<float> convGain;
     extern const OpcodeSpec<float> gateAttack;
     extern const OpcodeSpec<float> gateRelease;
     extern const OpcodeSpec<bool> gateSTLink;
@@ -363,9 +372,21 @@ namespace Default
     extern const OpcodeSpec<FilterType> filter;
     extern const OpcodeSpec<EqType> eq;
     extern const OpcodeSpec<bool> sustainCancelsRelease;
+    extern const OpcodeSpec<float> voiceCullingThreshold;
+    extern const OpcodeSpec<bool> qualityGovernor;
+    extern const OpcodeSpec<bool> adaptiveSampleQuality;
+    extern const OpcodeSpec<bool> releasePrewarming;
+    extern const OpcodeSpec<bool> tabulatedFilters;
+    extern const OpcodeSpec<bool> controlRateModulations;
+    extern const OpcodeSpec<uint32_t> powerFollowerStride;
     extern const OpcodeSpec<float> loTimer;
     extern const OpcodeSpec<float> hiTimer;
     extern const OpcodeSpec<bool> ramBased;
+    extern const OpcodeSpec<bool> memoryMapped;
+    extern const OpcodeSpec<bool> encodedInRam;
+    extern const OpcodeSpec<bool> compactSamples;
+    extern const OpcodeSpec<bool> resampleSamples;
+    extern const OpcodeSpec<bool> deduplicateSamples;
 
     // Default/max count for objects
     constexpr int numEQs { 3 };
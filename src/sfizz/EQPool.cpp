@@ -1,93 +1,159 @@
 #include "EQPool.h"
 #include "Region.h"
 #include "Resources.h"
-#include "BufferPool.h"
 #include "SIMDHelpers.h"
 #include "utility/SwapAndPop.h"
 #include <absl/algorithm/container.h>
+#include <algorithm>
 #include <thread>
 
 sfz::EQHolder::EQHolder(Resources& resources)
 : resources(resources)
 {
-    eq = absl::make_unique<FilterEq>();
-    eq->init(config::defaultSampleRate);
+    band.init(config::defaultSampleRate);
+}
+
+size_t sfz::EQHolder::getMemoryUsage() const noexcept
+{
+    return sizeof(EQHolder);
 }
 
 void sfz::EQHolder::reset()
 {
-    eq->clear();
+    band.clear();
     prepared = false;
 }
 
-void sfz::EQHolder::setup(const Region& region, unsigned eqId, float velocity)
+sfz::EQHolder::Targets sfz::EQHolder::findTargets(const ModMatrix& mm, const Region& region, unsigned eqId)
+{
+    Targets targets;
+    targets.gain = mm.findTarget(ModKey::createNXYZ(ModId::EqGain, region.id, eqId));
+    targets.bandwidth = mm.findTarget(ModKey::createNXYZ(ModId::EqBandwidth, region.id, eqId));
+    targets.frequency = mm.findTarget(ModKey::createNXYZ(ModId::EqFrequency, region.id, eqId));
+    return targets;
+}
+
+void sfz::EQHolder::setup(const Region& region, unsigned eqId, const Targets& targets, float velocity)
 {
     ASSERT(velocity >= 0.0f && velocity <= 1.0f);
     ASSERT(eqId < region.equalizers.size());
 
     this->description = &region.equalizers[eqId];
-    eq->setType(description->type);
-    eq->setChannels(region.isStereo() ? 2 : 1);
+    band.setType(description->type);
+    numChannels = region.isStereo() ? 2 : 1;
 
     // Setup the base values
     baseFrequency = description->frequency + velocity * description->vel2frequency;
     baseBandwidth = description->bandwidth;
     baseGain = description->gain + velocity * description->vel2gain;
 
-    const ModMatrix& mm = resources.getModMatrix();
-    gainTarget = mm.findTarget(ModKey::createNXYZ(ModId::EqGain, region.id, eqId));
-    bandwidthTarget = mm.findTarget(ModKey::createNXYZ(ModId::EqBandwidth, region.id, eqId));
-    frequencyTarget = mm.findTarget(ModKey::createNXYZ(ModId::EqFrequency, region.id, eqId));
+    gainTarget = targets.gain;
+    bandwidthTarget = targets.bandwidth;
+    frequencyTarget = targets.frequency;
 
     // Disables smoothing of the parameters on the first call
     prepared = false;
 }
 
-void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numFrames)
+bool sfz::EQHolder::fetchModulations() noexcept
 {
-    if (description == nullptr) {
-        for (unsigned channelIdx = 0; channelIdx < eq->channels(); channelIdx++)
-            copy<float>({ inputs[channelIdx], numFrames }, { outputs[channelIdx], numFrames });
-        return;
-    }
-
     ModMatrix& mm = resources.getModMatrix();
-    BufferPool& bufferPool = resources.getBufferPool();
-    auto frequencySpan = bufferPool.getBuffer(numFrames);
-    auto bandwidthSpan = bufferPool.getBuffer(numFrames);
-    auto gainSpan = bufferPool.getBuffer(numFrames);
+    bool frequencyConstant;
+    bool bandwidthConstant;
+    bool gainConstant;
+    frequencyMod = mm.getModulation(frequencyTarget, frequencyConstant);
+    bandwidthMod = mm.getModulation(bandwidthTarget, bandwidthConstant);
+    gainMod = mm.getModulation(gainTarget, gainConstant);
+    return (!frequencyMod || frequencyConstant) && (!bandwidthMod || bandwidthConstant) && (!gainMod || gainConstant);
+}
 
-    if (!frequencySpan || !bandwidthSpan || !gainSpan)
-        return;
+void sfz::EQHolder::updateParameters(unsigned frame) noexcept
+{
+    const float frequency = frequencyMod ? (baseFrequency + frequencyMod[frame]) : baseFrequency;
+    const float bandwidth = bandwidthMod ? (baseBandwidth + bandwidthMod[frame]) : baseBandwidth;
+    const float gain = gainMod ? (baseGain + gainMod[frame]) : baseGain;
 
-    fill<float>(*frequencySpan, baseFrequency);
-    if (float* mod = mm.getModulation(frequencyTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *frequencySpan);
+    if (!prepared) {
+        band.prepare(frequency, bandwidth, gain);
+        prepared = true;
+    }
 
-    fill<float>(*bandwidthSpan, baseBandwidth);
-    if (float* mod = mm.getModulation(bandwidthTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *bandwidthSpan);
+    band.setParameters(frequency, bandwidth, gain);
+}
 
-    fill<float>(*gainSpan, baseGain);
-    if (float* mod = mm.getModulation(gainTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *gainSpan);
+void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numFrames)
+{
+    EQHolder* self = this;
+    processCascade(&self, 1, inputs, outputs, numFrames);
+}
 
-    if (!prepared) {
-        eq->prepare(frequencySpan->front(), bandwidthSpan->front(), gainSpan->front());
-        prepared = true;
+void sfz::EQHolder::processCascade(EQHolder* const eqs[], unsigned numEqs, const float* const inputs[], float* const outputs[], unsigned numFrames)
+{
+    if (numEqs == 0)
+        return;
+
+    const unsigned numChannels = eqs[0]->numChannels;
+
+    // The EQs which are not set up pass through
+    EqBand* bands[EqCascade::maxBandsPerPass];
+    EQHolder* holders[EqCascade::maxBandsPerPass];
+    const float* const* groupInputs = inputs;
+
+    unsigned first = 0;
+    while (first < numEqs) {
+        unsigned numBands = 0;
+        bool constant = true;
+        for (; first < numEqs && numBands < EqCascade::maxBandsPerPass; ++first) {
+            EQHolder* eq = eqs[first];
+            if (eq->description == nullptr)
+                continue;
+            constant = eq->fetchModulations() && constant;
+            holders[numBands] = eq;
+            bands[numBands] = &eq->band;
+            ++numBands;
+        }
+
+        if (numBands == 0)
+            break;
+
+        // Constant parameters are set once for the block, others at each
+        // control point
+        if (constant) {
+            for (unsigned b = 0; b < numBands; ++b)
+                holders[b]->updateParameters(0);
+            EqCascade::process(bands, numBands, groupInputs, outputs, numChannels, numFrames);
+        } else {
+            unsigned frame = 0;
+            while (frame < numFrames) {
+                const unsigned current = std::min<unsigned>(numFrames - frame, config::filterControlInterval);
+                const float* currentInputs[2];
+                float* currentOutputs[2];
+                for (unsigned c = 0; c < numChannels; ++c) {
+                    currentInputs[c] = groupInputs[c] + frame;
+                    currentOutputs[c] = outputs[c] + frame;
+                }
+
+                for (unsigned b = 0; b < numBands; ++b)
+                    holders[b]->updateParameters(frame);
+                EqCascade::process(bands, numBands, currentInputs, currentOutputs, numChannels, current);
+
+                frame += current;
+            }
+        }
+
+        // The next group goes in place
+        groupInputs = outputs;
     }
 
-    eq->processModulated(
-        inputs,
-        outputs,
-        frequencySpan->data(),
-        bandwidthSpan->data(),
-        gainSpan->data(),
-        numFrames
-    );
+    if (groupInputs == inputs) {
+        for (unsigned c = 0; c < numChannels; ++c) {
+            if (inputs[c] != outputs[c])
+                copy<float>({ inputs[c], numFrames }, { outputs[c], numFrames });
+        }
+    }
 }
 
 void sfz::EQHolder::setSampleRate(float sampleRate)
 {
-    eq->init(static_cast<double>(sampleRate));
+    band.init(static_cast<double>(sampleRate));
 }
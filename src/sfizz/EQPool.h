@@ -1,5 +1,5 @@
 #pragma once
-#include "SfzFilter.h"
+#include "EqCascade.h"
 #include "Defaults.h"
 #include "modulations/ModMatrix.h"
 #include <vector>
@@ -15,14 +15,31 @@ class EQHolder
 public:
     EQHolder() = delete;
     EQHolder(Resources& resources);
+    /**
+     * @brief The modulation targets of an EQ of a region
+     */
+    struct Targets {
+        ModMatrix::TargetId gain;
+        ModMatrix::TargetId frequency;
+        ModMatrix::TargetId bandwidth;
+    };
+    /**
+     * @brief Find the modulation targets of an EQ of a region
+     *
+     * @param mm
+     * @param region
+     * @param eqId          the EQ index in the region
+     */
+    static Targets findTargets(const ModMatrix& mm, const Region& region, unsigned eqId);
     /**
      * @brief Setup a new EQ from a region and an index
      *
      * @param description   the region from which we take the EQ
      * @param eqId          the EQ index in the region
+     * @param targets       the modulation targets of the EQ, as of findTargets()
      * @param description   the triggering velocity/value
      */
-    void setup(const Region& region, unsigned eqId, float velocity);
+    void setup(const Region& region, unsigned eqId, const Targets& targets, float velocity);
     /**
      * @brief Process a block of stereo inputs
      *
@@ -31,6 +48,18 @@ public:
      * @param numFrames
      */
     void process(const float** inputs, float** outputs, unsigned numFrames);
+
+    /**
+     * @brief Process the EQs of a voice in a cascade, in a single pass over
+     * the block for all of them
+     *
+     * @param eqs
+     * @param numEqs
+     * @param inputs
+     * @param outputs
+     * @param numFrames
+     */
+    static void processCascade(EQHolder* const eqs[], unsigned numEqs, const float* const inputs[], float* const outputs[], unsigned numFrames);
     /**
      * @brief Set the sample rate for the EQ
      *
@@ -41,10 +70,29 @@ public:
      * Reset the filter.
      */
     void reset();
+    /**
+     * @brief Get the memory of the holder and its EQ, in bytes
+     */
+    size_t getMemoryUsage() const noexcept;
 private:
+    /**
+     * @brief Get the modulations of the block
+     *
+     * @return true if the parameters are constant over the block
+     */
+    bool fetchModulations() noexcept;
+    /**
+     * @brief Set the parameters of the band at a frame of the block
+     */
+    void updateParameters(unsigned frame) noexcept;
+
     Resources& resources;
-    const EQDescription* description;
-    std::unique_ptr<FilterEq> eq;
+    const EQDescription* description { nullptr };
+    EqBand band;
+    unsigned numChannels { 1 };
+    const float* frequencyMod { nullptr };
+    const float* bandwidthMod { nullptr };
+    const float* gainMod { nullptr };
     float baseBandwidth { Default::eqBandwidth };
     float baseFrequency { Default::eqFrequency };
     float baseGain { Default::eqGain };
@@ -23,7 +23,9 @@
 #include "effects/Rectify.h"
 #include "effects/Gain.h"
 #include "effects/Width.h"
+#include "effects/Convolution.h"
 #include <algorithm>
+#include <cmath>
 
 namespace sfz {
 
@@ -45,6 +47,7 @@ void EffectFactory::registerStandardEffectTypes()
     registerEffectType("rectify", fx::Rectify::makeInstance);
     registerEffectType("gain", fx::Gain::makeInstance);
     registerEffectType("width", fx::Width::makeInstance);
+    registerEffectType("convolution", fx::Convolution::makeInstance);
 }
 
 void EffectFactory::registerEffectType(absl::string_view name, Effect::MakeInstance& make)
@@ -97,7 +100,24 @@ EffectBus::~EffectBus()
 
 void EffectBus::addEffect(std::unique_ptr<Effect> fx)
 {
+    fx->setQuality(_quality);
     _effects.emplace_back(std::move(fx));
+    updateTailFrames();
+}
+
+void EffectBus::updateTailFrames()
+{
+    double tailTime = 0.0;
+    for (const auto& effectPtr : _effects) {
+        const double effectTailTime = effectPtr->getTailTime();
+        if (effectTailTime < 0.0) {
+            _tailFrames = -1;
+            return;
+        }
+        tailTime += effectTailTime;
+    }
+
+    _tailFrames = static_cast<int64_t>(std::ceil(tailTime * _sampleRate));
 }
 
 const Effect* EffectBus::effectView(unsigned index) const
@@ -112,6 +132,7 @@ void EffectBus::clearInputs(unsigned nframes)
 {
     AudioSpan<float>(_inputs).first(nframes).fill(0.0f);
     AudioSpan<float>(_outputs).first(nframes).fill(0.0f);
+    _inputsPending = false;
 }
 
 void EffectBus::addToInputs(const float* const addInput[], float addGain, unsigned nframes)
@@ -123,6 +144,55 @@ void EffectBus::addToInputs(const float* const addInput[], float addGain, unsign
         absl::Span<const float> addIn { addInput[c], nframes };
         sfz::multiplyAdd1(addGain, addIn, _inputs.getSpan(c).first(nframes));
     }
+
+    _inputsPending = true;
+}
+
+void EffectBus::addToInputs(absl::Span<const std::unique_ptr<EffectBus>> buses,
+    absl::Span<const float> addGains, const float* const addInput[], unsigned nframes)
+{
+    const size_t numBuses = std::min(buses.size(), addGains.size());
+
+    // Gather the sends by groups, on the stack
+    constexpr unsigned maxGroupSize { 16 };
+    EffectBus* groupBuses[maxGroupSize];
+    float groupGains[maxGroupSize];
+    float* groupInputs[maxGroupSize];
+
+    size_t i = 0;
+    while (i < numBuses) {
+        unsigned groupSize = 0;
+        for (; i < numBuses && groupSize < maxGroupSize; ++i) {
+            EffectBus* bus = buses[i].get();
+            if (bus && addGains[i] != 0) {
+                groupBuses[groupSize] = bus;
+                groupGains[groupSize] = addGains[i];
+                ++groupSize;
+            }
+        }
+
+        if (groupSize == 0)
+            break;
+        if (groupSize == 1) {
+            groupBuses[0]->addToInputs(addInput, groupGains[0], nframes);
+            continue;
+        }
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            for (unsigned j = 0; j < groupSize; ++j)
+                groupInputs[j] = groupBuses[j]->_inputs.getSpan(c).data();
+            sfz::multiplyAdd1Multi<float>(groupGains, addInput[c], groupInputs, groupSize, nframes);
+        }
+
+        for (unsigned j = 0; j < groupSize; ++j)
+            groupBuses[j]->_inputsPending = true;
+    }
+}
+
+AudioSpan<float> EffectBus::getInputsToAdd(unsigned nframes) noexcept
+{
+    _inputsPending = true;
+    return AudioSpan<float>(_inputs).first(nframes);
 }
 
 void EffectBus::applyGain(const float* gain, unsigned nframes)
@@ -140,12 +210,39 @@ void EffectBus::setSampleRate(double sampleRate)
 {
     for (const auto& effectPtr : _effects)
         effectPtr->setSampleRate(sampleRate);
+
+    _sampleRate = sampleRate;
+    updateTailFrames();
+}
+
+void EffectBus::setQuality(int quality)
+{
+    if (quality == _quality)
+        return;
+
+    for (const auto& effectPtr : _effects)
+        effectPtr->setQuality(quality);
+
+    _quality = quality;
 }
 
 void EffectBus::clear()
 {
     for (const auto& effectPtr : _effects)
         effectPtr->clear();
+
+    _silentFrames = 0;
+    _suspended = false;
+}
+
+static bool isSilent(const AudioBuffer<float>& buffer, unsigned nframes)
+{
+    constexpr float threshold = config::effectSilenceThreshold;
+    for (unsigned c = 0; c < EffectChannels; ++c) {
+        if (!sfz::allWithin(buffer.getConstSpan(c).first(nframes), -threshold, threshold))
+            return false;
+    }
+    return true;
 }
 
 void EffectBus::process(unsigned nframes)
@@ -154,11 +251,29 @@ void EffectBus::process(unsigned nframes)
 
     // TODO: Can we have only one buffer and pass stuff without copies?
     if (numEffects > 0 && hasNonZeroOutput()) {
+        // Track the silence of the inputs, when the effects can be suspended
+        bool silentInput = false;
+        if (_tailFrames >= 0) {
+            silentInput = !_inputsPending || isSilent(_inputs, nframes);
+            if (!silentInput) {
+                _silentFrames = 0;
+                _suspended = false;
+            } else if (_suspended) {
+                return; // the outputs are already cleared
+            } else {
+                _silentFrames += nframes;
+            }
+        }
+
         _effects[0]->process(
             AudioSpan<float>(_inputs), AudioSpan<float>(_outputs), nframes);
         for (size_t i = 1; i < numEffects; ++i)
             _effects[i]->process(
                 AudioSpan<float>(_outputs), AudioSpan<float>(_outputs), nframes);
+
+        // Suspend once the tails have decayed
+        if (silentInput && _silentFrames > _tailFrames && isSilent(_outputs, nframes))
+            _suspended = true;
     } else {
         fx::Nothing().process(
             AudioSpan<float>(_inputs), AudioSpan<float>(_outputs), nframes);
@@ -167,13 +282,28 @@ void EffectBus::process(unsigned nframes)
 
 void EffectBus::mixOutputsTo(float* const mainOutput[], float* const mixOutput[], unsigned nframes)
 {
+    if (_suspended)
+        return;
+
     const float gainToMain = _gainToMain;
     const float gainToMix = _gainToMix;
 
+    // Both sends in a single pass over the outputs, when both are used
+    if (gainToMain != 0 && gainToMix != 0) {
+        const float gains[2] { gainToMain, gainToMix };
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            float* destinations[2] { mainOutput[c], mixOutput[c] };
+            sfz::multiplyAdd1Multi<float>(gains, _outputs.getConstSpan(c).data(), destinations, 2, nframes);
+        }
+        return;
+    }
+
     for (unsigned c = 0; c < EffectChannels; ++c) {
         auto fxOut = _outputs.getConstSpan(c).first(nframes);
-        sfz::multiplyAdd1(gainToMain, fxOut, absl::Span<float>(mainOutput[c], nframes));
-        sfz::multiplyAdd1(gainToMix, fxOut, absl::Span<float>(mixOutput[c], nframes));
+        if (gainToMain != 0)
+            sfz::multiplyAdd1(gainToMain, fxOut, absl::Span<float>(mainOutput[c], nframes));
+        if (gainToMix != 0)
+            sfz::multiplyAdd1(gainToMix, fxOut, absl::Span<float>(mixOutput[c], nframes));
     }
 }
 
@@ -182,6 +312,12 @@ size_t EffectBus::numEffects() const noexcept
     return _effects.size();
 }
 
+size_t EffectBus::getMemoryUsage() const noexcept
+{
+    return sizeof(EffectBus) + _effects.capacity() * sizeof(_effects[0])
+        + _inputs.getMemoryUsage() + _outputs.getMemoryUsage();
+}
+
 void EffectBus::setSamplesPerBlock(int samplesPerBlock) noexcept
 {
     _inputs.resize(samplesPerBlock);
@@ -6,6 +6,7 @@
 
 #pragma once
 #include "AudioBuffer.h"
+#include "AudioSpan.h"
 #include "Defaults.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -15,6 +16,7 @@
 
 namespace sfz {
 struct Opcode;
+class FilePool;
 
 enum {
     // Number of channels processed by effects
@@ -49,6 +51,31 @@ public:
      */
     virtual void process(const float* const inputs[], float* const outputs[], unsigned nframes) = 0;
 
+    /**
+       @brief Gets the longest time for which the output can stay silent
+              while the effect still has some earlier input to output, in
+              seconds, such as a pre-delay. The default is negative, for an
+              effect which can produce output without any input.
+
+              The bus suspends its effects once their input has been silent
+              for longer than the sum of these times and their output is
+              silent as well, and resumes them on the next non-silent input.
+     */
+    virtual double getTailTime() const { return -1.0; }
+
+    /**
+       @brief Sets the quality of the processing, from 0 to 3. The effects
+              which oversample run at most at 2^quality times the sample
+              rate. The default ignores it.
+     */
+    virtual void setQuality(int quality) { (void)quality; }
+
+    /**
+       @brief Loads the files which the effect refers to, after it is
+              instantiated. The default has no files.
+     */
+    virtual void loadFiles(FilePool& filePool) { (void)filePool; }
+
     /**
        @brief Type of the factory function used to instantiate an effect given
               the contents of the <effect> block
@@ -111,6 +138,12 @@ public:
      */
     bool hasNonZeroOutput() const { return (_gainToMain != 0 || _gainToMix != 0); }
 
+    /**
+       @brief Checks whether the effects are suspended, after their input
+              and output went silent.
+     */
+    bool isSuspended() const noexcept { return _suspended; }
+
     /**
        @brief Sets the amount of effect output going to the main.
      */
@@ -145,6 +178,21 @@ public:
      */
     void addToInputs(const float* const addInput[], float addGain, unsigned nframes);
 
+    /**
+       @brief Adds some audio into the input buffers of several buses at
+              once, with a gain for each of them. The audio is read once for
+              all the buses, and the missing buses and the zero gains are
+              skipped.
+     */
+    static void addToInputs(absl::Span<const std::unique_ptr<EffectBus>> buses,
+        absl::Span<const float> addGains, const float* const addInput[], unsigned nframes);
+
+    /**
+       @brief Returns the input buffers, to add some audio into them
+              directly.
+     */
+    AudioSpan<float> getInputsToAdd(unsigned nframes) noexcept;
+
     /**
        @brief Apply a gain to the inputs
      */
@@ -155,6 +203,12 @@ public:
      */
     void setSampleRate(double sampleRate);
 
+    /**
+       @brief Sets the quality of all effects in the bus, which applies to
+              the effects added later as well.
+     */
+    void setQuality(int quality);
+
     /**
        @brief Resets the state of all effects in the bus.
      */
@@ -183,12 +237,32 @@ public:
      * @return size_t
      */
     size_t numEffects() const noexcept;
+
+    /**
+     * @brief Return the memory of the buffers of the bus, in bytes. The
+     * internal state of the effects does not count.
+     *
+     * @return size_t
+     */
+    size_t getMemoryUsage() const noexcept;
 private:
+    /**
+       @brief Computes the number of frames of silent input after which the
+              effects can be suspended, or -1 if they cannot.
+     */
+    void updateTailFrames();
+
     std::vector<std::unique_ptr<Effect>> _effects;
     AudioBuffer<float> _inputs { EffectChannels, config::defaultSamplesPerBlock };
     AudioBuffer<float> _outputs { EffectChannels, config::defaultSamplesPerBlock };
     float _gainToMain { Default::effect };
     float _gainToMix { Default::effect };
+    double _sampleRate { config::defaultSampleRate };
+    int _quality { Default::effectQuality };
+    int64_t _tailFrames { -1 };
+    int64_t _silentFrames { 0 };
+    bool _inputsPending { false }; // some input arrived since the last clear
+    bool _suspended { false };
 };
 
 } // namespace sfz
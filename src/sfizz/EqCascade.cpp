@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "EqCascade.h"
+#include "Config.h"
+#include "MathHelpers.h"
+#include "SIMDHelpers.h"
+#include "utility/Debug.h"
+#include <simde/x86/sse2.h>
+#include <algorithm>
+#include <cmath>
+
+namespace sfz {
+
+EqBand::EqBand() noexcept
+{
+    init(config::defaultSampleRate);
+}
+
+void EqBand::init(double sampleRate) noexcept
+{
+    frequencyScale_ = 2.0 * M_PI / sampleRate;
+    // ln(2)/2 * 2 pi, the bandwidth in octaves to the Q
+    bandwidthScale_ = 2.1775860903036022 / sampleRate;
+    smoothingPole_ = std::exp(-1000.0 / sampleRate);
+    invalidateParameters();
+}
+
+void EqBand::invalidateParameters() noexcept
+{
+    cutoff_ = -1.0f;
+}
+
+void EqBand::clear() noexcept
+{
+    std::fill_n(coefs_, numCoefs, 0.0);
+    std::fill_n(b1x1_, maxChannels, 0.0);
+    std::fill_n(b2x1_, maxChannels, 0.0);
+    std::fill_n(z2_, maxChannels, 0.0);
+    std::fill_n(y1_, maxChannels, 0.0);
+}
+
+void EqBand::setType(EqType type) noexcept
+{
+    type_ = type;
+    invalidateParameters();
+    clear();
+}
+
+void EqBand::setParameters(float cutoff, float bw, float pksh) noexcept
+{
+    // The parameters mostly stay the same between the control points
+    if (cutoff == cutoff_ && bw == bandwidth_ && pksh == gain_)
+        return;
+
+    cutoff_ = cutoff;
+    bandwidth_ = bw;
+    gain_ = pksh;
+
+    // the same design as the faust filters
+    const double frequency = std::max(1.0, std::min(20000.0, static_cast<double>(cutoff)));
+    const double w = frequencyScale_ * frequency;
+    const double cosw = std::cos(w);
+    const double sinw = std::sin(w);
+    const double a = std::pow(10.0, 0.025 * std::max(-120.0, std::min(60.0, static_cast<double>(pksh))));
+    const double octaves = std::max(0.01, std::min(12.0, static_cast<double>(bw)));
+    const double q = std::max(0.001, 0.5 / std::sinh(bandwidthScale_ * frequency * octaves / sinw));
+
+    double c[numCoefs] {};
+    double a0 = 1.0;
+    switch (type_) {
+    case kEqPeak: {
+        const double alpha = 0.5 * sinw / q;
+        a0 = 1.0 + alpha / a;
+        c[0] = 1.0 + alpha * a;
+        c[1] = -2.0 * cosw;
+        c[2] = 1.0 - alpha * a;
+        c[3] = -2.0 * cosw;
+        c[4] = 1.0 - alpha / a;
+        break;
+    }
+    case kEqLshelf: {
+        const double s = std::sqrt(a) * sinw / q;
+        a0 = a + 1.0 + (a - 1.0) * cosw + s;
+        c[0] = a * (a + 1.0 - (a - 1.0) * cosw + s);
+        c[1] = 2.0 * a * (a - 1.0 - (a + 1.0) * cosw);
+        c[2] = a * (a + 1.0 - (a - 1.0) * cosw - s);
+        c[3] = -2.0 * (a - 1.0 + (a + 1.0) * cosw);
+        c[4] = a + 1.0 + (a - 1.0) * cosw - s;
+        break;
+    }
+    case kEqHshelf: {
+        const double s = std::sqrt(a) * sinw / q;
+        a0 = a + 1.0 - (a - 1.0) * cosw + s;
+        c[0] = a * (a + 1.0 + (a - 1.0) * cosw + s);
+        c[1] = -2.0 * a * (a - 1.0 + (a + 1.0) * cosw);
+        c[2] = a * (a + 1.0 + (a - 1.0) * cosw - s);
+        c[3] = 2.0 * (a - 1.0 - (a + 1.0) * cosw);
+        c[4] = a + 1.0 - (a - 1.0) * cosw - s;
+        break;
+    }
+    default:
+        break;
+    }
+
+    const double gain = (1.0 - smoothingPole_) / a0;
+    for (unsigned k = 0; k < numCoefs; ++k)
+        targets_[k] = c[k] * gain;
+}
+
+void EqBand::prepare(float cutoff, float bw, float pksh) noexcept
+{
+    clear();
+    setParameters(cutoff, bw, pksh);
+
+    const double gain = 1.0 - smoothingPole_;
+    for (unsigned k = 0; k < numCoefs; ++k)
+        coefs_[k] = (gain > 0.0) ? targets_[k] / gain : 0.0;
+}
+
+namespace {
+/**
+ * @brief The biquad of a band, in registers, with a channel per lane
+ */
+struct BandLanes {
+    void load(const double* targets, const double* coefs,
+        const double* b1x1, const double* b2x1, const double* z2, const double* y1) noexcept
+    {
+        t0 = simde_mm_set1_pd(targets[0]);
+        t1 = simde_mm_set1_pd(targets[1]);
+        t2 = simde_mm_set1_pd(targets[2]);
+        t3 = simde_mm_set1_pd(targets[3]);
+        t4 = simde_mm_set1_pd(targets[4]);
+        c0 = simde_mm_set1_pd(coefs[0]);
+        c1 = simde_mm_set1_pd(coefs[1]);
+        c2 = simde_mm_set1_pd(coefs[2]);
+        c3 = simde_mm_set1_pd(coefs[3]);
+        c4 = simde_mm_set1_pd(coefs[4]);
+        m0 = simde_mm_loadu_pd(b1x1);
+        m1 = simde_mm_loadu_pd(b2x1);
+        m2 = simde_mm_loadu_pd(z2);
+        m3 = simde_mm_loadu_pd(y1);
+    }
+
+    void store(double* coefs, double* b1x1, double* b2x1, double* z2, double* y1) const noexcept
+    {
+        // The coefficients are the same in both lanes
+        coefs[0] = simde_mm_cvtsd_f64(c0);
+        coefs[1] = simde_mm_cvtsd_f64(c1);
+        coefs[2] = simde_mm_cvtsd_f64(c2);
+        coefs[3] = simde_mm_cvtsd_f64(c3);
+        coefs[4] = simde_mm_cvtsd_f64(c4);
+        simde_mm_storeu_pd(b1x1, m0);
+        simde_mm_storeu_pd(b2x1, m1);
+        simde_mm_storeu_pd(z2, m2);
+        simde_mm_storeu_pd(y1, m3);
+    }
+
+    simde__m128d tick(simde__m128d x, simde__m128d pole) noexcept
+    {
+        c0 = simde_mm_add_pd(simde_mm_mul_pd(pole, c0), t0);
+        c1 = simde_mm_add_pd(simde_mm_mul_pd(pole, c1), t1);
+        c2 = simde_mm_add_pd(simde_mm_mul_pd(pole, c2), t2);
+        c3 = simde_mm_add_pd(simde_mm_mul_pd(pole, c3), t3);
+        c4 = simde_mm_add_pd(simde_mm_mul_pd(pole, c4), t4);
+        const simde__m128d y = simde_mm_sub_pd(
+            simde_mm_add_pd(m0, simde_mm_add_pd(simde_mm_mul_pd(c0, x), m2)),
+            simde_mm_mul_pd(c3, m3));
+        m2 = simde_mm_sub_pd(m1, simde_mm_mul_pd(c4, m3));
+        m0 = simde_mm_mul_pd(c1, x);
+        m1 = simde_mm_mul_pd(c2, x);
+        m3 = y;
+        return y;
+    }
+
+    simde__m128d t0, t1, t2, t3, t4;
+    simde__m128d c0, c1, c2, c3, c4;
+    // b1 x[n-1], b2 x[n-1], b2 x[n-2] - a2 y[n-2], y[n-1]
+    simde__m128d m0, m1, m2, m3;
+};
+} // namespace
+
+template <unsigned NumBands>
+void EqCascade::run(EqBand* const bands[], const float* const in[], float* const out[], unsigned numChannels, unsigned nframes) noexcept
+{
+    // The bands of the voice share the rate, thus the pole
+    const simde__m128d pole = simde_mm_set1_pd(bands[0]->smoothingPole_);
+
+    BandLanes lanes[NumBands];
+    for (unsigned b = 0; b < NumBands; ++b) {
+        const EqBand& band = *bands[b];
+        lanes[b].load(band.targets_, band.coefs_, band.b1x1_, band.b2x1_, band.z2_, band.y1_);
+    }
+
+    // The unused lane of a mono signal stays silent
+    const float* left = in[0];
+    float* outLeft = out[0];
+    if (numChannels > 1) {
+        const float* right = in[1];
+        float* outRight = out[1];
+        for (unsigned i = 0; i < nframes; ++i) {
+            simde__m128d x = simde_mm_set_pd(right[i], left[i]);
+            for (unsigned b = 0; b < NumBands; ++b)
+                x = lanes[b].tick(x, pole);
+            outLeft[i] = static_cast<float>(simde_mm_cvtsd_f64(x));
+            outRight[i] = static_cast<float>(simde_mm_cvtsd_f64(simde_mm_unpackhi_pd(x, x)));
+        }
+    } else {
+        for (unsigned i = 0; i < nframes; ++i) {
+            simde__m128d x = simde_mm_set_sd(left[i]);
+            for (unsigned b = 0; b < NumBands; ++b)
+                x = lanes[b].tick(x, pole);
+            outLeft[i] = static_cast<float>(simde_mm_cvtsd_f64(x));
+        }
+    }
+
+    for (unsigned b = 0; b < NumBands; ++b) {
+        EqBand& band = *bands[b];
+        lanes[b].store(band.coefs_, band.b1x1_, band.b2x1_, band.z2_, band.y1_);
+    }
+}
+
+void EqCascade::process(EqBand* const bands[], unsigned numBands, const float* const in[], float* const out[], unsigned numChannels, unsigned nframes) noexcept
+{
+    ASSERT(numChannels >= 1 && numChannels <= EqBand::maxChannels);
+
+    // The bands which pass through are left out
+    EqBand* activeBands[maxBandsPerPass];
+    unsigned numActive = 0;
+    const float* const* inputs = in;
+
+    auto runActive = [&]() {
+        switch (numActive) {
+        case 1: run<1>(activeBands, inputs, out, numChannels, nframes); break;
+        case 2: run<2>(activeBands, inputs, out, numChannels, nframes); break;
+        case 3: run<3>(activeBands, inputs, out, numChannels, nframes); break;
+        case 4: run<4>(activeBands, inputs, out, numChannels, nframes); break;
+        default: break;
+        }
+        // The next group goes in place
+        inputs = out;
+        numActive = 0;
+    };
+
+    for (unsigned b = 0; b < numBands; ++b) {
+        if (bands[b]->type() == kEqNone)
+            continue;
+        activeBands[numActive++] = bands[b];
+        if (numActive == maxBandsPerPass)
+            runActive();
+    }
+
+    if (numActive > 0)
+        runActive();
+
+    if (inputs == in) {
+        for (unsigned c = 0; c < numChannels; ++c) {
+            if (in[c] != out[c])
+                copy<float>({ in[c], nframes }, { out[c], nframes });
+        }
+    }
+}
+
+} // namespace sfz
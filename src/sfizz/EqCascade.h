@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "SfzFilter.h"
+
+namespace sfz {
+
+/**
+   Equalizer band for SFZ v1, which runs in a cascade with the other bands
+   of a voice or an effect, see `EqCascade`.
+
+   The band computes like `FilterEq`, with the same design and smoothing of
+   coefficients, in double precision.
+
+   Parameters:
+     `cutoff`: it's the opcode `egN_freq` (Hz)
+     `bw`: it's the opcode `eqN_bw` (octave)
+     `pksh`: it's the opcode `eqN_gain` (dB)
+ */
+class EqBand {
+public:
+    EqBand() noexcept;
+
+    /**
+       Set up the filter constants.
+       Run it exactly once after instantiating.
+     */
+    void init(double sampleRate) noexcept;
+
+    /**
+       Reinitialize the filter memory to zeros.
+     */
+    void clear() noexcept;
+
+    /**
+       Clear the filter memory, and compute the initial coefficients unaffected
+       by any smoothing.
+
+       Make sure to set the type first.
+     */
+    void prepare(float cutoff, float bw, float pksh) noexcept;
+
+    /**
+       Set the parameters, which the coefficients reach with smoothing.
+     */
+    void setParameters(float cutoff, float bw, float pksh) noexcept;
+
+    /**
+       Get the type of filter.
+     */
+    EqType type() const noexcept { return type_; }
+
+    /**
+       Set the type of filter, and clear the memory.
+       The band with no type passes its input through.
+     */
+    void setType(EqType type) noexcept;
+
+private:
+    friend class EqCascade;
+    void invalidateParameters() noexcept;
+
+    // the coefficients b0, b1, b2, a1, a2 of the biquad
+    enum { numCoefs = 5 };
+    enum { maxChannels = 2 };
+
+    EqType type_ { kEqNone };
+    double frequencyScale_ {};
+    double bandwidthScale_ {};
+    double smoothingPole_ {};
+    // the parameters of the targets
+    float cutoff_ {};
+    float bandwidth_ {};
+    float gain_ {};
+    // the targets, premultiplied by the complement of the pole
+    double targets_[numCoefs] {};
+    double coefs_[numCoefs] {};
+    // the memory per channel: b1 x[n-1], b2 x[n-1], b2 x[n-2] - a2 y[n-2],
+    // and y[n-1]
+    double b1x1_[maxChannels] {};
+    double b2x1_[maxChannels] {};
+    double z2_[maxChannels] {};
+    double y1_[maxChannels] {};
+};
+
+/**
+   Cascade of equalizer bands, which processes all of them in a single pass
+   over the block. The signal goes from a band to the next in registers,
+   and the channels run side by side in the lanes of vector registers.
+ */
+class EqCascade {
+public:
+    // bands held in registers at once, the longer cascades go by groups
+    enum { maxBandsPerPass = 4 };
+
+    /**
+       Process one cycle of the bands in order, with 1 or 2 channels.
+       `in[c]` and `out[c]` may refer to identical buffers, for in-place processing
+     */
+    static void process(EqBand* const bands[], unsigned numBands, const float* const in[], float* const out[], unsigned numChannels, unsigned nframes) noexcept;
+
+private:
+    template <unsigned NumBands>
+    static void run(EqBand* const bands[], const float* const in[], float* const out[], unsigned numChannels, unsigned nframes) noexcept;
+};
+
+} // namespace sfz
@@ -8,6 +8,7 @@
 #include <string>
 #include <memory>
 #include <iosfwd>
+#include <cstdint>
 
 namespace sfz {
 
@@ -94,6 +95,25 @@ private:
     static const std::string emptyFilename;
 };
 
+struct FileData;
+
+/**
+ * @brief The data of an identifier, resolved within a file pool. It stays
+ * valid as long as the pool keeps the same generation of files, so that
+ * the voices reach the data without looking up the file name.
+ */
+struct FileSlot {
+    FileData* data { nullptr };
+    // The identifier under which the pool keeps the data, which the loaders
+    // use in place of the one of the region
+    const FileId* id { nullptr };
+    uint32_t generation { 0 };
+    // Whether the data is the forward data of a reversed file, which the
+    // voices read backward
+    bool mirrored { false };
+    bool loaded { false };
+};
+
 }
 
 namespace std {
@@ -24,70 +24,165 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "FilePool.h"
+#include "TaskScheduler.h"
 #include "AudioReader.h"
 #include "Buffer.h"
 #include "AudioBuffer.h"
 #include "AudioSpan.h"
 #include "Config.h"
+#include "import/foreign_instruments/AudioFile.h"
+#include "utility/AtomicFile.h"
 #include "utility/SwapAndPop.h"
 #include "utility/Debug.h"
-#include <ThreadPool.h>
+#include <st_audiofile.hpp>
+#include <absl/strings/str_cat.h>
 #include <absl/types/span.h>
 #include <absl/strings/match.h>
 #include <absl/memory/memory.h>
+#include <absl/algorithm/container.h>
+#include <absl/container/flat_hash_set.h>
 #include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <thread>
 #include <system_error>
 #include <atomic_queue/defs.h>
-#if defined(_WIN32)
-#include <windows.h>
-#else
-#include <pthread.h>
-#endif
 using namespace std::placeholders;
 
-static std::weak_ptr<ThreadPool> globalThreadPoolWeakPtr;
-static std::mutex globalThreadPoolMutex;
+struct SharedPreloadEntry {
+    std::weak_ptr<sfz::FileAudioBuffer> buffer;
+    std::weak_ptr<sfz::FileCompactAudioBuffer> compactBuffer;
+    fs::file_time_type modificationTime;
+    double resampleRate { 0.0 };
+    std::vector<sfz::FrameRange> segments; // if the float data is a sparse preload
 
-static std::shared_ptr<ThreadPool> globalThreadPool()
-{
-    std::shared_ptr<ThreadPool> threadPool;
+    bool expired() const noexcept { return buffer.expired() && compactBuffer.expired(); }
+};
+
+struct SharedPreloadKey {
+    sfz::FileId id; // with the absolute file path
+    int numaNode { -1 };
+
+    bool operator==(const SharedPreloadKey& other) const noexcept
+    {
+        return numaNode == other.numaNode && id == other.id;
+    }
 
-    threadPool = globalThreadPoolWeakPtr.lock();
-    if (threadPool)
-        return threadPool;
+    template <class H>
+    friend H AbslHashValue(H h, const SharedPreloadKey& key)
+    {
+        return H::combine(std::move(h), std::hash<sfz::FileId>()(key.id), key.numaNode);
+    }
+};
 
-    std::lock_guard<std::mutex> lock(globalThreadPoolMutex);
-    threadPool = globalThreadPoolWeakPtr.lock();
-    if (threadPool)
-        return threadPool;
+// Preloaded data of all the file pools, keyed by file and NUMA node
+static absl::flat_hash_map<SharedPreloadKey, SharedPreloadEntry> sharedPreloads;
+static std::mutex sharedPreloadsMutex;
+
+/**
+ * @brief Find the shared preload of a key, erasing it if no pool holds it
+ * anymore. Call it with the mutex held.
+ */
+static absl::flat_hash_map<SharedPreloadKey, SharedPreloadEntry>::iterator findSharedPreload(const SharedPreloadKey& key)
+{
+    auto it = sharedPreloads.find(key);
+    if (it != sharedPreloads.end() && it->second.expired()) {
+        sharedPreloads.erase(it);
+        it = sharedPreloads.end();
+    }
+    return it;
+}
 
-    unsigned numThreads = std::thread::hardware_concurrency();
-    numThreads = (numThreads > 2) ? (numThreads - 2) : 1;
-    threadPool.reset(new ThreadPool(numThreads));
-    globalThreadPoolWeakPtr = threadPool;
-    return threadPool;
+/**
+ * @brief Erase the shared preloads which no pool holds anymore. The lookups
+ * only erase their own key, so sweep once per load or clear.
+ */
+static void pruneSharedPreloads()
+{
+    std::lock_guard<std::mutex> lock { sharedPreloadsMutex };
+    for (auto it = sharedPreloads.begin(), end = sharedPreloads.end(); it != end; ) {
+        auto copyIt = it++;
+        if (copyIt->second.expired())
+            sharedPreloads.erase(copyIt);
+    }
 }
 
+struct InformationCacheEntry {
+    int64_t fileSize { 0 };
+    int64_t modificationTime { 0 };
+    sfz::FileInformation information;
+    uint64_t contentHash { 0 }; // 0 until the file is hashed
+    // The envelope of the whole file, empty until it is measured
+    std::vector<float> envelopeRms;
+    std::vector<float> envelopePeak;
+};
+
+// Information read by all the file pools, keyed by absolute file path, and
+// the generation of the cache held by the index of each cache directory
+static absl::flat_hash_map<sfz::FileId, InformationCacheEntry> informationCache;
+static absl::flat_hash_map<std::string, uint64_t> informationIndexes;
+static uint64_t informationCacheGeneration { 0 };
+static std::mutex informationCacheMutex;
+
 void readBaseFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, uint32_t numFrames)
 {
     output.reset();
     output.resize(numFrames);
 
     const unsigned channels = reader.channels();
+    if (channels != 1 && channels != 2)
+        return;
 
-    if (channels == 1) {
+    float* outputs[2] {};
+    for (unsigned c = 0; c < channels; ++c)
         output.addChannel();
-        output.clear();
-        reader.readNextBlock(output.channelWriter(0), numFrames);
-    } else if (channels == 2) {
-        output.addChannel();
-        output.addChannel();
-        output.clear();
-        sfz::Buffer<float> tempReadBuffer { 2 * numFrames };
-        reader.readNextBlock(tempReadBuffer.data(), numFrames);
-        sfz::readInterleaved(tempReadBuffer, output.getSpan(0), output.getSpan(1));
+    output.clear();
+    for (unsigned c = 0; c < channels; ++c)
+        outputs[c] = output.channelWriter(c);
+    reader.readNextFrames(outputs, numFrames);
+}
+
+/**
+ * @brief Read the segments of a sparse preload into an output of the frames
+ * of the contiguous preload. The frames between the segments are decoded and
+ * dropped; the pages of the output which hold none are never touched, so
+ * they take no memory.
+ */
+void readSparseFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, uint32_t numFrames, const std::vector<sfz::FrameRange>& segments)
+{
+    output.reset();
+    output.resize(numFrames);
+
+    const unsigned channels = reader.channels();
+    if (channels != 1 && channels != 2)
+        return;
+
+    // The sample memory comes zeroed, and clearing it would make it resident
+    output.addChannels(channels);
+
+    constexpr size_t chunkSize { sfz::config::fileChunkSize };
+    std::vector<float> dropped(channels * chunkSize);
+    float* droppedOutputs[2] { dropped.data(), dropped.data() + (channels - 1) * chunkSize };
+    size_t position = 0;
+    for (const sfz::FrameRange& segment : segments) {
+        while (position < segment.start) {
+            const size_t numFrames = min(chunkSize, segment.start - position);
+            const size_t numRead = reader.readNextFrames(droppedOutputs, numFrames);
+            position += numRead;
+            if (numRead < numFrames)
+                return;
+        }
+
+        float* outputs[2] {};
+        for (unsigned c = 0; c < channels; ++c)
+            outputs[c] = output.channelWriter(c) + segment.start;
+        const size_t numFrames = segment.end - segment.start;
+        if (reader.readNextFrames(outputs, numFrames) < numFrames)
+            return;
+        position = segment.end;
     }
 }
 
@@ -98,72 +193,417 @@ sfz::FileAudioBuffer readFromFile(sfz::AudioReader& reader, uint32_t numFrames)
     return baseBuffer;
 }
 
-void streamFromFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, std::atomic<size_t>* filledFrames = nullptr)
+void prepareStream(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, size_t streamLimit)
 {
-    const auto numFrames = static_cast<size_t>(reader.frames());
-    const auto numChannels = reader.channels();
-    const auto chunkSize = static_cast<size_t>(sfz::config::fileChunkSize);
-
     output.reset();
     output.addChannels(reader.channels());
-    output.resize(numFrames);
-    output.clear();
+    output.resize(static_cast<size_t>(reader.frames()));
+    // The frames past the limit of the looped files are not touched until
+    // they are streamed
+    const size_t numFrames = min(output.getNumFrames(), streamLimit);
+    for (size_t c = 0; c < output.getNumChannels(); ++c)
+        sfz::fill(output.getSpan(c).first(numFrames), 0.0f);
+}
+
+/**
+ * @brief Stream a slice of a file into an output sized for the whole file.
+ *
+ * @param reader the reader, positioned after the frames already streamed
+ * @param output the output buffer
+ * @param frameCounter the number of frames already streamed, updated
+ * @param maxFrames the maximal number of frames to stream in this slice
+ * @param filledFrames the number of frames available to the players, updated
+ * @return true if the end of the file was reached
+ */
+template <class Buffer>
+bool streamFromFile(sfz::AudioReader& reader, Buffer& output, size_t& frameCounter, size_t maxFrames, std::atomic<size_t>* filledFrames = nullptr)
+{
+    const auto numFrames = output.getNumFrames();
+    const auto numChannels = reader.channels();
+    const auto chunkSize = static_cast<size_t>(sfz::config::fileChunkSize);
+    const auto sliceEnd = std::min(numFrames, frameCounter + maxFrames);
 
-    sfz::Buffer<float> fileBlock { chunkSize * numChannels };
-    size_t inputFrameCounter { 0 };
-    size_t outputFrameCounter { 0 };
-    bool inputEof = false;
+    float* outputs[2] {};
+    if (numChannels > 2)
+        return true;
 
-    while (!inputEof && inputFrameCounter < numFrames)
+    while (frameCounter < sliceEnd)
     {
-        auto thisChunkSize = std::min(chunkSize, numFrames - inputFrameCounter);
+        auto thisChunkSize = std::min(chunkSize, sliceEnd - frameCounter);
+        for (size_t chanIdx = 0; chanIdx < numChannels; chanIdx++)
+            outputs[chanIdx] = output.getSpan(chanIdx).data() + frameCounter;
         const auto numFramesRead = static_cast<size_t>(
-            reader.readNextBlock(fileBlock.data(), thisChunkSize));
+            reader.readNextFrames(outputs, thisChunkSize));
         if (numFramesRead == 0)
-            break;
+            return true;
 
-        if (numFramesRead < thisChunkSize) {
-            inputEof = true;
+        const bool inputEof = numFramesRead < thisChunkSize;
+        if (inputEof)
             thisChunkSize = numFramesRead;
+
+        frameCounter += thisChunkSize;
+
+        if (filledFrames != nullptr)
+            filledFrames->fetch_add(thisChunkSize);
+
+        if (inputEof)
+            return true;
+    }
+
+    return frameCounter >= numFrames;
+}
+
+/**
+ * @brief Decode frames read from an uncompressed file into an output sized
+ * for the whole file.
+ *
+ * @param layout the layout of the file
+ * @param data the frames as read
+ * @param numFrames the number of frames
+ * @param output the output buffer
+ * @param frameCounter the number of frames already streamed, updated
+ */
+template <class Buffer>
+void decodeRawFrames(const sfz::RawAudioLayout& layout, const unsigned char* data, size_t numFrames, Buffer& output, size_t& frameCounter)
+{
+    float* outputs[2];
+    for (unsigned c = 0; c < layout.channels; ++c)
+        outputs[c] = output.getSpan(c).subspan(frameCounter, numFrames).data();
+    sfz::decodeRawAudio(layout, data, numFrames, outputs);
+    frameCounter += numFrames;
+}
+
+/**
+ * @brief Get the rate of the data of a file if it is resampled, or 0 if the
+ * data is at the rate of the file.
+ */
+static double getResampleRate(const sfz::FileInformation& dataInformation) noexcept
+{
+    return (dataInformation.resampleRatio != 1.0) ? dataInformation.sampleRate : 0.0;
+}
+
+/**
+ * @brief Adapt the reader of a file to the rate of its data: the rates which
+ * are a power of 2 times the one of the file go through the oversampler, and
+ * the others through the resampler.
+ */
+static sfz::AudioReaderPtr createDataReader(sfz::AudioReaderPtr reader, double resampleRate)
+{
+    if (!reader || resampleRate <= 0.0 || reader->sampleRate() == 0)
+        return reader;
+
+    const double ratio = resampleRate / reader->sampleRate();
+    for (sfz::Oversampling factor : { sfz::Oversampling::x2, sfz::Oversampling::x4, sfz::Oversampling::x8 }) {
+        if (ratio == static_cast<int>(factor))
+            return sfz::createOversamplingAudioReader(std::move(reader), factor);
+    }
+    return sfz::createResamplingAudioReader(std::move(reader), resampleRate);
+}
+
+sfz::FileAudioBufferPtr sfz::FilePool::readSharedPreload(const fs::path& file, bool reverse, uint32_t numFrames, double resampleRate,
+    std::vector<FrameRange>& segments) const
+{
+    auto read = [&]() {
+        return std::make_shared<FileAudioBuffer>(segments.empty() ?
+            readPreload(file, reverse, numFrames, resampleRate) : readSparsePreload(file, reverse, numFrames, segments));
+    };
+
+    std::error_code ec;
+    const SharedPreloadKey key { FileId { fs::absolute(file, ec).lexically_normal().string(), reverse }, numaNode };
+    const fs::file_time_type modificationTime = fs::last_write_time(file, ec);
+    if (ec)
+        return read();
+
+    // A contiguous preload serves the sparse ones it covers, and a sparse
+    // one only the same segments
+    auto findShared = [&]() -> FileAudioBufferPtr {
+        const auto it = findSharedPreload(key);
+        if (it == sharedPreloads.end() || it->second.modificationTime != modificationTime
+            || it->second.resampleRate != resampleRate)
+            return {};
+        FileAudioBufferPtr buffer = it->second.buffer.lock();
+        if (!buffer || buffer->getNumFrames() < numFrames)
+            return {};
+        if (!it->second.segments.empty() && it->second.segments != segments)
+            return {};
+        segments = it->second.segments;
+        return buffer;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock { sharedPreloadsMutex };
+        if (FileAudioBufferPtr buffer = findShared())
+            return buffer;
+    }
+
+    // Decode without the lock, so that files can preload concurrently
+    auto buffer = read();
+
+    std::lock_guard<std::mutex> lock { sharedPreloadsMutex };
+    if (FileAudioBufferPtr sharedBuffer = findShared())
+        return sharedBuffer;
+
+    SharedPreloadEntry& entry = sharedPreloads[key];
+    if (entry.modificationTime != modificationTime || entry.resampleRate != resampleRate)
+        entry.compactBuffer.reset();
+    entry.buffer = buffer;
+    entry.modificationTime = modificationTime;
+    entry.resampleRate = resampleRate;
+    entry.segments = segments;
+
+    return buffer;
+}
+
+/**
+ * @brief Convert preloaded data to the compact storage, if all its frames
+ * are exactly representable as 16-bit integers.
+ */
+static sfz::FileCompactAudioBufferPtr makeCompactPreload(const sfz::FileAudioBuffer& buffer)
+{
+    const size_t numChannels = buffer.getNumChannels();
+    const size_t numFrames = buffer.getNumFrames();
+    auto compact = std::make_shared<sfz::FileCompactAudioBuffer>(numChannels, numFrames);
+
+    for (size_t c = 0; c < numChannels; ++c) {
+        const absl::Span<const float> input = buffer.getConstSpan(c);
+        const absl::Span<int16_t> output = compact->getSpan(c);
+        for (size_t i = 0; i < numFrames; ++i) {
+            const float value = input[i] * 32768.0f;
+            // Also false for NaN
+            if (!(value >= -32768.0f && value <= 32767.0f && value == std::trunc(value)))
+                return {};
+            output[i] = static_cast<int16_t>(value);
+        }
+    }
+
+    return compact;
+}
+
+void sfz::FilePool::setSharedPreload(FileData& data, const fs::path& file, bool reverse, uint32_t numFrames) const
+{
+    const SampleMemory::NodeScope nodeScope { numaNode };
+    const double resampleRate = getResampleRate(data.information);
+    data.preloadSegments = getPreloadSegments(data, numFrames);
+    if (!compactStorage) {
+        data.preloadedData = readSharedPreload(file, reverse, numFrames, resampleRate, data.preloadSegments);
+        data.compactPreloadedData.reset();
+        return;
+    }
+
+    std::error_code ec;
+    const SharedPreloadKey key { FileId { fs::absolute(file, ec).lexically_normal().string(), reverse }, numaNode };
+    const fs::file_time_type modificationTime = fs::last_write_time(file, ec);
+
+    auto findShared = [&]() -> FileCompactAudioBufferPtr {
+        const auto it = findSharedPreload(key);
+        if (ec || it == sharedPreloads.end() || it->second.modificationTime != modificationTime
+            || it->second.resampleRate != resampleRate)
+            return {};
+        FileCompactAudioBufferPtr buffer = it->second.compactBuffer.lock();
+        if (!buffer || buffer->getNumFrames() < numFrames)
+            return {};
+        return buffer;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock { sharedPreloadsMutex };
+        if (FileCompactAudioBufferPtr compact = findShared()) {
+            data.compactPreloadedData = std::move(compact);
+            data.preloadedData.reset();
+            return;
         }
-        const auto outputChunkSize = thisChunkSize;
+    }
+
+    FileAudioBufferPtr buffer = readSharedPreload(file, reverse, numFrames, resampleRate, data.preloadSegments);
+    FileCompactAudioBufferPtr compact = makeCompactPreload(*buffer);
+    if (!compact) {
+        data.preloadedData = std::move(buffer);
+        data.compactPreloadedData.reset();
+        return;
+    }
 
-        for (size_t chanIdx = 0; chanIdx < numChannels; chanIdx++) {
-            const auto outputChunk = output.getSpan(chanIdx).subspan(outputFrameCounter, outputChunkSize);
-            for (size_t i = 0; i < thisChunkSize; ++i)
-                outputChunk[i] = fileBlock[i * numChannels + chanIdx];
+    if (!ec) {
+        std::lock_guard<std::mutex> lock { sharedPreloadsMutex };
+        if (FileCompactAudioBufferPtr sharedCompact = findShared()) {
+            compact = std::move(sharedCompact);
+        } else {
+            // The float data was just registered by readSharedPreload
+            SharedPreloadEntry& entry = sharedPreloads[key];
+            entry.compactBuffer = compact;
+            entry.modificationTime = modificationTime;
         }
-        inputFrameCounter += thisChunkSize;
-        outputFrameCounter += outputChunkSize;
+    }
 
-        if (filledFrames != nullptr)
-            filledFrames->fetch_add(outputChunkSize);
+    data.compactPreloadedData = std::move(compact);
+    data.preloadedData.reset();
+}
+
+sfz::FilePool::SharedPreloadStats sfz::FilePool::getSharedPreloadStats()
+{
+    SharedPreloadStats stats;
+    std::lock_guard<std::mutex> lock { sharedPreloadsMutex };
+
+    for (const auto& p : sharedPreloads) {
+        long numOwners = p.second.buffer.use_count();
+        size_t bufferBytes = 0;
+        if (FileAudioBufferPtr buffer = p.second.buffer.lock()) {
+            size_t numFrames = buffer->getNumFrames();
+            if (!p.second.segments.empty()) {
+                numFrames = 0;
+                for (const FrameRange& segment : p.second.segments)
+                    numFrames += segment.end - segment.start;
+            }
+            bufferBytes = numFrames * buffer->getNumChannels() * sizeof(float);
+        }
+
+        const long numCompactOwners = p.second.compactBuffer.use_count();
+        if (numCompactOwners > numOwners) {
+            FileCompactAudioBufferPtr buffer = p.second.compactBuffer.lock();
+            if (!buffer)
+                continue;
+            numOwners = numCompactOwners;
+            bufferBytes = buffer->getNumFrames() * buffer->getNumChannels() * sizeof(int16_t);
+        }
+
+        if (numOwners < 2 || bufferBytes == 0)
+            continue;
+
+        stats.numSharedFiles += 1;
+        stats.bytesSaved += static_cast<size_t>(numOwners - 1) * bufferBytes;
     }
+
+    return stats;
 }
 
+struct sfz::FilePool::StreamJob
+{
+    explicit StreamJob(FilePool& pool) : sliceTask(pool, *this) {}
+
+    struct SliceTask final : public TaskScheduler::Task {
+        SliceTask(FilePool& pool, StreamJob& job) : pool(pool), job(job) {}
+        void run() noexcept override { pool.loadingJob(job); }
+        FilePool& pool;
+        StreamJob& job;
+    };
+
+    QueuedFileData request;
+    AudioReaderPtr reader; // open once the stream has started
+    std::shared_ptr<const std::vector<char>> encodedData; // which the reader decodes, if kept in memory
+    bool started { false };
+    size_t numStreamedFrames { 0 };
+    size_t numCountedFrames { 0 }; // the streamed frames in the stats
+    bool finished { false };
+    // Set last by the slices, after which they no longer touch the job
+    std::atomic<bool> sliceDone { false };
+    SliceTask sliceTask;
+
+    // Scheduling, only accessed under the loading jobs mutex
+    TimePoint origin {};
+    double framesPerSecond { 0.0 };
+    TimePoint deadline {};
+    bool running { false };
+    bool paused { false }; // a bounded stream with a full window
+
+    // Bounded streams only
+    size_t numReleasedFrames { 0 };
+
+    // Uncompressed files read with the asynchronous I/O
+    std::shared_ptr<AsyncFileIO::File> rawFile;
+    RawAudioLayout rawLayout;
+    std::vector<unsigned char> rawData; // the bytes of the current slice
+    size_t rawBytesRead { 0 };
+    bool runningAsync { false }; // only accessed by the dispatching thread
+
+    const void* key() const noexcept
+    {
+        if (request.stream)
+            return request.stream;
+        return request.data;
+    }
+
+    /**
+     * @brief Get the time when the player runs out of loaded frames
+     */
+    TimePoint getDeadline() const noexcept
+    {
+        if (framesPerSecond <= 0.0)
+            return origin;
+        const FileData& data = *request.data;
+        const size_t streamedFrames = request.stream ?
+            request.stream->availableFrames.load() : data.availableFrames.load();
+        const size_t availableFrames = std::max(streamedFrames, data.getNumPreloadedFrames());
+        return origin + std::chrono::duration_cast<TimePoint::duration>(
+            Duration(availableFrames / framesPerSecond));
+    }
+
+    static bool laterDeadline(const StreamJob* lhs, const StreamJob* rhs) noexcept
+    {
+        return lhs->deadline > rhs->deadline;
+    }
+};
+
+struct sfz::FilePool::GarbageTask final : public TaskScheduler::Task
+{
+    explicit GarbageTask(FilePool& pool) : pool(pool) {}
+    void run() noexcept override { pool.garbageJob(); }
+    FilePool& pool;
+};
+
+struct sfz::FilePool::PreloadTask final : public TaskScheduler::Task
+{
+    explicit PreloadTask(FilePool& pool) : pool(pool) {}
+    void run() noexcept override { pool.preloadJob(); }
+    FilePool& pool;
+};
+
+struct sfz::FilePool::DispatchTask final : public TaskScheduler::Task, public DispatchWaker
+{
+    explicit DispatchTask(FilePool& pool) : pool(pool) {}
+    void run() noexcept override { pool.dispatchingJob(); }
+    void wake() noexcept override { pool.wakeDispatch(); }
+    FilePool& pool;
+};
+
 sfz::FilePool::FilePool()
     : filesToLoad(alignedNew<FileQueue>()),
-      threadPool(globalThreadPool())
+      freeFileStreams(alignedNew<FileStreamQueue>()),
+      scheduler(TaskScheduler::getGlobal()),
+      lastUsedQueue(alignedNew<LastUsedQueue>()),
+      garbageToCollect(alignedNew<GarbageQueue>()),
+      garbageTask(new GarbageTask(*this)),
+      dispatchTask(new DispatchTask(*this)),
+      preloadsToLoad(alignedNew<PreloadQueue>()),
+      preloadTask(new PreloadTask(*this))
 {
     loadingJobs.reserve(config::maxVoices);
+    deferredStreams.reserve(config::maxVoices);
     lastUsedFiles.reserve(config::maxVoices);
-    garbageToCollect.reserve(config::maxVoices);
+
+    fileStreams.reserve(config::maxVoices);
+    activeFileStreams.reserve(config::maxVoices);
+    for (unsigned i = 0; i < config::maxVoices; ++i) {
+        fileStreams.emplace_back(new FileStream);
+        fileStreams.back()->wake = dispatchTask.get();
+        freeFileStreams->push(fileStreams.back().get());
+    }
 }
 
 sfz::FilePool::~FilePool()
 {
-    std::error_code ec;
+    // The slices which finish wake the dispatching up, which then returns
+    dispatchFlag = false;
+    TaskScheduler::wait(*dispatchTask);
 
-    garbageFlag = false;
-    semGarbageBarrier.post(ec);
-    garbageThread.join();
+    for (StreamJob* job : loadingJobs)
+        waitForSlice(*job);
 
-    dispatchFlag = false;
-    dispatchBarrier.post(ec);
-    dispatchThread.join();
+    // The completion thread still wakes the dispatching up after the last
+    // asynchronous slice is done; joining it leaves nothing to schedule it
+    asyncIO.reset();
 
-    for (auto& job : loadingJobs)
-        job.wait();
+    TaskScheduler::wait(*dispatchTask);
+    TaskScheduler::wait(*garbageTask);
+    TaskScheduler::wait(*preloadTask);
 }
 
 bool sfz::FilePool::checkSample(std::string& filename) const noexcept
@@ -243,6 +683,43 @@ bool sfz::FilePool::checkSampleId(FileId& fileId) const noexcept
     return result;
 }
 
+std::vector<uint8_t> sfz::FilePool::checkSampleIds(std::vector<FileId>& fileIds) noexcept
+{
+    std::vector<uint8_t> found(fileIds.size(), 0);
+    std::vector<size_t> uniqueIndices(fileIds.size());
+    std::vector<size_t> toCheck;
+    absl::flat_hash_map<FileId, size_t> uniqueIds;
+    for (size_t i = 0; i < fileIds.size(); ++i) {
+        const auto unique = uniqueIds.emplace(fileIds[i], i);
+        uniqueIndices[i] = unique.first->second;
+        if (!unique.second)
+            continue;
+        if (loadedFiles.contains(fileIds[i]))
+            found[i] = 1;
+        else
+            toCheck.push_back(i);
+    }
+
+    runConcurrently(toCheck.size(), [&](size_t j) {
+        const size_t i = toCheck[j];
+        std::string filename = fileIds[i].filename();
+        if (checkSample(filename)) {
+            fileIds[i] = FileId(std::move(filename), fileIds[i].isReverse());
+            found[i] = 1;
+        }
+    });
+
+    for (size_t i = 0; i < fileIds.size(); ++i) {
+        const size_t unique = uniqueIndices[i];
+        if (unique != i) {
+            fileIds[i] = fileIds[unique];
+            found[i] = found[unique];
+        }
+    }
+
+    return found;
+}
+
 absl::optional<sfz::FileInformation> getReaderInformation(sfz::AudioReader* reader) noexcept
 {
     const unsigned channels = reader->channels();
@@ -279,115 +756,1261 @@ absl::optional<sfz::FileInformation> getReaderInformation(sfz::AudioReader* read
     return returnedValue;
 }
 
-absl::optional<sfz::FileInformation> sfz::FilePool::checkExistingFileInformation(const FileId& fileId) noexcept
+namespace {
+
+// Header of the files of the decoded cache, followed by the path of the
+// sample file and the planar float data of each channel.
+struct DecodedCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reverse;
+    int64_t fileSize;
+    int64_t modificationTime;
+    int64_t end;
+    int64_t loopStart;
+    int64_t loopEnd;
+    double sampleRate;
+    int32_t hasLoop;
+    int32_t numChannels;
+    int32_t rootKey;
+    uint32_t numFrames;
+    uint32_t pathSize;
+    uint32_t reserved;
+};
+
+constexpr char decodedCacheMagic[8] = { 'S', 'F', 'Z', 'C', 'A', 'C', 'H', 'E' };
+constexpr uint32_t decodedCacheVersion = 1;
+
+struct FileStamp {
+    std::string path;
+    int64_t fileSize { 0 };
+    int64_t modificationTime { 0 };
+};
+
+/**
+ * @brief Get the absolute path of a file, with the size and modification
+ * time which tell whether it changed
+ */
+absl::optional<FileStamp> getFileStamp(const fs::path& file)
 {
-    const auto loadedFile = loadedFiles.find(fileId);
-    if (loadedFile != loadedFiles.end())
-        return loadedFile->second.information;
+    std::error_code ec;
+    FileStamp stamp;
+    stamp.path = fs::absolute(file, ec).lexically_normal().string();
+    stamp.fileSize = static_cast<int64_t>(fs::file_size(file, ec));
+    if (ec)
+        return {};
+    stamp.modificationTime = static_cast<int64_t>(fs::last_write_time(file, ec).time_since_epoch().count());
+    if (ec)
+        return {};
+    return stamp;
+}
 
-    const auto preloadedFile = preloadedFiles.find(fileId);
-    if (preloadedFile != preloadedFiles.end())
-        return preloadedFile->second.information;
+/**
+ * @brief Hash the bytes of a file, or return 0 if it cannot be read.
+ */
+uint64_t hashFileContent(const fs::path& file)
+{
+    fs::ifstream stream { file, std::ios::binary };
+    if (!stream)
+        return 0;
+
+    // FNV-1a on 64-bit words, with the high bits folded back in
+    constexpr uint64_t prime { 0x100000001B3 };
+    uint64_t hash { 0xCBF29CE484222325 };
+    std::vector<char> chunk(1 << 16);
+    while (stream) {
+        stream.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const auto numBytes = static_cast<size_t>(stream.gcount());
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= numBytes; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, chunk.data() + i, sizeof(word));
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 32;
+        }
+        for (; i < numBytes; ++i)
+            hash = (hash ^ static_cast<uint8_t>(chunk[i])) * prime;
+    }
 
-    return {};
+    if (stream.bad())
+        return 0;
+    return (hash != 0) ? hash : 1;
 }
 
-absl::optional<sfz::FileInformation> sfz::FilePool::getFileInformation(const FileId& fileId) noexcept
-{
-    auto existingInformation = checkExistingFileInformation(fileId);
-    if (existingInformation)
-        return existingInformation;
+struct DecodedCacheKey {
+    std::string path;
+    int64_t fileSize { 0 };
+    int64_t modificationTime { 0 };
+    bool reverse { false };
+    fs::path cacheFile;
+};
 
-    const fs::path file { rootDirectory / fileId.filename() };
+absl::optional<DecodedCacheKey> getDecodedCacheKey(const fs::path& cacheDirectory, const fs::path& file, bool reverse)
+{
+    if (cacheDirectory.empty())
+        return {};
 
-    if (!fs::exists(file))
+    auto stamp = getFileStamp(file);
+    if (!stamp)
         return {};
 
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
-    return getReaderInformation(reader.get());
+    DecodedCacheKey key;
+    key.path = std::move(stamp->path);
+    key.fileSize = stamp->fileSize;
+    key.modificationTime = stamp->modificationTime;
+    key.reverse = reverse;
+
+    const std::string hashed = absl::StrCat(
+        key.path, "|", reverse ? 1 : 0, "|", key.fileSize, "|", key.modificationTime);
+    const size_t hash = std::hash<std::string>()(hashed);
+    key.cacheFile = cacheDirectory / absl::StrCat(absl::Hex(hash, absl::kZeroPad16), ".sfzcache");
+    return key;
 }
 
-bool sfz::FilePool::preloadFile(const FileId& fileId, uint32_t maxOffset) noexcept
+bool readDecodedCacheHeader(fs::ifstream& stream, const DecodedCacheKey& key, DecodedCacheHeader& header)
 {
-    const auto loadedFile = loadedFiles.find(fileId);
-    if (loadedFile != loadedFiles.end()) {
-        loadedFile->second.preloadCallCount++;
-        return true;
-    }
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
 
-    auto fileInformation = getFileInformation(fileId);
-    if (!fileInformation)
+    if (std::memcmp(header.magic, decodedCacheMagic, sizeof(decodedCacheMagic)) != 0
+        || header.version != decodedCacheVersion
+        || header.reverse != (key.reverse ? 1u : 0u)
+        || header.fileSize != key.fileSize
+        || header.modificationTime != key.modificationTime
+        || header.pathSize != key.path.size()
+        || (header.numChannels != 1 && header.numChannels != 2))
         return false;
 
-    fileInformation->maxOffset = maxOffset;
-    const fs::path file { rootDirectory / fileId.filename() };
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+    // Different paths may share a hash, so check the one in the file
+    std::string path(header.pathSize, '\0');
+    if (!stream.read(&path[0], static_cast<std::streamsize>(path.size())))
+        return false;
 
-    const auto frames = static_cast<uint32_t>(reader->frames());
-    const auto framesToLoad = [&]() {
-        if (loadInRam)
-            return frames;
-        else
-            return min(frames, maxOffset + preloadSize);
-    }();
+    return path == key.path;
+}
 
-    const auto existingFile = preloadedFiles.find(fileId);
-    if (existingFile != preloadedFiles.end()) {
-        auto& fileData = existingFile->second;
-        if (framesToLoad > fileData.preloadedData.getNumFrames()) {
-            fileData.information.maxOffset = maxOffset;
-            fileData.preloadedData = readFromFile(*reader, framesToLoad);
-            fileData.fullyLoaded = frames == framesToLoad;
-        }
-        fileData.preloadCallCount++;
-    } else {
-        fileInformation->sampleRate = static_cast<double>(reader->sampleRate());
-        auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
-            readFromFile(*reader, framesToLoad),
-            *fileInformation
-        });
+sfz::FileInformation getDecodedCacheInformation(const DecodedCacheHeader& header)
+{
+    sfz::FileInformation information;
+    information.end = header.end;
+    information.loopStart = header.loopStart;
+    information.loopEnd = header.loopEnd;
+    information.hasLoop = header.hasLoop != 0;
+    information.sampleRate = header.sampleRate;
+    information.numChannels = header.numChannels;
+    information.rootKey = header.rootKey;
+    return information;
+}
+
+bool readDecodedCache(const DecodedCacheKey& key, sfz::FileAudioBuffer& output, uint32_t numFrames)
+{
+    fs::ifstream stream { key.cacheFile, std::ios::binary };
+    DecodedCacheHeader header;
+    if (!stream || !readDecodedCacheHeader(stream, key, header) || header.numFrames < numFrames)
+        return false;
 
-        insertedPair.first->second.preloadCallCount++;
-        insertedPair.first->second.status = FileData::Status::Preloaded;
-        insertedPair.first->second.fullyLoaded = framesToLoad == frames;
+    const std::streamoff dataStart = stream.tellg();
+    output.reset();
+    output.resize(numFrames);
+    for (int channel = 0; channel < header.numChannels; ++channel) {
+        output.addChannel();
+        const std::streamoff channelStart =
+            dataStart + std::streamoff(channel) * header.numFrames * sizeof(float);
+        const auto channelBytes = static_cast<std::streamsize>(numFrames * sizeof(float));
+        if (!stream.seekg(channelStart) || !stream.read(reinterpret_cast<char*>(output.channelWriter(channel)), channelBytes))
+            return false;
     }
 
     return true;
 }
 
-void sfz::FilePool::resetPreloadCallCounts() noexcept
+void writeDecodedCache(const DecodedCacheKey& key, const sfz::FileInformation& information, const sfz::FileAudioBuffer& buffer)
 {
-    for (auto& preloadedFile: preloadedFiles)
-        preloadedFile.second.preloadCallCount = 0;
+    std::error_code ec;
+    fs::create_directories(key.cacheFile.parent_path(), ec);
+    if (ec)
+        return;
 
-    for (auto& loadedFile: loadedFiles)
-        loadedFile.second.preloadCallCount = 0;
+    DecodedCacheHeader header {};
+    std::memcpy(header.magic, decodedCacheMagic, sizeof(decodedCacheMagic));
+    header.version = decodedCacheVersion;
+    header.reverse = key.reverse ? 1 : 0;
+    header.fileSize = key.fileSize;
+    header.modificationTime = key.modificationTime;
+    header.end = information.end;
+    header.loopStart = information.loopStart;
+    header.loopEnd = information.loopEnd;
+    header.sampleRate = information.sampleRate;
+    header.hasLoop = information.hasLoop ? 1 : 0;
+    header.numChannels = static_cast<int32_t>(buffer.getNumChannels());
+    header.rootKey = information.rootKey;
+    header.numFrames = static_cast<uint32_t>(buffer.getNumFrames());
+    header.pathSize = static_cast<uint32_t>(key.path.size());
+
+    sfz::writeFileAtomically(key.cacheFile, [&](std::ostream& stream) {
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(key.path.data(), static_cast<std::streamsize>(key.path.size()));
+        for (size_t channel = 0; channel < buffer.getNumChannels(); ++channel) {
+            const auto channelData = buffer.getConstSpan(channel);
+            stream.write(reinterpret_cast<const char*>(channelData.data()),
+                static_cast<std::streamsize>(channelData.size() * sizeof(float)));
+        }
+    });
 }
 
-void sfz::FilePool::removeUnusedPreloadedData() noexcept
+bool isDecodedCacheFormat(int format)
 {
-    for (auto it = preloadedFiles.begin(), end = preloadedFiles.end(); it != end; ) {
-        auto copyIt = it++;
-        if (copyIt->second.preloadCallCount == 0) {
-            DBG("[sfizz] Removing unused preloaded data: " << copyIt->first.filename());
-            preloadedFiles.erase(copyIt);
+    // Formats which are expensive to decode, unlike PCM
+    return format != st_audio_file_wav && format != st_audio_file_aiff;
+}
+
+// Header of the index of the information cache, followed by its entries,
+// each one followed by the path of its sample file, then by the RMS and the
+// peak values of its envelope.
+struct InformationIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numEntries;
+};
+
+struct InformationIndexEntry {
+    int64_t fileSize;
+    int64_t modificationTime;
+    int64_t end;
+    int64_t loopStart;
+    int64_t loopEnd;
+    double sampleRate;
+    int32_t hasLoop;
+    int32_t numChannels;
+    int32_t rootKey;
+    uint32_t reverse;
+    uint32_t hasWavetable;
+    uint32_t tableSize;
+    int32_t crossTableInterpolation;
+    uint32_t oneShot;
+    uint32_t pathSize;
+    uint32_t numEnvelopeWindows;
+    uint64_t contentHash;
+};
+
+constexpr char informationIndexMagic[8] = { 'S', 'F', 'Z', 'I', 'N', 'D', 'E', 'X' };
+constexpr uint32_t informationIndexVersion = 3;
+constexpr char informationIndexName[] = "information.sfzindex";
+
+// The generation of an index which lacks some of the cache
+constexpr uint64_t incompleteIndexGeneration = ~uint64_t(0);
+
+/**
+ * @brief Merge the index of a cache directory into the information cache,
+ * once. The entries already in the cache are newer and stay.
+ * The cache must be locked.
+ */
+void loadInformationIndex(const fs::path& cacheDirectory)
+{
+    const std::string directory = cacheDirectory.string();
+    if (informationIndexes.contains(directory))
+        return;
+
+    const bool hadEntries = !informationCache.empty();
+    informationIndexes[directory] = hadEntries ? incompleteIndexGeneration : informationCacheGeneration;
+
+    fs::ifstream stream { cacheDirectory / informationIndexName, std::ios::binary };
+    InformationIndexHeader header;
+    if (!stream || !stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, informationIndexMagic, sizeof(informationIndexMagic)) != 0
+        || header.version != informationIndexVersion)
+        return;
+
+    for (uint32_t i = 0; i < header.numEntries; ++i) {
+        InformationIndexEntry entry;
+        if (!stream.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+            return;
+        std::string path(entry.pathSize, '\0');
+        if (!stream.read(&path[0], static_cast<std::streamsize>(path.size())))
+            return;
+        std::vector<float> envelopeRms(entry.numEnvelopeWindows);
+        std::vector<float> envelopePeak(entry.numEnvelopeWindows);
+        const auto envelopeSize = static_cast<std::streamsize>(entry.numEnvelopeWindows * sizeof(float));
+        if (!stream.read(reinterpret_cast<char*>(envelopeRms.data()), envelopeSize)
+            || !stream.read(reinterpret_cast<char*>(envelopePeak.data()), envelopeSize))
+            return;
+
+        const sfz::FileId fileId { std::move(path), entry.reverse != 0 };
+        if (informationCache.contains(fileId))
+            continue;
+
+        InformationCacheEntry& cached = informationCache[fileId];
+        cached.fileSize = entry.fileSize;
+        cached.modificationTime = entry.modificationTime;
+        cached.information.end = entry.end;
+        cached.information.loopStart = entry.loopStart;
+        cached.information.loopEnd = entry.loopEnd;
+        cached.information.hasLoop = entry.hasLoop != 0;
+        cached.information.sampleRate = entry.sampleRate;
+        cached.information.numChannels = entry.numChannels;
+        cached.information.rootKey = entry.rootKey;
+        cached.contentHash = entry.contentHash;
+        cached.envelopeRms = std::move(envelopeRms);
+        cached.envelopePeak = std::move(envelopePeak);
+        if (entry.hasWavetable) {
+            sfz::WavetableInfo wavetable {};
+            wavetable.tableSize = entry.tableSize;
+            wavetable.crossTableInterpolation = entry.crossTableInterpolation;
+            wavetable.oneShot = entry.oneShot != 0;
+            cached.information.wavetable = wavetable;
         }
     }
+}
 
-    for (auto it = loadedFiles.begin(), end = loadedFiles.end(); it != end; ) {
-        auto copyIt = it++;
-        if (copyIt->second.preloadCallCount == 0) {
-            DBG("[sfizz] Removing unused loaded data: " << copyIt->first.filename());
-            loadedFiles.erase(copyIt);
+/**
+ * @brief Write the information cache into the index of a cache directory.
+ * The cache must be locked.
+ */
+bool writeInformationIndex(const fs::path& cacheDirectory)
+{
+    std::error_code ec;
+    fs::create_directories(cacheDirectory, ec);
+    if (ec)
+        return false;
+
+    InformationIndexHeader header {};
+    std::memcpy(header.magic, informationIndexMagic, sizeof(informationIndexMagic));
+    header.version = informationIndexVersion;
+    header.numEntries = static_cast<uint32_t>(informationCache.size());
+
+    return sfz::writeFileAtomically(cacheDirectory / informationIndexName, [&](std::ostream& stream) {
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& item : informationCache) {
+            const std::string& path = item.first.filename();
+            const sfz::FileInformation& information = item.second.information;
+            InformationIndexEntry entry {};
+            entry.fileSize = item.second.fileSize;
+            entry.modificationTime = item.second.modificationTime;
+            entry.end = information.end;
+            entry.loopStart = information.loopStart;
+            entry.loopEnd = information.loopEnd;
+            entry.sampleRate = information.sampleRate;
+            entry.hasLoop = information.hasLoop ? 1 : 0;
+            entry.numChannels = information.numChannels;
+            entry.rootKey = information.rootKey;
+            entry.reverse = item.first.isReverse() ? 1 : 0;
+            entry.contentHash = item.second.contentHash;
+            if (information.wavetable) {
+                entry.hasWavetable = 1;
+                entry.tableSize = information.wavetable->tableSize;
+                entry.crossTableInterpolation = information.wavetable->crossTableInterpolation;
+                entry.oneShot = information.wavetable->oneShot ? 1 : 0;
+            }
+            entry.pathSize = static_cast<uint32_t>(path.size());
+            entry.numEnvelopeWindows = static_cast<uint32_t>(item.second.envelopeRms.size());
+            const auto envelopeSize = static_cast<std::streamsize>(entry.numEnvelopeWindows * sizeof(float));
+            stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            stream.write(path.data(), static_cast<std::streamsize>(path.size()));
+            stream.write(reinterpret_cast<const char*>(item.second.envelopeRms.data()), envelopeSize);
+            stream.write(reinterpret_cast<const char*>(item.second.envelopePeak.data()), envelopeSize);
         }
-    }
+    });
 }
 
-sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
+} // namespace
+
+sfz::FileAudioBuffer sfz::FilePool::readPreload(const fs::path& file, bool reverse, uint32_t numFrames, double resampleRate) const
 {
-    auto fileInformation = getFileInformation(fileId);
-    if (!fileInformation)
-        return {};
+    const SampleMemory::NodeScope nodeScope { numaNode };
+    FileAudioBuffer buffer;
+    if (resampleRate > 0.0) {
+        AudioReaderPtr reader = createDataReader(createAudioReader(file, reverse), resampleRate);
+        readBaseFile(*reader, buffer, numFrames);
+        return buffer;
+    }
+
+    const auto key = getDecodedCacheKey(cacheDirectory, file, reverse);
+    if (key && readDecodedCache(*key, buffer, numFrames))
+        return buffer;
+
+    AudioReaderPtr reader = createAudioReader(file, reverse);
+    readBaseFile(*reader, buffer, numFrames);
+
+    if (key && isDecodedCacheFormat(reader->format())) {
+        auto information = getReaderInformation(reader.get());
+        if (information && !information->wavetable)
+            writeDecodedCache(*key, *information, buffer);
+    }
+
+    return buffer;
+}
+
+sfz::FileAudioBuffer sfz::FilePool::readSparsePreload(const fs::path& file, bool reverse, uint32_t numFrames, const std::vector<FrameRange>& segments) const
+{
+    const SampleMemory::NodeScope nodeScope { numaNode };
+    FileAudioBuffer buffer;
+    AudioReaderPtr reader = createAudioReader(file, reverse);
+    readSparseFile(*reader, buffer, numFrames, segments);
+    return buffer;
+}
+
+absl::optional<sfz::FileInformation> sfz::FilePool::readCachedFileInformation(const fs::path& file, bool reverse) const
+{
+    const auto key = getDecodedCacheKey(cacheDirectory, file, reverse);
+    if (!key)
+        return {};
+
+    fs::ifstream stream { key->cacheFile, std::ios::binary };
+    DecodedCacheHeader header;
+    if (!stream || !readDecodedCacheHeader(stream, *key, header))
+        return {};
+
+    return getDecodedCacheInformation(header);
+}
+
+absl::optional<sfz::FileInformation> sfz::FilePool::readFileInformation(const fs::path& file, bool reverse) const noexcept
+{
+    const auto stamp = getFileStamp(file);
+    if (stamp) {
+        std::lock_guard<std::mutex> lock { informationCacheMutex };
+        if (!cacheDirectory.empty())
+            loadInformationIndex(cacheDirectory);
+        const auto it = informationCache.find(FileId { stamp->path, reverse });
+        if (it != informationCache.end()
+            && it->second.fileSize == stamp->fileSize
+            && it->second.modificationTime == stamp->modificationTime)
+            return it->second.information;
+    }
+
+    auto information = readCachedFileInformation(file, reverse);
+    if (!information) {
+        AudioReaderPtr reader = createAudioReader(file, reverse);
+        information = getReaderInformation(reader.get());
+    }
+
+    if (information && stamp) {
+        std::lock_guard<std::mutex> lock { informationCacheMutex };
+        InformationCacheEntry& entry = informationCache[FileId { stamp->path, reverse }];
+        entry.fileSize = stamp->fileSize;
+        entry.modificationTime = stamp->modificationTime;
+        entry.information = *information;
+        entry.contentHash = 0;
+        entry.envelopeRms.clear();
+        entry.envelopePeak.clear();
+        ++informationCacheGeneration;
+    }
+
+    return information;
+}
+
+absl::optional<sfz::FilePool::ContentKey> sfz::FilePool::getContentKey(const FileId& fileId) const noexcept
+{
+    const fs::path file { rootDirectory / fileId.filename() };
+    const auto stamp = getFileStamp(file);
+    if (!stamp)
+        return {};
+
+    ContentKey key;
+    key.fileSize = stamp->fileSize;
+    key.reverse = fileId.isReverse();
+    const FileId cacheId { stamp->path, fileId.isReverse() };
+    auto findCached = [&]() -> InformationCacheEntry* {
+        const auto it = informationCache.find(cacheId);
+        if (it == informationCache.end() || it->second.fileSize != stamp->fileSize
+            || it->second.modificationTime != stamp->modificationTime)
+            return nullptr;
+        return &it->second;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock { informationCacheMutex };
+        if (!cacheDirectory.empty())
+            loadInformationIndex(cacheDirectory);
+        const InformationCacheEntry* cached = findCached();
+        if (cached && cached->contentHash != 0) {
+            key.hash = cached->contentHash;
+            return key;
+        }
+    }
+
+    // Hash without the lock, so that files can be hashed concurrently
+    key.hash = hashFileContent(file);
+    if (key.hash == 0)
+        return {};
+
+    std::lock_guard<std::mutex> lock { informationCacheMutex };
+    if (InformationCacheEntry* cached = findCached()) {
+        cached->contentHash = key.hash;
+        ++informationCacheGeneration;
+    }
+    return key;
+}
+
+sfz::FileId sfz::FilePool::deduplicateFile(const FileId& fileId) noexcept
+{
+    const auto alias = contentAliases.find(fileId);
+    if (alias != contentAliases.end())
+        return alias->second;
+
+    if (preloadedFiles.contains(fileId))
+        return fileId;
+
+    const auto key = getContentKey(fileId);
+    if (!key)
+        return fileId;
+
+    const auto inserted = contentFiles.emplace(*key, fileId);
+    if (inserted.second || inserted.first->second == fileId)
+        return fileId;
+
+    DBG("[sfizz] " << fileId.filename() << " has the contents of " << inserted.first->second.filename());
+    contentAliases.emplace(fileId, inserted.first->second);
+    return inserted.first->second;
+}
+
+void sfz::FilePool::forgetRemovedContents() noexcept
+{
+    for (auto it = contentAliases.begin(), end = contentAliases.end(); it != end; ) {
+        auto copyIt = it++;
+        if (!preloadedFiles.contains(copyIt->second))
+            contentAliases.erase(copyIt);
+    }
+
+    for (auto it = contentFiles.begin(), end = contentFiles.end(); it != end; ) {
+        auto copyIt = it++;
+        if (!preloadedFiles.contains(copyIt->second))
+            contentFiles.erase(copyIt);
+    }
+}
+
+void sfz::FilePool::saveFileInformationIndex() const noexcept
+{
+    if (cacheDirectory.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock { informationCacheMutex };
+    loadInformationIndex(cacheDirectory);
+    uint64_t& indexGeneration = informationIndexes[cacheDirectory.string()];
+    if (indexGeneration != informationCacheGeneration && writeInformationIndex(cacheDirectory))
+        indexGeneration = informationCacheGeneration;
+}
+
+size_t sfz::FilePool::getNumCachedFileInformation()
+{
+    std::lock_guard<std::mutex> lock { informationCacheMutex };
+    return informationCache.size();
+}
+
+void sfz::FilePool::clearFileInformationCache()
+{
+    std::lock_guard<std::mutex> lock { informationCacheMutex };
+    informationCache.clear();
+    informationIndexes.clear();
+    ++informationCacheGeneration;
+}
+
+template <class F>
+void sfz::FilePool::runConcurrently(size_t count, F&& function) noexcept
+{
+    const size_t numLanes = min(count, static_cast<size_t>(loadingParallelism));
+    if (numLanes < 2) {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    // The lanes take the next item until all are done; the calling thread
+    // is one of them, and runs the lanes which could not be scheduled.
+    std::atomic<size_t> nextItem { 0 };
+    auto lane = [&]() {
+        for (size_t i; (i = nextItem.fetch_add(1)) < count; )
+            function(i);
+    };
+
+    using LaneTask = TaskScheduler::FunctionTask<decltype(lane)>;
+    std::vector<std::unique_ptr<LaneTask>> lanes;
+    lanes.reserve(numLanes - 1);
+    for (size_t i = 1; i < numLanes; ++i) {
+        lanes.emplace_back(new LaneTask(lane));
+        scheduler->schedule(*lanes.back(), TaskScheduler::Priority::Low);
+    }
+
+    lane();
+    for (auto& task : lanes)
+        TaskScheduler::wait(*task);
+}
+
+void sfz::FilePool::runLoadingTasks(size_t count, const std::function<void(size_t)>& function) noexcept
+{
+    runConcurrently(count, function);
+}
+
+void sfz::FilePool::probeFileInformation(const std::vector<FileId>& fileIds) noexcept
+{
+    std::vector<const FileId*> toProbe;
+    absl::flat_hash_set<FileId> uniqueIds;
+    toProbe.reserve(fileIds.size());
+    for (const FileId& fileId : fileIds) {
+        if (uniqueIds.insert(fileId).second && !checkExistingFileInformation(fileId))
+            toProbe.push_back(&fileId);
+    }
+
+    std::vector<absl::optional<FileInformation>> results(toProbe.size());
+    runConcurrently(toProbe.size(), [&](size_t i) {
+        const fs::path file { rootDirectory / toProbe[i]->filename() };
+        std::error_code ec;
+        if (fs::exists(file, ec))
+            results[i] = readFileInformation(file, toProbe[i]->isReverse());
+    });
+
+    for (size_t i = 0; i < toProbe.size(); ++i) {
+        if (results[i])
+            probedInformation[*toProbe[i]] = *results[i];
+    }
+
+    // Hash the files which may be deduplicated ahead of their preloading
+    if (deduplicate) {
+        std::vector<const FileId*> toHash;
+        toHash.reserve(uniqueIds.size());
+        for (const FileId& fileId : uniqueIds) {
+            if (!preloadedFiles.contains(fileId) && !contentAliases.contains(fileId))
+                toHash.push_back(&fileId);
+        }
+        runConcurrently(toHash.size(), [&](size_t i) {
+            getContentKey(*toHash[i]);
+        });
+    }
+
+    saveFileInformationIndex();
+}
+
+size_t sfz::FilePool::probeDirectoryInformation(const fs::path& directory) noexcept
+{
+    const AudioFileInstrumentFormat& audioFormat = AudioFileInstrumentFormat::getInstance();
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it { rootDirectory / directory, ec }, end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && audioFormat.matchesFilePath(it->path()))
+            files.push_back(it->path());
+    }
+
+    std::atomic<size_t> numProbed { 0 };
+    runConcurrently(files.size(), [&](size_t i) {
+        if (readFileInformation(files[i], false))
+            numProbed.fetch_add(1);
+    });
+
+    saveFileInformationIndex();
+    return numProbed.load();
+}
+
+void sfz::FilePool::clearProbedFileInformation() noexcept
+{
+    probedInformation.clear();
+}
+
+double sfz::FilePool::getBasePreloadFrames(const FileInformation& information) const noexcept
+{
+    if (!adaptivePreloading || adaptiveLatency <= 0.0)
+        return preloadSize;
+
+    // The latency at the own rate of the file
+    const double fileRate = information.sampleRate / information.resampleRatio;
+    return max(static_cast<double>(config::minPreloadSize), std::ceil(adaptiveLatency * fileRate));
+}
+
+uint32_t sfz::FilePool::getFramesToPreload(const FileInformation& information, const FileId& fileId) const noexcept
+{
+    const auto frames = static_cast<uint32_t>(information.end + 1);
+    if (loadInRam)
+        return frames;
+
+    const auto scaledPreloadSize = static_cast<uint32_t>(std::ceil(
+        getBasePreloadFrames(information) * information.preloadRatio * static_cast<int>(oversamplingFactor)));
+    const auto maxOffset = static_cast<int64_t>(std::ceil(information.maxOffset * information.resampleRatio));
+    int64_t preloadEnd = maxOffset + int64_t(scaledPreloadSize);
+
+    // The profiled files preload as far as they played, the others little
+    if (!usageProfile.empty()) {
+        const FileUsage* usage = usageProfile.find(fileId);
+        if (usage && usage->numPlays > 0) {
+            const auto playedEnd = static_cast<int64_t>(std::ceil(usage->playedFrames * information.resampleRatio));
+            const auto hotEnd = maxOffset + static_cast<int64_t>(std::ceil(scaledPreloadSize * config::hotPreloadRatio));
+            preloadEnd = clamp(playedEnd, preloadEnd, hotEnd);
+        } else {
+            preloadEnd = maxOffset + static_cast<int64_t>(std::ceil(scaledPreloadSize * config::coldPreloadRatio));
+        }
+    }
+
+    return static_cast<uint32_t>(min(int64_t(frames), preloadEnd));
+}
+
+std::vector<sfz::FrameRange> sfz::FilePool::getPreloadSegments(const FileData& data, uint32_t numFrames) const
+{
+    std::vector<FrameRange> segments;
+    const FileInformation& information = data.information;
+    if (data.startRanges.empty() || loadInRam || compactStorage || information.resampleRatio != 1.0)
+        return segments;
+
+    const auto scaledPreloadSize = static_cast<uint32_t>(std::ceil(
+        getBasePreloadFrames(information) * information.preloadRatio * static_cast<int>(oversamplingFactor)));
+    auto addSegment = [&](uint32_t start, uint32_t end) {
+        end = min(end, numFrames);
+        if (start >= end)
+            return;
+        segments.push_back({ start, end });
+    };
+
+    addSegment(0, scaledPreloadSize);
+    for (const FrameRange& range : data.startRanges)
+        addSegment(range.start, range.end + scaledPreloadSize);
+
+    // Merge the segments which overlap or nearly touch
+    std::sort(segments.begin(), segments.end(), [](const FrameRange& lhs, const FrameRange& rhs) {
+        return lhs.start < rhs.start;
+    });
+    size_t numMerged = 0;
+    size_t numHeldFrames = 0;
+    for (const FrameRange& segment : segments) {
+        if (numMerged > 0 && segment.start <= segments[numMerged - 1].end + config::fileChunkSize) {
+            FrameRange& last = segments[numMerged - 1];
+            numHeldFrames += max(last.end, segment.end) - last.end;
+            last.end = max(last.end, segment.end);
+            continue;
+        }
+        numHeldFrames += segment.end - segment.start;
+        segments[numMerged++] = segment;
+    }
+    segments.resize(numMerged);
+
+    // Not worth the segments if they hold most of the frames anyway
+    if (numMerged < 2 || numHeldFrames * 2 > numFrames)
+        segments.clear();
+
+    return segments;
+}
+
+sfz::FileInformation sfz::FilePool::getDataInformation(const FileInformation& information) const noexcept
+{
+    if (information.sampleRate <= 0.0)
+        return information;
+
+    const bool resampled = resampling && information.sampleRate != sampleRate;
+    const double dataRate = (resampled ? sampleRate : information.sampleRate) * static_cast<int>(oversamplingFactor);
+    if (dataRate == information.sampleRate)
+        return information;
+
+    const double ratio = dataRate / information.sampleRate;
+    FileInformation dataInformation = information;
+    dataInformation.end = getResampledFrames(information.end + 1, information.sampleRate, dataRate) - 1;
+    dataInformation.loopStart = static_cast<int64_t>(std::llround(information.loopStart * ratio));
+    dataInformation.loopEnd = min(dataInformation.end, static_cast<int64_t>(std::llround(information.loopEnd * ratio)));
+    dataInformation.sampleRate = dataRate;
+    dataInformation.resampleRatio = ratio;
+    return dataInformation;
+}
+
+void sfz::FilePool::measureEnvelope(FileData& data, const FileId& fileId) const noexcept
+{
+    SampleEnvelope& envelope = data.envelope;
+    envelope.resize(static_cast<size_t>(max(data.information.end + 1, int64_t(0))));
+    if (envelope.isComplete())
+        return;
+
+    if (data.information.resampleRatio == 1.0) {
+        const auto stamp = getFileStamp(rootDirectory / fileId.filename());
+        if (stamp) {
+            std::lock_guard<std::mutex> lock { informationCacheMutex };
+            const auto it = informationCache.find(FileId { stamp->path, fileId.isReverse() });
+            if (it != informationCache.end()
+                && it->second.fileSize == stamp->fileSize
+                && it->second.modificationTime == stamp->modificationTime
+                && envelope.assign(it->second.envelopeRms, it->second.envelopePeak))
+                return;
+        }
+    }
+
+    // The frames between the segments of a sparse preload read as silence,
+    // so only the head of the file is measured
+    if (data.mappedFile)
+        envelope.measure(AudioSpan<const float>({ data.mappedFile->getData() }), envelope.getNumFrames());
+    else if (data.compactPreloadedData)
+        envelope.measure(AudioSpan<const int16_t>(*data.compactPreloadedData), data.getPreloadSegment(0).end, 1.0f / 32768.0f);
+    else if (data.preloadedData)
+        envelope.measure(AudioSpan<const float>(*data.preloadedData), data.getPreloadSegment(0).end);
+
+    storeEnvelope(data, fileId);
+}
+
+void sfz::FilePool::storeEnvelope(const FileData& data, const FileId& fileId) const noexcept
+{
+    const SampleEnvelope& envelope = data.envelope;
+    if (data.information.resampleRatio != 1.0 || envelope.getNumWindows() == 0 || !envelope.isComplete())
+        return;
+
+    const auto stamp = getFileStamp(rootDirectory / fileId.filename());
+    if (!stamp)
+        return;
+
+    std::lock_guard<std::mutex> lock { informationCacheMutex };
+    const auto it = informationCache.find(FileId { stamp->path, fileId.isReverse() });
+    if (it == informationCache.end()
+        || it->second.fileSize != stamp->fileSize
+        || it->second.modificationTime != stamp->modificationTime
+        || !it->second.envelopeRms.empty())
+        return;
+
+    const auto rms = envelope.getRms();
+    const auto peak = envelope.getPeak();
+    it->second.envelopeRms.assign(rms.begin(), rms.end());
+    it->second.envelopePeak.assign(peak.begin(), peak.end());
+    ++informationCacheGeneration;
+}
+
+const sfz::SampleEnvelope* sfz::FilePool::getSampleEnvelope(const FileId& fileId) const noexcept
+{
+    const auto alias = contentAliases.find(fileId);
+    const FileId& id = (alias != contentAliases.end()) ? alias->second : fileId;
+
+    const auto loaded = loadedFiles.find(id);
+    if (loaded != loadedFiles.end())
+        return &loaded->second.envelope;
+
+    const auto preloaded = preloadedFiles.find(id);
+    if (preloaded != preloadedFiles.end())
+        return &preloaded->second.envelope;
+
+    return nullptr;
+}
+
+bool sfz::FilePool::preloadFiles(const std::vector<FileToPreload>& files, const PreloadCallback& callback) noexcept
+{
+    settleDeferredPreloads();
+
+    std::vector<uint32_t> framesToLoad(files.size(), 0);
+    std::vector<FileData> preloads(files.size());
+    std::vector<FileId> fileIds(files.size());
+    absl::flat_hash_set<FileId> contentIds;
+    for (size_t i = 0; i < files.size(); ++i) {
+        fileIds[i] = deduplicate ? deduplicateFile(files[i].fileId) : files[i].fileId;
+        const FileId& fileId = fileIds[i];
+        if (loadedFiles.contains(fileId))
+            continue;
+        // The files with the same contents are decoded once
+        if (deduplicate && !contentIds.insert(fileId).second)
+            continue;
+        auto fileInformation = getFileInformation(fileId);
+        if (!fileInformation)
+            continue;
+        fileInformation->maxOffset = files[i].maxOffset;
+        fileInformation->preloadRatio = files[i].preloadRatio;
+        const FileInformation dataInformation = getDataInformation(*fileInformation);
+        if (memoryMapped && !fileId.isReverse() && dataInformation.resampleRatio == 1.0)
+            continue;
+        if (files[i].deferred)
+            continue;
+        framesToLoad[i] = getFramesToPreload(dataInformation, fileId);
+        // The reversed files preloaded whole share the forward data
+        if (fileId.isReverse() && framesToLoad[i] > static_cast<uint32_t>(dataInformation.end)) {
+            fileIds[i] = FileId { fileId.filename(), false };
+            if (memoryMapped && dataInformation.resampleRatio == 1.0) {
+                framesToLoad[i] = 0;
+                continue;
+            }
+        }
+        preloads[i].information = dataInformation;
+        preloads[i].startRanges = files[i].startRanges;
+        const auto existingFile = preloadedFiles.find(fileId);
+        if (existingFile != preloadedFiles.end()
+            && (existingFile->second.mappedFile || (framesToLoad[i] <= existingFile->second.getNumPreloadedFrames()
+                && files[i].startRanges == existingFile->second.startRanges)))
+            framesToLoad[i] = 0;
+    }
+
+    // Decode the files concurrently; the shared preloads keep the buffers,
+    // so that preloading the files in order below picks them up.
+    std::atomic<size_t> numPreloadedFiles { 0 };
+    std::atomic<size_t> numBytesRead { 0 };
+    std::atomic<bool> canceled { false };
+    const std::thread::id callingThread = std::this_thread::get_id();
+
+    // The files which played the most in the usage profile come first
+    std::vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    if (!usageProfile.empty()) {
+        auto numPlays = [&](size_t i) -> uint32_t {
+            const FileUsage* usage = usageProfile.find(fileIds[i]);
+            return usage ? usage->numPlays : 0;
+        };
+        std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+            return numPlays(lhs) > numPlays(rhs);
+        });
+    }
+
+    runConcurrently(files.size(), [&](size_t k) {
+        const size_t i = order[k];
+        if (canceled)
+            return;
+
+        if (framesToLoad[i] > 0) {
+            const FileId& fileId = fileIds[i];
+            const fs::path file { rootDirectory / fileId.filename() };
+            setSharedPreload(preloads[i], file, fileId.isReverse(), framesToLoad[i]);
+            const FileData& data = preloads[i];
+            const size_t numChannels = data.preloadedData ?
+                data.preloadedData->getNumChannels() : data.compactPreloadedData->getNumChannels();
+            numBytesRead += numChannels * data.getNumHeldFrames() * sizeof(float);
+        }
+        ++numPreloadedFiles;
+
+        // Only the calling thread reports the progress
+        if (callback && std::this_thread::get_id() == callingThread) {
+            const PreloadProgress progress { numPreloadedFiles.load(), numBytesRead.load() };
+            if (!callback(progress))
+                canceled = true;
+        }
+    });
+
+    if (canceled)
+        return false;
+
+    for (const auto& file : files)
+        preloadFile(file.fileId, file.maxOffset, file.preloadRatio, file.deferred, file.loopEnd, file.startRanges);
+
+    // The data which the files above replaced is released by now
+    pruneSharedPreloads();
+
+    if (callback)
+        callback(PreloadProgress { files.size(), numBytesRead.load() });
+
+    return true;
+}
+
+absl::optional<sfz::FileInformation> sfz::FilePool::checkExistingFileInformation(const FileId& fileId) noexcept
+{
+    // The information of the resampled data is not in the frames of the file
+    const auto loadedFile = loadedFiles.find(fileId);
+    if (loadedFile != loadedFiles.end() && loadedFile->second.information.resampleRatio == 1.0)
+        return loadedFile->second.information;
+
+    const auto preloadedFile = preloadedFiles.find(fileId);
+    if (preloadedFile != preloadedFiles.end() && preloadedFile->second.information.resampleRatio == 1.0)
+        return preloadedFile->second.information;
+
+    const auto probedFile = probedInformation.find(fileId);
+    if (probedFile != probedInformation.end())
+        return probedFile->second;
+
+    return {};
+}
+
+absl::optional<sfz::FileInformation> sfz::FilePool::getFileInformation(const FileId& fileId) noexcept
+{
+    auto existingInformation = checkExistingFileInformation(fileId);
+    if (existingInformation)
+        return existingInformation;
+
+    const fs::path file { rootDirectory / fileId.filename() };
+
+    if (!fs::exists(file))
+        return {};
+
+    return readFileInformation(file, fileId.isReverse());
+}
+
+bool sfz::FilePool::preloadMirroredFile(const FileId& fileId, uint32_t maxOffset, float preloadRatio) noexcept
+{
+    const FileId forwardId { fileId.filename(), false };
+    const auto alias = contentAliases.find(fileId);
+    const bool wasMirrored = alias != contentAliases.end() && !alias->second.isReverse();
+    if (wasMirrored)
+        contentAliases.erase(alias);
+
+    auto fileInformation = getFileInformation(fileId);
+    if (!fileInformation)
+        return false;
+
+    // The files which do not preload whole stream their end first, from
+    // their own reversed data
+    fileInformation->maxOffset = maxOffset;
+    fileInformation->preloadRatio = preloadRatio;
+    const FileInformation dataInformation = getDataInformation(*fileInformation);
+    if (getFramesToPreload(dataInformation, fileId) <= static_cast<uint32_t>(dataInformation.end))
+        return false;
+
+    const auto end = static_cast<uint32_t>(fileInformation->end);
+    if (!preloadFile(forwardId, end, preloadRatio))
+        return false;
+
+    const FileId& contentId = getContentId(forwardId);
+    const auto forward = preloadedFiles.find(contentId);
+    if (forward == preloadedFiles.end() || !forward->second.fullyLoaded)
+        return false;
+
+    DBG("[sfizz] " << fileId.filename() << " plays its forward data backward");
+    forward->second.mirrored = true;
+    contentAliases.emplace(fileId, contentId);
+    if (!wasMirrored)
+        ++filesGeneration;
+    return true;
+}
+
+bool sfz::FilePool::preloadFile(const FileId& requestedId, uint32_t maxOffset, float preloadRatio, bool deferred, int64_t loopEnd,
+    const std::vector<FrameRange>& startRanges) noexcept
+{
+    const FileId fileId = deduplicate ? deduplicateFile(requestedId) : requestedId;
+
+    const auto loadedFile = loadedFiles.find(fileId);
+    if (loadedFile != loadedFiles.end()) {
+        loadedFile->second.preloadCallCount++;
+        return true;
+    }
+
+    if (fileId.isReverse() && !deferred && preloadMirroredFile(fileId, maxOffset, preloadRatio))
+        return true;
+
+    auto fileInformation = getFileInformation(fileId);
+    if (!fileInformation)
+        return false;
+
+    // The data which reversed files read backward stays whole
+    const auto mirroredFile = preloadedFiles.find(fileId);
+    const bool keepWhole = mirroredFile != preloadedFiles.end() && mirroredFile->second.mirrored;
+    const std::vector<FrameRange> noRanges;
+    const std::vector<FrameRange>& ranges = keepWhole ? noRanges : startRanges;
+    if (keepWhole)
+        maxOffset = max(maxOffset, static_cast<uint32_t>(fileInformation->end));
+
+    fileInformation->maxOffset = maxOffset;
+    fileInformation->preloadRatio = preloadRatio;
+    fileInformation = getDataInformation(*fileInformation);
+    const fs::path file { rootDirectory / fileId.filename() };
+
+    const auto frames = static_cast<uint32_t>(fileInformation->end + 1);
+    const auto framesToLoad = getFramesToPreload(*fileInformation, fileId);
+
+    // With the margin of the interpolators past the loop end
+    const size_t streamLimit = (loopEnd < 0) ? std::numeric_limits<size_t>::max() :
+        static_cast<size_t>(std::llround(loopEnd * fileInformation->resampleRatio)) + 1 + config::excessFileFrames;
+
+    const auto existingFile = preloadedFiles.find(fileId);
+    if (existingFile != preloadedFiles.end() && existingFile->second.mappedFile) {
+        existingFile->second.information.maxOffset = max(existingFile->second.information.maxOffset, fileInformation->maxOffset);
+        existingFile->second.preloadCallCount++;
+        return true;
+    }
+
+    if (existingFile == preloadedFiles.end() && memoryMapped && !fileId.isReverse()
+        && fileInformation->resampleRatio == 1.0) {
+        if (auto mappedFile = MappedAudioFile::open(file)) {
+            if (mappedFile->getData().size() == frames) {
+                ++filesGeneration;
+        auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
+                    std::make_shared<FileAudioBuffer>(),
+                    *fileInformation
+                });
+                auto& fileData = insertedPair.first->second;
+                fileData.mappedFile = std::move(mappedFile);
+                fileData.streamLimit = streamLimit;
+                fileData.preloadCallCount++;
+                fileData.status = FileData::Status::Preloaded;
+                fileData.fullyLoaded = true;
+                measureEnvelope(fileData, fileId);
+                return true;
+            }
+        }
+    }
+
+    if (existingFile != preloadedFiles.end()) {
+        auto& fileData = existingFile->second;
+        const bool wasDeferred = fileData.status == FileData::Status::Deferred;
+        if (wasDeferred && deferred) {
+            fileData.information = *fileInformation;
+            fileData.startRanges = ranges;
+        }
+        else if (framesToLoad > fileData.getNumPreloadedFrames() || ranges != fileData.startRanges) {
+            fileData.information.maxOffset = maxOffset;
+            fileData.information.preloadRatio = preloadRatio;
+            fileData.startRanges = ranges;
+            setSharedPreload(fileData, file, fileId.isReverse(), framesToLoad);
+            fileData.fullyLoaded = fileData.preloadsWholeFile();
+            measureEnvelope(fileData, fileId);
+            prepareStreamSource(fileData, fileId);
+        }
+        if (wasDeferred && !deferred)
+            fileData.status = FileData::Status::Preloaded;
+        fileData.streamLimit = streamLimit;
+        fileData.preloadCallCount++;
+    } else if (deferred) {
+        ++filesGeneration;
+        auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
+            FileAudioBufferPtr(),
+            *fileInformation
+        });
+        auto& fileData = insertedPair.first->second;
+        fileData.startRanges = ranges;
+        fileData.streamLimit = streamLimit;
+        fileData.preloadCallCount++;
+        fileData.status = FileData::Status::Deferred;
+    } else {
+        ++filesGeneration;
+        auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
+            FileAudioBufferPtr(),
+            *fileInformation
+        });
+
+        auto& fileData = insertedPair.first->second;
+        fileData.startRanges = ranges;
+        setSharedPreload(fileData, file, fileId.isReverse(), framesToLoad);
+        fileData.streamLimit = streamLimit;
+        fileData.preloadCallCount++;
+        fileData.status = FileData::Status::Preloaded;
+        fileData.fullyLoaded = fileData.preloadsWholeFile();
+        measureEnvelope(fileData, fileId);
+        prepareStreamSource(fileData, fileId);
+    }
+
+    return true;
+}
+
+namespace {
+
+/**
+ * @brief Read all the bytes of a file, as they are.
+ */
+std::shared_ptr<const std::vector<char>> readEncodedData(const fs::path& file)
+{
+    std::error_code ec;
+    const uint64_t fileSize = fs::file_size(file, ec);
+    fs::ifstream stream { file, std::ios::binary };
+    if (ec || !stream)
+        return {};
+
+    auto data = std::make_shared<std::vector<char>>(static_cast<size_t>(fileSize));
+    if (!stream.read(data->data(), static_cast<std::streamsize>(data->size())))
+        return {};
+
+    return data;
+}
+
+/**
+ * @brief Add the usage of a file since the usage profile was set into a
+ * profile, in the frames of the file.
+ */
+void recordUsage(sfz::UsageProfile& profile, const sfz::FileId& fileId, const sfz::FileData& data)
+{
+    const uint32_t numPlays = data.numPlays.load(std::memory_order_relaxed);
+    if (numPlays == 0)
+        return;
+
+    sfz::FileUsage usage;
+    usage.numPlays = numPlays;
+    usage.playedFrames = static_cast<uint64_t>(std::ceil(
+        data.playedFrames.load(std::memory_order_relaxed) / data.information.resampleRatio));
+    profile.record(fileId, usage);
+}
+
+} // namespace
+
+void sfz::FilePool::prepareStreamSource(FileData& data, const FileId& fileId) noexcept
+{
+    if (data.fullyLoaded || data.mappedFile) {
+        data.encodedData.reset();
+        closeReadahead(data);
+        return;
+    }
+
+    const fs::path file { rootDirectory / fileId.filename() };
+    if (encodedInRam) {
+        closeReadahead(data);
+        if (!data.encodedData)
+            data.encodedData = readEncodedData(file);
+        if (data.encodedData)
+            return;
+    }
+    else
+        data.encodedData.reset();
+
+    // The reversed files stream from their end, after decoding them whole
+    if (fileId.isReverse()) {
+        closeReadahead(data);
+        return;
+    }
+
+    if (!data.readaheadFile) {
+        if (numReadaheadFiles.fetch_add(1) >= config::maxReadaheadFiles) {
+            --numReadaheadFiles;
+            return;
+        }
+        data.readaheadFile = AsyncFileIO::File::open(file);
+        if (!data.readaheadFile) {
+            --numReadaheadFiles;
+            return;
+        }
+    }
+
+    // The frames of the data after the head, in the frames of the file
+    const FileInformation& information = data.information;
+    const auto headFrames = static_cast<uint64_t>(data.getPreloadSegment(0).end / information.resampleRatio);
+    RawAudioLayout layout;
+    if (getRawAudioLayout(file, layout)) {
+        data.readaheadOffset = layout.dataOffset + headFrames * layout.bytesPerFrame();
+    } else {
+        // The compressed files are read ahead from the same fraction of the file
+        std::error_code ec;
+        const uint64_t fileSize = fs::file_size(file, ec);
+        const auto numFrames = static_cast<uint64_t>(information.end + 1);
+        data.readaheadOffset = (ec || numFrames == 0) ? 0 :
+            static_cast<uint64_t>(static_cast<double>(fileSize) * headFrames / numFrames);
+    }
+}
+
+void sfz::FilePool::closeReadahead(FileData& data) noexcept
+{
+    if (!data.readaheadFile)
+        return;
+
+    data.readaheadFile.reset();
+    --numReadaheadFiles;
+}
+
+void sfz::FilePool::resetPreloadCallCounts() noexcept
+{
+    for (auto& preloadedFile: preloadedFiles) {
+        preloadedFile.second.preloadCallCount = 0;
+        preloadedFile.second.mirrored = false;
+    }
+
+    for (auto& loadedFile: loadedFiles)
+        loadedFile.second.preloadCallCount = 0;
+}
+
+void sfz::FilePool::removeUnusedPreloadedData() noexcept
+{
+    for (auto it = preloadedFiles.begin(), end = preloadedFiles.end(); it != end; ) {
+        auto copyIt = it++;
+        if (copyIt->second.preloadCallCount == 0) {
+            DBG("[sfizz] Removing unused preloaded data: " << copyIt->first.filename());
+            recordUsage(removedUsage, copyIt->first, copyIt->second);
+            closeReadahead(copyIt->second);
+            preloadedFiles.erase(copyIt);
+            ++filesGeneration;
+        }
+    }
+
+    for (auto it = loadedFiles.begin(), end = loadedFiles.end(); it != end; ) {
+        auto copyIt = it++;
+        if (copyIt->second.preloadCallCount == 0) {
+            DBG("[sfizz] Removing unused loaded data: " << copyIt->first.filename());
+            recordUsage(removedUsage, copyIt->first, copyIt->second);
+            loadedFiles.erase(copyIt);
+            ++filesGeneration;
+        }
+    }
+
+    forgetRemovedContents();
+}
+
+sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
+{
+    auto fileInformation = getFileInformation(fileId);
+    if (!fileInformation)
+        return {};
 
     const auto existingFile = loadedFiles.find(fileId);
     if (existingFile != loadedFiles.end()) {
@@ -395,158 +2018,967 @@ sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
         return { &existingFile->second };
     }
 
-    const fs::path file { rootDirectory / fileId.filename() };
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+    const fs::path file { rootDirectory / fileId.filename() };
+
+    const FileInformation dataInformation = getDataInformation(*fileInformation);
+    const auto frames = static_cast<uint32_t>(dataInformation.end + 1);
+    ++filesGeneration;
+    auto insertedPair = loadedFiles.insert_or_assign(fileId, {
+        std::make_shared<FileAudioBuffer>(readPreload(file, fileId.isReverse(), frames, getResampleRate(dataInformation))),
+        dataInformation
+    });
+    insertedPair.first->second.preloadCallCount++;
+    insertedPair.first->second.status = FileData::Status::Preloaded;
+    insertedPair.first->second.fullyLoaded = true;
+    measureEnvelope(insertedPair.first->second, fileId);
+    return { &insertedPair.first->second };
+}
+
+sfz::FileDataHolder sfz::FilePool::loadFromRam(const FileId& fileId, const std::vector<char>& data) noexcept
+{
+    const auto loaded = loadedFiles.find(fileId);
+    if (loaded != loadedFiles.end())
+        return { &loaded->second };
+
+    const SampleMemory::NodeScope nodeScope { numaNode };
+    auto reader = createAudioReaderFromMemory(data.data(), data.size(), fileId.isReverse());
+    auto fileInformation = getReaderInformation(reader.get());
+    if (!fileInformation)
+        return {};
+
+    const FileInformation dataInformation = getDataInformation(*fileInformation);
+    if (const double resampleRate = getResampleRate(dataInformation))
+        reader = createDataReader(std::move(reader), resampleRate);
+    const auto frames = static_cast<uint32_t>(reader->frames());
+    ++filesGeneration;
+    auto insertedPair = loadedFiles.insert_or_assign(fileId, {
+        std::make_shared<FileAudioBuffer>(readFromFile(*reader, frames)),
+        dataInformation
+    });
+    insertedPair.first->second.preloadCallCount++;
+    insertedPair.first->second.status = FileData::Status::Preloaded;
+    insertedPair.first->second.fullyLoaded = true;
+    insertedPair.first->second.envelope.resize(frames);
+    insertedPair.first->second.envelope.measure(AudioSpan<const float>(*insertedPair.first->second.preloadedData), frames);
+    DBG("Added a file " << fileId.filename());
+    return { &insertedPair.first->second };
+}
+
+sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId, uint64_t startFrame, float pitchRatio, float startDelay) noexcept
+{
+    FileSlot slot;
+    return getFilePromise(fileId, slot, startFrame, pitchRatio, startDelay);
+}
+
+void sfz::FilePool::resolveFile(const FileId& fileId, FileSlot& slot) noexcept
+{
+    slot.generation = filesGeneration;
+
+    const auto loaded = loadedFiles.find(fileId);
+    if (loaded != loadedFiles.end()) {
+        slot.data = &loaded->second;
+        slot.id = &loaded->first;
+        slot.mirrored = false;
+        slot.loaded = true;
+        return;
+    }
+
+    const auto preloaded = preloadedFiles.find(getContentId(fileId));
+    slot.data = (preloaded != preloadedFiles.end()) ? &preloaded->second : nullptr;
+    slot.id = (preloaded != preloadedFiles.end()) ? &preloaded->first : nullptr;
+    slot.mirrored = slot.id && fileId.isReverse() && !slot.id->isReverse();
+    slot.loaded = false;
+}
+
+sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId, FileSlot& slot, uint64_t startFrame, float pitchRatio, float startDelay) noexcept
+{
+    if (slot.generation != filesGeneration)
+        resolveFile(*fileId, slot);
+
+    if (slot.data)
+        slot.data->recordPlay();
+
+    if (slot.loaded)
+        return { slot.data };
+
+    if (!slot.data) {
+        DBG("[sfizz] File not found in the preloaded files: " << fileId->filename());
+        return {};
+    }
+
+    auto& fileData = *slot.data;
+    if (slot.mirrored)
+        return fileData.fullyLoaded ? FileDataHolder { &fileData, nullptr, true } : FileDataHolder {};
+
+    const auto status = fileData.status.load();
+    if (status == FileData::Status::Deferred || status == FileData::Status::Preloading) {
+        requestPreload(*fileId);
+        return {};
+    }
+
+    if (!fileData.fullyLoaded) {
+        startFrame = static_cast<uint64_t>(std::llround(startFrame * fileData.information.resampleRatio));
+        const double framesPerSecond = pitchRatio * fileData.information.sampleRate;
+        double originOffset = startDelay;
+        if (framesPerSecond > 0.0)
+            originOffset -= static_cast<double>(startFrame) / framesPerSecond;
+        const TimePoint origin = highResNow() + std::chrono::duration_cast<TimePoint::duration>(
+            Duration(originOffset));
+
+        // In the bounded mode, give the player a stream of its own
+        FileStream* stream = nullptr;
+        const bool streamedWhole = fileData.status == FileData::Status::Done;
+        if (streamingWindow > 0 && !streamedWhole && freeFileStreams->try_pop(stream)) {
+            stream->availableFrames = 0;
+            stream->playPosition = static_cast<int64_t>(startFrame);
+            stream->residentStart = 0;
+            stream->residentEnd = 0;
+            stream->throttled = false;
+            stream->released = false;
+            stream->window = streamingWindow;
+        }
+
+        QueuedFileData queuedData { slot.id, &fileData, stream, origin, framesPerSecond };
+        if (!filesToLoad->try_push(queuedData)) {
+            DBG("[sfizz] Could not enqueue the file to load for " << fileId << " (queue capacity " << filesToLoad->capacity() << ")");
+            if (stream)
+                freeFileStreams->push(stream);
+            return {};
+        }
+
+        wakeDispatch();
+
+        return { &fileData, stream };
+    }
+
+    return { &fileData };
+}
+
+bool sfz::FilePool::prewarmFile(const std::shared_ptr<FileId>& fileId) noexcept
+{
+    if (streamingWindow > 0 || immediateRelease)
+        return false;
+
+    const auto preloaded = preloadedFiles.find(getContentId(*fileId));
+    if (preloaded == preloadedFiles.end())
+        return false;
+
+    auto& fileData = preloaded->second;
+    if (fileData.fullyLoaded || fileData.status != FileData::Status::Preloaded)
+        return false;
+
+    // Keep the streamed data from the garbage collection until it plays
+    const TimePoint now = highResNow();
+    fileData.lastViewerLeftAt = now;
+    const TimePoint origin = now + std::chrono::duration_cast<TimePoint::duration>(
+        Duration(config::prewarmDelay));
+
+    QueuedFileData queuedData { &preloaded->first, &fileData, nullptr, origin, 0.0 };
+    if (!filesToLoad->try_push(queuedData))
+        return false;
+
+    wakeDispatch();
+    return true;
+}
+
+bool sfz::FilePool::requestPreload(const FileId& fileId) noexcept
+{
+    const auto preloaded = preloadedFiles.find(getContentId(fileId));
+    if (preloaded == preloadedFiles.end())
+        return false;
+
+    auto& fileData = preloaded->second;
+    auto status = FileData::Status::Deferred;
+    if (!fileData.status.compare_exchange_strong(status, FileData::Status::Preloading))
+        return false;
+
+    if (!preloadsToLoad->try_push(QueuedPreload { &preloaded->first, &fileData })) {
+        DBG("[sfizz] Could not enqueue the preload of " << fileId.filename());
+        fileData.status = FileData::Status::Deferred;
+        return false;
+    }
+
+    if (!scheduler->notify(*preloadTask, TaskScheduler::Priority::Low))
+        DBG("[sfizz] Could not schedule the deferred preloads");
+    return true;
+}
+
+bool sfz::FilePool::isPreloadDeferred(const FileId& fileId) const noexcept
+{
+    const auto preloaded = preloadedFiles.find(getContentId(fileId));
+    if (preloaded == preloadedFiles.end())
+        return false;
+
+    const auto status = preloaded->second.status.load();
+    return status == FileData::Status::Deferred || status == FileData::Status::Preloading;
+}
+
+void sfz::FilePool::releaseStreamLimit(FileData& data) noexcept
+{
+    if (data.streamLimit.exchange(std::numeric_limits<size_t>::max()) != std::numeric_limits<size_t>::max())
+        wakeDispatch();
+}
+
+void sfz::FilePool::preloadJob() noexcept
+{
+    QueuedPreload queued;
+    while (preloadsToLoad->try_pop(queued)) {
+        FileData& fileData = *queued.data;
+        const FileId& fileId = *queued.id;
+        const fs::path file { rootDirectory / fileId.filename() };
+        setSharedPreload(fileData, file, fileId.isReverse(), getFramesToPreload(fileData.information, fileId));
+        fileData.fullyLoaded = fileData.preloadsWholeFile();
+        measureEnvelope(fileData, fileId);
+        prepareStreamSource(fileData, fileId);
+        fileData.lastViewerLeftAt = highResNow();
+        fileData.status = FileData::Status::Preloaded;
+    }
+}
+
+void sfz::FilePool::settleDeferredPreloads() noexcept
+{
+    TaskScheduler::wait(*preloadTask);
+
+    QueuedPreload queued;
+    while (preloadsToLoad->try_pop(queued))
+        queued.data->status = FileData::Status::Deferred;
+}
+
+void sfz::FilePool::setSampleRate(double sampleRate) noexcept
+{
+    if (sampleRate == this->sampleRate)
+        return;
+
+    this->sampleRate = sampleRate;
+    if (resampling)
+        reloadFileData();
+}
+
+void sfz::FilePool::setOversamplingFactor(Oversampling factor) noexcept
+{
+    if (factor == oversamplingFactor)
+        return;
+
+    oversamplingFactor = factor;
+    reloadFileData();
+}
+
+void sfz::FilePool::reloadFileData() noexcept
+{
+    // The streamed data is at the former rate
+    emptyFileLoadingQueues();
+    for (auto& preloadedFile : preloadedFiles) {
+        auto& fileData = preloadedFile.second;
+        fileData.availableFrames = 0;
+        fileData.fileData.reset();
+        if (fileData.status != FileData::Status::Deferred)
+            fileData.status = FileData::Status::Preloaded;
+    }
+
+    for (auto& preloadedFile : preloadedFiles) {
+        auto& fileId = preloadedFile.first;
+        auto& fileData = preloadedFile.second;
+        auto fileInformation = getFileInformation(fileId);
+        if (fileData.mappedFile || !fileInformation)
+            continue;
+        fileInformation->maxOffset = fileData.information.maxOffset;
+        fileInformation->preloadRatio = fileData.information.preloadRatio;
+        fileData.information = getDataInformation(*fileInformation);
+        fileData.envelope = SampleEnvelope();
+        if (fileData.status == FileData::Status::Deferred)
+            continue;
+        fs::path file { rootDirectory / fileId.filename() };
+        setSharedPreload(fileData, file, fileId.isReverse(), getFramesToPreload(fileData.information, fileId));
+        fileData.fullyLoaded = fileData.preloadsWholeFile();
+        measureEnvelope(fileData, fileId);
+        prepareStreamSource(fileData, fileId);
+    }
+
+    for (auto& loadedFile : loadedFiles) {
+        auto& fileId = loadedFile.first;
+        auto& fileData = loadedFile.second;
+        auto fileInformation = getFileInformation(fileId);
+        if (!fileInformation)
+            continue;
+        fileData.information = getDataInformation(*fileInformation);
+        fs::path file { rootDirectory / fileId.filename() };
+        const auto frames = static_cast<uint32_t>(fileData.information.end + 1);
+        fileData.preloadedData = std::make_shared<FileAudioBuffer>(
+            readPreload(file, fileId.isReverse(), frames, getResampleRate(fileData.information)));
+        fileData.envelope = SampleEnvelope();
+        measureEnvelope(fileData, fileId);
+    }
+}
+
+void sfz::FilePool::setPreloadSize(uint32_t preloadSize) noexcept
+{
+    this->preloadSize = preloadSize;
+    if (loadInRam)
+        return;
+
+    resizePreloads();
+}
+
+void sfz::FilePool::setAdaptivePreloading(bool adaptive) noexcept
+{
+    if (adaptive == adaptivePreloading)
+        return;
+
+    adaptivePreloading = adaptive;
+    adaptiveLatency = 0.0;
+    if (adaptive)
+        updateAdaptivePreloading();
+    else if (!loadInRam)
+        resizePreloads();
+}
+
+bool sfz::FilePool::updateAdaptivePreloading() noexcept
+{
+    if (loadInRam || !updateAdaptiveLatency())
+        return false;
+
+    resizePreloads();
+    return true;
+}
+
+bool sfz::FilePool::updateAdaptiveLatency() noexcept
+{
+    if (!adaptivePreloading)
+        return false;
+
+    const double latency = getStreamingLatency(config::adaptivePreloadPercentile);
+    if (latency <= 0.0)
+        return false;
+
+    const double target = latency * config::adaptivePreloadMargin;
+    if (adaptiveLatency > 0.0 && target < adaptiveLatency * config::adaptivePreloadHysteresis
+        && target * config::adaptivePreloadHysteresis > adaptiveLatency)
+        return false;
+
+    // Halve the past measures, so that the changes of the storage show
+    for (auto& bucket : latencyBuckets)
+        bucket.store(bucket.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+
+    adaptiveLatency = target;
+    return true;
+}
+
+void sfz::FilePool::recordStreamingLatency(uint64_t nanoseconds) noexcept
+{
+    size_t bucket = 0;
+    for (uint64_t units = nanoseconds / 100000; units > 0 && bucket + 1 < numLatencyBuckets; units >>= 1)
+        ++bucket;
+    latencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    numFirstSlices.fetch_add(1, std::memory_order_relaxed);
+    totalFirstSliceNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    uint64_t maxNanoseconds = maxFirstSliceNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > maxNanoseconds
+        && !maxFirstSliceNanoseconds.compare_exchange_weak(maxNanoseconds, nanoseconds, std::memory_order_relaxed))
+        ;
+}
+
+double sfz::FilePool::getStreamingLatency(double percentile) const noexcept
+{
+    std::array<uint32_t, numLatencyBuckets> counts;
+    uint64_t numMeasures = 0;
+    for (size_t i = 0; i < numLatencyBuckets; ++i) {
+        counts[i] = latencyBuckets[i].load(std::memory_order_relaxed);
+        numMeasures += counts[i];
+    }
+    if (numMeasures < config::adaptivePreloadMinMeasures)
+        return 0.0;
+
+    const auto rank = static_cast<uint64_t>(std::ceil(clamp(percentile, 0.0, 1.0) * numMeasures));
+    uint64_t numBelow = 0;
+    size_t bucket = 0;
+    for (; bucket + 1 < numLatencyBuckets; ++bucket) {
+        numBelow += counts[bucket];
+        if (numBelow >= rank)
+            break;
+    }
+    return 1e-4 * static_cast<double>(uint64_t(1) << bucket);
+}
+
+void sfz::FilePool::copyLatencies(const FilePool& other) noexcept
+{
+    for (size_t i = 0; i < numLatencyBuckets; ++i)
+        latencyBuckets[i].store(other.latencyBuckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    adaptiveLatency = other.adaptiveLatency;
+}
+
+void sfz::FilePool::resizePreloads() noexcept
+{
+    // Update all the preloaded sizes
+    settleDeferredPreloads();
+    for (auto& preloadedFile : preloadedFiles) {
+        auto& fileId = preloadedFile.first;
+        auto& fileData = preloadedFile.second;
+        if (fileData.mappedFile || fileData.status == FileData::Status::Deferred)
+            continue;
+        fs::path file { rootDirectory / fileId.filename() };
+        const auto framesToLoad = getFramesToPreload(fileData.information, fileId);
+        // Shorter heads would find the longer ones which this file holds
+        if (fileData.getNumPreloadedFrames() > framesToLoad) {
+            fileData.preloadedData.reset();
+            fileData.compactPreloadedData.reset();
+        }
+        setSharedPreload(fileData, file, fileId.isReverse(), framesToLoad);
+        fileData.fullyLoaded = fileData.preloadsWholeFile();
+        measureEnvelope(fileData, fileId);
+        prepareStreamSource(fileData, fileId);
+    }
+
+    applyMemoryBudget();
+}
+
+void sfz::FilePool::loadingJob(StreamJob& job) noexcept
+{
+    job.finished = streamSlice(job);
+    job.sliceDone = true;
+
+    wakeDispatch();
+}
+
+bool sfz::FilePool::streamSlice(StreamJob& job) noexcept
+{
+    FileStream* stream = job.request.stream;
+    if (stream && stream->released)
+        return true;
+
+    if (!job.started && !startStream(job, *job.request.id))
+        return true;
+
+    const size_t sliceFrames = beginSlice(job);
+    if (job.paused)
+        return false;
+
+    bool over;
+    if (job.rawFile) {
+        const size_t numBytes = sliceFrames * job.rawLayout.bytesPerFrame();
+        job.rawData.resize(numBytes);
+        const auto offset = job.rawLayout.dataOffset + job.numStreamedFrames * job.rawLayout.bytesPerFrame();
+        const int64_t result = job.rawFile->read(offset, job.rawData.data(), numBytes);
+        over = decodeRawSlice(job, result > 0 ? static_cast<size_t>(result) : 0);
+    }
+    else if (stream)
+        over = streamFromFile(*job.reader, stream->buffer, job.numStreamedFrames, sliceFrames, &stream->availableFrames);
+    else {
+        FileData& data = *job.request.data;
+        over = streamFromFile(*job.reader, data.fileData, job.numStreamedFrames, sliceFrames, &data.availableFrames);
+    }
+
+    return endSlice(job, over);
+}
+
+bool sfz::FilePool::startStream(StreamJob& job, const FileId& id) noexcept
+{
+    const SampleMemory::NodeScope nodeScope { numaNode };
+    const fs::path file { rootDirectory / id.filename() };
+    std::error_code readError;
+    AudioReaderPtr reader;
+    job.encodedData = job.request.data->encodedData;
+    if (job.encodedData)
+        reader = createAudioReaderFromMemory(job.encodedData->data(), job.encodedData->size(), id.isReverse(), &readError);
+    else if (streamReaderFactory)
+        reader = streamReaderFactory(file, id.isReverse(), &readError);
+    else
+        reader = createAudioReader(file, id.isReverse(), &readError);
+
+    if (readError || !reader) {
+        DBG("[sfizz] reading the file errored for " << id << " with code " << readError << ": " << readError.message());
+        return false;
+    }
+
+    const double resampleRate = getResampleRate(job.request.data->information);
+    if (resampleRate > 0.0)
+        reader = createDataReader(std::move(reader), resampleRate);
 
-    const auto frames = static_cast<uint32_t>(reader->frames());
-    auto insertedPair = loadedFiles.insert_or_assign(fileId, {
-        readFromFile(*reader, frames),
-        *fileInformation
-    });
-    insertedPair.first->second.preloadCallCount++;
-    insertedPair.first->second.status = FileData::Status::Preloaded;
-    insertedPair.first->second.fullyLoaded = true;
-    return { &insertedPair.first->second };
+    if (FileStream* stream = job.request.stream) {
+        if (!stream->buffer.allocate(reader->channels(), static_cast<size_t>(reader->frames()))) {
+            DBG("[sfizz] Cannot allocate the stream buffer for " << id);
+            return false;
+        }
+    }
+    else {
+        FileData& data = *job.request.data;
+        FileData::Status currentStatus;
+
+        unsigned spinCounter { 0 };
+
+        while (1) {
+            currentStatus = data.status.load();
+            while (currentStatus == FileData::Status::Invalid) {
+                // Spin until the state changes
+                if (spinCounter > 1024) {
+                    DBG("[sfizz] " << id << " is stuck on Invalid? Leaving the load");
+                    return false;
+                }
+
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                currentStatus = data.status.load();
+                spinCounter += 1;
+            }
+            // wait for garbage collection
+            if (currentStatus == FileData::Status::GarbageCollecting) {
+                atomic_queue::spin_loop_pause();
+                atomic_queue::spin_loop_pause();
+                atomic_queue::spin_loop_pause();
+                atomic_queue::spin_loop_pause();
+                continue;
+            }
+            // Already loading or loaded
+            if (currentStatus != FileData::Status::Preloaded)
+                return false;
+
+            // go outside loop if this gets token
+            if (data.status.compare_exchange_strong(currentStatus, FileData::Status::Streaming))
+                break;
+        }
+
+        prepareStream(*reader, data.fileData, data.streamLimit);
+    }
+
+    // The uncompressed files are read by offset, which the asynchronous I/O
+    // can do for many files at once
+    RawAudioLayout layout;
+    if (asyncIO && asyncStreaming && !streamReaderFactory && !job.encodedData && !id.isReverse() && resampleRate == 0.0 && getRawAudioLayout(file, layout)
+        && layout.frames == static_cast<uint64_t>(reader->frames()) && layout.channels == reader->channels()) {
+        // The file may be kept open already
+        job.rawFile = job.request.data->readaheadFile;
+        if (!job.rawFile)
+            job.rawFile = AsyncFileIO::File::open(file);
+        job.rawLayout = layout;
+    }
+
+    if (!job.rawFile)
+        job.reader = std::move(reader);
+
+    job.started = true;
+    return true;
 }
 
-sfz::FileDataHolder sfz::FilePool::loadFromRam(const FileId& fileId, const std::vector<char>& data) noexcept
+size_t sfz::FilePool::beginSlice(StreamJob& job) noexcept
 {
-    const auto loaded = loadedFiles.find(fileId);
-    if (loaded != loadedFiles.end())
-        return { &loaded->second };
+    const size_t sliceSize = static_cast<size_t>(config::streamSliceSize);
+    FileStream* stream = job.request.stream;
+    if (!stream) {
+        // The looped files pause at the loop end until released, and in
+        // the immediate release the files which nobody plays anymore
+        FileData& data = *job.request.data;
+        const size_t endFrame = min(data.fileData.getNumFrames(), data.streamLimit.load());
+        const bool atLimit = job.numStreamedFrames >= endFrame && endFrame < data.fileData.getNumFrames();
+        if (atLimit || (immediateRelease && data.readerCount == 0)) {
+            job.paused = true;
+            data.streamPaused = true;
+            addLastUsedFile(job);
+            return 0;
+        }
+        return min(sliceSize, endFrame - job.numStreamedFrames);
+    }
 
-    auto reader = createAudioReaderFromMemory(data.data(), data.size(), fileId.isReverse());
-    auto fileInformation = getReaderInformation(reader.get());
-    const auto frames = static_cast<uint32_t>(reader->frames());
-    auto insertedPair = loadedFiles.insert_or_assign(fileId, {
-        readFromFile(*reader, frames),
-        *fileInformation
-    });
-    insertedPair.first->second.preloadCallCount++;
-    insertedPair.first->second.status = FileData::Status::Preloaded;
-    insertedPair.first->second.fullyLoaded = true;
-    DBG("Added a file " << fileId.filename());
-    return { &insertedPair.first->second };
+    // Give back the frames behind the play head, except the loop segment
+    const int64_t position = max(stream->playPosition.load(), int64_t(0));
+    const size_t releaseEnd = min(job.numStreamedFrames,
+        static_cast<size_t>(max(position - config::streamReleaseMargin, int64_t(0))));
+    const size_t loopStart = static_cast<size_t>(max(stream->residentStart.load(), int64_t(0)));
+    const size_t loopEnd = static_cast<size_t>(max(stream->residentEnd.load(), int64_t(0)));
+    if (releaseEnd > job.numReleasedFrames) {
+        if (loopEnd > loopStart) {
+            stream->buffer.release(job.numReleasedFrames, min(releaseEnd, loopStart));
+            stream->buffer.release(max(job.numReleasedFrames, loopEnd), releaseEnd);
+        }
+        else
+            stream->buffer.release(job.numReleasedFrames, releaseEnd);
+        job.numReleasedFrames = releaseEnd;
+    }
+
+    // Stream up to the window ahead of the play head
+    size_t windowEnd = static_cast<size_t>(position) + stream->window;
+    if (job.numStreamedFrames >= windowEnd) {
+        // Pause, unless the player moved on before seeing the flag
+        stream->throttled = true;
+        windowEnd = static_cast<size_t>(max(stream->playPosition.load(), int64_t(0))) + stream->window;
+        if (job.numStreamedFrames >= windowEnd) {
+            job.paused = true;
+            return 0;
+        }
+        stream->throttled = false;
+    }
+
+    return min(sliceSize, windowEnd - job.numStreamedFrames,
+        stream->buffer.getNumFrames() - job.numStreamedFrames);
 }
 
-sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId) noexcept
+bool sfz::FilePool::endSlice(StreamJob& job, bool over) noexcept
 {
-    const auto loaded = loadedFiles.find(*fileId);
-    if (loaded != loadedFiles.end())
-        return { &loaded->second };
-
-    const auto preloaded = preloadedFiles.find(*fileId);
-    if (preloaded == preloadedFiles.end()) {
-        DBG("[sfizz] File not found in the preloaded files: " << fileId->filename());
-        return {};
+    if (job.numStreamedFrames > job.numCountedFrames) {
+        const size_t numChannels = job.request.stream ?
+            job.request.stream->buffer.getNumChannels() : job.request.data->fileData.getNumChannels();
+        const size_t numFrames = job.numStreamedFrames - job.numCountedFrames;
+        numStreamedBytes.fetch_add(numFrames * numChannels * sizeof(float), std::memory_order_relaxed);
+        if (job.numCountedFrames == 0) {
+            const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                highResNow() - job.request.queued).count();
+            recordStreamingLatency(static_cast<uint64_t>(max(latency, decltype(latency)(0))));
+        }
+        job.numCountedFrames = job.numStreamedFrames;
     }
 
-    auto& fileData = preloaded->second;
-    if (!fileData.fullyLoaded) {
-        QueuedFileData queuedData { fileId, &fileData };
-        if (!filesToLoad->try_push(queuedData)) {
-            DBG("[sfizz] Could not enqueue the file to load for " << fileId << " (queue capacity " << filesToLoad->capacity() << ")");
-            return {};
+    if (FileStream* stream = job.request.stream) {
+        const size_t loopStart = static_cast<size_t>(max(stream->residentStart.load(), int64_t(0)));
+        const size_t loopEnd = static_cast<size_t>(max(stream->residentEnd.load(), int64_t(0)));
+        size_t keptLoopFrames = 0;
+        if (loopEnd > loopStart && loopStart < job.numReleasedFrames)
+            keptLoopFrames = min(loopEnd, job.numReleasedFrames) - loopStart;
+        const size_t residentFrames = job.numStreamedFrames - job.numReleasedFrames + keptLoopFrames;
+        stream->residentBytes = residentFrames * stream->buffer.getNumChannels() * sizeof(float);
+    }
+    else {
+        FileData& data = *job.request.data;
+        data.envelope.measure(AudioSpan<const float>(data.fileData), job.numStreamedFrames);
+        if (over) {
+            data.status = FileData::Status::Done;
+            storeEnvelope(data, *job.request.id);
+            addLastUsedFile(job);
         }
+    }
 
-        std::error_code ec;
-        dispatchBarrier.post(ec);
-        ASSERT(!ec);
+    if (over) {
+        job.reader.reset();
+        job.rawFile.reset();
+        job.encodedData.reset();
     }
 
-    return { &preloaded->second };
+    return over;
 }
 
-void sfz::FilePool::setPreloadSize(uint32_t preloadSize) noexcept
+void sfz::FilePool::addLastUsedFile(const StreamJob& job) noexcept
 {
-    this->preloadSize = preloadSize;
-    if (loadInRam)
-        return;
+    // The audio thread takes them at every block, unless it stopped
+    if (!lastUsedQueue->try_push(*job.request.id))
+        DBG("[sfizz] Could not hand the last used file " << *job.request.id << " to the garbage collection");
+}
 
-    // Update all the preloaded sizes
-    for (auto& preloadedFile : preloadedFiles) {
-        auto& fileId = preloadedFile.first;
-        auto& fileData = preloadedFile.second;
-        const auto maxOffset = fileData.information.maxOffset;
-        fs::path file { rootDirectory / fileId.filename() };
-        AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
-        const auto frames = reader->frames();
-        const auto framesToLoad = min(frames, maxOffset + preloadSize);
-        fileData.preloadedData = readFromFile(*reader, static_cast<uint32_t>(framesToLoad));
-        fileData.fullyLoaded = frames == framesToLoad;
+bool sfz::FilePool::decodeRawSlice(StreamJob& job, size_t numBytes) noexcept
+{
+    const size_t sliceFrames = job.rawData.size() / job.rawLayout.bytesPerFrame();
+    const size_t numFrames = min(sliceFrames, numBytes / job.rawLayout.bytesPerFrame());
+
+    if (FileStream* stream = job.request.stream) {
+        decodeRawFrames(job.rawLayout, job.rawData.data(), numFrames, stream->buffer, job.numStreamedFrames);
+        stream->availableFrames.fetch_add(numFrames);
+        return numFrames < sliceFrames || job.numStreamedFrames >= stream->buffer.getNumFrames();
     }
+
+    FileData& data = *job.request.data;
+    decodeRawFrames(job.rawLayout, job.rawData.data(), numFrames, data.fileData, job.numStreamedFrames);
+    data.availableFrames.fetch_add(numFrames);
+    return numFrames < sliceFrames || job.numStreamedFrames >= data.fileData.getNumFrames();
 }
 
-void sfz::FilePool::loadingJob(const QueuedFileData& data) noexcept
+void sfz::FilePool::startAsyncSlice(StreamJob& job) noexcept
 {
-    raiseCurrentThreadPriority();
+    FileStream* stream = job.request.stream;
+    if (stream && stream->released) {
+        finishAsyncSlice(job, true);
+        return;
+    }
 
-    std::shared_ptr<FileId> id = data.id.lock();
-    if (!id) {
-        // file ID was nulled, it means the region was deleted, ignore
+    const size_t sliceFrames = beginSlice(job);
+    if (job.paused) {
+        finishAsyncSlice(job, false);
         return;
     }
 
-    const fs::path file { rootDirectory / id->filename() };
-    std::error_code readError;
-    AudioReaderPtr reader = createAudioReader(file, id->isReverse(), &readError);
+    const size_t numBytes = sliceFrames * job.rawLayout.bytesPerFrame();
+    const auto offset = job.rawLayout.dataOffset + job.numStreamedFrames * job.rawLayout.bytesPerFrame();
+    job.rawData.resize(numBytes);
+    job.rawBytesRead = 0;
 
-    if (readError) {
-        DBG("[sfizz] reading the file errored for " << *id << " with code " << readError << ": " << readError.message());
+    if (numBytes > 0 && asyncIO->read(*job.rawFile, offset, job.rawData.data(), numBytes, &job)) {
+        ++numAsyncReads;
         return;
     }
 
-    FileData::Status currentStatus;
-
-    unsigned spinCounter { 0 };
+    // The queue is full, read the slice here
+    const int64_t result = numBytes > 0 ? job.rawFile->read(offset, job.rawData.data(), numBytes) : 0;
+    const bool over = decodeRawSlice(job, result > 0 ? static_cast<size_t>(result) : 0);
+    finishAsyncSlice(job, endSlice(job, over));
+}
 
-    while (1) {
-        currentStatus = data.data->status.load();
-        while (currentStatus == FileData::Status::Invalid) {
-            // Spin until the state changes
-            if (spinCounter > 1024) {
-                DBG("[sfizz] " << *id << " is stuck on Invalid? Leaving the load");
+void sfz::FilePool::asyncSliceRead(StreamJob& job, int64_t result) noexcept
+{
+    const size_t numBytes = job.rawData.size();
+    if (result > 0) {
+        job.rawBytesRead += static_cast<size_t>(result);
+
+        // Continue the short reads where they stopped
+        if (job.rawBytesRead < numBytes) {
+            const auto offset = job.rawLayout.dataOffset
+                + job.numStreamedFrames * job.rawLayout.bytesPerFrame() + job.rawBytesRead;
+            unsigned char* remainder = job.rawData.data() + job.rawBytesRead;
+            const size_t remainderSize = numBytes - job.rawBytesRead;
+            if (asyncIO->read(*job.rawFile, offset, remainder, remainderSize, &job))
                 return;
-            }
-
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
-            currentStatus = data.data->status.load();
-            spinCounter += 1;
+            const int64_t remainderResult = job.rawFile->read(offset, remainder, remainderSize);
+            if (remainderResult > 0)
+                job.rawBytesRead += static_cast<size_t>(remainderResult);
         }
-        // wait for garbage collection
-        if (currentStatus == FileData::Status::GarbageCollecting) {
-            atomic_queue::spin_loop_pause();
-            atomic_queue::spin_loop_pause();
-            atomic_queue::spin_loop_pause();
-            atomic_queue::spin_loop_pause();
-            continue;
-        }
-        // Already loading or loaded
-        if (currentStatus != FileData::Status::Preloaded)
-            return;
-
-        // go outside loop if this gets token
-        if (data.data->status.compare_exchange_strong(currentStatus, FileData::Status::Streaming))
-            break;
     }
 
-    streamFromFile(*reader, data.data->fileData, &data.data->availableFrames);
+    const bool over = decodeRawSlice(job, job.rawBytesRead);
+    finishAsyncSlice(job, endSlice(job, over));
+}
+
+void sfz::FilePool::finishAsyncSlice(StreamJob& job, bool over) noexcept
+{
+    job.finished = over;
+    // Last, since the job can go away once the slice is over
+    job.sliceDone = true;
 
-    data.data->status = FileData::Status::Done;
+    wakeDispatch();
+}
 
-    std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
-    if (absl::c_find(lastUsedFiles, *id) == lastUsedFiles.end())
-        lastUsedFiles.push_back(*id);
+std::unique_ptr<sfz::AsyncFileIO> sfz::FilePool::createAsyncFileIO() noexcept
+{
+    return AsyncFileIO::create(config::asyncQueueDepth, [this](void* job, int64_t result) {
+        asyncSliceRead(*static_cast<StreamJob*>(job), result);
+    });
 }
 
 void sfz::FilePool::clear()
 {
-    std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
     emptyFileLoadingQueues();
-    garbageToCollect.clear();
+    garbageJob();
+    FileId lastUsed;
+    while (lastUsedQueue->try_pop(lastUsed))
+        ;
     lastUsedFiles.clear();
+    for (auto& file : preloadedFiles) {
+        recordUsage(removedUsage, file.first, file.second);
+        closeReadahead(file.second);
+    }
+    for (const auto& file : loadedFiles)
+        recordUsage(removedUsage, file.first, file.second);
     preloadedFiles.clear();
     loadedFiles.clear();
+    ++filesGeneration;
+    pruneSharedPreloads();
+    probedInformation.clear();
+    contentFiles.clear();
+    contentAliases.clear();
+
+    // The next files preload after the latest measures
+    updateAdaptiveLatency();
+}
+
+void sfz::FilePool::setUsageProfile(UsageProfile profile)
+{
+    usageProfile = std::move(profile);
+    removedUsage.clear();
+    for (auto* files : { &preloadedFiles, &loadedFiles }) {
+        for (auto& file : *files) {
+            file.second.numPlays = 0;
+            file.second.playedFrames = 0;
+        }
+    }
+}
+
+sfz::UsageProfile sfz::FilePool::getUsageProfile() const
+{
+    UsageProfile profile = usageProfile;
+    profile.merge(removedUsage);
+    for (const auto* files : { &preloadedFiles, &loadedFiles }) {
+        for (const auto& file : *files)
+            recordUsage(profile, file.first, file.second);
+    }
+    return profile;
+}
+
+size_t sfz::FilePool::getNumMappedSamples() const noexcept
+{
+    return static_cast<size_t>(absl::c_count_if(preloadedFiles, [](const std::pair<const FileId, FileData>& file) {
+        return file.second.mappedFile != nullptr;
+    }));
+}
+
+namespace {
+
+size_t getPreloadedBytes(const sfz::FileData& data) noexcept
+{
+    const size_t encodedBytes = data.encodedData ? data.encodedData->size() : 0;
+    if (data.compactPreloadedData)
+        return encodedBytes + data.compactPreloadedData->getNumFrames() * data.compactPreloadedData->getNumChannels() * sizeof(int16_t);
+    if (data.preloadedData)
+        return encodedBytes + data.getNumHeldFrames() * data.preloadedData->getNumChannels() * sizeof(float);
+    return encodedBytes;
+}
+
+size_t getStreamedBytes(const sfz::FileData& data) noexcept
+{
+    // The streams are sized for the whole file once started
+    const auto status = data.status.load();
+    if (status != sfz::FileData::Status::Streaming && status != sfz::FileData::Status::Done)
+        return 0;
+    const auto numFrames = min(static_cast<size_t>(data.information.end + 1), data.streamLimit.load());
+    return numFrames * static_cast<size_t>(data.information.numChannels) * sizeof(float);
+}
+
+template <class B>
+std::shared_ptr<B> copyHead(const B& buffer, size_t numFrames)
+{
+    const size_t numChannels = buffer.getNumChannels();
+    auto head = std::make_shared<B>(numChannels, numFrames);
+    for (size_t c = 0; c < numChannels; ++c) {
+        const auto input = buffer.getConstSpan(c).first(numFrames);
+        std::copy(input.begin(), input.end(), head->getSpan(c).begin());
+    }
+    return head;
+}
+
+} // namespace
+
+size_t sfz::FilePool::getMemoryUsage() const noexcept
+{
+    return getPreloadedMemory() + getStreamedMemory();
+}
+
+size_t sfz::FilePool::getPreloadedMemory() const noexcept
+{
+    size_t usage = 0;
+    for (const auto& file : preloadedFiles)
+        usage += getPreloadedBytes(file.second);
+    for (const auto& file : loadedFiles)
+        usage += getPreloadedBytes(file.second);
+    return usage;
+}
+
+size_t sfz::FilePool::getStreamedMemory() const noexcept
+{
+    size_t usage = getStreamingMemory();
+    for (const auto& file : preloadedFiles)
+        usage += getStreamedBytes(file.second);
+    return usage;
+}
+
+void sfz::FilePool::setMemoryBudget(size_t numBytes) noexcept
+{
+    memoryBudget = numBytes;
+    applyMemoryBudget();
+}
+
+void sfz::FilePool::applyMemoryBudget() noexcept
+{
+    // The last used files hold each file once, so this many never allocate
+    // on the audio thread
+    if (lastUsedFiles.capacity() < preloadedFiles.size())
+        lastUsedFiles.reserve(preloadedFiles.size());
+
+    if (memoryBudget == 0)
+        return;
+
+    size_t usage = getMemoryUsage();
+    if (usage <= memoryBudget)
+        return;
+
+    std::vector<FileData*> idleFiles;
+    idleFiles.reserve(preloadedFiles.size());
+    for (auto& file : preloadedFiles) {
+        FileData& data = file.second;
+        if (data.readerCount == 0 && !data.mappedFile)
+            idleFiles.push_back(&data);
+    }
+    std::sort(idleFiles.begin(), idleFiles.end(), [](const FileData* lhs, const FileData* rhs) {
+        return lhs->lastViewerLeftAt < rhs->lastViewerLeftAt;
+    });
+
+    // Free the streamed data first
+    for (FileData* data : idleFiles) {
+        if (usage <= memoryBudget)
+            return;
+
+        auto status = FileData::Status::Done;
+        const size_t streamedBytes = getStreamedBytes(*data);
+        if (data->status.compare_exchange_strong(status, FileData::Status::GarbageCollecting)) {
+            data->availableFrames = 0;
+            data->fileData.reset();
+            data->status = FileData::Status::Preloaded;
+            usage -= streamedBytes;
+        }
+    }
+
+    if (loadInRam)
+        return;
+
+    // Then shrink the preloaded data
+    for (FileData* data : idleFiles) {
+        if (usage <= memoryBudget)
+            return;
+
+        // The sparse preloads only hold the frames the players start on
+        if (data->status != FileData::Status::Preloaded || !data->preloadSegments.empty())
+            continue;
+
+        const int64_t frames = data->information.end + 1;
+        const auto minFrames = static_cast<size_t>(
+            min(frames, data->information.maxOffset + static_cast<int64_t>(config::minPreloadSize)));
+        if (data->getNumPreloadedFrames() <= minFrames)
+            continue;
+
+        const size_t preloadedBytes = getPreloadedBytes(*data);
+        if (data->compactPreloadedData)
+            data->compactPreloadedData = copyHead(*data->compactPreloadedData, minFrames);
+        else
+            data->preloadedData = copyHead(*data->preloadedData, minFrames);
+        data->fullyLoaded = false;
+        usage -= preloadedBytes - getPreloadedBytes(*data);
+    }
+}
+
+sfz::FilePool::UnderrunStats sfz::FilePool::getUnderrunStats() const noexcept
+{
+    UnderrunStats stats;
+    stats.numUnderruns = numUnderruns.load(std::memory_order_relaxed);
+    stats.numMissingFrames = numMissingFrames.load(std::memory_order_relaxed);
+    stats.lastRegionId = lastUnderrunRegionId.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void sfz::FilePool::resetUnderrunStats() noexcept
+{
+    numUnderruns.store(0, std::memory_order_relaxed);
+    numMissingFrames.store(0, std::memory_order_relaxed);
+    lastUnderrunRegionId.store(-1, std::memory_order_relaxed);
+}
+
+sfz::FilePool::StreamingStats sfz::FilePool::getStreamingStats() const noexcept
+{
+    StreamingStats stats;
+    stats.streamedBytes = numStreamedBytes.load(std::memory_order_relaxed);
+    stats.numStreams = numFirstSlices.load(std::memory_order_relaxed);
+    stats.totalFirstSliceLatency = 1e-9 * static_cast<double>(totalFirstSliceNanoseconds.load(std::memory_order_relaxed));
+    stats.maxFirstSliceLatency = 1e-9 * static_cast<double>(maxFirstSliceNanoseconds.load(std::memory_order_relaxed));
+    stats.collectedBytes = numCollectedBytes.load(std::memory_order_relaxed);
+    stats.numQueuedRequests = filesToLoad->was_size();
+    stats.numQueuedStreams = numQueuedStreams.load(std::memory_order_relaxed);
+    stats.numLoadingJobs = numLoadingJobs.load(std::memory_order_relaxed);
+    stats.workers = scheduler->getUtilization();
+    return stats;
+}
+
+size_t sfz::FilePool::getNumEncodedSamples() const noexcept
+{
+    return static_cast<size_t>(absl::c_count_if(preloadedFiles, [](const std::pair<const FileId, FileData>& file) {
+        return file.second.encodedData != nullptr;
+    }));
+}
+
+size_t sfz::FilePool::getNumCompactSamples() const noexcept
+{
+    return static_cast<size_t>(absl::c_count_if(preloadedFiles, [](const std::pair<const FileId, FileData>& file) {
+        return file.second.compactPreloadedData != nullptr;
+    }));
 }
 
 uint32_t sfz::FilePool::getPreloadSize() const noexcept
@@ -554,81 +2986,277 @@ uint32_t sfz::FilePool::getPreloadSize() const noexcept
     return preloadSize;
 }
 
-template <typename R>
-bool is_ready(std::future<R> const& f)
+void sfz::FilePool::collectStreamRequests() noexcept
+{
+    QueuedFileData queuedData;
+    while (filesToLoad->try_pop(queuedData)) {
+        if (queuedData.stream)
+            activeFileStreams.push_back(queuedData.stream);
+
+        const void* key = queuedData.stream ?
+            static_cast<const void*>(queuedData.stream) : static_cast<const void*>(queuedData.data);
+        auto it = streams.find(key);
+        if (it != streams.end() && isCollectedStream(*it->second)) {
+            // A new player of a file which was taken back while paused
+            pausedStreams.erase(absl::c_find(pausedStreams, it->second.get()));
+            streams.erase(it);
+            it = streams.end();
+        }
+        if (it == streams.end()) {
+            // The system reads the file ahead while the stream waits its turn
+            const FileData& data = *queuedData.data;
+            if (data.readaheadFile)
+                data.readaheadFile->willNeed(data.readaheadOffset, config::readaheadBytes);
+
+            std::unique_ptr<StreamJob> job { new StreamJob(*this) };
+            job->request = queuedData;
+            job->origin = queuedData.origin;
+            job->framesPerSecond = queuedData.framesPerSecond;
+            queueStream(*job);
+            streams.emplace(key, std::move(job));
+            continue;
+        }
+
+        // Keep the most urgent of the players of the same file
+        StreamJob& job = *it->second;
+        const TimePoint previousOrigin = job.origin;
+        const double previousFramesPerSecond = job.framesPerSecond;
+        const TimePoint previousDeadline = job.getDeadline();
+        job.origin = queuedData.origin;
+        job.framesPerSecond = queuedData.framesPerSecond;
+        if (job.getDeadline() >= previousDeadline) {
+            job.origin = previousOrigin;
+            job.framesPerSecond = previousFramesPerSecond;
+        }
+        else if (!job.running) {
+            job.deadline = job.getDeadline();
+            std::make_heap(streamQueue.begin(), streamQueue.end(), StreamJob::laterDeadline);
+        }
+    }
+}
+
+bool sfz::FilePool::isCollectedStream(const StreamJob& job) noexcept
+{
+    return job.paused && !job.running && !job.request.stream
+        && job.request.data->status == FileData::Status::Preloaded;
+}
+
+void sfz::FilePool::collectStreamSlices(bool wait) noexcept
+{
+    swapAndPopAll(loadingJobs, [this, wait](StreamJob* job) {
+        if (!wait && !job->sliceDone)
+            return false;
+
+        waitForSlice(*job);
+        job->running = false;
+        if (job->finished)
+            streams.erase(job->key());
+        else if (job->paused)
+            pausedStreams.push_back(job);
+        else
+            queueStream(*job);
+        return true;
+    });
+}
+
+void sfz::FilePool::resumeStreams() noexcept
+{
+    swapAndPopAll(pausedStreams, [this](StreamJob* job) {
+        if (!job->request.stream) {
+            FileData& data = *job->request.data;
+            const auto status = data.status.load();
+            if (status == FileData::Status::Preloaded) {
+                // The garbage collection took the idle file back
+                streams.erase(job->key());
+                return true;
+            }
+            if (status != FileData::Status::Streaming || job->numStreamedFrames >= data.streamLimit)
+                return false;
+            if (immediateRelease && data.readerCount == 0)
+                return false;
+            data.streamPaused = false;
+        } else {
+            const FileStream& stream = *job->request.stream;
+            if (stream.throttled && !stream.released)
+                return false;
+        }
+
+        job->paused = false;
+        queueStream(*job);
+        return true;
+    });
+}
+
+void sfz::FilePool::recycleFileStreams() noexcept
+{
+    swapAndPopAll(activeFileStreams, [this](FileStream* stream) {
+        if (!stream->released || streams.find(stream) != streams.end())
+            return false;
+
+        stream->buffer.reset();
+        stream->availableFrames = 0;
+        stream->residentBytes = 0;
+        freeFileStreams->push(stream);
+        return true;
+    });
+}
+
+void sfz::FilePool::queueStream(StreamJob& job) noexcept
 {
-    return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    job.deadline = job.getDeadline();
+    streamQueue.push_back(&job);
+    std::push_heap(streamQueue.begin(), streamQueue.end(), StreamJob::laterDeadline);
+}
+
+void sfz::FilePool::wakeDispatch() noexcept
+{
+    if (!scheduler->notify(*dispatchTask, TaskScheduler::Priority::High))
+        DBG("[sfizz] Could not schedule the dispatching of the streams");
 }
 
 void sfz::FilePool::dispatchingJob() noexcept
 {
-    while (dispatchBarrier.wait(), dispatchFlag) {
+    // The dispatching shares the workers with the slices
+    const size_t maxLoadingJobs = scheduler->getNumWorkers();
+
+    if (!dispatchFlag)
+        return;
+
+    {
         std::lock_guard<std::mutex> guard { loadingJobsMutex };
 
-        QueuedFileData queuedData;
-        if (filesToLoad->try_pop(queuedData)) {
-            if (queuedData.id.expired()) {
-                // file ID was nulled, it means the region was deleted, ignore
+        collectStreamRequests();
+        collectStreamSlices(false);
+        resumeStreams();
+        recycleFileStreams();
+
+        // Run the slices of the most urgent streams, on the background
+        // threads, or with the asynchronous I/O for the uncompressed files
+        size_t numAsyncSlices = static_cast<size_t>(absl::c_count_if(loadingJobs,
+            [](const StreamJob* job) { return job->runningAsync; }));
+        size_t numThreadSlices = loadingJobs.size() - numAsyncSlices;
+        while (!streamQueue.empty()
+            && (numThreadSlices < maxLoadingJobs || numAsyncSlices < config::asyncQueueDepth)) {
+            std::pop_heap(streamQueue.begin(), streamQueue.end(), StreamJob::laterDeadline);
+            StreamJob* job = streamQueue.back();
+            streamQueue.pop_back();
+
+            const bool async = job->rawFile != nullptr;
+            if (async ? numAsyncSlices >= config::asyncQueueDepth : numThreadSlices >= maxLoadingJobs) {
+                deferredStreams.push_back(job);
+                continue;
+            }
+
+            job->running = true;
+            job->sliceDone = false;
+            job->runningAsync = async;
+            if (async) {
+                loadingJobs.push_back(job);
+                ++numAsyncSlices;
+                startAsyncSlice(*job);
+            }
+            else if (scheduler->schedule(job->sliceTask, TaskScheduler::Priority::High)) {
+                loadingJobs.push_back(job);
+                ++numThreadSlices;
+            }
+            else {
+                job->running = false;
+                deferredStreams.push_back(job);
             }
-            else
-                loadingJobs.push_back(
-                    threadPool->enqueue([this](const QueuedFileData& data) { loadingJob(data); }, std::move(queuedData)));
         }
 
-        // Clear finished jobs
-        swapAndPopAll(loadingJobs, [](std::future<void>& future) {
-            return is_ready(future);
-        });
+        for (StreamJob* job : deferredStreams) {
+            streamQueue.push_back(job);
+            std::push_heap(streamQueue.begin(), streamQueue.end(), StreamJob::laterDeadline);
+        }
+        deferredStreams.clear();
+
+        numQueuedStreams.store(streamQueue.size(), std::memory_order_relaxed);
+        numLoadingJobs.store(loadingJobs.size(), std::memory_order_relaxed);
     }
 }
 
 void sfz::FilePool::garbageJob() noexcept
 {
-    while (semGarbageBarrier.wait(), garbageFlag) {
-        std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
-        garbageToCollect.clear();
+    // The buffers are freed as they leave the queue
+    FileAudioBuffer buffer;
+    while (garbageToCollect->try_pop(buffer))
+        buffer.reset();
+}
+
+void sfz::FilePool::waitForSlice(StreamJob& job) noexcept
+{
+    if (job.runningAsync) {
+        while (!job.sliceDone)
+            std::this_thread::yield();
     }
+    else
+        TaskScheduler::wait(job.sliceTask);
 }
 
 void sfz::FilePool::waitForBackgroundLoading() noexcept
 {
     std::lock_guard<std::mutex> guard { loadingJobsMutex };
 
-    for (auto& job : loadingJobs)
-        job.wait();
+    collectStreamRequests();
+    collectStreamSlices(true);
+
+    // Finish the remaining streams here, most urgent first, and fill the
+    // windows of the bounded ones
+    std::vector<StreamJob*> jobs;
+    jobs.swap(pausedStreams);
+    jobs.insert(jobs.end(), streamQueue.begin(), streamQueue.end());
+    streamQueue.clear();
+    std::sort(jobs.begin(), jobs.end(), [](const StreamJob* lhs, const StreamJob* rhs) {
+        return lhs->deadline < rhs->deadline;
+    });
 
-    loadingJobs.clear();
+    for (StreamJob* job : jobs) {
+        job->paused = false;
+        bool over;
+        while (!(over = streamSlice(*job)) && !job->paused)
+            ;
+        if (over)
+            streams.erase(job->key());
+        else
+            pausedStreams.push_back(job);
+    }
+
+    recycleFileStreams();
 }
 
-void sfz::FilePool::raiseCurrentThreadPriority() noexcept
+void sfz::FilePool::emptyFileLoadingQueues() noexcept
 {
-#if defined(_WIN32)
-    HANDLE thread = GetCurrentThread();
-    const int priority = THREAD_PRIORITY_ABOVE_NORMAL; /*THREAD_PRIORITY_HIGHEST*/
-    if (!SetThreadPriority(thread, priority)) {
-        std::system_error error(GetLastError(), std::system_category());
-        DBG("[sfizz] Cannot set current thread priority: " << error.what());
-    }
-#else
-    pthread_t thread = pthread_self();
-    int policy;
-    sched_param param;
+    settleDeferredPreloads();
+    std::lock_guard<std::mutex> guard { loadingJobsMutex };
 
-    if (pthread_getschedparam(thread, &policy, &param) != 0) {
-        DBG("[sfizz] Cannot get current thread scheduling parameters");
-        return;
+    QueuedFileData queuedData;
+    while (filesToLoad->try_pop(queuedData)) {
+        if (queuedData.stream)
+            activeFileStreams.push_back(queuedData.stream);
     }
 
-    policy = SCHED_RR;
-    const int minprio = sched_get_priority_min(policy);
-    const int maxprio = sched_get_priority_max(policy);
-    param.sched_priority = minprio + config::backgroundLoaderPthreadPriority * (maxprio - minprio) / 100;
+    for (StreamJob* job : loadingJobs)
+        waitForSlice(*job);
 
-    if (pthread_setschedparam(thread, policy, &param) != 0) {
-        DBG("[sfizz] Cannot set current thread scheduling parameters");
-        return;
-    }
-#endif
+    loadingJobs.clear();
+    streamQueue.clear();
+    pausedStreams.clear();
+    streams.clear();
+    recycleFileStreams();
+}
+
+void sfz::FilePool::setStreamingWindow(uint32_t numFrames) noexcept
+{
+    streamingWindow = (numFrames > 0) ? max(numFrames, config::minStreamingWindow) : 0;
+}
+
+size_t sfz::FilePool::getStreamingMemory() const noexcept
+{
+    size_t numBytes = 0;
+    for (const auto& stream : fileStreams)
+        numBytes += stream->residentBytes;
+    return numBytes;
 }
 
 void sfz::FilePool::setRamLoading(bool loadInRam) noexcept
@@ -639,33 +3267,63 @@ void sfz::FilePool::setRamLoading(bool loadInRam) noexcept
     this->loadInRam = loadInRam;
 
     if (loadInRam) {
+        settleDeferredPreloads();
         for (auto& preloadedFile : preloadedFiles) {
+            if (preloadedFile.second.mappedFile || preloadedFile.second.status == FileData::Status::Deferred)
+                continue;
             fs::path file { rootDirectory / preloadedFile.first.filename() };
-            AudioReaderPtr reader = createAudioReader(file, preloadedFile.first.isReverse());
             auto& fileData = preloadedFile.second;
-            fileData.preloadedData = readFromFile(
-                *reader,
-                fileData.information.end
+            setSharedPreload(
+                fileData,
+                file,
+                preloadedFile.first.isReverse(),
+                static_cast<uint32_t>(fileData.information.end)
             );
             fileData.fullyLoaded = true;
+            measureEnvelope(fileData, preloadedFile.first);
         }
     } else {
         setPreloadSize(preloadSize);
     }
 }
 
+void sfz::FilePool::collectLastUsedFiles() noexcept
+{
+    FileId id;
+    while (lastUsedFiles.size() < lastUsedFiles.capacity() && lastUsedQueue->try_pop(id)) {
+        if (absl::c_find(lastUsedFiles, id) == lastUsedFiles.end())
+            lastUsedFiles.push_back(std::move(id));
+    }
+}
+
 void sfz::FilePool::triggerGarbageCollection() noexcept
 {
-    const std::unique_lock<SpinMutex> guard { garbageAndLastUsedMutex, std::try_to_lock };
-    if (!guard.owns_lock())
-        return;
+    collectLastUsedFiles();
+
+    // Over the memory budget, collect the least recently played files
+    // first, without waiting for them to be idle for the clearing period.
+    size_t excessBytes = 0;
+    if (memoryBudget > 0) {
+        const size_t usage = getMemoryUsage();
+        if (usage > memoryBudget) {
+            excessBytes = usage - memoryBudget;
+            auto lastViewed = [this](const FileId& id) {
+                const auto it = preloadedFiles.find(getContentId(id));
+                return (it != preloadedFiles.end()) ? it->second.lastViewerLeftAt : decltype(FileData::lastViewerLeftAt) {};
+            };
+            std::sort(lastUsedFiles.begin(), lastUsedFiles.end(), [&](const FileId& lhs, const FileId& rhs) {
+                return lastViewed(lhs) < lastViewed(rhs);
+            });
+        }
+    }
 
     const auto now = std::chrono::high_resolution_clock::now();
-    swapAndPopAll(lastUsedFiles, [&](const FileId& id) {
-        if (garbageToCollect.size() == garbageToCollect.capacity())
+    auto collect = [&](const FileId& id) {
+        // Only this thread hands the garbage, so the room left stays
+        if (garbageToCollect->was_size() >= garbageToCollect->capacity())
            return false;
 
-        auto it = preloadedFiles.find(id);
+        auto it = preloadedFiles.find(getContentId(id));
         if (it == preloadedFiles.end()) {
             // Getting here means that the preloadedFiles got changed (probably cleared)
             // while the lastUsedFiles were untouched.
@@ -678,7 +3336,7 @@ void sfz::FilePool::triggerGarbageCollection() noexcept
             return false;
 
         const auto secondsIdle = std::chrono::duration_cast<std::chrono::seconds>(now - data.lastViewerLeftAt).count();
-        if (secondsIdle < config::fileClearingPeriod)
+        if (secondsIdle < config::fileClearingPeriod && excessBytes == 0 && !immediateRelease)
             return false;
 
         auto status = data.status.load();
@@ -688,26 +3346,40 @@ void sfz::FilePool::triggerGarbageCollection() noexcept
                 return true;
             }
         }
-        else if (status != FileData::Status::Done) {
+        else if (status != FileData::Status::Done
+            && !(status == FileData::Status::Streaming && data.streamPaused)) {
             return false;
         }
 
         // do garbage collection when changing the status is success
+        const size_t streamedBytes = getStreamedBytes(data);
         if (data.status.compare_exchange_strong(status, FileData::Status::GarbageCollecting)) {
             // recheck readerCount
             auto readerCount = data.readerCount.load();
             if (readerCount == 0) {
+                excessBytes -= min(excessBytes, streamedBytes);
+                numCollectedBytes.fetch_add(streamedBytes, std::memory_order_relaxed);
                 data.availableFrames = 0;
-                garbageToCollect.push_back(std::move(data.fileData));
+                data.streamPaused = false;
+                garbageToCollect->try_push(std::move(data.fileData));
                 data.status = FileData::Status::Preloaded;
                 return true;
             }
             data.status = status;
         }
         return false;
-    });
+    };
 
-    std::error_code ec;
-    semGarbageBarrier.post(ec);
-    ASSERT(!ec);
+    // Keep the order of the remaining files
+    auto kept = lastUsedFiles.begin();
+    for (auto it = lastUsedFiles.begin(), end = lastUsedFiles.end(); it != end; ++it) {
+        if (!collect(*it))
+            *kept++ = std::move(*it);
+    }
+    lastUsedFiles.erase(kept, lastUsedFiles.end());
+
+    // If the previous collection is still running, the next trigger
+    // collects what this one left
+    if (!garbageToCollect->was_empty())
+        scheduler->schedule(*garbageTask, TaskScheduler::Priority::Low);
 }
@@ -25,14 +25,20 @@
 
 #pragma once
 #include "Config.h"
+#include "AsyncFileIO.h"
 #include "Defaults.h"
-#include "RTSemaphore.h"
 #include "AudioBuffer.h"
 #include "AudioSpan.h"
 #include "FileId.h"
 #include "FileMetadata.h"
+#include "MappedAudioFile.h"
+#include "Oversampler.h"
+#include "SampleEnvelope.h"
+#include "SampleMemory.h"
+#include "UsageProfile.h"
 #include "SIMDHelpers.h"
-#include "SpinMutex.h"
+#include "StreamBuffer.h"
+#include "TaskScheduler.h"
 #include "utility/Timing.h"
 #include "utility/LeakDetector.h"
 #include "utility/MemoryHelpers.h"
@@ -41,20 +47,44 @@
 #include <absl/types/optional.h>
 #include <absl/strings/string_view.h>
 #include <atomic_queue/atomic_queue.h>
+#include <array>
+#include <atomic>
+#include <limits>
 #include <chrono>
 #include <thread>
-#include <future>
+#include <functional>
 #include <memory>
-class ThreadPool;
+#include <system_error>
+#include <utility>
+#include <vector>
 
 namespace sfz {
+class AudioReader;
+
 using FileAudioBuffer = AudioBuffer<float, 2, config::defaultAlignment,
-                                    sfz::config::excessFileFrames, sfz::config::excessFileFrames>;
+                                    sfz::config::excessFileFrames, sfz::config::excessFileFrames,
+                                    SampleAllocator>;
 using FileAudioBufferPtr = std::shared_ptr<FileAudioBuffer>;
+using FileCompactAudioBuffer = AudioBuffer<int16_t, 2, config::defaultAlignment,
+                                           sfz::config::excessFileFrames, sfz::config::excessFileFrames,
+                                           SampleAllocator>;
+using FileCompactAudioBufferPtr = std::shared_ptr<FileCompactAudioBuffer>;
+
+/**
+ * @brief A range of frames, from the first one up to the one after the last.
+ */
+struct FrameRange {
+    uint32_t start { 0 };
+    uint32_t end { 0 };
+
+    bool operator==(const FrameRange& other) const noexcept { return start == other.start && end == other.end; }
+    bool operator!=(const FrameRange& other) const noexcept { return !(*this == other); }
+};
 
 struct FileInformation {
     int64_t end { Default::sampleEnd };
     int64_t maxOffset { 0 };
+    float preloadRatio { 1.0f };
     int64_t loopStart { Default::loopStart };
     int64_t loopEnd { Default::loopEnd };
     bool hasLoop { false };
@@ -62,25 +92,101 @@ struct FileInformation {
     int numChannels { 0 };
     int rootKey { 0 };
     absl::optional<WavetableInfo> wavetable;
+    // The frames of the data per frame of the file, if the data is resampled
+    // at the engine rate. The positions above are then in the frames of the
+    // data, except the maximal offset.
+    double resampleRatio { 1.0 };
 };
 
 // Strict C++11 disallows member initialization if aggregate initialization is to be used...
 struct FileData
 {
-    enum class Status { Invalid, Preloaded, Streaming, Done, GarbageCollecting };
+    // A deferred file has no preload until requestPreload, which reads it
+    // in the background, through the preloading status
+    enum class Status { Invalid, Preloaded, Streaming, Done, GarbageCollecting, Deferred, Preloading };
     FileData() = default;
-    FileData(FileAudioBuffer preloaded, FileInformation info)
+    FileData(FileAudioBufferPtr preloaded, FileInformation info)
     : preloadedData(std::move(preloaded)), information(std::move(info))
     {
 
     }
-    AudioSpan<const float> getData()
+    /**
+     * @brief Get the data to play, which is empty if the frames to play are
+     * in the compact storage.
+     */
+    AudioSpan<const float> getData(size_t preloadEnd = std::numeric_limits<size_t>::max())
     {
         ASSERT(readerCount > 0);
-        if (status != Status::GarbageCollecting && availableFrames > preloadedData.getNumFrames())
+        if (mappedFile)
+            return AudioSpan<const float>({ mappedFile->getData() });
+        const size_t preloadedFrames = min(preloadEnd, getNumPreloadedFrames());
+        if (status != Status::GarbageCollecting && availableFrames > preloadedFrames)
             return AudioSpan<const float>(fileData).first(availableFrames);
+        else if (preloadedData)
+            return AudioSpan<const float>(*preloadedData).first(preloadedFrames);
         else
-            return AudioSpan<const float>(preloadedData);
+            return {};
+    }
+    /**
+     * @brief Get the data to play if it is in the compact storage, and
+     * otherwise an empty span.
+     */
+    AudioSpan<const int16_t> getCompactData()
+    {
+        ASSERT(readerCount > 0);
+        if (mappedFile || !compactPreloadedData)
+            return {};
+        if (status != Status::GarbageCollecting && availableFrames > compactPreloadedData->getNumFrames())
+            return {};
+        return AudioSpan<const int16_t>(*compactPreloadedData);
+    }
+    size_t getNumPreloadedFrames() const noexcept
+    {
+        if (compactPreloadedData)
+            return compactPreloadedData->getNumFrames();
+        if (preloadedData)
+            return preloadedData->getNumFrames();
+        return 0;
+    }
+    /**
+     * @brief Get the number of preloaded frames which are held in memory,
+     * which are those of the segments in a sparse preload.
+     */
+    size_t getNumHeldFrames() const noexcept
+    {
+        if (preloadSegments.empty())
+            return getNumPreloadedFrames();
+        size_t numFrames = 0;
+        for (const FrameRange& segment : preloadSegments)
+            numFrames += segment.end - segment.start;
+        return numFrames;
+    }
+    /**
+     * @brief Whether the preload holds all the frames of the file, so that
+     * it never streams.
+     */
+    bool preloadsWholeFile() const noexcept
+    {
+        return preloadSegments.empty()
+            && static_cast<size_t>(information.end + 1) <= getNumPreloadedFrames();
+    }
+    /**
+     * @brief Get the segment of the preload which holds a start frame, or
+     * else the segment below, whose start is the closest reachable offset
+     * below the frame. A contiguous preload is a single segment.
+     */
+    FrameRange getPreloadSegment(size_t frame) const noexcept
+    {
+        const auto numFrames = static_cast<uint32_t>(getNumPreloadedFrames());
+        if (preloadSegments.empty())
+            return { 0, numFrames };
+        FrameRange below { 0, 0 };
+        for (const FrameRange& segment : preloadSegments) {
+            if (segment.start > frame)
+                break;
+            below = segment;
+        }
+        return below;
     }
 
     FileData(const FileData& other) = delete;
@@ -90,38 +196,180 @@ struct FileData
         ASSERT(other.readerCount == 0); // Probably should not be moving this...
         information = std::move(other.information);
         preloadedData = std::move(other.preloadedData);
+        compactPreloadedData = std::move(other.compactPreloadedData);
+        startRanges = std::move(other.startRanges);
+        preloadSegments = std::move(other.preloadSegments);
         fileData = std::move(other.fileData);
+        mappedFile = std::move(other.mappedFile);
+        envelope = std::move(other.envelope);
         preloadCallCount = other.preloadCallCount;
         availableFrames = other.availableFrames.load();
+        streamLimit = other.streamLimit.load();
+        streamPaused = other.streamPaused.load();
         lastViewerLeftAt = other.lastViewerLeftAt;
         status = other.status.load();
+        fullyLoaded = other.fullyLoaded;
+        mirrored = other.mirrored;
+        numPlays = other.numPlays.load();
+        playedFrames = other.playedFrames.load();
+        readaheadFile = std::move(other.readaheadFile);
+        readaheadOffset = other.readaheadOffset;
+        encodedData = std::move(other.encodedData);
     }
     FileData& operator=(FileData&& other)
     {
         ASSERT(other.readerCount == 0); // Probably should not be moving this...
         information = std::move(other.information);
         preloadedData = std::move(other.preloadedData);
+        compactPreloadedData = std::move(other.compactPreloadedData);
+        startRanges = std::move(other.startRanges);
+        preloadSegments = std::move(other.preloadSegments);
         fileData = std::move(other.fileData);
+        mappedFile = std::move(other.mappedFile);
+        envelope = std::move(other.envelope);
         preloadCallCount = other.preloadCallCount;
         availableFrames = other.availableFrames.load();
+        streamLimit = other.streamLimit.load();
+        streamPaused = other.streamPaused.load();
         lastViewerLeftAt = other.lastViewerLeftAt;
         status = other.status.load();
+        fullyLoaded = other.fullyLoaded;
+        mirrored = other.mirrored;
+        numPlays = other.numPlays.load();
+        playedFrames = other.playedFrames.load();
+        readaheadFile = std::move(other.readaheadFile);
+        readaheadOffset = other.readaheadOffset;
+        encodedData = std::move(other.encodedData);
         return *this;
     }
 
-    FileAudioBuffer preloadedData;
+    FileAudioBufferPtr preloadedData; // possibly shared with other file pools
+    FileCompactAudioBufferPtr compactPreloadedData; // set instead of preloadedData in the compact storage
+    // The start frames which the players can reach, in the frames of the
+    // file, or empty to preload contiguously up to the maximal offset
+    std::vector<FrameRange> startRanges;
+    // The ranges of frames of a sparse preload, sorted; the frames between
+    // them read as silence. Empty if the preload is contiguous.
+    std::vector<FrameRange> preloadSegments;
     FileInformation information;
     FileAudioBuffer fileData {};
+    std::unique_ptr<MappedAudioFile> mappedFile; // played in place instead of the buffers if set
+    // The envelope of the data, measured as far as the preload and the
+    // stream of the file reach
+    SampleEnvelope envelope;
     int preloadCallCount { 0 };
     std::atomic<Status> status { Status::Invalid };
     bool fullyLoaded { false };
     std::atomic<size_t> availableFrames { 0 };
+    // The frames streamed while the players only loop, raised once one may
+    // play past the loop
+    std::atomic<size_t> streamLimit { std::numeric_limits<size_t>::max() };
+    // Whether the stream waits at the limit, which lets the garbage
+    // collection take the idle file back
+    std::atomic<bool> streamPaused { false };
+    // Whether reversed files read the data backward, which keeps it whole
+    bool mirrored { false };
+    // The players take and give the data back on the audio thread, which
+    // also decides the garbage collection, so the counts change without
+    // read-modify-writes, and the other threads only read them.
     std::atomic<int> readerCount { 0 };
     std::chrono::time_point<std::chrono::high_resolution_clock> lastViewerLeftAt;
+    // The usage of the file by the players, for the usage profile; the
+    // played frames are in the frames of the data
+    std::atomic<uint32_t> numPlays { 0 };
+    std::atomic<size_t> playedFrames { 0 };
+    // The file kept open for the streams, which the system reads ahead of
+    // from the offset in bytes after the preload once a player starts
+    std::shared_ptr<AsyncFileIO::File> readaheadFile;
+    uint64_t readaheadOffset { 0 };
+    // The bytes of the file, which the streams decode instead of reading the
+    // file, in the encoded RAM storage
+    std::shared_ptr<const std::vector<char>> encodedData;
+
+    /**
+     * @brief Record that a player started the data, from the audio thread.
+     */
+    void recordPlay() noexcept
+    {
+        numPlays.store(numPlays.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    /**
+     * @brief Change the count of the players of the data, from the audio
+     * thread.
+     */
+    void addReaders(int count) noexcept
+    {
+        readerCount.store(readerCount.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Record that a player reached a frame of the data. This is
+     * real-time safe.
+     */
+    void recordPlayback(int64_t position) noexcept
+    {
+        const size_t frame = (position > 0) ? static_cast<size_t>(position) : 0;
+        size_t played = playedFrames.load(std::memory_order_relaxed);
+        while (frame > played && !playedFrames.compare_exchange_weak(played, frame, std::memory_order_relaxed))
+            ;
+    }
 
     LEAK_DETECTOR(FileData);
 };
 
+/**
+ * @brief Wakes the dispatching of the streams of a file pool up.
+ */
+class DispatchWaker
+{
+public:
+    virtual ~DispatchWaker() {}
+    virtual void wake() noexcept = 0;
+};
+
+/**
+ * @brief The data of a file streamed for a single player, in the bounded
+ * streaming mode.
+ *
+ * The loaders keep up to a window of frames ahead of the play head, and give
+ * the frames behind it back to the system, except the loop segment.
+ */
+struct FileStream
+{
+    /**
+     * @brief Report the playback state, from the player
+     *
+     * @param position the play head
+     * @param loopStart the first frame of the loop segment to keep
+     * @param loopEnd the frame after the loop segment to keep
+     */
+    void updatePlayback(int64_t position, int64_t loopStart, int64_t loopEnd) noexcept
+    {
+        playPosition = position;
+        residentStart = loopStart;
+        residentEnd = loopEnd;
+
+        // Wake the loaders up once half of the window is played
+        const int64_t ahead = static_cast<int64_t>(availableFrames.load()) - position;
+        if (ahead < static_cast<int64_t>(window / 2) && throttled.exchange(false))
+            wake->wake();
+    }
+
+    AudioSpan<const float> getData() const noexcept { return buffer.getData(availableFrames); }
+
+    StreamBuffer buffer;
+    std::atomic<size_t> availableFrames { 0 };
+    std::atomic<int64_t> playPosition { 0 };
+    std::atomic<int64_t> residentStart { 0 };
+    std::atomic<int64_t> residentEnd { 0 };
+    std::atomic<size_t> residentBytes { 0 };
+    std::atomic<bool> throttled { false };
+    std::atomic<bool> released { false };
+    size_t window { 0 };
+    DispatchWaker* wake { nullptr };
+
+    LEAK_DETECTOR(FileStream);
+};
 
 class FileDataHolder {
 public:
@@ -131,27 +379,44 @@ public:
     FileDataHolder(FileDataHolder&& other)
     {
         this->data = other.data;
+        this->stream = other.stream;
+        this->preloadEnd = other.preloadEnd;
+        this->mirrored = other.mirrored;
         other.data = nullptr;
+        other.stream = nullptr;
     }
     FileDataHolder& operator=(FileDataHolder&& other)
     {
         this->data = other.data;
+        this->stream = other.stream;
+        this->preloadEnd = other.preloadEnd;
+        this->mirrored = other.mirrored;
         other.data = nullptr;
+        other.stream = nullptr;
         return *this;
     }
-    FileDataHolder(FileData* data) : data(data)
+    FileDataHolder(FileData* data, FileStream* stream = nullptr, bool mirrored = false)
+        : data(data), stream(stream), mirrored(mirrored)
     {
         if (!data)
             return;
 
-        data->readerCount += 1;
+        data->addReaders(1);
     }
     void reset()
     {
+        preloadEnd = std::numeric_limits<size_t>::max();
+        mirrored = false;
+        if (stream) {
+            stream->released = true;
+            stream->wake->wake();
+            stream = nullptr;
+        }
+
         if (!data)
             return;
 
-        data->readerCount -= 1;
+        data->addReaders(-1);
         data->lastViewerLeftAt = highResNow();
         data = nullptr;
     }
@@ -160,11 +425,80 @@ public:
         ASSERT(!data || data->readerCount > 0);
         reset();
     }
+    /**
+     * @brief Get the data to play, from the own stream of the holder once
+     * it goes past the preloaded data.
+     */
+    AudioSpan<const float> getData()
+    {
+        if (stream && stream->availableFrames > min(preloadEnd, data->getNumPreloadedFrames()))
+            return stream->getData();
+        return data->getData(preloadEnd);
+    }
+    /**
+     * @brief Whether the data is the forward data of a reversed file, which
+     * the player reads backward from its last frame.
+     */
+    bool isMirrored() const noexcept { return mirrored; }
+    /**
+     * @brief Whether the data to play comes from the own stream of the
+     * holder rather than from the preloaded data.
+     */
+    bool isStreaming() const noexcept
+    {
+        return stream && stream->availableFrames > min(preloadEnd, data->getNumPreloadedFrames());
+    }
+    /**
+     * @brief Set the frame where the player starts, which bounds the
+     * preloaded frames it reads to the end of its segment in a sparse
+     * preload.
+     *
+     * @param frame the start frame, in the frames of the data
+     * @return the start frame, moved down to the start of the segment
+     *         below if no segment holds it
+     */
+    uint64_t startAt(uint64_t frame) noexcept
+    {
+        if (!data || data->preloadSegments.empty())
+            return frame;
+        const FrameRange segment = data->getPreloadSegment(frame);
+        preloadEnd = segment.end;
+        return (frame < segment.end) ? frame : segment.start;
+    }
+    /**
+     * @brief Get the data to play if it is in the compact storage, and
+     * otherwise an empty span.
+     */
+    AudioSpan<const int16_t> getCompactData()
+    {
+        if (stream && stream->availableFrames > data->getNumPreloadedFrames())
+            return {};
+        return data->getCompactData();
+    }
+    /**
+     * @brief Report the playback state to the own stream of the holder,
+     * if any, and to the usage of the file.
+     *
+     * @param position the play head
+     * @param loopStart the first frame of the loop segment to keep
+     * @param loopEnd the frame after the loop segment to keep
+     */
+    void updatePlayback(int64_t position, int64_t loopStart, int64_t loopEnd) noexcept
+    {
+        if (data && !mirrored)
+            data->recordPlayback(position);
+        if (stream)
+            stream->updatePlayback(position, loopStart, loopEnd);
+    }
     FileData& operator*() { return *data; }
     FileData* operator->() { return data; }
     explicit operator bool() const { return data != nullptr; }
 private:
     FileData* data { nullptr };
+    FileStream* stream { nullptr };
+    // The end of the preloaded frames which the player reads
+    size_t preloadEnd { std::numeric_limits<size_t>::max() };
+    bool mirrored { false };
     LEAK_DETECTOR(FileDataHolder);
 };
 
@@ -193,8 +527,8 @@ public:
     /**
      * @brief Construct a new File Pool object.
      *
-     * This creates the background threads based on config::numBackgroundThreads
-     * as well as the garbage collection thread.
+     * This shares the background workers of the process, on which the
+     * dispatching of the streams, the slices and the garbage collection run.
      */
     FilePool();
 
@@ -220,16 +554,107 @@ public:
      */
     absl::optional<FileInformation> getFileInformation(const FileId& fileId) noexcept;
 
+    /**
+     * @brief Get the RMS and peak envelope of the data of a file in the pool,
+     * as far as it is measured.
+     *
+     * @param fileId
+     * @return the envelope, or nullptr if the file is not in the pool
+     */
+    const SampleEnvelope* getSampleEnvelope(const FileId& fileId) const noexcept;
+
     /**
      * @brief Preload a file with the proper offset bounds
      *
      * @param fileId
      * @param maxOffset the maximum offset to consider for preloading. The total preloaded
-     *                  size will be preloadSize + offset
+     *                  size will be preloadSize * preloadRatio + offset
+     * @param preloadRatio the highest playback speed of the file relative to
+     *                     the original, which scales the preload size
+     * @param deferred whether to only register the file, and read its
+     *                 preload once requested with requestPreload
+     * @param loopEnd the last frame of the file which its sustained loops
+     *                play, after which it streams once releaseStreamLimit
+     *                is called, or -1 to stream the whole file
+     * @param startRanges the start frames which the players can reach, at
+     *                    most maxOffset. If they leave enough frames out,
+     *                    only the file head and the frames after each range
+     *                    are preloaded, which is a sparse preload; if empty,
+     *                    the preload is contiguous up to maxOffset.
      * @return true if the preloading went fine
      * @return false if something went wrong ()
      */
-    bool preloadFile(const FileId& fileId, uint32_t maxOffset) noexcept;
+    bool preloadFile(const FileId& fileId, uint32_t maxOffset, float preloadRatio = 1.0f, bool deferred = false, int64_t loopEnd = -1,
+        const std::vector<FrameRange>& startRanges = {}) noexcept;
+    /**
+     * @brief A file to preload, with its maximum offset, preload ratio,
+     * whether it is deferred, its loop end and its start ranges, as for
+     * preloadFile
+     */
+    struct FileToPreload {
+        FileId fileId;
+        uint32_t maxOffset;
+        float preloadRatio;
+        bool deferred { false };
+        int64_t loopEnd { -1 };
+        std::vector<FrameRange> startRanges {};
+    };
+    struct PreloadProgress {
+        size_t numPreloadedFiles;
+        size_t numBytesRead;
+    };
+    /**
+     * @brief A function which receives the progress of preloadFiles, and
+     * returns false to cancel the preloading.
+     */
+    using PreloadCallback = std::function<bool(const PreloadProgress&)>;
+    /**
+     * @brief Preload several files with the proper offset bounds. The files
+     * are decoded concurrently, following the loading parallelism, and the
+     * result is the same as preloading them one after the other in order.
+     *
+     * @param files the files, with their maximum offset and preload ratio
+     * @param callback the function which receives the progress, on the
+     *                 calling thread; it can cancel between two files
+     * @return true if all the files were preloaded
+     * @return false if the preloading was canceled, in which case none was
+     */
+    bool preloadFiles(const std::vector<FileToPreload>& files, const PreloadCallback& callback = {}) noexcept;
+    /**
+     * @brief Read the information of several files concurrently, following
+     * the loading parallelism. Until clearProbedFileInformation is called,
+     * getFileInformation returns it without opening the files again.
+     *
+     * @param fileIds
+     */
+    void probeFileInformation(const std::vector<FileId>& fileIds) noexcept;
+    /**
+     * @brief Forget the information read by probeFileInformation.
+     */
+    void clearProbedFileInformation() noexcept;
+    /**
+     * @brief Read the information of all the audio files in a directory and
+     * its subdirectories, concurrently, into the information cache. Later
+     * loads of these files then skip opening them to scan their metadata.
+     *
+     * @param directory the directory, relative to the root directory
+     * @return the number of audio files with readable information
+     */
+    size_t probeDirectoryInformation(const fs::path& directory) noexcept;
+    /**
+     * @brief Set how many files load concurrently when probing and
+     * preloading several files. The calling thread is joined by the
+     * background loading threads; 1 loads the files serially.
+     *
+     * @param parallelism
+     */
+    void setLoadingParallelism(unsigned parallelism) noexcept { loadingParallelism = (parallelism > 0) ? parallelism : 1; }
+    /**
+     * @brief Get how many files load concurrently
+     *
+     * @return unsigned
+     */
+    unsigned getLoadingParallelism() const noexcept { return loadingParallelism; }
 
     /**
      * @brief Load a file and return its information. The file pool will store this
@@ -268,6 +693,15 @@ public:
      */
     bool checkSampleId(FileId& fileId) const noexcept;
 
+    /**
+     * @brief Check several samples like checkSampleId, concurrently following
+     * the loading parallelism. The repeated identifiers are checked once.
+     *
+     * @param fileIds the sample file identifiers; may be updated by the method
+     * @return for each identifier, nonzero if the sample was found
+     */
+    std::vector<uint8_t> checkSampleIds(std::vector<FileId>& fileIds) noexcept;
+
     /**
      * @brief Clear all preloaded files.
      *
@@ -285,12 +719,74 @@ public:
     void removeUnusedPreloadedData() noexcept;
 
     /**
-     * @brief Get a handle on a file, which triggers background loading
+     * @brief Get a handle on a file, which triggers background loading.
+     *
+     * The background loaders stream the files in slices, most urgent first:
+     * the deadline of a file is the time its player runs out of loaded data,
+     * estimated from the start position, the start delay and the playback
+     * rate.
+     *
+     * @param fileId the file to preload
+     * @param startFrame the frame where the playback starts
+     * @param pitchRatio the playback rate relative to the file sample rate,
+     *                   or 0 if unknown
+     * @param startDelay the delay before the playback starts, in seconds
+     * @return FileDataHolder a file data handle
+     */
+    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId, uint64_t startFrame = 0, float pitchRatio = 0.0f, float startDelay = 0.0f) noexcept;
+    /**
+     * @brief Same as `getFilePromise`, with the data resolved in a slot. The
+     * slot is resolved again only if the pool added or removed files since.
      *
      * @param fileId the file to preload
+     * @param slot the data of the file, resolved by a former call or by
+     *             `resolveFile`
+     * @param startFrame the frame where the playback starts
+     * @param pitchRatio the playback rate relative to the file sample rate,
+     *                   or 0 if unknown
+     * @param startDelay the delay before the playback starts, in seconds
      * @return FileDataHolder a file data handle
      */
-    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId) noexcept;
+    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId, FileSlot& slot, uint64_t startFrame = 0, float pitchRatio = 0.0f, float startDelay = 0.0f) noexcept;
+    /**
+     * @brief Resolve the data of a file in a slot, for `getFilePromise`.
+     *
+     * @param fileId
+     * @param slot
+     */
+    void resolveFile(const FileId& fileId, FileSlot& slot) noexcept;
+    /**
+     * @brief Start streaming a file which is likely to play soon, without a
+     * handle on it. The request comes after the ones of the players, as if
+     * the file was due after the prewarming delay. This does nothing in the
+     * bounded mode, where the players stream on their own, nor in the
+     * immediate release, which would free the data before it plays.
+     *
+     * @param fileId the file to stream
+     * @return true if the file was queued
+     */
+    bool prewarmFile(const std::shared_ptr<FileId>& fileId) noexcept;
+    /**
+     * @brief Read the preload of a deferred file in the background. Until it
+     * is read, the file gives no promise. This is real-time safe, and does
+     * nothing for the other files.
+     *
+     * @param fileId the file to preload
+     * @return true if the preload was queued
+     */
+    bool requestPreload(const FileId& fileId) noexcept;
+    /**
+     * @brief Check whether the preload of a file waits for a request, or is
+     * being read.
+     */
+    bool isPreloadDeferred(const FileId& fileId) const noexcept;
+    /**
+     * @brief Let a file stream past the end of its loop, once a player
+     * leaves the loop. This is real-time safe.
+     *
+     * @param data the data of the file
+     */
+    void releaseStreamLimit(FileData& data) noexcept;
     /**
      * @brief Change the preloading size. This will trigger a full
      * reload of all samples, so don't call it on the audio thread.
@@ -304,27 +800,65 @@ public:
      * @return uint32_t
      */
     uint32_t getPreloadSize() const noexcept;
+    /**
+     * @brief Set whether the preloaded heads follow the measured streaming
+     * latency instead of the preload size.
+     *
+     * In the adaptive mode, the heads cover a high percentile of the times
+     * from the stream requests to their first slices, at the rate of each
+     * file and at its highest playback speed. The preload size applies until
+     * enough latencies are measured. The heads resize on the next load or
+     * update of the adaptive preloading.
+     */
+    void setAdaptivePreloading(bool adaptive) noexcept;
+    bool isAdaptivePreloading() const noexcept { return adaptivePreloading; }
+    /**
+     * @brief Resize the preloaded heads if the latency they should cover
+     * changed much since they were sized. This reloads the heads like a
+     * change of the preload size, so don't call it on the audio thread.
+     *
+     * @return true if the heads resized
+     */
+    bool updateAdaptivePreloading() noexcept;
+    /**
+     * @brief Record the time from a stream request to its first slice, in
+     * the stats and the measures of the adaptive preloading. This is
+     * lock-free.
+     */
+    void recordStreamingLatency(uint64_t nanoseconds) noexcept;
+    /**
+     * @brief Get a percentile of the latencies from the stream requests to
+     * their first slices, rounded up to the next power of 2 of 100 µs. This
+     * is lock-free.
+     *
+     * @param percentile between 0 and 1
+     * @return the latency in seconds, or 0 if too few were measured
+     */
+    double getStreamingLatency(double percentile) const noexcept;
+    /**
+     * @brief Get the latency which the heads cover in the adaptive mode.
+     *
+     * @return the latency in seconds, or 0 if the preload size applies
+     */
+    double getAdaptiveLatency() const noexcept { return adaptiveLatency; }
+    /**
+     * @brief Take the measured latencies and the covered latency of another
+     * pool, which replaces this one after a background load.
+     */
+    void copyLatencies(const FilePool& other) noexcept;
     /**
      * @brief Empty the file loading queues without actually loading
      * the files. All promises will be unfulfilled. Don't call this
      * method on the audio thread as it will spinlock.
      *
      */
-    void emptyFileLoadingQueues() noexcept
-    {
-        // nothing to do in this implementation,
-        // deleting the region and its sample ID take care of it
-    }
+    void emptyFileLoadingQueues() noexcept;
     /**
      * @brief Wait for the background loading to finish for all promises
-     * in the queue.
+     * in the queue. The streams which are not running are finished on the
+     * calling thread.
      */
     void waitForBackgroundLoading() noexcept;
-    /**
-     * @brief Assign the current thread a priority which is appropriate
-     * for background sample file processing.
-     */
-    static void raiseCurrentThreadPriority() noexcept;
     /**
      * @brief Change whether all samples are loaded in ram.
      * This will trigger a purge and reloading.
@@ -332,56 +866,816 @@ public:
      * @param loadInRam
      */
     void setRamLoading(bool loadInRam) noexcept;
+    /**
+     * @brief Change whether the files which can be played in place are
+     * memory-mapped instead of preloaded. The operating system then pages
+     * their data in and out as needed. This applies to the files preloaded
+     * afterwards, and only where the mappings are supported.
+     *
+     * @param memoryMapped
+     */
+    void setMemoryMapping(bool memoryMapped) noexcept
+    {
+        this->memoryMapped = memoryMapped && MappedAudioFile::isSupported();
+    }
+    /**
+     * @brief Get the number of memory-mapped sample files
+     *
+     * @return size_t
+     */
+    size_t getNumMappedSamples() const noexcept;
+    /**
+     * @brief Change whether the files which stream are kept in memory as
+     * they are encoded in the files, so FLAC frames for the FLAC files, and
+     * the streams decode them from memory instead of reading the files.
+     * The decoded frames of each player are bounded by the streaming window,
+     * if set, or else the decoded files are collected once idle.
+     * This applies to the files preloaded afterwards.
+     *
+     * @param encodedInRam
+     */
+    void setEncodedRamStorage(bool encodedInRam) noexcept { this->encodedInRam = encodedInRam; }
+    /**
+     * @brief Get the number of sample files kept encoded in memory
+     *
+     * @return size_t
+     */
+    size_t getNumEncodedSamples() const noexcept;
+    /**
+     * @brief Change whether the preloaded data is kept as 16-bit integers,
+     * for the files whose frames are all exactly representable this way,
+     * like those in 16-bit PCM. This halves the memory of their preloaded
+     * data. This applies to the files preloaded afterwards.
+     *
+     * @param compactStorage
+     */
+    void setCompactStorage(bool compactStorage) noexcept { this->compactStorage = compactStorage; }
+    /**
+     * @brief Change whether the files at another rate than the engine are
+     * resampled at the engine rate as they load, with a high-quality offline
+     * resampler. They then play at a ratio of exactly 1 when not transposed.
+     * The resampled files are neither memory-mapped nor decoded from the
+     * cache directory. This applies to the files preloaded afterwards.
+     *
+     * @param resampling
+     */
+    void setResampling(bool resampling) noexcept { this->resampling = resampling; }
+    /**
+     * @brief Check whether the files are resampled at the engine rate
+     */
+    bool isResampling() const noexcept { return resampling; }
+    /**
+     * @brief Change whether the files with identical contents share their
+     * preloaded data. The files are hashed once, and their hashes kept in
+     * the information cache and its index; a file of the same size and
+     * hash as one preloaded before plays the data of the latter. This
+     * applies to the files preloaded afterwards.
+     *
+     * @param deduplicate
+     */
+    void setDeduplication(bool deduplicate) noexcept { this->deduplicate = deduplicate; }
+    /**
+     * @brief Get the number of files which play the data of another file
+     * with identical contents
+     *
+     * @return size_t
+     */
+    size_t getNumDeduplicatedFiles() const noexcept { return contentAliases.size(); }
+    /**
+     * @brief Set the engine rate, at which the files are resampled. When the
+     * files are resampled, a change reloads the data of all the files, which
+     * must not be played at the moment.
+     *
+     * @param sampleRate
+     */
+    void setSampleRate(double sampleRate) noexcept;
+    /**
+     * @brief Get the engine rate
+     */
+    double getSampleRate() const noexcept { return sampleRate; }
+    /**
+     * @brief Set the factor by which the files are oversampled as they load,
+     * after their decoding and resampling, on the background threads like
+     * the rest of the streaming. The players follow the streamed frames as
+     * they are oversampled, and the preloads grow by the factor, so they
+     * last as long. A change reloads the data of all the files, which must
+     * not be played at the moment; the memory-mapped files keep their rate.
+     *
+     * @param factor
+     */
+    void setOversamplingFactor(Oversampling factor) noexcept;
+    /**
+     * @brief Get the factor by which the files are oversampled
+     */
+    Oversampling getOversamplingFactor() const noexcept { return oversamplingFactor; }
+    /**
+     * @brief Get the number of sample files preloaded in the compact storage
+     *
+     * @return size_t
+     */
+    size_t getNumCompactSamples() const noexcept;
+    /**
+     * @brief Set the directory of the decoded cache. The preloaded data of
+     * compressed files is stored there once decoded, and read back instead
+     * of decoding the files again, on this run or the following ones.
+     * The index of the information cache is kept there too.
+     * An empty path disables the cache.
+     *
+     * @param directory
+     */
+    void setCacheDirectory(const fs::path& directory) { cacheDirectory = directory; }
+    /**
+     * @brief Get the number of files in the information cache, which the
+     * file pools of the process share. It keeps the information read from
+     * each file, as long as the size and modification time of the file stay
+     * the same; with a cache directory, it also persists in an index there.
+     *
+     * @return size_t
+     */
+    static size_t getNumCachedFileInformation();
+    /**
+     * @brief Empty the information cache, in memory only.
+     */
+    static void clearFileInformationCache();
+    /**
+     * @brief Get the directory of the decoded cache
+     *
+     * @return const fs::path&
+     */
+    const fs::path& getCacheDirectory() const noexcept { return cacheDirectory; }
+    /**
+     * @brief Set the usage profile of the instrument, which guides the
+     * preloads which follow. The files which played are preloaded first,
+     * and as far as they played up to config::hotPreloadRatio times the
+     * preload size; the files which never played preload a fraction
+     * config::coldPreloadRatio of it. An empty profile preloads all the files
+     * the same. Call it out of the loading, before loading the instrument.
+     *
+     * @param profile
+     */
+    void setUsageProfile(UsageProfile profile);
+    /**
+     * @brief Get the usage profile of the instrument: the one which was set,
+     * with the usage of the files since.
+     *
+     * @return UsageProfile
+     */
+    UsageProfile getUsageProfile() const;
+    /**
+     * @brief Call a function on the items from 0 to count - 1, on as many
+     * threads as the loading parallelism allows. The function must not use
+     * the pool, which is not thread-safe.
+     *
+     * @param count
+     * @param function
+     */
+    void runLoadingTasks(size_t count, const std::function<void(size_t)>& function) noexcept;
+    /**
+     * @brief Set the window of the bounded streaming mode. Each player of a
+     * file which is not entirely preloaded then streams the file on its own,
+     * holding about this many frames ahead of its play head in memory, and
+     * the loop segment if any. A window of 0 streams the whole files
+     * instead, shared by their players. This applies to the files played
+     * afterwards.
+     *
+     * @param numFrames the window, at least config::minStreamingWindow if not 0
+     */
+    void setStreamingWindow(uint32_t numFrames) noexcept;
+    /**
+     * @brief Get the window of the bounded streaming mode, or 0 if disabled
+     *
+     * @return uint32_t
+     */
+    uint32_t getStreamingWindow() const noexcept { return streamingWindow; }
+    /**
+     * @brief Change whether the uncompressed files are read with the
+     * asynchronous I/O of the system, which keeps many reads in flight from
+     * a single thread, rather than with blocking reads on the background
+     * threads. This applies to the files played afterwards, and has no effect
+     * on systems without asynchronous I/O.
+     *
+     * @param asyncStreaming
+     */
+    void setAsyncStreaming(bool asyncStreaming) noexcept { this->asyncStreaming = asyncStreaming; }
+    /**
+     * @brief Check whether the uncompressed files are read asynchronously
+     *
+     * @return true if enabled and the system supports it
+     */
+    bool isAsyncStreaming() const noexcept { return asyncStreaming && asyncIO; }
+    /**
+     * @brief Get the number of slices read asynchronously so far
+     *
+     * @return uint64_t
+     */
+    uint64_t getNumAsyncReads() const noexcept { return numAsyncReads.load(); }
+    /**
+     * @brief Create the reader of a streamed file, from its path and
+     * direction, setting the error if it fails.
+     */
+    using StreamReaderFactory = std::function<std::unique_ptr<AudioReader>(const fs::path&, bool, std::error_code*)>;
+    /**
+     * @brief Set the factory of the readers which stream the files in the
+     * background, instead of the readers of the files themselves, for
+     * instance to simulate the latency of a slow storage. The readers are
+     * created and used on the background threads, and the asynchronous
+     * reads are bypassed. Set it before playing, or to an empty function to
+     * go back to the readers of the files.
+     *
+     * @param factory
+     */
+    void setStreamReaderFactory(StreamReaderFactory factory) { streamReaderFactory = std::move(factory); }
+    /**
+     * @brief Get the memory held by the bounded streams, in bytes
+     *
+     * @return size_t
+     */
+    size_t getStreamingMemory() const noexcept;
+    /**
+     * @brief Set a budget for the memory of the sample data, in bytes, or 0
+     * for no budget. Over the budget, the streamed data of the idle files is
+     * freed first, least recently played first, and then their preloaded
+     * data is shrunk back to config::minPreloadSize frames past their
+     * offsets, unless all samples are loaded in ram. This applies the
+     * budget right away.
+     *
+     * @param numBytes
+     */
+    void setMemoryBudget(size_t numBytes) noexcept;
+    /**
+     * @brief Get the memory budget, in bytes, or 0 if none
+     *
+     * @return size_t
+     */
+    size_t getMemoryBudget() const noexcept { return memoryBudget; }
+    /**
+     * @brief Free the streamed data of the files as soon as their last
+     * player leaves, instead of after config::fileClearingPeriod. The
+     * streams of the files left without a player pause, and the garbage
+     * collection takes their data back.
+     *
+     * @param immediate
+     */
+    void setImmediateRelease(bool immediate) noexcept { immediateRelease = immediate; }
+    /**
+     * @brief Check whether the streamed data is freed as soon as the last
+     * player of a file leaves.
+     */
+    bool isImmediateRelease() const noexcept { return immediateRelease; }
+    /**
+     * @brief Set the NUMA node of the sample data which the pool loads from
+     * now on, or -1 for the node of the loading thread. The preloads are then
+     * shared with the pools of the same node only, so that every node holds
+     * a replica of the files played on it.
+     *
+     * @param node
+     */
+    void setNumaNode(int node) noexcept { numaNode = (node >= 0) ? node : -1; }
+    /**
+     * @brief Get the NUMA node of the sample data, or -1 if none.
+     */
+    int getNumaNode() const noexcept { return numaNode; }
+    /**
+     * @brief Get the memory of the sample data, in bytes: the preloaded and
+     * loaded data, the streamed data and the bounded streams. The data
+     * shared with other file pools counts in each of them, and the
+     * memory-mapped files do not count.
+     *
+     * @return size_t
+     */
+    size_t getMemoryUsage() const noexcept;
+    /**
+     * @brief Get the memory of the preloaded and loaded sample data, in
+     * bytes, which is part of the memory usage.
+     *
+     * @return size_t
+     */
+    size_t getPreloadedMemory() const noexcept;
+    /**
+     * @brief Get the memory of the streamed sample data and the bounded
+     * streams, in bytes, which is part of the memory usage.
+     *
+     * @return size_t
+     */
+    size_t getStreamedMemory() const noexcept;
+    /**
+     * @brief Bring the memory back under the budget, if any, freeing the
+     * streamed data and shrinking the preloaded data of the idle files.
+     * This is called by the Synth after loading.
+     */
+    void applyMemoryBudget() noexcept;
     /**
      * @brief Prepares unused data to be freed on a background thread.
      * This should be called regularly by the Synth, otherwise memory
      * risk building up.
      */
     void triggerGarbageCollection() noexcept;
+    /**
+     * @brief Take the files which the loaders are done with, for the
+     * garbage collection. This is called by the Synth at every block, from
+     * the audio thread, so that the loaders always have room to hand them.
+     */
+    void collectLastUsedFiles() noexcept;
+
+    struct SharedPreloadStats {
+        size_t numSharedFiles { 0 };
+        size_t bytesSaved { 0 };
+    };
+    /**
+     * @brief Get statistics on the preloaded data that the file pools of the
+     * process share, instead of holding a copy each.
+     *
+     * @return SharedPreloadStats
+     */
+    static SharedPreloadStats getSharedPreloadStats();
+
+    struct UnderrunStats {
+        uint64_t numUnderruns { 0 };
+        uint64_t numMissingFrames { 0 };
+        int lastRegionId { -1 };
+    };
+    /**
+     * @brief Report a streaming underrun, when a player reaches the end of
+     * the loaded frames before the end of the sample. This is lock-free.
+     *
+     * @param regionId the number of the region played
+     * @param numMissingFrames the frames of the block which were left silent
+     */
+    void reportUnderrun(int regionId, size_t numMissingFrames) noexcept
+    {
+        numUnderruns.fetch_add(1, std::memory_order_relaxed);
+        this->numMissingFrames.fetch_add(numMissingFrames, std::memory_order_relaxed);
+        lastUnderrunRegionId.store(regionId, std::memory_order_relaxed);
+    }
+    /**
+     * @brief Get the counters of the streaming underruns since the creation
+     * of the pool or the last reset. This is lock-free.
+     *
+     * @return UnderrunStats
+     */
+    UnderrunStats getUnderrunStats() const noexcept;
+    /**
+     * @brief Reset the counters of the streaming underruns
+     */
+    void resetUnderrunStats() noexcept;
+
+    struct StreamingStats {
+        // Counters, since the creation of the pool
+        uint64_t streamedBytes { 0 }; // of the decoded frames
+        uint64_t numStreams { 0 }; // which read their first slice
+        double totalFirstSliceLatency { 0.0 }; // seconds from the requests to the first slices
+        double maxFirstSliceLatency { 0.0 };
+        uint64_t collectedBytes { 0 }; // of the streamed data the garbage collection freed
+        // Gauges
+        size_t numQueuedRequests { 0 }; // waiting for the dispatching
+        size_t numQueuedStreams { 0 }; // waiting for a slice
+        size_t numLoadingJobs { 0 }; // running a slice
+        // The background workers, which the pools of the process share
+        TaskScheduler::Utilization workers {};
+    };
+    /**
+     * @brief Get the counters and the gauges of the streaming, as of the
+     * last dispatching. This is lock-free.
+     *
+     * @return StreamingStats
+     */
+    StreamingStats getStreamingStats() const noexcept;
 private:
+    /**
+     * @brief Get the preloaded data of a file, reusing the data of another
+     * file pool of the process if it covers at least the requested frames.
+     *
+     * @param file the path of the file
+     * @param reverse whether the file is reversed
+     * @param numFrames the number of frames to preload
+     * @param resampleRate the rate to resample the file at, or 0 to keep its rate
+     * @param segments the segments of a sparse preload, or empty; cleared
+     *                 if the data found is contiguous
+     * @return FileAudioBufferPtr
+     */
+    FileAudioBufferPtr readSharedPreload(const fs::path& file, bool reverse, uint32_t numFrames, double resampleRate,
+        std::vector<FrameRange>& segments) const;
+    /**
+     * @brief Set the preloaded data of a file, in the compact storage if
+     * enabled and the frames are representable there, and otherwise as
+     * floats, sparse if the start ranges of the file allow it. Every kind
+     * is shared with the other file pools.
+     *
+     * @param data the file data to update
+     * @param file the path of the file
+     * @param reverse whether the file is reversed
+     * @param numFrames the number of frames to preload
+     */
+    void setSharedPreload(FileData& data, const fs::path& file, bool reverse, uint32_t numFrames) const;
+    /**
+     * @brief Get the number of frames to preload for a file, from its maximum
+     * offset and preload ratio, and its usage in the usage profile.
+     *
+     * @param information the file information
+     * @param fileId the file
+     */
+    uint32_t getFramesToPreload(const FileInformation& information, const FileId& fileId) const noexcept;
+
+    /**
+     * @brief Prepare where a streamed file is read from. In the encoded RAM
+     * storage, read the bytes of the file into memory. Otherwise, keep the
+     * file open, as long as fewer than config::maxReadaheadFiles are, and
+     * locate the bytes after its preload, which are read ahead when a player
+     * starts. Call it after the preload changes.
+     *
+     * @param data the data of the file
+     * @param fileId the file
+     */
+    void prepareStreamSource(FileData& data, const FileId& fileId) noexcept;
+    /**
+     * @brief Close the file kept open for the read ahead, if any.
+     */
+    void closeReadahead(FileData& data) noexcept;
+    /**
+     * @brief Get the segments of a sparse preload of a file, from its start
+     * ranges: the file head, and the preload size after each range. This is
+     * empty if the preload should be contiguous, which is when they cover
+     * most of its frames, or the data is resampled or in the compact storage.
+     *
+     * @param data the file data, with its data information
+     * @param numFrames the frames of the contiguous preload
+     */
+    std::vector<FrameRange> getPreloadSegments(const FileData& data, uint32_t numFrames) const;
+    /**
+     * @brief Read the preloaded data of a file from the decoded cache, or
+     * decode it and store it in the cache if the format is worth it. The
+     * resampled data bypasses the cache.
+     *
+     * @param file the path of the file
+     * @param reverse whether the file is reversed
+     * @param numFrames the number of frames to preload
+     * @param resampleRate the rate to resample the file at, or 0 to keep its rate
+     * @return FileAudioBuffer
+     */
+    FileAudioBuffer readPreload(const fs::path& file, bool reverse, uint32_t numFrames, double resampleRate) const;
+    /**
+     * @brief Read the segments of a sparse preload of a file, into data of
+     * the frames of the contiguous preload. The decoded cache is bypassed.
+     *
+     * @param file the path of the file
+     * @param reverse whether the file is reversed
+     * @param numFrames the frames of the contiguous preload
+     * @param segments the segments
+     * @return FileAudioBuffer
+     */
+    FileAudioBuffer readSparsePreload(const fs::path& file, bool reverse, uint32_t numFrames, const std::vector<FrameRange>& segments) const;
+    /**
+     * @brief Get the information of the data of a file in the pool, whose
+     * positions are in resampled frames if the pool resamples the file.
+     *
+     * @param information the information of the file
+     */
+    FileInformation getDataInformation(const FileInformation& information) const noexcept;
+    /**
+     * @brief Measure the envelope of a file over its preloaded data, or take
+     * it from the information cache if it was measured for the whole file.
+     *
+     * @param data the file data, with its data information
+     * @param fileId the file
+     */
+    void measureEnvelope(FileData& data, const FileId& fileId) const noexcept;
+    /**
+     * @brief Store the complete envelope of a file into the information
+     * cache, which persists it with the index. The envelopes of the
+     * resampled data are in other frames than those of the file, so they
+     * are not stored.
+     *
+     * @param data the file data, with its data information
+     * @param fileId the file
+     */
+    void storeEnvelope(const FileData& data, const FileId& fileId) const noexcept;
+    /**
+     * @brief Read again the data of the files, after a change of the rate
+     * of the data.
+     */
+    void reloadFileData() noexcept;
+    /**
+     * @brief Get the information of a file from the decoded cache, if present.
+     *
+     * @param file the path of the file
+     * @param reverse whether the file is reversed
+     * @return absl::optional<FileInformation>
+     */
+    absl::optional<FileInformation> readCachedFileInformation(const fs::path& file, bool reverse) const;
+
+    /**
+     * @brief Read the information of a file from the information cache, the
+     * decoded cache, or the file itself. This does not use the state of the
+     * pool.
+     *
+     * @param file the path of the file
+     * @param reverse whether the file is reversed
+     * @return absl::optional<FileInformation>
+     */
+    absl::optional<FileInformation> readFileInformation(const fs::path& file, bool reverse) const noexcept;
+    /**
+     * @brief Write the information cache into the index of the cache
+     * directory, if it changed since it was last written there.
+     */
+    void saveFileInformationIndex() const noexcept;
+    /**
+     * @brief Call a function on the items from 0 to count - 1, on as many
+     * threads as the loading parallelism allows.
+     */
+    template <class F>
+    void runConcurrently(size_t count, F&& function) noexcept;
 
     absl::optional<sfz::FileInformation> checkExistingFileInformation(const FileId& fileId) noexcept;
+    /**
+     * @brief The contents of a file, as its size and the hash of its bytes.
+     */
+    struct ContentKey {
+        uint64_t hash { 0 };
+        int64_t fileSize { 0 };
+        bool reverse { false };
+
+        bool operator==(const ContentKey& other) const noexcept
+        {
+            return hash == other.hash && fileSize == other.fileSize && reverse == other.reverse;
+        }
+
+        template <class H>
+        friend H AbslHashValue(H h, const ContentKey& key)
+        {
+            return H::combine(std::move(h), key.hash, key.fileSize, key.reverse);
+        }
+    };
+    /**
+     * @brief Get the contents of a file, hashing it if the information
+     * cache does not have its hash yet.
+     */
+    absl::optional<ContentKey> getContentKey(const FileId& fileId) const noexcept;
+    /**
+     * @brief Get the file whose data a file plays, which is the first one
+     * preloaded with the same contents, and register it for the next ones.
+     */
+    FileId deduplicateFile(const FileId& fileId) noexcept;
+    /**
+     * @brief Preload the forward data of a reversed file whole, for the
+     * voices to read backward, if the reversed file would preload whole.
+     *
+     * @return true if the file reads the forward data
+     */
+    bool preloadMirroredFile(const FileId& fileId, uint32_t maxOffset, float preloadRatio) noexcept;
+    /**
+     * @brief Get the file whose data a file plays, which is itself unless
+     * it was deduplicated.
+     */
+    const FileId& getContentId(const FileId& fileId) const noexcept
+    {
+        if (contentAliases.empty())
+            return fileId;
+        const auto it = contentAliases.find(fileId);
+        return (it != contentAliases.end()) ? it->second : fileId;
+    }
+    /**
+     * @brief Forget the contents of the files which are no longer preloaded.
+     */
+    void forgetRemovedContents() noexcept;
+    /**
+     * @brief Get the frames of a file which the preloads cover past its
+     * offsets, before the scaling by its playback speed.
+     */
+    double getBasePreloadFrames(const FileInformation& information) const noexcept;
+    /**
+     * @brief Reload the preloaded heads after a change of their size.
+     */
+    void resizePreloads() noexcept;
+    /**
+     * @brief Update the latency which the heads cover in the adaptive mode,
+     * if the measures changed much.
+     *
+     * @return true if it changed
+     */
+    bool updateAdaptiveLatency() noexcept;
     fs::path rootDirectory;
 
     bool loadInRam { config::loadInRam };
+    bool memoryMapped { config::memoryMapped && MappedAudioFile::isSupported() };
+    bool encodedInRam { config::encodedInRam };
+    bool compactStorage { config::compactSamples };
+    bool resampling { config::resampleSamples };
+    bool deduplicate { config::deduplicateSamples };
+    Oversampling oversamplingFactor { Oversampling::x1 };
+    double sampleRate { config::defaultSampleRate };
+    size_t memoryBudget { 0 };
+    std::atomic<bool> immediateRelease { false };
+    std::atomic<int> numaNode { -1 };
+
+    std::atomic<uint64_t> numUnderruns { 0 };
+    std::atomic<uint64_t> numMissingFrames { 0 };
+    std::atomic<int> lastUnderrunRegionId { -1 };
+    std::atomic<uint64_t> numStreamedBytes { 0 };
+    std::atomic<uint64_t> numFirstSlices { 0 };
+    std::atomic<uint64_t> totalFirstSliceNanoseconds { 0 };
+    std::atomic<uint64_t> maxFirstSliceNanoseconds { 0 };
+    std::atomic<uint64_t> numCollectedBytes { 0 };
+    std::atomic<size_t> numQueuedStreams { 0 };
+    std::atomic<size_t> numLoadingJobs { 0 };
+    // The first slice latencies, by powers of 2 of 100 µs
+    static constexpr size_t numLatencyBuckets { 24 };
+    std::array<std::atomic<uint32_t>, numLatencyBuckets> latencyBuckets {};
+    bool adaptivePreloading { false };
+    double adaptiveLatency { 0.0 };
+    fs::path cacheDirectory;
+    unsigned loadingParallelism { config::loadingParallelism };
+    uint32_t streamingWindow { config::streamingWindow };
     uint32_t preloadSize { config::preloadSize };
+    // The profile which guides the preloads, and the usage of the files
+    // removed from the pool since it was set
+    UsageProfile usageProfile;
+    UsageProfile removedUsage;
+    std::atomic<int> numReadaheadFiles { 0 };
 
     // Signals
-    volatile bool dispatchFlag { true };
-    volatile bool garbageFlag { true };
-    RTSemaphore dispatchBarrier;
-    RTSemaphore semGarbageBarrier;
+    std::atomic<bool> dispatchFlag { true };
 
     // Structures for the background loaders
     struct QueuedFileData
     {
         QueuedFileData() noexcept {}
-        QueuedFileData(std::weak_ptr<FileId> id, FileData* data) noexcept
-        : id(id), data(data) {}
-        std::weak_ptr<FileId> id;
+        QueuedFileData(const FileId* id, FileData* data, FileStream* stream, TimePoint origin, double framesPerSecond) noexcept
+        : id(id), data(data), stream(stream), origin(origin), framesPerSecond(framesPerSecond), queued(highResNow()) {}
+        const FileId* id { nullptr }; // the key of the data in the pool, which lives as long as the data
         FileData* data { nullptr };
+        FileStream* stream { nullptr }; // the own stream of the player, in the bounded mode
+        TimePoint origin {}; // when the player would be at the first frame
+        double framesPerSecond { 0.0 }; // the speed of the player, or 0 if unknown
+        TimePoint queued {}; // when the request was made
     };
 
     using FileQueue = atomic_queue::AtomicQueue2<QueuedFileData, config::maxVoices>;
     aligned_unique_ptr<FileQueue> filesToLoad;
 
+    // A file streamed in slices, which lives until the file is done
+    struct StreamJob;
+    /**
+     * @brief Move the requests of the queue into the streams, merging the
+     * requests on the same file into the most urgent.
+     */
+    void collectStreamRequests() noexcept;
+    /**
+     * @brief Collect the slices which are over, and requeue their streams
+     * if unfinished.
+     *
+     * @param wait whether to wait for the running slices
+     */
+    void collectStreamSlices(bool wait) noexcept;
+    /**
+     * @brief Check whether a paused stream lost its file to the garbage
+     * collection, so it has to start over.
+     */
+    static bool isCollectedStream(const StreamJob& job) noexcept;
+    /**
+     * @brief Push a stream into the queue according to its deadline.
+     */
+    void queueStream(StreamJob& job) noexcept;
+    /**
+     * @brief Requeue the paused streams which need more frames.
+     */
+    void resumeStreams() noexcept;
+    /**
+     * @brief Give the bounded streams which their players released back to
+     * the free list, once no job uses them.
+     */
+    void recycleFileStreams() noexcept;
+    /**
+     * @brief Stream the next slice of a file on the calling thread. The
+     * bounded streams pause once their window is full.
+     *
+     * @return true if the stream is over
+     */
+    bool streamSlice(StreamJob& job) noexcept;
+    /**
+     * @brief Open the file of a stream, and claim the file data or allocate
+     * the buffer of the bounded stream.
+     *
+     * @return false if the stream cannot run
+     */
+    bool startStream(StreamJob& job, const FileId& id) noexcept;
+    /**
+     * @brief Get the number of frames of the next slice, and make room for
+     * them in the bounded streams. The bounded streams with a full window
+     * and the files streamed up to their limit are paused instead.
+     */
+    size_t beginSlice(StreamJob& job) noexcept;
+    /**
+     * @brief Account for the frames of a slice which was read.
+     *
+     * @param over whether the end of the file was reached
+     * @return true if the stream is over
+     */
+    bool endSlice(StreamJob& job, bool over) noexcept;
+    /**
+     * @brief Put the file of a stream among the ones the garbage collection
+     * looks at.
+     */
+    void addLastUsedFile(const StreamJob& job) noexcept;
+    /**
+     * @brief Decode the frames of a slice read from an uncompressed file.
+     *
+     * @param numBytes the number of bytes read
+     * @return true if the end of the file was reached
+     */
+    bool decodeRawSlice(StreamJob& job, size_t numBytes) noexcept;
+    /**
+     * @brief Start the next slice of an uncompressed file with the
+     * asynchronous I/O, or read it right away if it cannot be queued.
+     */
+    void startAsyncSlice(StreamJob& job) noexcept;
+    /**
+     * @brief Receive the result of an asynchronous read, on the completion
+     * thread.
+     */
+    void asyncSliceRead(StreamJob& job, int64_t result) noexcept;
+    /**
+     * @brief Mark an asynchronous slice as over.
+     */
+    void finishAsyncSlice(StreamJob& job, bool over) noexcept;
+    std::unique_ptr<AsyncFileIO> createAsyncFileIO() noexcept;
+
+    /**
+     * @brief Collect the requests and the slices which are over, and start
+     * the next slices. This runs on the background workers whenever a file
+     * is requested, a slice is over or a stream needs more frames.
+     */
     void dispatchingJob() noexcept;
+    /**
+     * @brief Run the dispatching once more.
+     */
+    void wakeDispatch() noexcept;
     void garbageJob() noexcept;
-    void loadingJob(const QueuedFileData& data) noexcept;
+    void loadingJob(StreamJob& job) noexcept;
+    /**
+     * @brief Wait until the slice of a loading job is over.
+     */
+    void waitForSlice(StreamJob& job) noexcept;
     std::mutex loadingJobsMutex;
-    std::vector<std::future<void>> loadingJobs;
-    std::thread dispatchThread { &FilePool::dispatchingJob, this };
-    std::thread garbageThread { &FilePool::garbageJob, this };
+    absl::flat_hash_map<const void*, std::unique_ptr<StreamJob>> streams; // by file data or bounded stream
+    std::vector<StreamJob*> streamQueue; // heap, most urgent first
+    std::vector<StreamJob*> pausedStreams;
+    std::vector<StreamJob*> loadingJobs;
+    std::vector<StreamJob*> deferredStreams; // kept while the dispatching thread fills the slices
+
+    // Asynchronous reads of the uncompressed files
+    std::unique_ptr<AsyncFileIO> asyncIO { createAsyncFileIO() };
+    std::atomic<bool> asyncStreaming { config::asyncStreaming };
+    std::atomic<uint64_t> numAsyncReads { 0 };
+    StreamReaderFactory streamReaderFactory;
+
+    // Bounded streams
+    using FileStreamQueue = atomic_queue::AtomicQueue2<FileStream*, config::maxVoices>;
+    std::vector<std::unique_ptr<FileStream>> fileStreams;
+    aligned_unique_ptr<FileStreamQueue> freeFileStreams;
+    std::vector<FileStream*> activeFileStreams;
 
-    SpinMutex garbageAndLastUsedMutex;
+    // The files the loaders are done with, handed to the audio thread, which
+    // keeps them in the last used files until it collects their data
+    using LastUsedQueue = atomic_queue::AtomicQueue2<FileId, config::maxVoices>;
+    aligned_unique_ptr<LastUsedQueue> lastUsedQueue;
     std::vector<FileId> lastUsedFiles;
-    std::vector<FileAudioBuffer> garbageToCollect;
+    // The data the audio thread collected, handed to the garbage task
+    using GarbageQueue = atomic_queue::AtomicQueue2<FileAudioBuffer, config::maxVoices>;
+    aligned_unique_ptr<GarbageQueue> garbageToCollect;
 
-    std::shared_ptr<ThreadPool> threadPool;
+    std::shared_ptr<TaskScheduler> scheduler;
+    struct GarbageTask;
+    std::unique_ptr<GarbageTask> garbageTask;
+    struct DispatchTask;
+    std::unique_ptr<DispatchTask> dispatchTask;
+
+    // Preloads of the deferred files, read on request
+    struct QueuedPreload
+    {
+        const FileId* id { nullptr };
+        FileData* data { nullptr };
+    };
+    using PreloadQueue = atomic_queue::AtomicQueue2<QueuedPreload, config::maxVoices>;
+    aligned_unique_ptr<PreloadQueue> preloadsToLoad;
+    struct PreloadTask;
+    std::unique_ptr<PreloadTask> preloadTask;
+    void preloadJob() noexcept;
+    /**
+     * @brief Wait for the preloads which are read, and put the queued ones
+     * back to the deferred state.
+     */
+    void settleDeferredPreloads() noexcept;
 
     // Preloaded data
     absl::flat_hash_map<FileId, FileData> preloadedFiles;
     absl::flat_hash_map<FileId, FileData> loadedFiles;
+    // Changes when files are added or removed, which may move the data
+    uint32_t filesGeneration { 1 };
+    absl::flat_hash_map<FileId, FileInformation> probedInformation;
+    // The preloaded file of each contents, and the files deduplicated into
+    // another one
+    absl::flat_hash_map<ContentKey, FileId> contentFiles;
+    absl::flat_hash_map<FileId, FileId> contentAliases;
     LEAK_DETECTOR(FilePool);
 };
 }
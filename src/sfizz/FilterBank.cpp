@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "FilterBank.h"
+#include "Config.h"
+#include "MathHelpers.h"
+#include "SIMDHelpers.h"
+#include "utility/Debug.h"
+#include <simde/simde-features.h>
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+#include <simde/x86/sse.h>
+#endif
+#include <algorithm>
+#include <cmath>
+
+namespace sfz {
+
+bool FilterBank::supports(FilterType type) noexcept
+{
+    switch (type) {
+    case kFilterLpf2p:
+    case kFilterHpf2p:
+    case kFilterBpf2p:
+    case kFilterBrf2p:
+        return true;
+    default:
+        return false;
+    }
+}
+
+FilterBank::FilterBank() noexcept
+{
+    init(config::defaultSampleRate);
+}
+
+void FilterBank::init(double sampleRate) noexcept
+{
+    frequencyScale_ = static_cast<float>(2.0 * M_PI / sampleRate);
+    smoothingPole_ = static_cast<float>(std::exp(-1000.0 / sampleRate));
+    invalidateTargets();
+}
+
+void FilterBank::invalidateTargets() noexcept
+{
+    std::fill_n(cutoffs_, maxLanes, -1.0f);
+}
+
+void FilterBank::clear() noexcept
+{
+    for (unsigned k = 0; k < numCoefs; ++k)
+        std::fill_n(coefs_[k], maxLanes, 0.0f);
+    std::fill_n(b1x1_, maxLanes, 0.0f);
+    std::fill_n(b2x1_, maxLanes, 0.0f);
+    std::fill_n(z2_, maxLanes, 0.0f);
+    std::fill_n(y1_, maxLanes, 0.0f);
+}
+
+void FilterBank::setType(FilterType type) noexcept
+{
+    type_ = type;
+    invalidateTargets();
+    clear();
+}
+
+void FilterBank::setTargets(unsigned lane, float cutoff, float q) noexcept
+{
+    // Most lanes keep their parameters between the control points
+    if (cutoff == cutoffs_[lane] && q == resonances_[lane])
+        return;
+
+    cutoffs_[lane] = cutoff;
+    resonances_[lane] = q;
+
+    // the same design as the faust filters
+    const float frequency = std::max(1.0f, std::min(20000.0f, cutoff));
+    const float w = frequencyScale_ * frequency;
+    const float resonance = std::max(0.001f, db2mag(std::min(60.0f, std::max(-60.0f, q))));
+    const float cosw = std::cos(w);
+    const float alpha = 0.5f * std::sin(w) / resonance;
+    const float gain = (1.0f - smoothingPole_) / (1.0f + alpha);
+
+    float b[3] {};
+    switch (type_) {
+    case kFilterLpf2p:
+        b[0] = b[2] = 0.5f * (1.0f - cosw);
+        b[1] = 1.0f - cosw;
+        break;
+    case kFilterHpf2p:
+        b[0] = b[2] = 0.5f * (1.0f + cosw);
+        b[1] = -1.0f - cosw;
+        break;
+    case kFilterBpf2p:
+        b[0] = alpha;
+        b[2] = -alpha;
+        break;
+    case kFilterBrf2p:
+        b[0] = b[2] = 1.0f;
+        b[1] = -2.0f * cosw;
+        break;
+    default:
+        break;
+    }
+
+    const float coefs[numCoefs] { b[0], b[1], b[2], -2.0f * cosw, 1.0f - alpha };
+    for (unsigned k = 0; k < numCoefs; ++k)
+        targets_[k][lane] = coefs[k] * gain;
+}
+
+void FilterBank::prepareLane(unsigned lane, float cutoff, float q) noexcept
+{
+    ASSERT(lane < maxLanes);
+    if (!supports(type_))
+        return;
+
+    setTargets(lane, cutoff, q);
+    const float gain = 1.0f - smoothingPole_;
+    for (unsigned k = 0; k < numCoefs; ++k)
+        coefs_[k][lane] = (gain > 0.0f) ? targets_[k][lane] / gain : 0.0f;
+
+    b1x1_[lane] = 0.0f;
+    b2x1_[lane] = 0.0f;
+    z2_[lane] = 0.0f;
+    y1_[lane] = 0.0f;
+}
+
+void FilterBank::process(const float* const in[], float* const out[], const float cutoff[], const float q[], unsigned numLanes, unsigned nframes) noexcept
+{
+    ASSERT(numLanes <= maxLanes);
+    if (!supports(type_)) {
+        for (unsigned l = 0; l < numLanes; ++l)
+            copy<float>({ in[l], nframes }, { out[l], nframes });
+        return;
+    }
+
+    for (unsigned l = 0; l < numLanes; ++l)
+        setTargets(l, cutoff[l], q[l]);
+
+    run(in, out, numLanes, nframes);
+}
+
+void FilterBank::processModulated(const float* const in[], float* const out[], const float* const cutoff[], const float* const q[], unsigned numLanes, unsigned nframes) noexcept
+{
+    ASSERT(numLanes <= maxLanes);
+    if (!supports(type_)) {
+        for (unsigned l = 0; l < numLanes; ++l)
+            copy<float>({ in[l], nframes }, { out[l], nframes });
+        return;
+    }
+
+    unsigned frame = 0;
+    while (frame < nframes) {
+        unsigned current = nframes - frame;
+
+        if (current > config::filterControlInterval)
+            current = config::filterControlInterval;
+
+        const float* current_in[maxLanes];
+        float* current_out[maxLanes];
+
+        for (unsigned l = 0; l < numLanes; ++l) {
+            setTargets(l, cutoff[l][frame], q[l][frame]);
+            current_in[l] = in[l] + frame;
+            current_out[l] = out[l] + frame;
+        }
+
+        run(current_in, current_out, numLanes, current);
+
+        frame += current;
+    }
+}
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+namespace {
+/**
+ * @brief Transpose 4 vectors of 4 values
+ */
+inline void transpose4(simde__m128& a, simde__m128& b, simde__m128& c, simde__m128& d) noexcept
+{
+    const simde__m128 ab0 = simde_mm_unpacklo_ps(a, b);
+    const simde__m128 cd0 = simde_mm_unpacklo_ps(c, d);
+    const simde__m128 ab1 = simde_mm_unpackhi_ps(a, b);
+    const simde__m128 cd1 = simde_mm_unpackhi_ps(c, d);
+    a = simde_mm_movelh_ps(ab0, cd0);
+    b = simde_mm_movehl_ps(cd0, ab0);
+    c = simde_mm_movelh_ps(ab1, cd1);
+    d = simde_mm_movehl_ps(cd1, ab1);
+}
+} // namespace
+#endif
+
+void FilterBank::run(const float* const in[], float* const out[], unsigned numLanes, unsigned nframes) noexcept
+{
+    // The lanes are interleaved in the block, the unused lanes are silent
+    const unsigned numUsedLanes = (numLanes > 4) ? 8 : 4;
+    static const float silence[blockFrames] {};
+
+    unsigned frame = 0;
+    while (frame < nframes) {
+        const unsigned current = std::min<unsigned>(nframes - frame, blockFrames);
+        const float* inputs[maxLanes];
+        for (unsigned l = 0; l < numUsedLanes; ++l)
+            inputs[l] = (l < numLanes) ? in[l] + frame : silence;
+
+        unsigned i = 0;
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+        for (; i + 4 <= current; i += 4) {
+            for (unsigned l = 0; l < numUsedLanes; l += 4) {
+                simde__m128 x0 = simde_mm_loadu_ps(inputs[l] + i);
+                simde__m128 x1 = simde_mm_loadu_ps(inputs[l + 1] + i);
+                simde__m128 x2 = simde_mm_loadu_ps(inputs[l + 2] + i);
+                simde__m128 x3 = simde_mm_loadu_ps(inputs[l + 3] + i);
+                transpose4(x0, x1, x2, x3);
+                float* frames = block_ + i * maxLanes + l;
+                simde_mm_storeu_ps(frames, x0);
+                simde_mm_storeu_ps(frames + maxLanes, x1);
+                simde_mm_storeu_ps(frames + 2 * maxLanes, x2);
+                simde_mm_storeu_ps(frames + 3 * maxLanes, x3);
+            }
+        }
+#endif
+        for (; i < current; ++i) {
+            for (unsigned l = 0; l < numUsedLanes; ++l)
+                block_[i * maxLanes + l] = inputs[l][i];
+        }
+
+        if (numUsedLanes > 4)
+            runLanes<2>(current);
+        else
+            runLanes<1>(current);
+
+        // The outputs of the unused lanes go to a scratch buffer
+        float* outputs[maxLanes];
+        for (unsigned l = 0; l < numUsedLanes; ++l)
+            outputs[l] = (l < numLanes) ? out[l] + frame : scratch_;
+
+        i = 0;
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+        for (; i + 4 <= current; i += 4) {
+            for (unsigned l = 0; l < numUsedLanes; l += 4) {
+                const float* frames = block_ + i * maxLanes + l;
+                simde__m128 y0 = simde_mm_loadu_ps(frames);
+                simde__m128 y1 = simde_mm_loadu_ps(frames + maxLanes);
+                simde__m128 y2 = simde_mm_loadu_ps(frames + 2 * maxLanes);
+                simde__m128 y3 = simde_mm_loadu_ps(frames + 3 * maxLanes);
+                transpose4(y0, y1, y2, y3);
+                simde_mm_storeu_ps(outputs[l] + i, y0);
+                simde_mm_storeu_ps(outputs[l + 1] + i, y1);
+                simde_mm_storeu_ps(outputs[l + 2] + i, y2);
+                simde_mm_storeu_ps(outputs[l + 3] + i, y3);
+            }
+        }
+#endif
+        for (; i < current; ++i) {
+            for (unsigned l = 0; l < numLanes; ++l)
+                outputs[l][i] = block_[i * maxLanes + l];
+        }
+
+        frame += current;
+    }
+}
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+namespace {
+/**
+ * @brief The biquads of 4 lanes, in registers
+ */
+struct BiquadLanes {
+    BiquadLanes(const float* const targets[], const float* const coefs[], const float* const memory[], unsigned lane) noexcept
+    {
+        t0 = simde_mm_loadu_ps(targets[0] + lane);
+        t1 = simde_mm_loadu_ps(targets[1] + lane);
+        t2 = simde_mm_loadu_ps(targets[2] + lane);
+        t3 = simde_mm_loadu_ps(targets[3] + lane);
+        t4 = simde_mm_loadu_ps(targets[4] + lane);
+        c0 = simde_mm_loadu_ps(coefs[0] + lane);
+        c1 = simde_mm_loadu_ps(coefs[1] + lane);
+        c2 = simde_mm_loadu_ps(coefs[2] + lane);
+        c3 = simde_mm_loadu_ps(coefs[3] + lane);
+        c4 = simde_mm_loadu_ps(coefs[4] + lane);
+        b1x1 = simde_mm_loadu_ps(memory[0] + lane);
+        b2x1 = simde_mm_loadu_ps(memory[1] + lane);
+        z2 = simde_mm_loadu_ps(memory[2] + lane);
+        y1 = simde_mm_loadu_ps(memory[3] + lane);
+    }
+
+    void store(float* const coefs[], float* const memory[], unsigned lane) const noexcept
+    {
+        simde_mm_storeu_ps(coefs[0] + lane, c0);
+        simde_mm_storeu_ps(coefs[1] + lane, c1);
+        simde_mm_storeu_ps(coefs[2] + lane, c2);
+        simde_mm_storeu_ps(coefs[3] + lane, c3);
+        simde_mm_storeu_ps(coefs[4] + lane, c4);
+        simde_mm_storeu_ps(memory[0] + lane, b1x1);
+        simde_mm_storeu_ps(memory[1] + lane, b2x1);
+        simde_mm_storeu_ps(memory[2] + lane, z2);
+        simde_mm_storeu_ps(memory[3] + lane, y1);
+    }
+
+    simde__m128 tick(simde__m128 x, simde__m128 pole) noexcept
+    {
+        c0 = simde_mm_add_ps(simde_mm_mul_ps(pole, c0), t0);
+        c1 = simde_mm_add_ps(simde_mm_mul_ps(pole, c1), t1);
+        c2 = simde_mm_add_ps(simde_mm_mul_ps(pole, c2), t2);
+        c3 = simde_mm_add_ps(simde_mm_mul_ps(pole, c3), t3);
+        c4 = simde_mm_add_ps(simde_mm_mul_ps(pole, c4), t4);
+        const simde__m128 y = simde_mm_sub_ps(
+            simde_mm_add_ps(simde_mm_add_ps(b1x1, simde_mm_mul_ps(c0, x)), z2),
+            simde_mm_mul_ps(c3, y1));
+        z2 = simde_mm_sub_ps(b2x1, simde_mm_mul_ps(c4, y1));
+        b1x1 = simde_mm_mul_ps(c1, x);
+        b2x1 = simde_mm_mul_ps(c2, x);
+        y1 = y;
+        return y;
+    }
+
+    simde__m128 t0, t1, t2, t3, t4;
+    simde__m128 c0, c1, c2, c3, c4;
+    simde__m128 b1x1, b2x1, z2, y1;
+};
+} // namespace
+#endif
+
+template <unsigned NumGroups>
+void FilterBank::runLanes(unsigned numFrames) noexcept
+{
+    static_assert(NumGroups == 1 || NumGroups == 2, "The bank has 4 or 8 lanes");
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    // The groups are independent, so that their recursions run side by side
+    const float* const targets[numCoefs] { targets_[0], targets_[1], targets_[2], targets_[3], targets_[4] };
+    float* const coefs[numCoefs] { coefs_[0], coefs_[1], coefs_[2], coefs_[3], coefs_[4] };
+    float* const memory[4] { b1x1_, b2x1_, z2_, y1_ };
+    const simde__m128 pole = simde_mm_set1_ps(smoothingPole_);
+    BiquadLanes first { targets, coefs, memory, 0 };
+    BiquadLanes second { targets, coefs, memory, 4 };
+
+    for (unsigned i = 0; i < numFrames; ++i) {
+        float* frame = block_ + i * maxLanes;
+        simde_mm_storeu_ps(frame, first.tick(simde_mm_loadu_ps(frame), pole));
+        if (NumGroups > 1)
+            simde_mm_storeu_ps(frame + 4, second.tick(simde_mm_loadu_ps(frame + 4), pole));
+    }
+
+    first.store(coefs, memory, 0);
+    if (NumGroups > 1)
+        second.store(coefs, memory, 4);
+#else
+    const float pole = smoothingPole_;
+    for (unsigned l = 0; l < 4 * NumGroups; ++l) {
+        float coefs[numCoefs];
+        for (unsigned k = 0; k < numCoefs; ++k)
+            coefs[k] = coefs_[k][l];
+        float b1x1 = b1x1_[l];
+        float b2x1 = b2x1_[l];
+        float z2 = z2_[l];
+        float y1 = y1_[l];
+
+        for (unsigned i = 0; i < numFrames; ++i) {
+            for (unsigned k = 0; k < numCoefs; ++k)
+                coefs[k] = pole * coefs[k] + targets_[k][l];
+
+            float& frame = block_[i * maxLanes + l];
+            const float x = frame;
+            const float y = b1x1 + coefs[0] * x + z2 - coefs[3] * y1;
+            z2 = b2x1 - coefs[4] * y1;
+            b1x1 = coefs[1] * x;
+            b2x1 = coefs[2] * x;
+            y1 = y;
+            frame = y;
+        }
+
+        for (unsigned k = 0; k < numCoefs; ++k)
+            coefs_[k][l] = coefs[k];
+        b1x1_[l] = b1x1;
+        b2x1_[l] = b2x1;
+        z2_[l] = z2;
+        y1_[l] = y1;
+    }
+#endif
+}
+
+} // namespace sfz
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "SfzFilter.h"
+
+namespace sfz {
+
+/**
+   Bank of mono filters of a single type, which run side by side in the lanes
+   of vector registers, each lane with its own parameters and memory.
+   A lane is a voice, or a channel of a stereo voice.
+
+   The lanes compute like `Filter`, with the same smoothing of coefficients,
+   in single precision. Only the resonant 2-pole filters are available:
+   `lpf_2p`, `hpf_2p`, `bpf_2p` and `brf_2p`.
+
+   Parameters:
+     `cutoff`: it's the opcode `filN_cutoff` (Hz)
+     `q`: it's the opcode `filN_resonance` (dB)
+ */
+class FilterBank {
+public:
+    enum { maxLanes = 8 };
+
+    FilterBank() noexcept;
+
+    /**
+       Check whether the bank can run a type of filter.
+     */
+    static bool supports(FilterType type) noexcept;
+
+    /**
+       Set up the filter constants.
+       Run it exactly once after instantiating.
+     */
+    void init(double sampleRate) noexcept;
+
+    /**
+       Reinitialize the memory of all the lanes to zeros.
+     */
+    void clear() noexcept;
+
+    /**
+       Clear the memory of a lane, and compute its initial coefficients
+       unaffected by any smoothing.
+
+       Make sure to set the filter type first.
+     */
+    void prepareLane(unsigned lane, float cutoff, float q) noexcept;
+
+    /**
+       Process one cycle of the first `numLanes` lanes without modulating
+       cutoff or Q. `cutoff[l]` and `q[l]` are the parameters of lane `l`.
+       `in[l]` and `out[l]` may refer to identical buffers, for in-place processing
+     */
+    void process(const float* const in[], float* const out[], const float cutoff[], const float q[], unsigned numLanes, unsigned nframes) noexcept;
+
+    /**
+       Process one cycle of the first `numLanes` lanes with cutoff and Q values
+       varying over time. `cutoff[l]` and `q[l]` are the parameters of lane `l`.
+       `in[l]` and `out[l]` may refer to identical buffers, for in-place processing
+     */
+    void processModulated(const float* const in[], float* const out[], const float* const cutoff[], const float* const q[], unsigned numLanes, unsigned nframes) noexcept;
+
+    /**
+       Get the type of filter.
+     */
+    FilterType type() const noexcept { return type_; }
+
+    /**
+       Set the type of filter, and clear the memory of all the lanes.
+       The types which the bank cannot run process nothing.
+     */
+    void setType(FilterType type) noexcept;
+
+private:
+    void setTargets(unsigned lane, float cutoff, float q) noexcept;
+    void invalidateTargets() noexcept;
+    void run(const float* const in[], float* const out[], unsigned numLanes, unsigned nframes) noexcept;
+    template <unsigned NumGroups>
+    void runLanes(unsigned numFrames) noexcept;
+
+    // the coefficients b0, b1, b2, a1, a2 of the biquad
+    enum { numCoefs = 5 };
+    // frames staged in the interleaved block at once
+    enum { blockFrames = 32 };
+
+    FilterType type_ { kFilterNone };
+    float frequencyScale_ {};
+    float smoothingPole_ {};
+    // the parameters of the targets
+    float cutoffs_[maxLanes] {};
+    float resonances_[maxLanes] {};
+    // the targets, premultiplied by the complement of the pole
+    float targets_[numCoefs][maxLanes] {};
+    float coefs_[numCoefs][maxLanes] {};
+    // the memory: b1 x[n-1], b2 x[n-1], b2 x[n-2] - a2 y[n-2], and y[n-1]
+    float b1x1_[maxLanes] {};
+    float b2x1_[maxLanes] {};
+    float z2_[maxLanes] {};
+    float y1_[maxLanes] {};
+    float block_[blockFrames * maxLanes] {};
+    float scratch_[blockFrames] {};
+};
+
+} // namespace sfz
@@ -1,10 +1,13 @@
 #include "FilterPool.h"
 #include "Region.h"
 #include "Resources.h"
+#include "SynthConfig.h"
 #include "BufferPool.h"
 #include "SIMDHelpers.h"
 #include "utility/SwapAndPop.h"
 #include <absl/algorithm/container.h>
+#include <algorithm>
+#include <limits>
 #include <thread>
 #include <chrono>
 
@@ -15,13 +18,74 @@ sfz::FilterHolder::FilterHolder(Resources& resources)
     filter->init(config::defaultSampleRate);
 }
 
+size_t sfz::FilterHolder::getMemoryUsage() const noexcept
+{
+    return sizeof(FilterHolder) + (filter ? filter->getMemoryUsage() : 0);
+}
+
 void sfz::FilterHolder::reset()
 {
     filter->clear();
     prepared = false;
 }
 
-void sfz::FilterHolder::setup(const Region& region, unsigned filterId, int noteNumber, float velocity)
+float sfz::FilterHolder::transparentCutoff() const noexcept
+{
+    if (description == nullptr)
+        return std::numeric_limits<float>::infinity();
+
+    switch (description->type) {
+    case kFilterLpf1p:
+    case kFilterLpf2p:
+    case kFilterLpf4p:
+    case kFilterLpf6p:
+    case kFilterLpf2pSv:
+        // Under Nyquist, even a cutoff near the top of the audible band dulls
+        // the top octave, which a bypass would change
+        return 0.5f * sampleRate;
+    default:
+        return std::numeric_limits<float>::infinity();
+    }
+}
+
+bool sfz::FilterHolder::isTransparent(float cutoff, float resonance) const noexcept
+{
+    return cutoff >= transparentCutoff() && resonance <= 0.0f;
+}
+
+template <class Process>
+void sfz::FilterHolder::passThrough(const float** inputs, float** outputs, unsigned numFrames, Process&& process)
+{
+    const unsigned numChannels = filter->channels();
+    for (unsigned channelIdx = 0; channelIdx < numChannels; channelIdx++) {
+        if (inputs[channelIdx] != outputs[channelIdx])
+            copy<float>({ inputs[channelIdx], numFrames }, { outputs[channelIdx], numFrames });
+    }
+
+    // The poles of an open filter are near the origin, so a few frames are
+    // enough for its state to follow the input, and resume without a click
+    const unsigned tailFrames = std::min(numFrames, config::filterPassthroughFrames);
+    const unsigned offset = numFrames - tailFrames;
+    float scratch[2][config::filterPassthroughFrames];
+    const float* tailInputs[2] {};
+    float* tailOutputs[2] {};
+    for (unsigned channelIdx = 0; channelIdx < numChannels && channelIdx < 2; channelIdx++) {
+        tailInputs[channelIdx] = outputs[channelIdx] + offset;
+        tailOutputs[channelIdx] = scratch[channelIdx];
+    }
+    process(tailInputs, tailOutputs, offset, tailFrames);
+}
+
+sfz::FilterHolder::Targets sfz::FilterHolder::findTargets(const ModMatrix& mm, const Region& region, unsigned filterId)
+{
+    Targets targets;
+    targets.gain = mm.findTarget(ModKey::createNXYZ(ModId::FilGain, region.id, filterId));
+    targets.cutoff = mm.findTarget(ModKey::createNXYZ(ModId::FilCutoff, region.id, filterId));
+    targets.resonance = mm.findTarget(ModKey::createNXYZ(ModId::FilResonance, region.id, filterId));
+    return targets;
+}
+
+void sfz::FilterHolder::setup(const Region& region, unsigned filterId, const Targets& targets, int noteNumber, float velocity)
 {
     ASSERT(velocity >= 0.0f && velocity <= 1.0f);
     ASSERT(filterId < region.filters.size());
@@ -29,6 +93,7 @@ void sfz::FilterHolder::setup(const Region& region, unsigned filterId, int noteN
     this->description = &region.filters[filterId];
     filter->setType(description->type);
     filter->setChannels(region.isStereo() ? 2 : 1);
+    filter->setTabulated(resources.getSynthConfig().tabulatedFilters);
 
     // Setup the base values
     baseCutoff = description->cutoff;
@@ -51,10 +116,9 @@ void sfz::FilterHolder::setup(const Region& region, unsigned filterId, int noteN
     baseGain = description->gain;
     baseResonance = description->resonance;
 
-    ModMatrix& mm = resources.getModMatrix();
-    gainTarget = mm.findTarget(ModKey::createNXYZ(ModId::FilGain, region.id, filterId));
-    cutoffTarget = mm.findTarget(ModKey::createNXYZ(ModId::FilCutoff, region.id, filterId));
-    resonanceTarget = mm.findTarget(ModKey::createNXYZ(ModId::FilResonance, region.id, filterId));
+    gainTarget = targets.gain;
+    cutoffTarget = targets.cutoff;
+    resonanceTarget = targets.resonance;
 
     // Disable smoothing of the parameters on the first call
     prepared = false;
@@ -71,7 +135,43 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
         return;
     }
 
+    // The cache of the lane which renders the voice in this block
+    filter->setCoefficientCache(&resources.getFilterCoefficientCache());
+
     ModMatrix& mm = resources.getModMatrix();
+    bool cutoffConstant;
+    bool resonanceConstant;
+    bool gainConstant;
+    const float* cutoffMod = mm.getModulation(cutoffTarget, cutoffConstant);
+    const float* resonanceMod = mm.getModulation(resonanceTarget, resonanceConstant);
+    const float* gainMod = mm.getModulation(gainTarget, gainConstant);
+
+    // Constant parameters are processed as scalars
+    if ((!cutoffMod || cutoffConstant) && (!resonanceMod || resonanceConstant) && (!gainMod || gainConstant)) {
+        float cutoff = baseCutoff;
+        if (cutoffMod)
+            cutoff *= centsFactor(cutoffMod[0]);
+        cutoff = Default::filterCutoff.bounds.clamp(cutoff);
+        const float resonance = resonanceMod ? (baseResonance + resonanceMod[0]) : baseResonance;
+        const float gain = gainMod ? (baseGain + gainMod[0]) : baseGain;
+
+        if (!prepared) {
+            filter->prepare(cutoff, resonance, gain);
+            prepared = true;
+        }
+
+        if (isTransparent(cutoff, resonance)) {
+            passThrough(inputs, outputs, numFrames,
+                [&](const float** in, float** out, unsigned, unsigned count) {
+                    filter->process(in, out, cutoff, resonance, gain, count);
+                });
+            return;
+        }
+
+        filter->process(inputs, outputs, cutoff, resonance, gain, numFrames);
+        return;
+    }
+
     BufferPool& bufferPool = resources.getBufferPool();
     auto cutoffSpan = bufferPool.getBuffer(numFrames);
     auto resonanceSpan = bufferPool.getBuffer(numFrames);
@@ -80,26 +180,40 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
     if (!cutoffSpan || !resonanceSpan || !gainSpan)
         return;
 
-    fill<float>(*cutoffSpan, baseCutoff);
-    if (float* mod = mm.getModulation(cutoffTarget)) {
-        for (size_t i = 0; i < numFrames; ++i)
-            (*cutoffSpan)[i] *= centsFactor(mod[i]);
+    if (cutoffMod) {
+        centsFactor<float>(absl::MakeConstSpan(cutoffMod, numFrames), *cutoffSpan);
+        applyGain1<float>(baseCutoff, *cutoffSpan);
+    } else {
+        fill<float>(*cutoffSpan, baseCutoff);
     }
     sfz::clampAll(*cutoffSpan, Default::filterCutoff.bounds);
 
     fill<float>(*resonanceSpan, baseResonance);
-    if (float* mod = mm.getModulation(resonanceTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *resonanceSpan);
+    if (resonanceMod)
+        add<float>(absl::Span<const float>(resonanceMod, numFrames), *resonanceSpan);
 
     fill<float>(*gainSpan, baseGain);
-    if (float* mod = mm.getModulation(gainTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *gainSpan);
+    if (gainMod)
+        add<float>(absl::Span<const float>(gainMod, numFrames), *gainSpan);
 
     if (!prepared) {
         filter->prepare(cutoffSpan->front(), resonanceSpan->front(), gainSpan->front());
         prepared = true;
     }
 
+    // Transparent if it stays so over the whole block
+    const float openCutoff = transparentCutoff();
+    if (openCutoff <= Default::filterCutoff.bounds.getEnd()
+        && allWithin<float>(*cutoffSpan, openCutoff, Default::filterCutoff.bounds.getEnd())
+        && allWithin<float>(*resonanceSpan, std::numeric_limits<float>::lowest(), 0.0f)) {
+        passThrough(inputs, outputs, numFrames,
+            [&](const float** in, float** out, unsigned offset, unsigned count) {
+                filter->processModulated(in, out, cutoffSpan->data() + offset,
+                    resonanceSpan->data() + offset, gainSpan->data() + offset, count);
+            });
+        return;
+    }
+
     filter->processModulated(
         inputs,
         outputs,
@@ -113,5 +227,6 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
 
 void sfz::FilterHolder::setSampleRate(float sampleRate)
 {
+    this->sampleRate = sampleRate;
     filter->init(static_cast<double>(sampleRate));
 }
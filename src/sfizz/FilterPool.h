@@ -15,15 +15,32 @@ class FilterHolder
 public:
     FilterHolder() = delete;
     FilterHolder(Resources& resources);
+    /**
+     * @brief The modulation targets of a filter of a region
+     */
+    struct Targets {
+        ModMatrix::TargetId gain;
+        ModMatrix::TargetId cutoff;
+        ModMatrix::TargetId resonance;
+    };
+    /**
+     * @brief Find the modulation targets of a filter of a region
+     *
+     * @param mm
+     * @param region
+     * @param filterId      the filter index in the region
+     */
+    static Targets findTargets(const ModMatrix& mm, const Region& region, unsigned filterId);
     /**
      * @brief Setup a new filter based on a filter description, and a triggering note parameters.
      *
      * @param description   the region from which we take the filter
      * @param filterId      the filter index in the region
+     * @param targets       the modulation targets of the filter, as of findTargets()
      * @param noteNumber    the triggering note number
      * @param velocity      the triggering note velocity/value
      */
-    void setup(const Region& region, unsigned filterId, int noteNumber = static_cast<int>(Default::key), float velocity = 0);
+    void setup(const Region& region, unsigned filterId, const Targets& targets, int noteNumber = static_cast<int>(Default::key), float velocity = 0);
     /**
      * @brief Process a block of stereo inputs
      *
@@ -42,7 +59,29 @@ public:
      * Reset the filter.
      */
     void reset();
+    /**
+     * @brief Is the filter taken as transparent for these parameters? This
+     * is a lowpass filter which is fully open, from Nyquist on, without
+     * resonance.
+     */
+    bool isTransparent(float cutoff, float resonance) const noexcept;
+    /**
+     * @brief Get the memory of the holder and its filter, in bytes
+     */
+    size_t getMemoryUsage() const noexcept;
 private:
+    /**
+     * @brief The cutoff from which the filter is transparent, or infinity if
+     * it never is.
+     */
+    float transparentCutoff() const noexcept;
+    /**
+     * @brief Pass the block through, and run the filter over its last frames
+     * into scratch buffers.
+     */
+    template <class Process>
+    void passThrough(const float** inputs, float** outputs, unsigned numFrames, Process&& process);
+
     Resources& resources;
     const FilterDescription* description;
     std::unique_ptr<Filter> filter;
@@ -52,6 +91,7 @@ private:
     ModMatrix::TargetId gainTarget;
     ModMatrix::TargetId cutoffTarget;
     ModMatrix::TargetId resonanceTarget;
+    float sampleRate { config::defaultSampleRate };
     bool prepared { false };
 };
 
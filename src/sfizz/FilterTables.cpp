@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "FilterTables.h"
+#include "Config.h"
+#include "MathHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+namespace sfz {
+
+// the ranges of the faust filters
+static constexpr float minCutoff = 1.0f;
+static constexpr float maxCutoff = 20000.0f;
+static constexpr float minResonance = -60.0f;
+static constexpr float maxResonance = 60.0f;
+// the octaves of the cutoff table, up to 2^15 Hz
+static constexpr int numOctaves = 15;
+
+/**
+   Cubic Hermite interpolation between `y0` and `y1` at `mu` in [0, 1],
+   where `d0` and `d1` are the slopes scaled to the length of the interval.
+ */
+static inline double hermite(double y0, double d0, double y1, double d1, double mu) noexcept
+{
+    const double c2 = 3.0 * (y1 - y0) - 2.0 * d0 - d1;
+    const double c3 = 2.0 * (y0 - y1) + d0 + d1;
+    return y0 + mu * (d0 + mu * (c2 + mu * c3));
+}
+
+RbjCoefficientTable::RbjCoefficientTable(double sampleRate)
+    : sampleRate_(sampleRate), frequencyScale_(2.0 * M_PI / sampleRate)
+{
+    constexpr int stepsPerOctave = config::filterTableStepsPerOctave;
+    const size_t size = numOctaves * stepsPerOctave + 1;
+    versines_.resize(size);
+    sines_.resize(size);
+
+    for (size_t i = 0; i < size; ++i) {
+        const int octave = static_cast<int>(i / stepsPerOctave);
+        const int step = static_cast<int>(i % stepsPerOctave);
+        const double frequency = std::ldexp(1.0 + double(step) / stepsPerOctave, octave);
+        const double w = frequencyScale_ * frequency;
+        const double halfSine = std::sin(0.5 * w);
+        versines_[i] = 2.0 * halfSine * halfSine;
+        sines_[i] = std::sin(w);
+    }
+}
+
+std::shared_ptr<const RbjCoefficientTable> RbjCoefficientTable::get(double sampleRate)
+{
+    static std::mutex mutex;
+    static std::vector<std::weak_ptr<const RbjCoefficientTable>> tables;
+
+    std::lock_guard<std::mutex> lock { mutex };
+
+    std::shared_ptr<const RbjCoefficientTable> table;
+    auto it = tables.begin();
+    while (it != tables.end()) {
+        std::shared_ptr<const RbjCoefficientTable> existing = it->lock();
+        if (!existing)
+            it = tables.erase(it);
+        else {
+            if (existing->sampleRate() == sampleRate)
+                table = std::move(existing);
+            ++it;
+        }
+    }
+
+    if (!table) {
+        table = std::make_shared<const RbjCoefficientTable>(sampleRate);
+        tables.emplace_back(table);
+    }
+
+    return table;
+}
+
+bool RbjCoefficientTable::supports(FilterType type) noexcept
+{
+    switch (type) {
+    case kFilterLpf2p:
+    case kFilterHpf2p:
+    case kFilterBpf2p:
+    case kFilterBrf2p:
+        return true;
+    default:
+        return false;
+    }
+}
+
+BiquadCoefficients RbjCoefficientTable::design(FilterType type, double versine, double sine, double alphaFactor) noexcept
+{
+    const double cosw = 1.0 - versine;
+    const double alpha = sine * alphaFactor;
+    const double gain = 1.0 / (1.0 + alpha);
+
+    BiquadCoefficients c {};
+    switch (type) {
+    case kFilterLpf2p:
+        c.b0 = c.b2 = 0.5 * versine * gain;
+        c.b1 = versine * gain;
+        break;
+    case kFilterHpf2p:
+        c.b0 = c.b2 = 0.5 * (1.0 + cosw) * gain;
+        c.b1 = (-1.0 - cosw) * gain;
+        break;
+    case kFilterBpf2p:
+        c.b0 = alpha * gain;
+        c.b2 = -alpha * gain;
+        break;
+    case kFilterBrf2p:
+        c.b0 = c.b2 = gain;
+        c.b1 = -2.0 * cosw * gain;
+        break;
+    default:
+        break;
+    }
+    c.a1 = -2.0 * cosw * gain;
+    c.a2 = (1.0 - alpha) * gain;
+    return c;
+}
+
+double RbjCoefficientTable::alphaFactor(float q) noexcept
+{
+    constexpr int stepsPerDecibel = config::filterTableStepsPerDecibel;
+    constexpr int size = static_cast<int>(maxResonance - minResonance) * stepsPerDecibel + 1;
+
+    // by resonance, the factor `1 / (2 Q)` of the sine in `alpha`
+    struct Factors {
+        Factors()
+        {
+            for (int i = 0; i < size; ++i) {
+                const double resonance = std::pow(10.0, 0.05 * (minResonance + double(i) / stepsPerDecibel));
+                values[i] = 0.5 / std::max(0.001, resonance);
+            }
+        }
+        double values[size];
+    };
+    static const Factors factors;
+
+    const double position = (double(std::min(maxResonance, std::max(minResonance, q))) - minResonance) * stepsPerDecibel;
+    const int index = std::min(static_cast<int>(position), size - 2);
+    const double mu = position - index;
+
+    // the derivative of the factor, per step
+    constexpr double slope = -0.05 * 2.302585092994046 / stepsPerDecibel;
+    const double f0 = factors.values[index];
+    const double f1 = factors.values[index + 1];
+    return hermite(f0, f0 * slope, f1, f1 * slope, mu);
+}
+
+BiquadCoefficients RbjCoefficientTable::compute(FilterType type, float cutoff, float q) const noexcept
+{
+    constexpr int stepsPerOctave = config::filterTableStepsPerOctave;
+    const float frequency = std::max(minCutoff, std::min(maxCutoff, cutoff));
+    const Fraction<uint64_t> mantissa = fp_mantissa(frequency);
+    const double position = double(mantissa.num) * (double(stepsPerOctave) / double(mantissa.den));
+    const int step = static_cast<int>(position);
+    const double mu = position - step;
+    const int octave = fp_exponent(frequency);
+    const size_t index = octave * stepsPerOctave + step;
+
+    // the derivatives in w are `sin(w)` and `cos(w)`, scaled by the step
+    const double dw = frequencyScale_ * double(1 << octave) * (1.0 / stepsPerOctave);
+    const double v0 = versines_[index];
+    const double v1 = versines_[index + 1];
+    const double s0 = sines_[index];
+    const double s1 = sines_[index + 1];
+    const double versine = hermite(v0, s0 * dw, v1, s1 * dw, mu);
+    const double sine = hermite(s0, (1.0 - v0) * dw, s1, (1.0 - v1) * dw, mu);
+
+    return design(type, versine, sine, alphaFactor(q));
+}
+
+BiquadCoefficients RbjCoefficientTable::computeExact(FilterType type, double sampleRate, float cutoff, float q) noexcept
+{
+    const double frequency = std::max(minCutoff, std::min(maxCutoff, cutoff));
+    const double w = 2.0 * M_PI / sampleRate * frequency;
+    const double resonance = std::max(0.001, std::pow(10.0, 0.05 * std::min(maxResonance, std::max(minResonance, q))));
+    return design(type, 1.0 - std::cos(w), std::sin(w), 0.5 / resonance);
+}
+
+const BiquadCoefficients& FilterCoefficientCache::compute(const RbjCoefficientTable& table, FilterType type, float cutoff, float q) noexcept
+{
+    uint32_t cutoffBits;
+    uint32_t qBits;
+    std::memcpy(&cutoffBits, &cutoff, sizeof(float));
+    std::memcpy(&qBits, &q, sizeof(float));
+    const uint32_t hash = (cutoffBits * 0x9E3779B1u) ^ (qBits * 0x85EBCA77u) ^ static_cast<uint32_t>(type);
+    Entry& entry = entries_[(hash >> 16) % entries_.size()];
+
+    const double sampleRate = table.sampleRate();
+    if (entry.epoch == epoch_ && entry.type == type && entry.cutoff == cutoff
+        && entry.q == q && entry.sampleRate == sampleRate) {
+        ++numHits_;
+        return entry.coefs;
+    }
+
+    ++numMisses_;
+    entry.epoch = epoch_;
+    entry.type = type;
+    entry.cutoff = cutoff;
+    entry.q = q;
+    entry.sampleRate = sampleRate;
+    entry.coefs = table.compute(type, cutoff, q);
+    return entry.coefs;
+}
+
+void FilterCoefficientCache::clear() noexcept
+{
+    if (++epoch_ == 0) {
+        // wrapped around, the old epochs would look current
+        for (Entry& entry : entries_)
+            entry.epoch = 0;
+        epoch_ = 1;
+    }
+}
+
+} // namespace sfz
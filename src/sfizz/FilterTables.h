@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "SfzFilter.h"
+#include "Config.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sfz {
+
+/**
+   Coefficients of a biquad, normalized such that `a0` is unity.
+ */
+struct BiquadCoefficients {
+    double b0, b1, b2, a1, a2;
+};
+
+/**
+   Tabulated design of the resonant 2-pole filters `lpf_2p`, `hpf_2p`,
+   `bpf_2p` and `brf_2p`, with the RBJ formulas of the faust filters.
+
+   The tables replace the trigonometric terms of the cutoff and the power of
+   the resonance by cubic interpolations, which modulated filters recompute
+   at every control interval. The splines take their slopes from the analytic
+   derivatives, so the tables only store the values. The cutoffs are spaced
+   in octaves, and linearly within an octave, so the exponent and mantissa of
+   the cutoff locate it.
+
+   The tables of the cutoff hold for a single sample rate, and are shared by
+   the filters at this sample rate.
+
+   Parameters:
+     `cutoff`: it's the opcode `filN_cutoff` (Hz)
+     `q`: it's the opcode `filN_resonance` (dB)
+ */
+class RbjCoefficientTable {
+public:
+    explicit RbjCoefficientTable(double sampleRate);
+
+    /**
+       Get the table shared at a sample rate, creating it if there is none.
+       The creation allocates, do not call it in the RT thread.
+     */
+    static std::shared_ptr<const RbjCoefficientTable> get(double sampleRate);
+
+    /**
+       Check whether the tables can design a type of filter.
+     */
+    static bool supports(FilterType type) noexcept;
+
+    /**
+       Get the sample rate of the table.
+     */
+    double sampleRate() const noexcept { return sampleRate_; }
+
+    /**
+       Compute the coefficients of a filter by interpolation of the tables.
+       Make sure the type is supported.
+     */
+    BiquadCoefficients compute(FilterType type, float cutoff, float q) const noexcept;
+
+    /**
+       Compute the coefficients of a filter like the faust filters do,
+       without the tables.
+     */
+    static BiquadCoefficients computeExact(FilterType type, double sampleRate, float cutoff, float q) noexcept;
+
+private:
+    static BiquadCoefficients design(FilterType type, double versine, double sine, double alphaFactor) noexcept;
+    static double alphaFactor(float q) noexcept;
+
+    double sampleRate_ {};
+    double frequencyScale_ {};
+    // by cutoff, `1 - cos(w)` and `sin(w)`
+    std::vector<double> versines_;
+    std::vector<double> sines_;
+};
+
+/**
+   Cache of the designs of the tabulated filters, which the filters with the
+   same parameters share over a block: the sister voices, the unison layers,
+   or the chords of a region without key tracking.
+
+   The entries are keyed on the type, the cutoff, the resonance and the sample
+   rate, and remain until the next clear, usually at the start of the block.
+   A cache is not shared; each render lane has its own.
+ */
+class FilterCoefficientCache {
+public:
+    /**
+       Get the coefficients of a filter from the cache, or design them from
+       the tables and keep them. Make sure the type is supported.
+     */
+    const BiquadCoefficients& compute(const RbjCoefficientTable& table, FilterType type, float cutoff, float q) noexcept;
+
+    /**
+       Forget all the entries.
+     */
+    void clear() noexcept;
+
+    /**
+       Get the number of designs which were found in the cache, and which were
+       not, since the creation.
+     */
+    uint64_t getNumHits() const noexcept { return numHits_; }
+    uint64_t getNumMisses() const noexcept { return numMisses_; }
+
+private:
+    struct Entry {
+        uint32_t epoch { 0 };
+        FilterType type {};
+        float cutoff {};
+        float q {};
+        double sampleRate {};
+        BiquadCoefficients coefs {};
+    };
+
+    // the entries of other epochs are stale, which clears them all at once
+    uint32_t epoch_ { 1 };
+    uint64_t numHits_ { 0 };
+    uint64_t numMisses_ { 0 };
+    std::array<Entry, config::filterCoefficientCacheSize> entries_ {};
+};
+
+} // namespace sfz
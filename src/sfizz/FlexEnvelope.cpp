@@ -29,6 +29,8 @@
 #include "Config.h"
 #include "SIMDHelpers.h"
 #include <absl/types/optional.h>
+#include <algorithm>
+#include <cmath>
 
 namespace sfz {
 
@@ -71,6 +73,11 @@ FlexEnvelope::~FlexEnvelope()
 {
 }
 
+size_t FlexEnvelope::getMemoryUsage() const noexcept
+{
+    return sizeof(FlexEnvelope) + sizeof(Impl);
+}
+
 void FlexEnvelope::setSampleRate(double sampleRate)
 {
     Impl& impl = *impl_;
@@ -230,30 +237,42 @@ void FlexEnvelope::Impl::process(absl::Span<float> out)
         if (currentFramesUntilRelease_)
             maxFrameIndex = std::min(maxFrameIndex, frameIndex + *currentFramesUntilRelease_);
 
-        // Process the current stage
-        float time = currentTime_;
-        float level = currentLevel_;
+        // Process the frames of the current stage at once: the times, their
+        // shapes and the levels go by vectors
         const float stageEndTime = stageTime_;
         const float sourceLevel = stageSourceLevel_;
         const float targetLevel = stageTargetLevel_;
         const bool sustained = stageSustained_;
-        const Curve& curve = *stageCurve_;
-        size_t framesDone = 0;
-        while ((time < stageEndTime || sustained) && frameIndex < maxFrameIndex) {
-            time += samplePeriod;
-            float x = time * (1.0f / stageEndTime);
-            float c = curve.evalNormalized(x);
-            level = sourceLevel + c * (targetLevel - sourceLevel);
-            out[frameIndex++] = level;
-            ++framesDone;
+        size_t framesDone = maxFrameIndex - frameIndex;
+        bool stageComplete = false;
+        if (!sustained) {
+            const double framesLeft = std::ceil(double(stageEndTime - currentTime_) / samplePeriod);
+            const size_t stageFrames = static_cast<size_t>(std::max(1.0, framesLeft));
+            if (stageFrames <= framesDone) {
+                framesDone = stageFrames;
+                stageComplete = true;
+            }
+        }
+
+        if (framesDone > 0) {
+            const absl::Span<float> segment = out.subspan(frameIndex, framesDone);
+            const float time = currentTime_;
+            linearRamp<float>(segment, time + samplePeriod, samplePeriod);
+            applyGain1(1.0f / stageEndTime, segment);
+            stageCurve_->evalSpan(segment, segment);
+            applyGain1(targetLevel - sourceLevel, segment);
+            add1(sourceLevel, segment);
+            currentLevel_ = segment.back();
+            frameIndex += framesDone;
+
+            // A complete stage ends on its time, the next one takes over
+            currentTime_ = stageComplete ? std::max(stageEndTime, time + framesDone * samplePeriod)
+                : time + framesDone * samplePeriod;
         }
-        currentLevel_ = level;
 
         // Update the counter to release
         if (currentFramesUntilRelease_)
             *currentFramesUntilRelease_ -= framesDone;
-
-        currentTime_ = time;
     }
 }
 
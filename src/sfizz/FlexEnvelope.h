@@ -20,6 +20,11 @@ public:
     explicit FlexEnvelope(Resources &resources);
     ~FlexEnvelope();
 
+    /**
+       Gets the memory of the envelope, in bytes.
+     */
+    size_t getMemoryUsage() const noexcept;
+
     /**
        Sets the sample rate.
      */
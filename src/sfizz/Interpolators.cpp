@@ -5,9 +5,13 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "Interpolators.h"
+#include "simd/InterpolatorsAVX2.h"
+#include "cpuid/cpuinfo.hpp"
 
 namespace sfz {
 
+static bool sincBlockAVX2 = false;
+
 void initializeInterpolators()
 {
     SincInterpolatorTraits<8>::initialize();
@@ -18,6 +22,62 @@ void initializeInterpolators()
     SincInterpolatorTraits<48>::initialize();
     SincInterpolatorTraits<60>::initialize();
     SincInterpolatorTraits<72>::initialize();
+
+    // Note: the cpuid library has no FMA flag, the block kernel uses none
+    if (sincInterpolatorsAVX2Available()) {
+        cpuid::cpuinfo cpuInfo;
+        sincBlockAVX2 = cpuInfo.has_avx2();
+    }
+}
+
+template <size_t Points>
+static void sincBlockWithTable(
+    const float* const sources[], float* const outputs[],
+    unsigned numChannels, const int* indices, const float* coeffs,
+    const float* addingGains, size_t numFrames) noexcept
+{
+    const auto& ws = *SincInterpolatorTraits<Points>::windowedSinc;
+    sincInterpolateAVX2(
+        ws.getTablePointer(), ws.getTableSize(), Points,
+        sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+}
+
+bool interpolateSincBlock(
+    InterpolatorModel model, const float* const sources[], float* const outputs[],
+    unsigned numChannels, const int* indices, const float* coeffs,
+    const float* addingGains, size_t numFrames) noexcept
+{
+    if (!sincBlockAVX2)
+        return false;
+
+    switch (model) {
+    case kInterpolatorSinc8:
+        sincBlockWithTable<8>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc12:
+        sincBlockWithTable<12>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc16:
+        sincBlockWithTable<16>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc24:
+        sincBlockWithTable<24>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc36:
+        sincBlockWithTable<36>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc48:
+        sincBlockWithTable<48>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc60:
+        sincBlockWithTable<60>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    case kInterpolatorSinc72:
+        sincBlockWithTable<72>(sources, outputs, numChannels, indices, coeffs, addingGains, numFrames);
+        return true;
+    default:
+        return false;
+    }
 }
 
 } // namespace sfz
@@ -5,6 +5,7 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #pragma once
+#include <cstddef>
 
 namespace sfz {
 
@@ -63,6 +64,45 @@ void initializeInterpolators();
 template <InterpolatorModel M, class R>
 R interpolate(const R* values, R coeff);
 
+/**
+ * @brief Interpolate the two channels of a stereo signal at the same position,
+ *        computing the interpolation kernel once for both
+ *
+ * @tparam M the interpolator model
+ * @tparam R the sample type
+ * @param left Pointer to a value in the left channel, padded as for `interpolate`
+ * @param right Pointer to a value in the right channel, padded as for `interpolate`
+ * @param coeff the interpolation coefficient
+ * @param leftOutput the value interpolated from the left channel
+ * @param rightOutput the value interpolated from the right channel
+ */
+template <InterpolatorModel M, class R>
+void interpolateStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput);
+
+/**
+ * @brief Interpolate a block of frames with a windowed-sinc model, using the
+ *        vectorized block implementation if the processor supports it.
+ *
+ * Frame `i` of channel `c` is interpolated from `&sources[c][indices[i]]` with
+ * coefficient `coeffs[i]`. The result is written to `outputs[c][i]`, or added
+ * to it after multiplication by `addingGains[i]` if the gains are not null.
+ *
+ * @param model the interpolator model, which must be a windowed-sinc
+ * @param sources the channels to interpolate, padded as for `interpolate`
+ * @param outputs the output channels
+ * @param numChannels the number of channels
+ * @param indices the integral positions of the frames
+ * @param coeffs the interpolation coefficients of the frames
+ * @param addingGains the gains if adding to the outputs, or null
+ * @param numFrames the number of frames
+ * @return true if the block was interpolated, false if there is no block
+ *         implementation and the caller must interpolate frame by frame
+ */
+bool interpolateSincBlock(
+    InterpolatorModel model, const float* const sources[], float* const outputs[],
+    unsigned numChannels, const int* indices, const float* coeffs,
+    const float* addingGains, size_t numFrames) noexcept;
+
 } // namespace sfz
 
 #include "Interpolators.hpp"
@@ -40,6 +40,12 @@ inline R interpolate(const R* values, R coeff)
     return Interpolator<M, R>::process(values, coeff);
 }
 
+template <InterpolatorModel M, class R>
+inline void interpolateStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput)
+{
+    Interpolator<M, R>::processStereo(left, right, coeff, leftOutput, rightOutput);
+}
+
 //------------------------------------------------------------------------------
 // Nearest
 
@@ -51,6 +57,13 @@ public:
     {
         return values[coeff > static_cast<R>(0.5)];
     }
+
+    static inline void processStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput)
+    {
+        const bool next = coeff > static_cast<R>(0.5);
+        leftOutput = left[next];
+        rightOutput = right[next];
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -64,6 +77,13 @@ public:
     {
         return values[0] * (static_cast<R>(1.0) - coeff) + values[1] * coeff;
     }
+
+    static inline void processStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput)
+    {
+        const R complement = static_cast<R>(1.0) - coeff;
+        leftOutput = left[0] * complement + left[1] * coeff;
+        rightOutput = right[0] * complement + right[1] * coeff;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -81,6 +101,16 @@ public:
         simde__m128 y = simde_mm_mul_ps(h, simde_mm_loadu_ps(values - 1));
         return simde_vaddvq_f32(simde__m128_to_simde_float32x4(y));
     }
+
+    static inline void processStereo(const float* left, const float* right, float coeff, float& leftOutput, float& rightOutput)
+    {
+        simde__m128 x = simde_mm_sub_ps(simde_mm_setr_ps(-1, 0, 1, 2), simde_mm_set1_ps(coeff));
+        simde__m128 h = hermite3x4(x);
+        simde__m128 yl = simde_mm_mul_ps(h, simde_mm_loadu_ps(left - 1));
+        simde__m128 yr = simde_mm_mul_ps(h, simde_mm_loadu_ps(right - 1));
+        leftOutput = simde_vaddvq_f32(simde__m128_to_simde_float32x4(yl));
+        rightOutput = simde_vaddvq_f32(simde__m128_to_simde_float32x4(yr));
+    }
 };
 #endif
 
@@ -100,6 +130,19 @@ public:
         }
         return y;
     }
+
+    static inline void processStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput)
+    {
+        R yl = 0;
+        R yr = 0;
+        for (int i = -1; i < 3; ++i) {
+            R h = hermite3<R>(i - coeff);
+            yl += h * left[i];
+            yr += h * right[i];
+        }
+        leftOutput = yl;
+        rightOutput = yr;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -117,6 +160,16 @@ public:
         simde__m128 y = simde_mm_mul_ps(h, simde_mm_loadu_ps(values - 1));
         return simde_vaddvq_f32(simde__m128_to_simde_float32x4(y));
     }
+
+    static inline void processStereo(const float* left, const float* right, float coeff, float& leftOutput, float& rightOutput)
+    {
+        simde__m128 x = simde_mm_sub_ps(simde_mm_setr_ps(-1, 0, 1, 2), simde_mm_set1_ps(coeff));
+        simde__m128 h = bspline3x4(x);
+        simde__m128 yl = simde_mm_mul_ps(h, simde_mm_loadu_ps(left - 1));
+        simde__m128 yr = simde_mm_mul_ps(h, simde_mm_loadu_ps(right - 1));
+        leftOutput = simde_vaddvq_f32(simde__m128_to_simde_float32x4(yl));
+        rightOutput = simde_vaddvq_f32(simde__m128_to_simde_float32x4(yr));
+    }
 };
 #endif
 
@@ -136,6 +189,19 @@ public:
         }
         return y;
     }
+
+    static inline void processStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput)
+    {
+        R yl = 0;
+        R yr = 0;
+        for (int i = -1; i < 3; ++i) {
+            R h = bspline3<R>(i - coeff);
+            yl += h * left[i];
+            yr += h * right[i];
+        }
+        leftOutput = yl;
+        rightOutput = yr;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -220,6 +286,29 @@ public:
 
         return simde_vaddvq_f32(simde__m128_to_simde_float32x4(y));
     }
+
+    static inline void processStereo(const float* left, const float* right, float coeff, float& leftOutput, float& rightOutput)
+    {
+        const auto &ws = *SincInterpolatorTraits<Points>::windowedSinc;
+
+        constexpr int j0 = 1 - int(Points) / 2;
+        float x0 = j0 - coeff;
+
+        simde__m128 yl = simde_mm_set1_ps(0.0f);
+        simde__m128 yr = simde_mm_set1_ps(0.0f);
+        simde__m128 x = simde_mm_add_ps(simde_mm_set1_ps(x0), simde_mm_setr_ps(0, 1, 2, 3));
+        size_t i = 0;
+        do {
+            simde__m128 h = ws.getUncheckedX4(x);
+            yl = simde_mm_add_ps(yl, simde_mm_mul_ps(h, simde_mm_loadu_ps(&left[j0 + i])));
+            yr = simde_mm_add_ps(yr, simde_mm_mul_ps(h, simde_mm_loadu_ps(&right[j0 + i])));
+            x = simde_mm_add_ps(x, simde_mm_set1_ps(4.0f));
+            i += 4;
+        } while (i < Points);
+
+        leftOutput = simde_vaddvq_f32(simde__m128_to_simde_float32x4(yl));
+        rightOutput = simde_vaddvq_f32(simde__m128_to_simde_float32x4(yr));
+    }
 };
 #endif
 
@@ -245,6 +334,27 @@ public:
 
         return y;
     }
+
+    static inline void processStereo(const R* left, const R* right, R coeff, R& leftOutput, R& rightOutput)
+    {
+        const auto &ws = *SincInterpolatorTraits<Points>::windowedSinc;
+
+        int j0 = 1 - int(Points) / 2;
+
+        R h[Points];
+        for (int i = 0; i < int(Points); ++i)
+            h[i] = R(ws.getUnchecked(j0 - coeff + i));
+
+        R yl = h[0] * left[j0];
+        R yr = h[0] * right[j0];
+        for (int i = 1; i < int(Points); ++i) {
+            yl += h[i] * left[j0 + i];
+            yr += h[i] * right[j0 + i];
+        }
+
+        leftOutput = yl;
+        rightOutput = yr;
+    }
 };
 
 template <class R>
@@ -16,6 +16,10 @@
 #include "modulations/ModMatrix.h"
 #include "modulations/ModKey.h"
 #include "modulations/ModId.h"
+#include <simde/simde-features.h>
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+#include <simde/x86/sse2.h>
+#endif
 #include <array>
 #include <algorithm>
 #include <cmath>
@@ -57,6 +61,11 @@ LFO::~LFO()
 {
 }
 
+size_t LFO::getMemoryUsage() const noexcept
+{
+    return sizeof(LFO) + sizeof(Impl);
+}
+
 void LFO::setSampleRate(double sampleRate)
 {
     impl_->sampleRate_ = sampleRate;
@@ -154,6 +163,96 @@ inline float LFO::eval<LFOWave::Saw>(float phase)
     return 1 - 2 * phase;
 }
 
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+/**
+   Select `a` in the lanes of the mask, `b` in others.
+ */
+static inline simde__m128 select(simde__m128 mask, simde__m128 a, simde__m128 b)
+{
+    return simde_mm_or_ps(simde_mm_and_ps(mask, a), simde_mm_andnot_ps(mask, b));
+}
+
+/**
+   Wrap 4 normalized phases into the domain [0;1[, like `wrapPhase`.
+ */
+static inline simde__m128 wrapPhases(simde__m128 phase)
+{
+    simde__m128 wrapped = simde_mm_sub_ps(phase, simde_mm_cvtepi32_ps(simde_mm_cvttps_epi32(phase)));
+    const simde__m128 negative = simde_mm_cmplt_ps(wrapped, simde_mm_setzero_ps());
+    return simde_mm_add_ps(wrapped, simde_mm_and_ps(negative, simde_mm_set1_ps(1.0f)));
+}
+
+/**
+   Evaluate the wave at 4 phases at once, like `LFO::eval`.
+ */
+template <LFOWave W>
+static simde__m128 evalWaves(simde__m128 phase);
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Triangle>(simde__m128 phase)
+{
+    const simde__m128 phase4 = simde_mm_mul_ps(simde_mm_set1_ps(4.0f), phase);
+    simde__m128 y = simde_mm_add_ps(simde_mm_mul_ps(simde_mm_set1_ps(-4.0f), phase), simde_mm_set1_ps(2.0f));
+    y = select(simde_mm_cmplt_ps(phase, simde_mm_set1_ps(0.25f)), phase4, y);
+    y = select(simde_mm_cmpgt_ps(phase, simde_mm_set1_ps(0.75f)), simde_mm_sub_ps(phase4, simde_mm_set1_ps(4.0f)), y);
+    return y;
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Sine>(simde__m128 phase)
+{
+    const simde__m128 x = simde_mm_sub_ps(simde_mm_add_ps(phase, phase), simde_mm_set1_ps(1.0f));
+    const simde__m128 absX = simde_mm_andnot_ps(simde_mm_set1_ps(-0.0f), x);
+    const simde__m128 y = simde_mm_mul_ps(simde_mm_mul_ps(simde_mm_set1_ps(-4.0f), x), simde_mm_sub_ps(simde_mm_set1_ps(1.0f), absX));
+    return y;
+}
+
+/**
+   Evaluate a pulse wave which is high below the threshold.
+ */
+static inline simde__m128 evalPulses(simde__m128 phase, float threshold)
+{
+    const simde__m128 high = simde_mm_cmplt_ps(phase, simde_mm_set1_ps(threshold));
+    return select(high, simde_mm_set1_ps(hiPulse), simde_mm_set1_ps(loPulse));
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Pulse75>(simde__m128 phase)
+{
+    return evalPulses(phase, 0.75f);
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Square>(simde__m128 phase)
+{
+    return evalPulses(phase, 0.5f);
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Pulse25>(simde__m128 phase)
+{
+    return evalPulses(phase, 0.25f);
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Pulse12_5>(simde__m128 phase)
+{
+    return evalPulses(phase, 0.125f);
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Ramp>(simde__m128 phase)
+{
+    return simde_mm_sub_ps(simde_mm_mul_ps(simde_mm_set1_ps(2.0f), phase), simde_mm_set1_ps(1.0f));
+}
+
+template <>
+inline simde__m128 evalWaves<LFOWave::Saw>(simde__m128 phase)
+{
+    return simde_mm_sub_ps(simde_mm_set1_ps(1.0f), simde_mm_mul_ps(simde_mm_set1_ps(2.0f), phase));
+}
+#endif
+
 template <LFOWave W>
 void LFO::processWave(unsigned nth, absl::Span<float> out, const float* phaseIn)
 {
@@ -164,8 +263,18 @@ void LFO::processWave(unsigned nth, absl::Span<float> out, const float* phaseIn)
 
     const float offset = sub.offset;
     const float scale = sub.scale;
+    size_t i = 0;
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    const simde__m128 offsets = simde_mm_set1_ps(offset);
+    const simde__m128 scales = simde_mm_set1_ps(scale);
+    for (; i + 4 <= numFrames; i += 4) {
+        const simde__m128 y = simde_mm_add_ps(offsets, simde_mm_mul_ps(scales, evalWaves<W>(simde_mm_loadu_ps(phaseIn + i))));
+        simde_mm_storeu_ps(&out[i], simde_mm_add_ps(simde_mm_loadu_ps(&out[i]), y));
+    }
+#endif
 
-    for (size_t i = 0; i < numFrames; ++i) {
+    for (; i < numFrames; ++i) {
         float phase = phaseIn[i];
         out[i] += offset + scale * eval<W>(phase);
     }
@@ -303,6 +412,29 @@ void LFO::process(absl::Span<float> out)
     processFadeIn(out);
 }
 
+bool LFO::isVoiceIndependent() const noexcept
+{
+    const Impl& impl = *impl_;
+    const LFODescription& desc = *impl.desc_;
+
+    // the phase follows the beat clock, not the start of the voice
+    if (desc.beats <= 0 || !impl.resources_.getBeatClock().isPlaying())
+        return false;
+
+    if (impl.delayFramesLeft_ > 0 || impl.fadePosition_ < 1.0f)
+        return false;
+
+    if (impl.beatsKeyId || impl.phaseKeyId)
+        return false;
+
+    for (const LFODescription::Sub& sub : desc.sub) {
+        if (sub.wave == LFOWave::RandomSH)
+            return false;
+    }
+
+    return true;
+}
+
 void LFO::processFadeIn(absl::Span<float> out)
 {
     Impl& impl = *impl_;
@@ -324,6 +456,19 @@ void LFO::processFadeIn(absl::Span<float> out)
     impl.fadePosition_ = fadePosition;
 }
 
+/**
+   Advance a phase in [0;1[ by an increment less than 1 in magnitude, and wrap
+   it like `wrapPhase`. The result is the same, with a shorter dependency
+   from a frame to the next.
+ */
+static inline float advancePhase(float phase, float incr)
+{
+    float next = phase + incr;
+    next = (next >= 1.0f) ? (next - 1.0f) : next;
+    next = (next < 0.0f) ? (next + 1.0f) : next;
+    return next;
+}
+
 void LFO::generatePhase(unsigned nth, absl::Span<float> phases)
 {
     Impl& impl = *impl_;
@@ -376,27 +521,50 @@ void LFO::generatePhase(unsigned nth, absl::Span<float> phases)
         // generate using the frequency
         if (!freqMod) {
             float incr = ratio * samplePeriod * baseFreq;
-            for (size_t i = 0; i < numFrames; ++i) {
-                phases[i] = phase;
-                phase = wrapPhase(phase + incr);
+            if (std::fabs(incr) < 1.0f) {
+                for (size_t i = 0; i < numFrames; ++i) {
+                    phases[i] = phase;
+                    phase = advancePhase(phase, incr);
+                }
+            }
+            else {
+                for (size_t i = 0; i < numFrames; ++i) {
+                    phases[i] = phase;
+                    phase = wrapPhase(phase + incr);
+                }
             }
         }
         else {
             for (size_t i = 0; i < numFrames; ++i) {
                 phases[i] = phase;
                 float incr = ratio * samplePeriod * (baseFreq + freqMod[i]);
-                phase = wrapPhase(phase + incr);
+                phase = (std::fabs(incr) < 1.0f) ? advancePhase(phase, incr) : wrapPhase(phase + incr);
             }
         }
 
     }
 
     // apply phase offsets
+    size_t i = 0;
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    const simde__m128 phaseOffsets = simde_mm_set1_ps(phaseOffset);
+    if (!phaseMod) {
+        for (; i + 4 <= numFrames; i += 4) {
+            const simde__m128 offsetPhases = simde_mm_add_ps(simde_mm_loadu_ps(&phases[i]), phaseOffsets);
+            simde_mm_storeu_ps(&phases[i], wrapPhases(offsetPhases));
+        }
+    } else {
+        for (; i + 4 <= numFrames; i += 4) {
+            const simde__m128 offsetPhases = simde_mm_add_ps(simde_mm_add_ps(simde_mm_loadu_ps(&phases[i]), phaseOffsets), simde_mm_loadu_ps(phaseMod + i));
+            simde_mm_storeu_ps(&phases[i], wrapPhases(offsetPhases));
+        }
+    }
+#endif
     if (!phaseMod) {
-        for (size_t i = 0; i < numFrames; ++i)
+        for (; i < numFrames; ++i)
             phases[i] = wrapPhase(phases[i] + phaseOffset);
     } else {
-        for (size_t i = 0; i < numFrames; ++i)
+        for (; i < numFrames; ++i)
             phases[i] = wrapPhase(phases[i] + phaseOffset + phaseMod[i]);
     }
 
@@ -55,6 +55,11 @@ public:
     explicit LFO(Resources& resources);
     ~LFO();
 
+    /**
+       Gets the memory of the LFO, in bytes.
+     */
+    size_t getMemoryUsage() const noexcept;
+
     /**
        Sets the sample rate.
      */
@@ -79,6 +84,14 @@ public:
      */
     void process(absl::Span<float> out);
 
+    /**
+       Check whether the next cycle is identical in all the voices which
+       run this LFO. It is the case of a LFO on the beat clock while playing,
+       without sample-and-hold or modulations, which is past its delay and
+       fade-in. Processing the next cycle does not change its state.
+     */
+    bool isVoiceIndependent() const noexcept;
+
 private:
     /**
        Evaluate the wave at a given phase.
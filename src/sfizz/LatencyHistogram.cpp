@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sfz {
+
+constexpr double LatencyHistogram::minDuration;
+constexpr int LatencyHistogram::bucketsPerOctave;
+constexpr int LatencyHistogram::numOctaves;
+constexpr int LatencyHistogram::numBuckets;
+
+LatencyHistogram::LatencyHistogram() noexcept
+{
+    reset();
+}
+
+void LatencyHistogram::add(double duration) noexcept
+{
+    buckets_[bucketIndex(duration)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    double sum = sum_.load(std::memory_order_relaxed);
+    while (!sum_.compare_exchange_weak(sum, sum + duration, std::memory_order_relaxed));
+
+    double min = min_.load(std::memory_order_relaxed);
+    while (duration < min && !min_.compare_exchange_weak(min, duration, std::memory_order_relaxed));
+
+    double max = max_.load(std::memory_order_relaxed);
+    while (duration > max && !max_.compare_exchange_weak(max, duration, std::memory_order_relaxed));
+}
+
+void LatencyHistogram::reset() noexcept
+{
+    for (std::atomic<uint32_t>& bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0.0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+    max_.store(0.0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMin() const noexcept
+{
+    const double min = min_.load(std::memory_order_relaxed);
+    return std::isinf(min) ? 0.0 : min;
+}
+
+double LatencyHistogram::getMax() const noexcept
+{
+    return max_.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMean() const noexcept
+{
+    const uint64_t count = getCount();
+    return (count > 0) ? sum_.load(std::memory_order_relaxed) / static_cast<double>(count) : 0.0;
+}
+
+double LatencyHistogram::getPercentile(double fraction) const noexcept
+{
+    // the buckets are read once, since they can change while reading
+    std::array<uint32_t, numBuckets> buckets;
+    uint64_t total = 0;
+    for (int i = 0; i < numBuckets; ++i) {
+        buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+
+    if (total == 0)
+        return 0.0;
+
+    const double clampedFraction = (fraction < 0.0) ? 0.0 : (fraction > 1.0) ? 1.0 : fraction;
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clampedFraction * total)));
+
+    const double max = getMax();
+    uint64_t cumulated = 0;
+    for (int i = 0; i < numBuckets; ++i) {
+        cumulated += buckets[i];
+        if (cumulated >= rank)
+            return std::min(bucketUpperBound(i), max);
+    }
+
+    return max;
+}
+
+int LatencyHistogram::bucketIndex(double duration) noexcept
+{
+    if (!(duration >= minDuration))
+        return 0;
+
+    const double octaves = std::log2(duration / minDuration);
+    const double index = 1.0 + octaves * bucketsPerOctave;
+    return (index < numBuckets - 1) ? static_cast<int>(index) : numBuckets - 1;
+}
+
+double LatencyHistogram::bucketUpperBound(int index) noexcept
+{
+    if (index >= numBuckets - 1)
+        return std::numeric_limits<double>::infinity();
+
+    return minDuration * std::exp2(static_cast<double>(index) / bucketsPerOctave);
+}
+
+} // namespace sfz
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace sfz {
+
+/**
+ * @brief A histogram of durations, in buckets of logarithmic widths.
+ *
+ * One thread adds the durations while others read the statistics, without
+ * locks. A reset concurrent to an addition may keep some of the addition.
+ */
+class LatencyHistogram {
+public:
+    static constexpr double minDuration { 1e-6 }; // upper bound of the first bucket
+    static constexpr int bucketsPerOctave { 8 };
+    static constexpr int numOctaves { 24 }; // up to about 16 seconds
+    static constexpr int numBuckets { 1 + bucketsPerOctave * numOctaves };
+
+    LatencyHistogram() noexcept;
+
+    /**
+     * @brief Add a duration in seconds. It is RT-safe.
+     */
+    void add(double duration) noexcept;
+
+    /**
+     * @brief Forget all the durations.
+     */
+    void reset() noexcept;
+
+    uint64_t getCount() const noexcept { return count_.load(std::memory_order_relaxed); }
+    double getMin() const noexcept;
+    double getMax() const noexcept;
+    double getMean() const noexcept;
+
+    /**
+     * @brief Get the duration under which a fraction of the durations are.
+     * It is the upper bound of the bucket of the percentile, limited to the
+     * maximum duration, or 0 if there are no durations.
+     *
+     * @param fraction between 0 and 1, eg. 0.99 for the 99th percentile
+     */
+    double getPercentile(double fraction) const noexcept;
+
+    /**
+     * @brief Get the bucket of a duration.
+     */
+    static int bucketIndex(double duration) noexcept;
+
+    /**
+     * @brief Get the upper bound of the durations of a bucket.
+     */
+    static double bucketUpperBound(int index) noexcept;
+
+private:
+    std::array<std::atomic<uint32_t>, numBuckets> buckets_;
+    std::atomic<uint64_t> count_ { 0 };
+    std::atomic<double> sum_ { 0.0 };
+    std::atomic<double> min_;
+    std::atomic<double> max_ { 0.0 };
+};
+
+} // namespace sfz
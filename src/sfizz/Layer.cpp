@@ -6,6 +6,9 @@
 
 #include "Layer.h"
 #include "Region.h"
+#include "MathHelpers.h"
+#include "modulations/ModId.h"
+#include "modulations/ModKey.h"
 #include "utility/Debug.h"
 #include "utility/SwapAndPop.h"
 #include <absl/algorithm/container.h>
@@ -24,6 +27,12 @@ Layer::Layer(const Region& region, const MidiState& midiState)
     initializeActivations();
 }
 
+Layer::Layer(const Region& prototype, int regionNumber, const MidiState& midiState)
+    : midiState_(midiState), region_(prototype, regionNumber)
+{
+    initializeActivations();
+}
+
 Layer::~Layer()
 {
 }
@@ -32,6 +41,8 @@ void Layer::initializeActivations()
 {
     const Region& region = region_;
 
+    updateTriggerView();
+
     keySwitched_ = !region.usesKeySwitches;
     previousKeySwitched_ = !region.usesPreviousKeySwitches;
     sequenceSwitched_ = !region.usesSequenceSwitches;
@@ -40,44 +51,161 @@ void Layer::initializeActivations()
     aftertouchSwitched_ = true;
     programSwitched_ = true;
     ccSwitched_.set();
+    numUnsatisfiedCCs_ = 0;
+}
+
+void Layer::updateTriggerView() noexcept
+{
+    const Region& region = region_;
+    TriggerView& view = trigger_;
+
+    view.velocityRange = region.velocityRange;
+    view.polyAftertouchRange = region.polyAftertouchRange;
+    view.randRange = region.randRange;
+    view.sustainThreshold = region.sustainThreshold;
+    view.sostenutoThreshold = region.sostenutoThreshold;
+    view.keyRange = region.keyRange;
+    view.sequenceLength = region.sequenceLength;
+    view.sequencePosition = region.sequencePosition;
+    view.sustainCC = region.sustainCC;
+    view.sostenutoCC = region.sostenutoCC;
+    view.trigger = region.trigger;
+    view.velocityOverride = region.velocityOverride;
+    view.checkSustain = region.checkSustain;
+    view.checkSostenuto = region.checkSostenuto;
+    view.triggerOnNote = region.triggerOnNote;
+    view.triggerOnCC = region.triggerOnCC;
+}
+
+void Layer::prepareVoiceTemplate(const ModMatrix& mm)
+{
+    const Region& region = region_;
+    VoiceTemplate& voice = voiceTemplate_;
+    const NumericId<Region> id = region.getId();
+
+    voice.masterAmplitudeTarget = mm.findTarget(ModKey::createNXYZ(ModId::MasterAmplitude, id));
+    voice.amplitudeTarget = mm.findTarget(ModKey::createNXYZ(ModId::Amplitude, id));
+    voice.volumeTarget = mm.findTarget(ModKey::createNXYZ(ModId::Volume, id));
+    voice.panTarget = mm.findTarget(ModKey::createNXYZ(ModId::Pan, id));
+    voice.positionTarget = mm.findTarget(ModKey::createNXYZ(ModId::Position, id));
+    voice.widthTarget = mm.findTarget(ModKey::createNXYZ(ModId::Width, id));
+    voice.pitchTarget = mm.findTarget(ModKey::createNXYZ(ModId::Pitch, id));
+    voice.oscillatorDetuneTarget = mm.findTarget(ModKey::createNXYZ(ModId::OscillatorDetune, id));
+    voice.oscillatorModDepthTarget = mm.findTarget(ModKey::createNXYZ(ModId::OscillatorModDepth, id));
+
+    const auto numFilters = static_cast<unsigned>(region.filters.size());
+    voice.filterTargets.resize(numFilters);
+    for (unsigned i = 0; i < numFilters; ++i)
+        voice.filterTargets[i] = FilterHolder::findTargets(mm, region, i);
+
+    const auto numEqs = static_cast<unsigned>(region.equalizers.size());
+    voice.equalizerTargets.resize(numEqs);
+    for (unsigned i = 0; i < numEqs; ++i)
+        voice.equalizerTargets[i] = EQHolder::findTargets(mm, region, i);
+
+    updateVoiceTemplate();
+}
+
+void Layer::updateVoiceTemplate() noexcept
+{
+    const Region& region = region_;
+    VoiceTemplate& voice = voiceTemplate_;
+
+    voice.baseGain = region.getBaseGain();
+
+    voice.renderFeatures = 0;
+    if (region.isOscillator())
+        voice.renderFeatures |= VoiceTemplate::renderOscillator;
+    if (region.isStereo())
+        voice.renderFeatures |= VoiceTemplate::renderStereo;
+    if (!region.filters.empty())
+        voice.renderFeatures |= VoiceTemplate::renderFilters;
+    if (!region.equalizers.empty())
+        voice.renderFeatures |= VoiceTemplate::renderEqualizers;
+    if (!region.crossfadeCCInRange.empty() || !region.crossfadeCCOutRange.empty())
+        voice.renderFeatures |= VoiceTemplate::renderCrossfades;
+
+    const int m = region.oscillatorMulti;
+    const float d = region.oscillatorDetune;
+
+    // 3-9: unison mode, 1: normal/RM, 2: PM/FM
+    if (m < 3 || region.oscillatorMode > 0) {
+        voice.waveUnisonSize = 1;
+        // carrier
+        voice.waveDetuneRatio[0] = 1.0;
+        voice.waveLeftGain[0] = 1.0;
+        voice.waveRightGain[0] = 1.0;
+        // modulator
+        const float modDepth = region.oscillatorModDepth;
+        voice.waveDetuneRatio[1] = centsFactor(d);
+        voice.waveLeftGain[1] = modDepth;
+        voice.waveRightGain[1] = modDepth;
+        return;
+    }
+
+    // oscillator count, aka. unison size
+    voice.waveUnisonSize = m;
+
+    // detune (cents)
+    float detunes[config::oscillatorsPerVoice];
+    detunes[0] = 0.0;
+    detunes[1] = -d;
+    detunes[2] = +d;
+    for (int i = 3; i < m; ++i) {
+        int n = (i - 1) / 2;
+        detunes[i] = d * ((i & 1) ? -0.25f : +0.25f) * float(n);
+    }
+
+    // detune (ratio)
+    for (int i = 0; i < m; ++i)
+        voice.waveDetuneRatio[i] = centsFactor(detunes[i]);
+
+    // gains
+    voice.waveLeftGain[0] = 0.0;
+    voice.waveRightGain[m - 1] = 0.0;
+    for (int i = 0; i < m - 1; ++i) {
+        float g = 1.0f - float(i) / float(m - 1);
+        voice.waveLeftGain[m - 1 - i] = g;
+        voice.waveRightGain[i] = g;
+    }
 }
 
 bool Layer::isSwitchedOn() const noexcept
 {
     return keySwitched_ && previousKeySwitched_ && sequenceSwitched_ && pitchSwitched_
-        && programSwitched_ && bpmSwitched_ && aftertouchSwitched_ && ccSwitched_.all();
+        && programSwitched_ && bpmSwitched_ && aftertouchSwitched_ && isCCSwitchedOn();
 }
 
 bool Layer::registerNoteOn(int noteNumber, float velocity, float randValue) noexcept
 {
     ASSERT(velocity >= 0.0f && velocity <= 1.0f);
 
-    const Region& region = region_;
+    const TriggerView& view = trigger_;
 
-    const bool keyOk = region.keyRange.containsWithEnd(noteNumber);
+    const bool keyOk = view.keyRange.containsWithEnd(noteNumber);
     if (keyOk) {
         // Sequence activation
         sequenceSwitched_ =
-            ((sequenceCounter_++ % region.sequenceLength) == region.sequencePosition - 1);
+            ((sequenceCounter_++ % view.sequenceLength) == view.sequencePosition - 1);
     }
 
     const bool polyAftertouchActive =
-        region.polyAftertouchRange.containsWithEnd(midiState_.getPolyAftertouch(noteNumber));
+        view.polyAftertouchRange.containsWithEnd(midiState_.getPolyAftertouch(noteNumber));
 
     if (!isSwitchedOn() || !polyAftertouchActive)
         return false;
 
-    if (!region.triggerOnNote)
+    if (!view.triggerOnNote)
         return false;
 
-    if (region.velocityOverride == VelocityOverride::previous)
+    if (view.velocityOverride == VelocityOverride::previous)
         velocity = midiState_.getVelocityOverride();
 
-    const bool velOk = region.velocityRange.containsWithEnd(velocity);
-    const bool randOk = region.randRange.contains(randValue) || (randValue >= 1.0f && region.randRange.isValid() && region.randRange.getEnd() >= 1.0f);
-    const bool firstLegatoNote = (region.trigger == Trigger::first && midiState_.getActiveNotes() == 1);
-    const bool attackTrigger = (region.trigger == Trigger::attack);
-    const bool notFirstLegatoNote = (region.trigger == Trigger::legato && midiState_.getActiveNotes() > 1);
+    const bool velOk = view.velocityRange.containsWithEnd(velocity);
+    const bool randOk = view.randRange.contains(randValue) || (randValue >= 1.0f && view.randRange.isValid() && view.randRange.getEnd() >= 1.0f);
+    const bool firstLegatoNote = (view.trigger == Trigger::first && midiState_.getActiveNotes() == 1);
+    const bool attackTrigger = (view.trigger == Trigger::attack);
+    const bool notFirstLegatoNote = (view.trigger == Trigger::legato && midiState_.getActiveNotes() > 1);
 
     return keyOk && velOk && randOk && (attackTrigger || firstLegatoNote || notFirstLegatoNote);
 }
@@ -86,32 +214,32 @@ bool Layer::registerNoteOff(int noteNumber, float velocity, float randValue) noe
 {
     ASSERT(velocity >= 0.0f && velocity <= 1.0f);
 
-    const Region& region = region_;
+    const TriggerView& view = trigger_;
 
     const bool polyAftertouchActive =
-        region.polyAftertouchRange.containsWithEnd(midiState_.getPolyAftertouch(noteNumber));
+        view.polyAftertouchRange.containsWithEnd(midiState_.getPolyAftertouch(noteNumber));
 
     if (!isSwitchedOn() || !polyAftertouchActive)
         return false;
 
-    if (!region.triggerOnNote)
+    if (!view.triggerOnNote)
         return false;
 
     // Prerequisites
 
-    const bool keyOk = region.keyRange.containsWithEnd(noteNumber);
-    const bool velOk = region.velocityRange.containsWithEnd(velocity);
-    const bool randOk = region.randRange.contains(randValue) || (randValue >= 1.0f && region.randRange.isValid() && region.randRange.getEnd() >= 1.0f);
+    const bool keyOk = view.keyRange.containsWithEnd(noteNumber);
+    const bool velOk = view.velocityRange.containsWithEnd(velocity);
+    const bool randOk = view.randRange.contains(randValue) || (randValue >= 1.0f && view.randRange.isValid() && view.randRange.getEnd() >= 1.0f);
 
     if (!(velOk && keyOk && randOk))
         return false;
 
     // Release logic
 
-    if (region.trigger == Trigger::release_key)
+    if (view.trigger == Trigger::release_key)
         return true;
 
-    if (region.trigger == Trigger::release) {
+    if (view.trigger == Trigger::release) {
         const bool sostenutoed = isNoteSostenutoed(noteNumber);
 
         if (sostenutoed && !sostenutoPressed_) {
@@ -133,56 +261,63 @@ bool Layer::registerNoteOff(int noteNumber, float velocity, float randValue) noe
 
 void Layer::updateCCState(int ccNumber, float ccValue) noexcept
 {
-    const Region& region = region_;
+    const TriggerView& view = trigger_;
 
-    if (ccNumber == region.sustainCC)
-        sustainPressed_ = region.checkSustain && ccValue >= region.sustainThreshold;
+    if (ccNumber == view.sustainCC)
+        sustainPressed_ = view.checkSustain && ccValue >= view.sustainThreshold;
 
-    if (ccNumber == region.sostenutoCC) {
-        const bool newState = region.checkSostenuto && ccValue >= region.sostenutoThreshold;
+    if (ccNumber == view.sostenutoCC) {
+        const bool newState = view.checkSostenuto && ccValue >= view.sostenutoThreshold;
         if (!sostenutoPressed_ && newState)
             storeSostenutoNotes();
 
-        if (!newState && sostenutoPressed_)
+        if (!newState && sostenutoPressed_) {
             delayedSostenutoReleases_.clear();
+            updatePendingRelease();
+        }
 
         sostenutoPressed_ = newState;
     }
 
-    const auto conditions = region.ccConditions.get(ccNumber);
+    const auto conditions = region_.ccConditions.get(ccNumber);
 
     if (!conditions)
         return;
 
-    ccSwitched_.set(ccNumber, conditions->containsWithEnd(ccValue));
+    const bool satisfied = conditions->containsWithEnd(ccValue);
+    if (satisfied == ccSwitched_.test(ccNumber))
+        return;
+
+    ccSwitched_.set(ccNumber, satisfied);
+    numUnsatisfiedCCs_ += satisfied ? -1 : 1;
 }
 
 bool Layer::registerCC(int ccNumber, float ccValue, float randValue, int extendedArg) noexcept
 {
-    const Region& region = region_;
+    const TriggerView& view = trigger_;
 
     updateCCState(ccNumber, ccValue);
 
-    if (!region.triggerOnCC)
+    if (!view.triggerOnCC)
         return false;
 
-    const bool randOk = region.randRange.contains(randValue)
-        || (randValue >= 1.0f && region.randRange.isValid() && region.randRange.getEnd() >= 1.0f);
+    const bool randOk = view.randRange.contains(randValue)
+        || (randValue >= 1.0f && view.randRange.isValid() && view.randRange.getEnd() >= 1.0f);
 
     if (!randOk)
         return false;
 
-    if (auto triggerRange = region.ccTriggers.get(ccNumber)) {
+    if (auto triggerRange = region_.ccTriggers.get(ccNumber)) {
         if (!triggerRange->containsWithEnd(ccValue))
             return false;
 
         // only respect this polyAT trigger if the note number is one of ours
-        if (ccNumber == ExtendedCCs::polyphonicAftertouch && extendedArg >= 0 && !region.keyRange.containsWithEnd(extendedArg)) {
+        if (ccNumber == ExtendedCCs::polyphonicAftertouch && extendedArg >= 0 && !view.keyRange.containsWithEnd(extendedArg)) {
             return false;
         }
 
         sequenceSwitched_ =
-            ((sequenceCounter_++ % region.sequenceLength) == region.sequencePosition - 1);
+            ((sequenceCounter_++ % view.sequenceLength) == view.sequencePosition - 1);
 
         if (isSwitchedOn() && (ccNumber == ExtendedCCs::polyphonicAftertouch || ccValue != midiState_.getCCValue(ccNumber)))
             return true;
@@ -218,6 +353,7 @@ void Layer::delaySustainRelease(int noteNumber, float velocity) noexcept
         return;
 
     delayedSustainReleases_.emplace_back(noteNumber, velocity);
+    updatePendingRelease();
 }
 
 void Layer::delaySostenutoRelease(int noteNumber, float velocity) noexcept
@@ -226,6 +362,7 @@ void Layer::delaySostenutoRelease(int noteNumber, float velocity) noexcept
         return;
 
     delayedSostenutoReleases_.emplace_back(noteNumber, velocity);
+    updatePendingRelease();
 }
 
 void Layer::removeFromSostenutoReleases(int noteNumber) noexcept
@@ -233,13 +370,14 @@ void Layer::removeFromSostenutoReleases(int noteNumber) noexcept
     swapAndPopFirst(delayedSostenutoReleases_, [=](const std::pair<int, float>& p) {
         return p.first == noteNumber;
     });
+    updatePendingRelease();
 }
 
 void Layer::storeSostenutoNotes() noexcept
 {
     ASSERT(delayedSostenutoReleases_.empty());
-    const Region& region = region_;
-    for (int note = region.keyRange.getStart(); note <= region.keyRange.getEnd(); ++note) {
+    const TriggerView& view = trigger_;
+    for (int note = view.keyRange.getStart(); note <= view.keyRange.getEnd(); ++note) {
         if (midiState_.isNotePressed(note))
             delaySostenutoRelease(note, midiState_.getNoteVelocity(note));
     }
@@ -260,4 +398,41 @@ bool Layer::isNoteSostenutoed(int noteNumber) const noexcept
     }) != delayedSostenutoReleases_.end();
 }
 
+void Layer::updatePendingRelease() noexcept
+{
+    if (!pendingReleases_)
+        return;
+
+    const bool pending = !delayedSustainReleases_.empty() || !delayedSostenutoReleases_.empty();
+    if (pending == pendingReleaseLinked_)
+        return;
+
+    if (pending) {
+        previousPendingRelease_ = nullptr;
+        nextPendingRelease_ = pendingReleases_->first;
+        if (nextPendingRelease_)
+            nextPendingRelease_->previousPendingRelease_ = this;
+        pendingReleases_->first = this;
+    } else {
+        if (previousPendingRelease_)
+            previousPendingRelease_->nextPendingRelease_ = nextPendingRelease_;
+        else
+            pendingReleases_->first = nextPendingRelease_;
+        if (nextPendingRelease_)
+            nextPendingRelease_->previousPendingRelease_ = previousPendingRelease_;
+        previousPendingRelease_ = nullptr;
+        nextPendingRelease_ = nullptr;
+    }
+    pendingReleaseLinked_ = pending;
+}
+
+void Layer::SharedCrossfade::prepare(const Region& region, size_t samplesPerBlock)
+{
+    cycle = ~uint64_t(0);
+    if (region.crossfadeCCInRange.empty() && region.crossfadeCCOutRange.empty())
+        gain.clear();
+    else
+        gain.resize(samplesPerBlock);
+}
+
 } // namespace sfz
@@ -6,7 +6,12 @@
 
 #pragma once
 #include "Region.h"
+#include "Buffer.h"
 #include "Config.h"
+#include "Smoothers.h"
+#include "FilterPool.h"
+#include "EQPool.h"
+#include "modulations/ModMatrix.h"
 #include "utility/NumericId.h"
 #include "utility/LeakDetector.h"
 #include <absl/strings/string_view.h>
@@ -32,6 +37,11 @@ public:
      */
     Layer(const Region& region, const MidiState& midiState);
 
+    /**
+     * @brief Initialize a layer based on a copy of a region under another number.
+     */
+    Layer(const Region& prototype, int regionNumber, const MidiState& midiState);
+
     ~Layer();
 
     /**
@@ -44,10 +54,30 @@ public:
     Region& getRegion() noexcept { return region_; }
 
     /**
-     * @brief Reset the activations to their initial states.
+     * @brief Reset the activations to their initial states, and copy the
+     * trigger members of the region into the trigger view.
      */
     void initializeActivations();
 
+    /**
+     * @brief Copy the trigger members of the region into the trigger view.
+     * Call it after modifying one of these members of the region.
+     */
+    void updateTriggerView() noexcept;
+
+    /**
+     * @brief Find the modulation targets of the voice template, and compute
+     * the rest of it. Call it once the connections of the instrument are in
+     * the modulation matrix.
+     */
+    void prepareVoiceTemplate(const ModMatrix& mm);
+
+    /**
+     * @brief Compute the members of the voice template taken from the
+     * region. Call it after modifying one of these members of the region.
+     */
+    void updateVoiceTemplate() noexcept;
+
     /**
      * @brief Given the current midi state, is the region switched on?
      *
@@ -55,6 +85,13 @@ public:
      * @return false
      */
     bool isSwitchedOn() const noexcept;
+    /**
+     * @brief Are all the CC conditions of the region satisfied?
+     *
+     * @return true
+     * @return false
+     */
+    bool isCCSwitchedOn() const noexcept { return numUnsatisfiedCCs_ == 0; }
     /**
      * @brief Register a new note on event. The region may be switched on or off using keys so
      * this function updates the keyswitches state.
@@ -138,7 +175,50 @@ public:
     bool isNoteSustained(int noteNumber) const noexcept;
     bool isNoteSostenutoed(int noteNumber) const noexcept;
 
+    /**
+     * @brief The layers which hold delayed sustain or sostenuto releases,
+     * linked through the layers, so a pedal release only visits the layers
+     * with notes held rather than all the release layers.
+     */
+    struct PendingReleaseList {
+        Layer* first { nullptr };
+    };
+    PendingReleaseList* pendingReleases_ { nullptr };
+    Layer* previousPendingRelease_ { nullptr };
+    Layer* nextPendingRelease_ { nullptr };
+    bool pendingReleaseLinked_ { false };
+    /**
+     * @brief Link the layer in its pending release list if it holds delayed
+     * releases, or unlink it if it holds none. Call it after changing them.
+     */
+    void updatePendingRelease() noexcept;
+
+    /**
+     * @brief The members of the region read at every trigger check. They are
+     * kept next to the activation state, so dispatching an event to a layer
+     * touches a cache line or two rather than the scattered region members.
+     */
+    struct TriggerView {
+        UncheckedRange<float> velocityRange { Default::loVel, Default::hiVel };
+        UncheckedRange<float> polyAftertouchRange { Default::loPolyAftertouch, Default::hiPolyAftertouch };
+        UncheckedRange<float> randRange { Default::loNormalized, Default::hiNormalized };
+        float sustainThreshold { Default::sustainThreshold };
+        float sostenutoThreshold { Default::sostenutoThreshold };
+        UncheckedRange<uint8_t> keyRange { Default::loKey, Default::hiKey };
+        uint8_t sequenceLength { Default::sequence };
+        uint8_t sequencePosition { Default::sequence };
+        uint8_t sustainCC { Default::sustainCC };
+        uint8_t sostenutoCC { Default::sostenutoCC };
+        Trigger trigger { Default::trigger };
+        VelocityOverride velocityOverride { Default::velocityOverride };
+        bool checkSustain { Default::checkSustain };
+        bool checkSostenuto { Default::checkSostenuto };
+        bool triggerOnNote { true };
+        bool triggerOnCC { false };
+    };
+
     const MidiState& midiState_;
+    TriggerView trigger_;
     bool keySwitched_ {};
     bool previousKeySwitched_ {};
     bool sequenceSwitched_ {};
@@ -147,9 +227,74 @@ public:
     bool bpmSwitched_ {};
     bool aftertouchSwitched_ {};
     std::bitset<config::numCCs> ccSwitched_;
+    // Number of cleared bits in ccSwitched_, maintained along with it
+    int numUnsatisfiedCCs_ { 0 };
 
     int sequenceCounter_ { 0 };
 
+    /**
+     * @brief The crossfade gain of a cycle, which the voices of the region
+     * compute alike from the same controllers. The first voice to render
+     * stores it, with the states of its smoother, and the voices with the
+     * same smoother state take it and the state after. The voices of a
+     * region render on the same lane, so there is no race between them.
+     */
+    struct SharedCrossfade {
+        /**
+         * @brief Allocate the gain for the blocks, if the region has
+         * crossfades.
+         */
+        void prepare(const Region& region, size_t samplesPerBlock);
+
+        Buffer<float> gain;
+        uint64_t cycle { ~uint64_t(0) };
+        size_t numFrames { 0 };
+        Smoother before;
+        Smoother after;
+    };
+    mutable SharedCrossfade sharedCrossfade_;
+
+    /**
+     * @brief The setup of the voices of the region which depends neither on
+     * the key nor on the velocity, so a voice start copies it rather than
+     * looking up the modulation targets and computing the unison.
+     */
+    struct VoiceTemplate {
+        ModMatrix::TargetId masterAmplitudeTarget;
+        ModMatrix::TargetId amplitudeTarget;
+        ModMatrix::TargetId volumeTarget;
+        ModMatrix::TargetId panTarget;
+        ModMatrix::TargetId positionTarget;
+        ModMatrix::TargetId widthTarget;
+        ModMatrix::TargetId pitchTarget;
+        ModMatrix::TargetId oscillatorDetuneTarget;
+        ModMatrix::TargetId oscillatorModDepthTarget;
+        std::vector<FilterHolder::Targets> filterTargets;
+        std::vector<EQHolder::Targets> equalizerTargets;
+
+        /**
+         * @brief The stages which the voices of the region go through; they
+         * select a render of the voice specialized to them.
+         */
+        enum RenderFeatures : unsigned {
+            renderOscillator = 1 << 0,
+            renderStereo = 1 << 1,
+            renderFilters = 1 << 2,
+            renderEqualizers = 1 << 3,
+            renderCrossfades = 1 << 4,
+            numRenderVariants = 1 << 5
+        };
+        unsigned renderFeatures { 0 };
+
+        float baseGain { 1.0f };
+        // the oscillators of the unison, or the carrier and the modulator
+        unsigned waveUnisonSize { 1 };
+        float waveDetuneRatio[config::oscillatorsPerVoice] {};
+        float waveLeftGain[config::oscillatorsPerVoice] {};
+        float waveRightGain[config::oscillatorsPerVoice] {};
+    };
+    VoiceTemplate voiceTemplate_;
+
     Region region_;
 
     LEAK_DETECTOR(Layer);
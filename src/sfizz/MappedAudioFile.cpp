@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "MappedAudioFile.h"
+#include "Config.h"
+#include "utility/Debug.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace sfz {
+
+#if !defined(_WIN32)
+namespace {
+
+constexpr uint16_t kWavFormatFloat = 3;
+constexpr uint16_t kWavFormatExtensible = 0xfffe;
+
+uint16_t readLE16(const unsigned char* data) noexcept
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t readLE32(const unsigned char* data) noexcept
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+        | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+bool isLittleEndianHost() noexcept
+{
+    const uint32_t value = 1;
+    unsigned char first;
+    std::memcpy(&first, &value, 1);
+    return first == 1;
+}
+
+/**
+ * @brief Locate the data chunk of a mono 32-bit float WAV file.
+ */
+bool findFloatWavData(int fd, off_t fileSize, off_t& dataOffset, off_t& dataSize) noexcept
+{
+    unsigned char header[12];
+    if (fileSize < 12 || pread(fd, header, 12, 0) != 12)
+        return false;
+    if (std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool formatOk = false;
+    off_t offset = 12;
+    while (offset + 8 <= fileSize) {
+        unsigned char chunk[8];
+        if (pread(fd, chunk, 8, offset) != 8)
+            return false;
+
+        const off_t chunkSize = readLE32(chunk + 4);
+        const off_t chunkData = offset + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[26];
+            const size_t fmtSize = chunkSize >= 26 ? 26 : 16;
+            if (chunkSize < 16 || pread(fd, fmt, fmtSize, chunkData) != static_cast<ssize_t>(fmtSize))
+                return false;
+
+            uint16_t formatTag = readLE16(fmt);
+            if (formatTag == kWavFormatExtensible && fmtSize == 26)
+                formatTag = readLE16(fmt + 24); // first bytes of the subformat GUID
+            const uint16_t numChannels = readLE16(fmt + 2);
+            const uint16_t bitsPerSample = readLE16(fmt + 14);
+            formatOk = formatTag == kWavFormatFloat && numChannels == 1 && bitsPerSample == 32;
+            if (!formatOk)
+                return false;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!formatOk)
+                return false;
+            dataOffset = chunkData;
+            dataSize = std::min(chunkSize, fileSize - chunkData);
+            dataSize -= dataSize % sizeof(float);
+            return dataSize > 0 && dataOffset % sizeof(float) == 0;
+        }
+
+        offset = chunkData + chunkSize + (chunkSize & 1);
+    }
+
+    return false;
+}
+
+} // namespace
+#endif
+
+std::unique_ptr<MappedAudioFile> MappedAudioFile::open(const fs::path& path)
+{
+#if defined(_WIN32)
+    (void)path;
+    return {};
+#else
+    if (!isLittleEndianHost())
+        return {};
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return {};
+
+    struct FdCloser {
+        ~FdCloser() { ::close(fd); }
+        int fd;
+    } closer { fd };
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return {};
+
+    off_t dataOffset;
+    off_t dataSize;
+    if (!findFloatWavData(fd, st.st_size, dataOffset, dataSize))
+        return {};
+
+    // Reserve zero pages around the file mapping, so that the padding frames
+    // before and after the data read as silence
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto roundUp = [pageSize](size_t size) { return (size + pageSize - 1) / pageSize * pageSize; };
+
+    const size_t paddingSize = roundUp(config::excessFileFrames * sizeof(float));
+    const size_t fileMapSize = roundUp(static_cast<size_t>(dataOffset + dataSize));
+    const size_t mappingSize = paddingSize + fileMapSize + paddingSize;
+
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return {};
+
+    unsigned char* fileStart = static_cast<unsigned char*>(mapping) + paddingSize;
+    if (mmap(fileStart, static_cast<size_t>(dataOffset + dataSize), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(mapping, mappingSize);
+        return {};
+    }
+
+    // Blank the header and whatever follows the data in the last page; this
+    // only copies the first and last pages of the mapping
+    std::memset(fileStart, 0, static_cast<size_t>(dataOffset));
+    const size_t dataEnd = static_cast<size_t>(dataOffset + dataSize);
+    std::memset(fileStart + dataEnd, 0, fileMapSize - dataEnd);
+    mprotect(mapping, mappingSize, PROT_READ);
+
+    std::unique_ptr<MappedAudioFile> file { new MappedAudioFile };
+    file->mapping_ = mapping;
+    file->mappingSize_ = mappingSize;
+    file->data_ = absl::MakeConstSpan(
+        reinterpret_cast<const float*>(fileStart + dataOffset),
+        static_cast<size_t>(dataSize) / sizeof(float));
+    return file;
+#endif
+}
+
+MappedAudioFile::~MappedAudioFile()
+{
+#if !defined(_WIN32)
+    if (mapping_)
+        munmap(mapping_, mappingSize_);
+#endif
+}
+
+} // namespace sfz
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "utility/LeakDetector.h"
+#include <absl/types/span.h>
+#include <ghc/fs_std.hpp>
+#include <memory>
+
+namespace sfz {
+
+/**
+ * @brief A read-only memory mapping of the sample data of an audio file,
+ * which can be played in place without decoding.
+ *
+ * Only the files whose data is already in the layout of the file pool
+ * buffers can be mapped, which are mono WAV files of 32-bit float samples on
+ * a little-endian host. The data is surrounded by config::excessFileFrames
+ * frames of silence on each side, like the decoded buffers.
+ *
+ * The mappings are only supported on the POSIX systems; elsewhere no file
+ * is mapped, and the file pool decodes the files as usual.
+ */
+class MappedAudioFile {
+public:
+    /**
+     * @brief Whether the files can be mapped on this system
+     */
+    static constexpr bool isSupported() noexcept
+    {
+#if defined(_WIN32)
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    /**
+     * @brief Map the data of an audio file
+     *
+     * @param path the file to map
+     * @return the mapping, or null if the file cannot be mapped, which is
+     *         always the case if the mappings are not supported
+     */
+    static std::unique_ptr<MappedAudioFile> open(const fs::path& path);
+
+    ~MappedAudioFile();
+
+    MappedAudioFile(const MappedAudioFile&) = delete;
+    MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+
+    /**
+     * @brief Get the sample data of the file
+     */
+    absl::Span<const float> getData() const noexcept { return data_; }
+
+private:
+    MappedAudioFile() = default;
+
+    void* mapping_ { nullptr };
+    size_t mappingSize_ { 0 };
+    absl::Span<const float> data_;
+
+    LEAK_DETECTOR(MappedAudioFile);
+};
+
+} // namespace sfz
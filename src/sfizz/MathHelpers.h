@@ -315,6 +315,25 @@ inline uint32_t nextPow2(uint32_t v)
     return v;
 }
 
+/**
+ * @brief Count the trailing zero bits of an integer
+ *
+ * @param v A non-zero integer
+ * @return The index of the lowest bit set in @p v
+ */
+inline unsigned countTrailingZeros(uint64_t v)
+{
+    ASSERT(v != 0);
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#else
+    unsigned n = 0;
+    for (; !(v & 1); v >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
 /**
    @brief Wrap a normalized phase into the domain [0;1[
  */
@@ -718,7 +737,8 @@ private:
  *
  */
 namespace Random {
-static fast_rand randomGenerator;
+// thread-local, because voices may render concurrently on several threads
+static thread_local fast_rand randomGenerator;
 } // namespace Random
 
 /**
@@ -94,11 +94,27 @@ void sfz::MidiState::flushEvents() noexcept
         events.resize(1);
     };
 
-    for (auto& events : ccEvents)
-        flushEventVector(events);
+    // only the vectors which received events this block have to be flushed
+    for (unsigned i = 0; i < numChangedCCs; ++i) {
+        const int ccNumber = changedCCs[i];
+        flushEventVector(ccEvents[ccNumber]);
+        changedCCSet.reset(ccNumber);
+    }
+    numChangedCCs = 0;
 
-    for (auto& events: polyAftertouchEvents)
-        flushEventVector(events);
+    for (unsigned i = 0; i < numChangedPolyAftertouchNotes; ++i) {
+        const int noteNumber = changedPolyAftertouchNotes[i];
+        flushEventVector(polyAftertouchEvents[noteNumber]);
+        changedPolyAftertouchSet.reset(noteNumber);
+    }
+    numChangedPolyAftertouchNotes = 0;
+
+    for (unsigned i = 0; i < numChangedPerNoteLanes; ++i) {
+        const int lane = changedPerNoteLanes[i];
+        flushEventVector(perNoteEvents[lane / 128][lane % 128]);
+        changedPerNoteSet.reset(lane);
+    }
+    numChangedPerNoteLanes = 0;
 
     flushEventVector(pitchEvents);
     flushEventVector(channelAftertouchEvents);
@@ -118,6 +134,11 @@ void sfz::MidiState::setSamplesPerBlock(int samplesPerBlock) noexcept
     for (auto& events: polyAftertouchEvents)
         updateEventBufferSize(events);
 
+    for (auto& lanes: perNoteEvents) {
+        for (auto& events: lanes)
+            updateEventBufferSize(events);
+    }
+
     updateEventBufferSize(pitchEvents);
     updateEventBufferSize(channelAftertouchEvents);
 }
@@ -182,7 +203,30 @@ void sfz::MidiState::polyAftertouchEvent(int delay, int noteNumber, float aftert
     if (noteNumber < 0 || noteNumber >= static_cast<int>(polyAftertouchEvents.size()))
         return;
 
-    insertEventInVector(polyAftertouchEvents[noteNumber], delay, aftertouch);
+    EventVector& events = polyAftertouchEvents[noteNumber];
+    insertEventInVector(events, delay, aftertouch);
+
+    if (events.size() > 1 && !changedPolyAftertouchSet.test(noteNumber)) {
+        changedPolyAftertouchSet.set(noteNumber);
+        changedPolyAftertouchNotes[numChangedPolyAftertouchNotes++] = static_cast<uint8_t>(noteNumber);
+    }
+}
+
+void sfz::MidiState::perNoteEvent(int delay, int noteNumber, int ccNumber, float value) noexcept
+{
+    ASSERT(isPerNoteCC(ccNumber));
+    if (noteNumber < 0 || noteNumber > 127 || !isPerNoteCC(ccNumber))
+        return;
+
+    const int index = ccNumber - ExtendedCCs::perNotePitchBend;
+    EventVector& events = perNoteEvents[index][noteNumber];
+    insertEventInVector(events, delay, value);
+
+    const int lane = index * 128 + noteNumber;
+    if (events.size() > 1 && !changedPerNoteSet.test(lane)) {
+        changedPerNoteSet.set(lane);
+        changedPerNoteLanes[numChangedPerNoteLanes++] = static_cast<uint16_t>(lane);
+    }
 }
 
 float sfz::MidiState::getChannelAftertouch() const noexcept
@@ -200,9 +244,25 @@ float sfz::MidiState::getPolyAftertouch(int noteNumber) const noexcept
     return polyAftertouchEvents[noteNumber].back().value;
 }
 
+float sfz::MidiState::getPerNoteValue(int noteNumber, int ccNumber) const noexcept
+{
+    if (noteNumber < 0 || noteNumber > 127 || !isPerNoteCC(ccNumber))
+        return 0.0f;
+
+    const EventVector& events = perNoteEvents[ccNumber - ExtendedCCs::perNotePitchBend][noteNumber];
+    ASSERT(events.size() > 0);
+    return events.back().value;
+}
+
 void sfz::MidiState::ccEvent(int delay, int ccNumber, float ccValue) noexcept
 {
-    insertEventInVector(ccEvents[ccNumber], delay, ccValue);
+    EventVector& events = ccEvents[ccNumber];
+    insertEventInVector(events, delay, ccValue);
+
+    if (events.size() > 1 && !changedCCSet.test(ccNumber)) {
+        changedCCSet.set(ccNumber);
+        changedCCs[numChangedCCs++] = static_cast<uint16_t>(ccNumber);
+    }
 }
 
 float sfz::MidiState::getCCValue(int ccNumber) const noexcept
@@ -263,8 +323,20 @@ void sfz::MidiState::resetEventStates() noexcept
    for (auto& events : polyAftertouchEvents)
         clearEvents(events);
 
+    for (auto& lanes : perNoteEvents) {
+        for (auto& events : lanes)
+            clearEvents(events);
+    }
+
     clearEvents(pitchEvents);
     clearEvents(channelAftertouchEvents);
+
+    numChangedCCs = 0;
+    changedCCSet.reset();
+    numChangedPolyAftertouchNotes = 0;
+    changedPolyAftertouchSet.reset();
+    numChangedPerNoteLanes = 0;
+    changedPerNoteSet.reset();
 }
 
 const sfz::EventVector& sfz::MidiState::getCCEvents(int ccIdx) const noexcept
@@ -293,6 +365,14 @@ const sfz::EventVector& sfz::MidiState::getPolyAftertouchEvents(int noteNumber)
     return polyAftertouchEvents[noteNumber];
 }
 
+const sfz::EventVector& sfz::MidiState::getPerNoteEvents(int noteNumber, int ccNumber) const noexcept
+{
+    if (noteNumber < 0 || noteNumber > 127 || !isPerNoteCC(ccNumber))
+        return nullEvent;
+
+    return perNoteEvents[ccNumber - ExtendedCCs::perNotePitchBend][noteNumber];
+}
+
 int sfz::MidiState::getProgram() const noexcept
 {
     return currentProgram;
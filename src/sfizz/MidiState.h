@@ -120,6 +120,18 @@ public:
      */
     void polyAftertouchEvent(int delay, int noteNumber, float aftertouch) noexcept;
 
+    /**
+     * @brief Register an event of a per-note controller, which MPE sends on
+     * the channel of each note.
+     *
+     * @param delay
+     * @param noteNumber
+     * @param ccNumber the extended CC of the controller, ExtendedCCs::perNotePitchBend
+     *                 or ExtendedCCs::perNoteTimbre
+     * @param value
+     */
+    void perNoteEvent(int delay, int noteNumber, int ccNumber, float value) noexcept;
+
     /**
      * @brief Get the channel aftertouch status
 
@@ -134,6 +146,15 @@ public:
      */
     float getPolyAftertouch(int noteNumber) const noexcept;
 
+    /**
+     * @brief Get the last value of a per-note controller
+     *
+     * @param noteNumber
+     * @param ccNumber
+     * @return float
+     */
+    float getPerNoteValue(int noteNumber, int ccNumber) const noexcept;
+
     /**
      * @brief Get the current midi program
      *
@@ -211,6 +232,7 @@ public:
 
     const EventVector& getCCEvents(int ccIdx) const noexcept;
     const EventVector& getPolyAftertouchEvents(int noteNumber) const noexcept;
+    const EventVector& getPerNoteEvents(int noteNumber, int ccNumber) const noexcept;
     const EventVector& getPitchEvents() const noexcept;
     const EventVector& getChannelAftertouchEvents() const noexcept;
     /**
@@ -295,6 +317,35 @@ private:
      */
     std::array<EventVector, 128> polyAftertouchEvents;
 
+    /**
+     * @brief Per-note controller status, by controller and by note.
+     */
+    static constexpr int numPerNoteCCs = ExtendedCCs::perNoteTimbre - ExtendedCCs::perNotePitchBend + 1;
+    std::array<std::array<EventVector, 128>, numPerNoteCCs> perNoteEvents;
+
+    /**
+     * @brief CCs which hold more than a single event, to flush.
+     */
+    std::array<uint16_t, config::numCCs> changedCCs;
+    unsigned numChangedCCs { 0 };
+    std::bitset<config::numCCs> changedCCSet;
+
+    /**
+     * @brief Notes whose polyphonic aftertouch holds more than a single
+     * event, to flush.
+     */
+    std::array<uint8_t, 128> changedPolyAftertouchNotes;
+    unsigned numChangedPolyAftertouchNotes { 0 };
+    std::bitset<128> changedPolyAftertouchSet;
+
+    /**
+     * @brief Lanes of the per-note controllers which hold more than a single
+     * event, to flush, as the controller index times 128 plus the note.
+     */
+    std::array<uint16_t, numPerNoteCCs * 128> changedPerNoteLanes;
+    unsigned numChangedPerNoteLanes { 0 };
+    std::bitset<numPerNoteCCs * 128> changedPerNoteSet;
+
     /**
      * @brief Current midi program
      */
@@ -32,6 +32,8 @@ public:
         G = gain / (1 + gain);
     }
 
+    Type coefficient() const { return G; }
+
     void processLowpass(absl::Span<const Type> input, absl::Span<Type> output)
     {
         CHECK_SPAN_SIZES(input, output);
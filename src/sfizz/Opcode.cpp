@@ -24,27 +24,31 @@ Opcode::Opcode(absl::string_view inputOpcode, absl::string_view inputValue)
     , value(trim(inputValue))
     , category(identifyCategory(inputOpcode))
 {
-    size_t nextCharIndex { 0 };
-    int parameterPosition { 0 };
-    auto nextNumIndex = name.find_first_of("1234567890");
-    while (nextNumIndex != name.npos) {
-        const auto numLetters = nextNumIndex - nextCharIndex;
-        parameterPosition += numLetters;
-        lettersOnlyHash = hashNoAmpersand(name.substr(nextCharIndex, numLetters), lettersOnlyHash);
-        nextCharIndex = name.find_first_not_of("1234567890", nextNumIndex);
+    // The numbers in the name are the parameters, which the hash replaces
+    // by ampersands
+    const absl::string_view view { name };
+    size_t index = 0;
+    while (index < view.size()) {
+        const char c = view[index];
+        if (!absl::ascii_isdigit(c)) {
+            if (c != '&')
+                lettersOnlyHash = hashByte(c, lettersOnlyHash);
+            ++index;
+            continue;
+        }
+
+        size_t end = index + 1;
+        while (end < view.size() && absl::ascii_isdigit(view[end]))
+            ++end;
 
         uint32_t returnedValue;
-        const auto numDigits = (nextCharIndex == name.npos) ? name.npos : nextCharIndex - nextNumIndex;
-        if (absl::SimpleAtoi(name.substr(nextNumIndex, numDigits), &returnedValue)) {
+        if (absl::SimpleAtoi(view.substr(index, end - index), &returnedValue)) {
             lettersOnlyHash = hash("&", lettersOnlyHash);
             parameters.push_back(returnedValue);
         }
 
-        nextNumIndex = name.find_first_of("1234567890", nextCharIndex);
+        index = end;
     }
-
-    if (nextCharIndex != name.npos)
-        lettersOnlyHash = hashNoAmpersand(name.substr(nextCharIndex), lettersOnlyHash);
 }
 
 static absl::string_view extractBackInteger(absl::string_view opcodeName)
@@ -143,6 +147,49 @@ OpcodeCategory Opcode::identifyCategory(absl::string_view name)
     return category;
 }
 
+Opcode OpcodeCleanupCache::cleanUp(const Opcode& opcode, OpcodeScope scope)
+{
+    auto& names = names_[scope];
+    auto it = names.find(opcode.name);
+    if (it == names.end()) {
+        Opcode cleanOpcode = opcode.cleanUp(scope);
+        CleanName cleanName;
+        if (cleanOpcode.name != opcode.name) {
+            cleanName.unchanged = false;
+            cleanName.name = cleanOpcode.name;
+            cleanName.lettersOnlyHash = cleanOpcode.lettersOnlyHash;
+            cleanName.parameters = cleanOpcode.parameters;
+            cleanName.category = cleanOpcode.category;
+        }
+        names.emplace(opcode.name, std::move(cleanName));
+        return cleanOpcode;
+    }
+
+    Opcode cleanOpcode { opcode };
+    const CleanName& cleanName = it->second;
+    if (!cleanName.unchanged) {
+        cleanOpcode.name = cleanName.name;
+        cleanOpcode.lettersOnlyHash = cleanName.lettersOnlyHash;
+        cleanOpcode.parameters = cleanName.parameters;
+        cleanOpcode.category = cleanName.category;
+    }
+    return cleanOpcode;
+}
+
+void OpcodeCleanupCache::clear() noexcept
+{
+    for (auto& names : names_)
+        names.clear();
+}
+
+size_t OpcodeCleanupCache::size() const noexcept
+{
+    size_t size = 0;
+    for (const auto& names : names_)
+        size += names.size();
+    return size;
+}
+
 template <typename T>
 absl::optional<T> transformInt_(OpcodeSpec<T> spec, int64_t v)
 {
@@ -10,10 +10,13 @@
 #include "SfzHelpers.h"
 #include "utility/LeakDetector.h"
 #include "utility/StringViewHelpers.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
 #include "absl/meta/type_traits.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/string_view.h"
+#include <array>
 #include <vector>
 #include <type_traits>
 #include <iosfwd>
@@ -69,8 +72,10 @@ struct Opcode {
     std::string name {};
     std::string value {};
     uint64_t lettersOnlyHash { Fnv1aBasis };
-    // This is to handle the integer parameters of some opcodes
-    std::vector<uint16_t> parameters;
+    // This is to handle the integer parameters of some opcodes; few opcodes
+    // have more than a couple, which are kept without allocating
+    using Parameters = absl::InlinedVector<uint16_t, 4>;
+    Parameters parameters;
     OpcodeCategory category;
 
     /*
@@ -135,6 +140,42 @@ private:
     LEAK_DETECTOR(Opcode);
 };
 
+/**
+ * @brief The normalized names of the opcodes met during a load, by raw name
+ * and scope, such that each repeated opcode name is cleaned up and tokenized
+ * once.
+ */
+class OpcodeCleanupCache {
+public:
+    /**
+     * @brief Normalize an opcode like Opcode::cleanUp, reusing the name,
+     * hash and parameters normalized for the same raw name and scope.
+     *
+     * @param opcode opcode to normalize
+     * @param scope scope where this opcode appears
+     * @return normalized opcode
+     */
+    Opcode cleanUp(const Opcode& opcode, OpcodeScope scope);
+    /**
+     * @brief Forget the names, at the end of a load.
+     */
+    void clear() noexcept;
+    /**
+     * @brief Get the number of raw names kept, over all the scopes.
+     */
+    size_t size() const noexcept;
+
+private:
+    struct CleanName {
+        bool unchanged { true };
+        std::string name;
+        uint64_t lettersOnlyHash { Fnv1aBasis };
+        Opcode::Parameters parameters;
+        OpcodeCategory category { kOpcodeNormal };
+    };
+    std::array<absl::flat_hash_map<std::string, CleanName>, kOpcodeScopeEffect + 1> names_;
+};
+
 /**
  * @brief Convert a note in string to its equivalent midi note number
  *
@@ -2894,7 +2894,11 @@ end_control:
 
 Opcode Opcode::cleanUp(OpcodeScope scope) const
 {
-    return Opcode(cleanUpOpcodeName(name, scope), value);
+    std::string cleanName = cleanUpOpcodeName(name, scope);
+    // Most names are clean already, which saves tokenizing them again
+    if (cleanName == name)
+        return *this;
+    return Opcode(cleanName, value);
 }
 
 } // namespace sfz
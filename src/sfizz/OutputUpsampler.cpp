@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "OutputUpsampler.h"
+#include "utility/Debug.h"
+#include <algorithm>
+#include <cmath>
+
+namespace sfz {
+
+/**
+ * @brief Compute the delay of the upsampling filters at DC, as the centroid
+ * of their impulse response.
+ */
+static int computeLatency(int factor)
+{
+    if (factor == 1)
+        return 0;
+
+    constexpr int numFrames { 4096 };
+    std::vector<float> impulse(numFrames);
+    std::vector<float> response(numFrames * factor);
+    std::vector<float> temp(std::max(1, Upsampler::recommendedBuffer(factor, numFrames)));
+    impulse[0] = 1.0f;
+
+    std::vector<Upsampler, jsl::aligned_allocator<Upsampler, config::defaultAlignment>> upsampler(1);
+    upsampler[0].process(factor, impulse.data(), response.data(), numFrames, temp.data(), static_cast<int>(temp.size()));
+
+    double moment = 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < response.size(); ++i) {
+        moment += static_cast<double>(i) * response[i];
+        sum += response[i];
+    }
+    return (sum > 0.0) ? static_cast<int>(std::lround(moment / sum)) : 0;
+}
+
+void OutputUpsampler::prepare(int factor, size_t numChannels, size_t maxFrames)
+{
+    ASSERT(Upsampler::canProcess(factor));
+
+    const size_t maxInputFrames = (maxFrames + factor - 1) / factor;
+    // the pending frames are fewer than the factor
+    const size_t maxOutputFrames = maxInputFrames * factor + factor;
+
+    if (factor != factor_)
+        latency_ = computeLatency(factor);
+
+    factor_ = factor;
+    upsamplers_ = aligned_vector<Upsampler>(numChannels);
+    input_ = AudioBuffer<float>(numChannels, maxInputFrames);
+    output_ = AudioBuffer<float>(numChannels, maxOutputFrames);
+    temp_.resize(std::max<size_t>(1, Upsampler::recommendedBuffer(factor, static_cast<int>(maxInputFrames))));
+    pendingFrames_ = 0;
+}
+
+void OutputUpsampler::clear() noexcept
+{
+    for (Upsampler& upsampler : upsamplers_)
+        upsampler.clear();
+    pendingFrames_ = 0;
+}
+
+size_t OutputUpsampler::getFramesToRender(size_t numFrames) const noexcept
+{
+    if (numFrames <= pendingFrames_)
+        return 0;
+
+    const size_t missing = numFrames - pendingFrames_;
+    return (missing + factor_ - 1) / factor_;
+}
+
+AudioSpan<float> OutputUpsampler::getInput(size_t numFrames) noexcept
+{
+    ASSERT(numFrames <= input_.getNumFrames());
+    return AudioSpan<float>(input_).first(numFrames);
+}
+
+AudioSpan<const float> OutputUpsampler::process(size_t numFrames) noexcept
+{
+    ASSERT(numFrames <= input_.getNumFrames());
+    ASSERT(pendingFrames_ + numFrames * factor_ <= output_.getNumFrames());
+
+    for (size_t c = 0, n = numFrames > 0 ? input_.getNumChannels() : 0; c < n; ++c) {
+        upsamplers_[c].process(
+            factor_, input_.channelReader(c), output_.channelWriter(c) + pendingFrames_,
+            static_cast<int>(numFrames), temp_.data(), static_cast<int>(temp_.size()));
+    }
+
+    pendingFrames_ += numFrames * factor_;
+    return AudioSpan<const float>(output_).first(pendingFrames_);
+}
+
+void OutputUpsampler::consume(size_t numFrames) noexcept
+{
+    ASSERT(numFrames <= pendingFrames_);
+
+    const size_t remaining = pendingFrames_ - numFrames;
+    for (size_t c = 0, n = output_.getNumChannels(); c < n; ++c) {
+        float* channel = output_.channelWriter(c);
+        std::copy(channel + numFrames, channel + pendingFrames_, channel);
+    }
+    pendingFrames_ = remaining;
+}
+
+} // namespace sfz
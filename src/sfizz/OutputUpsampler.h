@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "Buffer.h"
+#include "OversamplerHelpers.h"
+#include "utility/LeakDetector.h"
+#include <jsl/allocator>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief Upsampler of the outputs of the engine, when it processes at a
+ * fraction of the host sample rate. The frames upsampled past the end of a
+ * host block are kept for the next one, so the host blocks may have any size.
+ */
+class OutputUpsampler {
+public:
+    /**
+     * @brief Set the factor, and allocate for the channels and the block
+     * size of the host. This clears the filters and the pending frames.
+     *
+     * @param factor     1, 2, 4 or 8
+     * @param numChannels
+     * @param maxFrames  the most frames of a host block
+     */
+    void prepare(int factor, size_t numChannels, size_t maxFrames);
+
+    /**
+     * @brief Clear the filters and the pending frames.
+     */
+    void clear() noexcept;
+
+    int getFactor() const noexcept { return factor_; }
+    size_t getNumChannels() const noexcept { return input_.getNumChannels(); }
+
+    /**
+     * @brief Get the frames at the host rate which were upsampled in the
+     * previous blocks and not output yet.
+     */
+    size_t getPendingFrames() const noexcept { return pendingFrames_; }
+
+    /**
+     * @brief Get the frames to render at the processing rate so that a host
+     * block is complete.
+     *
+     * @param numFrames the frames of the host block
+     */
+    size_t getFramesToRender(size_t numFrames) const noexcept;
+
+    /**
+     * @brief Get the buffer to render the frames at the processing rate into.
+     *
+     * @param numFrames the frames to render, as of getFramesToRender()
+     */
+    AudioSpan<float> getInput(size_t numFrames) noexcept;
+
+    /**
+     * @brief Upsample the frames rendered into the input, after the pending
+     * ones.
+     *
+     * @param numFrames the frames rendered
+     * @return AudioSpan<const float> the pending frames, followed by the ones
+     *         upsampled
+     */
+    AudioSpan<const float> process(size_t numFrames) noexcept;
+
+    /**
+     * @brief Drop the frames which were output, and keep the others pending.
+     *
+     * @param numFrames
+     */
+    void consume(size_t numFrames) noexcept;
+
+    /**
+     * @brief Get the delay of the filters at the low frequencies, in frames at
+     * the host rate.
+     */
+    int getLatency() const noexcept { return latency_; }
+
+private:
+    template <class T, std::size_t A = config::defaultAlignment>
+    using aligned_vector = std::vector<T, jsl::aligned_allocator<T, A>>;
+
+    int factor_ { 1 };
+    int latency_ { 0 };
+    aligned_vector<Upsampler> upsamplers_;
+    AudioBuffer<float> input_;
+    AudioBuffer<float> output_;
+    Buffer<float> temp_;
+    size_t pendingFrames_ { 0 };
+
+    LEAK_DETECTOR(OutputUpsampler);
+};
+
+} // namespace sfz
@@ -6,11 +6,14 @@
 
 #include "Oversampler.h"
 #include "OversamplerHelpers.h"
+#include "StereoUpsampler.h"
 #include "Buffer.h"
 #include "AudioSpan.h"
 #include "AudioReader.h"
 #include "SIMDConfig.h"
+#include "SIMDHelpers.h"
 #include <jsl/allocator>
+#include <algorithm>
 
 template <class T, std::size_t A = sfz::config::defaultAlignment>
 using aligned_vector = std::vector<T, jsl::aligned_allocator<T, A>>;
@@ -116,3 +119,165 @@ void sfz::Oversampler::stream(AudioReader& input, AudioSpan<float> output, std::
             framesReady->fetch_add(outputChunkSize);
     }
 }
+
+namespace sfz {
+
+/**
+ * @brief Audio file reader which oversamples the frames of another reader,
+ * keeping the state of the filters from a chunk to the next. The stereo
+ * files run through the vectorized stereo stages, and the others channel by
+ * channel.
+ */
+class OversamplingAudioReader : public AudioReader {
+public:
+    OversamplingAudioReader(AudioReaderPtr reader, Oversampling factor);
+    AudioReaderType type() const override { return reader_->type(); }
+    int format() const override { return reader_->format(); }
+    int64_t frames() const override { return reader_->frames() * factor_; }
+    unsigned channels() const override { return reader_->channels(); }
+    unsigned sampleRate() const override { return reader_->sampleRate() * static_cast<unsigned>(factor_); }
+    size_t readNextBlock(float* buffer, size_t frames) override;
+    size_t readNextFrames(float* const outputs[], size_t frames) override;
+    // The metadata positions are in the frames of the source, so there is none
+
+private:
+    bool oversampleNextChunk();
+    bool oversampleNextStereoChunk();
+
+private:
+    AudioReaderPtr reader_;
+    int factor_ { 1 };
+    bool stereo_ { false };
+    aligned_vector<Upsampler> upsamplers_;
+    StereoUpsampler stereoUpsampler_;
+    AudioBuffer<float> input_;
+    AudioBuffer<float> output_;
+    // The interleaved frames of the stereo files
+    std::vector<float> stereoInput_;
+    std::vector<float> stereoOutput_;
+    Buffer<float> temp_;
+    // The oversampled frames of the last chunk which are not read yet
+    size_t outputStart_ { 0 };
+    size_t outputEnd_ { 0 };
+    std::vector<float> channelFrames_;
+};
+
+OversamplingAudioReader::OversamplingAudioReader(AudioReaderPtr reader, Oversampling factor)
+    : reader_(std::move(reader)), factor_(static_cast<int>(factor)),
+      stereo_(reader_->channels() == 2)
+{
+    const size_t chunkSize = config::fileChunkSize;
+    const auto numOutputFrames = chunkSize * static_cast<size_t>(factor_);
+    if (stereo_) {
+        stereoInput_.resize(2 * chunkSize);
+        stereoOutput_.resize(2 * numOutputFrames);
+        temp_.resize(std::max<size_t>(1, StereoUpsampler::recommendedBuffer(factor_, chunkSize)));
+    } else {
+        upsamplers_.resize(reader_->channels());
+        input_ = AudioBuffer<float>(reader_->channels(), chunkSize);
+        output_ = AudioBuffer<float>(reader_->channels(), numOutputFrames);
+        temp_.resize(std::max<size_t>(128, Upsampler::recommendedBuffer(16, chunkSize)));
+    }
+}
+
+bool OversamplingAudioReader::oversampleNextChunk()
+{
+    if (stereo_)
+        return oversampleNextStereoChunk();
+
+    const unsigned numChannels = reader_->channels();
+    float* inputs[config::maxChannels] {};
+    for (unsigned c = 0; c < numChannels; ++c)
+        inputs[c] = input_.channelWriter(c);
+
+    const size_t numRead = reader_->readNextFrames(inputs, config::fileChunkSize);
+    if (numRead == 0)
+        return false;
+
+    for (unsigned c = 0; c < numChannels; ++c) {
+        upsamplers_[c].process(factor_, inputs[c], output_.channelWriter(c),
+            static_cast<int>(numRead), temp_.data(), static_cast<int>(temp_.size()));
+    }
+    outputStart_ = 0;
+    outputEnd_ = numRead * static_cast<size_t>(factor_);
+    return true;
+}
+
+bool OversamplingAudioReader::oversampleNextStereoChunk()
+{
+    const size_t numRead = reader_->readNextBlock(stereoInput_.data(), config::fileChunkSize);
+    if (numRead == 0)
+        return false;
+
+    stereoUpsampler_.process(factor_, stereoInput_.data(), stereoOutput_.data(), numRead, temp_.data());
+    outputStart_ = 0;
+    outputEnd_ = numRead * static_cast<size_t>(factor_);
+    return true;
+}
+
+size_t OversamplingAudioReader::readNextFrames(float* const outputs[], size_t frames)
+{
+    const unsigned numChannels = reader_->channels();
+    size_t numFramesRead = 0;
+    while (numFramesRead < frames) {
+        if (outputStart_ == outputEnd_ && !oversampleNextChunk())
+            break;
+
+        const size_t numFrames = std::min(frames - numFramesRead, outputEnd_ - outputStart_);
+        if (stereo_) {
+            readInterleaved(&stereoOutput_[2 * outputStart_], outputs[0] + numFramesRead,
+                outputs[1] + numFramesRead, static_cast<unsigned>(2 * numFrames));
+        } else {
+            for (unsigned c = 0; c < numChannels; ++c) {
+                const float* source = output_.channelReader(c) + outputStart_;
+                std::copy(source, source + numFrames, outputs[c] + numFramesRead);
+            }
+        }
+        outputStart_ += numFrames;
+        numFramesRead += numFrames;
+    }
+    return numFramesRead;
+}
+
+size_t OversamplingAudioReader::readNextBlock(float* buffer, size_t frames)
+{
+    const unsigned numChannels = reader_->channels();
+    if (numChannels == 1)
+        return readNextFrames(&buffer, frames);
+
+    if (stereo_) {
+        size_t numFramesRead = 0;
+        while (numFramesRead < frames) {
+            if (outputStart_ == outputEnd_ && !oversampleNextChunk())
+                break;
+
+            const size_t numFrames = std::min(frames - numFramesRead, outputEnd_ - outputStart_);
+            const float* source = &stereoOutput_[2 * outputStart_];
+            std::copy(source, source + 2 * numFrames, buffer + 2 * numFramesRead);
+            outputStart_ += numFrames;
+            numFramesRead += numFrames;
+        }
+        return numFramesRead;
+    }
+
+    channelFrames_.resize(numChannels * frames);
+    float* outputs[config::maxChannels] {};
+    for (unsigned c = 0; c < numChannels; ++c)
+        outputs[c] = &channelFrames_[c * frames];
+
+    const size_t numFramesRead = readNextFrames(outputs, frames);
+    for (size_t i = 0; i < numFramesRead; ++i) {
+        for (unsigned c = 0; c < numChannels; ++c)
+            buffer[i * numChannels + c] = outputs[c][i];
+    }
+    return numFramesRead;
+}
+
+AudioReaderPtr createOversamplingAudioReader(AudioReaderPtr reader, Oversampling factor)
+{
+    if (!reader || factor == Oversampling::x1 || reader->channels() > config::maxChannels)
+        return reader;
+    return AudioReaderPtr(new OversamplingAudioReader(std::move(reader), factor));
+}
+
+} // namespace sfz
@@ -7,6 +7,7 @@
 #pragma once
 #include "Buffer.h"
 #include "AudioBuffer.h"
+#include "AudioReader.h"
 #include "AudioSpan.h"
 #include "Config.h"
 #include "utility/Debug.h"
@@ -15,7 +16,6 @@
 #include <memory>
 
 namespace sfz {
-class AudioReader;
 
 enum class Oversampling: int {
     x1 = 1,
@@ -71,4 +71,17 @@ private:
     LEAK_DETECTOR(Oversampler);
 };
 
+/**
+ * @brief Create a reader of the frames of another one oversampled by a
+ *        factor, chunk by chunk as they are read, with the filters of the
+ *        Oversampler. This is the stage which the file pool puts after the
+ *        decoding of the oversampled files, so they stream progressively.
+ *
+ * @param reader
+ * @param factor
+ * @return AudioReaderPtr the same reader if the factor is x1, or if it has
+ *         more than config::maxChannels
+ */
+AudioReaderPtr createOversamplingAudioReader(AudioReaderPtr reader, Oversampling factor);
+
 }
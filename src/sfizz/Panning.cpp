@@ -1,167 +1,178 @@
 #include "Panning.h"
 #include "MathHelpers.h"
-#include <array>
+#include <simde/simde-features.h>
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+#include <simde/x86/sse.h>
+#endif
 #include <cmath>
 
-#if SFIZZ_HAVE_NEON
-#include <arm_neon.h>
-#include "simd/Common.h"
-using Type = float;
-constexpr unsigned TypeAlignment = 4;
-constexpr unsigned ByteAlignment = TypeAlignment * sizeof(Type);
-#endif
+namespace sfz
+{
 
+// The gain of the left channel is cos(pi/2 x), approximated on [0, 1] as
+// (1 - x^2) g(x^2), which is exactly 1 at 0 and 0 at 1. The error of the
+// approximation is under 1e-7, the right channel takes the gain at 1 - x.
+static constexpr float panCoeffs[] {
+    0.9999999474196122f, -0.2336980268873181f, 0.01995129056772355f, -0.0008567027362161636f
+};
 
-namespace sfz
+float panLaw(float pan)
 {
+    const float u = pan * pan;
+    const float g = panCoeffs[0] + u * (panCoeffs[1] + u * (panCoeffs[2] + u * panCoeffs[3]));
+    return (1.0f - u) * g;
+}
 
-constexpr int panSize { 4095 };
+namespace {
 
-// Table of pan values for the left channel, extra element for safety
-static const auto panData = []()
+inline float normalizePan(float pan)
 {
-    std::array<float, panSize + 1> pan;
-    int i = 0;
+    return clamp((pan + 1.0f) * 0.5f, 0.0f, 1.0f);
+}
 
-    for (; i < panSize; ++i)
-        pan[i] = std::cos(i * (piTwo<double>() / (panSize - 1)));
+inline void tickPan(float pan, float& left, float& right)
+{
+    const float p = normalizePan(pan);
+    left *= panLaw(p);
+    right *= panLaw(1 - p);
+}
 
-    for (; i < static_cast<int>(pan.size()); ++i)
-        pan[i] = pan[panSize - 1];
+inline void tickWidth(float width, float& left, float& right)
+{
+    const float w = normalizePan(width);
+    const float coeff1 = panLaw(w);
+    const float coeff2 = panLaw(1 - w);
+    const float l = left;
+    const float r = right;
+    left = l * coeff2 + r * coeff1;
+    right = l * coeff1 + r * coeff2;
+}
 
-    return pan;
-}();
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+/**
+ * @brief The normalized pan of 4 envelope values
+ */
+inline simde__m128 normalizePan(simde__m128 pan)
+{
+    const simde__m128 half = simde_mm_set1_ps(0.5f);
+    const simde__m128 p = simde_mm_add_ps(simde_mm_mul_ps(pan, half), half);
+    return simde_mm_max_ps(simde_mm_min_ps(p, simde_mm_set1_ps(1.0f)), simde_mm_setzero_ps());
+}
 
-float panLookup(float pan)
+/**
+ * @brief The pan law of 4 normalized values
+ */
+inline simde__m128 panLaw(simde__m128 x)
 {
-    // reduce range, round to nearest
-    const long index = lroundPositive(pan * (panSize - 1));
-    return panData[index];
+    const simde__m128 u = simde_mm_mul_ps(x, x);
+    simde__m128 g = simde_mm_set1_ps(panCoeffs[3]);
+    g = simde_mm_add_ps(simde_mm_mul_ps(g, u), simde_mm_set1_ps(panCoeffs[2]));
+    g = simde_mm_add_ps(simde_mm_mul_ps(g, u), simde_mm_set1_ps(panCoeffs[1]));
+    g = simde_mm_add_ps(simde_mm_mul_ps(g, u), simde_mm_set1_ps(panCoeffs[0]));
+    return simde_mm_mul_ps(simde_mm_sub_ps(simde_mm_set1_ps(1.0f), u), g);
 }
 
-inline void tickPan(const float* pan, float* leftBuffer, float* rightBuffer)
+inline void tickPan(simde__m128 pan, simde__m128& left, simde__m128& right)
 {
-    auto p = (*pan + 1.0f) * 0.5f;
-    p = clamp(p, 0.0f, 1.0f);
-    *leftBuffer *= panLookup(p);
-    *rightBuffer *= panLookup(1 - p);
+    const simde__m128 p = normalizePan(pan);
+    left = simde_mm_mul_ps(left, panLaw(p));
+    right = simde_mm_mul_ps(right, panLaw(simde_mm_sub_ps(simde_mm_set1_ps(1.0f), p)));
 }
 
-void pan(const float* panEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
+inline void tickWidth(simde__m128 width, simde__m128& left, simde__m128& right)
 {
-    const auto* sentinel = panEnvelope + size;
-
-#if SFIZZ_HAVE_NEON
-    const auto* firstAligned = prevAligned<ByteAlignment>(panEnvelope + TypeAlignment - 1);
-
-    if (willAlign<ByteAlignment>(panEnvelope, leftBuffer, rightBuffer) && (firstAligned < sentinel)) {
-        while (panEnvelope < firstAligned) {
-            tickPan(panEnvelope, leftBuffer, rightBuffer);
-            incrementAll(panEnvelope, leftBuffer, rightBuffer);
-        }
-
-        uint32_t indices[TypeAlignment];
-        float leftPan[TypeAlignment];
-        float rightPan[TypeAlignment];
-        const auto* lastAligned = prevAligned<ByteAlignment>(sentinel);
-        while (panEnvelope < lastAligned) {
-            float32x4_t mmPan = vld1q_f32(panEnvelope);
-            mmPan = vaddq_f32(mmPan, vdupq_n_f32(1.0f));
-            mmPan = vmulq_n_f32(mmPan, 0.5f * panSize);
-            mmPan = vaddq_f32(mmPan, vdupq_n_f32(0.5f));
-            uint32x4_t mmIdx = vcvtq_u32_f32(mmPan);
-            mmIdx = vminq_u32(mmIdx, vdupq_n_u32(panSize - 1));
-            mmIdx = vmaxq_u32(mmIdx, vdupq_n_u32(0));
-            vst1q_u32(indices, mmIdx);
-
-            leftPan[0] = panData[indices[0]];
-            rightPan[0] = panData[panSize - indices[0] - 1];
-            leftPan[1] = panData[indices[1]];
-            rightPan[1] = panData[panSize - indices[1] - 1];
-            leftPan[2] = panData[indices[2]];
-            rightPan[2] = panData[panSize - indices[2] - 1];
-            leftPan[3] = panData[indices[3]];
-            rightPan[3] = panData[panSize - indices[3] - 1];
-
-            vst1q_f32(leftBuffer, vmulq_f32(vld1q_f32(leftBuffer), vld1q_f32(leftPan)));
-            vst1q_f32(rightBuffer, vmulq_f32(vld1q_f32(rightBuffer), vld1q_f32(rightPan)));
-
-            incrementAll<TypeAlignment>(panEnvelope, leftBuffer, rightBuffer);
-        }
-    }
+    const simde__m128 w = normalizePan(width);
+    const simde__m128 coeff1 = panLaw(w);
+    const simde__m128 coeff2 = panLaw(simde_mm_sub_ps(simde_mm_set1_ps(1.0f), w));
+    const simde__m128 l = left;
+    const simde__m128 r = right;
+    left = simde_mm_add_ps(simde_mm_mul_ps(l, coeff2), simde_mm_mul_ps(r, coeff1));
+    right = simde_mm_add_ps(simde_mm_mul_ps(l, coeff1), simde_mm_mul_ps(r, coeff2));
+}
 #endif
 
-    while (panEnvelope < sentinel) {
-        tickPan(panEnvelope, leftBuffer, rightBuffer);
-        incrementAll(panEnvelope, leftBuffer, rightBuffer);
+} // namespace
+
+void pan(const float* panEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
+{
+    unsigned i = 0;
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    for (; i + 4 <= size; i += 4) {
+        simde__m128 left = simde_mm_loadu_ps(leftBuffer + i);
+        simde__m128 right = simde_mm_loadu_ps(rightBuffer + i);
+        tickPan(simde_mm_loadu_ps(panEnvelope + i), left, right);
+        simde_mm_storeu_ps(leftBuffer + i, left);
+        simde_mm_storeu_ps(rightBuffer + i, right);
     }
+#endif
 
+    for (; i < size; ++i)
+        tickPan(panEnvelope[i], leftBuffer[i], rightBuffer[i]);
 }
 
-inline void tickWidth(const float* width, float* leftBuffer, float* rightBuffer)
+void width(const float* widthEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
 {
-    float w = (*width + 1.0f) * 0.5f;
-    w = clamp(w, 0.0f, 1.0f);
-    const auto coeff1 = panLookup(w);
-    const auto coeff2 = panLookup(1 - w);
-    const auto l = *leftBuffer;
-    const auto r = *rightBuffer;
-    *leftBuffer = l * coeff2 + r * coeff1;
-    *rightBuffer = l * coeff1 + r * coeff2;
+    unsigned i = 0;
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    for (; i + 4 <= size; i += 4) {
+        simde__m128 left = simde_mm_loadu_ps(leftBuffer + i);
+        simde__m128 right = simde_mm_loadu_ps(rightBuffer + i);
+        tickWidth(simde_mm_loadu_ps(widthEnvelope + i), left, right);
+        simde_mm_storeu_ps(leftBuffer + i, left);
+        simde_mm_storeu_ps(rightBuffer + i, right);
+    }
+#endif
+
+    for (; i < size; ++i)
+        tickWidth(widthEnvelope[i], leftBuffer[i], rightBuffer[i]);
 }
 
-void width(const float* widthEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
+void panWidthPosition(const float* panEnvelope, const float* widthEnvelope, const float* positionEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
 {
-    const auto* sentinel = widthEnvelope + size;
-
-#if SFIZZ_HAVE_NEON
-    const auto* firstAligned = prevAligned<ByteAlignment>(widthEnvelope + TypeAlignment  - 1);
-
-    if (willAlign<ByteAlignment>(widthEnvelope, leftBuffer, rightBuffer) && firstAligned < sentinel) {
-        while (widthEnvelope < firstAligned) {
-            tickWidth(widthEnvelope, leftBuffer, rightBuffer);
-            incrementAll(widthEnvelope, leftBuffer, rightBuffer);
-        }
-
-        uint32_t indices[TypeAlignment];
-        float coeff1[TypeAlignment];
-        float coeff2[TypeAlignment];
-        const auto* lastAligned = prevAligned<ByteAlignment>(sentinel);
-        while (widthEnvelope < lastAligned) {
-            float32x4_t mmWidth = vld1q_f32(widthEnvelope);
-            mmWidth = vaddq_f32(mmWidth, vdupq_n_f32(1.0f));
-            mmWidth = vmulq_n_f32(mmWidth, 0.5f * panSize);
-            mmWidth = vaddq_f32(mmWidth, vdupq_n_f32(0.5f));
-            uint32x4_t mmIdx = vcvtq_u32_f32(mmWidth);
-            mmIdx = vminq_u32(mmIdx, vdupq_n_u32(panSize - 1));
-            mmIdx = vmaxq_u32(mmIdx, vdupq_n_u32(0));
-            vst1q_u32(indices, mmIdx);
-
-            coeff1[0] = panData[indices[0]];
-            coeff2[0] = panData[panSize - indices[0] - 1];
-            coeff1[1] = panData[indices[1]];
-            coeff2[1] = panData[panSize - indices[1] - 1];
-            coeff1[2] = panData[indices[2]];
-            coeff2[2] = panData[panSize - indices[2] - 1];
-            coeff1[3] = panData[indices[3]];
-            coeff2[3] = panData[panSize - indices[3] - 1];
-
-            float32x4_t mmCoeff1 = vld1q_f32(coeff1);
-            float32x4_t mmCoeff2 = vld1q_f32(coeff2);
-            float32x4_t mmLeft = vld1q_f32(leftBuffer);
-            float32x4_t mmRight = vld1q_f32(rightBuffer);
-
-            vst1q_f32(leftBuffer, vaddq_f32(vmulq_f32(mmCoeff2, mmLeft), vmulq_f32(mmCoeff1, mmRight)));
-            vst1q_f32(rightBuffer, vaddq_f32(vmulq_f32(mmCoeff1, mmLeft), vmulq_f32(mmCoeff2, mmRight)));
-
-            incrementAll<TypeAlignment>(widthEnvelope, leftBuffer, rightBuffer);
-        }
+    unsigned i = 0;
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    for (; i + 4 <= size; i += 4) {
+        simde__m128 left = simde_mm_loadu_ps(leftBuffer + i);
+        simde__m128 right = simde_mm_loadu_ps(rightBuffer + i);
+        tickPan(simde_mm_loadu_ps(panEnvelope + i), left, right);
+        tickWidth(simde_mm_loadu_ps(widthEnvelope + i), left, right);
+        tickPan(simde_mm_loadu_ps(positionEnvelope + i), left, right);
+        simde_mm_storeu_ps(leftBuffer + i, left);
+        simde_mm_storeu_ps(rightBuffer + i, right);
     }
-#endif // SFIZZ_HAVE_NEON
+#endif
 
-    while (widthEnvelope < sentinel) {
-        tickWidth(widthEnvelope, leftBuffer, rightBuffer);
-        incrementAll(widthEnvelope, leftBuffer, rightBuffer);
+    for (; i < size; ++i) {
+        tickPan(panEnvelope[i], leftBuffer[i], rightBuffer[i]);
+        tickWidth(widthEnvelope[i], leftBuffer[i], rightBuffer[i]);
+        tickPan(positionEnvelope[i], leftBuffer[i], rightBuffer[i]);
+    }
+}
+
+void widthAndPosition(float widthValue, float positionValue, float gain, float* leftBuffer, float* rightBuffer, unsigned size) noexcept
+{
+    const float w = normalizePan(widthValue);
+    const float widthCoeff1 = panLaw(w);
+    const float widthCoeff2 = panLaw(1 - w);
+
+    const float p = normalizePan(positionValue);
+    const float leftGain = gain * panLaw(p);
+    const float rightGain = gain * panLaw(1 - p);
+
+    // width followed by position, as a 2x2 matrix
+    const float ll = leftGain * widthCoeff2;
+    const float lr = leftGain * widthCoeff1;
+    const float rl = rightGain * widthCoeff1;
+    const float rr = rightGain * widthCoeff2;
+
+    for (unsigned i = 0; i < size; ++i) {
+        const float l = leftBuffer[i];
+        const float r = rightBuffer[i];
+        leftBuffer[i] = ll * l + lr * r;
+        rightBuffer[i] = rl * l + rr * r;
     }
 }
 
@@ -6,14 +6,14 @@ namespace sfz
 {
 
 /**
-* @brief Lookup a value from the pan table
-*        No check is done on the range, needs to be capped
-*        between 0 and panSize.
+* @brief Compute the gain of the left channel for a pan in [0, 1], which is
+*        cos(pi/2 pan) within 1e-7. The right channel has the gain at 1 - pan.
+*        No check is done on the range, needs to be capped between 0 and 1.
 *
 * @param pan
 * @return float
 */
-float panLookup(float pan);
+float panLaw(float pan);
 
 
 /**
@@ -47,4 +47,44 @@ inline void width(absl::Span<const float> widthEnvelope, absl::Span<float> leftB
     width(widthEnvelope.data(), leftBuffer.data(), rightBuffer.data(), minSpanSize(widthEnvelope, leftBuffer, rightBuffer));
 }
 
+/**
+ * @brief Applies the pan, width and position envelopes in a single pass over
+ * the buffers. This is equivalent to calling `pan`, `width`, and `pan` with
+ * the position.
+ *
+ * @param panEnvelope
+ * @param widthEnvelope
+ * @param positionEnvelope
+ * @param leftBuffer
+ * @param rightBuffer
+ * @param size
+ */
+void panWidthPosition(const float* panEnvelope, const float* widthEnvelope, const float* positionEnvelope, float* leftBuffer, float* rightBuffer, unsigned size) noexcept;
+inline void panWidthPosition(absl::Span<const float> panEnvelope, absl::Span<const float> widthEnvelope, absl::Span<const float> positionEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    CHECK_SPAN_SIZES(panEnvelope, widthEnvelope, positionEnvelope, leftBuffer, rightBuffer);
+    panWidthPosition(panEnvelope.data(), widthEnvelope.data(), positionEnvelope.data(), leftBuffer.data(), rightBuffer.data(), minSpanSize(panEnvelope, widthEnvelope, positionEnvelope, leftBuffer, rightBuffer));
+}
+
+/**
+ * @brief Applies constant width and position values, followed by a gain, as a
+ * single stereo matrix. This is equivalent to calling `width` and `pan` with
+ * constant envelopes, and then applying the gain, but it makes a single pass
+ * over the buffers.
+ *
+ * @param widthValue
+ * @param positionValue
+ * @param gain
+ * @param leftBuffer
+ * @param rightBuffer
+ * @param size
+ */
+void widthAndPosition(float widthValue, float positionValue, float gain, float* leftBuffer, float* rightBuffer, unsigned size) noexcept;
+
+inline void widthAndPosition(float widthValue, float positionValue, float gain, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    CHECK_SPAN_SIZES(leftBuffer, rightBuffer);
+    widthAndPosition(widthValue, positionValue, gain, leftBuffer.data(), rightBuffer.data(), minSpanSize(leftBuffer, rightBuffer));
+}
+
 }
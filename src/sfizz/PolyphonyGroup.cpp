@@ -26,11 +26,15 @@ void sfz::PolyphonyGroup::removeVoice(const Voice* voice) noexcept
 void sfz::PolyphonyGroup::removeAllVoices() noexcept
 {
     voices.clear();
+    numPlaying_ = 0;
 }
 
-unsigned sfz::PolyphonyGroup::numPlayingVoices() const noexcept
+void sfz::PolyphonyGroup::setVoicePlaying(bool playing) noexcept
 {
-    return absl::c_count_if(voices, [](const Voice* v) {
-        return !v->offedOrFree();
-    });
+    if (playing) {
+        ++numPlaying_;
+    } else {
+        ASSERT(numPlaying_ > 0);
+        numPlaying_ -= (numPlaying_ > 0);
+    }
 }
@@ -40,6 +40,13 @@ public:
      * @brief Remove all the voices from this polyphony group.
      */
     void removeAllVoices() noexcept;
+    /**
+     * @brief Count a registered voice which starts playing, or which stops
+     * as it is offed or released to be cleaned up.
+     *
+     * @param playing
+     */
+    void setVoicePlaying(bool playing) noexcept;
     /**
      * @brief Get the polyphony limit for this group
      *
@@ -49,7 +56,12 @@ public:
     /**
      * @brief Returns the number of playing (unreleased) voices
      */
-    unsigned numPlayingVoices() const noexcept;
+    unsigned numPlayingVoices() const noexcept { return numPlaying_; }
+    /**
+     * @brief Returns the number of active voices which no longer count as
+     * playing, being offed or about to be cleaned up
+     */
+    unsigned numOffedVoices() const noexcept { return static_cast<unsigned>(voices.size()) - numPlaying_; }
     /**
      * @brief Get the active voices
      *
@@ -70,6 +82,7 @@ public:
 private:
     unsigned polyphonyLimit { config::maxVoices };
     std::vector<Voice*> voices;
+    unsigned numPlaying_ { 0 };
     unsigned mostRecentStartStamp_ { 0 };
 };
 
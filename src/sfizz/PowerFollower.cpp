@@ -8,6 +8,7 @@
 #include "Defaults.h"
 #include "SIMDHelpers.h"
 #include <absl/types/span.h>
+#include <algorithm>
 
 namespace sfz {
 
@@ -35,7 +36,7 @@ void PowerFollower::setSamplesPerBlock(unsigned samplesPerBlock)
     }
 }
 
-void PowerFollower::process(AudioSpan<float> buffer) noexcept
+void PowerFollower::process(AudioSpan<float> buffer, float gain) noexcept
 {
     size_t numFrames = buffer.getNumFrames();
     if (numFrames == 0)
@@ -47,8 +48,12 @@ void PowerFollower::process(AudioSpan<float> buffer) noexcept
     float currentSum = currentSum_;
     size_t currentCount = currentCount_;
 
+    const size_t stride = stride_;
+    size_t strideOffset = strideOffset_;
+
     const float attackFactor = attackTrackingFactor_;
     const float releaseFactor = releaseTrackingFactor_;
+    const float powerGain = gain * gain;
 
     ///
     size_t index = 0;
@@ -56,11 +61,25 @@ void PowerFollower::process(AudioSpan<float> buffer) noexcept
         size_t blockSize = std::min(step - currentCount, numFrames - index);
         absl::Span<float> tempBuffer(tempBuffer_.get(), blockSize);
 
-        copy(buffer.getConstSpan(0).subspan(index, blockSize), tempBuffer);
-        for (unsigned i = 1, n = buffer.getNumChannels(); i < n; ++i)
-            add(buffer.getConstSpan(i).subspan(index, blockSize), tempBuffer);
-
-        currentSum += sumSquares<float>(tempBuffer);
+        if (stride == 1) {
+            copy(buffer.getConstSpan(0).subspan(index, blockSize), tempBuffer);
+            for (unsigned i = 1, n = buffer.getNumChannels(); i < n; ++i)
+                add(buffer.getConstSpan(i).subspan(index, blockSize), tempBuffer);
+
+            currentSum += powerGain * sumSquares<float>(tempBuffer);
+        } else {
+            // each frame read stands for the ones of its stride
+            float sum = 0.0f;
+            size_t frame = strideOffset;
+            for (; frame < blockSize; frame += stride) {
+                float sample = 0.0f;
+                for (unsigned i = 0, n = buffer.getNumChannels(); i < n; ++i)
+                    sample += buffer.getConstSpan(i)[index + frame];
+                sum += sample * sample;
+            }
+            strideOffset = frame - blockSize;
+            currentSum += powerGain * static_cast<float>(stride) * sum;
+        }
         currentCount += blockSize;
 
         if (currentCount == step) {
@@ -79,6 +98,7 @@ void PowerFollower::process(AudioSpan<float> buffer) noexcept
     currentPower_ = currentPower;
     currentSum_ = currentSum;
     currentCount_ = currentCount;
+    strideOffset_ = strideOffset;
 }
 
 void PowerFollower::clear() noexcept
@@ -86,6 +106,13 @@ void PowerFollower::clear() noexcept
     currentPower_ = 0;
     currentSum_ = 0;
     currentCount_ = 0;
+    strideOffset_ = 0;
+}
+
+void PowerFollower::setStride(unsigned stride) noexcept
+{
+    stride_ = std::max(1u, stride);
+    strideOffset_ = 0;
 }
 
 void PowerFollower::updateTrackingFactor() noexcept
@@ -15,8 +15,14 @@ public:
     PowerFollower();
     void setSampleRate(float sampleRate) noexcept;
     void setSamplesPerBlock(unsigned samplesPerBlock);
-    void process(AudioSpan<float> buffer) noexcept;
+    void process(AudioSpan<float> buffer, float gain = 1.0f) noexcept;
     void clear() noexcept;
+    /**
+     * @brief Estimate the power from one frame in `stride`, which is cheaper
+     * and precise enough for the stealing. A stride of 1 reads all frames.
+     */
+    void setStride(unsigned stride) noexcept;
+    unsigned getStride() const noexcept { return stride_; }
     float getAveragePower() const noexcept { return currentPower_; }
 
 private:
@@ -34,6 +40,9 @@ private:
     float currentPower_ {};
     float currentSum_ = 0;
     size_t currentCount_ = 0;
+    unsigned stride_ = 1;
+    // the frames to skip before the next one read, with a stride
+    size_t strideOffset_ = 0;
 };
 
 } // namespace sfz
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "QualityGovernor.h"
+#include "Config.h"
+#include "Defaults.h"
+#include <algorithm>
+
+namespace sfz {
+
+void QualityGovernor::clear() noexcept
+{
+    load_ = 0.0;
+    qualityReduction_ = 0;
+    holdBlocks_ = 0;
+}
+
+void QualityGovernor::update(double duration, double deadline) noexcept
+{
+    if (deadline <= 0.0)
+        return;
+
+    const double load = duration / deadline;
+    if (load > load_)
+        load_ = load;
+    else
+        load_ += config::qualityGovernorReleaseFactor * (load - load_);
+
+    if (holdBlocks_ > 0) {
+        --holdBlocks_;
+        return;
+    }
+
+    if (load_ > config::qualityGovernorHighLoad && qualityReduction_ < config::qualityGovernorMaxSteps) {
+        ++qualityReduction_;
+        holdBlocks_ = config::qualityGovernorHoldBlocks;
+    }
+    else if (load_ < config::qualityGovernorLowLoad && qualityReduction_ > 0) {
+        --qualityReduction_;
+        holdBlocks_ = config::qualityGovernorHoldBlocks;
+    }
+}
+
+int QualityGovernor::reduceSampleQuality(int quality, int reduction) noexcept
+{
+    constexpr int hermiteQuality = 2;
+    return std::max(quality - reduction, std::min(quality, hermiteQuality));
+}
+
+int QualityGovernor::adaptSampleQuality(int quality, float minRatio, float maxRatio) noexcept
+{
+    // The highest ratios of 1, 4, 7 and 12 semitones up and their qualities
+    static constexpr float ratios[] = { 1.0594631f, 1.2599211f, 1.4983071f, 2.0f };
+    static constexpr int qualities[] = { 2, 4, 6, 8 };
+
+    int adapted = quality;
+    for (size_t i = 0; i < sizeof(ratios) / sizeof(ratios[0]); ++i) {
+        if (maxRatio <= ratios[i]) {
+            adapted = qualities[i];
+            break;
+        }
+    }
+
+    // An octave down and further, the images of the hermite come through
+    constexpr int sincQuality = 3;
+    if (minRatio < 0.5f)
+        adapted = std::max(adapted, sincQuality);
+
+    return std::min(quality, adapted);
+}
+
+int QualityGovernor::reduceOscillatorQuality(int quality, int reduction) noexcept
+{
+    const int defaultQuality = Default::oscillatorQuality;
+    return std::max(quality - reduction, std::min(quality, defaultQuality));
+}
+
+} // namespace sfz
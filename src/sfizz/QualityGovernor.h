@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+
+namespace sfz {
+
+/**
+ * @brief Watches the duration of the callbacks against their deadline, and
+ * decides how many steps the rendering quality of new voices should be
+ * lowered by.
+ *
+ * The load follows rising values immediately and falling values slowly, and
+ * the reduction changes by one step at most every few blocks, so new voices
+ * have the time to take effect before the next decision.
+ */
+class QualityGovernor {
+public:
+    /**
+     * @brief Reset the load measurement and the quality reduction.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Account for a rendered block.
+     *
+     * @param duration the time spent processing the block, in seconds
+     * @param deadline the duration of the block in real time, in seconds
+     */
+    void update(double duration, double deadline) noexcept;
+
+    /**
+     * @brief Get the smoothed ratio of processing time to real time.
+     */
+    double getLoad() const noexcept { return load_; }
+
+    /**
+     * @brief Get the current number of quality steps to remove.
+     */
+    int getQualityReduction() const noexcept { return qualityReduction_; }
+
+    /**
+     * @brief Lower a sample quality towards hermite interpolation.
+     * Qualities which are already at or under hermite are unchanged.
+     *
+     * @param quality the requested sample quality
+     * @param reduction the number of steps to remove
+     */
+    static int reduceSampleQuality(int quality, int reduction) noexcept;
+
+    /**
+     * @brief Lower an oscillator quality towards the default quality.
+     * Qualities which are already at or under the default are unchanged.
+     *
+     * @param quality the requested oscillator quality
+     * @param reduction the number of steps to remove
+     */
+    static int reduceOscillatorQuality(int quality, int reduction) noexcept;
+
+    /**
+     * @brief Choose the sample quality of a block from the range of its
+     * playback ratios, in frames of the source per output frame: hermite
+     * interpolation near unity, and longer sincs as the block transposes
+     * further upward, where the aliasing shows.
+     *
+     * @param quality the requested sample quality, which is the ceiling
+     * @param minRatio the lowest ratio of the block
+     * @param maxRatio the highest ratio of the block
+     */
+    static int adaptSampleQuality(int quality, float minRatio, float maxRatio) noexcept;
+
+private:
+    double load_ { 0.0 };
+    int qualityReduction_ { 0 };
+    int holdBlocks_ { 0 };
+};
+
+} // namespace sfz
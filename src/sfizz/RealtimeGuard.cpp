@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "RealtimeGuard.h"
+#include "Config.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#if SFIZZ_RT_CHECKS && defined(__GLIBC__)
+#define SFIZZ_RT_HOOKS 1
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace sfz {
+
+namespace {
+
+std::array<std::atomic<uint64_t>, RealtimeGuard::NumViolations> violations {};
+std::atomic<int> numReports { 0 };
+std::atomic<int> reportLimit { config::realtimeGuardReports };
+
+// The thread variables are read in malloc, so they must not be allocated
+#if SFIZZ_RT_HOOKS
+#define SFIZZ_HOOK_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define SFIZZ_HOOK_TLS
+#endif
+
+// The depth of the audio scopes of the thread, and whether it reports a
+// violation, during which the hooks do not check
+SFIZZ_HOOK_TLS thread_local int scopeDepth { 0 };
+SFIZZ_HOOK_TLS thread_local bool reporting { false };
+
+#if SFIZZ_RT_HOOKS
+const char* violationName(RealtimeGuard::Violation violation) noexcept
+{
+    switch (violation) {
+    case RealtimeGuard::Allocation: return "allocation";
+    case RealtimeGuard::Deallocation: return "deallocation";
+    case RealtimeGuard::Lock: return "lock";
+    case RealtimeGuard::FileAccess: return "file access";
+    default: return "violation";
+    }
+}
+
+void writeError(const char* text) noexcept
+{
+    ssize_t result = ::write(STDERR_FILENO, text, std::strlen(text));
+    (void)result;
+}
+
+/**
+ * @brief Count a violation if the thread is in an audio scope, and report
+ * it. This must neither allocate nor lock, since it runs in the hooks.
+ */
+void checkViolation(RealtimeGuard::Violation violation) noexcept
+{
+    if (scopeDepth <= 0 || reporting)
+        return;
+
+    reporting = true;
+    violations[violation].fetch_add(1, std::memory_order_relaxed);
+    if (numReports.fetch_add(1, std::memory_order_relaxed) < reportLimit.load(std::memory_order_relaxed)) {
+        writeError("[sfizz] real-time violation on an audio thread: ");
+        writeError(violationName(violation));
+        writeError("\n");
+        void* frames[32];
+        const int numFrames = ::backtrace(frames, 32);
+        ::backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+    }
+    reporting = false;
+}
+#endif
+
+} // namespace
+
+bool RealtimeGuard::isEnabled() noexcept
+{
+#if SFIZZ_RT_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t RealtimeGuard::getViolations(Violation violation) noexcept
+{
+    return violations[violation].load(std::memory_order_relaxed);
+}
+
+uint64_t RealtimeGuard::getTotalViolations() noexcept
+{
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t>& count : violations)
+        total += count.load(std::memory_order_relaxed);
+    return total;
+}
+
+void RealtimeGuard::resetViolations() noexcept
+{
+    for (std::atomic<uint64_t>& count : violations)
+        count.store(0, std::memory_order_relaxed);
+    numReports.store(0, std::memory_order_relaxed);
+}
+
+void RealtimeGuard::setReportLimit(int limit) noexcept
+{
+    reportLimit.store(limit, std::memory_order_relaxed);
+}
+
+void RealtimeGuard::enter() noexcept
+{
+    ++scopeDepth;
+}
+
+void RealtimeGuard::leave() noexcept
+{
+    --scopeDepth;
+}
+
+} // namespace sfz
+
+#if SFIZZ_RT_HOOKS
+/*
+  The hooks of the C library. The allocations of the C++ library go through
+  malloc and free; the C++ mutexes go through pthread_mutex_lock.
+ */
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+FILE* _IO_fopen(const char* path, const char* mode);
+int __open(const char* path, int flags, ...);
+
+void* malloc(size_t size)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::Allocation);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::Allocation);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::Allocation);
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::Allocation);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::Allocation);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::Allocation);
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void* memory = __libc_memalign(alignment, size);
+    if (!memory)
+        return ENOMEM;
+    *pointer = memory;
+    return 0;
+}
+
+void free(void* pointer)
+{
+    if (pointer)
+        sfz::checkViolation(sfz::RealtimeGuard::Deallocation);
+    __libc_free(pointer);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    using LockFunction = int (*)(pthread_mutex_t*);
+    // Resolved before the audio threads run, by the first lock of the process
+    static const LockFunction next = reinterpret_cast<LockFunction>(::dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    sfz::checkViolation(sfz::RealtimeGuard::Lock);
+    return next(mutex);
+}
+
+FILE* fopen(const char* path, const char* mode)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::FileAccess);
+    return _IO_fopen(path, mode);
+}
+
+int open(const char* path, int flags, ...)
+{
+    sfz::checkViolation(sfz::RealtimeGuard::FileAccess);
+    int mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, int);
+        va_end(args);
+    }
+    return __open(path, flags, mode);
+}
+} // extern "C"
+#endif
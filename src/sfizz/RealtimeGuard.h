@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <cstdint>
+
+namespace sfz {
+
+/**
+ * @brief Detection of the operations which are not real-time safe on the
+ * audio threads, in builds with SFIZZ_RT_CHECKS.
+ *
+ * The threads which are in a scope are the audio threads: the calls to the
+ * heap, the waits on the mutexes and the opening of the files report a
+ * violation, with a backtrace on the standard error for the first ones, and
+ * count it. This hooks the functions of the C library (glibc), so it is meant
+ * for the debug builds and the tests; in other builds the scopes do nothing.
+ */
+class RealtimeGuard {
+public:
+    enum Violation {
+        Allocation,
+        Deallocation,
+        Lock,
+        FileAccess,
+        NumViolations
+    };
+
+    /**
+     * @brief Are the violations detected in this build?
+     */
+    static bool isEnabled() noexcept;
+
+    /**
+     * @brief Get the violations of a kind since the start or the last reset.
+     */
+    static uint64_t getViolations(Violation violation) noexcept;
+    static uint64_t getTotalViolations() noexcept;
+    static void resetViolations() noexcept;
+
+    /**
+     * @brief Set the violations reported with a backtrace, after which they
+     * are only counted.
+     */
+    static void setReportLimit(int numReports) noexcept;
+
+    /**
+     * @brief A scope of the calling thread in which it runs as an audio
+     * thread. The scopes may nest.
+     */
+    class Scope {
+    public:
+#if SFIZZ_RT_CHECKS
+        Scope() noexcept { enter(); }
+        ~Scope() noexcept { leave(); }
+#else
+        Scope() noexcept {}
+#endif
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+private:
+    static void enter() noexcept;
+    static void leave() noexcept;
+};
+
+} // namespace sfz
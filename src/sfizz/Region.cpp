@@ -45,6 +45,42 @@ sfz::Region::Region(int regionNumber, absl::string_view defaultPath)
     amplitudeEG.release = Default::egRelease;
 }
 
+sfz::Region::Region(const Region& other, int regionNumber)
+    : Region(other)
+{
+    // The sample opcodes modify the identifier in place
+    sampleId = std::make_shared<FileId>(*other.sampleId);
+
+    const NumericId<Region> otherId = other.id;
+    id = NumericId<Region> { regionNumber };
+    if (id == otherId)
+        return;
+
+    const auto moveKey = [this, otherId](ModKey& key) {
+        if (key && key.region() == otherId)
+            key = ModKey(key.id(), id, key.parameters());
+    };
+
+    for (Connection& connection : connections) {
+        moveKey(connection.source);
+        moveKey(connection.target);
+        moveKey(connection.sourceDepthMod);
+    }
+
+    const auto moveLFOKeys = [&moveKey](LFODescription& lfo) {
+        moveKey(lfo.beatsKey);
+        moveKey(lfo.freqKey);
+        moveKey(lfo.phaseKey);
+    };
+
+    for (LFODescription& lfo : lfos)
+        moveLFOKeys(lfo);
+    for (absl::optional<LFODescription>* lfo : { &amplitudeLFO, &pitchLFO, &filterLFO }) {
+        if (*lfo)
+            moveLFOKeys(**lfo);
+    }
+}
+
 // Helper for ccN processing
 #define case_any_ccN(x)        \
     case hash(x "_oncc&"):     \
@@ -54,7 +90,10 @@ sfz::Region::Region(int regionNumber, absl::string_view defaultPath)
 
 bool sfz::Region::parseOpcode(const Opcode& rawOpcode, bool cleanOpcode)
 {
-    const Opcode opcode = cleanOpcode ? rawOpcode.cleanUp(kOpcodeScopeRegion) : rawOpcode;
+    absl::optional<Opcode> cleanOpcodeStorage;
+    if (cleanOpcode)
+        cleanOpcodeStorage = rawOpcode.cleanUp(kOpcodeScopeRegion);
+    const Opcode& opcode = cleanOpcodeStorage ? *cleanOpcodeStorage : rawOpcode;
 
     switch (opcode.lettersOnlyHash) {
 
@@ -72,6 +111,7 @@ bool sfz::Region::parseOpcode(const Opcode& rawOpcode, bool cleanOpcode)
                 filename = absl::StrCat(defaultPath, absl::StrReplaceAll(trimmedSample, { { "\\", "/" } }));
 
             *sampleId = FileId(std::move(filename), sampleId->isReverse());
+            sampleSlot = {};
         }
         break;
     case hash("sample_quality"):
@@ -79,6 +119,7 @@ bool sfz::Region::parseOpcode(const Opcode& rawOpcode, bool cleanOpcode)
         break;
     case hash("direction"):
         *sampleId = sampleId->reversed(opcode.value == "reverse");
+        sampleSlot = {};
         break;
     case hash("delay"):
         delay = opcode.read(Default::delay);
@@ -1837,6 +1878,53 @@ void sfz::Region::offsetAllKeys(int offset) noexcept
     }
 }
 
+size_t sfz::Region::getMemoryUsage() const noexcept
+{
+    auto vectorUsage = [](const auto& vector) { return vector.capacity() * sizeof(vector[0]); };
+
+    size_t usage = 0;
+    for (const auto* map : { &offsetCC, &endCC, &loopStartCC, &loopEndCC })
+        usage += map->getMemoryUsage();
+    for (const auto* map : { &ccConditions, &ccTriggers, &crossfadeCCInRange, &crossfadeCCOutRange })
+        usage += map->getMemoryUsage();
+    usage += delayCC.getMemoryUsage();
+    usage += ampVeltrackCC.getMemoryUsage() + pitchVeltrackCC.getMemoryUsage();
+    usage += vectorUsage(velocityPoints) + vectorUsage(equalizers) + vectorUsage(filters);
+    usage += vectorUsage(flexEGs) + vectorUsage(lfos) + vectorUsage(gainToEffect) + vectorUsage(connections);
+    usage += defaultPath.capacity();
+    if (keyswitchLabel)
+        usage += keyswitchLabel->capacity();
+    if (sampleId)
+        usage += sizeof(FileId) + sampleId->filename().capacity();
+    return usage;
+}
+
+int sfz::Region::getBufferNesting() const noexcept
+{
+    // The buffers of the stages, without their modulations
+    int stageNesting = 2; // amplitude, pan and crossfades
+    if (isOscillator()) {
+        // frequencies and detune, then the oscillator temporaries
+        if (oscillatorMode <= 0 && oscillatorMulti < 2)
+            stageNesting = max(stageNesting, 3);
+        else if (oscillatorMode <= 0 && oscillatorMulti >= 3)
+            stageNesting = max(stageNesting, 5);
+        else
+            stageNesting = max(stageNesting, 4);
+    }
+    else
+        stageNesting = max(stageNesting, 3); // coefficients, then the jumps or the loop crossfade
+    if (!filters.empty() || !equalizers.empty())
+        stageNesting = max(stageNesting, 3); // cutoff or frequency, resonance or bandwidth, and gain
+
+    // An LFO holds up to 2 buffers while computing its modulation, on top of
+    // the stage which asks for it; no LFO modulates another one.
+    const bool haveLFOs = !lfos.empty() || amplitudeLFO || pitchLFO || filterLFO;
+    const int lfoNesting = haveLFOs ? 2 : 0;
+
+    return stageNesting + lfoNesting;
+}
+
 float sfz::Region::getGainToEffectBus(unsigned number) const noexcept
 {
     if (number >= gainToEffect.size())
@@ -1850,6 +1938,23 @@ float sfz::Region::getBendInCents(float bend) const noexcept
     return bend > 0.0f ? bend * static_cast<float>(bendUp) : -bend * static_cast<float>(bendDown);
 }
 
+float sfz::Region::getMaxPitchRatio() const noexcept
+{
+    const float highestKey = pitchKeytrack >= 0.0f ? keyRange.getEnd() : keyRange.getStart();
+    float cents = pitchKeytrack * (highestKey - float(pitchKeycenter));
+    cents += pitch;
+    cents += config::centPerSemitone * transpose;
+
+    float veltrack = pitchVeltrack;
+    for (const auto& mod : pitchVeltrackCC)
+        veltrack += std::abs(mod.data.modifier);
+    cents += max(0.0f, veltrack);
+
+    cents += std::abs(pitchRandom);
+    cents += max(0.0f, bendUp, bendDown);
+    return centsFactor(cents);
+}
+
 sfz::Region::Connection* sfz::Region::getConnection(const ModKey& source, const ModKey& target)
 {
     auto pred = [&source, &target](const Connection& c)
@@ -29,6 +29,7 @@ namespace sfz {
 
 class RegionSet;
 class MidiState;
+class WavetableMulti;
 
 /**
  * @brief Regions are the basic building blocks for the SFZ parsing and handling code.
@@ -45,6 +46,12 @@ class MidiState;
 struct Region {
     explicit Region(int regionNumber, absl::string_view defaultPath = "");
     Region(const Region&) = default;
+    /**
+     * @brief Copy a region under another number, moving its modulation keys
+     * to the new number. The regions of a group copy in this way the
+     * prototype which parsed the opcodes of their headers.
+     */
+    Region(const Region& other, int regionNumber);
     ~Region() = default;
 
     /**
@@ -118,6 +125,14 @@ struct Region {
      * @return float
      */
     float getBendInCents(float bend) const noexcept;
+    /**
+     * @brief Get the highest playback speed of the sample relative to the
+     * original, from the key range, tuning, velocity tracking and bend range.
+     * The runtime modulations are not considered.
+     *
+     * @return float
+     */
+    float getMaxPitchRatio() const noexcept;
 
     /**
      * @brief Parse a new opcode into the region to fill in the proper parameters.
@@ -204,6 +219,20 @@ struct Region {
      */
     float getGainToEffectBus(unsigned number) const noexcept;
 
+    /**
+     * @brief Get the memory allocated by the region for its members, in bytes.
+     * It is approximate, and does not count the nested allocations of the
+     * filters, EQs, LFOs and envelopes.
+     */
+    size_t getMemoryUsage() const noexcept;
+
+    /**
+     * @brief Get the most mono buffers of the buffer pool which a voice of
+     * the region holds at once, according to its generator, its filters and
+     * its LFOs.
+     */
+    int getBufferNesting() const noexcept;
+
     /**
      * @brief Check if a region is disabled, if its sample end is weakly negative for example.
      */
@@ -230,10 +259,11 @@ struct Region {
      */
     absl::optional<ModKey::Parameters> ccModParameters(int cc, ModId id, uint8_t N = 0, uint8_t X = 0, uint8_t Y = 0, uint8_t Z = 0) const noexcept;
 
-    const NumericId<Region> id;
+    NumericId<Region> id;
 
     // Sound source: sample playback
     std::shared_ptr<FileId> sampleId { new FileId }; // Sample
+    mutable FileSlot sampleSlot {}; // The data of the sample in the file pool
     absl::optional<int> sampleQuality {};
     float delay { Default::delay }; // delay
     float delayRandom { Default::delayRandom }; // delay_random
@@ -255,6 +285,7 @@ struct Region {
     float oscillatorPhase { Default::oscillatorPhase };
     OscillatorEnabled oscillatorEnabled { Default::oscillator }; // oscillator
     bool hasWavetableSample { false }; // (set according to sample file)
+    const WavetableMulti* wave { nullptr }; // (set on loading, for oscillators)
     int oscillatorMode { Default::oscillatorMode };
     int oscillatorMulti { Default::oscillatorMulti };
     float oscillatorDetune { Default::oscillatorDetune };
@@ -54,14 +54,27 @@ void sfz::RegionSet::removeVoiceFromHierarchy(const Region* region, const Voice*
     }
 }
 
-unsigned sfz::RegionSet::numPlayingVoices() const noexcept
+void sfz::RegionSet::setVoicePlaying(bool playing) noexcept
 {
-    return absl::c_count_if(voices, [](const Voice* v) {
-        return !v->offedOrFree();
-    });
+    if (playing) {
+        ++numPlaying_;
+    } else {
+        ASSERT(numPlaying_ > 0);
+        numPlaying_ -= (numPlaying_ > 0);
+    }
+}
+
+void sfz::RegionSet::setVoicePlayingInHierarchy(const Region* region, bool playing) noexcept
+{
+    auto* parent = region->parent;
+    while (parent != nullptr) {
+        parent->setVoicePlaying(playing);
+        parent = parent->getParent();
+    }
 }
 
 void sfz::RegionSet::removeAllVoices() noexcept
 {
     voices.clear();
+    numPlaying_ = 0;
 }
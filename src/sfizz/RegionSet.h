@@ -64,6 +64,21 @@ public:
      * @param voice
      */
     static void removeVoiceFromHierarchy(const Region* region, const Voice* voice) noexcept;
+    /**
+     * @brief Count a registered voice which starts playing, or which stops
+     * as it is offed or released to be cleaned up.
+     *
+     * @param playing
+     */
+    void setVoicePlaying(bool playing) noexcept;
+    /**
+     * @brief Count a voice which starts or stops playing in the whole parent
+     * hierarchy of the region.
+     *
+     * @param region
+     * @param playing
+     */
+    static void setVoicePlayingInHierarchy(const Region* region, bool playing) noexcept;
     /**
      * @brief Get the polyphony limit
      *
@@ -92,7 +107,12 @@ public:
     /**
      * @brief Returns the number of playing (unreleased) voices
      */
-    unsigned numPlayingVoices() const noexcept;
+    unsigned numPlayingVoices() const noexcept { return numPlaying_; }
+    /**
+     * @brief Returns the number of active voices which no longer count as
+     * playing, being offed or about to be cleaned up
+     */
+    unsigned numOffedVoices() const noexcept { return static_cast<unsigned>(voices.size()) - numPlaying_; }
     /**
      * @brief Get the active voices
      *
@@ -128,6 +148,7 @@ private:
     std::vector<Region*> regions;
     std::vector<RegionSet*> subsets;
     std::vector<Voice*> voices;
+    unsigned numPlaying_ { 0 };
     unsigned polyphonyLimit { config::maxVoices };
 };
 
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "RenderThreadPool.h"
+#include "RealtimeGuard.h"
+#include "ScopedFTZ.h"
+#include "Config.h"
+#include "utility/Debug.h"
+#include <absl/memory/memory.h>
+#include <algorithm>
+#include <system_error>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sfz {
+
+static thread_local unsigned renderThreadLane = 0;
+
+RenderThreadPool::RenderThreadPool()
+{
+}
+
+RenderThreadPool::~RenderThreadPool()
+{
+    stopWorkers();
+}
+
+unsigned RenderThreadPool::currentLane() noexcept
+{
+    return renderThreadLane;
+}
+
+void RenderThreadPool::setNumLanes(unsigned numLanes)
+{
+    ASSERT(numLanes > 0);
+    numLanes = std::max(1u, numLanes);
+
+    if (numLanes == getNumLanes())
+        return;
+
+    stopWorkers();
+
+    quit_ = false;
+    workers_.reserve(numLanes - 1);
+    for (unsigned lane = 1; lane < numLanes; ++lane) {
+        workers_.push_back(absl::make_unique<Worker>());
+        Worker& worker = *workers_.back();
+        worker.thread = std::thread(&RenderThreadPool::workerProc, this, std::ref(worker), lane);
+    }
+}
+
+void RenderThreadPool::stopWorkers()
+{
+    quit_ = true;
+    for (auto& worker : workers_)
+        worker->semStart.post();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+    workers_.clear();
+}
+
+void RenderThreadPool::run(Job& job) noexcept
+{
+    const size_t numWorkers = workers_.size();
+
+    currentJob_ = &job;
+    for (size_t i = 0; i < numWorkers; ++i)
+        workers_[i]->semStart.post();
+
+    job.process(0);
+
+    for (size_t i = 0; i < numWorkers; ++i)
+        semDone_.wait();
+
+    currentJob_ = nullptr;
+}
+
+void RenderThreadPool::workerProc(Worker& worker, unsigned lane)
+{
+    renderThreadLane = lane;
+    raiseCurrentThreadPriority(lane);
+
+    while (1) {
+        worker.semStart.wait();
+
+        if (quit_)
+            break;
+
+        {
+            ScopedFTZ ftz;
+            RealtimeGuard::Scope realtimeScope;
+            currentJob_->process(lane);
+        }
+
+        semDone_.post();
+    }
+}
+
+void RenderThreadPool::raiseCurrentThreadPriority(unsigned lane) noexcept
+{
+#if defined(_WIN32)
+    HANDLE thread = GetCurrentThread();
+    const int priority = THREAD_PRIORITY_TIME_CRITICAL;
+    if (!SetThreadPriority(thread, priority)) {
+        std::system_error error(GetLastError(), std::system_category());
+        DBG("[sfizz] Cannot set current thread priority: " << error.what());
+    }
+    (void)lane;
+#else
+    pthread_t thread = pthread_self();
+    int policy;
+    sched_param param;
+
+    if (pthread_getschedparam(thread, &policy, &param) != 0) {
+        DBG("[sfizz] Cannot get current thread scheduling parameters");
+        return;
+    }
+
+    policy = SCHED_FIFO;
+    const int minprio = sched_get_priority_min(policy);
+    const int maxprio = sched_get_priority_max(policy);
+    param.sched_priority = minprio + config::renderThreadPthreadPriority * (maxprio - minprio) / 100;
+
+    if (pthread_setschedparam(thread, policy, &param) != 0)
+        DBG("[sfizz] Cannot set current thread scheduling parameters");
+
+#if defined(__linux__)
+    // pin the worker to a core, leaving the first one to the audio thread
+    const unsigned numCores = std::thread::hardware_concurrency();
+    if (numCores > 1) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(1 + (lane - 1) % (numCores - 1), &cpuSet);
+        if (pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet) != 0)
+            DBG("[sfizz] Cannot set current thread affinity");
+    }
+#else
+    (void)lane;
+#endif
+#endif
+}
+
+} // namespace sfz
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "RTSemaphore.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief A small pool of real-time worker threads, which split a job into
+ * lanes processed concurrently with the calling thread.
+ *
+ * Lane 0 always runs on the thread which calls `run`, and lanes 1 to N-1 run
+ * on the workers. A worker thread keeps the same lane during all its life,
+ * which it can retrieve with `currentLane`.
+ */
+class RenderThreadPool {
+public:
+    class Job {
+    public:
+        virtual ~Job() {}
+        /**
+         * @brief Process the part of the job which belongs to the lane.
+         *
+         * @param lane the lane index, from 0 to N-1
+         */
+        virtual void process(unsigned lane) noexcept = 0;
+    };
+
+    RenderThreadPool();
+    ~RenderThreadPool();
+
+    RenderThreadPool(const RenderThreadPool&) = delete;
+    RenderThreadPool& operator=(const RenderThreadPool&) = delete;
+
+    /**
+     * @brief Change the number of lanes, including the calling thread.
+     * This starts or stops worker threads; do not call it from the RT thread,
+     * nor while `run` is executing.
+     *
+     * @param numLanes the number of lanes, at least 1
+     */
+    void setNumLanes(unsigned numLanes);
+
+    /**
+     * @brief Get the number of lanes, including the calling thread.
+     */
+    unsigned getNumLanes() const noexcept { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    /**
+     * @brief Run the job on all the lanes, and wait until all of them are
+     * done. Lane 0 is processed on the calling thread.
+     *
+     * @param job the job to process
+     */
+    void run(Job& job) noexcept;
+
+    /**
+     * @brief Get the lane of the current thread.
+     * Threads which do not belong to any pool are on lane 0.
+     */
+    static unsigned currentLane() noexcept;
+
+private:
+    struct Worker {
+        std::thread thread;
+        RTSemaphore semStart;
+    };
+
+    void workerProc(Worker& worker, unsigned lane);
+    static void raiseCurrentThreadPriority(unsigned lane) noexcept;
+    void stopWorkers();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    RTSemaphore semDone_;
+    Job* currentJob_ { nullptr };
+    std::atomic<bool> quit_ { false };
+};
+
+} // namespace sfz
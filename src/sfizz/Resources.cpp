@@ -14,7 +14,13 @@
 #include "Tuning.h"
 #include "BeatClock.h"
 #include "Metronome.h"
+#include "RenderThreadPool.h"
+#include "VoicePools.h"
+#include "FilterTables.h"
 #include "modulations/ModMatrix.h"
+#include <absl/memory/memory.h>
+#include <algorithm>
+#include <vector>
 
 namespace sfz {
 
@@ -30,6 +36,14 @@ struct Resources::Impl {
     ModMatrix modMatrix;
     BeatClock beatClock;
     Metronome metronome;
+    VoicePools voicePools;
+    std::vector<std::unique_ptr<BufferPool>> laneBufferPools;
+    FilterCoefficientCache filterCache;
+    std::vector<std::unique_ptr<FilterCoefficientCache>> laneFilterCaches;
+    int samplesPerBlock { config::defaultSamplesPerBlock };
+    int numBuffers { config::bufferPoolSize };
+    int numStereoBuffers { config::stereoBufferPoolSize };
+    int numIndexBuffers { config::indexBufferPoolSize };
 };
 
 Resources::Resources()
@@ -48,17 +62,88 @@ void Resources::setSampleRate(float samplerate)
     impl.modMatrix.setSampleRate(samplerate);
     impl.beatClock.setSampleRate(samplerate);
     impl.metronome.init(samplerate);
+    impl.filePool.setSampleRate(samplerate);
+    impl.voicePools.setSampleRate(samplerate);
 }
 
 void Resources::setSamplesPerBlock(int samplesPerBlock)
 {
     Impl& impl = *impl_;
+    impl.samplesPerBlock = samplesPerBlock;
     impl.bufferPool.setBufferSize(samplesPerBlock);
+    for (auto& pool : impl.laneBufferPools)
+        pool->setBufferSize(samplesPerBlock);
     impl.midiState.setSamplesPerBlock(samplesPerBlock);
     impl.modMatrix.setSamplesPerBlock(samplesPerBlock);
     impl.beatClock.setSamplesPerBlock(samplesPerBlock);
 }
 
+void Resources::setNumLanes(unsigned numLanes)
+{
+    Impl& impl = *impl_;
+    ASSERT(numLanes > 0);
+    const size_t numExtraLanes = numLanes - 1;
+
+    impl.laneBufferPools.resize(numExtraLanes);
+    for (auto& pool : impl.laneBufferPools) {
+        if (!pool) {
+            pool = absl::make_unique<BufferPool>();
+            pool->setNumBuffers(impl.numBuffers, impl.numStereoBuffers, impl.numIndexBuffers);
+            pool->setBufferSize(impl.samplesPerBlock);
+        }
+    }
+
+    impl.laneFilterCaches.resize(numExtraLanes);
+    for (auto& cache : impl.laneFilterCaches) {
+        if (!cache)
+            cache = absl::make_unique<FilterCoefficientCache>();
+    }
+    impl.modMatrix.setNumLanes(numLanes);
+}
+
+void Resources::setBufferPoolSizes(int numBuffers, int numStereoBuffers, int numIndexBuffers)
+{
+    Impl& impl = *impl_;
+    impl.numBuffers = numBuffers;
+    impl.numStereoBuffers = numStereoBuffers;
+    impl.numIndexBuffers = numIndexBuffers;
+    impl.bufferPool.setNumBuffers(numBuffers, numStereoBuffers, numIndexBuffers);
+    for (auto& pool : impl.laneBufferPools)
+        pool->setNumBuffers(numBuffers, numStereoBuffers, numIndexBuffers);
+}
+
+BufferPoolStats Resources::getBufferPoolStats() const noexcept
+{
+    const Impl& impl = *impl_;
+    BufferPoolStats stats = impl.bufferPool.getStats();
+    for (const auto& pool : impl.laneBufferPools) {
+        const BufferPoolStats laneStats = pool->getStats();
+        stats.maxBuffersUsed = std::max(stats.maxBuffersUsed, laneStats.maxBuffersUsed);
+        stats.maxStereoBuffersUsed = std::max(stats.maxStereoBuffersUsed, laneStats.maxStereoBuffersUsed);
+        stats.maxIndexBuffersUsed = std::max(stats.maxIndexBuffersUsed, laneStats.maxIndexBuffersUsed);
+        stats.numBufferFailures += laneStats.numBufferFailures;
+        stats.numStereoBufferFailures += laneStats.numStereoBufferFailures;
+        stats.numIndexBufferFailures += laneStats.numIndexBufferFailures;
+    }
+    return stats;
+}
+
+void Resources::resetBufferPoolStats() noexcept
+{
+    Impl& impl = *impl_;
+    impl.bufferPool.resetStats();
+    for (auto& pool : impl.laneBufferPools)
+        pool->resetStats();
+}
+
+void Resources::clearFilterCoefficientCaches() noexcept
+{
+    Impl& impl = *impl_;
+    impl.filterCache.clear();
+    for (auto& cache : impl.laneFilterCaches)
+        cache->clear();
+}
+
 void Resources::clearNonState()
 {
     Impl& impl = *impl_;
@@ -66,6 +151,7 @@ void Resources::clearNonState()
     impl.filePool.clear();
     impl.wavePool.clearFileWaves();
     impl.modMatrix.clear();
+    impl.beatClock.clearConsumers();
     impl.metronome.clear();
 }
 
@@ -84,7 +170,22 @@ const SynthConfig& Resources::getSynthConfig() const noexcept
 
 const BufferPool& Resources::getBufferPool() const noexcept
 {
-    return impl_->bufferPool;
+    const unsigned lane = RenderThreadPool::currentLane();
+    if (lane == 0)
+        return impl_->bufferPool;
+
+    ASSERT(lane - 1 < impl_->laneBufferPools.size());
+    return *impl_->laneBufferPools[lane - 1];
+}
+
+const FilterCoefficientCache& Resources::getFilterCoefficientCache() const noexcept
+{
+    const unsigned lane = RenderThreadPool::currentLane();
+    if (lane == 0)
+        return impl_->filterCache;
+
+    ASSERT(lane - 1 < impl_->laneFilterCaches.size());
+    return *impl_->laneFilterCaches[lane - 1];
 }
 
 const MidiState& Resources::getMidiState() const noexcept
@@ -133,4 +234,9 @@ const Metronome& Resources::getMetronome() const noexcept
     return impl_->metronome;
 }
 
+const VoicePools& Resources::getVoicePools() const noexcept
+{
+    return impl_->voicePools;
+}
+
 } // namespace sfz
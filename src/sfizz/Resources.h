@@ -12,6 +12,7 @@ namespace sfz {
 
 struct SynthConfig;
 class BufferPool;
+struct BufferPoolStats;
 class MidiState;
 class CurveSet;
 class FilePool;
@@ -21,6 +22,8 @@ class StretchTuning;
 class ModMatrix;
 class BeatClock;
 class Metronome;
+class VoicePools;
+class FilterCoefficientCache;
 
 class Resources
 {
@@ -30,6 +33,39 @@ public:
 
     void setSampleRate(float samplerate);
     void setSamplesPerBlock(int samplesPerBlock);
+    /**
+     * @brief Set the number of render lanes, which process voices concurrently.
+     * Each lane has its own buffer pool and modulation context, which are
+     * selected according to the lane of the calling thread.
+     *
+     * @param numLanes
+     */
+    void setNumLanes(unsigned numLanes);
+    /**
+     * @brief Set the number of buffers of each kind in the buffer pools of
+     * all the lanes. No buffer must be held while calling this.
+     *
+     * @param numBuffers
+     * @param numStereoBuffers
+     * @param numIndexBuffers
+     */
+    void setBufferPoolSizes(int numBuffers, int numStereoBuffers, int numIndexBuffers);
+    /**
+     * @brief Get the use of the buffer pools of all the lanes, the highest
+     * of the high-water marks and the sum of the failures.
+     *
+     * @return BufferPoolStats
+     */
+    BufferPoolStats getBufferPoolStats() const noexcept;
+    /**
+     * @brief Reset the statistics of the buffer pools of all the lanes.
+     */
+    void resetBufferPoolStats() noexcept;
+    /**
+     * @brief Clear the filter coefficient caches of all the lanes, at the
+     * start of a block.
+     */
+    void clearFilterCoefficientCaches() noexcept;
     /**
      * @brief Clear resources that are related to a currently loaded SFZ file
      *
@@ -57,6 +93,8 @@ public:
     ACCESSOR_RW(getModMatrix, ModMatrix);
     ACCESSOR_RW(getBeatClock, BeatClock);
     ACCESSOR_RW(getMetronome, Metronome);
+    ACCESSOR_RW(getVoicePools, VoicePools);
+    ACCESSOR_RW(getFilterCoefficientCache, FilterCoefficientCache);
 
     #undef ACCESSOR_RW
 
@@ -14,6 +14,8 @@
    - SFIZZ_HAVE_SSE
    - SFIZZ_HAVE_SSE2
    - SFIZZ_HAVE_AVX
+   - SFIZZ_HAVE_AVX2
+   - SFIZZ_HAVE_FMA
    - SFIZZ_HAVE_NEON
  */
 
@@ -61,6 +63,20 @@
 // TODO: how to check for NEON on MSVC ARM?
 #endif
 
+#if defined(__GNUC__) || defined(_MSC_VER)
+#   if defined(__AVX2__)
+#       define SFIZZ_DETECT_AVX2 1
+#   else
+#       define SFIZZ_DETECT_AVX2 0
+#   endif
+// MSVC has no macro of its own for FMA, which comes with /arch:AVX2
+#   if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+#       define SFIZZ_DETECT_FMA 1
+#   else
+#       define SFIZZ_DETECT_FMA 0
+#   endif
+#endif
+
 #ifndef SFIZZ_HAVE_SSE
 #   ifdef SFIZZ_DETECT_SSE
 #       define SFIZZ_HAVE_SSE SFIZZ_DETECT_SSE
@@ -82,6 +98,20 @@
 #       define SFIZZ_HAVE_AVX 0
 #   endif
 #endif
+#ifndef SFIZZ_HAVE_AVX2
+#   ifdef SFIZZ_DETECT_AVX2
+#       define SFIZZ_HAVE_AVX2 SFIZZ_DETECT_AVX2
+#   else
+#       define SFIZZ_HAVE_AVX2 0
+#   endif
+#endif
+#ifndef SFIZZ_HAVE_FMA
+#   ifdef SFIZZ_DETECT_FMA
+#       define SFIZZ_HAVE_FMA SFIZZ_DETECT_FMA
+#   else
+#       define SFIZZ_HAVE_FMA 0
+#   endif
+#endif
 #ifndef SFIZZ_HAVE_NEON
 #   ifdef SFIZZ_DETECT_NEON
 #       define SFIZZ_HAVE_NEON SFIZZ_DETECT_NEON
@@ -9,26 +9,48 @@
 #include "utility/Debug.h"
 #include "simd/HelpersSSE.h"
 #include "simd/HelpersAVX.h"
+#include "simd/HelpersNEON.h"
+#include "Buffer.h"
+#include "utility/Timing.h"
 #include "cpuid/cpuinfo.hpp"
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_split.h>
+#include <algorithm>
 #include <array>
+#include <limits>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace sfz {
 
+struct CalibrationBuffers;
+
 template <class T>
 struct SIMDDispatch {
     constexpr SIMDDispatch() = default;
     void resetStatus();
     bool getStatus(SIMDOps op) const;
     void setStatus(SIMDOps op, bool enable);
+    bool setBackend(SIMDOps op, SIMDBackend backend);
+    SIMDBackend getBackend(SIMDOps op) const;
+    void calibrate();
+    void resetCalibration();
+    std::string saveBackends() const;
+    bool loadBackends(absl::string_view text);
+    static bool dispatched(SIMDOps op);
 
     decltype(&writeInterleavedScalar<T>) writeInterleaved = &writeInterleavedScalar<T>;
+    decltype(&addInterleavedScalar<T>) addInterleaved = &addInterleavedScalar<T>;
     decltype(&readInterleavedScalar<T>) readInterleaved = &readInterleavedScalar<T>;
+    decltype(&readInterleavedInt16Scalar<T>) readInterleavedInt16 = &readInterleavedInt16Scalar<T>;
+    decltype(&readInterleavedInt24Scalar<T>) readInterleavedInt24 = &readInterleavedInt24Scalar<T>;
     decltype(&gainScalar<T>) gain = &gainScalar<T>;
     decltype(&gain1Scalar<T>) gain1 = &gain1Scalar<T>;
     decltype(&divideScalar<T>) divide = &divideScalar<T>;
     decltype(&multiplyAddScalar<T>) multiplyAdd = &multiplyAddScalar<T>;
     decltype(&multiplyAdd1Scalar<T>) multiplyAdd1 = &multiplyAdd1Scalar<T>;
+    decltype(&multiplyAdd1MultiScalar<T>) multiplyAdd1Multi = &multiplyAdd1MultiScalar<T>;
     decltype(&multiplyMulScalar<T>) multiplyMul = &multiplyMulScalar<T>;
     decltype(&multiplyMul1Scalar<T>) multiplyMul1 = &multiplyMul1Scalar<T>;
     decltype(&linearRampScalar<T>) linearRamp = &linearRampScalar<T>;
@@ -44,12 +66,81 @@ struct SIMDDispatch {
     decltype(&sumSquaresScalar<T>) sumSquares = &sumSquaresScalar<T>;
     decltype(&clampAllScalar<T>) clampAll = &clampAllScalar<T>;
     decltype(&allWithinScalar<T>) allWithin = &allWithinScalar<T>;
+    decltype(&centsFactorScalar<T>) centsFactor = &centsFactorScalar<T>;
+    decltype(&db2magScalar<T>) db2mag = &db2magScalar<T>;
+    decltype(&interpolationPositionsScalar<T>) interpolationPositions = &interpolationPositionsScalar<T>;
 
 private:
+    bool selected(SIMDOps op, SIMDBackend backend);
+    uint64_t timeOp(SIMDOps op, CalibrationBuffers& buffers) const;
     std::array<bool, static_cast<unsigned>(SIMDOps::_sentinel)> simdStatus;
+    std::array<SIMDBackend, static_cast<unsigned>(SIMDOps::_sentinel)> simdBackends {};
+    std::array<SIMDBackend, static_cast<unsigned>(SIMDOps::_sentinel)> calibration {};
+    bool calibrated { false };
     cpuid::cpuinfo info;
 };
 
+static const char* const simdOpNames[] = {
+    "writeInterleaved",
+    "addInterleaved",
+    "readInterleaved",
+    "readInterleavedInt16",
+    "readInterleavedInt24",
+    "fill",
+    "gain",
+    "gain1",
+    "divide",
+    "linearRamp",
+    "multiplicativeRamp",
+    "add",
+    "add1",
+    "subtract",
+    "subtract1",
+    "multiplyAdd",
+    "multiplyAdd1",
+    "multiplyAdd1Multi",
+    "multiplyMul",
+    "multiplyMul1",
+    "copy",
+    "cumsum",
+    "diff",
+    "sfzInterpolationCast",
+    "mean",
+    "sumSquares",
+    "upsampling",
+    "clampAll",
+    "allWithin",
+    "centsFactor",
+    "db2mag",
+    "interpolationPositions",
+};
+
+static const char* const simdBackendNames[] = {
+    "scalar",
+    "sse",
+    "avx",
+    "neon",
+};
+
+static_assert(sizeof(simdOpNames) / sizeof(simdOpNames[0]) == static_cast<unsigned>(SIMDOps::_sentinel),
+    "Missing names of operations");
+static_assert(sizeof(simdBackendNames) / sizeof(simdBackendNames[0]) == static_cast<unsigned>(SIMDBackend::_sentinel),
+    "Missing names of backends");
+
+const char* simdOpName(SIMDOps op) noexcept
+{
+    const unsigned index = static_cast<unsigned>(op);
+    ASSERT(index < static_cast<unsigned>(SIMDOps::_sentinel));
+    return simdOpNames[index];
+}
+
+const char* simdBackendName(SIMDBackend backend) noexcept
+{
+    const unsigned index = static_cast<unsigned>(backend);
+    ASSERT(index < static_cast<unsigned>(SIMDBackend::_sentinel));
+    return simdBackendNames[index];
+}
+
 
 template <>
 bool SIMDDispatch<float>::getStatus(SIMDOps op) const
@@ -60,18 +151,70 @@ bool SIMDDispatch<float>::getStatus(SIMDOps op) const
 }
 
 template <>
-void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
+bool SIMDDispatch<float>::dispatched(SIMDOps op)
+{
+#define SIMD_OP(opname) case SIMDOps::opname : return true;
+    switch (op) {
+        default: break;
+        SIMD_OP(writeInterleaved)
+        SIMD_OP(addInterleaved)
+        SIMD_OP(readInterleaved)
+        SIMD_OP(readInterleavedInt16)
+        SIMD_OP(readInterleavedInt24)
+        SIMD_OP(gain)
+        SIMD_OP(gain1)
+        SIMD_OP(divide)
+        SIMD_OP(linearRamp)
+        SIMD_OP(multiplicativeRamp)
+        SIMD_OP(add)
+        SIMD_OP(add1)
+        SIMD_OP(subtract)
+        SIMD_OP(subtract1)
+        SIMD_OP(multiplyAdd)
+        SIMD_OP(multiplyAdd1)
+        SIMD_OP(multiplyAdd1Multi)
+        SIMD_OP(multiplyMul)
+        SIMD_OP(multiplyMul1)
+        SIMD_OP(copy)
+        SIMD_OP(cumsum)
+        SIMD_OP(diff)
+        SIMD_OP(mean)
+        SIMD_OP(sumSquares)
+        SIMD_OP(clampAll)
+        SIMD_OP(allWithin)
+        SIMD_OP(centsFactor)
+        SIMD_OP(db2mag)
+        SIMD_OP(interpolationPositions)
+    }
+#undef SIMD_OP
+    return false;
+}
+
+template <>
+bool SIMDDispatch<float>::selected(SIMDOps op, SIMDBackend backend)
+{
+    const unsigned index = static_cast<unsigned>(op);
+    simdBackends[index] = backend;
+    simdStatus[index] = backend != SIMDBackend::scalar;
+    return true;
+}
+
+template <>
+bool SIMDDispatch<float>::setBackend(SIMDOps op, SIMDBackend backend)
 {
     const unsigned index = static_cast<unsigned>(op);
     ASSERT(index < simdStatus.size());
-    simdStatus[index] = enable;
 
-    if (!enable) {
-#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## Scalar<float>; return;
+    switch (backend) {
+    case SIMDBackend::scalar:
+#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## Scalar<float>; return selected(op, backend);
         switch (op) {
             default: break;
             SIMD_OP(writeInterleaved)
+            SIMD_OP(addInterleaved)
             SIMD_OP(readInterleaved)
+            SIMD_OP(readInterleavedInt16)
+            SIMD_OP(readInterleavedInt24)
             SIMD_OP(gain)
             SIMD_OP(gain1)
             SIMD_OP(divide)
@@ -83,6 +226,7 @@ void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
             SIMD_OP(subtract1)
             SIMD_OP(multiplyAdd)
             SIMD_OP(multiplyAdd1)
+            SIMD_OP(multiplyAdd1Multi)
             SIMD_OP(multiplyMul)
             SIMD_OP(multiplyMul1)
             SIMD_OP(copy)
@@ -92,66 +236,151 @@ void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
             SIMD_OP(sumSquares)
             SIMD_OP(clampAll)
             SIMD_OP(allWithin)
+            SIMD_OP(centsFactor)
+            SIMD_OP(db2mag)
+            SIMD_OP(interpolationPositions)
         }
 #undef SIMD_OP
-    }
+        break;
 
+    case SIMDBackend::avx:
 #if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
-#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## AVX; return;
-    if (info.has_avx()) {
-        switch (op) {
-            default: break;
+#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## AVX; return selected(op, backend);
+        if (helpersAVXAvailable() && info.has_avx2() && info.has_fma3()) {
+            switch (op) {
+                default: break;
+                SIMD_OP(writeInterleaved)
+                SIMD_OP(addInterleaved)
+                SIMD_OP(readInterleaved)
+                SIMD_OP(readInterleavedInt16)
+                SIMD_OP(readInterleavedInt24)
+                SIMD_OP(gain)
+                SIMD_OP(gain1)
+                SIMD_OP(divide)
+                SIMD_OP(linearRamp)
+                SIMD_OP(multiplicativeRamp)
+                SIMD_OP(add)
+                SIMD_OP(add1)
+                SIMD_OP(subtract)
+                SIMD_OP(subtract1)
+                SIMD_OP(multiplyAdd)
+                SIMD_OP(multiplyAdd1)
+                SIMD_OP(multiplyAdd1Multi)
+                SIMD_OP(multiplyMul)
+                SIMD_OP(multiplyMul1)
+                SIMD_OP(copy)
+                SIMD_OP(cumsum)
+                SIMD_OP(diff)
+                SIMD_OP(mean)
+                SIMD_OP(sumSquares)
+                SIMD_OP(clampAll)
+                SIMD_OP(allWithin)
+                SIMD_OP(centsFactor)
+                SIMD_OP(db2mag)
+                SIMD_OP(interpolationPositions)
+            }
         }
-    }
 #undef SIMD_OP
+#endif // SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+        break;
 
-#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## SSE; return;
-    if (info.has_sse()) {
-        switch (op) {
-            default: break;
-            SIMD_OP(writeInterleaved)
-            SIMD_OP(readInterleaved)
-            SIMD_OP(gain)
-            SIMD_OP(gain1)
-            SIMD_OP(divide)
-            SIMD_OP(linearRamp)
-            SIMD_OP(multiplicativeRamp)
-            SIMD_OP(add)
-            SIMD_OP(add1)
-            SIMD_OP(subtract)
-            SIMD_OP(subtract1)
-            SIMD_OP(multiplyAdd)
-            SIMD_OP(multiplyAdd1)
-            SIMD_OP(multiplyMul)
-            SIMD_OP(multiplyMul1)
-            SIMD_OP(copy)
-            SIMD_OP(cumsum)
-            SIMD_OP(diff)
-            SIMD_OP(mean)
-            SIMD_OP(sumSquares)
-            SIMD_OP(clampAll)
-            SIMD_OP(allWithin)
+    case SIMDBackend::sse:
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## SSE; return selected(op, backend);
+        if (info.has_sse()) {
+            switch (op) {
+                default: break;
+                SIMD_OP(writeInterleaved)
+                SIMD_OP(addInterleaved)
+                SIMD_OP(readInterleaved)
+                SIMD_OP(readInterleavedInt16)
+                SIMD_OP(readInterleavedInt24)
+                SIMD_OP(gain)
+                SIMD_OP(gain1)
+                SIMD_OP(divide)
+                SIMD_OP(linearRamp)
+                SIMD_OP(multiplicativeRamp)
+                SIMD_OP(add)
+                SIMD_OP(add1)
+                SIMD_OP(subtract)
+                SIMD_OP(subtract1)
+                SIMD_OP(multiplyAdd)
+                SIMD_OP(multiplyAdd1)
+                SIMD_OP(multiplyAdd1Multi)
+                SIMD_OP(multiplyMul)
+                SIMD_OP(multiplyMul1)
+                SIMD_OP(copy)
+                SIMD_OP(cumsum)
+                SIMD_OP(diff)
+                SIMD_OP(mean)
+                SIMD_OP(sumSquares)
+                SIMD_OP(clampAll)
+                SIMD_OP(allWithin)
+                SIMD_OP(centsFactor)
+                SIMD_OP(db2mag)
+                SIMD_OP(interpolationPositions)
+            }
         }
-    }
 #undef SIMD_OP
 #endif // SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+        break;
 
+    case SIMDBackend::neon:
 #if SFIZZ_CPU_FAMILY_AARCH64 || SFIZZ_CPU_FAMILY_ARM
-#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## NEON; return;
-    if (info.has_neon()) {
-        switch (op) {
-            default: break;
+#define SIMD_OP(opname) case SIMDOps::opname : (opname) = opname ## NEON; return selected(op, backend);
+        if (info.has_neon()) {
+            switch (op) {
+                default: break;
+                SIMD_OP(readInterleavedInt16)
+            }
         }
-    }
 #undef SIMD_OP
 #endif // SFIZZ_CPU_FAMILY_AARCH64 || SFIZZ_CPU_FAMILY_ARM
+        break;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+template <>
+SIMDBackend SIMDDispatch<float>::getBackend(SIMDOps op) const
+{
+    const unsigned index = static_cast<unsigned>(op);
+    ASSERT(index < simdBackends.size());
+    return simdBackends[index];
+}
+
+template <>
+void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
+{
+    const unsigned index = static_cast<unsigned>(op);
+    ASSERT(index < simdStatus.size());
+
+    if (!enable)
+        setBackend(op, SIMDBackend::scalar);
+    else {
+        // The widest instructions first
+        for (SIMDBackend backend : { SIMDBackend::avx, SIMDBackend::sse, SIMDBackend::neon }) {
+            if (setBackend(op, backend))
+                break;
+        }
+    }
+
+    // The operations which are not dispatched keep their status too
+    simdStatus[index] = enable;
 }
 
 template <>
 void SIMDDispatch<float>::resetStatus()
 {
     setStatus(SIMDOps::writeInterleaved, false);
+    setStatus(SIMDOps::addInterleaved, false);
     setStatus(SIMDOps::readInterleaved, false);
+    setStatus(SIMDOps::readInterleavedInt16, true);
+    setStatus(SIMDOps::readInterleavedInt24, true);
     setStatus(SIMDOps::fill, true);
     setStatus(SIMDOps::gain, true);
     setStatus(SIMDOps::gain1, true);
@@ -164,6 +393,7 @@ void SIMDDispatch<float>::resetStatus()
     setStatus(SIMDOps::subtract1, false);
     setStatus(SIMDOps::multiplyAdd, false);
     setStatus(SIMDOps::multiplyAdd1, false);
+    setStatus(SIMDOps::multiplyAdd1Multi, true);
     setStatus(SIMDOps::multiplyMul, false);
     setStatus(SIMDOps::multiplyMul1, false);
     setStatus(SIMDOps::copy, false);
@@ -175,6 +405,216 @@ void SIMDDispatch<float>::resetStatus()
     setStatus(SIMDOps::upsampling, true);
     setStatus(SIMDOps::clampAll, false);
     setStatus(SIMDOps::allWithin, true);
+    setStatus(SIMDOps::centsFactor, true);
+    setStatus(SIMDOps::db2mag, true);
+    setStatus(SIMDOps::interpolationPositions, true);
+
+    if (calibrated) {
+        for (unsigned i = 0; i < calibration.size(); ++i) {
+            const auto op = static_cast<SIMDOps>(i);
+            if (dispatched(op))
+                setBackend(op, calibration[i]);
+        }
+    }
+}
+
+/**
+ * @brief The inputs and outputs of the calibration, with values in the usual
+ * ranges of each operation
+ */
+struct CalibrationBuffers {
+    static constexpr unsigned maxSize { 256 };
+
+    CalibrationBuffers()
+        : signal(maxSize), gains(maxSize), cents(maxSize), decibels(maxSize),
+          output(maxSize), output2(maxSize), interleaved(2 * maxSize),
+          interleavedInt16(2 * maxSize), interleavedInt24(6 * maxSize), indices(maxSize)
+    {
+        for (unsigned i = 0; i < maxSize; ++i) {
+            const float x = static_cast<float>(i) / maxSize;
+            signal[i] = 2.0f * x - 1.0f;
+            gains[i] = 0.5f + 0.5f * x;
+            cents[i] = 2400.0f * x - 1200.0f;
+            decibels[i] = 72.0f * x - 60.0f;
+        }
+        std::fill(interleaved.begin(), interleaved.end(), 0.5f);
+        std::fill(interleavedInt16.begin(), interleavedInt16.end(), int16_t { 0x4000 });
+        std::fill(interleavedInt24.begin(), interleavedInt24.end(), uint8_t { 0x40 });
+    }
+
+    Buffer<float> signal;
+    Buffer<float> gains;
+    Buffer<float> cents;
+    Buffer<float> decibels;
+    Buffer<float> output;
+    Buffer<float> output2;
+    Buffer<float> interleaved;
+    Buffer<int16_t> interleavedInt16;
+    Buffer<uint8_t> interleavedInt24;
+    Buffer<int> indices;
+};
+
+template <>
+uint64_t SIMDDispatch<float>::timeOp(SIMDOps op, CalibrationBuffers& buffers) const
+{
+    // The sizes of the blocks of the voices
+    constexpr unsigned sizes[] { 64, CalibrationBuffers::maxSize };
+    constexpr unsigned numRounds { 8 };
+    constexpr unsigned numRuns { 16 };
+
+    float* const outputs[] { buffers.output.data(), buffers.output2.data() };
+    volatile float sink = 0.0f;
+
+    auto run = [&](unsigned size) {
+        switch (op) {
+        default: break;
+        case SIMDOps::writeInterleaved: writeInterleaved(buffers.signal.data(), buffers.gains.data(), buffers.interleaved.data(), 2 * size); break;
+        case SIMDOps::addInterleaved: addInterleaved(buffers.signal.data(), buffers.gains.data(), buffers.interleaved.data(), 2 * size); break;
+        case SIMDOps::readInterleaved: readInterleaved(buffers.interleaved.data(), outputs[0], outputs[1], 2 * size); break;
+        case SIMDOps::readInterleavedInt16: readInterleavedInt16(buffers.interleavedInt16.data(), outputs[0], outputs[1], 2 * size); break;
+        case SIMDOps::readInterleavedInt24: readInterleavedInt24(buffers.interleavedInt24.data(), outputs[0], outputs[1], 2 * size); break;
+        case SIMDOps::gain: gain(buffers.gains.data(), buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::gain1: gain1(0.5f, buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::divide: divide(buffers.signal.data(), buffers.gains.data(), outputs[0], size); break;
+        case SIMDOps::linearRamp: sink = linearRamp(outputs[0], 0.0f, 1e-3f, size); break;
+        case SIMDOps::multiplicativeRamp: sink = multiplicativeRamp(outputs[0], 1.0f, 0.999f, size); break;
+        case SIMDOps::add: add(buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::add1: add1(0.5f, outputs[0], size); break;
+        case SIMDOps::subtract: subtract(buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::subtract1: subtract1(0.5f, outputs[0], size); break;
+        case SIMDOps::multiplyAdd: multiplyAdd(buffers.gains.data(), buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::multiplyAdd1: multiplyAdd1(0.5f, buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::multiplyAdd1Multi: multiplyAdd1Multi(buffers.gains.data(), buffers.signal.data(), outputs, 2, size); break;
+        case SIMDOps::multiplyMul: multiplyMul(buffers.gains.data(), buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::multiplyMul1: multiplyMul1(0.5f, buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::copy: copy(buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::cumsum: cumsum(buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::diff: diff(buffers.signal.data(), outputs[0], size); break;
+        case SIMDOps::mean: sink = mean(buffers.signal.data(), size); break;
+        case SIMDOps::sumSquares: sink = sumSquares(buffers.signal.data(), size); break;
+        case SIMDOps::clampAll: clampAll(outputs[0], -1.0f, 1.0f, size); break;
+        case SIMDOps::allWithin: sink = allWithin(buffers.signal.data(), -1.0f, 1.0f, size); break;
+        case SIMDOps::centsFactor: centsFactor(buffers.cents.data(), outputs[0], size); break;
+        case SIMDOps::db2mag: db2mag(buffers.decibels.data(), outputs[0], size); break;
+        case SIMDOps::interpolationPositions: interpolationPositions(buffers.cents.data(), 1.0f, 0, buffers.indices.data(), outputs[0], size); break;
+        }
+    };
+
+    // The best round of each size, against the interruptions
+    uint64_t total = 0;
+    for (unsigned size : sizes) {
+        // The outputs of the ramps and sums stay bounded over the runs
+        std::fill(outputs[0], outputs[0] + size, 0.0f);
+        std::fill(outputs[1], outputs[1] + size, 0.0f);
+        run(size);
+        uint64_t best = std::numeric_limits<uint64_t>::max();
+        for (unsigned round = 0; round < numRounds; ++round) {
+            const uint64_t start = CycleClock::now();
+            for (unsigned i = 0; i < numRuns; ++i)
+                run(size);
+            best = std::min(best, CycleClock::now() - start);
+            std::fill(outputs[0], outputs[0] + size, 0.0f);
+            std::fill(outputs[1], outputs[1] + size, 0.0f);
+        }
+        total += best;
+    }
+
+    (void)sink;
+    return total;
+}
+
+template <>
+void SIMDDispatch<float>::calibrate()
+{
+    CalibrationBuffers buffers;
+    for (unsigned i = 0; i < simdBackends.size(); ++i) {
+        const auto op = static_cast<SIMDOps>(i);
+        if (!dispatched(op))
+            continue;
+
+        // The current kernel stays unless another one is faster, which keeps
+        // the defaults where the clock does not count
+        SIMDBackend bestBackend = simdBackends[i];
+        uint64_t bestTime = timeOp(op, buffers);
+        for (unsigned b = 0; b < static_cast<unsigned>(SIMDBackend::_sentinel); ++b) {
+            const auto backend = static_cast<SIMDBackend>(b);
+            if (backend == bestBackend || !setBackend(op, backend))
+                continue;
+            const uint64_t time = timeOp(op, buffers);
+            if (time < bestTime) {
+                bestTime = time;
+                bestBackend = backend;
+            }
+        }
+
+        setBackend(op, bestBackend);
+        calibration[i] = bestBackend;
+    }
+
+    calibrated = true;
+}
+
+template <>
+void SIMDDispatch<float>::resetCalibration()
+{
+    calibrated = false;
+}
+
+template <>
+std::string SIMDDispatch<float>::saveBackends() const
+{
+    std::string text;
+    for (unsigned i = 0; i < simdBackends.size(); ++i) {
+        const auto op = static_cast<SIMDOps>(i);
+        if (!dispatched(op))
+            continue;
+        text.append(simdOpName(op));
+        text.push_back(' ');
+        text.append(simdBackendName(simdBackends[i]));
+        text.push_back('\n');
+    }
+    return text;
+}
+
+template <>
+bool SIMDDispatch<float>::loadBackends(absl::string_view text)
+{
+    auto findName = [](absl::string_view name, const char* const names[], unsigned numNames) -> int {
+        for (unsigned i = 0; i < numNames; ++i) {
+            if (name == names[i])
+                return static_cast<int>(i);
+        }
+        return -1;
+    };
+
+    std::vector<std::pair<SIMDOps, SIMDBackend>> entries;
+    for (absl::string_view line : absl::StrSplit(text, '\n', absl::SkipWhitespace())) {
+        const std::vector<absl::string_view> fields = absl::StrSplit(line, ' ', absl::SkipWhitespace());
+        if (fields.size() != 2)
+            return false;
+        const int opIndex = findName(absl::StripAsciiWhitespace(fields[0]), simdOpNames, static_cast<unsigned>(SIMDOps::_sentinel));
+        const int backendIndex = findName(absl::StripAsciiWhitespace(fields[1]), simdBackendNames, static_cast<unsigned>(SIMDBackend::_sentinel));
+        if (opIndex < 0 || backendIndex < 0 || !dispatched(static_cast<SIMDOps>(opIndex)))
+            return false;
+        entries.emplace_back(static_cast<SIMDOps>(opIndex), static_cast<SIMDBackend>(backendIndex));
+    }
+
+    const auto previousBackends = simdBackends;
+    const auto previousStatus = simdStatus;
+    for (const auto& entry : entries) {
+        if (!setBackend(entry.first, entry.second)) {
+            for (unsigned i = 0; i < previousBackends.size(); ++i) {
+                if (dispatched(static_cast<SIMDOps>(i)))
+                    setBackend(static_cast<SIMDOps>(i), previousBackends[i]);
+            }
+            simdStatus = previousStatus;
+            return false;
+        }
+    }
+
+    calibration = simdBackends;
+    calibrated = true;
+    return true;
 }
 
 ///
@@ -204,6 +644,42 @@ bool getSIMDOpStatus<float>(SIMDOps op)
     return simdDispatch<float>().getStatus(op);
 }
 
+template<>
+bool setSIMDOpBackend<float>(SIMDOps op, SIMDBackend backend)
+{
+    return simdDispatch<float>().setBackend(op, backend);
+}
+
+template<>
+SIMDBackend getSIMDOpBackend<float>(SIMDOps op)
+{
+    return simdDispatch<float>().getBackend(op);
+}
+
+template<>
+void calibrateSIMDOps<float>()
+{
+    simdDispatch<float>().calibrate();
+}
+
+template<>
+void resetSIMDCalibration<float>()
+{
+    simdDispatch<float>().resetCalibration();
+}
+
+template<>
+std::string saveSIMDOpBackends<float>()
+{
+    return simdDispatch<float>().saveBackends();
+}
+
+template<>
+bool loadSIMDOpBackends<float>(absl::string_view text)
+{
+    return simdDispatch<float>().loadBackends(text);
+}
+
 void initializeSIMDDispatchers()
 {
     simdDispatch<float>().resetStatus();
@@ -216,11 +692,26 @@ void readInterleaved(const float* input, float* outputLeft, float* outputRight,
     return simdDispatch<float>().readInterleaved(input, outputLeft, outputRight, inputSize);
 }
 
+void readInterleavedInt16(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    return simdDispatch<float>().readInterleavedInt16(input, outputLeft, outputRight, inputSize);
+}
+
+void readInterleavedInt24(const uint8_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    return simdDispatch<float>().readInterleavedInt24(input, outputLeft, outputRight, inputSize);
+}
+
 void writeInterleaved(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept
 {
     return simdDispatch<float>().writeInterleaved(inputLeft, inputRight, output, outputSize);
 }
 
+void addInterleaved(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept
+{
+    return simdDispatch<float>().addInterleaved(inputLeft, inputRight, output, outputSize);
+}
+
 template <>
 void applyGain1<float>(float gain, const float* input, float* output, unsigned size) noexcept
 {
@@ -251,6 +742,12 @@ void multiplyAdd1<float>(float gain, const float* input, float* output, unsigned
     return simdDispatch<float>().multiplyAdd1(gain, input, output, size);
 }
 
+template <>
+void multiplyAdd1Multi<float>(const float* gains, const float* input, float* const outputs[], unsigned numOutputs, unsigned size) noexcept
+{
+    return simdDispatch<float>().multiplyAdd1Multi(gains, input, outputs, numOutputs, size);
+}
+
 template <>
 void multiplyMul<float>(const float* gain, const float* input, float* output, unsigned size) noexcept
 {
@@ -341,4 +838,22 @@ bool allWithin<float>(const float* input, float low, float high, unsigned size)
     return simdDispatch<float>().allWithin(input, low, high, size);
 }
 
+template <>
+void centsFactor<float>(const float* input, float* output, unsigned size) noexcept
+{
+    simdDispatch<float>().centsFactor(input, output, size);
+}
+
+template <>
+void db2mag<float>(const float* input, float* output, unsigned size) noexcept
+{
+    simdDispatch<float>().db2mag(input, output, size);
+}
+
+template <>
+int64_t interpolationPositions<float>(const float* pitch, float ratio, int64_t start, int* indices, float* coeffs, unsigned size) noexcept
+{
+    return simdDispatch<float>().interpolationPositions(pitch, ratio, start, indices, coeffs, size);
+}
+
 }
@@ -29,9 +29,12 @@
 #include "MathHelpers.h"
 #include "utility/Debug.h"
 #include "simd/HelpersScalar.h"
+#include <absl/strings/string_view.h>
 #include <absl/types/span.h>
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <string>
 
 namespace sfz {
 
@@ -40,7 +43,10 @@ namespace sfz {
 
 enum class SIMDOps {
     writeInterleaved,
+    addInterleaved,
     readInterleaved,
+    readInterleavedInt16,
+    readInterleavedInt24,
     fill,
     gain,
     gain1,
@@ -53,6 +59,7 @@ enum class SIMDOps {
     subtract1,
     multiplyAdd,
     multiplyAdd1,
+    multiplyAdd1Multi,
     multiplyMul,
     multiplyMul1,
     copy,
@@ -64,6 +71,9 @@ enum class SIMDOps {
     upsampling,
     clampAll,
     allWithin,
+    centsFactor,
+    db2mag,
+    interpolationPositions,
     _sentinel //
 };
 
@@ -90,6 +100,83 @@ void setSIMDOpStatus<float>(SIMDOps op, bool status);
 template<>
 bool getSIMDOpStatus<float>(SIMDOps op);
 
+// The instruction sets which the dispatched operations have kernels for
+enum class SIMDBackend {
+    scalar,
+    sse,
+    avx,
+    neon,
+    _sentinel //
+};
+
+// The names of the operations and backends, as saved by saveSIMDOpBackends
+const char* simdOpName(SIMDOps op) noexcept;
+const char* simdBackendName(SIMDBackend backend) noexcept;
+
+/**
+ * @brief Select the kernel of a dispatched operation by its backend.
+ *
+ * @return false if the operation is not dispatched, or if it has no kernel
+ *         for this backend on this machine; the selection is then unchanged.
+ */
+template<class T>
+bool setSIMDOpBackend(SIMDOps op, SIMDBackend backend);
+
+// The backend of the kernel selected for an operation
+template<class T>
+SIMDBackend getSIMDOpBackend(SIMDOps op);
+
+/**
+ * @brief Time the kernels of each dispatched operation over blocks of 64 and
+ * 256 frames, and select the fastest. This takes a few milliseconds; call it
+ * once at startup, outside of the RT thread.
+ *
+ * The selection becomes the calibration, which the resets of the status apply
+ * over the defaults until resetSIMDCalibration is called.
+ */
+template<class T>
+void calibrateSIMDOps();
+
+// Drop the calibration; the next reset goes back to the defaults
+template<class T>
+void resetSIMDCalibration();
+
+/**
+ * @brief Save the selected backends, one "operation backend" line per
+ * dispatched operation, to store a calibration between the runs.
+ */
+template<class T>
+std::string saveSIMDOpBackends();
+
+/**
+ * @brief Load backends saved with saveSIMDOpBackends, select them and keep
+ * them as the calibration.
+ *
+ * @return false, leaving everything unchanged, if a line does not parse or
+ *         names a backend which this machine does not have; the text was
+ *         saved on another machine, and the calibration should run again.
+ */
+template<class T>
+bool loadSIMDOpBackends(absl::string_view text);
+
+template<>
+bool setSIMDOpBackend<float>(SIMDOps op, SIMDBackend backend);
+
+template<>
+SIMDBackend getSIMDOpBackend<float>(SIMDOps op);
+
+template<>
+void calibrateSIMDOps<float>();
+
+template<>
+void resetSIMDCalibration<float>();
+
+template<>
+std::string saveSIMDOpBackends<float>();
+
+template<>
+bool loadSIMDOpBackends<float>(absl::string_view text);
+
 /**
  * @brief Read interleaved stereo data from a buffer and separate it in a left/right pair of buffers.
  *
@@ -109,6 +196,46 @@ inline void readInterleaved(absl::Span<const float> input, absl::Span<float> out
     readInterleaved(input.data(), outputLeft.data(), outputRight.data(), size);
 }
 
+/**
+ * @brief Read interleaved stereo 16-bit samples, and convert them into a
+ * left/right pair of float buffers in [-1, 1).
+ *
+ * @param input
+ * @param outputLeft
+ * @param outputRight
+ * @param inputSize the number of samples
+ */
+void readInterleavedInt16(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+
+inline void readInterleavedInt16(absl::Span<const int16_t> input, absl::Span<float> outputLeft, absl::Span<float> outputRight) noexcept
+{
+    // Something is fishy with the sizes
+    SFIZZ_CHECK(outputLeft.size() == input.size() / 2);
+    SFIZZ_CHECK(outputRight.size() == input.size() / 2);
+    const auto size = min(input.size(), 2 * outputLeft.size(), 2 * outputRight.size());
+    readInterleavedInt16(input.data(), outputLeft.data(), outputRight.data(), size);
+}
+
+/**
+ * @brief Read interleaved stereo 24-bit little-endian samples, packed in 3
+ * bytes, and convert them into a left/right pair of float buffers in [-1, 1).
+ *
+ * @param input
+ * @param outputLeft
+ * @param outputRight
+ * @param inputSize the number of samples, a third of the bytes
+ */
+void readInterleavedInt24(const uint8_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+
+inline void readInterleavedInt24(absl::Span<const uint8_t> input, absl::Span<float> outputLeft, absl::Span<float> outputRight) noexcept
+{
+    // Something is fishy with the sizes
+    SFIZZ_CHECK(outputLeft.size() == input.size() / 6);
+    SFIZZ_CHECK(outputRight.size() == input.size() / 6);
+    const auto size = min(input.size() / 3, 2 * outputLeft.size(), 2 * outputRight.size());
+    readInterleavedInt24(input.data(), outputLeft.data(), outputRight.data(), size);
+}
+
 /**
  * @brief Write a pair of left and right stereo input into a single buffer interleaved.
  *
@@ -128,6 +255,25 @@ inline void writeInterleaved(absl::Span<const float> inputLeft, absl::Span<const
     writeInterleaved(inputLeft.data(), inputRight.data(), output.data(), size);
 }
 
+/**
+ * @brief Add a pair of left and right stereo input into a single buffer interleaved.
+ *
+ * @param inputLeft
+ * @param inputRight
+ * @param output
+ * @param outputSize
+ */
+void addInterleaved(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept;
+
+inline void addInterleaved(absl::Span<const float> inputLeft, absl::Span<const float> inputRight, absl::Span<float> output) noexcept
+{
+    // Something is fishy with the sizes
+    SFIZZ_CHECK(inputLeft.size() == output.size() / 2);
+    SFIZZ_CHECK(inputRight.size() == output.size() / 2);
+    const auto size = min(output.size(), 2 * inputLeft.size(), 2 * inputRight.size());
+    addInterleaved(inputLeft.data(), inputRight.data(), output.data(), size);
+}
+
 /**
  * @brief Fill a buffer with a value
  *
@@ -325,6 +471,27 @@ void multiplyAdd1(T gain, absl::Span<const T> input, absl::Span<T> output) noexc
     multiplyAdd1<T>(gain, input.data(), output.data(), minSpanSize(input, output));
 }
 
+/**
+ * @brief Applies a gain per output to the input and add it on each of the
+ * outputs, reading the input once for all of them. The outputs must not
+ * overlap the input nor each other.
+ *
+ * @tparam T the underlying type
+ * @param gains the gain for each output
+ * @param input
+ * @param outputs
+ * @param numOutputs
+ * @param size
+ */
+template <class T>
+void multiplyAdd1Multi(const T* gains, const T* input, T* const outputs[], unsigned numOutputs, unsigned size) noexcept
+{
+    multiplyAdd1MultiScalar(gains, input, outputs, numOutputs, size);
+}
+
+template <>
+void multiplyAdd1Multi<float>(const float* gains, const float* input, float* const outputs[], unsigned numOutputs, unsigned size) noexcept;
+
 /**
  * @brief Applies a gain to the input and multiply the output with it
  *
@@ -753,4 +920,110 @@ bool allWithin(absl::Span<const T> input, T low, T high) noexcept
     return allWithin<T>(input.data(), low, high, input.size());
 }
 
+/**
+ * @brief Convert the values in cents into pitch ratios, as `centsFactor`
+ * does for a single value.
+ *
+ * The SIMD version computes the power of 2 with a polynomial, within 1e-7
+ * relative.
+ *
+ * @tparam T the underlying type
+ * @param input
+ * @param output
+ * @param size
+ */
+template <class T>
+void centsFactor(const T* input, T* output, unsigned size) noexcept
+{
+    centsFactorScalar(input, output, size);
+}
+
+template <>
+void centsFactor<float>(const float* input, float* output, unsigned size) noexcept;
+
+template <class T>
+void centsFactor(absl::Span<const T> input, absl::Span<T> output) noexcept
+{
+    CHECK_SPAN_SIZES(input, output);
+    centsFactor<T>(input.data(), output.data(), minSpanSize(input, output));
+}
+
+// The single value version stays visible next to the spans
+using ::db2mag;
+
+/**
+ * @brief Convert the values in decibels into amplitude gains, as `db2mag`
+ * does for a single value.
+ *
+ * The SIMD version computes the power of 2 with the polynomial of
+ * `centsFactor`, within 2e-7 relative; the gains below -758 dB become the
+ * smallest normal float instead of 0.
+ *
+ * @tparam T the underlying type
+ * @param input
+ * @param output
+ * @param size
+ */
+template <class T>
+void db2mag(const T* input, T* output, unsigned size) noexcept
+{
+    db2magScalar(input, output, size);
+}
+
+template <>
+void db2mag<float>(const float* input, float* output, unsigned size) noexcept;
+
+template <class T>
+void db2mag(absl::Span<const T> input, absl::Span<T> output) noexcept
+{
+    CHECK_SPAN_SIZES(input, output);
+    db2mag<T>(input.data(), output.data(), minSpanSize(input, output));
+}
+
+/**
+ * @brief Compute the positions of the interpolation in the source, from the
+ * pitch of each output frame, in a single pass.
+ *
+ * The positions are in 32.32 fixed point, as made by `fixedPosition`, so that
+ * they stay exact over the longest samples. The first position is `start`;
+ * each next one adds a jump of `ratio * centsFactor(pitch[i])`, or `ratio` if
+ * `pitch` is null. The integer parts are the indices, and the coefficients are
+ * the fractions to 24 bits. This does the work of `centsFactor`, `applyGain1`,
+ * `cumsum`, `sfzInterpolationCast` and `add1<int>` over the block.
+ *
+ * The constant jumps are exact in all versions; the SIMD versions compute the
+ * jumps from the pitch with the polynomial of `centsFactor`.
+ *
+ * @tparam T the underlying type
+ * @param pitch the pitch in cents, or null for constant jumps; pitch[0] is unused
+ * @param ratio
+ * @param start
+ * @param indices
+ * @param coeffs
+ * @param size
+ * @return the position of the last frame, or `start` if there are none
+ */
+template <class T>
+int64_t interpolationPositions(const T* pitch, T ratio, int64_t start, int* indices, T* coeffs, unsigned size) noexcept
+{
+    return interpolationPositionsScalar(pitch, ratio, start, indices, coeffs, size);
+}
+
+template <>
+int64_t interpolationPositions<float>(const float* pitch, float ratio, int64_t start, int* indices, float* coeffs, unsigned size) noexcept;
+
+template <class T>
+int64_t interpolationPositions(absl::Span<const T> pitch, T ratio, int64_t start, absl::Span<int> indices, absl::Span<T> coeffs) noexcept
+{
+    CHECK_SPAN_SIZES(pitch, indices, coeffs);
+    return interpolationPositions<T>(pitch.data(), ratio, start, indices.data(), coeffs.data(), minSpanSize(pitch, indices, coeffs));
+}
+
+template <class T>
+int64_t interpolationPositions(T ratio, int64_t start, absl::Span<int> indices, absl::Span<T> coeffs) noexcept
+{
+    CHECK_SPAN_SIZES(indices, coeffs);
+    return interpolationPositions<T>(nullptr, ratio, start, indices.data(), coeffs.data(), minSpanSize(indices, coeffs));
+}
+
 } // namespace sfz
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "SampleEnvelope.h"
+#include "SIMDHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace sfz {
+
+SampleEnvelope::SampleEnvelope(SampleEnvelope&& other) noexcept
+    : rms_(std::move(other.rms_)),
+      peak_(std::move(other.peak_)),
+      numFrames_(other.numFrames_),
+      numMeasured_(other.numMeasured_.load())
+{
+    other.numFrames_ = 0;
+    other.numMeasured_ = 0;
+}
+
+SampleEnvelope& SampleEnvelope::operator=(SampleEnvelope&& other) noexcept
+{
+    rms_ = std::move(other.rms_);
+    peak_ = std::move(other.peak_);
+    numFrames_ = other.numFrames_;
+    numMeasured_ = other.numMeasured_.load();
+    other.numFrames_ = 0;
+    other.numMeasured_ = 0;
+    return *this;
+}
+
+void SampleEnvelope::resize(size_t numFrames)
+{
+    if (numFrames == numFrames_)
+        return;
+
+    constexpr size_t resolution = config::sampleEnvelopeResolution;
+    const size_t numWindows = (numFrames + resolution - 1) / resolution;
+    numMeasured_ = 0;
+    rms_.assign(numWindows, 0.0f);
+    peak_.assign(numWindows, 0.0f);
+    numFrames_ = numFrames;
+}
+
+namespace {
+
+float sumSquaresOf(absl::Span<const float> input) noexcept
+{
+    return sumSquares(input);
+}
+
+float sumSquaresOf(absl::Span<const int16_t> input) noexcept
+{
+    float sum = 0.0f;
+    for (int16_t value : input)
+        sum += static_cast<float>(value) * static_cast<float>(value);
+    return sum;
+}
+
+template <class T>
+float peakOf(absl::Span<const T> input) noexcept
+{
+    float peak = 0.0f;
+    for (T value : input)
+        peak = std::max(peak, std::abs(static_cast<float>(value)));
+    return peak;
+}
+
+} // namespace
+
+template <class T>
+void SampleEnvelope::measure(AudioSpan<const T> data, size_t numFrames, float scale) noexcept
+{
+    constexpr size_t resolution = config::sampleEnvelopeResolution;
+    const size_t numChannels = data.getNumChannels();
+    numFrames = std::min({ numFrames, numFrames_, data.getNumFrames() });
+    if (numChannels == 0)
+        return;
+
+    size_t window = numMeasured_.load(std::memory_order_relaxed);
+    const size_t numWindows = rms_.size();
+    while (window < numWindows) {
+        const size_t start = window * resolution;
+        const size_t end = std::min(start + resolution, numFrames_);
+        if (end > numFrames)
+            break;
+
+        float sum = 0.0f;
+        float peak = 0.0f;
+        for (size_t c = 0; c < numChannels; ++c) {
+            const auto input = data.getConstSpan(c).subspan(start, end - start);
+            sum += sumSquaresOf(input);
+            peak = std::max(peak, peakOf(input));
+        }
+
+        rms_[window] = scale * std::sqrt(sum / static_cast<float>(numChannels * (end - start)));
+        peak_[window] = scale * peak;
+        numMeasured_.store(++window, std::memory_order_release);
+    }
+}
+
+template void SampleEnvelope::measure<float>(AudioSpan<const float>, size_t, float) noexcept;
+template void SampleEnvelope::measure<int16_t>(AudioSpan<const int16_t>, size_t, float) noexcept;
+
+bool SampleEnvelope::assign(absl::Span<const float> rms, absl::Span<const float> peak) noexcept
+{
+    if (rms.size() != rms_.size() || peak.size() != peak_.size())
+        return false;
+
+    std::copy(rms.begin(), rms.end(), rms_.begin());
+    std::copy(peak.begin(), peak.end(), peak_.begin());
+    numMeasured_.store(rms_.size(), std::memory_order_release);
+    return true;
+}
+
+bool SampleEnvelope::getWindowAt(size_t frame, float& rms, float& peak) const noexcept
+{
+    const size_t window = frame / config::sampleEnvelopeResolution;
+    if (window >= getNumMeasuredWindows())
+        return false;
+
+    rms = rms_[window];
+    peak = peak_[window];
+    return true;
+}
+
+} // namespace sfz
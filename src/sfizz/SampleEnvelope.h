@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "AudioSpan.h"
+#include "Config.h"
+#include <absl/types/span.h>
+#include <atomic>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief The coarse RMS and peak envelope of the data of a sample, with one
+ * value of each per window of config::sampleEnvelopeResolution frames, over
+ * all the channels.
+ *
+ * The windows are measured in order as the frames of the data become
+ * available, by the preload and the stream of the file, on the background
+ * threads; the players read the measured windows concurrently.
+ */
+class SampleEnvelope {
+public:
+    SampleEnvelope() = default;
+    SampleEnvelope(SampleEnvelope&& other) noexcept;
+    SampleEnvelope& operator=(SampleEnvelope&& other) noexcept;
+    SampleEnvelope(const SampleEnvelope&) = delete;
+    SampleEnvelope& operator=(const SampleEnvelope&) = delete;
+
+    /**
+     * @brief Size the envelope for the frames of a data, which forgets the
+     * measured windows if the number of frames changes.
+     */
+    void resize(size_t numFrames);
+    /**
+     * @brief Measure the windows which are complete in the first frames of
+     * the data, after the ones already measured. The last window completes
+     * at the end of the data.
+     *
+     * @param data the data, whose first frames are available
+     * @param numFrames the number of frames available
+     * @param scale the scale to the full range of the values of the data
+     */
+    template <class T>
+    void measure(AudioSpan<const T> data, size_t numFrames, float scale = 1.0f) noexcept;
+    /**
+     * @brief Set all the windows at once, from an envelope measured before.
+     *
+     * @return false if the windows are not those of the data
+     */
+    bool assign(absl::Span<const float> rms, absl::Span<const float> peak) noexcept;
+
+    size_t getNumFrames() const noexcept { return numFrames_; }
+    size_t getNumWindows() const noexcept { return rms_.size(); }
+    size_t getNumMeasuredWindows() const noexcept { return numMeasured_.load(std::memory_order_acquire); }
+    bool isComplete() const noexcept { return getNumMeasuredWindows() == getNumWindows(); }
+    /**
+     * @brief Get the values of the measured windows.
+     */
+    absl::Span<const float> getRms() const noexcept { return absl::MakeConstSpan(rms_).first(getNumMeasuredWindows()); }
+    absl::Span<const float> getPeak() const noexcept { return absl::MakeConstSpan(peak_).first(getNumMeasuredWindows()); }
+    /**
+     * @brief Get the values of the window which holds a frame of the data.
+     *
+     * @return false if the window is not measured yet
+     */
+    bool getWindowAt(size_t frame, float& rms, float& peak) const noexcept;
+
+private:
+    std::vector<float> rms_;
+    std::vector<float> peak_;
+    size_t numFrames_ { 0 };
+    std::atomic<size_t> numMeasured_ { 0 };
+};
+
+} // namespace sfz
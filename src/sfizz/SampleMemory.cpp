@@ -0,0 +1,399 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "SampleMemory.h"
+#include "Config.h"
+#include "utility/Debug.h"
+#include <absl/container/flat_hash_map.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sfz {
+
+namespace {
+
+constexpr size_t slabSize { config::sampleSlabSize };
+constexpr size_t maxBlockSize { slabSize / 2 };
+constexpr size_t pageSize { 4096 };
+
+size_t roundUp(size_t bytes, size_t multiple) noexcept
+{
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+uintptr_t alignUp(uintptr_t address) noexcept
+{
+    return (address + slabSize - 1) & ~static_cast<uintptr_t>(slabSize - 1);
+}
+
+#if defined(_WIN32)
+
+void* allocateVirtual(void* address, size_t bytes, DWORD type, int node) noexcept
+{
+    if (node >= 0)
+        return VirtualAllocExNuma(GetCurrentProcess(), address, bytes, type, PAGE_READWRITE, static_cast<DWORD>(node));
+    return VirtualAlloc(address, bytes, type, PAGE_READWRITE);
+}
+
+void* mapRegion(size_t bytes, SampleMemory::Pages pages, int node) noexcept
+{
+    if (pages == SampleMemory::Pages::Explicit) {
+        // Needs the privilege to lock the pages in memory
+        const size_t largePageSize = GetLargePageMinimum();
+        if (largePageSize > 0 && slabSize % largePageSize == 0) {
+            void* region = allocateVirtual(
+                nullptr, roundUp(bytes, largePageSize),
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, node);
+            if (region)
+                return region;
+        }
+    }
+
+    // Reserve more to find an aligned address, and map it; another thread
+    // may take the address in between, hence the attempts
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        void* reserved = VirtualAlloc(nullptr, bytes + slabSize, MEM_RESERVE, PAGE_NOACCESS);
+        if (!reserved)
+            return nullptr;
+        void* aligned = reinterpret_cast<void*>(alignUp(reinterpret_cast<uintptr_t>(reserved)));
+        VirtualFree(reserved, 0, MEM_RELEASE);
+        void* region = allocateVirtual(aligned, bytes, MEM_RESERVE | MEM_COMMIT, node);
+        if (region)
+            return region;
+    }
+    return nullptr;
+}
+
+void unmapRegion(void* region, size_t) noexcept
+{
+    VirtualFree(region, 0, MEM_RELEASE);
+}
+
+int currentNode() noexcept
+{
+    PROCESSOR_NUMBER processor;
+    GetCurrentProcessorNumberEx(&processor);
+    USHORT node;
+    if (!GetNumaProcessorNodeEx(&processor, &node))
+        return -1;
+    return static_cast<int>(node);
+}
+
+#else
+
+/**
+ * @brief Have the pages of a region taken from a node when they are touched
+ * first, whichever thread touches them.
+ */
+void bindRegion(void* region, size_t bytes, int node) noexcept
+{
+#if defined(SYS_mbind)
+    constexpr int preferredPolicy = 1; // MPOL_PREFERRED
+    constexpr size_t bitsPerMask = 8 * sizeof(unsigned long);
+    constexpr size_t maxNodes = 1024;
+    if (node < 0 || static_cast<size_t>(node) >= maxNodes)
+        return;
+
+    unsigned long mask[maxNodes / bitsPerMask] {};
+    mask[node / bitsPerMask] = 1ul << (node % bitsPerMask);
+    // The kernel takes one bit more than the mask has
+    if (syscall(SYS_mbind, region, bytes, preferredPolicy, mask, maxNodes + 1, 0) != 0)
+        DBG("[sfizz] Cannot bind the sample memory to the node " << node);
+#else
+    (void)region;
+    (void)bytes;
+    (void)node;
+#endif
+}
+
+void* mapRegion(size_t bytes, SampleMemory::Pages pages, int node) noexcept
+{
+#if defined(MAP_HUGETLB)
+    if (pages == SampleMemory::Pages::Explicit) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+        flags |= 21 << MAP_HUGE_SHIFT; // the pages of 2 MB
+#endif
+        void* region = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (region != MAP_FAILED) {
+            bindRegion(region, bytes, node);
+            return region;
+        }
+    }
+#endif
+
+    // Map more to find an aligned address, and unmap the rest
+    const size_t mappedBytes = bytes + slabSize;
+    void* mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+        return nullptr;
+
+    const uintptr_t start = reinterpret_cast<uintptr_t>(mapped);
+    const uintptr_t aligned = alignUp(start);
+    const size_t head = aligned - start;
+    const size_t tail = mappedBytes - head - bytes;
+    if (head > 0)
+        munmap(mapped, head);
+    if (tail > 0)
+        munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+
+    void* region = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+    if (pages != SampleMemory::Pages::Normal)
+        madvise(region, bytes, MADV_HUGEPAGE);
+#else
+    (void)pages;
+#endif
+    bindRegion(region, bytes, node);
+    return region;
+}
+
+void unmapRegion(void* region, size_t bytes) noexcept
+{
+    munmap(region, bytes);
+}
+
+int currentNode() noexcept
+{
+#if defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+        return -1;
+    return static_cast<int>(node);
+#else
+    return -1;
+#endif
+}
+
+#endif
+
+// The slabs of the same pages and node
+using SlabPool = std::pair<SampleMemory::Pages, int>;
+
+struct Slab {
+    SlabPool pool { SampleMemory::Pages::Normal, -1 };
+    size_t sizeClass { 0 };
+    size_t numBlocks { 0 };
+    size_t numUsed { 0 };
+    size_t numCarved { 0 }; // the blocks were carved in order, then freed
+    void* freeBlocks { nullptr }; // linked through their first bytes
+    bool available { true };
+};
+
+struct State {
+    State()
+    {
+        for (size_t octave = config::minSampleBlockSize; octave < maxBlockSize; octave *= 2) {
+            for (size_t quarter = 0; quarter < 4; ++quarter)
+                classSizes.push_back(octave + quarter * octave / 4);
+        }
+        classSizes.push_back(maxBlockSize);
+    }
+
+    std::vector<std::vector<uintptr_t>>& getAvailableSlabs(const SlabPool& pool)
+    {
+        std::vector<std::vector<uintptr_t>>& available = availableSlabs[pool];
+        if (available.empty())
+            available.resize(classSizes.size());
+        return available;
+    }
+
+    std::atomic<SampleMemory::Pages> pages { SampleMemory::Pages::Normal };
+    std::atomic<size_t> mappedBytes { 0 };
+    std::mutex mutex;
+    std::vector<size_t> classSizes;
+    // for each pool and each class, the slabs with a free block
+    absl::flat_hash_map<SlabPool, std::vector<std::vector<uintptr_t>>> availableSlabs;
+    absl::flat_hash_map<uintptr_t, Slab> slabs;
+    absl::flat_hash_map<uintptr_t, size_t> largeRegions;
+};
+
+State& getState()
+{
+    // Never destroyed, as buffers of static objects may outlive it
+    static State* state = new State;
+    return *state;
+}
+
+thread_local int threadNode { -1 };
+
+void* allocateBlock(State& state, size_t bytes, SampleMemory::Pages pages, int node) noexcept
+{
+    const auto classIt = std::lower_bound(state.classSizes.begin(), state.classSizes.end(), bytes);
+    ASSERT(classIt != state.classSizes.end());
+    const size_t sizeClass = static_cast<size_t>(classIt - state.classSizes.begin());
+    const size_t blockSize = *classIt;
+
+    const std::lock_guard<std::mutex> lock { state.mutex };
+    const SlabPool pool { pages, node };
+    std::vector<uintptr_t>& available = state.getAvailableSlabs(pool)[sizeClass];
+    if (available.empty()) {
+        void* region = mapRegion(slabSize, pages, node);
+        if (!region)
+            return nullptr;
+        state.mappedBytes += slabSize;
+
+        Slab slab;
+        slab.pool = pool;
+        slab.sizeClass = sizeClass;
+        slab.numBlocks = slabSize / blockSize;
+        const uintptr_t key = reinterpret_cast<uintptr_t>(region);
+        state.slabs.emplace(key, slab);
+        available.push_back(key);
+    }
+
+    const uintptr_t key = available.back();
+    Slab& slab = state.slabs[key];
+    void* block;
+    if (slab.freeBlocks) {
+        block = slab.freeBlocks;
+        std::memcpy(&slab.freeBlocks, block, sizeof(void*));
+        std::memset(block, 0, bytes);
+    } else {
+        // the mapped pages are zeroed
+        block = reinterpret_cast<void*>(key + slab.numCarved * blockSize);
+        ++slab.numCarved;
+    }
+
+    if (++slab.numUsed == slab.numBlocks) {
+        available.pop_back();
+        slab.available = false;
+    }
+    return block;
+}
+
+bool deallocateBlock(State& state, void* block) noexcept
+{
+    const uintptr_t key = reinterpret_cast<uintptr_t>(block) & ~static_cast<uintptr_t>(slabSize - 1);
+
+    const std::lock_guard<std::mutex> lock { state.mutex };
+    const auto it = state.slabs.find(key);
+    if (it == state.slabs.end())
+        return false;
+
+    Slab& slab = it->second;
+    std::memcpy(block, &slab.freeBlocks, sizeof(void*));
+    slab.freeBlocks = block;
+    std::vector<uintptr_t>& available = state.availableSlabs[slab.pool][slab.sizeClass];
+
+    if (--slab.numUsed == 0) {
+        if (slab.available)
+            available.erase(std::find(available.begin(), available.end(), key));
+        state.slabs.erase(it);
+        unmapRegion(reinterpret_cast<void*>(key), slabSize);
+        state.mappedBytes -= slabSize;
+    } else if (!slab.available) {
+        available.push_back(key);
+        slab.available = true;
+    }
+    return true;
+}
+
+void* allocateLarge(State& state, size_t bytes, SampleMemory::Pages pages, int node) noexcept
+{
+    const size_t regionBytes = roundUp(bytes, (pages == SampleMemory::Pages::Explicit) ? slabSize : pageSize);
+    void* region = mapRegion(regionBytes, pages, node);
+    if (!region)
+        return nullptr;
+
+    const std::lock_guard<std::mutex> lock { state.mutex };
+    state.largeRegions.emplace(reinterpret_cast<uintptr_t>(region), regionBytes);
+    state.mappedBytes += regionBytes;
+    return region;
+}
+
+bool deallocateLarge(State& state, void* region) noexcept
+{
+    const std::lock_guard<std::mutex> lock { state.mutex };
+    const auto it = state.largeRegions.find(reinterpret_cast<uintptr_t>(region));
+    if (it == state.largeRegions.end())
+        return false;
+
+    unmapRegion(region, it->second);
+    state.mappedBytes -= it->second;
+    state.largeRegions.erase(it);
+    return true;
+}
+
+} // namespace
+
+void SampleMemory::setPages(Pages pages) noexcept
+{
+    getState().pages.store(pages);
+}
+
+SampleMemory::Pages SampleMemory::getPages() noexcept
+{
+    return getState().pages.load();
+}
+
+void* SampleMemory::allocate(size_t bytes) noexcept
+{
+    State& state = getState();
+    const Pages pages = state.pages.load(std::memory_order_relaxed);
+
+    const int node = threadNode;
+
+    // The small buffers are packed in slabs whatever the pages, so the many
+    // preloads cost a few mappings rather than an allocation each
+    void* memory = nullptr;
+    if (bytes > 0 && bytes <= maxBlockSize)
+        memory = allocateBlock(state, bytes, pages, node);
+    else if (bytes > 0 && (pages != Pages::Normal || node >= 0))
+        memory = allocateLarge(state, bytes, pages, node);
+
+    // The heap, also when the mapping fails
+    return memory ? memory : std::calloc(bytes, 1);
+}
+
+void SampleMemory::deallocate(void* pointer, size_t bytes) noexcept
+{
+    if (!pointer)
+        return;
+
+    // The memory may come from the heap whatever the current pages
+    State& state = getState();
+    const bool mapped = (bytes <= maxBlockSize) ?
+        deallocateBlock(state, pointer) : deallocateLarge(state, pointer);
+    if (!mapped)
+        std::free(pointer);
+}
+
+size_t SampleMemory::getMappedBytes() noexcept
+{
+    return getState().mappedBytes.load();
+}
+
+void SampleMemory::setThreadNode(int node) noexcept
+{
+    threadNode = (node >= 0) ? node : -1;
+}
+
+int SampleMemory::getThreadNode() noexcept
+{
+    return threadNode;
+}
+
+int SampleMemory::getCurrentNode() noexcept
+{
+    return currentNode();
+}
+
+} // namespace sfz
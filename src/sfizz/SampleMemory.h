@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <cstddef>
+
+namespace sfz {
+
+/**
+ * @brief The memory of the sample data of the process, which may be backed
+ * by huge pages to spare the TLB when the voices read across many files.
+ *
+ * The buffers of up to half a slab are carved out of slabs of
+ * config::sampleSlabSize bytes, in size classes of a quarter of an octave,
+ * so the many small preloads share a few mappings instead of fragmenting the
+ * heap; the slabs are unmapped when their last buffer is freed. With huge
+ * pages or on a NUMA node, the larger buffers are mapped on their own, and
+ * otherwise they come from the heap.
+ *
+ * The buffers which a thread allocates are placed on the node set for the
+ * thread, if any, from slabs of their own; the file pools set it around
+ * their loading to the node of their synth.
+ */
+class SampleMemory {
+public:
+    enum class Pages {
+        //! The pages of the system
+        Normal,
+        //! Mappings which the system may back with huge pages (Linux)
+        Transparent,
+        //! Huge pages reserved by the system (Linux), or large pages
+        //! (Windows), or else the transparent huge pages
+        Explicit,
+    };
+
+    /**
+     * @brief Set the pages of the buffers allocated from now on. The
+     * buffers allocated before keep their pages until they are freed.
+     */
+    static void setPages(Pages pages) noexcept;
+    static Pages getPages() noexcept;
+
+    /**
+     * @brief Allocate zeroed memory.
+     *
+     * @param bytes
+     * @return void* the memory, or null on failure
+     */
+    static void* allocate(size_t bytes) noexcept;
+
+    /**
+     * @brief Free the memory of allocate().
+     *
+     * @param pointer
+     * @param bytes the size given to allocate()
+     */
+    static void deallocate(void* pointer, size_t bytes) noexcept;
+
+    /**
+     * @brief Get the bytes mapped for the slabs and the large buffers, not
+     * counting the heap.
+     */
+    static size_t getMappedBytes() noexcept;
+
+    /**
+     * @brief Set the NUMA node of the buffers which the calling thread
+     * allocates from now on, or -1 for the node where the pages are touched
+     * first. Huge pages cannot move, so it is best to set this before the
+     * data is written.
+     */
+    static void setThreadNode(int node) noexcept;
+    static int getThreadNode() noexcept;
+
+    /**
+     * @brief Get the NUMA node of the processor which runs the calling
+     * thread, or -1 if unknown.
+     */
+    static int getCurrentNode() noexcept;
+
+    /**
+     * @brief Set the node of the calling thread for the lifetime of the
+     * object, if it is not -1, and restore the former one after.
+     */
+    class NodeScope {
+    public:
+        explicit NodeScope(int node) noexcept
+            : former_(getThreadNode())
+        {
+            if (node >= 0)
+                setThreadNode(node);
+        }
+        ~NodeScope() noexcept { setThreadNode(former_); }
+        NodeScope(const NodeScope&) = delete;
+        NodeScope& operator=(const NodeScope&) = delete;
+
+    private:
+        int former_;
+    };
+};
+
+/**
+ * @brief The allocation of the sample buffers, for `Buffer`.
+ */
+struct SampleAllocator {
+    static void* allocate(size_t bytes) noexcept { return SampleMemory::allocate(bytes); }
+    static void deallocate(void* pointer, size_t bytes) noexcept { SampleMemory::deallocate(pointer, bytes); }
+};
+
+} // namespace sfz
@@ -7,9 +7,11 @@
 #include "Config.h"
 #include "SfzFilter.h"
 #include "SfzFilterImpls.hpp"
+#include "FilterTables.h"
 #include "SIMDHelpers.h"
 #include "utility/StringViewHelpers.h"
 #include "utility/Debug.h"
+#include <cmath>
 #include <cstring>
 
 namespace sfz {
@@ -41,6 +43,32 @@ struct Filter::Impl {
     {
         return static_cast<unsigned>(type)|(channels << 16);
     }
+
+    // The tabulated design, which replaces the faust filters of the same type
+    bool fTabulated = false;
+    std::shared_ptr<const RbjCoefficientTable> fTable;
+    FilterCoefficientCache* fCache = nullptr;
+    double fSmoothingPole = 0.0;
+    float fCutoff = 0.0f;
+    float fResonance = 0.0f;
+    // the coefficients b0, b1, b2, a1, a2, and the targets premultiplied by
+    // the complement of the smoothing pole
+    enum { numCoefs = 5 };
+    double fCoefs[numCoefs] {};
+    double fTargets[numCoefs] {};
+    // the memory: b1 x[n-1], b2 x[n-1], b2 x[n-2] - a2 y[n-2], and y[n-1]
+    struct Memory { double b1x1, b2x1, z2, y1; };
+    Memory fMemory[maxChannels] {};
+
+    bool usesTable() const noexcept
+    {
+        return fTabulated && fTable && RbjCoefficientTable::supports(fType);
+    }
+    void clearTabulated() noexcept;
+    void setTargets(float cutoff, float q) noexcept;
+    void processTabulated(const float *const in[], float *const out[], unsigned nframes) noexcept;
+    template <unsigned NumChannels>
+    void runTabulated(const float *const in[], float *const out[], unsigned nframes) noexcept;
 };
 
 Filter::Filter()
@@ -48,6 +76,11 @@ Filter::Filter()
 {
 }
 
+size_t Filter::getMemoryUsage() const noexcept
+{
+    return sizeof(Filter) + sizeof(Impl);
+}
+
 Filter::~Filter()
 {
     sfzFilterDsp *dsp = P->getDsp(P->fChannels, P->fType);
@@ -64,6 +97,11 @@ void Filter::init(double sampleRate)
         dsp->init(sampleRate);
 
     P->fSampleRate = sampleRate;
+
+    // the same smoothing as the faust filters
+    P->fTable = RbjCoefficientTable::get(sampleRate);
+    P->fSmoothingPole = std::exp(-1000.0 / sampleRate);
+    P->clearTabulated();
 }
 
 void Filter::clear()
@@ -72,10 +110,21 @@ void Filter::clear()
 
     if (dsp)
         dsp->instanceClear();
+
+    P->clearTabulated();
 }
 
 void Filter::prepare(float cutoff, float q, float pksh)
 {
+    if (P->usesTable()) {
+        P->clearTabulated();
+        P->setTargets(cutoff, q);
+        const double gain = 1.0 - P->fSmoothingPole;
+        for (unsigned k = 0; k < Impl::numCoefs; ++k)
+            P->fCoefs[k] = (gain > 0.0) ? P->fTargets[k] / gain : 0.0;
+        return;
+    }
+
     sfzFilterDsp *dsp = P->getDsp(P->fChannels, P->fType);
 
     if (!dsp)
@@ -108,6 +157,12 @@ void Filter::process(const float *const in[], float *const out[], float cutoff,
         return;
     }
 
+    if (P->usesTable()) {
+        P->setTargets(cutoff, q);
+        P->processTabulated(in, out, nframes);
+        return;
+    }
+
     dsp->configureStandard(cutoff, q, pksh);
     dsp->compute(nframes, const_cast<float **>(in), const_cast<float **>(out));
 }
@@ -123,6 +178,8 @@ void Filter::processModulated(const float *const in[], float *const out[], const
         return;
     }
 
+    const bool tabulated = P->usesTable();
+
     unsigned frame = 0;
     while (frame < nframes) {
         unsigned current = nframes - frame;
@@ -138,8 +195,14 @@ void Filter::processModulated(const float *const in[], float *const out[], const
             current_out[c] = out[c] + frame;
         }
 
-        dsp->configureStandard(cutoff[frame], q[frame], pksh[frame]);
-        dsp->compute(current, const_cast<float **>(current_in), const_cast<float **>(current_out));
+        if (tabulated) {
+            P->setTargets(cutoff[frame], q[frame]);
+            P->processTabulated(current_in, current_out, current);
+        }
+        else {
+            dsp->configureStandard(cutoff[frame], q[frame], pksh[frame]);
+            dsp->compute(current, const_cast<float **>(current_in), const_cast<float **>(current_out));
+        }
 
         frame += current;
     }
@@ -163,6 +226,8 @@ void Filter::setChannels(unsigned channels)
         dsp = P->newDsp(channels, P->fType);
         if (dsp)
             dsp->init(P->fSampleRate);
+
+        P->clearTabulated();
     }
 }
 
@@ -183,9 +248,114 @@ void Filter::setType(FilterType type)
         dsp = P->newDsp(P->fChannels, type);
         if (dsp)
             dsp->init(P->fSampleRate);
+
+        P->clearTabulated();
     }
 }
 
+bool Filter::tabulated() const
+{
+    return P->fTabulated;
+}
+
+void Filter::setTabulated(bool tabulated)
+{
+    if (P->fTabulated != tabulated) {
+        sfzFilterDsp *dsp = P->getDsp(P->fChannels, P->fType);
+        if (dsp)
+            dsp->instanceClear();
+
+        P->fTabulated = tabulated;
+        P->clearTabulated();
+    }
+}
+
+void Filter::setCoefficientCache(FilterCoefficientCache* cache)
+{
+    P->fCache = cache;
+}
+
+void Filter::Impl::clearTabulated() noexcept
+{
+    for (Memory& memory : fMemory)
+        memory = Memory {};
+    for (double& coef : fCoefs)
+        coef = 0.0;
+    // force the design of targets on the next cycle
+    fCutoff = NAN;
+    fResonance = NAN;
+}
+
+void Filter::Impl::setTargets(float cutoff, float q) noexcept
+{
+    // Most cycles keep the parameters of the previous ones
+    if (cutoff == fCutoff && q == fResonance)
+        return;
+
+    fCutoff = cutoff;
+    fResonance = q;
+
+    const BiquadCoefficients c = fCache ? fCache->compute(*fTable, fType, cutoff, q)
+        : fTable->compute(fType, cutoff, q);
+    const double gain = 1.0 - fSmoothingPole;
+    fTargets[0] = c.b0 * gain;
+    fTargets[1] = c.b1 * gain;
+    fTargets[2] = c.b2 * gain;
+    fTargets[3] = c.a1 * gain;
+    fTargets[4] = c.a2 * gain;
+}
+
+void Filter::Impl::processTabulated(const float *const in[], float *const out[], unsigned nframes) noexcept
+{
+    if (fChannels == 2)
+        runTabulated<2>(in, out, nframes);
+    else
+        runTabulated<1>(in, out, nframes);
+}
+
+template <unsigned NumChannels>
+void Filter::Impl::runTabulated(const float *const in[], float *const out[], unsigned nframes) noexcept
+{
+    const double pole = fSmoothingPole;
+    const double t0 = fTargets[0], t1 = fTargets[1], t2 = fTargets[2], t3 = fTargets[3], t4 = fTargets[4];
+    double c0 = fCoefs[0], c1 = fCoefs[1], c2 = fCoefs[2], c3 = fCoefs[3], c4 = fCoefs[4];
+
+    Memory m[NumChannels];
+    const float *input[NumChannels];
+    float *output[NumChannels];
+    for (unsigned ch = 0; ch < NumChannels; ++ch) {
+        m[ch] = fMemory[ch];
+        input[ch] = in[ch];
+        output[ch] = out[ch];
+    }
+
+    // the recurrence of the faust filters, with coefficients staggered in time
+    for (unsigned i = 0; i < nframes; ++i) {
+        c0 = pole * c0 + t0;
+        c1 = pole * c1 + t1;
+        c2 = pole * c2 + t2;
+        c3 = pole * c3 + t3;
+        c4 = pole * c4 + t4;
+        for (unsigned ch = 0; ch < NumChannels; ++ch) {
+            const double x = input[ch][i];
+            const double y = m[ch].b1x1 + c0 * x + m[ch].z2 - c3 * m[ch].y1;
+            m[ch].z2 = m[ch].b2x1 - c4 * m[ch].y1;
+            m[ch].b1x1 = c1 * x;
+            m[ch].b2x1 = c2 * x;
+            m[ch].y1 = y;
+            output[ch][i] = static_cast<float>(y);
+        }
+    }
+
+    for (unsigned ch = 0; ch < NumChannels; ++ch)
+        fMemory[ch] = m[ch];
+    fCoefs[0] = c0;
+    fCoefs[1] = c1;
+    fCoefs[2] = c2;
+    fCoefs[3] = c3;
+    fCoefs[4] = c4;
+}
+
 sfzFilterDsp *Filter::Impl::getDsp(unsigned channels, FilterType type)
 {
     switch (idDsp(channels, type)) {
@@ -246,6 +416,11 @@ FilterEq::FilterEq()
 {
 }
 
+size_t FilterEq::getMemoryUsage() const noexcept
+{
+    return sizeof(FilterEq) + sizeof(Impl);
+}
+
 FilterEq::~FilterEq()
 {
     sfzFilterDsp *dsp = P->getDsp(P->fChannels, P->fType);
@@ -12,6 +12,7 @@
 namespace sfz {
 
 enum FilterType : int;
+class FilterCoefficientCache;
 
 /**
    Multi-mode filter for SFZ v2
@@ -84,6 +85,29 @@ public:
      */
     void setType(FilterType type);
 
+    /**
+       Check whether the filter designs from tables.
+     */
+    bool tabulated() const;
+
+    /**
+       Set whether the filter designs from tables, which replace the
+       trigonometric terms of the coefficients with interpolations.
+       It applies to the resonant 2-pole filters, the others are unaffected.
+     */
+    void setTabulated(bool tabulated);
+
+    /**
+       Set the cache which shares the tabulated designs with the other filters
+       of the block, or none. The cache must outlive its use by the filter.
+     */
+    void setCoefficientCache(FilterCoefficientCache* cache);
+
+    /**
+       Get the memory of the filter, in bytes.
+     */
+    size_t getMemoryUsage() const noexcept;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> P;
@@ -189,6 +213,11 @@ public:
      */
     void setType(EqType type);
 
+    /**
+       Get the memory of the filter, in bytes.
+     */
+    size_t getMemoryUsage() const noexcept;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> P;
@@ -221,9 +221,22 @@ enum ExtendedCCs {
     unipolarRandom,
     bipolarRandom,
     alternate,
+    perNotePitchBend,
+    perNoteTimbre,
     extendedCCupperBound
 };
 
+/**
+ * @brief Check if an extended CC is held for each note, as the per-note
+ * controllers of MPE
+ *
+ * @param cc
+ * @return bool
+ */
+inline CXX14_CONSTEXPR bool isPerNoteCC(int cc) {
+    return cc == ExtendedCCs::perNotePitchBend || cc == ExtendedCCs::perNoteTimbre;
+}
+
 enum AriaExtendedCCs {
     keydelta = 140,
     absoluteKeydelta,
@@ -274,6 +287,8 @@ inline CXX14_CONSTEXPR bool ccModulationIsPerVoice(int cc) {
     case ExtendedCCs::unipolarRandom: // fallthrough
     case ExtendedCCs::bipolarRandom: // fallthrough
     case ExtendedCCs::alternate:
+    case ExtendedCCs::perNotePitchBend:
+    case ExtendedCCs::perNoteTimbre:
     case AriaExtendedCCs::keydelta:
     case AriaExtendedCCs::absoluteKeydelta:
         return true;
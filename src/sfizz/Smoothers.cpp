@@ -65,6 +65,103 @@ void OnePoleSmoother::process(absl::Span<const float> input, absl::Span<float> o
     target_ = input.back();
 }
 
+///
+void OnePoleSmootherBank::process(OnePoleSmoother* const smoothers[], const float* const inputs[], float* const outputs[], const bool canShortcut[], unsigned numSmoothers, unsigned nframes)
+{
+    if (nframes == 0)
+        return;
+
+    // The smoothers which filter go in the lanes, the others copy
+    OnePoleSmoother* laneSmoothers[lanesPerPass];
+    const float* laneInputs[lanesPerPass];
+    float* laneOutputs[lanesPerPass];
+    unsigned numLanes = 0;
+
+    for (unsigned k = 0; k < numSmoothers; ++k) {
+        OnePoleSmoother& smoother = *smoothers[k];
+        const float* input = inputs[k];
+        const bool shortcut = canShortcut && canShortcut[k] &&
+            std::abs(input[0] - smoother.current()) / (std::abs(input[0]) + config::virtuallyZero) < config::smoothingShortcutThreshold;
+
+        if (shortcut || !smoother.smoothing) {
+            smoother.process({ input, nframes }, { outputs[k], nframes }, shortcut);
+            continue;
+        }
+
+        laneSmoothers[numLanes] = &smoother;
+        laneInputs[numLanes] = input;
+        laneOutputs[numLanes] = outputs[k];
+        if (++numLanes == lanesPerPass) {
+            processLanes(laneSmoothers, laneInputs, laneOutputs, numLanes, nframes);
+            numLanes = 0;
+        }
+    }
+
+    if (numLanes > 0)
+        processLanes(laneSmoothers, laneInputs, laneOutputs, numLanes, nframes);
+}
+
+void OnePoleSmootherBank::processLanes(OnePoleSmoother* const smoothers[], const float* const inputs[], float* const outputs[], unsigned numLanes, unsigned nframes)
+{
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    // The missing lanes repeat the first, and are not stored
+    const float* in[lanesPerPass];
+    alignas(16) float coefs[lanesPerPass];
+    alignas(16) float states[lanesPerPass];
+    for (unsigned l = 0; l < lanesPerPass; ++l) {
+        const OnePoleSmoother& smoother = *smoothers[(l < numLanes) ? l : 0];
+        in[l] = inputs[(l < numLanes) ? l : 0];
+        coefs[l] = smoother.filter.coefficient();
+        states[l] = smoother.filter.current();
+    }
+
+    const simde__m128 g = simde_mm_load_ps(coefs);
+    simde__m128 s = simde_mm_load_ps(states);
+
+    auto tick = [g, &s](simde__m128 x) -> simde__m128 {
+        const simde__m128 intermediate = simde_mm_mul_ps(g, simde_mm_sub_ps(x, s));
+        const simde__m128 y = simde_mm_add_ps(intermediate, s);
+        s = simde_mm_add_ps(y, intermediate);
+        return y;
+    };
+
+    unsigned i = 0;
+    for (; i + 4 <= nframes; i += 4) {
+        // 4 frames of the 4 lanes, transposed into a frame per register
+        simde__m128 x0 = simde_mm_loadu_ps(in[0] + i);
+        simde__m128 x1 = simde_mm_loadu_ps(in[1] + i);
+        simde__m128 x2 = simde_mm_loadu_ps(in[2] + i);
+        simde__m128 x3 = simde_mm_loadu_ps(in[3] + i);
+        SIMDE_MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+        x0 = tick(x0);
+        x1 = tick(x1);
+        x2 = tick(x2);
+        x3 = tick(x3);
+        SIMDE_MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+        const simde__m128 y[lanesPerPass] { x0, x1, x2, x3 };
+        for (unsigned l = 0; l < numLanes; ++l)
+            simde_mm_storeu_ps(outputs[l] + i, y[l]);
+    }
+
+    for (; i < nframes; ++i) {
+        alignas(16) float y[lanesPerPass];
+        simde_mm_store_ps(y, tick(simde_mm_setr_ps(in[0][i], in[1][i], in[2][i], in[3][i])));
+        for (unsigned l = 0; l < numLanes; ++l)
+            outputs[l][i] = y[l];
+    }
+
+    simde_mm_store_ps(states, s);
+    for (unsigned l = 0; l < numLanes; ++l) {
+        OnePoleSmoother& smoother = *smoothers[l];
+        smoother.filter.reset(states[l]);
+        smoother.target_ = inputs[l][nframes - 1];
+    }
+#else
+    for (unsigned l = 0; l < numLanes; ++l)
+        smoothers[l]->process({ inputs[l], nframes }, { outputs[l], nframes });
+#endif
+}
+
 ///
 LinearSmoother::LinearSmoother()
 {
@@ -49,11 +49,41 @@ public:
 
     float current() const { return filter.current(); }
 private:
+    friend class OnePoleSmootherBank;
     bool smoothing { false };
     OnePoleFilter<float> filter {};
     float target_ { 0.0f };
 };
 
+/**
+ * @brief Bank of one pole smoothers, which run side by side in the lanes of
+ * vector registers. A one pole filter is recursive in time, but the
+ * independent smoothers can go in parallel.
+ */
+class OnePoleSmootherBank {
+public:
+    // smoothers held in the registers at once, the larger banks go by groups
+    enum { lanesPerPass = 4 };
+
+    /**
+     * @brief Process a cycle of the smoothers, as `OnePoleSmoother::process`
+     * does for each of them. `inputs[k]` and `outputs[k]` can refer to the
+     * same memory.
+     *
+     * @param smoothers
+     * @param inputs
+     * @param outputs
+     * @param canShortcut whether each smoother can have the fast path, or
+     *                    null to have it for none
+     * @param numSmoothers
+     * @param nframes
+     */
+    static void process(OnePoleSmoother* const smoothers[], const float* const inputs[], float* const outputs[], const bool canShortcut[], unsigned numSmoothers, unsigned nframes);
+
+private:
+    static void processLanes(OnePoleSmoother* const smoothers[], const float* const inputs[], float* const outputs[], unsigned numLanes, unsigned nframes);
+};
+
 /**
  * @brief Linear smoother
  *
@@ -92,6 +122,15 @@ public:
     void process(absl::Span<const float> input, absl::Span<float> output, bool canShortcut = false);
 
     float current() const { return current_; }
+    /**
+     * @brief Whether the other smoother outputs the same as this one from
+     * the same input, holding the same state and smoothing.
+     */
+    bool hasSameState(const LinearSmoother& other) const noexcept
+    {
+        return current_ == other.current_ && target_ == other.target_
+            && step_ == other.step_ && smoothFrames_ == other.smoothFrames_;
+    }
 private:
     float current_ = 0.0;
     float target_ = 0.0;
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "OversamplerHelpers.h"
+#include "utility/Debug.h"
+#include <simde/x86/sse.h>
+#include <algorithm>
+#include <cstddef>
+
+namespace sfz {
+
+/**
+ * @brief Polyphase 2x upsampling stage of the hiir filters, for interleaved
+ * stereo frames. The two all-pass paths of the two channels run in the four
+ * lanes of a vector, as (left even, left odd, right even, right odd), so a
+ * stereo frame costs a single pass over the coefficients.
+ *
+ * @tparam NC the number of coefficients
+ */
+template <int NC>
+class StereoUpsampler2x {
+public:
+    StereoUpsampler2x() noexcept { clear(); }
+
+    void setCoefs(const double coefs[NC]) noexcept
+    {
+        for (int k = 0; k < numPairs; ++k) {
+            const float even = static_cast<float>(coefs[2 * k]);
+            const float odd = (2 * k + 1 < NC) ? static_cast<float>(coefs[2 * k + 1]) : 0.0f;
+            const float lanes[4] { even, odd, even, odd };
+            std::copy(lanes, lanes + 4, &coefs_[4 * k]);
+        }
+    }
+
+    void clear() noexcept
+    {
+        std::fill_n(x_, 4 * numPairs, 0.0f);
+        std::fill_n(y_, 4 * numPairs, 0.0f);
+    }
+
+    /**
+     * @brief Upsample interleaved stereo frames into twice as many.
+     *
+     * @param input the interleaved input, of numFrames frames
+     * @param output the interleaved output, of 2 * numFrames frames, which
+     *               must not overlap the input
+     * @param numFrames
+     */
+    void process(const float* input, float* output, size_t numFrames) noexcept
+    {
+        ASSERT(output + 4 * numFrames <= input || input + 2 * numFrames <= output);
+
+        simde__m128 c[numPairs];
+        simde__m128 x[numPairs];
+        simde__m128 y[numPairs];
+        for (int k = 0; k < numPairs; ++k) {
+            c[k] = simde_mm_loadu_ps(&coefs_[4 * k]);
+            x[k] = simde_mm_loadu_ps(&x_[4 * k]);
+            y[k] = simde_mm_loadu_ps(&y_[4 * k]);
+        }
+
+        constexpr int numFullPairs = NC / 2;
+
+        for (size_t i = 0; i < numFrames; ++i) {
+            const simde__m128 frame = simde_mm_setr_ps(input[2 * i], input[2 * i + 1], 0.0f, 0.0f);
+            simde__m128 v = simde_mm_unpacklo_ps(frame, frame);
+            for (int k = 0; k < numFullPairs; ++k) {
+                const simde__m128 t = simde_mm_add_ps(simde_mm_mul_ps(simde_mm_sub_ps(v, y[k]), c[k]), x[k]);
+                x[k] = v;
+                y[k] = t;
+                v = t;
+            }
+            if (numFullPairs < numPairs) {
+                constexpr int k = numPairs - 1;
+                const simde__m128 t = simde_mm_add_ps(simde_mm_mul_ps(simde_mm_sub_ps(v, y[k]), c[k]), x[k]);
+                x[k] = v;
+                y[k] = t;
+                // With an odd number of coefficients, the odd paths have
+                // one section less, and pass through the last one
+                const simde__m128 evenOdd = simde_mm_shuffle_ps(t, v, SIMDE_MM_SHUFFLE(3, 1, 2, 0));
+                v = simde_mm_shuffle_ps(evenOdd, evenOdd, SIMDE_MM_SHUFFLE(3, 1, 2, 0));
+            }
+            // (left even, right even, left odd, right odd)
+            simde_mm_storeu_ps(&output[4 * i], simde_mm_shuffle_ps(v, v, SIMDE_MM_SHUFFLE(3, 1, 2, 0)));
+        }
+
+        for (int k = 0; k < numPairs; ++k) {
+            simde_mm_storeu_ps(&x_[4 * k], x[k]);
+            simde_mm_storeu_ps(&y_[4 * k], y[k]);
+        }
+    }
+
+private:
+    static constexpr int numPairs = (NC + 1) / 2;
+    float coefs_[4 * numPairs] {};
+    float x_[4 * numPairs] {};
+    float y_[4 * numPairs] {};
+};
+
+/**
+ * @brief Upsampler of interleaved stereo frames by 2, 4 or 8, with the same
+ * stages and filters as `Upsampler`.
+ */
+class StereoUpsampler {
+public:
+    StereoUpsampler() noexcept
+    {
+        up2_.setCoefs(OSCoeffs2x);
+        up4_.setCoefs(OSCoeffs4x);
+        up8_.setCoefs(OSCoeffs8x);
+    }
+
+    void clear() noexcept
+    {
+        up2_.clear();
+        up4_.clear();
+        up8_.clear();
+    }
+
+    /**
+     * @brief Get the number of floats of the temporary buffer of process()
+     *
+     * @param factor
+     * @param numFrames the most frames processed at once
+     */
+    static size_t recommendedBuffer(int factor, size_t numFrames) noexcept
+    {
+        switch (factor) {
+        case 4:
+            return 4 * numFrames;
+        case 8:
+            return 12 * numFrames;
+        default:
+            return 0;
+        }
+    }
+
+    static bool canProcess(int factor) noexcept
+    {
+        return factor == 1 || factor == 2 || factor == 4 || factor == 8;
+    }
+
+    /**
+     * @brief Upsample interleaved stereo frames.
+     *
+     * @param factor 1, 2, 4 or 8
+     * @param input the interleaved input, of numFrames frames
+     * @param output the interleaved output, of factor * numFrames frames
+     * @param numFrames
+     * @param temp a buffer of at least recommendedBuffer(factor, numFrames)
+     *             floats
+     */
+    void process(int factor, const float* input, float* output, size_t numFrames, float* temp) noexcept
+    {
+        switch (factor) {
+        case 1:
+            std::copy(input, input + 2 * numFrames, output);
+            break;
+        case 2:
+            up2_.process(input, output, numFrames);
+            break;
+        case 4:
+            up2_.process(input, temp, numFrames);
+            up4_.process(temp, output, 2 * numFrames);
+            break;
+        case 8:
+            up2_.process(input, temp, numFrames);
+            up4_.process(temp, temp + 4 * numFrames, 2 * numFrames);
+            up8_.process(temp + 4 * numFrames, output, 4 * numFrames);
+            break;
+        default:
+            ASSERTFALSE;
+            break;
+        }
+    }
+
+private:
+    StereoUpsampler2x<12> up2_;
+    StereoUpsampler2x<4> up4_;
+    StereoUpsampler2x<3> up8_;
+};
+
+} // namespace sfz
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "StreamBuffer.h"
+#include "Config.h"
+#include "MathHelpers.h"
+#include <cstdint>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sfz {
+
+static size_t getPageSize() noexcept
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwPageSize);
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    reset();
+}
+
+bool StreamBuffer::allocate(size_t numChannels, size_t numFrames) noexcept
+{
+    reset();
+    if (numChannels == 0 || numChannels > 2)
+        return false;
+
+    // Each channel starts on its own page, after the padding frames
+    const size_t pageSize = getPageSize();
+    auto roundUp = [pageSize](size_t size) { return (size + pageSize - 1) / pageSize * pageSize; };
+    const size_t paddingFrames = config::excessFileFrames;
+    const size_t paddingSize = roundUp(paddingFrames * sizeof(float));
+    const size_t channelSize = paddingSize + roundUp((numFrames + paddingFrames) * sizeof(float));
+    const size_t mappingSize = numChannels * channelSize;
+
+    // The pages are zero and take no memory until written
+#if defined(_WIN32)
+    void* mapping = VirtualAlloc(nullptr, mappingSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!mapping)
+        return false;
+#else
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return false;
+#endif
+
+    mapping_ = mapping;
+    mappingSize_ = mappingSize;
+    numChannels_ = numChannels;
+    numFrames_ = numFrames;
+    for (size_t c = 0; c < numChannels; ++c) {
+        unsigned char* channelStart = static_cast<unsigned char*>(mapping) + c * channelSize;
+        channels_[c] = reinterpret_cast<float*>(channelStart + paddingSize);
+    }
+    return true;
+}
+
+void StreamBuffer::reset() noexcept
+{
+    if (mapping_) {
+#if defined(_WIN32)
+        VirtualFree(mapping_, 0, MEM_RELEASE);
+#else
+        munmap(mapping_, mappingSize_);
+#endif
+    }
+
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    numChannels_ = 0;
+    numFrames_ = 0;
+    channels_[0] = nullptr;
+    channels_[1] = nullptr;
+}
+
+void StreamBuffer::release(size_t frameStart, size_t frameEnd) noexcept
+{
+    frameEnd = min(frameEnd, numFrames_);
+    if (frameStart >= frameEnd)
+        return;
+
+    const uintptr_t pageSize = getPageSize();
+    for (size_t c = 0; c < numChannels_; ++c) {
+        const uintptr_t rangeStart = reinterpret_cast<uintptr_t>(channels_[c] + frameStart);
+        const uintptr_t rangeEnd = reinterpret_cast<uintptr_t>(channels_[c] + frameEnd);
+        const uintptr_t pageStart = (rangeStart + pageSize - 1) / pageSize * pageSize;
+        const uintptr_t pageEnd = rangeEnd / pageSize * pageSize;
+        if (pageStart >= pageEnd)
+            continue;
+
+        void* pages = reinterpret_cast<void*>(pageStart);
+        const size_t size = static_cast<size_t>(pageEnd - pageStart);
+#if defined(_WIN32)
+        // Decommit and recommit, which keeps the pages readable as zeros
+        VirtualFree(pages, size, MEM_DECOMMIT);
+        VirtualAlloc(pages, size, MEM_COMMIT, PAGE_READWRITE);
+#else
+        madvise(pages, size, MADV_DONTNEED);
+#endif
+    }
+}
+
+AudioSpan<const float> StreamBuffer::getData(size_t numFrames) const noexcept
+{
+    const float* channels[2] { channels_[0], channels_[1] };
+    return AudioSpan<const float>(channels, numChannels_, 0, min(numFrames, numFrames_));
+}
+
+} // namespace sfz
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "AudioSpan.h"
+#include "utility/LeakDetector.h"
+#include <absl/types/span.h>
+#include <cstddef>
+
+namespace sfz {
+
+/**
+ * @brief A buffer which spans a whole audio file in address space, but only
+ * holds the pages which were written and not released in memory.
+ *
+ * This backs the bounded streams, which keep a window of frames around the
+ * play head. The buffer is surrounded by config::excessFileFrames frames of
+ * silence on each side, like the decoded buffers. Released frames read as
+ * silence until written again.
+ */
+class StreamBuffer {
+public:
+    StreamBuffer() = default;
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    /**
+     * @brief Reserve the address space of the buffer, releasing the
+     * previous one.
+     *
+     * @param numChannels the number of channels, 1 or 2
+     * @param numFrames the number of frames
+     * @return true if the reservation succeeded
+     */
+    bool allocate(size_t numChannels, size_t numFrames) noexcept;
+
+    /**
+     * @brief Give the whole buffer back to the system.
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Give the memory of a range of frames back to the system. Only
+     * the pages which lie entirely inside the range are released.
+     *
+     * @param frameStart the first frame of the range
+     * @param frameEnd the frame after the range
+     */
+    void release(size_t frameStart, size_t frameEnd) noexcept;
+
+    size_t getNumChannels() const noexcept { return numChannels_; }
+    size_t getNumFrames() const noexcept { return numFrames_; }
+    absl::Span<float> getSpan(size_t channel) noexcept { return { channels_[channel], numFrames_ }; }
+
+    /**
+     * @brief Get the first frames of the buffer
+     *
+     * @param numFrames the number of frames
+     */
+    AudioSpan<const float> getData(size_t numFrames) const noexcept;
+
+private:
+    void* mapping_ { nullptr };
+    size_t mappingSize_ { 0 };
+    size_t numChannels_ { 0 };
+    size_t numFrames_ { 0 };
+    float* channels_[2] {};
+
+    LEAK_DETECTOR(StreamBuffer);
+};
+
+} // namespace sfz
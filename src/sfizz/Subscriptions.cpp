@@ -0,0 +1,326 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Subscriptions.h"
+#include "Synth.h"
+#include "RTSemaphore.h"
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/strip.h>
+#include <absl/strings/numbers.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sfz {
+
+namespace {
+
+/**
+ * @brief Read the number of a path of the form `<prefix>&<suffix>`, or -1
+ * if a star is in place of the number.
+ */
+bool parseIndexedPath(absl::string_view path, absl::string_view prefix, absl::string_view suffix, int& index) noexcept
+{
+    if (!absl::ConsumePrefix(&path, prefix) || !absl::ConsumeSuffix(&path, suffix) || path.empty())
+        return false;
+
+    if (path == "*") {
+        index = -1;
+        return true;
+    }
+
+    for (char c : path) {
+        if (!absl::ascii_isdigit(static_cast<unsigned char>(c)))
+            return false;
+    }
+    return absl::SimpleAtoi(path, &index);
+}
+
+} // namespace
+
+/**
+ * @brief The thread which broadcasts the subscriptions of all the synths of
+ * the process which have a receiver. It starts with the first receiver, and
+ * waits on a semaphore while no path is subscribed, which the subscriptions
+ * post without locking.
+ */
+class SubscriptionThread {
+public:
+    ~SubscriptionThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            if (!running_)
+                return;
+            running_ = false;
+        }
+        wake();
+        thread_.join();
+    }
+
+    void add(Subscriptions* subscriptions)
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        if (std::find(members_.begin(), members_.end(), subscriptions) == members_.end())
+            members_.push_back(subscriptions);
+        if (!running_) {
+            running_ = true;
+            thread_ = std::thread(&SubscriptionThread::run, this);
+        }
+    }
+
+    void remove(Subscriptions* subscriptions)
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        members_.erase(std::remove(members_.begin(), members_.end(), subscriptions), members_.end());
+    }
+
+    /**
+     * @brief Wake the thread, which is real-time safe.
+     */
+    void wake() noexcept
+    {
+        std::error_code ec;
+        semWake_.post(ec);
+    }
+
+    /**
+     * @brief Call a function with the lock which guards the receivers.
+     */
+    template <class F>
+    void withLock(F&& function)
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        function();
+    }
+
+private:
+    void run()
+    {
+        using Clock = std::chrono::steady_clock;
+        const uint32_t periodMs = std::max(1, 1000 / config::maxSubscriptionRate);
+
+        while (true) {
+            bool active = false;
+            {
+                // The lock is held over the broadcasts, so the receivers do
+                // not change while they are called
+                std::lock_guard<std::mutex> lock { mutex_ };
+                if (!running_)
+                    return;
+                const double time = std::chrono::duration<double>(Clock::now() - start_).count();
+                for (Subscriptions* subscriptions : members_) {
+                    if (subscriptions->isActive()) {
+                        active = true;
+                        subscriptions->broadcast(time);
+                    }
+                }
+            }
+
+            std::error_code ec;
+            if (active)
+                semWake_.timed_wait(periodMs, ec);
+            else
+                semWake_.wait(ec);
+        }
+    }
+
+    const std::chrono::steady_clock::time_point start_ { std::chrono::steady_clock::now() };
+    std::mutex mutex_;
+    std::vector<Subscriptions*> members_;
+    RTSemaphore semWake_;
+    bool running_ { false };
+    std::thread thread_;
+};
+
+static SubscriptionThread subscriptionThread;
+
+Subscriptions::Subscriptions(const Synth& synth)
+    : synth_(synth)
+{
+}
+
+Subscriptions::~Subscriptions()
+{
+    setReceiver(nullptr, nullptr);
+}
+
+bool Subscriptions::subscribe(absl::string_view path, int rate) noexcept
+{
+    return setSubscription(path, std::max(1, std::min(rate, config::maxSubscriptionRate)));
+}
+
+bool Subscriptions::unsubscribe(absl::string_view path) noexcept
+{
+    return setSubscription(path, 0);
+}
+
+void Subscriptions::unsubscribeAll() noexcept
+{
+    for (auto& rate : rates_)
+        rate.store(0, std::memory_order_relaxed);
+    for (auto& word : ccMask_)
+        word.store(0, std::memory_order_relaxed);
+    for (auto& word : voiceMask_)
+        word.store(0, std::memory_order_relaxed);
+}
+
+template <size_t N>
+void Subscriptions::setMaskBit(Mask<N>& mask, int index, bool value) noexcept
+{
+    if (index < 0) {
+        for (auto& word : mask)
+            word.store(value ? ~uint64_t(0) : 0, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint64_t bit = uint64_t(1) << (index % 64);
+    if (value)
+        mask[index / 64].fetch_or(bit, std::memory_order_relaxed);
+    else
+        mask[index / 64].fetch_and(~bit, std::memory_order_relaxed);
+}
+
+template <size_t N>
+bool Subscriptions::getMaskBit(const Mask<N>& mask, size_t index) noexcept
+{
+    return (mask[index / 64].load(std::memory_order_relaxed) >> (index % 64)) & 1;
+}
+
+bool Subscriptions::setSubscription(absl::string_view path, int rate) noexcept
+{
+    Topic topic;
+    int index = 0;
+    bool maskEmpty = true;
+    if (path == "/num_active_voices")
+        topic = kTopicActiveVoices;
+    else if (path == "/underruns/count")
+        topic = kTopicUnderrunCount;
+    else if (path == "/underruns/missing_frames")
+        topic = kTopicMissingFrames;
+    else if (parseIndexedPath(path, "/cc", "/value", index)) {
+        if (index >= static_cast<int>(config::numCCs))
+            return false;
+        topic = kTopicCCValues;
+        setMaskBit<config::numCCs>(ccMask_, index, rate > 0);
+        maskEmpty = std::all_of(ccMask_.begin(), ccMask_.end(),
+            [](const std::atomic<uint64_t>& word) { return word.load(std::memory_order_relaxed) == 0; });
+    }
+    else if (parseIndexedPath(path, "/voice", "/level", index)) {
+        if (index >= static_cast<int>(config::maxVoices))
+            return false;
+        topic = kTopicVoiceLevels;
+        setMaskBit<config::maxVoices>(voiceMask_, index, rate > 0);
+        maskEmpty = std::all_of(voiceMask_.begin(), voiceMask_.end(),
+            [](const std::atomic<uint64_t>& word) { return word.load(std::memory_order_relaxed) == 0; });
+    }
+    else
+        return false;
+
+    // The CCs and the voices share the rate of their topic, which stops
+    // with the last of them
+    if (rate > 0) {
+        rates_[topic].store(rate, std::memory_order_relaxed);
+        generations_[topic].fetch_add(1, std::memory_order_relaxed);
+        subscriptionThread.wake();
+    }
+    else if (maskEmpty)
+        rates_[topic].store(0, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool Subscriptions::isActive() const noexcept
+{
+    return std::any_of(rates_.begin(), rates_.end(),
+        [](const std::atomic<int>& rate) { return rate.load(std::memory_order_relaxed) > 0; });
+}
+
+void Subscriptions::setReceiver(sfizz_receive_t* receive, void* data)
+{
+    if (receive == nullptr)
+        subscriptionThread.remove(this);
+
+    subscriptionThread.withLock([&]() {
+        receive_ = receive;
+        receiveData_ = data;
+    });
+
+    if (receive != nullptr)
+        subscriptionThread.add(this);
+}
+
+void Subscriptions::broadcast(double time)
+{
+    Client client { receiveData_ };
+    client.setReceiveCallback(receive_);
+    if (!client.canReceive())
+        return;
+
+    const Synth::StateSnapshot snapshot = synth_.getStateSnapshot();
+    char path[32];
+
+    for (int topic = 0; topic < kNumTopics; ++topic) {
+        const int rate = rates_[topic].load(std::memory_order_relaxed);
+        if (rate <= 0)
+            continue;
+
+        // The new subscriptions receive all their values at once
+        const uint32_t generation = generations_[topic].load(std::memory_order_relaxed);
+        const bool renew = generation != seenGenerations_[topic];
+        if (!renew && time < nextTimes_[topic])
+            continue;
+        seenGenerations_[topic] = generation;
+        nextTimes_[topic] = time + 1.0 / rate;
+
+        switch (topic) {
+        case kTopicActiveVoices:
+            if (renew || snapshot.numActiveVoices != lastActiveVoices_) {
+                lastActiveVoices_ = snapshot.numActiveVoices;
+                client.receive<'i'>(0, "/num_active_voices", static_cast<int32_t>(lastActiveVoices_));
+            }
+            break;
+        case kTopicUnderrunCount:
+            if (renew || snapshot.numUnderruns != lastUnderrunCount_) {
+                lastUnderrunCount_ = snapshot.numUnderruns;
+                client.receive<'h'>(0, "/underruns/count", static_cast<int64_t>(lastUnderrunCount_));
+            }
+            break;
+        case kTopicMissingFrames:
+            if (renew || snapshot.numMissingFrames != lastMissingFrames_) {
+                lastMissingFrames_ = snapshot.numMissingFrames;
+                client.receive<'h'>(0, "/underruns/missing_frames", static_cast<int64_t>(lastMissingFrames_));
+            }
+            break;
+        case kTopicCCValues:
+            for (unsigned cc = 0; cc < config::numCCs; ++cc) {
+                const float value = snapshot.ccValues[cc];
+                if (!getMaskBit<config::numCCs>(ccMask_, cc) || (!renew && value == lastCCValues_[cc]))
+                    continue;
+                lastCCValues_[cc] = value;
+                std::snprintf(path, sizeof(path), "/cc%u/value", cc);
+                client.receive<'f'>(0, path, value);
+            }
+            break;
+        case kTopicVoiceLevels:
+            for (unsigned voice = 0; voice < config::maxVoices; ++voice) {
+                const float level = snapshot.voiceLevels[voice];
+                if (!getMaskBit<config::maxVoices>(voiceMask_, voice) || (!renew && level == lastVoiceLevels_[voice]))
+                    continue;
+                lastVoiceLevels_[voice] = level;
+                std::snprintf(path, sizeof(path), "/voice%u/level", voice);
+                client.receive<'f'>(0, path, level);
+            }
+            break;
+        }
+    }
+}
+
+} // namespace sfz
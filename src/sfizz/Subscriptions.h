@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Config.h"
+#include "Messaging.h"
+#include <absl/strings/string_view.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace sfz {
+
+class Synth;
+class SubscriptionThread;
+
+/**
+ * @brief The paths of the state of a synth which the clients subscribe to,
+ * and the thread which broadcasts their values as they change, at most at
+ * the rate asked for each.
+ *
+ * The paths are:
+ *  - `/num_active_voices`, the number of active voices
+ *  - `/cc&/value`, the value of a CC
+ *  - `/voice&/level`, the level of the amplitude envelope of a voice
+ *  - `/underruns/count` and `/underruns/missing_frames`, the streaming stats
+ *
+ * A star in place of the number of a CC or a voice subscribes to all of them.
+ *
+ * The subscriptions change from the messages, on any thread and without
+ * locking nor allocating. The broadcasts read the state snapshots of the
+ * synth from a thread which all the synths of the process share, so the
+ * changes between two broadcasts of a path coalesce into the last value, and
+ * the values which did not change are not broadcast again. The thread runs
+ * while a synth has a receiver, and sleeps until a path is subscribed.
+ */
+class Subscriptions {
+public:
+    explicit Subscriptions(const Synth& synth);
+    ~Subscriptions();
+
+    /**
+     * @brief Subscribe to a path, or change its rate.
+     *
+     * @param path the path of the state
+     * @param rate the most broadcasts per second, up to config::maxSubscriptionRate
+     * @return false if the path cannot be subscribed to
+     */
+    bool subscribe(absl::string_view path, int rate) noexcept;
+    /**
+     * @brief Unsubscribe from a path.
+     *
+     * @return false if the path cannot be subscribed to
+     */
+    bool unsubscribe(absl::string_view path) noexcept;
+    /**
+     * @brief Unsubscribe from all the paths.
+     */
+    void unsubscribeAll() noexcept;
+
+    /**
+     * @brief Set the function which receives the broadcasts, which is called
+     * from the thread of the subscriptions once a path is subscribed.
+     */
+    void setReceiver(sfizz_receive_t* receive, void* data);
+
+private:
+    friend class SubscriptionThread;
+    enum Topic {
+        kTopicActiveVoices,
+        kTopicUnderrunCount,
+        kTopicMissingFrames,
+        kTopicCCValues,
+        kTopicVoiceLevels,
+        kNumTopics,
+    };
+    bool setSubscription(absl::string_view path, int rate) noexcept;
+    /**
+     * @brief Is a path subscribed?
+     */
+    bool isActive() const noexcept;
+    /**
+     * @brief Broadcast the changes which are due at a time, in seconds.
+     */
+    void broadcast(double time);
+
+    template <size_t N>
+    using Mask = std::array<std::atomic<uint64_t>, (N + 63) / 64>;
+    template <size_t N>
+    static void setMaskBit(Mask<N>& mask, int index, bool value) noexcept;
+    template <size_t N>
+    static bool getMaskBit(const Mask<N>& mask, size_t index) noexcept;
+
+    const Synth& synth_;
+
+    // The state of the subscriptions, which the messages change
+    std::array<std::atomic<int>, kNumTopics> rates_ {};
+    std::array<std::atomic<uint32_t>, kNumTopics> generations_ {};
+    Mask<config::numCCs> ccMask_ {};
+    Mask<config::maxVoices> voiceMask_ {};
+
+    // The state of the broadcasts, which the thread keeps
+    std::array<double, kNumTopics> nextTimes_ {};
+    std::array<uint32_t, kNumTopics> seenGenerations_ {};
+    uint32_t lastActiveVoices_ { 0 };
+    uint64_t lastUnderrunCount_ { 0 };
+    uint64_t lastMissingFrames_ { 0 };
+    std::array<float, config::numCCs> lastCCValues_ {};
+    std::array<float, config::maxVoices> lastVoiceLevels_ {};
+
+    // The receiver, which the shared thread guards
+    sfizz_receive_t* receive_ { nullptr };
+    void* receiveData_ { nullptr };
+};
+
+} // namespace sfz
@@ -24,12 +24,15 @@
 #include "BeatClock.h"
 #include "Metronome.h"
 #include "SynthConfig.h"
+#include "Subscriptions.h"
+#include "RealtimeGuard.h"
 #include "ScopedFTZ.h"
 #include "utility/Base64.h"
 #include "utility/StringViewHelpers.h"
 #include "utility/Timing.h"
 #include "utility/XmlHelpers.h"
 #include "Voice.h"
+#include "VoicePools.h"
 #include "Interpolators.h"
 #include "parser/Parser.h"
 #include <absl/algorithm/container.h>
@@ -42,6 +45,7 @@
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <system_error>
 #include <utility>
 
 namespace sfz {
@@ -51,6 +55,7 @@ static constexpr bool loaderParsesPermissively = true;
 
 Synth::Synth()
 : impl_(new Impl) // NOLINT: (paul) I don't get why clang-tidy complains here
+, subscriptions_(new Subscriptions(*this))
 {
 }
 
@@ -64,11 +69,13 @@ Synth::Impl::Impl()
 {
     initializeSIMDDispatchers();
     initializeInterpolators();
+    // Calibrate the clock of the timings outside of the RT thread
+    CycleClock::secondsPerTick();
 
     parser_.setListener(this);
     effectFactory_.registerStandardEffectTypes();
     initEffectBuses();
-    resetVoices(config::numVoices);
+    resizeVoices(config::numVoices);
     resetDefaultCCValues();
     resetAllControllers(0);
 
@@ -88,6 +95,18 @@ Synth::Impl::~Impl()
     resources_.getFilePool().emptyFileLoadingQueues();
 }
 
+/**
+ * @brief Clean up the opcodes of a header once, rather than in each of
+ * the regions which inherit them.
+ */
+static void cleanUpOpcodes(std::vector<Opcode>& cleaned, const std::vector<Opcode>& members, OpcodeScope scope, OpcodeCleanupCache& cache)
+{
+    cleaned.clear();
+    cleaned.reserve(members.size());
+    for (const Opcode& member : members)
+        cleaned.push_back(cache.cleanUp(member, scope));
+}
+
 void Synth::Impl::onParseFullBlock(const std::string& header, const std::vector<Opcode>& members)
 {
     const auto newRegionSet = [&](OpcodeScope level) {
@@ -101,31 +120,38 @@ void Synth::Impl::onParseFullBlock(const std::string& header, const std::vector<
 
     switch (hash(header)) {
     case hash("global"):
-        globalOpcodes_ = members;
+        cleanUpOpcodes(globalOpcodes_, members, kOpcodeScopeRegion, opcodeCleanup_);
         newRegionSet(OpcodeScope::kOpcodeScopeGlobal);
         groupOpcodes_.clear();
         masterOpcodes_.clear();
         handleGlobalOpcodes(members);
+        resetRegionPrototype();
         break;
     case hash("control"):
         defaultPath_ = ""; // Always reset on a new control header
         handleControlOpcodes(members);
+        resetRegionPrototype();
         break;
     case hash("master"):
-        masterOpcodes_ = members;
+        cleanUpOpcodes(masterOpcodes_, members, kOpcodeScopeRegion, opcodeCleanup_);
         newRegionSet(OpcodeScope::kOpcodeScopeMaster);
         groupOpcodes_.clear();
         handleMasterOpcodes(members);
+        resetRegionPrototype();
         numMasters_++;
         break;
     case hash("group"):
-        groupOpcodes_ = members;
+        cleanUpOpcodes(groupOpcodes_, members, kOpcodeScopeRegion, opcodeCleanup_);
         newRegionSet(OpcodeScope::kOpcodeScopeGroup);
         handleGroupOpcodes(members, masterOpcodes_);
+        resetRegionPrototype();
         numGroups_++;
         break;
     case hash("region"):
-        buildRegion(members);
+        {
+            ScopedTiming timing { loadBreakdown_.regions, ScopedTiming::Operation::addToDuration };
+            buildRegion(members);
+        }
         break;
     case hash("curve"):
         resources_.getCurves().addCurveFromHeader(members);
@@ -153,44 +179,113 @@ void Synth::Impl::onParseWarning(const SourceRange& range, const std::string& me
     std::cerr << "Parse warning in " << relativePath << " at line " << range.start.lineNumber + 1 << ": " << message << '\n';
 }
 
+/**
+ * @brief Hash an opcode into a key. The lengths go before the strings, so
+ * that the bytes moved from the name to the value give another key.
+ */
+static uint64_t hashOpcode(const Opcode& opcode, uint64_t key) noexcept
+{
+    key = hashNumber(opcode.name.size(), key);
+    key = hash(opcode.name, key);
+    key = hashNumber(opcode.value.size(), key);
+    return hash(opcode.value, key);
+}
+
+void Synth::Impl::resetRegionPrototype()
+{
+    regionPrototype_.reset();
+    prototypeUnknownOpcodes_.clear();
+
+    uint64_t key = hash(defaultPath_);
+    key = hashNumber(octaveOffset_ * 12 + noteOffset_, key);
+    for (const std::vector<Opcode>* opcodes : { &globalOpcodes_, &masterOpcodes_, &groupOpcodes_ }) {
+        key = hashNumber(opcodes->size(), key);
+        for (const Opcode& opcode : *opcodes)
+            key = hashOpcode(opcode, key);
+    }
+    headerKey_ = key;
+}
+
+uint64_t Synth::Impl::getParsedRegionKey(int regionNumber, const std::vector<Opcode>& regionOpcodes) const noexcept
+{
+    uint64_t key = hashNumber(regionNumber, headerKey_);
+    key = hashNumber(regionOpcodes.size(), key);
+    for (const Opcode& opcode : regionOpcodes)
+        key = hashOpcode(opcode, key);
+    return key;
+}
+
 void Synth::Impl::buildRegion(const std::vector<Opcode>& regionOpcodes)
 {
     int regionNumber = static_cast<int>(layers_.size());
     MidiState& midiState = resources_.getMidiState();
-    Layer* lastLayer = new Layer(regionNumber, defaultPath_, midiState);
-    layers_.emplace_back(lastLayer);
-    Region* lastRegion = &lastLayer->getRegion();
 
-    //
-    auto parseOpcodes = [&](const std::vector<Opcode>& opcodes) {
+    // On a reload, the regions of unchanged opcodes skip their parse
+    const uint64_t key = getParsedRegionKey(regionNumber, regionOpcodes);
+    const ParsedRegion* previous = nullptr;
+    if (static_cast<size_t>(regionNumber) < previousParsedRegions_.size()
+        && previousParsedRegions_[regionNumber].key == key)
+        previous = &previousParsedRegions_[regionNumber];
+
+    auto parseOpcodes = [&](Region& region, const std::vector<Opcode>& opcodes, bool cleanOpcodes, std::vector<std::string>& unknownNames) {
         for (auto& opcode : opcodes) {
             const auto unknown = absl::c_find_if(unknownOpcodes_, [&](absl::string_view sv) { return sv.compare(opcode.name) == 0; });
             if (unknown != unknownOpcodes_.end()) {
+                unknownNames.push_back(opcode.name);
                 continue;
             }
 
-            if (!lastRegion->parseOpcode(opcode))
+            const bool parsed = cleanOpcodes ?
+                region.parseOpcode(opcodeCleanup_.cleanUp(opcode, kOpcodeScopeRegion), false) :
+                region.parseOpcode(opcode, false);
+            if (!parsed) {
                 unknownOpcodes_.emplace_back(opcode.name);
+                unknownNames.push_back(opcode.name);
+            }
         }
     };
 
-    parseOpcodes(globalOpcodes_);
-    parseOpcodes(masterOpcodes_);
-    parseOpcodes(groupOpcodes_);
-    parseOpcodes(regionOpcodes);
+    // The opcodes of the headers are parsed once into a prototype, which
+    // the regions copy before parsing their own
+    if (!previous && !regionPrototype_) {
+        regionPrototype_.reset(new Region(regionNumber, defaultPath_));
+        parseOpcodes(*regionPrototype_, globalOpcodes_, false, prototypeUnknownOpcodes_);
+        parseOpcodes(*regionPrototype_, masterOpcodes_, false, prototypeUnknownOpcodes_);
+        parseOpcodes(*regionPrototype_, groupOpcodes_, false, prototypeUnknownOpcodes_);
+    }
 
-    // Create the amplitude envelope
-    if (!lastRegion->flexAmpEG)
-        lastRegion->getOrCreateConnection(
-            ModKey::createNXYZ(ModId::AmpEG, lastRegion->id),
-            ModKey::createNXYZ(ModId::MasterAmplitude, lastRegion->id)).sourceDepth = 1.0f;
-    else
-        lastRegion->getOrCreateConnection(
-            ModKey::createNXYZ(ModId::Envelope, lastRegion->id, *lastRegion->flexAmpEG),
-            ModKey::createNXYZ(ModId::MasterAmplitude, lastRegion->id)).sourceDepth = 1.0f;
+    layers_.push_back(previous ?
+        layerArena_.create(*previous->region, midiState) :
+        layerArena_.create(*regionPrototype_, regionNumber, midiState));
+    Layer* lastLayer = layers_.back().get();
+    Region* lastRegion = &lastLayer->getRegion();
+
+    std::vector<std::string> regionUnknownOpcodes;
+    if (previous) {
+        regionUnknownOpcodes = previous->unknownOpcodes;
+        for (const std::string& name : regionUnknownOpcodes) {
+            if (absl::c_find(unknownOpcodes_, name) == unknownOpcodes_.end())
+                unknownOpcodes_.push_back(name);
+        }
+    } else {
+        regionUnknownOpcodes = prototypeUnknownOpcodes_;
+        parseOpcodes(*lastRegion, regionOpcodes, true, regionUnknownOpcodes);
+
+        // Create the amplitude envelope
+        if (!lastRegion->flexAmpEG)
+            lastRegion->getOrCreateConnection(
+                ModKey::createNXYZ(ModId::AmpEG, lastRegion->id),
+                ModKey::createNXYZ(ModId::MasterAmplitude, lastRegion->id)).sourceDepth = 1.0f;
+        else
+            lastRegion->getOrCreateConnection(
+                ModKey::createNXYZ(ModId::Envelope, lastRegion->id, *lastRegion->flexAmpEG),
+                ModKey::createNXYZ(ModId::MasterAmplitude, lastRegion->id)).sourceDepth = 1.0f;
+
+        if (octaveOffset_ != 0 || noteOffset_ != 0)
+            lastRegion->offsetAllKeys(octaveOffset_ * 12 + noteOffset_);
+    }
 
-    if (octaveOffset_ != 0 || noteOffset_ != 0)
-        lastRegion->offsetAllKeys(octaveOffset_ * 12 + noteOffset_);
+    parsedRegions_.push_back({ key, RegionPtr(new Region(*lastRegion)), std::move(regionUnknownOpcodes) });
 
     if (lastRegion->lastKeyswitch)
         lastKeyswitchLists_[*lastRegion->lastKeyswitch].push_back(lastLayer);
@@ -232,10 +327,16 @@ void Synth::Impl::buildRegion(const std::vector<Opcode>& regionOpcodes)
         const auto size = max(config::delayedReleaseVoices, keyLength);
         lastLayer->delayedSustainReleases_.reserve(size);
         lastLayer->delayedSostenutoReleases_.reserve(size);
+        lastLayer->pendingReleases_ = &pendingReleases_;
     }
 
     // Initialize status of Key switches, CC switches, etc
     lastLayer->initializeActivations();
+
+    if (asyncLoad_) {
+        asyncLoad_->numRegions_ = static_cast<int>(layers_.size());
+        asyncLoad_->reportProgress();
+    }
 }
 
 void Synth::Impl::addEffectBusesIfNecessary(uint16_t output)
@@ -278,11 +379,19 @@ void Synth::Impl::clear()
         list.clear();
     for (auto& list : ccActivationLists_)
         list.clear();
+    pedalCCs_.reset();
+    pendingReleases_.first = nullptr;
+    for (auto& index : noteVelocityIndex_) {
+        index.bucketStarts.clear();
+        index.buckets.clear();
+    }
+    noteVelocityIndexValid_ = false;
     previousKeyswitchLists_.clear();
 
     currentSet_ = nullptr;
     sets_.clear();
     layers_.clear();
+    layerArena_.clear();
     resources_.clearNonState();
     rootPath_.clear();
     numGroups_ = 0;
@@ -296,6 +405,11 @@ void Synth::Impl::clear()
     midiState.resetNoteStates();
     midiState.flushEvents();
     filePool.setRamLoading(config::loadInRam);
+    filePool.setMemoryMapping(config::memoryMapped);
+    filePool.setEncodedRamStorage(config::encodedInRam);
+    filePool.setCompactStorage(config::compactSamples);
+    filePool.setResampling(config::resampleSamples);
+    filePool.setDeduplication(config::deduplicateSamples);
     clearCCLabels();
     currentUsedCCs_.clear();
     sustainOrSostenuto_.clear();
@@ -308,17 +422,20 @@ void Synth::Impl::clear()
     globalOpcodes_.clear();
     masterOpcodes_.clear();
     groupOpcodes_.clear();
+    resetRegionPrototype();
     unknownOpcodes_.clear();
+    opcodeCleanup_.clear();
     modificationTime_ = absl::nullopt;
     playheadMoved_ = false;
 
     initEffectBuses();
+    prepareRenderLanes();
 }
 
 void Synth::Impl::handleMasterOpcodes(const std::vector<Opcode>& members)
 {
     for (auto& rawMember : members) {
-        const Opcode member = rawMember.cleanUp(kOpcodeScopeMaster);
+        const Opcode member = opcodeCleanup_.cleanUp(rawMember, kOpcodeScopeMaster);
 
         switch (member.lettersOnlyHash) {
         case hash("polyphony"):
@@ -335,7 +452,7 @@ void Synth::Impl::handleMasterOpcodes(const std::vector<Opcode>& members)
 void Synth::Impl::handleGlobalOpcodes(const std::vector<Opcode>& members)
 {
     for (auto& rawMember : members) {
-        const Opcode member = rawMember.cleanUp(kOpcodeScopeGlobal);
+        const Opcode member = opcodeCleanup_.cleanUp(rawMember, kOpcodeScopeGlobal);
 
         switch (member.lettersOnlyHash) {
         case hash("polyphony"):
@@ -359,7 +476,7 @@ void Synth::Impl::handleGroupOpcodes(const std::vector<Opcode>& members, const s
     absl::optional<unsigned> maxPolyphony;
 
     const auto parseOpcode = [&](const Opcode& rawMember) {
-        const Opcode member = rawMember.cleanUp(kOpcodeScopeGroup);
+        const Opcode member = opcodeCleanup_.cleanUp(rawMember, kOpcodeScopeGroup);
 
         switch (member.lettersOnlyHash) {
         case hash("group"):
@@ -393,7 +510,7 @@ void Synth::Impl::handleGroupOpcodes(const std::vector<Opcode>& members, const s
 void Synth::Impl::handleControlOpcodes(const std::vector<Opcode>& members)
 {
     for (auto& rawMember : members) {
-        const Opcode member = rawMember.cleanUp(kOpcodeScopeControl);
+        const Opcode member = opcodeCleanup_.cleanUp(rawMember, kOpcodeScopeControl);
 
         switch (member.lettersOnlyHash) {
         case hash("set_cc&"):
@@ -445,6 +562,31 @@ void Synth::Impl::handleControlOpcodes(const std::vector<Opcode>& members)
             FilePool& filePool = resources_.getFilePool();
             filePool.setRamLoading(member.read(Default::ramBased));
         } break;
+        case hash("hint_memory_mapped"):
+        {
+            FilePool& filePool = resources_.getFilePool();
+            filePool.setMemoryMapping(member.read(Default::memoryMapped));
+        } break;
+        case hash("hint_encoded_in_ram"):
+        {
+            FilePool& filePool = resources_.getFilePool();
+            filePool.setEncodedRamStorage(member.read(Default::encodedInRam));
+        } break;
+        case hash("hint_compact_samples"):
+        {
+            FilePool& filePool = resources_.getFilePool();
+            filePool.setCompactStorage(member.read(Default::compactSamples));
+        } break;
+        case hash("hint_resample_samples"):
+        {
+            FilePool& filePool = resources_.getFilePool();
+            filePool.setResampling(member.read(Default::resampleSamples));
+        } break;
+        case hash("hint_deduplicate_samples"):
+        {
+            FilePool& filePool = resources_.getFilePool();
+            filePool.setDeduplication(member.read(Default::deduplicateSamples));
+        } break;
         case hash("hint_stealing"):
             switch(hash(member.value)) {
             case hash("first"):
@@ -466,6 +608,30 @@ void Synth::Impl::handleControlOpcodes(const std::vector<Opcode>& members)
             config.sustainCancelsRelease = member.read(Default::sustainCancelsRelease);
         }
             break;
+        case hash("hint_voice_culling_threshold"):
+        {
+            SynthConfig& config = resources_.getSynthConfig();
+            config.voiceCullingThreshold = member.read(Default::voiceCullingThreshold);
+        }
+            break;
+        case hash("hint_tabulated_filters"):
+        {
+            SynthConfig& config = resources_.getSynthConfig();
+            config.tabulatedFilters = member.read(Default::tabulatedFilters);
+        }
+            break;
+        case hash("hint_control_rate_modulations"):
+        {
+            SynthConfig& config = resources_.getSynthConfig();
+            config.controlRateModulations = member.read(Default::controlRateModulations);
+        }
+            break;
+        case hash("hint_power_follower_stride"):
+        {
+            SynthConfig& config = resources_.getSynthConfig();
+            config.powerFollowerStride = member.read(Default::powerFollowerStride);
+        }
+            break;
         default:
             // Unsupported control opcode
             DBG("Unsupported control opcode: " << member.name);
@@ -485,7 +651,7 @@ void Synth::Impl::handleEffectOpcodes(const std::vector<Opcode>& rawMembers)
         if (opcode.lettersOnlyHash == hash("output"))
             output = opcode.read(Default::output);
 
-        members.push_back(opcode.cleanUp(kOpcodeScopeEffect));
+        members.push_back(opcodeCleanup_.cleanUp(opcode, kOpcodeScopeEffect));
     }
 
     addEffectBusesIfNecessary(output);
@@ -549,6 +715,7 @@ void Synth::Impl::handleEffectOpcodes(const std::vector<Opcode>& rawMembers)
     auto fx = effectFactory_.makeEffect(members);
     fx->setSampleRate(sampleRate_);
     fx->setSamplesPerBlock(samplesPerBlock_);
+    fx->loadFiles(resources_.getFilePool());
     getOrCreateBus(busIndex).addEffect(std::move(fx));
 }
 
@@ -610,6 +777,13 @@ void Synth::Impl::prepareSfzLoad(const fs::path& path)
     auto newPath_ = path.string();
     reloading = (lastPath_ == newPath_);
 
+    // Keep the parsed regions of the current file for the reload
+    previousParsedRegions_.clear();
+    if (reloading)
+        std::swap(previousParsedRegions_, parsedRegions_);
+    parsedRegions_.clear();
+    loadBreakdown_ = {};
+
     clear();
 
 #ifndef NDEBUG
@@ -636,40 +810,336 @@ void Synth::Impl::prepareSfzLoad(const fs::path& path)
 bool Synth::loadSfzFile(const fs::path& file)
 {
     Impl& impl = *impl_;
-    impl.prepareSfzLoad(file);
+    return impl.loadSfzFile(file);
+}
+
+bool Synth::loadConvertedFile(const fs::path& file, const std::function<std::string(const fs::path&)>& convert)
+{
+    Impl& impl = *impl_;
+    return impl.loadSfzFile(file, &convert);
+}
 
+bool Synth::Impl::loadSfzFile(const fs::path& file, const Parser::Converter* convert)
+{
     std::error_code ec;
     fs::path realFile = fs::canonical(file, ec);
+    if (ec)
+        realFile = file;
+    fs::path virtualFile = realFile;
+    if (convert)
+        virtualFile += ".sfz";
+
+    const std::lock_guard<SpinMutex> guard { loadMutex_ };
+    prepareSfzLoad(convert ? virtualFile : file);
+
     bool success = true;
-    Parser& parser = impl.parser_;
-    parser.parseFile(ec ? file : realFile);
+    parser_.setCacheDirectory(resources_.getFilePool().getCacheDirectory());
+    parser_.setIncludePrefetchThreads(config::includePrefetchThreads);
+    double parseDuration = 0.0;
+    {
+        ScopedTiming timing { parseDuration };
+        if (convert)
+            parser_.parseConvertedFile(virtualFile, realFile, *convert);
+        else
+            parser_.parseFile(realFile);
+    }
+    loadBreakdown_.parse = max(parseDuration - loadBreakdown_.regions, 0.0);
 
     // permissive parsing for compatibility
     if (!loaderParsesPermissively)
-        success = parser.getErrorCount() == 0;
+        success = parser_.getErrorCount() == 0;
 
-    success = success && !impl.layers_.empty();
+    success = success && !layers_.empty();
+
+    if (asyncLoad_ && asyncLoad_->isCanceled())
+        success = false;
 
     if (!success) {
         DBG("[sfizz] Loading failed");
-        auto& filePool = impl.resources_.getFilePool();
-        parser.clear();
-        filePool.clear();
+        abortSfzLoad();
         return false;
     }
 
-    impl.finalizeSfzLoad();
+    finalizeSfzLoad();
+
+    if (asyncLoad_ && asyncLoad_->isCanceled()) {
+        DBG("[sfizz] Loading canceled");
+        abortSfzLoad();
+        return false;
+    }
+
+    lastText_.clear();
+    lastConversion_ = nullptr;
+    if (convert) {
+        const Parser::Converter conversion = *convert;
+        lastConversion_ = [conversion, realFile]() { return conversion(realFile); };
+    }
+    return true;
+}
+
+void Synth::Impl::abortSfzLoad()
+{
+    // A canceled load may have built the instrument partly
+    if (asyncLoad_ && asyncLoad_->isCanceled()) {
+        clear();
+        lastPath_.clear();
+    }
+
+    parser_.clear();
+    resources_.getFilePool().clear();
+    parsedRegions_.clear();
+    previousParsedRegions_.clear();
+}
+
+void Synth::Impl::copyHostSettings(const Impl& other)
+{
+    resources_.getSynthConfig() = other.resources_.getSynthConfig();
+    resources_.getTuning() = other.resources_.getTuning();
+    resources_.getStretch() = other.resources_.getStretch();
+
+    FilePool& filePool = resources_.getFilePool();
+    const FilePool& otherFilePool = other.resources_.getFilePool();
+    filePool.setPreloadSize(otherFilePool.getPreloadSize());
+    filePool.setAdaptivePreloading(otherFilePool.isAdaptivePreloading());
+    filePool.copyLatencies(otherFilePool);
+    filePool.setCacheDirectory(otherFilePool.getCacheDirectory());
+    filePool.setLoadingParallelism(otherFilePool.getLoadingParallelism());
+    filePool.setStreamingWindow(otherFilePool.getStreamingWindow());
+    filePool.setMemoryBudget(otherFilePool.getMemoryBudget());
+    filePool.setImmediateRelease(otherFilePool.isImmediateRelease());
+    filePool.setNumaNode(otherFilePool.getNumaNode());
+    filePool.setOversamplingFactor(otherFilePool.getOversamplingFactor());
+    lazyKeyswitchPreloading_ = other.lazyKeyswitchPreloading_;
+    eagerKeyswitches_ = other.eagerKeyswitches_;
+    copyControllers(other);
+
+    voiceManager_.setVoiceBudget(other.voiceManager_.getVoiceBudget(), other.voiceManager_.getVoiceBudgetWeight());
+
+    maxProcessingRate_ = other.maxProcessingRate_;
+    volume_ = other.volume_;
+    stretchRatio_ = other.stretchRatio_;
+    broadcastReceiver = other.broadcastReceiver;
+    broadcastData = other.broadcastData;
+}
+
+void Synth::Impl::copyControllers(const Impl& other) noexcept
+{
+    MidiState& midiState = resources_.getMidiState();
+    const MidiState& otherMidiState = other.resources_.getMidiState();
+    for (int cc = 0; cc < config::numCCs; ++cc)
+        midiState.ccEvent(0, cc, otherMidiState.getCCValue(cc));
+    midiState.pitchBendEvent(0, otherMidiState.getPitchBend());
+    midiState.channelAftertouchEvent(0, otherMidiState.getChannelAftertouch());
+    midiState.programChangeEvent(0, otherMidiState.getProgram());
+    midiState.flushEvents();
+}
+
+std::unique_ptr<Synth::Impl> Synth::makeInstrument()
+{
+    Impl& impl = *impl_;
+    Synth staging;
+    staging.impl_->copyHostSettings(impl);
+    staging.setSamplesPerBlock(impl.hostSamplesPerBlock_);
+    staging.setSampleRate(impl.hostSampleRate_);
+    staging.setNumVoices(impl.numVoices_);
+    staging.setNumRenderThreads(getNumRenderThreads());
+    return std::move(staging.impl_);
+}
+
+std::unique_ptr<Synth::AsyncLoad> Synth::loadSfzFileAsync(const fs::path& file, LoadProgressCallback callback)
+{
+    std::unique_ptr<AsyncLoad> load { new AsyncLoad };
+    load->callback_ = std::move(callback);
+
+    // Prepare the new instrument aside, with the settings of the current one
+    load->built_ = makeInstrument().release();
+
+    AsyncLoad* loadPtr = load.get();
+    load->thread_ = std::thread([this, loadPtr, file]() {
+        Impl& built = *loadPtr->built_;
+        built.asyncLoad_ = loadPtr;
+        bool success = built.loadSfzFile(file);
+        built.asyncLoad_ = nullptr;
+
+        if (success) {
+            // Let renderBlock swap the instruments, unless canceled before
+            pendingLoad_.store(loadPtr);
+            while (!loadPtr->swapped_.timed_wait(config::swapWaitPeriod)) {
+                AsyncLoad* expected = loadPtr;
+                if (loadPtr->isCanceled() && pendingLoad_.compare_exchange_strong(expected, nullptr)) {
+                    success = false;
+                    break;
+                }
+            }
+        }
+
+        // Either the new instrument is left, or the previous one was swapped out
+        delete loadPtr->built_;
+        loadPtr->built_ = nullptr;
+        delete loadPtr->retired_;
+        loadPtr->retired_ = nullptr;
+
+        loadPtr->success_ = success;
+        loadPtr->reportProgress();
+        loadPtr->done_.store(true);
+    });
+
+    return load;
+}
+
+bool Synth::loadResidentProgram(int program, const fs::path& file)
+{
+    if (program < 0 || program >= config::numPrograms)
+        return false;
+
+    std::unique_ptr<Impl> instrument = makeInstrument();
+    if (!instrument->loadSfzFile(file))
+        return false;
+
+    if (program == activeProgram_) {
+        impl_ = std::move(instrument);
+        return true;
+    }
+
+    std::unique_ptr<Impl>& resident = residents_[program];
+    if (releasing_ == resident.get())
+        releasing_ = nullptr;
+    resident = std::move(instrument);
     return true;
 }
 
+void Synth::removeResidentProgram(int program)
+{
+    if (program < 0 || program >= config::numPrograms)
+        return;
+
+    if (program == activeProgram_) {
+        impl_ = std::move(base_);
+        activeProgram_ = -1;
+        if (releasing_ == impl_.get())
+            releasing_ = nullptr;
+        return;
+    }
+
+    std::unique_ptr<Impl>& resident = residents_[program];
+    if (releasing_ == resident.get())
+        releasing_ = nullptr;
+    resident.reset();
+}
+
+bool Synth::hasResidentProgram(int program) const noexcept
+{
+    if (program < 0 || program >= config::numPrograms)
+        return false;
+    return program == activeProgram_ || residents_[program] != nullptr;
+}
+
+void Synth::switchProgram(int program) noexcept
+{
+    const bool resident = residents_[program] != nullptr;
+    std::unique_ptr<Impl>& incoming = resident ? residents_[program] : base_;
+    if (!incoming || program == activeProgram_)
+        return;
+
+    Impl& previous = *impl_;
+    {
+        // The voices of the previous instrument end with their release
+        const std::unique_lock<SpinMutex> loadGuard { previous.loadMutex_, std::try_to_lock };
+        if (loadGuard.owns_lock()) {
+            for (auto& voice : previous.voiceManager_) {
+                if (!voice.isFree())
+                    voice.release(0);
+            }
+        }
+    }
+
+    // Another instrument which was still releasing stops
+    if (releasing_ && releasing_ != incoming.get()) {
+        const std::unique_lock<SpinMutex> loadGuard { releasing_->loadMutex_, std::try_to_lock };
+        if (loadGuard.owns_lock()) {
+            for (auto& voice : releasing_->voiceManager_)
+                voice.reset();
+        }
+    }
+
+    std::unique_ptr<Impl>& parking = (activeProgram_ >= 0) ? residents_[activeProgram_] : base_;
+    parking = std::move(impl_);
+    impl_ = std::move(incoming);
+    activeProgram_ = resident ? program : -1;
+    releasing_ = parking.get();
+
+    Impl& impl = *impl_;
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (loadGuard.owns_lock()) {
+        impl.copyControllers(previous);
+        impl.performProgramChange(0, program);
+    }
+}
+
+template <class F>
+void Synth::forEachInstrument(F&& function)
+{
+    function(*impl_);
+    if (base_)
+        function(*base_);
+    for (std::unique_ptr<Impl>& resident : residents_) {
+        if (resident)
+            function(*resident);
+    }
+}
+
+Synth::AsyncLoad::~AsyncLoad()
+{
+    wait();
+}
+
+void Synth::AsyncLoad::cancel() noexcept
+{
+    canceled_.store(true);
+}
+
+bool Synth::AsyncLoad::isDone() const noexcept
+{
+    return done_.load();
+}
+
+bool Synth::AsyncLoad::wait()
+{
+    if (thread_.joinable())
+        thread_.join();
+    return success_;
+}
+
+Synth::LoadProgress Synth::AsyncLoad::getProgress() const noexcept
+{
+    LoadProgress progress;
+    progress.numRegions = numRegions_.load(std::memory_order_relaxed);
+    progress.numFilesToPreload = numFilesToPreload_.load(std::memory_order_relaxed);
+    progress.numPreloadedFiles = numPreloadedFiles_.load(std::memory_order_relaxed);
+    progress.numBytesRead = numBytesRead_.load(std::memory_order_relaxed);
+    return progress;
+}
+
+void Synth::AsyncLoad::reportProgress()
+{
+    if (callback_)
+        callback_(getProgress());
+}
+
 bool Synth::loadSfzString(const fs::path& path, absl::string_view text)
 {
     Impl& impl = *impl_;
+    const std::lock_guard<SpinMutex> guard { impl.loadMutex_ };
     impl.prepareSfzLoad(path);
 
     bool success = true;
     Parser& parser = impl.parser_;
-    parser.parseString(path, text);
+    double parseDuration = 0.0;
+    {
+        ScopedTiming timing { parseDuration };
+        parser.parseString(path, text);
+    }
+    impl.loadBreakdown_.parse = max(parseDuration - impl.loadBreakdown_.regions, 0.0);
 
     // permissive parsing for compatibility
     if (!loaderParsesPermissively)
@@ -686,6 +1156,8 @@ bool Synth::loadSfzString(const fs::path& path, absl::string_view text)
     }
 
     impl.finalizeSfzLoad();
+    impl.lastText_ = std::string(text);
+    impl.lastConversion_ = nullptr;
     return true;
 }
 
@@ -694,10 +1166,37 @@ void Synth::Impl::setCurrentSwitch(uint8_t noteValue)
     currentSwitch_ = noteValue + 12 * octaveOffset_ + noteOffset_;
 }
 
+bool Synth::Impl::keyswitchPreloadNeeded(const Region& region) const noexcept
+{
+    if (!lazyKeyswitchPreloading_)
+        return true;
+
+    if (region.lastKeyswitch) {
+        const uint8_t sw = *region.lastKeyswitch;
+        return (currentSwitch_ && *currentSwitch_ == sw) || eagerKeyswitches_.test(sw);
+    }
+
+    if (region.lastKeyswitchRange) {
+        const auto& range = *region.lastKeyswitchRange;
+        if (currentSwitch_ && range.containsWithEnd(*currentSwitch_))
+            return true;
+        for (unsigned note = range.getStart(), end = range.getEnd(); note <= end; ++note) {
+            if (eagerKeyswitches_.test(note))
+                return true;
+        }
+        return false;
+    }
+
+    return true;
+}
+
 void Synth::Impl::finalizeSfzLoad()
 {
+    ScopedTiming finalizeTiming { loadBreakdown_.finalize };
     FilePool& filePool = resources_.getFilePool();
     WavetablePool& wavePool = resources_.getWavePool();
+    previousParsedRegions_.clear();
+    opcodeCleanup_.clear();
 
     const fs::path& rootDirectory = parser_.originalDirectory();
     filePool.setRootDirectory(rootDirectory);
@@ -708,12 +1207,17 @@ void Synth::Impl::finalizeSfzLoad()
     size_t currentRegionIndex = 0;
     size_t currentRegionCount = layers_.size();
 
-    absl::flat_hash_map<sfz::FileId, int64_t> filesToLoad;
+    std::vector<FilePool::FileToPreload> filesToLoad;
+    absl::flat_hash_map<sfz::FileId, size_t> filesToLoadIndices;
+
+    // by region, whether its sample was found
+    std::vector<uint8_t> samplesFound(layers_.size(), 0);
 
-    auto removeCurrentRegion = [this, &currentRegionIndex, &currentRegionCount]() {
+    auto removeCurrentRegion = [this, &currentRegionIndex, &currentRegionCount, &samplesFound]() {
         const Region& region = layers_[currentRegionIndex]->getRegion();
         DBG("Removing the region with sample " << *region.sampleId);
         layers_.erase(layers_.begin() + currentRegionIndex);
+        samplesFound.erase(samplesFound.begin() + currentRegionIndex);
         --currentRegionCount;
     };
 
@@ -721,6 +1225,7 @@ void Synth::Impl::finalizeSfzLoad()
     size_t maxEQs { 0 };
     size_t maxLFOs { 0 };
     size_t maxFlexEGs { 0 };
+    int maxBufferNesting { 0 };
     bool havePitchEG { false };
     bool haveFilterEG { false };
     bool haveAmplitudeLFO { false };
@@ -729,6 +1234,51 @@ void Synth::Impl::finalizeSfzLoad()
 
     FlexEGs::clearUnusedCurves();
 
+    // Find and read the information of all the samples concurrently beforehand
+    {
+        std::vector<sfz::FileId> samples;
+        std::vector<size_t> sampleRegions;
+        samples.reserve(layers_.size());
+        sampleRegions.reserve(layers_.size());
+        for (size_t i = 0; i < layers_.size(); ++i) {
+            const Region& region = layers_[i]->getRegion();
+            if (!region.isGenerator()) {
+                samples.push_back(*region.sampleId);
+                sampleRegions.push_back(i);
+            }
+        }
+
+        const std::vector<uint8_t> found = filePool.checkSampleIds(samples);
+        std::vector<sfz::FileId> existingSamples;
+        existingSamples.reserve(samples.size());
+        for (size_t i = 0; i < samples.size(); ++i) {
+            if (!found[i])
+                continue;
+            const size_t regionIndex = sampleRegions[i];
+            *layers_[regionIndex]->getRegion().sampleId = samples[i];
+            samplesFound[regionIndex] = 1;
+            existingSamples.push_back(samples[i]);
+        }
+        filePool.probeFileInformation(existingSamples);
+    }
+
+    // Build the wavetables of the files concurrently beforehand too
+    {
+        std::vector<std::string> fileWaves;
+        for (size_t i = 0; i < layers_.size(); ++i) {
+            Region& region = layers_[i]->getRegion();
+            if (region.isGenerator() || !samplesFound[i])
+                continue;
+            const auto fileInformation = filePool.getFileInformation(*region.sampleId);
+            if (!fileInformation)
+                continue;
+            region.hasWavetableSample = fileInformation->wavetable.has_value();
+            if (region.isOscillator())
+                fileWaves.emplace_back(region.sampleId->filename());
+        }
+        wavePool.createFileWaves(filePool, fileWaves);
+    }
+
     while (currentRegionIndex < currentRegionCount) {
         Layer& layer = *layers_[currentRegionIndex];
         Region& region = layer.getRegion();
@@ -736,7 +1286,7 @@ void Synth::Impl::finalizeSfzLoad()
         absl::optional<FileInformation> fileInformation;
 
         if (!region.isGenerator()) {
-            if (!filePool.checkSampleId(*region.sampleId)) {
+            if (!samplesFound[currentRegionIndex]) {
                 removeCurrentRegion();
                 continue;
             }
@@ -754,7 +1304,7 @@ void Synth::Impl::finalizeSfzLoad()
                 bool allZeros = true;
                 int numChannels = sample->information.numChannels;
                 for (int i = 0; i < numChannels; ++i) {
-                    allZeros &= allWithin(sample->preloadedData.getConstSpan(i),
+                    allZeros &= allWithin(sample->preloadedData->getConstSpan(i),
                         -config::virtuallyZero, config::virtuallyZero);
                 }
 
@@ -803,15 +1353,64 @@ void Synth::Impl::finalizeSfzLoad()
                 return Default::offsetMod.bounds.clamp(sumOffsetCC);
             }();
 
-            auto& toLoad = filesToLoad[*region.sampleId];
-            toLoad = max(toLoad, maxOffset);
+            // The start frames which the voices can reach, with the offset
+            // controller at each MIDI value; with several of them, anywhere
+            // up to the maximal offset
+            const auto startRanges = [&region, maxOffset]() {
+                std::vector<FrameRange> ranges;
+                auto addRange = [&](int64_t offset) {
+                    const auto start = static_cast<uint32_t>(min(Default::offset.bounds.clamp(offset), int64_t(maxOffset)));
+                    const auto last = static_cast<uint32_t>(min(Default::offset.bounds.clamp(offset + region.offsetRandom), int64_t(maxOffset)));
+                    ranges.push_back({ start, last + 1 });
+                };
+                if (region.offsetCC.empty())
+                    addRange(region.offset);
+                else if (region.offsetCC.size() == 1) {
+                    const int64_t depth = region.offsetCC.begin()->data;
+                    for (int value = 0; value <= 127; ++value)
+                        addRange(region.offset + static_cast<int64_t>(depth * normalize7Bits(value)));
+                }
+                else
+                    ranges.push_back({ 0, static_cast<uint32_t>(maxOffset) + 1 });
+                return ranges;
+            }();
+
+            // The regions played faster than the original read their
+            // preload sooner, and the ones played slower later
+            const float preloadRatio = clamp(region.getMaxPitchRatio(),
+                config::minPreloadRatio, config::maxPreloadRatio);
+
+            // The files of the articulations out of reach wait for their
+            // keyswitch, unless another region needs them
+            const bool deferred = !keyswitchPreloadNeeded(region);
+
+            // The sustained loops only stream up to their end, until a
+            // release of a loop_sustain leaves the loop
+            const bool fixedLoop = region.shouldLoop() && !region.loopCount
+                && region.loopStartCC.empty() && region.loopEndCC.empty()
+                && static_cast<int64_t>(maxOffset) <= region.loopRange.getEnd();
+            const int64_t loopEnd = fixedLoop ? region.loopRange.getEnd() : -1;
+
+            const auto index = filesToLoadIndices.emplace(*region.sampleId, filesToLoad.size());
+            if (index.second)
+                filesToLoad.push_back({ *region.sampleId, 0, 0.0f, deferred, loopEnd });
+            auto& toLoad = filesToLoad[index.first->second];
+            toLoad.maxOffset = max(toLoad.maxOffset, static_cast<uint32_t>(maxOffset));
+            toLoad.preloadRatio = max(toLoad.preloadRatio, preloadRatio);
+            toLoad.deferred = toLoad.deferred && deferred;
+            toLoad.loopEnd = (toLoad.loopEnd < 0 || loopEnd < 0) ? -1 : max(toLoad.loopEnd, loopEnd);
+            toLoad.startRanges.insert(toLoad.startRanges.end(), startRanges.begin(), startRanges.end());
         }
         else if (!region.isGenerator()) {
-            if (!wavePool.createFileWave(filePool, std::string(region.sampleId->filename()))) {
+            const std::string filename { region.sampleId->filename() };
+            if (!wavePool.createFileWave(filePool, filename)) {
                 removeCurrentRegion();
                 continue;
             }
+            region.wave = wavePool.getFileWave(filename);
         }
+        else
+            region.wave = WavetablePool::getGeneratorWave(region.sampleId->filename());
 
         if (region.lastKeyswitch) {
             if (currentSwitch_)
@@ -832,19 +1431,25 @@ void Synth::Impl::finalizeSfzLoad()
             }
         }
 
-        for (auto note = 0; note < 128; note++) {
-            if (region.keyRange.containsWithEnd(note))
-                noteActivationLists_[note].push_back(&layer);
-        }
+        {
+            ScopedTiming timing { loadBreakdown_.activation, ScopedTiming::Operation::addToDuration };
+            for (auto note = 0; note < 128; note++) {
+                if (region.keyRange.containsWithEnd(note))
+                    noteActivationLists_[note].push_back(&layer);
+            }
 
-        for (int cc = 0; cc < config::numCCs; cc++) {
-            if (region.ccTriggers.contains(cc)
-                || region.ccConditions.contains(cc)
-                || (cc == region.sustainCC && region.trigger == Trigger::release)
-                || (cc == region.sostenutoCC && region.trigger == Trigger::release))
-                ccActivationLists_[cc].push_back(&layer);
+            for (int cc = 0; cc < config::numCCs; cc++) {
+                if (region.ccTriggers.contains(cc)
+                    || region.ccConditions.contains(cc)
+                    || (cc == region.sustainCC && region.trigger == Trigger::release)
+                    || (cc == region.sostenutoCC && region.trigger == Trigger::release))
+                    ccActivationLists_[cc].push_back(&layer);
+            }
         }
 
+        pedalCCs_.set(region.sustainCC);
+        pedalCCs_.set(region.sostenutoCC);
+
         // Defaults
         MidiState& midiState = resources_.getMidiState();
         for (int cc = 0; cc < config::numCCs; cc++) {
@@ -878,6 +1483,7 @@ void Synth::Impl::finalizeSfzLoad()
         maxEQs = max(maxEQs, region.equalizers.size());
         maxLFOs = max(maxLFOs, region.lfos.size());
         maxFlexEGs = max(maxFlexEGs, region.flexEGs.size());
+        maxBufferNesting = max(maxBufferNesting, region.getBufferNesting());
         havePitchEG = havePitchEG || region.pitchEG != absl::nullopt;
         haveFilterEG = haveFilterEG || region.filterEG != absl::nullopt;
         haveAmplitudeLFO = haveAmplitudeLFO || region.amplitudeLFO != absl::nullopt;
@@ -893,13 +1499,27 @@ void Synth::Impl::finalizeSfzLoad()
     if (reloading)
         filePool.resetPreloadCallCounts();
 
-    for (const auto& toLoad: filesToLoad)
-        filePool.preloadFile(toLoad.first, toLoad.second);
+    if (!asyncLoad_)
+        filePool.preloadFiles(filesToLoad);
+    else {
+        AsyncLoad& load = *asyncLoad_;
+        load.numFilesToPreload_ = filesToLoad.size();
+        load.reportProgress();
+        filePool.preloadFiles(filesToLoad, [&load](const FilePool::PreloadProgress& progress) {
+            load.numPreloadedFiles_ = progress.numPreloadedFiles;
+            load.numBytesRead_ = progress.numBytesRead;
+            load.reportProgress();
+            return !load.isCanceled();
+        });
+    }
+    filePool.clearProbedFileInformation();
 
     // Remove preloaded data with no linked regions
     if (reloading)
         filePool.removeUnusedPreloadedData();
 
+    filePool.applyMemoryBudget();
+
     // Remove bad regions with unknown files
     if (currentRegionCount < layers_.size()) {
         DBG("Removing " << (layers_.size() - currentRegionCount)
@@ -907,6 +1527,13 @@ void Synth::Impl::finalizeSfzLoad()
     }
     layers_.resize(currentRegionCount);
 
+    // Resolve the data of the samples, so the voices start without lookups
+    for (const LayerPtr& layerPtr : layers_) {
+        const Region& region = layerPtr->getRegion();
+        if (!region.isGenerator())
+            filePool.resolveFile(*region.sampleId, region.sampleSlot);
+    }
+
     // collect all CCs used in regions, with matrix not yet connected
     BitArray<config::numCCs> usedCCs;
     for (const LayerPtr& layerPtr : layers_) {
@@ -949,10 +1576,14 @@ void Synth::Impl::finalizeSfzLoad()
     settingsPerVoice_.haveAmplitudeLFO = haveAmplitudeLFO;
     settingsPerVoice_.havePitchLFO = havePitchLFO;
     settingsPerVoice_.haveFilterLFO = haveFilterLFO;
+    settingsPerVoice_.maxBufferNesting = maxBufferNesting;
 
     applySettingsPerVoice();
     addEffectBusesIfNecessary(numOutputs_);
-    setupModMatrix();
+    {
+        ScopedTiming timing { loadBreakdown_.modMatrix };
+        setupModMatrix();
+    }
 
     // cache the set of used CCs for future access
     currentUsedCCs_ = collectAllUsedCCs();
@@ -979,6 +1610,80 @@ void Synth::Impl::finalizeSfzLoad()
                 swLastSlots_.set(key);
         }
     }
+
+    {
+        ScopedTiming timing { loadBreakdown_.activation, ScopedTiming::Operation::addToDuration };
+        buildNoteVelocityIndex();
+    }
+    prepareRenderLanes();
+    // The instrument may have more outputs to upsample
+    prepareOutputUpsampler();
+}
+
+void Synth::Impl::buildNoteVelocityIndex()
+{
+    // These layers are visited on every note-on of their keys: sequences count
+    // all the notes, and velocity overrides do not match on the note velocity
+    auto visitedOnAllVelocities = [](const Region& region) {
+        return region.sequenceLength > 1 || region.velocityOverride == VelocityOverride::previous;
+    };
+
+    for (int note = 0; note < 128; ++note) {
+        const LayerViewVector& layers = noteActivationLists_[note];
+        NoteVelocityIndex& index = noteVelocityIndex_[note];
+        std::vector<float>& starts = index.bucketStarts;
+        std::vector<LayerViewVector>& buckets = index.buckets;
+
+        // Every velocity range boundary starts a bucket
+        starts.clear();
+        starts.push_back(0.0f);
+        for (const Layer* layer : layers) {
+            const Region& region = layer->getRegion();
+            if (!visitedOnAllVelocities(region) && region.velocityRange.isValid()) {
+                starts.push_back(region.velocityRange.getStart());
+                starts.push_back(region.velocityRange.getEnd());
+            }
+        }
+        std::sort(starts.begin(), starts.end());
+        starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+        // A layer goes in all the buckets which start within its range; this
+        // keeps the candidates a superset of the matching layers
+        buckets.resize(starts.size());
+        for (LayerViewVector& bucket : buckets)
+            bucket.clear();
+        for (Layer* layer : layers) {
+            const Region& region = layer->getRegion();
+            if (visitedOnAllVelocities(region)) {
+                for (LayerViewVector& bucket : buckets)
+                    bucket.push_back(layer);
+                continue;
+            }
+
+            if (!region.velocityRange.isValid())
+                continue;
+
+            const float lo = region.velocityRange.getStart();
+            const float hi = region.velocityRange.getEnd();
+            auto it = std::lower_bound(starts.begin(), starts.end(), lo);
+            for (; it != starts.end() && *it <= hi; ++it)
+                buckets[std::distance(starts.begin(), it)].push_back(layer);
+        }
+    }
+
+    noteVelocityIndexValid_ = true;
+}
+
+const Synth::Impl::LayerViewVector& Synth::Impl::noteOnCandidates(int noteNumber, float velocity) const noexcept
+{
+    const NoteVelocityIndex& index = noteVelocityIndex_[noteNumber];
+    const std::vector<float>& starts = index.bucketStarts;
+
+    if (!noteVelocityIndexValid_ || starts.empty() || velocity < starts.front())
+        return noteActivationLists_[noteNumber];
+
+    auto it = std::upper_bound(starts.begin(), starts.end(), velocity);
+    return index.buckets[std::distance(starts.begin(), it) - 1];
 }
 
 bool Synth::loadScalaFile(const fs::path& path)
@@ -1022,12 +1727,15 @@ void Synth::loadStretchTuningByRatio(float ratio)
     Impl& impl = *impl_;
     SFIZZ_CHECK(ratio >= 0.0f && ratio <= 1.0f);
     ratio = clamp(ratio, 0.0f, 1.0f);
+    impl.stretchRatio_ = ratio;
 
     absl::optional<StretchTuning>& stretch = impl.resources_.getStretch();
     if (ratio > 0.0f)
         stretch = StretchTuning::createRailsbackFromRatio(ratio);
     else
         stretch.reset();
+
+    impl.resources_.getTuning().setStretchTuning(stretch ? &*stretch : nullptr);
 }
 
 int Synth::getNumActiveVoices() const noexcept
@@ -1049,67 +1757,353 @@ std::vector<const Voice*> Synth::getActiveVoices() const noexcept
 
 void Synth::setSamplesPerBlock(int samplesPerBlock) noexcept
 {
-    Impl& impl = *impl_;
     ASSERT(samplesPerBlock <= config::maxBlockSize);
 
-    impl.samplesPerBlock_ = samplesPerBlock;
-    for (auto& voice : impl.voiceManager_)
+    forEachInstrument([samplesPerBlock](Impl& impl) {
+        impl.hostSamplesPerBlock_ = samplesPerBlock;
+        impl.updateProcessingRate();
+    });
+}
+
+void Synth::Impl::setProcessingBlockSize(int samplesPerBlock)
+{
+    samplesPerBlock_ = samplesPerBlock;
+    for (auto& voice : voiceManager_)
         voice.setSamplesPerBlock(samplesPerBlock);
 
-    impl.resources_.setSamplesPerBlock(samplesPerBlock);
+    sizeBufferPools();
+    resources_.setSamplesPerBlock(samplesPerBlock);
 
-    for (int i = 0; i < impl.numOutputs_; ++i) {
-        for (auto& bus : impl.getEffectBusesForOutput(i)) {
+    for (int i = 0; i < numOutputs_; ++i) {
+        for (auto& bus : getEffectBusesForOutput(i)) {
             if (bus)
                 bus->setSamplesPerBlock(samplesPerBlock);
         }
     }
+
+    prepareRenderLanes();
 }
 
 int Synth::getSamplesPerBlock() const noexcept
 {
     Impl& impl = *impl_;
-    return impl.samplesPerBlock_;
+    return impl.hostSamplesPerBlock_;
 }
 
 void Synth::setSampleRate(float sampleRate) noexcept
 {
-    Impl& impl = *impl_;
+    forEachInstrument([sampleRate](Impl& impl) {
+        impl.hostSampleRate_ = sampleRate;
+        impl.updateProcessingRate();
+    });
+}
 
-    impl.sampleRate_ = sampleRate;
-    for (auto& voice : impl.voiceManager_)
+void Synth::Impl::setProcessingSampleRate(float sampleRate)
+{
+    // The voices play the data resampled at the former rate
+    if (resources_.getFilePool().isResampling() && sampleRate != sampleRate_) {
+        for (auto& voice : voiceManager_)
+            voice.reset();
+    }
+
+    sampleRate_ = sampleRate;
+    voiceManager_.setSampleRate(sampleRate);
+    for (auto& voice : voiceManager_)
         voice.setSampleRate(sampleRate);
 
-    impl.resources_.setSampleRate(sampleRate);
+    resources_.setSampleRate(sampleRate);
 
-    for (int i = 0; i < impl.numOutputs_; ++i) {
-        for (auto& bus : impl.getEffectBusesForOutput(i)) {
+    for (int i = 0; i < numOutputs_; ++i) {
+        for (auto& bus : getEffectBusesForOutput(i)) {
             if (bus)
                 bus->setSampleRate(sampleRate);
         }
     }
 }
 
-void Synth::renderBlock(AudioSpan<float> buffer) noexcept
+int Synth::Impl::processingFactor() const noexcept
+{
+    int factor = 1;
+    if (maxProcessingRate_ > 0.0f) {
+        while (factor < 8 && hostSampleRate_ > factor * maxProcessingRate_)
+            factor *= 2;
+    }
+    return factor;
+}
+
+void Synth::Impl::updateProcessingRate()
+{
+    const int factor = processingFactor();
+    const int samplesPerBlock = (hostSamplesPerBlock_ + factor - 1) / factor;
+    const float sampleRate = hostSampleRate_ / factor;
+
+    setProcessingBlockSize(samplesPerBlock);
+    setProcessingSampleRate(sampleRate);
+    prepareOutputUpsampler();
+}
+
+void Synth::Impl::prepareOutputUpsampler()
+{
+    const int factor = processingFactor();
+    const size_t numChannels = (factor > 1) ? 2 * static_cast<size_t>(numOutputs_) : 0;
+    const size_t maxFrames = (factor > 1) ? static_cast<size_t>(hostSamplesPerBlock_) : 0;
+    outputUpsampler_.prepare(factor, numChannels, maxFrames);
+}
+
+int Synth::Impl::processingDelay(int delay) const noexcept
+{
+    const int factor = outputUpsampler_.getFactor();
+    if (factor == 1)
+        return delay;
+
+    // The next block starts after the frames upsampled ahead
+    const int pendingFrames = static_cast<int>(outputUpsampler_.getPendingFrames());
+    return std::max(0, delay - pendingFrames) / factor;
+}
+
+void Synth::setMaxProcessingRate(float sampleRate) noexcept
+{
+    sampleRate = std::max(0.0f, sampleRate);
+    forEachInstrument([sampleRate](Impl& impl) {
+        if (sampleRate == impl.maxProcessingRate_)
+            return;
+
+        impl.maxProcessingRate_ = sampleRate;
+        impl.updateProcessingRate();
+    });
+}
+
+float Synth::getMaxProcessingRate() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.maxProcessingRate_;
+}
+
+float Synth::getProcessingRate() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.sampleRate_;
+}
+
+int Synth::getLatency() const noexcept
 {
     Impl& impl = *impl_;
+    return impl.outputUpsampler_.getLatency();
+}
+
+/**
+ * @brief The destination of a block: a planar buffer, replaced or added to,
+ * or an interleaved buffer.
+ */
+struct Synth::RenderTarget {
+    AudioSpan<float> planar;
+    float* interleaved { nullptr };
+    size_t numChannels { 0 };
+    size_t numFrames { 0 };
+    bool adding { false };
+
+    // whether the outputs mix in place into the planar buffer
+    bool inPlace() const noexcept { return !interleaved && !adding; }
+
+    void clear() noexcept
+    {
+        if (interleaved)
+            std::fill(interleaved, interleaved + numChannels * numFrames, 0.0f);
+        else
+            planar.fill(0.0f);
+    }
+
+    /**
+     * @brief Deliver a stereo output, unless in place
+     *
+     * @param output the output, with the master volume applied
+     * @param start the first channel of the output
+     * @param add whether to add the output instead of replacing the channels
+     */
+    void deliver(AudioSpan<float, 2> output, size_t start, bool add) noexcept
+    {
+        if (!interleaved) {
+            AudioSpan<float, 2> destination = planar.getStereoSpan(start);
+            destination.add(output);
+            return;
+        }
+
+        const float* left = output.getChannel(0);
+        const float* right = output.getChannel(1);
+        if (numChannels == 2) {
+            if (add)
+                addInterleaved(left, right, interleaved, static_cast<unsigned>(2 * numFrames));
+            else
+                writeInterleaved(left, right, interleaved, static_cast<unsigned>(2 * numFrames));
+            return;
+        }
+
+        float* frame = interleaved + start;
+        for (size_t i = 0; i < numFrames; ++i, frame += numChannels) {
+            frame[0] = add ? frame[0] + left[i] : left[i];
+            frame[1] = add ? frame[1] + right[i] : right[i];
+        }
+    }
+
+    /**
+     * @brief Write the outputs upsampled from the processing rate, which
+     * wrap around the channels of the target as the outputs of a block do
+     *
+     * @param outputs the channels of all outputs, with the master volume
+     */
+    void write(AudioSpan<const float> outputs) noexcept
+    {
+        if (!adding)
+            clear();
+        if (numChannels == 0)
+            return;
+
+        for (size_t c = 0, n = outputs.getNumChannels(); c < n; ++c) {
+            const float* source = outputs.getChannel(c);
+            const size_t channel = c % numChannels;
+            if (!interleaved) {
+                add<float>(outputs.getConstSpan(c), planar.getSpan(channel));
+                continue;
+            }
+            float* frame = interleaved + channel;
+            for (size_t i = 0; i < numFrames; ++i, frame += numChannels)
+                *frame += source[i];
+        }
+    }
+};
+
+void Synth::renderBlock(AudioSpan<float> buffer) noexcept
+{
+    RenderTarget target;
+    target.planar = buffer;
+    target.numChannels = buffer.getNumChannels();
+    target.numFrames = buffer.getNumFrames();
+    renderBlock(target);
+}
+
+void Synth::renderBlockAdding(AudioSpan<float> buffer) noexcept
+{
+    RenderTarget target;
+    target.planar = buffer;
+    target.numChannels = buffer.getNumChannels();
+    target.numFrames = buffer.getNumFrames();
+    target.adding = true;
+    renderBlock(target);
+}
+
+void Synth::renderBlockInterleaved(float* buffer, size_t numChannels, size_t numFrames, bool adding) noexcept
+{
+    RenderTarget target;
+    target.interleaved = buffer;
+    target.numChannels = numChannels;
+    target.numFrames = numFrames;
+    target.adding = adding;
+    renderBlock(target);
+}
+
+void Synth::renderBlock(RenderTarget& target) noexcept
+{
+    RealtimeGuard::Scope realtimeScope;
+
+    // Swap in the instrument of a complete asynchronous load
+    if (AsyncLoad* load = pendingLoad_.exchange(nullptr)) {
+        load->retired_ = impl_.release();
+        impl_.reset(load->built_);
+        load->built_ = nullptr;
+        load->swapped_.post();
+    }
+
+    // Switch the instruments of the programs between the blocks
+    const int program = pendingProgram_.exchange(-1);
+    if (program >= 0)
+        switchProgram(program);
+
+    renderInstrument(*impl_, target);
+
+    // The previous instrument plays the release of its voices over
+    if (Impl* releasing = releasing_) {
+        RenderTarget tail = target;
+        tail.adding = true;
+        renderInstrument(*releasing, tail);
+        if (releasing->voiceManager_.getNumActiveVoices() == 0)
+            releasing_ = nullptr;
+    }
+}
+
+void Synth::renderInstrument(Impl& impl, RenderTarget& target) noexcept
+{
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock()) {
+        if (!target.adding)
+            target.clear();
+        return;
+    }
+
+    OutputUpsampler& upsampler = impl.outputUpsampler_;
+    if (upsampler.getFactor() == 1) {
+        renderBlockLocked(impl, target);
+        return;
+    }
+
+    // Process at the fraction of the host rate, and upsample the outputs
+    const size_t numFrames = target.numFrames;
+    if (numFrames > static_cast<size_t>(impl.hostSamplesPerBlock_)) {
+        CHECKFALSE;
+        if (!target.adding)
+            target.clear();
+        return;
+    }
+
+    const size_t numProcessingFrames = upsampler.getFramesToRender(numFrames);
+    if (numProcessingFrames > 0) {
+        RenderTarget processing;
+        processing.planar = upsampler.getInput(numProcessingFrames);
+        processing.numChannels = processing.planar.getNumChannels();
+        processing.numFrames = numProcessingFrames;
+        renderBlockLocked(impl, processing);
+    }
+
+    target.write(upsampler.process(numProcessingFrames).first(numFrames));
+    upsampler.consume(numFrames);
+}
+
+void Synth::renderBlockLocked(Impl& impl, RenderTarget& target) noexcept
+{
     ScopedFTZ ftz;
+    const uint64_t callbackStart = CycleClock::now();
+#if SFIZZ_TRACING
+    const TimePoint blockStart = highResNow();
+    const bool traceVoices = impl.tracer_.tracesVoices();
+#endif
     auto& callbackBreakdown = impl.callbackBreakdown_;
+    impl.timeVoices_ = impl.voiceTimingCounter_ == 0;
+    if (++impl.voiceTimingCounter_ >= impl.voiceTimingPeriod_)
+        impl.voiceTimingCounter_ = 0;
+#if SFIZZ_TRACING
+    impl.timeVoices_ = impl.timeVoices_ || traceVoices;
+#endif
     impl.resetCallbackBreakdown();
     callbackBreakdown.dispatch = impl.dispatchDuration_;
     impl.dispatchDuration_ = 0.0;
 
-    { // Silence buffer
+    const int numChannels = static_cast<int>(target.numChannels);
+    // the channels which no output replaces are silenced
+    const bool clearTarget = target.inPlace()
+        || (!target.adding && numChannels > 2 * impl.numOutputs_);
+    if (clearTarget) { // Silence buffer
         ScopedTiming logger { callbackBreakdown.renderMethod };
-        buffer.fill(0.0f);
+        target.clear();
     }
 
-    const size_t numFrames = buffer.getNumFrames();
+    const size_t numFrames = target.numFrames;
     if (numFrames < 1) {
         CHECKFALSE;
         return;
     }
 
+    impl.voiceManager_.updateVoiceBudget();
+    impl.resources_.clearFilterCoefficientCaches();
+
     const SynthConfig& synthConfig = impl.resources_.getSynthConfig();
     FilePool& filePool = impl.resources_.getFilePool();
     BufferPool& bufferPool = impl.resources_.getBufferPool();
@@ -1121,10 +2115,19 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
     const auto timeSinceLastCollection =
         std::chrono::duration_cast<std::chrono::seconds>(now - impl.lastGarbageCollection_);
 
-    if (timeSinceLastCollection.count() > config::fileClearingPeriod) {
+    // Collect more often to stay within a memory budget
+    const bool budgetCollectionDue = filePool.getMemoryBudget() > 0
+        && now - impl.lastGarbageCollection_ > std::chrono::milliseconds(config::memoryBudgetPeriod);
+
+    // The immediate release collects at every cycle, which is cheap as it
+    // only looks at the files which streamed
+    if (timeSinceLastCollection.count() > config::fileClearingPeriod || budgetCollectionDue
+        || filePool.isImmediateRelease()) {
         impl.lastGarbageCollection_ = now;
         filePool.triggerGarbageCollection();
     }
+    else
+        filePool.collectLastUsedFiles();
 
     auto tempSpan = bufferPool.getStereoBuffer(numFrames);
     auto tempMixSpan = bufferPool.getStereoBuffer(numFrames);
@@ -1161,32 +2164,43 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
     { // Main render block
         ScopedTiming logger { callbackBreakdown.renderMethod, ScopedTiming::Operation::addToDuration };
 
-        for (auto& voice : impl.voiceManager_) {
-            if (voice.isFree())
-                continue;
-
-            mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
+        // Start the loads of the samples of all voices before the first
+        // voice reads, so they overlap with the rendering
+        impl.voiceManager_.forEachBusyVoice([&](Voice& voice) {
+            voice.prefetchSource(static_cast<unsigned>(numFrames));
+        });
 
-            const Region* region = voice.getRegion();
-            ASSERT(region != nullptr);
-            const auto& effectBuses = impl.getEffectBusesForOutput(region->output);
+        if (impl.shouldRenderConcurrently()) {
+            impl.renderVoicesConcurrently(*tempSpan);
+        }
+        else {
+            impl.voiceManager_.forEachBusyVoice([&](Voice& voice) {
+#if SFIZZ_TRACING
+                const TimePoint voiceStart = traceVoices ? highResNow() : TimePoint {};
+#endif
+                mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
+
+                ASSERT(voice.getRegion() != nullptr);
+                voice.setTimingEnabled(impl.timeVoices_);
+                impl.renderVoiceToBuses(voice, *tempSpan, numFrames);
+                callbackBreakdown.data += voice.getLastDataDuration();
+                callbackBreakdown.amplitude += voice.getLastAmplitudeDuration();
+                callbackBreakdown.filters += voice.getLastFilterDuration();
+                callbackBreakdown.panning += voice.getLastPanningDuration();
+                impl.updateVoiceStartStats(voice);
+
+                mm.endVoice();
+#if SFIZZ_TRACING
+                if (traceVoices)
+                    impl.traceVoice(voice, voiceStart, 0);
+#endif
 
-            voice.renderBlock(*tempSpan);
-            for (size_t i = 0, n = effectBuses.size(); i < n; ++i) {
-                if (auto& bus = effectBuses[i]) {
-                    float addGain = region->getGainToEffectBus(i);
-                    bus->addToInputs(*tempSpan, addGain, numFrames);
+                if (voice.toBeCleanedUp()) {
+                    if (voice.wasCulled())
+                        ++callbackBreakdown.culledVoices;
+                    voice.reset();
                 }
-            }
-            callbackBreakdown.data += voice.getLastDataDuration();
-            callbackBreakdown.amplitude += voice.getLastAmplitudeDuration();
-            callbackBreakdown.filters += voice.getLastFilterDuration();
-            callbackBreakdown.panning += voice.getLastPanningDuration();
-
-            mm.endVoice();
-
-            if (voice.toBeCleanedUp())
-                voice.reset();
+            });
         }
     }
 
@@ -1195,17 +2209,22 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
         //    without any <effect>, the signal is just going to flow through it.
         ScopedTiming logger { callbackBreakdown.effects, ScopedTiming::Operation::addToDuration };
 
-        const int numChannels = static_cast<int>(buffer.getNumChannels());
+        // the buses are independent until they are mixed into the outputs
+        impl.processEffectBuses(numFrames);
+
+        // Out of place, the outputs mix into the free voice buffer and go to
+        // the target with the master volume
+        const float masterGain = db2mag(impl.volume_);
         for (int i = 0; i < impl.numOutputs_; ++i) {
             tempMixSpan->fill(0.0f);
             const auto outputStart = numChannels == 0 ? 0 : (2 * i) % numChannels;
-            auto outputSpan = buffer.getStereoSpan(outputStart);
+            AudioSpan<float, 2> outputSpan = target.inPlace() ? target.planar.getStereoSpan(outputStart) : AudioSpan<float, 2> { *tempSpan };
+            if (!target.inPlace())
+                outputSpan.fill(0.0f);
             const auto& effectBuses = impl.getEffectBusesForOutput(i);
             for (auto& bus : effectBuses) {
-                if (bus) {
-                    bus->process(numFrames);
+                if (bus)
                     bus->mixOutputsTo(outputSpan, *tempMixSpan, numFrames);
-                }
             }
 
             // Add the Mix output (fxNtomix opcodes)
@@ -1213,19 +2232,26 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
             //    perhaps it's designed as extension point for custom processing?
             //    as default behavior, it adds itself to the Main signal.
             outputSpan.add(*tempMixSpan);
+
+            if (!target.inPlace()) {
+                outputSpan.applyGain(masterGain);
+                const bool add = clearTarget || target.adding || 2 * i >= numChannels;
+                target.deliver(outputSpan, static_cast<size_t>(outputStart), add);
+            }
         }
     }
 
     // Apply the master volume
-    buffer.applyGain(db2mag(impl.volume_));
+    if (target.inPlace())
+        target.planar.applyGain(db2mag(impl.volume_));
 
     // Process the metronome (debugging tool for host time info)
     constexpr bool metronomeEnabled = false;
-    if (metronomeEnabled) {
+    if (metronomeEnabled && !target.interleaved) {
         Metronome& metro = impl.resources_.getMetronome();
         metro.processAdding(
             bc.getRunningBeatNumber().data(), bc.getRunningBeatsPerBar().data(),
-            buffer.getChannel(0), buffer.getChannel(1), numFrames);
+            target.planar.getChannel(0), target.planar.getChannel(1), numFrames);
     }
 
     // Perform any remaining modulators
@@ -1240,13 +2266,119 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
 
     { // Clear events and advance midi time
         ScopedTiming logger { impl.callbackBreakdown_.dispatch, ScopedTiming::Operation::addToDuration };
-        midiState.advanceTime(buffer.getNumFrames());
+        midiState.advanceTime(numFrames);
+    }
+
+    impl.updateQualityGovernor(numFrames);
+    impl.updateCallbackStats(
+        static_cast<double>(CycleClock::now() - callbackStart) * CycleClock::secondsPerTick());
+
+#if SFIZZ_TRACING
+    if (impl.tracer_.isActive()) {
+        TraceEvent event;
+        event.type = TraceEvent::Type::Block;
+        event.start = blockStart;
+        event.duration = Duration(highResNow() - blockStart).count();
+        event.stages[0] = static_cast<float>(callbackBreakdown.dispatch);
+        event.stages[1] = static_cast<float>(callbackBreakdown.renderMethod);
+        event.stages[2] = static_cast<float>(callbackBreakdown.effects);
+        event.number = static_cast<int32_t>(numFrames);
+        event.count = static_cast<int32_t>(impl.voiceManager_.getNumActiveVoices());
+        event.detail = callbackBreakdown.culledVoices;
+        event.underruns = static_cast<uint32_t>(filePool.getUnderrunStats().numUnderruns);
+        impl.tracer_.push(event);
+    }
+#endif
+
+    if (!target.interleaved) {
+        ASSERT(!hasNanInf(target.planar.getConstSpan(0)));
+        ASSERT(!hasNanInf(target.planar.getConstSpan(1)));
+        SFIZZ_CHECK(isReasonableAudio(target.planar.getConstSpan(0)));
+        SFIZZ_CHECK(isReasonableAudio(target.planar.getConstSpan(1)));
+    }
+
+    if (&impl == impl_.get())
+        publishStateSnapshot(impl);
+}
+
+void Synth::publishStateSnapshot(Impl& impl) noexcept
+{
+    const MidiState& midiState = impl.resources_.getMidiState();
+    StateSnapshot snapshot;
+    snapshot.version = ++stateVersion_;
+    snapshot.numActiveVoices = static_cast<uint32_t>(impl.voiceManager_.getNumActiveVoices());
+    snapshot.activeNotes = midiState.getActiveNotes();
+    snapshot.program = midiState.getProgram();
+    snapshot.pitchBend = midiState.getPitchBend();
+    snapshot.channelAftertouch = midiState.getChannelAftertouch();
+    for (int note = 0; note < 128; ++note)
+        snapshot.noteVelocities[note] = midiState.isNotePressed(note) ? midiState.getNoteVelocity(note) : 0.0f;
+    for (int cc = 0; cc < config::numCCs; ++cc)
+        snapshot.ccValues[cc] = midiState.getCCValue(cc);
+    size_t voiceIndex = 0;
+    for (Voice& voice : impl.voiceManager_) {
+        if (voiceIndex == config::maxVoices)
+            break;
+        snapshot.voiceLevels[voiceIndex++] = voice.isFree() ? 0.0f : voice.getAmplitudeEG()->getCurrentValue();
     }
+    const FilePool::UnderrunStats underruns = impl.resources_.getFilePool().getUnderrunStats();
+    snapshot.numUnderruns = underruns.numUnderruns;
+    snapshot.numMissingFrames = underruns.numMissingFrames;
+    stateSnapshot_.store(snapshot);
+}
+
+Synth::StateSnapshot Synth::getStateSnapshot() const noexcept
+{
+    return stateSnapshot_.load();
+}
+
+void Synth::Impl::updateQualityGovernor(size_t numFrames) noexcept
+{
+    SynthConfig& synthConfig = resources_.getSynthConfig();
+
+    // offline rendering has no deadline
+    if (!synthConfig.qualityGovernor || synthConfig.freeWheeling) {
+        qualityGovernor_.clear();
+        synthConfig.qualityReduction = 0;
+        return;
+    }
+
+    const CallbackBreakdown& bd = callbackBreakdown_;
+    const double duration = bd.dispatch + bd.renderMethod + bd.effects;
+    const double deadline = static_cast<double>(numFrames) / sampleRate_;
+    qualityGovernor_.update(duration, deadline);
+    synthConfig.qualityReduction = qualityGovernor_.getQualityReduction();
+}
+
+void Synth::Impl::updateVoiceStartStats(Voice& voice) noexcept
+{
+    Voice::StartLatency latency;
+    if (!voice.takeStartLatency(latency))
+        return;
+
+    voiceStartHistograms_[VoiceStartDispatch].add(latency.dispatchDuration);
+    voiceStartHistograms_[VoiceStartRender].add(latency.renderDelay);
+    if (latency.hasSample) {
+        std::atomic<uint64_t>& counter = latency.preloaded ? numPreloadedStarts_ : numNotPreloadedStarts_;
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
 
-    ASSERT(!hasNanInf(buffer.getConstSpan(0)));
-    ASSERT(!hasNanInf(buffer.getConstSpan(1)));
-    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(0)));
-    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(1)));
+void Synth::Impl::updateCallbackStats(double renderDuration) noexcept
+{
+    const CallbackBreakdown& bd = callbackBreakdown_;
+    callbackHistograms_[CallbackTotal].add(bd.dispatch + renderDuration);
+    callbackHistograms_[CallbackDispatch].add(bd.dispatch);
+    callbackHistograms_[CallbackRender].add(bd.renderMethod);
+    callbackHistograms_[CallbackEffects].add(bd.effects);
+
+    // the voice stages of the blocks which are not timed are from earlier
+    if (timeVoices_) {
+        callbackHistograms_[CallbackData].add(bd.data);
+        callbackHistograms_[CallbackAmplitude].add(bd.amplitude);
+        callbackHistograms_[CallbackFilters].add(bd.filters);
+        callbackHistograms_[CallbackPanning].add(bd.panning);
+    }
 }
 
 void Synth::noteOn(int delay, int noteNumber, int velocity) noexcept
@@ -1260,12 +2392,22 @@ void Synth::hdNoteOn(int delay, int noteNumber, float normalizedVelocity) noexce
     ASSERT(noteNumber < 128);
     ASSERT(noteNumber >= 0);
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.dispatchStart_ = CycleClock::now();
+    impl.performNoteOn(delay, noteNumber, normalizedVelocity);
+}
 
-    if (impl.lastKeyswitchLists_[noteNumber].empty())
-        impl.resources_.getMidiState().noteOnEvent(delay, noteNumber, normalizedVelocity);
+void Synth::Impl::performNoteOn(int delay, int noteNumber, float normalizedVelocity) noexcept
+{
+    if (lastKeyswitchLists_[noteNumber].empty())
+        resources_.getMidiState().noteOnEvent(delay, noteNumber, normalizedVelocity);
 
-    impl.noteOnDispatch(delay, noteNumber, normalizedVelocity);
+    noteOnDispatch(delay, noteNumber, normalizedVelocity);
 }
 
 void Synth::noteOff(int delay, int noteNumber, int velocity) noexcept
@@ -1279,22 +2421,32 @@ void Synth::hdNoteOff(int delay, int noteNumber, float normalizedVelocity) noexc
     ASSERT(noteNumber < 128);
     ASSERT(noteNumber >= 0);
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.dispatchStart_ = CycleClock::now();
+    impl.performNoteOff(delay, noteNumber, normalizedVelocity);
+}
 
+void Synth::Impl::performNoteOff(int delay, int noteNumber, float normalizedVelocity) noexcept
+{
     // FIXME: Some keyboards (e.g. Casio PX5S) can send a real note-off velocity. In this case, do we have a
     // way in sfz to specify that a release trigger should NOT use the note-on velocity?
     // auto replacedVelocity = (velocity == 0 ? getNoteVelocity(noteNumber) : velocity);
-    MidiState& midiState = impl.resources_.getMidiState();
+    MidiState& midiState = resources_.getMidiState();
 
-    if (impl.lastKeyswitchLists_[noteNumber].empty())
+    if (lastKeyswitchLists_[noteNumber].empty())
         midiState.noteOffEvent(delay, noteNumber, normalizedVelocity);
 
     const auto replacedVelocity = midiState.getNoteVelocity(noteNumber);
 
-    for (auto& voice : impl.voiceManager_)
+    for (auto& voice : voiceManager_)
         voice.registerNoteOff(delay, noteNumber, replacedVelocity);
 
-    impl.noteOffDispatch(delay, noteNumber, replacedVelocity);
+    noteOffDispatch(delay, noteNumber, replacedVelocity);
 }
 
 void Synth::Impl::startVoice(Layer* layer, int delay, const TriggerEvent& triggerEvent, SisterVoiceRingBuilder& ring) noexcept
@@ -1307,19 +2459,20 @@ void Synth::Impl::startVoice(Layer* layer, int delay, const TriggerEvent& trigge
         return;
 
     selectedVoice->reset();
-    if (selectedVoice->startVoice(layer, delay, triggerEvent))
+    if (selectedVoice->startVoice(layer, delay, triggerEvent)) {
         ring.addVoiceToRing(selectedVoice);
+        selectedVoice->setStartTime(
+            static_cast<double>(CycleClock::now() - dispatchStart_) * CycleClock::secondsPerTick());
+    }
 }
 
 void Synth::Impl::checkOffGroups(const Region* region, int delay, int number, bool chokedByCC)
 {
-    for (auto& voice : voiceManager_) {
-        if (voice.checkOffGroup(region, delay, number)) {
-            const TriggerEvent& event = voice.getTriggerEvent();
-            if (event.type == TriggerEventType::NoteOn && !chokedByCC)
-                noteOffDispatch(delay, event.number, event.value);
-        }
-    }
+    voiceManager_.checkOffGroups(region, delay, number, [&](const Voice& voice) {
+        const TriggerEvent& event = voice.getTriggerEvent();
+        if (event.type == TriggerEventType::NoteOn && !chokedByCC)
+            noteOffDispatch(delay, event.number, event.value);
+    });
 }
 
 void Synth::Impl::noteOffDispatch(int delay, int noteNumber, float velocity) noexcept
@@ -1335,8 +2488,8 @@ void Synth::Impl::noteOffDispatch(int delay, int noteNumber, float velocity) noe
         layer->keySwitched_ = false;
 
     for (Layer* layer : noteActivationLists_[noteNumber]) {
-        const Region& region = layer->getRegion();
         if (layer->registerNoteOff(noteNumber, velocity, randValue)) {
+            const Region& region = layer->getRegion();
             if (region.trigger == Trigger::release && !region.rtDead && !voiceManager_.playingAttackVoice(&region))
                 continue;
 
@@ -1346,22 +2499,37 @@ void Synth::Impl::noteOffDispatch(int delay, int noteNumber, float velocity) noe
     }
 }
 
-void Synth::Impl::noteOnDispatch(int delay, int noteNumber, float velocity) noexcept
+void Synth::Impl::selectLastKeyswitch(int noteNumber) noexcept
 {
-    const auto randValue = randNoteDistribution_(Random::randomGenerator);
-    SisterVoiceRingBuilder ring;
-    MidiState& midiState = resources_.getMidiState();
+    if (lastKeyswitchLists_[noteNumber].empty())
+        return;
 
-    if (!lastKeyswitchLists_[noteNumber].empty()) {
-        if (currentSwitch_ && *currentSwitch_ != noteNumber) {
-            for (Layer* layer : lastKeyswitchLists_[*currentSwitch_])
-                layer->keySwitched_ = false;
+    if (currentSwitch_ && *currentSwitch_ != noteNumber) {
+        for (Layer* layer : lastKeyswitchLists_[*currentSwitch_])
+            layer->keySwitched_ = false;
+    }
+    currentSwitch_ = noteNumber;
+
+    if (lazyKeyswitchPreloading_) {
+        FilePool& filePool = resources_.getFilePool();
+        for (Layer* layer : lastKeyswitchLists_[noteNumber]) {
+            const Region& region = layer->getRegion();
+            if (!region.isGenerator())
+                filePool.requestPreload(*region.sampleId);
         }
-        currentSwitch_ = noteNumber;
     }
 
     for (Layer* layer : lastKeyswitchLists_[noteNumber])
         layer->keySwitched_ = true;
+}
+
+void Synth::Impl::noteOnDispatch(int delay, int noteNumber, float velocity) noexcept
+{
+    const auto randValue = randNoteDistribution_(Random::randomGenerator);
+    SisterVoiceRingBuilder ring;
+    MidiState& midiState = resources_.getMidiState();
+
+    selectLastKeyswitch(noteNumber);
 
     for (Layer* layer : upKeyswitchLists_[noteNumber])
         layer->keySwitched_ = false;
@@ -1369,7 +2537,7 @@ void Synth::Impl::noteOnDispatch(int delay, int noteNumber, float velocity) noex
     for (Layer* layer : downKeyswitchLists_[noteNumber])
         layer->keySwitched_ = true;
 
-    for (Layer* layer : noteActivationLists_[noteNumber]) {
+    for (Layer* layer : noteOnCandidates(noteNumber, velocity)) {
         if (layer->registerNoteOn(noteNumber, velocity, randValue)) {
             const Region& region = layer->getRegion();
             if (region.useTimerRange && !voiceManager_.withinValidTimerRange(&region, midiState.getInternalClock() + delay, sampleRate_))
@@ -1385,6 +2553,19 @@ void Synth::Impl::noteOnDispatch(int delay, int noteNumber, float velocity) noex
         const Region& region = layer->getRegion();
         layer->previousKeySwitched_ = (region.previousKeyswitch == noteNumber);
     }
+
+    if (resources_.getSynthConfig().releasePrewarming)
+        prewarmReleases(noteNumber);
+}
+
+void Synth::Impl::prewarmReleases(int noteNumber) noexcept
+{
+    FilePool& filePool = resources_.getFilePool();
+    for (Layer* layer : noteActivationLists_[noteNumber]) {
+        const Region& region = layer->getRegion();
+        if (region.isRelease() && !region.isGenerator() && !region.disabled())
+            filePool.prewarmFile(region.sampleId);
+    }
 }
 
 void Synth::Impl::startDelayedSustainReleases(Layer* layer, int delay, SisterVoiceRingBuilder& ring) noexcept
@@ -1393,6 +2574,7 @@ void Synth::Impl::startDelayedSustainReleases(Layer* layer, int delay, SisterVoi
 
     if (!region.rtDead && !voiceManager_.playingAttackVoice(&region)) {
         layer->delayedSustainReleases_.clear();
+        layer->updatePendingRelease();
         return;
     }
 
@@ -1402,6 +2584,7 @@ void Synth::Impl::startDelayedSustainReleases(Layer* layer, int delay, SisterVoi
     }
 
     layer->delayedSustainReleases_.clear();
+    layer->updatePendingRelease();
 }
 
 void Synth::Impl::startDelayedSostenutoReleases(Layer* layer, int delay, SisterVoiceRingBuilder& ring) noexcept
@@ -1410,6 +2593,7 @@ void Synth::Impl::startDelayedSostenutoReleases(Layer* layer, int delay, SisterV
 
     if (!region.rtDead && !voiceManager_.playingAttackVoice(&region)) {
         layer->delayedSostenutoReleases_.clear();
+        layer->updatePendingRelease();
         return;
     }
 
@@ -1418,6 +2602,7 @@ void Synth::Impl::startDelayedSostenutoReleases(Layer* layer, int delay, SisterV
         startVoice(layer, delay, noteOffEvent, ring);
     }
     layer->delayedSostenutoReleases_.clear();
+    layer->updatePendingRelease();
 }
 
 void Synth::cc(int delay, int ccNumber, int ccValue) noexcept
@@ -1432,22 +2617,34 @@ void Synth::Impl::ccDispatch(int delay, int ccNumber, float value, int extendedA
     TriggerEvent triggerEvent { TriggerEventType::CC, ccNumber, value };
     const auto randValue = randNoteDistribution_(Random::randomGenerator);
     MidiState& midiState = resources_.getMidiState();
-    for (Layer* layer : ccActivationLists_[ccNumber]) {
-        const Region& region = layer->getRegion();
-
-        if (region.checkSustain && ccNumber == region.sustainCC && value < region.sustainThreshold)
-            startDelayedSustainReleases(layer, delay, ring);
-
-        if (region.checkSostenuto && ccNumber == region.sostenutoCC && value < region.sostenutoThreshold) {
-            if (layer->sustainPressed_) {
-                for (const auto& v: layer->delayedSostenutoReleases_)
-                    layer->delaySustainRelease(v.first, v.second);
 
-                layer->delayedSostenutoReleases_.clear();
-            } else {
-                startDelayedSostenutoReleases(layer, delay, ring);
+    // The pedal releases, over the layers which hold delayed releases; the
+    // next layer is read first, since the releases unlink the layer
+    if (pedalCCs_.test(ccNumber)) {
+        Layer* next = nullptr;
+        for (Layer* layer = pendingReleases_.first; layer; layer = next) {
+            next = layer->nextPendingRelease_;
+            const Layer::TriggerView& view = layer->trigger_;
+
+            if (view.checkSustain && ccNumber == view.sustainCC && value < view.sustainThreshold)
+                startDelayedSustainReleases(layer, delay, ring);
+
+            if (view.checkSostenuto && ccNumber == view.sostenutoCC && value < view.sostenutoThreshold) {
+                if (layer->sustainPressed_) {
+                    for (const auto& v: layer->delayedSostenutoReleases_)
+                        layer->delaySustainRelease(v.first, v.second);
+
+                    layer->delayedSostenutoReleases_.clear();
+                    layer->updatePendingRelease();
+                } else {
+                    startDelayedSostenutoReleases(layer, delay, ring);
+                }
             }
         }
+    }
+
+    for (Layer* layer : ccActivationLists_[ccNumber]) {
+        const Region& region = layer->getRegion();
 
         if (layer->registerCC(ccNumber, value, randValue, extendedArg)) {
             if (region.useTimerRange && ! voiceManager_.withinValidTimerRange(&region, midiState.getInternalClock() + delay, sampleRate_))
@@ -1462,12 +2659,26 @@ void Synth::Impl::ccDispatch(int delay, int ccNumber, float value, int extendedA
 void Synth::hdcc(int delay, int ccNumber, float normValue) noexcept
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.dispatchStart_ = CycleClock::now();
     impl.performHdcc(delay, ccNumber, normValue, true);
 }
 
 void Synth::automateHdcc(int delay, int ccNumber, float normValue) noexcept
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.dispatchStart_ = CycleClock::now();
     impl.performHdcc(delay, ccNumber, normValue, false);
 }
 
@@ -1476,8 +2687,6 @@ void Synth::Impl::performHdcc(int delay, int ccNumber, float normValue, bool asM
     ASSERT(ccNumber < config::numCCs);
     ASSERT(ccNumber >= 0);
 
-    ScopedTiming logger { dispatchDuration_, ScopedTiming::Operation::addToDuration };
-
     changedCCsThisCycle_.set(ccNumber);
 
     MidiState& midiState = resources_.getMidiState();
@@ -1496,13 +2705,22 @@ void Synth::Impl::performHdcc(int delay, int ccNumber, float normValue, bool asM
         }
     }
 
-    for (auto& voice : voiceManager_)
-        voice.registerCC(delay, ccNumber, normValue);
-
+    registerPedalCC(delay, ccNumber, normValue);
     ccDispatch(delay, ccNumber, normValue, extendedArg);
     midiState.ccEvent(delay, ccNumber, normValue);
 }
 
+void Synth::Impl::registerPedalCC(int delay, int ccNumber, float normValue) noexcept
+{
+    if (ccNumber < 0 || static_cast<size_t>(ccNumber) >= sustainOrSostenuto_.bit_size()
+        || !sustainOrSostenuto_.test(static_cast<size_t>(ccNumber)))
+        return;
+
+    voiceManager_.forEachActiveVoice([=](Voice& voice) {
+        voice.registerCC(delay, ccNumber, normValue);
+    });
+}
+
 void Synth::Impl::setDefaultHdcc(int ccNumber, float value)
 {
     ASSERT(ccNumber >= 0);
@@ -1535,26 +2753,46 @@ void Synth::pitchWheel(int delay, int pitch) noexcept
 void Synth::hdPitchWheel(int delay, float normalizedPitch) noexcept
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
 
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
-    impl.resources_.getMidiState().pitchBendEvent(delay, normalizedPitch);
+    RealtimeGuard::Scope realtimeScope;
+    impl.performPitchWheel(delay, normalizedPitch);
+}
 
-    for (const Impl::LayerPtr& layer : impl.layers_) {
-        layer->registerPitchWheel(normalizedPitch);
-    }
+void Synth::Impl::performPitchWheel(int delay, float normalizedPitch) noexcept
+{
+    resources_.getMidiState().pitchBendEvent(delay, normalizedPitch);
 
-    for (auto& voice : impl.voiceManager_) {
-        voice.registerPitchWheel(delay, normalizedPitch);
+    for (const LayerPtr& layer : layers_) {
+        layer->registerPitchWheel(normalizedPitch);
     }
 
-    impl.performHdcc(delay, ExtendedCCs::pitchBend, normalizedPitch, false);
+    performHdcc(delay, ExtendedCCs::pitchBend, normalizedPitch, false);
 }
 
 void Synth::programChange(int delay, int program) noexcept
 {
+    // A resident instrument takes over at the next block
+    if (program >= 0 && program < config::numPrograms && program != activeProgram_
+        && (residents_[program] || base_))
+        pendingProgram_.store(program);
+
     Impl& impl = *impl_;
-    impl.resources_.getMidiState().programChangeEvent(delay, program);
-    for (const Impl::LayerPtr& layer : impl.layers_)
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    impl.performProgramChange(delay, program);
+}
+
+void Synth::Impl::performProgramChange(int delay, int program) noexcept
+{
+    resources_.getMidiState().programChangeEvent(delay, program);
+    for (const LayerPtr& layer : layers_)
         layer->registerProgramChange(program);
 }
 
@@ -1568,19 +2806,24 @@ void Synth::channelAftertouch(int delay, int aftertouch) noexcept
 void Synth::hdChannelAftertouch(int delay, float normAftertouch) noexcept
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.performChannelAftertouch(delay, normAftertouch);
+}
 
-    impl.resources_.getMidiState().channelAftertouchEvent(delay, normAftertouch);
+void Synth::Impl::performChannelAftertouch(int delay, float normAftertouch) noexcept
+{
+    resources_.getMidiState().channelAftertouchEvent(delay, normAftertouch);
 
-    for (const Impl::LayerPtr& layerPtr : impl.layers_) {
+    for (const LayerPtr& layerPtr : layers_) {
         layerPtr->registerAftertouch(normAftertouch);
     }
 
-    for (auto& voice : impl.voiceManager_) {
-        voice.registerAftertouch(delay, normAftertouch);
-    }
-
-    impl.performHdcc(delay, ExtendedCCs::channelAftertouch, normAftertouch, false);
+    performHdcc(delay, ExtendedCCs::channelAftertouch, normAftertouch, false);
 }
 
 void Synth::polyAftertouch(int delay, int noteNumber, int aftertouch) noexcept
@@ -1592,47 +2835,165 @@ void Synth::polyAftertouch(int delay, int noteNumber, int aftertouch) noexcept
 void Synth::hdPolyAftertouch(int delay, int noteNumber, float normAftertouch) noexcept
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
-
-    impl.resources_.getMidiState().polyAftertouchEvent(delay, noteNumber, normAftertouch);
-
-    for (auto& voice : impl.voiceManager_)
-        voice.registerPolyAftertouch(delay, noteNumber, normAftertouch);
-
-    impl.performHdcc(delay, ExtendedCCs::polyphonicAftertouch, normAftertouch, false, noteNumber);
+    RealtimeGuard::Scope realtimeScope;
+    impl.performPolyAftertouch(delay, noteNumber, normAftertouch);
 }
 
-void Synth::tempo(int delay, float secondsPerBeat) noexcept
+void Synth::Impl::performPolyAftertouch(int delay, int noteNumber, float normAftertouch) noexcept
 {
-    Impl& impl = *impl_;
-    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    resources_.getMidiState().polyAftertouchEvent(delay, noteNumber, normAftertouch);
 
-    impl.resources_.getBeatClock().setTempo(delay, secondsPerBeat);
+    performHdcc(delay, ExtendedCCs::polyphonicAftertouch, normAftertouch, false, noteNumber);
 }
 
-void Synth::bpmTempo(int delay, float beatsPerMinute) noexcept
+void Synth::hdPerNotePitchWheel(int delay, int noteNumber, float normPitch) noexcept
 {
-    // TODO make this the main tempo function and remove the deprecated other one
-    return tempo(delay, 60 / beatsPerMinute);
+    Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.performPerNoteController(delay, noteNumber, ExtendedCCs::perNotePitchBend, normPitch);
 }
 
-void Synth::timeSignature(int delay, int beatsPerBar, int beatUnit)
+void Synth::hdPerNoteTimbre(int delay, int noteNumber, float normTimbre) noexcept
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+    impl.performPerNoteController(delay, noteNumber, ExtendedCCs::perNoteTimbre, normTimbre);
+}
 
-    impl.resources_.getBeatClock().setTimeSignature(delay, TimeSignature(beatsPerBar, beatUnit));
+void Synth::Impl::performPerNoteController(int delay, int noteNumber, int ccNumber, float normValue) noexcept
+{
+    resources_.getMidiState().perNoteEvent(delay, noteNumber, ccNumber, normValue);
 }
 
-void Synth::timePosition(int delay, int bar, double barBeat)
+void Synth::sendEvents(const sfizz_event_t* events, size_t count) noexcept
 {
     Impl& impl = *impl_;
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
-
-    BeatClock& beatClock = impl.resources_.getBeatClock();
-
-    const auto newPosition = BBT(bar, barBeat);
-    const auto newBeatPosition = newPosition.toBeats(beatClock.getTimeSignature());
+    RealtimeGuard::Scope realtimeScope;
+
+    for (size_t i = 0; i < count; ++i) {
+        const sfizz_event_t& event = events[i];
+        impl.dispatchStart_ = CycleClock::now();
+        switch (event.type) {
+        case SFIZZ_EVENT_NOTE_ON:
+            ASSERT(event.number >= 0 && event.number < 128);
+            impl.performNoteOn(event.delay, event.number, event.value);
+            break;
+        case SFIZZ_EVENT_NOTE_OFF:
+            ASSERT(event.number >= 0 && event.number < 128);
+            impl.performNoteOff(event.delay, event.number, event.value);
+            break;
+        case SFIZZ_EVENT_CC:
+            // A controller which is set again at the same delay, which no
+            // layer and no pedal listens to, only keeps its last value
+            if (i + 1 < count && impl.isCoalescableCC(event.number)) {
+                const sfizz_event_t& next = events[i + 1];
+                if (next.type == SFIZZ_EVENT_CC && next.number == event.number && next.delay == event.delay)
+                    break;
+            }
+            impl.performHdcc(event.delay, event.number, event.value, true);
+            break;
+        case SFIZZ_EVENT_PROGRAM_CHANGE:
+            impl.performProgramChange(event.delay, event.number);
+            break;
+        case SFIZZ_EVENT_PITCH_WHEEL:
+            impl.performPitchWheel(event.delay, event.value);
+            break;
+        case SFIZZ_EVENT_CHANNEL_AFTERTOUCH:
+            impl.performChannelAftertouch(event.delay, event.value);
+            break;
+        case SFIZZ_EVENT_POLY_AFTERTOUCH:
+            ASSERT(event.number >= 0 && event.number < 128);
+            impl.performPolyAftertouch(event.delay, event.number, event.value);
+            break;
+        case SFIZZ_EVENT_PER_NOTE_PITCH_WHEEL:
+            ASSERT(event.number >= 0 && event.number < 128);
+            impl.performPerNoteController(event.delay, event.number, ExtendedCCs::perNotePitchBend, event.value);
+            break;
+        case SFIZZ_EVENT_PER_NOTE_TIMBRE:
+            ASSERT(event.number >= 0 && event.number < 128);
+            impl.performPerNoteController(event.delay, event.number, ExtendedCCs::perNoteTimbre, event.value);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool Synth::Impl::isCoalescableCC(int ccNumber) const noexcept
+{
+    return ccNumber >= 0 && ccNumber < config::numCCs
+        && ccNumber != config::resetCC
+        && ccNumber != config::allNotesOffCC
+        && ccNumber != config::allSoundOffCC
+        && ccActivationLists_[ccNumber].empty()
+        && !pedalCCs_.test(ccNumber);
+}
+
+void Synth::tempo(int delay, float secondsPerBeat) noexcept
+{
+    Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+
+    impl.resources_.getBeatClock().setTempo(delay, secondsPerBeat);
+}
+
+void Synth::bpmTempo(int delay, float beatsPerMinute) noexcept
+{
+    // TODO make this the main tempo function and remove the deprecated other one
+    return tempo(delay, 60 / beatsPerMinute);
+}
+
+void Synth::timeSignature(int delay, int beatsPerBar, int beatUnit)
+{
+    Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+
+    impl.resources_.getBeatClock().setTimeSignature(delay, TimeSignature(beatsPerBar, beatUnit));
+}
+
+void Synth::timePosition(int delay, int bar, double barBeat)
+{
+    Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+    ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
+
+    BeatClock& beatClock = impl.resources_.getBeatClock();
+
+    const auto newPosition = BBT(bar, barBeat);
+    const auto newBeatPosition = newPosition.toBeats(beatClock.getTimeSignature());
     const auto currentBeatPosition = beatClock.getLastBeatPosition();
     const auto positionDifference = std::abs(newBeatPosition - currentBeatPosition);
     const auto threshold = config::playheadMovedFrames * beatClock.getBeatsPerFrame();
@@ -1646,7 +3007,12 @@ void Synth::timePosition(int delay, int bar, double barBeat)
 void Synth::playbackState(int delay, int playbackState)
 {
     Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
+    RealtimeGuard::Scope realtimeScope;
 
     impl.resources_.getBeatClock().setPlaying(delay, playbackState == 1);
 }
@@ -1669,6 +3035,12 @@ int Synth::getNumMasters() const noexcept
     return impl.numMasters_;
 }
 
+int Synth::getNumOutputs() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.numOutputs_;
+}
+
 int Synth::getNumCurves() const noexcept
 {
     Impl& impl = *impl_;
@@ -1857,6 +3229,24 @@ size_t Synth::getNumPreloadedSamples() const noexcept
     return impl.resources_.getFilePool().getNumPreloadedSamples();
 }
 
+size_t Synth::getSampleEnvelope(const std::string& sample, bool reverse, std::vector<float>& rms, std::vector<float>& peak) const
+{
+    const Impl& impl = *impl_;
+    const FileId fileId { absl::StrReplaceAll(sample, { { "\\", "/" } }), reverse };
+    const SampleEnvelope* envelope = impl.resources_.getFilePool().getSampleEnvelope(fileId);
+    if (!envelope) {
+        rms.clear();
+        peak.clear();
+        return 0;
+    }
+
+    const auto measuredRms = envelope->getRms();
+    const auto measuredPeak = envelope->getPeak();
+    rms.assign(measuredRms.begin(), measuredRms.end());
+    peak.assign(measuredPeak.begin(), measuredPeak.end());
+    return envelope->getNumWindows();
+}
+
 int Synth::getSampleQuality(ProcessMode mode)
 {
     Impl& impl = *impl_;
@@ -1929,11 +3319,301 @@ void Synth::setOscillatorQuality(ProcessMode mode, int quality)
     }
 }
 
+int Synth::getEffectQuality(ProcessMode mode)
+{
+    Impl& impl = *impl_;
+    SynthConfig& synthConfig = impl.resources_.getSynthConfig();
+    switch (mode) {
+    case ProcessLive:
+        return synthConfig.liveEffectQuality;
+    case ProcessFreewheeling:
+        return synthConfig.freeWheelingEffectQuality;
+    default:
+        SFIZZ_CHECK(false);
+        return 0;
+    }
+}
+
+void Synth::setEffectQuality(ProcessMode mode, int quality)
+{
+    SFIZZ_CHECK(quality >= 0 && quality <= 3);
+    Impl& impl = *impl_;
+    quality = clamp(quality, 0, 3);
+    SynthConfig& synthConfig = impl.resources_.getSynthConfig();
+
+    switch (mode) {
+    case ProcessLive:
+        synthConfig.liveEffectQuality = quality;
+        break;
+    case ProcessFreewheeling:
+        synthConfig.freeWheelingEffectQuality = quality;
+        break;
+    default:
+        SFIZZ_CHECK(false);
+        break;
+    }
+}
+
 void Synth::setSustainCancelsRelease(bool value)
 {
     impl_->resources_.getSynthConfig().sustainCancelsRelease = value;
 }
 
+void Synth::setVoiceCullingThreshold(float threshold)
+{
+    impl_->resources_.getSynthConfig().voiceCullingThreshold =
+        Default::voiceCullingThreshold.bounds.clamp(threshold);
+}
+
+float Synth::getVoiceCullingThreshold() const noexcept
+{
+    return impl_->resources_.getSynthConfig().voiceCullingThreshold;
+}
+
+void Synth::enableQualityGovernor(bool enable) noexcept
+{
+    impl_->resources_.getSynthConfig().qualityGovernor = enable;
+}
+
+bool Synth::isQualityGovernorEnabled() const noexcept
+{
+    return impl_->resources_.getSynthConfig().qualityGovernor;
+}
+
+void Synth::enableAdaptiveSampleQuality(bool enable) noexcept
+{
+    impl_->resources_.getSynthConfig().adaptiveSampleQuality = enable;
+}
+
+bool Synth::isAdaptiveSampleQualityEnabled() const noexcept
+{
+    return impl_->resources_.getSynthConfig().adaptiveSampleQuality;
+}
+
+int Synth::getQualityReduction() const noexcept
+{
+    return impl_->resources_.getSynthConfig().qualityReduction;
+}
+
+void Synth::setSampleCacheDirectory(const fs::path& directory)
+{
+    impl_->resources_.getFilePool().setCacheDirectory(directory);
+}
+
+const fs::path& Synth::getSampleCacheDirectory() const noexcept
+{
+    return impl_->resources_.getFilePool().getCacheDirectory();
+}
+
+bool Synth::loadUsageProfile(const fs::path& path)
+{
+    UsageProfile profile;
+    const bool loaded = profile.load(path);
+    impl_->resources_.getFilePool().setUsageProfile(std::move(profile));
+    return loaded;
+}
+
+bool Synth::saveUsageProfile(const fs::path& path) const
+{
+    return impl_->resources_.getFilePool().getUsageProfile().save(path);
+}
+
+size_t Synth::probeSampleDirectory(const fs::path& directory)
+{
+    return impl_->resources_.getFilePool().probeDirectoryInformation(directory);
+}
+
+void Synth::setLoadingParallelism(unsigned parallelism) noexcept
+{
+    impl_->resources_.getFilePool().setLoadingParallelism(parallelism);
+}
+
+unsigned Synth::getLoadingParallelism() const noexcept
+{
+    return impl_->resources_.getFilePool().getLoadingParallelism();
+}
+
+void Synth::setStreamingWindow(uint32_t numFrames) noexcept
+{
+    impl_->resources_.getFilePool().setStreamingWindow(numFrames);
+}
+
+uint32_t Synth::getStreamingWindow() const noexcept
+{
+    return impl_->resources_.getFilePool().getStreamingWindow();
+}
+
+void Synth::setMemoryBudget(size_t numBytes) noexcept
+{
+    impl_->resources_.getFilePool().setMemoryBudget(numBytes);
+}
+
+size_t Synth::getMemoryBudget() const noexcept
+{
+    return impl_->resources_.getFilePool().getMemoryBudget();
+}
+
+void Synth::enableImmediateRelease(bool enable) noexcept
+{
+    impl_->resources_.getFilePool().setImmediateRelease(enable);
+}
+
+bool Synth::isImmediateReleaseEnabled() const noexcept
+{
+    return impl_->resources_.getFilePool().isImmediateRelease();
+}
+
+void Synth::setNumaNode(int node) noexcept
+{
+    impl_->resources_.getFilePool().setNumaNode(node);
+}
+
+int Synth::getNumaNode() const noexcept
+{
+    return impl_->resources_.getFilePool().getNumaNode();
+}
+
+void Synth::enableLazyKeyswitchPreloading(bool enable) noexcept
+{
+    impl_->lazyKeyswitchPreloading_ = enable;
+}
+
+bool Synth::isLazyKeyswitchPreloadingEnabled() const noexcept
+{
+    return impl_->lazyKeyswitchPreloading_;
+}
+
+void Synth::setEagerKeyswitch(int noteNumber, bool eager) noexcept
+{
+    if (noteNumber < 0 || noteNumber > 127)
+        return;
+    impl_->eagerKeyswitches_.set(static_cast<size_t>(noteNumber), eager);
+}
+
+bool Synth::isEagerKeyswitch(int noteNumber) const noexcept
+{
+    if (noteNumber < 0 || noteNumber > 127)
+        return false;
+    return impl_->eagerKeyswitches_.test(static_cast<size_t>(noteNumber));
+}
+
+void Synth::enableReleasePrewarming(bool enable) noexcept
+{
+    impl_->resources_.getSynthConfig().releasePrewarming = enable;
+}
+
+bool Synth::isReleasePrewarmingEnabled() const noexcept
+{
+    return impl_->resources_.getSynthConfig().releasePrewarming;
+}
+
+size_t Synth::getMemoryUsage() const noexcept
+{
+    return impl_->resources_.getFilePool().getMemoryUsage();
+}
+
+Synth::MemoryBreakdown Synth::getMemoryBreakdown() const noexcept
+{
+    const Impl& impl = *impl_;
+    MemoryBreakdown memory;
+
+    const FilePool& filePool = impl.resources_.getFilePool();
+    memory.preloadedSamples = filePool.getPreloadedMemory();
+    memory.streamedSamples = filePool.getStreamedMemory();
+    memory.wavetables = impl.resources_.getWavePool().getMemoryUsage();
+
+    memory.voices = impl.resources_.getVoicePools().getMemoryUsage();
+    for (auto voice = impl.voiceManager_.cbegin(); voice != impl.voiceManager_.cend(); ++voice)
+        memory.voices += voice->getMemoryUsage();
+
+    memory.bufferPool = impl.resources_.getBufferPool().getMemoryUsage();
+
+    for (const auto& buses : impl.effectBuses_) {
+        for (const auto& bus : buses) {
+            if (bus)
+                memory.effectBuses += bus->getMemoryUsage();
+        }
+    }
+    for (const Impl::RenderLane& renderLane : impl.renderLanes_) {
+        for (const auto& busInputs : renderLane.busInputs) {
+            for (const auto& busInput : busInputs)
+                memory.effectBuses += busInput.getMemoryUsage();
+        }
+    }
+
+    memory.regions = impl.layerArena_.capacity() * sizeof(Layer)
+        + impl.layers_.capacity() * sizeof(Impl::LayerPtr);
+    for (const Impl::LayerPtr& layer : impl.layers_)
+        memory.regions += layer->getRegion().getMemoryUsage();
+
+    return memory;
+}
+
+Synth::UnderrunStats Synth::getUnderrunStats() const noexcept
+{
+    const Impl& impl = *impl_;
+    const FilePool::UnderrunStats poolStats = impl.resources_.getFilePool().getUnderrunStats();
+    UnderrunStats stats;
+    stats.numUnderruns = poolStats.numUnderruns;
+    stats.numMissingFrames = poolStats.numMissingFrames;
+    if (poolStats.lastRegionId >= 0) {
+        const NumericId<Region> id { poolStats.lastRegionId };
+        for (size_t i = 0, n = impl.layers_.size(); i < n; ++i) {
+            if (impl.layers_[i]->getRegion().getId() == id) {
+                stats.lastRegion = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+    return stats;
+}
+
+void Synth::resetUnderrunStats() noexcept
+{
+    impl_->resources_.getFilePool().resetUnderrunStats();
+}
+
+Synth::StreamingStats Synth::getStreamingStats() const noexcept
+{
+    const FilePool::StreamingStats poolStats = impl_->resources_.getFilePool().getStreamingStats();
+    StreamingStats stats;
+    stats.streamedBytes = poolStats.streamedBytes;
+    stats.numStreams = poolStats.numStreams;
+    stats.totalFirstSliceLatency = poolStats.totalFirstSliceLatency;
+    stats.maxFirstSliceLatency = poolStats.maxFirstSliceLatency;
+    stats.collectedBytes = poolStats.collectedBytes;
+    stats.numQueuedRequests = poolStats.numQueuedRequests;
+    stats.numQueuedStreams = poolStats.numQueuedStreams;
+    stats.numLoadingJobs = poolStats.numLoadingJobs;
+    stats.workersBusyTime = poolStats.workers.busyTime;
+    stats.workersElapsedTime = poolStats.workers.elapsedTime;
+    stats.numWorkers = poolStats.workers.numWorkers;
+    return stats;
+}
+
+Synth::BufferPoolStats Synth::getBufferPoolStats() const noexcept
+{
+    const Impl& impl = *impl_;
+    const BufferPool& bufferPool = impl.resources_.getBufferPool();
+    const sfz::BufferPoolStats poolStats = impl.resources_.getBufferPoolStats();
+    BufferPoolStats stats;
+    stats.numBuffers = bufferPool.getNumBuffers();
+    stats.numStereoBuffers = bufferPool.getNumStereoBuffers();
+    stats.numIndexBuffers = bufferPool.getNumIndexBuffers();
+    stats.maxBuffersUsed = poolStats.maxBuffersUsed;
+    stats.maxStereoBuffersUsed = poolStats.maxStereoBuffersUsed;
+    stats.maxIndexBuffersUsed = poolStats.maxIndexBuffersUsed;
+    stats.numBufferFailures = poolStats.numBufferFailures;
+    stats.numStereoBufferFailures = poolStats.numStereoBufferFailures;
+    stats.numIndexBufferFailures = poolStats.numIndexBufferFailures;
+    return stats;
+}
+
+void Synth::resetBufferPoolStats() noexcept
+{
+    impl_->resources_.resetBufferPoolStats();
+}
+
 float Synth::getVolume() const noexcept
 {
     Impl& impl = *impl_;
@@ -1960,53 +3640,397 @@ void Synth::setNumVoices(int numVoices) noexcept
     if (numVoices == impl.numVoices_)
         return;
 
-    impl.resetVoices(numVoices);
+    impl.resizeVoices(numVoices);
 }
 
-void Synth::Impl::resetVoices(int numVoices)
+void Synth::setVoiceBudget(VoiceBudget* budget, float weight) noexcept
 {
-    numVoices_ = numVoices;
+    forEachInstrument([budget, weight](Impl& impl) {
+        impl.voiceManager_.setVoiceBudget(budget, weight);
+    });
+}
 
-    for (auto& set : sets_)
-        set->removeAllVoices();
+void Synth::Impl::resizeVoices(int numVoices)
+{
+    numVoices_ = numVoices;
 
+    const size_t firstNewVoice = voiceManager_.getNumVoiceObjects();
     voiceManager_.requireNumVoices(numVoices_, resources_);
+    const size_t numVoiceObjects = voiceManager_.getNumVoiceObjects();
+    if (numVoiceObjects == firstNewVoice)
+        return;
 
-    for (auto& voice : voiceManager_) {
+    resources_.getVoicePools().grow(resources_, numVoiceObjects, settingsPerVoice_.regionNeeds);
+
+    for (size_t i = firstNewVoice; i < numVoiceObjects; ++i) {
+        Voice& voice = voiceManager_[i];
         voice.setSampleRate(this->sampleRate_);
         voice.setSamplesPerBlock(this->samplesPerBlock_);
+        applySettingsToVoice(voice);
     }
 
-    applySettingsPerVoice();
+    prepareRenderLanes();
+}
+
+int Synth::getNumRenderThreads() const noexcept
+{
+    Impl& impl = *impl_;
+    return static_cast<int>(impl.renderThreads_.getNumLanes());
+}
+
+void Synth::setNumRenderThreads(int numThreads) noexcept
+{
+    Impl& impl = *impl_;
+    numThreads = clamp(numThreads, 1, config::maxRenderThreads);
+
+    if (static_cast<unsigned>(numThreads) == impl.renderThreads_.getNumLanes())
+        return;
+
+    try {
+        impl.renderThreads_.setNumLanes(static_cast<unsigned>(numThreads));
+    }
+    catch (std::system_error& error) {
+        DBG("[sfizz] Cannot start the render threads: " << error.what());
+        impl.renderThreads_.setNumLanes(1);
+    }
+
+    impl.prepareRenderLanes();
 }
 
 void Synth::Impl::resetCallbackBreakdown()
 {
+    const CallbackBreakdown last = callbackBreakdown_;
     callbackBreakdown_ = CallbackBreakdown();
+
+    // Keep the voice stages of the last timed block
+    if (!timeVoices_) {
+        callbackBreakdown_.data = last.data;
+        callbackBreakdown_.amplitude = last.amplitude;
+        callbackBreakdown_.filters = last.filters;
+        callbackBreakdown_.panning = last.panning;
+    }
+}
+
+void Synth::Impl::prepareRenderLanes()
+{
+    const unsigned numLanes = renderThreads_.getNumLanes();
+    resources_.setNumLanes(numLanes);
+
+    renderLanes_.resize(numLanes);
+    for (unsigned lane = 0; lane < numLanes; ++lane) {
+        RenderLane& renderLane = renderLanes_[lane];
+        renderLane.voices.clear();
+        renderLane.voices.reserve(voiceManager_.getNumVoiceObjects());
+
+        // lane 0 adds into the effect buses directly
+        const size_t numOutputs = (lane > 0) ? effectBuses_.size() : 0;
+        renderLane.busInputs.resize(numOutputs);
+        for (size_t i = 0; i < numOutputs; ++i) {
+            const auto& effectBuses = effectBuses_[i];
+            auto& busInputs = renderLane.busInputs[i];
+            busInputs.resize(effectBuses.size());
+            for (size_t j = 0, n = effectBuses.size(); j < n; ++j) {
+                const size_t numChannels = effectBuses[j] ? EffectChannels : 0;
+                busInputs[j] = AudioBuffer<float>(numChannels, samplesPerBlock_);
+            }
+        }
+    }
+
+    regionLanes_.assign(layers_.size(), -1);
+    for (const LayerPtr& layer : layers_)
+        layer->sharedCrossfade_.prepare(layer->getRegion(), samplesPerBlock_);
+
+    size_t numEffectBuses = 0;
+    for (const auto& effectBuses : effectBuses_)
+        numEffectBuses += effectBuses.size();
+    effectRenderJob_.buses.clear();
+    effectRenderJob_.buses.reserve(numEffectBuses);
+}
+
+bool Synth::Impl::shouldRenderConcurrently() const noexcept
+{
+    return renderThreads_.getNumLanes() > 1 &&
+        voiceManager_.getNumActiveVoices() >= 2 * config::minVoicesPerRenderThread;
+}
+
+void Synth::Impl::renderVoiceToBuses(Voice& voice, AudioSpan<float> tempSpan, unsigned numFrames) noexcept
+{
+    const Region* region = voice.getRegion();
+    const auto& effectBuses = getEffectBusesForOutput(region->output);
+    const auto& gains = region->gainToEffect;
+
+    // The usual case is a voice going to the main bus only
+    EffectBus* singleBus = nullptr;
+    float singleGain = 0.0f;
+    unsigned numSends = 0;
+    for (size_t i = 0, n = std::min(effectBuses.size(), gains.size()); i < n && numSends < 2; ++i) {
+        if (effectBuses[i] && gains[i] != 0) {
+            singleBus = effectBuses[i].get();
+            singleGain = gains[i];
+            ++numSends;
+        }
+    }
+
+    if (numSends == 1) {
+        voice.renderBlock(tempSpan, singleBus->getInputsToAdd(numFrames), singleGain);
+        return;
+    }
+
+    voice.renderBlock(tempSpan);
+    EffectBus::addToInputs(effectBuses, gains, tempSpan, numFrames);
+}
+
+void Synth::Impl::renderVoicesConcurrently(AudioSpan<float> tempSpan) noexcept
+{
+    const unsigned numFrames = static_cast<unsigned>(tempSpan.getNumFrames());
+    const unsigned numActiveVoices = static_cast<unsigned>(voiceManager_.getNumActiveVoices());
+    const unsigned numLanes = std::min(
+        renderThreads_.getNumLanes(), numActiveVoices / config::minVoicesPerRenderThread);
+
+    // Distribute the voices; all the voices of a region go into the same lane,
+    // because the modulation matrix holds per-voice buffers for each region.
+    for (RenderLane& renderLane : renderLanes_)
+        renderLane.voices.clear();
+
+    voiceManager_.forEachBusyVoice([&](Voice& voice) {
+        const size_t regionIndex = static_cast<size_t>(voice.getRegion()->getId().number());
+        ASSERT(regionIndex < regionLanes_.size());
+        int& regionLane = regionLanes_[regionIndex];
+        if (regionLane < 0) {
+            regionLane = 0;
+            for (unsigned lane = 1; lane < numLanes; ++lane) {
+                if (renderLanes_[lane].voices.size() < renderLanes_[regionLane].voices.size())
+                    regionLane = static_cast<int>(lane);
+            }
+        }
+        renderLanes_[regionLane].voices.push_back(&voice);
+    });
+
+    // Compute everything shared between lanes ahead of time
+    ModMatrix& mm = resources_.getModMatrix();
+    mm.generateGlobal();
+    BeatClock& beatClock = resources_.getBeatClock();
+    if (beatClock.hasConsumers())
+        beatClock.getRunningBeatPosition();
+
+    voiceRenderJob_.tempSpan = tempSpan;
+    voiceRenderJob_.numFrames = numFrames;
+    renderThreads_.run(voiceRenderJob_);
+
+    // Reduce the lanes in a fixed order
+    for (size_t lane = 0; lane < renderLanes_.size(); ++lane) {
+        RenderLane& renderLane = renderLanes_[lane];
+
+        for (size_t i = 0, n = renderLane.busInputs.size(); i < n; ++i) {
+            const auto& effectBuses = effectBuses_[i];
+            auto& busInputs = renderLane.busInputs[i];
+            for (size_t j = 0, m = effectBuses.size(); j < m; ++j) {
+                if (auto& bus = effectBuses[j])
+                    bus->addToInputs(AudioSpan<float>(busInputs[j]), 1.0f, numFrames);
+            }
+        }
+
+        callbackBreakdown_.data += renderLane.callbackBreakdown.data;
+        callbackBreakdown_.amplitude += renderLane.callbackBreakdown.amplitude;
+        callbackBreakdown_.filters += renderLane.callbackBreakdown.filters;
+        callbackBreakdown_.panning += renderLane.callbackBreakdown.panning;
+
+        for (const Voice* voice : renderLane.voices)
+            regionLanes_[voice->getRegion()->getId().number()] = -1;
+    }
+
+    // Clean up in the same order as the single-threaded rendering
+    voiceManager_.forEachBusyVoice([this](Voice& voice) {
+        updateVoiceStartStats(voice);
+        if (voice.toBeCleanedUp()) {
+            if (voice.wasCulled())
+                ++callbackBreakdown_.culledVoices;
+            voice.reset();
+        }
+    });
+}
+
+void Synth::Impl::processEffectBuses(unsigned numFrames) noexcept
+{
+    std::vector<EffectBus*>& buses = effectRenderJob_.buses;
+    buses.clear();
+
+    const int effectQuality = resources_.getSynthConfig().currentEffectQuality();
+
+    size_t numBusesWithEffects = 0;
+    for (int i = 0; i < numOutputs_; ++i) {
+        for (auto& bus : getEffectBusesForOutput(i)) {
+            if (!bus)
+                continue;
+            bus->setQuality(effectQuality);
+            if (bus->numEffects() > 0 && bus->hasNonZeroOutput()) {
+                buses.push_back(bus.get());
+                ++numBusesWithEffects;
+            }
+            else
+                bus->process(numFrames);
+        }
+    }
+
+    const unsigned numLanes = std::min(
+        renderThreads_.getNumLanes(), static_cast<unsigned>(numBusesWithEffects));
+
+    if (numLanes < 2) {
+        for (EffectBus* bus : buses)
+            bus->process(numFrames);
+        return;
+    }
+
+    effectRenderJob_.numLanes = numLanes;
+    effectRenderJob_.numFrames = numFrames;
+    renderThreads_.run(effectRenderJob_);
+}
+
+void Synth::Impl::EffectRenderJob::process(unsigned lane) noexcept
+{
+    for (size_t i = lane, n = buses.size(); i < n; i += numLanes)
+        buses[i]->process(numFrames);
+}
+
+void Synth::Impl::renderVoicesOfLane(unsigned lane) noexcept
+{
+    RenderLane& renderLane = renderLanes_[lane];
+    renderLane.callbackBreakdown = CallbackBreakdown();
+
+    const unsigned numFrames = voiceRenderJob_.numFrames;
+    if (lane > 0) {
+        for (auto& busInputs : renderLane.busInputs) {
+            for (auto& input : busInputs)
+                AudioSpan<float>(input).first(numFrames).fill(0.0f);
+        }
+    }
+
+    if (renderLane.voices.empty())
+        return;
+
+    SpanHolder<AudioSpan<float>> laneSpan;
+    AudioSpan<float> tempSpan = voiceRenderJob_.tempSpan;
+    if (lane > 0) {
+        // the buffer pool of the worker's lane
+        laneSpan = resources_.getBufferPool().getStereoBuffer(numFrames);
+        if (!laneSpan) {
+            DBG("[sfizz] Could not get a temporary buffer for render lane " << lane);
+            return;
+        }
+        tempSpan = *laneSpan;
+    }
+
+    ModMatrix& mm = resources_.getModMatrix();
+    CallbackBreakdown& callbackBreakdown = renderLane.callbackBreakdown;
+#if SFIZZ_TRACING
+    const bool traceVoices = tracer_.tracesVoices();
+#endif
+
+    for (Voice* voice : renderLane.voices) {
+#if SFIZZ_TRACING
+        const TimePoint voiceStart = traceVoices ? highResNow() : TimePoint {};
+#endif
+        mm.beginVoice(voice->getId(), voice->getRegion()->getId(), voice->getTriggerEvent().value);
+
+        const Region* region = voice->getRegion();
+        ASSERT(region != nullptr);
+        const auto& effectBuses = getEffectBusesForOutput(region->output);
+
+        voice->setTimingEnabled(timeVoices_);
+        if (lane == 0)
+            renderVoiceToBuses(*voice, tempSpan, numFrames);
+        else {
+            voice->renderBlock(tempSpan);
+            for (size_t i = 0, n = effectBuses.size(); i < n; ++i) {
+                float addGain = region->getGainToEffectBus(i);
+                if (effectBuses[i] && addGain != 0)
+                    AudioSpan<float>(renderLane.busInputs[region->output][i]).first(numFrames).multiplyAdd(tempSpan, addGain);
+            }
+        }
+        callbackBreakdown.data += voice->getLastDataDuration();
+        callbackBreakdown.amplitude += voice->getLastAmplitudeDuration();
+        callbackBreakdown.filters += voice->getLastFilterDuration();
+        callbackBreakdown.panning += voice->getLastPanningDuration();
+
+        mm.endVoice();
+#if SFIZZ_TRACING
+        if (traceVoices)
+            traceVoice(*voice, voiceStart, lane);
+#endif
+    }
 }
 
 void Synth::Impl::applySettingsPerVoice()
 {
+    size_t numVoices = 0;
     for (auto& voice : voiceManager_) {
-        voice.setMaxFiltersPerVoice(settingsPerVoice_.maxFilters);
-        voice.setMaxEQsPerVoice(settingsPerVoice_.maxEQs);
-        voice.setMaxLFOsPerVoice(settingsPerVoice_.maxLFOs);
-        voice.setMaxFlexEGsPerVoice(settingsPerVoice_.maxFlexEGs);
-        voice.setPitchEGEnabledPerVoice(settingsPerVoice_.havePitchEG);
-        voice.setFilterEGEnabledPerVoice(settingsPerVoice_.haveFilterEG);
-        voice.setAmplitudeLFOEnabledPerVoice(settingsPerVoice_.haveAmplitudeLFO);
-        voice.setPitchLFOEnabledPerVoice(settingsPerVoice_.havePitchLFO);
-        voice.setFilterLFOEnabledPerVoice(settingsPerVoice_.haveFilterLFO);
+        ASSERT(voice.isFree());
+        ++numVoices;
+    }
+
+    // Collected here, as the regions change after loading too
+    std::vector<VoicePools::RegionNeeds>& regionNeeds = settingsPerVoice_.regionNeeds;
+    regionNeeds.clear();
+    for (const LayerPtr& layerPtr : layers_) {
+        const Region& region = layerPtr->getRegion();
+        if (region.filters.empty() && region.equalizers.empty() && region.lfos.empty() && region.flexEGs.empty())
+            continue;
+        regionNeeds.push_back({ region.polyphony, region.filters.size(),
+            region.equalizers.size(), region.lfos.size(), region.flexEGs.size() });
     }
+
+    resources_.getVoicePools().resize(resources_, numVoices, settingsPerVoice_.regionNeeds);
+
+    for (auto& voice : voiceManager_)
+        applySettingsToVoice(voice);
+
+    sizeBufferPools();
+}
+
+void Synth::Impl::applySettingsToVoice(Voice& voice)
+{
+    voice.setMaxFiltersPerVoice(settingsPerVoice_.maxFilters);
+    voice.setMaxEQsPerVoice(settingsPerVoice_.maxEQs);
+    voice.setMaxLFOsPerVoice(settingsPerVoice_.maxLFOs);
+    voice.setMaxFlexEGsPerVoice(settingsPerVoice_.maxFlexEGs);
+    voice.setPitchEGEnabledPerVoice(settingsPerVoice_.havePitchEG);
+    voice.setFilterEGEnabledPerVoice(settingsPerVoice_.haveFilterEG);
+    voice.setAmplitudeLFOEnabledPerVoice(settingsPerVoice_.haveAmplitudeLFO);
+    voice.setPitchLFOEnabledPerVoice(settingsPerVoice_.havePitchLFO);
+    voice.setFilterLFOEnabledPerVoice(settingsPerVoice_.haveFilterLFO);
+}
+
+void Synth::Impl::sizeBufferPools()
+{
+    // The block rendering holds a mono buffer while the voices render
+    const int numBuffers = 1 + settingsPerVoice_.maxBufferNesting;
+    resources_.setBufferPoolSizes(
+        numBuffers, config::stereoBufferPoolSize, config::indexBufferPoolSize);
 }
 
 void Synth::Impl::setupModMatrix()
 {
     ModMatrix& mm = resources_.getModMatrix();
+    const bool controlRate = resources_.getSynthConfig().controlRateModulations;
+
+    // The tempo synced LFOs read the running buffers of the beat clock
+    BeatClock& beatClock = resources_.getBeatClock();
+    beatClock.clearConsumers();
+    auto registerBeats = [&beatClock](const LFODescription& desc) {
+        if (desc.beats > 0)
+            beatClock.registerConsumer();
+    };
 
     for (const LayerPtr& layerPtr : layers_) {
         const Region& region = layerPtr->getRegion();
 
+        for (const LFODescription& desc : region.lfos)
+            registerBeats(desc);
+        for (const auto* desc : { &region.amplitudeLFO, &region.pitchLFO, &region.filterLFO }) {
+            if (*desc)
+                registerBeats(**desc);
+        }
+
         for (const Region::Connection& conn : region.connections) {
             ModGenerator* gen = nullptr;
 
@@ -2074,10 +4098,16 @@ void Synth::Impl::setupModMatrix()
                 DBG("[sfizz] Failed to connect modulation source and target");
                 ASSERTFALSE;
             }
+
+            if (controlRate && ModIds::supportsControlRate(targetKey.id()))
+                mm.setControlRate(target, true);
         }
     }
 
     mm.init();
+
+    for (const LayerPtr& layerPtr : layers_)
+        layerPtr->prepareVoiceTemplate(mm);
 }
 
 void Synth::setPreloadSize(uint32_t preloadSize) noexcept
@@ -2098,6 +4128,50 @@ uint32_t Synth::getPreloadSize() const noexcept
     return impl.resources_.getFilePool().getPreloadSize();
 }
 
+void Synth::enableAdaptivePreloading(bool enable) noexcept
+{
+    impl_->resources_.getFilePool().setAdaptivePreloading(enable);
+}
+
+bool Synth::isAdaptivePreloadingEnabled() const noexcept
+{
+    return impl_->resources_.getFilePool().isAdaptivePreloading();
+}
+
+bool Synth::updateAdaptivePreloading() noexcept
+{
+    return impl_->resources_.getFilePool().updateAdaptivePreloading();
+}
+
+double Synth::getStreamingLatency(double percentile) const noexcept
+{
+    return impl_->resources_.getFilePool().getStreamingLatency(percentile);
+}
+
+bool Synth::setOversamplingFactor(int factor) noexcept
+{
+    Impl& impl = *impl_;
+
+    switch (factor) {
+    case 1: // fallthrough
+    case 2: // fallthrough
+    case 4: // fallthrough
+    case 8:
+        break;
+    default:
+        return false;
+    }
+
+    impl.resources_.getFilePool().setOversamplingFactor(static_cast<Oversampling>(factor));
+    return true;
+}
+
+int Synth::getOversamplingFactor() const noexcept
+{
+    Impl& impl = *impl_;
+    return static_cast<int>(impl.resources_.getFilePool().getOversamplingFactor());
+}
+
 void Synth::enableFreeWheeling() noexcept
 {
     Impl& impl = *impl_;
@@ -2124,11 +4198,8 @@ void Synth::Impl::resetAllControllers(int delay) noexcept
     for (int cc = 0; cc < config::numCCs; ++cc)
         midiState.ccEvent(delay, cc, defaultCCValues_[cc]);
 
-    for (auto& voice : voiceManager_) {
-        voice.registerPitchWheel(delay, 0);
-        for (int cc = 0; cc < config::numCCs; ++cc)
-            voice.registerCC(delay, cc, defaultCCValues_[cc]);
-    }
+    for (int cc = 0; cc < config::numCCs; ++cc)
+        registerPedalCC(delay, cc, defaultCCValues_[cc]);
 
     for (const LayerPtr& layerPtr : layers_) {
         Layer& layer = *layerPtr;
@@ -2178,10 +4249,121 @@ const Synth::CallbackBreakdown& Synth::getCallbackBreakdown() const noexcept
     return impl.callbackBreakdown_;
 }
 
+const Synth::LoadBreakdown& Synth::getLoadBreakdown() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.loadBreakdown_;
+}
+
+bool Synth::startTrace(const fs::path& file, bool traceVoices)
+{
+#if SFIZZ_TRACING
+    Impl& impl = *impl_;
+    return impl.tracer_.start(file, traceVoices);
+#else
+    (void)file;
+    (void)traceVoices;
+    return false;
+#endif
+}
+
+Synth::CallbackStats Synth::getCallbackStats(CallbackStage stage) const noexcept
+{
+    const Impl& impl = *impl_;
+    CallbackStats stats;
+    if (stage < 0 || stage >= NumCallbackStages)
+        return stats;
+
+    const LatencyHistogram& histogram = impl.callbackHistograms_[stage];
+    stats.numCallbacks = histogram.getCount();
+    stats.min = histogram.getMin();
+    stats.max = histogram.getMax();
+    stats.mean = histogram.getMean();
+    stats.p50 = histogram.getPercentile(0.5);
+    stats.p99 = histogram.getPercentile(0.99);
+    stats.p999 = histogram.getPercentile(0.999);
+    return stats;
+}
+
+void Synth::resetCallbackStats() noexcept
+{
+    Impl& impl = *impl_;
+    for (LatencyHistogram& histogram : impl.callbackHistograms_)
+        histogram.reset();
+}
+
+Synth::VoiceStartStats Synth::getVoiceStartStats(VoiceStartStage stage) const noexcept
+{
+    const Impl& impl = *impl_;
+    VoiceStartStats stats;
+    if (stage < 0 || stage >= NumVoiceStartStages)
+        return stats;
+
+    const LatencyHistogram& histogram = impl.voiceStartHistograms_[stage];
+    stats.numStarts = histogram.getCount();
+    stats.min = histogram.getMin();
+    stats.max = histogram.getMax();
+    stats.mean = histogram.getMean();
+    stats.p50 = histogram.getPercentile(0.5);
+    stats.p99 = histogram.getPercentile(0.99);
+    stats.p999 = histogram.getPercentile(0.999);
+    stats.numPreloaded = impl.numPreloadedStarts_.load(std::memory_order_relaxed);
+    stats.numNotPreloaded = impl.numNotPreloadedStarts_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Synth::resetVoiceStartStats() noexcept
+{
+    Impl& impl = *impl_;
+    for (LatencyHistogram& histogram : impl.voiceStartHistograms_)
+        histogram.reset();
+    impl.numPreloadedStarts_.store(0, std::memory_order_relaxed);
+    impl.numNotPreloadedStarts_.store(0, std::memory_order_relaxed);
+}
+
+void Synth::setVoiceTimingPeriod(int numBlocks) noexcept
+{
+    Impl& impl = *impl_;
+    impl.voiceTimingPeriod_ = max(1, numBlocks);
+    impl.voiceTimingCounter_ = 0;
+}
+
+int Synth::getVoiceTimingPeriod() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.voiceTimingPeriod_;
+}
+
+void Synth::stopTrace()
+{
+    Impl& impl = *impl_;
+    impl.tracer_.stop();
+}
+
+void Synth::Impl::traceVoice(const Voice& voice, TimePoint start, unsigned lane) noexcept
+{
+    TraceEvent event;
+    event.type = TraceEvent::Type::Voice;
+    event.lane = static_cast<uint8_t>(lane);
+    event.start = start;
+    event.duration = Duration(highResNow() - start).count();
+    event.stages[0] = static_cast<float>(voice.getLastDataDuration());
+    event.stages[1] = static_cast<float>(voice.getLastAmplitudeDuration());
+    event.stages[2] = static_cast<float>(voice.getLastFilterDuration());
+    event.stages[3] = static_cast<float>(voice.getLastPanningDuration());
+    event.number = voice.getRegion() ? static_cast<int32_t>(voice.getRegion()->getId().number()) : -1;
+    event.count = voice.getId().number();
+    event.detail = voice.getSourcePosition();
+    tracer_.push(event);
+}
+
 
 void Synth::allSoundOff() noexcept
 {
     Impl& impl = *impl_;
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
     for (auto& voice : impl.voiceManager_)
         voice.reset();
     for (int i = 0; i < impl.numOutputs_; ++i) {
@@ -2214,6 +4396,7 @@ void sfz::Synth::setBroadcastCallback(sfizz_receive_t* broadcast, void* data)
     Impl& impl = *impl_;
     impl.broadcastReceiver = broadcast;
     impl.broadcastData = data;
+    subscriptions_->setReceiver(broadcast, data);
 }
 
 void Synth::Impl::collectUsedCCsFromRegion(BitArray<config::numCCs>& usedCCs, const Region& region)
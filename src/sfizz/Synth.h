@@ -6,13 +6,20 @@
 
 #pragma once
 #include "AudioSpan.h"
+#include "Config.h"
 #include "Resources.h"
 #include "Messaging.h"
+#include "RTSemaphore.h"
 #include "utility/NumericId.h"
 #include "utility/LeakDetector.h"
+#include "utility/SeqLock.h"
 #include <ghc/fs_std.hpp>
 #include <absl/strings/string_view.h>
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <thread>
 #include <bitset>
 #include <string>
 #include <vector>
@@ -28,6 +35,8 @@ class EffectBus;
 struct Region;
 struct Layer;
 class Voice;
+class VoiceBudget;
+class Subscriptions;
 
 using CCNamePair = std::pair<uint16_t, std::string>;
 using NoteNamePair = std::pair<uint8_t, std::string>;
@@ -119,6 +128,148 @@ public:
      *         @true otherwise.
      */
     bool loadSfzString(const fs::path& path, absl::string_view text);
+    /**
+     * @brief Empties the current regions and load an instrument file of
+     * another format, which a function converts into an SFZ document.
+     *
+     * The document goes by the virtual path of the file with an added `.sfz`
+     * extension, like with loadSfzString(). When the synth has a cache
+     * directory, the parse is kept there like the ones of the SFZ files, so
+     * the next loads of the unchanged file replay the opcodes without
+     * converting nor parsing again.
+     *
+     * @param file The instrument file.
+     * @param convert The conversion of the file into an SFZ document, which
+     *                the synth keeps to save its state.
+     *
+     * @return @false if no regions were loaded,
+     *         @true otherwise.
+     */
+    bool loadConvertedFile(const fs::path& file, const std::function<std::string(const fs::path&)>& convert);
+    struct Impl;
+    /**
+     * @brief The progress of a load of an SFZ file.
+     */
+    struct LoadProgress {
+        int numRegions { 0 };
+        size_t numFilesToPreload { 0 };
+        size_t numPreloadedFiles { 0 };
+        size_t numBytesRead { 0 };
+    };
+    using LoadProgressCallback = std::function<void(const LoadProgress&)>;
+    /**
+     * @brief A load of an SFZ file running on a background thread, as
+     * started by loadSfzFileAsync().
+     *
+     * The instrument is built aside, and replaces the current one at the
+     * start of a call to renderBlock() once complete, so the load only ends
+     * if the synth keeps rendering, or if it is canceled.
+     *
+     * The handle must not outlive the synth. Destroying it waits for the
+     * load to end.
+     */
+    class AsyncLoad {
+    public:
+        ~AsyncLoad();
+        AsyncLoad(const AsyncLoad&) = delete;
+        AsyncLoad& operator=(const AsyncLoad&) = delete;
+        /**
+         * @brief Ask the load to stop between two files. The synth keeps the
+         * current instrument, unless the new one has already replaced it.
+         */
+        void cancel() noexcept;
+        /**
+         * @brief Is the load over, successfully or not?
+         */
+        bool isDone() const noexcept;
+        /**
+         * @brief Wait for the end of the load.
+         *
+         * @return true if the instrument was loaded and replaced the current one
+         * @return false if the load failed or was canceled
+         */
+        bool wait();
+        /**
+         * @brief Get the current progress of the load.
+         */
+        LoadProgress getProgress() const noexcept;
+
+    private:
+        friend class Synth;
+        friend struct Synth::Impl;
+        AsyncLoad() = default;
+        bool isCanceled() const noexcept { return canceled_.load(std::memory_order_relaxed); }
+        void reportProgress();
+
+        std::thread thread_;
+        LoadProgressCallback callback_;
+        std::atomic<bool> canceled_ { false };
+        std::atomic<bool> done_ { false };
+        bool success_ { false };
+        std::atomic<int> numRegions_ { 0 };
+        std::atomic<size_t> numFilesToPreload_ { 0 };
+        std::atomic<size_t> numPreloadedFiles_ { 0 };
+        std::atomic<size_t> numBytesRead_ { 0 };
+        Impl* built_ { nullptr }; // the new instrument, until swapped in
+        Impl* retired_ { nullptr }; // the previous instrument, once swapped out
+        RTSemaphore swapped_;
+    };
+    /**
+     * @brief Load a new SFZ file on a background thread, and replace the
+     * current instrument with it once complete.
+     *
+     * The new instrument starts with the settings of the synth, such as the
+     * sample rate, the number of voices or the tuning, and the current
+     * controller values. The current instrument keeps playing until the
+     * start of the first call to renderBlock() after the load, where the
+     * new one takes its place and the sounding voices stop.
+     *
+     * The RT functions can be called during the load, and apply to the
+     * current instrument. Other functions must not be called until the load
+     * is done.
+     *
+     * @param file
+     * @param callback the callback which receives the progress, called from
+     *                 the loading thread
+     * @return std::unique_ptr<AsyncLoad> the handle of the load
+     */
+    std::unique_ptr<AsyncLoad> loadSfzFileAsync(const fs::path& file, LoadProgressCallback callback = {});
+    /**
+     * @brief Load an SFZ file as the resident instrument of a program. The
+     * instrument is fully prepared aside, and a program change to this
+     * program switches to it at the start of the next block, while the
+     * voices of the previous instrument play their release. A program
+     * change to a program without a resident instrument switches back to
+     * the default instrument, which the synth had before. The instruments
+     * share the preloaded sample data.
+     *
+     * The resident instrument starts with the settings of the synth, and
+     * then follows its sample rate, block size and processing rate. The
+     * other functions, the loads included, apply to the active instrument.
+     *
+     * @param program the program, from 0 to 127
+     * @param file
+     * @return true if the file was loaded
+     */
+    bool loadResidentProgram(int program, const fs::path& file);
+    /**
+     * @brief Remove the resident instrument of a program. If it is active,
+     * the default instrument takes its place.
+     *
+     * @param program
+     */
+    void removeResidentProgram(int program);
+    /**
+     * @brief Check whether a program has a resident instrument.
+     *
+     * @param program
+     */
+    bool hasResidentProgram(int program) const noexcept;
+    /**
+     * @brief Get the program of the active instrument, or -1 for the
+     * default instrument.
+     */
+    int getActiveProgram() const noexcept { return activeProgram_; }
     /**
      * @brief Sets the tuning from a Scala file loaded from the file system.
      *
@@ -189,10 +340,37 @@ public:
      * @return int
      */
     int getNumCurves() const noexcept;
+    /**
+     * @brief Get the number of stereo outputs of the loaded instrument, from
+     * the highest output of its regions. The rendering writes the output N
+     * to the channels 2N and 2N+1, wrapping around the channels of the buffer.
+     *
+     * @return int
+     */
+    int getNumOutputs() const noexcept;
     /**
      * @brief Export a MIDI Name document describing the loaded instrument
      */
     std::string exportMidnam(absl::string_view model = {}) const;
+    /**
+     * @brief Save the state of the session as a compact binary blob: the
+     * instrument file, or its text if it was loaded from memory, the
+     * controllers which differ from their defaults, the current keyswitch,
+     * the tuning, the qualities, the number of voices and the volume.
+     */
+    std::vector<uint8_t> saveState() const;
+    /**
+     * @brief Restore a state of saveState(), which loads its instrument. With
+     * a cache directory, the load replays the parses of the unchanged files
+     * instead of parsing them again.
+     *
+     * @param data
+     * @param size
+     * @return true if the state was restored
+     * @return false if the data is not a state, or if the instrument failed
+     *         to load
+     */
+    bool loadState(const void* data, size_t size);
     /**
      * @brief Find the layer which is associated with the given identifier.
      *
@@ -282,6 +460,22 @@ public:
      * @return size_t
      */
     size_t getNumPreloadedSamples() const noexcept;
+    /**
+     * @brief Get the RMS and peak envelope of a sample of the instrument,
+     * with one value of each per window of config::sampleEnvelopeResolution
+     * frames of its data, as far as it is measured. The windows are measured
+     * from the preloaded data, and all of them once the sample is streamed
+     * or was measured whole before, which the information cache keeps.
+     *
+     * @param sample the sample, as in the sample opcode after the default path
+     * @param reverse whether the sample is the reversed one
+     * @param rms the RMS values, in the full scale
+     * @param peak the peak values, in the full scale
+     * @return the number of windows of the whole sample, which the measured
+     *         windows fall short of until it is measured, or 0 if the sample
+     *         is not loaded
+     */
+    size_t getSampleEnvelope(const std::string& sample, bool reverse, std::vector<float>& rms, std::vector<float>& peak) const;
 
     /**
      * @brief Set the maximum size of the blocks for the callback. The actual
@@ -304,6 +498,37 @@ public:
      * @param sampleRate
      */
     void setSampleRate(float sampleRate) noexcept;
+    /**
+     * @brief Set the highest sample rate at which the voices and the effects
+     * process, or 0 to process at the sample rate of the host. When the host
+     * runs above it, the engine processes at the host rate divided by 2, 4
+     * or 8, and upsamples its outputs to the host rate. This saves most of
+     * the processing of the high rate sessions, for instruments which have
+     * no content above the audible range.
+     *
+     * @param sampleRate
+     */
+    void setMaxProcessingRate(float sampleRate) noexcept;
+    /**
+     * @brief Get the highest processing sample rate, or 0 if none.
+     *
+     * @return float
+     */
+    float getMaxProcessingRate() const noexcept;
+    /**
+     * @brief Get the sample rate at which the voices and the effects process.
+     *
+     * @return float
+     */
+    float getProcessingRate() const noexcept;
+    /**
+     * @brief Get the latency of the outputs, in frames at the host rate,
+     * which the upsampling from the processing rate adds. The host should
+     * compensate it.
+     *
+     * @return int
+     */
+    int getLatency() const noexcept;
     /**
      * @brief Get the default resampling quality for the given mode.
      *
@@ -334,12 +559,363 @@ public:
      * @param quality the quality setting
      */
     void setOscillatorQuality(ProcessMode mode, int quality);
+    /**
+     * @brief Get the effect quality for the given mode.
+     *
+     * @param mode the processing mode
+     *
+     * @return the quality setting
+     */
+    int getEffectQuality(ProcessMode mode);
+    /**
+     * @brief Set the effect quality for the given mode. The effects which
+     * oversample run at most at 2^quality times the sample rate.
+     *
+     * @param mode the processing mode
+     * @param quality the quality setting, between 0 and 3
+     */
+    void setEffectQuality(ProcessMode mode, int quality);
     /**
      * @brief Set whether pressing the sustain pedal cancels the releases
      *
      * @param value
      */
     void setSustainCancelsRelease(bool value);
+    /**
+     * @brief Set the level under which released voices are ended early.
+     * The lowest value of the range disables the culling.
+     *
+     * @param threshold the threshold in dB, between -144 and 0
+     */
+    void setVoiceCullingThreshold(float threshold);
+    /**
+     * @brief Get the level under which released voices are ended early.
+     *
+     * @return float the threshold in dB
+     */
+    float getVoiceCullingThreshold() const noexcept;
+    /**
+     * @brief Enable or disable the quality governor. When enabled and not
+     * freewheeling, new voices use a lower sample and oscillator quality
+     * while the callbacks come close to their deadline.
+     *
+     * @param enable
+     */
+    void enableQualityGovernor(bool enable) noexcept;
+    /**
+     * @brief Is the quality governor enabled?
+     *
+     * @return true
+     * @return false
+     */
+    bool isQualityGovernorEnabled() const noexcept;
+    /**
+     * @brief Enable or disable the adaptive sample quality. When enabled,
+     * the voices choose the interpolation of each block from their playback
+     * ratios, up to the sample quality set.
+     *
+     * @param enable
+     */
+    void enableAdaptiveSampleQuality(bool enable) noexcept;
+    /**
+     * @brief Is the adaptive sample quality enabled?
+     *
+     * @return true
+     * @return false
+     */
+    bool isAdaptiveSampleQualityEnabled() const noexcept;
+    /**
+     * @brief Get the number of quality steps the governor currently removes
+     * from new voices.
+     *
+     * @return int
+     */
+    int getQualityReduction() const noexcept;
+    /**
+     * @brief Set the directory of the decoded sample cache. Compressed files
+     * keep their decoded preloaded data there, which later loads read back
+     * instead of decoding the files again. The parses of the instrument files
+     * are kept there as well, and replayed by the loads of unchanged files.
+     * An empty path disables the cache. This applies to the files preloaded
+     * afterwards.
+     *
+     * @param directory
+     */
+    void setSampleCacheDirectory(const fs::path& directory);
+    /**
+     * @brief Get the directory of the decoded sample cache.
+     *
+     * @return const fs::path&
+     */
+    const fs::path& getSampleCacheDirectory() const noexcept;
+    /**
+     * @brief Read the usage profile of the instrument from a file, which
+     * guides the preloads of the instrument loaded afterwards: the samples
+     * which played in the profile are preloaded first and as far as they
+     * played, and the others preload little. Then the profile records the
+     * usage of the samples, for saveUsageProfile.
+     *
+     * @param path the file of the profile, usually kept with the session
+     * @return false if the file is not a profile, in which case the samples
+     *         preload the same
+     */
+    bool loadUsageProfile(const fs::path& path);
+    /**
+     * @brief Write the usage profile of the instrument into a file: the
+     * profile which was loaded, with the samples which played since, how many
+     * times and how far.
+     *
+     * @param path the file of the profile
+     * @return false if the file could not be written
+     */
+    bool saveUsageProfile(const fs::path& path) const;
+    /**
+     * @brief Read the information of all the audio files in a directory and
+     * its subdirectories, such as the sample folder of a library, and keep
+     * it in the information cache. The following loads of these files skip
+     * scanning their metadata, and with a sample cache directory, so do the
+     * loads of later runs.
+     *
+     * @param directory the directory; a relative one is taken from the
+     *                  directory of the current instrument
+     * @return the number of audio files read
+     */
+    size_t probeSampleDirectory(const fs::path& directory);
+    /**
+     * @brief Set how many sample files are read concurrently while loading
+     * an instrument. A value of 1 reads them one after the other.
+     *
+     * @param parallelism
+     */
+    void setLoadingParallelism(unsigned parallelism) noexcept;
+    /**
+     * @brief Get how many sample files are read concurrently while loading
+     * an instrument.
+     *
+     * @return unsigned
+     */
+    unsigned getLoadingParallelism() const noexcept;
+    /**
+     * @brief Set the window of the bounded streaming mode, in frames. Every
+     * voice then streams its sample on its own and holds about this many
+     * frames ahead of its play head in memory, instead of the whole file.
+     * A window of 0 disables the bounded mode.
+     *
+     * @param numFrames
+     */
+    void setStreamingWindow(uint32_t numFrames) noexcept;
+    /**
+     * @brief Get the window of the bounded streaming mode, in frames, or 0
+     * if disabled.
+     *
+     * @return uint32_t
+     */
+    uint32_t getStreamingWindow() const noexcept;
+    /**
+     * @brief Set a budget for the memory of the sample data, in bytes, or 0
+     * for no budget. Over the budget, the streamed data of the idle samples
+     * is freed, least recently played first, and then their preloaded data
+     * is shrunk to a minimum.
+     *
+     * @param numBytes
+     */
+    void setMemoryBudget(size_t numBytes) noexcept;
+    /**
+     * @brief Get the memory budget, in bytes, or 0 if none.
+     *
+     * @return size_t
+     */
+    size_t getMemoryBudget() const noexcept;
+    /**
+     * @brief Enable or disable the immediate release of the streamed data.
+     * When enabled, the streamed data of a sample is freed in the
+     * background as soon as its last voice ends, instead of after some
+     * seconds of idleness, and the streams of the samples which nobody
+     * plays anymore stop. This bounds the memory of the large one-shot
+     * samples, at the expense of streaming again the samples replayed soon.
+     *
+     * @param enable
+     */
+    void enableImmediateRelease(bool enable) noexcept;
+    /**
+     * @brief Check whether the streamed data is freed as soon as its last
+     * voice ends.
+     *
+     * @return true if enabled
+     */
+    bool isImmediateReleaseEnabled() const noexcept;
+    /**
+     * @brief Set the NUMA node of the sample data loaded from now on, which
+     * is best the node of the thread which renders the synth, or -1 for the
+     * node of the loading threads. The preloads are shared only between the
+     * synths of the same node, which then hold a replica each.
+     *
+     * @param node
+     */
+    void setNumaNode(int node) noexcept;
+    /**
+     * @brief Get the NUMA node of the sample data, or -1 if none.
+     *
+     * @return int
+     */
+    int getNumaNode() const noexcept;
+    /**
+     * @brief Enable or disable the prewarming of the release samples. When
+     * enabled, a note-on starts streaming the samples of the release regions
+     * of the note, so they are loaded by the note-off. This does nothing in
+     * the bounded streaming mode.
+     *
+     * @param enable
+     */
+    void enableReleasePrewarming(bool enable) noexcept;
+    /**
+     * @brief Enable or disable the lazy preloading of the keyswitched
+     * articulations, which applies from the next load. When enabled, the
+     * samples of the regions under a `sw_last` are only preloaded if their
+     * keyswitch is the default one or an eager one, and the others load in
+     * the background once their keyswitch is selected. The regions play
+     * once their samples are preloaded.
+     *
+     * @param enable
+     */
+    void enableLazyKeyswitchPreloading(bool enable) noexcept;
+    /**
+     * @brief Is the lazy preloading of the keyswitched articulations enabled?
+     *
+     * @return true
+     * @return false
+     */
+    bool isLazyKeyswitchPreloadingEnabled() const noexcept;
+    /**
+     * @brief Set whether the articulation of a keyswitch is preloaded at
+     * load time in the lazy keyswitch preloading.
+     *
+     * @param noteNumber the keyswitch, between 0 and 127
+     * @param eager
+     */
+    void setEagerKeyswitch(int noteNumber, bool eager) noexcept;
+    /**
+     * @brief Is the articulation of a keyswitch preloaded at load time in
+     * the lazy keyswitch preloading?
+     *
+     * @param noteNumber the keyswitch, between 0 and 127
+     * @return true
+     * @return false
+     */
+    bool isEagerKeyswitch(int noteNumber) const noexcept;
+    /**
+     * @brief Is the prewarming of the release samples enabled?
+     *
+     * @return true
+     * @return false
+     */
+    bool isReleasePrewarmingEnabled() const noexcept;
+    /**
+     * @brief Get the memory of the sample data, in bytes.
+     *
+     * @return size_t
+     */
+    size_t getMemoryUsage() const noexcept;
+    /**
+     * @brief The memory of the synth by category, in bytes. The memory of
+     * the samples is exact, the other categories are estimates from the
+     * sizes of the objects and their main allocations.
+     */
+    struct MemoryBreakdown {
+        size_t preloadedSamples { 0 }; // the preloaded and loaded sample data
+        size_t streamedSamples { 0 }; // the streamed sample data and the bounded streams
+        size_t wavetables { 0 }; // the file waves
+        size_t voices { 0 }; // the voices, and the filters, EQs, LFOs and flex EGs of their pools
+        size_t bufferPool { 0 };
+        size_t effectBuses { 0 }; // the buffers of the buses, without the state of the effects
+        size_t regions { 0 };
+
+        size_t total() const noexcept
+        {
+            return preloadedSamples + streamedSamples + wavetables + voices
+                + bufferPool + effectBuses + regions;
+        }
+    };
+    /**
+     * @brief Get the memory of the synth by category. It walks the
+     * instrument, so avoid calling it on every block.
+     *
+     * @return MemoryBreakdown
+     */
+    MemoryBreakdown getMemoryBreakdown() const noexcept;
+    /**
+     * @brief The counters of the streaming underruns, when a voice reaches
+     * the end of the loaded frames of a sample before its end, and stops.
+     */
+    struct UnderrunStats {
+        uint64_t numUnderruns { 0 };
+        uint64_t numMissingFrames { 0 }; // frames of the blocks left silent
+        int lastRegion { -1 }; // index of the region of the last underrun, or -1
+    };
+    /**
+     * @brief Get the counters of the streaming underruns since the start or
+     * the last reset.
+     *
+     * @return UnderrunStats
+     */
+    UnderrunStats getUnderrunStats() const noexcept;
+    /**
+     * @brief Reset the counters of the streaming underruns.
+     */
+    void resetUnderrunStats() noexcept;
+    /**
+     * @brief The counters and the gauges of the streaming, and the use of
+     * the background workers which the synths of the process share.
+     */
+    struct StreamingStats {
+        uint64_t streamedBytes { 0 }; // of the decoded frames
+        uint64_t numStreams { 0 }; // which read their first slice
+        double totalFirstSliceLatency { 0.0 }; // seconds from the requests to the first slices
+        double maxFirstSliceLatency { 0.0 };
+        uint64_t collectedBytes { 0 }; // of the streamed data the garbage collection freed
+        size_t numQueuedRequests { 0 };
+        size_t numQueuedStreams { 0 };
+        size_t numLoadingJobs { 0 };
+        double workersBusyTime { 0.0 }; // seconds, summed over the workers
+        double workersElapsedTime { 0.0 }; // seconds since the start of the workers
+        unsigned numWorkers { 0 };
+    };
+    /**
+     * @brief Get the counters and the gauges of the streaming since the
+     * start. This is lock-free.
+     *
+     * @return StreamingStats
+     */
+    StreamingStats getStreamingStats() const noexcept;
+    /**
+     * @brief The use of the buffer pools since the start or the last reset.
+     * The high-water marks are the most buffers held at once, and the
+     * failures count the requests for a buffer which could not be served;
+     * the processing which asked for it is then skipped.
+     */
+    struct BufferPoolStats {
+        int numBuffers { 0 }; // mono buffers per pool
+        int numStereoBuffers { 0 };
+        int numIndexBuffers { 0 };
+        int maxBuffersUsed { 0 };
+        int maxStereoBuffersUsed { 0 };
+        int maxIndexBuffersUsed { 0 };
+        int numBufferFailures { 0 };
+        int numStereoBufferFailures { 0 };
+        int numIndexBufferFailures { 0 };
+    };
+    /**
+     * @brief Get the use of the buffer pools, over all the render lanes.
+     * The pools are sized when loading an instrument and when setting the
+     * samples per block, from the deepest buffer nesting of the regions.
+     *
+     * @return BufferPoolStats
+     */
+    BufferPoolStats getBufferPoolStats() const noexcept;
+    /**
+     * @brief Reset the high-water marks and the failures of the buffer pools.
+     */
+    void resetBufferPoolStats() noexcept;
     /**
      * @brief Get the current value for the volume, in dB.
      *
@@ -507,6 +1083,34 @@ public:
      * @param normAftertouch
      */
     void hdPolyAftertouch(int delay, int noteNumber, float normAftertouch) noexcept;
+    /**
+     * @brief Send a per-note pitch bend event to the synth, as MPE sends on
+     * the channel of a note. The voices of the note add it to the pitch
+     * wheel, and the regions read it as the extended CC 138.
+     *
+     * @param delay
+     * @param noteNumber
+     * @param normPitch the normalized pitch bend, in domain -1 to 1
+     */
+    void hdPerNotePitchWheel(int delay, int noteNumber, float normPitch) noexcept;
+    /**
+     * @brief Send a per-note timbre event to the synth, as MPE sends with
+     * CC 74 on the channel of a note. The regions read it as the extended
+     * CC 139.
+     *
+     * @param delay
+     * @param noteNumber
+     * @param normTimbre the normalized timbre, in domain 0 to 1
+     */
+    void hdPerNoteTimbre(int delay, int noteNumber, float normTimbre) noexcept;
+    /**
+     * @brief Send a batch of delay-ordered events to the synth, like the
+     *        high-precision events one by one
+     *
+     * @param events
+     * @param count
+     */
+    void sendEvents(const sfizz_event_t* events, size_t count) noexcept;
     /**
      * @brief       Send the time signature.
      *
@@ -549,6 +1153,27 @@ public:
      */
     void renderBlock(AudioSpan<float> buffer) noexcept;
 
+    /**
+     * @brief Render a block of audio data, adding it to the content of the
+     * buffer instead of replacing it.
+     *
+     * @param buffer the buffer to add the next block into
+     */
+    void renderBlockAdding(AudioSpan<float> buffer) noexcept;
+
+    /**
+     * @brief Render a block of audio data into an interleaved buffer. The
+     * output N goes to the channels 2N and 2N+1, wrapping around the
+     * channels of the buffer, as with renderBlock().
+     *
+     * @param buffer the interleaved buffer, of numChannels * numFrames samples
+     * @param numChannels the number of channels of the buffer, a multiple of 2
+     * @param numFrames the number of frames of the block
+     * @param adding whether to add the block to the content of the buffer
+     *               instead of replacing it
+     */
+    void renderBlockInterleaved(float* buffer, size_t numChannels, size_t numFrames, bool adding = false) noexcept;
+
     /**
      * @brief Get the number of active voices
      *
@@ -563,6 +1188,33 @@ public:
      */
     std::vector<const Voice*> getActiveVoices() const noexcept;
 
+    /**
+     * @brief The state of the active instrument which the user interfaces
+     * query, as of the end of a block.
+     */
+    struct StateSnapshot {
+        uint64_t version { 0 }; // increments with each block, 0 before the first
+        uint32_t numActiveVoices { 0 };
+        int activeNotes { 0 };
+        int program { 0 };
+        float pitchBend { 0.0f };
+        float channelAftertouch { 0.0f };
+        std::array<float, 128> noteVelocities {}; // of the pressed notes, 0 for the others
+        std::array<float, config::numCCs> ccValues {};
+        std::array<float, config::maxVoices> voiceLevels {}; // of the amplitude envelopes, by voice
+        uint64_t numUnderruns { 0 };
+        uint64_t numMissingFrames { 0 };
+    };
+    /**
+     * @brief Get the state of the active instrument as of the last block,
+     * which the render publishes once per block. It may be called from any
+     * thread concurrently with the render, without locking nor waiting for
+     * the render.
+     *
+     * @return StateSnapshot
+     */
+    StateSnapshot getStateSnapshot() const noexcept;
+
     /**
      * @brief Get the total number of voices in the synth (the polyphony)
      *
@@ -575,10 +1227,61 @@ public:
      * it out of the RT thread. It can also take a long time to return.
      * If the new number of voices is the same as the current one, it will
      * release the lock immediately and exit.
+     * The voices which play are kept: a lower polyphony lets the voices past
+     * the limit finish, and a higher one only constructs the missing voices.
      *
      * @param numVoices
      */
     void setNumVoices(int numVoices) noexcept;
+    /**
+     * @brief Share a limit of the playing voices with other synths, or stop
+     * sharing it if the budget is null. When the voices of the members exceed
+     * the limit of the budget, the voice of lowest priority across them is
+     * fast released, after the priorities of the voices which their stealers
+     * would take: the older and quieter voices of the less weighted synths go
+     * first. The budget must outlive the synth.
+     *
+     * @param budget the budget, such as VoiceBudget::getGlobal()
+     * @param weight the weight of the voices of the synth in the priorities
+     */
+    void setVoiceBudget(VoiceBudget* budget, float weight = 1.0f) noexcept;
+    /**
+     * @brief Get the number of threads which render the voices, including
+     * the thread which calls `renderBlock`.
+     *
+     * @return int
+     */
+    int getNumRenderThreads() const noexcept;
+    /**
+     * @brief Change the number of threads which render the voices, including
+     * the thread which calls `renderBlock`. With more than one thread, the
+     * voices are distributed on a pool of real-time worker threads, and the
+     * results are summed in a deterministic order. The default is 1, which
+     * renders all the voices on the calling thread.
+     * This function starts or stops threads; do not call it from the RT thread.
+     *
+     * @param numThreads
+     */
+    void setNumRenderThreads(int numThreads) noexcept;
+
+    /**
+     * @brief Set the factor by which the sample files are oversampled as
+     * they load, which lowers the aliasing of the transposed samples with
+     * the cheaper interpolators. The files are oversampled in the background
+     * as they stream, and their data takes the factor times more memory.
+     * This reloads the data of the files; do not call it from the RT thread.
+     *
+     * @param factor 1, 2, 4 or 8
+     * @return true if the factor is valid
+     */
+    bool setOversamplingFactor(int factor) noexcept;
+
+    /**
+     * @brief Get the factor by which the sample files are oversampled.
+     *
+     * @return int
+     */
+    int getOversamplingFactor() const noexcept;
 
     /**
      * @brief Set the preloaded file size.
@@ -597,6 +1300,38 @@ public:
      * @return Oversampling
      */
     uint32_t getPreloadSize() const noexcept;
+    /**
+     * @brief Enable the adaptive preloading, in which the preloaded heads
+     * of the files cover the measured streaming latency, at the rate and the
+     * highest playback speed of each file, instead of the preload size. The
+     * preload size applies until enough latencies are measured.
+     *
+     * @param enable
+     */
+    void enableAdaptivePreloading(bool enable) noexcept;
+    /**
+     * @brief Is the adaptive preloading enabled?
+     *
+     * @return true
+     * @return false
+     */
+    bool isAdaptivePreloadingEnabled() const noexcept;
+    /**
+     * @brief Resize the preloaded heads in the adaptive mode, if the
+     * measured streaming latency changed much since they were sized. The
+     * loads also size the heads after the latest measures.
+     *
+     * @return true if the heads resized
+     */
+    bool updateAdaptivePreloading() noexcept;
+    /**
+     * @brief Get a percentile of the measured times from the stream requests
+     * to their first slices.
+     *
+     * @param percentile between 0 and 1
+     * @return the latency in seconds, or 0 if too few were measured
+     */
+    double getStreamingLatency(double percentile) const noexcept;
 
     /**
      * @brief Gets the number of allocated buffers.
@@ -659,6 +1394,7 @@ public:
         double filters { 0 };
         double panning { 0 };
         double effects { 0 };
+        int culledVoices { 0 };
     };
     /**
      * @brief View the callback breakdown for the last frame.
@@ -668,6 +1404,152 @@ public:
      */
     const CallbackBreakdown& getCallbackBreakdown() const noexcept;
 
+    /**
+     * @brief The durations of the stages of the last load, in seconds.
+     * The regions are built as the parser completes their headers, and the
+     * parse excludes this building. The finalization includes the activation
+     * lists and the modulation matrix.
+     */
+    struct LoadBreakdown
+    {
+        double parse { 0 };
+        double regions { 0 };
+        double finalize { 0 };
+        double activation { 0 };
+        double modMatrix { 0 };
+    };
+    /**
+     * @brief View the durations of the stages of the last load.
+     *
+     * @return const LoadBreakdown&
+     */
+    const LoadBreakdown& getLoadBreakdown() const noexcept;
+
+    /**
+     * @brief The timed stages of the callbacks. The total is the dispatch of
+     * the events since the previous block, and the whole render call.
+     */
+    enum CallbackStage {
+        CallbackTotal,
+        CallbackDispatch,
+        CallbackRender,
+        CallbackData,
+        CallbackAmplitude,
+        CallbackFilters,
+        CallbackPanning,
+        CallbackEffects,
+        NumCallbackStages,
+    };
+    /**
+     * @brief The statistics of the durations of a callback stage, in seconds.
+     * The percentiles are the upper bounds of buckets of logarithmic widths,
+     * 9% apart.
+     */
+    struct CallbackStats {
+        uint64_t numCallbacks { 0 };
+        double min { 0 };
+        double max { 0 };
+        double mean { 0 };
+        double p50 { 0 };
+        double p99 { 0 };
+        double p999 { 0 };
+    };
+    /**
+     * @brief Get the statistics of a callback stage since the start or the
+     * last reset. It does not block the real-time thread, and may be called
+     * from the control thread while rendering.
+     *
+     * @param stage
+     * @return CallbackStats
+     */
+    CallbackStats getCallbackStats(CallbackStage stage) const noexcept;
+    /**
+     * @brief Reset the statistics of all the callback stages. It may be
+     * called from the control thread while rendering.
+     */
+    void resetCallbackStats() noexcept;
+
+    /**
+     * @brief The timed stages of the starts of the voices, from the event to
+     * the first sample. The dispatch runs from the entry of the event into
+     * the synth to the start of the voice, through the region matching, the
+     * voice stealing and the lookup of the sample data. The render delay
+     * runs from the start of the voice to the start of the rendering of the
+     * block of its first sample.
+     */
+    enum VoiceStartStage {
+        VoiceStartDispatch,
+        VoiceStartRender,
+        NumVoiceStartStages,
+    };
+    /**
+     * @brief The statistics of the durations of a voice start stage, in
+     * seconds, as for the callbacks, and how the first blocks of the voices
+     * of samples were served.
+     */
+    struct VoiceStartStats {
+        uint64_t numStarts { 0 };
+        double min { 0 };
+        double max { 0 };
+        double mean { 0 };
+        double p50 { 0 };
+        double p99 { 0 };
+        double p999 { 0 };
+        // the first blocks read from the preloaded data, or else from the
+        // stream or short of data
+        uint64_t numPreloaded { 0 };
+        uint64_t numNotPreloaded { 0 };
+    };
+    /**
+     * @brief Get the statistics of a voice start stage since the start or
+     * the last reset. It does not block the real-time thread, and may be
+     * called from the control thread while rendering.
+     *
+     * @param stage
+     * @return VoiceStartStats
+     */
+    VoiceStartStats getVoiceStartStats(VoiceStartStage stage) const noexcept;
+    /**
+     * @brief Reset the statistics of the voice starts. It may be called from
+     * the control thread while rendering.
+     */
+    void resetVoiceStartStats() noexcept;
+
+    /**
+     * @brief Set every how many blocks the stages of the voices are timed.
+     * Between two timed blocks, the data, amplitude, filters and panning of
+     * the callback breakdown are those of the last timed block.
+     *
+     * @param numBlocks the period in blocks, 1 to time every block
+     */
+    void setVoiceTimingPeriod(int numBlocks) noexcept;
+
+    /**
+     * @brief Get every how many blocks the stages of the voices are timed.
+     *
+     * @return int
+     */
+    int getVoiceTimingPeriod() const noexcept;
+
+    /**
+     * @brief Start a trace of the timings of the blocks, and optionally of
+     * the voices, into a file of the Chrome trace format, which Perfetto
+     * also reads. The events of the real-time thread go through a lock-free
+     * queue and a background thread writes them. The tracing is only
+     * compiled in builds with SFIZZ_TRACING.
+     *
+     * @param file          the file of the trace
+     * @param traceVoices   whether to trace the voices as well as the blocks
+     * @return true if the trace started, false if the file could not be
+     *         opened or the build has no tracing
+     */
+    bool startTrace(const fs::path& file, bool traceVoices = false);
+
+    /**
+     * @brief Stop the current trace, and close its file.
+     */
+    void stopTrace();
+
     /**
      * @brief Shuts down the current processing, clear buffers and reset the voices.
      *
@@ -731,18 +1613,91 @@ public:
      */
     void dispatchMessage(Client& client, int delay, const char* path, const char* sig, const sfizz_arg_t* args);
 
+    /**
+     * @brief Dispatch a bundle of incoming messages to the synth engine, and
+     * write the replies into a buffer.
+     * @since 1.3.0
+     *
+     * The requests and the replies are OSC messages laid one after the other,
+     * as written by `sfizz_prepare_message`. The messages are dispatched
+     * under a single lock of the synth and the replies are written without
+     * allocating. When the replies do not fit in the buffer, it holds the
+     * ones which fit and the others are dropped.
+     *
+     * @param delay            The delay of the messages in the block, in samples.
+     * @param requests         The request messages.
+     * @param requestsSize     The size of the request messages.
+     * @param replies          The buffer which receives the reply messages.
+     * @param repliesCapacity  The capacity of the reply buffer.
+     * @return                 The size necessary to store all the replies,
+     *                         <= repliesCapacity if none was dropped.
+     */
+    uint32_t dispatchMessageBundle(int delay, const void* requests, uint32_t requestsSize, void* replies, uint32_t repliesCapacity);
+
     /**
      * @brief Set the function which receives broadcast messages from the synth engine.
      * @since 1.0.0
      *
+     * The function receives as well the values of the paths subscribed with
+     * the `/subscribe` message, from the thread of the subscriptions.
+     *
      * @param broadcast    The pointer to the receiving function.
      * @param data         The opaque data pointer which is passed to the receiver.
      */
     void setBroadcastCallback(sfizz_receive_t* broadcast, void* data);
 
-    struct Impl;
 private:
+    /**
+     * @brief Dispatch a message with the load lock held.
+     */
+    void dispatchMessageLocked(Client& client, int delay, const char* path, const char* sig, const sfizz_arg_t* args);
+
+    struct RenderTarget;
+    void renderBlock(RenderTarget& target) noexcept;
+    /**
+     * @brief Render a block at the processing rate with the load lock held.
+     */
+    void renderBlockLocked(Impl& impl, RenderTarget& target) noexcept;
+    /**
+     * @brief Render a block of an instrument at the host rate.
+     */
+    void renderInstrument(Impl& impl, RenderTarget& target) noexcept;
+    /**
+     * @brief Build an instrument with the settings of the active one.
+     */
+    std::unique_ptr<Impl> makeInstrument();
+    /**
+     * @brief Switch to the instrument of a program change, if any, and
+     * release the voices of the previous one.
+     */
+    void switchProgram(int program) noexcept;
+    /**
+     * @brief Publish the state of an instrument for getStateSnapshot.
+     */
+    void publishStateSnapshot(Impl& impl) noexcept;
+    /**
+     * @brief Call a function for the active instrument and the others.
+     */
+    template <class F>
+    void forEachInstrument(F&& function);
+
     std::unique_ptr<Impl> impl_;
+    std::atomic<AsyncLoad*> pendingLoad_ { nullptr };
+
+    // The instruments of the programs, except the active one, and the
+    // default instrument while a program is active
+    std::array<std::unique_ptr<Impl>, config::numPrograms> residents_;
+    std::unique_ptr<Impl> base_;
+    int activeProgram_ { -1 };
+    std::atomic<int> pendingProgram_ { -1 };
+    Impl* releasing_ { nullptr }; // the previous instrument, until its voices end
+
+    // The state of the active instrument, published by the render
+    SeqLock<StateSnapshot> stateSnapshot_;
+    uint64_t stateVersion_ { 0 };
+
+    // The broadcasts of the subscribed state, last to stop their thread first
+    std::unique_ptr<Subscriptions> subscriptions_;
 
     LEAK_DETECTOR(Synth);
 };
@@ -19,6 +19,9 @@ struct SynthConfig
     int liveOscillatorQuality { Default::oscillatorQuality };
     int freeWheelingOscillatorQuality { Default::freewheelingOscillatorQuality };
 
+    int liveEffectQuality { Default::effectQuality };
+    int freeWheelingEffectQuality { Default::freewheelingEffectQuality };
+
     int currentSampleQuality() const noexcept
     {
         return freeWheeling ? freeWheelingSampleQuality : liveSampleQuality;
@@ -29,6 +32,40 @@ struct SynthConfig
         return freeWheeling ? freeWheelingOscillatorQuality : liveOscillatorQuality;
     }
 
+    int currentEffectQuality() const noexcept
+    {
+        return freeWheeling ? freeWheelingEffectQuality : liveEffectQuality;
+    }
+
     bool sustainCancelsRelease { Default::sustainCancelsRelease };
+
+    // Released voices below this level are ended early; disabled at the lower bound
+    float voiceCullingThreshold { Default::voiceCullingThreshold };
+
+    bool voiceCullingEnabled() const noexcept
+    {
+        return voiceCullingThreshold > Default::voiceCullingThreshold.bounds.getStart();
+    }
+
+    // Lower the quality of new voices when the callbacks near their deadline
+    bool qualityGovernor { Default::qualityGovernor };
+    // Quality steps removed for new voices, updated by the governor every block
+    int qualityReduction { 0 };
+
+    // Choose the sample quality of each block from the playback ratios,
+    // under the quality set
+    bool adaptiveSampleQuality { Default::adaptiveSampleQuality };
+
+    // Start streaming the release samples of a note when it goes down
+    bool releasePrewarming { Default::releasePrewarming };
+
+    // Design the coefficients of the resonant 2-pole filters from tables
+    bool tabulatedFilters { Default::tabulatedFilters };
+
+    // Compute the slow modulation targets at control rate
+    bool controlRateModulations { Default::controlRateModulations };
+
+    // Frames between the ones which the power followers of the voices read
+    uint32_t powerFollowerStride { Default::powerFollowerStride };
 };
 }
@@ -5,7 +5,9 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "Defaults.h"
+#include "RealtimeGuard.h"
 #include "Region.h"
+#include "Subscriptions.h"
 #include "SynthMessagingHelper.hpp"
 
 namespace sfz {
@@ -13,12 +15,86 @@ namespace sfz {
 void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, const char* sig, const sfizz_arg_t* args)
 {
     Impl& impl = *impl_;
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return;
+
+    dispatchMessageLocked(client, delay, path, sig, args);
+}
+
+namespace {
+
+/**
+ * @brief The replies of a message bundle, written one after the other in
+ * the buffer of the caller.
+ */
+struct BundleReplies {
+    uint8_t* buffer { nullptr };
+    uint32_t capacity { 0 };
+    uint32_t size { 0 }; // the size to fit all the replies
+    bool overflow { false };
+
+    static void receive(void* data, int, const char* path, const char* sig, const sfizz_arg_t* args)
+    {
+        BundleReplies& self = *reinterpret_cast<BundleReplies*>(data);
+        const uint32_t remaining = self.overflow ? 0 : (self.capacity - self.size);
+        const uint32_t messageSize = sfizz_prepare_message(
+            self.overflow ? nullptr : self.buffer + self.size, remaining, path, sig, args);
+        // Keep the replies in order: after the first one dropped, only count
+        self.overflow = self.overflow || messageSize > remaining;
+        self.size += messageSize;
+    }
+};
+
+} // namespace
+
+uint32_t sfz::Synth::dispatchMessageBundle(int delay, const void* requests, uint32_t requestsSize, void* replies, uint32_t repliesCapacity)
+{
+    Impl& impl = *impl_;
+    const std::unique_lock<SpinMutex> loadGuard { impl.loadMutex_, std::try_to_lock };
+    if (!loadGuard.owns_lock())
+        return 0;
+
+    BundleReplies bundleReplies;
+    bundleReplies.buffer = reinterpret_cast<uint8_t*>(replies);
+    bundleReplies.capacity = replies ? repliesCapacity : 0;
+
+    Client client(&bundleReplies);
+    client.setReceiveCallback(&BundleReplies::receive);
+
+    const uint8_t* request = reinterpret_cast<const uint8_t*>(requests);
+    uint32_t remaining = requestsSize;
+    alignas(sfizz_arg_t) uint8_t argsBuffer[config::maxBundleMessageArgsSize];
+
+    while (remaining > 0) {
+        const char* path;
+        const char* sig;
+        const sfizz_arg_t* args;
+        const int32_t messageSize = sfizz_extract_message(
+            request, remaining, argsBuffer, sizeof(argsBuffer), &path, &sig, &args);
+        if (messageSize <= 0)
+            break; // invalid, or its arguments do not fit
+        dispatchMessageLocked(client, delay, path, sig, args);
+        request += messageSize;
+        remaining -= static_cast<uint32_t>(messageSize);
+    }
+
+    return bundleReplies.size;
+}
+
+void sfz::Synth::dispatchMessageLocked(Client& client, int delay, const char* path, const char* sig, const sfizz_arg_t* args)
+{
+    Impl& impl = *impl_;
+    delay = impl.processingDelay(delay);
     MessagingHelper m {client, delay, path, sig, args, impl};
     using ModParam = MessagingHelper::ModParam;
 
     switch (hashMessagePath(path, sig)) {
         #define MATCH(p, s) case hash(p "," s): if (m.match(p, s))
         MATCH("/hello", "") { m.reply(""); } break;
+        MATCH("/subscribe", "si") { m.reply(subscriptions_->subscribe(args[0].s, args[1].i)); } break;
+        MATCH("/unsubscribe", "s") { m.reply(subscriptions_->unsubscribe(args[0].s)); } break;
+        MATCH("/unsubscribe_all", "") { subscriptions_->unsubscribeAll(); } break;
         //----------------------------------------------------------------------
         MATCH("/num_regions", "") { m.reply(impl.layers_.size()); } break;
         MATCH("/num_groups", "") { m.reply(impl.numGroups_); } break;
@@ -29,11 +105,70 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/note_offset", "") { m.reply(impl.noteOffset_); } break;
         MATCH("/num_outputs", "") { m.reply(impl.numOutputs_); } break;
         MATCH("/num_active_voices", "") { m.reply(uint32_t(impl.voiceManager_.getNumActiveVoices())); } break;
+        MATCH("/underruns/count", "") { m.reply(getUnderrunStats().numUnderruns); } break;
+        MATCH("/underruns/missing_frames", "") { m.reply(getUnderrunStats().numMissingFrames); } break;
+        MATCH("/underruns/last_region", "") { m.reply(getUnderrunStats().lastRegion); } break;
+        MATCH("/buffer_pool/num_buffers", "") { m.reply(getBufferPoolStats().numBuffers); } break;
+        MATCH("/buffer_pool/num_stereo_buffers", "") { m.reply(getBufferPoolStats().numStereoBuffers); } break;
+        MATCH("/buffer_pool/num_index_buffers", "") { m.reply(getBufferPoolStats().numIndexBuffers); } break;
+        MATCH("/buffer_pool/max_buffers_used", "") { m.reply(getBufferPoolStats().maxBuffersUsed); } break;
+        MATCH("/buffer_pool/max_stereo_buffers_used", "") { m.reply(getBufferPoolStats().maxStereoBuffersUsed); } break;
+        MATCH("/buffer_pool/max_index_buffers_used", "") { m.reply(getBufferPoolStats().maxIndexBuffersUsed); } break;
+        MATCH("/buffer_pool/buffer_failures", "") { m.reply(getBufferPoolStats().numBufferFailures); } break;
+        MATCH("/buffer_pool/stereo_buffer_failures", "") { m.reply(getBufferPoolStats().numStereoBufferFailures); } break;
+        MATCH("/buffer_pool/index_buffer_failures", "") { m.reply(getBufferPoolStats().numIndexBufferFailures); } break;
+        MATCH("/buffer_pool/reset", "") { resetBufferPoolStats(); } break;
+        #define MATCH_CALLBACK_STATS(name, stage)                                                                  \
+        MATCH("/stats/" name "/count", "") { m.reply(getCallbackStats(stage).numCallbacks); } break;            \
+        MATCH("/stats/" name "/min", "") { m.reply(getCallbackStats(stage).min); } break;                       \
+        MATCH("/stats/" name "/max", "") { m.reply(getCallbackStats(stage).max); } break;                       \
+        MATCH("/stats/" name "/mean", "") { m.reply(getCallbackStats(stage).mean); } break;                     \
+        MATCH("/stats/" name "/p50", "") { m.reply(getCallbackStats(stage).p50); } break;                       \
+        MATCH("/stats/" name "/p99", "") { m.reply(getCallbackStats(stage).p99); } break;                       \
+        MATCH("/stats/" name "/p999", "") { m.reply(getCallbackStats(stage).p999); } break;
+        MATCH_CALLBACK_STATS("total", CallbackTotal)
+        MATCH_CALLBACK_STATS("dispatch", CallbackDispatch)
+        MATCH_CALLBACK_STATS("render", CallbackRender)
+        MATCH_CALLBACK_STATS("data", CallbackData)
+        MATCH_CALLBACK_STATS("amplitude", CallbackAmplitude)
+        MATCH_CALLBACK_STATS("filters", CallbackFilters)
+        MATCH_CALLBACK_STATS("panning", CallbackPanning)
+        MATCH_CALLBACK_STATS("effects", CallbackEffects)
+        #undef MATCH_CALLBACK_STATS
+        MATCH("/stats/reset", "") { resetCallbackStats(); } break;
+        #define MATCH_VOICE_START_STATS(name, stage)                                                               \
+        MATCH("/stats/" name "/count", "") { m.reply(getVoiceStartStats(stage).numStarts); } break;             \
+        MATCH("/stats/" name "/min", "") { m.reply(getVoiceStartStats(stage).min); } break;                     \
+        MATCH("/stats/" name "/max", "") { m.reply(getVoiceStartStats(stage).max); } break;                     \
+        MATCH("/stats/" name "/mean", "") { m.reply(getVoiceStartStats(stage).mean); } break;                   \
+        MATCH("/stats/" name "/p50", "") { m.reply(getVoiceStartStats(stage).p50); } break;                     \
+        MATCH("/stats/" name "/p99", "") { m.reply(getVoiceStartStats(stage).p99); } break;                     \
+        MATCH("/stats/" name "/p999", "") { m.reply(getVoiceStartStats(stage).p999); } break;
+        MATCH_VOICE_START_STATS("voice_dispatch", VoiceStartDispatch)
+        MATCH_VOICE_START_STATS("voice_render", VoiceStartRender)
+        #undef MATCH_VOICE_START_STATS
+        MATCH("/stats/voice_start/preloaded", "") { m.reply(getVoiceStartStats(VoiceStartRender).numPreloaded); } break;
+        MATCH("/stats/voice_start/not_preloaded", "") { m.reply(getVoiceStartStats(VoiceStartRender).numNotPreloaded); } break;
+        MATCH("/stats/voice_start/reset", "") { resetVoiceStartStats(); } break;
+        MATCH("/stats/realtime/allocations", "") { m.reply(RealtimeGuard::getViolations(RealtimeGuard::Allocation)); } break;
+        MATCH("/stats/realtime/deallocations", "") { m.reply(RealtimeGuard::getViolations(RealtimeGuard::Deallocation)); } break;
+        MATCH("/stats/realtime/locks", "") { m.reply(RealtimeGuard::getViolations(RealtimeGuard::Lock)); } break;
+        MATCH("/stats/realtime/file_accesses", "") { m.reply(RealtimeGuard::getViolations(RealtimeGuard::FileAccess)); } break;
+        MATCH("/stats/realtime/reset", "") { RealtimeGuard::resetViolations(); } break;
         MATCH("/sustain_cancels_release", "") { m.reply(&SynthConfig::sustainCancelsRelease); } break;
         MATCH("/sample_quality", "") { m.reply(&SynthConfig::liveSampleQuality); } break;
         MATCH("/sustain_cancels_release", "s") { m.set(&SynthConfig::sustainCancelsRelease, Default::sustainCancelsRelease); } break;
         MATCH("/sustain_cancels_release", "T") { m.set(&SynthConfig::sustainCancelsRelease, Default::sustainCancelsRelease); } break;
         MATCH("/sustain_cancels_release", "F") { m.set(&SynthConfig::sustainCancelsRelease, Default::sustainCancelsRelease); } break;
+        MATCH("/voice_culling_threshold", "") { m.reply(&SynthConfig::voiceCullingThreshold); } break;
+        MATCH("/voice_culling_threshold", "f") { m.set(&SynthConfig::voiceCullingThreshold, Default::voiceCullingThreshold); } break;
+        MATCH("/quality_governor", "") { m.reply(&SynthConfig::qualityGovernor); } break;
+        MATCH("/quality_governor", "T") { m.set(&SynthConfig::qualityGovernor, Default::qualityGovernor); } break;
+        MATCH("/quality_governor", "F") { m.set(&SynthConfig::qualityGovernor, Default::qualityGovernor); } break;
+        MATCH("/adaptive_sample_quality", "") { m.reply(&SynthConfig::adaptiveSampleQuality); } break;
+        MATCH("/adaptive_sample_quality", "T") { m.set(&SynthConfig::adaptiveSampleQuality, Default::adaptiveSampleQuality); } break;
+        MATCH("/adaptive_sample_quality", "F") { m.set(&SynthConfig::adaptiveSampleQuality, Default::adaptiveSampleQuality); } break;
+        MATCH("/quality_reduction", "") { m.reply(&SynthConfig::qualityReduction); } break;
         MATCH("/sample_quality", "i") { m.set(&SynthConfig::liveSampleQuality, Default::sampleQuality); } break;
         MATCH("/oscillator_quality", "") { m.reply(&SynthConfig::liveOscillatorQuality); } break;
         MATCH("/oscillator_quality", "i") { m.set(&SynthConfig::liveOscillatorQuality, Default::oscillatorQuality); } break;
@@ -41,6 +176,10 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/freewheeling_sample_quality", "i") { m.set(&SynthConfig::freeWheelingSampleQuality, Default::sampleQuality); } break;
         MATCH("/freewheeling_oscillator_quality", "") { m.reply(&SynthConfig::freeWheelingOscillatorQuality); } break;
         MATCH("/freewheeling_oscillator_quality", "i") { m.set(&SynthConfig::freeWheelingOscillatorQuality, Default::oscillatorQuality); } break;
+        MATCH("/effect_quality", "") { m.reply(&SynthConfig::liveEffectQuality); } break;
+        MATCH("/effect_quality", "i") { m.set(&SynthConfig::liveEffectQuality, Default::effectQuality); } break;
+        MATCH("/freewheeling_effect_quality", "") { m.reply(&SynthConfig::freeWheelingEffectQuality); } break;
+        MATCH("/freewheeling_effect_quality", "i") { m.set(&SynthConfig::freeWheelingEffectQuality, Default::effectQuality); } break;
         //----------------------------------------------------------------------
         MATCH("/key/slots", "") { m.reply(impl.keySlots_); } break;
         MATCH("/key&/label", "") { if (auto k = m.sindex(0)) m.reply(impl.getKeyLabel(*k)); } break;
@@ -66,6 +205,14 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/pitch_bend", "") { m.reply(impl.resources_.getMidiState().getPitchBend()); } break;
         //----------------------------------------------------------------------
         MATCH("/mem/buffers", "") { m.reply(BufferCounter::counter().getTotalBytes()); } break;
+        MATCH("/mem/preloaded_samples", "") { m.reply(getMemoryBreakdown().preloadedSamples); } break;
+        MATCH("/mem/streamed_samples", "") { m.reply(getMemoryBreakdown().streamedSamples); } break;
+        MATCH("/mem/wavetables", "") { m.reply(getMemoryBreakdown().wavetables); } break;
+        MATCH("/mem/voices", "") { m.reply(getMemoryBreakdown().voices); } break;
+        MATCH("/mem/buffer_pool", "") { m.reply(getMemoryBreakdown().bufferPool); } break;
+        MATCH("/mem/effect_buses", "") { m.reply(getMemoryBreakdown().effectBuses); } break;
+        MATCH("/mem/regions", "") { m.reply(getMemoryBreakdown().regions); } break;
+        MATCH("/mem/total", "") { m.reply(getMemoryBreakdown().total()); } break;
         //----------------------------------------------------------------------
         MATCH("/region&/delay", "") { m.reply(&Region::delay); } break;
         MATCH("/region&/delay", "f") { m.set(&Region::delay, Default::delay); } break;
@@ -121,7 +268,7 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/pitch_keycenter", "") { m.reply(&Region::pitchKeycenter); } break;
         MATCH("/region&/pitch_keycenter", "i") { m.set(&Region::pitchKeycenter, Default::key); } break;
         MATCH("/region&/vel_range", "") { m.reply(&Region::velocityRange); } break;
-        MATCH("/region&/vel_range", "ff") { m.set(&Region::velocityRange); } break;
+        MATCH("/region&/vel_range", "ff") { m.set(&Region::velocityRange); impl.noteVelocityIndexValid_ = false; } break;
         MATCH("/region&/bend_range", "") { m.reply(&Region::bendRange); } break;
         MATCH("/region&/bend_range", "ff") { m.set(&Region::bendRange); } break;
         MATCH("/region&/program_range", "") { m.reply(&Region::programRange); } break;
@@ -158,7 +305,7 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/sw_previous", "i") { m.set(&Region::previousKeyswitch, Default::key); } break;
         MATCH("/region&/sw_previous", "s") { m.set(&Region::previousKeyswitch, Default::key); } break;
         MATCH("/region&/sw_vel", "") { m.reply(&Region::velocityOverride); } break;
-        MATCH("/region&/sw_vel", "s") { m.set(&Region::velocityOverride, Default::velocityOverride); } break;
+        MATCH("/region&/sw_vel", "s") { m.set(&Region::velocityOverride, Default::velocityOverride); impl.noteVelocityIndexValid_ = false; } break;
         MATCH("/region&/chanaft_range", "") { m.reply(&Region::aftertouchRange); } break;
         MATCH("/region&/chanaft_range", "ff") { m.set(&Region::aftertouchRange); } break;
         MATCH("/region&/polyaft_range", "") { m.reply(&Region::polyAftertouchRange); } break;
@@ -168,7 +315,7 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/rand_range", "") { m.reply(&Region::randRange); } break;
         MATCH("/region&/rand_range", "ff") { m.set(&Region::randRange, Default::loNormalized, Default::hiNormalized); } break;
         MATCH("/region&/seq_length", "") { m.reply(&Region::sequenceLength); } break;
-        MATCH("/region&/seq_length", "i") { m.set(&Region::sequenceLength, Default::sequence); } break;
+        MATCH("/region&/seq_length", "i") { m.set(&Region::sequenceLength, Default::sequence); impl.noteVelocityIndexValid_ = false; } break;
         MATCH("/region&/seq_position", "") { m.reply(&Region::sequencePosition); } break;
         MATCH("/region&/seq_position", "i") { m.set(&Region::sequencePosition, Default::sequence); } break;
         MATCH("/region&/trigger", "") { m.reply(&Region::trigger); } break;
@@ -448,9 +595,19 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/sostenuto_sw", "T") { m.set(&Region::checkSostenuto, Default::checkSostenuto); } break;
         MATCH("/region&/sostenuto_sw", "F") { m.set(&Region::checkSostenuto, Default::checkSostenuto); } break;
         MATCH("/region&/sustain_cc", "") { m.reply(&Region::sustainCC); } break;
-        MATCH("/region&/sustain_cc", "i") { m.set(&Region::sustainCC, Default::sustainCC); } break;
+        MATCH("/region&/sustain_cc", "i") {
+            if (auto region = m.getRegion()) {
+                m.set(&Region::sustainCC, Default::sustainCC);
+                impl.sustainOrSostenuto_.set(region->sustainCC);
+            }
+        } break;
         MATCH("/region&/sostenuto_cc", "") { m.reply(&Region::sostenutoCC); } break;
-        MATCH("/region&/sostenuto_cc", "i") { m.set(&Region::sostenutoCC, Default::sostenutoCC); } break;
+        MATCH("/region&/sostenuto_cc", "i") {
+            if (auto region = m.getRegion()) {
+                m.set(&Region::sostenutoCC, Default::sostenutoCC);
+                impl.sustainOrSostenuto_.set(region->sostenutoCC);
+            }
+        } break;
         MATCH("/region&/sustain_lo", "") { m.reply(&Region::sustainThreshold); } break;
         MATCH("/region&/sustain_lo", "f") { m.set(&Region::sustainThreshold); } break;
         MATCH("/region&/sostenuto_lo", "") { m.reply(&Region::sostenutoThreshold); } break;
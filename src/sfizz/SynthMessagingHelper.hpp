@@ -106,6 +106,7 @@ public:
     void reply(const char* value) { client.receive<'s'>(delay, path, value); }
     // void reply(float value) { client.receive<'f'>(delay, path, value); }
     void reply(const float& value) { client.receive<'f'>(delay, path, value); }
+    void reply(const double& value) { client.receive<'d'>(delay, path, value); }
     void reply(absl::nullopt_t) { client.receive<'N'>(delay, path, {}); }
 
     void reply(const bool& value)
@@ -502,8 +503,12 @@ public:
     template <class T, class F, class... Args>
     void dispatch(F&& f, T Region::*member, Args&&... args)
     {
-        if (auto region = getRegion())
-            inv::invoke(std::forward<F>(f), this, (*region).*member, std::forward<Args>(args)...);
+        if (auto layer = getLayer()) {
+            inv::invoke(std::forward<F>(f), this, layer->getRegion().*member, std::forward<Args>(args)...);
+            // the trigger members and the voice template are copied into the layer
+            layer->updateTriggerView();
+            layer->updateVoiceTemplate();
+        }
     }
 
     template <class T, class F, class... Args>
@@ -579,14 +584,19 @@ public:
     // Validate and fetch elements from the sfizz data structures. By default, we kind of
     // assume that regions/voices will be the first index, CCs will be the last, and
     // EQ/Filter/.. will be in-between.
-    Region* getRegion(absl::optional<unsigned> index = {})
+    Layer* getLayer(absl::optional<unsigned> index = {})
     {
         const auto idx = index.value_or(indices[0]);
         if (idx >= impl.layers_.size())
             return {};
 
-        Layer& layer = *impl.layers_[idx];
-        return &layer.getRegion();
+        return impl.layers_[idx].get();
+    }
+
+    Region* getRegion(absl::optional<unsigned> index = {})
+    {
+        Layer* layer = getLayer(index);
+        return layer ? &layer->getRegion() : nullptr;
     }
 
     FilterDescription* getFilter(Region& region, absl::optional<unsigned> index = {})
@@ -5,8 +5,16 @@
 #include "SisterVoiceRing.h"
 #include "TriggerEvent.h"
 #include "VoiceManager.h"
+#include "VoicePools.h"
 #include "Layer.h"
+#include "OutputUpsampler.h"
+#include "RenderThreadPool.h"
+#include "LatencyHistogram.h"
+#include "QualityGovernor.h"
+#include "Tracer.h"
+#include "SpinMutex.h"
 #include "BitArray.h"
+#include "utility/ObjectArena.h"
 #include "modulations/sources/ADSREnvelope.h"
 #include "modulations/sources/Controller.h"
 #include "modulations/sources/FlexEnvelope.h"
@@ -15,6 +23,7 @@
 #include "modulations/sources/LFO.h"
 #include "parser/Parser.h"
 #include "parser/ParserListener.h"
+#include <atomic>
 
 namespace sfz {
 
@@ -103,16 +112,59 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void buildRegion(const std::vector<Opcode>& regionOpcodes);
     /**
-     * @brief Resets and possibly changes the number of voices (polyphony) in
-     * the synth.
+     * @brief Change the number of voices (polyphony) in the synth, keeping the
+     * voices which play. Only the voices which are added are set up.
      *
      * @param numVoices
      */
-    void resetVoices(int numVoices);
+    void resizeVoices(int numVoices);
     /**
      * @brief Make the stored settings take effect in all the voices
      */
     void applySettingsPerVoice();
+    /**
+     * @brief Make the stored settings take effect in a voice
+     */
+    void applySettingsToVoice(Voice& voice);
+
+    /**
+     * @brief Size the buffer pools for the deepest buffer nesting of the
+     * regions, on top of the buffers held by the synth while rendering.
+     */
+    void sizeBufferPools();
+
+    /**
+     * @brief Get the factor between the host rate and the processing rate:
+     * the smallest of 1, 2, 4 or 8 which brings the processing rate within
+     * the maximum, if any.
+     */
+    int processingFactor() const noexcept;
+    /**
+     * @brief Apply the host rate and block size to the processing, after a
+     * change of these or of the maximum processing rate.
+     */
+    void updateProcessingRate();
+    /**
+     * @brief Set the sample rate of the voices, the effects and the
+     * resources.
+     */
+    void setProcessingSampleRate(float sampleRate);
+    /**
+     * @brief Set the block size of the voices, the effects and the
+     * resources.
+     */
+    void setProcessingBlockSize(int samplesPerBlock);
+    /**
+     * @brief Allocate the upsampling of the outputs for the current factor,
+     * block size and number of outputs.
+     */
+    void prepareOutputUpsampler();
+    /**
+     * @brief Convert the delay of an event from frames at the host rate to
+     * frames at the processing rate, from the start of the next processing
+     * block.
+     */
+    int processingDelay(int delay) const noexcept;
 
     /**
      * @brief Establish all connections of the modulation matrix.
@@ -135,6 +187,21 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void noteOnDispatch(int delay, int noteNumber, float velocity) noexcept;
 
+    /**
+     * @brief Select the articulation of a keyswitch of the sw_last kind, if
+     * the note is one.
+     *
+     * @param noteNumber
+     */
+    void selectLastKeyswitch(int noteNumber) noexcept;
+
+    /**
+     * @brief Start streaming the samples of the release regions of a note
+     *
+     * @param noteNumber
+     */
+    void prewarmReleases(int noteNumber) noexcept;
+
     /**
      * @brief Check all regions and start voices for note off events
      *
@@ -189,6 +256,21 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void resetDefaultCCValues() noexcept;
 
+    /**
+     * @brief Drop the region prototype after a change of the opcodes of the
+     * headers or of the control settings, and update the key of these.
+     */
+    void resetRegionPrototype();
+
+    /**
+     * @brief Get the key of a region from everything its parse depends on:
+     * its number, the opcodes of its headers and the control settings.
+     *
+     * @param regionNumber
+     * @param regionOpcodes
+     */
+    uint64_t getParsedRegionKey(int regionNumber, const std::vector<Opcode>& regionOpcodes) const noexcept;
+
     /**
      * @brief Prepare before loading a new SFZ file. The behavior of this function
      * is changed by the reloading state.
@@ -204,6 +286,37 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void finalizeSfzLoad();
 
+    /**
+     * @brief Load an SFZ file, holding the load mutex during the load.
+     *
+     * @param file
+     * @param convert the conversion of the file into an SFZ document, if it
+     *                is of another format
+     * @return true if the instrument was loaded
+     */
+    bool loadSfzFile(const fs::path& file, const Parser::Converter* convert = nullptr);
+
+    /**
+     * @brief Abandon a load which failed or was canceled.
+     */
+    void abortSfzLoad();
+
+    /**
+     * @brief Take the settings of the host from another synth, which are
+     * kept across loads: the processing parameters, the tuning, the file
+     * settings, the volume, the broadcast receiver and the controller values.
+     *
+     * @param other
+     */
+    void copyHostSettings(const Impl& other);
+
+    /**
+     * @brief Take the controller values of another synth.
+     *
+     * @param other
+     */
+    void copyControllers(const Impl& other) noexcept;
+
     /**
      * @brief Set the current keyswitch, taking into account octave offsets and the like.
      *
@@ -211,6 +324,14 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void setCurrentSwitch(uint8_t noteValue);
 
+    /**
+     * @brief Check whether the preload of a region is needed before its
+     * keyswitch is selected, in the lazy keyswitch preloading.
+     *
+     * @param region
+     */
+    bool keyswitchPreloadNeeded(const Region& region) const noexcept;
+
     template<class T>
     static void collectUsedCCsFromCCMap(BitArray<config::numCCs>& usedCCs, const CCMap<T> map) noexcept
     {
@@ -244,6 +365,43 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void performHdcc(int delay, int ccNumber, float normValue, bool asMidi, int extendedArg=-1) noexcept;
 
+    /**
+     * @brief Deliver a CC event to the active voices, if some region uses it
+     * as its sustain or sostenuto pedal. The voices react to their pedals
+     * when the events happen; they read the other controllers from the midi
+     * state when they render.
+     *
+     * @param delay      The delay
+     * @param ccNumber   The CC number
+     * @param normValue  The normalized value
+     */
+    void registerPedalCC(int delay, int ccNumber, float normValue) noexcept;
+
+    /**
+     * @brief Perform the other events, without the load lock and the
+     *        dispatch timing, which the callers take.
+     */
+    void performNoteOn(int delay, int noteNumber, float normalizedVelocity) noexcept;
+    void performNoteOff(int delay, int noteNumber, float normalizedVelocity) noexcept;
+    void performProgramChange(int delay, int program) noexcept;
+    void performPitchWheel(int delay, float normalizedPitch) noexcept;
+    void performChannelAftertouch(int delay, float normAftertouch) noexcept;
+    void performPolyAftertouch(int delay, int noteNumber, float normAftertouch) noexcept;
+    /**
+     * @brief Record the event of a per-note controller, which only the
+     * voices of the note read, through their modulation sources.
+     */
+    void performPerNoteController(int delay, int noteNumber, int ccNumber, float normValue) noexcept;
+
+    /**
+     * @brief Check whether only the last of several values of a controller
+     *        at the same delay matters, because no layer and no voice reacts
+     *        to the intermediate ones.
+     *
+     * @param ccNumber
+     */
+    bool isCoalescableCC(int ccNumber) const noexcept;
+
     /**
      * @brief Set the default value for a CC
      *
@@ -267,12 +425,61 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void resetCallbackBreakdown();
 
+    /**
+     * @brief Resize the render lanes after a change of the number of render
+     * threads, voices, regions, effect buses or block size.
+     */
+    void prepareRenderLanes();
+
+    /**
+     * @brief Check whether the voices of this cycle should be distributed
+     * on the render threads.
+     */
+    bool shouldRenderConcurrently() const noexcept;
+
+    /**
+     * @brief Render all voices with the render threads, and sum them into the
+     * inputs of the effect buses.
+     *
+     * @param tempSpan temporary buffer used by the calling thread
+     */
+    void renderVoicesConcurrently(AudioSpan<float> tempSpan) noexcept;
+
+    /**
+     * @brief Render a voice and send it to the effect buses of its output.
+     * When it goes to a single bus, it adds itself straight into the inputs.
+     *
+     * @param voice
+     * @param tempSpan temporary buffer for the rendering
+     * @param numFrames
+     */
+    void renderVoiceToBuses(Voice& voice, AudioSpan<float> tempSpan, unsigned numFrames) noexcept;
+
+    /**
+     * @brief Render the voices assigned to a single lane.
+     * Lane 0 adds directly into the effect buses, whereas the other lanes
+     * add into their own bus inputs, which are summed after all lanes are done.
+     *
+     * @param lane
+     */
+    void renderVoicesOfLane(unsigned lane) noexcept;
+
+    /**
+     * @brief Process the effect buses of all outputs, distributing them on the
+     * render threads if there are several buses with effects. The outputs are
+     * not mixed.
+     *
+     * @param numFrames
+     */
+    void processEffectBuses(unsigned numFrames) noexcept;
+
     int numGroups_ { 0 };
     int numMasters_ { 0 };
     int numOutputs_ { 1 };
 
     // Opcode memory; these are used to build regions, as a new region
-    // will integrate opcodes from the group, master and global block
+    // will integrate opcodes from the group, master and global block.
+    // They are cleaned up for the region scope once per header.
     std::vector<Opcode> globalOpcodes_;
     std::vector<Opcode> masterOpcodes_;
     std::vector<Opcode> groupOpcodes_;
@@ -290,16 +497,41 @@ struct Synth::Impl final: public Parser::Listener {
 
     // Set as sw_default if present in the file
     absl::optional<uint8_t> currentSwitch_;
+    // Preload only the articulations of the current and the eager keyswitches
+    bool lazyKeyswitchPreloading_ { false };
+    BitArray<128> eagerKeyswitches_;
     std::vector<std::string> unknownOpcodes_;
+    // The opcode names normalized during the current load
+    OpcodeCleanupCache opcodeCleanup_;
     using RegionViewVector = std::vector<Region*>;
     using LayerViewVector = std::vector<Layer*>;
     using VoiceViewVector = std::vector<Voice*>;
-    using LayerPtr = std::unique_ptr<Layer>;
+    using LayerArena = ObjectArena<Layer>;
+    using LayerPtr = LayerArena::Pointer;
     using RegionPtr = std::unique_ptr<Region>;
     using RegionSetPtr = std::unique_ptr<RegionSet>;
+    // The layers are created contiguously in the arena, in the order of loading;
+    // it outlives the layers and releases its memory when they are cleared.
+    LayerArena layerArena_;
     std::vector<LayerPtr> layers_;
     VoiceManager voiceManager_;
 
+    // The regions of the last load as they were parsed, before finalizing
+    // them, by region number; a reload reuses the ones of the same opcodes
+    struct ParsedRegion {
+        uint64_t key { 0 };
+        RegionPtr region;
+        std::vector<std::string> unknownOpcodes;
+    };
+    std::vector<ParsedRegion> parsedRegions_;
+    std::vector<ParsedRegion> previousParsedRegions_;
+
+    // The region parsed from the opcodes of the current headers, with the
+    // key of these opcodes and the control settings
+    RegionPtr regionPrototype_;
+    std::vector<std::string> prototypeUnknownOpcodes_;
+    uint64_t headerKey_ { 0 };
+
     // These are more general "groups" than sfz and encapsulates the full hierarchy
     RegionSet* currentSet_ { nullptr };
     std::vector<RegionSetPtr> sets_;
@@ -310,6 +542,39 @@ struct Synth::Impl final: public Parser::Listener {
     LayerViewVector previousKeyswitchLists_;
     std::array<LayerViewVector, 128> noteActivationLists_;
     std::array<LayerViewVector, config::numCCs> ccActivationLists_;
+    // The sustain and sostenuto controllers of the regions
+    std::bitset<config::numCCs> pedalCCs_;
+    // The layers which hold delayed releases until the pedals go up
+    Layer::PendingReleaseList pendingReleases_;
+
+    // The note activation lists split into velocity buckets, so that a note-on
+    // only visits the layers which can match its velocity
+    struct NoteVelocityIndex {
+        std::vector<float> bucketStarts; // sorted
+        std::vector<LayerViewVector> buckets;
+    };
+    std::array<NoteVelocityIndex, 128> noteVelocityIndex_;
+
+    // Held during the loads; the RT functions do nothing while it is
+    SpinMutex loadMutex_;
+    // The asynchronous load in progress, if any
+    AsyncLoad* asyncLoad_ { nullptr };
+    bool noteVelocityIndexValid_ { false };
+
+    /**
+     * @brief Build the velocity index from the note activation lists.
+     */
+    void buildNoteVelocityIndex();
+
+    /**
+     * @brief Get the layers which may start on a note-on, in the same order
+     * as the note activation list.
+     *
+     * @param noteNumber
+     * @param velocity
+     * @return const LayerViewVector&
+     */
+    const LayerViewVector& noteOnCandidates(int noteNumber, float velocity) const noexcept;
 
     // Effect factory and buses
     EffectFactory effectFactory_;
@@ -321,7 +586,13 @@ struct Synth::Impl final: public Parser::Listener {
 
     int samplesPerBlock_ { config::defaultSamplesPerBlock };
     float sampleRate_ { config::defaultSampleRate };
+    // The host rate and block size, which may be multiples of the above
+    int hostSamplesPerBlock_ { config::defaultSamplesPerBlock };
+    float hostSampleRate_ { config::defaultSampleRate };
+    float maxProcessingRate_ { 0.0f };
+    OutputUpsampler outputUpsampler_;
     float volume_ { Default::globalVolume };
+    float stretchRatio_ { 0.0f };
     int numVoices_ { config::numVoices };
 
     // Distribution used to generate random value for the *rand opcodes
@@ -354,20 +625,89 @@ struct Synth::Impl final: public Parser::Listener {
         size_t maxEQs { 0 };
         size_t maxLFOs { 0 };
         size_t maxFlexEGs { 0 };
+        // The voice pools are sized for the regions which borrow from them
+        std::vector<VoicePools::RegionNeeds> regionNeeds;
         bool havePitchEG { false };
         bool haveFilterEG { false };
         bool haveAmplitudeLFO { false };
         bool havePitchLFO { false };
         bool haveFilterLFO { false };
+        int maxBufferNesting { 0 };
     } settingsPerVoice_;
 
     CallbackBreakdown callbackBreakdown_;
+    LoadBreakdown loadBreakdown_;
     double dispatchDuration_ { 0 };
+    int voiceTimingPeriod_ { config::voiceTimingPeriod };
+    int voiceTimingCounter_ { 0 };
+    bool timeVoices_ { true };
+    std::array<LatencyHistogram, NumCallbackStages> callbackHistograms_;
+    std::array<LatencyHistogram, NumVoiceStartStages> voiceStartHistograms_;
+    std::atomic<uint64_t> numPreloadedStarts_ { 0 };
+    std::atomic<uint64_t> numNotPreloadedStarts_ { 0 };
+    // the cycle clock when the event in dispatch entered the synth
+    uint64_t dispatchStart_ { 0 };
+    QualityGovernor qualityGovernor_;
+    Tracer tracer_;
+
+    /**
+     * @brief Trace the rendering of a voice which started at a time.
+     */
+    void traceVoice(const Voice& voice, TimePoint start, unsigned lane) noexcept;
+
+    /**
+     * @brief Update the quality of new voices from the load of the last block.
+     *
+     * @param numFrames the size of the last block
+     */
+    void updateQualityGovernor(size_t numFrames) noexcept;
+
+    /**
+     * @brief Add the durations of the last callback to the statistics.
+     *
+     * @param renderDuration the duration of the whole render call
+     */
+    void updateCallbackStats(double renderDuration) noexcept;
+
+    /**
+     * @brief Add the latency of the start of a voice to the statistics, once
+     * the voice rendered the block of its first sample.
+     *
+     * @param voice a voice which rendered in this cycle
+     */
+    void updateVoiceStartStats(Voice& voice) noexcept;
+
+    // Multi-threaded voice rendering
+    struct RenderLane {
+        VoiceViewVector voices;
+        std::vector<std::vector<AudioBuffer<float>>> busInputs; // same layout as effectBuses_
+        CallbackBreakdown callbackBreakdown;
+    };
+    struct VoiceRenderJob final : public RenderThreadPool::Job {
+        explicit VoiceRenderJob(Impl& impl) : impl(impl) {}
+        void process(unsigned lane) noexcept final { impl.renderVoicesOfLane(lane); }
+        Impl& impl;
+        AudioSpan<float> tempSpan;
+        unsigned numFrames { 0 };
+    };
+    struct EffectRenderJob final : public RenderThreadPool::Job {
+        void process(unsigned lane) noexcept final;
+        std::vector<EffectBus*> buses;
+        unsigned numLanes { 1 };
+        unsigned numFrames { 0 };
+    };
+    RenderThreadPool renderThreads_;
+    std::vector<RenderLane> renderLanes_;
+    std::vector<int> regionLanes_; // lane of each region in the current cycle, or -1
+    VoiceRenderJob voiceRenderJob_ { *this };
+    EffectRenderJob effectRenderJob_;
 
     std::chrono::time_point<std::chrono::high_resolution_clock> lastGarbageCollection_;
 
     Parser parser_;
     std::string lastPath_;
+    std::string lastText_; // the text of an instrument loaded from memory
+    std::function<std::string()> lastConversion_; // the text of an instrument converted from a file
     absl::optional<fs::file_time_type> modificationTime_ { };
     bool reloading { false };
 
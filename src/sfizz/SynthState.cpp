@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "SynthPrivate.h"
+#include "SynthConfig.h"
+#include "Tuning.h"
+#include <cstring>
+#include <sstream>
+
+namespace sfz {
+
+namespace {
+
+constexpr char stateMagic[8] = { 'S', 'F', 'Z', 'S', 'T', 'A', 'T', 'E' };
+constexpr uint32_t stateVersion = 1;
+
+enum class Source : uint8_t { None, File, Text };
+
+template <class T>
+void writeValue(std::ostream& stream, T value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+bool readValue(std::istream& stream, T& value)
+{
+    return bool(stream.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+void writeString(std::ostream& stream, absl::string_view string)
+{
+    writeValue(stream, static_cast<uint32_t>(string.size()));
+    stream.write(string.data(), static_cast<std::streamsize>(string.size()));
+}
+
+bool readString(std::istream& stream, std::string& string)
+{
+    uint32_t size;
+    if (!readValue(stream, size))
+        return false;
+
+    // A corrupt size fails without allocating past the end of the state
+    const std::streampos position = stream.tellg();
+    if (!stream.seekg(0, std::ios::end))
+        return false;
+    const std::streamoff remaining = stream.tellg() - position;
+    if (!stream.seekg(position) || remaining < static_cast<std::streamoff>(size))
+        return false;
+
+    string.resize(size);
+    return size == 0 || bool(stream.read(&string[0], static_cast<std::streamsize>(size)));
+}
+
+bool readSource(std::istream& stream, Source& source, std::string& string)
+{
+    uint8_t value;
+    if (!readValue(stream, value) || value > static_cast<uint8_t>(Source::Text))
+        return false;
+    source = static_cast<Source>(value);
+    return source == Source::None || readString(stream, string);
+}
+
+/**
+ * @brief The contents of a state, read in full before any of it applies.
+ */
+struct State {
+    Source instrument { Source::None };
+    std::string instrumentPath;
+    std::string instrumentText;
+    Source scale { Source::None };
+    std::string scaleString;
+    int32_t rootKey { 0 };
+    float tuningFrequency { 0.0f };
+    float stretchRatio { 0.0f };
+    int32_t qualities[6] {};
+    int32_t numVoices { 0 };
+    float volume { 0.0f };
+    std::vector<std::pair<uint16_t, float>> ccValues;
+    float pitchBend { 0.0f };
+    float channelAftertouch { 0.0f };
+    int32_t program { 0 };
+    int16_t keyswitch { -1 };
+};
+
+bool readState(std::istream& stream, State& state)
+{
+    char magic[sizeof(stateMagic)];
+    uint32_t version;
+    if (!stream.read(magic, sizeof(magic)) || std::memcmp(magic, stateMagic, sizeof(stateMagic)) != 0
+        || !readValue(stream, version) || version != stateVersion)
+        return false;
+
+    if (!readSource(stream, state.instrument, state.instrumentPath))
+        return false;
+    if (state.instrument == Source::Text && !readString(stream, state.instrumentText))
+        return false;
+
+    if (!readSource(stream, state.scale, state.scaleString) || !readValue(stream, state.rootKey)
+        || !readValue(stream, state.tuningFrequency) || !readValue(stream, state.stretchRatio))
+        return false;
+
+    for (int32_t& quality : state.qualities) {
+        if (!readValue(stream, quality))
+            return false;
+    }
+
+    if (!readValue(stream, state.numVoices) || state.numVoices <= 0 || !readValue(stream, state.volume))
+        return false;
+
+    uint32_t numCCs;
+    if (!readValue(stream, numCCs) || numCCs > config::numCCs)
+        return false;
+    state.ccValues.resize(numCCs);
+    for (auto& ccValue : state.ccValues) {
+        if (!readValue(stream, ccValue.first) || ccValue.first >= config::numCCs
+            || !readValue(stream, ccValue.second))
+            return false;
+    }
+
+    return readValue(stream, state.pitchBend) && readValue(stream, state.channelAftertouch)
+        && readValue(stream, state.program) && readValue(stream, state.keyswitch);
+}
+
+} // namespace
+
+std::vector<uint8_t> Synth::saveState() const
+{
+    Impl& impl = *impl_;
+    const Tuning& tuning = impl.resources_.getTuning();
+    const SynthConfig& synthConfig = impl.resources_.getSynthConfig();
+    const MidiState& midiState = impl.resources_.getMidiState();
+    std::ostringstream stream;
+
+    stream.write(stateMagic, sizeof(stateMagic));
+    writeValue(stream, stateVersion);
+
+    // Only the reference of a file, which the load may replay from the cache
+    if (impl.layers_.empty()) {
+        writeValue(stream, Source::None);
+    } else if (impl.lastText_.empty() && !impl.lastConversion_) {
+        writeValue(stream, Source::File);
+        writeString(stream, impl.lastPath_);
+    } else {
+        // The converted instruments are kept as their text, converted anew
+        writeValue(stream, Source::Text);
+        writeString(stream, impl.lastPath_);
+        writeString(stream, impl.lastText_.empty() ? impl.lastConversion_() : impl.lastText_);
+    }
+
+    if (const absl::optional<fs::path> scalaFile = tuning.getScalaFile()) {
+        writeValue(stream, Source::File);
+        writeString(stream, scalaFile->string());
+    } else if (!tuning.getScalaText().empty()) {
+        writeValue(stream, Source::Text);
+        writeString(stream, tuning.getScalaText());
+    } else {
+        writeValue(stream, Source::None);
+    }
+    writeValue(stream, static_cast<int32_t>(tuning.getScalaRootKey()));
+    writeValue(stream, tuning.getTuningFrequency());
+    writeValue(stream, impl.stretchRatio_);
+
+    for (int32_t quality : {
+             synthConfig.liveSampleQuality, synthConfig.freeWheelingSampleQuality,
+             synthConfig.liveOscillatorQuality, synthConfig.freeWheelingOscillatorQuality,
+             synthConfig.liveEffectQuality, synthConfig.freeWheelingEffectQuality })
+        writeValue(stream, quality);
+
+    writeValue(stream, static_cast<int32_t>(impl.numVoices_));
+    writeValue(stream, impl.volume_);
+
+    // The controllers at their defaults come back with the instrument
+    std::vector<std::pair<uint16_t, float>> ccValues;
+    for (uint16_t cc = 0; cc < config::numCCs; ++cc) {
+        const float value = midiState.getCCValue(cc);
+        if (value != impl.defaultCCValues_[cc])
+            ccValues.emplace_back(cc, value);
+    }
+    writeValue(stream, static_cast<uint32_t>(ccValues.size()));
+    for (const auto& ccValue : ccValues) {
+        writeValue(stream, ccValue.first);
+        writeValue(stream, ccValue.second);
+    }
+
+    writeValue(stream, midiState.getPitchBend());
+    writeValue(stream, midiState.getChannelAftertouch());
+    writeValue(stream, static_cast<int32_t>(midiState.getProgram()));
+    writeValue(stream, static_cast<int16_t>(impl.currentSwitch_ ? *impl.currentSwitch_ : -1));
+
+    const std::string data = stream.str();
+    return std::vector<uint8_t>(data.begin(), data.end());
+}
+
+bool Synth::loadState(const void* data, size_t size)
+{
+    std::istringstream stream { std::string(reinterpret_cast<const char*>(data), size) };
+    State state;
+    if (!readState(stream, state))
+        return false;
+
+    // The instrument loads first, so that a failure leaves the rest as it is
+    bool success = true;
+    if (state.instrument == Source::File)
+        success = loadSfzFile(state.instrumentPath);
+    else if (state.instrument == Source::Text)
+        success = loadSfzString(state.instrumentPath, state.instrumentText);
+    if (!success)
+        return false;
+
+    setNumVoices(state.numVoices);
+    setVolume(state.volume);
+    setSampleQuality(ProcessLive, state.qualities[0]);
+    setSampleQuality(ProcessFreewheeling, state.qualities[1]);
+    setOscillatorQuality(ProcessLive, state.qualities[2]);
+    setOscillatorQuality(ProcessFreewheeling, state.qualities[3]);
+    setEffectQuality(ProcessLive, state.qualities[4]);
+    setEffectQuality(ProcessFreewheeling, state.qualities[5]);
+
+    Impl& impl = *impl_;
+    Tuning& tuning = impl.resources_.getTuning();
+    if (state.scale == Source::File)
+        loadScalaFile(state.scaleString);
+    else if (state.scale == Source::Text)
+        loadScalaString(state.scaleString);
+    else
+        tuning.loadEqualTemperamentScale();
+    setScalaRootKey(state.rootKey);
+    setTuningFrequency(state.tuningFrequency);
+    loadStretchTuningByRatio(state.stretchRatio);
+
+    // The values only, without triggering the regions on the controllers
+    MidiState& midiState = impl.resources_.getMidiState();
+    for (const auto& ccValue : state.ccValues) {
+        midiState.ccEvent(0, ccValue.first, ccValue.second);
+        for (const auto& layerPtr : impl.layers_)
+            layerPtr->updateCCState(ccValue.first, ccValue.second);
+    }
+    midiState.pitchBendEvent(0, state.pitchBend);
+    midiState.channelAftertouchEvent(0, state.channelAftertouch);
+    midiState.programChangeEvent(0, state.program);
+    midiState.flushEvents();
+
+    if (state.keyswitch >= 0 && state.keyswitch < 128)
+        impl.selectLastKeyswitch(state.keyswitch);
+
+    return true;
+}
+
+} // namespace sfz
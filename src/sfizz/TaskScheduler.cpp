@@ -0,0 +1,327 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "TaskScheduler.h"
+#include "Config.h"
+#include "utility/Debug.h"
+#include <absl/memory/memory.h>
+#include <algorithm>
+#include <mutex>
+#include <system_error>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sfz {
+
+static std::weak_ptr<TaskScheduler> globalSchedulerWeakPtr;
+static std::mutex globalSchedulerMutex;
+static TaskScheduler::ThreadSettings globalThreadSettings;
+
+TaskScheduler::ThreadSettings::ThreadSettings()
+    : priority(config::backgroundLoaderPthreadPriority)
+{
+}
+
+TaskScheduler::TaskScheduler(unsigned numWorkers, const ThreadSettings& settings)
+    : settings_(settings)
+{
+    numWorkers = std::max(1u, numWorkers);
+
+    workers_.reserve(numWorkers);
+    for (unsigned i = 0; i < numWorkers; ++i) {
+        workers_.push_back(absl::make_unique<Worker>());
+        for (auto& queue : workers_.back()->queues)
+            queue.reset(alignedNew<TaskQueue>());
+    }
+
+    // Start the threads once all the queues exist, since they steal from each other
+    for (unsigned i = 0; i < numWorkers; ++i)
+        workers_[i]->thread = std::thread(&TaskScheduler::workerProc, this, i);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    quit_ = true;
+    for (size_t i = 0; i < workers_.size(); ++i)
+        semWork_.post();
+    for (auto& worker : workers_)
+        worker->thread.join();
+}
+
+std::shared_ptr<TaskScheduler> TaskScheduler::getGlobal()
+{
+    std::shared_ptr<TaskScheduler> scheduler;
+
+    scheduler = globalSchedulerWeakPtr.lock();
+    if (scheduler)
+        return scheduler;
+
+    std::lock_guard<std::mutex> lock(globalSchedulerMutex);
+    scheduler = globalSchedulerWeakPtr.lock();
+    if (scheduler)
+        return scheduler;
+
+    const unsigned numWorkers = globalThreadSettings.numThreads;
+    scheduler.reset(new TaskScheduler(numWorkers ? numWorkers : defaultNumWorkers(), globalThreadSettings));
+    globalSchedulerWeakPtr = scheduler;
+    return scheduler;
+}
+
+void TaskScheduler::setGlobalThreadSettings(const ThreadSettings& settings)
+{
+    std::lock_guard<std::mutex> lock(globalSchedulerMutex);
+    globalThreadSettings = settings;
+    if (std::shared_ptr<TaskScheduler> scheduler = globalSchedulerWeakPtr.lock())
+        scheduler->setThreadSettings(settings);
+}
+
+auto TaskScheduler::getGlobalThreadSettings() -> ThreadSettings
+{
+    std::lock_guard<std::mutex> lock(globalSchedulerMutex);
+    return globalThreadSettings;
+}
+
+void TaskScheduler::setThreadSettings(const ThreadSettings& settings)
+{
+    {
+        std::lock_guard<SpinMutex> lock(settingsMutex_);
+        settings_ = settings;
+    }
+    settingsGeneration_.fetch_add(1, std::memory_order_release);
+
+    // Wake up the workers to apply them
+    for (size_t i = 0; i < workers_.size(); ++i)
+        semWork_.post();
+}
+
+unsigned TaskScheduler::defaultNumWorkers() noexcept
+{
+    const unsigned numThreads = std::thread::hardware_concurrency();
+    return (numThreads > 2) ? (numThreads - 2) : 1;
+}
+
+bool TaskScheduler::schedule(Task& task, Priority priority) noexcept
+{
+    int expected = Task::Idle;
+    if (!task.state_.compare_exchange_strong(expected, Task::Queued, std::memory_order_acq_rel))
+        return false;
+
+    const unsigned numWorkers = getNumWorkers();
+    const unsigned first = nextWorker_.fetch_add(1, std::memory_order_relaxed);
+    const unsigned p = static_cast<unsigned>(priority);
+
+    for (unsigned i = 0; i < numWorkers; ++i) {
+        TaskQueue& queue = *workers_[(first + i) % numWorkers]->queues[p];
+        if (queue.try_push(&task)) {
+            std::error_code ec;
+            semWork_.post(ec);
+            ASSERT(!ec);
+            return true;
+        }
+    }
+
+    task.state_.store(Task::Idle, std::memory_order_release);
+    return false;
+}
+
+bool TaskScheduler::notify(Task& task, Priority priority) noexcept
+{
+    int state = task.state_.load(std::memory_order_acquire);
+    while (true) {
+        switch (state) {
+        case Task::Idle:
+            if (schedule(task, priority))
+                return true;
+            state = task.state_.load(std::memory_order_acquire);
+            if (state == Task::Idle)
+                return false; // the queues are full
+            break;
+        case Task::Running:
+            if (task.state_.compare_exchange_weak(state, Task::Rerun, std::memory_order_acq_rel))
+                return true;
+            break;
+        default:
+            // Queued, or to run again, so it will see the changes before this call
+            return true;
+        }
+    }
+}
+
+void TaskScheduler::wait(const Task& task) noexcept
+{
+    while (!task.isIdle())
+        std::this_thread::yield();
+}
+
+TaskScheduler::Task* TaskScheduler::takeTask(unsigned index) noexcept
+{
+    const unsigned numWorkers = getNumWorkers();
+    Task* task;
+
+    // Own queue first, then the others, at each priority in turn
+    for (unsigned p = 0; p < numPriorities; ++p) {
+        for (unsigned i = 0; i < numWorkers; ++i) {
+            TaskQueue& queue = *workers_[(index + i) % numWorkers]->queues[p];
+            if (queue.try_pop(task))
+                return task;
+        }
+    }
+
+    return nullptr;
+}
+
+void TaskScheduler::workerProc(unsigned index)
+{
+    uint32_t generation = ~settingsGeneration_.load(std::memory_order_acquire);
+    bool pinned = false;
+
+    do {
+        const uint32_t currentGeneration = settingsGeneration_.load(std::memory_order_acquire);
+        if (generation != currentGeneration) {
+            generation = currentGeneration;
+            ThreadSettings settings;
+            {
+                std::lock_guard<SpinMutex> lock(settingsMutex_);
+                settings = settings_;
+            }
+            applyThreadSettings(settings, pinned);
+        }
+
+        // A post may wake a worker for a task which another one stole;
+        // it just goes back to sleep
+        Task* task = takeTask(index);
+        if (!task)
+            continue;
+
+        // The busy time counts from the first task to the last of a wakeup
+        const auto busyStart = std::chrono::steady_clock::now();
+        do {
+            // Run again here when notified while running
+            int state;
+            do {
+                task->state_.store(Task::Running, std::memory_order_release);
+                task->run();
+                state = Task::Running;
+            } while (!task->state_.compare_exchange_strong(state, Task::Idle, std::memory_order_acq_rel));
+        } while ((task = takeTask(index)));
+        const auto busyTime = std::chrono::steady_clock::now() - busyStart;
+        busyNanoseconds_.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(busyTime).count()), std::memory_order_relaxed);
+    } while (semWork_.wait(), !quit_);
+}
+
+TaskScheduler::Utilization TaskScheduler::getUtilization() const noexcept
+{
+    Utilization utilization;
+    utilization.busyTime = 1e-9 * static_cast<double>(busyNanoseconds_.load(std::memory_order_relaxed));
+    utilization.elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    utilization.numWorkers = getNumWorkers();
+    return utilization;
+}
+
+void TaskScheduler::applyThreadSettings(const ThreadSettings& settings, bool& pinned) noexcept
+{
+    using Policy = ThreadSettings::Policy;
+    const int priority = std::max(0, std::min(settings.priority, 100));
+
+#if defined(_WIN32)
+    HANDLE thread = GetCurrentThread();
+
+    // The MMCSS task is only available by loading avrt.dll
+    static HANDLE(WINAPI* avSetMmThreadCharacteristics)(LPCWSTR, LPDWORD) = []() {
+        HMODULE avrt = LoadLibraryW(L"avrt.dll");
+        return avrt ? reinterpret_cast<HANDLE(WINAPI*)(LPCWSTR, LPDWORD)>(
+            GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW")) : nullptr;
+    }();
+    thread_local HANDLE mmcssTask = nullptr;
+
+    int threadPriority = THREAD_PRIORITY_NORMAL;
+    switch (settings.policy) {
+    case Policy::Default:
+        threadPriority = THREAD_PRIORITY_ABOVE_NORMAL;
+        break;
+    case Policy::Normal:
+        break;
+    case Policy::RealTime:
+        threadPriority = (priority > 50) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+        if (!mmcssTask && avSetMmThreadCharacteristics) {
+            DWORD taskIndex = 0;
+            mmcssTask = avSetMmThreadCharacteristics(L"Pro Audio", &taskIndex);
+            if (!mmcssTask)
+                DBG("[sfizz] Cannot join the MMCSS task");
+        }
+        break;
+    }
+
+    if (!SetThreadPriority(thread, threadPriority)) {
+        std::system_error error(GetLastError(), std::system_category());
+        DBG("[sfizz] Cannot set current thread priority: " << error.what());
+    }
+
+    if (settings.affinityMask != 0 || pinned) {
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+        const DWORD_PTR mask = settings.affinityMask ?
+            static_cast<DWORD_PTR>(settings.affinityMask) : processMask;
+        if (SetThreadAffinityMask(thread, mask) == 0)
+            DBG("[sfizz] Cannot set current thread affinity");
+        pinned = settings.affinityMask != 0;
+    }
+#else
+    pthread_t thread = pthread_self();
+    int policy;
+    sched_param param;
+
+    if (pthread_getschedparam(thread, &policy, &param) != 0) {
+        DBG("[sfizz] Cannot get current thread scheduling parameters");
+        return;
+    }
+
+    switch (settings.policy) {
+    case Policy::Default:
+        policy = SCHED_RR;
+        break;
+    case Policy::Normal:
+        policy = SCHED_OTHER;
+        break;
+    case Policy::RealTime:
+        policy = SCHED_FIFO;
+        break;
+    }
+
+    const int minprio = sched_get_priority_min(policy);
+    const int maxprio = sched_get_priority_max(policy);
+    param.sched_priority = minprio + priority * (maxprio - minprio) / 100;
+
+    if (pthread_setschedparam(thread, policy, &param) != 0)
+        DBG("[sfizz] Cannot set current thread scheduling parameters");
+
+#if defined(__linux__)
+    if (settings.affinityMask != 0 || pinned) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        const unsigned numCpus = std::min<unsigned>(CPU_SETSIZE, 64);
+        for (unsigned cpu = 0; cpu < numCpus; ++cpu) {
+            if (settings.affinityMask == 0 || (settings.affinityMask & (uint64_t(1) << cpu)))
+                CPU_SET(cpu, &cpuSet);
+        }
+        if (pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet) != 0)
+            DBG("[sfizz] Cannot set current thread affinity");
+        pinned = settings.affinityMask != 0;
+    }
+#else
+    // No thread affinity on this system
+    (void)pinned;
+#endif
+#endif
+}
+
+} // namespace sfz
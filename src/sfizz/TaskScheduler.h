@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "RTSemaphore.h"
+#include "utility/MemoryHelpers.h"
+#include "SpinMutex.h"
+#include <atomic_queue/atomic_queue.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief The background worker threads shared by all the synths of the
+ * process, which run the streaming, garbage collection and loading tasks.
+ *
+ * Every worker has a lock-free queue per priority. The tasks are spread
+ * over the queues of the workers, and a worker with nothing left in its own
+ * queues steals the tasks of the others, the high priority ones first.
+ *
+ * The tasks belong to the caller, which keeps them alive until they are
+ * done; scheduling one does not allocate.
+ */
+class TaskScheduler {
+public:
+    enum class Priority {
+        High, // streaming
+        Low, // garbage collection, background loading
+    };
+
+    /**
+     * @brief The settings of the worker threads.
+     */
+    struct ThreadSettings {
+        enum class Policy {
+            Default, // round-robin, or above normal on Windows
+            Normal, // the scheduling of the creating thread
+            RealTime, // FIFO, or the "Pro Audio" MMCSS task on Windows
+        };
+        unsigned numThreads { 0 }; // 0 for defaultNumWorkers
+        Policy policy { Policy::Default };
+        int priority; // in % of the range of the policy
+        uint64_t affinityMask { 0 }; // a bit per CPU, 0 for all of them
+        ThreadSettings();
+    };
+
+    class Task {
+    public:
+        virtual ~Task() {}
+        /**
+         * @brief Run the task on a worker thread.
+         */
+        virtual void run() noexcept = 0;
+
+        /**
+         * @brief Check whether the task is neither queued nor running.
+         */
+        bool isIdle() const noexcept { return state_.load(std::memory_order_acquire) == Idle; }
+
+    private:
+        friend class TaskScheduler;
+        enum State : int { Idle, Queued, Running, Rerun };
+        std::atomic<int> state_ { Idle };
+    };
+
+    /**
+     * @brief A task which calls a function object.
+     */
+    template <class F>
+    class FunctionTask final : public Task {
+    public:
+        explicit FunctionTask(F function) : function_(std::move(function)) {}
+        void run() noexcept override { function_(); }
+
+    private:
+        F function_;
+    };
+
+    explicit TaskScheduler(unsigned numWorkers, const ThreadSettings& settings = ThreadSettings());
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * @brief Get the scheduler shared by the file pools of the process,
+     * which is created with the first of them and goes away with the last.
+     */
+    static std::shared_ptr<TaskScheduler> getGlobal();
+
+    /**
+     * @brief Get the default number of workers, which leaves two cores to
+     * the audio and control threads.
+     */
+    static unsigned defaultNumWorkers() noexcept;
+
+    unsigned getNumWorkers() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief The time the workers spent running tasks since their start,
+     * summed over the workers, and the time since their start.
+     */
+    struct Utilization {
+        double busyTime { 0.0 }; // seconds
+        double elapsedTime { 0.0 }; // seconds
+        unsigned numWorkers { 0 };
+    };
+    /**
+     * @brief Get the utilization of the workers. This is lock-free.
+     */
+    Utilization getUtilization() const noexcept;
+
+    /**
+     * @brief Change the settings of the workers of the process. The workers
+     * which run take the new policy, priority and affinity as soon as they
+     * are idle, and the number of threads applies when the workers start
+     * again, once all the synths are gone.
+     */
+    static void setGlobalThreadSettings(const ThreadSettings& settings);
+
+    /**
+     * @brief Get the settings of the workers of the process.
+     */
+    static ThreadSettings getGlobalThreadSettings();
+
+    /**
+     * @brief Change the policy, priority and affinity of the workers, which
+     * apply them when they are idle.
+     */
+    void setThreadSettings(const ThreadSettings& settings);
+
+    /**
+     * @brief Queue a task. This is real-time safe.
+     *
+     * @param task the idle task
+     * @param priority the priority
+     * @return true if the task was queued, false if it was not idle or if
+     *         the queues are full
+     */
+    bool schedule(Task& task, Priority priority) noexcept;
+
+    /**
+     * @brief Make sure that a task runs once more after this call: queue
+     * it if idle, or have it run again once over if running. This is
+     * real-time safe, and several notifications may coalesce into one run.
+     *
+     * @param task the task
+     * @param priority the priority, if queued
+     * @return false if the task was idle and the queues are full
+     */
+    bool notify(Task& task, Priority priority) noexcept;
+
+    /**
+     * @brief Wait until a task is no longer queued nor running.
+     */
+    static void wait(const Task& task) noexcept;
+
+private:
+    static constexpr unsigned queueSize { 1024 };
+    static constexpr unsigned numPriorities { 2 };
+    using TaskQueue = atomic_queue::AtomicQueue<Task*, queueSize>;
+
+    struct Worker {
+        std::thread thread;
+        aligned_unique_ptr<TaskQueue> queues[numPriorities];
+    };
+
+    void workerProc(unsigned index);
+    Task* takeTask(unsigned index) noexcept;
+    /**
+     * @brief Apply the settings to the calling thread.
+     *
+     * @param pinned whether the thread has an affinity, updated
+     */
+    static void applyThreadSettings(const ThreadSettings& settings, bool& pinned) noexcept;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<unsigned> nextWorker_ { 0 };
+    std::atomic<uint64_t> busyNanoseconds_ { 0 };
+    const std::chrono::steady_clock::time_point start_ { std::chrono::steady_clock::now() };
+    RTSemaphore semWork_;
+    std::atomic<bool> quit_ { false };
+    SpinMutex settingsMutex_;
+    ThreadSettings settings_;
+    std::atomic<uint32_t> settingsGeneration_ { 0 };
+};
+
+} // namespace sfz
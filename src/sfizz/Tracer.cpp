@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Tracer.h"
+#include <chrono>
+#include <iomanip>
+
+namespace sfz {
+
+Tracer::Tracer()
+    : queue_(new EventQueue)
+{
+}
+
+Tracer::~Tracer()
+{
+    stop();
+}
+
+bool Tracer::start(const fs::path& file, bool traceVoices)
+{
+    stop();
+
+    // Forget the events pushed after the end of the last trace
+    TraceEvent event;
+    while (queue_->try_pop(event));
+
+    stream_.open(file, std::ios::binary | std::ios::trunc);
+    if (!stream_)
+        return false;
+
+    stream_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"sfizz\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Blocks\"}}";
+    stream_ << std::fixed << std::setprecision(3);
+    namedLanes_.reset();
+
+    traceVoices_ = traceVoices;
+    origin_ = highResNow();
+    numDropped_.store(0, std::memory_order_relaxed);
+    draining_.store(true, std::memory_order_relaxed);
+    drainingThread_ = std::thread(&Tracer::drainingJob, this);
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+void Tracer::stop()
+{
+    if (!drainingThread_.joinable())
+        return;
+
+    active_.store(false, std::memory_order_release);
+    draining_.store(false, std::memory_order_relaxed);
+    drainingThread_.join();
+    drain();
+
+    stream_ << "\n]}\n";
+    stream_.close();
+}
+
+void Tracer::push(const TraceEvent& event) noexcept
+{
+    if (!isActive())
+        return;
+
+    if (!queue_->try_push(event))
+        numDropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Tracer::drainingJob()
+{
+    while (draining_.load(std::memory_order_relaxed)) {
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(config::traceDrainPeriod));
+    }
+}
+
+void Tracer::drain()
+{
+    TraceEvent event;
+    while (queue_->try_pop(event))
+        writeEvent(event);
+    stream_.flush();
+}
+
+void Tracer::writeEvent(const TraceEvent& event)
+{
+    // the times of the trace format are in microseconds
+    const double start = 1e6 * Duration(event.start - origin_).count();
+    const double duration = 1e6 * event.duration;
+    auto stage = [&event](int index) { return 1e6 * event.stages[index]; };
+
+    stream_ << ",\n";
+
+    switch (event.type) {
+    case TraceEvent::Type::Block:
+        stream_ << "{\"name\":\"block\",\"cat\":\"block\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+            << ",\"ts\":" << start << ",\"dur\":" << duration
+            << ",\"args\":{\"frames\":" << event.number
+            << ",\"voices\":" << event.count
+            << ",\"culled\":" << event.detail
+            << ",\"underruns\":" << event.underruns
+            << ",\"dispatch\":" << stage(0)
+            << ",\"render\":" << stage(1)
+            << ",\"effects\":" << stage(2) << "}}";
+        break;
+    case TraceEvent::Type::Voice:
+        {
+            const int tid = 1 + event.lane;
+            if (!namedLanes_.test(event.lane)) {
+                namedLanes_.set(event.lane);
+                stream_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                    << ",\"args\":{\"name\":\"Voices, lane " << int(event.lane) << "\"}},\n";
+            }
+            stream_ << "{\"name\":\"region " << event.number << "\",\"cat\":\"voice\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << start << ",\"dur\":" << duration
+                << ",\"args\":{\"region\":" << event.number
+                << ",\"voice\":" << event.count
+                << ",\"position\":" << event.detail
+                << ",\"data\":" << stage(0)
+                << ",\"amplitude\":" << stage(1)
+                << ",\"filters\":" << stage(2)
+                << ",\"panning\":" << stage(3) << "}}";
+        }
+        break;
+    }
+}
+
+} // namespace sfz
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Config.h"
+#include "utility/Timing.h"
+#include <atomic_queue/atomic_queue.h>
+#include <ghc/fs_std.hpp>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace sfz {
+
+/**
+ * @brief A timed event of the processing.
+ */
+struct TraceEvent {
+    enum class Type : uint8_t { Block, Voice };
+    Type type { Type::Block };
+    uint8_t lane { 0 }; // render lane of a voice
+    TimePoint start {};
+    double duration { 0 }; // seconds
+    // the stages in seconds: the dispatch, render and effects of a block,
+    // or the data, amplitude, filters and panning of a voice
+    float stages[4] {};
+    int32_t number { 0 }; // frames of a block, or region of a voice
+    int32_t count { 0 }; // voices of a block, or identifier of a voice
+    int32_t detail { 0 }; // culled voices of a block, or source position of a voice
+    uint32_t underruns { 0 }; // streaming underruns since the start
+};
+
+/**
+ * @brief Trace of the timings of the processing, kept in files of the Chrome
+ * trace format, which Perfetto also reads.
+ *
+ * The real-time thread pushes the events into a lock-free queue, without
+ * blocking, and drops them if the queue is full. A background thread drains
+ * the queue into the file.
+ */
+class Tracer {
+public:
+    Tracer();
+    ~Tracer();
+
+    /**
+     * @brief Start a trace into a file, replacing any current trace.
+     * Do not call it in the RT thread.
+     *
+     * @param file          the file to write
+     * @param traceVoices   whether the voices are traced as well as the blocks
+     * @return true if the file could be opened
+     */
+    bool start(const fs::path& file, bool traceVoices);
+
+    /**
+     * @brief Stop the current trace, writing the remaining events and
+     * closing the file. Do not call it in the RT thread.
+     */
+    void stop();
+
+    /**
+     * @brief Check whether a trace is running.
+     */
+    bool isActive() const noexcept { return active_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Check whether a trace of the voices is running.
+     */
+    bool tracesVoices() const noexcept { return isActive() && traceVoices_; }
+
+    /**
+     * @brief Add an event to the trace, if running. It is RT-safe.
+     */
+    void push(const TraceEvent& event) noexcept;
+
+    /**
+     * @brief Get the number of events dropped by the current or last trace,
+     * because the queue was full.
+     */
+    uint64_t getNumDroppedEvents() const noexcept { return numDropped_.load(std::memory_order_relaxed); }
+
+private:
+    void drainingJob();
+    void drain();
+    void writeEvent(const TraceEvent& event);
+
+    using EventQueue = atomic_queue::AtomicQueue2<TraceEvent, config::traceQueueSize>;
+    std::unique_ptr<EventQueue> queue_;
+    std::atomic<bool> active_ { false };
+    std::atomic<bool> draining_ { false };
+    std::atomic<uint64_t> numDropped_ { 0 };
+    bool traceVoices_ { false };
+    TimePoint origin_ {};
+    fs::ofstream stream_;
+    std::bitset<256> namedLanes_;
+    std::thread drainingThread_;
+};
+
+} // namespace sfz
@@ -23,17 +23,23 @@ public:
     const Tunings::Tuning& tuning() const { return tuning_; }
 
     float getKeyFractional12TET(int midiKey) const;
+    float getStretchRatioOfKey(int midiKey) const;
 
     int rootKey() const { return rootKey_; }
     float tuningFrequency() const { return tuningFrequency_; }
 
-    void updateScale(const Tunings::Scale& scale, absl::optional<fs::path> sourceFile = {});
+    const absl::optional<fs::path>& scalaFile() const { return scalaFile_; }
+    const std::string& scalaText() const { return scalaText_; }
+
+    void updateScale(const Tunings::Scale& scale, absl::optional<fs::path> sourceFile = {}, std::string sourceText = {});
     bool shouldReloadScala();
     void updateRootKey(int rootKey);
     void updateTuningFrequency(float tuningFrequency);
+    void updateStretch(const StretchTuning* stretch);
     void reset();
 private:
     void updateKeysFractional12TET();
+    void updateKeysStretchRatio();
     static Tunings::KeyboardMapping mappingFromParameters(int rootKey, float tuningFrequency);
 
 private:
@@ -48,11 +54,17 @@ private:
     };
 
     absl::optional<fs::path> scalaFile_;
+    std::string scalaText_; // if loaded from memory
     fs::file_time_type modificationTime_ {};
 
     static constexpr int numKeys = Tunings::Tuning::N;
     static constexpr int keyOffset = 256; // Surge tuning has key range ±256
     std::array<float, numKeys> keysFractional12TET_;
+
+    // stretch ratios at the retuned MIDI keys, rebuilt with the scale
+    static constexpr int numMidiKeys = 128;
+    absl::optional<StretchTuning> stretch_;
+    std::array<float, numMidiKeys> keysStretchRatio_;
 };
 
 void Tuning::Impl::reset()
@@ -64,6 +76,7 @@ void Tuning::Impl::reset()
         mappingFromParameters(defaultRootKey, defaultTuningFrequency)
     );
     scalaFile_.reset();
+    scalaText_.clear();
     modificationTime_ = fs::file_time_type::min();
     updateKeysFractional12TET();
 }
@@ -73,12 +86,18 @@ float Tuning::Impl::getKeyFractional12TET(int midiKey) const
     return keysFractional12TET_[std::max(0, std::min(numKeys - 1, midiKey + keyOffset))];
 }
 
-void Tuning::Impl::updateScale(const Tunings::Scale& scale, absl::optional<fs::path> sourceFile)
+float Tuning::Impl::getStretchRatioOfKey(int midiKey) const
+{
+    return keysStretchRatio_[std::max(0, std::min(numMidiKeys - 1, midiKey))];
+}
+
+void Tuning::Impl::updateScale(const Tunings::Scale& scale, absl::optional<fs::path> sourceFile, std::string sourceText)
 {
     tuning_ = Tunings::Tuning(scale, tuning_.keyboardMapping);
     updateKeysFractional12TET();
 
     scalaFile_ = sourceFile;
+    scalaText_ = std::move(sourceText);
 
     if (sourceFile) {
         std::error_code ec;
@@ -135,6 +154,24 @@ void Tuning::Impl::updateKeysFractional12TET()
         double freq = tuning_.frequencyForMidiNote(key - keyOffset);
         keysFractional12TET_[key] = 12.0 * std::log2(freq / 440.0) + 69.0;
     }
+    updateKeysStretchRatio();
+}
+
+void Tuning::Impl::updateStretch(const StretchTuning* stretch)
+{
+    if (stretch)
+        stretch_ = *stretch;
+    else
+        stretch_.reset();
+    updateKeysStretchRatio();
+}
+
+void Tuning::Impl::updateKeysStretchRatio()
+{
+    for (int key = 0; key < numMidiKeys; ++key) {
+        keysStretchRatio_[key] = stretch_ ?
+            stretch_->getRatioForFractionalKey(getKeyFractional12TET(key)) : 1.0f;
+    }
 }
 
 Tunings::KeyboardMapping Tuning::Impl::mappingFromParameters(int rootKey, float tuningFrequency)
@@ -159,6 +196,13 @@ Tuning::~Tuning()
 {
 }
 
+Tuning& Tuning::operator=(const Tuning& other)
+{
+    if (this != &other)
+        *impl_ = *other.impl_;
+    return *this;
+}
+
 bool Tuning::loadScalaFile(const fs::path& path)
 {
     Tunings::Scale scl;
@@ -208,7 +252,7 @@ bool Tuning::loadScalaString(const std::string& text)
         goto failure;
     }
 
-    impl_->updateScale(scl);
+    impl_->updateScale(scl, {}, text);
     return true;
 
 failure:
@@ -236,6 +280,16 @@ float Tuning::getTuningFrequency() const
     return impl_->tuningFrequency();
 }
 
+absl::optional<fs::path> Tuning::getScalaFile() const
+{
+    return impl_->scalaFile();
+}
+
+const std::string& Tuning::getScalaText() const
+{
+    return impl_->scalaText();
+}
+
 void Tuning::loadEqualTemperamentScale()
 {
     impl_->updateScale(Tunings::evenTemperament12NoteScale());
@@ -251,6 +305,16 @@ float Tuning::getKeyFractional12TET(int midiKey)
     return impl_->getKeyFractional12TET(midiKey);
 }
 
+float Tuning::getStretchRatioOfKey(int midiKey) const
+{
+    return impl_->getStretchRatioOfKey(midiKey);
+}
+
+void Tuning::setStretchTuning(const StretchTuning* stretch)
+{
+    impl_->updateStretch(stretch);
+}
+
 bool Tuning::shouldReloadScala()
 {
     return impl_->shouldReloadScala();
@@ -6,14 +6,19 @@
 
 #pragma once
 #include "ghc/fs_std.hpp"
+#include <absl/types/optional.h>
 #include <memory>
+#include <string>
 
 namespace sfz {
 
+class StretchTuning;
+
 class Tuning {
 public:
     Tuning();
     ~Tuning();
+    Tuning& operator=(const Tuning& other);
 
     /**
      * @brief Load a scale from a file in the Scala format.
@@ -45,6 +50,17 @@ public:
      */
     float getTuningFrequency() const;
 
+    /**
+     * @brief Get the file of the current scale, if loaded from a file.
+     */
+    absl::optional<fs::path> getScalaFile() const;
+
+    /**
+     * @brief Get the text of the current scale, if loaded from memory, or
+     * else an empty string.
+     */
+    const std::string& getScalaText() const;
+
     /**
      * @brief Load the equal-temperament scale.
      */
@@ -60,6 +76,18 @@ public:
      */
     float getKeyFractional12TET(int midiKey);
 
+    /**
+     * @brief Set the stretch tuning, or none if null, which applies over the
+     * present scale.
+     */
+    void setStretchTuning(const StretchTuning* stretch);
+
+    /**
+     * @brief Get the stretch ratio of the MIDI key, at its fractional key
+     * under the present tuning. It is 1 without a stretch tuning.
+     */
+    float getStretchRatioOfKey(int midiKey) const;
+
     /**
      * @brief Check whether the underlying scala file has changed.
      *
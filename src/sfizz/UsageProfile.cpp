@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "UsageProfile.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace sfz {
+
+namespace {
+
+struct UsageProfileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numEntries;
+};
+
+struct UsageProfileEntry {
+    uint64_t playedFrames;
+    uint32_t numPlays;
+    uint32_t reverse;
+    uint32_t pathSize;
+    uint32_t reserved;
+};
+
+constexpr char usageProfileMagic[8] = { 'S', 'F', 'Z', 'U', 'S', 'A', 'G', 'E' };
+constexpr uint32_t usageProfileVersion = 1;
+
+} // namespace
+
+void UsageProfile::record(const FileId& fileId, FileUsage usage)
+{
+    FileUsage& recorded = usage_[fileId];
+    recorded.numPlays += usage.numPlays;
+    recorded.playedFrames = std::max(recorded.playedFrames, usage.playedFrames);
+}
+
+void UsageProfile::merge(const UsageProfile& other)
+{
+    for (const auto& item : other.usage_)
+        record(item.first, item.second);
+}
+
+const FileUsage* UsageProfile::find(const FileId& fileId) const noexcept
+{
+    const auto it = usage_.find(fileId);
+    return (it != usage_.end()) ? &it->second : nullptr;
+}
+
+bool UsageProfile::load(const fs::path& path)
+{
+    usage_.clear();
+
+    fs::ifstream stream { path, std::ios::binary };
+    UsageProfileHeader header;
+    if (!stream || !stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, usageProfileMagic, sizeof(usageProfileMagic)) != 0
+        || header.version != usageProfileVersion)
+        return false;
+
+    for (uint32_t i = 0; i < header.numEntries; ++i) {
+        UsageProfileEntry entry;
+        if (!stream.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+            usage_.clear();
+            return false;
+        }
+        std::string filename(entry.pathSize, '\0');
+        if (!stream.read(&filename[0], static_cast<std::streamsize>(filename.size()))) {
+            usage_.clear();
+            return false;
+        }
+        FileUsage usage;
+        usage.numPlays = entry.numPlays;
+        usage.playedFrames = entry.playedFrames;
+        record(FileId { std::move(filename), entry.reverse != 0 }, usage);
+    }
+
+    return true;
+}
+
+bool UsageProfile::save(const fs::path& path) const
+{
+    UsageProfileHeader header {};
+    std::memcpy(header.magic, usageProfileMagic, sizeof(usageProfileMagic));
+    header.version = usageProfileVersion;
+    header.numEntries = static_cast<uint32_t>(usage_.size());
+
+    std::error_code ec;
+    fs::path temporaryFile = path;
+    temporaryFile += ".tmp";
+    {
+        fs::ofstream stream { temporaryFile, std::ios::binary | std::ios::trunc };
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& item : usage_) {
+            const std::string& filename = item.first.filename();
+            UsageProfileEntry entry {};
+            entry.playedFrames = item.second.playedFrames;
+            entry.numPlays = item.second.numPlays;
+            entry.reverse = item.first.isReverse() ? 1 : 0;
+            entry.pathSize = static_cast<uint32_t>(filename.size());
+            stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            stream.write(filename.data(), static_cast<std::streamsize>(filename.size()));
+        }
+        if (!stream) {
+            stream.close();
+            fs::remove(temporaryFile, ec);
+            return false;
+        }
+    }
+
+    fs::rename(temporaryFile, path, ec);
+    if (ec) {
+        fs::remove(temporaryFile, ec);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace sfz
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "FileId.h"
+#include <ghc/fs_std.hpp>
+#include <absl/container/flat_hash_map.h>
+#include <cstdint>
+
+namespace sfz {
+
+/**
+ * @brief How the players used a file: how many times they played it, and
+ * the furthest frame of the file they reached.
+ */
+struct FileUsage {
+    uint32_t numPlays { 0 };
+    uint64_t playedFrames { 0 };
+};
+
+/**
+ * @brief The usage of the files of an instrument over its sessions, which
+ * the file pool records and which guides its preloads on the next loads.
+ */
+class UsageProfile {
+public:
+    /**
+     * @brief Add the usage of a file, which sums the plays and keeps the
+     * furthest frame.
+     */
+    void record(const FileId& fileId, FileUsage usage);
+    /**
+     * @brief Add the usage of all the files of another profile.
+     */
+    void merge(const UsageProfile& other);
+    /**
+     * @brief Get the usage of a file, or null if it never played.
+     */
+    const FileUsage* find(const FileId& fileId) const noexcept;
+
+    bool empty() const noexcept { return usage_.empty(); }
+    size_t size() const noexcept { return usage_.size(); }
+    void clear() noexcept { usage_.clear(); }
+
+    /**
+     * @brief Replace the profile with the one of a file.
+     *
+     * @return false if the file is not a profile, in which case the profile
+     *         is empty
+     */
+    bool load(const fs::path& path);
+    /**
+     * @brief Write the profile into a file, through a temporary file, such
+     * that the file is always whole.
+     *
+     * @return false if the file could not be written
+     */
+    bool save(const fs::path& path) const;
+
+private:
+    absl::flat_hash_map<FileId, FileUsage> usage_;
+};
+
+} // namespace sfz
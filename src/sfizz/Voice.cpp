@@ -24,19 +24,25 @@
 #include "OnePoleFilter.h"
 #include "Panning.h"
 #include "PowerFollower.h"
+#include "QualityGovernor.h"
 #include "SfzHelpers.h"
 #include "SIMDHelpers.h"
 #include "Smoothers.h"
 #include "FilePool.h"
 #include "Wavetables.h"
 #include "Tuning.h"
+#include "VoicePools.h"
 #include "BufferPool.h"
 #include "SynthConfig.h"
 #include "utility/Macros.h"
+#include "utility/MemoryHelpers.h"
 #include "utility/Timing.h"
 #include <absl/algorithm/container.h>
 #include <absl/types/span.h>
+#include <array>
 #include <random>
+#include <type_traits>
+#include <utility>
 
 namespace sfz {
 
@@ -49,15 +55,19 @@ struct Voice::Impl
      * in rendering each block of data.
      *
      * @param buffer
+     * @param dormant only advance the position and the loops, leaving the
+     *                buffer silent
      */
-    void fillWithData(AudioSpan<float> buffer) noexcept;
+    void fillWithData(AudioSpan<float> buffer, bool dormant = false) noexcept;
     /**
      * @brief Fill a span with data from a generator source. This is the first step
      * in rendering each block of data.
      *
      * @param buffer
+     * @param dormant only advance the phases of the oscillators, leaving the
+     *                buffer silent
      */
-    void fillWithGenerator(AudioSpan<float> buffer) noexcept;
+    void fillWithGenerator(AudioSpan<float> buffer, bool dormant = false) noexcept;
 
     /**
      * @brief Fill a destination with an interpolated source.
@@ -73,6 +83,21 @@ struct Voice::Impl
         absl::Span<const int> indices, absl::Span<const float> coeffs,
         absl::Span<const float> addingGains);
 
+    /**
+     * @brief Fill a destination with an interpolated source in the compact
+     *        storage, converting the frames to float run by run.
+     *
+     * @param source the source sample, padded like the file buffers
+     * @param dest the destination buffer
+     * @param indices the integral parts of the source positions
+     * @param coeffs the fractional parts of the source positions
+     */
+    template <InterpolatorModel M, bool Adding>
+    static void fillInterpolated(
+        const AudioSpan<const int16_t>& source, const AudioSpan<float>& dest,
+        absl::Span<const int> indices, absl::Span<const float> coeffs,
+        absl::Span<const float> addingGains);
+
     /**
      * @brief Fill a destination with an interpolated source, selecting
      *        interpolation type dynamically by quality level.
@@ -83,12 +108,43 @@ struct Voice::Impl
      * @param coeffs the fractional parts of the source positions
      * @param quality the quality level 1-10
      */
-    template <bool Adding>
+    template <bool Adding, class T>
     static void fillInterpolatedWithQuality(
-        const AudioSpan<const float>& source, const AudioSpan<float>& dest,
+        const AudioSpan<const T>& source, const AudioSpan<float>& dest,
         absl::Span<const int> indices, absl::Span<const float> coeffs,
         absl::Span<const float> addingGains, int quality);
 
+    /**
+     * @brief Fill a destination by copying or decimating the source, if the
+     *        source positions are integral and advance by a constant step.
+     *
+     * @param source the source sample
+     * @param dest the destination buffer
+     * @param indices the integral parts of the source positions
+     * @param coeffs the fractional parts of the source positions
+     * @param step the step between the source positions, 1 or 2
+     * @return true if the destination was filled, false if it must be
+     *         interpolated instead
+     */
+    template <class T>
+    static bool fillStepped(
+        const AudioSpan<const T>& source, const AudioSpan<float>& dest,
+        absl::Span<const int> indices, absl::Span<const float> coeffs, int step);
+
+    /**
+     * @brief Mirror the source positions of a reversed file into the ones of
+     *        the forward file, whose data it reads backward.
+     *
+     * @param indices the integral parts of the reversed positions
+     * @param coeffs the fractional parts of the reversed positions
+     * @param lastFrame the last frame of the file
+     * @param mirroredIndices the integral parts of the forward positions
+     * @param mirroredCoeffs the fractional parts of the forward positions
+     */
+    static void mirrorPositions(
+        absl::Span<const int> indices, absl::Span<const float> coeffs, int lastFrame,
+        absl::Span<int> mirroredIndices, absl::Span<float> mirroredCoeffs) noexcept;
+
     /**
      * @brief Get a S-shaped curve that is applicable to loop crossfading.
      */
@@ -110,18 +166,27 @@ struct Voice::Impl
     void applyCrossfades(absl::Span<float> modulationSpan) noexcept;
     void resetCrossfades() noexcept;
 
+    /**
+     * @brief Compute the gain of the amplitude stage over the block
+     *
+     * @param gainSpan
+     */
+    template <unsigned Features>
+    void amplitudeGain(absl::Span<float> gainSpan) noexcept;
     /**
      * @brief Amplitude stage for a mono source
      *
      * @param buffer
+     * @param gain the gain of the frames of the buffer
      */
-    void ampStageMono(AudioSpan<float> buffer) noexcept;
+    void ampStageMono(AudioSpan<float> buffer, absl::Span<const float> gain) noexcept;
     /**
      * @brief Amplitude stage for a stereo source
      *
      * @param buffer
+     * @param gain the gain of the frames of the buffer
      */
-    void ampStageStereo(AudioSpan<float> buffer) noexcept;
+    void ampStageStereo(AudioSpan<float> buffer, absl::Span<const float> gain) noexcept;
     /**
      * @brief Amplitude stage for a mono source
      *
@@ -129,12 +194,42 @@ struct Voice::Impl
      */
     void panStageMono(AudioSpan<float> buffer) noexcept;
     void panStageStereo(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Render the stages of a block into the buffer, up to the output
+     * gain, which is left to apply.
+     *
+     * The features are the stages of the region, as of
+     * Layer::VoiceTemplate::RenderFeatures; the render of each combination
+     * leaves out the other stages and their checks.
+     *
+     * @param buffer
+     * @return false if the voice produced nothing
+     */
+    template <unsigned Features>
+    bool renderStages(AudioSpan<float, 2> buffer) noexcept;
+    using RenderStages = bool (Impl::*)(AudioSpan<float, 2>);
+    template <size_t... Features>
+    static std::array<RenderStages, sizeof...(Features)> makeRenderVariants(std::index_sequence<Features...>)
+    {
+        return {{ &Impl::renderStages<Features>... }};
+    }
+    // The renders by features, and the one of the region of the voice
+    static const std::array<RenderStages, Layer::VoiceTemplate::numRenderVariants> renderVariants_;
+    RenderStages renderStages_ { &Impl::renderStages<0> };
+    /**
+     * @brief Update the state of the voice after a block
+     *
+     * @param buffer the block, up to the output gain
+     */
+    void endBlock(AudioSpan<float, 2> buffer) noexcept;
     /**
      * @brief Amplitude stage for a mono source
      *
      * @param buffer
      */
+    template <unsigned Features>
     void filterStageMono(AudioSpan<float> buffer) noexcept;
+    template <unsigned Features>
     void filterStageStereo(AudioSpan<float> buffer) noexcept;
     /**
      * @brief Compute the pitch envelope. This envelope is meant to multiply
@@ -148,19 +243,35 @@ struct Voice::Impl
     /**
      * @brief Initialize frequency and gain coefficients for the oscillators.
      */
-    void setupOscillatorUnison();
+    void setupOscillatorUnison(const Layer::VoiceTemplate& voiceTemplate) noexcept;
     void updateChannelPowers(AudioSpan<float> buffer);
 
     /**
      * @brief Modify the voice state and notify any listeners.
      */
     void switchState(State s);
+    /**
+     * @brief Tell the listener when the voice starts or stops counting
+     * against the polyphony, as of `offedOrFree`.
+     */
+    void updatePlaying() noexcept;
+
+    /**
+     * @brief Borrow the filters, EQs, LFOs and flex EGs of a region from the
+     * voice pools, or none of them if the pools lack some.
+     */
+    bool acquirePooledObjects(const Region& region) noexcept;
+
+    /**
+     * @brief Give back the borrowed objects to the voice pools
+     */
+    void releasePooledObjects() noexcept;
 
     /**
      * @brief Save the modulation targets to avoid recomputing them in every callback.
      * Must be called during startVoice() ideally.
      */
-    void saveModulationTargets(const Region* region) noexcept;
+    void saveModulationTargets(const Layer::VoiceTemplate& voiceTemplate) noexcept;
 
     /**
      * @brief Get the sample quality determined by the active region.
@@ -225,6 +336,7 @@ struct Voice::Impl
     State state_ { State::idle };
     bool noteIsOff_ { false };
     bool offed_ { false };
+    bool playing_ { false };
     enum class SustainState { Up, Sustaining };
     SustainState sustainState_ { SustainState::Up };
     enum class SostenutoState { Up, Sustaining, PreviouslyDown };
@@ -240,11 +352,20 @@ struct Voice::Impl
     float baseFrequency_ { 440.0 };
     uint8_t pitchKeycenter_ { Default::key };
 
-    float floatPositionOffset_ { 0.0f };
+    // The play position in 32.32 fixed point, split in the index in the
+    // source and the fraction
     int sourcePosition_ { 0 };
+    uint32_t positionFraction_ { 0 };
     int initialDelay_ { 0 };
     int age_ { 0 };
     uint32_t count_ { 1 };
+    bool underran_ { false };
+
+    // the latency of the start, until the synth takes it
+    uint64_t startTicks_ { 0 };
+    StartLatency startLatency_;
+    bool startPending_ { false };
+    bool startMeasured_ { false };
     int sampleEnd_ { 0 };
     int sampleSize_ { 0 };
 
@@ -266,10 +387,11 @@ struct Voice::Impl
 
     Resources& resources_;
 
-    std::vector<FilterHolder> filters_;
-    std::vector<EQHolder> equalizers_;
-    std::vector<std::unique_ptr<LFO>> lfos_;
-    std::vector<std::unique_ptr<FlexEnvelope>> flexEGs_;
+    // Borrowed from the voice pools for the region
+    std::vector<FilterHolder*> filters_;
+    std::vector<EQHolder*> equalizers_;
+    std::vector<LFO*> lfos_;
+    std::vector<FlexEnvelope*> flexEGs_;
 
     std::unique_ptr<LFO> lfoAmplitude_;
     std::unique_ptr<LFO> lfoPitch_;
@@ -287,10 +409,11 @@ struct Voice::Impl
     float waveLeftGain_[config::oscillatorsPerVoice] {};
     float waveRightGain_[config::oscillatorsPerVoice] {};
 
-    double dataDuration_;
-    double amplitudeDuration_;
-    double panningDuration_;
-    double filterDuration_;
+    double dataDuration_ { 0 };
+    double amplitudeDuration_ { 0 };
+    double panningDuration_ { 0 };
+    double filterDuration_ { 0 };
+    bool timingEnabled_ { true };
 
     fast_real_distribution<float> uniformNoiseDist_ { -config::uniformNoiseBounds, config::uniformNoiseBounds };
     fast_gaussian_generator<float> gaussianNoiseDist_ { 0.0f, config::noiseVariance };
@@ -313,6 +436,21 @@ struct Voice::Impl
     bool followPower_ { false };
     PowerFollower powerFollower_;
 
+    /**
+     * @brief End the voice if it stayed released and inaudible for long enough
+     */
+    void cullIfInaudible() noexcept;
+    float lastAmplitudeGain_ { 1.0f };
+    // The constant gain of the block which the stages leave to apply, so
+    // that it goes with the mix of the voice into its destination
+    float outputGain_ { 1.0f };
+    int inaudibleBlocks_ { 0 };
+    bool culled_ { false };
+    // The gain of the last block was zero, so only the state advanced
+    bool dormant_ { false };
+
+    int qualityReduction_ { 0 };
+
     ExtendedCCValues extendedCCValues_;
 };
 
@@ -373,11 +511,8 @@ Voice& Voice::operator=(Voice&& other) noexcept {
 Voice::Impl::Impl(int voiceNumber, Resources& resources)
 : id_ { voiceNumber }, stateListener_(nullptr), resources_(resources)
 {
-    for (unsigned i = 0; i < config::filtersPerVoice; ++i)
-        filters_.emplace_back(resources);
-
-    for (unsigned i = 0; i < config::eqsPerVoice; ++i)
-        equalizers_.emplace_back(resources);
+    filters_.reserve(config::filtersPerVoice);
+    equalizers_.reserve(config::eqsPerVoice);
 
     for (WavetableOscillator& osc : waveOscillators_)
         osc.init(sampleRate_);
@@ -416,7 +551,9 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
 
     impl.layer_ = layer;
     const Region& region = layer->getRegion();
+    const Layer::VoiceTemplate& voiceTemplate = layer->voiceTemplate_;
     impl.region_ = &region;
+    impl.renderStages_ = Impl::renderVariants_[voiceTemplate.renderFeatures];
 
     impl.triggerEvent_ = event;
     if (impl.triggerEvent_.type == TriggerEventType::CC)
@@ -425,7 +562,7 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
     if (region.velocityOverride == VelocityOverride::previous)
         impl.triggerEvent_.value = midiState.getVelocityOverride();
 
-    if (region.disabled()) {
+    if (region.disabled() || !impl.acquirePooledObjects(region)) {
         impl.switchState(State::cleanMeUp);
         return false;
     }
@@ -435,6 +572,8 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
         delay = 0;
 
     impl.triggerDelay_ = delay;
+    impl.qualityReduction_ = resources.getSynthConfig().qualityReduction;
+    impl.powerFollower_.setStride(resources.getSynthConfig().powerFollowerStride);
     impl.initialDelay_ = delay + static_cast<int>(regionDelay(region, midiState) * impl.sampleRate_);
     impl.startTimestamp_ = midiState.getInternalClock() + impl.initialDelay_; // need to set this before switchState
 
@@ -442,31 +581,18 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
 
     impl.updateExtendedCCValues();
 
+    // do Scala retuning and reconvert the frequency into a 12TET key number
+    Tuning& tuning = resources.getTuning();
+    const float numberRetuned = tuning.getKeyFractional12TET(impl.triggerEvent_.number);
+
+    impl.pitchRatio_ = basePitchVariation(region, numberRetuned, impl.triggerEvent_.value, midiState, curveSet);
+
+    // apply stretch tuning if set, tabulated with the scale
+    impl.pitchRatio_ *= tuning.getStretchRatioOfKey(impl.triggerEvent_.number);
+
     if (region.isOscillator()) {
-        WavetablePool& wavePool = resources.getWavePool();
-        const WavetableMulti* wave = nullptr;
-        if (!region.isGenerator())
-            wave = wavePool.getFileWave(region.sampleId->filename());
-        else {
-            switch (hash(region.sampleId->filename())) {
-            default:
-            case hash("*silence"):
-                break;
-            case hash("*sine"):
-                wave = wavePool.getWaveSin();
-                break;
-            case hash("*triangle"): // fallthrough
-            case hash("*tri"):
-                wave = wavePool.getWaveTriangle();
-                break;
-            case hash("*square"):
-                wave = wavePool.getWaveSquare();
-                break;
-            case hash("*saw"):
-                wave = wavePool.getWaveSaw();
-                break;
-            }
-        }
+        // resolved on loading, or null for silence
+        const WavetableMulti* wave = region.wave;
         const float phase = region.getPhase();
         const int quality =
             region.oscillatorQuality.value_or(Default::oscillatorQuality);
@@ -475,55 +601,63 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
             osc.setPhase(phase);
             osc.setQuality(quality);
         }
-        impl.setupOscillatorUnison();
+        impl.setupOscillatorUnison(voiceTemplate);
     } else {
         FilePool& filePool = resources.getFilePool();
-        impl.currentPromise_ = filePool.getFilePromise(region.sampleId);
+        impl.sourcePosition_ = sampleOffset(region, midiState);
+        impl.currentPromise_ = filePool.getFilePromise(region.sampleId, region.sampleSlot, impl.sourcePosition_,
+            impl.pitchRatio_, impl.initialDelay_ / impl.sampleRate_);
         if (!impl.currentPromise_) {
             impl.switchState(State::cleanMeUp);
             return false;
         }
+        // The positions of the region are in the frames of the file
+        const double resampleRatio = impl.currentPromise_->information.resampleRatio;
+        if (resampleRatio != 1.0)
+            impl.sourcePosition_ = static_cast<int>(std::llround(impl.sourcePosition_ * resampleRatio));
+        // A sparse preload only holds the frames after the reachable offsets
+        impl.sourcePosition_ = static_cast<int>(impl.currentPromise_.startAt(impl.sourcePosition_));
         impl.updateLoopInformation();
         impl.speedRatio_ = static_cast<float>(impl.currentPromise_->information.sampleRate / impl.sampleRate_);
-        impl.sourcePosition_ = sampleOffset(region, midiState);
     }
 
-    // do Scala retuning and reconvert the frequency into a 12TET key number
-    Tuning& tuning = resources.getTuning();
-    const float numberRetuned = tuning.getKeyFractional12TET(impl.triggerEvent_.number);
-
-    impl.pitchRatio_ = basePitchVariation(region, numberRetuned, impl.triggerEvent_.value, midiState, curveSet);
-
-    // apply stretch tuning if set
-    if (absl::optional<StretchTuning>& stretch = resources.getStretch())
-        impl.pitchRatio_ *= stretch->getRatioForFractionalKey(numberRetuned);
-
     impl.pitchKeycenter_ = region.pitchKeycenter;
     impl.baseVolumedB_ = baseVolumedB(region, midiState, impl.triggerEvent_.number);
-    impl.baseGain_ = region.getBaseGain();
+    impl.baseGain_ = voiceTemplate.baseGain;
     if (impl.triggerEvent_.type != TriggerEventType::CC || region.velocityOverride == VelocityOverride::previous)
         impl.baseGain_ *= noteGain(region, impl.triggerEvent_.number, impl.triggerEvent_.value, midiState, curveSet);
 
     impl.gainSmoother_.reset();
     impl.resetCrossfades();
 
+    ModMatrix& modMatrix = resources.getModMatrix();
+    ASSERT(voiceTemplate.filterTargets.size() == region.filters.size());
+    ASSERT(voiceTemplate.equalizerTargets.size() == region.equalizers.size());
+
     for (unsigned i = 0; i < region.filters.size(); ++i) {
-        impl.filters_[i].setup(region, i, impl.triggerEvent_.number, impl.triggerEvent_.value);
+        const FilterHolder::Targets targets = (i < voiceTemplate.filterTargets.size()) ?
+            voiceTemplate.filterTargets[i] : FilterHolder::findTargets(modMatrix, region, i);
+        impl.filters_[i]->setup(region, i, targets, impl.triggerEvent_.number, impl.triggerEvent_.value);
     }
 
     for (unsigned i = 0; i < region.equalizers.size(); ++i) {
-        impl.equalizers_[i].setup(region, i, impl.triggerEvent_.value);
+        const EQHolder::Targets targets = (i < voiceTemplate.equalizerTargets.size()) ?
+            voiceTemplate.equalizerTargets[i] : EQHolder::findTargets(modMatrix, region, i);
+        impl.equalizers_[i]->setup(region, i, targets, impl.triggerEvent_.value);
     }
 
     impl.baseFrequency_ = tuning.getFrequencyOfKey(impl.triggerEvent_.number);
     impl.sampleEnd_ = int(sampleEnd(region, midiState));
+    if (impl.currentPromise_ && impl.currentPromise_->information.resampleRatio != 1.0) {
+        const FileInformation& info = impl.currentPromise_->information;
+        impl.sampleEnd_ = min(int(info.end), int(std::llround(impl.sampleEnd_ * info.resampleRatio)));
+    }
     impl.sampleSize_ = impl.sampleEnd_- impl.sourcePosition_ - 1;
     impl.bendSmoother_.setSmoothing(region.bendSmooth, impl.sampleRate_);
     impl.bendSmoother_.reset(region.getBendInCents(midiState.getPitchBend()));
 
-    ModMatrix& modMatrix = resources.getModMatrix();
     modMatrix.initVoice(impl.id_, region.getId(), impl.initialDelay_);
-    impl.saveModulationTargets(&region);
+    impl.saveModulationTargets(voiceTemplate);
 
     if (region.checkSustain) {
         const bool sustainPressed =
@@ -544,8 +678,11 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
 
 int Voice::Impl::getCurrentSampleQuality() const noexcept
 {
-    return (region_ && region_->sampleQuality) ?
-        *region_->sampleQuality : resources_.getSynthConfig().currentSampleQuality();
+    if (region_ && region_->sampleQuality)
+        return *region_->sampleQuality;
+
+    const int quality = resources_.getSynthConfig().currentSampleQuality();
+    return QualityGovernor::reduceSampleQuality(quality, qualityReduction_);
 }
 
 int Voice::getCurrentSampleQuality() const noexcept
@@ -556,8 +693,11 @@ int Voice::getCurrentSampleQuality() const noexcept
 
 int Voice::Impl::getCurrentOscillatorQuality() const noexcept
 {
-    return (region_ && region_->oscillatorQuality) ?
-        *region_->oscillatorQuality : resources_.getSynthConfig().currentOscillatorQuality();
+    if (region_ && region_->oscillatorQuality)
+        return *region_->oscillatorQuality;
+
+    const int quality = resources_.getSynthConfig().currentOscillatorQuality();
+    return QualityGovernor::reduceOscillatorQuality(quality, qualityReduction_);
 }
 
 int Voice::getCurrentOscillatorQuality() const noexcept
@@ -583,6 +723,10 @@ void Voice::Impl::release(int delay) noexcept
     if (state_ != State::playing)
         return;
 
+    // The sustained loop is left, so the file streams on past its end
+    if (region_->loopMode == LoopMode::loop_sustain && currentPromise_)
+        resources_.getFilePool().releaseStreamLimit(*currentPromise_);
+
     if (!region_->flexAmpEG) {
         if (egAmplitude_.getRemainingDelay() > delay)
             switchState(State::cleanMeUp);
@@ -617,6 +761,7 @@ void Voice::Impl::off(int delay, bool fast) noexcept
     }
 
     offed_ = true;
+    updatePlaying();
     release(delay);
 }
 
@@ -697,37 +842,6 @@ void Voice::registerCC(int delay, int ccNumber, float ccValue) noexcept
     }
 }
 
-void Voice::registerPitchWheel(int delay, float pitch) noexcept
-{
-    Impl& impl = *impl_;
-    if (impl.state_ != State::playing)
-        return;
-    UNUSED(delay);
-    UNUSED(pitch);
-}
-
-void Voice::registerAftertouch(int delay, float aftertouch) noexcept
-{
-    // TODO
-    UNUSED(delay);
-    UNUSED(aftertouch);
-}
-
-void Voice::registerPolyAftertouch(int delay, int noteNumber, float aftertouch) noexcept
-{
-    Impl& impl = *impl_;
-    if (impl.state_ != State::playing)
-        return;
-
-    if (!(impl.triggerEvent_.type == TriggerEventType::NoteOn || impl.triggerEvent_.type == TriggerEventType::NoteOff)
-        || impl.triggerEvent_.number != noteNumber)
-        return;
-
-    // TODO
-    UNUSED(delay);
-    UNUSED(aftertouch);
-}
-
 void Voice::registerTempo(int delay, float secondsPerQuarter) noexcept
 {
     // TODO
@@ -745,11 +859,6 @@ void Voice::setSampleRate(float sampleRate) noexcept
     for (WavetableOscillator& osc : impl.waveOscillators_)
         osc.init(sampleRate);
 
-    for (auto& eg : impl.flexEGs_)
-        eg->setSampleRate(sampleRate);
-
-    for (auto& lfo : impl.lfos_)
-        lfo->setSampleRate(sampleRate);
     if (auto* lfo = impl.lfoAmplitude_.get())
         lfo->setSampleRate(sampleRate);
     if (auto* lfo = impl.lfoPitch_.get())
@@ -757,12 +866,6 @@ void Voice::setSampleRate(float sampleRate) noexcept
     if (auto* lfo = impl.lfoFilter_.get())
         lfo->setSampleRate(sampleRate);
 
-    for (auto& filter : impl.filters_)
-        filter.setSampleRate(sampleRate);
-
-    for (auto& eq : impl.equalizers_)
-        eq.setSampleRate(sampleRate);
-
     impl.powerFollower_.setSampleRate(sampleRate);
 }
 
@@ -776,59 +879,162 @@ void Voice::setSamplesPerBlock(int samplesPerBlock) noexcept
 void Voice::renderBlock(AudioSpan<float, 2> buffer) noexcept
 {
     Impl& impl = *impl_;
-    ASSERT(static_cast<int>(buffer.getNumFrames()) <= impl.samplesPerBlock_);
-    buffer.fill(0.0f);
+    if (!(impl.*impl.renderStages_)(buffer))
+        return;
 
-    const Region* region = impl.region_;
-    if (region == nullptr || region->disabled())
+    if (impl.outputGain_ != 1.0f)
+        buffer.applyGain(impl.outputGain_);
+    impl.outputGain_ = 1.0f;
+
+    impl.endBlock(buffer);
+
+#if 0
+    ASSERT(!hasNanInf(buffer.getConstSpan(0)));
+    ASSERT(!hasNanInf(buffer.getConstSpan(1)));
+    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(0)));
+    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(1)));
+#endif
+}
+
+void Voice::renderBlock(AudioSpan<float, 2> buffer, AudioSpan<float, 2> destination, float gain) noexcept
+{
+    Impl& impl = *impl_;
+    ASSERT(destination.getNumFrames() == buffer.getNumFrames());
+    if (!(impl.*impl.renderStages_)(buffer))
         return;
 
-    const auto delay = min(static_cast<size_t>(impl.initialDelay_), buffer.getNumFrames());
+    // The output gain of the stages goes with the mix
+    const float mixGain = gain * impl.outputGain_;
+    if (mixGain != 0.0f)
+        destination.multiplyAdd(buffer, mixGain);
+
+    impl.endBlock(buffer);
+}
+
+template <unsigned Features>
+bool Voice::Impl::renderStages(AudioSpan<float, 2> buffer) noexcept
+{
+    using VoiceTemplate = Layer::VoiceTemplate;
+
+    ASSERT(static_cast<int>(buffer.getNumFrames()) <= samplesPerBlock_);
+    buffer.fill(0.0f);
+    outputGain_ = 1.0f;
+
+    // A voice which failed to start has no modulation targets
+    const Region* region = region_;
+    if (region == nullptr || region->disabled() || state_ == State::cleanMeUp)
+        return false;
+
+    const auto delay = min(static_cast<size_t>(initialDelay_), buffer.getNumFrames());
     auto delayed_buffer = buffer.subspan(delay);
-    impl.initialDelay_ -= static_cast<int>(delay);
+    initialDelay_ -= static_cast<int>(delay);
+
+    // The first sample of the voice is in this block
+    const bool firstSample = startPending_ && delay < buffer.getNumFrames();
+    if (firstSample) {
+        startLatency_.renderDelay =
+            static_cast<double>(CycleClock::now() - startTicks_) * CycleClock::secondsPerTick();
+    }
+
+    // the stages after the data add up the durations of their tiles
+    if (!timingEnabled_)
+        dataDuration_ = 0.0;
+    amplitudeDuration_ = 0.0;
+    filterDuration_ = 0.0;
+    panningDuration_ = 0.0;
+
+    const size_t numFrames = buffer.getNumFrames();
+    auto gainSpan = resources_.getBufferPool().getBuffer(numFrames);
+    if (gainSpan)
+        amplitudeGain<Features>(*gainSpan);
+
+    // With a gain of zero over the block, such as a layer crossfaded out, the
+    // voice is dormant: the position, the envelopes and the modulations
+    // advance, but the voice renders nothing
+    const bool dormant = gainSpan && allWithin<float>(*gainSpan, 0.0f, 0.0f);
+    if (dormant && !dormant_) {
+        // the filters restart at rest, as they would after a silent input
+        IF_CONSTEXPR (Features & VoiceTemplate::renderFilters) {
+            for (unsigned i = 0; i < region->filters.size(); ++i)
+                filters_[i]->reset();
+        }
+        IF_CONSTEXPR (Features & VoiceTemplate::renderEqualizers) {
+            for (unsigned i = 0; i < region->equalizers.size(); ++i)
+                equalizers_[i]->reset();
+        }
+    }
+    dormant_ = dormant;
 
     { // Fill buffer with raw data
-        ScopedTiming logger { impl.dataDuration_ };
-        if (region->isOscillator())
-            impl.fillWithGenerator(delayed_buffer);
+        ScopedTiming logger { dataDuration_, ScopedTiming::Operation::replaceDuration, timingEnabled_ };
+        IF_CONSTEXPR (Features & VoiceTemplate::renderOscillator)
+            fillWithGenerator(delayed_buffer, dormant);
         else
-            impl.fillWithData(delayed_buffer);
+            fillWithData(delayed_buffer, dormant);
     }
 
-    if (region->isStereo()) {
-        impl.ampStageStereo(buffer);
-        impl.panStageStereo(buffer);
-        impl.filterStageStereo(buffer);
-    } else {
-        impl.ampStageMono(buffer);
-        impl.filterStageMono(buffer);
-        impl.panStageMono(buffer);
+    if (firstSample) {
+        startLatency_.hasSample = !(Features & VoiceTemplate::renderOscillator);
+        startLatency_.preloaded = startLatency_.hasSample && currentPromise_
+            && !currentPromise_.isStreaming() && !underran_;
+        startPending_ = false;
+        startMeasured_ = true;
     }
 
+    if (dormant)
+        return true;
+
+    // The other stages go through the block in tiles which stay in the cache,
+    // with the modulations of the frames of the tile
+    ModMatrix& mm = resources_.getModMatrix();
+    constexpr size_t tileSize { config::voiceTileSize };
+
+    for (size_t offset = 0; offset < numFrames; offset += tileSize) {
+        const size_t tileFrames = min(tileSize, numFrames - offset);
+        const AudioSpan<float> tile = AudioSpan<float>(buffer).subspan(offset, tileFrames);
+        mm.setFrameOffset(static_cast<unsigned>(offset));
+
+        // the pan stages set the same compensation in every tile
+        outputGain_ = 1.0f;
+
+        IF_CONSTEXPR (Features & VoiceTemplate::renderStereo) {
+            if (gainSpan)
+                ampStageStereo(tile, gainSpan->subspan(offset, tileFrames));
+            panStageStereo(tile);
+            filterStageStereo<Features>(tile);
+        } else {
+            if (gainSpan)
+                ampStageMono(tile, gainSpan->subspan(offset, tileFrames));
+            filterStageMono<Features>(tile);
+            panStageMono(tile);
+        }
+    }
+
+    mm.setFrameOffset(0);
+    return true;
+}
+
+void Voice::Impl::endBlock(AudioSpan<float, 2> buffer) noexcept
+{
+    const Region* region = region_;
     if (!region->flexAmpEG) {
-        if (!impl.egAmplitude_.isSmoothing())
-            impl.switchState(State::cleanMeUp);
+        if (!egAmplitude_.isSmoothing())
+            switchState(State::cleanMeUp);
     }
     else {
-        if (impl.flexEGs_[*region->flexAmpEG]->isFinished())
-            impl.switchState(State::cleanMeUp);
+        if (flexEGs_[*region->flexAmpEG]->isFinished())
+            switchState(State::cleanMeUp);
     }
 
-    impl.powerFollower_.process(buffer);
+    powerFollower_.process(buffer, outputGain_);
+    cullIfInaudible();
 
-    impl.age_ += buffer.getNumFrames();
-    if (impl.triggerDelay_) {
+    age_ += buffer.getNumFrames();
+    if (triggerDelay_) {
         // Should be OK but just in case;
-        impl.age_ = min(impl.age_ - *impl.triggerDelay_, 0);
-        impl.triggerDelay_ = absl::nullopt;
+        age_ = min(age_ - *triggerDelay_, 0);
+        triggerDelay_ = absl::nullopt;
     }
-
-#if 0
-    ASSERT(!hasNanInf(buffer.getConstSpan(0)));
-    ASSERT(!hasNanInf(buffer.getConstSpan(1)));
-    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(0)));
-    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(1)));
-#endif
 }
 
 void Voice::Impl::resetCrossfades() noexcept
@@ -853,9 +1059,24 @@ void Voice::Impl::resetCrossfades() noexcept
 
 void Voice::Impl::applyCrossfades(absl::Span<float> modulationSpan) noexcept
 {
+    // without crossfades, the smoother stays at unity
+    if (region_->crossfadeCCInRange.empty() && region_->crossfadeCCOutRange.empty())
+        return;
+
     const auto numSamples = modulationSpan.size();
     const auto xfCurve = region_->crossfadeCCCurve;
 
+    // Another voice of the region took the same trajectory in this cycle
+    Layer::SharedCrossfade& shared = layer_->sharedCrossfade_;
+    const uint64_t cycle = resources_.getModMatrix().getCycle();
+    const bool canShare = numSamples <= shared.gain.size();
+    if (canShare && shared.cycle == cycle && shared.numFrames == numSamples
+        && xfadeSmoother_.hasSameState(shared.before)) {
+        xfadeSmoother_ = shared.after;
+        applyGain<float>(absl::MakeConstSpan(shared.gain.data(), numSamples), modulationSpan);
+        return;
+    }
+
     MidiState& midiState = resources_.getMidiState();
     BufferPool& bufferPool = resources_.getBufferPool();
 
@@ -865,29 +1086,51 @@ void Voice::Impl::applyCrossfades(absl::Span<float> modulationSpan) noexcept
     if (!tempSpan || !xfadeSpan)
         return;
 
-    fill<float>(*xfadeSpan, 1.0f);
+    // The curves apply per event, not per frame. Constant controllers
+    // give a gain for the whole block, and only the moving ones an envelope.
+    float constantGain = 1.0f;
+    bool hasEnvelope = false;
+    auto addCrossfade = [&](const EventVector& events, auto&& lambda) {
+        if (events.size() == 1) {
+            constantGain *= lambda(events[0].value);
+        } else if (!hasEnvelope) {
+            linearEnvelope(events, *xfadeSpan, lambda);
+            hasEnvelope = true;
+        } else {
+            linearEnvelope(events, *tempSpan, lambda);
+            applyGain<float>(*tempSpan, *xfadeSpan);
+        }
+    };
 
-    bool canShortcut = true;
     for (const auto& mod : region_->crossfadeCCInRange) {
-        const auto& events = midiState.getCCEvents(mod.cc);
-        canShortcut &= (events.size() == 1);
-        linearEnvelope(events, *tempSpan, [&](float x) {
+        addCrossfade(midiState.getCCEvents(mod.cc), [&](float x) {
             return crossfadeIn(mod.data, x, xfCurve);
         });
-        applyGain<float>(*tempSpan, *xfadeSpan);
     }
 
     for (const auto& mod : region_->crossfadeCCOutRange) {
-        const auto& events = midiState.getCCEvents(mod.cc);
-        canShortcut &= (events.size() == 1);
-        linearEnvelope(events, *tempSpan, [&](float x) {
+        addCrossfade(midiState.getCCEvents(mod.cc), [&](float x) {
             return crossfadeOut(mod.data, x, xfCurve);
         });
-        applyGain<float>(*tempSpan, *xfadeSpan);
     }
 
+    const bool canShortcut = !hasEnvelope;
+    if (!hasEnvelope)
+        fill<float>(*xfadeSpan, constantGain);
+    else if (constantGain != 1.0f)
+        applyGain1<float>(constantGain, *xfadeSpan);
+
+    const Smoother before = xfadeSmoother_;
     xfadeSmoother_.process(*xfadeSpan, *xfadeSpan, canShortcut);
     applyGain<float>(*xfadeSpan, modulationSpan);
+
+    if (canShare) {
+        copy<float>(*xfadeSpan, absl::MakeSpan(shared.gain.data(), numSamples));
+        shared.cycle = cycle;
+        shared.numFrames = numSamples;
+        shared.before = before;
+        shared.after = xfadeSmoother_;
+    }
 }
 
 
@@ -902,61 +1145,58 @@ void Voice::Impl::amplitudeEnvelope(absl::Span<float> modulationSpan) noexcept
     ASSERT(ampegOut.data());
     copy(ampegOut, modulationSpan);
 
+    // Base amplitude and volume, in a single pass
+    applyGain1<float>(baseGain_ * db2mag(baseVolumedB_), modulationSpan);
+
     // Amplitude envelope
-    applyGain1<float>(baseGain_, modulationSpan);
-    if (float* mod = mm.getModulation(amplitudeTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            modulationSpan[i] *= mod[i];
+    bool constant;
+    if (float* mod = mm.getModulation(amplitudeTarget_, constant)) {
+        if (constant)
+            applyGain1<float>(mod[0], modulationSpan);
+        else
+            applyGain<float>(absl::MakeConstSpan(mod, numSamples), modulationSpan);
     }
 
     // Volume envelope
-    applyGain1<float>(db2mag(baseVolumedB_), modulationSpan);
-    if (float* mod = mm.getModulation(volumeTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            modulationSpan[i] *= db2mag(mod[i]);
+    if (float* mod = mm.getModulation(volumeTarget_, constant)) {
+        if (constant)
+            applyGain1<float>(db2mag(mod[0]), modulationSpan);
+        else if (auto tempSpan = resources_.getBufferPool().getBuffer(numSamples)) {
+            sfz::db2mag<float>(absl::MakeConstSpan(mod, numSamples), *tempSpan);
+            applyGain<float>(*tempSpan, modulationSpan);
+        }
     }
 
     // Smooth the gain transitions
     gainSmoother_.process(modulationSpan, modulationSpan);
 }
 
-void Voice::Impl::ampStageMono(AudioSpan<float> buffer) noexcept
+template <unsigned Features>
+void Voice::Impl::amplitudeGain(absl::Span<float> gainSpan) noexcept
 {
-    ScopedTiming logger { amplitudeDuration_ };
+    ScopedTiming logger { amplitudeDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
 
-    const auto numSamples = buffer.getNumFrames();
-    const auto leftBuffer = buffer.getSpan(0);
-
-    BufferPool& bufferPool = resources_.getBufferPool();
-
-    auto modulationSpan = bufferPool.getBuffer(numSamples);
-    if (!modulationSpan)
-        return;
-
-    amplitudeEnvelope(*modulationSpan);
-    applyCrossfades(*modulationSpan);
-    applyGain<float>(*modulationSpan, leftBuffer);
+    amplitudeEnvelope(gainSpan);
+    IF_CONSTEXPR (Features & Layer::VoiceTemplate::renderCrossfades)
+        applyCrossfades(gainSpan);
+    lastAmplitudeGain_ = gainSpan.empty() ? 0.0f : gainSpan.back();
 }
 
-void Voice::Impl::ampStageStereo(AudioSpan<float> buffer) noexcept
+void Voice::Impl::ampStageMono(AudioSpan<float> buffer, absl::Span<const float> gain) noexcept
 {
-    ScopedTiming logger { amplitudeDuration_ };
-
-    BufferPool& bufferPool = resources_.getBufferPool();
-
-    const auto numSamples = buffer.getNumFrames();
-    auto modulationSpan = bufferPool.getBuffer(numSamples);
-    if (!modulationSpan)
-        return;
+    ScopedTiming logger { amplitudeDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
+    applyGain<float>(gain, buffer.getSpan(0));
+}
 
-    amplitudeEnvelope(*modulationSpan);
-    applyCrossfades(*modulationSpan);
-    buffer.applyGain(*modulationSpan);
+void Voice::Impl::ampStageStereo(AudioSpan<float> buffer, absl::Span<const float> gain) noexcept
+{
+    ScopedTiming logger { amplitudeDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
+    buffer.applyGain(gain);
 }
 
 void Voice::Impl::panStageMono(AudioSpan<float> buffer) noexcept
 {
-    ScopedTiming logger { panningDuration_ };
+    ScopedTiming logger { panningDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
 
     const auto numSamples = buffer.getNumFrames();
     const auto leftBuffer = buffer.getSpan(0);
@@ -974,21 +1214,23 @@ void Voice::Impl::panStageMono(AudioSpan<float> buffer) noexcept
     copy<float>(leftBuffer, rightBuffer);
 
     // Apply panning
-    fill(*modulationSpan, region_->pan);
-    if (float* mod = mm.getModulation(panTarget_)) {
+    bool panConstant;
+    const float* panMod = mm.getModulation(panTarget_, panConstant);
+    fill(*modulationSpan, (panMod && panConstant) ? (region_->pan + panMod[0]) : region_->pan);
+    if (panMod && !panConstant) {
         for (size_t i = 0; i < numSamples; ++i)
-            (*modulationSpan)[i] += mod[i];
+            (*modulationSpan)[i] += panMod[i];
     }
     pan(*modulationSpan, leftBuffer, rightBuffer);
 
-    // add +3dB (10^(3/20)) to compensate for the pan stage (-3dB per stage)
-    applyGain1(1.4125375446227544f, leftBuffer);
-    applyGain1(1.4125375446227544f, rightBuffer);
+    // add +3dB (10^(3/20)) to compensate for the pan stage (-3dB per stage),
+    // along with the output of the voice
+    outputGain_ *= 1.4125375446227544f;
 }
 
 void Voice::Impl::panStageStereo(AudioSpan<float> buffer) noexcept
 {
-    ScopedTiming logger { panningDuration_ };
+    ScopedTiming logger { panningDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
     const auto numSamples = buffer.getNumFrames();
     const auto leftBuffer = buffer.getSpan(0);
     const auto rightBuffer = buffer.getSpan(1);
@@ -1001,53 +1243,82 @@ void Voice::Impl::panStageStereo(AudioSpan<float> buffer) noexcept
 
     ModMatrix& mm = resources_.getModMatrix();
 
-    // Apply panning
-    fill(*modulationSpan, region_->pan);
-    if (float* mod = mm.getModulation(panTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            (*modulationSpan)[i] += mod[i];
-    }
-    pan(*modulationSpan, leftBuffer, rightBuffer);
+    // Fill the envelope of a stage
+    auto fillEnvelope = [numSamples](absl::Span<float> envelope, float value, const float* mod, bool constant) {
+        fill(envelope, (mod && constant) ? (value + mod[0]) : value);
+        if (mod && !constant) {
+            for (size_t i = 0; i < numSamples; ++i)
+                envelope[i] += mod[i];
+        }
+    };
 
-    // Apply the width/position process
-    fill(*modulationSpan, region_->width);
-    if (float* mod = mm.getModulation(widthTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            (*modulationSpan)[i] += mod[i];
-    }
-    width(*modulationSpan, leftBuffer, rightBuffer);
+    bool panConstant;
+    bool widthConstant;
+    bool positionConstant;
+    const float* panMod = mm.getModulation(panTarget_, panConstant);
+    const float* widthMod = mm.getModulation(widthTarget_, widthConstant);
+    const float* positionMod = mm.getModulation(positionTarget_, positionConstant);
 
-    fill(*modulationSpan, region_->position);
-    if (float* mod = mm.getModulation(positionTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            (*modulationSpan)[i] += mod[i];
+    // add +6dB (10^(6/20)) to compensate for the 2 pan stages (-3dB per stage)
+    constexpr float panCompensation = 1.9952623149688797f;
+
+    // Constant width and position are applied in a single pass
+    if ((!widthMod || widthConstant) && (!positionMod || positionConstant)) {
+        fillEnvelope(*modulationSpan, region_->pan, panMod, panConstant);
+        pan(*modulationSpan, leftBuffer, rightBuffer);
+
+        const float widthValue = widthMod ? (region_->width + widthMod[0]) : region_->width;
+        const float positionValue = positionMod ? (region_->position + positionMod[0]) : region_->position;
+        widthAndPosition(widthValue, positionValue, panCompensation, leftBuffer, rightBuffer);
+        return;
     }
-    pan(*modulationSpan, leftBuffer, rightBuffer);
 
-    // add +6dB (10^(6/20)) to compensate for the 2 pan stages (-3dB per stage)
-    applyGain1(1.9952623149688797f, leftBuffer);
-    applyGain1(1.9952623149688797f, rightBuffer);
+    auto widthSpan = bufferPool.getBuffer(numSamples);
+    auto positionSpan = bufferPool.getBuffer(numSamples);
+    if (!widthSpan || !positionSpan)
+        return;
+
+    // Apply the pan, and the width/position process, in a single pass
+    fillEnvelope(*modulationSpan, region_->pan, panMod, panConstant);
+    fillEnvelope(*widthSpan, region_->width, widthMod, widthConstant);
+    fillEnvelope(*positionSpan, region_->position, positionMod, positionConstant);
+    panWidthPosition(*modulationSpan, *widthSpan, *positionSpan, leftBuffer, rightBuffer);
+
+    // The filters which come next are linear, the compensation goes along
+    // with the output of the voice
+    outputGain_ *= panCompensation;
 }
 
+template <unsigned Features>
 void Voice::Impl::filterStageMono(AudioSpan<float> buffer) noexcept
 {
-    ScopedTiming logger { filterDuration_ };
+    IF_CONSTEXPR (!(Features & (Layer::VoiceTemplate::renderFilters | Layer::VoiceTemplate::renderEqualizers)))
+        return;
+
+    ScopedTiming logger { filterDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
     const auto numSamples = buffer.getNumFrames();
     const auto leftBuffer = buffer.getSpan(0);
     const float* inputChannel[1] { leftBuffer.data() };
     float* outputChannel[1] { leftBuffer.data() };
-    for (unsigned i = 0; i < region_->filters.size(); ++i) {
-        filters_[i].process(inputChannel, outputChannel, numSamples);
+    IF_CONSTEXPR (Features & Layer::VoiceTemplate::renderFilters) {
+        for (unsigned i = 0; i < region_->filters.size(); ++i) {
+            filters_[i]->process(inputChannel, outputChannel, numSamples);
+        }
     }
 
-    for (unsigned i = 0; i < region_->equalizers.size(); ++i) {
-        equalizers_[i].process(inputChannel, outputChannel, numSamples);
+    IF_CONSTEXPR (Features & Layer::VoiceTemplate::renderEqualizers) {
+        const auto numEqs = static_cast<unsigned>(region_->equalizers.size());
+        EQHolder::processCascade(equalizers_.data(), numEqs, inputChannel, outputChannel, numSamples);
     }
 }
 
+template <unsigned Features>
 void Voice::Impl::filterStageStereo(AudioSpan<float> buffer) noexcept
 {
-    ScopedTiming logger { filterDuration_ };
+    IF_CONSTEXPR (!(Features & (Layer::VoiceTemplate::renderFilters | Layer::VoiceTemplate::renderEqualizers)))
+        return;
+
+    ScopedTiming logger { filterDuration_, ScopedTiming::Operation::addToDuration, timingEnabled_ };
     const auto numSamples = buffer.getNumFrames();
     const auto leftBuffer = buffer.getSpan(0);
     const auto rightBuffer = buffer.getSpan(1);
@@ -1055,16 +1326,22 @@ void Voice::Impl::filterStageStereo(AudioSpan<float> buffer) noexcept
     const float* inputChannels[2] { leftBuffer.data(), rightBuffer.data() };
     float* outputChannels[2] { leftBuffer.data(), rightBuffer.data() };
 
-    for (unsigned i = 0; i < region_->filters.size(); ++i) {
-        filters_[i].process(inputChannels, outputChannels, numSamples);
+    IF_CONSTEXPR (Features & Layer::VoiceTemplate::renderFilters) {
+        for (unsigned i = 0; i < region_->filters.size(); ++i) {
+            filters_[i]->process(inputChannels, outputChannels, numSamples);
+        }
     }
 
-    for (unsigned i = 0; i < region_->equalizers.size(); ++i) {
-        equalizers_[i].process(inputChannels, outputChannels, numSamples);
+    IF_CONSTEXPR (Features & Layer::VoiceTemplate::renderEqualizers) {
+        const auto numEqs = static_cast<unsigned>(region_->equalizers.size());
+        EQHolder::processCascade(equalizers_.data(), numEqs, inputChannels, outputChannels, numSamples);
     }
 }
 
-void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
+const std::array<Voice::Impl::RenderStages, Layer::VoiceTemplate::numRenderVariants> Voice::Impl::renderVariants_ =
+    Voice::Impl::makeRenderVariants(std::make_index_sequence<Layer::VoiceTemplate::numRenderVariants>());
+
+void Voice::Impl::fillWithData(AudioSpan<float> buffer, bool dormant) noexcept
 {
     const size_t numSamples = buffer.getNumFrames();
     if (numSamples == 0)
@@ -1075,8 +1352,11 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         return;
     }
 
-    auto source = currentPromise_->getData();
-    if (source.getNumFrames() == 0) {
+    // Only one of the sources is set
+    const auto source = currentPromise_.getData();
+    const auto compactSource = currentPromise_.getCompactData();
+    const size_t sourceFrames = max(source.getNumFrames(), compactSource.getNumFrames());
+    if (sourceFrames == 0) {
         DBG("[Voice] Empty source in promise");
         return;
     }
@@ -1091,34 +1371,72 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
     auto indices = bufferPool.getIndexBuffer(numSamples);
     if (!indices || !coeffs)
         return;
+
+    // the step between source frames, if the positions are integral and
+    // advance at a constant 1:1 or 2:1 ratio, otherwise 0
+    int sourceStep = 0;
+    uint32_t lastFraction = 0;
+    // the reversed files which are held whole read the forward data backward
+    const bool mirrored = currentPromise_.isMirrored();
+    const int lastFrame = static_cast<int>(currentPromise_->information.end);
+    SpanHolder<absl::Span<int>> mirroredIndices;
+    SpanHolder<absl::Span<float>> mirroredCoeffs;
+    if (mirrored) {
+        mirroredIndices = bufferPool.getIndexBuffer(numSamples);
+        mirroredCoeffs = bufferPool.getBuffer(numSamples);
+        if (!mirroredIndices || !mirroredCoeffs)
+            return;
+    }
+    // the range of the playback ratios over the block, for the adaptive quality
+    const bool adaptiveQuality = resources_.getSynthConfig().adaptiveSampleQuality;
+    float minRatio = 1.0f;
+    float maxRatio = 1.0f;
     {
-        auto jumps = bufferPool.getBuffer(numSamples);
-        if (!jumps)
+        auto pitchBuffer = bufferPool.getBuffer(numSamples);
+        if (!pitchBuffer)
             return;
 
-        absl::Span<float> pitch = *jumps; // temporary
+        absl::Span<float> pitch = *pitchBuffer;
         pitchEnvelope(pitch);
 
-        float baseRatio = pitchRatio_ * speedRatio_;
-        for (size_t i = 0; i < numSamples; ++i)
-            (*jumps)[i] = baseRatio * centsFactor(pitch[i]);
-
-        // Take the first sample if the voice just started
-        if (age_ == 0)
-            jumps->front() = 0.0f;
+        const float baseRatio = pitchRatio_ * speedRatio_;
+        const float firstPitch = pitch.front();
+        const bool constantPitch = allWithin<float>(pitch, firstPitch, firstPitch);
+        const float ratio = baseRatio * centsFactor(firstPitch);
+
+        // The position of the last frame played, in 32.32 fixed point; take
+        // the first sample if the voice just started
+        const int64_t position = (static_cast<int64_t>(sourcePosition_) << 32) + positionFraction_;
+        const int64_t start = (age_ == 0) ? position : position + fixedPosition(ratio);
+
+        const int64_t last = constantPitch ?
+            interpolationPositions<float>(ratio, start, *indices, *coeffs) :
+            interpolationPositions<float>(pitch, baseRatio, start, *indices, *coeffs);
+        lastFraction = static_cast<uint32_t>(last);
+
+        if (adaptiveQuality && constantPitch)
+            minRatio = maxRatio = ratio;
+        else if (adaptiveQuality) {
+            const auto range = absl::c_minmax_element(pitch);
+            minRatio = baseRatio * centsFactor(*range.first);
+            maxRatio = baseRatio * centsFactor(*range.second);
+        }
 
-        jumps->front() += floatPositionOffset_;
-        cumsum<float>(*jumps, *jumps);
-        sfzInterpolationCast<float>(*jumps, *indices, *coeffs);
-        add1<int>(sourcePosition_, *indices);
+        // The positions are exact multiples of the ratio
+        if (constantPitch && (ratio == 1.0f || ratio == 2.0f) && static_cast<uint32_t>(start) == 0 && !mirrored)
+            sourceStep = static_cast<int>(ratio);
     }
 
     // Update loop characteristics with the current CC state
     updateLoopInformation();
     const auto loop = this->loop_;
+    if (region_->shouldLoop())
+        currentPromise_.updatePlayback(sourcePosition_, loop.xfInStart, loop.end + 1);
+    else
+        currentPromise_.updatePlayback(sourcePosition_, 0, 0);
 
     // Looping logic
-    const bool hasLoopSamples = static_cast<size_t>(loop.end) < source.getNumFrames();
+    const bool hasLoopSamples = static_cast<size_t>(loop.end) < sourceFrames;
     const bool loopCountReached = region_->loopCount && loop_.restarts >= *region_->loopCount;
     const bool loopContinuous = (region_->loopMode == LoopMode::loop_continuous);
     const bool loopSustain = (region_->loopMode == LoopMode::loop_sustain) && !released();
@@ -1162,7 +1480,9 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         numPartitions = 1;
     }
 
-    const auto sampleEnd = min( int(sampleEnd_), int(currentPromise_->information.end), int(source.getNumFrames())) - 1;
+    const auto sampleEnd = min( int(sampleEnd_), int(currentPromise_->information.end), int(sourceFrames)) - 1;
+    // Reaching the end of the source before the end of the sample is an underrun
+    const bool sourceShort = int(sourceFrames) < min(int(sampleEnd_), int(currentPromise_->information.end));
 
     int blockRestarts { 0 };
     int oldIndex {};
@@ -1219,6 +1539,17 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
             (*indices)[i] -= sampleSize_ * blockRestarts;
 
             if ((*indices)[i] >= sampleEnd) {
+                if (sourceShort) {
+                    if (!underran_) {
+                        resources_.getFilePool().reportUnderrun(region_->getId().number(), numSamples - i);
+                        underran_ = true;
+                    }
+                    off(int(i), true);
+                    fill<int>(indices->subspan(i), sampleEnd);
+                    fill<float>(coeffs->subspan(i), 0x1.fffffep-1);
+                    break;
+                }
+
                 if (region_->sampleCount && count_ < *region_->sampleCount && !region_->shouldLoop()) {
                     (*indices)[i] -= sampleSize_;
                     blockRestarts += 1;
@@ -1235,7 +1566,11 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
     }
 
     // interpolation processing
-    const int quality = getCurrentSampleQuality();
+    int quality = getCurrentSampleQuality();
+    if (adaptiveQuality)
+        quality = QualityGovernor::adaptSampleQuality(quality, minRatio, maxRatio);
+    if (dormant)
+        numPartitions = 0;
 
     for (unsigned ptNo = 0; ptNo < numPartitions; ++ptNo) {
         // current partition
@@ -1249,8 +1584,26 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         absl::Span<const int> ptIndices = indices->subspan(ptStart, ptSize);
         absl::Span<const float> ptCoeffs = coeffs->subspan(ptStart, ptSize);
 
-        fillInterpolatedWithQuality<false>(
-            source, ptBuffer, ptIndices, ptCoeffs, {}, quality);
+        // the positions read in the source
+        absl::Span<const int> readIndices = ptIndices;
+        absl::Span<const float> readCoeffs = ptCoeffs;
+        if (mirrored) {
+            absl::Span<int> forwardIndices = mirroredIndices->subspan(ptStart, ptSize);
+            absl::Span<float> forwardCoeffs = mirroredCoeffs->subspan(ptStart, ptSize);
+            mirrorPositions(ptIndices, ptCoeffs, lastFrame, forwardIndices, forwardCoeffs);
+            readIndices = forwardIndices;
+            readCoeffs = forwardCoeffs;
+        }
+
+        if (compactSource.getNumFrames() > 0) {
+            if (!sourceStep || !fillStepped(compactSource, ptBuffer, readIndices, readCoeffs, sourceStep))
+                fillInterpolatedWithQuality<false>(
+                    compactSource, ptBuffer, readIndices, readCoeffs, {}, quality);
+        } else {
+            if (!sourceStep || !fillStepped(source, ptBuffer, readIndices, readCoeffs, sourceStep))
+                fillInterpolatedWithQuality<false>(
+                    source, ptBuffer, readIndices, readCoeffs, {}, quality);
+        }
 
         if (ptType == kPartitionLoopXfade) {
             auto xfTemp1 = bufferPool.getBuffer(numSamples);
@@ -1276,12 +1629,12 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
                 IF_CONSTEXPR (config::loopXfadeCurve == 2) {
                     const Curve& xfIn = getSCurve();
                     for (unsigned i = 0; i < ptSize; ++i)
-                        xfCurve[i] = xfIn.evalNormalized(1.0f - xfCurvePos[i]);
+                        xfCurve[i] = 1.0f - xfCurvePos[i];
+                    xfIn.evalSpan(xfCurve, xfCurve);
                 }
                 else IF_CONSTEXPR (config::loopXfadeCurve == 1) {
                     const Curve& xfOut = curves.getCurve(6);
-                    for (unsigned i = 0; i < ptSize; ++i)
-                        xfCurve[i] = xfOut.evalNormalized(xfCurvePos[i]);
+                    xfOut.evalSpan(xfCurvePos, xfCurve);
                 }
                 else IF_CONSTEXPR (config::loopXfadeCurve == 0) {
                     // TODO(jpc) vectorize this
@@ -1316,6 +1669,14 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
                 // offset the indices and coeffs
                 xfInIndices = xfInIndices.subspan(applyOffset);
                 absl::Span<const float> xfInCoeffs = ptCoeffs.subspan(applyOffset);
+                // the main fill is done, so its mirrored positions are overwritten
+                if (mirrored) {
+                    absl::Span<int> forwardIndices = mirroredIndices->subspan(ptStart + applyOffset, applySize);
+                    absl::Span<float> forwardCoeffs = mirroredCoeffs->subspan(ptStart + applyOffset, applySize);
+                    mirrorPositions(xfInIndices, xfInCoeffs, lastFrame, forwardIndices, forwardCoeffs);
+                    xfInIndices = forwardIndices;
+                    xfInCoeffs = forwardCoeffs;
+                }
                 // offset the curve positions
                 absl::Span<float> xfInCurvePos = xfCurvePos.subspan(applyOffset);
                 // offset the output buffer
@@ -1325,13 +1686,11 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
                 absl::Span<float> xfCurve = xfTemp2->first(applySize);
                 IF_CONSTEXPR (config::loopXfadeCurve == 2) {
                     const Curve& xfIn = getSCurve();
-                    for (unsigned i = 0; i < applySize; ++i)
-                        xfCurve[i] = xfIn.evalNormalized(xfInCurvePos[i]);
+                    xfIn.evalSpan(xfInCurvePos, xfCurve);
                 }
                 else IF_CONSTEXPR (config::loopXfadeCurve == 1) {
                     const Curve& xfIn = curves.getCurve(5);
-                    for (unsigned i = 0; i < applySize; ++i)
-                        xfCurve[i] = xfIn.evalNormalized(xfInCurvePos[i]);
+                    xfIn.evalSpan(xfInCurvePos, xfCurve);
                 }
                 else IF_CONSTEXPR (config::loopXfadeCurve == 0) {
                     // TODO(jpc) vectorize this
@@ -1339,14 +1698,18 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
                         xfCurve[i] = clamp(xfInCurvePos[i], 0.0f, 1.0f);
                 }
                 // apply in curve
-                fillInterpolatedWithQuality<true>(
-                    source, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
+                if (compactSource.getNumFrames() > 0)
+                    fillInterpolatedWithQuality<true>(
+                        compactSource, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
+                else
+                    fillInterpolatedWithQuality<true>(
+                        source, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
             }
         }
     }
 
     sourcePosition_ = indices->back();
-    floatPositionOffset_ = coeffs->back();
+    positionFraction_ = lastFraction;
 
 #if 1
     ASSERT(!hasNanInf(buffer.getConstSpan(0)));
@@ -1367,6 +1730,17 @@ void Voice::Impl::fillInterpolated(
     auto* addingGain = addingGains.data();
     auto leftSource = source.getConstSpan(0);
     auto left = dest.getChannel(0);
+
+    IF_CONSTEXPR(M >= kInterpolatorSinc8) {
+        const bool stereo = source.getNumChannels() > 1;
+        const float* sources[2] { leftSource.data(), stereo ? source.getConstSpan(1).data() : nullptr };
+        float* outputs[2] { left, stereo ? dest.getChannel(1) : nullptr };
+        if (interpolateSincBlock(
+                M, sources, outputs, stereo ? 2 : 1, ind, coeff,
+                Adding ? addingGain : nullptr, indices.size()))
+            return;
+    }
+
     if (source.getNumChannels() == 1) {
         while (ind < indices.end()) {
             auto output = interpolate<M>(&leftSource[*ind], *coeff);
@@ -1382,8 +1756,9 @@ void Voice::Impl::fillInterpolated(
         auto right = dest.getChannel(1);
         auto rightSource = source.getConstSpan(1);
         while (ind < indices.end()) {
-            auto leftOutput = interpolate<M>(&leftSource[*ind], *coeff);
-            auto rightOutput = interpolate<M>(&rightSource[*ind], *coeff);
+            float leftOutput;
+            float rightOutput;
+            interpolateStereo<M>(&leftSource[*ind], &rightSource[*ind], *coeff, leftOutput, rightOutput);
             IF_CONSTEXPR(Adding) {
                 float g = *addingGain++;
                 *left += g * leftOutput;
@@ -1398,9 +1773,108 @@ void Voice::Impl::fillInterpolated(
     }
 }
 
-template <bool Adding>
+template <InterpolatorModel M, bool Adding>
+void Voice::Impl::fillInterpolated(
+    const AudioSpan<const int16_t>& source, const AudioSpan<float>& dest,
+    absl::Span<const int> indices, absl::Span<const float> coeffs,
+    absl::Span<const float> addingGains)
+{
+    // The runs cover increasing indices within a span of runFrames, and the
+    // conversion adds the padding of the file buffers on each side, which
+    // is wider than the interpolation windows.
+    constexpr int runFrames { config::compactConversionFrames };
+    constexpr int padding { config::excessFileFrames };
+    constexpr float scale { 1.0f / 32768.0f };
+    float converted[2][runFrames + 2 * padding];
+    int runIndices[runFrames];
+
+    const size_t numChannels = source.getNumChannels();
+    const size_t numIndices = indices.size();
+    size_t runStart = 0;
+    while (runStart < numIndices) {
+        const int firstIndex = indices[runStart];
+        int lastIndex = firstIndex;
+        size_t runEnd = runStart + 1;
+        while (runEnd < numIndices && runEnd - runStart < static_cast<size_t>(runFrames)) {
+            const int index = indices[runEnd];
+            if (index < lastIndex || index - firstIndex >= runFrames)
+                break;
+            lastIndex = index;
+            ++runEnd;
+        }
+
+        const int numConverted = lastIndex - firstIndex + 1 + 2 * padding;
+        for (size_t c = 0; c < numChannels; ++c) {
+            const int16_t* input = source.getConstSpan(c).data() + firstIndex - padding;
+            for (int i = 0; i < numConverted; ++i)
+                converted[c][i] = scale * input[i];
+        }
+
+        const size_t runSize = runEnd - runStart;
+        for (size_t i = 0; i < runSize; ++i)
+            runIndices[i] = indices[runStart + i] - firstIndex + padding;
+
+        const float* channels[2] { converted[0], converted[1] };
+        const AudioSpan<const float> runSource(channels, numChannels, 0, static_cast<size_t>(numConverted));
+        fillInterpolated<M, Adding>(
+            runSource, dest.subspan(runStart, runSize), absl::MakeConstSpan(runIndices, runSize),
+            coeffs.subspan(runStart, runSize), Adding ? addingGains.subspan(runStart, runSize) : addingGains);
+        runStart = runEnd;
+    }
+}
+
+template <class T>
+bool Voice::Impl::fillStepped(
+    const AudioSpan<const T>& source, const AudioSpan<float>& dest,
+    absl::Span<const int> indices, absl::Span<const float> coeffs, int step)
+{
+    const size_t numFrames = indices.size();
+    if (numFrames == 0)
+        return true;
+
+    // The loop and end handling may break the regularity of the positions
+    if (!allWithin<float>(coeffs, 0.0f, 0.0f))
+        return false;
+
+    const int firstIndex = indices.front();
+    for (size_t i = 1; i < numFrames; ++i) {
+        if (indices[i] != firstIndex + step * static_cast<int>(i))
+            return false;
+    }
+
+    constexpr float scale = std::is_same<T, int16_t>::value ? (1.0f / 32768.0f) : 1.0f;
+    const size_t numChannels = source.getNumChannels();
+    for (size_t c = 0; c < numChannels; ++c) {
+        const T* input = source.getConstSpan(c).data() + firstIndex;
+        float* output = dest.getChannel(c);
+        if (step == 1) {
+            for (size_t i = 0; i < numFrames; ++i)
+                output[i] = scale * static_cast<float>(input[i]);
+        } else {
+            for (size_t i = 0; i < numFrames; ++i)
+                output[i] = scale * static_cast<float>(input[step * i]);
+        }
+    }
+
+    return true;
+}
+
+void Voice::Impl::mirrorPositions(
+    absl::Span<const int> indices, absl::Span<const float> coeffs, int lastFrame,
+    absl::Span<int> mirroredIndices, absl::Span<float> mirroredCoeffs) noexcept
+{
+    // The frame i + f of the reversed file is the frame last - i - f of the
+    // forward file, and the interpolation kernels are symmetric in time
+    for (size_t i = 0, n = indices.size(); i < n; ++i) {
+        const bool fractional = coeffs[i] > 0.0f;
+        mirroredIndices[i] = lastFrame - indices[i] - (fractional ? 1 : 0);
+        mirroredCoeffs[i] = fractional ? (1.0f - coeffs[i]) : 0.0f;
+    }
+}
+
+template <bool Adding, class T>
 void Voice::Impl::fillInterpolatedWithQuality(
-    const AudioSpan<const float>& source, const AudioSpan<float>& dest,
+    const AudioSpan<const T>& source, const AudioSpan<float>& dest,
     absl::Span<const int> indices, absl::Span<const float> coeffs,
     absl::Span<const float> addingGains, int quality)
 {
@@ -1494,11 +1968,16 @@ const Curve& Voice::Impl::getSCurve()
     return curve;
 }
 
-void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer) noexcept
+void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer, bool dormant) noexcept
 {
     const auto leftSpan = buffer.getSpan(0);
     const auto rightSpan  = buffer.getSpan(1);
 
+    const bool noise = region_->sampleId->filename() == "*noise"
+        || region_->sampleId->filename() == "*gnoise";
+    if (dormant && noise)
+        return;
+
     if (region_->sampleId->filename() == "*noise") {
         auto gen = [&]() {
             return uniformNoiseDist_(Random::randomGenerator);
@@ -1530,8 +2009,8 @@ void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer) noexcept
         const float keycenterFrequency = midiNoteFrequency(pitchKeycenter_);
         const float baseRatio = pitchRatio_ * keycenterFrequency;
 
-        for (size_t i = 0; i < numFrames; ++i)
-            (*frequencies)[i] = baseRatio * centsFactor(pitch[i]);
+        centsFactor<float>(pitch, *frequencies);
+        applyGain1(baseRatio, *frequencies);
 
         auto detuneSpan = bufferPool.getBuffer(numFrames);
         if (!detuneSpan)
@@ -1548,6 +2027,11 @@ void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer) noexcept
                 return;
 
             WavetableOscillator& osc = waveOscillators_[0];
+            if (dormant) {
+                osc.advance(frequencies->data(), 1.0f, nullptr, numFrames);
+                return;
+            }
+
             osc.setQuality(quality);
             fill(*detuneSpan, 1.0f);
             osc.processModulated(frequencies->data(), detuneSpan->data(), tempSpan->data(), buffer.getNumFrames());
@@ -1556,36 +2040,30 @@ void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer) noexcept
         }
         else if (oscillatorMode <= 0 && oscillatorMulti >= 3) {
             // unison oscillator
-            auto tempSpan = bufferPool.getBuffer(numFrames);
-            auto tempLeftSpan = bufferPool.getBuffer(numFrames);
-            auto tempRightSpan = bufferPool.getBuffer(numFrames);
-            if (!tempSpan || !tempLeftSpan || !tempRightSpan)
+            const float* detuneMod = modMatrix.getModulation(oscillatorDetuneTarget_);
+            if (detuneMod) {
+                centsFactor<float>(absl::MakeConstSpan(detuneMod, numFrames), *detuneSpan);
+            }
+
+            if (dormant) {
+                for (unsigned u = 0, uSize = waveUnisonSize_; u < uSize; ++u) {
+                    waveOscillators_[u].advance(frequencies->data(), waveDetuneRatio_[u],
+                        detuneMod ? detuneSpan->data() : nullptr, numFrames);
+                }
                 return;
+            }
 
-            const float* detuneMod = modMatrix.getModulation(oscillatorDetuneTarget_);
+            WavetableOscillator* oscillators[config::oscillatorsPerVoice];
             for (unsigned u = 0, uSize = waveUnisonSize_; u < uSize; ++u) {
-                WavetableOscillator& osc = waveOscillators_[u];
-                osc.setQuality(quality);
-                if (!detuneMod)
-                    fill(*detuneSpan, waveDetuneRatio_[u]);
-                else {
-                    for (size_t i = 0; i < numFrames; ++i)
-                        (*detuneSpan)[i] = centsFactor(detuneMod[i]);
-                    applyGain1(waveDetuneRatio_[u], *detuneSpan);
-                }
-                osc.processModulated(frequencies->data(), detuneSpan->data(), tempSpan->data(), numFrames);
-                if (u == 0) {
-                    applyGain1<float>(waveLeftGain_[u], *tempSpan, *tempLeftSpan);
-                    applyGain1<float>(waveRightGain_[u], *tempSpan, *tempRightSpan);
-                }
-                else {
-                    multiplyAdd1<float>(waveLeftGain_[u], *tempSpan, *tempLeftSpan);
-                    multiplyAdd1<float>(waveRightGain_[u], *tempSpan, *tempRightSpan);
-                }
+                oscillators[u] = &waveOscillators_[u];
+                oscillators[u]->setQuality(quality);
             }
 
-            copy<float>(*tempLeftSpan, leftSpan);
-            copy<float>(*tempRightSpan, rightSpan);
+            WavetableOscillator::processUnison(
+                oscillators, waveUnisonSize_, frequencies->data(),
+                waveDetuneRatio_, detuneMod ? detuneSpan->data() : nullptr,
+                waveLeftGain_, waveRightGain_,
+                leftSpan.data(), rightSpan.data(), numFrames);
         }
         else {
             // modulated oscillator
@@ -1607,11 +2085,18 @@ void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer) noexcept
             if (!detuneMod)
                 fill(*detuneSpan, waveDetuneRatio_[1]);
             else {
-                for (size_t i = 0; i < numFrames; ++i)
-                    (*detuneSpan)[i] = centsFactor(detuneMod[i]);
+                centsFactor<float>(absl::MakeConstSpan(detuneMod, numFrames), *detuneSpan);
                 applyGain1(waveDetuneRatio_[1], *detuneSpan);
             }
 
+            // the ring modulation leaves the phase of the carrier to its
+            // frequency, but the frequency modulation needs the modulator
+            if (dormant && region_->oscillatorMode != 1 && region_->oscillatorMode != 2) {
+                oscMod.advance(frequencies->data(), 1.0f, detuneSpan->data(), numFrames);
+                oscCar.advance(frequencies->data(), 1.0f, nullptr, numFrames);
+                return;
+            }
+
             oscMod.processModulated(frequencies->data(), detuneSpan->data(), modulatorSpan->data(), numFrames);
 
             // scale the modulator
@@ -1640,6 +2125,10 @@ void Voice::Impl::fillWithGenerator(AudioSpan<float> buffer) noexcept
             fm_synthesis:
                 fill(*detuneSpan, 1.0f);
                 multiplyAdd<float>(*modulatorSpan, *frequencies, *frequencies);
+                if (dormant) {
+                    oscCar.advance(frequencies->data(), 1.0f, nullptr, numFrames);
+                    return;
+                }
                 oscCar.processModulated(frequencies->data(), detuneSpan->data(), tempSpan->data(), buffer.getNumFrames());
                 break;
             }
@@ -1675,6 +2164,39 @@ bool Voice::Impl::released() const noexcept
         return flexEGs_[*region_->flexAmpEG]->isReleased();
 }
 
+void Voice::Impl::cullIfInaudible() noexcept
+{
+    const SynthConfig& synthConfig = resources_.getSynthConfig();
+    if (!synthConfig.voiceCullingEnabled() || state_ != State::playing || !released()) {
+        inaudibleBlocks_ = 0;
+        return;
+    }
+
+    const float thresholdGain = db2mag(synthConfig.voiceCullingThreshold);
+    const float thresholdPower = thresholdGain * thresholdGain;
+    if (std::abs(lastAmplitudeGain_) >= thresholdGain || powerFollower_.getAveragePower() >= thresholdPower) {
+        inaudibleBlocks_ = 0;
+        return;
+    }
+
+    if (++inaudibleBlocks_ >= config::voiceCullingBlocks) {
+        culled_ = true;
+        switchState(State::cleanMeUp);
+    }
+}
+
+bool Voice::isDormant() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.dormant_;
+}
+
+bool Voice::wasCulled() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.culled_;
+}
+
 bool Voice::checkOffGroup(const Region* other, int delay, int noteNumber) noexcept
 {
     Impl& impl = *impl_;
@@ -1689,7 +2211,7 @@ bool Voice::checkOffGroup(const Region* other, int delay, int noteNumber) noexce
     if ((impl.triggerEvent_.type == TriggerEventType::NoteOn
             ||  impl.triggerEvent_.type == TriggerEventType::CC)
         && region->offBy && *region->offBy == other->group
-        && (region->group != other->group || !layer->ccSwitched_.all() || noteNumber != impl.triggerEvent_.number)) {
+        && (region->group != other->group || !layer->isCCSwitchedOn() || noteNumber != impl.triggerEvent_.number)) {
         off(delay);
         return true;
     }
@@ -1707,7 +2229,10 @@ void Voice::reset() noexcept
     impl.sourcePosition_ = 0;
     impl.age_ = 0;
     impl.count_ = 1;
-    impl.floatPositionOffset_ = 0.0f;
+    impl.underran_ = false;
+    impl.startPending_ = false;
+    impl.startMeasured_ = false;
+    impl.positionFraction_ = 0;
     impl.noteIsOff_ = false;
     impl.sostenutoState_ = Impl::SostenutoState::Up;
     impl.offed_ = false;
@@ -1715,12 +2240,13 @@ void Voice::reset() noexcept
     impl.resetLoopInformation();
 
     impl.powerFollower_.clear();
+    impl.lastAmplitudeGain_ = 1.0f;
+    impl.inaudibleBlocks_ = 0;
+    impl.culled_ = false;
+    impl.dormant_ = false;
+    impl.qualityReduction_ = 0;
 
-    for (auto& filter : impl.filters_)
-        filter.reset();
-
-    for (auto& eq : impl.equalizers_)
-        eq.reset();
+    impl.releasePooledObjects();
 
     removeVoiceFromRing();
 }
@@ -1750,7 +2276,12 @@ void Voice::Impl::updateLoopInformation() noexcept
     const double rate = info.sampleRate;
 
     loop_.start = static_cast<int>(loopStart(region, midiState));
-    loop_.end = max(static_cast<int>(loopEnd(region, midiState)), loop_.start);
+    loop_.end = static_cast<int>(loopEnd(region, midiState));
+    if (info.resampleRatio != 1.0) {
+        loop_.start = static_cast<int>(std::llround(loop_.start * info.resampleRatio));
+        loop_.end = min(static_cast<int>(info.end), static_cast<int>(std::llround(loop_.end * info.resampleRatio)));
+    }
+    loop_.end = max(loop_.end, loop_.start);
     loop_.size = loop_.end + 1 - loop_.start;
     loop_.xfSize = static_cast<int>(lroundPositive(region.loopCrossfade * rate));
     // Clamp the crossfade to the part available before the loop starts
@@ -1802,51 +2333,81 @@ bool Voice::offedOrFree() const noexcept
 void Voice::setMaxFiltersPerVoice(size_t numFilters)
 {
     Impl& impl = *impl_;
-    if (numFilters == impl.filters_.size())
-        return;
-
-    impl.filters_.clear();
-    for (unsigned i = 0; i < numFilters; ++i)
-        impl.filters_.emplace_back(impl.resources_);
+    ASSERT(impl.filters_.empty());
+    impl.filters_.reserve(numFilters);
 }
 
 void Voice::setMaxEQsPerVoice(size_t numFilters)
 {
     Impl& impl = *impl_;
-    if (numFilters == impl.equalizers_.size())
-        return;
-
-    impl.equalizers_.clear();
-    for (unsigned i = 0; i < numFilters; ++i)
-        impl.equalizers_.emplace_back(impl.resources_);
+    ASSERT(impl.equalizers_.empty());
+    impl.equalizers_.reserve(numFilters);
 }
 
 void Voice::setMaxLFOsPerVoice(size_t numLFOs)
 {
     Impl& impl = *impl_;
-    Resources& resources = impl.resources_;
+    ASSERT(impl.lfos_.empty());
+    impl.lfos_.reserve(numLFOs);
+}
 
-    impl.lfos_.resize(numLFOs);
+void Voice::setMaxFlexEGsPerVoice(size_t numFlexEGs)
+{
+    Impl& impl = *impl_;
+    ASSERT(impl.flexEGs_.empty());
+    impl.flexEGs_.reserve(numFlexEGs);
+}
 
-    for (size_t i = 0; i < numLFOs; ++i) {
-        auto lfo = absl::make_unique<LFO>(resources);
-        lfo->setSampleRate(impl.sampleRate_);
-        impl.lfos_[i] = std::move(lfo);
+bool Voice::Impl::acquirePooledObjects(const Region& region) noexcept
+{
+    ASSERT(filters_.empty() && equalizers_.empty() && lfos_.empty() && flexEGs_.empty());
+    VoicePools& pools = resources_.getVoicePools();
+
+    const auto acquire = [](auto& pool, auto& objects, size_t count) -> bool {
+        if (pool.numAvailable() < count || objects.capacity() < count)
+            return false;
+        for (size_t i = 0; i < count; ++i)
+            objects.push_back(pool.acquire());
+        return true;
+    };
+
+    const bool acquired =
+        acquire(pools.getFilters(), filters_, region.filters.size())
+        && acquire(pools.getEQs(), equalizers_, region.equalizers.size())
+        && acquire(pools.getLFOs(), lfos_, region.lfos.size())
+        && acquire(pools.getFlexEGs(), flexEGs_, region.flexEGs.size());
+
+    if (!acquired) {
+        DBG("[Voice] Not enough pooled objects for the region " << region.id.number());
+        releasePooledObjects();
     }
+
+    return acquired;
 }
 
-void Voice::setMaxFlexEGsPerVoice(size_t numFlexEGs)
+void Voice::Impl::releasePooledObjects() noexcept
 {
-    Impl& impl = *impl_;
-    Resources& resources = impl.resources_;
+    VoicePools& pools = resources_.getVoicePools();
 
-    impl.flexEGs_.resize(numFlexEGs);
+    for (FilterHolder* filter : filters_) {
+        filter->reset();
+        pools.getFilters().release(filter);
+    }
+    filters_.clear();
 
-    for (size_t i = 0; i < numFlexEGs; ++i) {
-        auto eg = absl::make_unique<FlexEnvelope>(resources);
-        eg->setSampleRate(impl.sampleRate_);
-        impl.flexEGs_[i] = std::move(eg);
+    for (EQHolder* eq : equalizers_) {
+        eq->reset();
+        pools.getEQs().release(eq);
     }
+    equalizers_.clear();
+
+    for (LFO* lfo : lfos_)
+        pools.getLFOs().release(lfo);
+    lfos_.clear();
+
+    for (FlexEnvelope* eg : flexEGs_)
+        pools.getFlexEGs().release(eg);
+    flexEGs_.clear();
 }
 
 void Voice::setPitchEGEnabledPerVoice(bool havePitchEG)
@@ -1906,74 +2467,35 @@ void Voice::setFilterLFOEnabledPerVoice(bool haveFilterLFO)
         impl.lfoFilter_.reset();
 }
 
-void Voice::Impl::setupOscillatorUnison()
+void Voice::Impl::setupOscillatorUnison(const Layer::VoiceTemplate& voiceTemplate) noexcept
 {
-    const int m = region_->oscillatorMulti;
-    const float d = region_->oscillatorDetune;
-
-    // 3-9: unison mode, 1: normal/RM, 2: PM/FM
-    if (m < 3 || region_->oscillatorMode > 0) {
-        waveUnisonSize_ = 1;
-        // carrier
-        waveDetuneRatio_[0] = 1.0;
-        waveLeftGain_[0] = 1.0;
-        waveRightGain_[0] = 1.0;
-        // modulator
-        const float modDepth = region_->oscillatorModDepth;
-        waveDetuneRatio_[1] = centsFactor(d);
-        waveLeftGain_[1] = modDepth;
-        waveRightGain_[1] = modDepth;
-        return;
-    }
-
-    // oscillator count, aka. unison size
-    waveUnisonSize_ = m;
-
-    // detune (cents)
-    float detunes[config::oscillatorsPerVoice];
-    detunes[0] = 0.0;
-    detunes[1] = -d;
-    detunes[2] = +d;
-    for (int i = 3; i < m; ++i) {
-        int n = (i - 1) / 2;
-        detunes[i] = d * ((i & 1) ? -0.25f : +0.25f) * float(n);
-    }
-
-    // detune (ratio)
-    for (int i = 0; i < m; ++i)
-        waveDetuneRatio_[i] = centsFactor(detunes[i]);
-
-    // gains
-    waveLeftGain_[0] = 0.0;
-    waveRightGain_[m - 1] = 0.0;
-    for (int i = 0; i < m - 1; ++i) {
-        float g = 1.0f - float(i) / float(m - 1);
-        waveLeftGain_[m - 1 - i] = g;
-        waveRightGain_[i] = g;
-    }
-
-#if 0
-    fprintf(stderr, "\n");
-    fprintf(stderr, "# Left:\n");
-    for (int i = m - 1; i >= 0; --i) {
-        if (waveLeftGain[i] != 0)
-            fprintf(stderr, "[%d] %10g cents, %10g dB\n", i, detunes[i], 20.0f * std::log10(waveLeftGain[i]));
-    }
-    fprintf(stderr, "\n");
-    fprintf(stderr, "# Right:\n");
-    for (int i = 0; i < m; ++i) {
-        if (waveRightGain[i] != 0)
-            fprintf(stderr, "[%d] %10g cents, %10g dB\n", i, detunes[i], 20.0f * std::log10(waveRightGain[i]));
-    }
-#endif
+    waveUnisonSize_ = voiceTemplate.waveUnisonSize;
+    copy<float>(voiceTemplate.waveDetuneRatio, waveDetuneRatio_);
+    copy<float>(voiceTemplate.waveLeftGain, waveLeftGain_);
+    copy<float>(voiceTemplate.waveRightGain, waveRightGain_);
 }
 
 void Voice::Impl::switchState(State s)
 {
     if (s != state_) {
         state_ = s;
+        // the voice counts while it is registered as active
+        if (s != State::playing)
+            updatePlaying();
         if (stateListener_)
             stateListener_->onVoiceStateChanging(id_, s);
+        if (s == State::playing)
+            updatePlaying();
+    }
+}
+
+void Voice::Impl::updatePlaying() noexcept
+{
+    const bool playing = state_ == State::playing && !offed_;
+    if (playing != playing_) {
+        playing_ = playing;
+        if (stateListener_)
+            stateListener_->onVoicePlayingChanging(id_, playing);
     }
 }
 
@@ -1991,6 +2513,19 @@ void Voice::Impl::pitchEnvelope(absl::Span<float> pitchSpan) noexcept
         linearEnvelope(events, pitchSpan, bendLambda, region_->bendStep);
     else
         linearEnvelope(events, pitchSpan, bendLambda);
+
+    // The per-note pitch bend of the note of the voice adds to the channel one
+    if (triggerEvent_.type != TriggerEventType::CC) {
+        const EventVector& noteEvents = midiState.getPerNoteEvents(triggerEvent_.number, ExtendedCCs::perNotePitchBend);
+        if (noteEvents.size() > 1 || noteEvents.front().value != 0.0f) {
+            auto noteBuffer = resources_.getBufferPool().getBuffer(numFrames);
+            if (noteBuffer) {
+                absl::Span<float> noteBend = noteBuffer->first(numFrames);
+                linearEnvelope(noteEvents, noteBend, bendLambda);
+                add<float>(noteBend, pitchSpan);
+            }
+        }
+    }
     bendSmoother_.process(pitchSpan, pitchSpan);
 
     ModMatrix& mm = resources_.getModMatrix();
@@ -2005,18 +2540,18 @@ void Voice::Impl::resetSmoothers() noexcept
     gainSmoother_.reset(0.0f);
 }
 
-void Voice::Impl::saveModulationTargets(const Region* region) noexcept
+void Voice::Impl::saveModulationTargets(const Layer::VoiceTemplate& voiceTemplate) noexcept
 {
-    ModMatrix& mm = resources_.getModMatrix();
-    masterAmplitudeTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::MasterAmplitude, region->getId()));
-    amplitudeTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::Amplitude, region->getId()));
-    volumeTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::Volume, region->getId()));
-    panTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::Pan, region->getId()));
-    positionTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::Position, region->getId()));
-    widthTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::Width, region->getId()));
-    pitchTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::Pitch, region->getId()));
-    oscillatorDetuneTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::OscillatorDetune, region->getId()));
-    oscillatorModDepthTarget_ = mm.findTarget(ModKey::createNXYZ(ModId::OscillatorModDepth, region->getId()));
+    // found in the matrix as the instrument loaded
+    masterAmplitudeTarget_ = voiceTemplate.masterAmplitudeTarget;
+    amplitudeTarget_ = voiceTemplate.amplitudeTarget;
+    volumeTarget_ = voiceTemplate.volumeTarget;
+    panTarget_ = voiceTemplate.panTarget;
+    positionTarget_ = voiceTemplate.positionTarget;
+    widthTarget_ = voiceTemplate.widthTarget;
+    pitchTarget_ = voiceTemplate.pitchTarget;
+    oscillatorDetuneTarget_ = voiceTemplate.oscillatorDetuneTarget;
+    oscillatorModDepthTarget_ = voiceTemplate.oscillatorModDepthTarget;
 }
 
 void Voice::enablePowerFollower() noexcept
@@ -2086,6 +2621,20 @@ int Voice::getSourcePosition() const noexcept
     return impl.sourcePosition_;
 }
 
+bool Voice::getSourceEnvelope(float& rms, float& peak) const noexcept
+{
+    Impl& impl = *impl_;
+    if (!impl.currentPromise_ || impl.sourcePosition_ < 0)
+        return false;
+
+    // The mirrored data is the forward one, and so is its envelope
+    size_t position = static_cast<size_t>(impl.sourcePosition_);
+    if (impl.currentPromise_.isMirrored())
+        position = static_cast<size_t>(max<int64_t>(0, int64_t(impl.currentPromise_->information.end) - impl.sourcePosition_));
+
+    return impl.currentPromise_->envelope.getWindowAt(position, rms, peak);
+}
+
 unsigned Voice::getStartTimestampSamples() const noexcept
 {
     Impl& impl = *impl_;
@@ -2095,13 +2644,13 @@ unsigned Voice::getStartTimestampSamples() const noexcept
 LFO* Voice::getLFO(size_t index)
 {
     Impl& impl = *impl_;
-    return impl.lfos_[index].get();
+    return impl.lfos_[index];
 }
 
 FlexEnvelope* Voice::getFlexEG(size_t index)
 {
     Impl& impl = *impl_;
-    return impl.flexEGs_[index].get();
+    return impl.flexEGs_[index];
 }
 
 int Voice::getAge() const noexcept
@@ -2110,6 +2659,92 @@ int Voice::getAge() const noexcept
     return impl.age_;
 }
 
+size_t Voice::getMemoryUsage() const noexcept
+{
+    const Impl& impl = *impl_;
+    size_t usage = sizeof(Voice) + sizeof(Impl);
+    usage += impl.filters_.capacity() * sizeof(FilterHolder*);
+    usage += impl.equalizers_.capacity() * sizeof(EQHolder*);
+    usage += impl.lfos_.capacity() * sizeof(LFO*);
+    usage += impl.flexEGs_.capacity() * sizeof(FlexEnvelope*);
+    for (const LFO* lfo : { impl.lfoAmplitude_.get(), impl.lfoPitch_.get(), impl.lfoFilter_.get() }) {
+        if (lfo)
+            usage += lfo->getMemoryUsage();
+    }
+    for (const ADSREnvelope* eg : { impl.egPitch_.get(), impl.egFilter_.get() }) {
+        if (eg)
+            usage += sizeof(ADSREnvelope);
+    }
+    return usage;
+}
+
+void Voice::setTimingEnabled(bool enabled) noexcept
+{
+    Impl& impl = *impl_;
+    impl.timingEnabled_ = enabled;
+}
+
+void Voice::prefetchSource(unsigned numFrames) noexcept
+{
+    Impl& impl = *impl_;
+    const Region* region = impl.region_;
+    if (region == nullptr || region->isOscillator() || !impl.currentPromise_)
+        return;
+
+    const auto source = impl.currentPromise_.getData();
+    const auto compactSource = impl.currentPromise_.getCompactData();
+    const int sourceFrames = static_cast<int>(max(source.getNumFrames(), compactSource.getNumFrames()));
+    if (sourceFrames == 0)
+        return;
+
+    // The exact positions come with the pitch modulations in the render:
+    // estimate them from the base ratio, with a margin for the interpolators
+    constexpr int margin { 16 };
+    const int delay = min(impl.initialDelay_, static_cast<int>(numFrames));
+    const float ratio = impl.pitchRatio_ * impl.speedRatio_;
+    const int span = static_cast<int>(std::ceil(ratio * (numFrames - delay))) + 2 * margin;
+
+    auto prefetchFrames = [&](int first, int count) {
+        first = max(0, first - margin);
+        count = min(count, sourceFrames - first);
+        if (count <= 0)
+            return;
+        for (size_t c = 0; c < source.getNumChannels(); ++c)
+            prefetchRange(source.getConstSpan(c).data() + first, count * sizeof(float));
+        for (size_t c = 0; c < compactSource.getNumChannels(); ++c)
+            prefetchRange(compactSource.getConstSpan(c).data() + first, count * sizeof(int16_t));
+    };
+
+    const int position = impl.sourcePosition_;
+    prefetchFrames(position, span);
+
+    // The part after the loop end wraps to the loop start
+    const auto& loop = impl.loop_;
+    if (region->shouldLoop() && loop.size > 0 && position + span > loop.end + 1)
+        prefetchFrames(loop.xfInStart, position + span - (loop.end + 1) + loop.start - loop.xfInStart);
+}
+
+void Voice::setStartTime(double dispatchDuration) noexcept
+{
+    Impl& impl = *impl_;
+    impl.startTicks_ = CycleClock::now();
+    impl.startLatency_ = StartLatency {};
+    impl.startLatency_.dispatchDuration = dispatchDuration;
+    impl.startPending_ = true;
+    impl.startMeasured_ = false;
+}
+
+bool Voice::takeStartLatency(StartLatency& latency) noexcept
+{
+    Impl& impl = *impl_;
+    if (!impl.startMeasured_)
+        return false;
+
+    latency = impl.startLatency_;
+    impl.startMeasured_ = false;
+    return true;
+}
+
 double Voice::getLastDataDuration() const noexcept
 {
     Impl& impl = *impl_;
@@ -64,6 +64,12 @@ public:
     class StateListener {
     public:
         virtual void onVoiceStateChanging(NumericId<Voice> /*id*/, State /*state*/) {}
+        /**
+         * @brief Called when the voice starts to count against the polyphony,
+         * after it starts playing, and when it stops to, as it is offed or
+         * released to be cleaned up, before it becomes idle at the latest.
+         */
+        virtual void onVoicePlayingChanging(NumericId<Voice> /*id*/, bool /*playing*/) {}
     };
 
     /**
@@ -148,30 +154,6 @@ public:
      * @param ccValue
      */
     void registerCC(int delay, int ccNumber, float ccValue) noexcept;
-    /**
-     * @brief Register a pitch wheel event; for now this does nothing
-     *
-     * @param delay
-     * @param pitch
-     */
-    void registerPitchWheel(int delay, float pitch) noexcept;
-    /**
-     * @brief Register an aftertouch event; for now this does nothing
-     *
-     * @param delay
-     * @param aftertouch
-     */
-    void registerAftertouch(int delay, float aftertouch) noexcept;
-
-    /**
-     * @brief Register a polyphonic aftertouch event; for now this does nothing
-     *
-     * @param delay
-     * @param noteNumber
-     * @param aftertouch
-     */
-    void registerPolyAftertouch(int delay, int noteNumber, float aftertouch) noexcept;
-
     /**
      * @brief Register a tempo event; for now this does nothing
      *
@@ -198,6 +180,18 @@ public:
      */
     void renderBlock(AudioSpan<float, 2> buffer) noexcept;
 
+    /**
+     * @brief Render a block of data for this voice and add it with a gain
+     * into the destination, which saves a pass over the block compared to
+     * rendering and mixing it. The buffer is the scratch space of the
+     * rendering, and holds the voice up to a gain afterwards.
+     *
+     * @param buffer
+     * @param destination
+     * @param gain
+     */
+    void renderBlock(AudioSpan<float, 2> buffer, AudioSpan<float, 2> destination, float gain) noexcept;
+
     /**
      * @brief Is the voice free?
      *
@@ -219,6 +213,19 @@ public:
      * @return false
      */
     bool offedOrFree() const noexcept;
+    /**
+     * @brief Was the voice ended early because it was inaudible?
+     * This stays valid until the voice is reset.
+     *
+     * @return true
+     * @return false
+     */
+    bool wasCulled() const noexcept;
+    /**
+     * @brief Was the gain of the last block of the voice zero, so that it
+     * only advanced its state rather than rendering?
+     */
+    bool isDormant() const noexcept;
     /**
      * @brief Get the event that triggered the voice
      *
@@ -381,11 +388,63 @@ public:
      */
     int getAge() const noexcept;
 
+    /**
+     * @brief Set whether the stages of the next blocks are timed. The last
+     * durations are zero for the blocks which are not timed.
+     *
+     * @param enabled
+     */
+    void setTimingEnabled(bool enabled) noexcept;
+
+    /**
+     * @brief Prefetch the part of the source which the next block is likely
+     * to read, so the samples are in the cache when the voice renders.
+     *
+     * @param numFrames the size of the next block
+     */
+    void prefetchSource(unsigned numFrames) noexcept;
+
+    /**
+     * @brief Get the memory of the voice, in bytes, without the filters,
+     * EQs, LFOs and flex EGs borrowed from the voice pools.
+     */
+    size_t getMemoryUsage() const noexcept;
+
     double getLastDataDuration() const noexcept;
     double getLastAmplitudeDuration() const noexcept;
     double getLastFilterDuration() const noexcept;
     double getLastPanningDuration() const noexcept;
 
+    /**
+     * @brief The latency of the start of the voice, as the stages of
+     * `Synth::VoiceStartStage`, in seconds.
+     */
+    struct StartLatency {
+        double dispatchDuration { 0 };
+        double renderDelay { 0 };
+        // whether the voice plays a sample, and its first block read the
+        // preloaded data rather than the stream
+        bool hasSample { false };
+        bool preloaded { false };
+    };
+
+    /**
+     * @brief Mark the start of the voice, at the end of the dispatch of its
+     * event.
+     *
+     * @param dispatchDuration the duration of the dispatch up to the start
+     */
+    void setStartTime(double dispatchDuration) noexcept;
+
+    /**
+     * @brief Take the latency of the start, once the voice rendered the block
+     * of its first sample. It is given once per start.
+     *
+     * @param latency
+     * @return true if the latency is measured and not taken yet
+     */
+    bool takeStartLatency(StartLatency& latency) noexcept;
+
     /**
      * @brief Get the SFZv1 amplitude LFO, if existing
      */
@@ -436,6 +495,14 @@ public:
      * @return int
      */
     int getSourcePosition() const noexcept;
+    /**
+     * @brief Get the values of the RMS and peak envelope of the sample at the
+     * current source position, which the file pool measured on loading.
+     *
+     * @return false if the voice plays no sample or the window is not
+     *         measured yet
+     */
+    bool getSourceEnvelope(float& rms, float& peak) const noexcept;
 
     /**
      * @brief Get the timestamp in midistate transport sample time when the voice was started, in samples
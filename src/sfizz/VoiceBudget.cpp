@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "VoiceBudget.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sfz {
+
+VoiceBudget& VoiceBudget::getGlobal() noexcept
+{
+    static VoiceBudget budget;
+    return budget;
+}
+
+int VoiceBudget::join(float weight) noexcept
+{
+    for (size_t i = 0; i < members_.size(); ++i) {
+        Member& member = members_[i];
+        bool used = false;
+        if (member.used.compare_exchange_strong(used, true)) {
+            member.numPlaying.store(0);
+            member.weight.store(weight);
+            member.victimPriority.store(std::numeric_limits<float>::max());
+            member.stealRequests.store(0);
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void VoiceBudget::leave(int member) noexcept
+{
+    if (member < 0)
+        return;
+
+    Member& m = members_[member];
+    m.numPlaying.store(0);
+    m.victimPriority.store(std::numeric_limits<float>::max());
+    m.used.store(false);
+}
+
+void VoiceBudget::setWeight(int member, float weight) noexcept
+{
+    if (member >= 0)
+        members_[member].weight.store(weight);
+}
+
+float VoiceBudget::getWeight(int member) const noexcept
+{
+    return (member >= 0) ? members_[member].weight.load() : 1.0f;
+}
+
+int VoiceBudget::getNumPlayingVoices() const noexcept
+{
+    int numPlaying = 0;
+    for (const Member& member : members_)
+        numPlaying += member.numPlaying.load(std::memory_order_relaxed);
+    return numPlaying;
+}
+
+bool VoiceBudget::isReached() const noexcept
+{
+    const int limit = limit_.load(std::memory_order_relaxed);
+    return limit > 0 && getNumPlayingVoices() >= limit;
+}
+
+void VoiceBudget::setNumPlayingVoices(int member, int numPlaying) noexcept
+{
+    members_[member].numPlaying.store(numPlaying, std::memory_order_relaxed);
+}
+
+void VoiceBudget::setVictimPriority(int member, float priority) noexcept
+{
+    members_[member].victimPriority.store(priority, std::memory_order_relaxed);
+}
+
+int VoiceBudget::findVictim() const noexcept
+{
+    int victim = -1;
+    float lowest = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < members_.size(); ++i) {
+        const Member& member = members_[i];
+        if (!member.used.load(std::memory_order_relaxed))
+            continue;
+        const float priority = member.victimPriority.load(std::memory_order_relaxed);
+        if (priority < lowest) {
+            lowest = priority;
+            victim = static_cast<int>(i);
+        }
+    }
+    return victim;
+}
+
+void VoiceBudget::requestSteal(int member) noexcept
+{
+    members_[member].stealRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+int VoiceBudget::takeStealRequests(int member) noexcept
+{
+    return members_[member].stealRequests.exchange(0, std::memory_order_relaxed);
+}
+
+float VoiceBudget::getPriority(float age, float power, float weight) noexcept
+{
+    return weight * (1.0f + std::sqrt(std::max(power, 0.0f))) / (1.0f + std::max(age, 0.0f));
+}
+
+} // namespace sfz
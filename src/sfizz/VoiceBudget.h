@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Config.h"
+#include <array>
+#include <atomic>
+
+namespace sfz {
+
+/**
+ * @brief A limit of the voices playing across several synths, such as the
+ * instances of a plugin in a host.
+ *
+ * The members publish the number of their playing voices, and the priority
+ * of the voice which their stealer would take. When a voice start exceeds the
+ * limit, the member of the voice of lowest priority loses it: at once if it
+ * is the member which starts the voice, or else at the start of its next
+ * block, since the members render on threads of their own.
+ *
+ * The members join and leave from the control threads; the rest is lock-free
+ * and may be called from the audio threads. The budget must outlive its
+ * members.
+ */
+class VoiceBudget {
+public:
+    /**
+     * @brief Get the budget shared by the synths of the process.
+     */
+    static VoiceBudget& getGlobal() noexcept;
+
+    /**
+     * @brief Set the limit of the playing voices of the members, or 0 for
+     * no limit.
+     */
+    void setLimit(int numVoices) noexcept { limit_.store(numVoices > 0 ? numVoices : 0); }
+    int getLimit() const noexcept { return limit_.load(); }
+
+    /**
+     * @brief Join the budget.
+     *
+     * @param weight the weight of the voices of the member in their priority
+     * @return the member, or -1 if there are config::maxVoiceBudgetMembers
+     */
+    int join(float weight) noexcept;
+
+    /**
+     * @brief Leave the budget. The member may be taken by another synth.
+     */
+    void leave(int member) noexcept;
+
+    void setWeight(int member, float weight) noexcept;
+    float getWeight(int member) const noexcept;
+
+    /**
+     * @brief Get the voices playing in all the members.
+     */
+    int getNumPlayingVoices() const noexcept;
+
+    /**
+     * @brief Is the limit reached by the voices playing in the members?
+     */
+    bool isReached() const noexcept;
+
+    /**
+     * @brief Publish the state of the voices of a member.
+     *
+     * @param numPlaying the voices playing
+     */
+    void setNumPlayingVoices(int member, int numPlaying) noexcept;
+
+    /**
+     * @brief Publish the priority of the voice which a member would steal,
+     * from getPriority(), or the largest float if there is none.
+     */
+    void setVictimPriority(int member, float priority) noexcept;
+
+    /**
+     * @brief Find the member of the voice of lowest priority, or -1 if no
+     * member has a voice to steal.
+     */
+    int findVictim() const noexcept;
+
+    /**
+     * @brief Ask a member to steal one of its voices.
+     */
+    void requestSteal(int member) noexcept;
+
+    /**
+     * @brief Take the voices which other members asked a member to steal.
+     */
+    int takeStealRequests(int member) noexcept;
+
+    /**
+     * @brief Compute the priority of a voice; the older and the quieter voices
+     * of the members of the smaller weights have the lower ones.
+     *
+     * @param age the age of the voice in seconds
+     * @param power the average power of the voice, or 0 if not followed
+     * @param weight the weight of the member
+     */
+    static float getPriority(float age, float power, float weight) noexcept;
+
+private:
+    struct Member {
+        std::atomic<bool> used { false };
+        std::atomic<int> numPlaying { 0 };
+        std::atomic<float> weight { 1.0f };
+        std::atomic<float> victimPriority { 0.0f };
+        std::atomic<int> stealRequests { 0 };
+    };
+    std::array<Member, config::maxVoiceBudgetMembers> members_;
+    std::atomic<int> limit_ { 0 };
+};
+
+} // namespace sfz
@@ -8,9 +8,16 @@
 #include "SisterVoiceRing.h"
 #include "RegionSet.h"
 #include <absl/algorithm/container.h>
+#include <algorithm>
+#include <limits>
 
 namespace sfz {
 
+VoiceManager::~VoiceManager()
+{
+    setVoiceBudget(nullptr);
+}
+
 void VoiceManager::onVoiceStateChanging(NumericId<Voice> id, Voice::State state)
 {
     if (state == Voice::State::idle) {
@@ -19,6 +26,8 @@ void VoiceManager::onVoiceStateChanging(NumericId<Voice> id, Voice::State state)
         const uint32_t group = region->group;
         RegionSet::removeVoiceFromHierarchy(region, voice);
         swapAndPopFirst(activeVoices_, [voice](const Voice* v) { return v == voice; });
+        setMaskBit(busyVoices_, indexOf(*voice), false);
+        removeFromRenderOrder(voice);
         ASSERT(polyphonyGroups_.contains(group));
         polyphonyGroups_[group].removeVoice(voice);
     } else if (state == Voice::State::playing) {
@@ -26,12 +35,33 @@ void VoiceManager::onVoiceStateChanging(NumericId<Voice> id, Voice::State state)
         const Region* region = voice->getRegion();
         const uint32_t group = region->group;
         activeVoices_.push_back(voice);
+        setVoiceFields(*voice);
+        setMaskBit(busyVoices_, indexOf(*voice), true);
+        insertInRenderOrder(voice);
         RegionSet::registerVoiceInHierarchy(region, voice);
         ASSERT(polyphonyGroups_.contains(group));
         polyphonyGroups_[group].registerVoice(voice);
     }
 }
 
+void VoiceManager::onVoicePlayingChanging(NumericId<Voice> id, bool playing)
+{
+    const Voice* voice = getVoiceById(id);
+    const Region* region = voice->getRegion();
+    if (playing) {
+        ++numPlayingVoices_;
+    } else {
+        ASSERT(numPlayingVoices_ > 0);
+        numPlayingVoices_ -= (numPlayingVoices_ > 0);
+    }
+    setMaskBit(playingVoices_, indexOf(*voice), playing);
+    if (budgetMember_ >= 0)
+        budget_->setNumPlayingVoices(budgetMember_, static_cast<int>(numPlayingVoices_));
+    RegionSet::setVoicePlayingInHierarchy(region, playing);
+    ASSERT(polyphonyGroups_.contains(region->group));
+    polyphonyGroups_[region->group].setVoicePlaying(playing);
+}
+
 const Voice* VoiceManager::getVoiceById(NumericId<Voice> id) const noexcept
 {
     const size_t size = list_.size();
@@ -67,20 +97,14 @@ void VoiceManager::reset()
 
 bool VoiceManager::playingAttackVoice(const Region* releaseRegion) noexcept
 {
-    const auto compatibleVoice = [releaseRegion](const Voice& v) -> bool {
-        const TriggerEvent& event = v.getTriggerEvent();
-        return (
-            !v.isFree()
-            && event.type == TriggerEventType::NoteOn
-            && releaseRegion->keyRange.containsWithEnd(event.number)
-            && releaseRegion->velocityRange.containsWithEnd(event.value)
-        );
-    };
+    for (size_t i = nextVoiceOf(busyVoices_, 0); i < list_.size(); i = nextVoiceOf(busyVoices_, i + 1)) {
+        if (voiceTriggers_[i] == TriggerEventType::NoteOn
+            && releaseRegion->keyRange.containsWithEnd(voiceNotes_[i])
+            && releaseRegion->velocityRange.containsWithEnd(voiceVelocities_[i]))
+            return true;
+    }
 
-    if (absl::c_find_if(list_, compatibleVoice) == list_.end())
-        return false;
-    else
-        return true;
+    return false;
 }
 
 void VoiceManager::ensureNumPolyphonyGroups(int groupIdx) noexcept
@@ -117,25 +141,87 @@ void VoiceManager::clear()
     for (auto& pg : polyphonyGroups_)
         pg.second.removeAllVoices();
     list_.clear();
+    numEffectiveVoices_ = 0;
     activeVoices_.clear();
+    numPlayingVoices_ = 0;
+    if (budgetMember_ >= 0)
+        budget_->setNumPlayingVoices(budgetMember_, 0);
+    busyVoices_.fill(0);
+    playingVoices_.fill(0);
+    renderOrder_.clear();
+}
+
+size_t VoiceManager::indexOf(const Voice& voice) const noexcept
+{
+    const size_t index = static_cast<size_t>(&voice - list_.data());
+    ASSERT(index < list_.size());
+    return index;
+}
+
+void VoiceManager::setMaskBit(VoiceMask& mask, size_t index, bool value) noexcept
+{
+    const uint64_t bit = uint64_t(1) << (index % 64);
+    if (value)
+        mask[index / 64] |= bit;
+    else
+        mask[index / 64] &= ~bit;
+}
+
+void VoiceManager::setVoiceFields(const Voice& voice) noexcept
+{
+    const size_t index = indexOf(voice);
+    const Region* region = voice.getRegion();
+    const TriggerEvent& event = voice.getTriggerEvent();
+    voiceRegions_[index] = region;
+    voiceGroups_[index] = region->group;
+    voiceOffBy_[index] = region->offBy ? *region->offBy : noOffBy;
+    voiceTriggers_[index] = event.type;
+    voiceNotes_[index] = event.number;
+    voiceVelocities_[index] = event.value;
+}
+
+void VoiceManager::insertInRenderOrder(Voice* voice) noexcept
+{
+    const Region* region = voice->getRegion();
+    ASSERT(region != nullptr);
+    const RenderEntry entry { std::hash<FileId>()(*region->sampleId), region->getId(), voice };
+
+    // After the voices of the same key, which keeps the order of the starts
+    auto position = std::upper_bound(renderOrder_.begin(), renderOrder_.end(), entry,
+        [](const RenderEntry& lhs, const RenderEntry& rhs) {
+            if (lhs.sample != rhs.sample)
+                return lhs.sample < rhs.sample;
+            return lhs.region.number() < rhs.region.number();
+        });
+    renderOrder_.insert(position, entry);
+}
+
+void VoiceManager::removeFromRenderOrder(const Voice* voice) noexcept
+{
+    auto it = absl::c_find_if(renderOrder_, [voice](const RenderEntry& entry) { return entry.voice == voice; });
+    if (it != renderOrder_.end())
+        renderOrder_.erase(it);
 }
 
 void VoiceManager::setStealingAlgorithm(StealingAlgorithm algorithm)
 {
     switch(algorithm){
     case StealingAlgorithm::First:
+        powerFollowers_ = false;
         for (auto& voice : list_)
             voice.disablePowerFollower();
 
         stealer_ = absl::make_unique<FirstStealer>();
         break;
     case StealingAlgorithm::Oldest:
+        powerFollowers_ = false;
         for (auto& voice : list_)
             voice.disablePowerFollower();
 
         stealer_ = absl::make_unique<OldestStealer>();
         break;
     case StealingAlgorithm::EnvelopeAndAge:
+        powerFollowers_ = true;
         for (auto& voice : list_)
             voice.enablePowerFollower();
 
@@ -144,6 +230,57 @@ void VoiceManager::setStealingAlgorithm(StealingAlgorithm algorithm)
     }
 }
 
+void VoiceManager::setVoiceBudget(VoiceBudget* budget, float weight) noexcept
+{
+    budgetWeight_ = weight;
+    if (budget == budget_ && budgetMember_ >= 0) {
+        budget_->setWeight(budgetMember_, weight);
+        return;
+    }
+
+    if (budgetMember_ >= 0)
+        budget_->leave(budgetMember_);
+
+    budget_ = budget;
+    budgetMember_ = budget ? budget->join(weight) : -1;
+    if (budgetMember_ >= 0) {
+        budget_->setNumPlayingVoices(budgetMember_, static_cast<int>(numPlayingVoices_));
+        publishBudgetPriority();
+    }
+}
+
+Voice* VoiceManager::findBudgetVictim() noexcept
+{
+    if (numPlayingVoices_ == 0)
+        return {};
+
+    return stealer_->checkPolyphony(absl::MakeSpan(activeVoices_), 1);
+}
+
+void VoiceManager::publishBudgetPriority() noexcept
+{
+    const Voice* victim = findBudgetVictim();
+    const float priority = victim ?
+        VoiceBudget::getPriority(victim->getAge() / sampleRate_, victim->getAveragePower(), budgetWeight_)
+        : std::numeric_limits<float>::max();
+    budget_->setVictimPriority(budgetMember_, priority);
+}
+
+void VoiceManager::updateVoiceBudget() noexcept
+{
+    if (budgetMember_ < 0)
+        return;
+
+    for (int i = budget_->takeStealRequests(budgetMember_); i > 0; --i) {
+        Voice* candidate = findBudgetVictim();
+        if (!candidate)
+            break;
+        SisterVoiceRing::offAllSisters(candidate, 0, true);
+    }
+
+    publishBudgetPriority();
+}
+
 void VoiceManager::checkPolyphony(const Region* region, int delay, const TriggerEvent& triggerEvent) noexcept
 {
     checkNotePolyphony(region, delay, triggerEvent);
@@ -151,17 +288,27 @@ void VoiceManager::checkPolyphony(const Region* region, int delay, const Trigger
     checkGroupPolyphony(region, delay);
     checkSetPolyphony(region, delay);
     checkEnginePolyphony(delay);
+    checkBudgetPolyphony(delay);
 }
 
 Voice* VoiceManager::findFreeVoice() noexcept
 {
-    Voice* freeVoice = nullptr;
-    for (auto& v: list_) {
-        if (v.isFree()) {
-            freeVoice = &v;
-            break;
+    const size_t numVoices = static_cast<size_t>(numEffectiveVoices_);
+    for (size_t w = 0; w < busyVoices_.size() && w * 64 < numVoices; ++w) {
+        const uint64_t freeBits = ~busyVoices_[w];
+        if (freeBits != 0) {
+            const size_t index = w * 64 + countTrailingZeros(freeBits);
+            if (index < numVoices) {
+                ASSERT(list_[index].isFree());
+                return &list_[index];
+            }
         }
+    }
 
+    // All voices are busy, take the oldest of the offed ones
+    Voice* freeVoice = nullptr;
+    for (size_t i = 0; i < numVoices; ++i) {
+        Voice& v = list_[i];
         if (v.offedOrFree()) {
             if (freeVoice == nullptr || v.getAge() > freeVoice->getAge())
                 freeVoice = &v;
@@ -178,24 +325,42 @@ Voice* VoiceManager::findFreeVoice() noexcept
 void VoiceManager::requireNumVoices(int numVoices, Resources& resources)
 {
     numRequiredVoices_ = numVoices;
-    const int numEffectiveVoices = std::min(int(config::maxVoices), numVoices +
+    numEffectiveVoices_ = std::min(int(config::maxVoices), numVoices +
             std::max(int(numVoices * config::overflowVoiceMultiplier), config::minOverflowVoices));
-
-    clear();
-    list_.reserve(numEffectiveVoices);
-    temp_.reserve(numEffectiveVoices);
-    activeVoices_.reserve(numEffectiveVoices);
-
-    for (int i = 0; i < numEffectiveVoices; ++i) {
+    ASSERT(numEffectiveVoices_ <= static_cast<int>(busyVoices_.size() * 64));
+
+    // Reserved once for the most voices, so that the voices never move and
+    // the lists of voices never reallocate when the polyphony grows
+    list_.reserve(config::maxVoices);
+    temp_.reserve(config::maxVoices);
+    activeVoices_.reserve(config::maxVoices);
+    renderOrder_.reserve(config::maxVoices);
+    renderVoices_.reserve(config::maxVoices);
+
+    // The voices past the limit stay, and finish playing if they are busy
+    for (int i = static_cast<int>(list_.size()); i < numEffectiveVoices_; ++i) {
         list_.emplace_back(i, resources);
         Voice& lastVoice = list_.back();
         lastVoice.setStateListener(this);
+        if (powerFollowers_)
+            lastVoice.enablePowerFollower();
     }
 }
 
 void VoiceManager::checkRegionPolyphony(const Region* region, int delay) noexcept
 {
-    Voice* candidate = stealer_->checkRegionPolyphony(region, absl::MakeSpan(activeVoices_));
+    // In the order of the active voices, which the stealers break the ties on
+    temp_.clear();
+    for (Voice* voice : activeVoices_) {
+        const size_t i = indexOf(*voice);
+        if (hasMaskBit(playingVoices_, i) && voiceRegions_[i] == region)
+            temp_.push_back(voice);
+    }
+
+    if (temp_.size() < region->polyphony)
+        return;
+
+    Voice* candidate = stealer_->checkRegionPolyphony(region, absl::MakeSpan(temp_));
     SisterVoiceRing::offAllSisters(candidate, delay);
 }
 
@@ -208,12 +373,12 @@ void VoiceManager::checkNotePolyphony(const Region* region, int delay, const Tri
     temp_.clear();
 
     for (Voice* voice : activeVoices_) {
-        const TriggerEvent& voiceTriggerEvent = voice->getTriggerEvent();
-        if (!voice->offedOrFree()
-            && voice->getRegion()->group == region->group
-            && voiceTriggerEvent.number == triggerEvent.number) {
+        const size_t i = indexOf(*voice);
+        if (hasMaskBit(playingVoices_, i)
+            && voiceGroups_[i] == region->group
+            && voiceNotes_[i] == triggerEvent.number) {
             notePolyphonyCounter += 1;
-            if (region->selfMask == SelfMask::dontMask || voiceTriggerEvent.value <= triggerEvent.value)
+            if (region->selfMask == SelfMask::dontMask || voiceVelocities_[i] <= triggerEvent.value)
                 temp_.push_back(voice);
         }
     }
@@ -257,6 +422,9 @@ bool VoiceManager::withinValidTimerRange(const Region* region, unsigned timestam
 void VoiceManager::checkGroupPolyphony(const Region* region, int delay) noexcept
 {
     auto& group = polyphonyGroups_[region->group];
+    if (group.numPlayingVoices() < group.getPolyphonyLimit())
+        return;
+
     Voice* candidate = stealer_->checkPolyphony(
         absl::MakeSpan(group.getActiveVoices()), group.getPolyphonyLimit());
     SisterVoiceRing::offAllSisters(candidate, delay);
@@ -266,18 +434,40 @@ void VoiceManager::checkSetPolyphony(const Region* region, int delay) noexcept
 {
     auto parent = region->parent;
     while (parent != nullptr) {
-        Voice* candidate = stealer_->checkPolyphony(
-            absl::MakeSpan(parent->getActiveVoices()), parent->getPolyphonyLimit());
-        SisterVoiceRing::offAllSisters(candidate, delay);
+        if (parent->numPlayingVoices() >= parent->getPolyphonyLimit()) {
+            Voice* candidate = stealer_->checkPolyphony(
+                absl::MakeSpan(parent->getActiveVoices()), parent->getPolyphonyLimit());
+            SisterVoiceRing::offAllSisters(candidate, delay);
+        }
         parent = parent->getParent();
     }
 }
 
 void VoiceManager::checkEnginePolyphony(int delay) noexcept
 {
+    if (numPlayingVoices_ < static_cast<unsigned>(numRequiredVoices_))
+        return;
+
     Voice* candidate = stealer_->checkPolyphony(
         absl::MakeSpan(activeVoices_), numRequiredVoices_);
     SisterVoiceRing::offAllSisters(candidate, delay, true);
 }
 
+void VoiceManager::checkBudgetPolyphony(int delay) noexcept
+{
+    if (budgetMember_ < 0 || !budget_->isReached())
+        return;
+
+    // The other members take their voices at the start of their blocks
+    publishBudgetPriority();
+    const int victim = budget_->findVictim();
+    if (victim == budgetMember_) {
+        SisterVoiceRing::offAllSisters(findBudgetVictim(), delay, true);
+        publishBudgetPriority();
+    }
+    else if (victim >= 0) {
+        budget_->requestSteal(victim);
+    }
+}
+
 } // namespace sfz
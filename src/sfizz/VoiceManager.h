@@ -8,22 +8,34 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "Config.h"
+#include "MathHelpers.h"
 #include "PolyphonyGroup.h"
 #include "Region.h"
 #include "Resources.h"
 #include "Voice.h"
+#include "VoiceBudget.h"
 #include "VoiceStealing.h"
+#include <array>
+#include <limits>
 #include <vector>
 
 namespace sfz {
 
 struct VoiceManager final : public Voice::StateListener
 {
+    ~VoiceManager();
+
     /**
      * @brief The voice callback which is called during a change of state.
      */
     void onVoiceStateChanging(NumericId<Voice> id, Voice::State state) final;
 
+    /**
+     * @brief The voice callback which keeps the counts of the playing voices,
+     * so that the polyphony checks do not visit the voices under the limits.
+     */
+    void onVoicePlayingChanging(NumericId<Voice> id, bool playing) final;
+
     /**
      * @brief Find the voice which is associated with the given identifier.
      *
@@ -100,6 +112,30 @@ struct VoiceManager final : public Voice::StateListener
      */
     void setStealingAlgorithm(StealingAlgorithm algorithm);
 
+    /**
+     * @brief Join a voice budget shared with other synths, leaving the former
+     * one, or leave it if null. Call it out of the RT thread.
+     *
+     * @param budget
+     * @param weight the weight of the voices in the priorities of the budget
+     */
+    void setVoiceBudget(VoiceBudget* budget, float weight = 1.0f) noexcept;
+    VoiceBudget* getVoiceBudget() const noexcept { return (budgetMember_ >= 0) ? budget_ : nullptr; }
+    float getVoiceBudgetWeight() const noexcept { return budgetWeight_; }
+
+    /**
+     * @brief Set the sample rate, which converts the ages of the voices in
+     * the priorities of the voice budget.
+     */
+    void setSampleRate(float sampleRate) noexcept { sampleRate_ = sampleRate; }
+
+    /**
+     * @brief Steal the voices which other members of the voice budget asked
+     * for, and publish the priority of the next one. Call it at the start of
+     * the blocks.
+     */
+    void updateVoiceBudget() noexcept;
+
     /**
      * @brief Off voices as necessary depending on the trigger event and started region
      *
@@ -133,12 +169,21 @@ struct VoiceManager final : public Voice::StateListener
      * @brief Require a number of voices from this manager.
      * In practice, the manager will handle slightly more, in order to
      * allow voices to die off upon reaching higher polyphony count.
+     * The voices are kept across the changes: the ones which are missing are
+     * added at the end of the list, and the ones past a lower limit are not
+     * taken anymore but finish playing.
      *
      * @param numVoices
      * @param resources
      */
     void requireNumVoices(int numVoices, Resources& resources);
 
+    /**
+     * @brief Get the number of voices in the list, which may be more than the
+     * voices under the limit after a lower polyphony was required.
+     */
+    size_t getNumVoiceObjects() const noexcept { return list_.size(); }
+
     /**
      * @brief Is this timestamp within the lo/hitimer range for this region based on current group activity
      *
@@ -149,14 +194,98 @@ struct VoiceManager final : public Voice::StateListener
      */
     bool withinValidTimerRange(const Region* region, unsigned timestampSamples, float sampleRate) const noexcept;
 
+    /**
+     * @brief Call a function on the voices which are not free, grouped by
+     * sample and region, such that the voices which share their data render
+     * one after the other. The function may reset the voice it receives.
+     *
+     * @param function
+     */
+    template <class F>
+    void forEachBusyVoice(F&& function)
+    {
+        // Resetting a voice changes the order, so visit a copy of it
+        renderVoices_.clear();
+        for (const RenderEntry& entry : renderOrder_)
+            renderVoices_.push_back(entry.voice);
+        for (Voice* voice : renderVoices_) {
+            if (!voice->isFree())
+                function(*voice);
+        }
+    }
+
+    /**
+     * @brief Call a function on the voices which are playing or releasing.
+     * The function must not reset the voice it receives.
+     *
+     * @param function
+     */
+    template <class F>
+    void forEachActiveVoice(F&& function)
+    {
+        for (Voice* voice : activeVoices_)
+            function(*voice);
+    }
+
+    /**
+     * @brief Off the voices which a region offs as it starts, and call a
+     * function on each of them. The function may start voices.
+     *
+     * @param region the region which starts
+     * @param delay
+     * @param number the note or the CC which starts the region
+     * @param function
+     */
+    template <class F>
+    void checkOffGroups(const Region* region, int delay, int number, F&& function)
+    {
+        const int64_t group = region->group;
+        for (size_t i = nextVoiceOf(busyVoices_, 0); i < list_.size(); i = nextVoiceOf(busyVoices_, i + 1)) {
+            if (voiceOffBy_[i] == group && list_[i].checkOffGroup(region, delay, number))
+                function(list_[i]);
+        }
+    }
+
 private:
     int numRequiredVoices_ { config::numVoices };
+    // The voices of the list which can be taken
+    int numEffectiveVoices_ { 0 };
     std::vector<Voice> list_;
     std::vector<Voice*> activeVoices_;
+    unsigned numPlayingVoices_ { 0 };
+    using VoiceMask = std::array<uint64_t, (config::maxVoices + 63) / 64>;
+    // The voices of the list which are not free, by words of 64 voices,
+    // such that the free voices are found without visiting the list
+    VoiceMask busyVoices_ {};
+    // The voices which count against the polyphony, as of `offedOrFree`
+    VoiceMask playingVoices_ {};
+    // The fields of the voices which the checks compare, by index in the
+    // list, which are set as the voices start. The checks sweep these over
+    // the masks above, and visit only the voices which match.
+    static constexpr int64_t noOffBy { std::numeric_limits<int64_t>::min() };
+    std::array<const Region*, config::maxVoices> voiceRegions_ {};
+    std::array<int64_t, config::maxVoices> voiceGroups_ {};
+    std::array<int64_t, config::maxVoices> voiceOffBy_ {};
+    std::array<TriggerEventType, config::maxVoices> voiceTriggers_ {};
+    std::array<int, config::maxVoices> voiceNotes_ {};
+    std::array<float, config::maxVoices> voiceVelocities_ {};
     std::vector<Voice*> temp_;
+    struct RenderEntry {
+        size_t sample;
+        NumericId<Region> region;
+        Voice* voice;
+    };
+    // The busy voices, kept sorted by sample and region on the changes of state
+    std::vector<RenderEntry> renderOrder_;
+    std::vector<Voice*> renderVoices_;
     // These are the `group=` groups where you can off voices
     absl::flat_hash_map<int, PolyphonyGroup> polyphonyGroups_;
     std::unique_ptr<VoiceStealer> stealer_ { absl::make_unique<OldestStealer>() };
+    bool powerFollowers_ { false };
+    VoiceBudget* budget_ { nullptr };
+    int budgetMember_ { -1 };
+    float budgetWeight_ { 1.0f };
+    float sampleRate_ { config::defaultSampleRate };
 
     /**
      * @brief Check the region polyphony, releasing voices if necessary
@@ -198,6 +327,47 @@ private:
      */
     void checkEnginePolyphony(int delay) noexcept;
 
+    /**
+     * @brief Check the voice budget shared with other synths, fast releasing
+     * a voice of the member of lowest priority if necessary
+     *
+     * @param delay
+     */
+    void checkBudgetPolyphony(int delay) noexcept;
+
+    /**
+     * @brief Find the voice which the stealer would take, for the voice budget
+     */
+    Voice* findBudgetVictim() noexcept;
+    void publishBudgetPriority() noexcept;
+
+    size_t indexOf(const Voice& voice) const noexcept;
+    static void setMaskBit(VoiceMask& mask, size_t index, bool value) noexcept;
+    static bool hasMaskBit(const VoiceMask& mask, size_t index) noexcept
+    {
+        return (mask[index / 64] >> (index % 64)) & 1;
+    }
+    /**
+     * @brief Get the first voice of a mask from an index on, or
+     * config::maxVoices if there is none. The mask is read on each call, so
+     * the voices which change between the calls are seen as they are.
+     */
+    static size_t nextVoiceOf(const VoiceMask& mask, size_t index) noexcept
+    {
+        for (size_t w = index / 64; w < mask.size(); ++w) {
+            uint64_t bits = mask[w];
+            if (w == index / 64)
+                bits &= ~uint64_t(0) << (index % 64);
+            if (bits != 0)
+                return w * 64 + countTrailingZeros(bits);
+        }
+        return config::maxVoices;
+    }
+    void setVoiceFields(const Voice& voice) noexcept;
+
+    void insertInRenderOrder(Voice* voice) noexcept;
+    void removeFromRenderOrder(const Voice* voice) noexcept;
+
 public:
     // Vector shortcuts
     typename decltype(list_)::iterator begin() { return list_.begin(); }
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "VoicePools.h"
+#include "Config.h"
+#include "FilterPool.h"
+#include "EQPool.h"
+#include "LFO.h"
+#include "FlexEnvelope.h"
+#include <absl/memory/memory.h>
+#include <algorithm>
+#include <functional>
+
+namespace sfz {
+
+VoicePools::VoicePools()
+    : sampleRate_(config::defaultSampleRate)
+{
+}
+
+VoicePools::~VoicePools()
+{
+}
+
+void VoicePools::resize(Resources& resources, size_t numVoices, const std::vector<RegionNeeds>& needs)
+{
+    filters_.clear();
+    equalizers_.clear();
+    lfos_.clear();
+    flexEGs_.clear();
+    grow(resources, numVoices, needs);
+}
+
+void VoicePools::grow(Resources& resources, size_t numVoices, const std::vector<RegionNeeds>& needs)
+{
+    const float sampleRate = sampleRate_;
+
+    filters_.grow(getPoolSize(numVoices, needs, &RegionNeeds::numFilters), [&]() {
+        auto filter = absl::make_unique<FilterHolder>(resources);
+        filter->setSampleRate(sampleRate);
+        return filter;
+    });
+
+    equalizers_.grow(getPoolSize(numVoices, needs, &RegionNeeds::numEQs), [&]() {
+        auto eq = absl::make_unique<EQHolder>(resources);
+        eq->setSampleRate(sampleRate);
+        return eq;
+    });
+
+    lfos_.grow(getPoolSize(numVoices, needs, &RegionNeeds::numLFOs), [&]() {
+        auto lfo = absl::make_unique<LFO>(resources);
+        lfo->setSampleRate(sampleRate);
+        return lfo;
+    });
+
+    flexEGs_.grow(getPoolSize(numVoices, needs, &RegionNeeds::numFlexEGs), [&]() {
+        auto eg = absl::make_unique<FlexEnvelope>(resources);
+        eg->setSampleRate(sampleRate);
+        return eg;
+    });
+}
+
+size_t VoicePools::getPoolSize(size_t numVoices, const std::vector<RegionNeeds>& needs, size_t RegionNeeds::*count)
+{
+    // The most demanding regions take the voices first
+    std::vector<std::pair<size_t, size_t>> demands; // objects per voice, voices
+    for (const RegionNeeds& region : needs) {
+        if (region.*count == 0)
+            continue;
+        const size_t polyphony = region.polyphony;
+        const size_t numOverflowVoices = std::max(
+            static_cast<size_t>(polyphony * config::overflowVoiceMultiplier),
+            static_cast<size_t>(config::minOverflowVoices));
+        demands.emplace_back(region.*count, std::min(numVoices, polyphony + numOverflowVoices));
+    }
+    std::sort(demands.begin(), demands.end(), std::greater<std::pair<size_t, size_t>>());
+
+    size_t size = 0;
+    size_t remainingVoices = numVoices;
+    for (const auto& demand : demands) {
+        if (remainingVoices == 0)
+            break;
+        const size_t voices = std::min(remainingVoices, demand.second);
+        size += voices * demand.first;
+        remainingVoices -= voices;
+    }
+    return size;
+}
+
+void VoicePools::setSampleRate(float sampleRate)
+{
+    sampleRate_ = sampleRate;
+    filters_.forEach([sampleRate](FilterHolder& filter) { filter.setSampleRate(sampleRate); });
+    equalizers_.forEach([sampleRate](EQHolder& eq) { eq.setSampleRate(sampleRate); });
+    lfos_.forEach([sampleRate](LFO& lfo) { lfo.setSampleRate(sampleRate); });
+    flexEGs_.forEach([sampleRate](FlexEnvelope& eg) { eg.setSampleRate(sampleRate); });
+}
+
+size_t VoicePools::getMemoryUsage() const noexcept
+{
+    return filters_.getMemoryUsage() + equalizers_.getMemoryUsage()
+        + lfos_.getMemoryUsage() + flexEGs_.getMemoryUsage();
+}
+
+} // namespace sfz
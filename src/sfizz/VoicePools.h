@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "utility/Debug.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sfz {
+
+class Resources;
+class FilterHolder;
+class EQHolder;
+class LFO;
+class FlexEnvelope;
+
+/**
+ * @brief A fixed set of objects, which are borrowed and given back
+ * without allocating.
+ */
+template <class T>
+class ObjectPool {
+public:
+    /**
+     * @brief Remove all the objects of the pool.
+     * All the borrowed objects must have been given back or forgotten.
+     */
+    void clear() noexcept
+    {
+        objects_.clear();
+        available_.clear();
+    }
+
+    /**
+     * @brief Add available objects up to a size, keeping the objects of the
+     * pool, borrowed or not, and doing nothing if the pool is large enough.
+     *
+     * @param size      the number of objects
+     * @param create    a function which returns a new object
+     */
+    template <class F>
+    void grow(size_t size, F&& create)
+    {
+        if (size <= objects_.size())
+            return;
+
+        objects_.reserve(size);
+        available_.reserve(size);
+        while (objects_.size() < size) {
+            objects_.emplace_back(create());
+            available_.push_back(objects_.back().get());
+        }
+    }
+
+    /**
+     * @brief Borrow an object
+     *
+     * @return the object, or null if none is available
+     */
+    T* acquire() noexcept
+    {
+        if (available_.empty())
+            return nullptr;
+
+        T* object = available_.back();
+        available_.pop_back();
+        return object;
+    }
+
+    /**
+     * @brief Give back a borrowed object
+     *
+     * @param object
+     */
+    void release(T* object) noexcept
+    {
+        ASSERT(object != nullptr);
+        ASSERT(available_.size() < objects_.size());
+        available_.push_back(object);
+    }
+
+    size_t size() const noexcept { return objects_.size(); }
+    size_t numAvailable() const noexcept { return available_.size(); }
+
+    /**
+     * @brief Get the memory of the pool and its objects, in bytes
+     */
+    size_t getMemoryUsage() const noexcept
+    {
+        size_t usage = objects_.capacity() * sizeof(objects_[0]) + available_.capacity() * sizeof(T*);
+        for (const auto& object : objects_)
+            usage += object->getMemoryUsage();
+        return usage;
+    }
+
+    /**
+     * @brief Apply a function to all the objects of the pool
+     *
+     * @param function
+     */
+    template <class F>
+    void forEach(F&& function)
+    {
+        for (auto& object : objects_)
+            function(*object);
+    }
+
+private:
+    std::vector<std::unique_ptr<T>> objects_;
+    std::vector<T*> available_;
+};
+
+/**
+ * @brief The filters, equalizers, LFOs and flex EGs shared by the voices,
+ * which borrow as many as their region needs when they start.
+ */
+class VoicePools {
+public:
+    VoicePools();
+    ~VoicePools();
+
+    /**
+     * @brief The objects which a region needs in each of its voices, and
+     * the polyphony which bounds its voices.
+     */
+    struct RegionNeeds {
+        uint32_t polyphony { 0 };
+        size_t numFilters { 0 };
+        size_t numEQs { 0 };
+        size_t numLFOs { 0 };
+        size_t numFlexEGs { 0 };
+    };
+
+    /**
+     * @brief Size the pools for the most objects which a number of voices
+     * can hold at once, playing the regions up to their polyphony. This
+     * allocates, and forgets the objects which are borrowed.
+     *
+     * @param resources
+     * @param numVoices
+     * @param needs     the regions which need objects
+     */
+    void resize(Resources& resources, size_t numVoices, const std::vector<RegionNeeds>& needs);
+
+    /**
+     * @brief Add to the pools the objects of more voices, keeping the objects
+     * which are borrowed. This allocates.
+     *
+     * @param resources
+     * @param numVoices
+     * @param needs     the regions which need objects
+     */
+    void grow(Resources& resources, size_t numVoices, const std::vector<RegionNeeds>& needs);
+
+    /**
+     * @brief Get the most objects of a kind which a number of voices can
+     * hold at once. The regions release their voices past their polyphony,
+     * which still hold their objects as they die, so a region counts as many
+     * overflow voices as the engine does.
+     *
+     * @param numVoices
+     * @param needs
+     * @param count     the objects of the kind in the needs
+     */
+    static size_t getPoolSize(size_t numVoices, const std::vector<RegionNeeds>& needs, size_t RegionNeeds::*count);
+
+    /**
+     * @brief Set the sample rate of all the objects
+     *
+     * @param sampleRate
+     */
+    void setSampleRate(float sampleRate);
+
+    /**
+     * @brief Get the memory of all the pools, in bytes
+     */
+    size_t getMemoryUsage() const noexcept;
+
+    ObjectPool<FilterHolder>& getFilters() noexcept { return filters_; }
+    ObjectPool<EQHolder>& getEQs() noexcept { return equalizers_; }
+    ObjectPool<LFO>& getLFOs() noexcept { return lfos_; }
+    ObjectPool<FlexEnvelope>& getFlexEGs() noexcept { return flexEGs_; }
+
+private:
+    float sampleRate_;
+    ObjectPool<FilterHolder> filters_;
+    ObjectPool<EQHolder> equalizers_;
+    ObjectPool<LFO> lfos_;
+    ObjectPool<FlexEnvelope> flexEGs_;
+};
+
+} // namespace sfz
@@ -1,5 +1,10 @@
 #include "VoiceStealing.h"
 #include "SisterVoiceRing.h"
+#include <algorithm>
+#include <simde/simde-features.h>
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+#include <simde/x86/sse2.h>
+#endif
 
 namespace sfz {
 
@@ -75,6 +80,57 @@ Voice* OldestStealer::checkPolyphony(absl::Span<Voice*> candidates, unsigned max
         [=](const Voice* v, const Voice* c) { return (c == nullptr || v->getAge() > c->getAge()); });
 }
 
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+/**
+ * @brief Find the greatest of the ages above a threshold, whose powers are
+ * below a threshold, 4 voices at a time.
+ *
+ * @return the age, or -1 if no voice qualifies
+ */
+static int maxStealableAge(const int* ages, const float* powers, size_t size, int ageThreshold, float powerThreshold) noexcept
+{
+    const simde__m128i none = simde_mm_set1_epi32(-1);
+    const simde__m128i ageLimit = simde_mm_set1_epi32(ageThreshold);
+    const simde__m128 powerLimit = simde_mm_set1_ps(powerThreshold);
+    simde__m128i best = none;
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const simde__m128i age = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(ages + i));
+        const simde__m128 power = simde_mm_loadu_ps(powers + i);
+        const simde__m128i stealable = simde_mm_and_si128(
+            simde_mm_cmpgt_epi32(age, ageLimit),
+            simde_mm_castps_si128(simde_mm_cmplt_ps(power, powerLimit)));
+        const simde__m128i candidate = simde_mm_or_si128(
+            simde_mm_and_si128(stealable, age), simde_mm_andnot_si128(stealable, none));
+        const simde__m128i greater = simde_mm_cmpgt_epi32(candidate, best);
+        best = simde_mm_or_si128(
+            simde_mm_and_si128(greater, candidate), simde_mm_andnot_si128(greater, best));
+    }
+
+    alignas(16) int lanes[4];
+    simde_mm_store_si128(reinterpret_cast<simde__m128i*>(lanes), best);
+    int maxAge = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+
+    for (; i < size; ++i) {
+        if (ages[i] > ageThreshold && powers[i] < powerThreshold)
+            maxAge = std::max(maxAge, ages[i]);
+    }
+
+    return maxAge;
+}
+#else
+static int maxStealableAge(const int* ages, const float* powers, size_t size, int ageThreshold, float powerThreshold) noexcept
+{
+    int maxAge = -1;
+    for (size_t i = 0; i < size; ++i) {
+        if (ages[i] > ageThreshold && powers[i] < powerThreshold)
+            maxAge = std::max(maxAge, ages[i]);
+    }
+    return maxAge;
+}
+#endif
+
 /**
  * @brief Stealer on envelope and age.
  * The stealer checks that the power to try and kill voices with relative low contribution
@@ -84,45 +140,55 @@ Voice* OldestStealer::checkPolyphony(absl::Span<Voice*> candidates, unsigned max
  * their sound, but it's reasonable for sounds with a quick attack and longer
  * release.
  *
- * @param voices
+ * The stolen voice is the first in the order of `voiceOrdering` to be older
+ * than the age threshold and quieter than the power threshold, across its
+ * sister voices, or the first voice of all if there is none. The ages and the
+ * powers of the sister rings go into contiguous arrays, so that a single pass
+ * finds the age of the stolen voice without sorting the candidates.
+ *
  * @return sfz::Voice*
  */
-sfz::Voice* stealEnvelopeAndAge(absl::Span<Voice*> voices) noexcept
+Voice* EnvelopeAndAgeStealer::stealEnvelopeAndAge() noexcept
 {
-    absl::c_sort(voices, voiceOrdering);
-
-    const auto sumPower = absl::c_accumulate(voices, 0.0f, [](float sum, const Voice* v) {
-        return sum + v->getAveragePower();
-    });
-
-    const auto powerThreshold = sumPower
-        / static_cast<float>(voices.size()) * config::stealingPowerCoeff;
-    const auto ageThreshold =
-        static_cast<int>(voices.front()->getAge() * config::stealingAgeCoeff);
-
-    Voice* returnedVoice = voices.front();
-    unsigned idx = 0;
-    while (idx < voices.size()) {
-        const auto ref = voices[idx];
-
-        if (ref->getAge() <= ageThreshold) {
-            // Went too far, we'll kill the oldest note.
-            break;
-        }
+    const size_t numVoices = temp_.size();
+    ASSERT(numVoices > 0);
+    ages_.resize(numVoices);
+    powers_.resize(numVoices);
+
+    Voice* oldest = temp_.front();
+    float sumPower = 0.0f;
+    for (size_t i = 0; i < numVoices; ++i) {
+        Voice* voice = temp_[i];
+        ages_[i] = voice->getAge();
+        sumPower += voice->getAveragePower();
 
         float maxPower { 0.0f };
-        SisterVoiceRing::applyToRing(ref, [&](Voice* v) {
+        SisterVoiceRing::applyToRing(voice, [&](Voice* v) {
             maxPower = max(maxPower, v->getAveragePower());
         });
+        powers_[i] = maxPower;
 
-        if (maxPower < powerThreshold) {
-            returnedVoice = ref;
-            break;
-        }
+        if (voiceOrdering(voice, oldest))
+            oldest = voice;
+    }
+
+    const auto powerThreshold = sumPower
+        / static_cast<float>(numVoices) * config::stealingPowerCoeff;
+    const auto ageThreshold =
+        static_cast<int>(oldest->getAge() * config::stealingAgeCoeff);
+
+    const int stolenAge = maxStealableAge(ages_.data(), powers_.data(), numVoices, ageThreshold, powerThreshold);
+    if (stolenAge < 0) {
+        // No voice is quiet enough, we'll kill the oldest note.
+        return oldest;
+    }
 
-        // Jump over the sister voices in the set
-        do { idx++; }
-        while (idx < voices.size() && sisterVoices(ref, voices[idx]));
+    Voice* returnedVoice = nullptr;
+    for (size_t i = 0; i < numVoices; ++i) {
+        if (ages_[i] != stolenAge || !(powers_[i] < powerThreshold))
+            continue;
+        if (returnedVoice == nullptr || voiceOrdering(temp_[i], returnedVoice))
+            returnedVoice = temp_[i];
     }
 
     return returnedVoice;
@@ -137,7 +203,7 @@ Voice* EnvelopeAndAgeStealer::checkRegionPolyphony(const Region* region, absl::S
     });
 
     if (temp_.size() >= region->polyphony)
-        return stealEnvelopeAndAge(absl::MakeSpan(temp_));
+        return stealEnvelopeAndAge();
 
     return {};
 }
@@ -150,7 +216,7 @@ Voice* EnvelopeAndAgeStealer::checkPolyphony(absl::Span<Voice*> candidates, unsi
     });
 
     if (temp_.size() >= maxPolyphony)
-        return stealEnvelopeAndAge(absl::MakeSpan(temp_));
+        return stealEnvelopeAndAge();
 
     return {};
 }
@@ -158,6 +224,8 @@ Voice* EnvelopeAndAgeStealer::checkPolyphony(absl::Span<Voice*> candidates, unsi
 EnvelopeAndAgeStealer::EnvelopeAndAgeStealer()
 {
     temp_.reserve(config::maxVoices);
+    ages_.reserve(config::maxVoices);
+    powers_.reserve(config::maxVoices);
 }
 
 }
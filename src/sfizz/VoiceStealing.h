@@ -65,7 +65,11 @@ public:
     Voice* checkRegionPolyphony(const Region* region, absl::Span<Voice*> candidates) final;
     Voice* checkPolyphony(absl::Span<Voice*> candidates, unsigned maxPolyphony) final;
 private:
+    Voice* stealEnvelopeAndAge() noexcept;
     std::vector<Voice*> temp_;
+    // The ages of the candidates, and the maximal powers of their sister rings
+    std::vector<int> ages_;
+    std::vector<float> powers_;
 };
 
 }
@@ -8,8 +8,17 @@
 #include "FilePool.h"
 #include "Interpolators.h"
 #include "MathHelpers.h"
+#include "utility/AtomicFile.h"
+#include "utility/StringViewHelpers.h"
 #include "absl/meta/type_traits.h"
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/str_cat.h>
+#include <ghc/fs_std.hpp>
 #include <kiss_fftr.h>
+#include <cstring>
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+#include <simde/x86/sse2.h>
+#endif
 
 namespace sfz {
 
@@ -183,6 +192,260 @@ void WavetableOscillator::processModulated(const float* frequencies, const float
     }
 }
 
+void WavetableOscillator::advance(const float* frequencies, float detuneRatio, const float* detuneMod, unsigned nframes)
+{
+    // the increments add up in double precision, to wrap once at the end
+    double increment = 0.0;
+    if (detuneMod) {
+        for (unsigned i = 0; i < nframes; ++i)
+            increment += frequencies[i] * detuneMod[i];
+    } else {
+        for (unsigned i = 0; i < nframes; ++i)
+            increment += frequencies[i];
+    }
+
+    double phase = _phase + increment * (detuneRatio * _sampleInterval);
+    phase -= std::floor(phase);
+    _phase = clamp(static_cast<float>(phase), 0.0f, 0x1.fffffep-1f);
+}
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+namespace {
+constexpr unsigned unisonLanes = 4;
+constexpr unsigned maxUnisonGroups = (config::oscillatorsPerVoice + unisonLanes - 1) / unisonLanes;
+
+/**
+ * @brief Interpolation of a table at the positions of 4 lanes
+ */
+template <InterpolatorModel M>
+struct LaneInterpolator;
+
+template <>
+struct LaneInterpolator<kInterpolatorNearest> {
+    static simde__m128 process(const float* table, const int* indices, simde__m128 frac)
+    {
+        alignas(16) float fracs[unisonLanes];
+        simde_mm_store_ps(fracs, frac);
+        return simde_mm_setr_ps(
+            table[indices[0] + (fracs[0] > 0.5f)], table[indices[1] + (fracs[1] > 0.5f)],
+            table[indices[2] + (fracs[2] > 0.5f)], table[indices[3] + (fracs[3] > 0.5f)]);
+    }
+};
+
+template <>
+struct LaneInterpolator<kInterpolatorLinear> {
+    static simde__m128 process(const float* table, const int* indices, simde__m128 frac)
+    {
+        // the consecutive values of each lane, transposed to a vector per point
+        simde__m128 r0 = simde_mm_loadu_ps(&table[indices[0]]);
+        simde__m128 r1 = simde_mm_loadu_ps(&table[indices[1]]);
+        simde__m128 r2 = simde_mm_loadu_ps(&table[indices[2]]);
+        simde__m128 r3 = simde_mm_loadu_ps(&table[indices[3]]);
+        SIMDE_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        const simde__m128 complement = simde_mm_sub_ps(simde_mm_set1_ps(1.0f), frac);
+        return simde_mm_add_ps(simde_mm_mul_ps(r0, complement), simde_mm_mul_ps(r1, frac));
+    }
+};
+
+template <>
+struct LaneInterpolator<kInterpolatorHermite3> {
+    static simde__m128 process(const float* table, const int* indices, simde__m128 frac)
+    {
+        simde__m128 r0 = simde_mm_loadu_ps(&table[indices[0] - 1]);
+        simde__m128 r1 = simde_mm_loadu_ps(&table[indices[1] - 1]);
+        simde__m128 r2 = simde_mm_loadu_ps(&table[indices[2] - 1]);
+        simde__m128 r3 = simde_mm_loadu_ps(&table[indices[3] - 1]);
+        SIMDE_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        const simde__m128 h0 = hermite3x4(simde_mm_sub_ps(simde_mm_set1_ps(-1.0f), frac));
+        const simde__m128 h1 = hermite3x4(simde_mm_sub_ps(simde_mm_setzero_ps(), frac));
+        const simde__m128 h2 = hermite3x4(simde_mm_sub_ps(simde_mm_set1_ps(1.0f), frac));
+        const simde__m128 h3 = hermite3x4(simde_mm_sub_ps(simde_mm_set1_ps(2.0f), frac));
+        return simde_mm_add_ps(
+            simde_mm_add_ps(simde_mm_mul_ps(h0, r0), simde_mm_mul_ps(h1, r1)),
+            simde_mm_add_ps(simde_mm_mul_ps(h2, r2), simde_mm_mul_ps(h3, r3)));
+    }
+};
+
+/**
+ * @brief The table, or the pair of tables, for the frequency of a frame
+ */
+template <bool Dual>
+struct LaneTables;
+
+template <>
+struct LaneTables<false> {
+    LaneTables(const WavetableMulti& multi, float frequency)
+        : table(multi.getTableForFrequency(frequency).data())
+    {
+    }
+
+    template <InterpolatorModel M>
+    simde__m128 interpolate(const int* indices, simde__m128 frac) const
+    {
+        return LaneInterpolator<M>::process(table, indices, frac);
+    }
+
+    const float* table;
+};
+
+template <>
+struct LaneTables<true> {
+    LaneTables(const WavetableMulti& multi, float frequency)
+        : dt(multi.getInterpolationPairForFrequency(frequency))
+    {
+    }
+
+    template <InterpolatorModel M>
+    simde__m128 interpolate(const int* indices, simde__m128 frac) const
+    {
+        const simde__m128 y1 = LaneInterpolator<M>::process(dt.table1, indices, frac);
+        const simde__m128 y2 = LaneInterpolator<M>::process(dt.table2, indices, frac);
+        return simde_mm_add_ps(
+            simde_mm_mul_ps(simde_mm_set1_ps(1 - dt.delta), y1),
+            simde_mm_mul_ps(simde_mm_set1_ps(dt.delta), y2));
+    }
+
+    WavetableMulti::DualTable dt;
+};
+
+// the same as incrementAndWrap, in all lanes
+simde__m128 incrementAndWrapLanes(simde__m128 phase, simde__m128 inc)
+{
+    phase = simde_mm_add_ps(phase, inc);
+    phase = simde_mm_sub_ps(phase, simde_mm_cvtepi32_ps(simde_mm_cvttps_epi32(phase)));
+    const simde__m128 negative = simde_mm_cmplt_ps(phase, simde_mm_setzero_ps());
+    phase = simde_mm_add_ps(phase, simde_mm_and_ps(negative, simde_mm_set1_ps(1.0f)));
+    return phase;
+}
+} // namespace
+
+template <InterpolatorModel M, bool Dual>
+void WavetableOscillator::processUnisonLanes(
+    WavetableOscillator* const oscillators[], unsigned numOscillators,
+    const float* frequencies, const float* detuneRatios, const float* detuneMod,
+    const float* leftGains, const float* rightGains,
+    float* left, float* right, unsigned nframes)
+{
+    ASSERT(numOscillators > 0 && numOscillators <= config::oscillatorsPerVoice);
+    const unsigned numGroups = (numOscillators + unisonLanes - 1) / unisonLanes;
+
+    // The lanes past the last oscillator stay silent
+    alignas(16) float phases[maxUnisonGroups * unisonLanes] {};
+    alignas(16) float ratios[maxUnisonGroups * unisonLanes] {};
+    alignas(16) float leftLanes[maxUnisonGroups * unisonLanes] {};
+    alignas(16) float rightLanes[maxUnisonGroups * unisonLanes] {};
+    for (unsigned u = 0; u < numOscillators; ++u) {
+        phases[u] = oscillators[u]->_phase;
+        ratios[u] = detuneRatios[u];
+        leftLanes[u] = leftGains[u];
+        rightLanes[u] = rightGains[u];
+    }
+
+    simde__m128 phase[maxUnisonGroups];
+    simde__m128 ratio[maxUnisonGroups];
+    simde__m128 leftGain[maxUnisonGroups];
+    simde__m128 rightGain[maxUnisonGroups];
+    for (unsigned g = 0; g < numGroups; ++g) {
+        phase[g] = simde_mm_load_ps(&phases[g * unisonLanes]);
+        ratio[g] = simde_mm_load_ps(&ratios[g * unisonLanes]);
+        leftGain[g] = simde_mm_load_ps(&leftLanes[g * unisonLanes]);
+        rightGain[g] = simde_mm_load_ps(&rightLanes[g * unisonLanes]);
+    }
+
+    const WavetableOscillator& first = *oscillators[0];
+    const WavetableMulti& multi = *first._multi;
+    const simde__m128 tableSize = simde_mm_set1_ps(static_cast<float>(multi.tableSize()));
+    const simde__m128 sampleInterval = simde_mm_set1_ps(first._sampleInterval);
+
+    for (unsigned i = 0; i < nframes; ++i) {
+        const float frequency = frequencies[i];
+        const simde__m128 frequencyLanes = simde_mm_set1_ps(frequency);
+        const simde__m128 mod = simde_mm_set1_ps(detuneMod ? detuneMod[i] : 1.0f);
+        const LaneTables<Dual> tables { multi, frequency };
+
+        simde__m128 mixLeft = simde_mm_setzero_ps();
+        simde__m128 mixRight = simde_mm_setzero_ps();
+        for (unsigned g = 0; g < numGroups; ++g) {
+            const simde__m128 position = simde_mm_mul_ps(phase[g], tableSize);
+            const simde__m128i index = simde_mm_cvttps_epi32(position);
+            const simde__m128 frac = simde_mm_sub_ps(position, simde_mm_cvtepi32_ps(index));
+            alignas(16) int indices[unisonLanes];
+            simde_mm_store_si128(reinterpret_cast<simde__m128i*>(indices), index);
+
+            const simde__m128 y = tables.template interpolate<M>(indices, frac);
+            mixLeft = simde_mm_add_ps(mixLeft, simde_mm_mul_ps(leftGain[g], y));
+            mixRight = simde_mm_add_ps(mixRight, simde_mm_mul_ps(rightGain[g], y));
+
+            const simde__m128 detune = simde_mm_mul_ps(ratio[g], mod);
+            const simde__m128 inc = simde_mm_mul_ps(frequencyLanes, simde_mm_mul_ps(detune, sampleInterval));
+            phase[g] = incrementAndWrapLanes(phase[g], inc);
+        }
+
+        // Sum the lanes: [L0+L2, R0+R2, L1+L3, R1+R3], then [L, R, ...]
+        simde__m128 sums = simde_mm_add_ps(
+            simde_mm_unpacklo_ps(mixLeft, mixRight), simde_mm_unpackhi_ps(mixLeft, mixRight));
+        sums = simde_mm_add_ps(sums, simde_mm_movehl_ps(sums, sums));
+        left[i] = simde_mm_cvtss_f32(sums);
+        right[i] = simde_mm_cvtss_f32(simde_mm_shuffle_ps(sums, sums, SIMDE_MM_SHUFFLE(1, 1, 1, 1)));
+    }
+
+    for (unsigned g = 0; g < numGroups; ++g)
+        simde_mm_store_ps(&phases[g * unisonLanes], phase[g]);
+    for (unsigned u = 0; u < numOscillators; ++u)
+        oscillators[u]->_phase = phases[u];
+}
+#endif
+
+void WavetableOscillator::processUnison(
+    WavetableOscillator* const oscillators[], unsigned numOscillators,
+    const float* frequencies, const float* detuneRatios, const float* detuneMod,
+    const float* leftGains, const float* rightGains,
+    float* left, float* right, unsigned nframes)
+{
+    if (numOscillators == 0) {
+        std::fill_n(left, nframes, 0.0f);
+        std::fill_n(right, nframes, 0.0f);
+        return;
+    }
+
+#if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
+    int quality = clamp(oscillators[0]->_quality, 0, 3);
+
+    switch (quality) {
+    case 0:
+        processUnisonLanes<kInterpolatorNearest, false>(oscillators, numOscillators, frequencies, detuneRatios, detuneMod, leftGains, rightGains, left, right, nframes);
+        break;
+    case 1:
+        processUnisonLanes<kInterpolatorLinear, false>(oscillators, numOscillators, frequencies, detuneRatios, detuneMod, leftGains, rightGains, left, right, nframes);
+        break;
+    case 2:
+        processUnisonLanes<kInterpolatorHermite3, false>(oscillators, numOscillators, frequencies, detuneRatios, detuneMod, leftGains, rightGains, left, right, nframes);
+        break;
+    case 3:
+        processUnisonLanes<kInterpolatorHermite3, true>(oscillators, numOscillators, frequencies, detuneRatios, detuneMod, leftGains, rightGains, left, right, nframes);
+        break;
+    }
+#else
+    // One oscillator after the other, by chunks
+    constexpr unsigned chunkSize = 64;
+    float detunes[chunkSize];
+    float output[chunkSize];
+    for (unsigned offset = 0; offset < nframes; offset += chunkSize) {
+        const unsigned count = std::min(chunkSize, nframes - offset);
+        for (unsigned u = 0; u < numOscillators; ++u) {
+            WavetableOscillator& osc = *oscillators[u];
+            for (unsigned i = 0; i < count; ++i)
+                detunes[i] = detuneRatios[u] * (detuneMod ? detuneMod[offset + i] : 1.0f);
+            osc.processModulated(frequencies + offset, detunes, output, count);
+            for (unsigned i = 0; i < count; ++i) {
+                left[offset + i] = (u == 0 ? 0.0f : left[offset + i]) + leftGains[u] * output[i];
+                right[offset + i] = (u == 0 ? 0.0f : right[offset + i]) + rightGains[u] * output[i];
+            }
+        }
+    }
+#endif
+}
+
 //------------------------------------------------------------------------------
 void HarmonicProfile::generate(
     absl::Span<float> table, double amplitude, double cutoff) const
@@ -392,19 +655,18 @@ WavetableMulti WavetableMulti::createForHarmonicProfile(
 
 const WavetableMulti* WavetableMulti::getSilenceWavetable()
 {
-    static WavetableMulti wm;
-    static bool initialized { false };
-
-    if (!initialized) {
+    // initialized once, even with several synths created concurrently
+    static const WavetableMulti wm = []() {
+        WavetableMulti silence;
         constexpr unsigned numTables = WavetableMulti::numTables();
-        wm.allocateStorage(1);
+        silence.allocateStorage(1);
         for (unsigned m = 0; m < numTables; ++m) {
-            float* ptr = const_cast<float*>(wm.getTablePointer(m));
+            float* ptr = const_cast<float*>(silence.getTablePointer(m));
             *ptr = 0;
         }
-        wm.fillExtra();
-        initialized = true;
-    }
+        silence.fillExtra();
+        return silence;
+    }();
     return &wm;
 }
 
@@ -468,10 +730,10 @@ private:
 
 WavetablePool::WavetablePool()
 {
-    getWaveSin();
-    getWaveTriangle();
-    getWaveSaw();
-    getWaveSquare();
+    // The oscillators fall back to silence on the audio thread, so it must
+    // exist beforehand; the standard waves build on the first load which
+    // uses them.
+    WavetableMulti::getSilenceWavetable();
 }
 
 const WavetableMulti* WavetablePool::getWaveSin()
@@ -499,6 +761,24 @@ const WavetableMulti* WavetablePool::getWaveSquare()
     return &wave;
 }
 
+const WavetableMulti* WavetablePool::getGeneratorWave(absl::string_view name)
+{
+    switch (hash(name)) {
+    default:
+    case hash("*silence"):
+        return nullptr;
+    case hash("*sine"):
+        return getWaveSin();
+    case hash("*triangle"): // fallthrough
+    case hash("*tri"):
+        return getWaveTriangle();
+    case hash("*square"):
+        return getWaveSquare();
+    case hash("*saw"):
+        return getWaveSaw();
+    }
+}
+
 const WavetableMulti* WavetablePool::getFileWave(const std::string& filename)
 {
     auto it = _fileWaves.find(filename);
@@ -513,27 +793,22 @@ void WavetablePool::clearFileWaves()
     _fileWaves.clear();
 }
 
-bool WavetablePool::createFileWave(FilePool& filePool, const std::string& filename)
+size_t WavetablePool::getMemoryUsage() const noexcept
 {
-    if (_fileWaves.contains(filename))
-        return true;
-
-    auto fileHandle = filePool.loadFile(FileId(filename));
-    if (!fileHandle)
-        return false;
-
-    if (fileHandle->information.numChannels > 1)
-        DBG("[sfizz] Only the first channel of " << filename << " will be used to create the wavetable");
+    size_t usage = 0;
+    for (const auto& wave : _fileWaves)
+        usage += wave.second->getMemoryUsage();
+    return usage;
+}
 
-    auto audioData = fileHandle->preloadedData.getConstSpan(0);
+//------------------------------------------------------------------------------
 
+WavetableMulti WavetableMulti::createForWaveform(
+    absl::Span<const float> waveform, unsigned tableSize, double refSampleRate)
+{
     // an even size is required for FFT
-    static_assert(absl::remove_reference_t<decltype(fileHandle->preloadedData)>::PaddingRight > 0,
-                  "Right padding is required on the audio file buffer");
-    if (audioData.size() & 1)
-        audioData = absl::MakeConstSpan(audioData.data(), audioData.size() + 1);
-
-    size_t fftSize = audioData.size();
+    ASSERT(waveform.size() % 2 == 0);
+    size_t fftSize = waveform.size();
     size_t specSize = fftSize / 2 + 1;
 
     typedef std::complex<kiss_fft_scalar> cpx;
@@ -543,7 +818,7 @@ bool WavetablePool::createFileWave(FilePool& filePool, const std::string& filena
     if (!cfg)
         throw std::bad_alloc();
 
-    kiss_fftr(cfg, audioData.data(), reinterpret_cast<kiss_fft_cpx*>(spec.get()));
+    kiss_fftr(cfg, waveform.data(), reinterpret_cast<kiss_fft_cpx*>(spec.get()));
     kiss_fftr_free(cfg);
 
     // scale transform, and normalize amplitude and phase
@@ -555,11 +830,168 @@ bool WavetablePool::createFileWave(FilePool& filePool, const std::string& filena
         absl::Span<const std::complex<float>> { spec.get(), specSize }
     };
 
-    auto wave = std::make_shared<WavetableMulti>(
-        WavetableMulti::createForHarmonicProfile(hp, 1.0));
+    return createForHarmonicProfile(hp, 1.0, tableSize, refSampleRate);
+}
+
+/**
+ * @brief The cache of the multisamples of file waves, in the cache directory
+ * of the file pool. The files are keyed by a hash of the waveform, the table
+ * size and the reference sample rate, which the headers repeat.
+ */
+struct WavetableCache {
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t tableSize;
+        double refSampleRate;
+        uint64_t waveformHash;
+        uint64_t waveformSize;
+        uint64_t dataSize;
+    };
+
+    static constexpr char magic[8] = { 'S', 'F', 'Z', 'W', 'A', 'V', 'E', 'S' };
+    static constexpr uint32_t version = 1;
 
-    _fileWaves[filename] = wave;
-    return true;
+    // FNV-1a, which stays the same from a run to the next
+    static uint64_t hashWaveform(absl::Span<const float> waveform)
+    {
+        uint64_t hash = 0xcbf29ce484222325u;
+        const auto* bytes = reinterpret_cast<const unsigned char*>(waveform.data());
+        for (size_t i = 0, n = waveform.size() * sizeof(float); i < n; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3u;
+        }
+        return hash;
+    }
+
+    static Header makeHeader(absl::Span<const float> waveform, unsigned tableSize, double refSampleRate)
+    {
+        Header header {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.tableSize = tableSize;
+        header.refSampleRate = refSampleRate;
+        header.waveformHash = hashWaveform(waveform);
+        header.waveformSize = waveform.size();
+        header.dataSize = (tableSize + 2 * WavetableMulti::_tableExtra) * WavetableMulti::numTables();
+        return header;
+    }
+
+    static fs::path getCacheFile(const fs::path& cacheDirectory, const Header& header)
+    {
+        const size_t hash = std::hash<std::string>()(absl::StrCat(
+            header.waveformHash, "|", header.waveformSize, "|", header.tableSize, "|", header.refSampleRate));
+        return cacheDirectory / absl::StrCat(absl::Hex(hash, absl::kZeroPad16), ".sfzwave");
+    }
+
+    static bool read(const fs::path& file, const Header& expected, WavetableMulti& wave)
+    {
+        fs::ifstream stream { file, std::ios::binary };
+        Header header;
+        if (!stream || !stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(&header, &expected, sizeof(header)) != 0)
+            return false;
+
+        wave.allocateStorage(expected.tableSize);
+        ASSERT(wave._multiData.size() == expected.dataSize);
+        const auto dataBytes = static_cast<std::streamsize>(expected.dataSize * sizeof(float));
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(wave._multiData.data()), dataBytes));
+    }
+
+    static void write(const fs::path& file, const Header& header, const WavetableMulti& wave)
+    {
+        std::error_code ec;
+        fs::create_directories(file.parent_path(), ec);
+        if (ec)
+            return;
+
+        writeFileAtomically(file, [&](std::ostream& stream) {
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(reinterpret_cast<const char*>(wave._multiData.data()),
+                static_cast<std::streamsize>(wave._multiData.size() * sizeof(float)));
+        });
+    }
+
+    static std::shared_ptr<WavetableMulti> getOrCreate(const fs::path& cacheDirectory, absl::Span<const float> waveform)
+    {
+        if (cacheDirectory.empty())
+            return std::make_shared<WavetableMulti>(WavetableMulti::createForWaveform(waveform));
+
+        const Header header = makeHeader(waveform, config::tableSize, config::tableRefSampleRate);
+        const fs::path file = getCacheFile(cacheDirectory, header);
+        auto wave = std::make_shared<WavetableMulti>();
+        if (read(file, header, *wave))
+            return wave;
+
+        wave = std::make_shared<WavetableMulti>(WavetableMulti::createForWaveform(waveform));
+        write(file, header, *wave);
+        return wave;
+    }
+};
+
+constexpr char WavetableCache::magic[8];
+constexpr uint32_t WavetableCache::version;
+
+bool WavetablePool::createFileWave(FilePool& filePool, const std::string& filename)
+{
+    createFileWaves(filePool, absl::MakeConstSpan(&filename, 1));
+    return _fileWaves.contains(filename);
+}
+
+void WavetablePool::createFileWaves(FilePool& filePool, absl::Span<const std::string> filenames)
+{
+    struct FileWave {
+        std::string filename;
+        FileDataHolder fileHandle;
+        absl::Span<const float> waveform;
+        std::shared_ptr<WavetableMulti> wave;
+    };
+
+    // The files load in order from the pool, which is not thread-safe
+    std::vector<FileWave> fileWaves;
+    fileWaves.reserve(filenames.size());
+    absl::flat_hash_set<absl::string_view> queued;
+    for (const std::string& filename : filenames) {
+        if (_fileWaves.contains(filename) || !queued.insert(filename).second)
+            continue;
+
+        auto fileHandle = filePool.loadFile(FileId(filename));
+        if (!fileHandle)
+            continue;
+
+        if (fileHandle->information.numChannels > 1)
+            DBG("[sfizz] Only the first channel of " << filename << " will be used to create the wavetable");
+
+        auto audioData = fileHandle->preloadedData->getConstSpan(0);
+
+        // an even size is required for FFT
+        static_assert(absl::remove_reference_t<decltype(*fileHandle->preloadedData)>::PaddingRight > 0,
+                      "Right padding is required on the audio file buffer");
+        if (audioData.size() & 1)
+            audioData = absl::MakeConstSpan(audioData.data(), audioData.size() + 1);
+
+        FileWave fileWave;
+        fileWave.filename = filename;
+        fileWave.fileHandle = std::move(fileHandle);
+        fileWave.waveform = audioData;
+        fileWaves.push_back(std::move(fileWave));
+    }
+
+    // The mipmaps build concurrently, or come from the cache
+    const fs::path& cacheDirectory = filePool.getCacheDirectory();
+    filePool.runLoadingTasks(fileWaves.size(), [&fileWaves, &cacheDirectory](size_t i) {
+        FileWave& fileWave = fileWaves[i];
+        try {
+            fileWave.wave = WavetableCache::getOrCreate(cacheDirectory, fileWave.waveform);
+        } catch (const std::bad_alloc&) {
+            DBG("[sfizz] Could not allocate the wavetable of " << fileWave.filename);
+        }
+    });
+
+    for (FileWave& fileWave : fileWaves) {
+        if (fileWave.wave)
+            _fileWaves[fileWave.filename] = std::move(fileWave.wave);
+    }
 }
 
 } // namespace sfz
@@ -11,6 +11,7 @@
 #include "utility/LeakDetector.h"
 #include <absl/types/span.h>
 #include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
 #include <array>
 #include <memory>
 #include <complex>
@@ -73,6 +74,30 @@ public:
      */
     void processModulated(const float* frequencies, const float* detuneRatios, float* output, unsigned nframes);
 
+    /**
+       Advance the phase as a cycle of processModulated would, without
+       computing the output. `detuneMod` has an element per frame, which
+       multiplies the detune ratio; it may be null.
+     */
+    void advance(const float* frequencies, float detuneRatio, const float* detuneMod, unsigned nframes);
+
+    /**
+       Compute a cycle of a unison of oscillators, with varying frequency, and
+       mix them into the left and right outputs.
+
+       The oscillators must have the same wavetable and quality. They run
+       together in the lanes of vector registers.
+
+       `detuneRatios`, `leftGains` and `rightGains` have an element per
+       oscillator. `detuneMod` has an element per frame, which multiplies all
+       the detune ratios; it may be null.
+     */
+    static void processUnison(
+        WavetableOscillator* const oscillators[], unsigned numOscillators,
+        const float* frequencies, const float* detuneRatios, const float* detuneMod,
+        const float* leftGains, const float* rightGains,
+        float* left, float* right, unsigned nframes);
+
 private:
     // single-table interpolation
     template <InterpolatorModel M>
@@ -86,6 +111,14 @@ private:
     template <InterpolatorModel M>
     void processModulatedDual(const float* frequencies, const float* detuneRatios, float* output, unsigned nframes);
 
+    // unison in vector lanes
+    template <InterpolatorModel M, bool Dual>
+    static void processUnisonLanes(
+        WavetableOscillator* const oscillators[], unsigned numOscillators,
+        const float* frequencies, const float* detuneRatios, const float* detuneMod,
+        const float* leftGains, const float* rightGains,
+        float* left, float* right, unsigned nframes);
+
 private:
     float _phase = 0.0f;
     float _sampleInterval = 0.0f;
@@ -218,10 +251,22 @@ public:
         unsigned tableSize = config::tableSize,
         double refSampleRate = config::tableRefSampleRate);
 
+    // create a multisample from a period of a waveform, such as the one of a
+    // sound file, of even size
+    static WavetableMulti createForWaveform(
+        absl::Span<const float> waveform,
+        unsigned tableSize = config::tableSize,
+        double refSampleRate = config::tableRefSampleRate);
+
     // get a tiny silent wavetable with null content for use with oscillators
     static const WavetableMulti* getSilenceWavetable();
 
+    // get the memory of the tables, in bytes
+    size_t getMemoryUsage() const noexcept { return _multiData.allocationSize() * sizeof(float); }
+
 private:
+    friend struct WavetableCache;
+
     // get a pointer to the beginning of the N-th table
     const float* getTablePointer(unsigned index) const
     {
@@ -270,16 +315,46 @@ struct WavetablePool {
      * @return true if the wavetable was correctly created (or existed already)
      */
     bool createFileWave(FilePool& filePool, const std::string& filename);
+    /**
+     * @brief Create the wavetables of several files, which do not exist yet.
+     * The tables build concurrently on the loading threads of the file pool,
+     * and persist in its cache directory, if any.
+     * This function is not real-time safe.
+     *
+     * @param filePool the file pool to use to load the files
+     * @param filenames the file names to load
+     */
+    void createFileWaves(FilePool& filePool, absl::Span<const std::string> filenames);
     /**
      * @brief Removes all the stored file waves from the wavetable pool.
      */
     void clearFileWaves();
+    /**
+     * @brief Get the memory of the file waves, in bytes. The predefined
+     * waves are shared by all the pools, and do not count.
+     */
+    size_t getMemoryUsage() const noexcept;
 
+    /**
+     * @brief Get the standard waves, which are built once per process on
+     * the first call, and shared immutably by all the pools. They do not
+     * depend on the sample rate, their harmonics being limited for the
+     * reference rate of the tables.
+     * This function is not real-time safe on the first call.
+     */
     static const WavetableMulti* getWaveSin();
     static const WavetableMulti* getWaveTriangle();
     static const WavetableMulti* getWaveSaw();
     static const WavetableMulti* getWaveSquare();
 
+    /**
+     * @brief Get the wave of a generator sample, such as `*sine`.
+     *
+     * @param name the name of the generator
+     * @return the wave, or null for the ones which play no wavetable
+     */
+    static const WavetableMulti* getGeneratorWave(absl::string_view name);
+
 private:
     absl::flat_hash_map<std::string, std::shared_ptr<WavetableMulti>> _fileWaves;
 };
@@ -12,7 +12,7 @@ namespace sfz {
 
 void WindowedSincDetail::calculateTable(absl::Span<float> table, size_t sincExtent, double beta, size_t extra)
 {
-    size_t tableSize = table.size();
+    size_t tableSize = table.size() - extra;
 
     auto window = absl::make_unique<float[]>(tableSize);
     kaiserWindow(beta, absl::MakeSpan(window.get(), tableSize));
@@ -27,7 +27,7 @@ void WindowedSincDetail::calculateTable(absl::Span<float> table, size_t sincExte
     }
 
     for (size_t i = 0; i < extra; ++i)
-        table[extra + i] = table[tableSize - 1];
+        table[tableSize + i] = table[tableSize - 1];
 }
 
 double WindowedSincDetail::calculateExact(double x, size_t sincExtent, double beta)
@@ -21,7 +21,7 @@ inline void AbstractWindowedSinc<T>::fillTable() noexcept
     size_t tableSize = static_cast<T*>(this)->getTableSize();
 
     WindowedSincDetail::calculateTable(
-        absl::MakeSpan(table, tableSize), points, beta_, TableExtra);
+        absl::MakeSpan(table, tableSize + TableExtra), points, beta_, TableExtra);
 }
 
 template <class T>
@@ -31,7 +31,7 @@ inline float AbstractWindowedSinc<T>::getUnchecked(float x) const noexcept
     size_t points = static_cast<const T*>(this)->getNumPoints();
     size_t tableSize = static_cast<const T*>(this)->getTableSize();
 
-    float ix = (x + points / 2.0f) * ((tableSize - 1) / points);
+    float ix = (x + points / 2.0f) * (float(tableSize - 1) / points);
     intptr_t i0 = static_cast<intptr_t>(ix);
     float mu = ix - i0;
     float y0 = table[i0];
@@ -49,7 +49,7 @@ inline simde__m128 AbstractWindowedSinc<T>::getUncheckedX4(simde__m128 x) const
 
     simde__m128 ix = simde_mm_mul_ps(
         simde_mm_add_ps(x, simde_mm_set1_ps(points / 2.0f)),
-        simde_mm_set1_ps((tableSize - 1) / points));
+        simde_mm_set1_ps(float(tableSize - 1) / points));
     alignas(simde__m128i) int j0[4];
     simde__m128i i0 = simde_mm_cvttps_epi32(ix);
     simde_mm_store_si128((simde__m128i*)j0, i0);
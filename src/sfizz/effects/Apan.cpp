@@ -23,6 +23,7 @@
 #include "Apan.h"
 #include "LFOCommon.h"
 #include "Opcode.h"
+#include "SIMDHelpers.h"
 #include "utility/Macros.h"
 #include <limits>
 #include <cmath>
@@ -56,21 +57,22 @@ namespace fx {
 
         computeLfos(modL, modR, nframes);
 
-        const float* inL = inputs[0];
-        const float* inR = inputs[1];
-        float* outL = outputs[0];
-        float* outR = outputs[1];
-
-        for (unsigned i = 0; i < nframes; ++i) {
-            float modDD = depth * 0.5f * (modL[i] - modR[i]); // LFO in ±depth
-
-            // uses a linear pan law
-            float gainL = 1 - modDD;
-            float gainR = 1 + modDD;
+        // The LFO in ±depth, with a linear pan law: the gains are
+        // `(1 ∓ modDD) * wet + dry`, where `modDD = depth * (modL - modR) / 2`
+        subtract<float>(modR, modL, nframes);
+        applyGain1(0.5f * depth * wet, modL, nframes);
+        fill(modR, wet + dry, nframes);
+        add<float>(modL, modR, nframes);
+        applyGain1(-1.0f, modL, nframes);
+        add1(wet + dry, modL, nframes);
+
+        applyGain<float>(modL, inputs[0], outputs[0], nframes);
+        applyGain<float>(modR, inputs[1], outputs[1], nframes);
+    }
 
-            outL[i] = inL[i] * (gainL * wet + dry);
-            outR[i] = inR[i] * (gainR * wet + dry);
-        }
+    double Apan::getTailTime() const
+    {
+        return 0.0;
     }
 
     std::unique_ptr<Effect> Apan::makeInstance(absl::Span<const Opcode> members)
@@ -127,20 +129,22 @@ namespace fx {
         float samplePeriod = _samplePeriod;
         float frequency = _lfoFrequency;
         float offset = _lfoPhaseOffset;
-        float phaseLeft = _lfoPhase;
+
+        // The phases go by a ramp, which leaves the evaluations independent
+        // of each other, so they vectorize
+        float phaseEnd = linearRamp<float>(left, _lfoPhase, frequency * samplePeriod, nframes);
 
         for (unsigned i = 0; i < nframes; ++i) {
+            float phaseLeft = left[i];
+            phaseLeft -= static_cast<int>(phaseLeft);
             float phaseRight = phaseLeft + offset;
             phaseRight -= static_cast<int>(phaseRight);
 
             left[i] = lfo::evaluateAtPhase<Wave>(phaseLeft);
             right[i] = lfo::evaluateAtPhase<Wave>(phaseRight);
-
-            phaseLeft += frequency * samplePeriod;
-            phaseLeft -= static_cast<int>(phaseLeft);
         }
 
-        _lfoPhase = phaseLeft;
+        _lfoPhase = phaseEnd - static_cast<int>(phaseEnd);
     }
 
 } // namespace fx
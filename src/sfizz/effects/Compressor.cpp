@@ -13,6 +13,7 @@
 - [x] comp_ratio          Ratio (linear gain)
 - [x] comp_threshold      Threshold (dB)
 - [x] comp_stlink         Stereo link (boolean)
+- [x] comp_oversampling   Oversampling factor, 1 to 8 (sfizz extension)
 
 */
 
@@ -23,8 +24,7 @@
 #include "MathHelpers.h"
 #include "OversamplerHelpers.h"
 #include "absl/memory/memory.h"
-
-static constexpr int _oversampling = 2;
+#include <algorithm>
 
 namespace sfz {
 namespace fx {
@@ -33,10 +33,15 @@ namespace fx {
         faustCompressor _compressor[2];
         bool _stlink { Default::compSTLink };
         float _inputGain { Default::compGain };
-        AudioBuffer<float, 2> _tempBuffer2x { 2, _oversampling * config::defaultSamplesPerBlock };
-        AudioBuffer<float, 2> _gain2x { 2, _oversampling * config::defaultSamplesPerBlock };
-        hiir::Downsampler2x<12> _downsampler2x[EffectChannels];
-        hiir::Upsampler2x<12> _upsampler2x[EffectChannels];
+        double _sampleRate { config::defaultSampleRate };
+        int _maxOversampling { Default::compOversampling };
+        int _oversampling { Default::compOversampling };
+        AudioBuffer<float, 2> _tempBufferOs { 2, config::maxEffectOversampling * config::defaultSamplesPerBlock };
+        AudioBuffer<float, 2> _gainOs { 2, config::maxEffectOversampling * config::defaultSamplesPerBlock };
+        std::unique_ptr<float[]> _resamplerTemp { new float[config::maxEffectOversampling * config::defaultSamplesPerBlock] };
+        int _resamplerTempSize { config::maxEffectOversampling * config::defaultSamplesPerBlock };
+        sfz::Downsampler _downsampler[EffectChannels];
+        sfz::Upsampler _upsampler[EffectChannels];
     };
 
     Compressor::Compressor()
@@ -54,14 +59,10 @@ namespace fx {
     void Compressor::setSampleRate(double sampleRate)
     {
         Impl& impl = *_impl;
+        impl._sampleRate = sampleRate;
         for (faustCompressor& comp : impl._compressor) {
-            comp.classInit(_oversampling * sampleRate);
-            comp.instanceConstants(_oversampling * sampleRate);
-        }
-
-        for (unsigned c = 0; c < EffectChannels; ++c) {
-            impl._downsampler2x[c].set_coefs(OSCoeffs2x);
-            impl._upsampler2x[c].set_coefs(OSCoeffs2x);
+            comp.classInit(impl._oversampling * sampleRate);
+            comp.instanceConstants(impl._oversampling * sampleRate);
         }
 
         clear();
@@ -70,8 +71,11 @@ namespace fx {
     void Compressor::setSamplesPerBlock(int samplesPerBlock)
     {
         Impl& impl = *_impl;
-        impl._tempBuffer2x.resize(_oversampling * samplesPerBlock);
-        impl._gain2x.resize(_oversampling * samplesPerBlock);
+        const int maxFrames = config::maxEffectOversampling * samplesPerBlock;
+        impl._tempBufferOs.resize(maxFrames);
+        impl._gainOs.resize(maxFrames);
+        impl._resamplerTemp.reset(new float[maxFrames]);
+        impl._resamplerTempSize = maxFrames;
     }
 
     void Compressor::clear()
@@ -79,70 +83,101 @@ namespace fx {
         Impl& impl = *_impl;
         for (faustCompressor& comp : impl._compressor)
             comp.instanceClear();
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            impl._downsampler[c].clear();
+            impl._upsampler[c].clear();
+        }
+    }
+
+    void Compressor::setQuality(int quality)
+    {
+        Impl& impl = *_impl;
+        const int oversampling = std::min(impl._maxOversampling, 1 << quality);
+        if (oversampling == impl._oversampling)
+            return;
+
+        impl._oversampling = oversampling;
+        for (faustCompressor& comp : impl._compressor)
+            comp.instanceConstants(oversampling * impl._sampleRate);
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            impl._downsampler[c].clear();
+            impl._upsampler[c].clear();
+        }
     }
 
     void Compressor::process(const float* const inputs[], float* const outputs[], unsigned nframes)
     {
         Impl& impl = *_impl;
-        auto inOut2x = AudioSpan<float>(impl._tempBuffer2x).first(_oversampling * nframes);
+        const int oversampling = impl._oversampling;
+        const unsigned nframesOs = oversampling * nframes;
+        auto inOutOs = AudioSpan<float>(impl._tempBufferOs).first(nframesOs);
 
-        absl::Span<float> left2x = inOut2x.getSpan(0);
-        absl::Span<float> right2x = inOut2x.getSpan(1);
+        absl::Span<float> leftOs = inOutOs.getSpan(0);
+        absl::Span<float> rightOs = inOutOs.getSpan(1);
 
-        impl._upsampler2x[0].process_block(left2x.data(), inputs[0], nframes);
-        impl._upsampler2x[1].process_block(right2x.data(), inputs[1], nframes);
+        float* temp = impl._resamplerTemp.get();
+        const int tempSize = impl._resamplerTempSize;
+        impl._upsampler[0].process(oversampling, inputs[0], leftOs.data(), nframes, temp, tempSize);
+        impl._upsampler[1].process(oversampling, inputs[1], rightOs.data(), nframes, temp, tempSize);
 
         const float inputGain = impl._inputGain;
-        for (unsigned i = 0; i < _oversampling * nframes; ++i) {
-            left2x[i] *= inputGain;
-            right2x[i] *= inputGain;
+        for (unsigned i = 0; i < nframesOs; ++i) {
+            leftOs[i] *= inputGain;
+            rightOs[i] *= inputGain;
         }
 
         if (!impl._stlink) {
-            absl::Span<float> leftGain2x = impl._gain2x.getSpan(0);
-            absl::Span<float> rightGain2x = impl._gain2x.getSpan(1);
+            absl::Span<float> leftGainOs = impl._gainOs.getSpan(0);
+            absl::Span<float> rightGainOs = impl._gainOs.getSpan(1);
 
             {
                 faustCompressor& comp = impl._compressor[0];
-                float* inputs[] = { left2x.data() };
-                float* outputs[] = { leftGain2x.data() };
-                comp.compute(_oversampling * nframes, inputs, outputs);
+                float* inputs[] = { leftOs.data() };
+                float* outputs[] = { leftGainOs.data() };
+                comp.compute(nframesOs, inputs, outputs);
             }
 
             {
                 faustCompressor& comp = impl._compressor[1];
-                float* inputs[] = { right2x.data() };
-                float* outputs[] = { rightGain2x.data() };
-                comp.compute(_oversampling * nframes, inputs, outputs);
+                float* inputs[] = { rightOs.data() };
+                float* outputs[] = { rightGainOs.data() };
+                comp.compute(nframesOs, inputs, outputs);
             }
 
-            for (unsigned i = 0; i < _oversampling * nframes; ++i) {
-                left2x[i] *= leftGain2x[i];
-                right2x[i] *= rightGain2x[i];
+            for (unsigned i = 0; i < nframesOs; ++i) {
+                leftOs[i] *= leftGainOs[i];
+                rightOs[i] *= rightGainOs[i];
             }
         }
         else {
-            absl::Span<float> compIn2x = impl._gain2x.getSpan(0);
-            for (unsigned i = 0; i < _oversampling * nframes; ++i)
-                compIn2x[i] = std::abs(left2x[i]) + std::abs(right2x[1]);
+            absl::Span<float> compInOs = impl._gainOs.getSpan(0);
+            for (unsigned i = 0; i < nframesOs; ++i)
+                compInOs[i] = std::abs(leftOs[i]) + std::abs(rightOs[i]);
 
-            absl::Span<float> gain2x = impl._gain2x.getSpan(1);
+            absl::Span<float> gainOs = impl._gainOs.getSpan(1);
 
             {
                 faustCompressor& comp = impl._compressor[0];
-                float* inputs[] = { compIn2x.data() };
-                float* outputs[] = { gain2x.data() };
-                comp.compute(_oversampling * nframes, inputs, outputs);
+                float* inputs[] = { compInOs.data() };
+                float* outputs[] = { gainOs.data() };
+                comp.compute(nframesOs, inputs, outputs);
             }
 
-            for (unsigned i = 0; i < _oversampling * nframes; ++i) {
-                left2x[i] *= gain2x[i];
-                right2x[i] *= gain2x[i];
+            for (unsigned i = 0; i < nframesOs; ++i) {
+                leftOs[i] *= gainOs[i];
+                rightOs[i] *= gainOs[i];
             }
         }
 
-        impl._downsampler2x[0].process_block(outputs[0], left2x.data(), nframes);
-        impl._downsampler2x[1].process_block(outputs[1], right2x.data(), nframes);
+        impl._downsampler[0].process(oversampling, leftOs.data(), outputs[0], nframes, temp, tempSize);
+        impl._downsampler[1].process(oversampling, rightOs.data(), outputs[1], nframes, temp, tempSize);
+    }
+
+    double Compressor::getTailTime() const
+    {
+        return 0.0;
     }
 
     std::unique_ptr<Effect> Compressor::makeInstance(absl::Span<const Opcode> members)
@@ -188,6 +223,10 @@ namespace fx {
             case hash("comp_stlink"):
                 impl._stlink = opc.read(Default::compSTLink);
                 break;
+            case hash("comp_oversampling"):
+                impl._maxOversampling = static_cast<int>(nextPow2(opc.read(Default::compOversampling)));
+                impl._oversampling = impl._maxOversampling;
+                break;
             }
         }
 
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/**
+   Note: this effect is a sfizz extension
+
+   Note: implementation status
+
+- [x] conv_ir       The impulse response, mono or stereo, relative to the file
+- [x] conv_dry      Dry (%)
+- [x] conv_wet      Wet (%)
+- [x] conv_gain     Gain of the wet signal (dB)
+
+   The convolution has no latency. Its direct head and the early partitions
+   run in the audio thread, and the late partitions on the background
+   workers; see PartitionedConvolver.
+ */
+
+#include "Convolution.h"
+#include "impl/PartitionedConvolver.h"
+#include "FilePool.h"
+#include "Opcode.h"
+#include "utility/StringViewHelpers.h"
+#include "utility/Debug.h"
+#include <absl/strings/str_replace.h>
+#include <algorithm>
+#include <cmath>
+
+namespace sfz {
+namespace fx {
+
+    Convolution::Convolution()
+    {
+        for (auto& convolver : _convolvers)
+            convolver.reset(new PartitionedConvolver(config::convolutionHeadSize, config::convolutionTailPartitionSize));
+    }
+
+    Convolution::~Convolution()
+    {
+    }
+
+    void Convolution::setSampleRate(double sampleRate)
+    {
+        if (sampleRate == _sampleRate)
+            return;
+
+        _sampleRate = sampleRate;
+        updateImpulseResponse();
+    }
+
+    void Convolution::setSamplesPerBlock(int samplesPerBlock)
+    {
+        _tempBuffer.resize(samplesPerBlock);
+    }
+
+    void Convolution::clear()
+    {
+        for (auto& convolver : _convolvers)
+            convolver->clear();
+    }
+
+    void Convolution::process(const float* const inputs[], float* const outputs[], unsigned nframes)
+    {
+        const float dry = _dry;
+        const float wet = _wet * _gain;
+
+        // The outputs can be the inputs
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            absl::Span<float> convolved = _tempBuffer.getSpan(c).first(nframes);
+            _convolvers[c]->process(inputs[c], convolved.data(), nframes);
+            for (unsigned i = 0; i < nframes; ++i)
+                outputs[c][i] = dry * inputs[c][i] + wet * convolved[i];
+        }
+    }
+
+    double Convolution::getTailTime() const
+    {
+        return _impulseLength / _sampleRate;
+    }
+
+    void Convolution::loadFiles(FilePool& filePool)
+    {
+        std::string filename = absl::StrReplaceAll(trim(_filename), { { "\\", "/" } });
+        if (filename.empty())
+            return;
+
+        if (!filePool.checkSample(filename)) {
+            DBG("[sfizz] Cannot find the impulse response " << filename);
+            return;
+        }
+
+        FileDataHolder fileData = filePool.loadFile(FileId(filename));
+        if (!fileData || !fileData->preloadedData) {
+            DBG("[sfizz] Cannot load the impulse response " << filename);
+            return;
+        }
+
+        const FileAudioBuffer& data = *fileData->preloadedData;
+        _numImpulseChannels = static_cast<unsigned>(std::min<size_t>(data.getNumChannels(), EffectChannels));
+        for (unsigned c = 0; c < _numImpulseChannels; ++c) {
+            const auto channel = data.getConstSpan(c);
+            _impulse[c].assign(channel.begin(), channel.end());
+        }
+        _impulseSampleRate = fileData->information.sampleRate;
+
+        updateImpulseResponse();
+    }
+
+    void Convolution::updateImpulseResponse()
+    {
+        if (_numImpulseChannels == 0)
+            return;
+
+        // Resample linearly if the file is at another rate, keeping the gain
+        const double ratio = _impulseSampleRate / _sampleRate;
+        const size_t inputLength = _impulse[0].size();
+        _impulseLength = (ratio == 1.0) ? inputLength :
+            static_cast<size_t>(std::ceil(inputLength / ratio));
+
+        std::vector<float> resampled(_impulseLength);
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            const std::vector<float>& impulse = _impulse[std::min(c, _numImpulseChannels - 1)];
+            if (ratio == 1.0) {
+                _convolvers[c]->setImpulseResponse(impulse);
+                continue;
+            }
+
+            for (size_t i = 0; i < _impulseLength; ++i) {
+                const double position = i * ratio;
+                const size_t index = static_cast<size_t>(position);
+                const float mu = static_cast<float>(position - index);
+                const float x0 = (index < inputLength) ? impulse[index] : 0.0f;
+                const float x1 = (index + 1 < inputLength) ? impulse[index + 1] : 0.0f;
+                resampled[i] = static_cast<float>(ratio) * (x0 + mu * (x1 - x0));
+            }
+            _convolvers[c]->setImpulseResponse(resampled);
+        }
+    }
+
+    std::unique_ptr<Effect> Convolution::makeInstance(absl::Span<const Opcode> members)
+    {
+        Convolution* convolution = new Convolution;
+        std::unique_ptr<Effect> fx { convolution };
+
+        for (const Opcode& opc : members) {
+            switch (opc.lettersOnlyHash) {
+            case hash("conv_ir"):
+                convolution->_filename = opc.value;
+                break;
+            case hash("conv_dry"):
+                convolution->_dry = opc.read(Default::convDry);
+                break;
+            case hash("conv_wet"):
+                convolution->_wet = opc.read(Default::convWet);
+                break;
+            case hash("conv_gain"):
+                convolution->_gain = opc.read(Default::convGain);
+                break;
+            }
+        }
+
+        return fx;
+    }
+
+} // namespace fx
+} // namespace sfz
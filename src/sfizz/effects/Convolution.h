@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Effects.h"
+#include "AudioBuffer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sfz {
+namespace fx {
+
+    class PartitionedConvolver;
+
+    /**
+     * @brief Convolution with an impulse response file
+     */
+    class Convolution : public Effect {
+    public:
+        Convolution();
+        ~Convolution();
+
+        /**
+         * @brief Initializes with the given sample rate.
+         */
+        void setSampleRate(double sampleRate) override;
+
+        /**
+         * @brief Sets the maximum number of frames to render at a time. The actual
+         * value can be lower but should never be higher.
+         */
+        void setSamplesPerBlock(int samplesPerBlock) override;
+
+        /**
+         * @brief Reset the state to initial.
+         */
+        void clear() override;
+
+        /**
+         * @brief Computes a cycle of the effect in stereo.
+         */
+        void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
+
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
+        /**
+         * @brief Loads the impulse response.
+         */
+        void loadFiles(FilePool& filePool) override;
+
+        /**
+          * @brief Instantiates given the contents of the <effect> block.
+          */
+        static std::unique_ptr<Effect> makeInstance(absl::Span<const Opcode> members);
+
+    private:
+        /**
+         * @brief Sets the response of the convolvers, at the sample rate.
+         */
+        void updateImpulseResponse();
+
+        std::string _filename;
+        float _dry { Default::convDry };
+        float _wet { Default::convWet };
+        float _gain { Default::convGain };
+        double _sampleRate { config::defaultSampleRate };
+
+        // The response as in the file, mono or stereo
+        std::vector<float> _impulse[EffectChannels];
+        unsigned _numImpulseChannels { 0 };
+        double _impulseSampleRate { config::defaultSampleRate };
+        size_t _impulseLength { 0 }; // at the sample rate
+
+        std::unique_ptr<PartitionedConvolver> _convolvers[EffectChannels];
+        AudioBuffer<float, EffectChannels> _tempBuffer { EffectChannels, config::defaultSamplesPerBlock };
+    };
+
+} // namespace fx
+} // namespace sfz
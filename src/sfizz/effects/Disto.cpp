@@ -16,6 +16,11 @@
 - [ ] disto_dry_oncc
 - [x] disto_wet
 - [ ] disto_wet_oncc
+- [x] disto_oversampling (sfizz extension)
+
+   The oversampling is the highest, limited by the effect quality of the
+   synth. It drops while the signal is too low for the stages to produce
+   harmonics that would alias, and comes back as soon as the level rises.
 */
 
 #include "Disto.h"
@@ -25,9 +30,11 @@
 #include "MathHelpers.h"
 #include "OversamplerHelpers.h"
 #include <absl/types/span.h>
+#include <algorithm>
 #include <cmath>
 
-static constexpr int _oversampling = 8;
+// Time for which the level stays low before the oversampling drops
+static constexpr double _oversamplingHoldTime = 0.1; // s
 
 namespace sfz {
 namespace fx {
@@ -41,6 +48,11 @@ struct Disto::Impl {
     float _dry { Default::effect };
     float _wet { Default::effect };
     unsigned _numStages = { Default::distoStages };
+    double _sampleRate { config::defaultSampleRate };
+    int _opcodeOversampling { Default::distoOversampling };
+    int _maxOversampling { Default::distoOversampling }; // with the quality
+    int _oversampling { Default::distoOversampling }; // current
+    int _holdFrames { 0 }; // left before the oversampling drops
 
     float _toneLpfMem[EffectChannels] = {};
     faustDisto _stages[EffectChannels][Default::maxDistoStages];
@@ -48,6 +60,7 @@ struct Disto::Impl {
     sfz::Upsampler _upsampler[EffectChannels];
     sfz::Downsampler _downsampler[EffectChannels];
     std::unique_ptr<float[]> _temp[2];
+    int _tempSize { 0 };
 
     // use the same formula as reverb
     float toneCutoff() const noexcept
@@ -55,8 +68,51 @@ struct Disto::Impl {
         float mk = 21.0f + _tone * 1.08f;
         return 440.0f * std::exp2((mk - 69.0f) * (1.0f / 12.0f));
     }
+
+    // The lowest oversampling for the stages to not alias, given the peak
+    // of their input
+    int requiredOversampling(float peak) const noexcept;
+    void setOversampling(int oversampling);
 };
 
+int Disto::Impl::requiredOversampling(float peak) const noexcept
+{
+    if (_wet == 0.0f)
+        return 1;
+
+    // The sigmoid is about linear under a drive of 1/4, and its harmonics
+    // grow with the drive; a stage amplifies by drive/2 until it saturates
+    const float a = _depth * 0.2f + 2.0f;
+    float x = peak;
+    float drive = 0.0f;
+    for (unsigned s = 0; s < _numStages; ++s) {
+        drive = std::max(drive, a * x);
+        x = std::min(2.0f, 0.5f * a * x);
+    }
+
+    if (drive < 0.25f)
+        return 1;
+    if (drive < 1.0f)
+        return 2;
+    if (drive < 4.0f)
+        return 4;
+    return 8;
+}
+
+void Disto::Impl::setOversampling(int oversampling)
+{
+    if (oversampling == _oversampling)
+        return;
+
+    _oversampling = oversampling;
+    for (unsigned c = 0; c < EffectChannels; ++c) {
+        for (faustDisto& stage : _stages[c])
+            stage.instanceConstants(oversampling * _sampleRate);
+        _downsampler[c].clear();
+        _upsampler[c].clear();
+    }
+}
+
 Disto::Disto()
     : _impl(new Impl)
 {
@@ -64,7 +120,7 @@ Disto::Disto()
 
     for (unsigned c = 0; c < EffectChannels; ++c) {
         for (faustDisto& stage : impl._stages[c])
-            stage.init(_oversampling * config::defaultSampleRate);
+            stage.init(impl._oversampling * config::defaultSampleRate);
     }
 }
 
@@ -76,11 +132,12 @@ void Disto::setSampleRate(double sampleRate)
 {
     Impl& impl = *_impl;
     impl._samplePeriod = 1.0 / sampleRate;
+    impl._sampleRate = sampleRate;
 
     for (unsigned c = 0; c < EffectChannels; ++c) {
         for (faustDisto& stage : impl._stages[c]) {
-            stage.classInit(_oversampling * sampleRate);
-            stage.instanceConstants(_oversampling * sampleRate);
+            stage.classInit(impl._oversampling * sampleRate);
+            stage.instanceConstants(impl._oversampling * sampleRate);
         }
     }
 
@@ -92,7 +149,8 @@ void Disto::setSamplesPerBlock(int samplesPerBlock)
     Impl& impl = *_impl;
 
     for (std::unique_ptr<float[]>& temp : impl._temp)
-        temp.reset(new float[_oversampling * samplesPerBlock]);
+        temp.reset(new float[config::maxEffectOversampling * samplesPerBlock]);
+    impl._tempSize = config::maxEffectOversampling * samplesPerBlock;
 }
 
 void Disto::clear()
@@ -108,6 +166,15 @@ void Disto::clear()
         impl._downsampler[c].clear();
         impl._upsampler[c].clear();
     }
+
+    impl._holdFrames = 0;
+}
+
+void Disto::setQuality(int quality)
+{
+    Impl& impl = *_impl;
+    impl._maxOversampling = std::min(impl._opcodeOversampling, 1 << quality);
+    impl.setOversampling(std::min(impl._oversampling, impl._maxOversampling));
 }
 
 void Disto::process(const float* const inputs[], float* const outputs[], unsigned nframes)
@@ -120,6 +187,7 @@ void Disto::process(const float* const inputs[], float* const outputs[], unsigne
     const float depth = impl._depth;
     const float toneLpfPole = std::exp(float(-2.0 * M_PI) * impl.toneCutoff() * impl._samplePeriod);
 
+    float peak = 0.0f;
     for (unsigned c = 0; c < EffectChannels; ++c) {
         // compute LPF
         absl::Span<const float> channelIn(inputs[c], nframes);
@@ -130,15 +198,32 @@ void Disto::process(const float* const inputs[], float* const outputs[], unsigne
             //           `dry=0 wet=<any>`, it is the same behavior as reference
             lpfMem = channelIn[i] * dry * (1.0f - toneLpfPole) + lpfMem * toneLpfPole;
             lpfOut[i] = lpfMem;
+            peak = std::max(peak, std::abs(lpfMem));
         }
         impl._toneLpfMem[c] = lpfMem;
+    }
+
+    // raise the oversampling at once, and lower it once the level held
+    const int required = std::min(impl.requiredOversampling(peak), impl._maxOversampling);
+    if (required >= impl._oversampling) {
+        impl.setOversampling(required);
+        impl._holdFrames = static_cast<int>(_oversamplingHoldTime * impl._sampleRate);
+    }
+    else if ((impl._holdFrames -= static_cast<int>(nframes)) <= 0)
+        impl.setOversampling(required);
+
+    const int oversampling = impl._oversampling;
+
+    for (unsigned c = 0; c < EffectChannels; ++c) {
+        absl::Span<const float> channelIn(inputs[c], nframes);
+        absl::Span<float> lpfOut(outputs[c], nframes);
 
         // upsample
         absl::Span<float> temp[2] = {
-            absl::Span<float>(impl._temp[0].get(), _oversampling * nframes),
-            absl::Span<float>(impl._temp[1].get(), _oversampling * nframes),
+            absl::Span<float>(impl._temp[0].get(), oversampling * nframes),
+            absl::Span<float>(impl._temp[1].get(), impl._tempSize),
         };
-        impl._upsampler[c].process(_oversampling, lpfOut.data(), temp[0].data(), nframes, temp[1].data(), static_cast<int>(temp[1].size()));
+        impl._upsampler[c].process(oversampling, lpfOut.data(), temp[0].data(), nframes, temp[1].data(), static_cast<int>(temp[1].size()));
         absl::Span<float> upsamplerOut = temp[0];
 
         // run disto stages
@@ -149,11 +234,11 @@ void Disto::process(const float* const inputs[], float* const outputs[], unsigne
             //
             float *faustIn[] = { stageInOut.data() };
             float *faustOut[] = { stageInOut.data() };
-            impl._stages[c][s].compute(_oversampling * nframes, faustIn, faustOut);
+            impl._stages[c][s].compute(oversampling * nframes, faustIn, faustOut);
         }
 
         // downsample
-        impl._downsampler[c].process(_oversampling, stageInOut.data(), outputs[c], nframes, temp[1].data(), static_cast<int>(temp[1].size()));
+        impl._downsampler[c].process(oversampling, stageInOut.data(), outputs[c], nframes, temp[1].data(), static_cast<int>(temp[1].size()));
 
         // dry/wet mix
         absl::Span<float> mixOut(outputs[c], nframes);
@@ -162,6 +247,11 @@ void Disto::process(const float* const inputs[], float* const outputs[], unsigne
     }
 }
 
+double Disto::getTailTime() const
+{
+    return 0.0;
+}
+
 std::unique_ptr<Effect> Disto::makeInstance(absl::Span<const Opcode> members)
 {
     Disto* disto = new Disto;
@@ -186,6 +276,11 @@ std::unique_ptr<Effect> Disto::makeInstance(absl::Span<const Opcode> members)
         case hash("disto_wet"):
             impl._wet = opc.read(Default::effect);
             break;
+        case hash("disto_oversampling"):
+            impl._opcodeOversampling = static_cast<int>(nextPow2(opc.read(Default::distoOversampling)));
+            impl._maxOversampling = impl._opcodeOversampling;
+            impl.setOversampling(impl._opcodeOversampling);
+            break;
         }
     }
 
@@ -40,6 +40,16 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
+        /**
+         * @brief Sets the quality, which limits the oversampling.
+         */
+        void setQuality(int quality) override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
@@ -29,38 +29,34 @@ namespace fx {
     Eq::Eq(const EQDescription& desc)
         : _desc(desc)
     {
-        _filter.setType(desc.type);
-        _filter.setChannels(2);
+        _band.setType(desc.type);
     }
 
     void Eq::setSampleRate(double sampleRate)
     {
-        _filter.init(sampleRate);
+        _band.init(sampleRate);
         prepareFilter();
     }
 
     void Eq::setSamplesPerBlock(int samplesPerBlock)
     {
-        _tempBuffer.resize(samplesPerBlock);
+        (void)samplesPerBlock;
     }
 
     void Eq::clear()
     {
-        _filter.clear();
         prepareFilter();
     }
 
     void Eq::process(const float* const inputs[], float* const outputs[], unsigned nframes)
     {
-        absl::Span<float> cutoff = _tempBuffer.getSpan(0).first(nframes);
-        absl::Span<float> bw = _tempBuffer.getSpan(1).first(nframes);
-        absl::Span<float> pksh = _tempBuffer.getSpan(2).first(nframes);
-
-        sfz::fill(cutoff, _desc.frequency);
-        sfz::fill(bw, _desc.bandwidth);
-        sfz::fill(pksh, _desc.gain);
+        EqBand* band = &_band;
+        EqCascade::process(&band, 1, inputs, outputs, EffectChannels, nframes);
+    }
 
-        _filter.processModulated(inputs, outputs, cutoff.data(), bw.data(), pksh.data(), nframes);
+    double Eq::getTailTime() const
+    {
+        return 0.0;
     }
 
     std::unique_ptr<Effect> Eq::makeInstance(absl::Span<const Opcode> members)
@@ -91,7 +87,7 @@ namespace fx {
 
     void Eq::prepareFilter()
     {
-        _filter.prepare(_desc.frequency, _desc.bandwidth, _desc.gain);
+        _band.prepare(_desc.frequency, _desc.bandwidth, _desc.gain);
     }
 
 } // namespace fx
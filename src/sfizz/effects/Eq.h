@@ -7,7 +7,7 @@
 #pragma once
 #include "Effects.h"
 #include "EQDescription.h"
-#include "SfzFilter.h"
+#include "EqCascade.h"
 
 namespace sfz {
 namespace fx {
@@ -40,6 +40,11 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
@@ -49,9 +54,8 @@ namespace fx {
         void prepareFilter();
 
     private:
-        sfz::FilterEq _filter;
+        sfz::EqBand _band;
         EQDescription _desc;
-        AudioBuffer<float, 3> _tempBuffer { 3, config::defaultSamplesPerBlock };
     };
 
 } // namespace fx
@@ -65,6 +65,11 @@ namespace fx {
         _filter.processModulated(inputs, outputs, cutoff.data(), q.data(), pksh.data(), nframes);
     }
 
+    double Filter::getTailTime() const
+    {
+        return 0.0;
+    }
+
     std::unique_ptr<Effect> Filter::makeInstance(absl::Span<const Opcode> members)
     {
         FilterDescription desc;
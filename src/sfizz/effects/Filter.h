@@ -40,6 +40,11 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
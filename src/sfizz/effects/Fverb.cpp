@@ -9,8 +9,11 @@
 #include "Opcode.h"
 #include "Config.h"
 #include "MathHelpers.h"
+#include "AudioBuffer.h"
+#include "OversamplerHelpers.h"
 #include <absl/memory/memory.h>
 #include <absl/strings/ascii.h>
+#include <algorithm>
 #include <cmath>
 
 /**
@@ -31,6 +34,17 @@
 - [ ] reverb_tone_oncc
 - [x] reverb_damp
 - [ ] reverb_damp_oncc
+- [x] reverb_quality (sfizz extension)
+
+   The quality tiers trade the bandwidth of the reverberation for CPU:
+   - 2 (high): the whole network runs at the sample rate.
+   - 1 (medium): the network runs at half the sample rate, between a pair of
+     half-band filters; this costs about 70% of the high tier.
+   - 0 (low): the network runs at a quarter of the sample rate, the wet
+     signal being band-limited to an eighth of it; this costs about 50% of
+     the high tier.
+   The dry signal is mixed at the full rate in every tier, and the lower
+   tiers delay the wet signal by a few frames.
  */
 
 namespace sfz {
@@ -38,6 +52,30 @@ namespace fx {
 
     struct Fverb::Impl {
         faustFverb dsp;
+        float predelay { Default::fverbPredelay }; // s
+        double sampleRate { config::defaultSampleRate };
+
+        // The network runs at sampleRate / factor below the high tier
+        static constexpr unsigned maxFactor = 4;
+        unsigned factor { 1 };
+        float dry { 1.0f }; // mixed outside of the network, below the high tier
+
+        AudioBuffer<float, 2> fullRate { 2, config::defaultSamplesPerBlock + maxFactor };
+        AudioBuffer<float, 2> halfRate { 2, config::defaultSamplesPerBlock / 2 + maxFactor };
+        AudioBuffer<float, 2> wetFullRate { 2, config::defaultSamplesPerBlock + maxFactor };
+        hiir::Downsampler2x<4> downsampler4x[EffectChannels]; // full to half rate
+        hiir::Downsampler2x<12> downsampler2x[EffectChannels]; // to the network rate
+        hiir::Upsampler2x<12> upsampler2x[EffectChannels]; // from the network rate
+        hiir::Upsampler2x<4> upsampler4x[EffectChannels]; // half to full rate
+
+        // The frames left over when the block is not a multiple of the factor;
+        // the sum of both counts is always factor - 1
+        float pendingInputs[EffectChannels][maxFactor] {};
+        float pendingOutputs[EffectChannels][maxFactor] {};
+        unsigned numPendingInputs { 0 };
+        unsigned numPendingOutputs { 0 };
+
+        void processSubRate(const float* const inputs[], float* const outputs[], unsigned nframes);
 
         struct Profile {
             float tailDensity; // %
@@ -140,15 +178,27 @@ namespace fx {
         Impl& impl = *impl_;
         auto& dsp = impl.dsp;
 
-        dsp.classInit(sampleRate);
-        dsp.instanceConstants(sampleRate);
+        impl.sampleRate = sampleRate;
+        dsp.classInit(sampleRate / impl.factor);
+        dsp.instanceConstants(sampleRate / impl.factor);
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            impl.downsampler4x[c].set_coefs(OSCoeffs4x);
+            impl.downsampler2x[c].set_coefs(OSCoeffs2x);
+            impl.upsampler2x[c].set_coefs(OSCoeffs2x);
+            impl.upsampler4x[c].set_coefs(OSCoeffs4x);
+        }
 
         clear();
     }
 
     void Fverb::setSamplesPerBlock(int samplesPerBlock)
     {
-        (void)samplesPerBlock;
+        Impl& impl = *impl_;
+
+        impl.fullRate.resize(samplesPerBlock + Impl::maxFactor);
+        impl.halfRate.resize(samplesPerBlock / 2 + Impl::maxFactor);
+        impl.wetFullRate.resize(samplesPerBlock + Impl::maxFactor);
     }
 
     void Fverb::clear()
@@ -157,6 +207,18 @@ namespace fx {
         auto& dsp = impl.dsp;
 
         dsp.instanceClear();
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            impl.downsampler4x[c].clear_buffers();
+            impl.downsampler2x[c].clear_buffers();
+            impl.upsampler2x[c].clear_buffers();
+            impl.upsampler4x[c].clear_buffers();
+        }
+
+        impl.numPendingInputs = 0;
+        impl.numPendingOutputs = impl.factor - 1;
+        for (unsigned c = 0; c < EffectChannels; ++c)
+            std::fill_n(impl.pendingOutputs[c], Impl::maxFactor, 0.0f);
     }
 
     void Fverb::process(const float* const inputs[], float* const outputs[], unsigned nframes)
@@ -164,7 +226,85 @@ namespace fx {
         Impl& impl = *impl_;
         auto& dsp = impl.dsp;
 
-        dsp.compute(nframes, const_cast<float**>(inputs), const_cast<float**>(outputs));
+        if (impl.factor == 1)
+            dsp.compute(nframes, const_cast<float**>(inputs), const_cast<float**>(outputs));
+        else
+            impl.processSubRate(inputs, outputs, nframes);
+    }
+
+    void Fverb::Impl::processSubRate(const float* const inputs[], float* const outputs[], unsigned nframes)
+    {
+        const unsigned numInputs = numPendingInputs + nframes;
+        const unsigned numSubFrames = numInputs / factor;
+        const unsigned numProcessed = numSubFrames * factor;
+
+        // Queue the inputs after the ones left from the previous block
+        float* fullPtrs[EffectChannels];
+        float* halfPtrs[EffectChannels];
+        float* wetPtrs[EffectChannels];
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            fullPtrs[c] = fullRate.getSpan(c).data();
+            halfPtrs[c] = halfRate.getSpan(c).data();
+            wetPtrs[c] = wetFullRate.getSpan(c).data();
+            std::copy_n(pendingInputs[c], numPendingInputs, fullPtrs[c]);
+            std::copy_n(inputs[c], nframes, fullPtrs[c] + numPendingInputs);
+        }
+
+        // Keep the inputs which make no complete frame at the network rate
+        const unsigned numLeftInputs = numInputs - numProcessed;
+        for (unsigned c = 0; c < EffectChannels; ++c)
+            std::copy_n(fullPtrs[c] + numProcessed, numLeftInputs, pendingInputs[c]);
+
+        for (unsigned c = 0; c < EffectChannels; ++c)
+            std::copy_n(pendingOutputs[c], numPendingOutputs, wetPtrs[c]);
+
+        if (numSubFrames > 0) {
+            // Down to the network rate, in place at the start of the full rate buffer
+            for (unsigned c = 0; c < EffectChannels; ++c) {
+                if (factor == 4) {
+                    downsampler4x[c].process_block(halfPtrs[c], fullPtrs[c], 2 * numSubFrames);
+                    downsampler2x[c].process_block(fullPtrs[c], halfPtrs[c], numSubFrames);
+                }
+                else
+                    downsampler2x[c].process_block(fullPtrs[c], fullPtrs[c], numSubFrames);
+            }
+
+            dsp.compute(numSubFrames, fullPtrs, fullPtrs);
+
+            // Up to the full rate, after the outputs left from the previous block
+            for (unsigned c = 0; c < EffectChannels; ++c) {
+                float* wet = wetPtrs[c] + numPendingOutputs;
+                if (factor == 4) {
+                    upsampler2x[c].process_block(halfPtrs[c], fullPtrs[c], numSubFrames);
+                    upsampler4x[c].process_block(wet, halfPtrs[c], 2 * numSubFrames);
+                }
+                else
+                    upsampler2x[c].process_block(wet, fullPtrs[c], numSubFrames);
+            }
+        }
+
+        const unsigned numWet = numPendingOutputs + numProcessed;
+        ASSERT(numWet >= nframes);
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            const float* input = inputs[c];
+            const float* wet = wetPtrs[c];
+            float* output = outputs[c];
+            for (unsigned i = 0; i < nframes; ++i)
+                output[i] = dry * input[i] + wet[i];
+            std::copy_n(wet + nframes, numWet - nframes, pendingOutputs[c]);
+        }
+
+        numPendingInputs = numLeftInputs;
+        numPendingOutputs = numWet - nframes;
+    }
+
+    double Fverb::getTailTime() const
+    {
+        // The reverberation decays, but it only appears after the pre-delay
+        // and the diffusion, which is under a second at the largest size
+        const double diffusionTime = 1.0;
+        const double latency = (impl_->factor - 1) / impl_->sampleRate;
+        return impl_->predelay + diffusionTime + latency;
     }
 
     std::unique_ptr<Effect> Fverb::makeInstance(absl::Span<const Opcode> members)
@@ -180,6 +320,7 @@ namespace fx {
         float predelay { Default::fverbPredelay };
         float tone { Default::fverbTone };
         float damp { Default::fverbDamp };
+        int32_t quality { Default::fverbQuality };
 
         for (const Opcode& opc : members) {
             switch (opc.lettersOnlyHash) {
@@ -225,6 +366,9 @@ namespace fx {
             case hash("reverb_damp"):
                 damp = opc.read(Default::fverbDamp);
                 break;
+            case hash("reverb_quality"):
+                quality = opc.read(Default::fverbQuality);
+                break;
             }
         }
 
@@ -234,12 +378,20 @@ namespace fx {
 
         Impl& impl = *reverb->impl_;
         faustFverb& dsp = impl.dsp;
+        impl.predelay = predelay;
+        impl.factor = (quality >= 2) ? 1 : (quality == 1) ? 2 : 4;
+        reverb->setSampleRate(impl.sampleRate);
         dsp.setPredelay(predelay * 1e3);
         dsp.setTailDensity(profile->tailDensity);
         dsp.setDecay(decayMax * size * 0.01f + decayMin * (1.0f - size * 0.01f));
         dsp.setModulatorFrequency(profile->modulationFrequency);
         dsp.setModulatorDepth(profile->modulationDepth);
-        dsp.setDry(profile->dry * dry * 0.01f);
+        if (impl.factor == 1)
+            dsp.setDry(profile->dry * dry * 0.01f);
+        else {
+            dsp.setDry(0.0f);
+            impl.dry = profile->dry * dry * 1e-4f;
+        }
         dsp.setWet(profile->wet * wet * 0.01f);
         dsp.setInputAmount(input);
         dsp.setInputLowPassCutoff(Impl::lpfCutoff(tone));
@@ -16,6 +16,7 @@
 
 #include "Gain.h"
 #include "Opcode.h"
+#include "MathHelpers.h"
 #include "SIMDHelpers.h"
 #include "absl/memory/memory.h"
 
@@ -29,7 +30,7 @@ namespace fx {
 
     void Gain::setSamplesPerBlock(int samplesPerBlock)
     {
-        _tempBuffer.resize(samplesPerBlock);
+        (void)samplesPerBlock;
     }
 
     void Gain::clear()
@@ -38,20 +39,16 @@ namespace fx {
 
     void Gain::process(const float* const inputs[], float* const outputs[], unsigned nframes)
     {
-        const float baseGain = _gain;
+        // the gain is not modulated, so it converts to linear once
+        const float gain = db2mag(_gain);
 
-        absl::Span<float> gains = _tempBuffer.getSpan(0);
-        std::fill(gains.begin(), gains.end(), baseGain);
-
-        // to linear
-        for (unsigned i = 0; i < nframes; ++i)
-            gains[i] = std::pow(10.0f, 0.05f * gains[i]);
+        for (unsigned c = 0; c < EffectChannels; ++c)
+            sfz::applyGain1(gain, inputs[c], outputs[c], nframes);
+    }
 
-        for (unsigned c = 0; c < EffectChannels; ++c) {
-            absl::Span<const float> input { inputs[c], nframes };
-            absl::Span<float> output { outputs[c], nframes };
-            sfz::applyGain(absl::Span<const float> { gains }, input, output);
-        }
+    double Gain::getTailTime() const
+    {
+        return 0.0;
     }
 
     std::unique_ptr<Effect> Gain::makeInstance(absl::Span<const Opcode> members)
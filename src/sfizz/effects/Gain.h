@@ -36,6 +36,11 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
@@ -43,7 +48,6 @@ namespace fx {
 
     private:
         float _gain = 0; // in dB
-        AudioBuffer<float, 1> _tempBuffer { 1, config::defaultSamplesPerBlock };
     };
 
 } // namespace fx
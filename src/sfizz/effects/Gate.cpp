@@ -25,6 +25,7 @@
 #include "AudioSpan.h"
 #include "MathHelpers.h"
 #include "OversamplerHelpers.h"
+#include "SIMDHelpers.h"
 #include "absl/memory/memory.h"
 
 static constexpr int _oversampling = 2;
@@ -96,10 +97,8 @@ namespace fx {
         impl._upsampler2x[1].process_block(right2x.data(), inputs[1], nframes);
 
         const float inputGain = impl._inputGain;
-        for (unsigned i = 0; i < _oversampling * nframes; ++i) {
-            left2x[i] *= inputGain;
-            right2x[i] *= inputGain;
-        }
+        applyGain1(inputGain, left2x);
+        applyGain1(inputGain, right2x);
 
         if (!impl._stlink) {
             absl::Span<float> leftGain2x = impl._gain2x.getSpan(0);
@@ -119,15 +118,13 @@ namespace fx {
                 gate.compute(_oversampling * nframes, inputs, outputs);
             }
 
-            for (unsigned i = 0; i < _oversampling * nframes; ++i) {
-                left2x[i] *= leftGain2x[i];
-                right2x[i] *= rightGain2x[i];
-            }
+            applyGain<float>(leftGain2x.first(left2x.size()), left2x);
+            applyGain<float>(rightGain2x.first(right2x.size()), right2x);
         }
         else {
             absl::Span<float> gateIn2x = impl._gain2x.getSpan(0);
             for (unsigned i = 0; i < _oversampling * nframes; ++i)
-                gateIn2x[i] = std::abs(left2x[i]) + std::abs(right2x[1]);
+                gateIn2x[i] = std::abs(left2x[i]) + std::abs(right2x[i]);
 
             absl::Span<float> gain2x = impl._gain2x.getSpan(1);
 
@@ -138,16 +135,19 @@ namespace fx {
                 gate.compute(_oversampling * nframes, inputs, outputs);
             }
 
-            for (unsigned i = 0; i < _oversampling * nframes; ++i) {
-                left2x[i] *= gain2x[i];
-                right2x[i] *= gain2x[i];
-            }
+            applyGain<float>(gain2x.first(left2x.size()), left2x);
+            applyGain<float>(gain2x.first(right2x.size()), right2x);
         }
 
         impl._downsampler2x[0].process_block(outputs[0], left2x.data(), nframes);
         impl._downsampler2x[1].process_block(outputs[1], right2x.data(), nframes);
     }
 
+    double Gate::getTailTime() const
+    {
+        return 0.0;
+    }
+
     std::unique_ptr<Effect> Gate::makeInstance(absl::Span<const Opcode> members)
     {
         Gate* gate = new Gate;
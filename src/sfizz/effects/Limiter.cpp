@@ -7,16 +7,16 @@
 /*
    Note(jpc): implementation status
 
-   Complete (no opcodes)
+- [x] limiter_oversampling   Oversampling factor, 1 to 8 (sfizz extension)
 */
 
 #include "Limiter.h"
 #include "gen/limiter.hxx"
 #include "Opcode.h"
 #include "AudioSpan.h"
+#include "MathHelpers.h"
 #include "absl/memory/memory.h"
-
-static constexpr int _oversampling = 2;
+#include <algorithm>
 
 namespace sfz {
 namespace fx {
@@ -33,38 +33,64 @@ namespace fx {
 
     void Limiter::setSampleRate(double sampleRate)
     {
+        _sampleRate = sampleRate;
         _limiter->classInit(_oversampling * sampleRate);
         _limiter->instanceConstants(_oversampling * sampleRate);
 
-        for (unsigned c = 0; c < EffectChannels; ++c) {
-            _downsampler2x[c].set_coefs(OSCoeffs2x);
-            _upsampler2x[c].set_coefs(OSCoeffs2x);
-        }
-
         clear();
     }
 
     void Limiter::setSamplesPerBlock(int samplesPerBlock)
     {
-        _tempBuffer2x.resize(2 * samplesPerBlock);
+        const int maxFrames = config::maxEffectOversampling * samplesPerBlock;
+        _tempBufferOs.resize(maxFrames);
+        _resamplerTemp.reset(new float[maxFrames]);
+        _resamplerTempSize = maxFrames;
     }
 
     void Limiter::clear()
     {
         _limiter->instanceClear();
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            _downsampler[c].clear();
+            _upsampler[c].clear();
+        }
+    }
+
+    void Limiter::setQuality(int quality)
+    {
+        const int oversampling = std::min(_maxOversampling, 1 << quality);
+        if (oversampling == _oversampling)
+            return;
+
+        _oversampling = oversampling;
+        _limiter->instanceConstants(oversampling * _sampleRate);
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            _downsampler[c].clear();
+            _upsampler[c].clear();
+        }
     }
 
     void Limiter::process(const float* const inputs[], float* const outputs[], unsigned nframes)
     {
-        auto inOut2x = AudioSpan<float>( _tempBuffer2x).first(2 * nframes);
+        const int oversampling = _oversampling;
+        auto inOutOs = AudioSpan<float>(_tempBufferOs).first(oversampling * nframes);
+        float* temp = _resamplerTemp.get();
 
         for (unsigned c = 0; c < EffectChannels; ++c)
-            _upsampler2x[c].process_block(inOut2x.getSpan(c).data(), inputs[c], nframes);
+            _upsampler[c].process(oversampling, inputs[c], inOutOs.getSpan(c).data(), nframes, temp, _resamplerTempSize);
 
-        _limiter->compute(2 * nframes, inOut2x, inOut2x);
+        _limiter->compute(oversampling * nframes, inOutOs, inOutOs);
 
         for (unsigned c = 0; c < EffectChannels; ++c)
-            _downsampler2x[c].process_block(outputs[c], inOut2x.getSpan(c).data(), nframes);
+            _downsampler[c].process(oversampling, inOutOs.getSpan(c).data(), outputs[c], nframes, temp, _resamplerTempSize);
+    }
+
+    double Limiter::getTailTime() const
+    {
+        return 0.0;
     }
 
     std::unique_ptr<Effect> Limiter::makeInstance(absl::Span<const Opcode> members)
@@ -73,8 +99,12 @@ namespace fx {
         std::unique_ptr<Effect> fx { limiter };
 
         for (const Opcode& opc : members) {
-            // no opcodes
-            (void)opc;
+            switch (opc.lettersOnlyHash) {
+            case hash("limiter_oversampling"):
+                limiter->_maxOversampling = static_cast<int>(nextPow2(opc.read(Default::limiterOversampling)));
+                limiter->_oversampling = limiter->_maxOversampling;
+                break;
+            }
         }
 
         return fx;
@@ -41,6 +41,16 @@ namespace fx {
           */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
+        /**
+         * @brief Sets the quality, which limits the oversampling.
+         */
+        void setQuality(int quality) override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
@@ -48,9 +58,14 @@ namespace fx {
 
     private:
         std::unique_ptr<faustLimiter> _limiter;
-        AudioBuffer<float, 2> _tempBuffer2x { 2, 2 * config::defaultSamplesPerBlock };
-        hiir::Downsampler2x<12> _downsampler2x[EffectChannels];
-        hiir::Upsampler2x<12> _upsampler2x[EffectChannels];
+        double _sampleRate { config::defaultSampleRate };
+        int _maxOversampling { Default::limiterOversampling };
+        int _oversampling { Default::limiterOversampling };
+        AudioBuffer<float, 2> _tempBufferOs { 2, config::maxEffectOversampling * config::defaultSamplesPerBlock };
+        std::unique_ptr<float[]> _resamplerTemp { new float[config::maxEffectOversampling * config::defaultSamplesPerBlock] };
+        int _resamplerTempSize { config::maxEffectOversampling * config::defaultSamplesPerBlock };
+        sfz::Downsampler _downsampler[EffectChannels];
+        sfz::Upsampler _upsampler[EffectChannels];
     };
 
 } // namespace fx
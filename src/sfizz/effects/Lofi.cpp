@@ -55,7 +55,10 @@ namespace fx {
 
     void Lofi::setSamplesPerBlock(int samplesPerBlock)
     {
-        (void)samplesPerBlock;
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            _bitred[c].setSamplesPerBlock(samplesPerBlock);
+            _decim[c].setSamplesPerBlock(samplesPerBlock);
+        }
     }
 
     void Lofi::clear()
@@ -77,6 +80,11 @@ namespace fx {
         }
     }
 
+    double Lofi::getTailTime() const
+    {
+        return 0.0;
+    }
+
     std::unique_ptr<Effect> Lofi::makeInstance(absl::Span<const Opcode> members)
     {
         Lofi* lofi = new Lofi;
@@ -96,6 +104,24 @@ namespace fx {
         return fx;
     }
 
+    /**
+     * @brief Oversample a stepped signal, with the midpoints of the steps
+     * between the frames. The frames which repeat the last value have it
+     * for their midpoint too.
+     */
+    static void interpolateSteps2x(const float* y, float lastValue, float* y2x, uint32_t nframes)
+    {
+        if (nframes == 0)
+            return;
+
+        y2x[0] = 0.5f * (y[0] + lastValue);
+        y2x[1] = y[0];
+        for (uint32_t i = 1; i < nframes; ++i) {
+            y2x[2 * i] = 0.5f * (y[i] + y[i - 1]);
+            y2x[2 * i + 1] = y[i];
+        }
+    }
+
     ///
     void Lofi::Bitred::init(double sampleRate)
     {
@@ -104,6 +130,11 @@ namespace fx {
         fDownsampler2x.set_coefs(OSCoeffs2x);
     }
 
+    void Lofi::Bitred::setSamplesPerBlock(int samplesPerBlock)
+    {
+        fTemp2x.resize(2 * samplesPerBlock);
+    }
+
     void Lofi::Bitred::clear()
     {
         fLastValue = 0.0;
@@ -124,27 +155,25 @@ namespace fx {
             return;
         }
 
-        float lastValue = fLastValue;
+        if (nframes == 0)
+            return;
+
+        const float lastValue = fLastValue;
 
         const float steps = (1.0f + (100.0f - fDepth)) * 0.75f;
         const float invSteps = 1.0f / steps;
-        float y2x[4] { 0.0f, 0.0f, 0.0f, 0.0f };
 
+        // the quantization of each frame is independent, it vectorizes
         for (uint32_t i = 0; i < nframes; ++i) {
             float x = in[i];
-
-            float y = std::copysign((int)(0.5f + std::fabs(x * steps)), x) * invSteps; // NOLINT
-
-            y2x[0] = (y != lastValue) ? (0.5f * (y + lastValue)) : y;
-            y2x[1] = y;
-
-            lastValue = y;
-
-            y = fDownsampler2x.process_sample(y2x);
-            out[i] = y;
+            out[i] = std::copysign((int)(0.5f + std::fabs(x * steps)), x) * invSteps; // NOLINT
         }
 
-        fLastValue = lastValue;
+        float* y2x = fTemp2x.getSpan(0).data();
+        interpolateSteps2x(out, lastValue, y2x, nframes);
+        fLastValue = out[nframes - 1];
+
+        fDownsampler2x.process_block(out, y2x, nframes);
     }
 
     ///
@@ -155,6 +184,11 @@ namespace fx {
         fDownsampler2x.set_coefs(OSCoeffs2x);
     }
 
+    void Lofi::Decim::setSamplesPerBlock(int samplesPerBlock)
+    {
+        fTemp2x.resize(2 * samplesPerBlock);
+    }
+
     void Lofi::Decim::clear()
     {
         fPhase = 0.0;
@@ -184,9 +218,10 @@ namespace fx {
         }();
 
         float phase = fPhase;
-        float lastValue = fLastValue;
-        float y2x[4] { 0.0f, 0.0f, 0.0f, 0.0f };
+        const float initialValue = fLastValue;
+        float lastValue = initialValue;
 
+        // the sample and hold, then the oversampling by blocks
         for (uint32_t i = 0; i < nframes; ++i) {
             float x = in[i];
 
@@ -194,15 +229,15 @@ namespace fx {
             float y = (phase > 1.0f) ? x : lastValue;
             phase -= static_cast<float>(static_cast<int>(phase));
 
-            y2x[0] = (y != lastValue) ? (0.5f * (y + lastValue)) : y;
-            y2x[1] = y;
-
             lastValue = y;
-
-            y = fDownsampler2x.process_sample(y2x);
             out[i] = y;
         }
 
+        float* y2x = fTemp2x.getSpan(0).data();
+        interpolateSteps2x(out, initialValue, y2x, nframes);
+
+        fDownsampler2x.process_block(out, y2x, nframes);
+
         fPhase = phase;
         fLastValue = lastValue;
     }
@@ -37,6 +37,11 @@ namespace fx {
           */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
@@ -50,6 +55,7 @@ namespace fx {
         class Bitred {
         public:
             void init(double sampleRate);
+            void setSamplesPerBlock(int samplesPerBlock);
             void clear();
             void setDepth(float depth);
             void process(const float* in, float* out, uint32_t nframes);
@@ -58,12 +64,14 @@ namespace fx {
             float fDepth = 0.0;
             float fLastValue = 0.0;
             hiir::Downsampler2x<12> fDownsampler2x;
+            AudioBuffer<float, 1> fTemp2x { 1, 2 * config::defaultSamplesPerBlock };
         };
 
         ///
         class Decim {
         public:
             void init(double sampleRate);
+            void setSamplesPerBlock(int samplesPerBlock);
             void clear();
             void setDepth(float depth);
             void process(const float* in, float* out, uint32_t nframes);
@@ -74,6 +82,7 @@ namespace fx {
             float fPhase = 0.0;
             float fLastValue = 0.0;
             hiir::Downsampler2x<12> fDownsampler2x;
+            AudioBuffer<float, 1> fTemp2x { 1, 2 * config::defaultSamplesPerBlock };
         };
 
         ///
@@ -32,5 +32,10 @@ namespace fx {
         }
     }
 
+    double Nothing::getTailTime() const
+    {
+        return 0.0;
+    }
+
 } // namespace fx
 } // namespace sfz
@@ -35,6 +35,11 @@ namespace fx {
          * @brief Copy the input signal to the output
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
+
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
     };
 
 } // namespace fx
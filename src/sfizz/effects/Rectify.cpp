@@ -36,7 +36,7 @@ namespace fx {
 
     void Rectify::setSamplesPerBlock(int samplesPerBlock)
     {
-        _tempBuffer.resize(samplesPerBlock);
+        _tempBuffer2x.resize(2 * samplesPerBlock);
     }
 
     void Rectify::clear()
@@ -51,34 +51,29 @@ namespace fx {
     {
         // Note(jpc) I define opcode `rectify` to be a mix amount.
         //           half-wave rectification is achieved simply by halving it.
-        const float baseAmount = _amount * (_full ? 1.0f : 0.5f);
+        const float amount = normalizePercents(_amount * (_full ? 1.0f : 0.5f));
 
-        absl::Span<float> amounts = _tempBuffer.getSpan(0);
-        std::fill(amounts.begin(), amounts.end(), baseAmount);
+        float* temp2x = _tempBuffer2x.getSpan(0).data();
 
         for (unsigned c = 0; c < EffectChannels; ++c) {
-            const float *input = inputs[c];
-            float *output = outputs[c];
+            // the resampling goes by blocks, and the rectification of the
+            // oversampled block vectorizes
+            _upsampler2x[c].process_block(temp2x, inputs[c], nframes);
 
-            auto &up2x = _upsampler2x[c];
-            auto &down2x = _downsampler2x[c];
-
-            for (unsigned i = 0; i < nframes; ++i) {
-                const float amount = normalizePercents(amounts[i]);
-                float in = input[i];
-
-                float in2x[2];
-                up2x.process_sample(in2x[0], in2x[1], in);
-
-                float out2x[2];
-                out2x[0] = amount * std::fabs(in2x[0]) + (1.0f - amount) * in2x[0];
-                out2x[1] = amount * std::fabs(in2x[1]) + (1.0f - amount) * in2x[1];
-
-                output[i] = down2x.process_sample(out2x);
+            for (unsigned i = 0; i < 2 * nframes; ++i) {
+                const float in = temp2x[i];
+                temp2x[i] = amount * std::fabs(in) + (1.0f - amount) * in;
             }
+
+            _downsampler2x[c].process_block(outputs[c], temp2x, nframes);
         }
     }
 
+    double Rectify::getTailTime() const
+    {
+        return 0.0;
+    }
+
     std::unique_ptr<Effect> Rectify::makeInstance(absl::Span<const Opcode> members)
     {
         Rectify* rectify = new Rectify;
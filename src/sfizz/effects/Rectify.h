@@ -39,13 +39,18 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Gets the time for which the output can lag the input.
+         */
+        double getTailTime() const override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
         static std::unique_ptr<Effect> makeInstance(absl::Span<const Opcode> members);
 
     private:
-        AudioBuffer<float, 1> _tempBuffer { 1, config::defaultSamplesPerBlock };
+        AudioBuffer<float, 1> _tempBuffer2x { 1, 2 * config::defaultSamplesPerBlock };
         hiir::Downsampler2x<12> _downsampler2x[2];
         hiir::Upsampler2x<12> _upsampler2x[2];
 
@@ -19,6 +19,8 @@ Extensions
 #include "impl/ResonantArray.h"
 #include "impl/ResonantArraySSE.h"
 #include "impl/ResonantArrayAVX.h"
+#include "impl/ResonantArrayAVX512.h"
+#include "impl/ResonantArrayNEON.h"
 #include "Opcode.h"
 #include "MathHelpers.h"
 #include "SIMDHelpers.h"
@@ -35,10 +37,16 @@ namespace fx {
 
 #if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
         cpuid::cpuinfo cpuInfo;
-        if (cpuInfo.has_avx())
+        if (cpuInfo.has_avx512_f())
+            array = new ResonantArrayAVX512;
+        else if (cpuInfo.has_avx())
             array = new ResonantArrayAVX;
         else if (cpuInfo.has_sse())
             array = new ResonantArraySSE;
+#elif SFIZZ_HAVE_NEON
+        cpuid::cpuinfo cpuInfo;
+        if (cpuInfo.has_neon())
+            array = new ResonantArrayNEON;
 #endif
         if (!array)
             array = new ResonantArrayScalar;
@@ -124,6 +132,11 @@ namespace fx {
         sfz::multiplyAdd<float>(wet, resOutput, outputR);
     }
 
+    double Strings::getTailTime() const
+    {
+        return 0.0;
+    }
+
     std::unique_ptr<Effect> Strings::makeInstance(absl::Span<const Opcode> members)
     {
         Strings* strings = new Strings;
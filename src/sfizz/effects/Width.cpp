@@ -17,6 +17,7 @@
 #include "Width.h"
 #include "Panning.h"
 #include "Opcode.h"
+#include "SIMDHelpers.h"
 #include "absl/memory/memory.h"
 
 namespace sfz {
@@ -38,27 +39,24 @@ namespace fx {
 
     void Width::process(const float* const inputs[], float* const outputs[], unsigned nframes)
     {
-        const float baseWidth = _width;
-
-        absl::Span<float> widths = _tempBuffer.getSpan(0);
-        std::fill(widths.begin(), widths.end(), baseWidth);
-
-        absl::Span<const float> input1 { inputs[0], nframes };
-        absl::Span<const float> input2 { inputs[1], nframes };
-        absl::Span<float> output1 { outputs[0], nframes };
-        absl::Span<float> output2 { outputs[1], nframes };
-
-        for (unsigned i = 0; i < nframes; ++i) {
-            const float l = input1[i];
-            const float r = input2[i];
-
-            const float w = clamp((widths[i] + 100.0f) * 0.005f, 0.0f, 1.0f);
-            const float coeff1 = panLookup(w);
-            const float coeff2 = panLookup(1.0f - w);
+        // the width is not modulated, so the matrix is the same for the block
+        const float w = clamp((_width + 100.0f) * 0.005f, 0.0f, 1.0f);
+        const float coeff1 = panLaw(w);
+        const float coeff2 = panLaw(1.0f - w);
+
+        // the outputs may be the inputs: the left goes to the temporary
+        // buffer, until the right has read the left input
+        float* left = _tempBuffer.getSpan(0).data();
+        applyGain1(coeff2, inputs[0], left, nframes);
+        multiplyAdd1(coeff1, inputs[1], left, nframes);
+        applyGain1(coeff2, inputs[1], outputs[1], nframes);
+        multiplyAdd1(coeff1, inputs[0], outputs[1], nframes);
+        copy(left, outputs[0], nframes);
+    }
 
-            output1[i] = l * coeff2 + r * coeff1;
-            output2[i] = l * coeff1 + r * coeff2;
-        }
+    double Width::getTailTime() const
+    {
+        return 0.0;
     }
 
     std::unique_ptr<Effect> Width::makeInstance(absl::Span<const Opcode> members)
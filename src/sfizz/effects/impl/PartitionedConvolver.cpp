@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "PartitionedConvolver.h"
+#include "utility/Debug.h"
+#include <kiss_fftr.h>
+#include <algorithm>
+#include <new>
+
+namespace sfz {
+namespace fx {
+
+static void freeFft(kiss_fftr_state* fft)
+{
+    kiss_fftr_free(fft);
+}
+
+static kiss_fftr_state* allocateFft(unsigned size, bool inverse)
+{
+    kiss_fftr_state* fft = kiss_fftr_alloc(static_cast<int>(size), inverse, nullptr, nullptr);
+    if (!fft)
+        throw std::bad_alloc();
+    return fft;
+}
+
+static kiss_fft_cpx* asComplex(std::vector<float>& data) noexcept
+{
+    static_assert(sizeof(kiss_fft_cpx) == 2 * sizeof(float), "The complex numbers must be pairs of floats");
+    return reinterpret_cast<kiss_fft_cpx*>(data.data());
+}
+
+//------------------------------------------------------------------------------
+
+PartitionedConvolver::Stage::Stage(unsigned partitionSize)
+    : partitionSize(partitionSize),
+      numBins(partitionSize + 1),
+      forward(allocateFft(2 * partitionSize, false), &freeFft),
+      inverse(allocateFft(2 * partitionSize, true), &freeFft),
+      outputSpectrum(2 * numBins),
+      outputFrame(2 * partitionSize)
+{
+}
+
+void PartitionedConvolver::Stage::setPartitions(absl::Span<const float> impulse)
+{
+    numPartitions = static_cast<unsigned>((impulse.size() + partitionSize - 1) / partitionSize);
+    spectra.assign(2 * numBins * numPartitions, 0.0f);
+    delayLine.assign(2 * numBins * numPartitions, 0.0f);
+    delayLineHead = 0;
+
+    // Zero-padded to twice the partition size, and scaled for the inverse
+    // transform, which is not normalized
+    const float scale = 1.0f / (2 * partitionSize);
+    std::vector<float> frame(2 * partitionSize);
+    for (unsigned p = 0; p < numPartitions; ++p) {
+        std::fill(frame.begin(), frame.end(), 0.0f);
+        const auto partition = impulse.subspan(p * partitionSize, partitionSize);
+        std::transform(partition.begin(), partition.end(), frame.begin(),
+            [scale](float x) { return x * scale; });
+        kiss_fftr(forward.get(), frame.data(),
+            reinterpret_cast<kiss_fft_cpx*>(&spectra[2 * numBins * p]));
+    }
+}
+
+void PartitionedConvolver::Stage::clear() noexcept
+{
+    std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+    delayLineHead = 0;
+}
+
+void PartitionedConvolver::Stage::compute(const float* input, float* output) noexcept
+{
+    if (numPartitions == 0)
+        return;
+
+    // The newest input goes in front of the delay line, which is circular
+    delayLineHead = (delayLineHead + numPartitions - 1) % numPartitions;
+    kiss_fftr(forward.get(), input,
+        reinterpret_cast<kiss_fft_cpx*>(&delayLine[2 * numBins * delayLineHead]));
+
+    std::fill(outputSpectrum.begin(), outputSpectrum.end(), 0.0f);
+    float* acc = outputSpectrum.data();
+    for (unsigned p = 0; p < numPartitions; ++p) {
+        const unsigned d = (delayLineHead + p) % numPartitions;
+        const float* x = &delayLine[2 * numBins * d];
+        const float* h = &spectra[2 * numBins * p];
+        for (unsigned b = 0; b < numBins; ++b) {
+            const float xr = x[2 * b], xi = x[2 * b + 1];
+            const float hr = h[2 * b], hi = h[2 * b + 1];
+            acc[2 * b] += xr * hr - xi * hi;
+            acc[2 * b + 1] += xr * hi + xi * hr;
+        }
+    }
+
+    kiss_fftri(inverse.get(), asComplex(outputSpectrum), outputFrame.data());
+
+    // The first half wraps around, the second half is the convolution
+    std::copy_n(outputFrame.data() + partitionSize, partitionSize, output);
+}
+
+//------------------------------------------------------------------------------
+
+PartitionedConvolver::PartitionedConvolver(unsigned headSize, unsigned tailPartitionSize)
+    : headSize_(headSize),
+      tailPartitionSize_(tailPartitionSize),
+      headInput_(2 * headSize),
+      body_(headSize),
+      bodyOutput_(headSize),
+      tail_(tailPartitionSize),
+      tailInput_(2 * tailPartitionSize),
+      tailTaskInput_(2 * tailPartitionSize),
+      tailOutput_(tailPartitionSize),
+      tailTaskOutput_(tailPartitionSize)
+{
+    ASSERT(tailPartitionSize % headSize == 0);
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+    TaskScheduler::wait(tailTask_);
+}
+
+void PartitionedConvolver::setImpulseResponse(absl::Span<const float> impulse)
+{
+    TaskScheduler::wait(tailTask_);
+
+    // The body ends where the tail can start, one partition ahead of its
+    // output
+    const size_t bodyEnd = 2 * tailPartitionSize_;
+
+    const auto head = impulse.first(std::min<size_t>(headSize_, impulse.size()));
+    head_.assign(head.rbegin(), head.rend());
+
+    body_.setPartitions(impulse.size() > headSize_ ?
+        impulse.subspan(headSize_, bodyEnd - headSize_) : absl::Span<const float> {});
+    tail_.setPartitions(impulse.size() > bodyEnd ?
+        impulse.subspan(bodyEnd) : absl::Span<const float> {});
+
+    if (tail_.numPartitions > 0 && !scheduler_)
+        scheduler_ = TaskScheduler::getGlobal();
+
+    clear();
+}
+
+void PartitionedConvolver::clear() noexcept
+{
+    TaskScheduler::wait(tailTask_);
+    tailPending_ = false;
+
+    std::fill(headInput_.begin(), headInput_.end(), 0.0f);
+    headPosition_ = 0;
+
+    body_.clear();
+    std::fill(bodyOutput_.begin(), bodyOutput_.end(), 0.0f);
+
+    tail_.clear();
+    std::fill(tailInput_.begin(), tailInput_.end(), 0.0f);
+    std::fill(tailOutput_.begin(), tailOutput_.end(), 0.0f);
+    std::fill(tailTaskOutput_.begin(), tailTaskOutput_.end(), 0.0f);
+    tailPosition_ = 0;
+}
+
+void PartitionedConvolver::process(const float* input, float* output, unsigned nframes) noexcept
+{
+    const unsigned headLength = static_cast<unsigned>(head_.size());
+    const bool hasBody = body_.numPartitions > 0;
+    const bool hasTail = tail_.numPartitions > 0;
+
+    // Go by chunks up to the next head partition, which ends the tail
+    // partitions as well
+    while (nframes > 0) {
+        const unsigned chunk = std::min(nframes, headSize_ - headPosition_);
+
+        float* headInput = headInput_.data() + headSize_ + headPosition_;
+        std::copy_n(input, chunk, headInput);
+        if (hasTail)
+            std::copy_n(input, chunk, tailInput_.data() + tailPartitionSize_ + tailPosition_);
+
+        const float* bodyOutput = bodyOutput_.data() + headPosition_;
+        const float* tailOutput = tailOutput_.data() + tailPosition_;
+        const float* head = head_.data();
+        for (unsigned i = 0; i < chunk; ++i) {
+            const float* x = headInput + i + 1 - headLength;
+            float y = 0.0f;
+            for (unsigned k = 0; k < headLength; ++k)
+                y += head[k] * x[k];
+            output[i] = y + bodyOutput[i] + tailOutput[i];
+        }
+
+        input += chunk;
+        output += chunk;
+        nframes -= chunk;
+        headPosition_ += chunk;
+        tailPosition_ += chunk;
+
+        if (headPosition_ == headSize_) {
+            if (hasBody)
+                body_.compute(headInput_.data(), bodyOutput_.data());
+            std::copy_n(headInput_.data() + headSize_, headSize_, headInput_.data());
+            headPosition_ = 0;
+        }
+
+        if (tailPosition_ == tailPartitionSize_) {
+            if (hasTail) {
+                finishTail();
+                startTail();
+            }
+            tailPosition_ = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::finishTail() noexcept
+{
+    // The output is due from now on; wait if the workers are late
+    if (tailPending_) {
+        TaskScheduler::wait(tailTask_);
+        tailPending_ = false;
+    }
+    std::swap(tailOutput_, tailTaskOutput_);
+}
+
+void PartitionedConvolver::startTail() noexcept
+{
+    std::copy(tailInput_.begin(), tailInput_.end(), tailTaskInput_.begin());
+    std::copy_n(tailInput_.data() + tailPartitionSize_, tailPartitionSize_, tailInput_.data());
+
+    if (scheduler_ && scheduler_->schedule(tailTask_, TaskScheduler::Priority::High))
+        tailPending_ = true;
+    else
+        tailTask_.run();
+}
+
+void PartitionedConvolver::TailTask::run() noexcept
+{
+    convolver.tail_.compute(convolver.tailTaskInput_.data(), convolver.tailTaskOutput_.data());
+}
+
+} // namespace fx
+} // namespace sfz
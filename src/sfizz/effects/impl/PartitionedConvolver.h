@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "TaskScheduler.h"
+#include <absl/types/span.h>
+#include <memory>
+#include <vector>
+
+struct kiss_fftr_state;
+
+namespace sfz {
+namespace fx {
+
+/**
+ * @brief Convolution of a signal with an impulse response, without latency,
+ * over partitions which grow along the response.
+ *
+ * - the head, the first taps, is a direct filter;
+ * - the body, up to twice the size of the tail partitions, goes by uniform
+ *   partitions of the size of the head, which run on the audio thread each
+ *   time that a partition of input arrived;
+ * - the tail goes by larger partitions, which run on the background workers
+ *   during the partition before their output is due.
+ */
+class PartitionedConvolver {
+public:
+    PartitionedConvolver(unsigned headSize, unsigned tailPartitionSize);
+    ~PartitionedConvolver();
+
+    /**
+     * @brief Set the impulse response, from a non-audio thread.
+     */
+    void setImpulseResponse(absl::Span<const float> impulse);
+
+    /**
+     * @brief Reset the state to initial.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Convolve a block of input into the output, which may not be
+     * the same buffer.
+     */
+    void process(const float* input, float* output, unsigned nframes) noexcept;
+
+private:
+    using FftPtr = std::unique_ptr<kiss_fftr_state, void (*)(kiss_fftr_state*)>;
+
+    /**
+     * @brief Uniform partitions of the response, over-lap saved through a
+     * frequency-domain delay line
+     */
+    struct Stage {
+        explicit Stage(unsigned partitionSize);
+        void setPartitions(absl::Span<const float> impulse);
+        void clear() noexcept;
+        // Convolve the last 2 partitions of input, to the output of the
+        // partition which comes after the next
+        void compute(const float* input, float* output) noexcept;
+
+        unsigned partitionSize;
+        unsigned numBins;
+        unsigned numPartitions { 0 };
+        FftPtr forward;
+        FftPtr inverse;
+        std::vector<float> spectra; // the partitions of the response
+        std::vector<float> delayLine; // the spectra of the input, newest first
+        unsigned delayLineHead { 0 };
+        std::vector<float> outputSpectrum;
+        std::vector<float> outputFrame;
+    };
+
+    struct TailTask final : public TaskScheduler::Task {
+        explicit TailTask(PartitionedConvolver& convolver) : convolver(convolver) {}
+        void run() noexcept override;
+        PartitionedConvolver& convolver;
+    };
+
+    void finishTail() noexcept;
+    void startTail() noexcept;
+
+    const unsigned headSize_;
+    const unsigned tailPartitionSize_;
+
+    std::vector<float> head_; // reversed
+    std::vector<float> headInput_; // the previous and the current partition
+    unsigned headPosition_ { 0 };
+
+    Stage body_;
+    std::vector<float> bodyOutput_;
+
+    Stage tail_;
+    std::vector<float> tailInput_; // the previous and the current partition
+    std::vector<float> tailTaskInput_;
+    std::vector<float> tailOutput_;
+    std::vector<float> tailTaskOutput_;
+    unsigned tailPosition_ { 0 };
+    bool tailPending_ { false };
+
+    std::shared_ptr<TaskScheduler> scheduler_;
+    TailTask tailTask_ { *this };
+};
+
+} // namespace fx
+} // namespace sfz
@@ -7,6 +7,7 @@
 #include "ResonantArray.h"
 #include "ResonantString.h"
 #include "SIMDHelpers.h"
+#include "Config.h"
 
 namespace sfz {
 namespace fx {
@@ -28,6 +29,7 @@ void ResonantArrayScalar::setup(
 
     _strings.reset(strings);
     _numStrings = numStrings;
+    _awake.reset(new bool[numStrings]());
 
     for (unsigned i = 0; i < numStrings; ++i) {
         ResonantString& rs = strings[i];
@@ -46,6 +48,7 @@ void ResonantArrayScalar::clear()
     for (unsigned i = 0; i < numStrings; ++i) {
         ResonantString& rs = strings[i];
         rs.clear();
+        _awake[i] = false;
     }
 }
 
@@ -59,10 +62,21 @@ void ResonantArrayScalar::process(const float *inPtr, float *outPtr, unsigned nu
 
     sfz::fill(output, 0.0f);
 
+    // the strings which are not ringing only wake up on input
+    constexpr float threshold = config::effectSilenceThreshold;
+    const bool silentInput = sfz::allWithin<float>(input, -threshold, threshold);
+
     for (unsigned is = 0; is < numStrings; ++is) {
         ResonantString& rs = strings[is];
+        if (silentInput && !_awake[is])
+            continue;
         for (unsigned i = 0; i < numFrames; ++i)
             output[i] += rs.process(input[i]);
+
+        // sleep once the string has decayed without input
+        _awake[is] = !silentInput || !rs.isQuiet(threshold);
+        if (!_awake[is])
+            rs.clear();
     }
 }
 
@@ -51,6 +51,7 @@ public:
 private:
     std::unique_ptr<ResonantString[]> _strings;
     unsigned _numStrings = 0;
+    std::unique_ptr<bool[]> _awake; // whether a string has to run
 };
 
 } // namespace sfz
@@ -6,6 +6,7 @@
 
 #include "ResonantArrayAVX.h"
 #include "Config.h"
+#include "SIMDHelpers.h"
 #include <cstring>
 
 #if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
@@ -33,14 +34,17 @@ void ResonantArrayAVX::setup(
     ResonantStringAVX* stringPacks = _stringPacks.data();
 
     _numStrings = numStrings;
+    _packAwake.reset(new bool[numStringPacks]());
 
     for (unsigned p = 0; p < numStringPacks; ++p) {
         ResonantStringAVX& rs = stringPacks[p];
         rs.init(sampleRate);
 
-        __m256 pitchAVX = _mm256_set1_ps(0.0f);
-        __m256 bandwidthAVX = _mm256_set1_ps(0.0f);
-        __m256 feedbackAVX = _mm256_set1_ps(0.0f);
+        // the unused strings of the last pack copy the first one, to keep
+        // finite coefficients, and they are silent with a zero gain
+        __m256 pitchAVX = _mm256_set1_ps(pitches[p * avxVectorSize]);
+        __m256 bandwidthAVX = _mm256_set1_ps(bandwidths[p * avxVectorSize]);
+        __m256 feedbackAVX = _mm256_set1_ps(feedbacks[p * avxVectorSize]);
         __m256 gainAVX = _mm256_set1_ps(0.0f);
 
         // copy 8 string parameters, or less if not enough remaining in buffer
@@ -70,6 +74,7 @@ void ResonantArrayAVX::clear()
     for (unsigned p = 0; p < numStringPacks; ++p) {
         ResonantStringAVX& rs = reinterpret_cast<ResonantStringAVX&>(stringPacks[p]);
         rs.clear();
+        _packAwake[p] = false;
     }
 }
 
@@ -78,15 +83,26 @@ void ResonantArrayAVX::process(const float *inPtr, float *outPtr, unsigned numFr
     ResonantStringAVX* stringPacks = _stringPacks.data();
     const unsigned numStringPacks = (_numStrings + avxVectorSize - 1) / avxVectorSize;
 
+    // the strings which are not ringing only wake up on input
+    constexpr float threshold = config::effectSilenceThreshold;
+    const bool silentInput = sfz::allWithin(inPtr, -threshold, threshold, numFrames);
+
     // receive 8 resonator outputs per pack
     __m256* outputs8 = reinterpret_cast<__m256*>(_workBuffer.data());
     std::memset(outputs8, 0, numFrames * sizeof(__m256));
 
     for (unsigned p = 0; p < numStringPacks; ++p) {
         ResonantStringAVX& rs = reinterpret_cast<ResonantStringAVX&>(stringPacks[p]);
+        if (silentInput && !_packAwake[p])
+            continue;
         for (unsigned i = 0; i < numFrames; ++i)
             outputs8[i] = _mm256_add_ps(
                 outputs8[i], rs.process(_mm256_broadcast_ss(&inPtr[i])));
+
+        // sleep once the strings have decayed without input
+        _packAwake[p] = !silentInput || !rs.isQuiet(threshold);
+        if (!_packAwake[p])
+            rs.clear();
     }
 
     // sum resonator outputs 8 to 1
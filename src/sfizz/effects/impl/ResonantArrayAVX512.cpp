@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "ResonantArrayAVX512.h"
+#include "Config.h"
+#include "SIMDHelpers.h"
+#include <cstring>
+
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+namespace sfz {
+namespace fx {
+
+static constexpr unsigned avx512VectorSize = sizeof(__m512) / sizeof(float);
+
+ResonantArrayAVX512::ResonantArrayAVX512()
+{
+    setSamplesPerBlock(config::defaultSamplesPerBlock);
+}
+
+ResonantArrayAVX512::~ResonantArrayAVX512()
+{
+}
+
+void ResonantArrayAVX512::setup(
+    float sampleRate, unsigned numStrings,
+    const float pitches[], const float bandwidths[],
+    const float feedbacks[], const float gains[])
+{
+    const unsigned numStringPacks = (numStrings + avx512VectorSize - 1) / avx512VectorSize;
+    _stringPacks.resize(numStringPacks);
+    ResonantStringAVX512* stringPacks = _stringPacks.data();
+
+    _numStrings = numStrings;
+    _packAwake.reset(new bool[numStringPacks]());
+
+    for (unsigned p = 0; p < numStringPacks; ++p) {
+        ResonantStringAVX512& rs = stringPacks[p];
+        rs.init(sampleRate);
+
+        // the unused strings of the last pack copy the first one, to keep
+        // finite coefficients, and they are silent with a zero gain
+        __m512 pitchAVX512 = _mm512_set1_ps(pitches[p * avx512VectorSize]);
+        __m512 bandwidthAVX512 = _mm512_set1_ps(bandwidths[p * avx512VectorSize]);
+        __m512 feedbackAVX512 = _mm512_set1_ps(feedbacks[p * avx512VectorSize]);
+        __m512 gainAVX512 = _mm512_set1_ps(0.0f);
+
+        // copy 16 string parameters, or less if not enough remaining in buffer
+        unsigned numCopy = std::min(avx512VectorSize, numStrings - (p * avx512VectorSize));
+
+        std::memcpy(&pitchAVX512, &pitches[p * avx512VectorSize], numCopy * sizeof(float));
+        std::memcpy(&bandwidthAVX512, &bandwidths[p * avx512VectorSize], numCopy * sizeof(float));
+        std::memcpy(&feedbackAVX512, &feedbacks[p * avx512VectorSize], numCopy * sizeof(float));
+        std::memcpy(&gainAVX512, &gains[p * avx512VectorSize], numCopy * sizeof(float));
+
+        rs.setResonanceFrequency(pitchAVX512, bandwidthAVX512);
+        rs.setResonanceFeedback(feedbackAVX512);
+        rs.setGain(gainAVX512);
+    }
+}
+
+void ResonantArrayAVX512::setSamplesPerBlock(unsigned samplesPerBlock)
+{
+    _workBuffer.resize(avx512VectorSize * samplesPerBlock);
+}
+
+void ResonantArrayAVX512::clear()
+{
+    ResonantStringAVX512* stringPacks = _stringPacks.data();
+    const unsigned numStringPacks = (_numStrings + avx512VectorSize - 1) / avx512VectorSize;
+
+    for (unsigned p = 0; p < numStringPacks; ++p) {
+        ResonantStringAVX512& rs = reinterpret_cast<ResonantStringAVX512&>(stringPacks[p]);
+        rs.clear();
+        _packAwake[p] = false;
+    }
+}
+
+void ResonantArrayAVX512::process(const float *inPtr, float *outPtr, unsigned numFrames)
+{
+    ResonantStringAVX512* stringPacks = _stringPacks.data();
+    const unsigned numStringPacks = (_numStrings + avx512VectorSize - 1) / avx512VectorSize;
+
+    // the strings which are not ringing only wake up on input
+    constexpr float threshold = config::effectSilenceThreshold;
+    const bool silentInput = sfz::allWithin(inPtr, -threshold, threshold, numFrames);
+
+    // receive 16 resonator outputs per pack
+    __m512* outputs16 = reinterpret_cast<__m512*>(_workBuffer.data());
+    std::memset(outputs16, 0, numFrames * sizeof(__m512));
+
+    for (unsigned p = 0; p < numStringPacks; ++p) {
+        ResonantStringAVX512& rs = reinterpret_cast<ResonantStringAVX512&>(stringPacks[p]);
+        if (silentInput && !_packAwake[p])
+            continue;
+        for (unsigned i = 0; i < numFrames; ++i)
+            outputs16[i] = _mm512_add_ps(
+                outputs16[i], rs.process(_mm512_set1_ps(inPtr[i])));
+
+        // sleep once the strings have decayed without input
+        _packAwake[p] = !silentInput || !rs.isQuiet(threshold);
+        if (!_packAwake[p])
+            rs.clear();
+    }
+
+    // sum resonator outputs 16 to 1
+    for (unsigned i = 0; i < numFrames; ++i)
+        outPtr[i] = _mm512_reduce_add_ps(outputs16[i]);
+}
+
+} // namespace sfz
+} // namespace fx
+#endif
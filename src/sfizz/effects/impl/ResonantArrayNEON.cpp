@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "ResonantArrayNEON.h"
+#include "Config.h"
+#include "SIMDHelpers.h"
+#include <cstring>
+
+#if SFIZZ_HAVE_NEON
+namespace sfz {
+namespace fx {
+
+static constexpr unsigned neonVectorSize = sizeof(float32x4_t) / sizeof(float);
+
+ResonantArrayNEON::ResonantArrayNEON()
+{
+    setSamplesPerBlock(config::defaultSamplesPerBlock);
+}
+
+ResonantArrayNEON::~ResonantArrayNEON()
+{
+}
+
+void ResonantArrayNEON::setup(
+    float sampleRate, unsigned numStrings,
+    const float pitches[], const float bandwidths[],
+    const float feedbacks[], const float gains[])
+{
+    const unsigned numStringPacks = (numStrings + neonVectorSize - 1) / neonVectorSize;
+    _stringPacks.resize(numStringPacks);
+    ResonantStringNEON* stringPacks = _stringPacks.data();
+
+    _numStrings = numStrings;
+    _packAwake.reset(new bool[numStringPacks]());
+
+    for (unsigned p = 0; p < numStringPacks; ++p) {
+        ResonantStringNEON& rs = stringPacks[p];
+        rs.init(sampleRate);
+
+        // the unused strings of the last pack copy the first one, to keep
+        // finite coefficients, and they are silent with a zero gain
+        float32x4_t pitchNEON = vdupq_n_f32(pitches[p * neonVectorSize]);
+        float32x4_t bandwidthNEON = vdupq_n_f32(bandwidths[p * neonVectorSize]);
+        float32x4_t feedbackNEON = vdupq_n_f32(feedbacks[p * neonVectorSize]);
+        float32x4_t gainNEON = vdupq_n_f32(0.0f);
+
+        // copy 4 string parameters, or less if not enough remaining in buffer
+        unsigned numCopy = std::min(neonVectorSize, numStrings - (p * neonVectorSize));
+
+        std::memcpy(&pitchNEON, &pitches[p * neonVectorSize], numCopy * sizeof(float));
+        std::memcpy(&bandwidthNEON, &bandwidths[p * neonVectorSize], numCopy * sizeof(float));
+        std::memcpy(&feedbackNEON, &feedbacks[p * neonVectorSize], numCopy * sizeof(float));
+        std::memcpy(&gainNEON, &gains[p * neonVectorSize], numCopy * sizeof(float));
+
+        rs.setResonanceFrequency(pitchNEON, bandwidthNEON);
+        rs.setResonanceFeedback(feedbackNEON);
+        rs.setGain(gainNEON);
+    }
+}
+
+void ResonantArrayNEON::setSamplesPerBlock(unsigned samplesPerBlock)
+{
+    _workBuffer.resize(neonVectorSize * samplesPerBlock);
+}
+
+void ResonantArrayNEON::clear()
+{
+    ResonantStringNEON* stringPacks = _stringPacks.data();
+    const unsigned numStringPacks = (_numStrings + neonVectorSize - 1) / neonVectorSize;
+
+    for (unsigned p = 0; p < numStringPacks; ++p) {
+        ResonantStringNEON& rs = stringPacks[p];
+        rs.clear();
+        _packAwake[p] = false;
+    }
+}
+
+void ResonantArrayNEON::process(const float *inPtr, float *outPtr, unsigned numFrames)
+{
+    ResonantStringNEON* stringPacks = _stringPacks.data();
+    const unsigned numStringPacks = (_numStrings + neonVectorSize - 1) / neonVectorSize;
+
+    // the strings which are not ringing only wake up on input
+    constexpr float threshold = config::effectSilenceThreshold;
+    const bool silentInput = sfz::allWithin(inPtr, -threshold, threshold, numFrames);
+
+    // receive 4 resonator outputs per pack
+    float32x4_t* outputs4 = reinterpret_cast<float32x4_t*>(_workBuffer.data());
+    std::memset(outputs4, 0, numFrames * sizeof(float32x4_t));
+
+    for (unsigned p = 0; p < numStringPacks; ++p) {
+        ResonantStringNEON& rs = stringPacks[p];
+        if (silentInput && !_packAwake[p])
+            continue;
+        for (unsigned i = 0; i < numFrames; ++i)
+            outputs4[i] = vaddq_f32(
+                outputs4[i], rs.process(vdupq_n_f32(inPtr[i])));
+
+        // sleep once the strings have decayed without input
+        _packAwake[p] = !silentInput || !rs.isQuiet(threshold);
+        if (!_packAwake[p])
+            rs.clear();
+    }
+
+    // sum resonator outputs 4 to 1
+    for (unsigned i = 0; i < numFrames; ++i) {
+#if SFIZZ_CPU_FAMILY_AARCH64
+        outPtr[i] = vaddvq_f32(outputs4[i]);
+#else
+        const float32x2_t x = vadd_f32(vget_low_f32(outputs4[i]), vget_high_f32(outputs4[i]));
+        outPtr[i] = vget_lane_f32(vpadd_f32(x, x), 0);
+#endif
+    }
+}
+
+} // namespace sfz
+} // namespace fx
+#endif
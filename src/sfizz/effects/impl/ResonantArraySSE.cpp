@@ -6,6 +6,7 @@
 
 #include "ResonantArraySSE.h"
 #include "Config.h"
+#include "SIMDHelpers.h"
 #include <cstring>
 
 #if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
@@ -33,14 +34,17 @@ void ResonantArraySSE::setup(
     ResonantStringSSE* stringPacks = _stringPacks.data();
 
     _numStrings = numStrings;
+    _packAwake.reset(new bool[numStringPacks]());
 
     for (unsigned p = 0; p < numStringPacks; ++p) {
         ResonantStringSSE& rs = stringPacks[p];
         rs.init(sampleRate);
 
-        __m128 pitchSSE = _mm_set1_ps(0.0f);
-        __m128 bandwidthSSE = _mm_set1_ps(0.0f);
-        __m128 feedbackSSE = _mm_set1_ps(0.0f);
+        // the unused strings of the last pack copy the first one, to keep
+        // finite coefficients, and they are silent with a zero gain
+        __m128 pitchSSE = _mm_set1_ps(pitches[p * sseVectorSize]);
+        __m128 bandwidthSSE = _mm_set1_ps(bandwidths[p * sseVectorSize]);
+        __m128 feedbackSSE = _mm_set1_ps(feedbacks[p * sseVectorSize]);
         __m128 gainSSE = _mm_set1_ps(0.0f);
 
         // copy 4 string parameters, or less if not enough remaining in buffer
@@ -70,6 +74,7 @@ void ResonantArraySSE::clear()
     for (unsigned p = 0; p < numStringPacks; ++p) {
         ResonantStringSSE& rs = stringPacks[p];
         rs.clear();
+        _packAwake[p] = false;
     }
 }
 
@@ -78,15 +83,26 @@ void ResonantArraySSE::process(const float *inPtr, float *outPtr, unsigned numFr
     ResonantStringSSE* stringPacks = _stringPacks.data();
     const unsigned numStringPacks = (_numStrings + sseVectorSize - 1) / sseVectorSize;
 
+    // the strings which are not ringing only wake up on input
+    constexpr float threshold = config::effectSilenceThreshold;
+    const bool silentInput = sfz::allWithin(inPtr, -threshold, threshold, numFrames);
+
     // receive 4 resonator outputs per pack
     __m128* outputs4 = reinterpret_cast<__m128*>(_workBuffer.data());
     std::memset(outputs4, 0, numFrames * sizeof(__m128));
 
     for (unsigned p = 0; p < numStringPacks; ++p) {
         ResonantStringSSE& rs = stringPacks[p];
+        if (silentInput && !_packAwake[p])
+            continue;
         for (unsigned i = 0; i < numFrames; ++i)
             outputs4[i] = _mm_add_ps(
                 outputs4[i], rs.process(_mm_load1_ps(&inPtr[i])));
+
+        // sleep once the strings have decayed without input
+        _packAwake[p] = !silentInput || !rs.isQuiet(threshold);
+        if (!_packAwake[p])
+            rs.clear();
     }
 
     // sum resonator outputs 4 to 1
@@ -33,6 +33,7 @@ public:
 private:
     Buffer<ResonantStringSSE, 16> _stringPacks;
     unsigned _numStrings = 0;
+    std::unique_ptr<bool[]> _packAwake; // whether a pack has to run
     Buffer<float, 16> _workBuffer;
 };
 
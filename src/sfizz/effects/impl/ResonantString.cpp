@@ -99,5 +99,13 @@ float ResonantString::process(float input)
     return output;
 }
 
+bool ResonantString::isQuiet(float threshold) const
+{
+    // the level of the state, once it goes to the output
+    const float level = std::max({ std::fabs(fRec0[1]), std::fabs(fRec1[1]),
+        std::fabs(fRec2[1]), std::fabs(fRec2[2]) });
+    return level * std::fabs(fControl[0]) < threshold;
+}
+
 } // namespace sfz
 } // namespace fx
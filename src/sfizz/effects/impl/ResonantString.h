@@ -27,6 +27,7 @@ public:
     void setResonanceFeedback(float feedback);
     void setResonanceFrequency(float frequency, float bandwidth);
     float process(float input);
+    bool isQuiet(float threshold) const;
 
 private:
     float fConst0;
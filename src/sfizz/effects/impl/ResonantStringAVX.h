@@ -31,6 +31,7 @@ public:
     void setResonanceFeedback(__m256 feedback);
     void setResonanceFrequency(__m256 frequency, __m256 bandwidth);
     __m256 process(__m256 input);
+    bool isQuiet(float threshold) const;
 
 private:
     __m256 fConst0;
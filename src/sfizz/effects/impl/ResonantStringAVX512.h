@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/**
+   Note(jpc): generated with faust and edited
+ */
+
+/* ------------------------------------------------------------
+name: "resonant_string"
+Code generated with Faust 2.20.2 (https://faust.grame.fr)
+Compilation options: -lang cpp -inpl -os -scal -ftz 0
+------------------------------------------------------------ */
+
+#pragma once
+#include "SIMDConfig.h"
+
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+#include "immintrin.h"
+
+namespace sfz {
+namespace fx {
+
+class alignas(64) ResonantStringAVX512 {
+public:
+    void init(float sample_rate);
+    void clear();
+    void setGain(__m512 gain);
+    void setResonanceFeedback(__m512 feedback);
+    void setResonanceFrequency(__m512 frequency, __m512 bandwidth);
+    __m512 process(__m512 input);
+    bool isQuiet(float threshold) const;
+
+private:
+    __m512 fConst0;
+    __m512 fConst1;
+    __m512 fRec0[2];
+    __m512 fConst2;
+    __m512 fConst3;
+    __m512 fConst4;
+    __m512 fConst5;
+    __m512 fConst6;
+    __m512 fConst7;
+    __m512 fConst8;
+    __m512 fRec2[3];
+    __m512 fRec1[2];
+    __m512 fControl[18];
+};
+
+} // namespace sfz
+} // namespace fx
+#endif
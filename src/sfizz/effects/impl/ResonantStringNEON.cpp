@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/**
+   Note(jpc): generated with faust and edited
+ */
+
+/* ------------------------------------------------------------
+name: "resonant_string"
+Code generated with Faust 2.20.2 (https://faust.grame.fr)
+Compilation options: -lang cpp -inpl -os -scal -ftz 0
+------------------------------------------------------------ */
+
+#include "ResonantStringNEON.h"
+
+#if SFIZZ_HAVE_NEON
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <cstdint>
+
+namespace sfz {
+namespace fx {
+
+static float faustpower2_f(float value)
+{
+    return (value * value);
+}
+
+static float32x4_t faustpower2_v(float32x4_t value)
+{
+    return vmulq_f32(value, value);
+}
+
+static float load_nth_v(const float32x4_t &x, unsigned i)
+{
+    return reinterpret_cast<const float *>(&x)[i];
+}
+
+static void store_nth_v(float32x4_t &x, unsigned i, float v)
+{
+    reinterpret_cast<float *>(&x)[i] = v;
+}
+
+static float32x4_t div_v(float32x4_t a, float32x4_t b)
+{
+#if SFIZZ_CPU_FAMILY_AARCH64
+    return vdivq_f32(a, b);
+#else
+    // no vector division before ARMv8, but it only computes the coefficients
+    float32x4_t r;
+    for (int i = 0; i < int(sizeof(float32x4_t) / sizeof(float)); ++i)
+        store_nth_v(r, i, load_nth_v(a, i) / load_nth_v(b, i));
+    return r;
+#endif
+}
+
+void ResonantStringNEON::init(float sample_rate)
+{
+    if (reinterpret_cast<uintptr_t>(this) & 15)
+        throw std::runtime_error("The resonant string is misaligned for NEON");
+
+    fConst0 = vdupq_n_f32(sample_rate);
+    fConst1 = div_v(vdupq_n_f32(6.28318548f), fConst0);
+    fConst2 = div_v(vdupq_n_f32(2.0f), fConst0);
+    fConst3 = vmulq_f32(vdupq_n_f32(2.0f), fConst0);
+    fConst4 = div_v(vdupq_n_f32(3.14159274f), fConst0);
+    fConst5 = div_v(vdupq_n_f32(0.5f), fConst0);
+    fConst6 = vmulq_f32(vdupq_n_f32(4.0f), faustpower2_v(fConst0));
+    fConst7 = faustpower2_v(div_v(vdupq_n_f32(1.0f), fConst0));
+    fConst8 = vmulq_f32(vdupq_n_f32(2.0f), fConst7);
+
+    clear();
+}
+
+void ResonantStringNEON::clear()
+{
+    for (int l0 = 0; (l0 < 2); l0 = (l0 + 1)) {
+        fRec0[l0] = vdupq_n_f32(0.0f);
+    }
+    for (int l1 = 0; (l1 < 3); l1 = (l1 + 1)) {
+        fRec2[l1] = vdupq_n_f32(0.0f);
+    }
+    for (int l2 = 0; (l2 < 2); l2 = (l2 + 1)) {
+        fRec1[l2] = vdupq_n_f32(0.0f);
+    }
+}
+
+void ResonantStringNEON::setGain(float32x4_t gain)
+{
+    fControl[0] = gain;
+}
+
+void ResonantStringNEON::setResonanceFeedback(float32x4_t feedback)
+{
+    fControl[1] = feedback;
+}
+
+void ResonantStringNEON::setResonanceFrequency(float32x4_t frequency, float32x4_t bandwidth)
+{
+    fControl[2] = frequency;
+    fControl[3] = vmulq_f32(fConst1, fControl[2]);
+    for (int i = 0; i < int(sizeof(float32x4_t) / sizeof(float)); ++i) {
+        store_nth_v(fControl[4], i, std::sin(load_nth_v(fControl[3], i)));
+        store_nth_v(fControl[5], i, std::cos(load_nth_v(fControl[3], i)));
+    }
+    fControl[6] = vmulq_f32(vdupq_n_f32(0.5f), bandwidth);
+    for (int i = 0; i < int(sizeof(float32x4_t) / sizeof(float)); ++i) {
+        store_nth_v(fControl[7], i, std::tan((load_nth_v(fConst4, i) * (load_nth_v(fControl[6], i) + load_nth_v(fControl[2], i)))));
+        store_nth_v(fControl[8], i, faustpower2_f(std::sqrt((load_nth_v(fConst6, i) * (load_nth_v(fControl[7], i) * std::tan((load_nth_v(fConst4, i) * (load_nth_v(fControl[2], i) - load_nth_v(fControl[6], i)))))))));
+    }
+    fControl[9] = vsubq_f32(vmulq_f32(fConst3, fControl[7]), vmulq_f32(fConst5, div_v(fControl[8], fControl[7])));
+    fControl[10] = vmulq_f32(fConst7, fControl[8]);
+    fControl[11] = vmulq_f32(fConst2, fControl[9]);
+    fControl[12] = vaddq_f32(vaddq_f32(fControl[10], fControl[11]), vdupq_n_f32(4.0f));
+    fControl[13] = vmulq_f32(fConst2, div_v(fControl[9], fControl[12]));
+    fControl[14] = vsubq_f32(vdupq_n_f32(0.0f), fControl[13]);
+    fControl[15] = div_v(vdupq_n_f32(1.0f), fControl[12]);
+    fControl[16] = vaddq_f32(vmulq_f32(fConst8, fControl[8]), vdupq_n_f32(-8.0f));
+    fControl[17] = vaddq_f32(fControl[10], vsubq_f32(vdupq_n_f32(4.0f), fControl[11]));
+}
+
+float32x4_t ResonantStringNEON::process(float32x4_t input)
+{
+    fRec0[0] = vmulq_f32(fControl[1], vaddq_f32(vmulq_f32(fControl[4], fRec1[1]), vmulq_f32(fControl[5], fRec0[1])));
+    float32x4_t fTemp0 = input;
+    fRec2[0] = vsubq_f32(fTemp0, vmulq_f32(fControl[15], vaddq_f32(vmulq_f32(fControl[16], fRec2[1]), vmulq_f32(fControl[17], fRec2[2]))));
+    fRec1[0] = vsubq_f32(vaddq_f32(vmulq_f32(fControl[14], fRec2[2]), vaddq_f32(vmulq_f32(fControl[5], fRec1[1]), vmulq_f32(fControl[13], fRec2[0]))),vmulq_f32(fControl[4], fRec0[1]));
+    float32x4_t output = vmulq_f32(fControl[0], fRec0[0]);
+    fRec0[1] = fRec0[0];
+    fRec2[2] = fRec2[1];
+    fRec2[1] = fRec2[0];
+    fRec1[1] = fRec1[0];
+    return output;
+}
+
+bool ResonantStringNEON::isQuiet(float threshold) const
+{
+    // the level of the state, once it goes to the output
+    for (int i = 0; i < int(sizeof(float32x4_t) / sizeof(float)); ++i) {
+        const float level = std::max({ std::fabs(load_nth_v(fRec0[1], i)), std::fabs(load_nth_v(fRec1[1], i)),
+            std::fabs(load_nth_v(fRec2[1], i)), std::fabs(load_nth_v(fRec2[2], i)) });
+        if (level * std::fabs(load_nth_v(fControl[0], i)) >= threshold)
+            return false;
+    }
+    return true;
+}
+
+} // namespace sfz
+} // namespace fx
+#endif
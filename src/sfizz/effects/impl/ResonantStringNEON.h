@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/**
+   Note(jpc): generated with faust and edited
+ */
+
+/* ------------------------------------------------------------
+name: "resonant_string"
+Code generated with Faust 2.20.2 (https://faust.grame.fr)
+Compilation options: -lang cpp -inpl -os -scal -ftz 0
+------------------------------------------------------------ */
+
+#pragma once
+#include "SIMDConfig.h"
+
+#if SFIZZ_HAVE_NEON
+#include <arm_neon.h>
+
+namespace sfz {
+namespace fx {
+
+class alignas(16) ResonantStringNEON {
+public:
+    void init(float sample_rate);
+    void clear();
+    void setGain(float32x4_t gain);
+    void setResonanceFeedback(float32x4_t feedback);
+    void setResonanceFrequency(float32x4_t frequency, float32x4_t bandwidth);
+    float32x4_t process(float32x4_t input);
+    bool isQuiet(float threshold) const;
+
+private:
+    float32x4_t fConst0;
+    float32x4_t fConst1;
+    float32x4_t fRec0[2];
+    float32x4_t fConst2;
+    float32x4_t fConst3;
+    float32x4_t fConst4;
+    float32x4_t fConst5;
+    float32x4_t fConst6;
+    float32x4_t fConst7;
+    float32x4_t fConst8;
+    float32x4_t fRec2[3];
+    float32x4_t fRec1[2];
+    float32x4_t fControl[18];
+};
+
+} // namespace sfz
+} // namespace fx
+#endif
@@ -124,6 +124,18 @@ __m128 ResonantStringSSE::process(__m128 input)
     return output;
 }
 
+bool ResonantStringSSE::isQuiet(float threshold) const
+{
+    // the level of the state, once it goes to the output
+    for (int i = 0; i < int(sizeof(__m128) / sizeof(float)); ++i) {
+        const float level = std::max({ std::fabs(load_nth_v(fRec0[1], i)), std::fabs(load_nth_v(fRec1[1], i)),
+            std::fabs(load_nth_v(fRec2[1], i)), std::fabs(load_nth_v(fRec2[2], i)) });
+        if (level * std::fabs(load_nth_v(fControl[0], i)) >= threshold)
+            return false;
+    }
+    return true;
+}
+
 } // namespace sfz
 } // namespace fx
 #endif
@@ -31,6 +31,7 @@ public:
     void setResonanceFeedback(__m128 feedback);
     void setResonanceFrequency(__m128 frequency, __m128 bandwidth);
     __m128 process(__m128 input);
+    bool isQuiet(float threshold) const;
 
 private:
     __m128 fConst0;
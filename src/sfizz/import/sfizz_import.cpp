@@ -6,6 +6,7 @@
 
 #include "sfizz_import.h"
 #include "ForeignInstrument.h"
+#include "sfizz/sfizz_private.hpp"
 
 bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const char** format)
 {
@@ -19,10 +20,10 @@ bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const cha
             *format = nullptr;
     }
     else {
-        auto importer = ifmt->createImporter();
-        std::string virtualPath = std::string(path) + ".sfz";
-        std::string sfzText = importer->convertToSfz(path);
-        if (!sfizz_load_string(synth, virtualPath.c_str(), sfzText.c_str()))
+        // The synth keeps the conversion, and its parse when it has a cache
+        std::shared_ptr<sfz::InstrumentImporter> importer = ifmt->createImporter();
+        const auto convert = [importer](const fs::path& file) { return importer->convertToSfz(file); };
+        if (!synth->synth.loadConvertedFile(path, convert))
             return false;
         if (format)
             *format = ifmt->name();
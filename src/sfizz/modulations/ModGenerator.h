@@ -31,6 +31,14 @@ public:
      */
     virtual void setSamplesPerBlock(unsigned count) { (void)count; }
 
+    /**
+     * @brief Start a new cycle, before any generation in this cycle.
+     * It is called once per cycle, outside of the render lanes.
+     *
+     * @param numFrames the number of frames of the cycle
+     */
+    virtual void beginCycle(unsigned numFrames) { (void)numFrames; }
+
     /**
      * @brief Initialize the generator.
      *
@@ -159,4 +159,24 @@ int ModIds::flags(ModId id) noexcept
     }
 }
 
+bool ModIds::supportsControlRate(ModId id) noexcept
+{
+    switch (id) {
+    case ModId::Amplitude:
+    case ModId::Pan:
+    case ModId::Width:
+    case ModId::Position:
+    case ModId::Volume:
+    case ModId::FilGain:
+    case ModId::FilCutoff:
+    case ModId::FilResonance:
+    case ModId::EqGain:
+    case ModId::EqFrequency:
+    case ModId::EqBandwidth:
+        return true;
+    default:
+        return false;
+    }
+}
+
 } // namespace sfz
@@ -118,6 +118,11 @@ namespace ModIds {
 bool isSource(ModId id) noexcept;
 bool isTarget(ModId id) noexcept;
 int flags(ModId id) noexcept;
+/**
+ * @brief Check whether a target varies slowly enough to be computed at
+ * control rate, when the synth is configured to.
+ */
+bool supportsControlRate(ModId id) noexcept;
 
 template <class F> inline void forEachSourceId(F&& f)
 {
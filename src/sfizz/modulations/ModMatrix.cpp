@@ -10,6 +10,7 @@
 #include "ModGenerator.h"
 #include "Buffer.h"
 #include "Config.h"
+#include "RenderThreadPool.h"
 #include "SIMDHelpers.h"
 #include "utility/Debug.h"
 #include <absl/container/flat_hash_map.h>
@@ -25,15 +26,32 @@ struct ModMatrix::Impl {
     uint32_t samplesPerBlock_ {};
 
     uint32_t numFrames_ {};
-    NumericId<Voice> currentVoiceId_ {};
-    NumericId<Region> currentRegionId_ {};
+    uint64_t cycle_ {};
+
+    struct VoiceContext {
+        NumericId<Voice> currentVoiceId_ {};
+        NumericId<Region> currentRegionId_ {};
+        float currentVoiceTriggerValue_ {};
+        // the first frame of the tile which the voice processes
+        uint32_t frameOffset_ {};
+    };
+
+    // one voice context per render lane
+    std::vector<VoiceContext> voiceContexts_ { 1 };
 
-    float currentVoiceTriggerValue_ {};
+    VoiceContext& currentVoiceContext() noexcept
+    {
+        const unsigned lane = RenderThreadPool::currentLane();
+        ASSERT(lane < voiceContexts_.size());
+        return voiceContexts_[lane];
+    }
 
     struct Source {
         ModKey key;
         ModGenerator* gen {};
         bool bufferReady {};
+        // the buffer holds a single value over the cycle
+        bool constant {};
         Buffer<float> buffer;
     };
 
@@ -48,7 +66,13 @@ struct ModMatrix::Impl {
         ModKey key;
         uint32_t region {};
         absl::flat_hash_map<uint32_t, ConnectionData> connectedSources;
+        // the range of the connections in the compiled graph
+        uint32_t connectionsBegin {};
+        uint32_t connectionsEnd {};
+        bool controlRate {};
         bool bufferReady {};
+        // the buffer holds a single value over the cycle
+        bool constant {};
         Buffer<float> buffer;
     };
 
@@ -64,6 +88,16 @@ struct ModMatrix::Impl {
 
     std::vector<Source> sources_;
     std::vector<Target> targets_;
+
+    // the connections compiled by `init`, contiguous per target
+    struct Connection {
+        uint32_t sourceIndex {};
+        ConnectionData data;
+    };
+    std::vector<Connection> connections_;
+
+    // the distinct generators of the sources
+    std::vector<ModGenerator*> generators_;
 };
 
 ModMatrix::ModMatrix()
@@ -85,6 +119,8 @@ void ModMatrix::clear()
     impl.targetIndex_.clear();
     impl.sources_.clear();
     impl.targets_.clear();
+    impl.connections_.clear();
+    impl.generators_.clear();
     impl.sourceIndicesForGlobal_.clear();
     impl.targetIndicesForGlobal_.clear();
     impl.sourceIndicesForRegion_.clear();
@@ -122,6 +158,13 @@ void ModMatrix::setSamplesPerBlock(unsigned samplesPerBlock)
         target.buffer.resize(samplesPerBlock);
 }
 
+void ModMatrix::setNumLanes(unsigned numLanes)
+{
+    Impl& impl = *impl_;
+    ASSERT(numLanes > 0);
+    impl.voiceContexts_.resize(numLanes);
+}
+
 ModMatrix::SourceId ModMatrix::registerSource(const ModKey& key, ModGenerator& gen)
 {
     Impl& impl = *impl_;
@@ -145,6 +188,9 @@ ModMatrix::SourceId ModMatrix::registerSource(const ModKey& key, ModGenerator& g
     if (key.region().number() > impl.maxRegionIdx_)
         impl.maxRegionIdx_ = key.region().number();
 
+    if (std::find(impl.generators_.begin(), impl.generators_.end(), &gen) == impl.generators_.end())
+        impl.generators_.push_back(&gen);
+
     gen.setSampleRate(impl.sampleRate_);
     gen.setSamplesPerBlock(impl.samplesPerBlock_);
 
@@ -225,6 +271,26 @@ bool ModMatrix::connect(SourceId sourceId, TargetId targetId, float sourceDepth,
     return true;
 }
 
+void ModMatrix::setControlRate(TargetId targetId, bool controlRate)
+{
+    Impl& impl = *impl_;
+
+    if (!validTarget(targetId))
+        return;
+
+    impl.targets_[targetId.number()].controlRate = controlRate;
+}
+
+bool ModMatrix::isControlRate(TargetId targetId) const
+{
+    const Impl& impl = *impl_;
+
+    if (!validTarget(targetId))
+        return false;
+
+    return impl.targets_[targetId.number()].controlRate;
+}
+
 void ModMatrix::init()
 {
     Impl& impl = *impl_;
@@ -261,6 +327,23 @@ void ModMatrix::init()
             impl.targetIndicesForRegion_[target.key.region().number()].push_back(i);
         }
     }
+
+    // the graph is static from now on, compile the connections of the targets
+    // into a contiguous array, in order of their sources
+    impl.connections_.clear();
+    for (Impl::Target& target : impl.targets_) {
+        target.connectionsBegin = static_cast<uint32_t>(impl.connections_.size());
+        for (const auto& cs : target.connectedSources) {
+            Impl::Connection conn;
+            conn.sourceIndex = cs.first;
+            conn.data = cs.second;
+            impl.connections_.push_back(conn);
+        }
+        target.connectionsEnd = static_cast<uint32_t>(impl.connections_.size());
+        std::sort(
+            impl.connections_.begin() + target.connectionsBegin, impl.connections_.end(),
+            [](const Impl::Connection& a, const Impl::Connection& b) { return a.sourceIndex < b.sourceIndex; });
+    }
 }
 
 void ModMatrix::initVoice(NumericId<Voice> voiceId, NumericId<Region> regionId, unsigned delay)
@@ -307,6 +390,10 @@ void ModMatrix::beginCycle(unsigned numFrames)
     Impl& impl = *impl_;
 
     impl.numFrames_ = numFrames;
+    ++impl.cycle_;
+
+    for (ModGenerator* gen : impl.generators_)
+        gen->beginCycle(numFrames);
 
     for (auto idx: impl.sourceIndicesForGlobal_) {
         Impl::Source& source = impl.sources_[idx];
@@ -318,6 +405,11 @@ void ModMatrix::beginCycle(unsigned numFrames)
     }
 }
 
+uint64_t ModMatrix::getCycle() const noexcept
+{
+    return impl_->cycle_;
+}
+
 void ModMatrix::endCycle()
 {
     Impl& impl = *impl_;
@@ -334,14 +426,42 @@ void ModMatrix::endCycle()
     impl.numFrames_ = 0;
 }
 
+/**
+ * @brief Check whether a buffer holds a single value.
+ */
+static bool isConstant(absl::Span<const float> buffer)
+{
+    return !buffer.empty() && allWithin(buffer, buffer.front(), buffer.front());
+}
+
+void ModMatrix::generateGlobal()
+{
+    Impl& impl = *impl_;
+    const uint32_t numFrames = impl.numFrames_;
+
+    for (auto idx: impl.sourceIndicesForGlobal_) {
+        Impl::Source& source = impl.sources_[idx];
+        if (!source.bufferReady) {
+            absl::Span<float> buffer(source.buffer.data(), numFrames);
+            source.gen->generate(source.key, {}, buffer);
+            source.constant = isConstant(buffer);
+            source.bufferReady = true;
+        }
+    }
+    for (auto idx: impl.targetIndicesForGlobal_)
+        getModulation(TargetId(static_cast<int>(idx)));
+}
+
 void ModMatrix::beginVoice(NumericId<Voice> voiceId, NumericId<Region> regionId, float triggerValue)
 {
     Impl& impl = *impl_;
+    Impl::VoiceContext& context = impl.currentVoiceContext();
 
-    impl.currentVoiceId_ = voiceId;
-    impl.currentRegionId_ = regionId;
+    context.currentVoiceId_ = voiceId;
+    context.currentRegionId_ = regionId;
 
-    impl.currentVoiceTriggerValue_ = triggerValue;
+    context.currentVoiceTriggerValue_ = triggerValue;
+    context.frameOffset_ = 0;
 
     ASSERT(regionId);
 
@@ -360,9 +480,10 @@ void ModMatrix::beginVoice(NumericId<Voice> voiceId, NumericId<Region> regionId,
 void ModMatrix::endVoice()
 {
     Impl& impl = *impl_;
+    Impl::VoiceContext& context = impl.currentVoiceContext();
     const uint32_t numFrames = impl.numFrames_;
-    const NumericId<Voice> voiceId = impl.currentVoiceId_;
-    const NumericId<Region> regionId = impl.currentRegionId_;
+    const NumericId<Voice> voiceId = context.currentVoiceId_;
+    const NumericId<Region> regionId = context.currentRegionId_;
 
     ASSERT(regionId);
     ASSERT(static_cast<size_t>(regionId.number()) < impl.sourceIndicesForRegion_.size());
@@ -377,20 +498,81 @@ void ModMatrix::endVoice()
         }
     }
 
-    impl.currentVoiceId_ = {};
-    impl.currentRegionId_ = {};
+    context.currentVoiceId_ = {};
+    context.currentRegionId_ = {};
 
-    impl.currentVoiceTriggerValue_ = 0.0f;
+    context.currentVoiceTriggerValue_ = 0.0f;
+    context.frameOffset_ = 0;
+}
+
+void ModMatrix::setFrameOffset(unsigned offset) noexcept
+{
+    Impl& impl = *impl_;
+    ASSERT(offset <= impl.numFrames_);
+    impl.currentVoiceContext().frameOffset_ = offset;
+}
+
+/**
+ * @brief Visit the frames of the control points, one every interval and the
+ * last one.
+ */
+template <class F>
+static void forEachControlPoint(uint32_t numFrames, uint32_t interval, F&& f)
+{
+    if (numFrames == 0)
+        return;
+
+    for (uint32_t i = 0; ; i = std::min(i + interval, numFrames - 1)) {
+        f(i);
+        if (i + 1 >= numFrames)
+            break;
+    }
+}
+
+/**
+ * @brief Interpolate linearly between the control points of a buffer.
+ */
+static void interpolateControlPoints(absl::Span<float> buffer, uint32_t interval)
+{
+    const uint32_t numFrames = static_cast<uint32_t>(buffer.size());
+
+    for (uint32_t a = 0; a + 1 < numFrames; ) {
+        const uint32_t b = std::min(a + interval, numFrames - 1);
+        const float start = buffer[a];
+        const float step = (buffer[b] - start) / (b - a);
+        for (uint32_t i = a + 1; i < b; ++i)
+            buffer[i] = start + step * (i - a);
+        a = b;
+    }
 }
 
 float* ModMatrix::getModulation(TargetId targetId)
 {
+    bool constant;
+    return getModulation(targetId, constant);
+}
+
+float* ModMatrix::getModulation(TargetId targetId, bool& constant)
+{
+    float* buffer = getCycleModulation(targetId, constant);
+    if (!buffer)
+        return nullptr;
+
+    return buffer + impl_->currentVoiceContext().frameOffset_;
+}
+
+float* ModMatrix::getCycleModulation(TargetId targetId, bool& constant)
+{
+    constant = false;
+
     if (!validTarget(targetId))
         return nullptr;
 
     Impl& impl = *impl_;
-    const NumericId<Region> regionId = impl.currentRegionId_;
-    const float triggerValue = impl.currentVoiceTriggerValue_;
+    const Impl::VoiceContext& context = impl.currentVoiceContext();
+    const NumericId<Voice> voiceId = context.currentVoiceId_;
+    const NumericId<Region> regionId = context.currentRegionId_;
+    const float triggerValue = context.currentVoiceTriggerValue_;
     const uint32_t targetIndex = targetId.number();
     Impl::Target &target = impl.targets_[targetIndex];
     const int targetFlags = target.key.flags();
@@ -403,21 +585,31 @@ float* ModMatrix::getModulation(TargetId targetId)
         return nullptr;
 
     // check if already processed
-    if (target.bufferReady)
+    if (target.bufferReady) {
+        constant = target.constant;
         return buffer.data();
+    }
 
     // set the ready flag to prevent a cycle
     // in case there is, be sure to initialize the buffer
     target.bufferReady = true;
 
-    auto sourcesPos = target.connectedSources.begin();
-    auto sourcesEnd = target.connectedSources.end();
+    constexpr uint32_t controlInterval = config::modControlInterval;
+    const bool controlRate = target.controlRate && numFrames > controlInterval;
+
+    const Impl::Connection* connPos = impl.connections_.data() + target.connectionsBegin;
+    const Impl::Connection* connEnd = impl.connections_.data() + target.connectionsEnd;
     bool isFirstSource = true;
 
+    // while the sources are constant, combine them in a single value
+    const bool multiplicative = targetFlags & kModIsMultiplicative;
+    bool allConstant = true;
+    float constantValue = 0.0f;
+
     // generate sources in their dedicated buffers
     // then add or multiply, depending on target flags
-    while (sourcesPos != sourcesEnd) {
-        Impl::Source &source = impl.sources_[sourcesPos->first];
+    while (connPos != connEnd) {
+        Impl::Source &source = impl.sources_[connPos->sourceIndex];
         const int sourceFlags = source.key.flags();
 
         // only accept per-voice sources of the same region
@@ -430,19 +622,57 @@ float* ModMatrix::getModulation(TargetId targetId)
 
             // unless source is already done, process it
             if (!source.bufferReady) {
-                source.gen->generate(source.key, impl.currentVoiceId_, sourceBuffer);
+                source.gen->generate(source.key, voiceId, sourceBuffer);
+                source.constant = isConstant(sourceBuffer);
                 source.bufferReady = true;
             }
 
-            float sourceDepth = sourcesPos->second.sourceDepth_;
+            float sourceDepth = connPos->data.sourceDepth_;
             if (sourceFlags & kModIsPerVoice) {
-                const float velToDepth = sourcesPos->second.velToDepth_;
+                const float velToDepth = connPos->data.velToDepth_;
                 sourceDepth += triggerValue * velToDepth;
             }
 
-            const float* sourceDepthMod = getModulation(sourcesPos->second.sourceDepthModId_);
+            bool sourceDepthModConstant;
+            const float* sourceDepthMod = getCycleModulation(connPos->data.sourceDepthModId_, sourceDepthModConstant);
+
+            const bool constantSource = source.constant && (!sourceDepthMod || sourceDepthModConstant);
+            if (allConstant && !constantSource) {
+                // the target varies from this source on, expand the value so far
+                if (!isFirstSource)
+                    fill(buffer, constantValue);
+                allConstant = false;
+            }
 
-            if (isFirstSource) {
+            if (allConstant) {
+                float depth = sourceDepth;
+                if (sourceDepthMod)
+                    depth = multiplicative ? (depth * sourceDepthMod[0]) : (depth + sourceDepthMod[0]);
+                const float value = depth * sourceBuffer[0];
+                if (isFirstSource)
+                    constantValue = value;
+                else if (multiplicative)
+                    constantValue *= value;
+                else
+                    constantValue += value;
+                isFirstSource = false;
+            }
+            else if (controlRate) {
+                forEachControlPoint(numFrames, controlInterval, [&](uint32_t i) {
+                    float depth = sourceDepth;
+                    if (sourceDepthMod)
+                        depth = multiplicative ? (depth * sourceDepthMod[i]) : (depth + sourceDepthMod[i]);
+                    const float value = depth * sourceBuffer[i];
+                    if (isFirstSource)
+                        buffer[i] = value;
+                    else if (multiplicative)
+                        buffer[i] *= value;
+                    else
+                        buffer[i] += value;
+                });
+                isFirstSource = false;
+            }
+            else if (isFirstSource) {
                 if (sourceDepth == 1 && !sourceDepthMod)
                     copy(absl::Span<const float>(sourceBuffer), buffer);
                 else if (!sourceDepthMod) {
@@ -481,7 +711,7 @@ float* ModMatrix::getModulation(TargetId targetId)
             }
         }
 
-        ++sourcesPos;
+        ++connPos;
     }
 
     // if there were no source, fill output with the neutral element
@@ -493,7 +723,13 @@ float* ModMatrix::getModulation(TargetId targetId)
             fill(buffer, 0.0f);
         }
     }
+    else if (allConstant)
+        fill(buffer, constantValue);
+    else if (controlRate)
+        interpolateControlPoints(buffer, controlInterval);
 
+    target.constant = allConstant;
+    constant = allConstant;
     return buffer.data();
 }
 
@@ -53,6 +53,15 @@ public:
      */
     void setSamplesPerBlock(unsigned samplesPerBlock);
 
+    /**
+     * @brief Set the number of render lanes which process voices concurrently.
+     * Every lane has a separate current voice, which is selected according
+     * to the lane of the calling thread.
+     *
+     * @param numLanes number of lanes, at least 1
+     */
+    void setNumLanes(unsigned numLanes);
+
     /**
      * @brief Register a modulation source inside the matrix.
      * If it is already present, it just returns the existing id.
@@ -102,9 +111,29 @@ public:
      */
     bool connect(SourceId sourceId, TargetId targetId, float sourceDepth, const ModKey& sourceDepthMod, float velToDepth);
 
+    /**
+     * @brief Set whether a target is computed at control rate.
+     * Such a target combines its sources every `config::modControlInterval`
+     * frames and on the last frame of the cycle, and interpolates linearly in
+     * between. The sources themselves are still generated at every frame.
+     *
+     * @param targetId identifier of the modulation target
+     * @param controlRate whether the target is at control rate
+     */
+    void setControlRate(TargetId targetId, bool controlRate);
+
+    /**
+     * @brief Return whether a target is computed at control rate.
+     *
+     * @param targetId identifier of the modulation target
+     */
+    bool isControlRate(TargetId targetId) const;
+
     /**
      * @brief Reinitialize modulation sources overall.
      * This must be called once after setting up the matrix.
+     * It compiles the connections for processing, so the connections made
+     * afterwards take effect at the next call.
      */
     void init();
 
@@ -133,12 +162,25 @@ public:
      */
     void beginCycle(unsigned numFrames);
 
+    /**
+     * @brief Get the number of the current cycle, which changes at every
+     * `beginCycle`, so the voices can tell what was computed in this cycle.
+     */
+    uint64_t getCycle() const noexcept;
+
     /**
      * @brief End modulation processing for the entire cycle.
      * This performs a dummy run of any unused modulations.
      */
     void endCycle();
 
+    /**
+     * @brief Generate all the per-cycle sources and targets in advance.
+     * This must be called before processing voices on several render lanes,
+     * so that the lanes only read the per-cycle buffers.
+     */
+    void generateGlobal();
+
     /**
      * @brief Start modulation processing for a given voice.
      * This clears all the buffers which are per-voice.
@@ -155,6 +197,16 @@ public:
      */
     void endVoice();
 
+    /**
+     * @brief Set the first frame of the cycle which the current voice
+     * processes, when it processes the cycle in several tiles. The buffers
+     * from `getModulation` start at this frame, until `endVoice` or another
+     * call sets it back.
+     *
+     * @param offset the frame from the start of the cycle
+     */
+    void setFrameOffset(unsigned offset) noexcept;
+
     /**
      * @brief Get the modulation buffer for the given target.
      * If the target does not exist, the result is null.
@@ -163,6 +215,16 @@ public:
      */
     float* getModulation(TargetId targetId);
 
+    /**
+     * @brief Get the modulation buffer for the given target.
+     * Same as `getModulation`, and tell whether the buffer holds a single
+     * value over the cycle, so that the caller can process it as a scalar.
+     *
+     * @param targetId identifier of the modulation target
+     * @param constant whether the modulation is constant, false if null
+     */
+    float* getModulation(TargetId targetId, bool& constant);
+
     /**
      * @brief Get the modulation buffer for the given target.
      * Same as `getModulation`, but accepting a key directly.
@@ -220,6 +282,11 @@ public:
     bool visitTargets(KeyVisitor& vtor) const;
 
 private:
+    /**
+     * @brief Get the modulation buffer of the whole cycle for the given target.
+     */
+    float* getCycleModulation(TargetId targetId, bool& constant);
+
     struct Impl;
     std::unique_ptr<Impl> impl_;
 };
@@ -17,6 +17,7 @@ namespace sfz {
 
 struct ControllerSource::Impl {
     float getLastTransformedValue(uint16_t cc, uint8_t curve) const noexcept;
+    float getLastTransformedValue(uint16_t cc, uint8_t curve, NumericId<Voice> voiceId) const noexcept;
     double sampleRate_ = config::defaultSampleRate;
     Resources* res_ = nullptr;
     VoiceManager* voiceManager_ = nullptr;
@@ -42,6 +43,25 @@ float ControllerSource::Impl::getLastTransformedValue(uint16_t cc, uint8_t curve
     return curve.evalNormalized(lastCCValue);
 }
 
+float ControllerSource::Impl::getLastTransformedValue(uint16_t cc, uint8_t curveIndex, NumericId<Voice> voiceId) const noexcept
+{
+    if (!isPerNoteCC(cc))
+        return getLastTransformedValue(cc, curveIndex);
+
+    // The per-note controllers start from the value of the note of the voice
+    ASSERT(res_);
+    const Voice* voice = voiceManager_->getVoiceById(voiceId);
+    if (!voice || voice->getTriggerEvent().type == TriggerEventType::CC)
+        return 0.0f;
+
+    const float value = res_->getMidiState().getPerNoteValue(voice->getTriggerEvent().number, cc);
+    if (cc == ExtendedCCs::perNotePitchBend)
+        return value;
+
+    const Curve& curve = res_->getCurves().getCurve(curveIndex);
+    return curve.evalNormalized(value);
+}
+
 void ControllerSource::resetSmoothers()
 {
     for (auto& item : impl_->smoother_) {
@@ -70,14 +90,13 @@ void ControllerSource::setSamplesPerBlock(unsigned count)
 
 void ControllerSource::init(const ModKey& sourceKey, NumericId<Voice> voiceId, unsigned delay)
 {
-    (void)voiceId;
     (void)delay;
 
     const ModKey::Parameters p = sourceKey.parameters();
     if (p.smooth > 0) {
         Smoother s;
         s.setSmoothing(p.smooth, impl_->sampleRate_);
-        s.reset(impl_->getLastTransformedValue(p.cc, p.curve));
+        s.reset(impl_->getLastTransformedValue(p.cc, p.curve, voiceId));
         impl_->smoother_[sourceKey] = s;
     }
     else {
@@ -184,6 +203,23 @@ void ControllerSource::generate(const ModKey& sourceKey, NumericId<Voice> voiceI
             canShortcut = true;
             break;
         }
+    case ExtendedCCs::perNotePitchBend: // fallthrough
+    case ExtendedCCs::perNoteTimbre: {
+            // The lane of the note of the voice, which no other voice reads
+            const auto voice = impl_->voiceManager_->getVoiceById(voiceId);
+            if (!voice || voice->getTriggerEvent().type == TriggerEventType::CC) {
+                sfz::fill(buffer, 0.0f);
+                canShortcut = true;
+                break;
+            }
+            const EventVector& events = ms.getPerNoteEvents(voice->getTriggerEvent().number, p.cc);
+            if (p.cc == ExtendedCCs::perNotePitchBend)
+                linearEnvelope(events, buffer, [](float x) { return x; }, p.step);
+            else
+                linearEnvelope(events, buffer, transformValue, p.step);
+            canShortcut = events.size() == 1;
+            break;
+        }
     case ExtendedCCs::pitchBend: // fallthrough
     case ExtendedCCs::channelAftertouch: {
             const EventVector& events = ms.getCCEvents(p.cc);
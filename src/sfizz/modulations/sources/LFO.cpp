@@ -11,6 +11,7 @@
 #include "../../SIMDHelpers.h"
 #include "../../Config.h"
 #include "../../utility/Debug.h"
+#include <algorithm>
 
 namespace sfz {
 
@@ -19,6 +20,22 @@ LFOSource::LFOSource(VoiceManager& manager)
 {
 }
 
+void LFOSource::setSamplesPerBlock(unsigned count)
+{
+    for (SharedOutput& output : shared_)
+        output.buffer.resize(count);
+}
+
+void LFOSource::beginCycle(unsigned numFrames)
+{
+    (void)numFrames;
+
+    for (SharedOutput& output : shared_) {
+        output.owner.store(nullptr, std::memory_order_relaxed);
+        output.ready.store(false, std::memory_order_relaxed);
+    }
+}
+
 void LFOSource::init(const ModKey& sourceKey, NumericId<Voice> voiceId, unsigned delay)
 {
     Voice* voice = voiceManager_.getVoiceById(voiceId);
@@ -77,16 +94,20 @@ void LFOSource::generate(const ModKey& sourceKey, NumericId<Voice> voiceId, absl
 
     const Region* region = voice->getRegion();
     LFO* lfo = nullptr;
+    const LFODescription* desc = nullptr;
 
     switch (sourceKey.id()) {
     case ModId::AmpLFO:
         lfo = voice->getAmplitudeLFO();
+        desc = &*region->amplitudeLFO;
         break;
     case ModId::PitchLFO:
         lfo = voice->getPitchLFO();
+        desc = &*region->pitchLFO;
         break;
     case ModId::FilLFO:
         lfo = voice->getFilterLFO();
+        desc = &*region->filterLFO;
         break;
     case ModId::LFO:
         {
@@ -96,6 +117,7 @@ void LFOSource::generate(const ModKey& sourceKey, NumericId<Voice> voiceId, absl
                 return;
             }
             lfo = voice->getLFO(lfoIndex);
+            desc = &region->lfos[lfoIndex];
         }
         break;
     default:
@@ -103,6 +125,34 @@ void LFOSource::generate(const ModKey& sourceKey, NumericId<Voice> voiceId, absl
         return;
     }
 
+    if (!lfo->isVoiceIndependent() || buffer.size() > shared_[0].buffer.size()) {
+        lfo->process(buffer);
+        return;
+    }
+
+    // the voices of a region run the same LFO in the cycle,
+    // compute it in the first and copy it in the others
+    for (SharedOutput& output : shared_) {
+        const LFODescription* owner = output.owner.load(std::memory_order_acquire);
+        if (owner == desc) {
+            if (!output.ready.load(std::memory_order_acquire))
+                break;
+            const float* shared = output.buffer.data();
+            std::copy(shared, shared + buffer.size(), buffer.begin());
+            return;
+        }
+        if (!owner && output.owner.compare_exchange_strong(owner, desc, std::memory_order_acq_rel)) {
+            lfo->process(buffer);
+            std::copy(buffer.begin(), buffer.end(), output.buffer.data());
+            output.ready.store(true, std::memory_order_release);
+            return;
+        }
+        if (owner == desc) {
+            // claimed by another voice meanwhile
+            break;
+        }
+    }
+
     lfo->process(buffer);
 }
 
@@ -7,17 +7,36 @@
 #pragma once
 #include "../ModGenerator.h"
 #include "../../VoiceManager.h"
+#include "../../Buffer.h"
+#include "../../Config.h"
+#include <array>
+#include <atomic>
+
 namespace sfz {
+struct LFODescription;
 class Synth;
 
 class LFOSource : public ModGenerator {
 public:
     explicit LFOSource(VoiceManager &manager);
+    void setSamplesPerBlock(unsigned count) override;
+    void beginCycle(unsigned numFrames) override;
     void init(const ModKey& sourceKey, NumericId<Voice> voiceId, unsigned delay) override;
     void generate(const ModKey& sourceKey, NumericId<Voice> voiceId, absl::Span<float> buffer) override;
 
 private:
+    /**
+     * @brief Output of a voice-independent LFO, computed by the first voice
+     * which runs it in the cycle, and copied by the others.
+     */
+    struct SharedOutput {
+        std::atomic<const LFODescription*> owner { nullptr };
+        std::atomic<bool> ready { false };
+        Buffer<float> buffer;
+    };
+
     VoiceManager& voiceManager_;
+    std::array<SharedOutput, config::maxSharedLFOs> shared_;
 };
 
 } // namespace sfz
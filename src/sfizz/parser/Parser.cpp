@@ -7,11 +7,83 @@
 #include "Parser.h"
 #include "ParserListener.h"
 #include "ParserPrivate.h"
+#include "utility/AtomicFile.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <functional>
 
 namespace sfz {
 
+namespace {
+
+constexpr char parseCacheMagic[8] = { 'S', 'F', 'Z', 'P', 'A', 'R', 'S', 'E' };
+constexpr uint32_t parseCacheVersion = 1;
+
+// The depth of the definitions which expand into other definitions, past
+// which the expansion is taken as recursive
+constexpr unsigned maxDefinitionDepth = 32;
+
+struct FileStamp {
+    int64_t fileSize { 0 };
+    int64_t modificationTime { 0 };
+};
+
+absl::optional<FileStamp> getFileStamp(const fs::path& file)
+{
+    std::error_code ec;
+    FileStamp stamp;
+    stamp.fileSize = static_cast<int64_t>(fs::file_size(file, ec));
+    if (ec)
+        return {};
+    stamp.modificationTime = static_cast<int64_t>(fs::last_write_time(file, ec).time_since_epoch().count());
+    if (ec)
+        return {};
+    return stamp;
+}
+
+/**
+ * @brief Get the definitions in order, since the order of the hash map
+ * changes from a run to another
+ */
+std::vector<std::pair<std::string, std::string>> getSortedDefinitions(const Parser::DefinitionSet& definitions)
+{
+    std::vector<std::pair<std::string, std::string>> sorted(definitions.begin(), definitions.end());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+template <class T>
+void writeValue(std::ostream& stream, T value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+bool readValue(std::istream& stream, T& value)
+{
+    return bool(stream.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+void writeString(std::ostream& stream, absl::string_view string)
+{
+    writeValue(stream, static_cast<uint32_t>(string.size()));
+    stream.write(string.data(), static_cast<std::streamsize>(string.size()));
+}
+
+bool readString(std::istream& stream, std::string& string)
+{
+    uint32_t size;
+    if (!readValue(stream, size))
+        return false;
+    string.resize(size);
+    return size == 0 || bool(stream.read(&string[0], static_cast<std::streamsize>(size)));
+}
+
+} // namespace
+
 Parser::Parser()
 {
 }
@@ -24,6 +96,7 @@ void Parser::clear()
 {
     _pathsIncluded.clear();
     _currentDefinitions = _externalDefinitions;
+    indexDefinitions();
     _currentHeader.reset();
     _currentOpcodes.clear();
     _errorCount = 0;
@@ -42,7 +115,59 @@ void Parser::clearExternalDefinitions()
 
 void Parser::parseFile(const fs::path& path)
 {
-    parseVirtualFile(path, nullptr);
+    parseCachedFile(path, {}, nullptr);
+}
+
+void Parser::parseConvertedFile(const fs::path& path, const fs::path& sourceFile, const Converter& convert)
+{
+    parseCachedFile(path, sourceFile, &convert);
+}
+
+void Parser::parseCachedFile(const fs::path& path, const fs::path& sourceFile, const Converter* convert)
+{
+    _parsedFromCache = false;
+
+    const fs::path fullPath =
+        (path.empty() || path.is_absolute()) ? path : _originalDirectory / path;
+    const fs::path cacheFile = getCacheFile(fullPath);
+    if (!cacheFile.empty() && replayCache(fullPath, cacheFile)) {
+        _parsedFromCache = true;
+        return;
+    }
+
+    fs::path recordFile;
+    if (!cacheFile.empty()) {
+        std::error_code ec;
+        fs::create_directories(cacheFile.parent_path(), ec);
+        recordFile = getTemporaryFile(cacheFile, "blocks");
+        if (!ec)
+            _recordStream = absl::make_unique<fs::ofstream>(recordFile, std::ios::binary | std::ios::trunc);
+        if (_recordStream && !*_recordStream)
+            _recordStream.reset();
+    }
+
+    _numRecordedBlocks = 0;
+    if (convert) {
+        const fs::path fullSource =
+            (sourceFile.empty() || sourceFile.is_absolute()) ? sourceFile : _originalDirectory / sourceFile;
+        parseVirtualFile(path, absl::make_unique<StringReader>(fullPath, (*convert)(fullSource)));
+        // The document comes out of the source, whose changes make it stale
+        _pathsIncluded.erase(fullPath.string());
+        _pathsIncluded.insert(fullSource.string());
+    }
+    else
+        parseVirtualFile(path, nullptr);
+
+    if (_recordStream) {
+        _recordStream->close();
+        const bool recorded = !_recordStream->fail();
+        _recordStream.reset();
+        // The replays do not report the errors, so keep only the clean parses
+        if (recorded && _errorCount == 0)
+            writeCache(fullPath, cacheFile, recordFile);
+        std::error_code ec;
+        fs::remove(recordFile, ec);
+    }
 }
 
 void Parser::parseString(const fs::path& path, absl::string_view sfzView)
@@ -60,6 +185,7 @@ void Parser::parseVirtualFile(const fs::path& path, std::unique_ptr<Reader> read
     includeNewFile(path, std::move(reader), {});
     processTopLevel();
     flushCurrentHeader();
+    _includePrefetcher.reset();
 
     if (_listener)
         _listener->onParseEnd();
@@ -91,6 +217,14 @@ void Parser::includeNewFile(const fs::path& path, std::unique_ptr<Reader> reader
         return;
     }
 
+    if (_pathsIncluded.empty() && _includePrefetchThreads > 0)
+        _includePrefetcher = absl::make_unique<IncludePrefetcher>(_originalDirectory, _includePrefetchThreads);
+
+    if (!reader && _includePrefetcher) {
+        if (absl::optional<std::string> contents = _includePrefetcher->takeFile(fullPath))
+            reader = absl::make_unique<StringReader>(fullPath, std::move(*contents));
+    }
+
     if (!reader) {
         auto fileReader = absl::make_unique<FileReader>(fullPath);
         if (fileReader->hasError()) {
@@ -98,6 +232,8 @@ void Parser::includeNewFile(const fs::path& path, std::unique_ptr<Reader> reader
             emitError(makeErrorRange(), "Cannot open file for reading: " + fullPath.string());
             return;
         }
+        if (_includePrefetcher)
+            _includePrefetcher->scanFile(fullPath);
         reader = std::move(fileReader);
     }
 
@@ -108,6 +244,21 @@ void Parser::includeNewFile(const fs::path& path, std::unique_ptr<Reader> reader
 void Parser::addDefinition(absl::string_view id, absl::string_view value)
 {
     _currentDefinitions[id] = std::string(value);
+    _expandedDefinitions.clear();
+
+    const auto length = std::lower_bound(_definitionLengths.begin(), _definitionLengths.end(), id.size());
+    if (length == _definitionLengths.end() || *length != id.size())
+        _definitionLengths.insert(length, id.size());
+}
+
+void Parser::indexDefinitions()
+{
+    _expandedDefinitions.clear();
+    _definitionLengths.clear();
+    for (const auto& definition : _currentDefinitions)
+        _definitionLengths.push_back(definition.first.size());
+    std::sort(_definitionLengths.begin(), _definitionLengths.end());
+    _definitionLengths.erase(std::unique(_definitionLengths.begin(), _definitionLengths.end()), _definitionLengths.end());
 }
 
 void Parser::processTopLevel()
@@ -403,12 +554,176 @@ void Parser::flushCurrentHeader()
     if (_currentHeader) {
         if (_listener)
             _listener->onParseFullBlock(*_currentHeader, _currentOpcodes);
+        if (_recordStream) {
+            writeString(*_recordStream, *_currentHeader);
+            writeValue(*_recordStream, static_cast<uint32_t>(_currentOpcodes.size()));
+            for (const Opcode& opcode : _currentOpcodes) {
+                writeString(*_recordStream, opcode.name);
+                writeString(*_recordStream, opcode.value);
+            }
+            ++_numRecordedBlocks;
+        }
         _currentHeader.reset();
     }
 
     _currentOpcodes.clear();
 }
 
+fs::path Parser::getCacheFile(const fs::path& fullPath) const
+{
+    if (_cacheDirectory.empty() || fullPath.empty())
+        return {};
+
+    std::string hashed = fullPath.string();
+    for (const auto& definition : getSortedDefinitions(_externalDefinitions))
+        absl::StrAppend(&hashed, "|", definition.first, "=", definition.second);
+    const size_t hash = std::hash<std::string>()(hashed);
+    return _cacheDirectory / absl::StrCat(absl::Hex(hash, absl::kZeroPad16), ".sfzparse");
+}
+
+bool Parser::replayCache(const fs::path& fullPath, const fs::path& cacheFile)
+{
+    fs::ifstream stream { cacheFile, std::ios::binary };
+    char magic[sizeof(parseCacheMagic)];
+    uint32_t version;
+    if (!stream || !stream.read(magic, sizeof(magic))
+        || std::memcmp(magic, parseCacheMagic, sizeof(parseCacheMagic)) != 0
+        || !readValue(stream, version) || version != parseCacheVersion)
+        return false;
+
+    // Different keys may share a hash, so check the ones in the file
+    std::string path;
+    if (!readString(stream, path) || path != fullPath.string())
+        return false;
+
+    uint32_t numDefinitions;
+    if (!readValue(stream, numDefinitions) || numDefinitions != _externalDefinitions.size())
+        return false;
+    for (const auto& definition : getSortedDefinitions(_externalDefinitions)) {
+        std::string id;
+        std::string value;
+        if (!readString(stream, id) || !readString(stream, value)
+            || id != definition.first || value != definition.second)
+            return false;
+    }
+
+    // Any change of the included files makes the cache stale
+    IncludeFileSet pathsIncluded;
+    uint32_t numFiles;
+    if (!readValue(stream, numFiles))
+        return false;
+    for (uint32_t i = 0; i < numFiles; ++i) {
+        std::string file;
+        FileStamp cached;
+        if (!readString(stream, file) || !readValue(stream, cached.fileSize)
+            || !readValue(stream, cached.modificationTime))
+            return false;
+        const absl::optional<FileStamp> stamp = getFileStamp(file);
+        if (!stamp || stamp->fileSize != cached.fileSize
+            || stamp->modificationTime != cached.modificationTime)
+            return false;
+        pathsIncluded.insert(std::move(file));
+    }
+
+    DefinitionSet currentDefinitions;
+    uint64_t warningCount;
+    if (!readValue(stream, numDefinitions))
+        return false;
+    for (uint32_t i = 0; i < numDefinitions; ++i) {
+        std::string id;
+        std::string value;
+        if (!readString(stream, id) || !readString(stream, value))
+            return false;
+        currentDefinitions[id] = std::move(value);
+    }
+    if (!readValue(stream, warningCount))
+        return false;
+
+    // Read all the blocks before replaying any
+    std::vector<std::pair<std::string, std::vector<Opcode>>> blocks;
+    uint32_t numBlocks;
+    if (!readValue(stream, numBlocks))
+        return false;
+    blocks.reserve(numBlocks);
+    for (uint32_t i = 0; i < numBlocks; ++i) {
+        std::string header;
+        uint32_t numOpcodes;
+        if (!readString(stream, header) || !readValue(stream, numOpcodes))
+            return false;
+        std::vector<Opcode> opcodes;
+        opcodes.reserve(numOpcodes);
+        for (uint32_t j = 0; j < numOpcodes; ++j) {
+            std::string name;
+            std::string value;
+            if (!readString(stream, name) || !readString(stream, value))
+                return false;
+            opcodes.emplace_back(name, value);
+        }
+        blocks.emplace_back(std::move(header), std::move(opcodes));
+    }
+
+    clear();
+    _originalDirectory = fullPath.parent_path();
+    _pathsIncluded = std::move(pathsIncluded);
+    _currentDefinitions = std::move(currentDefinitions);
+    indexDefinitions();
+    _warningCount = static_cast<size_t>(warningCount);
+
+    if (!_listener)
+        return true;
+
+    _listener->onParseBegin();
+    for (const auto& block : blocks) {
+        _listener->onParseHeader({}, block.first);
+        for (const Opcode& opcode : block.second)
+            _listener->onParseOpcode({}, {}, opcode.name, opcode.value);
+        _listener->onParseFullBlock(block.first, block.second);
+    }
+    _listener->onParseEnd();
+    return true;
+}
+
+void Parser::writeCache(const fs::path& fullPath, const fs::path& cacheFile, const fs::path& recordFile) const
+{
+    writeFileAtomically(cacheFile, [&](std::ostream& stream) {
+        stream.write(parseCacheMagic, sizeof(parseCacheMagic));
+        writeValue(stream, parseCacheVersion);
+        writeString(stream, fullPath.string());
+
+        writeValue(stream, static_cast<uint32_t>(_externalDefinitions.size()));
+        for (const auto& definition : getSortedDefinitions(_externalDefinitions)) {
+            writeString(stream, definition.first);
+            writeString(stream, definition.second);
+        }
+
+        writeValue(stream, static_cast<uint32_t>(_pathsIncluded.size()));
+        for (const std::string& file : _pathsIncluded) {
+            const absl::optional<FileStamp> stamp = getFileStamp(file);
+            if (!stamp) {
+                // Give the cache up
+                stream.setstate(std::ios::failbit);
+                return;
+            }
+            writeString(stream, file);
+            writeValue(stream, stamp->fileSize);
+            writeValue(stream, stamp->modificationTime);
+        }
+
+        writeValue(stream, static_cast<uint32_t>(_currentDefinitions.size()));
+        for (const auto& definition : _currentDefinitions) {
+            writeString(stream, definition.first);
+            writeString(stream, definition.second);
+        }
+        writeValue(stream, static_cast<uint64_t>(_warningCount));
+
+        writeValue(stream, _numRecordedBlocks);
+        if (_numRecordedBlocks > 0) {
+            fs::ifstream blocks { recordFile, std::ios::binary };
+            stream << blocks.rdbuf();
+        }
+    });
+}
+
 Parser::CommentType Parser::getCommentType(Reader& reader)
 {
     if (reader.peekChar() != '/')
@@ -504,57 +819,85 @@ size_t Parser::extractToEol(Reader& reader, std::string* dst)
 std::string Parser::expandDollarVars(const SourceRange& range, absl::string_view src)
 {
     std::string dst;
-    std::string srcbuf; // temporary for retries when recursive
-    std::string name; // temporary for variable name
-    bool keepExpanding = true;
-
     dst.reserve(2 * src.size());
-    name.reserve(64);
-
-    while (keepExpanding) {
-        size_t i = 0;
-        size_t n = src.size();
-        size_t numExpansions = 0;
-        while (i < n) {
-            char c = src[i++];
-
-            if (c != '$')
-                dst.push_back(c);
-            else {
-                ++numExpansions;
-                name.clear();
-
-                // ARIA: we will accumulate any chars after $, until this is the
-                //       name of a known variable
-                auto def = _currentDefinitions.end();
-                while (i < n && isIdentifierChar(src[i]) && def == _currentDefinitions.end()) {
-                    name.push_back(src[i++]);
-                    def = _currentDefinitions.find(name);
-                }
-
-                if (name.empty()) {
-                    emitWarning(range, "Expected variable name after $.");
-                    continue;
-                }
-
-                if (def == _currentDefinitions.end()) {
-                    emitWarning(range, "The variable `" + name + "` is not defined.");
-                    continue;
-                }
-
-                dst.append(def->second);
-            }
+    appendExpansion(range, src, dst, 0);
+    return dst;
+}
+
+void Parser::appendExpansion(const SourceRange& range, absl::string_view src, std::string& dst, unsigned depth)
+{
+    size_t i = 0;
+    const size_t n = src.size();
+    while (i < n) {
+        const size_t dollar = src.find('$', i);
+        if (dollar == src.npos) {
+            dst.append(src.data() + i, n - i);
+            break;
+        }
+
+        dst.append(src.data() + i, dollar - i);
+        i = dollar + 1;
+
+        size_t end = i;
+        while (end < n && isIdentifierChar(src[end]))
+            ++end;
+
+        const absl::string_view identifier = src.substr(i, end - i);
+        if (identifier.empty()) {
+            emitWarning(range, "Expected variable name after $.");
+            continue;
         }
 
-        keepExpanding = numExpansions > 0;
-        if (keepExpanding) {
-            srcbuf = dst;
-            src = srcbuf;
-            dst.clear();
+        // ARIA: the name is the shortest known variable after $, so the
+        //       lengths of the names are tried in increasing order
+        auto def = _currentDefinitions.end();
+        for (size_t length : _definitionLengths) {
+            if (length > identifier.size())
+                break;
+            def = _currentDefinitions.find(identifier.substr(0, length));
+            if (def != _currentDefinitions.end())
+                break;
         }
+
+        if (def == _currentDefinitions.end()) {
+            emitWarning(range, absl::StrCat("The variable `", identifier, "` is not defined."));
+            i = end;
+            continue;
+        }
+
+        i += def->first.size();
+        appendDefinition(range, def->first, def->second, dst, depth);
     }
+}
 
-    return dst;
+void Parser::appendDefinition(const SourceRange& range, const std::string& name, const std::string& value, std::string& dst, unsigned depth)
+{
+    if (value.find('$') == value.npos) {
+        dst.append(value);
+        return;
+    }
+
+    // The definitions which refer to others expand once, until the
+    // definitions change
+    const auto cached = _expandedDefinitions.find(name);
+    if (cached != _expandedDefinitions.end()) {
+        dst.append(cached->second);
+        return;
+    }
+
+    if (depth >= maxDefinitionDepth) {
+        emitWarning(range, "The variable `" + name + "` expands recursively.");
+        return;
+    }
+
+    std::string expanded;
+    const size_t warningCount = _warningCount;
+    appendExpansion(range, value, expanded, depth + 1);
+    dst.append(expanded);
+
+    // The expansions which warn are not kept, so they warn on every use
+    if (_warningCount == warningCount)
+        _expandedDefinitions.emplace(name, std::move(expanded));
 }
 
 bool Parser::isIdentifierChar(char c)
@@ -10,12 +10,15 @@
 #include <absl/types/optional.h>
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <functional>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace sfz {
 
 class Reader;
+class IncludePrefetcher;
 class ParserListener;
 struct SourceLocation;
 struct SourceRange;
@@ -35,6 +38,22 @@ public:
 
     void parseFile(const fs::path& path);
     void parseString(const fs::path& path, absl::string_view sfzView);
+
+    /**
+     * @brief The conversion of a file of another format into an SFZ document.
+     */
+    using Converter = std::function<std::string(const fs::path&)>;
+    /**
+     * @brief Parse the SFZ document converted from a file of another format,
+     * under a virtual path. The parse is kept like the ones of the SFZ files,
+     * and depends on the source file instead of the virtual one, so the next
+     * parses of the unchanged file replay it without converting again.
+     *
+     * @param path the virtual path of the SFZ document
+     * @param sourceFile the file to convert
+     * @param convert the conversion, called unless the parse is replayed
+     */
+    void parseConvertedFile(const fs::path& path, const fs::path& sourceFile, const Converter& convert);
     void parseVirtualFile(const fs::path& path, std::unique_ptr<Reader> reader);
 
     void setRecursiveIncludeGuardEnabled(bool en) { _recursiveIncludeGuardEnabled = en; }
@@ -42,6 +61,27 @@ public:
 
     const fs::path& originalDirectory() const noexcept { return _originalDirectory; }
 
+    /**
+     * @brief Set the directory where the parses of files are kept. A parse of
+     * a file replays the kept one instead, as long as the included files and
+     * the external definitions did not change. An empty path disables it.
+     */
+    void setCacheDirectory(const fs::path& directory) { _cacheDirectory = directory; }
+    const fs::path& getCacheDirectory() const noexcept { return _cacheDirectory; }
+
+    /**
+     * @brief Whether the last parse replayed a kept one.
+     */
+    bool isParsedFromCache() const noexcept { return _parsedFromCache; }
+
+    /**
+     * @brief Set the number of threads which read the included files ahead
+     * of the parse, concurrently. The parse itself is unchanged, and feeds
+     * the listener in the order of the source. Zero disables it.
+     */
+    void setIncludePrefetchThreads(unsigned numThreads) noexcept { _includePrefetchThreads = numThreads; }
+    unsigned getIncludePrefetchThreads() const noexcept { return _includePrefetchThreads; }
+
     typedef absl::flat_hash_set<std::string> IncludeFileSet;
     typedef absl::flat_hash_map<std::string, std::string> DefinitionSet;
 
@@ -73,6 +113,12 @@ private:
     // state handling
     void flushCurrentHeader();
 
+    // cache of the parses
+    void parseCachedFile(const fs::path& path, const fs::path& sourceFile, const Converter* convert);
+    fs::path getCacheFile(const fs::path& fullPath) const;
+    bool replayCache(const fs::path& fullPath, const fs::path& cacheFile);
+    void writeCache(const fs::path& fullPath, const fs::path& cacheFile, const fs::path& recordFile) const;
+
     // helpers
     enum class CommentType {
         None,
@@ -85,6 +131,9 @@ private:
     static void trimRight(std::string& text);
     static size_t extractToEol(Reader& reader, std::string* dst); // ignores comment
     std::string expandDollarVars(const SourceRange& range, absl::string_view src);
+    void appendExpansion(const SourceRange& range, absl::string_view src, std::string& dst, unsigned depth);
+    void appendDefinition(const SourceRange& range, const std::string& name, const std::string& value, std::string& dst, unsigned depth);
+    void indexDefinitions();
 
     // predicates
     static bool isIdentifierChar(char c);
@@ -100,11 +149,19 @@ private:
     // a current list of files included, last one at the back
     std::vector<std::unique_ptr<Reader>> _included;
 
+    // reader of the included files ahead of the parse
+    unsigned _includePrefetchThreads = 0;
+    std::unique_ptr<IncludePrefetcher> _includePrefetcher;
+
     // recursive include guard
     size_t _maxIncludeDepth = 32;
     bool _recursiveIncludeGuardEnabled = false;
     IncludeFileSet _pathsIncluded;
     DefinitionSet _currentDefinitions;
+    // the sorted lengths of the names of the current definitions, and the
+    // expanded values of the ones which refer to others, until they change
+    std::vector<size_t> _definitionLengths;
+    DefinitionSet _expandedDefinitions;
 
     // parsing state
     absl::optional<std::string> _currentHeader;
@@ -113,6 +170,13 @@ private:
     // errors and warnings
     size_t _errorCount = 0;
     size_t _warningCount = 0;
+
+    // cache of the parses, and the blocks of the current parse to keep there,
+    // which are written aside as they are parsed rather than kept in memory
+    fs::path _cacheDirectory;
+    bool _parsedFromCache = false;
+    std::unique_ptr<fs::ofstream> _recordStream;
+    uint32_t _numRecordedBlocks = 0;
 };
 
 /**
@@ -5,6 +5,10 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "ParserPrivate.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include <algorithm>
+#include <sstream>
 
 namespace sfz {
 
@@ -12,7 +16,6 @@ Reader::Reader(const fs::path& filePath)
 {
     _accum.reserve(256);
     _loc.filePath = std::make_shared<fs::path>(filePath);
-    _lineNumColumns.reserve(256);
 }
 
 int Reader::getChar()
@@ -105,7 +108,7 @@ void Reader::updateSourceLocationAdding(int byte)
     if (byte != '\n')
         _loc.columnNumber += 1;
     else {
-        _lineNumColumns.push_back(_loc.columnNumber);
+        _lineEndColumns[_loc.lineNumber % kLineHistorySize] = _loc.columnNumber;
         _loc.lineNumber += 1;
         _loc.columnNumber = 0;
     }
@@ -117,15 +120,14 @@ void Reader::updateSourceLocationRemoving(int byte)
         _loc.columnNumber -= 1;
     else {
         _loc.lineNumber -= 1;
-        _loc.columnNumber = _lineNumColumns[_loc.lineNumber];
-        _lineNumColumns.pop_back();
+        _loc.columnNumber = _lineEndColumns[_loc.lineNumber % kLineHistorySize];
     }
 }
 
 //------------------------------------------------------------------------------
 
 FileReader::FileReader(const fs::path& filePath)
-    : Reader(filePath), _fileStream(filePath)
+    : Reader(filePath), _fileStream(filePath), _buffer(new char[kBufferSize])
 {
 }
 
@@ -136,7 +138,15 @@ bool FileReader::hasError()
 
 int FileReader::getNextStreamByte()
 {
-    return _fileStream.get();
+    if (_bufferPosition == _bufferFill) {
+        _fileStream.read(_buffer.get(), kBufferSize);
+        _bufferFill = static_cast<size_t>(_fileStream.gcount());
+        _bufferPosition = 0;
+        if (_bufferFill == 0)
+            return kEof;
+    }
+
+    return static_cast<unsigned char>(_buffer[_bufferPosition++]);
 }
 
 StringViewReader::StringViewReader(const fs::path& filePath, absl::string_view sfzView)
@@ -152,4 +162,176 @@ int StringViewReader::getNextStreamByte()
     return kEof;
 }
 
+StringReader::StringReader(const fs::path& filePath, std::string sfzText)
+    : Reader(filePath), _sfzText(std::move(sfzText))
+{
+}
+
+int StringReader::getNextStreamByte()
+{
+    if (position < _sfzText.length())
+        return static_cast<unsigned char>(_sfzText[position++]);
+
+    return kEof;
+}
+
+//------------------------------------------------------------------------------
+
+IncludePrefetcher::IncludePrefetcher(const fs::path& rootDirectory, unsigned numThreads)
+    : _rootDirectory(rootDirectory)
+{
+    _threads.reserve(numThreads);
+    for (unsigned i = 0; i < numThreads; ++i)
+        _threads.emplace_back(&IncludePrefetcher::work, this);
+}
+
+IncludePrefetcher::~IncludePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+        _stopping = true;
+        _queue.clear();
+    }
+    _workCondition.notify_all();
+    for (std::thread& thread : _threads)
+        thread.join();
+}
+
+void IncludePrefetcher::scanFile(const fs::path& path)
+{
+    std::lock_guard<std::mutex> lock { _mutex };
+    enqueue(path.string(), false);
+}
+
+absl::optional<std::string> IncludePrefetcher::takeFile(const fs::path& path)
+{
+    const std::string key = path.string();
+    std::unique_lock<std::mutex> lock { _mutex };
+
+    auto it = _entries.find(key);
+    if (it == _entries.end() || !it->second.keepContents)
+        return {};
+
+    // Read it now rather than after the files queued before it
+    if (it->second.state == State::Queued) {
+        _queue.erase(std::find(_queue.begin(), _queue.end(), key));
+        _entries.erase(it);
+        lock.unlock();
+        return process(key, true);
+    }
+
+    _doneCondition.wait(lock, [&]() { return _entries[key].state == State::Done; });
+    it = _entries.find(key);
+    absl::optional<std::string> contents = std::move(it->second.contents);
+    _entries.erase(it);
+    return contents;
+}
+
+void IncludePrefetcher::work()
+{
+    std::unique_lock<std::mutex> lock { _mutex };
+
+    while (true) {
+        _workCondition.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+        if (_stopping)
+            return;
+
+        const std::string path = std::move(_queue.front());
+        _queue.pop_front();
+        Entry& entry = _entries[path];
+        entry.state = State::Running;
+        const bool keepContents = entry.keepContents;
+
+        lock.unlock();
+        absl::optional<std::string> contents = process(path, keepContents);
+        lock.lock();
+
+        Entry& done = _entries[path];
+        done.state = State::Done;
+        done.contents = std::move(contents);
+        if (!keepContents)
+            _entries.erase(path);
+        _doneCondition.notify_all();
+    }
+}
+
+absl::optional<std::string> IncludePrefetcher::process(const fs::path& path, bool keepContents)
+{
+    fs::ifstream stream { path };
+    if (!stream.is_open())
+        return {};
+
+    // The scanned files are read along, the prefetched ones kept whole
+    std::string contents;
+    if (keepContents) {
+        std::ostringstream text;
+        text << stream.rdbuf();
+        if (stream.bad())
+            return {};
+        contents = text.str();
+    }
+
+    auto scanLine = [this](absl::string_view line) {
+        if (line.find("#include") == line.npos)
+            return;
+        std::lock_guard<std::mutex> lock { _mutex };
+        queueIncludes(line);
+    };
+
+    if (keepContents) {
+        absl::string_view text { contents };
+        while (!text.empty()) {
+            const size_t end = std::min(text.find('\n'), text.size());
+            scanLine(text.substr(0, end));
+            text.remove_prefix(std::min(end + 1, text.size()));
+        }
+        return contents;
+    }
+
+    std::string line;
+    while (std::getline(stream, line) && !_stopping)
+        scanLine(line);
+    return {};
+}
+
+void IncludePrefetcher::queueIncludes(absl::string_view line)
+{
+    for (size_t position; (position = line.find("#include")) != line.npos; ) {
+        line.remove_prefix(position + 8);
+        line = absl::StripLeadingAsciiWhitespace(line);
+        if (!absl::StartsWith(line, "\""))
+            continue;
+
+        line.remove_prefix(1);
+
+        const size_t end = line.find_first_of("\"\r\n");
+        if (end == line.npos)
+            return;
+
+        const absl::string_view path = line.substr(0, end);
+        line.remove_prefix(end);
+        if (!path.empty() && path.find('$') == path.npos)
+            enqueue(getFullPath(path), true);
+    }
+}
+
+void IncludePrefetcher::enqueue(const std::string& path, bool keepContents)
+{
+    if (_stopping || !_seen.insert(path).second)
+        return;
+
+    Entry& entry = _entries[path];
+    entry.keepContents = keepContents;
+    _queue.push_back(path);
+    _workCondition.notify_one();
+}
+
+std::string IncludePrefetcher::getFullPath(absl::string_view path) const
+{
+    std::string file { path };
+    std::replace(file.begin(), file.end(), '\\', '/');
+    const fs::path filePath { file };
+    return (filePath.is_absolute() ? filePath : _rootDirectory / filePath).string();
+}
+
 }  // namespace sfz
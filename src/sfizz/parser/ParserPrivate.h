@@ -8,7 +8,18 @@
 #include "Parser.h"
 #include "ghc/fs_std.hpp"
 #include "absl/strings/string_view.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include <fstream>
 
 namespace sfz {
@@ -101,7 +112,12 @@ private:
 private:
     std::string _accum; // new characters at the front, old at the back
     SourceLocation _loc;
-    std::vector<int> _lineNumColumns;
+    // the columns at the ends of the last lines, by line number modulo the
+    // size, to restore when putting back their newlines. The characters put
+    // back come from the line being read, so few lines are kept whatever the
+    // size of the source.
+    static constexpr size_t kLineHistorySize = 16;
+    std::array<size_t, kLineHistorySize> _lineEndColumns {};
 };
 
 /**
@@ -116,7 +132,13 @@ protected:
     int getNextStreamByte() override;
 
 private:
+    // the file is read through a buffer of fixed size, which holds the only
+    // part of the source text in memory
+    static constexpr size_t kBufferSize = 64 * 1024;
     fs::ifstream _fileStream;
+    std::unique_ptr<char[]> _buffer;
+    size_t _bufferPosition { 0 };
+    size_t _bufferFill { 0 };
 };
 
 /**
@@ -134,6 +156,75 @@ private:
     size_t position { 0 };
 };
 
+/**
+ * @brief String-based version of Reader, which owns the string.
+ */
+class StringReader : public Reader {
+public:
+    explicit StringReader(const fs::path& filePath, std::string sfzText);
+
+protected:
+    int getNextStreamByte() override;
+
+private:
+    std::string _sfzText;
+    size_t position { 0 };
+};
+
+/**
+ * @brief Reader of the files included by a parse, ahead of the parser.
+ *
+ * The files scanned by the prefetcher are searched for `#include` directives,
+ * and the files they include are read into memory concurrently, and scanned
+ * in turn. The parser then takes the contents of the included files as it
+ * reaches them, so the latency of opening each file overlaps the parsing.
+ *
+ * The includes with variables in their paths are left to the parser, which
+ * alone knows the definitions.
+ */
+class IncludePrefetcher {
+public:
+    IncludePrefetcher(const fs::path& rootDirectory, unsigned numThreads);
+    ~IncludePrefetcher();
+
+    /**
+     * @brief Look for the includes of a file which the parser reads itself.
+     */
+    void scanFile(const fs::path& path);
+
+    /**
+     * @brief Take the contents of an included file, waiting for them if they
+     * are being read. It returns nothing if the file was not prefetched or
+     * could not be read.
+     */
+    absl::optional<std::string> takeFile(const fs::path& path);
+
+private:
+    enum class State { Queued, Running, Done };
+
+    struct Entry {
+        State state { State::Queued };
+        bool keepContents { false };
+        absl::optional<std::string> contents;
+    };
+
+    void work();
+    absl::optional<std::string> process(const fs::path& path, bool keepContents);
+    void queueIncludes(absl::string_view line);
+    void enqueue(const std::string& path, bool keepContents);
+    std::string getFullPath(absl::string_view path) const;
+
+    fs::path _rootDirectory;
+    std::mutex _mutex;
+    std::condition_variable _workCondition;
+    std::condition_variable _doneCondition;
+    std::deque<std::string> _queue;
+    absl::flat_hash_map<std::string, Entry> _entries;
+    absl::flat_hash_set<std::string> _seen;
+    std::atomic<bool> _stopping { false };
+    std::vector<std::thread> _threads;
+};
+
 }  // namespace sfz
 
 #include "ParserPrivate.hpp"
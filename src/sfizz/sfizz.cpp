@@ -6,9 +6,13 @@
 
 #include "Synth.h"
 #include "Messaging.h"
+#include "SampleMemory.h"
+#include "TaskScheduler.h"
+#include "VoiceBudget.h"
 #include "sfizz.hpp"
 #include "sfizz_private.hpp"
 #include "absl/memory/memory.h"
+#include <algorithm>
 
 sfz::Sfizz::Sfizz()
     : synth(new sfizz_synth_t)
@@ -55,6 +59,84 @@ bool sfz::Sfizz::loadSfzString(const std::string& path, const std::string& text)
     return synth->synth.loadSfzString(path, text);
 }
 
+void sfz::Sfizz::LoadDeleter::operator()(sfizz_load_t *load) const noexcept
+{
+    delete load;
+}
+
+auto sfz::Sfizz::loadSfzFileAsync(const std::string& path, std::function<void(const LoadProgress&)> callback) -> LoadPtr
+{
+    sfz::Synth::LoadProgressCallback progressCallback;
+    if (callback) {
+        progressCallback = [callback](const sfz::Synth::LoadProgress& progress) {
+            callback(LoadProgress {
+                progress.numRegions,
+                progress.numFilesToPreload,
+                progress.numPreloadedFiles,
+                progress.numBytesRead,
+            });
+        };
+    }
+
+    return LoadPtr(new sfizz_load_t { synth->synth.loadSfzFileAsync(path, std::move(progressCallback)) });
+}
+
+void sfz::Sfizz::cancelLoad(sfizz_load_t& load) noexcept
+{
+    load.load->cancel();
+}
+
+bool sfz::Sfizz::isLoadDone(sfizz_load_t& load) noexcept
+{
+    return load.load->isDone();
+}
+
+bool sfz::Sfizz::waitLoad(sfizz_load_t& load)
+{
+    return load.load->wait();
+}
+
+auto sfz::Sfizz::getLoadProgress(sfizz_load_t& load) noexcept -> LoadProgress
+{
+    const sfz::Synth::LoadProgress progress = load.load->getProgress();
+    return LoadProgress {
+        progress.numRegions,
+        progress.numFilesToPreload,
+        progress.numPreloadedFiles,
+        progress.numBytesRead,
+    };
+}
+
+bool sfz::Sfizz::loadResidentProgram(int program, const std::string& path)
+{
+    return synth->synth.loadResidentProgram(program, path);
+}
+
+void sfz::Sfizz::removeResidentProgram(int program)
+{
+    synth->synth.removeResidentProgram(program);
+}
+
+bool sfz::Sfizz::hasResidentProgram(int program) const noexcept
+{
+    return synth->synth.hasResidentProgram(program);
+}
+
+int sfz::Sfizz::getActiveProgram() const noexcept
+{
+    return synth->synth.getActiveProgram();
+}
+
+std::vector<uint8_t> sfz::Sfizz::saveState() const
+{
+    return synth->synth.saveState();
+}
+
+bool sfz::Sfizz::loadState(const void* data, size_t size)
+{
+    return synth->synth.loadState(data, size);
+}
+
 bool sfz::Sfizz::loadScalaFile(const std::string& path)
 {
     return synth->synth.loadScalaFile(path);
@@ -120,6 +202,11 @@ size_t sfz::Sfizz::getNumPreloadedSamples() const noexcept
     return synth->synth.getNumPreloadedSamples();
 }
 
+size_t sfz::Sfizz::getSampleEnvelope(const std::string& sample, bool reverse, std::vector<float>& rms, std::vector<float>& peak) const
+{
+    return synth->synth.getSampleEnvelope(sample, reverse, rms, peak);
+}
+
 void sfz::Sfizz::setSamplesPerBlock(int samplesPerBlock) noexcept
 {
     synth->synth.setSamplesPerBlock(samplesPerBlock);
@@ -130,6 +217,26 @@ void sfz::Sfizz::setSampleRate(float sampleRate) noexcept
     synth->synth.setSampleRate(sampleRate);
 }
 
+void sfz::Sfizz::setMaxProcessingRate(float sampleRate) noexcept
+{
+    synth->synth.setMaxProcessingRate(sampleRate);
+}
+
+float sfz::Sfizz::getMaxProcessingRate() const noexcept
+{
+    return synth->synth.getMaxProcessingRate();
+}
+
+float sfz::Sfizz::getProcessingRate() const noexcept
+{
+    return synth->synth.getProcessingRate();
+}
+
+int sfz::Sfizz::getLatency() const noexcept
+{
+    return synth->synth.getLatency();
+}
+
 int sfz::Sfizz::getSampleQuality(ProcessMode mode)
 {
     return synth->synth.getSampleQuality(static_cast<sfz::Synth::ProcessMode>(mode));
@@ -150,11 +257,271 @@ void sfz::Sfizz::setOscillatorQuality(ProcessMode mode, int quality)
     synth->synth.setOscillatorQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
 }
 
+int sfz::Sfizz::getEffectQuality(ProcessMode mode)
+{
+    return synth->synth.getEffectQuality(static_cast<sfz::Synth::ProcessMode>(mode));
+}
+
+void sfz::Sfizz::setEffectQuality(ProcessMode mode, int quality)
+{
+    synth->synth.setEffectQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
+}
+
 void sfz::Sfizz::setSustainCancelsRelease(bool value)
 {
     synth->synth.setSustainCancelsRelease(value);
 }
 
+void sfz::Sfizz::setVoiceCullingThreshold(float threshold)
+{
+    synth->synth.setVoiceCullingThreshold(threshold);
+}
+
+float sfz::Sfizz::getVoiceCullingThreshold() const noexcept
+{
+    return synth->synth.getVoiceCullingThreshold();
+}
+
+void sfz::Sfizz::enableQualityGovernor(bool enable) noexcept
+{
+    synth->synth.enableQualityGovernor(enable);
+}
+
+bool sfz::Sfizz::isQualityGovernorEnabled() const noexcept
+{
+    return synth->synth.isQualityGovernorEnabled();
+}
+
+void sfz::Sfizz::enableAdaptiveSampleQuality(bool enable) noexcept
+{
+    synth->synth.enableAdaptiveSampleQuality(enable);
+}
+
+bool sfz::Sfizz::isAdaptiveSampleQualityEnabled() const noexcept
+{
+    return synth->synth.isAdaptiveSampleQualityEnabled();
+}
+
+int sfz::Sfizz::getQualityReduction() const noexcept
+{
+    return synth->synth.getQualityReduction();
+}
+
+void sfz::Sfizz::setSampleCacheDirectory(const std::string& directory)
+{
+    synth->synth.setSampleCacheDirectory(directory);
+}
+
+std::string sfz::Sfizz::getSampleCacheDirectory() const
+{
+    return synth->synth.getSampleCacheDirectory().string();
+}
+
+bool sfz::Sfizz::loadUsageProfile(const std::string& path)
+{
+    return synth->synth.loadUsageProfile(path);
+}
+
+bool sfz::Sfizz::saveUsageProfile(const std::string& path) const
+{
+    return synth->synth.saveUsageProfile(path);
+}
+
+int sfz::Sfizz::probeSampleDirectory(const std::string& directory)
+{
+    return static_cast<int>(synth->synth.probeSampleDirectory(directory));
+}
+
+void sfz::Sfizz::setLoadingParallelism(unsigned parallelism) noexcept
+{
+    synth->synth.setLoadingParallelism(parallelism);
+}
+
+unsigned sfz::Sfizz::getLoadingParallelism() const noexcept
+{
+    return synth->synth.getLoadingParallelism();
+}
+
+void sfz::Sfizz::setBackgroundThreadSettings(const ThreadSettings& settings)
+{
+    sfz::TaskScheduler::ThreadSettings schedulerSettings;
+    schedulerSettings.numThreads = settings.numThreads;
+    schedulerSettings.policy = static_cast<sfz::TaskScheduler::ThreadSettings::Policy>(settings.policy);
+    schedulerSettings.priority = settings.priority;
+    schedulerSettings.affinityMask = settings.affinityMask;
+    sfz::TaskScheduler::setGlobalThreadSettings(schedulerSettings);
+}
+
+auto sfz::Sfizz::getBackgroundThreadSettings() -> ThreadSettings
+{
+    const sfz::TaskScheduler::ThreadSettings schedulerSettings = sfz::TaskScheduler::getGlobalThreadSettings();
+    return ThreadSettings {
+        schedulerSettings.numThreads,
+        static_cast<ThreadSettings::Policy>(schedulerSettings.policy),
+        schedulerSettings.priority,
+        schedulerSettings.affinityMask,
+    };
+}
+
+void sfz::Sfizz::setSampleMemoryPages(MemoryPages pages)
+{
+    sfz::SampleMemory::setPages(static_cast<sfz::SampleMemory::Pages>(pages));
+}
+
+auto sfz::Sfizz::getSampleMemoryPages() -> MemoryPages
+{
+    return static_cast<MemoryPages>(sfz::SampleMemory::getPages());
+}
+
+void sfz::Sfizz::setStreamingWindow(uint32_t numFrames) noexcept
+{
+    synth->synth.setStreamingWindow(numFrames);
+}
+
+uint32_t sfz::Sfizz::getStreamingWindow() const noexcept
+{
+    return synth->synth.getStreamingWindow();
+}
+
+void sfz::Sfizz::setMemoryBudget(size_t numBytes) noexcept
+{
+    synth->synth.setMemoryBudget(numBytes);
+}
+
+size_t sfz::Sfizz::getMemoryBudget() const noexcept
+{
+    return synth->synth.getMemoryBudget();
+}
+
+void sfz::Sfizz::enableImmediateRelease(bool enable) noexcept
+{
+    synth->synth.enableImmediateRelease(enable);
+}
+
+bool sfz::Sfizz::isImmediateReleaseEnabled() const noexcept
+{
+    return synth->synth.isImmediateReleaseEnabled();
+}
+
+void sfz::Sfizz::setNumaNode(int node) noexcept
+{
+    synth->synth.setNumaNode(node);
+}
+
+int sfz::Sfizz::getNumaNode() const noexcept
+{
+    return synth->synth.getNumaNode();
+}
+
+int sfz::Sfizz::getCurrentNumaNode() noexcept
+{
+    return sfz::SampleMemory::getCurrentNode();
+}
+
+void sfz::Sfizz::enableLazyKeyswitchPreloading(bool enable) noexcept
+{
+    synth->synth.enableLazyKeyswitchPreloading(enable);
+}
+
+bool sfz::Sfizz::isLazyKeyswitchPreloadingEnabled() const noexcept
+{
+    return synth->synth.isLazyKeyswitchPreloadingEnabled();
+}
+
+void sfz::Sfizz::setEagerKeyswitch(int noteNumber, bool eager) noexcept
+{
+    synth->synth.setEagerKeyswitch(noteNumber, eager);
+}
+
+bool sfz::Sfizz::isEagerKeyswitch(int noteNumber) const noexcept
+{
+    return synth->synth.isEagerKeyswitch(noteNumber);
+}
+
+void sfz::Sfizz::enableReleasePrewarming(bool enable) noexcept
+{
+    synth->synth.enableReleasePrewarming(enable);
+}
+
+bool sfz::Sfizz::isReleasePrewarmingEnabled() const noexcept
+{
+    return synth->synth.isReleasePrewarmingEnabled();
+}
+
+size_t sfz::Sfizz::getMemoryUsage() const noexcept
+{
+    return synth->synth.getMemoryUsage();
+}
+
+auto sfz::Sfizz::getMemoryBreakdown() const noexcept -> MemoryBreakdown
+{
+    const sfz::Synth::MemoryBreakdown memory = synth->synth.getMemoryBreakdown();
+    return MemoryBreakdown {
+        memory.preloadedSamples,
+        memory.streamedSamples,
+        memory.wavetables,
+        memory.voices,
+        memory.bufferPool,
+        memory.effectBuses,
+        memory.regions,
+        memory.total(),
+    };
+}
+
+auto sfz::Sfizz::getUnderrunStats() const noexcept -> UnderrunStats
+{
+    const sfz::Synth::UnderrunStats stats = synth->synth.getUnderrunStats();
+    return UnderrunStats {
+        stats.numUnderruns,
+        stats.numMissingFrames,
+        stats.lastRegion,
+    };
+}
+
+void sfz::Sfizz::resetUnderrunStats() noexcept
+{
+    synth->synth.resetUnderrunStats();
+}
+
+auto sfz::Sfizz::getStreamingStats() const noexcept -> StreamingStats
+{
+    const sfz::Synth::StreamingStats stats = synth->synth.getStreamingStats();
+    return StreamingStats {
+        stats.streamedBytes,
+        stats.numStreams,
+        stats.totalFirstSliceLatency,
+        stats.maxFirstSliceLatency,
+        stats.collectedBytes,
+        stats.numQueuedRequests,
+        stats.numQueuedStreams,
+        stats.numLoadingJobs,
+        stats.workersBusyTime,
+        stats.workersElapsedTime,
+        stats.numWorkers,
+    };
+}
+
+auto sfz::Sfizz::getBufferPoolStats() const noexcept -> BufferPoolStats
+{
+    const sfz::Synth::BufferPoolStats stats = synth->synth.getBufferPoolStats();
+    return BufferPoolStats {
+        stats.numBuffers,
+        stats.numStereoBuffers,
+        stats.numIndexBuffers,
+        stats.maxBuffersUsed,
+        stats.maxStereoBuffersUsed,
+        stats.maxIndexBuffersUsed,
+        stats.numBufferFailures,
+        stats.numStereoBufferFailures,
+        stats.numIndexBufferFailures,
+    };
+}
+
+void sfz::Sfizz::resetBufferPoolStats() noexcept
+{
+    synth->synth.resetBufferPoolStats();
+}
+
 float sfz::Sfizz::getVolume() const noexcept
 {
     return synth->synth.getVolume();
@@ -240,6 +607,21 @@ void sfz::Sfizz::hdPolyAftertouch(int delay, int noteNumber, float aftertouch) n
     synth->synth.hdPolyAftertouch(delay, noteNumber, aftertouch);
 }
 
+void sfz::Sfizz::hdPerNotePitchWheel(int delay, int noteNumber, float pitch) noexcept
+{
+    synth->synth.hdPerNotePitchWheel(delay, noteNumber, pitch);
+}
+
+void sfz::Sfizz::hdPerNoteTimbre(int delay, int noteNumber, float timbre) noexcept
+{
+    synth->synth.hdPerNoteTimbre(delay, noteNumber, timbre);
+}
+
+void sfz::Sfizz::sendEvents(const sfizz_event_t* events, size_t count) noexcept
+{
+    synth->synth.sendEvents(events, count);
+}
+
 void sfz::Sfizz::tempo(int delay, float secondsPerBeat) noexcept
 {
     synth->synth.tempo(delay, secondsPerBeat);
@@ -271,11 +653,39 @@ void sfz::Sfizz::renderBlock(float** buffers, size_t numSamples, int numOutputs)
     synth->synth.renderBlock(bufferSpan);
 }
 
+void sfz::Sfizz::renderBlockAdding(float** buffers, size_t numSamples, int numOutputs) noexcept
+{
+    sfz::AudioSpan<float> bufferSpan { buffers, static_cast<size_t>(numOutputs * 2), 0, numSamples };
+    synth->synth.renderBlockAdding(bufferSpan);
+}
+
+void sfz::Sfizz::renderBlockInterleaved(float* buffer, size_t numSamples, int numOutputs, bool adding) noexcept
+{
+    synth->synth.renderBlockInterleaved(buffer, static_cast<size_t>(numOutputs * 2), numSamples, adding);
+}
+
 int sfz::Sfizz::getNumActiveVoices() const noexcept
 {
     return synth->synth.getNumActiveVoices();
 }
 
+auto sfz::Sfizz::getStateSnapshot() const noexcept -> StateSnapshot
+{
+    const sfz::Synth::StateSnapshot state = synth->synth.getStateSnapshot();
+    static_assert(sizeof(StateSnapshot::ccValues) / sizeof(float) == config::numCCs, "The CCs must match the configuration");
+
+    StateSnapshot snapshot;
+    snapshot.version = state.version;
+    snapshot.numActiveVoices = state.numActiveVoices;
+    snapshot.activeNotes = state.activeNotes;
+    snapshot.program = state.program;
+    snapshot.pitchBend = state.pitchBend;
+    snapshot.channelAftertouch = state.channelAftertouch;
+    std::copy(state.noteVelocities.begin(), state.noteVelocities.end(), snapshot.noteVelocities);
+    std::copy(state.ccValues.begin(), state.ccValues.end(), snapshot.ccValues);
+    return snapshot;
+}
+
 int sfz::Sfizz::getNumVoices() const noexcept
 {
     return synth->synth.getNumVoices();
@@ -286,15 +696,39 @@ void sfz::Sfizz::setNumVoices(int numVoices) noexcept
     synth->synth.setNumVoices(numVoices);
 }
 
-bool sfz::Sfizz::setOversamplingFactor(int) noexcept
+void sfz::Sfizz::setSharedVoiceLimit(int numVoices) noexcept
+{
+    sfz::VoiceBudget::getGlobal().setLimit(numVoices);
+}
+
+int sfz::Sfizz::getSharedVoiceLimit() noexcept
+{
+    return sfz::VoiceBudget::getGlobal().getLimit();
+}
+
+void sfz::Sfizz::setSharedVoiceBudget(bool shared, float weight) noexcept
+{
+    synth->synth.setVoiceBudget(shared ? &sfz::VoiceBudget::getGlobal() : nullptr, weight);
+}
+
+int sfz::Sfizz::getNumRenderThreads() const noexcept
+{
+    return synth->synth.getNumRenderThreads();
+}
+
+void sfz::Sfizz::setNumRenderThreads(int numThreads) noexcept
 {
-    return true;
+    synth->synth.setNumRenderThreads(numThreads);
 }
 
+bool sfz::Sfizz::setOversamplingFactor(int factor) noexcept
+{
+    return synth->synth.setOversamplingFactor(factor);
+}
 
 int sfz::Sfizz::getOversamplingFactor() const noexcept
 {
-    return 1;
+    return synth->synth.getOversamplingFactor();
 }
 
 void sfz::Sfizz::setPreloadSize(uint32_t preloadSize) noexcept
@@ -307,6 +741,26 @@ uint32_t sfz::Sfizz::getPreloadSize() const noexcept
     return synth->synth.getPreloadSize();
 }
 
+void sfz::Sfizz::enableAdaptivePreloading(bool enable) noexcept
+{
+    synth->synth.enableAdaptivePreloading(enable);
+}
+
+bool sfz::Sfizz::isAdaptivePreloadingEnabled() const noexcept
+{
+    return synth->synth.isAdaptivePreloadingEnabled();
+}
+
+bool sfz::Sfizz::updateAdaptivePreloading() noexcept
+{
+    return synth->synth.updateAdaptivePreloading();
+}
+
+double sfz::Sfizz::getStreamingLatency(double percentile) const noexcept
+{
+    return synth->synth.getStreamingLatency(percentile);
+}
+
 int sfz::Sfizz::getAllocatedBuffers() const noexcept
 {
     return synth->synth.getAllocatedBuffers();
@@ -366,9 +820,52 @@ sfz::Sfizz::CallbackBreakdown sfz::Sfizz::getCallbackBreakdown() noexcept
     breakdown.dispatch = bd.dispatch;
     breakdown.filters = bd.filters;
     breakdown.effects = bd.effects;
+    breakdown.culledVoices = bd.culledVoices;
     return breakdown;
 }
 
+auto sfz::Sfizz::getCallbackStats(CallbackStage stage) const noexcept -> CallbackStats
+{
+    const sfz::Synth::CallbackStats stats =
+        synth->synth.getCallbackStats(static_cast<sfz::Synth::CallbackStage>(stage));
+    return CallbackStats {
+        stats.numCallbacks,
+        stats.min,
+        stats.max,
+        stats.mean,
+        stats.p50,
+        stats.p99,
+        stats.p999,
+    };
+}
+
+void sfz::Sfizz::resetCallbackStats() noexcept
+{
+    synth->synth.resetCallbackStats();
+}
+
+auto sfz::Sfizz::getVoiceStartStats(VoiceStartStage stage) const noexcept -> VoiceStartStats
+{
+    const sfz::Synth::VoiceStartStats stats =
+        synth->synth.getVoiceStartStats(static_cast<sfz::Synth::VoiceStartStage>(stage));
+    return VoiceStartStats {
+        stats.numStarts,
+        stats.min,
+        stats.max,
+        stats.mean,
+        stats.p50,
+        stats.p99,
+        stats.p999,
+        stats.numPreloaded,
+        stats.numNotPreloaded,
+    };
+}
+
+void sfz::Sfizz::resetVoiceStartStats() noexcept
+{
+    synth->synth.resetVoiceStartStats();
+}
+
 void sfz::Sfizz::allSoundOff() noexcept
 {
     synth->synth.allSoundOff();
@@ -424,6 +921,11 @@ void sfz::Sfizz::sendMessage(Client& client, int delay, const char* path, const
     synth->synth.dispatchMessage(client, delay, path, sig, args);
 }
 
+uint32_t sfz::Sfizz::sendMessageBundle(int delay, const void* requests, uint32_t requestsSize, void* replies, uint32_t repliesCapacity)
+{
+    return synth->synth.dispatchMessageBundle(delay, requests, requestsSize, replies, repliesCapacity);
+}
+
 void sfz::Sfizz::setBroadcastCallback(sfizz_receive_t* broadcast, void* data)
 {
     synth->synth.setBroadcastCallback(broadcast, data);
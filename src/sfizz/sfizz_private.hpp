@@ -35,3 +35,7 @@ public:
     sfz::Synth synth;
     std::atomic<size_t> rc;
 };
+
+struct sfizz_load_t {
+    std::unique_ptr<sfz::Synth::AsyncLoad> load;
+};
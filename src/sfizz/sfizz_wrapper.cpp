@@ -7,6 +7,9 @@
 #include "Config.h"
 #include "Synth.h"
 #include "Messaging.h"
+#include "SampleMemory.h"
+#include "TaskScheduler.h"
+#include "VoiceBudget.h"
 #include "utility/Macros.h"
 #include "sfizz.h"
 #include "sfizz_private.hpp"
@@ -26,6 +29,89 @@ bool sfizz_load_file(sfizz_synth_t* synth, const char* path)
     return synth->synth.loadSfzFile(path);
 }
 
+sfizz_load_t* sfizz_load_file_async(sfizz_synth_t* synth, const char* path, sfizz_load_progress_callback_t* callback, void* data)
+{
+    sfz::Synth::LoadProgressCallback progressCallback;
+    if (callback) {
+        progressCallback = [callback, data](const sfz::Synth::LoadProgress& progress) {
+            const sfizz_load_progress_t cProgress {
+                progress.numRegions,
+                progress.numFilesToPreload,
+                progress.numPreloadedFiles,
+                progress.numBytesRead,
+            };
+            callback(data, &cProgress);
+        };
+    }
+
+    return new sfizz_load_t { synth->synth.loadSfzFileAsync(path, std::move(progressCallback)) };
+}
+
+void sfizz_cancel_load(sfizz_load_t* load)
+{
+    load->load->cancel();
+}
+
+bool sfizz_is_load_done(sfizz_load_t* load)
+{
+    return load->load->isDone();
+}
+
+bool sfizz_wait_load(sfizz_load_t* load)
+{
+    return load->load->wait();
+}
+
+void sfizz_get_load_progress(sfizz_load_t* load, sfizz_load_progress_t* progress)
+{
+    const sfz::Synth::LoadProgress current = load->load->getProgress();
+    progress->num_regions = current.numRegions;
+    progress->num_files_to_preload = current.numFilesToPreload;
+    progress->num_preloaded_files = current.numPreloadedFiles;
+    progress->num_bytes_read = current.numBytesRead;
+}
+
+void sfizz_free_load(sfizz_load_t* load)
+{
+    delete load;
+}
+
+bool sfizz_load_resident_program(sfizz_synth_t* synth, int program, const char* path)
+{
+    return synth->synth.loadResidentProgram(program, path);
+}
+
+void sfizz_remove_resident_program(sfizz_synth_t* synth, int program)
+{
+    synth->synth.removeResidentProgram(program);
+}
+
+bool sfizz_has_resident_program(sfizz_synth_t* synth, int program)
+{
+    return synth->synth.hasResidentProgram(program);
+}
+
+int sfizz_get_active_program(sfizz_synth_t* synth)
+{
+    return synth->synth.getActiveProgram();
+}
+
+void* sfizz_save_state(sfizz_synth_t* synth, size_t* size)
+{
+    const std::vector<uint8_t> state = synth->synth.saveState();
+    void* data = std::malloc(state.size());
+    if (data)
+        std::copy(state.begin(), state.end(), static_cast<uint8_t*>(data));
+    if (size)
+        *size = data ? state.size() : 0;
+    return data;
+}
+
+bool sfizz_load_state(sfizz_synth_t* synth, const void* data, size_t size)
+{
+    return synth->synth.loadState(data, size);
+}
+
 bool sfizz_load_string(sfizz_synth_t* synth, const char* path, const char* text)
 {
     return synth->synth.loadSfzString(path, text);
@@ -113,6 +199,22 @@ void sfizz_set_sample_rate(sfizz_synth_t* synth, float sample_rate)
 {
     synth->synth.setSampleRate(sample_rate);
 }
+void sfizz_set_max_processing_rate(sfizz_synth_t* synth, float sample_rate)
+{
+    synth->synth.setMaxProcessingRate(sample_rate);
+}
+float sfizz_get_max_processing_rate(sfizz_synth_t* synth)
+{
+    return synth->synth.getMaxProcessingRate();
+}
+float sfizz_get_processing_rate(sfizz_synth_t* synth)
+{
+    return synth->synth.getProcessingRate();
+}
+int sfizz_get_latency(sfizz_synth_t* synth)
+{
+    return synth->synth.getLatency();
+}
 
 void sfizz_send_note_on(sfizz_synth_t* synth, int delay, int note_number, int velocity)
 {
@@ -174,6 +276,18 @@ void sfizz_send_hd_poly_aftertouch(sfizz_synth_t* synth, int delay, int note_num
 {
     synth->synth.hdPolyAftertouch(delay, note_number, aftertouch);
 }
+void sfizz_send_hd_per_note_pitch_wheel(sfizz_synth_t* synth, int delay, int note_number, float pitch)
+{
+    synth->synth.hdPerNotePitchWheel(delay, note_number, pitch);
+}
+void sfizz_send_hd_per_note_timbre(sfizz_synth_t* synth, int delay, int note_number, float timbre)
+{
+    synth->synth.hdPerNoteTimbre(delay, note_number, timbre);
+}
+void sfizz_send_events(sfizz_synth_t* synth, const sfizz_event_t* events, size_t count)
+{
+    synth->synth.sendEvents(events, count);
+}
 void sfizz_send_tempo(sfizz_synth_t* synth, int delay, float seconds_per_quarter)
 {
     synth->synth.tempo(delay, seconds_per_quarter);
@@ -201,6 +315,22 @@ void sfizz_render_block(sfizz_synth_t* synth, float** channels, int num_channels
     synth->synth.renderBlock(channelSpan);
 }
 
+void sfizz_render_block_adding(sfizz_synth_t* synth, float** channels, int num_channels, int num_frames)
+{
+    sfz::AudioSpan<float> channelSpan { channels, static_cast<size_t>(num_channels), 0, static_cast<size_t>(num_frames) };
+    synth->synth.renderBlockAdding(channelSpan);
+}
+
+void sfizz_render_block_interleaved(sfizz_synth_t* synth, float* buffer, int num_channels, int num_frames)
+{
+    synth->synth.renderBlockInterleaved(buffer, static_cast<size_t>(num_channels), static_cast<size_t>(num_frames));
+}
+
+void sfizz_render_block_interleaved_adding(sfizz_synth_t* synth, float* buffer, int num_channels, int num_frames)
+{
+    synth->synth.renderBlockInterleaved(buffer, static_cast<size_t>(num_channels), static_cast<size_t>(num_frames), true);
+}
+
 unsigned int sfizz_get_preload_size(sfizz_synth_t* synth)
 {
     return synth->synth.getPreloadSize();
@@ -210,14 +340,29 @@ void sfizz_set_preload_size(sfizz_synth_t* synth, unsigned int preload_size)
     synth->synth.setPreloadSize(preload_size);
 }
 
-sfizz_oversampling_factor_t sfizz_get_oversampling_factor(sfizz_synth_t*)
+void sfizz_enable_adaptive_preloading(sfizz_synth_t* synth, bool enable)
 {
-    return SFIZZ_OVERSAMPLING_X1;
+    synth->synth.enableAdaptivePreloading(enable);
 }
 
-bool sfizz_set_oversampling_factor(sfizz_synth_t*, sfizz_oversampling_factor_t)
+bool sfizz_is_adaptive_preloading_enabled(sfizz_synth_t* synth)
 {
-    return true;
+    return synth->synth.isAdaptivePreloadingEnabled();
+}
+
+bool sfizz_update_adaptive_preloading(sfizz_synth_t* synth)
+{
+    return synth->synth.updateAdaptivePreloading();
+}
+
+sfizz_oversampling_factor_t sfizz_get_oversampling_factor(sfizz_synth_t* synth)
+{
+    return static_cast<sfizz_oversampling_factor_t>(synth->synth.getOversamplingFactor());
+}
+
+bool sfizz_set_oversampling_factor(sfizz_synth_t* synth, sfizz_oversampling_factor_t oversampling)
+{
+    return synth->synth.setOversamplingFactor(static_cast<int>(oversampling));
 }
 
 int sfizz_get_sample_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode)
@@ -240,11 +385,246 @@ void sfizz_set_oscillator_quality(sfizz_synth_t* synth, sfizz_process_mode_t mod
     return synth->synth.setOscillatorQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
 }
 
+int sfizz_get_effect_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode)
+{
+    return synth->synth.getEffectQuality(static_cast<sfz::Synth::ProcessMode>(mode));
+}
+
+void sfizz_set_effect_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode, int quality)
+{
+    return synth->synth.setEffectQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
+}
+
 void sfizz_set_sustain_cancels_release(sfizz_synth_t* synth, bool value)
 {
     return synth->synth.setSustainCancelsRelease(value);
 }
 
+void sfizz_set_voice_culling_threshold(sfizz_synth_t* synth, float threshold)
+{
+    return synth->synth.setVoiceCullingThreshold(threshold);
+}
+
+float sfizz_get_voice_culling_threshold(sfizz_synth_t* synth)
+{
+    return synth->synth.getVoiceCullingThreshold();
+}
+
+void sfizz_enable_quality_governor(sfizz_synth_t* synth, bool enable)
+{
+    return synth->synth.enableQualityGovernor(enable);
+}
+
+bool sfizz_is_quality_governor_enabled(sfizz_synth_t* synth)
+{
+    return synth->synth.isQualityGovernorEnabled();
+}
+
+void sfizz_enable_adaptive_sample_quality(sfizz_synth_t* synth, bool enable)
+{
+    return synth->synth.enableAdaptiveSampleQuality(enable);
+}
+
+bool sfizz_is_adaptive_sample_quality_enabled(sfizz_synth_t* synth)
+{
+    return synth->synth.isAdaptiveSampleQualityEnabled();
+}
+
+int sfizz_get_quality_reduction(sfizz_synth_t* synth)
+{
+    return synth->synth.getQualityReduction();
+}
+
+void sfizz_set_sample_cache_directory(sfizz_synth_t* synth, const char* directory)
+{
+    synth->synth.setSampleCacheDirectory(directory ? directory : "");
+}
+
+int sfizz_probe_sample_directory(sfizz_synth_t* synth, const char* directory)
+{
+    return directory ? static_cast<int>(synth->synth.probeSampleDirectory(directory)) : 0;
+}
+
+void sfizz_set_loading_parallelism(sfizz_synth_t* synth, unsigned int parallelism)
+{
+    synth->synth.setLoadingParallelism(parallelism);
+}
+
+unsigned int sfizz_get_loading_parallelism(sfizz_synth_t* synth)
+{
+    return synth->synth.getLoadingParallelism();
+}
+
+void sfizz_set_background_thread_settings(const sfizz_thread_settings_t* settings)
+{
+    sfz::TaskScheduler::ThreadSettings schedulerSettings;
+    schedulerSettings.numThreads = settings->num_threads;
+    schedulerSettings.policy = static_cast<sfz::TaskScheduler::ThreadSettings::Policy>(settings->policy);
+    schedulerSettings.priority = settings->priority;
+    schedulerSettings.affinityMask = settings->affinity_mask;
+    sfz::TaskScheduler::setGlobalThreadSettings(schedulerSettings);
+}
+
+void sfizz_get_background_thread_settings(sfizz_thread_settings_t* settings)
+{
+    const sfz::TaskScheduler::ThreadSettings schedulerSettings = sfz::TaskScheduler::getGlobalThreadSettings();
+    settings->num_threads = schedulerSettings.numThreads;
+    settings->policy = static_cast<sfizz_thread_policy_t>(schedulerSettings.policy);
+    settings->priority = schedulerSettings.priority;
+    settings->affinity_mask = schedulerSettings.affinityMask;
+}
+
+void sfizz_set_sample_memory_pages(sfizz_memory_pages_t pages)
+{
+    sfz::SampleMemory::setPages(static_cast<sfz::SampleMemory::Pages>(pages));
+}
+
+sfizz_memory_pages_t sfizz_get_sample_memory_pages()
+{
+    return static_cast<sfizz_memory_pages_t>(sfz::SampleMemory::getPages());
+}
+
+void sfizz_set_streaming_window(sfizz_synth_t* synth, uint32_t num_frames)
+{
+    synth->synth.setStreamingWindow(num_frames);
+}
+
+uint32_t sfizz_get_streaming_window(sfizz_synth_t* synth)
+{
+    return synth->synth.getStreamingWindow();
+}
+
+void sfizz_set_memory_budget(sfizz_synth_t* synth, size_t num_bytes)
+{
+    synth->synth.setMemoryBudget(num_bytes);
+}
+
+size_t sfizz_get_memory_budget(sfizz_synth_t* synth)
+{
+    return synth->synth.getMemoryBudget();
+}
+
+void sfizz_enable_immediate_release(sfizz_synth_t* synth, bool enable)
+{
+    synth->synth.enableImmediateRelease(enable);
+}
+
+bool sfizz_is_immediate_release_enabled(sfizz_synth_t* synth)
+{
+    return synth->synth.isImmediateReleaseEnabled();
+}
+
+void sfizz_set_numa_node(sfizz_synth_t* synth, int node)
+{
+    synth->synth.setNumaNode(node);
+}
+
+int sfizz_get_numa_node(sfizz_synth_t* synth)
+{
+    return synth->synth.getNumaNode();
+}
+
+int sfizz_get_current_numa_node()
+{
+    return sfz::SampleMemory::getCurrentNode();
+}
+
+void sfizz_enable_lazy_keyswitch_preloading(sfizz_synth_t* synth, bool enable)
+{
+    synth->synth.enableLazyKeyswitchPreloading(enable);
+}
+
+bool sfizz_is_lazy_keyswitch_preloading_enabled(sfizz_synth_t* synth)
+{
+    return synth->synth.isLazyKeyswitchPreloadingEnabled();
+}
+
+void sfizz_set_eager_keyswitch(sfizz_synth_t* synth, int note_number, bool eager)
+{
+    synth->synth.setEagerKeyswitch(note_number, eager);
+}
+
+bool sfizz_is_eager_keyswitch(sfizz_synth_t* synth, int note_number)
+{
+    return synth->synth.isEagerKeyswitch(note_number);
+}
+
+void sfizz_enable_release_prewarming(sfizz_synth_t* synth, bool enable)
+{
+    synth->synth.enableReleasePrewarming(enable);
+}
+
+bool sfizz_is_release_prewarming_enabled(sfizz_synth_t* synth)
+{
+    return synth->synth.isReleasePrewarmingEnabled();
+}
+
+size_t sfizz_get_memory_usage(sfizz_synth_t* synth)
+{
+    return synth->synth.getMemoryUsage();
+}
+
+void sfizz_get_memory_breakdown(sfizz_synth_t* synth, sfizz_memory_breakdown_t* memory)
+{
+    const sfz::Synth::MemoryBreakdown synthMemory = synth->synth.getMemoryBreakdown();
+    memory->preloaded_samples = synthMemory.preloadedSamples;
+    memory->streamed_samples = synthMemory.streamedSamples;
+    memory->wavetables = synthMemory.wavetables;
+    memory->voices = synthMemory.voices;
+    memory->buffer_pool = synthMemory.bufferPool;
+    memory->effect_buses = synthMemory.effectBuses;
+    memory->regions = synthMemory.regions;
+    memory->total = synthMemory.total();
+}
+
+void sfizz_get_underrun_stats(sfizz_synth_t* synth, sfizz_underrun_stats_t* stats)
+{
+    const sfz::Synth::UnderrunStats synthStats = synth->synth.getUnderrunStats();
+    stats->num_underruns = synthStats.numUnderruns;
+    stats->num_missing_frames = synthStats.numMissingFrames;
+    stats->last_region = synthStats.lastRegion;
+}
+
+void sfizz_reset_underrun_stats(sfizz_synth_t* synth)
+{
+    synth->synth.resetUnderrunStats();
+}
+
+void sfizz_get_streaming_stats(sfizz_synth_t* synth, sfizz_streaming_stats_t* stats)
+{
+    const sfz::Synth::StreamingStats synthStats = synth->synth.getStreamingStats();
+    stats->streamed_bytes = synthStats.streamedBytes;
+    stats->num_streams = synthStats.numStreams;
+    stats->total_first_slice_latency = synthStats.totalFirstSliceLatency;
+    stats->max_first_slice_latency = synthStats.maxFirstSliceLatency;
+    stats->collected_bytes = synthStats.collectedBytes;
+    stats->num_queued_requests = synthStats.numQueuedRequests;
+    stats->num_queued_streams = synthStats.numQueuedStreams;
+    stats->num_loading_jobs = synthStats.numLoadingJobs;
+    stats->workers_busy_time = synthStats.workersBusyTime;
+    stats->workers_elapsed_time = synthStats.workersElapsedTime;
+    stats->num_workers = synthStats.numWorkers;
+}
+
+void sfizz_get_buffer_pool_stats(sfizz_synth_t* synth, sfizz_buffer_pool_stats_t* stats)
+{
+    const sfz::Synth::BufferPoolStats synthStats = synth->synth.getBufferPoolStats();
+    stats->num_buffers = synthStats.numBuffers;
+    stats->num_stereo_buffers = synthStats.numStereoBuffers;
+    stats->num_index_buffers = synthStats.numIndexBuffers;
+    stats->max_buffers_used = synthStats.maxBuffersUsed;
+    stats->max_stereo_buffers_used = synthStats.maxStereoBuffersUsed;
+    stats->max_index_buffers_used = synthStats.maxIndexBuffersUsed;
+    stats->num_buffer_failures = synthStats.numBufferFailures;
+    stats->num_stereo_buffer_failures = synthStats.numStereoBufferFailures;
+    stats->num_index_buffer_failures = synthStats.numIndexBufferFailures;
+}
+
+void sfizz_reset_buffer_pool_stats(sfizz_synth_t* synth)
+{
+    synth->synth.resetBufferPoolStats();
+}
+
 void sfizz_set_volume(sfizz_synth_t* synth, float volume)
 {
     synth->synth.setVolume(volume);
@@ -260,11 +640,36 @@ void sfizz_set_num_voices(sfizz_synth_t* synth, int num_voices)
     synth->synth.setNumVoices(num_voices);
 }
 
+void sfizz_set_shared_voice_limit(int num_voices)
+{
+    sfz::VoiceBudget::getGlobal().setLimit(num_voices);
+}
+
+int sfizz_get_shared_voice_limit()
+{
+    return sfz::VoiceBudget::getGlobal().getLimit();
+}
+
+void sfizz_set_shared_voice_budget(sfizz_synth_t* synth, bool shared, float weight)
+{
+    synth->synth.setVoiceBudget(shared ? &sfz::VoiceBudget::getGlobal() : nullptr, weight);
+}
+
 int sfizz_get_num_voices(sfizz_synth_t* synth)
 {
     return synth->synth.getNumVoices();
 }
 
+void sfizz_set_num_render_threads(sfizz_synth_t* synth, int num_threads)
+{
+    synth->synth.setNumRenderThreads(num_threads);
+}
+
+int sfizz_get_num_render_threads(sfizz_synth_t* synth)
+{
+    return synth->synth.getNumRenderThreads();
+}
+
 int sfizz_get_num_buffers(sfizz_synth_t* synth)
 {
     return synth->synth.getAllocatedBuffers();
@@ -345,6 +750,44 @@ void sfizz_get_callback_breakdown(sfizz_synth_t* synth, sfizz_callback_breakdown
     breakdown->effects = bd.effects;
 }
 
+void sfizz_get_callback_stats(sfizz_synth_t* synth, sfizz_callback_stage_t stage, sfizz_callback_stats_t* stats)
+{
+    const sfz::Synth::CallbackStats synthStats =
+        synth->synth.getCallbackStats(static_cast<sfz::Synth::CallbackStage>(stage));
+    stats->num_callbacks = synthStats.numCallbacks;
+    stats->min = synthStats.min;
+    stats->max = synthStats.max;
+    stats->mean = synthStats.mean;
+    stats->p50 = synthStats.p50;
+    stats->p99 = synthStats.p99;
+    stats->p999 = synthStats.p999;
+}
+
+void sfizz_reset_callback_stats(sfizz_synth_t* synth)
+{
+    synth->synth.resetCallbackStats();
+}
+
+void sfizz_get_voice_start_stats(sfizz_synth_t* synth, sfizz_voice_start_stage_t stage, sfizz_voice_start_stats_t* stats)
+{
+    const sfz::Synth::VoiceStartStats synthStats =
+        synth->synth.getVoiceStartStats(static_cast<sfz::Synth::VoiceStartStage>(stage));
+    stats->num_starts = synthStats.numStarts;
+    stats->min = synthStats.min;
+    stats->max = synthStats.max;
+    stats->mean = synthStats.mean;
+    stats->p50 = synthStats.p50;
+    stats->p99 = synthStats.p99;
+    stats->p999 = synthStats.p999;
+    stats->num_preloaded = synthStats.numPreloaded;
+    stats->num_not_preloaded = synthStats.numNotPreloaded;
+}
+
+void sfizz_reset_voice_start_stats(sfizz_synth_t* synth)
+{
+    synth->synth.resetVoiceStartStats();
+}
+
 void sfizz_all_sound_off(sfizz_synth_t* synth)
 {
     return synth->synth.allSoundOff();
@@ -458,6 +901,11 @@ void sfizz_send_message(sfizz_synth_t* synth, sfizz_client_t* client, int delay,
     synth->synth.dispatchMessage(*reinterpret_cast<sfz::Client*>(client), delay, path, sig, args);
 }
 
+uint32_t sfizz_send_message_bundle(sfizz_synth_t* synth, int delay, const void* requests, uint32_t requests_size, void* replies, uint32_t replies_capacity)
+{
+    return synth->synth.dispatchMessageBundle(delay, requests, requests_size, replies, replies_capacity);
+}
+
 void sfizz_set_broadcast_callback(sfizz_synth_t* synth, sfizz_receive_t* broadcast, void* data)
 {
     synth->synth.setBroadcastCallback(broadcast, data);
@@ -7,27 +7,192 @@
 #include "HelpersAVX.h"
 #include "../SIMDConfig.h"
 #include "../MathHelpers.h"
+#include "HelpersScalar.h"
 #include "Common.h"
+#include <algorithm>
 
-#if SFIZZ_HAVE_AVX
+/*
+   The versions for AVX2 with FMA, which go 8 frames at a time.
+
+   The buffers are aligned on 16 bytes at best, and they rarely share their
+   alignment on 32 bytes, so the loads and stores are unaligned; on the
+   processors with AVX2 they cost the same as the aligned ones when the data
+   happens to be aligned.
+ */
+
+#define SFIZZ_HAVE_AVX2_FMA (SFIZZ_HAVE_AVX2 && SFIZZ_HAVE_FMA)
+
+#if SFIZZ_HAVE_AVX2_FMA
 #include <immintrin.h>
 using Type = float;
 constexpr unsigned TypeAlignment = 8;
-constexpr unsigned ByteAlignment = TypeAlignment * sizeof(Type);
+
+/**
+ * @brief Broadcast the last element of the register to all the elements
+ */
+static inline __m256 broadcastLast(__m256 x) noexcept
+{
+    return _mm256_permutevar8x32_ps(x, _mm256_set1_epi32(7));
+}
+
+/**
+ * @brief Sum of the elements of the register
+ */
+static inline float horizontalSum(__m256 x) noexcept
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+}
+#endif
+
+bool helpersAVXAvailable() noexcept
+{
+    return SFIZZ_HAVE_AVX2_FMA;
+}
+
+void readInterleavedAVX(const float* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + inputSize - 1;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (input + 2 * TypeAlignment <= sentinel + 1) {
+        // L0 R0 L1 R1 L2 R2 L3 R3 | L4 R4 L5 R5 L6 R6 L7 R7
+        const auto register0 = _mm256_loadu_ps(input);
+        const auto register1 = _mm256_loadu_ps(input + TypeAlignment);
+        // L0 L1 L4 L5 L2 L3 L6 L7, the 128-bit lanes go back in order after
+        const auto left = _mm256_shuffle_ps(register0, register1, 0b10001000);
+        const auto right = _mm256_shuffle_ps(register0, register1, 0b11011101);
+        _mm256_storeu_ps(outputLeft, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(left), 0b11011000)));
+        _mm256_storeu_ps(outputRight, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(right), 0b11011000)));
+        input += 2 * TypeAlignment;
+        incrementAll<TypeAlignment>(outputLeft, outputRight);
+    }
+#endif
+
+    while (input < sentinel) {
+        *outputLeft++ = *input++;
+        *outputRight++ = *input++;
+    }
+}
+
+void readInterleavedInt16AVX(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + inputSize - 1;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    // Each 32-bit lane holds a frame, with the left sample in the low half
+    const auto* lastBlock = input + 16 * (inputSize / 16);
+    const auto scale = _mm256_set1_ps(1.0f / 32768.0f);
+    while (input < lastBlock) {
+        const auto frames = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+        const auto left = _mm256_srai_epi32(_mm256_slli_epi32(frames, 16), 16);
+        const auto right = _mm256_srai_epi32(frames, 16);
+        _mm256_storeu_ps(outputLeft, _mm256_mul_ps(_mm256_cvtepi32_ps(left), scale));
+        _mm256_storeu_ps(outputRight, _mm256_mul_ps(_mm256_cvtepi32_ps(right), scale));
+        input += 16;
+        incrementAll<TypeAlignment>(outputLeft, outputRight);
+    }
+#endif
+
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<float>(*input++) * (1.0f / 32768.0f);
+        *outputRight++ = static_cast<float>(*input++) * (1.0f / 32768.0f);
+    }
+}
+
+void readInterleavedInt24AVX(const uint8_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + 3 * (inputSize & ~1u);
+
+#if SFIZZ_HAVE_AVX2_FMA
+    // Each lane gathers the byte before its sample, which the mask clears.
+    // The first frame is done apart, so that the loads stay in the input.
+    if (input < sentinel) {
+        *outputLeft++ = static_cast<float>(readInt24(input)) * (1.0f / 2147483648.0f);
+        *outputRight++ = static_cast<float>(readInt24(input + 3)) * (1.0f / 2147483648.0f);
+        input += 6;
+    }
+    const auto* lastBlock = input + 48 * ((sentinel - input) / 48);
+    const auto scale = _mm256_set1_ps(1.0f / 2147483648.0f);
+    const auto mask = _mm256_set1_epi32(~0xff);
+    const auto leftOffsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    const auto rightOffsets = _mm256_add_epi32(leftOffsets, _mm256_set1_epi32(3));
+    while (input < lastBlock) {
+        const int* base = reinterpret_cast<const int*>(input - 1);
+        const auto left = _mm256_i32gather_epi32(base, leftOffsets, 1);
+        const auto right = _mm256_i32gather_epi32(base, rightOffsets, 1);
+        _mm256_storeu_ps(outputLeft, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(left, mask)), scale));
+        _mm256_storeu_ps(outputRight, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(right, mask)), scale));
+        input += 48;
+        incrementAll<TypeAlignment>(outputLeft, outputRight);
+    }
 #endif
 
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<float>(readInt24(input)) * (1.0f / 2147483648.0f);
+        *outputRight++ = static_cast<float>(readInt24(input + 3)) * (1.0f / 2147483648.0f);
+        input += 6;
+    }
+}
+
+void writeInterleavedAVX(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept
+{
+    const auto* sentinel = output + outputSize - 1;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + 2 * TypeAlignment <= sentinel + 1) {
+        const auto left = _mm256_loadu_ps(inputLeft);
+        const auto right = _mm256_loadu_ps(inputRight);
+        // L0 R0 L1 R1 L4 R4 L5 R5 and L2 R2 L3 R3 L6 R6 L7 R7
+        const auto low = _mm256_unpacklo_ps(left, right);
+        const auto high = _mm256_unpackhi_ps(left, right);
+        _mm256_storeu_ps(output, _mm256_permute2f128_ps(low, high, 0x20));
+        _mm256_storeu_ps(output + TypeAlignment, _mm256_permute2f128_ps(low, high, 0x31));
+        output += 2 * TypeAlignment;
+        incrementAll<TypeAlignment>(inputLeft, inputRight);
+    }
+#endif
+
+    while (output < sentinel) {
+        *output++ = *inputLeft++;
+        *output++ = *inputRight++;
+    }
+}
+
+void addInterleavedAVX(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept
+{
+    const auto* sentinel = output + outputSize - 1;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + 2 * TypeAlignment <= sentinel + 1) {
+        const auto left = _mm256_loadu_ps(inputLeft);
+        const auto right = _mm256_loadu_ps(inputRight);
+        const auto low = _mm256_unpacklo_ps(left, right);
+        const auto high = _mm256_unpackhi_ps(left, right);
+        float* output2 = output + TypeAlignment;
+        _mm256_storeu_ps(output, _mm256_add_ps(_mm256_loadu_ps(output), _mm256_permute2f128_ps(low, high, 0x20)));
+        _mm256_storeu_ps(output2, _mm256_add_ps(_mm256_loadu_ps(output2), _mm256_permute2f128_ps(low, high, 0x31)));
+        output += 2 * TypeAlignment;
+        incrementAll<TypeAlignment>(inputLeft, inputRight);
+    }
+#endif
+
+    while (output < sentinel) {
+        *output++ += *inputLeft++;
+        *output++ += *inputRight++;
+    }
+}
+
 void gain1AVX(float gain, const float* input, float* output, unsigned size) noexcept
 {
     const auto* sentinel = output + size;
 
-#if SFIZZ_HAVE_AVX
-    const auto* lastAligned = prevAligned<ByteAlignment>(sentinel);
+#if SFIZZ_HAVE_AVX2_FMA
     const auto mmGain = _mm256_set1_ps(gain);
-    while (unaligned<ByteAlignment>(input, output) && output < lastAligned)
-        *output++ = gain * (*input++);
-
-    while (output < lastAligned) {
-        _mm256_store_ps(output, _mm256_mul_ps(mmGain, _mm256_load_ps(input)));
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_mul_ps(mmGain, _mm256_loadu_ps(input)));
         incrementAll<TypeAlignment>(input, output);
     }
 #endif
@@ -40,17 +205,555 @@ void gainAVX(const float* gain, const float* input, float* output, unsigned size
 {
     const auto* sentinel = output + size;
 
-#if SFIZZ_HAVE_AVX
-    const auto* lastAligned = prevAligned<ByteAlignment>(sentinel);
-    while (unaligned<ByteAlignment>(input, output) && output < lastAligned)
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_mul_ps(_mm256_loadu_ps(gain), _mm256_loadu_ps(input)));
+        incrementAll<TypeAlignment>(gain, input, output);
+    }
+#endif
+
+    while (output < sentinel)
         *output++ = (*gain++) * (*input++);
+}
+
+void divideAVX(const float* input, const float* divisor, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_div_ps(_mm256_loadu_ps(input), _mm256_loadu_ps(divisor)));
+        incrementAll<TypeAlignment>(divisor, input, output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ = (*input++) / (*divisor++);
+}
 
-    while (output < lastAligned) {
-        _mm256_store_ps(output, _mm256_mul_ps(_mm256_load_ps(gain), _mm256_load_ps(input)));
+void multiplyAddAVX(const float* gain, const float* input, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_fmadd_ps(_mm256_loadu_ps(gain), _mm256_loadu_ps(input), _mm256_loadu_ps(output)));
+        incrementAll<TypeAlignment>(gain, input, output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ += (*gain++) * (*input++);
+}
+
+void multiplyAdd1AVX(float gain, const float* input, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto mmGain = _mm256_set1_ps(gain);
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_fmadd_ps(mmGain, _mm256_loadu_ps(input), _mm256_loadu_ps(output)));
         incrementAll<TypeAlignment>(input, output);
     }
 #endif
 
     while (output < sentinel)
-        *output++ = (*gain++) * (*input++);
+        *output++ += gain * (*input++);
+}
+
+void multiplyAdd1MultiAVX(const float* gains, const float* input, float* const outputs[], unsigned numOutputs, unsigned size) noexcept
+{
+    unsigned i = 0;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    constexpr unsigned maxGroupSize { 8 };
+    for (unsigned first = 0; first < numOutputs; first += maxGroupSize) {
+        const unsigned groupSize = std::min(maxGroupSize, numOutputs - first);
+        __m256 mmGains[maxGroupSize];
+        for (unsigned j = 0; j < groupSize; ++j)
+            mmGains[j] = _mm256_set1_ps(gains[first + j]);
+
+        float* const* groupOutputs = outputs + first;
+        for (i = 0; i + TypeAlignment <= size; i += TypeAlignment) {
+            const auto mmIn = _mm256_loadu_ps(input + i);
+            for (unsigned j = 0; j < groupSize; ++j) {
+                float* output = groupOutputs[j] + i;
+                _mm256_storeu_ps(output, _mm256_fmadd_ps(mmGains[j], mmIn, _mm256_loadu_ps(output)));
+            }
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        const float x = input[i];
+        for (unsigned j = 0; j < numOutputs; ++j)
+            outputs[j][i] += gains[j] * x;
+    }
+}
+
+void multiplyMulAVX(const float* gain, const float* input, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        const auto mmProduct = _mm256_mul_ps(_mm256_loadu_ps(gain), _mm256_loadu_ps(input));
+        _mm256_storeu_ps(output, _mm256_mul_ps(mmProduct, _mm256_loadu_ps(output)));
+        incrementAll<TypeAlignment>(gain, input, output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ *= (*gain++) * (*input++);
+}
+
+void multiplyMul1AVX(float gain, const float* input, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto mmGain = _mm256_set1_ps(gain);
+    while (output + TypeAlignment <= sentinel) {
+        const auto mmProduct = _mm256_mul_ps(mmGain, _mm256_loadu_ps(input));
+        _mm256_storeu_ps(output, _mm256_mul_ps(mmProduct, _mm256_loadu_ps(output)));
+        incrementAll<TypeAlignment>(input, output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ *= gain * (*input++);
+}
+
+float linearRampAVX(float* output, float start, float step, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    if (output + TypeAlignment <= sentinel) {
+        // The ramp restarts from the last value of each register, as in SSE
+        auto mmStart = _mm256_set1_ps(start - step);
+        const auto mmStep = _mm256_mul_ps(_mm256_set1_ps(step), _mm256_setr_ps(1, 2, 3, 4, 5, 6, 7, 8));
+        while (output + TypeAlignment <= sentinel) {
+            mmStart = _mm256_add_ps(mmStart, mmStep);
+            _mm256_storeu_ps(output, mmStart);
+            mmStart = broadcastLast(mmStart);
+            incrementAll<TypeAlignment>(output);
+        }
+        start = _mm256_cvtss_f32(mmStart) + step;
+    }
+#endif
+
+    while (output < sentinel) {
+        *output++ = start;
+        start += step;
+    }
+    return start;
+}
+
+float multiplicativeRampAVX(float* output, float start, float step, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    if (output + TypeAlignment <= sentinel) {
+        float steps[TypeAlignment];
+        steps[0] = step;
+        for (unsigned i = 1; i < TypeAlignment; ++i)
+            steps[i] = steps[i - 1] * step;
+
+        auto mmStart = _mm256_set1_ps(start / step);
+        const auto mmStep = _mm256_loadu_ps(steps);
+        while (output + TypeAlignment <= sentinel) {
+            mmStart = _mm256_mul_ps(mmStart, mmStep);
+            _mm256_storeu_ps(output, mmStart);
+            mmStart = broadcastLast(mmStart);
+            incrementAll<TypeAlignment>(output);
+        }
+        start = _mm256_cvtss_f32(mmStart) * step;
+    }
+#endif
+
+    while (output < sentinel) {
+        *output++ = start;
+        start *= step;
+    }
+    return start;
+}
+
+void addAVX(const float* input, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_add_ps(_mm256_loadu_ps(output), _mm256_loadu_ps(input)));
+        incrementAll<TypeAlignment>(input, output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ += *input++;
+}
+
+void add1AVX(float value, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto mmValue = _mm256_set1_ps(value);
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_add_ps(_mm256_loadu_ps(output), mmValue));
+        incrementAll<TypeAlignment>(output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ += value;
+}
+
+void subtractAVX(const float* input, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_sub_ps(_mm256_loadu_ps(output), _mm256_loadu_ps(input)));
+        incrementAll<TypeAlignment>(input, output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ -= *input++;
+}
+
+void subtract1AVX(float value, float* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto mmValue = _mm256_set1_ps(value);
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_sub_ps(_mm256_loadu_ps(output), mmValue));
+        incrementAll<TypeAlignment>(output);
+    }
+#endif
+
+    while (output < sentinel)
+        *output++ -= value;
+}
+
+void copyAVX(const float* input, float* output, unsigned size) noexcept
+{
+    // The sentinel is the input here
+    const auto* sentinel = input + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (input + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_loadu_ps(input));
+        incrementAll<TypeAlignment>(input, output);
+    }
+#endif
+
+    std::copy(input, sentinel, output);
+}
+
+float meanAVX(const float* vector, unsigned size) noexcept
+{
+    const auto* sentinel = vector + size;
+
+    float result { 0.0f };
+    if (size == 0)
+        return result;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    auto mmSums = _mm256_setzero_ps();
+    while (vector + TypeAlignment <= sentinel) {
+        mmSums = _mm256_add_ps(mmSums, _mm256_loadu_ps(vector));
+        incrementAll<TypeAlignment>(vector);
+    }
+    result = horizontalSum(mmSums);
+#endif
+
+    while (vector < sentinel)
+        result += *vector++;
+
+    return result / static_cast<float>(size);
+}
+
+float sumSquaresAVX(const float* vector, unsigned size) noexcept
+{
+    const auto* sentinel = vector + size;
+
+    float result { 0.0f };
+    if (size == 0)
+        return result;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    auto mmSums = _mm256_setzero_ps();
+    while (vector + TypeAlignment <= sentinel) {
+        const auto mmValues = _mm256_loadu_ps(vector);
+        mmSums = _mm256_fmadd_ps(mmValues, mmValues, mmSums);
+        incrementAll<TypeAlignment>(vector);
+    }
+    result = horizontalSum(mmSums);
+#endif
+
+    while (vector < sentinel) {
+        result += (*vector) * (*vector);
+        vector++;
+    }
+
+    return result;
+}
+
+void cumsumAVX(const float* input, float* output, unsigned size) noexcept
+{
+    if (size == 0)
+        return;
+
+    const auto* sentinel = output + size;
+    *output++ = *input++;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    auto mmOutput = _mm256_set1_ps(*(output - 1));
+    while (output + TypeAlignment <= sentinel) {
+        // The prefix sums in the 128-bit lanes, then the sum of the low lane
+        // carried over into the high lane
+        auto mmOffset = _mm256_loadu_ps(input);
+        mmOffset = _mm256_add_ps(mmOffset, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(mmOffset), 4)));
+        mmOffset = _mm256_add_ps(mmOffset, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(mmOffset), 8)));
+        const auto mmCarry = _mm256_permute2f128_ps(mmOffset, mmOffset, 0x08);
+        mmOffset = _mm256_add_ps(mmOffset, _mm256_shuffle_ps(mmCarry, mmCarry, _MM_SHUFFLE(3, 3, 3, 3)));
+        mmOutput = _mm256_add_ps(mmOutput, mmOffset);
+        _mm256_storeu_ps(output, mmOutput);
+        mmOutput = broadcastLast(mmOutput);
+        incrementAll<TypeAlignment>(input, output);
+    }
+#endif
+
+    while (output < sentinel) {
+        *output = *(output - 1) + *input;
+        incrementAll(input, output);
+    }
+}
+
+void diffAVX(const float* input, float* output, unsigned size) noexcept
+{
+    if (size == 0)
+        return;
+
+    const auto* sentinel = output + size;
+    *output++ = *input++;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, _mm256_sub_ps(_mm256_loadu_ps(input), _mm256_loadu_ps(input - 1)));
+        incrementAll<TypeAlignment>(input, output);
+    }
+#endif
+
+    while (output < sentinel) {
+        *output = *input - *(input - 1);
+        incrementAll(input, output);
+    }
+}
+
+void clampAllAVX(float* input, float low, float high, unsigned size) noexcept
+{
+    if (size == 0)
+        return;
+
+    const auto* sentinel = input + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto mmLow = _mm256_set1_ps(low);
+    const auto mmHigh = _mm256_set1_ps(high);
+    while (input + TypeAlignment <= sentinel) {
+        const auto mmIn = _mm256_loadu_ps(input);
+        _mm256_storeu_ps(input, _mm256_max_ps(_mm256_min_ps(mmIn, mmHigh), mmLow));
+        incrementAll<TypeAlignment>(input);
+    }
+#endif
+
+    while (input < sentinel) {
+        const float clampedAbove = *input > high ? high : *input;
+        *input = clampedAbove < low ? low : clampedAbove;
+        incrementAll(input);
+    }
+}
+
+bool allWithinAVX(const float* input, float low, float high, unsigned size) noexcept
+{
+    if (size == 0)
+        return true;
+
+    if (low > high)
+        std::swap(low, high);
+
+    const auto* sentinel = input + size;
+
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto mmLow = _mm256_set1_ps(low);
+    const auto mmHigh = _mm256_set1_ps(high);
+    while (input + TypeAlignment <= sentinel) {
+        const auto mmIn = _mm256_loadu_ps(input);
+        const auto mmOutside = _mm256_or_ps(_mm256_cmp_ps(mmIn, mmLow, _CMP_LT_OQ), _mm256_cmp_ps(mmIn, mmHigh, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(mmOutside) != 0)
+            return false;
+
+        incrementAll<TypeAlignment>(input);
+    }
+#endif
+
+    while (input < sentinel) {
+        if (*input < low || *input > high)
+            return false;
+
+        incrementAll(input);
+    }
+
+    return true;
+}
+
+#if SFIZZ_HAVE_AVX2_FMA
+// The same computation as exp2ScaledSSE, with the polynomial in FMA
+static inline __m256 exp2ScaledAVX(__m256 mmX, float unitHigh, float unitLow) noexcept
+{
+    const float unit = unitHigh + unitLow;
+    mmX = _mm256_max_ps(_mm256_min_ps(mmX, _mm256_set1_ps(127.0f * unit)), _mm256_set1_ps(-126.0f * unit));
+    const auto mmScale = _mm256_set1_ps(1.0f / unit);
+    const auto mmN = _mm256_cvtps_epi32(_mm256_mul_ps(mmX, mmScale));
+    const auto mmNf = _mm256_cvtepi32_ps(mmN);
+    mmX = _mm256_fnmadd_ps(mmNf, _mm256_set1_ps(unitHigh), mmX);
+    mmX = _mm256_fnmadd_ps(mmNf, _mm256_set1_ps(unitLow), mmX);
+    const auto mmF = _mm256_mul_ps(mmX, mmScale);
+    auto mmP = _mm256_set1_ps(1.535336188319500e-4f);
+    mmP = _mm256_fmadd_ps(mmP, mmF, _mm256_set1_ps(1.339887440266574e-3f));
+    mmP = _mm256_fmadd_ps(mmP, mmF, _mm256_set1_ps(9.618437357674640e-3f));
+    mmP = _mm256_fmadd_ps(mmP, mmF, _mm256_set1_ps(5.550332471162809e-2f));
+    mmP = _mm256_fmadd_ps(mmP, mmF, _mm256_set1_ps(2.402264791363012e-1f));
+    mmP = _mm256_fmadd_ps(mmP, mmF, _mm256_set1_ps(6.931472028550421e-1f));
+    mmP = _mm256_fmadd_ps(mmP, mmF, _mm256_set1_ps(1.0f));
+    const auto mmPow2N = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(mmN, _mm256_set1_epi32(127)), 23));
+    return _mm256_mul_ps(mmP, mmPow2N);
+}
+#endif
+
+static void exp2ScaledAVX(const float* input, float* output, float unitHigh, float unitLow, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_AVX2_FMA
+    const auto* sentinel = output + size;
+    while (output + TypeAlignment <= sentinel) {
+        _mm256_storeu_ps(output, exp2ScaledAVX(_mm256_loadu_ps(input), unitHigh, unitLow));
+        incrementAll<TypeAlignment>(input, output);
+    }
+
+    const auto remaining = static_cast<unsigned>(sentinel - output);
+    if (remaining > 0) {
+        float last[TypeAlignment] {};
+        std::copy_n(input, remaining, last);
+        _mm256_storeu_ps(last, exp2ScaledAVX(_mm256_loadu_ps(last), unitHigh, unitLow));
+        std::copy_n(last, remaining, output);
+    }
+#else
+    const float scale = 1.0f / (unitHigh + unitLow);
+    for (unsigned i = 0; i < size; ++i)
+        output[i] = std::exp2(input[i] * scale);
+#endif
+}
+
+void centsFactorAVX(const float* input, float* output, unsigned size) noexcept
+{
+    exp2ScaledAVX(input, output, 1200.0f, 0.0f, size);
+}
+
+void db2magAVX(const float* input, float* output, unsigned size) noexcept
+{
+    exp2ScaledAVX(input, output, 6.0205078125f, 9.210077962370e-5f, size);
+}
+
+int64_t interpolationPositionsAVX(const float* pitch, float ratio, int64_t start, int* indices, float* coeffs, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_AVX2_FMA
+    if (size == 0)
+        return start;
+
+    const auto mmRatio = _mm256_set1_ps(ratio);
+    const auto mmStep = _mm256_set1_epi64x(fixedPosition(ratio));
+    const auto mmCoeffScale = _mm256_set1_ps(1.0f / 16777216.0f);
+    // The first position is the start, without a jump
+    auto mmFirst = _mm256_set_epi64x(0, 0, 0, -1);
+    auto mmPosition = _mm256_set1_epi64x(start);
+
+    // The prefix sums of the 64-bit lanes
+    auto prefixSum = [](__m256i x) {
+        x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+        const auto mmCarry = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 1, 1, 1));
+        return _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_setzero_si256(), mmCarry, 0xF0));
+    };
+
+    auto positions = [&](const float* pitch, int* indices, float* coeffs, int64_t* lanes) {
+        // The jumps of the frames 0-3 and 4-7, in 64-bit lanes
+        __m256i mmLow = mmStep;
+        __m256i mmHigh = mmStep;
+        if (pitch) {
+            const auto mmJumps = _mm256_mul_ps(mmRatio, exp2ScaledAVX(_mm256_loadu_ps(pitch), 1200.0f, 0.0f));
+            const auto mmInteger = _mm256_cvttps_epi32(mmJumps);
+            const auto mmFraction = _mm256_sub_ps(mmJumps, _mm256_cvtepi32_ps(mmInteger));
+            // The 32 bits of the fraction, converted through the signed range
+            const auto mmFractionBits = _mm256_xor_si256(
+                _mm256_cvtps_epi32(_mm256_fmsub_ps(mmFraction, _mm256_set1_ps(4294967296.0f), _mm256_set1_ps(2147483648.0f))),
+                _mm256_set1_epi32(static_cast<int>(0x80000000u)));
+            // The unpacks go by 128-bit lanes, the frames 0-1 and 2-3 first
+            const auto mmFractionOrdered = _mm256_permute4x64_epi64(mmFractionBits, _MM_SHUFFLE(3, 1, 2, 0));
+            const auto mmIntegerOrdered = _mm256_permute4x64_epi64(mmInteger, _MM_SHUFFLE(3, 1, 2, 0));
+            mmLow = _mm256_unpacklo_epi32(mmFractionOrdered, mmIntegerOrdered);
+            mmHigh = _mm256_unpackhi_epi32(mmFractionOrdered, mmIntegerOrdered);
+        }
+        mmLow = _mm256_andnot_si256(mmFirst, mmLow);
+        mmLow = _mm256_add_epi64(mmPosition, prefixSum(mmLow));
+        mmHigh = _mm256_add_epi64(_mm256_permute4x64_epi64(mmLow, _MM_SHUFFLE(3, 3, 3, 3)), prefixSum(mmHigh));
+        mmPosition = _mm256_permute4x64_epi64(mmHigh, _MM_SHUFFLE(3, 3, 3, 3));
+        mmFirst = _mm256_setzero_si256();
+
+        // The integer parts are the high halves, the fractions the low ones;
+        // the shuffles give the frames 0 1 4 5 2 3 6 7
+        const auto mmLowPs = _mm256_castsi256_ps(mmLow);
+        const auto mmHighPs = _mm256_castsi256_ps(mmHigh);
+        const auto mmIndices = _mm256_permute4x64_epi64(
+            _mm256_castps_si256(_mm256_shuffle_ps(mmLowPs, mmHighPs, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+        const auto mmFractions = _mm256_permute4x64_epi64(
+            _mm256_castps_si256(_mm256_shuffle_ps(mmLowPs, mmHighPs, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices), mmIndices);
+        _mm256_storeu_ps(coeffs, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(mmFractions, 8)), mmCoeffScale));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), mmLow);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + 4), mmHigh);
+    };
+
+    int64_t lanes[TypeAlignment];
+    const auto* sentinel = coeffs + size;
+    while (coeffs + TypeAlignment <= sentinel) {
+        positions(pitch, indices, coeffs, lanes);
+        if (pitch)
+            pitch += TypeAlignment;
+        incrementAll<TypeAlignment>(indices, coeffs);
+    }
+
+    const auto remaining = static_cast<unsigned>(sentinel - coeffs);
+    if (remaining == 0)
+        return lanes[TypeAlignment - 1];
+
+    float lastPitch[TypeAlignment] {};
+    int lastIndices[TypeAlignment];
+    float lastCoeffs[TypeAlignment];
+    if (pitch)
+        std::copy_n(pitch, remaining, lastPitch);
+    positions(pitch ? lastPitch : nullptr, lastIndices, lastCoeffs, lanes);
+    std::copy_n(lastIndices, remaining, indices);
+    std::copy_n(lastCoeffs, remaining, coeffs);
+    return lanes[remaining - 1];
+#else
+    return interpolationPositionsScalar(pitch, ratio, start, indices, coeffs, size);
+#endif
 }
@@ -5,6 +5,39 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #pragma once
+#include <cstdint>
 
-void gain1AVX(float gain, const float* input, float* output, unsigned size) noexcept;
+/* These are the AVX2 and FMA versions of the SIMDHelpers */
+
+// Whether the versions were built with AVX2 and FMA; otherwise they are scalar
+bool helpersAVXAvailable() noexcept;
+
+void readInterleavedAVX(const float* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+void readInterleavedInt16AVX(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+void readInterleavedInt24AVX(const uint8_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+void writeInterleavedAVX(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept;
+void addInterleavedAVX(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept;
 void gainAVX(const float* gain, const float* input, float* output, unsigned size) noexcept;
+void gain1AVX(float gain, const float* input, float* output, unsigned size) noexcept;
+void divideAVX(const float* input, const float* divisor, float* output, unsigned size) noexcept;
+void multiplyAddAVX(const float* gain, const float* input, float* output, unsigned size) noexcept;
+void multiplyAdd1AVX(float gain, const float* input, float* output, unsigned size) noexcept;
+void multiplyAdd1MultiAVX(const float* gains, const float* input, float* const outputs[], unsigned numOutputs, unsigned size) noexcept;
+void multiplyMulAVX(const float* gain, const float* input, float* output, unsigned size) noexcept;
+void multiplyMul1AVX(float gain, const float* input, float* output, unsigned size) noexcept;
+float linearRampAVX(float* output, float start, float step, unsigned size) noexcept;
+float multiplicativeRampAVX(float* output, float start, float step, unsigned size) noexcept;
+void addAVX(const float* input, float* output, unsigned size) noexcept;
+void add1AVX(float value, float* output, unsigned size) noexcept;
+void subtractAVX(const float* input, float* output, unsigned size) noexcept;
+void subtract1AVX(float value, float* output, unsigned size) noexcept;
+void copyAVX(const float* input, float* output, unsigned size) noexcept;
+float meanAVX(const float* vector, unsigned size) noexcept;
+float sumSquaresAVX(const float* vector, unsigned size) noexcept;
+void cumsumAVX(const float* input, float* output, unsigned size) noexcept;
+void diffAVX(const float* input, float* output, unsigned size) noexcept;
+void clampAllAVX(float* input, float low, float high, unsigned size) noexcept;
+bool allWithinAVX(const float* input, float low, float high, unsigned size) noexcept;
+void centsFactorAVX(const float* input, float* output, unsigned size) noexcept;
+void db2magAVX(const float* input, float* output, unsigned size) noexcept;
+int64_t interpolationPositionsAVX(const float* pitch, float ratio, int64_t start, int* indices, float* coeffs, unsigned size) noexcept;
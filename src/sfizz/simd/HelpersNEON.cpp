@@ -5,6 +5,8 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "HelpersNEON.h"
+#include "../SIMDConfig.h"
+#include "../MathHelpers.h"
 #include "Common.h"
 
 #if SFIZZ_HAVE_NEON
@@ -14,3 +16,26 @@
 using Type = float;
 constexpr unsigned TypeAlignment = 4;
 constexpr unsigned ByteAlignment = TypeAlignment * sizeof(Type);
+
+void readInterleavedInt16NEON(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + inputSize - 1;
+
+#if SFIZZ_HAVE_NEON
+    const auto* lastBlock = input + 16 * (inputSize / 16);
+    while (input < lastBlock) {
+        const int16x8x2_t frames = vld2q_s16(input);
+        vst1q_f32(outputLeft, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(frames.val[0])), 15));
+        vst1q_f32(outputLeft + TypeAlignment, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(frames.val[0])), 15));
+        vst1q_f32(outputRight, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(frames.val[1])), 15));
+        vst1q_f32(outputRight + TypeAlignment, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(frames.val[1])), 15));
+        input += 16;
+        incrementAll<2 * TypeAlignment>(outputLeft, outputRight);
+    }
+#endif
+
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<float>(*input++) * (1.0f / 32768.0f);
+        *outputRight++ = static_cast<float>(*input++) * (1.0f / 32768.0f);
+    }
+}
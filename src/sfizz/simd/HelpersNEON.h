@@ -5,3 +5,7 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #pragma once
+#include <cstdint>
+
+/* These are the NEON versions of the SIMDHelpers */
+void readInterleavedInt16NEON(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
@@ -7,8 +7,11 @@
 #include "HelpersSSE.h"
 #include "../SIMDConfig.h"
 #include "../MathHelpers.h"
+#include "HelpersScalar.h"
 #include "Common.h"
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 #if SFIZZ_HAVE_SSE2
 #include <immintrin.h>
@@ -54,6 +57,79 @@ void readInterleavedSSE(const float* input, float* outputLeft, float* outputRigh
     }
 }
 
+void readInterleavedInt16SSE(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + inputSize - 1;
+
+#if SFIZZ_HAVE_SSE2
+    // Each 32-bit lane holds a frame, with the left sample in the low half
+    const auto* lastBlock = input + 8 * (inputSize / 8);
+    const auto scale = _mm_set1_ps(1.0f / 32768.0f);
+    while (input < lastBlock) {
+        const auto frames = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+        const auto left = _mm_srai_epi32(_mm_slli_epi32(frames, 16), 16);
+        const auto right = _mm_srai_epi32(frames, 16);
+        _mm_storeu_ps(outputLeft, _mm_mul_ps(_mm_cvtepi32_ps(left), scale));
+        _mm_storeu_ps(outputRight, _mm_mul_ps(_mm_cvtepi32_ps(right), scale));
+        input += 8;
+        incrementAll<TypeAlignment>(outputLeft, outputRight);
+    }
+#endif
+
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<float>(*input++) * (1.0f / 32768.0f);
+        *outputRight++ = static_cast<float>(*input++) * (1.0f / 32768.0f);
+    }
+}
+
+#if SFIZZ_HAVE_SSE2
+/**
+ * @brief Load 4 bytes, the 3 of a 24-bit sample in the upper bits
+ */
+static inline int loadInt24Lane(const uint8_t* input) noexcept
+{
+    int value;
+    std::memcpy(&value, input - 1, sizeof(value));
+    return value;
+}
+#endif
+
+void readInterleavedInt24SSE(const uint8_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + 3 * (inputSize & ~1u);
+
+#if SFIZZ_HAVE_SSE2
+    // Each lane loads the byte before its sample, which the mask clears.
+    // The first frame is done apart, so that the loads stay in the input.
+    if (input < sentinel) {
+        *outputLeft++ = static_cast<float>(readInt24(input)) * (1.0f / 2147483648.0f);
+        *outputRight++ = static_cast<float>(readInt24(input + 3)) * (1.0f / 2147483648.0f);
+        input += 6;
+    }
+    const auto* lastBlock = input + 24 * ((sentinel - input) / 24);
+    const auto scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    const auto mask = _mm_set1_epi32(~0xff);
+    while (input < lastBlock) {
+        const auto left = _mm_set_epi32(
+            loadInt24Lane(input + 18), loadInt24Lane(input + 12),
+            loadInt24Lane(input + 6), loadInt24Lane(input));
+        const auto right = _mm_set_epi32(
+            loadInt24Lane(input + 21), loadInt24Lane(input + 15),
+            loadInt24Lane(input + 9), loadInt24Lane(input + 3));
+        _mm_storeu_ps(outputLeft, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(left, mask)), scale));
+        _mm_storeu_ps(outputRight, _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(right, mask)), scale));
+        input += 24;
+        incrementAll<TypeAlignment>(outputLeft, outputRight);
+    }
+#endif
+
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<float>(readInt24(input)) * (1.0f / 2147483648.0f);
+        *outputRight++ = static_cast<float>(readInt24(input + 3)) * (1.0f / 2147483648.0f);
+        input += 6;
+    }
+}
+
 void writeInterleavedSSE(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept
 {
     const auto* sentinel = output + outputSize - 1;
@@ -82,6 +158,34 @@ void writeInterleavedSSE(const float* inputLeft, const float* inputRight, float*
     }
 }
 
+void addInterleavedSSE(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept
+{
+    const auto* sentinel = output + outputSize - 1;
+
+#if SFIZZ_HAVE_SSE2
+    const auto* lastAligned = prevAligned<ByteAlignment>(output + outputSize - TypeAlignment);
+    while (unaligned<ByteAlignment>(output, inputRight, inputLeft) && output < lastAligned) {
+        *output++ += *inputLeft++;
+        *output++ += *inputRight++;
+    }
+
+    while (output < lastAligned) {
+        const auto lInRegister = _mm_load_ps(inputLeft);
+        const auto rInRegister = _mm_load_ps(inputRight);
+        const auto outRegister1 = _mm_unpacklo_ps(lInRegister, rInRegister);
+        _mm_store_ps(output, _mm_add_ps(_mm_load_ps(output), outRegister1));
+        const auto outRegister2 = _mm_unpackhi_ps(lInRegister, rInRegister);
+        _mm_store_ps(output + 4, _mm_add_ps(_mm_load_ps(output + 4), outRegister2));
+        incrementAll<TypeAlignment>(output, output, inputLeft, inputRight);
+    }
+#endif
+
+    while (output < sentinel) {
+        *output++ += *inputLeft++;
+        *output++ += *inputRight++;
+    }
+}
+
 void gain1SSE(float gain, const float* input, float* output, unsigned size) noexcept
 {
     const auto* sentinel = output + size;
@@ -183,6 +287,37 @@ void multiplyAdd1SSE(float gain, const float* input, float* output, unsigned siz
         *output++ += gain * (*input++);
 }
 
+void multiplyAdd1MultiSSE(const float* gains, const float* input, float* const outputs[], unsigned numOutputs, unsigned size) noexcept
+{
+    unsigned i = 0;
+
+#if SFIZZ_HAVE_SSE2
+    // The outputs can each have their own alignment, so they go unaligned
+    constexpr unsigned maxGroupSize { 8 };
+    for (unsigned first = 0; first < numOutputs; first += maxGroupSize) {
+        const unsigned groupSize = std::min(maxGroupSize, numOutputs - first);
+        __m128 mmGains[maxGroupSize];
+        for (unsigned j = 0; j < groupSize; ++j)
+            mmGains[j] = _mm_set1_ps(gains[first + j]);
+
+        float* const* groupOutputs = outputs + first;
+        for (i = 0; i + TypeAlignment <= size; i += TypeAlignment) {
+            const auto mmIn = _mm_loadu_ps(input + i);
+            for (unsigned j = 0; j < groupSize; ++j) {
+                float* output = groupOutputs[j] + i;
+                _mm_storeu_ps(output, _mm_add_ps(_mm_mul_ps(mmGains[j], mmIn), _mm_loadu_ps(output)));
+            }
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        const float x = input[i];
+        for (unsigned j = 0; j < numOutputs; ++j)
+            outputs[j][i] += gains[j] * x;
+    }
+}
+
 void multiplyMulSSE(const float* gain, const float* input, float* output, unsigned size) noexcept
 {
     const auto* sentinel = output + size;
@@ -587,3 +722,144 @@ bool allWithinSSE(const float* input, float low, float high, unsigned size) noex
 
     return true;
 }
+
+#if SFIZZ_HAVE_SSE2
+// 2^f for f in [-0.5, 0.5], with the polynomial of Cephes exp2f
+static inline __m128 exp2FractionSSE(__m128 mmF) noexcept
+{
+    auto mmP = _mm_set1_ps(1.535336188319500e-4f);
+    mmP = _mm_add_ps(_mm_mul_ps(mmP, mmF), _mm_set1_ps(1.339887440266574e-3f));
+    mmP = _mm_add_ps(_mm_mul_ps(mmP, mmF), _mm_set1_ps(9.618437357674640e-3f));
+    mmP = _mm_add_ps(_mm_mul_ps(mmP, mmF), _mm_set1_ps(5.550332471162809e-2f));
+    mmP = _mm_add_ps(_mm_mul_ps(mmP, mmF), _mm_set1_ps(2.402264791363012e-1f));
+    mmP = _mm_add_ps(_mm_mul_ps(mmP, mmF), _mm_set1_ps(6.931472028550421e-1f));
+    return _mm_add_ps(_mm_mul_ps(mmP, mmF), _mm_set1_ps(1.0f));
+}
+
+// 2^(x / unit), with the unit of an octave split in high and low parts.
+// 2^(x / unit) = 2^n * 2^f, with n the nearest integer; the high part times
+// n is exact, so that f keeps its precision when x is far from 0.
+static inline __m128 exp2ScaledSSE(__m128 mmX, float unitHigh, float unitLow) noexcept
+{
+    const float unit = unitHigh + unitLow;
+    mmX = _mm_max_ps(_mm_min_ps(mmX, _mm_set1_ps(127.0f * unit)), _mm_set1_ps(-126.0f * unit));
+    const auto mmScale = _mm_set1_ps(1.0f / unit);
+    const auto mmN = _mm_cvtps_epi32(_mm_mul_ps(mmX, mmScale));
+    const auto mmNf = _mm_cvtepi32_ps(mmN);
+    mmX = _mm_sub_ps(mmX, _mm_mul_ps(mmNf, _mm_set1_ps(unitHigh)));
+    mmX = _mm_sub_ps(mmX, _mm_mul_ps(mmNf, _mm_set1_ps(unitLow)));
+    const auto mmP = exp2FractionSSE(_mm_mul_ps(mmX, mmScale));
+    const auto mmPow2N = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(mmN, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(mmP, mmPow2N);
+}
+#endif
+
+// The frames which do not fill a register go through a register as well,
+// for the same precision everywhere
+static void exp2ScaledSSE(const float* input, float* output, float unitHigh, float unitLow, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_SSE2
+    const auto* sentinel = output + size;
+    while (output + TypeAlignment <= sentinel) {
+        _mm_storeu_ps(output, exp2ScaledSSE(_mm_loadu_ps(input), unitHigh, unitLow));
+        incrementAll<TypeAlignment>(input, output);
+    }
+
+    const auto remaining = static_cast<unsigned>(sentinel - output);
+    if (remaining > 0) {
+        alignas(ByteAlignment) float last[TypeAlignment] {};
+        std::copy_n(input, remaining, last);
+        _mm_store_ps(last, exp2ScaledSSE(_mm_load_ps(last), unitHigh, unitLow));
+        std::copy_n(last, remaining, output);
+    }
+#else
+    const float scale = 1.0f / (unitHigh + unitLow);
+    for (unsigned i = 0; i < size; ++i)
+        output[i] = std::exp2(input[i] * scale);
+#endif
+}
+
+void centsFactorSSE(const float* input, float* output, unsigned size) noexcept
+{
+    exp2ScaledSSE(input, output, 1200.0f, 0.0f, size);
+}
+
+void db2magSSE(const float* input, float* output, unsigned size) noexcept
+{
+    // 20 / log2(10) = 6.020599913279624 dB per octave, the high part in 13 bits
+    exp2ScaledSSE(input, output, 6.0205078125f, 9.210077962370e-5f, size);
+}
+
+int64_t interpolationPositionsSSE(const float* pitch, float ratio, int64_t start, int* indices, float* coeffs, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_SSE2
+    if (size == 0)
+        return start;
+
+    const auto mmRatio = _mm_set1_ps(ratio);
+    const auto mmStep = _mm_set1_epi64x(fixedPosition(ratio));
+    const auto mmCoeffScale = _mm_set1_ps(1.0f / 16777216.0f);
+    // The first position is the start, without a jump
+    auto mmFirst = _mm_set_epi32(0, 0, -1, -1);
+    auto mmPosition = _mm_set1_epi64x(start);
+
+    auto positions = [&](const float* pitch, int* indices, float* coeffs, int64_t* lanes) {
+        // The jumps of the frames 0-1 and 2-3, in 64-bit lanes
+        __m128i mmLow = mmStep;
+        __m128i mmHigh = mmStep;
+        if (pitch) {
+            const auto mmJumps = _mm_mul_ps(mmRatio, exp2ScaledSSE(_mm_loadu_ps(pitch), 1200.0f, 0.0f));
+            const auto mmInteger = _mm_cvttps_epi32(mmJumps);
+            const auto mmFraction = _mm_sub_ps(mmJumps, _mm_cvtepi32_ps(mmInteger));
+            // The 32 bits of the fraction, converted through the signed range
+            const auto mmFractionBits = _mm_xor_si128(
+                _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(mmFraction, _mm_set1_ps(4294967296.0f)), _mm_set1_ps(2147483648.0f))),
+                _mm_set1_epi32(static_cast<int>(0x80000000u)));
+            mmLow = _mm_unpacklo_epi32(mmFractionBits, mmInteger);
+            mmHigh = _mm_unpackhi_epi32(mmFractionBits, mmInteger);
+        }
+        mmLow = _mm_andnot_si128(mmFirst, mmLow);
+        mmLow = _mm_add_epi64(mmLow, _mm_slli_si128(mmLow, 8));
+        mmHigh = _mm_add_epi64(mmHigh, _mm_slli_si128(mmHigh, 8));
+        mmLow = _mm_add_epi64(mmPosition, mmLow);
+        mmHigh = _mm_add_epi64(_mm_unpackhi_epi64(mmLow, mmLow), mmHigh);
+        mmPosition = _mm_unpackhi_epi64(mmHigh, mmHigh);
+        mmFirst = _mm_setzero_si128();
+
+        // The integer parts are the high halves, the fractions the low ones
+        const auto mmLowPs = _mm_castsi128_ps(mmLow);
+        const auto mmHighPs = _mm_castsi128_ps(mmHigh);
+        const auto mmIndices = _mm_castps_si128(_mm_shuffle_ps(mmLowPs, mmHighPs, _MM_SHUFFLE(3, 1, 3, 1)));
+        const auto mmFractions = _mm_castps_si128(_mm_shuffle_ps(mmLowPs, mmHighPs, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), mmIndices);
+        _mm_storeu_ps(coeffs, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(mmFractions, 8)), mmCoeffScale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), mmLow);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 2), mmHigh);
+    };
+
+    int64_t lanes[TypeAlignment];
+    const auto* sentinel = coeffs + size;
+    while (coeffs + TypeAlignment <= sentinel) {
+        positions(pitch, indices, coeffs, lanes);
+        if (pitch)
+            pitch += TypeAlignment;
+        incrementAll<TypeAlignment>(indices, coeffs);
+    }
+
+    const auto remaining = static_cast<unsigned>(sentinel - coeffs);
+    if (remaining == 0)
+        return lanes[TypeAlignment - 1];
+
+    float lastPitch[TypeAlignment] {};
+    int lastIndices[TypeAlignment];
+    float lastCoeffs[TypeAlignment];
+    if (pitch)
+        std::copy_n(pitch, remaining, lastPitch);
+    positions(pitch ? lastPitch : nullptr, lastIndices, lastCoeffs, lanes);
+    std::copy_n(lastIndices, remaining, indices);
+    std::copy_n(lastCoeffs, remaining, coeffs);
+    return lanes[remaining - 1];
+#else
+    return interpolationPositionsScalar(pitch, ratio, start, indices, coeffs, size);
+#endif
+}
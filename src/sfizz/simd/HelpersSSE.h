@@ -5,15 +5,20 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #pragma once
+#include <cstdint>
 
 /* These are the SSE versions of the SIMDHelpers */
 void readInterleavedSSE(const float* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+void readInterleavedInt16SSE(const int16_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
+void readInterleavedInt24SSE(const uint8_t* input, float* outputLeft, float* outputRight, unsigned inputSize) noexcept;
 void writeInterleavedSSE(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept;
+void addInterleavedSSE(const float* inputLeft, const float* inputRight, float* output, unsigned outputSize) noexcept;
 void gainSSE(const float* gain, const float* input, float* output, unsigned size) noexcept;
 void gain1SSE(float gain, const float* input, float* output, unsigned size) noexcept;
 void divideSSE(const float* input, const float* divisor, float* output, unsigned size) noexcept;
 void multiplyAddSSE(const float* gain, const float* input, float* output, unsigned size) noexcept;
 void multiplyAdd1SSE(float gain, const float* input, float* output, unsigned size) noexcept;
+void multiplyAdd1MultiSSE(const float* gains, const float* input, float* const outputs[], unsigned numOutputs, unsigned size) noexcept;
 void multiplyMulSSE(const float* gain, const float* input, float* output, unsigned size) noexcept;
 void multiplyMul1SSE(float gain, const float* input, float* output, unsigned size) noexcept;
 float linearRampSSE(float* output, float start, float step, unsigned size) noexcept;
@@ -29,3 +34,6 @@ void cumsumSSE(const float* input, float* output, unsigned size) noexcept;
 void diffSSE(const float* input, float* output, unsigned size) noexcept;
 void clampAllSSE(float* input, float low, float high, unsigned size) noexcept;
 bool allWithinSSE(const float* input, float low, float high, unsigned size) noexcept;
+void centsFactorSSE(const float* input, float* output, unsigned size) noexcept;
+void db2magSSE(const float* input, float* output, unsigned size) noexcept;
+int64_t interpolationPositionsSSE(const float* pitch, float ratio, int64_t start, int* indices, float* coeffs, unsigned size) noexcept;
@@ -6,6 +6,8 @@
 
 #pragma once
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 template<class T>
 inline void readInterleavedScalar(const T* input, T* outputLeft, T* outputRight, unsigned inputSize) noexcept
@@ -17,6 +19,37 @@ inline void readInterleavedScalar(const T* input, T* outputLeft, T* outputRight,
     }
 }
 
+template<class T>
+inline void readInterleavedInt16Scalar(const int16_t* input, T* outputLeft, T* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + inputSize - 1;
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<T>(*input++) * static_cast<T>(1.0 / 32768.0);
+        *outputRight++ = static_cast<T>(*input++) * static_cast<T>(1.0 / 32768.0);
+    }
+}
+
+/**
+ * @brief Read a little-endian 24-bit sample into the upper bits of a 32-bit integer
+ */
+inline int32_t readInt24(const uint8_t* input) noexcept
+{
+    const uint32_t bits = (static_cast<uint32_t>(input[0]) << 8)
+        | (static_cast<uint32_t>(input[1]) << 16) | (static_cast<uint32_t>(input[2]) << 24);
+    return static_cast<int32_t>(bits);
+}
+
+template<class T>
+inline void readInterleavedInt24Scalar(const uint8_t* input, T* outputLeft, T* outputRight, unsigned inputSize) noexcept
+{
+    const auto* sentinel = input + 3 * (inputSize & ~1u);
+    while (input < sentinel) {
+        *outputLeft++ = static_cast<T>(readInt24(input)) * static_cast<T>(1.0 / 2147483648.0);
+        *outputRight++ = static_cast<T>(readInt24(input + 3)) * static_cast<T>(1.0 / 2147483648.0);
+        input += 6;
+    }
+}
+
 template<class T>
 inline void writeInterleavedScalar(const T* inputLeft, const T* inputRight, T* output, unsigned outputSize) noexcept
 {
@@ -27,6 +60,16 @@ inline void writeInterleavedScalar(const T* inputLeft, const T* inputRight, T* o
     }
 }
 
+template<class T>
+inline void addInterleavedScalar(const T* inputLeft, const T* inputRight, T* output, unsigned outputSize) noexcept
+{
+    const auto* sentinel = output + outputSize - 1;
+    while (output < sentinel) {
+        *output++ += *inputLeft++;
+        *output++ += *inputRight++;
+    }
+}
+
 template<class T>
 inline void gain1Scalar(T gain, const T* input, T* output, unsigned size) noexcept
 {
@@ -67,6 +110,16 @@ inline void multiplyAdd1Scalar(T gain, const T* input, T* output, unsigned size)
         *output++ += gain * (*input++);
 }
 
+template <class T>
+inline void multiplyAdd1MultiScalar(const T* gains, const T* input, T* const outputs[], unsigned numOutputs, unsigned size) noexcept
+{
+    for (unsigned i = 0; i < size; ++i) {
+        const T x = input[i];
+        for (unsigned j = 0; j < numOutputs; ++j)
+            outputs[j][i] += gains[j] * x;
+    }
+}
+
 template <class T>
 inline void multiplyMulScalar(const T* gain, const T* input, T* output, unsigned size) noexcept
 {
@@ -236,3 +289,47 @@ bool allWithinScalar(const T* input, T low, T high, unsigned size ) noexcept
 
     return true;
 }
+
+template <class T>
+void centsFactorScalar(const T* input, T* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+    while (output < sentinel)
+        *output++ = std::exp2(*input++ * static_cast<T>(1.0 / 1200.0));
+}
+
+template <class T>
+void db2magScalar(const T* input, T* output, unsigned size) noexcept
+{
+    const auto* sentinel = output + size;
+    while (output < sentinel)
+        *output++ = std::pow(static_cast<T>(10.0), *input++ * static_cast<T>(0.05));
+}
+
+// The positions of the interpolation are in 32.32 fixed point
+constexpr int64_t positionUnit { int64_t(1) << 32 };
+
+inline int64_t fixedPosition(double position) noexcept
+{
+    return static_cast<int64_t>(std::llround(position * static_cast<double>(positionUnit)));
+}
+
+template <class T>
+int64_t interpolationPositionsScalar(const T* pitch, T ratio, int64_t start, int* indices, T* coeffs, unsigned size) noexcept
+{
+    if (size == 0)
+        return start;
+
+    // The coefficients keep the 24 high bits of the fraction
+    constexpr T coeffScale { static_cast<T>(1.0 / (1 << 24)) };
+    const int64_t step = fixedPosition(ratio);
+    int64_t position = start;
+    for (unsigned i = 0; ; ) {
+        indices[i] = static_cast<int>(position >> 32);
+        coeffs[i] = static_cast<T>(static_cast<uint32_t>(position) >> 8) * coeffScale;
+        if (++i == size)
+            break;
+        position += pitch ? fixedPosition(ratio * std::exp2(pitch[i] * static_cast<T>(1.0 / 1200.0))) : step;
+    }
+    return position;
+}
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "InterpolatorsAVX2.h"
+#include "../SIMDConfig.h"
+
+// Note: this file is built with AVX2 flags, it must not include the inline
+//       headers of sfizz, which would otherwise get instantiated with AVX2.
+
+#if SFIZZ_HAVE_AVX2
+#include <immintrin.h>
+
+/**
+ * @brief Sum the 8 elements of a vector
+ */
+static inline float horizontalSum(__m256 x) noexcept
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(s);
+}
+
+template <size_t Points>
+static void sincInterpolateFrames(
+    const float* table, float tableScale,
+    const float* const sources[], float* const outputs[], unsigned numChannels,
+    const int* indices, const float* coeffs, const float* addingGains,
+    size_t numFrames) noexcept
+{
+    static_assert(Points % 4 == 0, "Windowed sinc must be multiple of 4");
+    constexpr int j0 = 1 - int(Points) / 2;
+    constexpr size_t numWide = Points / 8 * 8;
+
+    const __m256 ramp = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 offset = _mm256_set1_ps(Points / 2.0f);
+    const __m256 scale = _mm256_set1_ps(tableScale);
+
+    alignas(32) float h[Points];
+
+    for (size_t f = 0; f < numFrames; ++f) {
+        const float x0 = j0 - coeffs[f];
+
+        // the kernel at 8 points at a time, as gathered table lookups
+        for (size_t i = 0; i < numWide; i += 8) {
+            __m256 x = _mm256_add_ps(_mm256_set1_ps(x0 + i), ramp);
+            __m256 ix = _mm256_mul_ps(_mm256_add_ps(x, offset), scale);
+            __m256i i0 = _mm256_cvttps_epi32(ix);
+            __m256 mu = _mm256_sub_ps(ix, _mm256_cvtepi32_ps(i0));
+            __m256 y0 = _mm256_i32gather_ps(table, i0, 4);
+            __m256 y1 = _mm256_i32gather_ps(table + 1, i0, 4);
+            _mm256_store_ps(&h[i], _mm256_add_ps(y0, _mm256_mul_ps(mu, _mm256_sub_ps(y1, y0))));
+        }
+        if (numWide < Points) {
+            __m128 x = _mm_add_ps(_mm_set1_ps(x0 + numWide), _mm256_castps256_ps128(ramp));
+            __m128 ix = _mm_mul_ps(_mm_add_ps(x, _mm256_castps256_ps128(offset)), _mm256_castps256_ps128(scale));
+            __m128i i0 = _mm_cvttps_epi32(ix);
+            __m128 mu = _mm_sub_ps(ix, _mm_cvtepi32_ps(i0));
+            __m128 y0 = _mm_i32gather_ps(table, i0, 4);
+            __m128 y1 = _mm_i32gather_ps(table + 1, i0, 4);
+            _mm_store_ps(&h[numWide], _mm_add_ps(y0, _mm_mul_ps(mu, _mm_sub_ps(y1, y0))));
+        }
+
+        // the same kernel applied to all channels
+        for (unsigned c = 0; c < numChannels; ++c) {
+            const float* values = sources[c] + indices[f] + j0;
+            __m256 y = _mm256_setzero_ps();
+            for (size_t i = 0; i < numWide; i += 8)
+                y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_load_ps(&h[i]), _mm256_loadu_ps(&values[i])));
+            if (numWide < Points) {
+                __m128 t = _mm_mul_ps(_mm_load_ps(&h[numWide]), _mm_loadu_ps(&values[numWide]));
+                y = _mm256_add_ps(y, _mm256_insertf128_ps(_mm256_setzero_ps(), t, 0));
+            }
+            const float result = horizontalSum(y);
+            if (addingGains)
+                outputs[c][f] += addingGains[f] * result;
+            else
+                outputs[c][f] = result;
+        }
+    }
+}
+#endif
+
+bool sincInterpolatorsAVX2Available() noexcept
+{
+    return SFIZZ_HAVE_AVX2;
+}
+
+void sincInterpolateAVX2(
+    const float* table, size_t tableSize, size_t points,
+    const float* const sources[], float* const outputs[], unsigned numChannels,
+    const int* indices, const float* coeffs, const float* addingGains,
+    size_t numFrames) noexcept
+{
+#if SFIZZ_HAVE_AVX2
+    const float tableScale = static_cast<float>(tableSize - 1) / points;
+
+    #define SINC_INTERPOLATE_FRAMES(Points)                                \
+        case Points:                                                       \
+            sincInterpolateFrames<Points>(                                 \
+                table, tableScale, sources, outputs, numChannels,          \
+                indices, coeffs, addingGains, numFrames);                  \
+            break
+
+    switch (points) {
+    SINC_INTERPOLATE_FRAMES(8);
+    SINC_INTERPOLATE_FRAMES(12);
+    SINC_INTERPOLATE_FRAMES(16);
+    SINC_INTERPOLATE_FRAMES(24);
+    SINC_INTERPOLATE_FRAMES(36);
+    SINC_INTERPOLATE_FRAMES(48);
+    SINC_INTERPOLATE_FRAMES(60);
+    SINC_INTERPOLATE_FRAMES(72);
+    default:
+        break;
+    }
+
+    #undef SINC_INTERPOLATE_FRAMES
+#else
+    (void)table;
+    (void)tableSize;
+    (void)points;
+    (void)sources;
+    (void)outputs;
+    (void)numChannels;
+    (void)indices;
+    (void)coeffs;
+    (void)addingGains;
+    (void)numFrames;
+#endif
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief Whether the windowed-sinc block interpolator was built with AVX2.
+ * The processor support must be checked separately.
+ */
+bool sincInterpolatorsAVX2Available() noexcept;
+
+/**
+ * @brief Interpolate a block of frames with a windowed-sinc table, gathering
+ * 8 taps of the kernel at a time. The kernel of a frame is computed once and
+ * applied to every channel.
+ *
+ * @param table the windowed-sinc table, with at least one extra point
+ * @param tableSize the size of the table, without the extra points
+ * @param points the number of points of the windowed-sinc
+ * @param sources the channels to interpolate
+ * @param outputs the output channels
+ * @param numChannels the number of channels
+ * @param indices the integral positions of the frames
+ * @param coeffs the interpolation coefficients of the frames
+ * @param addingGains the gains if adding to the outputs, or null
+ * @param numFrames the number of frames
+ */
+void sincInterpolateAVX2(
+    const float* table, size_t tableSize, size_t points,
+    const float* const sources[], float* const outputs[], unsigned numChannels,
+    const int* indices, const float* coeffs, const float* addingGains,
+    size_t numFrames) noexcept;
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <absl/strings/str_cat.h>
+#include <absl/strings/string_view.h>
+#include <ghc/fs_std.hpp>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <system_error>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace sfz
+{
+
+/**
+ * @brief Get a file next to another, which no other call of this process or
+ * of another process shares
+ *
+ * @param file
+ * @param extension
+ * @return fs::path
+ */
+inline fs::path getTemporaryFile(const fs::path& file, absl::string_view extension = "tmp")
+{
+    static std::atomic<uint64_t> counter { 0 };
+#if defined(_WIN32)
+    const auto processId = _getpid();
+#else
+    const auto processId = getpid();
+#endif
+    fs::path temporaryFile = file;
+    temporaryFile += absl::StrCat(".", processId, ".", counter.fetch_add(1, std::memory_order_relaxed), ".", extension);
+    return temporaryFile;
+}
+
+/**
+ * @brief Write a file aside and rename it over the file, so that the readers
+ * never see a partial file. The writer puts the stream in a failed state to
+ * give up, which leaves the file as it was.
+ *
+ * @param file
+ * @param writer called with the output stream
+ * @return true if the file was replaced
+ */
+template<class W>
+bool writeFileAtomically(const fs::path& file, W&& writer)
+{
+    std::error_code ec;
+    const fs::path temporaryFile = getTemporaryFile(file);
+    fs::ofstream stream { temporaryFile, std::ios::binary | std::ios::trunc };
+    if (stream)
+        writer(static_cast<std::ostream&>(stream));
+    // Closing flushes, which fails too
+    stream.close();
+    if (stream.fail()) {
+        fs::remove(temporaryFile, ec);
+        return false;
+    }
+
+    fs::rename(temporaryFile, file, ec);
+    if (ec) {
+        fs::remove(temporaryFile, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace sfz
@@ -7,6 +7,9 @@
 #pragma once
 #include <jsl/allocator>
 #include <memory>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
 
 namespace sfz {
 
@@ -55,4 +58,23 @@ struct aligned_deleter {
 template <class T, size_t A = alignof(T)>
 using aligned_unique_ptr = std::unique_ptr<T, aligned_deleter<T, A>>;
 
+/**
+ * @brief Hint the processor to bring a memory range into the cache, ahead of
+ * the reads. It is a no-op on the compilers without a prefetch intrinsic.
+ */
+inline void prefetchRange(const void* data, size_t size) noexcept
+{
+    constexpr size_t cacheLineSize = 64;
+    const char* bytes = static_cast<const char*>(data);
+    for (size_t offset = 0; offset < size; offset += cacheLineSize) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(bytes + offset, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(bytes + offset, _MM_HINT_T0);
+#else
+        (void)bytes;
+#endif
+    }
+}
+
 } // namespace sfz
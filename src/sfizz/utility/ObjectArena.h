@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <jsl/allocator>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief Allocate objects of type T contiguously, in their order of creation,
+ * within blocks which grow in size up to a maximum.
+ *
+ * Destroying an object only runs its destructor; the memory is kept by the
+ * arena until it is cleared, which makes the creation and destruction of many
+ * objects cost a few allocations rather than one each.
+ */
+template <class T, size_t MaxBlockSize = 1024>
+class ObjectArena {
+public:
+    static constexpr size_t minBlockSize = 16;
+    static_assert(MaxBlockSize >= minBlockSize, "The blocks must hold the minimum size");
+
+    /**
+     * @brief Destroys an object of the arena, leaving its memory to the arena.
+     */
+    struct Deleter {
+        void operator()(T* object) const noexcept
+        {
+            object->~T();
+        }
+    };
+
+    using Pointer = std::unique_ptr<T, Deleter>;
+
+    ObjectArena() = default;
+    ObjectArena(const ObjectArena&) = delete;
+    ObjectArena& operator=(const ObjectArena&) = delete;
+    ~ObjectArena() { clear(); }
+
+    /**
+     * @brief Construct a new object in the arena.
+     */
+    template <class... Args>
+    Pointer create(Args&&... args)
+    {
+        if (blocks_.empty() || used_ == blocks_.back().size) {
+            const size_t size = blocks_.empty() ? minBlockSize :
+                std::min(2 * blocks_.back().size, MaxBlockSize);
+            blocks_.push_back({ allocator().allocate(size), size });
+            used_ = 0;
+        }
+
+        T* object = blocks_.back().data + used_;
+        ::new (static_cast<void*>(object)) T(std::forward<Args>(args)...);
+        ++used_;
+        return Pointer(object);
+    }
+
+    /**
+     * @brief Release the memory of the arena. All the objects created from
+     * the arena must have been destroyed.
+     */
+    void clear() noexcept
+    {
+        for (const Block& block : blocks_)
+            allocator().deallocate(block.data, block.size);
+        blocks_.clear();
+        used_ = 0;
+    }
+
+    /**
+     * @brief Get the number of objects which the allocated blocks hold.
+     */
+    size_t capacity() const noexcept
+    {
+        size_t capacity = 0;
+        for (const Block& block : blocks_)
+            capacity += block.size;
+        return capacity;
+    }
+
+    /**
+     * @brief Get the number of allocated blocks.
+     */
+    size_t numBlocks() const noexcept { return blocks_.size(); }
+
+private:
+    using allocator = jsl::aligned_allocator<T, alignof(T)>;
+
+    struct Block {
+        T* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    // number of objects created in the last block
+    size_t used_ { 0 };
+};
+
+} // namespace sfz
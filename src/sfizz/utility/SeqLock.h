@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace sfz {
+
+/**
+ * @brief A value which one thread publishes and any number of threads read
+ * concurrently, without locking nor waiting for the writer.
+ *
+ * The value is kept as relaxed atomic words between two increments of a
+ * sequence number, which is odd while a store is in progress; the readers
+ * copy the words and retry if the sequence changed meanwhile.
+ */
+template <class T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "The value must be trivially copyable");
+
+public:
+    SeqLock() noexcept { store(T {}); }
+
+    /**
+     * @brief Publish a value. Only one thread may store.
+     */
+    void store(const T& value) noexcept
+    {
+        std::array<uint32_t, numWords> words {};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < numWords; ++i)
+            words_[i].store(words[i], std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Read the last value published, retrying while it is stored.
+     */
+    T load() const noexcept
+    {
+        T value;
+        while (!tryLoad(value))
+            ;
+        return value;
+    }
+
+    /**
+     * @brief Read the last value published, unless a store is in progress.
+     *
+     * @return true if the value was read whole
+     */
+    bool tryLoad(T& value) const noexcept
+    {
+        const uint32_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+
+        std::array<uint32_t, numWords> words;
+        for (size_t i = 0; i < numWords; ++i)
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != before)
+            return false;
+
+        std::memcpy(&value, words.data(), sizeof(T));
+        return true;
+    }
+
+private:
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    std::atomic<uint32_t> sequence_ { 0 };
+    std::array<std::atomic<uint32_t>, numWords> words_ {};
+};
+
+} // namespace sfz
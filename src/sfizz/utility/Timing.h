@@ -6,7 +6,14 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <thread>
 #include <type_traits>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace sfz
 {
@@ -24,7 +31,72 @@ static TimePoint highResNow()
 }
 
 /**
- * @brief Creates an RAII logger which fills or adds to a duration on destruction
+ * @brief A clock of the processor counters, much cheaper to read than the
+ * system clocks. It reads the time-stamp counter on x86, which is calibrated
+ * against the steady clock on first use, and the virtual counter on ARM64.
+ * Other targets fall back to the steady clock.
+ */
+struct CycleClock
+{
+    /**
+     * @brief Read the counter, in ticks.
+     */
+    static uint64_t now() noexcept
+    {
+#if defined(EMSCRIPTEN)
+        return 0;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /**
+     * @brief Get the duration of a tick in seconds. The first call calibrates
+     * the counter where needed, taking a few milliseconds; the synth calls it
+     * on construction, so that it does not happen in the RT thread.
+     */
+    static double secondsPerTick() noexcept
+    {
+        static const double period = calibrate();
+        return period;
+    }
+
+private:
+    static double calibrate() noexcept
+    {
+#if defined(EMSCRIPTEN)
+        return 0.0;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)) \
+    || defined(__x86_64__) || defined(__i386__)
+        const auto clockStart = std::chrono::steady_clock::now();
+        const uint64_t ticksStart = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        const auto clockEnd = std::chrono::steady_clock::now();
+        const uint64_t ticksEnd = now();
+        const double elapsed = std::chrono::duration<double>(clockEnd - clockStart).count();
+        return (ticksEnd > ticksStart) ? elapsed / static_cast<double>(ticksEnd - ticksStart) : 0.0;
+#elif defined(__aarch64__)
+        uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        return (frequency > 0) ? 1.0 / static_cast<double>(frequency) : 0.0;
+#else
+        return static_cast<double>(std::chrono::steady_clock::period::num)
+            / static_cast<double>(std::chrono::steady_clock::period::den);
+#endif
+    }
+};
+
+/**
+ * @brief Creates an RAII logger which fills or adds to a duration on destruction.
+ * It reads the CycleClock, and does nothing if it is disabled.
  *
  */
 struct ScopedTiming
@@ -40,25 +112,35 @@ struct ScopedTiming
      *
      * @param targetDuration
      * @param op
+     * @param enabled whether the scope is timed, or left untouched
      */
-    ScopedTiming(double& targetDuration, Operation op = Operation::replaceDuration)
-    : targetDuration(targetDuration), operation(op) {}
+    ScopedTiming(double& targetDuration, Operation op = Operation::replaceDuration, bool enabled = true)
+    : targetDuration(targetDuration), operation(op), enabled(enabled),
+      creationTicks(enabled ? CycleClock::now() : 0) {}
     ~ScopedTiming()
     {
+        if (!enabled)
+            return;
+
+        // a thread moved to another core can read an earlier count
+        const uint64_t ticks = CycleClock::now();
+        const double duration = (ticks > creationTicks) ?
+            static_cast<double>(ticks - creationTicks) * CycleClock::secondsPerTick() : 0.0;
         switch(operation)
         {
         case(Operation::replaceDuration):
-            targetDuration = (highResNow() - creationTime).count();
+            targetDuration = duration;
             break;
         case(Operation::addToDuration):
-            targetDuration += (highResNow() - creationTime).count();
+            targetDuration += duration;
             break;
         }
     }
 
     double& targetDuration;
     const Operation operation;
-    const TimePoint creationTime { highResNow() };
+    const bool enabled;
+    const uint64_t creationTicks;
 };
 
 }
@@ -50,6 +50,33 @@ typedef union {
     uint8_t m[4]; /**< 4-byte midi message union value */
 } sfizz_arg_t;
 
+/**
+ * @brief The types of the events in a batch.
+ * @since 1.3.0
+ */
+typedef enum {
+    SFIZZ_EVENT_NOTE_ON, /**< Note on, with the note number and the normalized velocity */
+    SFIZZ_EVENT_NOTE_OFF, /**< Note off, with the note number and the normalized velocity */
+    SFIZZ_EVENT_CC, /**< CC, with the CC number and the normalized value */
+    SFIZZ_EVENT_PROGRAM_CHANGE, /**< Program change, with the program number */
+    SFIZZ_EVENT_PITCH_WHEEL, /**< Pitch wheel, with the normalized pitch in domain -1 to 1 */
+    SFIZZ_EVENT_CHANNEL_AFTERTOUCH, /**< Channel aftertouch, with the normalized value */
+    SFIZZ_EVENT_POLY_AFTERTOUCH, /**< Polyphonic aftertouch, with the note number and the normalized value */
+    SFIZZ_EVENT_PER_NOTE_PITCH_WHEEL, /**< Per-note pitch wheel, with the note number and the normalized pitch in domain -1 to 1 */
+    SFIZZ_EVENT_PER_NOTE_TIMBRE, /**< Per-note timbre, with the note number and the normalized value */
+} sfizz_event_type_t;
+
+/**
+ * @brief A midi-type event in a batch, with high precision values.
+ * @since 1.3.0
+ */
+typedef struct {
+    int32_t delay; /**< The delay of the event in the block, in samples */
+    int32_t type; /**< The type of the event, a sfizz_event_type_t */
+    int32_t number; /**< The note, CC or program number, if any */
+    float value; /**< The normalized value, if any */
+} sfizz_event_t;
+
 /**
  * @brief Generic message receiving function
  * @since 1.0.0
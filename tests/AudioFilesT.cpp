@@ -5,12 +5,18 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "AudioSpan.h"
+#include "AudioReader.h"
 #include "absl/types/span.h"
 #include "sfizz/Synth.h"
+#include "sfizz/FilePool.h"
+#include "sfizz/MappedAudioFile.h"
+#include "sfizz/Resources.h"
 #include "TestHelpers.h"
 #include "catch2/catch.hpp"
 #include "st_audiofile.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <vector>
 using namespace Catch::literals;
 
@@ -34,6 +40,19 @@ void compareFiles(const fs::path& lFile, const fs::path& rFile)
     REQUIRE( approxEqual<float>(wav, flac) );
 }
 
+static std::vector<char> readFileBytes(const fs::path& path)
+{
+    fs::ifstream file(path, std::ios::binary | std::ios::ate);
+    const std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    std::vector<char> buffer(static_cast<size_t>(size));
+    if (!file.read(buffer.data(), size))
+        buffer.clear();
+
+    return buffer;
+}
+
 TEST_CASE("[AudioFiles] Compare Flac and WAV")
 {
     compareFiles(fs::current_path() / "tests/TestFiles/kick.wav",
@@ -190,3 +209,306 @@ TEST_CASE("[Files] Embedded sample data")
         REQUIRE(tmp1 == tmp2);
     }
 }
+
+TEST_CASE("[Files] Memory-mapped float WAV")
+{
+    if (!sfz::MappedAudioFile::isSupported()) {
+        REQUIRE(!sfz::MappedAudioFile::open(fs::current_path() / "tests/TestFiles/kick_float.wav"));
+        return;
+    }
+
+    auto mappedFile = sfz::MappedAudioFile::open(fs::current_path() / "tests/TestFiles/kick_float.wav");
+    REQUIRE(mappedFile);
+    const auto data = mappedFile->getData();
+    REQUIRE(data.size() == 44012);
+
+    // the padding frames around the data are silent
+    for (int i = 1; i <= sfz::config::excessFileFrames; ++i) {
+        REQUIRE(data.data()[-i] == 0.0f);
+        REQUIRE(data.data()[data.size() - 1 + i] == 0.0f);
+    }
+
+    // files needing a conversion are not mapped
+    REQUIRE(!sfz::MappedAudioFile::open(fs::current_path() / "tests/TestFiles/kick.wav"));
+    REQUIRE(!sfz::MappedAudioFile::open(fs::current_path() / "tests/TestFiles/kick.flac"));
+    REQUIRE(!sfz::MappedAudioFile::open(fs::current_path() / "tests/TestFiles/nonexistent.wav"));
+}
+
+TEST_CASE("[Files] Uncompressed WAV decode like the readers")
+{
+    for (const char* name : { "kick.wav", "looped_flute.wav", "stereo_sample.wav", "kick_float.wav" }) {
+        INFO(name);
+        const fs::path path = fs::current_path() / "tests/TestFiles" / name;
+        sfz::RawAudioLayout layout;
+        REQUIRE(sfz::getRawAudioLayout(path, layout));
+
+        // The memory readers decode with the libraries
+        const std::vector<char> file = readFileBytes(path);
+        auto reader = sfz::createAudioReaderFromMemory(file.data(), file.size(), false);
+        REQUIRE(layout.frames == static_cast<uint64_t>(reader->frames()));
+        REQUIRE(layout.channels == reader->channels());
+        REQUIRE(layout.sampleRate == reader->sampleRate());
+
+        const size_t numFrames = static_cast<size_t>(layout.frames);
+        std::vector<float> expected(numFrames * layout.channels);
+        REQUIRE(reader->readNextBlock(expected.data(), numFrames) == numFrames);
+
+        const auto dataStart = file.begin() + static_cast<std::ptrdiff_t>(layout.dataOffset);
+        const std::vector<unsigned char> data(dataStart, dataStart + numFrames * layout.bytesPerFrame());
+
+        std::vector<float> decoded(numFrames);
+        std::vector<float> expectedChannel(numFrames);
+        for (unsigned c = 0; c < layout.channels; ++c) {
+            sfz::decodeRawAudio(layout, data.data(), c, absl::MakeSpan(decoded));
+            for (size_t i = 0; i < numFrames; ++i)
+                expectedChannel[i] = expected[i * layout.channels + c];
+            REQUIRE(decoded == expectedChannel);
+        }
+    }
+
+    sfz::RawAudioLayout layout;
+    REQUIRE(!sfz::getRawAudioLayout(fs::current_path() / "tests/TestFiles/kick.flac", layout));
+    REQUIRE(!sfz::getRawAudioLayout(fs::current_path() / "tests/TestFiles/nonexistent.wav", layout));
+}
+
+TEST_CASE("[AudioFiles] Uncompressed WAV readers")
+{
+    for (const char* name : { "kick.wav", "looped_flute.wav", "stereo_sample.wav" }) {
+        for (bool reverse : { false, true }) {
+            INFO(name << (reverse ? " reversed" : ""));
+            const fs::path path = fs::current_path() / "tests/TestFiles" / name;
+            const std::vector<char> file = readFileBytes(path);
+            auto expectedReader = sfz::createAudioReaderFromMemory(file.data(), file.size(), reverse);
+            auto reader = sfz::createAudioReader(path, reverse);
+            REQUIRE(reader->type() == expectedReader->type());
+            REQUIRE(reader->frames() == expectedReader->frames());
+            REQUIRE(reader->channels() == expectedReader->channels());
+            REQUIRE(reader->sampleRate() == expectedReader->sampleRate());
+
+            const unsigned numChannels = reader->channels();
+            const size_t numFrames = static_cast<size_t>(reader->frames());
+            std::vector<float> expected(numFrames * numChannels);
+            REQUIRE(expectedReader->readNextBlock(expected.data(), numFrames) == numFrames);
+
+            // Read in uneven blocks, interleaved and then in separate channels
+            const size_t blockSize = 1000;
+            std::vector<float> interleaved(numFrames * numChannels);
+            std::vector<std::vector<float>> channels(numChannels, std::vector<float>(numFrames));
+            size_t position = 0;
+            while (position < numFrames / 2) {
+                const size_t count = reader->readNextBlock(&interleaved[position * numChannels], blockSize);
+                REQUIRE(count == blockSize);
+                for (size_t i = 0; i < count; ++i) {
+                    for (unsigned c = 0; c < numChannels; ++c)
+                        channels[c][position + i] = interleaved[(position + i) * numChannels + c];
+                }
+                position += count;
+            }
+            while (position < numFrames) {
+                float* outputs[2] {};
+                for (unsigned c = 0; c < numChannels; ++c)
+                    outputs[c] = &channels[c][position];
+                const size_t count = reader->readNextFrames(outputs, blockSize);
+                REQUIRE(count == std::min(blockSize, numFrames - position));
+                position += count;
+            }
+            REQUIRE(reader->readNextBlock(interleaved.data(), blockSize) == 0);
+
+            for (unsigned c = 0; c < numChannels; ++c) {
+                std::vector<float> expectedChannel(numFrames);
+                for (size_t i = 0; i < numFrames; ++i)
+                    expectedChannel[i] = expected[i * numChannels + c];
+                REQUIRE(channels[c] == expectedChannel);
+            }
+        }
+    }
+}
+
+TEST_CASE("[Files] Memory-mapped samples play like decoded samples")
+{
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+
+    synth1.setSamplesPerBlock(256);
+    synth2.setSamplesPerBlock(256);
+
+    synth1.loadSfzFile(fs::current_path() / "tests/TestFiles/kick.sfz");
+    synth2.loadSfzFile(fs::current_path() / "tests/TestFiles/kick_mapped.sfz");
+
+    REQUIRE(synth1.getResources().getFilePool().getNumMappedSamples() == 0);
+    REQUIRE(synth2.getResources().getFilePool().getNumMappedSamples() == 1);
+    REQUIRE(synth2.getNumPreloadedSamples() == 1);
+
+    sfz::AudioBuffer<float> buffer1 { 2, 256 };
+    sfz::AudioBuffer<float> buffer2 { 2, 256 };
+
+    synth1.noteOn(0, 60, 100);
+    synth2.noteOn(0, 60, 100);
+
+    for (unsigned i = 0; i < 200; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        REQUIRE(approxEqual(buffer1.getConstSpan(0), buffer2.getConstSpan(0)));
+        REQUIRE(approxEqual(buffer1.getConstSpan(1), buffer2.getConstSpan(1)));
+    }
+    REQUIRE(synth2.getNumActiveVoices() == 0);
+}
+
+TEST_CASE("[Files] Samples in the compact storage play like decoded samples")
+{
+    const std::string regions = R"(
+        <region> key=60 sample=kick.wav
+        <region> key=62 sample=looped_flute.wav sample_quality=10
+        <region> key=64 sample=looped_flute.wav loop_mode=loop_continuous loop_crossfade=0.1
+        <region> key=66 sample=stereo_sample.wav
+        <region> lokey=70 hikey=74 pitch_keycenter=62 sample=looped_flute.wav
+    )";
+
+    for (uint32_t preloadSize : { 256u, 200000u }) {
+        INFO("Preload size: " << preloadSize);
+        sfz::Synth synth1;
+        sfz::Synth synth2;
+        synth1.enableFreeWheeling();
+        synth2.enableFreeWheeling();
+        synth1.setPreloadSize(preloadSize);
+        synth2.setPreloadSize(preloadSize);
+
+        const fs::path sfzPath = fs::current_path() / "tests/TestFiles/compact.sfz";
+        synth1.loadSfzString(sfzPath, regions);
+        synth2.loadSfzString(sfzPath, "<control> hint_compact_samples=1" + regions);
+
+        // The 24-bit file keeps floats
+        REQUIRE(synth1.getResources().getFilePool().getNumCompactSamples() == 0);
+        REQUIRE(synth2.getResources().getFilePool().getNumCompactSamples() == 2);
+        REQUIRE(synth2.getNumPreloadedSamples() == 3);
+
+        sfz::AudioBuffer<float> buffer1 { 2, 256 };
+        sfz::AudioBuffer<float> buffer2 { 2, 256 };
+
+        for (int key : { 60, 62, 64, 66, 71, 74 }) {
+            synth1.noteOn(0, key, 100);
+            synth2.noteOn(0, key, 100);
+        }
+
+        for (unsigned i = 0; i < 800; ++i) {
+            synth1.renderBlock(buffer1);
+            synth2.renderBlock(buffer2);
+            for (unsigned c = 0; c < 2; ++c) {
+                const auto expected = buffer1.getConstSpan(c);
+                const auto actual = buffer2.getConstSpan(c);
+                REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+            }
+        }
+    }
+}
+
+static std::vector<char> makeFloatWav(const std::vector<float>& samples, uint32_t sampleRate)
+{
+    auto put32 = [](std::vector<char>& data, uint32_t value) {
+        for (unsigned i = 0; i < 4; ++i)
+            data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    };
+    auto put16 = [](std::vector<char>& data, uint16_t value) {
+        data.push_back(static_cast<char>(value & 0xff));
+        data.push_back(static_cast<char>(value >> 8));
+    };
+    const auto dataSize = static_cast<uint32_t>(samples.size() * sizeof(float));
+    std::vector<char> file;
+    file.insert(file.end(), { 'R', 'I', 'F', 'F' });
+    put32(file, 36 + dataSize);
+    file.insert(file.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+    put32(file, 16);
+    put16(file, 3); // IEEE float
+    put16(file, 1);
+    put32(file, sampleRate);
+    put32(file, sampleRate * sizeof(float));
+    put16(file, sizeof(float));
+    put16(file, 32);
+    file.insert(file.end(), { 'd', 'a', 't', 'a' });
+    put32(file, dataSize);
+    const size_t offset = file.size();
+    file.resize(offset + dataSize);
+    std::memcpy(&file[offset], samples.data(), dataSize);
+    return file;
+}
+
+TEST_CASE("[AudioFiles] Resampling reader")
+{
+    const double frequency = 1000.0;
+    std::vector<float> sine(8820);
+    for (size_t i = 0; i < sine.size(); ++i)
+        sine[i] = static_cast<float>(std::sin(2 * M_PI * frequency * i / 44100.0));
+    const std::vector<char> file = makeFloatWav(sine, 44100);
+
+    auto reader = sfz::createResamplingAudioReader(
+        sfz::createAudioReaderFromMemory(file.data(), file.size(), false), 48000.0);
+    REQUIRE(reader->sampleRate() == 48000.0);
+    REQUIRE(reader->channels() == 1);
+    REQUIRE(reader->frames() == 9600);
+    REQUIRE(sfz::getResampledFrames(8820, 44100.0, 48000.0) == 9600);
+
+    std::vector<float> output(9600);
+    size_t position = 0;
+    while (position < output.size()) {
+        const size_t count = reader->readNextBlock(&output[position], 1000);
+        REQUIRE(count > 0);
+        position += count;
+    }
+    REQUIRE(position == output.size());
+
+    // Away from the edges, the output is the same sine at the new rate
+    for (size_t i = 200; i < output.size() - 200; ++i)
+        REQUIRE(output[i] == Approx(std::sin(2 * M_PI * frequency * i / 48000.0)).margin(1e-3));
+
+    // The same rate keeps the reader
+    auto sameRate = sfz::createAudioReaderFromMemory(file.data(), file.size(), false);
+    const sfz::AudioReader* sameRateReader = sameRate.get();
+    REQUIRE(sfz::createResamplingAudioReader(std::move(sameRate), 44100.0).get() == sameRateReader);
+}
+
+TEST_CASE("[Files] Resample the files at the engine rate")
+{
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    const std::string regions = "<region> sample=kick.wav loop_mode=one_shot";
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/resample.sfz";
+    synth1.loadSfzString(sfzPath, regions);
+    synth2.loadSfzString(sfzPath, "<control> hint_resample_samples=1" + regions);
+
+    sfz::FilePool& filePool1 = synth1.getResources().getFilePool();
+    sfz::FilePool& filePool2 = synth2.getResources().getFilePool();
+    const auto& sampleId = synth2.getRegionView(0)->sampleId;
+    auto information1 = filePool1.getFilePromise(synth1.getRegionView(0)->sampleId)->information;
+    auto information2 = filePool2.getFilePromise(sampleId)->information;
+    REQUIRE(information1.sampleRate == 44100.0);
+    REQUIRE(information1.resampleRatio == 1.0);
+    REQUIRE(information2.sampleRate == 48000.0);
+    REQUIRE(information2.resampleRatio == Approx(48000.0 / 44100.0));
+    REQUIRE(information2.end + 1 == sfz::getResampledFrames(information1.end + 1, 44100.0, 48000.0));
+
+    // The file information stays in the frames of the file
+    REQUIRE(filePool2.getFileInformation(*sampleId)->sampleRate == 44100.0);
+
+    sfz::AudioBuffer<float> buffer1 { 2, 256 };
+    sfz::AudioBuffer<float> buffer2 { 2, 256 };
+    synth1.noteOn(0, 60, 100);
+    synth2.noteOn(0, 60, 100);
+    double energy1 = 0.0;
+    double energy2 = 0.0;
+    for (unsigned i = 0; i < 100; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (float x : buffer1.getConstSpan(0))
+            energy1 += x * x;
+        for (float x : buffer2.getConstSpan(0))
+            energy2 += x * x;
+    }
+    REQUIRE(energy2 > 0.0);
+    REQUIRE(energy2 == Approx(energy1).epsilon(0.05));
+
+    // A new rate resamples the files again
+    synth2.setSampleRate(96000.0f);
+    information2 = filePool2.getFilePromise(sampleId)->information;
+    REQUIRE(information2.sampleRate == 96000.0);
+    REQUIRE(information2.resampleRatio == Approx(96000.0 / 44100.0));
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/BeatClock.h"
+#include "sfizz/Synth.h"
+#include "sfizz/Resources.h"
+#include "catch2/catch.hpp"
+#include "ghc/fs_std.hpp"
+
+TEST_CASE("[BeatClock] Tempo synced LFOs are the consumers")
+{
+    sfz::Synth synth;
+    const sfz::BeatClock& clock = synth.getResources().getBeatClock();
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/beat_consumers.sfz", R"(
+        <region> sample=*sine lfo1_freq=2 lfo1_pitch=100
+    )");
+    REQUIRE(!clock.hasConsumers());
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/beat_consumers.sfz", R"(
+        <region> sample=*sine lfo1_beats=1 lfo1_pitch=100
+    )");
+    REQUIRE(clock.hasConsumers());
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/beat_consumers.sfz", R"(
+        <region> sample=*sine amplfo_freq=2 amplfo_depth=3
+    )");
+    REQUIRE(!clock.hasConsumers());
+}
+
+TEST_CASE("[BeatClock] The clock advances the same without consumers")
+{
+    constexpr unsigned numFrames { 256 };
+    sfz::BeatClock computed;
+    sfz::BeatClock skipped;
+    computed.registerConsumer();
+
+    for (sfz::BeatClock* clock : { &computed, &skipped }) {
+        clock->setSampleRate(48000.0);
+        clock->setSamplesPerBlock(numFrames);
+    }
+
+    for (int cycle = 0; cycle < 8; ++cycle) {
+        for (sfz::BeatClock* clock : { &computed, &skipped }) {
+            clock->beginCycle(numFrames);
+            if (cycle == 1)
+                clock->setPlaying(10, true);
+            else if (cycle == 3)
+                clock->setTempo(100, 0.25);
+            else if (cycle == 5)
+                clock->setTimePosition(50, sfz::BBT(2, 1.5));
+            clock->endCycle();
+        }
+        REQUIRE(skipped.getLastBeatPosition() == Approx(computed.getLastBeatPosition()).margin(1e-6));
+    }
+
+    // Requested without consumers, the buffers are computed on demand
+    for (sfz::BeatClock* clock : { &computed, &skipped })
+        clock->beginCycle(numFrames);
+    absl::Span<const float> expected = computed.getRunningBeatPosition();
+    absl::Span<const float> positions = skipped.getRunningBeatPosition();
+    REQUIRE(positions.size() == expected.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+        REQUIRE(positions[i] == Approx(expected[i]).margin(1e-5));
+    absl::Span<const int> expectedBeats = computed.getRunningBeatNumber();
+    absl::Span<const int> beats = skipped.getRunningBeatNumber();
+    for (size_t i = 0; i < beats.size(); ++i)
+        REQUIRE(beats[i] == expectedBeats[i]);
+}
@@ -5,8 +5,11 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "sfizz/Buffer.h"
+#include "sfizz/SampleMemory.h"
 #include "catch2/catch.hpp"
 #include <algorithm>
+#include <memory>
+#include <vector>
 using namespace Catch::literals;
 
 TEST_CASE("[Buffer] Empty (float)")
@@ -201,3 +204,83 @@ TEST_CASE("[Buffer] Buffer counter")
     REQUIRE(haveNumBuffers(1));
     REQUIRE(haveTotalAllocation(b2.allocationSize()));
 }
+
+TEST_CASE("[Buffer] Sample memory in huge pages")
+{
+    using SampleBuffer = sfz::Buffer<float, sfz::config::defaultAlignment, sfz::SampleAllocator>;
+    const size_t mappedBefore = sfz::SampleMemory::getMappedBytes();
+    sfz::SampleMemory::setPages(sfz::SampleMemory::Pages::Transparent);
+
+    {
+        // The small buffers share a slab
+        std::vector<std::unique_ptr<SampleBuffer>> buffers;
+        for (int i = 0; i < 16; ++i) {
+            buffers.emplace_back(new SampleBuffer(1000));
+            REQUIRE(std::all_of(buffers.back()->begin(), buffers.back()->end(), [](float x) { return x == 0.0f; }));
+            std::fill(buffers.back()->begin(), buffers.back()->end(), 1.0f);
+        }
+        REQUIRE(sfz::SampleMemory::getMappedBytes() == mappedBefore + sfz::config::sampleSlabSize);
+
+        // A freed block comes back zeroed
+        buffers.front().reset(new SampleBuffer(1000));
+        REQUIRE(std::all_of(buffers.front()->begin(), buffers.front()->end(), [](float x) { return x == 0.0f; }));
+
+        // The large buffers are mapped on their own, and keep their data
+        buffers.back()->resize(1 << 20);
+        REQUIRE(sfz::SampleMemory::getMappedBytes() > mappedBefore + sfz::config::sampleSlabSize);
+        REQUIRE(std::all_of(buffers.back()->begin(), buffers.back()->begin() + 1000, [](float x) { return x == 1.0f; }));
+    }
+    REQUIRE(sfz::SampleMemory::getMappedBytes() == mappedBefore);
+
+    // The buffers are freed after a change of pages; with the normal pages,
+    // the small buffers take slabs of their own and the large ones the heap
+    std::unique_ptr<SampleBuffer> huge { new SampleBuffer(1000) };
+    sfz::SampleMemory::setPages(sfz::SampleMemory::Pages::Normal);
+    std::unique_ptr<SampleBuffer> normal { new SampleBuffer(1000) };
+    std::unique_ptr<SampleBuffer> heap { new SampleBuffer(1 << 20) };
+    REQUIRE(sfz::SampleMemory::getMappedBytes() == mappedBefore + 2 * sfz::config::sampleSlabSize);
+    huge.reset();
+    normal.reset();
+    heap.reset();
+    REQUIRE(sfz::SampleMemory::getMappedBytes() == mappedBefore);
+}
+
+TEST_CASE("[Buffer] Preloads packed in slabs")
+{
+    using SampleBuffer = sfz::Buffer<float, sfz::config::defaultAlignment, sfz::SampleAllocator>;
+    const size_t mappedBefore = sfz::SampleMemory::getMappedBytes();
+    sfz::SampleMemory::setPages(sfz::SampleMemory::Pages::Normal);
+
+    {
+        // The heads of 8192 frames, many per slab
+        std::vector<std::unique_ptr<SampleBuffer>> buffers;
+        for (int i = 0; i < 1000; ++i)
+            buffers.emplace_back(new SampleBuffer(8192));
+        const size_t slabBytes = sfz::SampleMemory::getMappedBytes() - mappedBefore;
+        REQUIRE(slabBytes >= 1000 * 8192 * sizeof(float));
+        REQUIRE(slabBytes <= 2 * 1000 * 8192 * sizeof(float));
+    }
+    REQUIRE(sfz::SampleMemory::getMappedBytes() == mappedBefore);
+}
+
+TEST_CASE("[Buffer] Sample memory on a NUMA node")
+{
+    using SampleBuffer = sfz::Buffer<float, sfz::config::defaultAlignment, sfz::SampleAllocator>;
+    const size_t mappedBefore = sfz::SampleMemory::getMappedBytes();
+    sfz::SampleMemory::setPages(sfz::SampleMemory::Pages::Normal);
+    REQUIRE(sfz::SampleMemory::getThreadNode() == -1);
+
+    {
+        const sfz::SampleMemory::NodeScope nodeScope { 0 };
+        REQUIRE(sfz::SampleMemory::getThreadNode() == 0);
+
+        // The large buffers are mapped for the node, and the small ones
+        // take a slab apart from the buffers without a node
+        SampleBuffer large { 1 << 20 };
+        SampleBuffer small { 1000 };
+        REQUIRE(std::all_of(large.begin(), large.end(), [](float x) { return x == 0.0f; }));
+        REQUIRE(sfz::SampleMemory::getMappedBytes() >= mappedBefore + (1 << 20) * sizeof(float) + sfz::config::sampleSlabSize);
+    }
+    REQUIRE(sfz::SampleMemory::getThreadNode() == -1);
+    REQUIRE(sfz::SampleMemory::getMappedBytes() == mappedBefore);
+}
@@ -4,8 +4,11 @@
 // license. You should have receive a LICENSE.md file along with the code.
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
+#include "sfizz/utility/SeqLock.h"
 #include "catch2/catch.hpp"
 #include <SpinMutex.h>
+#include <array>
+#include <atomic>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -49,3 +52,48 @@ TEST_CASE("[SpinMutex] Basic synchronization")
 
     REQUIRE(counter == num_threads * num_iterations);
 }
+
+TEST_CASE("[SeqLock] Readers see whole values")
+{
+    constexpr size_t num_readers = 4;
+    constexpr uint32_t num_stores = 100000;
+    using Value = std::array<uint32_t, 64>;
+
+    sfz::SeqLock<Value> lock;
+    std::atomic<bool> done { false };
+    std::atomic<size_t> torn { 0 };
+    std::atomic<size_t> backwards { 0 };
+
+    auto reader_run = [&]()
+    {
+        uint32_t last = 0;
+        while (!done.load()) {
+            const Value value = lock.load();
+            for (uint32_t item : value) {
+                if (item != value[0])
+                    ++torn;
+            }
+            if (value[0] < last)
+                ++backwards;
+            last = value[0];
+        }
+    };
+
+    std::thread readers[num_readers];
+    for (unsigned i = 0; i < num_readers; ++i)
+        readers[i] = std::thread(reader_run);
+
+    Value value;
+    for (uint32_t i = 1; i <= num_stores; ++i) {
+        value.fill(i);
+        lock.store(value);
+    }
+    done = true;
+
+    for (unsigned i = 0; i < num_readers; ++i)
+        readers[i].join();
+
+    REQUIRE(torn == 0);
+    REQUIRE(backwards == 0);
+    REQUIRE(lock.load()[0] == num_stores);
+}
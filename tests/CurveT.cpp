@@ -260,3 +260,27 @@ TEST_CASE("[Curve] Build from points")
     REQUIRE(curve.evalNormalized(63_norm) == curvePoints[63]);
 }
 
+
+TEST_CASE("[Curve] Evaluate spans")
+{
+    const sfz::CurveSet curveSet = sfz::CurveSet::createPredefined();
+    std::vector<float> input(1021);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = -0.1f + 1.2f * static_cast<float>(i) / (input.size() - 1);
+    input[10] = 63_norm;
+    input[11] = 1.0f;
+
+    for (unsigned c = 0; c < sfz::Curve::NumPredefinedCurves; ++c) {
+        INFO("Curve " << c);
+        const sfz::Curve& curve = curveSet.getCurve(c);
+        std::vector<float> output(input.size());
+        curve.evalSpan(input, absl::MakeSpan(output));
+        for (size_t i = 0; i < input.size(); ++i)
+            REQUIRE( output[i] == Approx(curve.evalNormalized(input[i])).margin(1e-6) );
+
+        // In place
+        std::vector<float> inPlace = input;
+        curve.evalSpan(inPlace, absl::MakeSpan(inPlace));
+        REQUIRE( inPlace == output );
+    }
+}
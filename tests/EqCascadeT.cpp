@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/EqCascade.h"
+#include "sfizz/SfzFilter.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr double sampleRate { 48000.0 };
+constexpr unsigned numFrames { 1001 };
+
+struct Channels {
+    explicit Channels(unsigned numChannels)
+        : inputs(numChannels, std::vector<float>(numFrames)),
+          expected(numChannels, std::vector<float>(numFrames)),
+          outputs(numChannels, std::vector<float>(numFrames))
+    {
+        std::minstd_rand prng;
+        std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+        for (auto& channel : inputs) {
+            for (float& x : channel)
+                x = dist(prng);
+        }
+        expected = inputs;
+        outputs = inputs;
+    }
+
+    std::vector<std::vector<float>> inputs;
+    std::vector<std::vector<float>> expected;
+    std::vector<std::vector<float>> outputs;
+};
+
+void checkChannels(const Channels& channels)
+{
+    for (size_t c = 0; c < channels.outputs.size(); ++c) {
+        INFO("Channel " << c);
+        for (unsigned i = 0; i < numFrames; ++i)
+            REQUIRE(channels.outputs[c][i] == Approx(channels.expected[c][i]).margin(1e-4));
+    }
+}
+
+} // namespace
+
+TEST_CASE("[EqCascade] Bands without a type pass through")
+{
+    sfz::EqBand band;
+    band.setType(sfz::kEqNone);
+    const float input[4] { 1.0f, 2.0f, 3.0f, 4.0f };
+    float output[4] {};
+    const float* in[1] { input };
+    float* out[1] { output };
+    sfz::EqBand* bands[1] { &band };
+    sfz::EqCascade::process(bands, 1, in, out, 1, 4);
+    REQUIRE(std::equal(input, input + 4, output));
+}
+
+TEST_CASE("[EqCascade] Cascades compute like the equalizers in series")
+{
+    const sfz::EqType types[] { sfz::kEqPeak, sfz::kEqLshelf, sfz::kEqHshelf };
+
+    for (unsigned numChannels : { 1u, 2u }) {
+        for (unsigned numBands : { 1u, 3u, 6u }) {
+            INFO(numChannels << " channels, " << numBands << " bands");
+            Channels channels { numChannels };
+            std::vector<sfz::FilterEq> eqs(numBands);
+            std::vector<sfz::EqBand> bands(numBands);
+            std::vector<sfz::EqBand*> bandPointers;
+
+            auto parameters = [](unsigned b, unsigned frame, float& cutoff, float& bw, float& pksh) {
+                cutoff = 200.0f * (b + 1) + 2.0f * frame;
+                bw = 0.5f + 0.25f * b;
+                pksh = 3.0f * std::sin(0.01f * frame + b);
+            };
+
+            for (unsigned b = 0; b < numBands; ++b) {
+                float cutoff, bw, pksh;
+                parameters(b, 0, cutoff, bw, pksh);
+                eqs[b].init(sampleRate);
+                eqs[b].setType(types[b % 3]);
+                eqs[b].setChannels(numChannels);
+                eqs[b].prepare(cutoff, bw, pksh);
+                bands[b].init(sampleRate);
+                bands[b].setType(types[b % 3]);
+                bands[b].prepare(cutoff, bw, pksh);
+                bandPointers.push_back(&bands[b]);
+            }
+
+            // In place, with the parameters changing between the cycles
+            unsigned frame = 0;
+            while (frame < numFrames) {
+                const unsigned current = std::min(numFrames - frame, 64u);
+                const float* expectedIn[2];
+                float* expectedOut[2];
+                const float* in[2];
+                float* out[2];
+                for (unsigned c = 0; c < numChannels; ++c) {
+                    expectedIn[c] = expectedOut[c] = channels.expected[c].data() + frame;
+                    in[c] = out[c] = channels.outputs[c].data() + frame;
+                }
+
+                for (unsigned b = 0; b < numBands; ++b) {
+                    float cutoff, bw, pksh;
+                    parameters(b, frame, cutoff, bw, pksh);
+                    eqs[b].process(expectedIn, expectedOut, cutoff, bw, pksh, current);
+                    bands[b].setParameters(cutoff, bw, pksh);
+                }
+                sfz::EqCascade::process(bandPointers.data(), numBands, in, out, numChannels, current);
+                frame += current;
+            }
+
+            checkChannels(channels);
+        }
+    }
+}
@@ -7,6 +7,8 @@
 #include "TestHelpers.h"
 #include "sfizz/Synth.h"
 #include "sfizz/Voice.h"
+#include "sfizz/FilePool.h"
+#include "sfizz/AudioReader.h"
 #include "sfizz/SfzHelpers.h"
 #include "sfizz/parser/Parser.h"
 #include "sfizz/modulations/ModId.h"
@@ -14,6 +16,10 @@
 #include "sfizz/utility/bit_array/BitArray.h"
 #include "catch2/catch.hpp"
 #include "ghc/fs_std.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
 #if defined(__APPLE__)
 #include <unistd.h> // pathconf
 #endif
@@ -680,6 +686,30 @@ TEST_CASE("[Files] Case sentitiveness")
     }
 }
 
+TEST_CASE("[Files] Samples checked concurrently")
+{
+    sfz::FilePool pool;
+    pool.setRootDirectory(fs::current_path() / "tests/TestFiles");
+    pool.setLoadingParallelism(4);
+
+    std::vector<sfz::FileId> samples {
+        sfz::FileId { "kick.wav" },
+        sfz::FileId { "doesNotExist.wav" },
+        sfz::FileId { "snare.wav", true },
+        sfz::FileId { "kick.wav" },
+        sfz::FileId { "Dummy1.wav" },
+    };
+    std::vector<sfz::FileId> expected = samples;
+    std::vector<uint8_t> expectedFound;
+    for (sfz::FileId& sample : expected)
+        expectedFound.push_back(pool.checkSampleId(sample) ? 1 : 0);
+
+    REQUIRE(pool.checkSampleIds(samples) == expectedFound);
+    REQUIRE(expectedFound[0]);
+    REQUIRE(!expectedFound[1]);
+    REQUIRE(samples == expected);
+}
+
 TEST_CASE("[Files] Empty file")
 {
     Synth synth;
@@ -780,6 +810,73 @@ TEST_CASE("[Files] Unused samples are cleared on reloading")
     REQUIRE(synth.getNumPreloadedSamples() == 0);
 }
 
+TEST_CASE("[Files] Reloading reuses the unchanged regions")
+{
+    sfz::Synth synth;
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/reused_regions.sfz";
+    synth.loadSfzString(sfzPath, R"(
+        <group> volume=-3
+        <region> sample=kick.wav key=60 unknown_opcode=1
+        <region> sample=snare.wav key=62
+    )");
+    REQUIRE(synth.getNumRegions() == 2);
+    const sfz::FileId* kick = synth.getRegionView(0)->sampleId.get();
+    const sfz::FileId* snare = synth.getRegionView(1)->sampleId.get();
+
+    // Only the second region changes
+    synth.loadSfzString(sfzPath, R"(
+        <group> volume=-3
+        <region> sample=kick.wav key=60 unknown_opcode=1
+        <region> sample=snare.wav key=64
+    )");
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getRegionView(0)->sampleId.get() == kick);
+    REQUIRE(synth.getRegionView(1)->sampleId.get() != snare);
+    REQUIRE(synth.getRegionView(0)->volume == -3.0f);
+    REQUIRE(synth.getRegionView(0)->keyRange == sfz::Range<uint8_t>(60, 60));
+    REQUIRE(synth.getRegionView(1)->keyRange == sfz::Range<uint8_t>(64, 64));
+    REQUIRE(synth.getUnknownOpcodes() == std::vector<std::string> { "unknown_opcode" });
+    REQUIRE(synth.getNumPreloadedSamples() == 2);
+
+    // A change of the group changes all its regions
+    synth.loadSfzString(sfzPath, R"(
+        <group> volume=-6
+        <region> sample=kick.wav key=60 unknown_opcode=1
+        <region> sample=snare.wav key=64
+    )");
+    REQUIRE(synth.getRegionView(0)->sampleId.get() != kick);
+    REQUIRE(synth.getRegionView(0)->volume == -6.0f);
+    REQUIRE(synth.getRegionView(1)->volume == -6.0f);
+}
+
+TEST_CASE("[Files] Reloading tells the opcodes apart from their concatenation")
+{
+    sfz::Synth synth;
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/reused_regions.sfz";
+    const auto hasConnectionFromCC = [&synth](int cc) {
+        for (const auto& connection : synth.getRegionView(0)->connections) {
+            const sfz::ModId id = connection.source.id();
+            if ((id == sfz::ModId::Controller || id == sfz::ModId::PerVoiceController)
+                && connection.source.parameters().cc == cc)
+                return true;
+        }
+        return false;
+    };
+
+    synth.loadSfzString(sfzPath, R"(
+        <region> sample=kick.wav amplitude_oncc2=10
+    )");
+    REQUIRE(hasConnectionFromCC(2));
+    REQUIRE(!hasConnectionFromCC(21));
+
+    // The same bytes, split otherwise between the name and the value
+    synth.loadSfzString(sfzPath, R"(
+        <region> sample=kick.wav amplitude_oncc21=0
+    )");
+    REQUIRE(!hasConnectionFromCC(2));
+    REQUIRE(hasConnectionFromCC(21));
+}
+
 TEST_CASE("[Files] Key center from audio file, with embedded sample data")
 {
     sfz::Synth synth;
@@ -818,3 +915,1229 @@ TEST_CASE("[Files] NewDrums: disappearing CCs (#1077)")
 
     REQUIRE( used == expected );
 }
+
+TEST_CASE("[Files] Preloaded data is shared between synths")
+{
+    const auto before = sfz::FilePool::getSharedPreloadStats();
+    {
+        sfz::Synth synth1;
+        sfz::Synth synth2;
+        synth1.loadSfzFile(fs::current_path() / "tests/TestFiles/kick.sfz");
+        synth2.loadSfzFile(fs::current_path() / "tests/TestFiles/kick.sfz");
+
+        const auto shared = sfz::FilePool::getSharedPreloadStats();
+        REQUIRE(shared.numSharedFiles == before.numSharedFiles + 1);
+        REQUIRE(shared.bytesSaved >= before.bytesSaved + synth1.getPreloadSize() * sizeof(float));
+
+        // a larger preload is not shared until the other synth catches up
+        synth1.setPreloadSize(2 * synth1.getPreloadSize());
+        REQUIRE(sfz::FilePool::getSharedPreloadStats().numSharedFiles == before.numSharedFiles);
+        synth2.setPreloadSize(synth1.getPreloadSize());
+        REQUIRE(sfz::FilePool::getSharedPreloadStats().numSharedFiles == before.numSharedFiles + 1);
+
+        sfz::AudioBuffer<float> buffer { 2, 256 };
+        synth2.noteOn(0, 60, 100);
+        synth2.renderBlock(buffer);
+        REQUIRE(synth2.getNumActiveVoices() == 1);
+    }
+    const auto after = sfz::FilePool::getSharedPreloadStats();
+    REQUIRE(after.numSharedFiles == before.numSharedFiles);
+    REQUIRE(after.bytesSaved == before.bytesSaved);
+}
+
+TEST_CASE("[Files] Decoded cache of compressed files")
+{
+    const fs::path cacheDirectory = fs::temp_directory_path() / "sfizz_decoded_cache_test";
+    fs::remove_all(cacheDirectory);
+
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/kick_flac_cache.sfz";
+    const std::string sfzString = R"(<region> sample=kick.flac)";
+
+    auto render = [&](bool useCache) {
+        sfz::Synth synth;
+        if (useCache)
+            synth.setSampleCacheDirectory(cacheDirectory);
+        synth.loadSfzString(sfzPath, sfzString);
+        REQUIRE(synth.getNumRegions() == 1);
+
+        sfz::AudioBuffer<float> buffer { 2, 256 };
+        std::vector<float> output;
+        synth.noteOn(0, 60, 100);
+        for (unsigned i = 0; i < 8; ++i) {
+            synth.renderBlock(buffer);
+            const auto left = buffer.getConstSpan(0);
+            output.insert(output.end(), left.begin(), left.end());
+        }
+        return output;
+    };
+
+    auto numCacheFiles = [&]() {
+        size_t count = 0;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(cacheDirectory, ec))
+            count += (entry.path().extension() == ".sfzcache") ? 1 : 0;
+        return count;
+    };
+
+    const std::vector<float> uncached = render(false);
+    REQUIRE(std::any_of(uncached.begin(), uncached.end(), [](float x) { return x != 0.0f; }));
+    REQUIRE(numCacheFiles() == 0);
+    REQUIRE(render(true) == uncached);
+    REQUIRE(numCacheFiles() == 1);
+    // read back from the cache
+    REQUIRE(render(true) == uncached);
+    REQUIRE(numCacheFiles() == 1);
+
+    fs::remove_all(cacheDirectory);
+}
+
+TEST_CASE("[Files] Persistent information cache")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_information_cache_test";
+    const fs::path cacheDirectory = directory / "cache";
+    const fs::path samples = directory / "samples";
+    const fs::path flute = samples / "sub" / "looped_flute.wav";
+    fs::remove_all(directory);
+    fs::create_directories(samples / "sub");
+    fs::copy_file(fs::current_path() / "tests/TestFiles/kick.wav", samples / "kick.wav");
+    fs::copy_file(fs::current_path() / "tests/TestFiles/looped_flute.wav", flute);
+    {
+        fs::ofstream stream { samples / "notes.txt" };
+        stream << "not a sample";
+    }
+
+    sfz::FilePool::clearFileInformationCache();
+    sfz::FilePool pool;
+    pool.setRootDirectory(samples);
+    pool.setCacheDirectory(cacheDirectory);
+    REQUIRE(pool.probeDirectoryInformation(".") == 2);
+    REQUIRE(sfz::FilePool::getNumCachedFileInformation() == 2);
+    REQUIRE(fs::exists(cacheDirectory / "information.sfzindex"));
+    const auto expected = pool.getFileInformation(sfz::FileId { "sub/looped_flute.wav" });
+    REQUIRE(expected);
+    REQUIRE(expected->hasLoop);
+
+    // Spoil the file, keeping its size and modification time
+    const auto modificationTime = fs::last_write_time(flute);
+    const auto fileSize = fs::file_size(flute);
+    {
+        fs::ofstream stream { flute, std::ios::binary | std::ios::trunc };
+        stream << std::string(fileSize, '\0');
+    }
+    fs::last_write_time(flute, modificationTime);
+
+    // The information comes back from the index
+    sfz::FilePool::clearFileInformationCache();
+    REQUIRE(sfz::FilePool::getNumCachedFileInformation() == 0);
+    sfz::FilePool otherPool;
+    otherPool.setRootDirectory(samples);
+    otherPool.setCacheDirectory(cacheDirectory);
+    const auto cached = otherPool.getFileInformation(sfz::FileId { "sub/looped_flute.wav" });
+    REQUIRE(sfz::FilePool::getNumCachedFileInformation() == 2);
+    REQUIRE(cached);
+    REQUIRE(cached->end == expected->end);
+    REQUIRE(cached->hasLoop);
+    REQUIRE(cached->loopStart == expected->loopStart);
+    REQUIRE(cached->loopEnd == expected->loopEnd);
+    REQUIRE(cached->sampleRate == expected->sampleRate);
+    REQUIRE(cached->numChannels == expected->numChannels);
+    REQUIRE(cached->rootKey == expected->rootKey);
+
+    // A changed file is read again
+    fs::last_write_time(flute, modificationTime + std::chrono::seconds(10));
+    const auto changed = otherPool.getFileInformation(sfz::FileId { "sub/looped_flute.wav" });
+    REQUIRE((!changed || !changed->hasLoop));
+
+    sfz::FilePool::clearFileInformationCache();
+    fs::remove_all(directory);
+}
+
+TEST_CASE("[Files] Concurrent loading matches serial loading")
+{
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/concurrent_loading.sfz";
+    const std::string sfzString = R"(
+        <region> key=60 sample=kick.wav
+        <region> key=61 sample=snare.wav offset=1000
+        <region> key=62 sample=closedhat.wav
+        <region> key=63 sample=looped_flute.wav
+        <region> key=64 sample=stereo_sample.wav
+        <region> key=65 sample=kick.wav offset=4000
+        <region> key=66 sample=root_key_38.wav pitch_keycenter=sample
+        <region> key=67 sample=36-CajonCenter-1.wav
+        <region> key=68 sample=36-CajonCenter-2.wav direction=reverse
+        <region> key=69 sample=*sine
+        <region> key=70 sample=does_not_exist.wav
+    )";
+
+    sfz::Synth serial;
+    serial.setLoadingParallelism(1);
+    serial.loadSfzString(sfzPath, sfzString);
+
+    sfz::Synth concurrent;
+    concurrent.setLoadingParallelism(8);
+    REQUIRE(concurrent.getLoadingParallelism() == 8);
+    concurrent.loadSfzString(sfzPath, sfzString);
+
+    REQUIRE(concurrent.getNumRegions() == serial.getNumRegions());
+    REQUIRE(concurrent.getNumPreloadedSamples() == serial.getNumPreloadedSamples());
+    for (int i = 0; i < serial.getNumRegions(); ++i) {
+        const Region* expected = serial.getRegionView(i);
+        const Region* region = concurrent.getRegionView(i);
+        REQUIRE(*region->sampleId == *expected->sampleId);
+        REQUIRE(region->sampleEnd == expected->sampleEnd);
+        REQUIRE(region->loopRange == expected->loopRange);
+        REQUIRE(region->loopMode == expected->loopMode);
+        REQUIRE(region->hasStereoSample == expected->hasStereoSample);
+        REQUIRE(region->pitchKeycenter == expected->pitchKeycenter);
+    }
+
+    sfz::AudioBuffer<float> serialBuffer { 2, 256 };
+    sfz::AudioBuffer<float> concurrentBuffer { 2, 256 };
+    for (int note = 60; note <= 69; ++note) {
+        serial.noteOn(0, note, 100);
+        concurrent.noteOn(0, note, 100);
+    }
+    for (unsigned block = 0; block < 16; ++block) {
+        serial.renderBlock(serialBuffer);
+        concurrent.renderBlock(concurrentBuffer);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = serialBuffer.getConstSpan(c);
+            const auto actual = concurrentBuffer.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+}
+
+TEST_CASE("[Files] Streamed samples match the fully preloaded samples")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav
+        <region> key=62 sample=36-CajonCenter-3.wav
+        <region> key=64 sample=stereo_sample.wav pitch_keytrack=100
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.enableFreeWheeling();
+    synth2.enableFreeWheeling();
+    synth1.setPreloadSize(256);
+    synth2.setPreloadSize(200000);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/streaming.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/streaming.sfz", sfzText);
+
+    sfz::AudioBuffer<float> buffer1 { 2, 1024 };
+    sfz::AudioBuffer<float> buffer2 { 2, 1024 };
+    for (int key : { 60, 62, 64 }) {
+        synth1.noteOn(0, key, 100);
+        synth2.noteOn(0, key, 100);
+    }
+
+    for (unsigned i = 0; i < 200; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer2.getConstSpan(c);
+            const auto actual = buffer1.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+    REQUIRE(synth1.getUnderrunStats().numUnderruns == 0);
+}
+
+TEST_CASE("[Files] Bounded streams match the fully preloaded samples")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=no_loop
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.enableFreeWheeling();
+    synth2.enableFreeWheeling();
+    synth1.setPreloadSize(256);
+    synth1.setStreamingWindow(32768);
+    synth2.setPreloadSize(200000);
+    REQUIRE(synth1.getStreamingWindow() == 32768);
+    REQUIRE(synth2.getStreamingWindow() == 0);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/streaming.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/streaming.sfz", sfzText);
+
+    const sfz::FilePool& filePool = synth1.getResources().getFilePool();
+    const size_t maxMemory = 2 * sizeof(float) * (32768 + sfz::config::streamSliceSize
+        + sfz::config::streamReleaseMargin + 2 * sfz::config::fileChunkSize);
+    size_t peakMemory = 0;
+
+    sfz::AudioBuffer<float> buffer1 { 2, 1024 };
+    sfz::AudioBuffer<float> buffer2 { 2, 1024 };
+    synth1.noteOn(0, 60, 100);
+    synth2.noteOn(0, 60, 100);
+    for (unsigned i = 0; i < 200; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer2.getConstSpan(c);
+            const auto actual = buffer1.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+        const size_t memory = filePool.getStreamingMemory();
+        REQUIRE(memory <= maxMemory);
+        peakMemory = std::max(peakMemory, memory);
+    }
+    REQUIRE(peakMemory > 0);
+}
+
+TEST_CASE("[Files] Bounded streams keep the loop resident")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=loop_continuous
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.enableFreeWheeling();
+    synth2.enableFreeWheeling();
+    synth1.setPreloadSize(256);
+    synth1.setStreamingWindow(32768);
+    synth2.setPreloadSize(200000);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/streaming.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/streaming.sfz", sfzText);
+
+    sfz::AudioBuffer<float> buffer1 { 2, 1024 };
+    sfz::AudioBuffer<float> buffer2 { 2, 1024 };
+    synth1.noteOn(0, 60, 100);
+    synth2.noteOn(0, 60, 100);
+    for (unsigned i = 0; i < 400; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer2.getConstSpan(c);
+            const auto actual = buffer1.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+    REQUIRE(synth1.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("[Files] Memory budget")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=no_loop
+        <region> key=62 sample=kick.wav
+        <region> key=64 sample=snare.wav
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.enableFreeWheeling();
+    synth2.enableFreeWheeling();
+    synth1.setPreloadSize(200000);
+    synth2.setPreloadSize(200000);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/budget.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/budget.sfz", sfzText);
+
+    const size_t fullUsage = synth2.getMemoryUsage();
+    REQUIRE(fullUsage > 0);
+    REQUIRE(synth2.getMemoryBudget() == 0);
+
+    // The preloaded data shrinks, but the files play the same
+    synth2.setMemoryBudget(fullUsage / 2);
+    REQUIRE(synth2.getMemoryBudget() == fullUsage / 2);
+    REQUIRE(synth2.getMemoryUsage() <= fullUsage / 2);
+
+    sfz::AudioBuffer<float> buffer1 { 2, 1024 };
+    sfz::AudioBuffer<float> buffer2 { 2, 1024 };
+    for (int key : { 60, 62, 64 }) {
+        synth1.noteOn(0, key, 100);
+        synth2.noteOn(0, key, 100);
+    }
+    for (unsigned i = 0; i < 400; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer1.getConstSpan(c);
+            const auto actual = buffer2.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+    REQUIRE(synth2.getNumActiveVoices() == 0);
+
+    // The streamed data of the idle files is freed while rendering
+    REQUIRE(synth2.getMemoryUsage() > fullUsage / 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * sfz::config::memoryBudgetPeriod));
+    synth2.renderBlock(buffer2);
+    REQUIRE(synth2.getMemoryUsage() <= fullUsage / 2);
+
+    // Without a budget, nothing shrinks
+    synth2.setMemoryBudget(0);
+    synth2.setPreloadSize(200001);
+    REQUIRE(synth2.getMemoryUsage() == fullUsage);
+}
+
+TEST_CASE("[Files] Release samples are streamed at note-on when prewarming")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=*sine
+        <region> key=60 sample=looped_flute.wav trigger=release
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.enableFreeWheeling();
+    synth2.enableFreeWheeling();
+    synth1.setPreloadSize(256);
+    synth2.setPreloadSize(256);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/prewarm.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/prewarm.sfz", sfzText);
+    REQUIRE(!synth1.isReleasePrewarmingEnabled());
+    synth1.enableReleasePrewarming(true);
+    REQUIRE(synth1.isReleasePrewarmingEnabled());
+
+    const size_t preloadedUsage = synth1.getMemoryUsage();
+    REQUIRE(synth2.getMemoryUsage() == preloadedUsage);
+
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    synth1.noteOn(0, 60, 100);
+    synth2.noteOn(0, 60, 100);
+    synth1.renderBlock(buffer);
+    synth2.renderBlock(buffer);
+    REQUIRE(synth1.getMemoryUsage() > preloadedUsage);
+    REQUIRE(synth2.getMemoryUsage() == preloadedUsage);
+}
+
+TEST_CASE("[Files] Lazy preloading of the keyswitched articulations")
+{
+    const std::string sfzText = R"(
+        <global> sw_lokey=24 sw_hikey=26 sw_default=24
+        <region> key=60 sw_last=24 sample=kick.wav
+        <region> key=60 sw_last=25 sample=snare.wav
+        <region> key=60 sw_last=26 sample=closedhat.wav
+    )";
+    sfz::Synth synth;
+    synth.enableLazyKeyswitchPreloading(true);
+    synth.setEagerKeyswitch(26, true);
+    REQUIRE(synth.isLazyKeyswitchPreloadingEnabled());
+    REQUIRE(synth.isEagerKeyswitch(26));
+    REQUIRE(!synth.isEagerKeyswitch(25));
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/lazy.sfz", sfzText);
+
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    REQUIRE(synth.getNumPreloadedSamples() == 3);
+    REQUIRE(!filePool.isPreloadDeferred(sfz::FileId { "kick.wav" }));
+    REQUIRE(filePool.isPreloadDeferred(sfz::FileId { "snare.wav" }));
+    REQUIRE(!filePool.isPreloadDeferred(sfz::FileId { "closedhat.wav" }));
+
+    // Selecting the keyswitch loads the articulation in the background
+    synth.noteOn(0, 25, 100);
+    for (int i = 0; i < 1000 && filePool.isPreloadDeferred(sfz::FileId { "snare.wav" }); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(!filePool.isPreloadDeferred(sfz::FileId { "snare.wav" }));
+
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    // Without the lazy mode, all the articulations are preloaded
+    synth.enableLazyKeyswitchPreloading(false);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/lazy.sfz", sfzText);
+    REQUIRE(!synth.getResources().getFilePool().isPreloadDeferred(sfz::FileId { "snare.wav" }));
+}
+
+TEST_CASE("[Files] Streaming stats")
+{
+    sfz::Synth synth;
+    synth.enableFreeWheeling();
+    synth.setPreloadSize(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/streaming_stats.sfz", R"(
+        <region> key=60 sample=kick.wav
+    )");
+    auto stats = synth.getStreamingStats();
+    REQUIRE(stats.streamedBytes == 0);
+    REQUIRE(stats.numStreams == 0);
+    REQUIRE(stats.numWorkers > 0);
+
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    synth.noteOn(0, 60, 100);
+    for (unsigned i = 0; i < 10; ++i)
+        synth.renderBlock(buffer);
+    // The slice is counted once over, which may follow its frames
+    for (unsigned i = 0; i < 1000 && synth.getStreamingStats().numStreams == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    stats = synth.getStreamingStats();
+    REQUIRE(stats.streamedBytes > 0);
+    REQUIRE(stats.streamedBytes % (2 * sizeof(float)) == 0);
+    REQUIRE(stats.numStreams == 1);
+    REQUIRE(stats.maxFirstSliceLatency >= 0.0);
+    REQUIRE(stats.totalFirstSliceLatency == stats.maxFirstSliceLatency);
+    REQUIRE(stats.workersBusyTime >= 0.0);
+    REQUIRE(stats.workersElapsedTime > 0.0);
+}
+
+TEST_CASE("[Files] Adaptive preloading")
+{
+    sfz::Synth synth;
+    synth.setPreloadSize(8192);
+    synth.enableAdaptivePreloading(true);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/adaptive_preload.sfz", R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=no_loop bend_up=0
+    )");
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    auto preloadedFrames = [&]() {
+        return filePool.getFilePromise(synth.getRegionView(0)->sampleId)->getNumPreloadedFrames();
+    };
+
+    // The preload size applies until enough latencies are measured; the
+    // region without pitch bend reads its preload at the speed of the file
+    REQUIRE(synth.getStreamingLatency(0.99) == 0.0);
+    REQUIRE(!synth.updateAdaptivePreloading());
+    REQUIRE(preloadedFrames() == 8192);
+
+    // 200 ms rounds up to 204.8 ms, which the heads cover twice
+    for (unsigned i = 0; i < sfz::config::adaptivePreloadMinMeasures; ++i)
+        filePool.recordStreamingLatency(200000000);
+    REQUIRE(synth.getStreamingLatency(0.99) == Approx(0.2048));
+    REQUIRE(synth.updateAdaptivePreloading());
+    REQUIRE(filePool.getAdaptiveLatency() == Approx(0.4096));
+    REQUIRE(preloadedFrames() == static_cast<size_t>(std::ceil(0.4096 * 44100)));
+
+    // The small changes keep the heads
+    for (unsigned i = 0; i < 4 * sfz::config::adaptivePreloadMinMeasures; ++i)
+        filePool.recordStreamingLatency(150000000);
+    REQUIRE(!synth.updateAdaptivePreloading());
+
+    // The faster storage shrinks them, down to the least preload
+    for (unsigned i = 0; i < 500 * sfz::config::adaptivePreloadMinMeasures; ++i)
+        filePool.recordStreamingLatency(1000000);
+    REQUIRE(synth.updateAdaptivePreloading());
+    REQUIRE(preloadedFrames() == sfz::config::minPreloadSize);
+
+    // The loads keep the adaptive heads
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/adaptive_preload.sfz", R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=no_loop bend_up=0
+    )");
+    REQUIRE(preloadedFrames() == sfz::config::minPreloadSize);
+
+    synth.enableAdaptivePreloading(false);
+    REQUIRE(preloadedFrames() == 8192);
+}
+
+TEST_CASE("[Files] Streaming underruns")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_underrun_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    fs::copy_file(fs::current_path() / "tests/TestFiles/kick.wav", directory / "kick.wav");
+
+    sfz::Synth synth;
+    synth.enableFreeWheeling();
+    synth.setPreloadSize(256);
+    synth.loadSfzString(directory / "underrun.sfz", R"(
+        <region> key=60 sample=kick.wav
+        <region> key=62 sample=kick.wav
+    )");
+    REQUIRE(synth.getUnderrunStats().numUnderruns == 0);
+    REQUIRE(synth.getUnderrunStats().lastRegion == -1);
+
+    // The file cannot stream anymore, so the voice only has the preloaded frames
+    fs::remove(directory / "kick.wav");
+    sfz::AudioBuffer<float> buffer { 2, 100 };
+    synth.noteOn(0, 62, 100);
+    for (unsigned i = 0; i < 10; ++i)
+        synth.renderBlock(buffer);
+
+    const auto stats = synth.getUnderrunStats();
+    REQUIRE(stats.numUnderruns == 1);
+    REQUIRE(stats.numMissingFrames > 0);
+    REQUIRE(stats.numMissingFrames < 100);
+    REQUIRE(stats.lastRegion == 1);
+
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.dispatchMessage(client, 0, "/underruns/count", "", nullptr);
+    synth.dispatchMessage(client, 0, "/underruns/missing_frames", "", nullptr);
+    synth.dispatchMessage(client, 0, "/underruns/last_region", "", nullptr);
+    std::vector<std::string> expected {
+        "/underruns/count,h : { 1 }",
+        "/underruns/missing_frames,h : { " + std::to_string(stats.numMissingFrames) + " }",
+        "/underruns/last_region,i : { 1 }",
+    };
+    REQUIRE(messageList == expected);
+
+    synth.resetUnderrunStats();
+    REQUIRE(synth.getUnderrunStats().numUnderruns == 0);
+    REQUIRE(synth.getUnderrunStats().numMissingFrames == 0);
+    REQUIRE(synth.getUnderrunStats().lastRegion == -1);
+    fs::remove_all(directory);
+}
+
+TEST_CASE("[Files] Asynchronous streaming")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=no_loop
+        <region> key=62 sample=stereo_sample.wav loop_mode=no_loop
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.setPreloadSize(1024);
+    synth2.setPreloadSize(200000);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/async.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/async.sfz", sfzText);
+
+    const sfz::FilePool& filePool = synth1.getResources().getFilePool();
+    if (!filePool.isAsyncStreaming())
+        return;
+
+    sfz::AudioBuffer<float> buffer1 { 2, 256 };
+    sfz::AudioBuffer<float> buffer2 { 2, 256 };
+    for (int key : { 60, 62 }) {
+        synth1.noteOn(0, key, 100);
+        synth2.noteOn(0, key, 100);
+    }
+    synth1.renderBlock(buffer1);
+    synth2.renderBlock(buffer2);
+
+    // Wait for the files to be streamed, in slices after the first ones
+    const uint64_t numSlices = 186582 / sfz::config::streamSliceSize + 95304 / sfz::config::streamSliceSize;
+    for (unsigned i = 0; i < 500 && filePool.getNumAsyncReads() < numSlices; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(filePool.getNumAsyncReads() >= numSlices);
+
+    for (unsigned i = 0; i < 800; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer2.getConstSpan(c);
+            const auto actual = buffer1.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+    REQUIRE(synth1.getUnderrunStats().numUnderruns == 0);
+}
+
+TEST_CASE("[Files] Streaming through a reader factory")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav loop_mode=no_loop
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.setPreloadSize(1024);
+    synth2.setPreloadSize(200000);
+
+    std::atomic<int> numReaders { 0 };
+    sfz::FilePool& filePool = synth1.getResources().getFilePool();
+    filePool.setStreamReaderFactory([&numReaders](const fs::path& path, bool reverse, std::error_code* ec) {
+        ++numReaders;
+        return sfz::createAudioReader(path, reverse, ec);
+    });
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/factory.sfz", sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/factory.sfz", sfzText);
+
+    sfz::AudioBuffer<float> buffer1 { 2, 256 };
+    sfz::AudioBuffer<float> buffer2 { 2, 256 };
+    synth1.noteOn(0, 60, 100);
+    synth2.noteOn(0, 60, 100);
+    synth1.renderBlock(buffer1);
+    synth2.renderBlock(buffer2);
+    filePool.waitForBackgroundLoading();
+    REQUIRE(numReaders == 1);
+
+    for (unsigned i = 0; i < 100; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer2.getConstSpan(c);
+            const auto actual = buffer1.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+    filePool.setStreamReaderFactory({});
+}
+
+TEST_CASE("[Files] Sustained loops stream up to their end")
+{
+    sfz::Synth synth;
+    synth.setPreloadSize(1024);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/stream_limit.sfz", R"(
+        <region> key=60 sample=kick.wav loop_mode=loop_sustain loop_start=2000 loop_end=4000
+    )");
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    const auto sampleId = synth.getRegionView(0)->sampleId;
+
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    filePool.waitForBackgroundLoading();
+    size_t availableFrames = filePool.getFilePromise(sampleId)->availableFrames;
+    REQUIRE(availableFrames > 4000);
+    REQUIRE(availableFrames < 44012);
+
+    // The release leaves the loop, so the rest streams
+    synth.noteOff(0, 60, 0);
+    synth.renderBlock(buffer);
+    filePool.waitForBackgroundLoading();
+    availableFrames = filePool.getFilePromise(sampleId)->availableFrames;
+    REQUIRE(availableFrames == 44012);
+}
+
+TEST_CASE("[Files] Immediate release of the streamed data")
+{
+    auto getStreamedMemory = [](bool immediate) {
+        sfz::Synth synth;
+        synth.setPreloadSize(1024);
+        synth.enableImmediateRelease(immediate);
+        REQUIRE(synth.isImmediateReleaseEnabled() == immediate);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/immediate_release.sfz", R"(
+            <region> key=60 sample=kick.wav
+        )");
+        sfz::FilePool& filePool = synth.getResources().getFilePool();
+
+        sfz::AudioBuffer<float> buffer { 2, 256 };
+        synth.noteOn(0, 60, 100);
+        synth.renderBlock(buffer);
+        filePool.waitForBackgroundLoading();
+        REQUIRE(filePool.getStreamedMemory() > 0);
+        for (int i = 0; i < 1000 && synth.getNumActiveVoices() > 0; ++i)
+            synth.renderBlock(buffer);
+        REQUIRE(synth.getNumActiveVoices() == 0);
+        synth.renderBlock(buffer);
+        return filePool.getStreamedMemory();
+    };
+
+    REQUIRE(getStreamedMemory(false) > 0);
+    REQUIRE(getStreamedMemory(true) == 0);
+}
+
+TEST_CASE("[Files] Oversampled files")
+{
+    sfz::Synth synth;
+    REQUIRE(synth.getOversamplingFactor() == 1);
+    REQUIRE(!synth.setOversamplingFactor(3));
+    REQUIRE(synth.setOversamplingFactor(2));
+    REQUIRE(synth.getOversamplingFactor() == 2);
+    synth.setPreloadSize(1024);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/oversampling.sfz", R"(
+        <region> key=60 sample=kick.wav
+    )");
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    const auto sampleId = synth.getRegionView(0)->sampleId;
+    const sfz::FileInformation information = filePool.getFilePromise(sampleId)->information;
+    REQUIRE(information.sampleRate == 88200.0);
+    REQUIRE(information.end + 1 == 2 * 44012);
+
+    // The oversampled frames stream in the background
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    filePool.waitForBackgroundLoading();
+    REQUIRE(filePool.getFilePromise(sampleId)->availableFrames == 2 * 44012);
+
+    // Back to the rate of the file
+    REQUIRE(synth.setOversamplingFactor(1));
+    REQUIRE(filePool.getFilePromise(sampleId)->information.end + 1 == 44012);
+}
+
+TEST_CASE("[Files] Preload size follows the playback speed")
+{
+    auto getUsage = [](const std::string& regionText) {
+        sfz::Synth synth;
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/preload_ratio.sfz",
+            "<region> sample=looped_flute.wav pitch_keycenter=60 bend_up=0 " + regionText);
+        return synth.getMemoryUsage();
+    };
+
+    const size_t atRoot = getUsage("key=60");
+    REQUIRE(atRoot > 0);
+    REQUIRE(getUsage("lokey=36 hikey=48") == atRoot / 2);
+    REQUIRE(getUsage("lokey=48 hikey=60") == atRoot);
+    REQUIRE(getUsage("lokey=60 hikey=84") == atRoot * 4);
+    REQUIRE(getUsage("key=60 transpose=12") == atRoot * 2);
+    REQUIRE(getUsage("key=60 bend_up=1200") == atRoot * 2);
+    REQUIRE(getUsage("lokey=48 hikey=84 pitch_keytrack=0") == atRoot);
+    REQUIRE(getUsage("lokey=48 hikey=84 pitch_keytrack=-100") == atRoot * 2);
+
+    // The ratio of a file is the highest of its regions
+    REQUIRE(getUsage("key=60 <region> sample=looped_flute.wav key=72 pitch_keycenter=60 bend_up=0") == atRoot * 2);
+}
+
+TEST_CASE("[Files] Asynchronous loading")
+{
+    sfz::Synth synth;
+    std::atomic<int> numCallbacks { 0 };
+    auto load = synth.loadSfzFileAsync(fs::current_path() / "tests/TestFiles/kick.sfz",
+        [&numCallbacks](const sfz::Synth::LoadProgress&) { ++numCallbacks; });
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    while (!load->isDone())
+        synth.renderBlock(buffer);
+    REQUIRE(load->wait());
+    REQUIRE(numCallbacks > 0);
+    REQUIRE(synth.getNumRegions() == 1);
+    REQUIRE(synth.getNumPreloadedSamples() == 1);
+
+    const auto progress = load->getProgress();
+    REQUIRE(progress.numRegions == 1);
+    REQUIRE(progress.numFilesToPreload == 1);
+    REQUIRE(progress.numPreloadedFiles == 1);
+    REQUIRE(progress.numBytesRead >= synth.getPreloadSize() * sizeof(float));
+
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("[Files] Rendering during an asynchronous load")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(fs::current_path() / "tests/TestFiles/kick.sfz");
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+
+    auto load = synth.loadSfzFileAsync(fs::current_path() / "tests/TestFiles/newdrums_flat.sfz");
+    while (!load->isDone()) {
+        synth.noteOn(0, 60, 100);
+        synth.cc(0, 64, 127);
+        synth.renderBlock(buffer);
+    }
+    REQUIRE(load->wait());
+    REQUIRE(synth.getNumRegions() > 1);
+}
+
+TEST_CASE("[Files] Canceling an asynchronous load")
+{
+    sfz::Synth synth;
+    std::promise<void> canceled;
+    std::shared_future<void> waitCanceled = canceled.get_future().share();
+    auto load = synth.loadSfzFileAsync(fs::current_path() / "tests/TestFiles/newdrums_flat.sfz",
+        [waitCanceled](const sfz::Synth::LoadProgress&) { waitCanceled.wait(); });
+    load->cancel();
+    canceled.set_value();
+    REQUIRE(!load->wait());
+    REQUIRE(synth.getNumRegions() == 0);
+    REQUIRE(synth.getNumPreloadedSamples() == 0);
+
+    // the synth loads normally afterwards
+    REQUIRE(synth.loadSfzFile(fs::current_path() / "tests/TestFiles/newdrums_flat.sfz"));
+    REQUIRE(synth.getNumRegions() > 1);
+}
+
+TEST_CASE("[Files] The current instrument plays during an asynchronous load")
+{
+    sfz::Synth synth;
+    synth.setSampleRate(48000.0f);
+    synth.setSamplesPerBlock(128);
+    synth.setNumVoices(32);
+    synth.setVolume(-6.0f);
+    synth.loadSfzFile(fs::current_path() / "tests/TestFiles/kick.sfz");
+    synth.hdcc(0, 20, 0.25f);
+    sfz::AudioBuffer<float> buffer { 2, 128 };
+
+    std::promise<void> resumed;
+    std::shared_future<void> waitResumed = resumed.get_future().share();
+    auto load = synth.loadSfzFileAsync(fs::current_path() / "tests/TestFiles/newdrums_flat.sfz",
+        [waitResumed](const sfz::Synth::LoadProgress&) { waitResumed.wait(); });
+
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumRegions() == 1);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+    REQUIRE(!load->isDone());
+
+    resumed.set_value();
+    while (!load->isDone())
+        synth.renderBlock(buffer);
+    REQUIRE(load->wait());
+    REQUIRE(synth.getNumRegions() > 1);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    REQUIRE(synth.getSamplesPerBlock() == 128);
+    REQUIRE(synth.getNumVoices() == 32);
+    REQUIRE(synth.getVolume() == -6.0f);
+    REQUIRE(synth.getHdcc(20) == 0.25f);
+}
+
+TEST_CASE("[Files] Canceling an asynchronous load before the swap")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(fs::current_path() / "tests/TestFiles/kick.sfz");
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+
+    std::atomic<bool> built { false };
+    auto load = synth.loadSfzFileAsync(fs::current_path() / "tests/TestFiles/newdrums_flat.sfz",
+        [&built](const sfz::Synth::LoadProgress& progress) {
+            if (progress.numFilesToPreload > 0 && progress.numPreloadedFiles == progress.numFilesToPreload)
+                built = true;
+        });
+    while (!built)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // without rendering, the new instrument never takes the place of the current one
+    load->cancel();
+    REQUIRE(!load->wait());
+    REQUIRE(synth.getNumRegions() == 1);
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumRegions() == 1);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("[Files] Regions resolve the data of their sample at load")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/file_slots.sfz", R"(
+        <region> key=60 sample=kick.wav
+        <region> key=61 sample=snare.wav
+    )");
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    const sfz::Region* kick = synth.getRegionView(0);
+    REQUIRE(kick->sampleSlot.data != nullptr);
+    const sfz::FileSlot resolved = kick->sampleSlot;
+
+    REQUIRE(kick->sampleSlot.id != nullptr);
+    REQUIRE(*kick->sampleSlot.id == *kick->sampleId);
+
+    {
+        auto promise = filePool.getFilePromise(kick->sampleId, kick->sampleSlot);
+        REQUIRE(promise);
+        REQUIRE(&promise->information == &resolved.data->information);
+        REQUIRE(kick->sampleSlot.generation == resolved.generation);
+        auto other = filePool.getFilePromise(kick->sampleId, kick->sampleSlot);
+        REQUIRE(resolved.data->readerCount == 2);
+        other.reset();
+        REQUIRE(resolved.data->readerCount == 1);
+    }
+    REQUIRE(resolved.data->readerCount == 0);
+
+    // A slot of an older generation of files resolves again
+    sfz::FileSlot slot;
+    slot.generation = resolved.generation - 1;
+    auto promise = filePool.getFilePromise(synth.getRegionView(1)->sampleId, slot);
+    REQUIRE(promise);
+    REQUIRE(slot.data != resolved.data);
+    REQUIRE(slot.generation == resolved.generation);
+    REQUIRE(&promise->information == &slot.data->information);
+}
+
+TEST_CASE("[Files] Sparse preloading of the offsets")
+{
+    sfz::Synth sparse;
+    sparse.loadSfzString(fs::current_path() / "tests/TestFiles/sparse_preload.sfz",
+        "<region> key=60 sample=looped_flute.wav offset=100000");
+    sfz::Synth contiguous;
+    contiguous.loadSfzString(fs::current_path() / "tests/TestFiles/sparse_preload.sfz",
+        "<region> key=60 sample=looped_flute.wav offset_random=100000");
+    REQUIRE(sparse.getMemoryUsage() * 4 < contiguous.getMemoryUsage());
+
+    const sfz::Region* sparseRegion = sparse.getRegionView(0);
+    const sfz::Region* contiguousRegion = contiguous.getRegionView(0);
+    // Held without a request to stream, so that the data stays the preloaded one
+    sfz::FileSlot sparseSlot;
+    sfz::FileSlot contiguousSlot;
+    sparse.getResources().getFilePool().resolveFile(*sparseRegion->sampleId, sparseSlot);
+    contiguous.getResources().getFilePool().resolveFile(*contiguousRegion->sampleId, contiguousSlot);
+    sfz::FileDataHolder sparsePromise { sparseSlot.data };
+    sfz::FileDataHolder contiguousPromise { contiguousSlot.data };
+    REQUIRE(sparsePromise);
+    REQUIRE(contiguousPromise);
+    REQUIRE(sparsePromise->preloadSegments.size() == 2);
+    REQUIRE(contiguousPromise->preloadSegments.empty());
+    REQUIRE(sparsePromise->getNumPreloadedFrames() == contiguousPromise->getNumPreloadedFrames());
+
+    // The frames between the segments start at the segment below
+    REQUIRE(sparsePromise.startAt(50000) == 0);
+    REQUIRE(sparsePromise.getData().getNumFrames() < 50000);
+
+    REQUIRE(sparsePromise.startAt(100000) == 100000);
+    const auto sparseData = sparsePromise.getData();
+    const auto contiguousData = contiguousPromise.getData();
+    REQUIRE(sparseData.getNumFrames() == contiguousData.getNumFrames());
+    for (size_t c = 0; c < sparseData.getNumChannels(); ++c) {
+        const auto sparseFrames = sparseData.getConstSpan(c);
+        const auto contiguousFrames = contiguousData.getConstSpan(c);
+        REQUIRE(std::equal(sparseFrames.begin(), sparseFrames.begin() + sparse.getPreloadSize(), contiguousFrames.begin()));
+        REQUIRE(std::equal(sparseFrames.begin() + 100000, sparseFrames.end(), contiguousFrames.begin() + 100000));
+    }
+}
+
+TEST_CASE("[Files] Deduplication of the files with identical contents")
+{
+    // kick.wav and snare.wav have the same bytes
+    const std::string regions = R"(
+        <region> key=60 sample=kick.wav
+        <region> key=61 sample=snare.wav
+        <region> key=62 sample=looped_flute.wav
+    )";
+
+    sfz::Synth separate;
+    separate.loadSfzString(fs::current_path() / "tests/TestFiles/deduplication.sfz", regions);
+    REQUIRE(separate.getResources().getFilePool().getNumPreloadedSamples() == 3);
+
+    sfz::Synth deduplicated;
+    deduplicated.setSamplesPerBlock(256);
+    deduplicated.loadSfzString(fs::current_path() / "tests/TestFiles/deduplication.sfz",
+        "<control> hint_deduplicate_samples=1" + regions);
+    sfz::FilePool& filePool = deduplicated.getResources().getFilePool();
+    REQUIRE(filePool.getNumPreloadedSamples() == 2);
+    REQUIRE(filePool.getNumDeduplicatedFiles() == 1);
+    REQUIRE(deduplicated.getMemoryUsage() < separate.getMemoryUsage());
+
+    // The regions keep their sample, and play the same data
+    const sfz::Region* kick = deduplicated.getRegionView(0);
+    const sfz::Region* snare = deduplicated.getRegionView(1);
+    REQUIRE(snare->sampleId->filename() == "snare.wav");
+    REQUIRE(kick->sampleSlot.data != nullptr);
+    REQUIRE(kick->sampleSlot.data == snare->sampleSlot.data);
+    REQUIRE(deduplicated.getRegionView(2)->sampleSlot.data != kick->sampleSlot.data);
+
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    deduplicated.noteOn(0, 61, 85);
+    deduplicated.renderBlock(buffer);
+    REQUIRE(deduplicated.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("[Files] Reversed samples held whole share the forward data")
+{
+    sfz::Synth synth;
+    synth.setPreloadSize(65536);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/mirrored.sfz", R"(
+        <region> key=60 sample=kick.wav
+        <region> key=61 sample=kick.wav direction=reverse
+    )");
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    REQUIRE(filePool.getNumPreloadedSamples() == 1);
+
+    const sfz::Region* forward = synth.getRegionView(0);
+    const sfz::Region* reverse = synth.getRegionView(1);
+    REQUIRE(reverse->sampleId->isReverse());
+    REQUIRE(reverse->sampleSlot.data != nullptr);
+    REQUIRE(reverse->sampleSlot.data == forward->sampleSlot.data);
+    REQUIRE(reverse->sampleSlot.mirrored);
+    REQUIRE(!forward->sampleSlot.mirrored);
+
+    auto promise = filePool.getFilePromise(reverse->sampleId, reverse->sampleSlot);
+    REQUIRE(promise);
+    REQUIRE(promise.isMirrored());
+}
+
+TEST_CASE("[Files] Mirrored reversed samples match the reversed data")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=looped_flute.wav direction=reverse
+        <region> lokey=62 hikey=64 pitch_keycenter=62 sample=stereo_sample.wav direction=reverse
+    )";
+    // The small preloads stream the reversed data, the large ones mirror the
+    // forward data
+    sfz::Synth streamed;
+    sfz::Synth mirrored;
+    streamed.enableFreeWheeling();
+    mirrored.enableFreeWheeling();
+    streamed.setPreloadSize(256);
+    mirrored.setPreloadSize(200000);
+    streamed.loadSfzString(fs::current_path() / "tests/TestFiles/mirrored.sfz", sfzText);
+    mirrored.loadSfzString(fs::current_path() / "tests/TestFiles/mirrored.sfz", sfzText);
+    REQUIRE(!streamed.getRegionView(0)->sampleSlot.mirrored);
+    REQUIRE(mirrored.getRegionView(0)->sampleSlot.mirrored);
+
+    sfz::AudioBuffer<float> streamedBuffer { 2, 1024 };
+    sfz::AudioBuffer<float> mirroredBuffer { 2, 1024 };
+    for (int key : { 60, 63 }) {
+        streamed.noteOn(0, key, 100);
+        mirrored.noteOn(0, key, 100);
+    }
+
+    for (unsigned i = 0; i < 100; ++i) {
+        streamed.renderBlock(streamedBuffer);
+        mirrored.renderBlock(mirroredBuffer);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = streamedBuffer.getConstSpan(c);
+            const auto actual = mirroredBuffer.getConstSpan(c);
+            REQUIRE(approxEqual(actual, expected, 1e-4f));
+        }
+    }
+    REQUIRE(streamed.getUnderrunStats().numUnderruns == 0);
+}
+
+TEST_CASE("[Files] Envelopes of the samples")
+{
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/envelopes.sfz";
+    const std::string sfzText = "<region> key=60 sample=36-CajonCenter-3.wav";
+    std::vector<float> rms;
+    std::vector<float> peak;
+
+    // The preload measures the head of the sample
+    sfz::FilePool::clearFileInformationCache();
+    sfz::Synth streamed;
+    streamed.enableFreeWheeling();
+    streamed.setSamplesPerBlock(1024);
+    streamed.setPreloadSize(1024);
+    streamed.loadSfzString(sfzPath, sfzText);
+    const size_t numWindows = streamed.getSampleEnvelope("36-CajonCenter-3.wav", false, rms, peak);
+    REQUIRE(numWindows == (44113 + sfz::config::sampleEnvelopeResolution - 1) / sfz::config::sampleEnvelopeResolution);
+    REQUIRE(rms.size() >= 2);
+    REQUIRE(rms.size() < numWindows);
+    REQUIRE(peak.size() == rms.size());
+
+    // A whole preload measures the whole sample
+    sfz::FilePool::clearFileInformationCache();
+    sfz::Synth preloaded;
+    preloaded.setPreloadSize(200000);
+    preloaded.loadSfzString(sfzPath, sfzText);
+    std::vector<float> expectedRms;
+    std::vector<float> expectedPeak;
+    REQUIRE(preloaded.getSampleEnvelope("36-CajonCenter-3.wav", false, expectedRms, expectedPeak) == numWindows);
+    REQUIRE(expectedRms.size() == numWindows);
+    REQUIRE(std::any_of(expectedRms.begin(), expectedRms.end(), [](float x) { return x > 0.0f; }));
+    for (size_t i = 0; i < numWindows; ++i) {
+        REQUIRE(expectedRms[i] <= expectedPeak[i]);
+        REQUIRE(expectedPeak[i] <= 1.0f);
+    }
+    REQUIRE(preloaded.getSampleEnvelope("36-CajonCenter-3.wav", true, rms, peak) == 0);
+    REQUIRE(rms.empty());
+
+    // The stream measures the rest, which the voices read
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    streamed.noteOn(0, 60, 100);
+    streamed.renderBlock(buffer);
+    float voiceRms = 0.0f;
+    float voicePeak = 0.0f;
+    const auto voices = getPlayingVoices(streamed);
+    REQUIRE(voices.size() == 1);
+    REQUIRE(voices[0]->getSourceEnvelope(voiceRms, voicePeak));
+    REQUIRE(voiceRms <= voicePeak);
+    for (unsigned i = 0; i < 50; ++i)
+        streamed.renderBlock(buffer);
+    REQUIRE(streamed.getSampleEnvelope("36-CajonCenter-3.wav", false, rms, peak) == numWindows);
+    REQUIRE(rms == expectedRms);
+    REQUIRE(peak == expectedPeak);
+
+    sfz::FilePool::clearFileInformationCache();
+}
+
+TEST_CASE("[Files] Usage profiles guide the preloads")
+{
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/usage_profile.sfz";
+    const std::string sfzText = R"(
+        <region> key=60 sample=36-CajonCenter-3.wav
+        <region> key=62 sample=36-CajonCenter-4.wav
+    )";
+    const fs::path profilePath = fs::temp_directory_path() / "sfizz_usage_profile_test.sfzusage";
+    std::error_code ec;
+    fs::remove(profilePath, ec);
+
+    // The session records the sample which plays, and how far; it ends
+    // before the next load, which would share its preloads otherwise
+    {
+        sfz::Synth session;
+        session.enableFreeWheeling();
+        session.setSamplesPerBlock(1024);
+        session.setPreloadSize(1024);
+        REQUIRE(!session.loadUsageProfile(profilePath));
+        session.loadSfzString(sfzPath, sfzText);
+        sfz::AudioBuffer<float> buffer { 2, 1024 };
+        session.noteOn(0, 60, 100);
+        for (unsigned i = 0; i < 20; ++i)
+            session.renderBlock(buffer);
+        REQUIRE(session.saveUsageProfile(profilePath));
+    }
+
+    sfz::UsageProfile profile;
+    REQUIRE(profile.load(profilePath));
+    REQUIRE(profile.size() == 1);
+    const sfz::FileUsage* usage = profile.find(sfz::FileId { "36-CajonCenter-3.wav" });
+    REQUIRE(usage);
+    REQUIRE(usage->numPlays == 1);
+    REQUIRE(usage->playedFrames > 16 * 1024);
+    REQUIRE(!profile.find(sfz::FileId { "36-CajonCenter-4.wav" }));
+
+    // The next load preloads the played sample further, and the other less
+    sfz::Synth synth;
+    synth.setPreloadSize(1024);
+    REQUIRE(synth.loadUsageProfile(profilePath));
+    synth.loadSfzString(sfzPath, sfzText);
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    const size_t hotFrames = filePool.getFilePromise(synth.getRegionView(0)->sampleId)->getNumPreloadedFrames();
+    const size_t coldFrames = filePool.getFilePromise(synth.getRegionView(1)->sampleId)->getNumPreloadedFrames();
+    REQUIRE(hotFrames > 4 * 1024);
+    REQUIRE(coldFrames < 1024);
+
+    // The profile accumulates over the sessions
+    REQUIRE(synth.saveUsageProfile(profilePath));
+    REQUIRE(profile.load(profilePath));
+    REQUIRE(profile.find(sfz::FileId { "36-CajonCenter-3.wav" })->numPlays == 2);
+    REQUIRE(profile.find(sfz::FileId { "36-CajonCenter-4.wav" })->numPlays == 1);
+
+    fs::remove(profilePath, ec);
+}
+
+TEST_CASE("[Files] Streamed files are kept open for the read ahead")
+{
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/readahead.sfz";
+    sfz::Synth synth;
+    synth.setPreloadSize(1024);
+    synth.loadSfzString(sfzPath, R"(
+        <region> key=60 sample=looped_flute.wav
+        <region> key=62 sample=kick.wav
+        <region> key=64 sample=looped_flute.wav direction=reverse
+    )");
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+
+    // The read ahead starts after the preloaded head of the data
+    auto streamed = filePool.getFilePromise(synth.getRegionView(0)->sampleId);
+    REQUIRE(streamed);
+    REQUIRE(!streamed->fullyLoaded);
+    REQUIRE(streamed->readaheadFile);
+    sfz::RawAudioLayout layout;
+    REQUIRE(sfz::getRawAudioLayout(fs::current_path() / "tests/TestFiles/looped_flute.wav", layout));
+    REQUIRE(streamed->readaheadOffset == layout.dataOffset + streamed->getNumPreloadedFrames() * layout.bytesPerFrame());
+    streamed.reset();
+
+    // The reversed files stream after decoding the whole file
+    auto reversed = filePool.getFilePromise(synth.getRegionView(2)->sampleId);
+    REQUIRE(reversed);
+    REQUIRE(!reversed->readaheadFile);
+    reversed.reset();
+
+    // The whole preloads do not stream
+    synth.setPreloadSize(200000);
+    auto whole = filePool.getFilePromise(synth.getRegionView(0)->sampleId);
+    REQUIRE(whole->fullyLoaded);
+    REQUIRE(!whole->readaheadFile);
+}
+
+TEST_CASE("[Files] Streams decode the files kept encoded in memory")
+{
+    const std::string sfzText = R"(
+        <region> key=60 sample=kick.flac
+        <region> key=62 sample=looped_flute.wav
+    )";
+    sfz::Synth synth1;
+    sfz::Synth synth2;
+    synth1.enableFreeWheeling();
+    synth2.enableFreeWheeling();
+    synth1.setPreloadSize(256);
+    synth2.setPreloadSize(200000);
+    synth1.loadSfzString(fs::current_path() / "tests/TestFiles/encoded_in_ram.sfz",
+        "<control> hint_encoded_in_ram=1" + sfzText);
+    synth2.loadSfzString(fs::current_path() / "tests/TestFiles/encoded_in_ram.sfz", sfzText);
+    sfz::FilePool& filePool = synth1.getResources().getFilePool();
+    REQUIRE(filePool.getNumEncodedSamples() == 2);
+
+    auto encoded = filePool.getFilePromise(synth1.getRegionView(0)->sampleId);
+    REQUIRE(encoded);
+    REQUIRE(encoded->encodedData);
+    REQUIRE(encoded->encodedData->size() == fs::file_size(fs::current_path() / "tests/TestFiles/kick.flac"));
+    REQUIRE(!encoded->readaheadFile);
+    encoded.reset();
+
+    sfz::AudioBuffer<float> buffer1 { 2, 1024 };
+    sfz::AudioBuffer<float> buffer2 { 2, 1024 };
+    for (int key : { 60, 62 }) {
+        synth1.noteOn(0, key, 100);
+        synth2.noteOn(0, key, 100);
+    }
+
+    for (unsigned i = 0; i < 200; ++i) {
+        synth1.renderBlock(buffer1);
+        synth2.renderBlock(buffer2);
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto expected = buffer2.getConstSpan(c);
+            const auto actual = buffer1.getConstSpan(c);
+            REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin()));
+        }
+    }
+    REQUIRE(synth1.getUnderrunStats().numUnderruns == 0);
+}
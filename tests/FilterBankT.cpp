@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/FilterBank.h"
+#include "sfizz/SfzFilter.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr double sampleRate { 48000.0 };
+constexpr unsigned numFrames { 1001 };
+
+struct Lanes {
+    explicit Lanes(unsigned numLanes)
+        : inputs(numLanes, std::vector<float>(numFrames)),
+          expected(numLanes, std::vector<float>(numFrames)),
+          outputs(numLanes, std::vector<float>(numFrames)),
+          cutoffs(numLanes, std::vector<float>(numFrames)),
+          resonances(numLanes, std::vector<float>(numFrames))
+    {
+        std::minstd_rand prng;
+        std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+        for (unsigned l = 0; l < numLanes; ++l) {
+            for (unsigned i = 0; i < numFrames; ++i) {
+                inputs[l][i] = dist(prng);
+                cutoffs[l][i] = 200.0f * (l + 1) + 5.0f * i;
+                resonances[l][i] = 6.0f * std::sin(0.01f * i + l);
+            }
+        }
+    }
+
+    std::vector<std::vector<float>> inputs;
+    std::vector<std::vector<float>> expected;
+    std::vector<std::vector<float>> outputs;
+    std::vector<std::vector<float>> cutoffs;
+    std::vector<std::vector<float>> resonances;
+};
+
+void checkLanes(const Lanes& lanes)
+{
+    for (size_t l = 0; l < lanes.outputs.size(); ++l) {
+        INFO("Lane " << l);
+        for (unsigned i = 0; i < numFrames; ++i)
+            REQUIRE(lanes.outputs[l][i] == Approx(lanes.expected[l][i]).margin(1e-4));
+    }
+}
+
+} // namespace
+
+TEST_CASE("[FilterBank] Supported types")
+{
+    REQUIRE(sfz::FilterBank::supports(sfz::kFilterLpf2p));
+    REQUIRE(sfz::FilterBank::supports(sfz::kFilterHpf2p));
+    REQUIRE(sfz::FilterBank::supports(sfz::kFilterBpf2p));
+    REQUIRE(sfz::FilterBank::supports(sfz::kFilterBrf2p));
+    REQUIRE(!sfz::FilterBank::supports(sfz::kFilterNone));
+    REQUIRE(!sfz::FilterBank::supports(sfz::kFilterLpf4p));
+    REQUIRE(!sfz::FilterBank::supports(sfz::kFilterLpf2pSv));
+
+    sfz::FilterBank bank;
+    bank.setType(sfz::kFilterPink);
+    const float input[4] { 1.0f, 2.0f, 3.0f, 4.0f };
+    float output[4] {};
+    const float* in[1] { input };
+    float* out[1] { output };
+    const float cutoff[1] { 1000.0f };
+    const float q[1] { 0.0f };
+    bank.process(in, out, cutoff, q, 1, 4);
+    REQUIRE(std::equal(input, input + 4, output));
+}
+
+TEST_CASE("[FilterBank] Lanes compute like the filters")
+{
+    for (sfz::FilterType type : { sfz::kFilterLpf2p, sfz::kFilterHpf2p, sfz::kFilterBpf2p, sfz::kFilterBrf2p }) {
+        for (unsigned numLanes : { 1u, 3u, 4u, 6u, 8u }) {
+            INFO("Type " << type << ", " << numLanes << " lanes");
+            sfz::FilterBank bank;
+            bank.init(sampleRate);
+            std::vector<std::unique_ptr<sfz::Filter>> filters;
+
+            { // Constant parameters
+                bank.setType(type);
+                filters.clear();
+                Lanes lanes { numLanes };
+                std::vector<float> cutoffs(numLanes);
+                std::vector<float> resonances(numLanes);
+                for (unsigned l = 0; l < numLanes; ++l) {
+                    cutoffs[l] = lanes.cutoffs[l][0];
+                    resonances[l] = lanes.resonances[l][0] + 3.0f;
+                    bank.prepareLane(l, cutoffs[l], resonances[l]);
+
+                    filters.emplace_back(new sfz::Filter);
+                    sfz::Filter& filter = *filters.back();
+                    filter.init(sampleRate);
+                    filter.setType(type);
+                    filter.prepare(cutoffs[l], resonances[l], 0.0f);
+                    const float* in[1] { lanes.inputs[l].data() };
+                    float* out[1] { lanes.expected[l].data() };
+                    filter.process(in, out, cutoffs[l], resonances[l], 0.0f, numFrames);
+                }
+
+                std::vector<const float*> in(numLanes);
+                std::vector<float*> out(numLanes);
+                for (unsigned l = 0; l < numLanes; ++l) {
+                    in[l] = lanes.inputs[l].data();
+                    out[l] = lanes.outputs[l].data();
+                }
+                bank.process(in.data(), out.data(), cutoffs.data(), resonances.data(), numLanes, numFrames);
+                checkLanes(lanes);
+            }
+
+            { // Modulated parameters
+                bank.setType(type);
+                filters.clear();
+                Lanes lanes { numLanes };
+                const std::vector<float> pksh(numFrames, 0.0f);
+                for (unsigned l = 0; l < numLanes; ++l) {
+                    filters.emplace_back(new sfz::Filter);
+                    sfz::Filter& filter = *filters.back();
+                    filter.init(sampleRate);
+                    filter.setType(type);
+                    const float* in[1] { lanes.inputs[l].data() };
+                    float* out[1] { lanes.expected[l].data() };
+                    filter.processModulated(in, out, lanes.cutoffs[l].data(), lanes.resonances[l].data(), pksh.data(), numFrames);
+                }
+
+                // In place, in cycles of whole control intervals, from a cleared memory
+                std::vector<const float*> in(numLanes);
+                std::vector<float*> out(numLanes);
+                std::vector<const float*> cutoffs(numLanes);
+                std::vector<const float*> resonances(numLanes);
+                lanes.outputs = lanes.inputs;
+                unsigned frame = 0;
+                while (frame < numFrames) {
+                    const unsigned current = std::min(numFrames - frame, 160u);
+                    for (unsigned l = 0; l < numLanes; ++l) {
+                        in[l] = lanes.outputs[l].data() + frame;
+                        out[l] = lanes.outputs[l].data() + frame;
+                        cutoffs[l] = lanes.cutoffs[l].data() + frame;
+                        resonances[l] = lanes.resonances[l].data() + frame;
+                    }
+                    bank.processModulated(in.data(), out.data(), cutoffs.data(), resonances.data(), numLanes, current);
+                    frame += current;
+                }
+                checkLanes(lanes);
+            }
+        }
+    }
+}
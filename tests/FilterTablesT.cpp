@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/FilterTables.h"
+#include "sfizz/SfzFilter.h"
+#include "sfizz/Synth.h"
+#include "sfizz/Resources.h"
+#include "sfizz/SynthConfig.h"
+#include "catch2/catch.hpp"
+#include "ghc/fs_std.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr double sampleRate { 48000.0 };
+constexpr unsigned numFrames { 1001 };
+
+const sfz::FilterType rbjTypes[] {
+    sfz::kFilterLpf2p, sfz::kFilterHpf2p, sfz::kFilterBpf2p, sfz::kFilterBrf2p
+};
+
+} // namespace
+
+TEST_CASE("[FilterTables] Supported types")
+{
+    for (sfz::FilterType type : rbjTypes)
+        REQUIRE(sfz::RbjCoefficientTable::supports(type));
+    REQUIRE(!sfz::RbjCoefficientTable::supports(sfz::kFilterNone));
+    REQUIRE(!sfz::RbjCoefficientTable::supports(sfz::kFilterLpf4p));
+    REQUIRE(!sfz::RbjCoefficientTable::supports(sfz::kFilterLpf2pSv));
+    REQUIRE(!sfz::RbjCoefficientTable::supports(sfz::kFilterPeq));
+}
+
+TEST_CASE("[FilterTables] Tables are shared by sample rate")
+{
+    auto table1 = sfz::RbjCoefficientTable::get(sampleRate);
+    auto table2 = sfz::RbjCoefficientTable::get(sampleRate);
+    auto table3 = sfz::RbjCoefficientTable::get(2 * sampleRate);
+    REQUIRE(table1 == table2);
+    REQUIRE(table1 != table3);
+    REQUIRE(table1->sampleRate() == sampleRate);
+    REQUIRE(table3->sampleRate() == 2 * sampleRate);
+}
+
+TEST_CASE("[FilterTables] Interpolated coefficients match the exact ones")
+{
+    const sfz::RbjCoefficientTable table { sampleRate };
+    for (sfz::FilterType type : rbjTypes) {
+        for (float cutoff = 1.0f; cutoff < 25000.0f; cutoff *= 1.037f) {
+            for (float q = -70.0f; q < 70.0f; q += 3.3f) {
+                INFO("Type " << type << ", cutoff " << cutoff << ", resonance " << q);
+                const sfz::BiquadCoefficients t = table.compute(type, cutoff, q);
+                const sfz::BiquadCoefficients e = sfz::RbjCoefficientTable::computeExact(type, sampleRate, cutoff, q);
+                REQUIRE(t.b0 == Approx(e.b0).epsilon(1e-5).margin(1e-7));
+                REQUIRE(t.b1 == Approx(e.b1).epsilon(1e-5).margin(1e-7));
+                REQUIRE(t.b2 == Approx(e.b2).epsilon(1e-5).margin(1e-7));
+                REQUIRE(t.a1 == Approx(e.a1).epsilon(1e-5).margin(1e-7));
+                REQUIRE(t.a2 == Approx(e.a2).epsilon(1e-5).margin(1e-7));
+            }
+        }
+    }
+}
+
+TEST_CASE("[FilterTables] Tabulated filters compute like the faust filters")
+{
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+
+    std::vector<float> inputs[2];
+    std::vector<float> cutoffs(numFrames);
+    std::vector<float> resonances(numFrames);
+    const std::vector<float> pksh(numFrames, 0.0f);
+    for (std::vector<float>& input : inputs) {
+        input.resize(numFrames);
+        for (float& x : input)
+            x = dist(prng);
+    }
+    for (unsigned i = 0; i < numFrames; ++i) {
+        cutoffs[i] = 300.0f + 10.0f * i;
+        resonances[i] = 6.0f * std::sin(0.01f * i);
+    }
+
+    for (sfz::FilterType type : rbjTypes) {
+        for (unsigned channels : { 1u, 2u }) {
+            INFO("Type " << type << ", " << channels << " channels");
+            sfz::Filter filters[2];
+            std::vector<float> outputs[2][2];
+            for (unsigned f = 0; f < 2; ++f) {
+                sfz::Filter& filter = filters[f];
+                filter.init(sampleRate);
+                filter.setType(type);
+                filter.setChannels(channels);
+                filter.setTabulated(f == 1);
+                REQUIRE(filter.tabulated() == (f == 1));
+
+                const float* in[2];
+                float* out[2];
+                for (unsigned c = 0; c < channels; ++c) {
+                    outputs[f][c].resize(numFrames);
+                    in[c] = inputs[c].data();
+                    out[c] = outputs[f][c].data();
+                }
+                filter.prepare(cutoffs[0], resonances[0], 0.0f);
+                filter.processModulated(in, out, cutoffs.data(), resonances.data(), pksh.data(), numFrames);
+            }
+
+            for (unsigned c = 0; c < channels; ++c) {
+                for (unsigned i = 0; i < numFrames; ++i)
+                    REQUIRE(outputs[1][c][i] == Approx(outputs[0][c][i]).margin(1e-5));
+            }
+        }
+    }
+}
+
+TEST_CASE("[FilterTables] Other filters are unaffected")
+{
+    std::vector<float> input(numFrames);
+    std::vector<float> outputs[2];
+    for (unsigned i = 0; i < numFrames; ++i)
+        input[i] = std::sin(0.1f * i);
+
+    for (unsigned f = 0; f < 2; ++f) {
+        sfz::Filter filter;
+        filter.init(sampleRate);
+        filter.setType(sfz::kFilterLpf4p);
+        filter.setTabulated(f == 1);
+        outputs[f].resize(numFrames);
+        const float* in[1] { input.data() };
+        float* out[1] { outputs[f].data() };
+        filter.prepare(1000.0f, 3.0f, 0.0f);
+        filter.process(in, out, 1000.0f, 3.0f, 0.0f, numFrames);
+    }
+
+    REQUIRE(outputs[0] == outputs[1]);
+}
+
+TEST_CASE("[FilterTables] Tabulated filters from the control header")
+{
+    sfz::Synth synth;
+    REQUIRE(!synth.getResources().getSynthConfig().tabulatedFilters);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/tabulatedFilters.sfz", R"(
+        <control> hint_tabulated_filters=1
+        <region> sample=*sine fil_type=lpf_2p cutoff=500 resonance=6
+    )");
+    REQUIRE(synth.getResources().getSynthConfig().tabulatedFilters);
+}
+
+TEST_CASE("[FilterTables] Cached designs match the tables")
+{
+    auto table = sfz::RbjCoefficientTable::get(sampleRate);
+    sfz::FilterCoefficientCache cache;
+
+    for (sfz::FilterType type : rbjTypes) {
+        for (float cutoff : { 50.0f, 440.0f, 1234.5f, 19000.0f }) {
+            for (float q : { -3.0f, 0.0f, 12.0f }) {
+                const sfz::BiquadCoefficients expected = table->compute(type, cutoff, q);
+                for (int i = 0; i < 2; ++i) {
+                    const sfz::BiquadCoefficients& c = cache.compute(*table, type, cutoff, q);
+                    REQUIRE(c.b0 == expected.b0);
+                    REQUIRE(c.b1 == expected.b1);
+                    REQUIRE(c.b2 == expected.b2);
+                    REQUIRE(c.a1 == expected.a1);
+                    REQUIRE(c.a2 == expected.a2);
+                }
+            }
+        }
+    }
+    REQUIRE(cache.getNumHits() > 0);
+
+    // A clear forgets the designs
+    cache.clear();
+    const uint64_t numMisses = cache.getNumMisses();
+    cache.compute(*table, sfz::kFilterLpf2p, 440.0f, 0.0f);
+    REQUIRE(cache.getNumMisses() == numMisses + 1);
+
+    // The designs of other sample rates are not shared
+    auto otherTable = sfz::RbjCoefficientTable::get(44100.0);
+    const sfz::BiquadCoefficients& other = cache.compute(*otherTable, sfz::kFilterLpf2p, 440.0f, 0.0f);
+    REQUIRE(cache.getNumMisses() == numMisses + 2);
+    REQUIRE(other.b0 == otherTable->compute(sfz::kFilterLpf2p, 440.0f, 0.0f).b0);
+}
@@ -6,8 +6,10 @@
 
 #include "sfizz/utility/StringViewHelpers.h"
 #include "sfizz/utility/Base64.h"
+#include "sfizz/utility/Timing.h"
 #include "catch2/catch.hpp"
 #include "absl/strings/string_view.h"
+#include <thread>
 using namespace Catch::literals;
 
 TEST_CASE("[Helpers] trimInPlace")
@@ -142,3 +144,30 @@ TEST_CASE("[Parsing] Base64")
         REQUIRE( view  == "foobar" );
     }
 }
+
+TEST_CASE("[Helpers] Cycle clock timings")
+{
+    REQUIRE(sfz::CycleClock::secondsPerTick() > 0.0);
+
+    double duration = 0.0;
+    {
+        sfz::ScopedTiming logger { duration };
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    // loose bounds, the sleep can overrun on a loaded machine
+    REQUIRE(duration > 0.015);
+    REQUIRE(duration < 1.0);
+
+    {
+        sfz::ScopedTiming logger { duration, sfz::ScopedTiming::Operation::addToDuration };
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE(duration > 0.035);
+
+    const double lastDuration = duration;
+    {
+        sfz::ScopedTiming logger { duration, sfz::ScopedTiming::Operation::replaceDuration, false };
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(duration == lastDuration);
+}
@@ -8,6 +8,8 @@
 #include "catch2/catch.hpp"
 #include <array>
 #include <numeric>
+#include <vector>
+#include <cmath>
 using namespace Catch::literals;
 
 TEST_CASE("[Interpolators] Sample at points")
@@ -127,3 +129,106 @@ TEST_CASE("[Interpolators] Windowed sinc precision")
     Check(windowedSincError(*sfz::SincInterpolatorTraits<60>::windowedSinc));
     Check(windowedSincError(*sfz::SincInterpolatorTraits<72>::windowedSinc));
 }
+
+template <sfz::InterpolatorModel M>
+static void checkStereo(const float* left, const float* right, unsigned size)
+{
+    for (unsigned i = 0; i < size; ++i) {
+        const float coeff = static_cast<float>(i % 16) / 16.0f;
+        float leftOutput;
+        float rightOutput;
+        sfz::interpolateStereo<M>(&left[i], &right[i], coeff, leftOutput, rightOutput);
+        REQUIRE(leftOutput == sfz::interpolate<M>(&left[i], coeff));
+        REQUIRE(rightOutput == sfz::interpolate<M>(&right[i], coeff));
+    }
+}
+
+TEST_CASE("[Interpolators] Stereo")
+{
+    sfz::initializeInterpolators();
+
+    constexpr unsigned padding = 36;
+    constexpr unsigned size = 64;
+    std::array<float, size + 2 * padding> left;
+    std::array<float, size + 2 * padding> right;
+    for (unsigned i = 0; i < left.size(); ++i) {
+        left[i] = std::sin(0.1f * i);
+        right[i] = std::cos(0.37f * i);
+    }
+
+    const float* l = &left[padding];
+    const float* r = &right[padding];
+    checkStereo<sfz::kInterpolatorNearest>(l, r, size);
+    checkStereo<sfz::kInterpolatorLinear>(l, r, size);
+    checkStereo<sfz::kInterpolatorHermite3>(l, r, size);
+    checkStereo<sfz::kInterpolatorBspline3>(l, r, size);
+    checkStereo<sfz::kInterpolatorSinc8>(l, r, size);
+    checkStereo<sfz::kInterpolatorSinc12>(l, r, size);
+    checkStereo<sfz::kInterpolatorSinc72>(l, r, size);
+}
+
+template <sfz::InterpolatorModel M>
+static void checkSincBlock(const float* left, const float* right, unsigned size)
+{
+    std::vector<int> indices(size);
+    std::vector<float> coeffs(size);
+    std::vector<float> gains(size);
+    for (unsigned i = 0; i < size; ++i) {
+        indices[i] = static_cast<int>(i * 3 / 4);
+        coeffs[i] = static_cast<float>((i * 7) % 32) / 32.0f;
+        gains[i] = 0.5f + 0.01f * i;
+    }
+
+    std::vector<float> leftOutput(size);
+    std::vector<float> rightOutput(size, 1.0f);
+    const float* sources[2] { left, right };
+    float* outputs[2] { leftOutput.data(), rightOutput.data() };
+
+    if (!sfz::interpolateSincBlock(M, sources, outputs, 1, indices.data(), coeffs.data(), nullptr, size))
+        return;
+    if (!sfz::interpolateSincBlock(M, &sources[1], &outputs[1], 1, indices.data(), coeffs.data(), gains.data(), size))
+        return;
+    for (unsigned i = 0; i < size; ++i) {
+        REQUIRE(leftOutput[i] == Approx(sfz::interpolate<M>(&left[indices[i]], coeffs[i])).margin(1e-5));
+        REQUIRE(rightOutput[i] == Approx(1.0f + gains[i] * sfz::interpolate<M>(&right[indices[i]], coeffs[i])).margin(1e-5));
+    }
+
+    std::fill(rightOutput.begin(), rightOutput.end(), 0.0f);
+    REQUIRE(sfz::interpolateSincBlock(M, sources, outputs, 2, indices.data(), coeffs.data(), nullptr, size));
+    for (unsigned i = 0; i < size; ++i) {
+        REQUIRE(leftOutput[i] == Approx(sfz::interpolate<M>(&left[indices[i]], coeffs[i])).margin(1e-5));
+        REQUIRE(rightOutput[i] == Approx(sfz::interpolate<M>(&right[indices[i]], coeffs[i])).margin(1e-5));
+    }
+}
+
+TEST_CASE("[Interpolators] Windowed sinc blocks")
+{
+    sfz::initializeInterpolators();
+
+    constexpr unsigned padding = 36;
+    constexpr unsigned size = 64;
+    std::array<float, size + 2 * padding> left;
+    std::array<float, size + 2 * padding> right;
+    for (unsigned i = 0; i < left.size(); ++i) {
+        left[i] = std::sin(0.1f * i);
+        right[i] = std::cos(0.37f * i);
+    }
+
+    const float* l = &left[padding];
+    const float* r = &right[padding];
+    checkSincBlock<sfz::kInterpolatorSinc8>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc12>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc16>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc24>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc36>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc48>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc60>(l, r, size);
+    checkSincBlock<sfz::kInterpolatorSinc72>(l, r, size);
+
+    const float* sources[1] { l };
+    float output = 0.0f;
+    float* outputs[1] { &output };
+    const int index = 0;
+    const float coeff = 0.0f;
+    REQUIRE(!sfz::interpolateSincBlock(sfz::kInterpolatorLinear, sources, outputs, 1, &index, &coeff, nullptr, 1));
+}
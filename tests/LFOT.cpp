@@ -8,9 +8,12 @@
 #include "sfizz/Synth.h"
 #include "sfizz/LFO.h"
 #include "sfizz/Region.h"
+#include "sfizz/Resources.h"
+#include "sfizz/AudioBuffer.h"
 #include "catch2/catch.hpp"
+#include "ghc/fs_std.hpp"
 
-static bool computeLFO(DataPoints& dp, const fs::path& sfzPath, double sampleRate, size_t numFrames)
+static bool computeLFO(DataPoints& dp, const fs::path& sfzPath, double sampleRate, size_t numFrames, size_t blockSize = 0)
 {
     sfz::Synth synth;
     sfz::Resources& resources = synth.getResources();
@@ -21,7 +24,7 @@ static bool computeLFO(DataPoints& dp, const fs::path& sfzPath, double sampleRat
     if (synth.getNumRegions() != 1)
         return false;
 
-    size_t bufferSize = static_cast<size_t>(synth.getSamplesPerBlock());
+    size_t bufferSize = blockSize ? blockSize : static_cast<size_t>(synth.getSamplesPerBlock());
 
     const std::vector<sfz::LFODescription>& desc = synth.getRegionView(0)->lfos;
     size_t numLfos = desc.size();
@@ -124,3 +127,95 @@ TEST_CASE("[LFO] Fade and delay")
         REQUIRE(mse < mseThreshold);
     }
 }
+
+TEST_CASE("[LFO] Waves do not depend on the block size")
+{
+    DataPoints ref;
+    REQUIRE(computeLFO(ref, "tests/lfo/lfo_waves.sfz", 100.0, 1000, 1));
+
+    for (size_t blockSize : { 3, 4, 7, 64, 1024 }) {
+        INFO("Block size " << blockSize);
+        DataPoints cur;
+        REQUIRE(computeLFO(cur, "tests/lfo/lfo_waves.sfz", 100.0, 1000, blockSize));
+        REQUIRE(ref.rows == cur.rows);
+        REQUIRE(ref.cols == cur.cols);
+        for (size_t i = 0; i < cur.rows * cur.cols; ++i)
+            REQUIRE(ref.data[i] == Approx(cur.data[i]).margin(1e-3));
+    }
+}
+
+TEST_CASE("[LFO] Voice independence")
+{
+    sfz::Synth synth;
+    sfz::Resources& resources = synth.getResources();
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/lfo_independence.sfz", R"(
+        <region> sample=*sine
+        lfo1_beats=1 lfo1_wave=1
+        lfo2_freq=1 lfo2_wave=1
+        lfo3_beats=1 lfo3_wave=12
+        lfo4_beats=1 lfo4_wave=1 lfo4_fade=1
+        lfo5_beats=1 lfo5_wave=1 lfo5_delay=1
+        lfo6_beats=1 lfo6_wave=1 lfo6_phase_oncc1=0.5
+    )");
+    REQUIRE(synth.getNumRegions() == 1);
+
+    const std::vector<sfz::LFODescription>& desc = synth.getRegionView(0)->lfos;
+    REQUIRE(desc.size() == 6);
+
+    std::vector<std::unique_ptr<sfz::LFO>> lfos;
+    for (const sfz::LFODescription& d : desc) {
+        lfos.emplace_back(new sfz::LFO(resources));
+        lfos.back()->setSampleRate(sfz::config::defaultSampleRate);
+        lfos.back()->configure(&d);
+        lfos.back()->start(0);
+    }
+
+    for (const auto& lfo : lfos)
+        REQUIRE(!lfo->isVoiceIndependent());
+
+    synth.playbackState(0, 1);
+    REQUIRE(lfos[0]->isVoiceIndependent());
+    REQUIRE(!lfos[1]->isVoiceIndependent());
+    REQUIRE(!lfos[2]->isVoiceIndependent());
+    REQUIRE(!lfos[3]->isVoiceIndependent());
+    REQUIRE(!lfos[4]->isVoiceIndependent());
+    REQUIRE(!lfos[5]->isVoiceIndependent());
+}
+
+TEST_CASE("[LFO] Voices share the output of voice-independent LFOs")
+{
+    const std::string sfz = R"(
+        <region> sample=*sine lokey=60 hikey=72 pitch_keycenter=60
+        lfo1_beats=0.5 lfo1_wave=1 lfo1_amplitude=50
+    )";
+
+    sfz::Synth synths[3];
+    for (sfz::Synth& synth : synths) {
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/lfo_shared.sfz", sfz);
+        synth.bpmTempo(0, 120.0f);
+        synth.playbackState(0, 1);
+    }
+
+    // both voices in the first, a voice in each of the others
+    synths[0].noteOn(0, 60, 100);
+    synths[0].noteOn(0, 64, 100);
+    synths[1].noteOn(0, 60, 100);
+    synths[2].noteOn(0, 64, 100);
+
+    const unsigned blockSize = static_cast<unsigned>(synths[0].getSamplesPerBlock());
+    sfz::AudioBuffer<float> buffers[3] {
+        { 2, blockSize }, { 2, blockSize }, { 2, blockSize }
+    };
+
+    for (unsigned block = 0; block < 20; ++block) {
+        for (unsigned s = 0; s < 3; ++s)
+            synths[s].renderBlock(buffers[s]);
+        REQUIRE(synths[0].getNumActiveVoices() == 2);
+        for (unsigned c = 0; c < 2; ++c) {
+            for (unsigned i = 0; i < blockSize; ++i) {
+                const float expected = buffers[1].getSample(c, i) + buffers[2].getSample(c, i);
+                REQUIRE(buffers[0].getSample(c, i) == Approx(expected).margin(1e-5));
+            }
+        }
+    }
+}
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/LatencyHistogram.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "TestHelpers.h"
+#include "catch2/catch.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+using namespace Catch::literals;
+
+TEST_CASE("[LatencyHistogram] Buckets")
+{
+    using Histogram = sfz::LatencyHistogram;
+    REQUIRE(Histogram::bucketIndex(0.0) == 0);
+    REQUIRE(Histogram::bucketIndex(-1.0) == 0);
+    REQUIRE(Histogram::bucketIndex(0.5e-6) == 0);
+    REQUIRE(Histogram::bucketIndex(1e-6) == 1);
+    REQUIRE(Histogram::bucketIndex(2e-6) == 1 + Histogram::bucketsPerOctave);
+    REQUIRE(Histogram::bucketIndex(1e6) == Histogram::numBuckets - 1);
+    REQUIRE(std::isinf(Histogram::bucketUpperBound(Histogram::numBuckets - 1)));
+
+    for (double duration : { 1.1e-6, 3.7e-5, 1e-3, 2.9e-3, 0.25 }) {
+        const int index = Histogram::bucketIndex(duration);
+        REQUIRE(duration < Histogram::bucketUpperBound(index));
+        REQUIRE(duration >= Histogram::bucketUpperBound(index - 1));
+    }
+}
+
+TEST_CASE("[LatencyHistogram] Statistics")
+{
+    sfz::LatencyHistogram histogram;
+    REQUIRE(histogram.getCount() == 0);
+    REQUIRE(histogram.getMin() == 0.0);
+    REQUIRE(histogram.getMax() == 0.0);
+    REQUIRE(histogram.getMean() == 0.0);
+    REQUIRE(histogram.getPercentile(0.99) == 0.0);
+
+    // 1 ms for most of the callbacks, and a few spikes of 10 ms
+    for (int i = 0; i < 995; ++i)
+        histogram.add(1e-3);
+    for (int i = 0; i < 5; ++i)
+        histogram.add(10e-3);
+
+    REQUIRE(histogram.getCount() == 1000);
+    REQUIRE(histogram.getMin() == 1e-3);
+    REQUIRE(histogram.getMax() == 10e-3);
+    REQUIRE(histogram.getMean() == Approx(1.045e-3));
+
+    const double p50 = histogram.getPercentile(0.5);
+    REQUIRE(p50 >= 1e-3);
+    REQUIRE(p50 < 1.1e-3);
+    REQUIRE(histogram.getPercentile(0.99) == p50);
+    REQUIRE(histogram.getPercentile(0.999) == 10e-3);
+    REQUIRE(histogram.getPercentile(1.0) == 10e-3);
+
+    histogram.reset();
+    REQUIRE(histogram.getCount() == 0);
+    REQUIRE(histogram.getMax() == 0.0);
+    REQUIRE(histogram.getPercentile(0.5) == 0.0);
+}
+
+TEST_CASE("[LatencyHistogram] Callback statistics of the synth")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString("stats.sfz", "<region> sample=*sine");
+    synth.noteOn(0, 60, 100);
+    for (int i = 0; i < 10; ++i)
+        synth.renderBlock(buffer);
+
+    const auto total = synth.getCallbackStats(sfz::Synth::CallbackTotal);
+    REQUIRE(total.numCallbacks == 10);
+    REQUIRE(total.min > 0.0);
+    REQUIRE(total.min <= total.mean);
+    REQUIRE(total.mean <= total.max);
+    REQUIRE(total.p50 <= total.p99);
+    REQUIRE(total.p99 <= total.p999);
+    REQUIRE(total.p999 <= total.max);
+    REQUIRE(synth.getCallbackStats(sfz::Synth::CallbackData).numCallbacks == 10);
+
+    // the voice stages are only added on the timed blocks
+    synth.resetCallbackStats();
+    REQUIRE(synth.getCallbackStats(sfz::Synth::CallbackTotal).numCallbacks == 0);
+    synth.setVoiceTimingPeriod(4);
+    for (int i = 0; i < 8; ++i)
+        synth.renderBlock(buffer);
+    REQUIRE(synth.getCallbackStats(sfz::Synth::CallbackRender).numCallbacks == 8);
+    REQUIRE(synth.getCallbackStats(sfz::Synth::CallbackData).numCallbacks == 2);
+
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.dispatchMessage(client, 0, "/stats/render/count", "", nullptr);
+    synth.dispatchMessage(client, 0, "/stats/data/count", "", nullptr);
+    synth.dispatchMessage(client, 0, "/stats/total/max", "", nullptr);
+    REQUIRE(messageList.size() == 3);
+    REQUIRE(messageList[0] == "/stats/render/count,h : { 8 }");
+    REQUIRE(messageList[1] == "/stats/data/count,h : { 2 }");
+    REQUIRE(messageList[2].find("/stats/total/max,d : {") == 0);
+
+    synth.dispatchMessage(client, 0, "/stats/reset", "", nullptr);
+    REQUIRE(synth.getCallbackStats(sfz::Synth::CallbackRender).numCallbacks == 0);
+}
+
+TEST_CASE("[LatencyHistogram] Voice start statistics of the synth")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/voice_start.sfz", R"(
+        <region> key=60 sample=kick.wav
+        <region> key=62 sample=*sine
+    )");
+    synth.noteOn(0, 60, 100);
+    synth.noteOn(10, 62, 100);
+    REQUIRE(synth.getVoiceStartStats(sfz::Synth::VoiceStartDispatch).numStarts == 0);
+    synth.renderBlock(buffer);
+    synth.renderBlock(buffer);
+
+    const auto dispatch = synth.getVoiceStartStats(sfz::Synth::VoiceStartDispatch);
+    REQUIRE(dispatch.numStarts == 2);
+    REQUIRE(dispatch.min <= dispatch.max);
+    const auto render = synth.getVoiceStartStats(sfz::Synth::VoiceStartRender);
+    REQUIRE(render.numStarts == 2);
+    REQUIRE(render.min <= render.max);
+    // the oscillators have no data to preload
+    REQUIRE(render.numPreloaded == 1);
+    REQUIRE(render.numNotPreloaded == 0);
+
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.dispatchMessage(client, 0, "/stats/voice_render/count", "", nullptr);
+    synth.dispatchMessage(client, 0, "/stats/voice_start/preloaded", "", nullptr);
+    REQUIRE(messageList.size() == 2);
+    REQUIRE(messageList[0] == "/stats/voice_render/count,h : { 2 }");
+    REQUIRE(messageList[1] == "/stats/voice_start/preloaded,h : { 1 }");
+
+    synth.dispatchMessage(client, 0, "/stats/voice_start/reset", "", nullptr);
+    REQUIRE(synth.getVoiceStartStats(sfz::Synth::VoiceStartDispatch).numStarts == 0);
+    REQUIRE(synth.getVoiceStartStats(sfz::Synth::VoiceStartRender).numPreloaded == 0);
+}
@@ -4,8 +4,11 @@
 // license. You should have receive a LICENSE.md file along with the code.
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
+#include "sfizz/Synth.h"
+#include "TestHelpers.h"
 #include "catch2/catch.hpp"
 #include <jsl/memory>
+#include <string>
 #include <vector>
 #include <cstdint>
 
@@ -39,3 +42,43 @@ TEST_CASE("[Memory] Aligned unique pointers")
     ptrs.clear();
     REQUIRE(numLiveObjects == 0);
 }
+
+TEST_CASE("[Memory] Breakdown of the synth memory")
+{
+    sfz::Synth synth;
+    const auto empty = synth.getMemoryBreakdown();
+    REQUIRE(empty.preloadedSamples == 0);
+    REQUIRE(empty.wavetables == 0);
+    REQUIRE(empty.voices > 0);
+    REQUIRE(empty.bufferPool > 0);
+    REQUIRE(empty.effectBuses > 0);
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/memory.sfz", R"(
+        <region> key=60 sample=kick.wav
+        <region> key=62 sample=snare.wav
+        <region> key=64 sample=ramp_wave.wav oscillator=on
+    )");
+    const auto loaded = synth.getMemoryBreakdown();
+    REQUIRE(loaded.preloadedSamples > 0);
+    REQUIRE(loaded.preloadedSamples == synth.getMemoryUsage() - loaded.streamedSamples);
+    REQUIRE(loaded.wavetables > 0);
+    REQUIRE(loaded.regions > empty.regions);
+    REQUIRE(loaded.total() == loaded.preloadedSamples + loaded.streamedSamples + loaded.wavetables
+        + loaded.voices + loaded.bufferPool + loaded.effectBuses + loaded.regions);
+
+    // more voices take more memory
+    synth.setNumVoices(2 * synth.getNumVoices());
+    REQUIRE(synth.getMemoryBreakdown().voices > loaded.voices);
+
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.dispatchMessage(client, 0, "/mem/preloaded_samples", "", nullptr);
+    synth.dispatchMessage(client, 0, "/mem/total", "", nullptr);
+    const auto memory = synth.getMemoryBreakdown();
+    std::vector<std::string> expected {
+        "/mem/preloaded_samples,h : { " + std::to_string(memory.preloadedSamples) + " }",
+        "/mem/total,h : { " + std::to_string(memory.total()) + " }",
+    };
+    REQUIRE(messageList == expected);
+}
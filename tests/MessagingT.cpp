@@ -5,9 +5,17 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "sfizz/Messaging.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "TestHelpers.h"
 #include "catch2/catch.hpp"
+#include <absl/algorithm/container.h>
 #include <absl/types/span.h>
+#include <ghc/fs_std.hpp>
+#include <chrono>
 #include <cstring>
+#include <mutex>
+#include <thread>
 
 TEST_CASE("[Messaging] OSC message creation")
 {
@@ -125,3 +133,150 @@ TEST_CASE("[Messaging] Type-safe client API")
     client.receive<'i', 'm', 'h', 'f', 'd', 's', 'b', 'T', 'F', 'N', 'I'>(
         0, "/test", i, m, h, f, d, s, &b, {}, {}, {}, {});
 }
+
+TEST_CASE("[Messaging] Message bundle")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/bundle.sfz", R"(
+        <region> sample=*sine key=60
+        <region> sample=*saw key=62
+    )");
+
+    uint8_t requests[256];
+    uint32_t requestsSize = 0;
+    requestsSize += sfizz_prepare_message(requests + requestsSize, sizeof(requests) - requestsSize, "/num_regions", "", nullptr);
+    requestsSize += sfizz_prepare_message(requests + requestsSize, sizeof(requests) - requestsSize, "/region0/key_range", "", nullptr);
+    requestsSize += sfizz_prepare_message(requests + requestsSize, sizeof(requests) - requestsSize, "/region1/key_range", "", nullptr);
+    REQUIRE(requestsSize <= sizeof(requests));
+
+    uint8_t replies[256];
+    const uint32_t repliesSize = synth.dispatchMessageBundle(0, requests, requestsSize, replies, sizeof(replies));
+    REQUIRE(repliesSize > 0);
+    REQUIRE(repliesSize <= sizeof(replies));
+
+    const char* path;
+    const char* sig;
+    const sfizz_arg_t* args;
+    uint8_t argsBuffer[256];
+    uint32_t offset = 0;
+    int32_t size;
+
+    size = sfizz_extract_message(replies + offset, repliesSize - offset, argsBuffer, sizeof(argsBuffer), &path, &sig, &args);
+    REQUIRE(size > 0);
+    offset += size;
+    REQUIRE(!strcmp(path, "/num_regions"));
+    REQUIRE(!strcmp(sig, "h"));
+    REQUIRE(args[0].h == 2);
+
+    size = sfizz_extract_message(replies + offset, repliesSize - offset, argsBuffer, sizeof(argsBuffer), &path, &sig, &args);
+    REQUIRE(size > 0);
+    offset += size;
+    REQUIRE(!strcmp(path, "/region0/key_range"));
+    REQUIRE(args[0].i == 60);
+
+    size = sfizz_extract_message(replies + offset, repliesSize - offset, argsBuffer, sizeof(argsBuffer), &path, &sig, &args);
+    REQUIRE(size > 0);
+    offset += size;
+    REQUIRE(!strcmp(path, "/region1/key_range"));
+    REQUIRE(args[0].i == 62);
+    REQUIRE(offset == repliesSize);
+
+    // Too small: the first reply fits, and the size of all of them is returned
+    sfizz_arg_t numRegions;
+    numRegions.h = 2;
+    const uint32_t firstSize = sfizz_prepare_message(nullptr, 0, "/num_regions", "h", &numRegions);
+    uint8_t smallReplies[32];
+    REQUIRE(firstSize <= sizeof(smallReplies));
+    REQUIRE(synth.dispatchMessageBundle(0, requests, requestsSize, smallReplies, sizeof(smallReplies)) == repliesSize);
+    size = sfizz_extract_message(smallReplies, firstSize, argsBuffer, sizeof(argsBuffer), &path, &sig, &args);
+    REQUIRE(size == static_cast<int32_t>(firstSize));
+    REQUIRE(!strcmp(path, "/num_regions"));
+    REQUIRE(args[0].h == 2);
+}
+
+namespace {
+
+struct Broadcasts {
+    std::mutex mutex;
+    std::vector<std::string> messages;
+
+    static void receive(void* data, int delay, const char* path, const char* sig, const sfizz_arg_t* args)
+    {
+        Broadcasts& self = *reinterpret_cast<Broadcasts*>(data);
+        std::lock_guard<std::mutex> lock { self.mutex };
+        simpleMessageReceiver(&self.messages, delay, path, sig, args);
+    }
+
+    // Wait for a broadcast from the thread of the subscriptions
+    bool waitFor(const std::string& message)
+    {
+        for (int i = 0; i < 200; ++i) {
+            {
+                std::lock_guard<std::mutex> lock { mutex };
+                if (absl::c_linear_search(messages, message))
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    size_t count(const std::string& message)
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return static_cast<size_t>(absl::c_count(messages, message));
+    }
+};
+
+} // namespace
+
+TEST_CASE("[Messaging] Subscriptions broadcast the changes")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/subscriptions.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+
+    Broadcasts broadcasts;
+    synth.setBroadcastCallback(&Broadcasts::receive, &broadcasts);
+
+    std::vector<std::string> replies;
+    sfz::Client client(&replies);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    sfizz_arg_t args[2];
+    args[0].s = "/num_active_voices";
+    args[1].i = 100;
+    synth.dispatchMessage(client, 0, "/subscribe", "si", args);
+    args[0].s = "/cc20/value";
+    synth.dispatchMessage(client, 0, "/subscribe", "si", args);
+    args[0].s = "/foo";
+    synth.dispatchMessage(client, 0, "/subscribe", "si", args);
+    REQUIRE(replies == std::vector<std::string> {
+        "/subscribe,T : {  }",
+        "/subscribe,T : {  }",
+        "/subscribe,F : {  }",
+    });
+
+    synth.renderBlock(buffer);
+    REQUIRE(broadcasts.waitFor("/num_active_voices,i : { 0 }"));
+    REQUIRE(broadcasts.waitFor("/cc20/value,f : { 0 }"));
+
+    synth.noteOn(0, 60, 100);
+    synth.hdcc(0, 20, 0.5f);
+    synth.hdcc(0, 21, 0.5f);
+    synth.renderBlock(buffer);
+    REQUIRE(broadcasts.waitFor("/num_active_voices,i : { 1 }"));
+    REQUIRE(broadcasts.waitFor("/cc20/value,f : { 0.5 }"));
+
+    // The values which did not change are not broadcast again
+    synth.renderBlock(buffer);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(broadcasts.count("/num_active_voices,i : { 1 }") == 1);
+    REQUIRE(broadcasts.count("/cc20/value,f : { 0.5 }") == 1);
+    REQUIRE(broadcasts.count("/cc21/value,f : { 0.5 }") == 0);
+
+    args[0].s = "/num_active_voices";
+    synth.dispatchMessage(client, 0, "/unsubscribe", "s", args);
+    synth.setBroadcastCallback(nullptr, nullptr);
+}
@@ -108,6 +108,70 @@ TEST_CASE("[MidiState] Flushing state")
     REQUIRE(state.getPitchBend() == 0.7f);
 }
 
+TEST_CASE("[MidiState] Flushing only the changed controllers")
+{
+    sfz::MidiState state;
+    for (int block = 0; block < 3; ++block) {
+        // a different set of controllers and notes every block
+        for (int cc = block; cc < sfz::config::numCCs; cc += 7)
+            state.ccEvent(10 + block, cc, sfz::normalizeCC(block + 1));
+        for (int note = block; note < 128; note += 5)
+            state.polyAftertouchEvent(20 + block, note, sfz::normalizeCC(block + 1));
+        state.ccEvent(100, 1, sfz::normalizeCC(100 + block));
+
+        state.advanceTime(1024);
+
+        for (int cc = 0; cc < sfz::config::numCCs; ++cc)
+            REQUIRE(state.getCCEvents(cc).size() == 1);
+        for (int note = 0; note < 128; ++note)
+            REQUIRE(state.getPolyAftertouchEvents(note).size() == 1);
+
+        for (int cc = block; cc < sfz::config::numCCs; cc += 7) {
+            if (cc != 1)
+                REQUIRE(state.getCCValue(cc) == sfz::normalizeCC(block + 1));
+        }
+        for (int note = block; note < 128; note += 5)
+            REQUIRE(state.getPolyAftertouch(note) == sfz::normalizeCC(block + 1));
+        REQUIRE(state.getCCValue(1) == sfz::normalizeCC(100 + block));
+    }
+
+    state.ccEvent(10, 64, 1.0f);
+    state.resetEventStates();
+    REQUIRE(state.getCCEvents(64).size() == 1);
+    state.ccEvent(10, 64, 1.0f);
+    state.flushEvents();
+    REQUIRE(state.getCCEvents(64).size() == 1);
+    REQUIRE(state.getCCValue(64) == 1.0f);
+}
+
+TEST_CASE("[MidiState] Per-note controllers")
+{
+    sfz::MidiState state;
+    state.perNoteEvent(10, 60, sfz::ExtendedCCs::perNotePitchBend, 0.5f);
+    state.perNoteEvent(20, 60, sfz::ExtendedCCs::perNotePitchBend, -0.25f);
+    state.perNoteEvent(30, 62, sfz::ExtendedCCs::perNoteTimbre, 0.75f);
+    state.perNoteEvent(30, 62, 74, 1.0f); // not a per-note controller
+
+    REQUIRE(state.getPerNoteEvents(60, sfz::ExtendedCCs::perNotePitchBend).size() == 3);
+    REQUIRE(state.getPerNoteEvents(60, sfz::ExtendedCCs::perNoteTimbre).size() == 1);
+    REQUIRE(state.getPerNoteEvents(62, sfz::ExtendedCCs::perNotePitchBend).size() == 1);
+    REQUIRE(state.getPerNoteValue(60, sfz::ExtendedCCs::perNotePitchBend) == -0.25f);
+    REQUIRE(state.getPerNoteValue(62, sfz::ExtendedCCs::perNoteTimbre) == 0.75f);
+    REQUIRE(state.getPerNoteValue(62, sfz::ExtendedCCs::perNotePitchBend) == 0.0f);
+    REQUIRE(state.getPerNoteValue(62, 74) == 0.0f);
+    // The channel-wide controllers do not change
+    REQUIRE(state.getCCValue(sfz::ExtendedCCs::perNoteTimbre) == 0.0f);
+
+    state.advanceTime(1024);
+    REQUIRE(state.getPerNoteEvents(60, sfz::ExtendedCCs::perNotePitchBend).size() == 1);
+    REQUIRE(state.getPerNoteValue(60, sfz::ExtendedCCs::perNotePitchBend) == -0.25f);
+    REQUIRE(state.getPerNoteValue(62, sfz::ExtendedCCs::perNoteTimbre) == 0.75f);
+
+    state.resetEventStates();
+    REQUIRE(state.getPerNoteValue(60, sfz::ExtendedCCs::perNotePitchBend) == 0.0f);
+    REQUIRE(state.getPerNoteValue(62, sfz::ExtendedCCs::perNoteTimbre) == 0.0f);
+}
+
 TEST_CASE("[MidiState] Set and get note velocities")
 {
     sfz::MidiState state;
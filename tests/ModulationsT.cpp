@@ -7,9 +7,14 @@
 #include "sfizz/modulations/ModMatrix.h"
 #include "sfizz/modulations/ModId.h"
 #include "sfizz/modulations/ModKey.h"
+#include "sfizz/modulations/ModGenerator.h"
 #include "sfizz/Synth.h"
+#include "sfizz/SynthConfig.h"
+#include "sfizz/Config.h"
 #include "TestHelpers.h"
 #include "catch2/catch.hpp"
+#include <cmath>
+#include <vector>
 
 TEST_CASE("[Modulations] Identifiers")
 {
@@ -159,6 +164,39 @@ TEST_CASE("[Modulations] LFO Filter connections")
     }));
 }
 
+TEST_CASE("[Modulations] Connections inherited from a group")
+{
+    sfz::Synth synth;
+    synth.loadSfzString("/modulation.sfz", R"(
+        <group> cutoff=100 amplitude_oncc20=50 lfo1_freq=1 lfo1_cutoff1=1
+        <region> sample=*sine
+        <region> sample=*saw pitch_oncc42=100
+        <region> sample=*square
+    )");
+
+    REQUIRE(synth.getNumRegions() == 3);
+    for (int i = 0; i < 3; ++i) {
+        const sfz::Region& region = *synth.getRegionView(i);
+        REQUIRE(region.id == NumericId<sfz::Region> { i });
+        REQUIRE(region.lfos.size() == 1);
+        REQUIRE(region.lfos[0].freqKey.region() == region.id);
+    }
+    REQUIRE(synth.getRegionView(0)->sampleId->filename() == "*sine");
+    REQUIRE(synth.getRegionView(1)->sampleId->filename() == "*saw");
+    REQUIRE(synth.getRegionView(2)->sampleId->filename() == "*square");
+
+    const std::string graph = synth.getResources().getModMatrix().toDotGraph();
+    REQUIRE(graph == createDefaultGraph({
+        R"("Controller 20 {curve=0, smooth=0, step=0}" -> "Amplitude {0}")",
+        R"("Controller 20 {curve=0, smooth=0, step=0}" -> "Amplitude {1}")",
+        R"("Controller 20 {curve=0, smooth=0, step=0}" -> "Amplitude {2}")",
+        R"("Controller 42 {curve=0, smooth=0, step=0}" -> "Pitch {1}")",
+        R"("LFO 1 {0}" -> "FilterCutoff {0, N=1}")",
+        R"("LFO 1 {1}" -> "FilterCutoff {1, N=1}")",
+        R"("LFO 1 {2}" -> "FilterCutoff {2, N=1}")",
+    }, 3));
+}
+
 TEST_CASE("[Modulations] EG Filter connections")
 {
     sfz::Synth synth;
@@ -538,6 +576,22 @@ TEST_CASE("[Modulations] LFO CC connections")
     }, 1));
 }
 
+TEST_CASE("[Modulations] Per-note controller connections")
+{
+    sfz::Synth synth;
+    synth.loadSfzString("/modulation.sfz", R"(
+        <region> sample=*sine
+            pitch_oncc138=1200
+            cutoff=500 fil_type=lpf_2p cutoff_oncc139=2400
+    )");
+
+    const std::string graph = synth.getResources().getModMatrix().toDotGraph();
+    REQUIRE(graph == createDefaultGraph({
+        R"("PerVoiceController 138 {curve=0, smooth=0, step=0, region=0}" -> "Pitch {0}")",
+        R"("PerVoiceController 139 {curve=0, smooth=0, step=0, region=0}" -> "FilterCutoff {0, N=1}")",
+    }, 1));
+}
+
 TEST_CASE("[Modulations] Extended CCs connections")
 {
     sfz::Synth synth;
@@ -558,3 +612,207 @@ TEST_CASE("[Modulations] Extended CCs connections")
         R"("Controller 1 {curve=1, smooth=10, step=0.1}" -> "LFOPhase {0, N=3}")",
     }, 1));
 }
+
+namespace {
+
+// a slow sine per-cycle source, continuing from a cycle to the next
+class SineGenerator : public sfz::ModGenerator {
+public:
+    explicit SineGenerator(float frequency) : frequency_(frequency) {}
+    void init(const sfz::ModKey&, NumericId<sfz::Voice>, unsigned) override {}
+    void generate(const sfz::ModKey&, NumericId<sfz::Voice>, absl::Span<float> buffer) override
+    {
+        for (float& x : buffer)
+            x = std::sin(2 * M_PI * frequency_ * frame_++ / 48000.0);
+    }
+
+private:
+    float frequency_ {};
+    unsigned frame_ {};
+};
+
+std::vector<float> computeTarget(sfz::ModId targetId, bool controlRate, unsigned numFrames)
+{
+    sfz::ModMatrix mm;
+    mm.setSampleRate(48000.0);
+    mm.setSamplesPerBlock(1024);
+
+    SineGenerator gen1 { 5.0f };
+    SineGenerator gen2 { 3.0f };
+    const NumericId<sfz::Region> region { 0 };
+    const sfz::ModMatrix::TargetId target = mm.registerTarget(sfz::ModKey::createNXYZ(targetId, region));
+    const sfz::ModMatrix::SourceId source1 = mm.registerSource(sfz::ModKey::createCC(1, 0, 0, 0), gen1);
+    const sfz::ModMatrix::SourceId source2 = mm.registerSource(sfz::ModKey::createCC(2, 0, 0, 0), gen2);
+    mm.connect(source1, target, 0.5f, {}, 0.0f);
+    mm.connect(source2, target, 2.0f, {}, 0.0f);
+    mm.setControlRate(target, controlRate);
+    REQUIRE(mm.isControlRate(target) == controlRate);
+    mm.init();
+
+    std::vector<float> output;
+    for (unsigned cycle = 0; cycle < 4; ++cycle) {
+        mm.beginCycle(numFrames);
+        mm.beginVoice(NumericId<sfz::Voice>(0), region, 1.0f);
+        const float* mod = mm.getModulation(target);
+        REQUIRE(mod);
+        output.insert(output.end(), mod, mod + numFrames);
+        mm.endVoice();
+        mm.endCycle();
+    }
+    return output;
+}
+
+} // namespace
+
+TEST_CASE("[Modulations] Control-rate targets")
+{
+    for (sfz::ModId targetId : { sfz::ModId::Amplitude, sfz::ModId::Pan }) {
+        for (unsigned numFrames : { 5u, 100u, 1024u }) {
+            INFO("Target " << static_cast<int>(targetId) << ", " << numFrames << " frames");
+            const std::vector<float> expected = computeTarget(targetId, false, numFrames);
+            const std::vector<float> actual = computeTarget(targetId, true, numFrames);
+            REQUIRE(actual.size() == expected.size());
+            for (size_t i = 0; i < actual.size(); ++i) {
+                const unsigned frame = i % numFrames;
+                if (frame % sfz::config::modControlInterval == 0 || frame == numFrames - 1)
+                    REQUIRE(actual[i] == expected[i]);
+                else
+                    REQUIRE(actual[i] == Approx(expected[i]).margin(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("[Modulations] Control-rate targets from the control header")
+{
+    sfz::Synth synth;
+    synth.loadSfzString("/modulation.sfz", R"(
+<control> hint_control_rate_modulations=1
+<region>
+sample=*sine
+amplitude_oncc20=59 pitch_oncc42=71 pan_oncc36=12.5 cutoff=100 cutoff_oncc40=20
+)");
+    REQUIRE(synth.getResources().getSynthConfig().controlRateModulations);
+
+    const sfz::ModMatrix& mm = synth.getResources().getModMatrix();
+    const NumericId<sfz::Region> region { 0 };
+    REQUIRE(mm.isControlRate(mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::Amplitude, region))));
+    REQUIRE(mm.isControlRate(mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::Pan, region))));
+    REQUIRE(mm.isControlRate(mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::FilCutoff, region))));
+    REQUIRE(!mm.isControlRate(mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::Pitch, region))));
+
+    sfz::Synth synth2;
+    synth2.loadSfzString("/modulation.sfz", R"(
+<region>
+sample=*sine
+amplitude_oncc20=59
+)");
+    const sfz::ModMatrix& mm2 = synth2.getResources().getModMatrix();
+    REQUIRE(!mm2.isControlRate(mm2.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::Amplitude, region))));
+}
+
+namespace {
+
+class ConstantGenerator : public sfz::ModGenerator {
+public:
+    explicit ConstantGenerator(float value) : value_(value) {}
+    void init(const sfz::ModKey&, NumericId<sfz::Voice>, unsigned) override {}
+    void generate(const sfz::ModKey&, NumericId<sfz::Voice>, absl::Span<float> buffer) override
+    {
+        for (float& x : buffer)
+            x = value_;
+    }
+
+private:
+    float value_ {};
+};
+
+} // namespace
+
+TEST_CASE("[Modulations] Constant targets")
+{
+    constexpr unsigned numFrames { 100 };
+    const NumericId<sfz::Region> region { 0 };
+
+    for (sfz::ModId targetId : { sfz::ModId::Amplitude, sfz::ModId::Pan }) {
+        INFO("Target " << static_cast<int>(targetId));
+        sfz::ModMatrix mm;
+        mm.setSampleRate(48000.0);
+        mm.setSamplesPerBlock(1024);
+
+        ConstantGenerator gen1 { 0.25f };
+        ConstantGenerator gen2 { 3.0f };
+        SineGenerator gen3 { 5.0f };
+        const sfz::ModMatrix::TargetId constantTarget = mm.registerTarget(sfz::ModKey::createNXYZ(targetId, region));
+        const sfz::ModMatrix::TargetId varyingTarget = mm.registerTarget(sfz::ModKey::createNXYZ(sfz::ModId::Width, region));
+        const sfz::ModMatrix::SourceId source1 = mm.registerSource(sfz::ModKey::createCC(1, 0, 0, 0), gen1);
+        const sfz::ModMatrix::SourceId source2 = mm.registerSource(sfz::ModKey::createCC(2, 0, 0, 0), gen2);
+        const sfz::ModMatrix::SourceId source3 = mm.registerSource(sfz::ModKey::createCC(3, 0, 0, 0), gen3);
+        mm.connect(source1, constantTarget, 0.5f, {}, 0.0f);
+        mm.connect(source2, constantTarget, 2.0f, {}, 0.0f);
+        mm.connect(source1, varyingTarget, 0.5f, {}, 0.0f);
+        mm.connect(source3, varyingTarget, 2.0f, {}, 0.0f);
+        mm.init();
+
+        mm.beginCycle(numFrames);
+        mm.beginVoice(NumericId<sfz::Voice>(0), region, 1.0f);
+
+        bool constant = false;
+        const float* mod = mm.getModulation(constantTarget, constant);
+        REQUIRE(mod);
+        REQUIRE(constant);
+        const float expected = (targetId == sfz::ModId::Amplitude) ? (0.125f * 6.0f) : (0.125f + 6.0f);
+        for (unsigned i = 0; i < numFrames; ++i)
+            REQUIRE(mod[i] == expected);
+
+        // already computed in this cycle
+        constant = false;
+        REQUIRE(mm.getModulation(constantTarget, constant) == mod);
+        REQUIRE(constant);
+
+        mod = mm.getModulation(varyingTarget, constant);
+        REQUIRE(mod);
+        REQUIRE(!constant);
+        for (unsigned i = 0; i < numFrames; ++i)
+            REQUIRE(mod[i] == Approx(0.125f + 2.0f * std::sin(2 * M_PI * 5.0 * i / 48000.0)).margin(1e-6));
+
+        mm.endVoice();
+        mm.endCycle();
+    }
+}
+
+TEST_CASE("[Modulations] Frame offset of the tiles of a voice")
+{
+    constexpr unsigned numFrames { 1000 };
+    constexpr unsigned offset { 256 };
+    const NumericId<sfz::Region> region { 0 };
+
+    sfz::ModMatrix mm;
+    mm.setSampleRate(48000.0);
+    mm.setSamplesPerBlock(1024);
+
+    SineGenerator gen { 5.0f };
+    const sfz::ModMatrix::TargetId target = mm.registerTarget(sfz::ModKey::createNXYZ(sfz::ModId::Pan, region));
+    const sfz::ModMatrix::SourceId source = mm.registerSource(sfz::ModKey::createCC(3, 0, 0, 0), gen);
+    mm.connect(source, target, 2.0f, {}, 0.0f);
+    mm.init();
+
+    mm.beginCycle(numFrames);
+    mm.beginVoice(NumericId<sfz::Voice>(0), region, 1.0f);
+
+    const float* mod = mm.getModulation(target);
+    REQUIRE(mod);
+    mm.setFrameOffset(offset);
+    REQUIRE(mm.getModulation(target) == mod + offset);
+    mm.setFrameOffset(0);
+    REQUIRE(mm.getModulation(target) == mod);
+
+    // the offset does not outlive the voice
+    mm.setFrameOffset(offset);
+    mm.endVoice();
+    mm.beginVoice(NumericId<sfz::Voice>(0), region, 1.0f);
+    REQUIRE(mm.getModulation(target) == mod);
+
+    mm.endVoice();
+    mm.endCycle();
+}
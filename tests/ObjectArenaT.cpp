@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "catch2/catch.hpp"
+#include "sfizz/utility/ObjectArena.h"
+#include <vector>
+
+namespace {
+
+struct Counted {
+    explicit Counted(int value, int& alive) : value(value), alive(alive) { ++alive; }
+    ~Counted() { --alive; }
+    int value;
+    int& alive;
+};
+
+} // namespace
+
+TEST_CASE("[ObjectArena] Objects are created in order")
+{
+    int alive = 0;
+    sfz::ObjectArena<Counted, 64> arena;
+    std::vector<sfz::ObjectArena<Counted, 64>::Pointer> objects;
+    for (int i = 0; i < 200; ++i)
+        objects.push_back(arena.create(i, alive));
+    REQUIRE(alive == 200);
+
+    for (int i = 0; i < 200; ++i)
+        REQUIRE(objects[i]->value == i);
+
+    // the blocks grow from 16 to 64 objects
+    REQUIRE(arena.numBlocks() == 5);
+    REQUIRE(arena.capacity() == 16 + 32 + 64 + 64 + 64);
+
+    // contiguous within a block
+    for (int i = 1; i < 16; ++i)
+        REQUIRE(objects[i].get() == objects[i - 1].get() + 1);
+    for (int i = 113; i < 176; ++i)
+        REQUIRE(objects[i].get() == objects[i - 1].get() + 1);
+}
+
+TEST_CASE("[ObjectArena] Destroying and clearing")
+{
+    int alive = 0;
+    sfz::ObjectArena<Counted> arena;
+    std::vector<sfz::ObjectArena<Counted>::Pointer> objects;
+    for (int i = 0; i < 20; ++i)
+        objects.push_back(arena.create(i, alive));
+
+    objects.erase(objects.begin() + 3);
+    REQUIRE(alive == 19);
+    REQUIRE(arena.numBlocks() == 2);
+
+    objects.clear();
+    REQUIRE(alive == 0);
+    arena.clear();
+    REQUIRE(arena.numBlocks() == 0);
+    REQUIRE(arena.capacity() == 0);
+
+    objects.push_back(arena.create(1, alive));
+    REQUIRE(alive == 1);
+    REQUIRE(arena.numBlocks() == 1);
+}
@@ -55,7 +55,7 @@ TEST_CASE("[Opcode] Construction")
         REQUIRE(opcode.lettersOnlyHash == hash("sample&"));
         REQUIRE(opcode.value == "dummy");
         REQUIRE(opcode.parameters.size() == 1);
-        REQUIRE(opcode.parameters == std::vector<uint16_t>({ 123 }));
+        REQUIRE(opcode.parameters == sfz::Opcode::Parameters({ 123 }));
     }
 
     SECTION("Parameterized opcode with ampersand")
@@ -65,7 +65,7 @@ TEST_CASE("[Opcode] Construction")
         REQUIRE(opcode.lettersOnlyHash == hash("sample&"));
         REQUIRE(opcode.value == "dummy");
         REQUIRE(opcode.parameters.size() == 1);
-        REQUIRE(opcode.parameters == std::vector<uint16_t>({ 123 }));
+        REQUIRE(opcode.parameters == sfz::Opcode::Parameters({ 123 }));
     }
 
     SECTION("Parameterized opcode with underscore")
@@ -74,7 +74,7 @@ TEST_CASE("[Opcode] Construction")
         REQUIRE(opcode.name == "sample_underscore123");
         REQUIRE(opcode.lettersOnlyHash == hash("sample_underscore&"));
         REQUIRE(opcode.value == "dummy");
-        REQUIRE(opcode.parameters == std::vector<uint16_t>({ 123 }));
+        REQUIRE(opcode.parameters == sfz::Opcode::Parameters({ 123 }));
     }
 
     SECTION("Parameterized opcode within the opcode")
@@ -83,7 +83,7 @@ TEST_CASE("[Opcode] Construction")
         REQUIRE(opcode.name == "sample1_underscore");
         REQUIRE(opcode.lettersOnlyHash == hash("sample&_underscore"));
         REQUIRE(opcode.value == "dummy");
-        REQUIRE(opcode.parameters == std::vector<uint16_t>({ 1 }));
+        REQUIRE(opcode.parameters == sfz::Opcode::Parameters({ 1 }));
     }
 
     SECTION("Parameterized opcode within the opcode")
@@ -105,7 +105,7 @@ TEST_CASE("[Opcode] Construction")
         REQUIRE(opcode.parameters.size() == 2);
         REQUIRE(opcode.parameters[0] == 123);
         REQUIRE(opcode.parameters[1] == 44);
-        REQUIRE(opcode.parameters == std::vector<uint16_t>({ 123, 44 }));
+        REQUIRE(opcode.parameters == sfz::Opcode::Parameters({ 123, 44 }));
     }
 
     SECTION("Parameterized opcode within the opcode twice, with a back parameter")
@@ -115,7 +115,7 @@ TEST_CASE("[Opcode] Construction")
         REQUIRE(opcode.lettersOnlyHash == hash("sample&_double&_underscore&"));
         REQUIRE(opcode.value == "dummy");
         REQUIRE(opcode.parameters.size() == 3);
-        REQUIRE(opcode.parameters == std::vector<uint16_t>({ 123, 44, 23 }));
+        REQUIRE(opcode.parameters == sfz::Opcode::Parameters({ 123, 44, 23 }));
     }
 }
 
@@ -299,6 +299,29 @@ TEST_CASE("[Opcode] Normalization")
     REQUIRE(Opcode("SaMpLe", "").cleanUp(kOpcodeScopeRegion).name == "sample");
 }
 
+TEST_CASE("[Opcode] Cached normalization")
+{
+    OpcodeCleanupCache cache;
+    for (int i = 0; i < 2; ++i) {
+        const Opcode renamed = cache.cleanUp(Opcode("FOO_cc7", "12"), kOpcodeScopeRegion);
+        REQUIRE(renamed.name == "foo_oncc7");
+        REQUIRE(renamed.value == "12");
+        REQUIRE(renamed.lettersOnlyHash == hash("foo_oncc&"));
+        REQUIRE(renamed.parameters == Opcode::Parameters { 7 });
+        REQUIRE(renamed.category == kOpcodeOnCcN);
+
+        const Opcode kept = cache.cleanUp(Opcode("foo_cc7", "3"), kOpcodeScopeControl);
+        REQUIRE(kept.name == "foo_cc7");
+        REQUIRE(kept.value == "3");
+        REQUIRE(kept.parameters == Opcode::Parameters { 7 });
+    }
+    // The values differ, though the names are the same
+    REQUIRE(cache.cleanUp(Opcode("FOO_cc7", "5"), kOpcodeScopeRegion).value == "5");
+    REQUIRE(cache.size() == 2);
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+}
+
 TEST_CASE("[Opcode] opcode read (uint8_t)")
 {
     SECTION("Basic")
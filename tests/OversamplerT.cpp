@@ -4,8 +4,14 @@
 // license. You should have receive a LICENSE.md file along with the code.
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
+#include "sfizz/Oversampler.h"
 #include "sfizz/OversamplerHelpers.h"
+#include "sfizz/StereoUpsampler.h"
 #include "catch2/catch.hpp"
+#include <ghc/fs_std.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
 
 TEST_CASE("[Oversampler] Conversion factor")
 {
@@ -19,3 +25,95 @@ TEST_CASE("[Oversampler] Conversion factor")
     REQUIRE(sfz::Upsampler::conversionFactor(44100.0, 1.0) == 1);
     REQUIRE(sfz::Upsampler::conversionFactor(44100.0, 1e10) == 128);
 }
+
+TEST_CASE("[Oversampler] Oversampling reader")
+{
+    for (const char* file : { "snare.wav", "stereo_sample.wav" }) {
+        INFO(file);
+        const fs::path path = fs::current_path() / "tests/TestFiles" / file;
+        const sfz::AudioReaderPtr source = sfz::createAudioReader(path, false);
+        REQUIRE(source);
+        const auto sourceFrames = source->frames();
+        const unsigned sourceRate = source->sampleRate();
+
+        auto readAll = [&](size_t blockSize) {
+            sfz::AudioReaderPtr reader = sfz::createOversamplingAudioReader(
+                sfz::createAudioReader(path, false), sfz::Oversampling::x4);
+            REQUIRE(reader->frames() == 4 * sourceFrames);
+            REQUIRE(reader->sampleRate() == 4 * sourceRate);
+            std::vector<float> frames(static_cast<size_t>(reader->frames()) * reader->channels());
+            size_t numRead = 0;
+            while (size_t n = reader->readNextBlock(&frames[numRead * reader->channels()], blockSize))
+                numRead += n;
+            REQUIRE(numRead == static_cast<size_t>(reader->frames()));
+            return frames;
+        };
+
+        // The filters keep their state between the blocks, of any size
+        const std::vector<float> expected = readAll(1 << 20);
+        REQUIRE(readAll(100) == expected);
+        REQUIRE(readAll(1) == expected);
+    }
+}
+
+TEST_CASE("[Oversampler] Stereo stages")
+{
+    constexpr size_t numFrames { 1000 };
+    constexpr size_t blockSize { 64 };
+    std::vector<float> left(numFrames);
+    std::vector<float> right(numFrames);
+    std::vector<float> interleaved(2 * numFrames);
+    std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    for (size_t i = 0; i < numFrames; ++i) {
+        left[i] = interleaved[2 * i] = dist(prng);
+        right[i] = interleaved[2 * i + 1] = dist(prng);
+    }
+
+    // The reference is the chain of the scalar stages of hiir, channel by channel
+    auto upsampleChannel = [](int factor, std::vector<float> input) {
+        hiir::Upsampler2xFpu<12> up2;
+        hiir::Upsampler2xFpu<4> up4;
+        hiir::Upsampler2xFpu<3> up8;
+        up2.set_coefs(sfz::OSCoeffs2x);
+        up4.set_coefs(sfz::OSCoeffs4x);
+        up8.set_coefs(sfz::OSCoeffs8x);
+        std::vector<float> output;
+        if (factor >= 2) {
+            output.resize(2 * input.size());
+            up2.process_block(output.data(), input.data(), static_cast<long>(input.size()));
+            input.swap(output);
+        }
+        if (factor >= 4) {
+            output.resize(2 * input.size());
+            up4.process_block(output.data(), input.data(), static_cast<long>(input.size()));
+            input.swap(output);
+        }
+        if (factor >= 8) {
+            output.resize(2 * input.size());
+            up8.process_block(output.data(), input.data(), static_cast<long>(input.size()));
+            input.swap(output);
+        }
+        return input;
+    };
+
+    for (int factor : { 1, 2, 4, 8 }) {
+        INFO("Factor " << factor);
+        REQUIRE(sfz::StereoUpsampler::canProcess(factor));
+        const std::vector<float> expectedLeft = upsampleChannel(factor, left);
+        const std::vector<float> expectedRight = upsampleChannel(factor, right);
+
+        sfz::StereoUpsampler upsampler;
+        std::vector<float> output(2 * factor * numFrames);
+        std::vector<float> temp(std::max<size_t>(1, sfz::StereoUpsampler::recommendedBuffer(factor, blockSize)));
+        for (size_t frame = 0; frame < numFrames; frame += blockSize) {
+            const size_t current = std::min(numFrames - frame, blockSize);
+            upsampler.process(factor, &interleaved[2 * frame], &output[2 * factor * frame], current, temp.data());
+        }
+
+        for (size_t i = 0; i < factor * numFrames; ++i) {
+            REQUIRE(output[2 * i] == Approx(expectedLeft[i]).margin(1e-5));
+            REQUIRE(output[2 * i + 1] == Approx(expectedRight[i]).margin(1e-5));
+        }
+    }
+}
@@ -504,6 +504,35 @@ R"(#define $B foo-$A-baz
         REQUIRE(mock.fullBlockMembers == expectedMembers);
 }
 
+TEST_CASE("[Parsing] Recursive expansion follows the redefinitions")
+{
+        sfz::Parser parser;
+        ParsingMocker mock;
+        parser.setListener(&mock);
+        parser.parseString("/recursiveRedefinition.sfz",
+R"(#define $B foo-$A
+#define $A bar
+<region> sample=$B.wav
+#define $A baz
+<region> sample=$B.wav
+#define $C $C
+<region> sample=$C.wav)");
+
+        std::vector<std::vector<sfz::Opcode>> expectedMembers = {
+            {{"sample", "foo-bar.wav"}},
+            {{"sample", "foo-baz.wav"}},
+            {{"sample", ".wav"}},
+        };
+        std::vector<std::string> expectedHeaders = {
+            "region", "region", "region"
+        };
+
+        REQUIRE(mock.errors.empty());
+        REQUIRE(mock.warnings.size() == 1);
+        REQUIRE(mock.fullBlockHeaders == expectedHeaders);
+        REQUIRE(mock.fullBlockMembers == expectedMembers);
+}
+
 TEST_CASE("[Parsing] Strange #define behavior")
 {
         sfz::Parser parser;
@@ -746,3 +775,229 @@ TEST_CASE("[Parsing] Sample data 2")
         REQUIRE(mock.fullBlockHeaders == expectedHeaders);
         REQUIRE(mock.fullBlockMembers == expectedMembers);
 }
+
+TEST_CASE("[Parsing] Parses replayed from the cache")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_parse_cache_test";
+    const fs::path cacheDirectory = directory / "cache";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    const fs::path mainFile = directory / "main.sfz";
+    const fs::path includedFile = directory / "included.sfz";
+    auto writeFile = [](const fs::path& path, const std::string& text) {
+        fs::ofstream stream { path, std::ios::binary | std::ios::trunc };
+        stream << text;
+    };
+    writeFile(mainFile, "#define $KEY 60\n<group> volume=-3\n#include \"included.sfz\"\n");
+    writeFile(includedFile, "<region> sample=*sine key=$KEY\n<region> sample=*saw key=62\n");
+
+    auto parse = [&](sfz::Parser& parser) {
+        ParsingMocker mock;
+        parser.setListener(&mock);
+        parser.parseFile(mainFile);
+        parser.setListener(nullptr);
+        return mock;
+    };
+
+    sfz::Parser parser;
+    parser.setCacheDirectory(cacheDirectory);
+    const ParsingMocker parsed = parse(parser);
+    REQUIRE(!parser.isParsedFromCache());
+    REQUIRE(parsed.fullBlockHeaders == std::vector<std::string> { "group", "region", "region" });
+
+    const ParsingMocker replayed = parse(parser);
+    REQUIRE(parser.isParsedFromCache());
+    REQUIRE(replayed.beginnings == 1);
+    REQUIRE(replayed.endings == 1);
+    REQUIRE(replayed.headers == parsed.headers);
+    REQUIRE(replayed.fullBlockHeaders == parsed.fullBlockHeaders);
+    REQUIRE(replayed.fullBlockMembers.size() == parsed.fullBlockMembers.size());
+    for (size_t i = 0; i < parsed.fullBlockMembers.size(); ++i) {
+        REQUIRE(replayed.fullBlockMembers[i].size() == parsed.fullBlockMembers[i].size());
+        for (size_t j = 0; j < parsed.fullBlockMembers[i].size(); ++j) {
+            REQUIRE(replayed.fullBlockMembers[i][j].name == parsed.fullBlockMembers[i][j].name);
+            REQUIRE(replayed.fullBlockMembers[i][j].value == parsed.fullBlockMembers[i][j].value);
+        }
+    }
+    REQUIRE(parser.getIncludedFiles().size() == 2);
+    REQUIRE(parser.getDefines().at("KEY") == "60");
+    REQUIRE(parser.originalDirectory() == directory);
+
+    // Another definition or a change of an included file parses again
+    parser.addExternalDefinition("$OTHER", "1");
+    parse(parser);
+    REQUIRE(!parser.isParsedFromCache());
+    parser.clearExternalDefinitions();
+    parse(parser);
+    REQUIRE(parser.isParsedFromCache());
+
+    writeFile(includedFile, "<region> sample=*sine key=$KEY\n");
+    const ParsingMocker changed = parse(parser);
+    REQUIRE(!parser.isParsedFromCache());
+    REQUIRE(changed.fullBlockHeaders == std::vector<std::string> { "group", "region" });
+
+    // Without a cache directory, nothing is replayed
+    sfz::Parser uncached;
+    parse(uncached);
+    REQUIRE(!uncached.isParsedFromCache());
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("[Parsing] Converted files are kept in the parse cache")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_parse_convert_test";
+    const fs::path cacheDirectory = directory / "cache";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    const fs::path sourceFile = directory / "instrument.preset";
+    const fs::path virtualFile = directory / "instrument.preset.sfz";
+    auto writeFile = [](const fs::path& path, const std::string& text) {
+        fs::ofstream stream { path, std::ios::binary | std::ios::trunc };
+        stream << text;
+    };
+    writeFile(sourceFile, "60 62");
+
+    // One region by key of the source
+    int numConversions = 0;
+    const sfz::Parser::Converter convert = [&numConversions](const fs::path& file) {
+        ++numConversions;
+        fs::ifstream stream { file };
+        std::string text = "<group> volume=-3\n";
+        int key;
+        while (stream >> key)
+            text += "<region> sample=*sine key=" + std::to_string(key) + "\n";
+        return text;
+    };
+
+    auto parse = [&](sfz::Parser& parser) {
+        ParsingMocker mock;
+        parser.setListener(&mock);
+        parser.parseConvertedFile(virtualFile, sourceFile, convert);
+        parser.setListener(nullptr);
+        return mock;
+    };
+
+    sfz::Parser parser;
+    parser.setCacheDirectory(cacheDirectory);
+    const ParsingMocker parsed = parse(parser);
+    REQUIRE(!parser.isParsedFromCache());
+    REQUIRE(numConversions == 1);
+    REQUIRE(parsed.fullBlockHeaders == std::vector<std::string> { "group", "region", "region" });
+    REQUIRE(parser.getIncludedFiles().size() == 1);
+    REQUIRE(parser.getIncludedFiles().contains(sourceFile.string()));
+
+    const ParsingMocker replayed = parse(parser);
+    REQUIRE(parser.isParsedFromCache());
+    REQUIRE(numConversions == 1);
+    REQUIRE(replayed.fullBlockHeaders == parsed.fullBlockHeaders);
+    REQUIRE(replayed.fullBlockMembers.size() == parsed.fullBlockMembers.size());
+    for (size_t i = 0; i < parsed.fullBlockMembers.size(); ++i) {
+        REQUIRE(replayed.fullBlockMembers[i].size() == parsed.fullBlockMembers[i].size());
+        for (size_t j = 0; j < parsed.fullBlockMembers[i].size(); ++j) {
+            REQUIRE(replayed.fullBlockMembers[i][j].name == parsed.fullBlockMembers[i][j].name);
+            REQUIRE(replayed.fullBlockMembers[i][j].value == parsed.fullBlockMembers[i][j].value);
+        }
+    }
+    REQUIRE(parser.getIncludedFiles().contains(sourceFile.string()));
+    REQUIRE(parser.originalDirectory() == directory);
+
+    // A change of the source converts again
+    writeFile(sourceFile, "60 62 64");
+    const ParsingMocker changed = parse(parser);
+    REQUIRE(!parser.isParsedFromCache());
+    REQUIRE(numConversions == 2);
+    REQUIRE(changed.fullBlockHeaders == std::vector<std::string> { "group", "region", "region", "region" });
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("[Parsing] Files larger than the read buffer")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_parse_large_test";
+    const fs::path cacheDirectory = directory / "cache";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    // about 1 MB of regions, one by line, with an error on the last line
+    constexpr int numRegions = 20000;
+    const fs::path file = directory / "large.sfz";
+    {
+        fs::ofstream stream { file, std::ios::binary | std::ios::trunc };
+        for (int i = 0; i < numRegions; ++i)
+            stream << "<region> sample=*sine key=" << (i % 128) << " seq_position=" << (i % 8 + 1) << " // round robin\n";
+        stream << "#include \"missing.sfz\"\n";
+    }
+
+    sfz::Parser parser;
+    parser.setCacheDirectory(cacheDirectory);
+    ParsingMocker mock;
+    parser.setListener(&mock);
+    parser.parseFile(file);
+    REQUIRE(mock.fullBlockHeaders.size() == numRegions);
+    REQUIRE(mock.fullBlockMembers.back().size() == 3);
+    REQUIRE(mock.fullBlockMembers.back()[1].value == std::to_string((numRegions - 1) % 128));
+    REQUIRE(mock.errors.size() == 1);
+    REQUIRE(mock.errors[0].start.lineNumber == numRegions);
+    REQUIRE(mock.errors[0].start.columnNumber == 0);
+
+    // The parses with errors are not kept in the cache, nor their blocks
+    REQUIRE(fs::is_empty(cacheDirectory));
+    fs::remove_all(directory);
+}
+
+TEST_CASE("[Parsing] Included files read ahead of the parse")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_parse_prefetch_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory / "parts");
+
+    auto writeFile = [](const fs::path& path, const std::string& text) {
+        fs::ofstream stream { path, std::ios::binary | std::ios::trunc };
+        stream << text;
+    };
+
+    std::string main = "#define $DIR parts\n<group> volume=-3\n";
+    for (int i = 0; i < 40; ++i) {
+        const std::string part = "part" + std::to_string(i) + ".sfz";
+        main += (i % 3 == 0) ? "#include \"$DIR/" + part + "\"\n" : "#include \"parts\\\\" + part + "\"\n";
+        std::string text = "<region> sample=*sine key=" + std::to_string(i) + "\n";
+        if (i % 5 == 0)
+            text += "#include \"parts/nested" + std::to_string(i) + ".sfz\"\n";
+        writeFile(directory / "parts" / part, text);
+        writeFile(directory / "parts" / ("nested" + std::to_string(i) + ".sfz"), "<region> sample=*saw key=$DIR\n");
+    }
+    main += "#include \"parts/missing.sfz\"\n/* #include \"parts/part1.sfz\" */\n<region> sample=*square\n";
+    writeFile(directory / "main.sfz", main);
+
+    auto parse = [&](unsigned numThreads) {
+        sfz::Parser parser;
+        parser.setIncludePrefetchThreads(numThreads);
+        ParsingMocker mock;
+        parser.setListener(&mock);
+        parser.parseFile(directory / "main.sfz");
+        REQUIRE(parser.getIncludedFiles().size() == 1 + 40 + 8);
+        return mock;
+    };
+
+    const ParsingMocker sequential = parse(0);
+    REQUIRE(sequential.fullBlockHeaders.size() == 1 + 40 + 8 + 1);
+    REQUIRE(sequential.errors.size() == 1);
+
+    for (unsigned numThreads : { 1u, 4u }) {
+        const ParsingMocker prefetched = parse(numThreads);
+        REQUIRE(prefetched.headers == sequential.headers);
+        REQUIRE(prefetched.opcodes.size() == sequential.opcodes.size());
+        for (size_t i = 0; i < sequential.opcodes.size(); ++i) {
+            REQUIRE(prefetched.opcodes[i].name == sequential.opcodes[i].name);
+            REQUIRE(prefetched.opcodes[i].value == sequential.opcodes[i].value);
+        }
+        REQUIRE(prefetched.errors.size() == 1);
+        REQUIRE(prefetched.errors[0].start.lineNumber == sequential.errors[0].start.lineNumber);
+        REQUIRE(prefetched.warnings.size() == sequential.warnings.size());
+    }
+
+    fs::remove_all(directory);
+}
@@ -13,6 +13,8 @@
 // Need these for the introspection of Synth
 #include "sfizz/PolyphonyGroup.h"
 #include "sfizz/RegionSet.h"
+#include "sfizz/VoiceStealing.h"
+#include "sfizz/VoiceBudget.h"
 
 using namespace Catch::literals;
 using namespace sfz::literals;
@@ -657,3 +659,215 @@ TEST_CASE("[Polyphony] A note coming one sample before another note cannot choke
     synth.renderBlock(buffer);
     REQUIRE( playingSamples(synth) == std::vector<std::string> { "kick.wav", "snare.wav" } );
 }
+
+TEST_CASE("[Polyphony] Free voices are taken in the order of the list")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(100);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/polyphony.sfz", R"(
+        <region> sample=*sine ampeg_release=0
+    )");
+    for (int note = 0; note < 70; ++note)
+        synth.noteOn(0, note, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 70 );
+    for (int i = 0; i < 70; ++i)
+        REQUIRE( synth.getVoiceView(i)->getTriggerEvent().number == i );
+
+    // Free a voice in each word of the busy voices
+    synth.noteOff(0, 3, 0);
+    synth.noteOff(0, 66, 0);
+    for (int i = 0; i < 10; ++i)
+        synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 68 );
+    REQUIRE( synth.getVoiceView(3)->isFree() );
+    REQUIRE( synth.getVoiceView(66)->isFree() );
+
+    synth.noteOn(0, 100, 100);
+    synth.noteOn(0, 101, 100);
+    synth.noteOn(0, 102, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 71 );
+    REQUIRE( synth.getVoiceView(3)->getTriggerEvent().number == 100 );
+    REQUIRE( synth.getVoiceView(66)->getTriggerEvent().number == 101 );
+    REQUIRE( synth.getVoiceView(70)->getTriggerEvent().number == 102 );
+}
+
+TEST_CASE("[Polyphony] Off groups and note polyphony reach the voices past the first word")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(100);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/polyphony.sfz", R"(
+        <region> lokey=0 hikey=69 group=1 off_by=2 sample=*sine
+        <region> key=80 group=3 note_polyphony=1 sample=*sine
+        <region> key=100 group=2 sample=*saw
+    )");
+    for (int note = 0; note < 70; ++note)
+        synth.noteOn(0, note, 100);
+    synth.noteOn(0, 80, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( numPlayingVoices(synth) == 71 );
+
+    synth.noteOn(0, 80, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( numPlayingVoices(synth) == 71 );
+    REQUIRE( synth.getVoiceView(70)->offedOrFree() );
+    REQUIRE( !synth.getVoiceView(71)->offedOrFree() );
+
+    synth.noteOn(0, 100, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( numPlayingVoices(synth) == 2 );
+    REQUIRE( !synth.getVoiceView(71)->offedOrFree() );
+    REQUIRE( synth.getVoiceView(72)->getRegion()->sampleId->filename() == "*saw" );
+}
+
+namespace {
+
+// The envelope and age stealing, by a scan of the voices sorted by age
+sfz::Voice* sortedEnvelopeAndAge(std::vector<sfz::Voice*> voices)
+{
+    absl::c_sort(voices, sfz::voiceOrdering);
+    float sumPower = 0.0f;
+    for (const sfz::Voice* v : voices)
+        sumPower += v->getAveragePower();
+    const float powerThreshold = sumPower / voices.size() * sfz::config::stealingPowerCoeff;
+    const int ageThreshold = static_cast<int>(voices.front()->getAge() * sfz::config::stealingAgeCoeff);
+
+    for (sfz::Voice* ref : voices) {
+        if (ref->getAge() <= ageThreshold)
+            break;
+        float maxPower = 0.0f;
+        sfz::SisterVoiceRing::applyToRing(ref, [&](sfz::Voice* v) {
+            maxPower = std::max(maxPower, v->getAveragePower());
+        });
+        if (maxPower < powerThreshold)
+            return ref;
+    }
+    return voices.front();
+}
+
+} // namespace
+
+TEST_CASE("[Polyphony] Envelope and age stealing takes the first quiet old voice")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(64);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/polyphony.sfz", R"(
+        <region> key=0-63 sample=*sine ampeg_attack=0.02 ampeg_decay=0.2 ampeg_sustain=10
+        <region> key=32-63 sample=*saw ampeg_sustain=50
+    )");
+
+    sfz::EnvelopeAndAgeStealer stealer;
+    for (int note = 0; note < 64; note += 2) {
+        synth.noteOn(0, note, 1 + (note * 37) % 127);
+        synth.renderBlock(buffer);
+
+        std::vector<sfz::Voice*> voices;
+        for (int i = 0; i < synth.getNumVoices(); ++i) {
+            auto* voice = const_cast<sfz::Voice*>(synth.getVoiceView(i));
+            if (!voice->offedOrFree())
+                voices.push_back(voice);
+        }
+        const unsigned polyphony = static_cast<unsigned>(voices.size());
+        REQUIRE( stealer.checkPolyphony(absl::MakeSpan(voices), polyphony) == sortedEnvelopeAndAge(voices) );
+        REQUIRE( stealer.checkPolyphony(absl::MakeSpan(voices), polyphony + 1) == nullptr );
+    }
+}
+
+TEST_CASE("[Polyphony] Counts of playing voices in the groups and sets")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/polyphony.sfz", R"(
+        <master> polyphony=4
+        <group> group=1 polyphony=3
+        <region> sample=*sine key=65 ampeg_release=1
+    )");
+    const sfz::PolyphonyGroup* group = synth.getPolyphonyGroupView(1);
+    const sfz::RegionSet* master = synth.getRegionView(0)->parent->getParent();
+    REQUIRE( master->getLevel() == sfz::kOpcodeScopeMaster );
+
+    for (int i = 0; i < 5; ++i)
+        synth.noteOn(i, 65, 64);
+    REQUIRE( group->numPlayingVoices() == 3 );
+    REQUIRE( group->numOffedVoices() == 2 );
+    synth.renderBlock(buffer);
+    REQUIRE( group->numPlayingVoices() == 3 );
+    REQUIRE( master->numPlayingVoices() == 3 );
+    REQUIRE( master->numPlayingVoices() == numActiveVoices(synth) );
+
+    // The voices released by the note still count against the polyphony
+    synth.noteOff(0, 65, 0);
+    synth.renderBlock(buffer);
+    REQUIRE( group->numPlayingVoices() == 3 );
+    REQUIRE( master->numPlayingVoices() == numActiveVoices(synth) );
+
+    synth.noteOn(0, 65, 64);
+    REQUIRE( group->numPlayingVoices() == 3 );
+    REQUIRE( group->numPlayingVoices() + group->numOffedVoices() == group->getActiveVoices().size() );
+
+    synth.allSoundOff();
+    REQUIRE( group->getActiveVoices().empty() );
+    REQUIRE( group->numPlayingVoices() == 0 );
+    REQUIRE( master->numOffedVoices() == 0 );
+}
+
+TEST_CASE("[Polyphony] Voice budget shared across synths")
+{
+    sfz::VoiceBudget budget;
+    budget.setLimit(4);
+    sfz::Synth first;
+    sfz::Synth second;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(first.getSamplesPerBlock()) };
+    const std::string sfz = "<region> sample=*sine ampeg_release=1";
+    first.loadSfzString(fs::current_path() / "tests/TestFiles/budget.sfz", sfz);
+    second.loadSfzString(fs::current_path() / "tests/TestFiles/budget.sfz", sfz);
+    first.setVoiceBudget(&budget);
+    second.setVoiceBudget(&budget);
+
+    // A synth alone steals its own voices
+    for (int i = 0; i < 5; ++i)
+        first.noteOn(0, 60 + i, 64);
+    REQUIRE( numActiveVoices(first) == 4 );
+    REQUIRE( budget.getNumPlayingVoices() == 4 );
+    first.renderBlock(buffer);
+
+    // The older voices of the other synth go at the start of its next block
+    second.noteOn(0, 70, 64);
+    REQUIRE( numActiveVoices(second) == 1 );
+    REQUIRE( numActiveVoices(first) == 4 );
+    first.renderBlock(buffer);
+    second.renderBlock(buffer);
+    REQUIRE( numActiveVoices(first) == 3 );
+    REQUIRE( budget.getNumPlayingVoices() == 4 );
+
+    // The synths which leave do not count
+    first.setVoiceBudget(nullptr);
+    REQUIRE( budget.getNumPlayingVoices() == 1 );
+    second.noteOn(0, 71, 64);
+    REQUIRE( numActiveVoices(second) == 2 );
+}
+
+TEST_CASE("[Polyphony] Voice budget weights")
+{
+    REQUIRE( sfz::VoiceBudget::getPriority(2.0f, 0.0f, 1.0f) < sfz::VoiceBudget::getPriority(1.0f, 0.0f, 1.0f) );
+    REQUIRE( sfz::VoiceBudget::getPriority(1.0f, 0.0f, 1.0f) < sfz::VoiceBudget::getPriority(1.0f, 0.5f, 1.0f) );
+    REQUIRE( sfz::VoiceBudget::getPriority(1.0f, 0.0f, 1.0f) < sfz::VoiceBudget::getPriority(1.0f, 0.0f, 2.0f) );
+
+    sfz::VoiceBudget budget;
+    const int light = budget.join(1.0f);
+    const int heavy = budget.join(4.0f);
+    REQUIRE( budget.findVictim() == -1 );
+    budget.setVictimPriority(light, sfz::VoiceBudget::getPriority(1.0f, 0.0f, budget.getWeight(light)));
+    budget.setVictimPriority(heavy, sfz::VoiceBudget::getPriority(2.0f, 0.0f, budget.getWeight(heavy)));
+    REQUIRE( budget.findVictim() == light );
+    budget.requestSteal(light);
+    budget.requestSteal(light);
+    REQUIRE( budget.takeStealRequests(light) == 2 );
+    REQUIRE( budget.takeStealRequests(light) == 0 );
+    budget.leave(light);
+    REQUIRE( budget.findVictim() == heavy );
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/QualityGovernor.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "sfizz/Config.h"
+#include "catch2/catch.hpp"
+using namespace Catch::literals;
+
+TEST_CASE("[QualityGovernor] Reduced qualities")
+{
+    // sinc12 -> sinc8 -> hermite, and no lower
+    REQUIRE(sfz::QualityGovernor::reduceSampleQuality(4, 0) == 4);
+    REQUIRE(sfz::QualityGovernor::reduceSampleQuality(4, 1) == 3);
+    REQUIRE(sfz::QualityGovernor::reduceSampleQuality(4, 2) == 2);
+    REQUIRE(sfz::QualityGovernor::reduceSampleQuality(4, 5) == 2);
+    REQUIRE(sfz::QualityGovernor::reduceSampleQuality(1, 5) == 1);
+    REQUIRE(sfz::QualityGovernor::reduceSampleQuality(10, 8) == 2);
+
+    REQUIRE(sfz::QualityGovernor::reduceOscillatorQuality(3, 1) == 2);
+    REQUIRE(sfz::QualityGovernor::reduceOscillatorQuality(3, 5) == 1);
+    REQUIRE(sfz::QualityGovernor::reduceOscillatorQuality(0, 5) == 0);
+}
+
+TEST_CASE("[QualityGovernor] Qualities adapted to the playback ratios")
+{
+    // hermite near unity, within the ceiling
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(10, 0.95f, 1.05f) == 2);
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(1, 0.95f, 1.05f) == 1);
+
+    // longer sincs further up
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(10, 1.1f, 1.1f) == 4);
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(10, 1.0f, 1.4f) == 6);
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(10, 1.9f, 1.9f) == 8);
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(10, 3.0f, 3.0f) == 10);
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(5, 3.0f, 3.0f) == 5);
+
+    // strongly down
+    REQUIRE(sfz::QualityGovernor::adaptSampleQuality(10, 0.25f, 0.25f) == 3);
+}
+
+TEST_CASE("[QualityGovernor] Steps down under load and back up")
+{
+    sfz::QualityGovernor governor;
+    const double deadline = 0.005;
+
+    governor.update(0.1 * deadline, deadline);
+    REQUIRE(governor.getQualityReduction() == 0);
+
+    // a heavy block lowers the quality once, then holds
+    governor.update(0.9 * deadline, deadline);
+    REQUIRE(governor.getQualityReduction() == 1);
+    for (int i = 0; i < sfz::config::qualityGovernorHoldBlocks; ++i)
+        governor.update(0.9 * deadline, deadline);
+    REQUIRE(governor.getQualityReduction() == 1);
+    governor.update(0.9 * deadline, deadline);
+    REQUIRE(governor.getQualityReduction() == 2);
+
+    // the reduction is bounded
+    for (int i = 0; i < 100 * sfz::config::qualityGovernorHoldBlocks; ++i)
+        governor.update(0.9 * deadline, deadline);
+    REQUIRE(governor.getQualityReduction() == sfz::config::qualityGovernorMaxSteps);
+
+    // the load decays slowly, and the quality comes back step by step
+    governor.update(0.1 * deadline, deadline);
+    REQUIRE(governor.getLoad() > sfz::config::qualityGovernorLowLoad);
+    for (int i = 0; i < 100 * sfz::config::qualityGovernorHoldBlocks; ++i)
+        governor.update(0.1 * deadline, deadline);
+    REQUIRE(governor.getQualityReduction() == 0);
+
+    governor.update(0.9 * deadline, deadline);
+    governor.clear();
+    REQUIRE(governor.getQualityReduction() == 0);
+    REQUIRE(governor.getLoad() == 0.0);
+}
+
+TEST_CASE("[QualityGovernor] Synth control")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    REQUIRE(!synth.isQualityGovernorEnabled());
+    synth.enableQualityGovernor(true);
+    REQUIRE(synth.isQualityGovernorEnabled());
+    synth.renderBlock(buffer);
+    synth.enableQualityGovernor(false);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getQualityReduction() == 0);
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+// The listeners are among the external interfaces
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
+#include "sfizz/RealtimeGuard.h"
+#include "sfizz/Synth.h"
+#include "TestHelpers.h"
+#include "catch2/catch.hpp"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using sfz::RealtimeGuard;
+
+namespace {
+
+/**
+ * @brief Report the real-time violations of each test case, so that the test
+ * suite built with SFIZZ_RT_CHECKS checks all the processing it runs.
+ */
+struct RealtimeGuardListener : Catch::TestEventListenerBase {
+    using TestEventListenerBase::TestEventListenerBase;
+
+    void testCaseStarting(const Catch::TestCaseInfo&) override
+    {
+        RealtimeGuard::resetViolations();
+    }
+
+    void testCaseEnded(const Catch::TestCaseStats& stats) override
+    {
+        if (RealtimeGuard::getTotalViolations() == 0)
+            return;
+
+        std::cerr << "Real-time violations in " << stats.testInfo.name << ": "
+                  << RealtimeGuard::getViolations(RealtimeGuard::Allocation) << " allocations, "
+                  << RealtimeGuard::getViolations(RealtimeGuard::Deallocation) << " deallocations, "
+                  << RealtimeGuard::getViolations(RealtimeGuard::Lock) << " locks, "
+                  << RealtimeGuard::getViolations(RealtimeGuard::FileAccess) << " file accesses\n";
+    }
+};
+
+} // namespace
+
+CATCH_REGISTER_LISTENER(RealtimeGuardListener)
+
+TEST_CASE("[RealtimeGuard] Violations of the audio scopes")
+{
+    RealtimeGuard::resetViolations();
+    RealtimeGuard::setReportLimit(0);
+
+    std::unique_ptr<int> outside { new int(1) };
+    outside.reset();
+    REQUIRE(RealtimeGuard::getTotalViolations() == 0);
+
+    {
+        RealtimeGuard::Scope scope;
+        std::unique_ptr<int> inside { new int(1) };
+        inside.reset();
+    }
+
+    if (RealtimeGuard::isEnabled()) {
+        REQUIRE(RealtimeGuard::getViolations(RealtimeGuard::Allocation) == 1);
+        REQUIRE(RealtimeGuard::getViolations(RealtimeGuard::Deallocation) == 1);
+    } else {
+        REQUIRE(RealtimeGuard::getTotalViolations() == 0);
+    }
+
+    RealtimeGuard::resetViolations();
+    REQUIRE(RealtimeGuard::getTotalViolations() == 0);
+    RealtimeGuard::setReportLimit(sfz::config::realtimeGuardReports);
+}
+
+TEST_CASE("[RealtimeGuard] Violation messages")
+{
+    sfz::Synth synth;
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.dispatchMessage(client, 0, "/stats/realtime/reset", "", nullptr);
+    synth.dispatchMessage(client, 0, "/stats/realtime/locks", "", nullptr);
+    REQUIRE(messageList.size() == 1);
+    REQUIRE(messageList[0] == "/stats/realtime/locks,h : { 0 }");
+}
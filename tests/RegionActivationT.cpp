@@ -47,6 +47,34 @@ TEST_CASE("Region activation", "Region tests")
         REQUIRE(!layer.isSwitchedOn());
     }
 
+    SECTION("Repeated CC values")
+    {
+        region.parseOpcode({ "locc4", "56" });
+        region.parseOpcode({ "hicc4", "59" });
+        region.parseOpcode({ "locc54", "18" });
+        region.parseOpcode({ "hicc54", "27" });
+        sfz::Layer layer { region, midiState };
+        for (int i = 0; i < 3; ++i) {
+            layer.updateCCState(4, 0_norm);
+            layer.updateCCState(54, 0_norm);
+        }
+        REQUIRE(!layer.isSwitchedOn());
+        for (int i = 0; i < 3; ++i)
+            layer.updateCCState(4, 57_norm);
+        REQUIRE(!layer.isSwitchedOn());
+        REQUIRE(!layer.isCCSwitchedOn());
+        for (int i = 0; i < 3; ++i)
+            layer.updateCCState(54, 20_norm);
+        REQUIRE(layer.isSwitchedOn());
+        layer.updateCCState(4, 60_norm);
+        layer.updateCCState(4, 61_norm);
+        REQUIRE(!layer.isSwitchedOn());
+        layer.updateCCState(4, 58_norm);
+        REQUIRE(layer.isSwitchedOn());
+        layer.initializeActivations();
+        REQUIRE(layer.isCCSwitchedOn());
+    }
+
     SECTION("Multiple CC ranges")
     {
         region.parseOpcode({ "locc4", "56" });
@@ -570,3 +570,31 @@ TEST_CASE("[Triggers] Respect poly-aftertouch note values when triggering on cc1
     synth.polyAftertouch(10, 57, 127);
     REQUIRE(playingSamples(synth) == std::vector<std::string> { "*saw", "*sine" });
 }
+
+TEST_CASE("[Triggers] Trigger members set by messages")
+{
+    Synth synth;
+    std::vector<std::string> messageList;
+    Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/trigger_messages.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+
+    sfizz_arg_t args[2];
+    args[0].f = 0.5f;
+    args[1].f = 1.0f;
+    synth.dispatchMessage(client, 0, "/region0/vel_range", "ff", args);
+    synth.noteOn(0, 60, 20);
+    REQUIRE(playingSamples(synth) == std::vector<std::string> { });
+    synth.noteOff(0, 60, 0);
+
+    args[0].f = 0.0f;
+    synth.dispatchMessage(client, 0, "/region0/vel_range", "ff", args);
+    args[0].s = "release_key";
+    synth.dispatchMessage(client, 0, "/region0/trigger", "s", args);
+    synth.noteOn(0, 60, 100);
+    REQUIRE(playingSamples(synth) == std::vector<std::string> { });
+    synth.noteOff(10, 60, 0);
+    REQUIRE(playingSamples(synth) == std::vector<std::string> { "*sine" });
+}
@@ -51,6 +51,14 @@ TEST_CASE("Set values", "[parsing][OSC]")
         REQUIRE( d.sendAndRead("/freewheeling_oscillator_quality", 2) == 2);
     }
 
+    SECTION("Effect quality") {
+        d.load(R"( <region> sample=kick.wav )");
+        REQUIRE( d.read<int32_t>("/effect_quality") == 3);
+        REQUIRE( d.read<int32_t>("/freewheeling_effect_quality") == 3);
+        REQUIRE( d.sendAndRead("/effect_quality", 1) == 1);
+        REQUIRE( d.sendAndRead("/freewheeling_effect_quality", 2) == 2);
+    }
+
     SECTION("Sustain cancels release") {
         d.load(R"( <region> sample=kick.wav )");
         REQUIRE( d.read<OSC>("/sustain_cancels_release") == OSC::False );
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/Synth.h"
+#include "sfizz/SIMDHelpers.h"
+#include "sfizz/AudioBuffer.h"
+#include "TestHelpers.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Render the instruments with the scalar kernels, then with the kernels of
+// each backend, and compare the outputs.
+
+namespace {
+
+struct DifferentialInstrument {
+    const char* name;
+    const char* text;
+};
+
+const DifferentialInstrument differentialInstruments[] = {
+    { "oscillator", R"(
+        <region> sample=*sine ampeg_attack=0.01 ampeg_release=0.1
+    )" },
+    { "filtered", R"(
+        <region> sample=*saw fil_type=lpf_2p cutoff=1200 resonance=6
+            lfo1_freq=5 lfo1_cutoff=1200 eq1_freq=800 eq1_gain=6
+    )" },
+    { "sampled", R"(
+        <region> lokey=0 hikey=59 sample=kick.wav eq1_freq=200 eq1_gain=-6
+        <region> lokey=60 hikey=127 sample=closedhat.wav pan=-30 width=50
+    )" },
+    { "looped", R"(
+        <region> sample=looped_flute.wav loop_mode=loop_continuous pitch_keycenter=60
+            ampeg_decay=0.5 ampeg_sustain=50
+    )" },
+    { "unison", R"(
+        <region> sample=*tri oscillator_multi=5 oscillator_detune=20 pitch_oncc1=100
+    )" },
+};
+
+constexpr int differentialBlockSize { 256 };
+constexpr int differentialNumBlocks { 16 };
+
+// Force the scalar kernels for all the operations, then select the kernels of
+// a backend where it has some; returns whether any operation took them
+bool selectBackend(sfz::SIMDBackend backend)
+{
+    bool selected = false;
+    for (int i = 0; i < static_cast<int>(sfz::SIMDOps::_sentinel); ++i) {
+        const auto op = static_cast<sfz::SIMDOps>(i);
+        sfz::setSIMDOpStatus<float>(op, false);
+        if (backend != sfz::SIMDBackend::scalar)
+            selected |= sfz::setSIMDOpBackend<float>(op, backend);
+    }
+    return selected || backend == sfz::SIMDBackend::scalar;
+}
+
+// The interleaved output of an instrument, loaded and rendered with the
+// selected kernels
+std::vector<float> renderDifferential(const DifferentialInstrument& instrument)
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(differentialBlockSize);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/simd_differential.sfz", instrument.text);
+
+    sfz::AudioBuffer<float> buffer { 2, differentialBlockSize };
+    std::vector<float> output;
+    output.reserve(2 * differentialBlockSize * differentialNumBlocks);
+
+    for (int block = 0; block < differentialNumBlocks; ++block) {
+        if (block == 0) {
+            synth.noteOn(0, 48, 100);
+            synth.noteOn(17, 64, 80);
+            synth.noteOn(101, 71, 63);
+        } else if (block == 4) {
+            synth.cc(5, 1, 64);
+        } else if (block == 8) {
+            synth.noteOff(32, 48, 0);
+            synth.noteOff(32, 64, 0);
+            synth.noteOff(32, 71, 0);
+        }
+        synth.renderBlock(buffer);
+        for (int i = 0; i < differentialBlockSize; ++i) {
+            output.push_back(buffer.getSample(0, i));
+            output.push_back(buffer.getSample(1, i));
+        }
+    }
+
+    return output;
+}
+
+} // namespace
+
+TEST_CASE("[SIMDDifferential] The backends render as the scalar kernels")
+{
+    for (const DifferentialInstrument& instrument : differentialInstruments) {
+        selectBackend(sfz::SIMDBackend::scalar);
+        const std::vector<float> reference = renderDifferential(instrument);
+        REQUIRE(std::any_of(reference.begin(), reference.end(), [](float x) { return x != 0.0f; }));
+
+        for (auto backend : { sfz::SIMDBackend::sse, sfz::SIMDBackend::avx, sfz::SIMDBackend::neon }) {
+            if (!selectBackend(backend))
+                continue;
+
+            const std::vector<float> output = renderDifferential(instrument);
+            REQUIRE(output.size() == reference.size());
+
+            double maxDeviation = 0.0;
+            double sumSquares = 0.0;
+            for (size_t i = 0; i < output.size(); ++i) {
+                const double deviation = std::abs(output[i] - reference[i]);
+                maxDeviation = std::max(maxDeviation, deviation);
+                sumSquares += deviation * deviation;
+            }
+            const double rmsDeviation = std::sqrt(sumSquares / output.size());
+
+            INFO("Instrument " << instrument.name << ", backend " << sfz::simdBackendName(backend));
+            CHECK(maxDeviation < 5e-3);
+            CHECK(rmsDeviation < 5e-4);
+        }
+    }
+
+    sfz::resetSIMDOpStatus<float>();
+}
@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/*
+   The AVX versions against the SSE versions, called directly, since the
+   dispatcher only ever selects one of them on a given machine.
+ */
+
+#include "sfizz/simd/HelpersSSE.h"
+#include "sfizz/simd/HelpersAVX.h"
+#include "sfizz/simd/HelpersScalar.h"
+#include "cpuid/cpuinfo.hpp"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Odd sizes and offsets, for the ends which do not fill a register
+constexpr unsigned sizes[] { 0, 1, 7, 8, 15, 33, 1023 };
+constexpr unsigned offsets[] { 0, 1, 3 };
+constexpr unsigned maxSize { 1023 + 3 };
+
+bool canRunAVX()
+{
+    static const bool canRun = []() {
+        cpuid::cpuinfo info;
+        return helpersAVXAvailable() && info.has_avx2() && info.has_fma3();
+    }();
+    return canRun;
+}
+
+std::vector<float> randomVector(unsigned size, float low = -1.0f, float high = 1.0f)
+{
+    static std::minstd_rand prng;
+    std::uniform_real_distribution<float> dist { low, high };
+    std::vector<float> vector(size);
+    for (float& x : vector)
+        x = dist(prng);
+    return vector;
+}
+
+void requireClose(const std::vector<float>& expected, const std::vector<float>& actual, float epsilon = 1e-6f)
+{
+    REQUIRE(expected.size() == actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        INFO("Index " << i);
+        REQUIRE(actual[i] == Approx(expected[i]).epsilon(epsilon).margin(std::max(1e-6f, epsilon)));
+    }
+}
+
+/**
+ * @brief Run the unary operations in place from the same input, for all the
+ * sizes and offsets
+ */
+template <class F, class G>
+void compareInPlace(F&& sse, G&& avx, float low = -1.0f, float high = 1.0f, float epsilon = 1e-6f)
+{
+    const std::vector<float> input = randomVector(maxSize, low, high);
+    for (unsigned offset : offsets) {
+        for (unsigned size : sizes) {
+            INFO("Size " << size << ", offset " << offset);
+            std::vector<float> expected = input;
+            std::vector<float> actual = input;
+            sse(expected.data() + offset, size);
+            avx(actual.data() + offset, size);
+            requireClose(expected, actual, epsilon);
+        }
+    }
+}
+
+/**
+ * @brief Run the binary operations from an input into an output, for all the
+ * sizes and offsets
+ */
+template <class F, class G>
+void compareBinary(F&& sse, G&& avx, float low = -1.0f, float high = 1.0f, float epsilon = 1e-6f)
+{
+    const std::vector<float> input = randomVector(maxSize, low, high);
+    const std::vector<float> output = randomVector(maxSize);
+    for (unsigned offset : offsets) {
+        for (unsigned size : sizes) {
+            INFO("Size " << size << ", offset " << offset);
+            std::vector<float> expected = output;
+            std::vector<float> actual = output;
+            sse(input.data() + offset, expected.data(), size);
+            avx(input.data() + offset, actual.data(), size);
+            requireClose(expected, actual, epsilon);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("[HelpersAVX] Interleaved reads and writes")
+{
+    if (!canRunAVX())
+        return;
+
+    for (unsigned size : sizes) {
+        INFO("Size " << size);
+        const unsigned numFrames = size / 2;
+        // The SSE versions need a frame at least
+        if (numFrames == 0)
+            continue;
+
+        const std::vector<float> interleaved = randomVector(2 * numFrames);
+        std::vector<float> expectedLeft(numFrames), expectedRight(numFrames);
+        std::vector<float> left(numFrames), right(numFrames);
+        readInterleavedSSE(interleaved.data(), expectedLeft.data(), expectedRight.data(), 2 * numFrames);
+        readInterleavedAVX(interleaved.data(), left.data(), right.data(), 2 * numFrames);
+        requireClose(expectedLeft, left);
+        requireClose(expectedRight, right);
+
+        std::vector<int16_t> interleaved16(2 * numFrames);
+        std::minstd_rand prng;
+        std::uniform_int_distribution<int> dist16 { -32768, 32767 };
+        for (int16_t& x : interleaved16)
+            x = static_cast<int16_t>(dist16(prng));
+        readInterleavedInt16SSE(interleaved16.data(), expectedLeft.data(), expectedRight.data(), 2 * numFrames);
+        readInterleavedInt16AVX(interleaved16.data(), left.data(), right.data(), 2 * numFrames);
+        requireClose(expectedLeft, left);
+        requireClose(expectedRight, right);
+
+        std::vector<uint8_t> interleaved24(6 * numFrames);
+        std::uniform_int_distribution<int> dist8 { 0, 255 };
+        for (uint8_t& x : interleaved24)
+            x = static_cast<uint8_t>(dist8(prng));
+        readInterleavedInt24SSE(interleaved24.data(), expectedLeft.data(), expectedRight.data(), 2 * numFrames);
+        readInterleavedInt24AVX(interleaved24.data(), left.data(), right.data(), 2 * numFrames);
+        requireClose(expectedLeft, left);
+        requireClose(expectedRight, right);
+
+        std::vector<float> expectedInterleaved = randomVector(2 * numFrames);
+        std::vector<float> actualInterleaved = expectedInterleaved;
+        writeInterleavedSSE(expectedLeft.data(), expectedRight.data(), expectedInterleaved.data(), 2 * numFrames);
+        writeInterleavedAVX(left.data(), right.data(), actualInterleaved.data(), 2 * numFrames);
+        requireClose(expectedInterleaved, actualInterleaved);
+
+        addInterleavedSSE(expectedLeft.data(), expectedRight.data(), expectedInterleaved.data(), 2 * numFrames);
+        addInterleavedAVX(left.data(), right.data(), actualInterleaved.data(), 2 * numFrames);
+        requireClose(expectedInterleaved, actualInterleaved);
+    }
+}
+
+TEST_CASE("[HelpersAVX] Gains and products")
+{
+    if (!canRunAVX())
+        return;
+
+    const std::vector<float> gains = randomVector(maxSize, 0.5f, 2.0f);
+
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { gainSSE(gains.data(), in, out, size); },
+        [&](const float* in, float* out, unsigned size) { gainAVX(gains.data(), in, out, size); });
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { gain1SSE(0.3f, in, out, size); },
+        [&](const float* in, float* out, unsigned size) { gain1AVX(0.3f, in, out, size); });
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { divideSSE(in, gains.data(), out, size); },
+        [&](const float* in, float* out, unsigned size) { divideAVX(in, gains.data(), out, size); });
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { multiplyAddSSE(gains.data(), in, out, size); },
+        [&](const float* in, float* out, unsigned size) { multiplyAddAVX(gains.data(), in, out, size); });
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { multiplyAdd1SSE(0.3f, in, out, size); },
+        [&](const float* in, float* out, unsigned size) { multiplyAdd1AVX(0.3f, in, out, size); });
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { multiplyMulSSE(gains.data(), in, out, size); },
+        [&](const float* in, float* out, unsigned size) { multiplyMulAVX(gains.data(), in, out, size); });
+    compareBinary(
+        [&](const float* in, float* out, unsigned size) { multiplyMul1SSE(0.3f, in, out, size); },
+        [&](const float* in, float* out, unsigned size) { multiplyMul1AVX(0.3f, in, out, size); });
+}
+
+TEST_CASE("[HelpersAVX] Gains to multiple outputs")
+{
+    if (!canRunAVX())
+        return;
+
+    const std::vector<float> input = randomVector(maxSize);
+    const std::vector<float> gains = randomVector(11);
+    for (unsigned numOutputs : { 1u, 8u, 11u }) {
+        for (unsigned size : sizes) {
+            INFO(numOutputs << " outputs, size " << size);
+            std::vector<std::vector<float>> expected(numOutputs, randomVector(size));
+            std::vector<std::vector<float>> actual = expected;
+            std::vector<float*> expectedOutputs, actualOutputs;
+            for (unsigned j = 0; j < numOutputs; ++j) {
+                expectedOutputs.push_back(expected[j].data());
+                actualOutputs.push_back(actual[j].data());
+            }
+            multiplyAdd1MultiSSE(gains.data(), input.data(), expectedOutputs.data(), numOutputs, size);
+            multiplyAdd1MultiAVX(gains.data(), input.data(), actualOutputs.data(), numOutputs, size);
+            for (unsigned j = 0; j < numOutputs; ++j)
+                requireClose(expected[j], actual[j]);
+        }
+    }
+}
+
+TEST_CASE("[HelpersAVX] Ramps")
+{
+    if (!canRunAVX())
+        return;
+
+    compareInPlace(
+        [](float* out, unsigned size) { REQUIRE(linearRampSSE(out, 0.5f, 0.01f, size) == Approx(0.5f + 0.01f * size)); },
+        [](float* out, unsigned size) { REQUIRE(linearRampAVX(out, 0.5f, 0.01f, size) == Approx(0.5f + 0.01f * size)); },
+        -1.0f, 1.0f, 1e-5f);
+    compareInPlace(
+        [](float* out, unsigned size) { multiplicativeRampSSE(out, 0.5f, 1.001f, size); },
+        [](float* out, unsigned size) { multiplicativeRampAVX(out, 0.5f, 1.001f, size); },
+        -1.0f, 1.0f, 1e-5f);
+}
+
+TEST_CASE("[HelpersAVX] Sums and differences")
+{
+    if (!canRunAVX())
+        return;
+
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { addSSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { addAVX(in, out, size); });
+    compareInPlace(
+        [](float* out, unsigned size) { add1SSE(0.3f, out, size); },
+        [](float* out, unsigned size) { add1AVX(0.3f, out, size); });
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { subtractSSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { subtractAVX(in, out, size); });
+    compareInPlace(
+        [](float* out, unsigned size) { subtract1SSE(0.3f, out, size); },
+        [](float* out, unsigned size) { subtract1AVX(0.3f, out, size); });
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { copySSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { copyAVX(in, out, size); });
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { cumsumSSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { cumsumAVX(in, out, size); },
+        -1.0f, 1.0f, 1e-4f);
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { diffSSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { diffAVX(in, out, size); });
+
+    const std::vector<float> input = randomVector(maxSize);
+    for (unsigned offset : offsets) {
+        for (unsigned size : sizes) {
+            INFO("Size " << size << ", offset " << offset);
+            const float* vector = input.data() + offset;
+            REQUIRE(meanAVX(vector, size) == Approx(meanSSE(vector, size)).margin(1e-5));
+            REQUIRE(sumSquaresAVX(vector, size) == Approx(sumSquaresSSE(vector, size)).epsilon(1e-5));
+        }
+    }
+}
+
+TEST_CASE("[HelpersAVX] Ranges")
+{
+    if (!canRunAVX())
+        return;
+
+    compareInPlace(
+        [](float* out, unsigned size) { clampAllSSE(out, -0.5f, 0.5f, size); },
+        [](float* out, unsigned size) { clampAllAVX(out, -0.5f, 0.5f, size); });
+
+    std::vector<float> input = randomVector(maxSize);
+    for (unsigned size : sizes) {
+        INFO("Size " << size);
+        REQUIRE(allWithinAVX(input.data(), -1.0f, 1.0f, size) == allWithinSSE(input.data(), -1.0f, 1.0f, size));
+        REQUIRE(allWithinAVX(input.data(), -0.5f, 0.5f, size) == allWithinSSE(input.data(), -0.5f, 0.5f, size));
+        if (size > 0) {
+            std::vector<float> outside = input;
+            outside[size - 1] = 2.0f;
+            REQUIRE(!allWithinAVX(outside.data(), -1.0f, 1.0f, size));
+        }
+    }
+}
+
+TEST_CASE("[HelpersAVX] Powers of 2")
+{
+    if (!canRunAVX())
+        return;
+
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { centsFactorSSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { centsFactorAVX(in, out, size); },
+        -12000.0f, 12000.0f, 2e-7f);
+    compareBinary(
+        [](const float* in, float* out, unsigned size) { db2magSSE(in, out, size); },
+        [](const float* in, float* out, unsigned size) { db2magAVX(in, out, size); },
+        -144.0f, 24.0f, 2e-7f);
+}
+
+TEST_CASE("[HelpersAVX] Interpolation positions")
+{
+    if (!canRunAVX())
+        return;
+
+    const std::vector<float> pitch = randomVector(maxSize, -1200.0f, 1200.0f);
+    const int64_t start = fixedPosition(100.25);
+    for (bool constant : { false, true }) {
+        for (unsigned size : sizes) {
+            INFO("Size " << size << (constant ? ", constant" : ""));
+            const float* pitchData = constant ? nullptr : pitch.data();
+            std::vector<int> indicesSSE(size);
+            std::vector<int> indicesAVX(size);
+            std::vector<float> coeffsSSE(size);
+            std::vector<float> coeffsAVX(size);
+            const int64_t lastSSE = interpolationPositionsSSE(pitchData, 1.3f, start, indicesSSE.data(), coeffsSSE.data(), size);
+            const int64_t lastAVX = interpolationPositionsAVX(pitchData, 1.3f, start, indicesAVX.data(), coeffsAVX.data(), size);
+            if (constant) {
+                REQUIRE(lastAVX == lastSSE);
+                REQUIRE(indicesAVX == indicesSSE);
+                REQUIRE(coeffsAVX == coeffsSSE);
+                continue;
+            }
+            // The jumps from the pitch round apart, and the positions may
+            // fall on either side of an integer
+            for (unsigned i = 0; i < size; ++i) {
+                INFO("Index " << i);
+                const double positionSSE = indicesSSE[i] + static_cast<double>(coeffsSSE[i]);
+                const double positionAVX = indicesAVX[i] + static_cast<double>(coeffsAVX[i]);
+                REQUIRE(positionAVX == Approx(positionSSE).epsilon(1e-6));
+            }
+            REQUIRE(static_cast<double>(lastAVX) == Approx(static_cast<double>(lastSSE)).epsilon(1e-6));
+        }
+    }
+}
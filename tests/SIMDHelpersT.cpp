@@ -182,6 +182,76 @@ TEST_CASE("[Helpers] Interleaved read SIMD vs Scalar")
     REQUIRE(rightOutputScalar == rightOutputSIMD);
 }
 
+TEST_CASE("[Helpers] Interleaved 16-bit read")
+{
+    std::array<int16_t, 10> input { 0, -32768, 16384, 32767, -16384, 1, -1, 8192, 2, -2 };
+    std::array<float, 5> expectedLeft { 0.0f, 0.5f, -0.5f, -1.0f / 32768, 2.0f / 32768 };
+    std::array<float, 5> expectedRight { -1.0f, 32767.0f / 32768, 1.0f / 32768, 0.25f, -2.0f / 32768 };
+    for (bool simd : { false, true }) {
+        std::array<float, 5> leftOutput;
+        std::array<float, 5> rightOutput;
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt16, simd);
+        sfz::readInterleavedInt16(input, absl::MakeSpan(leftOutput), absl::MakeSpan(rightOutput));
+        REQUIRE(leftOutput == expectedLeft);
+        REQUIRE(rightOutput == expectedRight);
+    }
+}
+
+TEST_CASE("[Helpers] Interleaved 16-bit read SIMD vs Scalar")
+{
+    std::vector<int16_t> input(medBufferSize * 2 + 2);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<int16_t>(i * 997);
+    std::array<float, medBufferSize> leftOutputScalar;
+    std::array<float, medBufferSize> rightOutputScalar;
+    std::array<float, medBufferSize> leftOutputSIMD;
+    std::array<float, medBufferSize> rightOutputSIMD;
+    const auto unalignedInput = absl::MakeConstSpan(input).subspan(1, medBufferSize * 2);
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt16, false);
+    sfz::readInterleavedInt16(unalignedInput, absl::MakeSpan(leftOutputScalar), absl::MakeSpan(rightOutputScalar));
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt16, true);
+    sfz::readInterleavedInt16(unalignedInput, absl::MakeSpan(leftOutputSIMD), absl::MakeSpan(rightOutputSIMD));
+    REQUIRE(leftOutputScalar == leftOutputSIMD);
+    REQUIRE(rightOutputScalar == rightOutputSIMD);
+}
+
+TEST_CASE("[Helpers] Interleaved 24-bit read")
+{
+    std::array<uint8_t, 18> input {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+        0x00, 0x00, 0x40, 0xff, 0xff, 0x7f,
+        0x01, 0x00, 0x00, 0xff, 0xff, 0xff,
+    };
+    std::array<float, 3> expectedLeft { 0.0f, 0.5f, 1.0f / 8388608 };
+    std::array<float, 3> expectedRight { -1.0f, 8388607.0f / 8388608, -1.0f / 8388608 };
+    for (bool simd : { false, true }) {
+        std::array<float, 3> leftOutput;
+        std::array<float, 3> rightOutput;
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt24, simd);
+        sfz::readInterleavedInt24(input, absl::MakeSpan(leftOutput), absl::MakeSpan(rightOutput));
+        REQUIRE(leftOutput == expectedLeft);
+        REQUIRE(rightOutput == expectedRight);
+    }
+}
+
+TEST_CASE("[Helpers] Interleaved 24-bit read SIMD vs Scalar")
+{
+    std::vector<uint8_t> input(medBufferSize * 6 + 1);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+    std::array<float, medBufferSize> leftOutputScalar;
+    std::array<float, medBufferSize> rightOutputScalar;
+    std::array<float, medBufferSize> leftOutputSIMD;
+    std::array<float, medBufferSize> rightOutputSIMD;
+    const auto unalignedInput = absl::MakeConstSpan(input).subspan(1, medBufferSize * 6);
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt24, false);
+    sfz::readInterleavedInt24(unalignedInput, absl::MakeSpan(leftOutputScalar), absl::MakeSpan(rightOutputScalar));
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::readInterleavedInt24, true);
+    sfz::readInterleavedInt24(unalignedInput, absl::MakeSpan(leftOutputSIMD), absl::MakeSpan(rightOutputSIMD));
+    REQUIRE(leftOutputScalar == leftOutputSIMD);
+    REQUIRE(rightOutputScalar == rightOutputSIMD);
+}
+
 TEST_CASE("[Helpers] Interleaved write")
 {
     std::array<float, 8> leftInput {
@@ -280,6 +350,37 @@ TEST_CASE("[Helpers] Interleaved write SIMD vs Scalar")
     REQUIRE(outputScalar == outputSIMD);
 }
 
+TEST_CASE("[Helpers] Interleaved add")
+{
+    std::array<float, 10> leftInput { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f };
+    std::array<float, 10> rightInput { 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f, 17.0f, 18.0f, 19.0f };
+    std::array<float, 20> output;
+    std::array<float, 20> expected = { 1.0f, 11.0f, 2.0f, 12.0f, 3.0f, 13.0f, 4.0f, 14.0f, 5.0f, 15.0f, 6.0f, 16.0f, 7.0f, 17.0f, 8.0f, 18.0f, 9.0f, 19.0f, 10.0f, 20.0f };
+    for (bool simd : { false, true }) {
+        absl::c_fill(output, 1.0f);
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::addInterleaved, simd);
+        sfz::addInterleaved(leftInput, rightInput, absl::MakeSpan(output));
+        REQUIRE(output == expected);
+    }
+}
+
+TEST_CASE("[Helpers] Interleaved add SIMD vs Scalar")
+{
+    std::array<float, medBufferSize> leftInput;
+    std::array<float, medBufferSize> rightInput;
+    std::array<float, medBufferSize * 2> outputScalar;
+    std::array<float, medBufferSize * 2> outputSIMD;
+    std::iota(leftInput.begin(), leftInput.end(), 0.0f);
+    std::iota(rightInput.begin(), rightInput.end(), static_cast<float>(medBufferSize));
+    std::iota(outputScalar.begin(), outputScalar.end(), 1.0f);
+    outputSIMD = outputScalar;
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::addInterleaved, false);
+    sfz::addInterleaved(leftInput, rightInput, absl::MakeSpan(outputScalar));
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::addInterleaved, true);
+    sfz::addInterleaved(leftInput, rightInput, absl::MakeSpan(outputSIMD));
+    REQUIRE(outputScalar == outputSIMD);
+}
+
 TEST_CASE("[Helpers] Gain, single")
 {
     std::array<float, 65> input;
@@ -584,6 +685,43 @@ TEST_CASE("[Helpers] MultiplyAdd fixed gain (SIMD vs scalar)")
     REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
 }
 
+TEST_CASE("[Helpers] MultiplyAdd fixed gains to multiple outputs (SIMD vs scalar)")
+{
+    // More outputs than a group, and a size which is not a multiple of the
+    // vectors
+    constexpr unsigned numOutputs = 11;
+    const unsigned size = bigBufferSize - 3;
+    std::vector<float> input(size);
+    std::vector<float> gains(numOutputs);
+    std::vector<std::vector<float>> outputsScalar(numOutputs, std::vector<float>(size));
+    std::vector<std::vector<float>> outputsSIMD(numOutputs, std::vector<float>(size));
+    absl::c_iota(input, 0.0f);
+    for (unsigned j = 0; j < numOutputs; ++j) {
+        gains[j] = 0.1f * j;
+        absl::c_iota(outputsScalar[j], static_cast<float>(j));
+        absl::c_iota(outputsSIMD[j], static_cast<float>(j));
+    }
+
+    std::vector<float*> scalarPointers;
+    std::vector<float*> simdPointers;
+    for (unsigned j = 0; j < numOutputs; ++j) {
+        scalarPointers.push_back(outputsScalar[j].data());
+        simdPointers.push_back(outputsSIMD[j].data());
+    }
+
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::multiplyAdd1Multi, false);
+    sfz::multiplyAdd1Multi<float>(gains.data(), input.data(), scalarPointers.data(), numOutputs, size);
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::multiplyAdd1Multi, true);
+    sfz::multiplyAdd1Multi<float>(gains.data(), input.data(), simdPointers.data(), numOutputs, size);
+    for (unsigned j = 0; j < numOutputs; ++j) {
+        std::vector<float> expected(size);
+        absl::c_iota(expected, static_cast<float>(j));
+        sfz::multiplyAdd1<float>(gains[j], input, absl::MakeSpan(expected));
+        REQUIRE(approxEqual<float>(outputsScalar[j], expected));
+        REQUIRE(approxEqual<float>(outputsSIMD[j], expected));
+    }
+}
+
 TEST_CASE("[Helpers] MultiplyMul (Scalar)")
 {
     std::array<float, 5> gain { 0.0f, 0.1f, 0.2f, 0.3f, 0.4f };
@@ -910,6 +1048,85 @@ TEST_CASE("[Helpers] Width tests")
     widthTest<10>(1.0f, 1.0f, -1.0f, 1.0f, 1.0f);
 }
 
+TEST_CASE("[Helpers] Width and position in a single pass")
+{
+    constexpr unsigned N = 17;
+    for (float widthValue : { -1.0f, 0.0f, 0.3f, 1.0f }) {
+        for (float positionValue : { -1.0f, -0.2f, 0.0f, 0.7f, 1.0f }) {
+            std::vector<float> left(N);
+            std::vector<float> right(N);
+            for (unsigned i = 0; i < N; ++i) {
+                left[i] = 0.1f * i;
+                right[i] = 1.0f - 0.05f * i;
+            }
+            std::vector<float> expectedLeft = left;
+            std::vector<float> expectedRight = right;
+
+            std::vector<float> envelope(N, widthValue);
+            sfz::width(envelope, absl::MakeSpan(expectedLeft), absl::MakeSpan(expectedRight));
+            std::fill(envelope.begin(), envelope.end(), positionValue);
+            sfz::pan(envelope, absl::MakeSpan(expectedLeft), absl::MakeSpan(expectedRight));
+            sfz::applyGain1(2.0f, absl::MakeSpan(expectedLeft));
+            sfz::applyGain1(2.0f, absl::MakeSpan(expectedRight));
+
+            sfz::widthAndPosition(widthValue, positionValue, 2.0f, absl::MakeSpan(left), absl::MakeSpan(right));
+            REQUIRE( approxEqual<float>(left, expectedLeft) );
+            REQUIRE( approxEqual<float>(right, expectedRight) );
+        }
+    }
+}
+
+TEST_CASE("[Helpers] Pan law error bounds")
+{
+    // The polynomial is within 1e-7 of the cosine law, plus the rounding
+    for (int i = 0; i <= 10000; ++i) {
+        const float x = i / 10000.0f;
+        REQUIRE( sfz::panLaw(x) == Approx(std::cos(x * M_PI / 2)).margin(2e-7) );
+    }
+    REQUIRE( sfz::panLaw(0.0f) == Approx(1.0f).margin(1e-7) );
+    REQUIRE( sfz::panLaw(1.0f) == 0.0f );
+
+    // The vector and the scalar parts compute the same law
+    constexpr unsigned N = 1023;
+    std::vector<float> envelope(N);
+    std::vector<float> left(N, 1.0f);
+    std::vector<float> right(N, 1.0f);
+    for (unsigned i = 0; i < N; ++i)
+        envelope[i] = -1.2f + 2.4f * i / (N - 1);
+    sfz::pan(envelope, absl::MakeSpan(left), absl::MakeSpan(right));
+    for (unsigned i = 0; i < N; ++i) {
+        const double p = std::max(0.0, std::min(1.0, (envelope[i] + 1.0) * 0.5));
+        REQUIRE( left[i] == Approx(std::cos(p * M_PI / 2)).margin(2e-7) );
+        REQUIRE( right[i] == Approx(std::sin(p * M_PI / 2)).margin(2e-7) );
+    }
+}
+
+TEST_CASE("[Helpers] Pan, width and position in a single pass")
+{
+    constexpr unsigned N = 37;
+    std::vector<float> panEnvelope(N);
+    std::vector<float> widthEnvelope(N);
+    std::vector<float> positionEnvelope(N);
+    std::vector<float> left(N);
+    std::vector<float> right(N);
+    for (unsigned i = 0; i < N; ++i) {
+        panEnvelope[i] = -0.9f + 0.05f * i;
+        widthEnvelope[i] = 1.0f - 0.06f * i;
+        positionEnvelope[i] = 0.3f - 0.02f * i;
+        left[i] = 0.1f * i;
+        right[i] = 1.0f - 0.05f * i;
+    }
+    std::vector<float> expectedLeft = left;
+    std::vector<float> expectedRight = right;
+    sfz::pan(panEnvelope, absl::MakeSpan(expectedLeft), absl::MakeSpan(expectedRight));
+    sfz::width(widthEnvelope, absl::MakeSpan(expectedLeft), absl::MakeSpan(expectedRight));
+    sfz::pan(positionEnvelope, absl::MakeSpan(expectedLeft), absl::MakeSpan(expectedRight));
+
+    sfz::panWidthPosition(panEnvelope, widthEnvelope, positionEnvelope, absl::MakeSpan(left), absl::MakeSpan(right));
+    REQUIRE( approxEqual<float>(left, expectedLeft) );
+    REQUIRE( approxEqual<float>(right, expectedRight) );
+}
+
 TEST_CASE("[Helpers] clampAll")
 {
     std::array<float, 10> inputScalar { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f };
@@ -951,3 +1168,168 @@ TEST_CASE("[Helpers] allWithin")
     REQUIRE( !sfz::allWithin<float>(input, 0.0f, 5.0f) );
     REQUIRE( !sfz::allWithin<float>(input, -1.0f, 7.0f) );
 }
+
+TEST_CASE("[Helpers] centsFactor (SIMD vs scalar)")
+{
+    std::vector<float> input(medBufferSize);
+    std::vector<float> outputScalar(medBufferSize);
+    std::vector<float> outputSIMD(medBufferSize);
+    for (int i = 0; i < medBufferSize; ++i)
+        input[i] = -12000.0f + 23.5f * i;
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::centsFactor, false);
+    sfz::centsFactor<float>(input, absl::MakeSpan(outputScalar));
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::centsFactor, true);
+    sfz::centsFactor<float>(input, absl::MakeSpan(outputSIMD));
+    for (int i = 0; i < medBufferSize; ++i) {
+        REQUIRE( outputScalar[i] == Approx(sfz::centsFactor(input[i])).epsilon(1e-6) );
+        REQUIRE( outputSIMD[i] == Approx(outputScalar[i]).epsilon(1e-6) );
+    }
+}
+
+TEST_CASE("[Helpers] db2mag (SIMD vs scalar)")
+{
+    std::vector<float> input(medBufferSize);
+    std::vector<float> outputScalar(medBufferSize);
+    std::vector<float> outputSIMD(medBufferSize);
+    for (int i = 0; i < medBufferSize; ++i)
+        input[i] = -144.0f + 0.3f * i;
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::db2mag, false);
+    sfz::db2mag<float>(input, absl::MakeSpan(outputScalar));
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::db2mag, true);
+    sfz::db2mag<float>(input, absl::MakeSpan(outputSIMD));
+    for (int i = 0; i < medBufferSize; ++i) {
+        REQUIRE( outputScalar[i] == Approx(db2mag(input[i])).epsilon(1e-6) );
+        // The SIMD version is within 2e-7 of the exact value
+        REQUIRE( outputSIMD[i] == Approx(std::pow(10.0, input[i] / 20.0)).epsilon(2e-7) );
+    }
+}
+
+TEST_CASE("[Helpers] Backends of the operations")
+{
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::gain1, false);
+    REQUIRE( sfz::getSIMDOpBackend<float>(sfz::SIMDOps::gain1) == sfz::SIMDBackend::scalar );
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::gain1, true);
+    REQUIRE( sfz::setSIMDOpBackend<float>(sfz::SIMDOps::gain1, sfz::SIMDBackend::scalar) );
+    REQUIRE( !sfz::getSIMDOpStatus<float>(sfz::SIMDOps::gain1) );
+    // Not a dispatched operation
+    REQUIRE( !sfz::setSIMDOpBackend<float>(sfz::SIMDOps::fill, sfz::SIMDBackend::scalar) );
+    REQUIRE( sfz::simdOpName(sfz::SIMDOps::multiplyAdd1Multi) == std::string("multiplyAdd1Multi") );
+    REQUIRE( sfz::simdBackendName(sfz::SIMDBackend::avx) == std::string("avx") );
+    sfz::resetSIMDOpStatus<float>();
+}
+
+TEST_CASE("[Helpers] Save and load the backends")
+{
+    sfz::setSIMDOpBackend<float>(sfz::SIMDOps::copy, sfz::SIMDBackend::scalar);
+    const std::string saved = sfz::saveSIMDOpBackends<float>();
+    REQUIRE( saved.find("copy scalar\n") != std::string::npos );
+    REQUIRE( saved.find("fill") == std::string::npos );
+
+    sfz::resetSIMDOpStatus<float>();
+    REQUIRE( sfz::loadSIMDOpBackends<float>(saved) );
+    REQUIRE( sfz::saveSIMDOpBackends<float>() == saved );
+
+    // The loaded backends survive the resets, until the calibration is dropped
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::copy, true);
+    sfz::resetSIMDOpStatus<float>();
+    REQUIRE( sfz::getSIMDOpBackend<float>(sfz::SIMDOps::copy) == sfz::SIMDBackend::scalar );
+
+    // Nothing changes on a rejected text
+    REQUIRE( !sfz::loadSIMDOpBackends<float>("copy sse\ngain1 nonsense\n") );
+    REQUIRE( !sfz::loadSIMDOpBackends<float>("fill scalar\n") );
+    REQUIRE( !sfz::loadSIMDOpBackends<float>("copy\n") );
+    REQUIRE( sfz::saveSIMDOpBackends<float>() == saved );
+
+    sfz::resetSIMDCalibration<float>();
+    sfz::resetSIMDOpStatus<float>();
+}
+
+TEST_CASE("[Helpers] Calibrate the operations")
+{
+    std::vector<float> input(medBufferSize);
+    std::vector<float> expected(medBufferSize);
+    std::vector<float> output(medBufferSize);
+    for (int i = 0; i < medBufferSize; ++i)
+        input[i] = -1.0f + 0.002f * i;
+
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::multiplyAdd1, false);
+    sfz::multiplyAdd1<float>(0.5f, input, absl::MakeSpan(expected));
+
+    sfz::calibrateSIMDOps<float>();
+    for (unsigned i = 0; i < static_cast<unsigned>(sfz::SIMDOps::_sentinel); ++i) {
+        const auto op = static_cast<sfz::SIMDOps>(i);
+        const sfz::SIMDBackend backend = sfz::getSIMDOpBackend<float>(op);
+        INFO(sfz::simdOpName(op) << " " << sfz::simdBackendName(backend));
+        // The calibration only selects among the dispatched operations
+        if (!sfz::setSIMDOpBackend<float>(op, backend))
+            continue;
+        REQUIRE( sfz::getSIMDOpStatus<float>(op) == (backend != sfz::SIMDBackend::scalar) );
+    }
+
+    sfz::multiplyAdd1<float>(0.5f, input, absl::MakeSpan(output));
+    for (int i = 0; i < medBufferSize; ++i)
+        REQUIRE( output[i] == Approx(expected[i]).margin(1e-6) );
+
+    const std::string calibrated = sfz::saveSIMDOpBackends<float>();
+    sfz::resetSIMDOpStatus<float>();
+    REQUIRE( sfz::saveSIMDOpBackends<float>() == calibrated );
+
+    sfz::resetSIMDCalibration<float>();
+    sfz::resetSIMDOpStatus<float>();
+}
+
+TEST_CASE("[Helpers] interpolationPositions (SIMD vs scalar)")
+{
+    std::vector<float> pitch(medBufferSize);
+    for (int i = 0; i < medBufferSize; ++i)
+        pitch[i] = 600.0f * std::sin(0.01f * i);
+
+    const float ratio = 1.3f;
+    const double start = 100.25;
+    for (bool simd : { false, true }) {
+        INFO((simd ? "SIMD" : "Scalar"));
+        std::vector<int> indices(medBufferSize);
+        std::vector<float> coeffs(medBufferSize);
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::interpolationPositions, simd);
+        const int64_t last = sfz::interpolationPositions<float>(
+            pitch, ratio, fixedPosition(start), absl::MakeSpan(indices), absl::MakeSpan(coeffs));
+        REQUIRE( indices.front() == 100 );
+        REQUIRE( coeffs.front() == 0.25f );
+
+        double expected = start;
+        for (int i = 0; i < medBufferSize; ++i) {
+            if (i > 0)
+                expected += ratio * std::exp2(pitch[i] / 1200.0);
+            const double actual = indices[i] + static_cast<double>(coeffs[i]);
+            REQUIRE( actual == Approx(expected).epsilon(1e-6) );
+            REQUIRE( coeffs[i] >= 0.0f );
+            REQUIRE( coeffs[i] < 1.0f );
+        }
+        REQUIRE( static_cast<int>(last >> 32) == indices.back() );
+    }
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::interpolationPositions, true);
+}
+
+TEST_CASE("[Helpers] interpolationPositions are exact over long samples")
+{
+    // About an hour at 48 kHz
+    const int64_t start = fixedPosition(1.7e8 + 0.25);
+    const int64_t step = fixedPosition(1.5);
+    for (bool simd : { false, true }) {
+        for (int size : { 0, 1, 7, medBufferSize }) {
+            INFO((simd ? "SIMD" : "Scalar") << ", size " << size);
+            std::vector<int> indices(size);
+            std::vector<float> coeffs(size);
+            sfz::setSIMDOpStatus<float>(sfz::SIMDOps::interpolationPositions, simd);
+            const int64_t last = sfz::interpolationPositions<float>(
+                1.5f, start, absl::MakeSpan(indices), absl::MakeSpan(coeffs));
+            REQUIRE( last == start + std::max(0, size - 1) * step );
+            for (int i = 0; i < size; ++i) {
+                const int64_t position = start + i * step;
+                REQUIRE( indices[i] == static_cast<int>(position >> 32) );
+                REQUIRE( coeffs[i] == ((i % 2 == 0) ? 0.25f : 0.75f) );
+            }
+        }
+    }
+    sfz::setSIMDOpStatus<float>(sfz::SIMDOps::interpolationPositions, true);
+}
@@ -395,3 +395,49 @@ TEST_CASE("[OnePoleFilter] Tests")
     testFilter(doubleInput05, doubleOutputLow05, doubleOutputHigh05, 0.5);
     testFilter(doubleInput09, doubleOutputLow09, doubleOutputHigh09, 0.9);
 }
+
+TEST_CASE("[OnePoleSmootherBank] Same as the smoothers one by one")
+{
+    constexpr unsigned numFrames = 103;
+    const unsigned smoothValues[] { 10, 0, 3, 25, 7, 1, 50 };
+
+    for (unsigned numSmoothers = 1; numSmoothers <= 7; ++numSmoothers) {
+        INFO(numSmoothers << " smoothers");
+        std::vector<sfz::OnePoleSmoother> expected(numSmoothers);
+        std::vector<sfz::OnePoleSmoother> smoothers(numSmoothers);
+        std::vector<std::vector<float>> inputs(numSmoothers, std::vector<float>(numFrames));
+        std::vector<std::vector<float>> outputs(numSmoothers, std::vector<float>(numFrames));
+        std::vector<float> expectedOutput(numFrames);
+        sfz::OnePoleSmoother* pointers[7];
+        const float* in[7];
+        float* out[7];
+        bool canShortcut[7];
+
+        for (unsigned k = 0; k < numSmoothers; ++k) {
+            expected[k].setSmoothing(smoothValues[k], sfz::config::defaultSampleRate);
+            smoothers[k].setSmoothing(smoothValues[k], sfz::config::defaultSampleRate);
+            expected[k].reset(0.1f * k);
+            smoothers[k].reset(0.1f * k);
+            pointers[k] = &smoothers[k];
+            in[k] = inputs[k].data();
+            out[k] = outputs[k].data();
+            // a smoother which starts within the threshold shortcuts
+            canShortcut[k] = (k % 3 == 2);
+        }
+
+        for (unsigned cycle = 0; cycle < 3; ++cycle) {
+            for (unsigned k = 0; k < numSmoothers; ++k) {
+                for (unsigned i = 0; i < numFrames; ++i)
+                    inputs[k][i] = (k % 3 == 2) ? 0.1f * k : std::sin(0.05f * (i + cycle * numFrames) + k);
+            }
+
+            sfz::OnePoleSmootherBank::process(pointers, in, out, canShortcut, numSmoothers, numFrames);
+
+            for (unsigned k = 0; k < numSmoothers; ++k) {
+                expected[k].process(inputs[k], absl::MakeSpan(expectedOutput), canShortcut[k]);
+                REQUIRE(approxEqual(absl::MakeConstSpan(outputs[k]), absl::MakeConstSpan(expectedOutput)));
+                REQUIRE(smoothers[k].current() == Approx(expected[k].current()));
+            }
+        }
+    }
+}
@@ -9,7 +9,13 @@
 #include "sfizz/Layer.h"
 #include "sfizz/SisterVoiceRing.h"
 #include "sfizz/SfzHelpers.h"
+#include "sfizz/SIMDHelpers.h"
 #include "sfizz/utility/NumericId.h"
+#include "sfizz/VoicePools.h"
+#include "sfizz/BufferPool.h"
+#include "sfizz/Wavetables.h"
+#include "sfizz/PowerFollower.h"
+#include "sfizz/SynthConfig.h"
 #include "BitArray.h"
 #include "TestHelpers.h"
 #include "catch2/catch.hpp"
@@ -61,8 +67,50 @@ TEST_CASE("[Synth] Change the number of voice while playing")
     synth.renderBlock(buffer);
     REQUIRE(synth.getNumActiveVoices() == 2);
     synth.setNumVoices(8);
-    REQUIRE(synth.getNumActiveVoices() == 0);
+    REQUIRE(synth.getNumActiveVoices() == 2);
     REQUIRE(synth.getNumVoices() == 8);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+    synth.setNumVoices(128);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+    REQUIRE(synth.getNumVoices() == 128);
+    synth.noteOn(0, 36, 24);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 3);
+}
+
+TEST_CASE("[Synth] The voices past a lower number of voices finish playing")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(64);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/polyphony.sfz", R"(
+        <region> sample=*sine ampeg_release=0
+    )");
+    for (int note = 0; note < 16; ++note)
+        synth.noteOn(0, note, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 16);
+
+    // The count of the active voices stops at the number of voices
+    synth.setNumVoices(2);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getActiveVoices().size() == 16);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+    REQUIRE(synth.getNumVoices() == 2);
+
+    // The notes off free voices past the limit, which are not taken anymore
+    for (int note = 0; note < 16; ++note)
+        synth.noteOff(0, note, 0);
+    for (int i = 0; i < 10; ++i)
+        synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    synth.noteOn(0, 60, 100);
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getActiveVoices().size() == 2);
+    for (const sfz::Voice* voice : synth.getActiveVoices())
+        REQUIRE((voice == synth.getVoiceView(0) || voice == synth.getVoiceView(1)));
 }
 
 TEST_CASE("[Synth] Check that the sample per block and sample rate are actually propagated to all voices even on recreation")
@@ -451,6 +499,71 @@ TEST_CASE("[Synth] Effect on the second output, with two outputs")
     REQUIRE( bus->gainToMix() == 0 );
 }
 
+TEST_CASE("[Synth] Rendering of the outputs into their channels")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    REQUIRE( synth.getNumOutputs() == 1 );
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/outputs.sfz", R"(
+        <region> key=60 sample=*sine
+        <region> key=62 sample=*sine output=2
+    )");
+    REQUIRE( synth.getNumOutputs() == 3 );
+
+    sfz::AudioBuffer<float> buffer { 6, 256 };
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    for (unsigned channel : { 0, 1, 2, 3 })
+        REQUIRE( sfz::meanSquared<float>(buffer.getConstSpan(channel)) == 0.0f );
+    REQUIRE( sfz::meanSquared<float>(buffer.getConstSpan(4)) > 0.0f );
+    REQUIRE( sfz::meanSquared<float>(buffer.getConstSpan(5)) > 0.0f );
+
+    // the outputs wrap around a stereo buffer
+    sfz::AudioBuffer<float> stereo { 2, 256 };
+    synth.renderBlock(stereo);
+    REQUIRE( sfz::meanSquared<float>(stereo.getConstSpan(0)) > 0.0f );
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/outputs_b.sfz", "<region> sample=*sine");
+    REQUIRE( synth.getNumOutputs() == 1 );
+}
+
+TEST_CASE("[Synth] Interleaved and adding renders match the planar render")
+{
+    const std::string text = R"(
+        <region> key=60 sample=*sine effect1=50
+        <region> key=62 sample=*saw output=1
+        <effect> bus=fx1 type=gain gain=-6
+    )";
+    sfz::Synth synths[3];
+    for (sfz::Synth& synth : synths) {
+        synth.setSamplesPerBlock(256);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/interleaved.sfz", text);
+        synth.noteOn(0, 60, 100);
+        synth.noteOn(0, 62, 100);
+    }
+
+    sfz::AudioBuffer<float> planar { 4, 256 };
+    std::vector<float> interleaved(4 * 256, 1.0f);
+    sfz::AudioBuffer<float> adding { 4, 256 };
+    for (unsigned c = 0; c < 4; ++c)
+        sfz::fill(adding.getSpan(c), 1.0f);
+
+    for (int block = 0; block < 4; ++block) {
+        synths[0].renderBlock(planar);
+        synths[1].renderBlockInterleaved(interleaved.data(), 4, 256, block == 0);
+        synths[2].renderBlockAdding(adding);
+        for (unsigned c = 0; c < 4; ++c) {
+            REQUIRE( sfz::meanSquared<float>(planar.getConstSpan(c)) > 0.0f );
+            for (unsigned i = 0; i < 256; ++i) {
+                const float offset = (block == 0) ? 1.0f : 0.0f;
+                REQUIRE( interleaved[4 * i + c] == Approx(planar.getSample(c, i) + offset).margin(1e-6) );
+                REQUIRE( adding.getSample(c, i) == Approx(planar.getSample(c, i) + 1.0f).margin(1e-6) );
+            }
+            sfz::fill(adding.getSpan(c), 1.0f);
+        }
+    }
+}
+
 TEST_CASE("[Synth] Basic curves")
 {
     sfz::Synth synth;
@@ -469,6 +582,24 @@ TEST_CASE("[Synth] Basic curves")
     REQUIRE( curves.getCurve(16).evalCC7(63) == Approx(63_norm) );
 }
 
+TEST_CASE("[Synth] Oscillator regions resolve their wave on loading")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/wavetable_regions.sfz", R"(
+        <region> sample=*sine
+        <region> sample=*tri
+        <region> sample=*noise
+        <region> sample=wavetables/surge.wav
+        <region> sample=kick.wav
+    )");
+    REQUIRE( synth.getNumRegions() == 5 );
+    REQUIRE( synth.getRegionView(0)->wave == sfz::WavetablePool::getWaveSin() );
+    REQUIRE( synth.getRegionView(1)->wave == sfz::WavetablePool::getWaveTriangle() );
+    REQUIRE( synth.getRegionView(2)->wave == nullptr );
+    REQUIRE( synth.getRegionView(3)->wave != nullptr );
+    REQUIRE( synth.getRegionView(4)->wave == nullptr );
+}
+
 TEST_CASE("[Synth] Velocity points")
 {
     sfz::Synth synth;
@@ -783,6 +914,30 @@ TEST_CASE("[Synth] Release (Different sustain CC)")
     REQUIRE( synth.getNumActiveVoices() == 2 );
 }
 
+TEST_CASE("[Synth] Sustain CC set by a message")
+{
+    sfz::Synth synth;
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/release.sfz", R"(
+        <region> key=62 sample=*sine ampeg_release=1
+    )");
+    sfizz_arg_t args;
+    args.i = 54;
+    synth.dispatchMessage(client, 0, "/region0/sustain_cc", "i", &args);
+    synth.noteOn(0, 62, 85);
+    synth.cc(0, 54, 127);
+    synth.noteOff(0, 62, 85);
+    synth.renderBlock(buffer);
+    REQUIRE( numPlayingVoices(synth) == 1 );
+    synth.cc(0, 54, 0);
+    synth.renderBlock(buffer);
+    REQUIRE( numPlayingVoices(synth) == 0 );
+    REQUIRE( synth.getNumActiveVoices() == 1 );
+}
+
 TEST_CASE("[Synth] Release (don't check sustain)")
 {
     sfz::Synth synth;
@@ -909,6 +1064,47 @@ TEST_CASE("[Synth] Release (sustain + sostenuto)")
     }
 }
 
+TEST_CASE("[Synth] Only the layers with delayed releases are pending")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/release.sfz", R"(
+        <region> lokey=60 hikey=64 sample=*silence
+        <region> key=62 sample=*sine trigger=release
+        <region> key=63 sample=*sine trigger=release
+        <region> key=64 sample=*sine trigger=release
+    )");
+    auto pending = [&](int idx) { return synth.getLayerView(idx)->pendingReleaseLinked_; };
+
+    synth.cc(0, 64, 127);
+    synth.cc(0, 66, 127);
+    REQUIRE( !pending(1) );
+    REQUIRE( !pending(2) );
+    REQUIRE( !pending(3) );
+
+    synth.noteOn(1, 62, 85);
+    synth.noteOn(1, 63, 85);
+    synth.noteOff(2, 62, 85);
+    synth.renderBlock(buffer);
+    REQUIRE( pending(1) );
+    REQUIRE( !pending(2) );
+    REQUIRE( !pending(3) );
+
+    // the sostenuto notes are held until the pedal goes up
+    synth.cc(3, 66, 0);
+    synth.noteOff(4, 63, 85);
+    REQUIRE( pending(1) );
+    REQUIRE( pending(2) );
+
+    synth.cc(5, 64, 0);
+    synth.renderBlock(buffer);
+    REQUIRE( !pending(1) );
+    REQUIRE( !pending(2) );
+    REQUIRE( !pending(3) );
+    // the two release voices, and the attack voices if still releasing
+    REQUIRE( synth.getNumActiveVoices() >= 2 );
+}
+
 TEST_CASE("[Synth] One shot regions with sustain + sostenuto")
 {
     sfz::Synth synth;
@@ -2202,4 +2398,1100 @@ TEST_CASE("[Synth] Note on and off with delay")
     for (int i = 0; i < 100; ++i)
         synth.renderBlock(buffer);
     CHECK(synth.getNumActiveVoices() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("[Synth] Render threads produce the same output as a single thread")
+{
+    const std::string sfz = R"(
+        <region> lokey=0 hikey=63 sample=*sine amplitude_oncc20=100
+            lfo1_freq=3 lfo1_amplitude=20 effect1=50
+        <region> lokey=64 hikey=127 sample=*saw fil_type=lpf_2p cutoff=2000
+            lfo1_freq=5 lfo1_cutoff=600 pan_oncc21=100
+        <effect> directtomain=50 fx1tomain=50 type=filter bus=fx1 filter_type=lpf_1p filter_cutoff=1000
+    )";
+
+    sfz::Synth reference;
+    sfz::Synth threaded;
+    threaded.setNumRenderThreads(4);
+    REQUIRE(threaded.getNumRenderThreads() == 4);
+
+    for (sfz::Synth* synth : { &reference, &threaded }) {
+        synth->setSamplesPerBlock(256);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/renderThreads.sfz", sfz);
+        synth->cc(0, 20, 64);
+        synth->cc(0, 21, 32);
+        for (int note = 40; note < 88; note += 2)
+            synth->noteOn(0, note, 100);
+    }
+
+    sfz::AudioBuffer<float> referenceBuffer { 2, 256 };
+    sfz::AudioBuffer<float> threadedBuffer { 2, 256 };
+    for (int block = 0; block < 20; ++block) {
+        reference.renderBlock(referenceBuffer);
+        threaded.renderBlock(threadedBuffer);
+        REQUIRE(threaded.getNumActiveVoices() == reference.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(referenceBuffer.getConstSpan(0), threadedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(referenceBuffer.getConstSpan(1), threadedBuffer.getConstSpan(1)));
+    }
+
+    threaded.setNumRenderThreads(1);
+    REQUIRE(threaded.getNumRenderThreads() == 1);
+}
+
+TEST_CASE("[Synth] Render threads process the effect buses like a single thread")
+{
+    const std::string sfz = R"(
+        <region> lokey=0 hikey=127 sample=*saw effect1=50 effect2=50
+        <effect> directtomain=50 fx1tomain=50 type=filter bus=fx1 filter_type=lpf_2p filter_cutoff=800
+        <effect> fx2tomain=50 type=filter bus=fx2 filter_type=hpf_2p filter_cutoff=3000
+        <effect> fx2tomix=50 type=lofi bus=fx2 bitred=50
+    )";
+
+    sfz::Synth reference;
+    sfz::Synth threaded;
+    threaded.setNumRenderThreads(3);
+
+    for (sfz::Synth* synth : { &reference, &threaded }) {
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/renderThreadsEffects.sfz", sfz);
+        synth->noteOn(0, 60, 100);
+        synth->noteOn(0, 67, 100);
+    }
+
+    sfz::AudioBuffer<float> referenceBuffer { 2, static_cast<unsigned>(reference.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> threadedBuffer { 2, static_cast<unsigned>(threaded.getSamplesPerBlock()) };
+    for (int block = 0; block < 10; ++block) {
+        reference.renderBlock(referenceBuffer);
+        threaded.renderBlock(threadedBuffer);
+        REQUIRE(approxEqual<float>(referenceBuffer.getConstSpan(0), threadedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(referenceBuffer.getConstSpan(1), threadedBuffer.getConstSpan(1)));
+    }
+}
+
+TEST_CASE("[Synth] Effect buses are suspended on silence")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/effectSuspension.sfz", R"(
+        <region> lokey=0 hikey=127 sample=*sine effect1=100 ampeg_release=0.01
+        <effect> fx1tomain=100 type=filter bus=fx1 filter_type=lpf_2p filter_cutoff=800
+    )");
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    const sfz::EffectBus* bus = synth.getEffectBusView(1);
+    REQUIRE(bus != nullptr);
+
+    synth.renderBlock(buffer);
+    REQUIRE(bus->isSuspended());
+
+    synth.noteOn(0, 60, 127);
+    synth.renderBlock(buffer);
+    REQUIRE(!bus->isSuspended());
+    synth.noteOff(0, 60, 0);
+
+    // The bus may suspend on the last frames of the release, under the
+    // silence threshold
+    for (int block = 0; block < 100 && (!bus->isSuspended() || synth.getNumActiveVoices() > 0); ++block)
+        synth.renderBlock(buffer);
+    REQUIRE(bus->isSuspended());
+    REQUIRE(synth.getNumActiveVoices() == 0);
+
+    synth.renderBlock(buffer);
+    REQUIRE(sfz::allWithin<float>(buffer.getConstSpan(0), -1e-5f, 1e-5f));
+    REQUIRE(sfz::allWithin<float>(buffer.getConstSpan(1), -1e-5f, 1e-5f));
+
+    synth.noteOn(0, 60, 127);
+    synth.renderBlock(buffer);
+    REQUIRE(!bus->isSuspended());
+}
+
+TEST_CASE("[Synth] Effect buses with a pre-delay wait for their tail")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/effectSuspensionTail.sfz", R"(
+        <region> lokey=0 hikey=127 sample=*sine effect1=100 ampeg_release=0.001
+        <effect> fx1tomain=100 type=fverb bus=fx1 reverb_predelay=0.5
+    )");
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    const sfz::EffectBus* bus = synth.getEffectBusView(1);
+    REQUIRE(bus != nullptr);
+
+    synth.noteOn(0, 60, 127);
+    synth.renderBlock(buffer);
+    synth.noteOff(0, 60, 0);
+
+    // Past the release, the reverberation has not appeared yet
+    const int predelayBlocks = static_cast<int>(0.5 * sfz::config::defaultSampleRate / 256);
+    for (int block = 0; block < predelayBlocks; ++block) {
+        synth.renderBlock(buffer);
+        REQUIRE(!bus->isSuspended());
+    }
+}
+
+TEST_CASE("[Synth] Reverb quality tiers render the wet signal")
+{
+    for (const std::string quality : { "0", "1", "2" }) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(256);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/reverbQuality.sfz", R"(
+            <region> lokey=0 hikey=127 sample=*sine effect1=100
+            <effect> fx1tomain=100 type=fverb bus=fx1 reverb_dry=0 reverb_quality=)" + quality);
+
+        // Blocks which are not a multiple of the rate of the lower tiers
+        sfz::AudioBuffer<float> buffer { 2, 101 };
+        synth.noteOn(0, 60, 127);
+        float peak = 0.0f;
+        for (int block = 0; block < 100; ++block) {
+            synth.renderBlock(buffer);
+            for (size_t c = 0; c < 2; ++c) {
+                for (float x : buffer.getConstSpan(c)) {
+                    REQUIRE(std::isfinite(x));
+                    peak = std::max(peak, std::abs(x));
+                }
+            }
+        }
+        REQUIRE(peak > 0.01f);
+    }
+}
+
+TEST_CASE("[Synth] Oversampled effects follow the effect quality")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/effectQuality.sfz", R"(
+        <region> lokey=0 hikey=127 sample=*sine effect1=100
+        <effect> fx1tomain=100 type=disto bus=fx1 disto_depth=100 disto_oversampling=8
+        <effect> fx1tomain=100 type=comp bus=fx1 comp_oversampling=4
+        <effect> fx1tomain=100 type=limiter bus=fx1 limiter_oversampling=2
+    )");
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+
+    synth.noteOn(0, 60, 127);
+    for (int quality : { 3, 0, 1, 2, 3 }) {
+        synth.setEffectQuality(sfz::Synth::ProcessLive, quality);
+        REQUIRE(synth.getEffectQuality(sfz::Synth::ProcessLive) == quality);
+        float peak = 0.0f;
+        for (int block = 0; block < 10; ++block) {
+            synth.renderBlock(buffer);
+            for (size_t c = 0; c < 2; ++c) {
+                for (float x : buffer.getConstSpan(c)) {
+                    REQUIRE(std::isfinite(x));
+                    peak = std::max(peak, std::abs(x));
+                }
+            }
+        }
+        REQUIRE(peak > 0.01f);
+    }
+}
+
+TEST_CASE("[Synth] Convolution with an impulse response file")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/convolution.sfz", R"(
+        <region> lokey=0 hikey=127 sample=*sine effect1=100
+        <effect> fx1tomain=100 type=convolution bus=fx1 conv_ir=kick.wav conv_dry=0
+    )");
+    sfz::AudioBuffer<float> buffer { 2, 101 };
+
+    synth.noteOn(0, 60, 127);
+    float peak = 0.0f;
+    for (int block = 0; block < 100; ++block) {
+        synth.renderBlock(buffer);
+        for (size_t c = 0; c < 2; ++c) {
+            for (float x : buffer.getConstSpan(c)) {
+                REQUIRE(std::isfinite(x));
+                peak = std::max(peak, std::abs(x));
+            }
+        }
+    }
+    REQUIRE(peak > 0.01f);
+}
+
+TEST_CASE("[Synth] Released voices under the culling threshold are ended early")
+{
+    const std::string sfz = R"(
+        <region> sample=*sine volume=-30 ampeg_release=10
+    )";
+
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/voiceCulling.sfz", sfz);
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+
+    SECTION("Culling disabled")
+    {
+        REQUIRE(synth.getVoiceCullingThreshold() == -144.0f);
+        synth.noteOn(0, 60, 127);
+        synth.renderBlock(buffer);
+        synth.noteOff(0, 60, 0);
+        for (int block = 0; block < 20; ++block) {
+            synth.renderBlock(buffer);
+            REQUIRE(synth.getCallbackBreakdown().culledVoices == 0);
+        }
+        REQUIRE(synth.getNumActiveVoices() == 1);
+    }
+
+    SECTION("Culling enabled")
+    {
+        synth.setVoiceCullingThreshold(-20.0f);
+        REQUIRE(synth.getVoiceCullingThreshold() == -20.0f);
+        synth.noteOn(0, 60, 127);
+        for (int block = 0; block < 20; ++block) {
+            synth.renderBlock(buffer);
+            REQUIRE(synth.getCallbackBreakdown().culledVoices == 0);
+        }
+        REQUIRE(synth.getNumActiveVoices() == 1);
+        synth.noteOff(0, 60, 0);
+        int culledVoices = 0;
+        for (int block = 0; block < 20; ++block) {
+            synth.renderBlock(buffer);
+            culledVoices += synth.getCallbackBreakdown().culledVoices;
+        }
+        REQUIRE(culledVoices == 1);
+        REQUIRE(synth.getNumActiveVoices() == 0);
+    }
+
+    SECTION("Culling threshold from the control header")
+    {
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/voiceCulling.sfz", R"(
+            <control> hint_voice_culling_threshold=-40
+            <region> sample=*sine
+        )");
+        REQUIRE(synth.getVoiceCullingThreshold() == -40.0f);
+    }
+}
+
+TEST_CASE("[Synth] Note-on matching with many velocity layers")
+{
+    sfz::Synth synth;
+    std::string sfz;
+    for (int layer = 0; layer < 32; ++layer) {
+        const int lovel = layer * 4;
+        const int hivel = lovel + 3;
+        for (int rr = 0; rr < 3; ++rr) {
+            sfz += "<region> sample=*sine lovel=" + std::to_string(lovel)
+                + " hivel=" + std::to_string(hivel)
+                + " lorand=" + std::to_string(rr / 3.0f)
+                + " hirand=" + std::to_string((rr + 1) / 3.0f) + "\n";
+        }
+    }
+    sfz += "<region> sample=*saw lovel=1 hivel=10 seq_length=2 seq_position=2\n";
+    sfz += "<region> sample=*square sw_vel=previous lovel=120 hivel=127\n";
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/velocityIndex.sfz", sfz);
+    REQUIRE(synth.getNumRegions() == 32 * 3 + 2);
+
+    SECTION("One velocity layer matches each note")
+    {
+        for (int velocity = 1; velocity < 128; velocity += 7) {
+            synth.noteOn(0, 60, velocity);
+            int numSineVoices = 0;
+            for (const sfz::Voice* voice : getPlayingVoices(synth)) {
+                const sfz::Region* region = voice->getRegion();
+                if (region->sampleId->filename() == "*sine") {
+                    REQUIRE(region->velocityRange.containsWithEnd(sfz::normalizeVelocity(velocity)));
+                    ++numSineVoices;
+                }
+            }
+            REQUIRE(numSineVoices == 1);
+            synth.allSoundOff();
+        }
+    }
+
+    SECTION("Sequences count the notes outside of their velocity range")
+    {
+        synth.noteOn(0, 60, 100);
+        REQUIRE(playingSamples(synth) == std::vector<std::string> { "*sine" });
+        synth.allSoundOff();
+        synth.noteOn(0, 60, 5);
+        REQUIRE(playingSamples(synth) == std::vector<std::string> { "*sine", "*saw" });
+    }
+
+    SECTION("Velocity overrides match on the previous velocity")
+    {
+        synth.noteOn(0, 60, 125);
+        synth.noteOff(0, 60, 0);
+        synth.allSoundOff();
+        synth.noteOn(0, 60, 50);
+        REQUIRE(playingSamples(synth) == std::vector<std::string> { "*sine", "*square" });
+    }
+}
+
+TEST_CASE("[Synth] Unity and octave ratios play the samples exactly")
+{
+    // Integral positions bypass the interpolation, so that the linear and
+    // windowed-sinc qualities render identically
+    const auto render = [](int quality, int key) {
+        sfz::Synth synth;
+        synth.setSampleRate(44100.0f);
+        synth.setSamplesPerBlock(256);
+        synth.setSampleQuality(sfz::Synth::ProcessLive, quality);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/unity_ratio.sfz", R"(
+            <region> sample=kick.wav key=60 pitch_keycenter=60
+            <region> sample=kick.wav key=72 pitch_keycenter=60
+        )");
+        synth.noteOn(0, key, 100);
+        sfz::AudioBuffer<float> buffer { 2, 256 };
+        std::vector<float> output;
+        for (unsigned i = 0; i < 8; ++i) {
+            synth.renderBlock(buffer);
+            output.insert(output.end(), buffer.getConstSpan(0).begin(), buffer.getConstSpan(0).end());
+        }
+        return output;
+    };
+
+    REQUIRE(render(1, 60) == render(10, 60));
+    REQUIRE(render(1, 72) == render(10, 72));
+    REQUIRE(render(1, 60) != render(1, 72));
+}
+
+TEST_CASE("[Synth] Per-note controllers only reach the voices of their note")
+{
+    enum class Routing { none, ownNote, otherNote };
+    const auto render = [](Routing routing) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(256);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/per_note.sfz", R"(
+            <region> sample=*saw bend_up=1200 fil_type=lpf_2p cutoff=200 cutoff_oncc139=3600
+        )");
+        synth.noteOn(0, 60, 100);
+        synth.noteOn(0, 64, 100);
+        const int note = (routing == Routing::ownNote) ? 64 : 62;
+        if (routing != Routing::none) {
+            synth.hdPerNotePitchWheel(10, note, 0.5f);
+            synth.hdPerNoteTimbre(10, note, 0.8f);
+        }
+
+        sfz::AudioBuffer<float> buffer { 2, 256 };
+        std::vector<float> output;
+        for (unsigned i = 0; i < 4; ++i) {
+            synth.renderBlock(buffer);
+            output.insert(output.end(), buffer.getConstSpan(0).begin(), buffer.getConstSpan(0).end());
+        }
+        return output;
+    };
+
+    REQUIRE(render(Routing::none) == render(Routing::otherNote));
+    REQUIRE(render(Routing::none) != render(Routing::ownNote));
+}
+
+TEST_CASE("[Synth] Batched events play like the events one by one")
+{
+    const std::vector<sfizz_event_t> events {
+        { 0, SFIZZ_EVENT_NOTE_ON, 60, 0.8f },
+        { 0, SFIZZ_EVENT_CC, 74, 0.2f },
+        { 0, SFIZZ_EVENT_CC, 74, 0.6f },
+        { 10, SFIZZ_EVENT_CC, 20, 0.1f },
+        { 10, SFIZZ_EVENT_CC, 20, 0.9f },
+        { 20, SFIZZ_EVENT_CC, 7, 0.5f },
+        { 30, SFIZZ_EVENT_PITCH_WHEEL, 0, 0.25f },
+        { 40, SFIZZ_EVENT_CHANNEL_AFTERTOUCH, 0, 0.3f },
+        { 50, SFIZZ_EVENT_POLY_AFTERTOUCH, 60, 0.4f },
+        { 55, SFIZZ_EVENT_PER_NOTE_PITCH_WHEEL, 60, -0.5f },
+        { 58, SFIZZ_EVENT_PER_NOTE_TIMBRE, 60, 0.7f },
+        { 60, SFIZZ_EVENT_PROGRAM_CHANGE, 3, 0.0f },
+        { 100, SFIZZ_EVENT_NOTE_OFF, 60, 0.0f },
+    };
+
+    const auto render = [&events](bool batched) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(256);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/batched_events.sfz", R"(
+            <region> sample=*sine key=60 fil_type=lpf_2p cutoff=200 cutoff_oncc74=3600
+                amplitude_oncc7=100 pitch_bend=1200 ampeg_release=0.1
+            <region> sample=*saw on_locc20=100 on_hicc20=127 volume_oncc130=-6
+        )");
+        if (batched)
+            synth.sendEvents(events.data(), events.size());
+        else {
+            for (const sfizz_event_t& event : events) {
+                switch (event.type) {
+                case SFIZZ_EVENT_NOTE_ON:
+                    synth.hdNoteOn(event.delay, event.number, event.value);
+                    break;
+                case SFIZZ_EVENT_NOTE_OFF:
+                    synth.hdNoteOff(event.delay, event.number, event.value);
+                    break;
+                case SFIZZ_EVENT_CC:
+                    synth.hdcc(event.delay, event.number, event.value);
+                    break;
+                case SFIZZ_EVENT_PROGRAM_CHANGE:
+                    synth.programChange(event.delay, event.number);
+                    break;
+                case SFIZZ_EVENT_PITCH_WHEEL:
+                    synth.hdPitchWheel(event.delay, event.value);
+                    break;
+                case SFIZZ_EVENT_CHANNEL_AFTERTOUCH:
+                    synth.hdChannelAftertouch(event.delay, event.value);
+                    break;
+                case SFIZZ_EVENT_POLY_AFTERTOUCH:
+                    synth.hdPolyAftertouch(event.delay, event.number, event.value);
+                    break;
+                case SFIZZ_EVENT_PER_NOTE_PITCH_WHEEL:
+                    synth.hdPerNotePitchWheel(event.delay, event.number, event.value);
+                    break;
+                case SFIZZ_EVENT_PER_NOTE_TIMBRE:
+                    synth.hdPerNoteTimbre(event.delay, event.number, event.value);
+                    break;
+                }
+            }
+        }
+
+        REQUIRE(synth.getNumActiveVoices() == 3);
+        REQUIRE(synth.getHdcc(74) == 0.6f);
+        REQUIRE(synth.getHdcc(20) == 0.9f);
+        REQUIRE(synth.getHdcc(7) == 0.5f);
+
+        sfz::AudioBuffer<float> buffer { 2, 256 };
+        std::vector<float> output;
+        for (unsigned i = 0; i < 4; ++i) {
+            synth.renderBlock(buffer);
+            output.insert(output.end(), buffer.getConstSpan(0).begin(), buffer.getConstSpan(0).end());
+        }
+        return output;
+    };
+
+    REQUIRE(render(true) == render(false));
+}
+
+TEST_CASE("[Synth] Voices borrow the LFOs, EGs and filters their region needs")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(4);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/voice_pools.sfz", R"(
+        <region> key=60 sample=*sine lfo1_freq=1 lfo2_freq=2 eg1_time1=1 eg1_level1=1
+            fil_type=lpf_2p cutoff=500 fil2_type=hpf_2p cutoff2=50 ampeg_release=0.01
+        <region> key=62 sample=*sine ampeg_release=0.01
+    )");
+
+    sfz::VoicePools& pools = synth.getResources().getVoicePools();
+    const size_t numVoices = pools.getLFOs().size() / 2;
+    REQUIRE( numVoices >= 4 );
+    REQUIRE( pools.getFlexEGs().size() == numVoices );
+    REQUIRE( pools.getFilters().size() == 2 * numVoices );
+    REQUIRE( pools.getLFOs().numAvailable() == 2 * numVoices );
+
+    synth.noteOn(0, 60, 100);
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 2 );
+    REQUIRE( pools.getLFOs().numAvailable() == 2 * numVoices - 2 );
+    REQUIRE( pools.getFlexEGs().numAvailable() == numVoices - 1 );
+    REQUIRE( pools.getFilters().numAvailable() == 2 * numVoices - 2 );
+
+    synth.noteOff(0, 60, 0);
+    synth.noteOff(0, 62, 0);
+    for (int i = 0; i < 100 && synth.getNumActiveVoices() > 0; ++i)
+        synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 0 );
+    REQUIRE( pools.getLFOs().numAvailable() == 2 * numVoices );
+    REQUIRE( pools.getFlexEGs().numAvailable() == numVoices );
+    REQUIRE( pools.getFilters().numAvailable() == 2 * numVoices );
+}
+
+TEST_CASE("[Synth] Voice stages timed every few blocks")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/voiceTiming.sfz", R"(
+        <region> sample=*sine cutoff=1000 fil_type=lpf_2p
+    )");
+    REQUIRE(synth.getVoiceTimingPeriod() == 1);
+    synth.setVoiceTimingPeriod(0);
+    REQUIRE(synth.getVoiceTimingPeriod() == 1);
+    synth.setVoiceTimingPeriod(4);
+    REQUIRE(synth.getVoiceTimingPeriod() == 4);
+
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    const double data = synth.getCallbackBreakdown().data;
+    REQUIRE(data > 0.0);
+
+    // the breakdown of the voices is kept between the timed blocks
+    for (int block = 1; block < 4; ++block) {
+        synth.renderBlock(buffer);
+        REQUIRE(synth.getCallbackBreakdown().data == data);
+    }
+}
+
+TEST_CASE("[Synth] Buffer pool telemetry")
+{
+    sfz::BufferPool pool;
+    pool.setNumBuffers(2, 1, 1);
+    REQUIRE(pool.getNumBuffers() == sfz::config::bufferPoolSize);
+    pool.setNumBuffers(sfz::config::bufferPoolSize + 2, 1, 1);
+    REQUIRE(pool.getNumBuffers() == sfz::config::bufferPoolSize + 2);
+    REQUIRE(pool.getNumStereoBuffers() == sfz::config::stereoBufferPoolSize);
+    REQUIRE(pool.getNumIndexBuffers() == sfz::config::indexBufferPoolSize);
+
+    {
+        std::vector<sfz::SpanHolder<absl::Span<float>>> buffers;
+        for (int i = 0; i < pool.getNumBuffers(); ++i) {
+            buffers.push_back(pool.getBuffer(16));
+            REQUIRE(buffers.back());
+        }
+        REQUIRE(!pool.getBuffer(16));
+        auto stereo = pool.getStereoBuffer(16);
+        REQUIRE(stereo);
+        REQUIRE(!pool.getIndexBuffer(sfz::config::defaultSamplesPerBlock + 1));
+    }
+
+    sfz::BufferPoolStats stats = pool.getStats();
+    REQUIRE(stats.maxBuffersUsed == sfz::config::bufferPoolSize + 2);
+    REQUIRE(stats.maxStereoBuffersUsed == 1);
+    REQUIRE(stats.maxIndexBuffersUsed == 0);
+    REQUIRE(stats.numBufferFailures == 1);
+    REQUIRE(stats.numStereoBufferFailures == 0);
+    REQUIRE(stats.numIndexBufferFailures == 1);
+
+    // the released buffers are available again
+    REQUIRE(pool.getBuffer(16));
+    pool.resetStats();
+    stats = pool.getStats();
+    REQUIRE(stats.maxBuffersUsed == 0);
+    REQUIRE(stats.numBufferFailures == 0);
+    REQUIRE(stats.numIndexBufferFailures == 0);
+}
+
+TEST_CASE("[Synth] Buffer pools sized from the instrument")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/bufferPool.sfz", R"(
+        <region> sample=*sine
+    )");
+    REQUIRE(synth.getBufferPoolStats().numBuffers == sfz::config::bufferPoolSize);
+
+    // unison and an LFO: the synth, the data stage and the LFO
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/bufferPool.sfz", R"(
+        <region> sample=*saw oscillator_multi=5 lfo1_freq=5 lfo1_pitch=100
+    )");
+    REQUIRE(synth.getBufferPoolStats().numBuffers == 8);
+    synth.setSamplesPerBlock(256);
+    REQUIRE(synth.getBufferPoolStats().numBuffers == 8);
+
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.resetBufferPoolStats();
+    synth.noteOn(0, 60, 100);
+    for (int block = 0; block < 4; ++block)
+        synth.renderBlock(buffer);
+
+    const sfz::Synth::BufferPoolStats stats = synth.getBufferPoolStats();
+    REQUIRE(stats.maxBuffersUsed > 0);
+    REQUIRE(stats.maxBuffersUsed <= stats.numBuffers);
+    REQUIRE(stats.maxStereoBuffersUsed >= 2);
+    REQUIRE(stats.numBufferFailures == 0);
+    REQUIRE(stats.numStereoBufferFailures == 0);
+    REQUIRE(stats.numIndexBufferFailures == 0);
+
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    synth.dispatchMessage(client, 0, "/buffer_pool/num_buffers", "", nullptr);
+    synth.dispatchMessage(client, 0, "/buffer_pool/buffer_failures", "", nullptr);
+    std::vector<std::string> expected {
+        "/buffer_pool/num_buffers,i : { 8 }",
+        "/buffer_pool/buffer_failures,i : { 0 }",
+    };
+    REQUIRE(messageList == expected);
+}
+
+TEST_CASE("[Synth] Load breakdown")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/loadBreakdown.sfz", R"(
+        <group> lovel=1 hivel=64
+        <region> sample=*sine key=60 lfo1_freq=5 lfo1_pitch=15
+        <region> sample=*saw key=62 cutoff=1000 cutoff_oncc74=1200
+    )");
+    const sfz::Synth::LoadBreakdown& load = synth.getLoadBreakdown();
+    REQUIRE(load.parse > 0.0);
+    REQUIRE(load.regions > 0.0);
+    REQUIRE(load.activation > 0.0);
+    REQUIRE(load.modMatrix > 0.0);
+    REQUIRE(load.finalize >= load.activation + load.modMatrix);
+}
+
+TEST_CASE("[Synth] Processing at a fraction of the host rate")
+{
+    sfz::Synth synth;
+    synth.setSampleRate(192000.0f);
+    synth.setSamplesPerBlock(1024);
+    REQUIRE(synth.getProcessingRate() == 192000.0f);
+    REQUIRE(synth.getLatency() == 0);
+
+    synth.setMaxProcessingRate(48000.0f);
+    REQUIRE(synth.getMaxProcessingRate() == 48000.0f);
+    REQUIRE(synth.getProcessingRate() == 48000.0f);
+    REQUIRE(synth.getSamplesPerBlock() == 1024);
+    const int latency = synth.getLatency();
+    REQUIRE(latency > 0);
+
+    // a rate under the maximum processes at the host rate
+    synth.setSampleRate(44100.0f);
+    REQUIRE(synth.getProcessingRate() == 44100.0f);
+    REQUIRE(synth.getLatency() == 0);
+    synth.setSampleRate(192000.0f);
+    REQUIRE(synth.getLatency() == latency);
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/processingRate.sfz", R"(
+        <region> sample=*sine ampeg_attack=0 ampeg_release=0
+    )");
+
+    // the delays of the events are at the host rate
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    synth.noteOn(512, 69, 127);
+    synth.renderBlock(buffer);
+    const float* left = buffer.channelReader(0);
+    REQUIRE(std::all_of(left, left + 500, [](float x) { return x == 0.0f; }));
+    REQUIRE(std::any_of(left + 512, left + 1024, [](float x) { return x != 0.0f; }));
+
+    // the blocks of any size add up to a continuous output
+    sfz::AudioBuffer<float> small { 2, 100 };
+    for (int block = 0; block < 10; ++block) {
+        synth.renderBlock(small);
+        const float* frames = small.channelReader(0);
+        REQUIRE(std::any_of(frames, frames + 100, [](float x) { return x != 0.0f; }));
+    }
+
+    synth.setMaxProcessingRate(0.0f);
+    REQUIRE(synth.getProcessingRate() == 192000.0f);
+    REQUIRE(synth.getLatency() == 0);
+}
+
+TEST_CASE("[Synth] Resident programs")
+{
+    sfz::Synth synth;
+    synth.setSampleRate(48000.0f);
+    synth.setSamplesPerBlock(1024);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/residentDefault.sfz", R"(
+        <region> sample=*sine ampeg_attack=0 ampeg_release=0.05
+    )");
+    REQUIRE(synth.loadResidentProgram(5, fs::current_path() / "tests/TestFiles/resident_program.sfz"));
+    REQUIRE(synth.hasResidentProgram(5));
+    REQUIRE_FALSE(synth.hasResidentProgram(4));
+    REQUIRE(synth.getActiveProgram() == -1);
+    REQUIRE(synth.getNumRegions() == 1);
+
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    synth.noteOn(0, 60, 127);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    // The program switches at the next block, and the previous voice plays
+    // its release over
+    synth.programChange(0, 5);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getActiveProgram() == 5);
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    const float* left = buffer.channelReader(0);
+    REQUIRE(std::any_of(left, left + 1024, [](float x) { return x != 0.0f; }));
+    for (int block = 0; block < 10; ++block)
+        synth.renderBlock(buffer);
+    REQUIRE(std::all_of(left, left + 1024, [](float x) { return x == 0.0f; }));
+
+    synth.noteOn(0, 62, 127);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    // The resident instruments follow the settings of the synth
+    synth.setSampleRate(44100.0f);
+    synth.programChange(0, 3);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getActiveProgram() == -1);
+    REQUIRE(synth.getNumRegions() == 1);
+    REQUIRE(synth.getProcessingRate() == 44100.0f);
+
+    synth.removeResidentProgram(5);
+    REQUIRE_FALSE(synth.hasResidentProgram(5));
+    synth.programChange(0, 5);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getActiveProgram() == -1);
+}
+
+TEST_CASE("[Synth] Save and load the state")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/state.sfz", R"(
+        <control> set_cc20=10
+        <region> sw_last=36 sw_lokey=36 sw_hikey=37 sample=*sine
+        <region> sw_last=37 sw_lokey=36 sw_hikey=37 sample=*saw
+    )");
+    synth.setNumVoices(32);
+    synth.setVolume(-6.0f);
+    synth.setSampleQuality(sfz::Synth::ProcessLive, 3);
+    synth.setScalaRootKey(62);
+    synth.setTuningFrequency(432.0f);
+    synth.cc(0, 20, 100);
+    synth.cc(0, 74, 64);
+    synth.noteOn(0, 37, 127);
+    synth.noteOff(1, 37, 0);
+    const std::vector<uint8_t> state = synth.saveState();
+
+    sfz::Synth other;
+    REQUIRE(other.loadState(state.data(), state.size()));
+    REQUIRE(other.getNumRegions() == 2);
+    REQUIRE(other.getNumVoices() == 32);
+    REQUIRE(other.getVolume() == -6.0f);
+    REQUIRE(other.getSampleQuality(sfz::Synth::ProcessLive) == 3);
+    REQUIRE(other.getScalaRootKey() == 62);
+    REQUIRE(other.getTuningFrequency() == 432.0f);
+    REQUIRE(other.getHdcc(20) == Approx(100.0f / 127));
+    REQUIRE(other.getHdcc(74) == Approx(64.0f / 127));
+    REQUIRE(other.getHdcc(7) == Approx(100.0f / 127)); // default volume
+    other.noteOn(0, 60, 127);
+    REQUIRE(getActiveVoices(other).size() == 1);
+    REQUIRE(getActiveVoices(other)[0]->getRegion()->sampleId->filename() == "*saw");
+
+    REQUIRE_FALSE(other.loadState(state.data(), state.size() - 1));
+    REQUIRE_FALSE(other.loadState("SFZSTATE", 8));
+}
+
+TEST_CASE("[Synth] Corrupt states and failed loads leave the synth as it is")
+{
+    std::vector<uint8_t> state;
+    auto append = [&state](const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        state.insert(state.end(), bytes, bytes + size);
+    };
+    auto appendValue = [&append](auto value) { append(&value, sizeof(value)); };
+    append("SFZSTATE", 8);
+    appendValue(uint32_t(1));
+
+    // A string longer than the state
+    std::vector<uint8_t> corrupt = state;
+    corrupt.push_back(1);
+    const uint32_t hugeSize = 0xfffffff0;
+    const uint8_t* sizeBytes = reinterpret_cast<const uint8_t*>(&hugeSize);
+    corrupt.insert(corrupt.end(), sizeBytes, sizeBytes + sizeof(hugeSize));
+    sfz::Synth synth;
+    REQUIRE_FALSE(synth.loadState(corrupt.data(), corrupt.size()));
+
+    // An instrument which does not load
+    const std::string path = (fs::current_path() / "tests/TestFiles/nonexistent.sfz").string();
+    appendValue(uint8_t(1));
+    appendValue(static_cast<uint32_t>(path.size()));
+    append(path.data(), path.size());
+    appendValue(uint8_t(0));
+    appendValue(int32_t(60));
+    appendValue(432.0f);
+    appendValue(1.0f);
+    for (int i = 0; i < 6; ++i)
+        appendValue(int32_t(1));
+    appendValue(int32_t(16));
+    appendValue(-12.0f);
+    appendValue(uint32_t(0));
+    appendValue(0.0f);
+    appendValue(0.0f);
+    appendValue(int32_t(0));
+    appendValue(int16_t(-1));
+
+    synth.setNumVoices(32);
+    REQUIRE_FALSE(synth.loadState(state.data(), state.size()));
+    REQUIRE(synth.getNumVoices() == 32);
+    REQUIRE(synth.getVolume() != -12.0f);
+    REQUIRE(synth.getTuningFrequency() != 432.0f);
+}
+
+TEST_CASE("[Synth] Crossfades shared by the voices of a region")
+{
+    // The voices of one region share the crossfade of a cycle, and must
+    // render the same as in two regions which compute it on their own
+    sfz::Synth shared;
+    sfz::Synth separate;
+    shared.loadSfzString(fs::current_path() / "tests/TestFiles/xfade_shared.sfz", R"(
+        <region> sample=*sine xfin_locc1=0 xfin_hicc1=127
+    )");
+    separate.loadSfzString(fs::current_path() / "tests/TestFiles/xfade_separate.sfz", R"(
+        <region> sample=*sine hikey=60 xfin_locc1=0 xfin_hicc1=127
+        <region> sample=*sine lokey=61 xfin_locc1=0 xfin_hicc1=127
+    )");
+
+    sfz::AudioBuffer<float> sharedBuffer { 2, 256 };
+    sfz::AudioBuffer<float> separateBuffer { 2, 256 };
+    for (sfz::Synth* synth : { &shared, &separate }) {
+        synth->setSamplesPerBlock(256);
+        synth->cc(0, 1, 20);
+        synth->noteOn(0, 60, 127);
+        synth->noteOn(0, 72, 127);
+    }
+
+    for (int block = 0; block < 8; ++block) {
+        for (sfz::Synth* synth : { &shared, &separate }) {
+            synth->cc(64, 1, 20 + 10 * block);
+            synth->cc(192, 1, 25 + 10 * block);
+            // a voice which starts in the middle of the crossfade
+            if (block == 4)
+                synth->noteOn(0, 67, 127);
+        }
+        shared.renderBlock(sharedBuffer);
+        separate.renderBlock(separateBuffer);
+        REQUIRE(shared.getNumActiveVoices() == separate.getNumActiveVoices());
+        for (size_t c = 0; c < 2; ++c) {
+            const float* a = sharedBuffer.channelReader(c);
+            const float* b = separateBuffer.channelReader(c);
+            REQUIRE(std::equal(a, a + 256, b));
+        }
+    }
+}
+
+TEST_CASE("[Synth] Voices of the layers crossfaded out are dormant")
+{
+    // The dormant layer renders nothing, as the synth without it
+    sfz::Synth synth;
+    sfz::Synth reference;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/xfade_dormant.sfz", R"(
+        <region> sample=*saw cutoff=2000 xfin_locc1=64 xfin_hicc1=127
+        <region> sample=*sine xfout_locc1=64 xfout_hicc1=127
+    )");
+    reference.loadSfzString(fs::current_path() / "tests/TestFiles/xfade_dormant.sfz", R"(
+        <region> sample=*sine xfout_locc1=64 xfout_hicc1=127
+    )");
+
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    sfz::AudioBuffer<float> referenceBuffer { 2, 256 };
+    for (sfz::Synth* s : { &synth, &reference }) {
+        s->setSamplesPerBlock(256);
+        s->cc(0, 1, 0);
+        s->noteOn(0, 60, 127);
+    }
+
+    auto dormantVoice = [&](int regionIdx) {
+        for (int i = 0; i < synth.getNumVoices(); ++i) {
+            const sfz::Voice* voice = synth.getVoiceView(i);
+            if (!voice->isFree() && voice->getRegion() == synth.getRegionView(regionIdx))
+                return voice->isDormant();
+        }
+        return false;
+    };
+
+    for (int block = 0; block < 4; ++block) {
+        synth.renderBlock(buffer);
+        reference.renderBlock(referenceBuffer);
+        REQUIRE( synth.getNumActiveVoices() == 2 );
+        REQUIRE( dormantVoice(0) );
+        REQUIRE( !dormantVoice(1) );
+        for (size_t c = 0; c < 2; ++c) {
+            const float* a = buffer.channelReader(c);
+            const float* b = referenceBuffer.channelReader(c);
+            REQUIRE(std::equal(a, a + 256, b));
+        }
+    }
+
+    // The layer wakes up as the crossfade opens
+    synth.cc(0, 1, 127);
+    synth.renderBlock(buffer);
+    synth.renderBlock(buffer);
+    REQUIRE( !dormantVoice(0) );
+    REQUIRE( dormantVoice(1) );
+    REQUIRE( numPlayingVoices(synth) == 2 );
+    const float* left = buffer.channelReader(0);
+    REQUIRE( std::any_of(left, left + 256, [](float x) { return x != 0.0f; }) );
+}
+
+TEST_CASE("[Synth] Voice templates of the regions")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/voice_template.sfz", R"(
+        <region> sample=*saw amplitude=50 oscillator_multi=3 oscillator_detune=10
+            cutoff=1000 cutoff_oncc20=1200 eq1_freq=500 eq1_gain_oncc21=6 pan_oncc22=50
+    )");
+
+    const sfz::Layer* layer = synth.getLayerView(0);
+    REQUIRE(layer);
+    const sfz::Layer::VoiceTemplate& voiceTemplate = layer->voiceTemplate_;
+    const sfz::ModMatrix& mm = synth.getResources().getModMatrix();
+    const NumericId<sfz::Region> region = layer->getRegion().getId();
+
+    REQUIRE(voiceTemplate.panTarget);
+    REQUIRE(voiceTemplate.panTarget == mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::Pan, region)));
+    REQUIRE(voiceTemplate.filterTargets.size() == 1);
+    REQUIRE(voiceTemplate.filterTargets[0].cutoff);
+    REQUIRE(voiceTemplate.filterTargets[0].cutoff == mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::FilCutoff, region, 0)));
+    REQUIRE(voiceTemplate.equalizerTargets.size() == 1);
+    REQUIRE(voiceTemplate.equalizerTargets[0].gain);
+    REQUIRE(voiceTemplate.equalizerTargets[0].gain == mm.findTarget(sfz::ModKey::createNXYZ(sfz::ModId::EqGain, region, 0)));
+
+    REQUIRE(voiceTemplate.baseGain == Approx(0.5f));
+    REQUIRE(voiceTemplate.waveUnisonSize == 3);
+    REQUIRE(voiceTemplate.waveDetuneRatio[0] == 1.0f);
+    REQUIRE(voiceTemplate.waveDetuneRatio[2] == Approx(sfz::centsFactor(10.0f)));
+
+    // The template follows the changes of the region
+    std::vector<std::string> messageList;
+    sfz::Client client(&messageList);
+    client.setReceiveCallback(&simpleMessageReceiver);
+    sfizz_arg_t args[1];
+    args[0].f = 25.0f;
+    synth.dispatchMessage(client, 0, "/region0/amplitude", "f", args);
+    REQUIRE(voiceTemplate.baseGain == Approx(0.25f));
+}
+
+TEST_CASE("[Synth] Render features of the regions")
+{
+    using VoiceTemplate = sfz::Layer::VoiceTemplate;
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/render_features.sfz", R"(
+        <region> key=36 sample=kick.wav
+        <region> key=37 sample=looped_flute.wav eq1_freq=500 eq1_gain=6
+        <region> key=38 sample=*saw cutoff=1000 xfin_locc1=0 xfin_hicc1=127
+        <region> key=39 sample=*saw oscillator_multi=3
+    )");
+
+    auto features = [&](int idx) { return synth.getLayerView(idx)->voiceTemplate_.renderFeatures; };
+    REQUIRE(features(0) == 0);
+    REQUIRE(features(1) == (VoiceTemplate::renderStereo | VoiceTemplate::renderEqualizers));
+    REQUIRE(features(2) == (VoiceTemplate::renderOscillator | VoiceTemplate::renderFilters | VoiceTemplate::renderCrossfades));
+    REQUIRE(features(3) == (VoiceTemplate::renderOscillator | VoiceTemplate::renderStereo));
+
+    // Each region renders through its own variant
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.cc(0, 1, 127);
+    for (int key : { 36, 37, 38, 39 }) {
+        synth.allSoundOff();
+        synth.renderBlock(buffer);
+        synth.noteOn(0, key, 100);
+        synth.renderBlock(buffer);
+        const float* left = buffer.channelReader(0);
+        const float* right = buffer.channelReader(1);
+        const size_t numFrames = buffer.getNumFrames();
+        INFO("Key " << key);
+        REQUIRE(std::any_of(left, left + numFrames, [](float x) { return x != 0.0f; }));
+        REQUIRE(std::any_of(right, right + numFrames, [](float x) { return x != 0.0f; }));
+    }
+}
+
+TEST_CASE("[Synth] Open lowpass filters pass the block through")
+{
+    auto render = [](const std::string& filter, float sampleRate) {
+        sfz::Synth synth;
+        synth.setSampleRate(sampleRate);
+        synth.loadSfzString(fs::current_path() / "tests/TestFiles/open_filter.sfz",
+            "<region> sample=kick.wav " + filter);
+        sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+        std::vector<float> output;
+        synth.noteOn(0, 60, 100);
+        for (int block = 0; block < 4; ++block) {
+            synth.renderBlock(buffer);
+            const float* left = buffer.channelReader(0);
+            output.insert(output.end(), left, left + buffer.getNumFrames());
+        }
+        return output;
+    };
+
+    // The cutoff reaches Nyquist at 32 kHz
+    const std::vector<float> unfiltered = render("", 32000.0f);
+    REQUIRE(std::any_of(unfiltered.begin(), unfiltered.end(), [](float x) { return x != 0.0f; }));
+    REQUIRE(render("fil_type=lpf_2p cutoff=20000", 32000.0f) == unfiltered);
+    REQUIRE(render("fil_type=lpf_4p cutoff=16000 resonance=0", 32000.0f) == unfiltered);
+    REQUIRE(render("fil_type=lpf_2p cutoff=20000 resonance=3", 32000.0f) != unfiltered);
+    REQUIRE(render("fil_type=hpf_2p cutoff=20000", 32000.0f) != unfiltered);
+    REQUIRE(render("fil_type=lpf_2p cutoff=2000", 32000.0f) != unfiltered);
+
+    // Under Nyquist, the filter runs
+    REQUIRE(render("fil_type=lpf_4p cutoff=20000", 48000.0f) != render("", 48000.0f));
+}
+
+TEST_CASE("[Synth] Power followers with a stride")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/power_stride.sfz", R"(
+        <control> hint_power_follower_stride=8
+        <region> sample=*sine
+    )");
+    REQUIRE(synth.getResources().getSynthConfig().powerFollowerStride == 8);
+
+    // The strided estimate of a steady signal follows the full one
+    constexpr unsigned numFrames { 1024 };
+    sfz::AudioBuffer<float> buffer { 2, numFrames };
+    for (unsigned i = 0; i < numFrames; ++i) {
+        const float sample = std::sin(2.0f * static_cast<float>(M_PI) * 441.0f * i / sfz::config::defaultSampleRate);
+        buffer.getSample(0, i) = sample;
+        buffer.getSample(1, i) = 0.5f * sample;
+    }
+
+    sfz::PowerFollower full;
+    sfz::PowerFollower strided;
+    strided.setStride(8);
+    REQUIRE(strided.getStride() == 8);
+    for (int block = 0; block < 64; ++block) {
+        full.process(sfz::AudioSpan<float>(buffer));
+        strided.process(sfz::AudioSpan<float>(buffer));
+    }
+    REQUIRE(full.getAveragePower() > 0.0f);
+    REQUIRE(strided.getAveragePower() == Approx(full.getAveragePower()).epsilon(0.05));
+}
+
+TEST_CASE("[Synth] The state snapshot follows the blocks")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/state_snapshot.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+    REQUIRE(synth.getStateSnapshot().version == 0);
+
+    synth.noteOn(0, 60, 100);
+    synth.hdcc(0, 20, 0.5f);
+    synth.renderBlock(buffer);
+    auto snapshot = synth.getStateSnapshot();
+    REQUIRE(snapshot.version == 1);
+    REQUIRE(snapshot.numActiveVoices == 1);
+    REQUIRE(snapshot.activeNotes == 1);
+    REQUIRE(snapshot.noteVelocities[60] == Approx(100.0f / 127.0f));
+    REQUIRE(snapshot.noteVelocities[61] == 0.0f);
+    REQUIRE(snapshot.ccValues[20] == 0.5f);
+
+    // The events of the next block show after it
+    synth.noteOff(0, 60, 0);
+    REQUIRE(synth.getStateSnapshot().noteVelocities[60] != 0.0f);
+    synth.renderBlock(buffer);
+    snapshot = synth.getStateSnapshot();
+    REQUIRE(snapshot.version == 2);
+    REQUIRE(snapshot.activeNotes == 0);
+    REQUIRE(snapshot.noteVelocities[60] == 0.0f);
+}
+
+TEST_CASE("[Synth] The voice pools follow the polyphony of the regions")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(64);
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/voice_pools_polyphony.sfz", R"(
+        <region> key=60 sample=*sine polyphony=1 lfo1_freq=1 lfo2_freq=2 lfo3_freq=3 lfo4_freq=4
+            ampeg_release=0.01
+        <region> key=62 sample=*sine ampeg_release=0.01
+    )");
+
+    // The region of one voice holds its voice and the overflow ones at most
+    const size_t numVoices = 1 + sfz::config::minOverflowVoices;
+    sfz::VoicePools& pools = synth.getResources().getVoicePools();
+    REQUIRE( pools.getLFOs().size() == 4 * numVoices );
+    REQUIRE( pools.getFilters().size() == 0 );
+    REQUIRE( pools.getFlexEGs().size() == 0 );
+
+    for (int i = 0; i < 10; ++i) {
+        synth.noteOn(0, 60, 100);
+        synth.noteOn(0, 62, 100);
+        synth.renderBlock(buffer);
+    }
+    REQUIRE( synth.getNumActiveVoices() > 1 );
+    REQUIRE( pools.getLFOs().numAvailable() <= 4 * numVoices - 4 );
+}
+
+TEST_CASE("[Synth] The voice pools hold the most objects the voices can borrow")
+{
+    using Needs = sfz::VoicePools::RegionNeeds;
+    const auto lfos = &Needs::numLFOs;
+    const size_t numOverflow = sfz::config::minOverflowVoices;
+
+    REQUIRE( sfz::VoicePools::getPoolSize(100, {}, lfos) == 0 );
+    REQUIRE( sfz::VoicePools::getPoolSize(100, { Needs { sfz::config::maxVoices, 0, 0, 2, 0 } }, lfos) == 200 );
+    REQUIRE( sfz::VoicePools::getPoolSize(100, { Needs { 1, 0, 0, 8, 0 } }, lfos) == 8 * (1 + numOverflow) );
+    REQUIRE( sfz::VoicePools::getPoolSize(100, {
+        Needs { sfz::config::maxVoices, 0, 0, 1, 0 },
+        Needs { 1, 0, 0, 8, 0 },
+        Needs { sfz::config::maxVoices, 0, 0, 0, 0 },
+    }, lfos) == 8 * (1 + numOverflow) + (100 - 1 - numOverflow) );
+    REQUIRE( sfz::VoicePools::getPoolSize(3, { Needs { 1, 0, 0, 8, 0 } }, lfos) == 24 );
+}
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/TaskScheduler.h"
+#include "catch2/catch.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace sfz;
+
+namespace {
+struct CountTask final : public TaskScheduler::Task {
+    explicit CountTask(std::atomic<int>& counter) : counter(counter) {}
+    void run() noexcept override { counter.fetch_add(1); }
+    std::atomic<int>& counter;
+};
+}
+
+TEST_CASE("[TaskScheduler] Run the tasks")
+{
+    TaskScheduler scheduler(3);
+    REQUIRE(scheduler.getNumWorkers() == 3);
+
+    std::atomic<int> counter { 0 };
+    std::vector<std::unique_ptr<CountTask>> tasks;
+    for (int i = 0; i < 100; ++i) {
+        tasks.emplace_back(new CountTask(counter));
+        REQUIRE(scheduler.schedule(*tasks.back(), i % 2 ? TaskScheduler::Priority::High : TaskScheduler::Priority::Low));
+    }
+
+    for (auto& task : tasks)
+        TaskScheduler::wait(*task);
+    REQUIRE(counter == 100);
+}
+
+TEST_CASE("[TaskScheduler] Reschedule a task once done")
+{
+    TaskScheduler scheduler(1);
+    std::atomic<int> counter { 0 };
+    CountTask task { counter };
+
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(scheduler.schedule(task, TaskScheduler::Priority::High));
+        TaskScheduler::wait(task);
+        REQUIRE(task.isIdle());
+    }
+    REQUIRE(counter == 10);
+}
+
+TEST_CASE("[TaskScheduler] Function tasks")
+{
+    TaskScheduler scheduler(2);
+    std::atomic<int> counter { 0 };
+    auto function = [&counter]() { counter += 2; };
+
+    TaskScheduler::FunctionTask<decltype(function)> task { function };
+    REQUIRE(scheduler.schedule(task, TaskScheduler::Priority::Low));
+    TaskScheduler::wait(task);
+    REQUIRE(counter == 2);
+}
+
+TEST_CASE("[TaskScheduler] Thread settings")
+{
+    const TaskScheduler::ThreadSettings defaults = TaskScheduler::getGlobalThreadSettings();
+
+    TaskScheduler::ThreadSettings settings;
+    settings.numThreads = 2;
+    settings.policy = TaskScheduler::ThreadSettings::Policy::Normal;
+    settings.priority = 0;
+    settings.affinityMask = 1;
+    TaskScheduler::setGlobalThreadSettings(settings);
+
+    const TaskScheduler::ThreadSettings current = TaskScheduler::getGlobalThreadSettings();
+    REQUIRE(current.numThreads == 2);
+    REQUIRE(current.policy == TaskScheduler::ThreadSettings::Policy::Normal);
+    REQUIRE(current.priority == 0);
+    REQUIRE(current.affinityMask == 1);
+    TaskScheduler::setGlobalThreadSettings(defaults);
+
+    // The workers still run the tasks with other settings
+    TaskScheduler scheduler(2, settings);
+    std::atomic<int> counter { 0 };
+    CountTask task { counter };
+    REQUIRE(scheduler.schedule(task, TaskScheduler::Priority::High));
+    TaskScheduler::wait(task);
+    scheduler.setThreadSettings(TaskScheduler::ThreadSettings());
+    REQUIRE(scheduler.schedule(task, TaskScheduler::Priority::Low));
+    TaskScheduler::wait(task);
+    REQUIRE(counter == 2);
+}
+
+TEST_CASE("[TaskScheduler] Notify a running task")
+{
+    TaskScheduler scheduler(2);
+    std::atomic<int> counter { 0 };
+    std::atomic<bool> started { false };
+    std::atomic<bool> release { false };
+
+    auto function = [&]() {
+        started = true;
+        while (!release)
+            std::this_thread::yield();
+        counter.fetch_add(1);
+    };
+    TaskScheduler::FunctionTask<decltype(function)> task { function };
+
+    REQUIRE(scheduler.notify(task, TaskScheduler::Priority::High));
+    while (!started)
+        std::this_thread::yield();
+
+    // Coalesced into one more run
+    REQUIRE(scheduler.notify(task, TaskScheduler::Priority::High));
+    REQUIRE(scheduler.notify(task, TaskScheduler::Priority::High));
+    release = true;
+
+    TaskScheduler::wait(task);
+    REQUIRE(counter == 2);
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/Tracer.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "catch2/catch.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static std::string readTrace(const fs::path& file)
+{
+    std::ifstream stream(file.string());
+    std::ostringstream contents;
+    contents << stream.rdbuf();
+    return contents.str();
+}
+
+static size_t countOccurrences(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != text.npos; pos = text.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+TEST_CASE("[Tracer] Events written to the trace")
+{
+    const fs::path file = fs::temp_directory_path() / "sfizz_tracer_test.json";
+    sfz::Tracer tracer;
+
+    sfz::TraceEvent event;
+    tracer.push(event);
+    REQUIRE(!tracer.isActive());
+
+    REQUIRE(tracer.start(file, true));
+    REQUIRE(tracer.isActive());
+    REQUIRE(tracer.tracesVoices());
+
+    event.type = sfz::TraceEvent::Type::Block;
+    event.start = sfz::highResNow();
+    event.duration = 1e-3;
+    event.number = 256;
+    tracer.push(event);
+    event.type = sfz::TraceEvent::Type::Voice;
+    event.lane = 2;
+    event.number = 7;
+    tracer.push(event);
+    tracer.push(event);
+    tracer.stop();
+    REQUIRE(!tracer.isActive());
+    REQUIRE(tracer.getNumDroppedEvents() == 0);
+
+    const std::string trace = readTrace(file);
+    REQUIRE(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+    REQUIRE(trace.rfind("]}") != trace.npos);
+    REQUIRE(countOccurrences(trace, "\"ph\":\"X\"") == 3);
+    REQUIRE(countOccurrences(trace, "\"frames\":256") == 1);
+    REQUIRE(countOccurrences(trace, "\"name\":\"region 7\"") == 2);
+    // the voice lane is named once
+    REQUIRE(countOccurrences(trace, "Voices, lane 2") == 1);
+    REQUIRE(trace.find("\"dur\":1000.000") != trace.npos);
+
+    // the events pushed after a stop are not in the file
+    tracer.push(event);
+    REQUIRE(countOccurrences(readTrace(file), "\"ph\":\"X\"") == 3);
+    fs::remove(file);
+}
+
+TEST_CASE("[Tracer] Trace of the synth")
+{
+    const fs::path file = fs::temp_directory_path() / "sfizz_synth_trace_test.json";
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString("trace.sfz", "<region> sample=*sine");
+    synth.noteOn(0, 60, 100);
+
+#if SFIZZ_TRACING
+    REQUIRE(synth.startTrace(file, true));
+    for (int i = 0; i < 4; ++i)
+        synth.renderBlock(buffer);
+    synth.stopTrace();
+
+    const std::string trace = readTrace(file);
+    REQUIRE(countOccurrences(trace, "\"cat\":\"block\"") == 4);
+    REQUIRE(countOccurrences(trace, "\"cat\":\"voice\"") == 4);
+    fs::remove(file);
+#else
+    REQUIRE(!synth.startTrace(file, true));
+    synth.renderBlock(buffer);
+    synth.stopTrace();
+#endif
+}
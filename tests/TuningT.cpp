@@ -120,4 +120,25 @@ TEST_CASE("[Tuning] Stretch interpolation bounds")
     }
 }
 
+TEST_CASE("[Tuning] Stretch ratios of the keys")
+{
+    sfz::Tuning tuning;
+    for (int key = 0; key < 128; ++key)
+        REQUIRE(tuning.getStretchRatioOfKey(key) == 1.0f);
+
+    auto stretch = sfz::StretchTuning::createRailsbackFromRatio(0.5f);
+    tuning.setStretchTuning(&stretch);
+    for (int key = 0; key < 128; ++key)
+        REQUIRE(tuning.getStretchRatioOfKey(key) == Approx(stretch.getRatioForIntegralKey(key)));
 
+    // Follows the scale, at the retuned keys
+    tuning.loadScalaString("! 7-TET\n7-TET\n7\n!\n171.42857\n342.85714\n514.28571\n685.71429\n857.14286\n1028.57143\n2/1\n");
+    for (int key = 0; key < 128; ++key) {
+        const float retuned = tuning.getKeyFractional12TET(key);
+        REQUIRE(tuning.getStretchRatioOfKey(key) == Approx(stretch.getRatioForFractionalKey(retuned)));
+    }
+
+    tuning.setStretchTuning(nullptr);
+    for (int key = 0; key < 128; ++key)
+        REQUIRE(tuning.getStretchRatioOfKey(key) == 1.0f);
+}
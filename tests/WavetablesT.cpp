@@ -6,12 +6,15 @@
 
 #include "sfizz/Wavetables.h"
 #include "sfizz/FileMetadata.h"
+#include "sfizz/FilePool.h"
 #include "sfizz/MathHelpers.h"
 #include "catch2/catch.hpp"
+#include "ghc/fs_std.hpp"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 TEST_CASE("[Wavetables] Frequency ranges")
 {
@@ -129,3 +132,136 @@ TEST_CASE("[Wavetables] Non-wavetable sound files, from memory")
     REQUIRE(reader.open());
     REQUIRE(!reader.extractWavetableInfo(wt));
 }
+
+TEST_CASE("[Wavetables] Unison of oscillators")
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr unsigned numFrames = 1024;
+    constexpr unsigned numOscillators = 9;
+    const sfz::WavetableMulti wave = sfz::WavetableMulti::createForHarmonicProfile(
+        sfz::HarmonicProfile::getSaw(), 1.0, 1024);
+
+    std::vector<float> frequencies(numFrames);
+    std::vector<float> detuneMod(numFrames);
+    for (unsigned i = 0; i < numFrames; ++i) {
+        frequencies[i] = 220.0f + 3000.0f * i / numFrames;
+        detuneMod[i] = 1.0f + 0.01f * std::sin(0.01f * i);
+    }
+
+    float detuneRatios[numOscillators];
+    float leftGains[numOscillators];
+    float rightGains[numOscillators];
+    for (unsigned u = 0; u < numOscillators; ++u) {
+        detuneRatios[u] = std::exp2((-40.0f + 10.0f * u) / 1200.0f);
+        leftGains[u] = 0.1f * (numOscillators - u);
+        rightGains[u] = 0.1f * (u + 1);
+    }
+
+    for (int quality = 0; quality <= 3; ++quality) {
+        for (const float* mod : { static_cast<const float*>(nullptr), static_cast<const float*>(detuneMod.data()) }) {
+            INFO("Quality " << quality << (mod ? ", modulated" : ""));
+            sfz::WavetableOscillator expectedOscillators[numOscillators];
+            sfz::WavetableOscillator oscillators[numOscillators];
+            sfz::WavetableOscillator* oscillatorPointers[numOscillators];
+            for (unsigned u = 0; u < numOscillators; ++u) {
+                for (sfz::WavetableOscillator* osc : { &expectedOscillators[u], &oscillators[u] }) {
+                    osc->init(sampleRate);
+                    osc->setWavetable(&wave);
+                    osc->setPhase(0.1f * u);
+                    osc->setQuality(quality);
+                }
+                oscillatorPointers[u] = &oscillators[u];
+            }
+
+            // Each oscillator separately, then mixed, over two cycles
+            std::vector<float> expectedLeft(numFrames);
+            std::vector<float> expectedRight(numFrames);
+            std::vector<float> output(numFrames);
+            std::vector<float> detunes(numFrames);
+            for (unsigned u = 0; u < numOscillators; ++u) {
+                for (unsigned i = 0; i < numFrames; ++i)
+                    detunes[i] = detuneRatios[u] * (mod ? mod[i] : 1.0f);
+                expectedOscillators[u].processModulated(frequencies.data(), detunes.data(), output.data(), numFrames / 2);
+                expectedOscillators[u].processModulated(&frequencies[numFrames / 2], &detunes[numFrames / 2], &output[numFrames / 2], numFrames / 2);
+                for (unsigned i = 0; i < numFrames; ++i) {
+                    expectedLeft[i] += leftGains[u] * output[i];
+                    expectedRight[i] += rightGains[u] * output[i];
+                }
+            }
+
+            std::vector<float> left(numFrames);
+            std::vector<float> right(numFrames);
+            sfz::WavetableOscillator::processUnison(
+                oscillatorPointers, numOscillators, frequencies.data(), detuneRatios, mod,
+                leftGains, rightGains, left.data(), right.data(), numFrames / 2);
+            sfz::WavetableOscillator::processUnison(
+                oscillatorPointers, numOscillators, &frequencies[numFrames / 2], detuneRatios, mod ? &mod[numFrames / 2] : nullptr,
+                leftGains, rightGains, &left[numFrames / 2], &right[numFrames / 2], numFrames / 2);
+
+            for (unsigned i = 0; i < numFrames; ++i) {
+                REQUIRE(left[i] == Approx(expectedLeft[i]).margin(1e-4));
+                REQUIRE(right[i] == Approx(expectedRight[i]).margin(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("[Wavetables] File waves built concurrently and cached")
+{
+    const fs::path cacheDirectory = fs::temp_directory_path() / "sfizz_wavetable_cache_test";
+    fs::remove_all(cacheDirectory);
+    const std::vector<std::string> filenames { "surge.wav", "clm.wav", "surge.wav" };
+
+    auto requireSameWaves = [](const sfz::WavetableMulti& a, const sfz::WavetableMulti& b) {
+        REQUIRE(a.tableSize() == b.tableSize());
+        for (unsigned m = 0; m < sfz::WavetableMulti::numTables(); ++m) {
+            const auto tableA = a.getTable(m);
+            const auto tableB = b.getTable(m);
+            REQUIRE(std::equal(tableA.begin(), tableA.end(), tableB.begin()));
+        }
+    };
+
+    auto numCacheFiles = [&cacheDirectory]() {
+        size_t count = 0;
+        std::error_code ec;
+        for (fs::directory_iterator it { cacheDirectory, ec }, end; !ec && it != end; it.increment(ec))
+            count += it->path().extension() == ".sfzwave";
+        return count;
+    };
+
+    sfz::FilePool filePool;
+    filePool.setRootDirectory(fs::current_path() / "tests/TestFiles/wavetables");
+
+    sfz::WavetablePool expected;
+    REQUIRE(expected.createFileWave(filePool, "surge.wav"));
+    REQUIRE(expected.createFileWave(filePool, "clm.wav"));
+
+    filePool.setCacheDirectory(cacheDirectory);
+    for (int run = 0; run < 2; ++run) {
+        // Built and written the first time, read back the second
+        sfz::WavetablePool waves;
+        waves.createFileWaves(filePool, filenames);
+        REQUIRE(numCacheFiles() == 2);
+        for (const std::string& filename : filenames) {
+            REQUIRE(waves.getFileWave(filename));
+            requireSameWaves(*waves.getFileWave(filename), *expected.getFileWave(filename));
+        }
+    }
+
+    fs::remove_all(cacheDirectory);
+}
+
+TEST_CASE("[Wavetables] Standard waves are shared by the pools")
+{
+    sfz::WavetablePool first;
+    sfz::WavetablePool second;
+    for (const char* name : { "*sine", "*triangle", "*saw", "*square" }) {
+        INFO(name);
+        const sfz::WavetableMulti* wave = first.getGeneratorWave(name);
+        REQUIRE(wave);
+        REQUIRE(wave == second.getGeneratorWave(name));
+    }
+    // Owned by none of the pools
+    REQUIRE(first.getMemoryUsage() == 0);
+    REQUIRE(second.getMemoryUsage() == 0);
+}